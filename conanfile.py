@@ -75,6 +75,7 @@ class LlfsConan(ConanFile):
         self.requires("glog/0.6.0", **VISIBLE)
         self.requires("gtest/1.14.0", **VISIBLE)
         self.requires("libbacktrace/cci.20210118", **VISIBLE)
+        self.requires("lz4/1.9.4", **VISIBLE)
         self.requires("openssl/3.2.0", **VISIBLE)
 
         self.requires("zlib/1.3", **OVERRIDE)
@@ -22,6 +22,15 @@ BATT_STRONG_TYPEDEF(usize, ThreadPoolSize);
 
 BATT_STRONG_TYPEDEF(usize, MaxQueueDepth);
 
+/** \brief The number of independent io_uring instances (submission/completion queue pairs) in a
+ * multi-queue IoRing.
+ */
+BATT_STRONG_TYPEDEF(usize, IoRingQueueCount);
+
+/** \brief Whether to pin each thread in a pool to its own CPU core.
+ */
+BATT_STRONG_TYPEDEF(bool, PinThreadsToCores);
+
 /*! \brief If set to true and the specified item/page is not found, then additional diagnostics will
  * be emitted (via logging).  Setting to false will suppress these diagnostics (as the application
  * has indicated that 'not found' is an expected/normal case for these calls).
@@ -33,6 +42,11 @@ BATT_STRONG_TYPEDEF(bool, OkIfNotFound);
  */
 BATT_STRONG_TYPEDEF(bool, UseParallelCopy);
 
+/** \brief Ask DataPacker to copy data with non-temporal (cache-bypassing) stores, if possible; for
+ * large payloads that won't be read back soon.
+ */
+BATT_STRONG_TYPEDEF(bool, UseNonTemporalCopy);
+
 /** \brief The number of bytes by which to delay trimming a Volume root log.
  */
 BATT_STRONG_TYPEDEF(u64, TrimDelayByteCount);
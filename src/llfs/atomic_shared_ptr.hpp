@@ -0,0 +1,81 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_ATOMIC_SHARED_PTR_HPP
+#define LLFS_ATOMIC_SHARED_PTR_HPP
+
+#include <llfs/config.hpp>
+//
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// A std::shared_ptr<T> that can be loaded and stored concurrently.
+//
+// Uses std::atomic<std::shared_ptr> where the standard library has it, and the (equivalent)
+// atomic shared_ptr free functions otherwise.
+//
+template <typename T>
+class AtomicSharedPtr
+{
+ public:
+  AtomicSharedPtr() = default;
+
+  explicit AtomicSharedPtr(std::shared_ptr<T> init) noexcept : ptr_{std::move(init)}
+  {
+  }
+
+  AtomicSharedPtr(const AtomicSharedPtr&) = delete;
+  AtomicSharedPtr& operator=(const AtomicSharedPtr&) = delete;
+
+  std::shared_ptr<T> load() const
+  {
+#if defined(__cpp_lib_atomic_shared_ptr)
+    return this->ptr_.load(std::memory_order_acquire);
+#else
+    return std::atomic_load_explicit(&this->ptr_, std::memory_order_acquire);
+#endif
+  }
+
+  void store(std::shared_ptr<T> desired)
+  {
+#if defined(__cpp_lib_atomic_shared_ptr)
+    this->ptr_.store(std::move(desired), std::memory_order_release);
+#else
+    std::atomic_store_explicit(&this->ptr_, std::move(desired), std::memory_order_release);
+#endif
+  }
+
+  bool compare_exchange_weak(std::shared_ptr<T>& expected, std::shared_ptr<T> desired)
+  {
+#if defined(__cpp_lib_atomic_shared_ptr)
+    return this->ptr_.compare_exchange_weak(expected, std::move(desired),
+                                            std::memory_order_acq_rel);
+#else
+    return std::atomic_compare_exchange_weak_explicit(&this->ptr_, &expected, std::move(desired),
+                                                      std::memory_order_acq_rel,
+                                                      std::memory_order_acquire);
+#endif
+  }
+
+ private:
+#if defined(__cpp_lib_atomic_shared_ptr)
+  std::atomic<std::shared_ptr<T>> ptr_;
+#else
+  std::shared_ptr<T> ptr_;
+#endif
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_ATOMIC_SHARED_PTR_HPP
@@ -71,6 +71,15 @@ class BasicLogStorageDriver
     return impl_.await_flush_pos(flush_pos);
   }
 
+#if LLFS_HAS_COROUTINES
+  // Only available if the storage implementation provides it.
+  //
+  coro::Task<StatusOr<slot_offset_type>> co_await_flush_pos(slot_offset_type flush_pos)
+  {
+    return impl_.co_await_flush_pos(flush_pos);
+  }
+#endif  // LLFS_HAS_COROUTINES
+
   //----
 
   Status set_commit_pos(slot_offset_type commit_pos)
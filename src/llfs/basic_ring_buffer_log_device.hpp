@@ -69,6 +69,16 @@ class BasicRingBufferLogDevice
     return this->driver_;
   }
 
+#if LLFS_HAS_COROUTINES
+  /** \brief Coroutine version of `sync(LogReadMode::kDurable, {.offset = min_offset})`: suspends
+   * the calling coroutine until the flush position reaches `min_offset`.
+   */
+  coro::Task<StatusOr<slot_offset_type>> co_await_flush_pos(slot_offset_type min_offset)
+  {
+    return this->driver_.co_await_flush_pos(min_offset);
+  }
+#endif  // LLFS_HAS_COROUTINES
+
  private:
   std::unique_ptr<WriterImpl> writer_ = std::make_unique<WriterImpl>(this);
   driver_type driver_{*this};
@@ -230,11 +240,18 @@ class BasicRingBufferLogDevice<Impl>::WriterImpl : public LogDevice::Writer
 
     const usize space_required = byte_count + head_room;
 
-    if (this->space() < space_required) {
+    // This is the only writer, so the commit pos can't change between here and `commit`; load it
+    // once.
+    //
+    const slot_offset_type commit_pos = this->device_->driver_.get_commit_pos();
+    const usize space_available =
+        this->device_->buffer_.size() -
+        slot_distance(this->device_->driver_.get_trim_pos(), commit_pos);
+
+    if (space_available < space_required) {
       return ::llfs::make_status(StatusCode::kPrepareFailedTrimRequired);
     }
 
-    const slot_offset_type commit_pos = this->device_->driver_.get_commit_pos();
     MutableBuffer writable_region = this->device_->buffer_.get_mut(commit_pos);
 
     this->prepared_offset_ = commit_pos;
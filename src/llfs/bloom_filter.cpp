@@ -9,5 +9,211 @@
 #include <llfs/bloom_filter.hpp>
 //
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define LLFS_BLOOM_FILTER_AVX2 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define LLFS_BLOOM_FILTER_NEON 1
+#endif
+
 namespace llfs {
+
+namespace {
+
+// Bit `i` of an item (0 <= i < hash_count) is at position `(hash_lo * kBlockSalts[i]) >> 23`
+// (0..511) of its block: bit `position % 8` of byte `position / 8`.  (These are the salts of the
+// Parquet split-block Bloom filter, extended to 16.)
+//
+alignas(64) constexpr u32 kBlockSalts[PackedBloomFilter::kMaxBlockedHashCount] = {
+    0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du, 0x705495c7u, 0x2df1424bu,
+    0x9efc4947u, 0x5c6bfb31u, 0x3e572e0fu, 0xd6a74dbfu, 0x8090c4bdu, 0x8d62d777u,
+    0x2974bcb7u, 0x3eff111du, 0xd23b9e69u, 0xfe5d4775u,
+};
+
+constexpr u32 kBlockBitShift = 32 - 9;
+
+inline u32 block_bit_position(u32 hash_lo, usize i) noexcept
+{
+  return (hash_lo * kBlockSalts[i]) >> kBlockBitShift;
+}
+
+using BlockContainsFn = bool (*)(const u8* block, u32 hash_lo, usize hash_count) noexcept;
+
+#if LLFS_BLOOM_FILTER_AVX2
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Tests 8 bit positions at a time, viewing the block as 16 (little-endian) 32-bit words.
+//
+__attribute__((target("avx2"))) bool block_contains_avx2(const u8* block, u32 hash_lo,
+                                                         usize hash_count) noexcept
+{
+  const __m256i lo_words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+  const __m256i hi_words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+  const __m256i hash = _mm256_set1_epi32(static_cast<int>(hash_lo));
+  const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+  for (usize i = 0; i < hash_count; i += 8) {
+    const __m256i salts = _mm256_load_si256(reinterpret_cast<const __m256i*>(kBlockSalts + i));
+    const __m256i positions = _mm256_srli_epi32(_mm256_mullo_epi32(hash, salts), kBlockBitShift);
+
+    // Fetch the 32-bit word holding each position (word_index is 0..15; the permutes only look at
+    // the low 3 bits).
+    //
+    const __m256i word_index = _mm256_srli_epi32(positions, 5);
+    const __m256i words = _mm256_blendv_epi8(
+        _mm256_permutevar8x32_epi32(lo_words, word_index),
+        _mm256_permutevar8x32_epi32(hi_words, word_index),
+        _mm256_cmpgt_epi32(word_index, _mm256_set1_epi32(7)));
+
+    // Ignore the lanes past `hash_count`.
+    //
+    const __m256i active = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(hash_count - i)),
+                                              lane);
+    const __m256i masks = _mm256_and_si256(
+        active, _mm256_sllv_epi32(_mm256_set1_epi32(1),
+                                  _mm256_and_si256(positions, _mm256_set1_epi32(31))));
+
+    // testc returns 1 iff (~words & masks) == 0.
+    //
+    if (!_mm256_testc_si256(words, masks)) {
+      return false;
+    }
+  }
+  return true;
 }
+
+BlockContainsFn select_block_contains() noexcept
+{
+  if (__builtin_cpu_supports("avx2")) {
+    return &block_contains_avx2;
+  }
+  return &blocked_bloom_block_contains_portable;
+}
+
+#elif LLFS_BLOOM_FILTER_NEON
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Tests all (up to 16) bit positions at once, using a 64-byte table lookup to fetch the byte
+// holding each one.
+//
+bool block_contains_neon(const u8* block, u32 hash_lo, usize hash_count) noexcept
+{
+  const uint8x16x4_t table = vld1q_u8_x4(block);
+  const uint32x4_t hash = vdupq_n_u32(hash_lo);
+
+  uint16x8_t positions16[2];
+  for (usize half = 0; half < 2; ++half) {
+    const uint32x4_t a = vshrq_n_u32(vmulq_u32(hash, vld1q_u32(kBlockSalts + half * 8)),
+                                     kBlockBitShift);
+    const uint32x4_t b = vshrq_n_u32(vmulq_u32(hash, vld1q_u32(kBlockSalts + half * 8 + 4)),
+                                     kBlockBitShift);
+    positions16[half] = vcombine_u16(vmovn_u32(a), vmovn_u32(b));
+  }
+
+  const uint8x16_t byte_index = vcombine_u8(vmovn_u16(vshrq_n_u16(positions16[0], 3)),
+                                            vmovn_u16(vshrq_n_u16(positions16[1], 3)));
+  const uint8x16_t bit_index = vcombine_u8(vmovn_u16(vandq_u16(positions16[0], vdupq_n_u16(7))),
+                                           vmovn_u16(vandq_u16(positions16[1], vdupq_n_u16(7))));
+
+  static const u8 kLanes[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+  const uint8x16_t active = vcltq_u8(vld1q_u8(kLanes), vdupq_n_u8(static_cast<u8>(hash_count)));
+
+  const uint8x16_t masks =
+      vandq_u8(active, vshlq_u8(vdupq_n_u8(1), vreinterpretq_s8_u8(bit_index)));
+  const uint8x16_t bytes = vqtbl4q_u8(table, byte_index);
+
+  return vminvq_u8(vceqq_u8(vandq_u8(bytes, masks), masks)) == 0xff;
+}
+
+BlockContainsFn select_block_contains() noexcept
+{
+  return &block_contains_neon;
+}
+
+#else
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BlockContainsFn select_block_contains() noexcept
+{
+  return &blocked_bloom_block_contains_portable;
+}
+
+#endif
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, BloomFilterLayout t)
+{
+  switch (t) {
+    case BloomFilterLayout::kFlat:
+      return out << "Flat";
+    case BloomFilterLayout::kBlocked512:
+      return out << "Blocked512";
+  }
+  return out << "BloomFilterLayout{" << static_cast<int>(t) << "}";
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool blocked_bloom_block_contains(const u8* block, u32 hash_lo, usize hash_count) noexcept
+{
+  static const BlockContainsFn impl = select_block_contains();
+
+  BATT_ASSERT_LE(hash_count, PackedBloomFilter::kMaxBlockedHashCount);
+
+  return impl(block, hash_lo, hash_count);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool blocked_bloom_block_contains_portable(const u8* block, u32 hash_lo,
+                                           usize hash_count) noexcept
+{
+  for (usize i = 0; i < hash_count; ++i) {
+    const u32 position = block_bit_position(hash_lo, i);
+    if ((block[position / 8] & (u8{1} << (position % 8))) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void blocked_bloom_block_insert(u8* block, u32 hash_lo, usize hash_count) noexcept
+{
+  BATT_CHECK_LE(hash_count, PackedBloomFilter::kMaxBlockedHashCount);
+
+  for (usize i = 0; i < hash_count; ++i) {
+    const u32 position = block_bit_position(hash_lo, i);
+    block[position / 8] |= (u8{1} << (position % 8));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void blocked_bloom_block_insert_atomic(u8* block, u32 hash_lo, usize hash_count) noexcept
+{
+  BATT_CHECK_LE(hash_count, PackedBloomFilter::kMaxBlockedHashCount);
+
+  // Bit `position % 8` of byte `position / 8` is bit `position % 64` of (little-endian) word
+  // `position / 64`.
+  //
+  std::array<u64, PackedBloomFilter::kBlockWords> word_masks;
+  word_masks.fill(0);
+
+  for (usize i = 0; i < hash_count; ++i) {
+    const u32 position = block_bit_position(hash_lo, i);
+    word_masks[position / 64] |= u64{1} << (position % 64);
+  }
+
+  little_u64* const words = reinterpret_cast<little_u64*>(block);
+  for (usize i = 0; i < word_masks.size(); ++i) {
+    if (word_masks[i] != 0) {
+      atomic_or_little_u64(&words[i], word_masks[i]);
+    }
+  }
+}
+
+}  // namespace llfs
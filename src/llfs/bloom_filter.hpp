@@ -22,18 +22,50 @@
 #include <batteries/static_assert.hpp>
 #include <batteries/suppress.hpp>
 
+#include <boost/endian/conversion.hpp>
 #include <boost/functional/hash.hpp>
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <type_traits>
+#include <vector>
 
 namespace llfs {
 
+/** \brief The arrangement of the bits of a PackedBloomFilter.
+ */
+enum struct BloomFilterLayout : u8 {
+  // Each of the `hash_count` bits for an item is in a random word of the whole filter; a query
+  // may touch up to `hash_count` cache lines.  All filters written before the layout was recorded
+  // in the filter header use this layout.
+  //
+  kFlat = 0,
+
+  // All the bits for an item are in the same 64-byte block (a single cache line, if the filter is
+  // 64-byte aligned), so a query touches one cache line.  The false positive rate is a bit higher
+  // than kFlat for the same size, and `hash_count` is at most
+  // PackedBloomFilter::kMaxBlockedHashCount.
+  //
+  kBlocked512 = 1,
+};
+
+std::ostream& operator<<(std::ostream& out, BloomFilterLayout t);
+
 struct BloomFilterParams {
   usize bits_per_item;
+  BloomFilterLayout layout = BloomFilterLayout::kFlat;
 };
 
-template <typename T, typename Fn>
-inline seq::LoopControl hash_for_bloom(const T& item, u64 count, Fn&& fn)
+// Calls `fn` with each of the `count` probe hashes for an item whose std::hash is `item_hash`
+// (BloomFilterLayout::kFlat), stopping early if `fn` returns seq::LoopControl::kBreak.
+//
+template <typename Fn>
+inline seq::LoopControl hash_for_bloom_from_item_hash(u64 item_hash, u64 count, Fn&& fn)
 {
   static constexpr u64 kSeeds[32] = {
       0xce3a9eb8b885d5afull, 0x33d9975b8a739ac6ull, 0xe65d0fff49425f03ull, 0x10bb3a132ec4fabcull,
@@ -49,7 +81,6 @@ inline seq::LoopControl hash_for_bloom(const T& item, u64 count, Fn&& fn)
     return b + 0x9e3779b9 + (a << 6) + (a >> 2);
   };
 
-  const u64 item_hash = std::hash<T>{}(item);
   usize seed = item_hash;
   for (u64 i = 0; i < count; ++i) {
     seed = mix_hash(seed, kSeeds[i % 32] + i / 32);
@@ -61,6 +92,58 @@ inline seq::LoopControl hash_for_bloom(const T& item, u64 count, Fn&& fn)
   return seq::LoopControl::kContinue;
 }
 
+template <typename T, typename Fn>
+inline seq::LoopControl hash_for_bloom(const T& item, u64 count, Fn&& fn)
+{
+  return hash_for_bloom_from_item_hash(std::hash<T>{}(item), count, BATT_FORWARD(fn));
+}
+
+// Returns the hash used to place `item` in a BloomFilterLayout::kBlocked512 filter: the upper 32
+// bits select the block and the lower 32 bits select the bits within it.
+//
+template <typename T>
+inline u64 hash_for_blocked_bloom(const T& item)
+{
+  // std::hash is the identity for many types; mix the bits (this is the MurmurHash3 finalizer) so
+  // that both halves are well distributed.
+  //
+  u64 h = std::hash<T>{}(item);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+// Returns true if all `hash_count` (at most PackedBloomFilter::kMaxBlockedHashCount) bits selected
+// by `hash_lo` are set in the 64-byte `block`.  Uses AVX2 (if the CPU supports it) or NEON.
+//
+bool blocked_bloom_block_contains(const u8* block, u32 hash_lo, usize hash_count) noexcept;
+
+// Same as blocked_bloom_block_contains, without SIMD instructions.
+//
+bool blocked_bloom_block_contains_portable(const u8* block, u32 hash_lo,
+                                           usize hash_count) noexcept;
+
+// Sets the `hash_count` bits selected by `hash_lo` in the 64-byte `block`.
+//
+void blocked_bloom_block_insert(u8* block, u32 hash_lo, usize hash_count) noexcept;
+
+// Same as blocked_bloom_block_insert, but sets the bits with atomic ORs (one per 64-bit word that
+// changes), so that concurrent inserts into the same block don't lose bits.  `block` must be 8-byte
+// aligned.
+//
+void blocked_bloom_block_insert_atomic(u8* block, u32 hash_lo, usize hash_count) noexcept;
+
+// Atomically sets the bits of `mask` in `*word`, which must be 8-byte aligned.
+//
+inline void atomic_or_little_u64(little_u64* word, u64 mask) noexcept
+{
+  __atomic_fetch_or(reinterpret_cast<u64*>(word), boost::endian::native_to_little(mask),
+                    __ATOMIC_RELAXED);
+}
+
 // Calculate the required bit rate for a given target false positive probability.
 //
 inline double optimal_bloom_filter_bit_rate(double target_false_positive_P)
@@ -79,16 +162,35 @@ struct PackedBloomFilter {
   //
   little_u16 hash_count;
 
-  // Align to 64-bit boundary.
+  little_u8 reserved_[2];
+
+  // The BloomFilterLayout, in the low 8 bits, tagged with kLayoutInfoMagic in the upper 24 bits
+  // (see `layout()`).
   //
-  little_u8 reserved_[6];
+  little_u32 layout_info;
 
-  // The actual filter array starts here (it will probably be larger than one element...)
+  // The actual filter array starts here (it will probably be larger than one element...)  Under
+  // BloomFilterLayout::kBlocked512 the filter words start at `words[kBlockedFirstWord]`.
   //
   little_u64 words[1];
 
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
+  static constexpr u32 kLayoutInfoMagic = 0xb100f100ul;
+  static constexpr u32 kLayoutInfoMagicMask = 0xffffff00ul;
+
+  // The number of 64-bit words in a BloomFilterLayout::kBlocked512 block.
+  //
+  static constexpr usize kBlockWords = 8;
+
+  // Under BloomFilterLayout::kBlocked512, the blocks start 64 bytes from the start of the filter
+  // header (i.e., this many words into `words`), so that they are cache-line aligned whenever the
+  // filter is.
+  //
+  static constexpr usize kBlockedFirstWord = 6;
+
+  static constexpr u16 kMaxBlockedHashCount = 16;
+
   // Approximate value of ln(2) * 65536 (fixed point, 16 bits decimal).
   //
   static constexpr u64 kLn2Fixed16 = 45426;
@@ -118,11 +220,58 @@ struct PackedBloomFilter {
 
   void initialize(const BloomFilterParams& params, usize item_count)
   {
-    const usize num_words = word_count_from_bit_count(params.bits_per_item * item_count);
+    const bool blocked = (params.layout == BloomFilterLayout::kBlocked512);
+
+    usize num_words = word_count_from_bit_count(params.bits_per_item * item_count);
+    if (blocked) {
+      num_words = std::max(num_words, kBlockWords);
+    }
     const usize filter_bit_count = num_words * 64;
 
     this->word_count_mask = num_words - 1;
     this->hash_count = optimal_hash_count(filter_bit_count, item_count);
+    if (blocked) {
+      this->hash_count = std::min<u16>(this->hash_count, kMaxBlockedHashCount);
+    }
+    std::memset(this->reserved_, 0, sizeof(this->reserved_));
+    this->layout_info = kLayoutInfoMagic | static_cast<u32>(params.layout);
+  }
+
+  BloomFilterLayout layout() const
+  {
+    const u32 info = this->layout_info.value();
+    if ((info & kLayoutInfoMagicMask) != kLayoutInfoMagic) {
+      return BloomFilterLayout::kFlat;
+    }
+    return static_cast<BloomFilterLayout>(info & ~kLayoutInfoMagicMask);
+  }
+
+  // The index in `words` of the first filter word.
+  //
+  usize first_word_index() const
+  {
+    return (this->layout() == BloomFilterLayout::kBlocked512) ? kBlockedFirstWord : 0;
+  }
+
+  const little_u64* filter_words() const
+  {
+    return this->words + this->first_word_index();
+  }
+
+  little_u64* filter_words()
+  {
+    return this->words + this->first_word_index();
+  }
+
+  const u8* block_from_hash(u64 hash_val) const
+  {
+    const u64 block_index = (hash_val >> 32) & (this->word_count_mask.value() / kBlockWords);
+    return reinterpret_cast<const u8*>(this->filter_words() + block_index * kBlockWords);
+  }
+
+  u8* block_from_hash(u64 hash_val)
+  {
+    return const_cast<u8*>(static_cast<const PackedBloomFilter*>(this)->block_from_hash(hash_val));
   }
 
   u64 index_from_hash(u64 hash_val) const
@@ -138,7 +287,67 @@ struct PackedBloomFilter {
   template <typename T>
   bool might_contain(const T& item) const
   {
-    return hash_for_bloom(item, this->hash_count, [this](u64 h) {
+    if (this->layout() == BloomFilterLayout::kBlocked512) {
+      const u64 h = hash_for_blocked_bloom(item);
+      return blocked_bloom_block_contains(this->block_from_hash(h), static_cast<u32>(h),
+                                          this->hash_count);
+    }
+
+    return this->flat_might_contain_item_hash(std::hash<T>{}(item));
+  }
+
+  // Sets `(*results)[i]` to `might_contain(items[i])` for all i (resizing `results` to
+  // items.size()).
+  //
+  // Works through `items` in chunks, first hashing every item in the chunk and prefetching the
+  // words (or block) it will probe, then testing them, so that the cache misses for the items in a
+  // chunk overlap instead of being taken one after another.
+  //
+  template <typename T>
+  void might_contain_batch(const batt::Slice<T>& items, std::vector<bool>* results) const
+  {
+    static constexpr usize kChunkSize = 32;
+
+    const bool blocked = (this->layout() == BloomFilterLayout::kBlocked512);
+    std::array<u64, kChunkSize> hashes;
+
+    results->resize(items.size());
+
+    for (usize chunk_begin = 0; chunk_begin < items.size(); chunk_begin += kChunkSize) {
+      const usize chunk_size = std::min(kChunkSize, items.size() - chunk_begin);
+
+      for (usize i = 0; i < chunk_size; ++i) {
+        const T& item = items[chunk_begin + i];
+        if (blocked) {
+          hashes[i] = hash_for_blocked_bloom(item);
+          const u8* const block = this->block_from_hash(hashes[i]);
+          __builtin_prefetch(block);
+          __builtin_prefetch(block + 63);
+        } else {
+          hashes[i] = std::hash<std::remove_const_t<T>>{}(item);
+          hash_for_bloom_from_item_hash(hashes[i], this->hash_count, [this](u64 h) {
+            __builtin_prefetch(&this->words[this->index_from_hash(h)]);
+          });
+        }
+      }
+
+      for (usize i = 0; i < chunk_size; ++i) {
+        if (blocked) {
+          (*results)[chunk_begin + i] = blocked_bloom_block_contains(
+              this->block_from_hash(hashes[i]), static_cast<u32>(hashes[i]), this->hash_count);
+        } else {
+          (*results)[chunk_begin + i] = this->flat_might_contain_item_hash(hashes[i]);
+        }
+      }
+    }
+  }
+
+  // BloomFilterLayout::kFlat only: returns `might_contain` for an item whose std::hash is
+  // `item_hash`.
+  //
+  bool flat_might_contain_item_hash(u64 item_hash) const
+  {
+    return hash_for_bloom_from_item_hash(item_hash, this->hash_count, [this](u64 h) {
              if ((this->words[this->index_from_hash(h)].value() & this->bit_mask_from_hash(h)) ==
                  0) {
                return seq::LoopControl::kBreak;
@@ -150,6 +359,12 @@ struct PackedBloomFilter {
   template <typename T>
   void insert(const T& item)
   {
+    if (this->layout() == BloomFilterLayout::kBlocked512) {
+      const u64 h = hash_for_blocked_bloom(item);
+      blocked_bloom_block_insert(this->block_from_hash(h), static_cast<u32>(h), this->hash_count);
+      return;
+    }
+
     hash_for_bloom(item, this->hash_count, [this](u64 h) {
       this->words[this->index_from_hash(h)] |= this->bit_mask_from_hash(h);
     });
@@ -157,7 +372,8 @@ struct PackedBloomFilter {
 
   void clear()
   {
-    std::memset(this->words, 0, sizeof(little_u64) * (this->word_count_mask + 1));
+    std::memset(this->words, 0,
+                sizeof(little_u64) * (this->first_word_index() + this->word_count_mask + 1));
   }
 
   usize word_count() const
@@ -167,15 +383,19 @@ struct PackedBloomFilter {
 
   batt::Slice<const little_u64> get_words() const
   {
-    return batt::as_slice(this->words, this->word_count());
+    return batt::as_slice(this->filter_words(), this->word_count());
   }
 };
 
 BATT_STATIC_ASSERT_EQ(sizeof(PackedBloomFilter), 24);
+BATT_STATIC_ASSERT_EQ(offsetof(PackedBloomFilter, words) +
+                          PackedBloomFilter::kBlockedFirstWord * sizeof(little_u64),
+                      64);
 
 inline usize packed_sizeof(const PackedBloomFilter& filter)
 {
-  return sizeof(PackedBloomFilter) + sizeof(little_u64) * filter.word_count_mask;
+  return sizeof(PackedBloomFilter) +
+         sizeof(little_u64) * (filter.first_word_index() + filter.word_count_mask);
 }
 
 inline usize packed_sizeof_bloom_filter(const BloomFilterParams& params, usize item_count)
@@ -212,6 +432,7 @@ void parallel_build_bloom_filter(batt::WorkerPool& worker_pool, Iter first, Iter
       auto* partial = reinterpret_cast<PackedBloomFilter*>(ptr);
       partial->word_count_mask = filter->word_count_mask;
       partial->hash_count = filter->hash_count;
+      partial->layout_info = filter->layout_info;
       temp_filters.emplace_back(partial);
     }
   }
@@ -251,10 +472,11 @@ void parallel_build_bloom_filter(batt::WorkerPool& worker_pool, Iter first, Iter
                              /*gen_work_fn=*/
                              [&](usize /*task_index*/, isize task_offset, isize task_size) {
                                return [task_offset, task_size, filter, &temp_filters] {
+                                 little_u64* const dst = filter->filter_words();
                                  for (isize i = task_offset; i < task_offset + task_size; ++i) {
-                                   filter->words[i] = 0;
+                                   dst[i] = 0;
                                    for (PackedBloomFilter* partial : temp_filters) {
-                                     filter->words[i] |= partial->words[i];
+                                     dst[i] |= partial->filter_words()[i];
                                    }
                                  }
                                };
@@ -263,6 +485,66 @@ void parallel_build_bloom_filter(batt::WorkerPool& worker_pool, Iter first, Iter
   }
 }
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Builds a PackedBloomFilter from a stream of pre-computed item hashes.
+//
+// parallel_build_bloom_filter needs random access to all the items up front, and a temporary
+// filter per input shard.  This instead sets the bits of each hash as it arrives, using atomic
+// ORs, so any number of threads can insert into the same builder at once and no memory is needed
+// beyond the filter itself.
+//
+// `insert_hash(h)` sets the same bits as `filter->insert(h)` (for `u64 h`); so if `h` is
+// `hash_fn(item)` for the `hash_fn` that would have been passed to parallel_build_bloom_filter,
+// the result is the same filter.
+//
+// The filter must be initialized (sized for the expected item count) and cleared before the first
+// insert, and must be 8-byte aligned.  The inserts are only guaranteed to be visible to other
+// threads once they have synchronized with the inserting threads (e.g., by joining them).
+//
+class StreamingBloomFilterBuilder
+{
+ public:
+  explicit StreamingBloomFilterBuilder(PackedBloomFilter* filter) noexcept
+      : filter_{filter}
+      , blocked_{filter->layout() == BloomFilterLayout::kBlocked512}
+  {
+    BATT_CHECK_EQ(reinterpret_cast<std::uintptr_t>(filter->words) % alignof(u64), 0u);
+  }
+
+  PackedBloomFilter* filter() const noexcept
+  {
+    return this->filter_;
+  }
+
+  void insert_hash(u64 item_hash) noexcept
+  {
+    PackedBloomFilter* const filter = this->filter_;
+
+    if (this->blocked_) {
+      const u64 h = hash_for_blocked_bloom(item_hash);
+      blocked_bloom_block_insert_atomic(filter->block_from_hash(h), static_cast<u32>(h),
+                                        filter->hash_count);
+      return;
+    }
+
+    hash_for_bloom(item_hash, filter->hash_count, [filter](u64 h) {
+      atomic_or_little_u64(&filter->words[filter->index_from_hash(h)],
+                           PackedBloomFilter::bit_mask_from_hash(h));
+    });
+  }
+
+  void insert_hashes(const batt::Slice<const u64>& item_hashes) noexcept
+  {
+    for (const u64 item_hash : item_hashes) {
+      this->insert_hash(item_hash);
+    }
+  }
+
+ private:
+  PackedBloomFilter* filter_;
+  bool blocked_;
+};
+
 }  // namespace llfs
 
 #endif  // LLFS_BLOOM_FILTER_HPP
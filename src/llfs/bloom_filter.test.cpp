@@ -13,21 +13,40 @@
 #include <llfs/metrics.hpp>
 #include <llfs/slice.hpp>
 
+#include <cstring>
 #include <random>
 #include <sstream>
+#include <thread>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 namespace {
 
+// Test Plan:
+//
+//  1. (RandomItems) Flat filters have no false negatives, and their false positive rate matches the
+//     theoretical rate.
+//  2. (BlockedRandomItems) Blocked filters have no false negatives, and a false positive rate close
+//     to that of a flat filter of the same size.
+//  3. (BlockedProbeMatchesPortable) The SIMD block test agrees with the portable one for all hash
+//     counts.
+//  4. (LayoutVersion) A filter header without a valid layout tag (as written before the layout was
+//     recorded) is read as BloomFilterLayout::kFlat.
+//  5. (MightContainBatch) might_contain_batch gives the same answers as might_contain, for both
+//     layouts and for batch sizes that aren't a multiple of the chunk size.
+//  6. (StreamingBuilder) StreamingBloomFilterBuilder, fed from several threads at once, builds the
+//     same filter as serial inserts of the same hashes, for both layouts.
+
 using llfs::as_slice;
+using llfs::BloomFilterLayout;
 using llfs::BloomFilterParams;
 using llfs::LatencyMetric;
 using llfs::LatencyTimer;
 using llfs::packed_sizeof_bloom_filter;
 using llfs::PackedBloomFilter;
 using llfs::parallel_build_bloom_filter;
+using llfs::StreamingBloomFilterBuilder;
 
 using namespace llfs::int_types;
 
@@ -166,4 +185,225 @@ TEST(BloomFilterTest, RandomItems)
                   << " query rate (key*bits/sec) == " << query_latency.rate_per_second();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+TEST(BloomFilterTest, BlockedRandomItems)
+{
+  std::default_random_engine rng{/*seed=*/51};
+
+  std::vector<std::string> items;
+  const usize n_items = 10 * 1000;
+  for (usize i = 0; i < n_items; ++i) {
+    items.emplace_back(make_random_word(rng));
+  }
+  std::sort(items.begin(), items.end());
+
+  const auto items_contains = [&items](const std::string& s) {
+    return std::binary_search(items.begin(), items.end(), s);
+  };
+
+  for (usize bits_per_item = 1; bits_per_item < 16; ++bits_per_item) {
+    const BloomFilterParams params{
+        .bits_per_item = bits_per_item,
+        .layout = BloomFilterLayout::kBlocked512,
+    };
+
+    std::unique_ptr<u8[]> memory{new u8[packed_sizeof_bloom_filter(params, items.size())]};
+    PackedBloomFilter* filter = (PackedBloomFilter*)memory.get();
+    *filter = PackedBloomFilter::from_params(params, items.size());
+
+    ASSERT_EQ(filter->layout(), BloomFilterLayout::kBlocked512);
+    ASSERT_LE(filter->hash_count, PackedBloomFilter::kMaxBlockedHashCount);
+    ASSERT_EQ(filter->word_count() % PackedBloomFilter::kBlockWords, 0u);
+
+    parallel_build_bloom_filter(
+        WorkerPool::default_pool(), items.begin(), items.end(),
+        [](const auto& v) -> decltype(auto) {
+          return v;
+        },
+        filter);
+
+    for (const std::string& s : items) {
+      EXPECT_TRUE(filter->might_contain(s));
+    }
+
+    usize total = 0;
+    usize false_positive = 0;
+    for (usize j = 0; j < n_items * 10; ++j) {
+      std::string query = make_random_word(rng);
+      if (items_contains(query)) {
+        continue;
+      }
+      total += 1;
+      if (filter->might_contain(query)) {
+        false_positive += 1;
+      }
+    }
+
+    const double k = filter->hash_count;
+    const double n = items.size();
+    const double m = filter->word_count() * 64;
+    const double flat_expected_rate = std::pow(1 - std::exp(-((k * (n + 0.5)) / (m - 1))), k);
+    const double actual_rate = double(false_positive) / double(total);
+
+    // Crowding within blocks costs some accuracy, mostly at high bit rates (where the rate is tiny
+    // anyway).
+    //
+    EXPECT_LT(actual_rate, flat_expected_rate * 2 + 0.0002)
+        << BATT_INSPECT(bits_per_item) << BATT_INSPECT(actual_rate)
+        << BATT_INSPECT(flat_expected_rate);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+TEST(BloomFilterTest, BlockedProbeMatchesPortable)
+{
+  std::default_random_engine rng{/*seed=*/1};
+  std::uniform_int_distribution<u32> pick_u32;
+
+  alignas(64) u8 block[64];
+
+  for (usize i = 0; i < 100 * 1000; ++i) {
+    // Make about half the bits set, so that both answers are common.
+    //
+    for (u8& b : block) {
+      b = static_cast<u8>(pick_u32(rng) | pick_u32(rng));
+    }
+    const u32 hash_lo = pick_u32(rng);
+    const usize hash_count = 1 + i % PackedBloomFilter::kMaxBlockedHashCount;
+
+    ASSERT_EQ(llfs::blocked_bloom_block_contains(block, hash_lo, hash_count),
+              llfs::blocked_bloom_block_contains_portable(block, hash_lo, hash_count))
+        << BATT_INSPECT(hash_lo) << BATT_INSPECT(hash_count);
+
+    alignas(64) u8 empty_block[64] = {0};
+    llfs::blocked_bloom_block_insert(empty_block, hash_lo, hash_count);
+    ASSERT_TRUE(llfs::blocked_bloom_block_contains(empty_block, hash_lo, hash_count));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+TEST(BloomFilterTest, LayoutVersion)
+{
+  PackedBloomFilter filter = PackedBloomFilter::from_params(
+      BloomFilterParams{.bits_per_item = 8, .layout = BloomFilterLayout::kBlocked512},
+      /*item_count=*/100);
+
+  EXPECT_EQ(filter.layout(), BloomFilterLayout::kBlocked512);
+  EXPECT_EQ(filter.first_word_index(), PackedBloomFilter::kBlockedFirstWord);
+
+  filter.layout_info = 0x12345601u;
+  EXPECT_EQ(filter.layout(), BloomFilterLayout::kFlat);
+  EXPECT_EQ(filter.first_word_index(), 0u);
+
+  filter = PackedBloomFilter::from_params(BloomFilterParams{.bits_per_item = 8}, 100);
+  EXPECT_EQ(filter.layout(), BloomFilterLayout::kFlat);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+TEST(BloomFilterTest, MightContainBatch)
+{
+  std::default_random_engine rng{/*seed=*/52};
+
+  std::vector<std::string> items;
+  for (usize i = 0; i < 1000; ++i) {
+    items.emplace_back(make_random_word(rng));
+  }
+
+  for (BloomFilterLayout layout : {BloomFilterLayout::kFlat, BloomFilterLayout::kBlocked512}) {
+    const BloomFilterParams params{
+        .bits_per_item = 6,
+        .layout = layout,
+    };
+
+    std::unique_ptr<u8[]> memory{new u8[packed_sizeof_bloom_filter(params, items.size())]};
+    PackedBloomFilter* filter = (PackedBloomFilter*)memory.get();
+    *filter = PackedBloomFilter::from_params(params, items.size());
+
+    filter->clear();
+    for (const std::string& s : items) {
+      filter->insert(s);
+    }
+
+    for (usize n_queries : {0, 1, 31, 32, 33, 1000}) {
+      std::vector<std::string> queries;
+      for (usize i = 0; i < n_queries; ++i) {
+        queries.emplace_back((i % 2) ? items[i % items.size()] : make_random_word(rng));
+      }
+
+      std::vector<bool> results(7, true);
+      filter->might_contain_batch(as_slice(queries), &results);
+
+      ASSERT_EQ(results.size(), queries.size());
+      for (usize i = 0; i < queries.size(); ++i) {
+        EXPECT_EQ(results[i], filter->might_contain(queries[i]))
+            << BATT_INSPECT(layout) << BATT_INSPECT(i) << BATT_INSPECT(queries[i]);
+      }
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// StreamingBloomFilterBuilder, fed the item hashes from several threads at once, builds exactly the
+// same filter as inserting the hashes one at a time.
+//
+TEST(BloomFilterTest, StreamingBuilder)
+{
+  std::default_random_engine rng{/*seed=*/60};
+
+  std::vector<u64> hashes;
+  for (usize i = 0; i < 20 * 1000; ++i) {
+    hashes.emplace_back(std::hash<std::string>{}(make_random_word(rng)));
+  }
+
+  for (BloomFilterLayout layout : {BloomFilterLayout::kFlat, BloomFilterLayout::kBlocked512}) {
+    const BloomFilterParams params{
+        .bits_per_item = 10,
+        .layout = layout,
+    };
+    const usize filter_size = packed_sizeof_bloom_filter(params, hashes.size());
+
+    std::unique_ptr<u64[]> expected_memory{new u64[(filter_size + 7) / 8]};
+    PackedBloomFilter* expected = (PackedBloomFilter*)expected_memory.get();
+    *expected = PackedBloomFilter::from_params(params, hashes.size());
+    expected->clear();
+    for (u64 h : hashes) {
+      expected->insert(h);
+    }
+
+    std::unique_ptr<u64[]> actual_memory{new u64[(filter_size + 7) / 8]};
+    PackedBloomFilter* actual = (PackedBloomFilter*)actual_memory.get();
+    *actual = PackedBloomFilter::from_params(params, hashes.size());
+    actual->clear();
+    {
+      StreamingBloomFilterBuilder builder{actual};
+
+      constexpr usize kThreadCount = 4;
+      constexpr usize kBatchSize = 100;
+
+      std::vector<std::thread> threads;
+      for (usize t = 0; t < kThreadCount; ++t) {
+        threads.emplace_back([&builder, &hashes, t] {
+          for (usize i = t * kBatchSize; i < hashes.size(); i += kThreadCount * kBatchSize) {
+            builder.insert_hashes(
+                as_slice(hashes.data() + i, std::min(kBatchSize, hashes.size() - i)));
+          }
+        });
+      }
+      for (std::thread& thread : threads) {
+        thread.join();
+      }
+    }
+
+    EXPECT_EQ(std::memcmp(expected, actual, filter_size), 0) << BATT_INSPECT(layout);
+
+    for (u64 h : hashes) {
+      EXPECT_TRUE(actual->might_contain(h));
+    }
+  }
+}
+
 }  // namespace
@@ -0,0 +1,131 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/buddy_allocator.hpp>
+//
+
+#include <batteries/assert.hpp>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ BuddyAllocator::BuddyAllocator(u64 total_size, u64 min_extent_size) noexcept
+    : total_size_{total_size}
+    , min_extent_size_{min_extent_size}
+{
+  BATT_CHECK_GT(min_extent_size, 0u);
+  BATT_CHECK_EQ(min_extent_size & (min_extent_size - 1), 0u)
+      << "min_extent_size must be a power of two";
+
+  usize max_order = 0;
+  while ((this->min_extent_size_ << (max_order + 1)) <= total_size &&
+         (this->min_extent_size_ << (max_order + 1)) != 0) {
+    ++max_order;
+  }
+  this->free_lists_.resize(max_order + 1);
+
+  // Cover [0, total_size) with the largest naturally aligned extents that fit.
+  //
+  u64 offset = 0;
+  for (usize order = max_order + 1; order > 0; --order) {
+    const u64 extent_size = this->min_extent_size_ << (order - 1);
+    while (offset + extent_size <= total_size) {
+      this->free_lists_[order - 1].insert(offset);
+      this->bytes_free_ += extent_size;
+      offset += extent_size;
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 BuddyAllocator::extent_size_for(u64 size) const
+{
+  u64 extent_size = this->min_extent_size_;
+  while (extent_size < size) {
+    extent_size <<= 1;
+  }
+  return extent_size;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize BuddyAllocator::order_of(u64 extent_size) const
+{
+  usize order = 0;
+  while ((this->min_extent_size_ << order) < extent_size) {
+    ++order;
+  }
+  return order;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<u64> BuddyAllocator::allocate(u64 size)
+{
+  const u64 extent_size = this->extent_size_for(size);
+  const usize order = this->order_of(extent_size);
+
+  // Find the smallest free extent that is large enough.
+  //
+  usize found_order = order;
+  while (found_order < this->free_lists_.size() && this->free_lists_[found_order].empty()) {
+    ++found_order;
+  }
+  if (found_order >= this->free_lists_.size()) {
+    return None;
+  }
+
+  auto iter = this->free_lists_[found_order].begin();
+  const u64 offset = *iter;
+  this->free_lists_[found_order].erase(iter);
+
+  // Split it, freeing the upper halves, until it is the requested size.
+  //
+  while (found_order > order) {
+    --found_order;
+    this->free_lists_[found_order].insert(offset + (this->min_extent_size_ << found_order));
+  }
+
+  this->bytes_free_ -= extent_size;
+
+  return offset;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void BuddyAllocator::free(u64 offset, u64 size)
+{
+  const u64 extent_size = this->extent_size_for(size);
+  usize order = this->order_of(extent_size);
+
+  BATT_CHECK_LT(order, this->free_lists_.size());
+  BATT_CHECK_EQ(offset % extent_size, 0u);
+  BATT_CHECK_LE(offset + extent_size, this->total_size_);
+
+  this->bytes_free_ += extent_size;
+
+  // Merge with the buddy for as long as it is free.
+  //
+  while (order + 1 < this->free_lists_.size()) {
+    const u64 buddy = offset ^ (this->min_extent_size_ << order);
+    auto iter = this->free_lists_[order].find(buddy);
+    if (iter == this->free_lists_[order].end()) {
+      break;
+    }
+    this->free_lists_[order].erase(iter);
+    offset = std::min(offset, buddy);
+    ++order;
+  }
+
+  const bool inserted = this->free_lists_[order].insert(offset).second;
+  BATT_CHECK(inserted) << "double free;" << BATT_INSPECT(offset) << BATT_INSPECT(size);
+}
+
+}  // namespace llfs
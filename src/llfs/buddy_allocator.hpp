@@ -0,0 +1,91 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_BUDDY_ALLOCATOR_HPP
+#define LLFS_BUDDY_ALLOCATOR_HPP
+
+#include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
+
+#include <set>
+#include <vector>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Allocates power-of-two-sized, naturally aligned extents of a linear address space (e.g.
+ * ranges of a file or block device) using the buddy system.
+ *
+ * Every extent is `min_extent_size << k` bytes for some k, and its offset is a multiple of its
+ * size.  Freeing an extent merges it with its buddy (the other half of the extent twice its size)
+ * whenever the buddy is free too, so the space freed by many small extents can later be allocated
+ * as one large extent and vice versa.
+ *
+ * Not thread-safe.
+ */
+class BuddyAllocator
+{
+ public:
+  /** \brief Creates an allocator for the range [0, total_size); `min_extent_size` must be a power
+   * of two.  If `total_size` isn't a multiple of `min_extent_size`, the remainder is never
+   * allocated.
+   */
+  explicit BuddyAllocator(u64 total_size, u64 min_extent_size) noexcept;
+
+  BuddyAllocator(const BuddyAllocator&) = delete;
+  BuddyAllocator& operator=(const BuddyAllocator&) = delete;
+
+  u64 total_size() const
+  {
+    return this->total_size_;
+  }
+
+  u64 min_extent_size() const
+  {
+    return this->min_extent_size_;
+  }
+
+  /** \brief The number of bytes not currently allocated.
+   */
+  u64 bytes_free() const
+  {
+    return this->bytes_free_;
+  }
+
+  /** \brief Returns the size of the extent that `allocate(size)` would return: `size` rounded up to
+   * a power of two, and at least `min_extent_size()`.
+   */
+  u64 extent_size_for(u64 size) const;
+
+  /** \brief Allocates an extent of `extent_size_for(size)` bytes.
+   *
+   * \return the offset of the extent, or None if there is no free extent that large.
+   */
+  Optional<u64> allocate(u64 size);
+
+  /** \brief Frees an extent returned by `allocate(size)` (passing the same size).
+   */
+  void free(u64 offset, u64 size);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  usize order_of(u64 extent_size) const;
+
+  const u64 total_size_;
+  const u64 min_extent_size_;
+  u64 bytes_free_ = 0;
+
+  // free_lists_[k] holds the offsets of the free extents of size `min_extent_size_ << k`.
+  //
+  std::vector<std::set<u64>> free_lists_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_BUDDY_ALLOCATOR_HPP
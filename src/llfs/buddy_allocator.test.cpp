@@ -0,0 +1,141 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/buddy_allocator.hpp>
+//
+#include <llfs/buddy_allocator.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+
+namespace {
+
+using namespace llfs::int_types;
+
+// Test Plan:
+//  1. Splitting and merging: allocate the smallest extent from an empty allocator, then free it;
+//     the whole range must be allocatable as one extent again.
+//  2. A total size that isn't a power of two is covered by smaller extents.
+//  3. Random allocate/free: extents never overlap, are aligned, bytes_free is exact, and freeing
+//     everything lets the whole range be allocated again.
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(BuddyAllocatorTest, SplitAndMerge)
+{
+  llfs::BuddyAllocator allocator{/*total_size=*/64 * 1024, /*min_extent_size=*/4096};
+
+  EXPECT_EQ(allocator.bytes_free(), 64u * 1024);
+  EXPECT_EQ(allocator.extent_size_for(1), 4096u);
+  EXPECT_EQ(allocator.extent_size_for(4097), 8192u);
+
+  llfs::Optional<u64> small = allocator.allocate(4096);
+  ASSERT_TRUE(small);
+  EXPECT_EQ(*small, 0u);
+  EXPECT_EQ(allocator.bytes_free(), 60u * 1024);
+
+  // The second half of the range is still one free extent.
+  //
+  llfs::Optional<u64> large = allocator.allocate(32 * 1024);
+  ASSERT_TRUE(large);
+  EXPECT_EQ(*large, 32u * 1024);
+
+  EXPECT_FALSE(allocator.allocate(32 * 1024));
+
+  allocator.free(*large, 32 * 1024);
+  allocator.free(*small, 4096);
+
+  EXPECT_EQ(allocator.bytes_free(), 64u * 1024);
+
+  llfs::Optional<u64> all = allocator.allocate(64 * 1024);
+  ASSERT_TRUE(all);
+  EXPECT_EQ(*all, 0u);
+  EXPECT_FALSE(allocator.allocate(1));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(BuddyAllocatorTest, NonPowerOfTwoTotal)
+{
+  llfs::BuddyAllocator allocator{/*total_size=*/(12 * 1024) + 100, /*min_extent_size=*/1024};
+
+  EXPECT_EQ(allocator.bytes_free(), 12u * 1024);
+
+  llfs::Optional<u64> first = allocator.allocate(8 * 1024);
+  ASSERT_TRUE(first);
+  EXPECT_EQ(*first, 0u);
+
+  EXPECT_FALSE(allocator.allocate(8 * 1024));
+
+  llfs::Optional<u64> second = allocator.allocate(4 * 1024);
+  ASSERT_TRUE(second);
+  EXPECT_EQ(*second, 8u * 1024);
+
+  EXPECT_EQ(allocator.bytes_free(), 0u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(BuddyAllocatorTest, RandomAllocateFree)
+{
+  constexpr u64 kTotalSize = 1024 * 1024;
+  constexpr u64 kMinExtentSize = 512;
+
+  for (u32 seed = 0; seed < 20; ++seed) {
+    std::default_random_engine rng{seed};
+    std::uniform_int_distribution<u64> pick_size{1, 64 * 1024};
+
+    llfs::BuddyAllocator allocator{kTotalSize, kMinExtentSize};
+
+    // offset -> extent size
+    std::map<u64, u64> allocated;
+    u64 bytes_allocated = 0;
+
+    for (usize i = 0; i < 2000; ++i) {
+      if (allocated.empty() || rng() % 3 != 0) {
+        const u64 size = pick_size(rng);
+        llfs::Optional<u64> offset = allocator.allocate(size);
+        if (!offset) {
+          continue;
+        }
+        const u64 extent_size = allocator.extent_size_for(size);
+        ASSERT_EQ(*offset % extent_size, 0u);
+        ASSERT_LE(*offset + extent_size, kTotalSize);
+
+        auto next = allocated.lower_bound(*offset);
+        if (next != allocated.end()) {
+          ASSERT_LE(*offset + extent_size, next->first);
+        }
+        if (next != allocated.begin()) {
+          auto prev = std::prev(next);
+          ASSERT_LE(prev->first + prev->second, *offset);
+        }
+
+        allocated.emplace(*offset, extent_size);
+        bytes_allocated += extent_size;
+      } else {
+        auto iter = std::next(allocated.begin(), rng() % allocated.size());
+        allocator.free(iter->first, iter->second);
+        bytes_allocated -= iter->second;
+        allocated.erase(iter);
+      }
+      ASSERT_EQ(allocator.bytes_free(), kTotalSize - bytes_allocated);
+    }
+
+    for (const auto& [offset, extent_size] : allocated) {
+      allocator.free(offset, extent_size);
+    }
+    EXPECT_EQ(allocator.bytes_free(), kTotalSize);
+    EXPECT_TRUE(allocator.allocate(kTotalSize));
+  }
+}
+
+}  // namespace
@@ -13,6 +13,7 @@
 #include <llfs/logging.hpp>
 
 #include <llfs/int_types.hpp>
+#include <llfs/lru_clock.hpp>
 #include <llfs/metrics.hpp>
 #include <llfs/optional.hpp>
 #include <llfs/slice.hpp>
@@ -21,8 +22,6 @@
 #include <batteries/async/mutex.hpp>
 #include <batteries/cpu_align.hpp>
 
-#include <boost/intrusive/list.hpp>
-#include <boost/intrusive/list_hook.hpp>
 #include <boost/intrusive_ptr.hpp>
 #include <boost/operators.hpp>
 #include <boost/smart_ptr/intrusive_ref_counter.hpp>
@@ -30,11 +29,10 @@
 #include <atomic>
 #include <functional>
 #include <memory>
+#include <random>
 
 namespace llfs {
 
-using CacheLRUHook = boost::intrusive::list_base_hook<boost::intrusive::tag<struct CacheLRUTag>>;
-
 using LogicalTimeStamp = u64;
 
 template <typename K, typename V>
@@ -68,24 +66,29 @@ class Cache : public boost::intrusive_ref_counter<Cache<K, V>>
   using Slot = AttachedCacheSlot<K, V>;
   using PinnedSlot = PinnedCacheSlot<K, V>;
 
-  static boost::intrusive_ptr<Cache> make_new(usize n_slots, const std::string& name)
+  // The default number of randomly chosen slots compared each time we look for a slot to evict.
+  //
+  static constexpr usize kDefaultEvictionCandidates = 8;
+
+  static boost::intrusive_ptr<Cache> make_new(
+      usize n_slots, const std::string& name,
+      usize eviction_candidates = kDefaultEvictionCandidates)
   {
-    return boost::intrusive_ptr<Cache>{new Cache{n_slots, name}};
+    return boost::intrusive_ptr<Cache>{new Cache{n_slots, name, eviction_candidates}};
   }
 
  private:
-  explicit Cache(usize n_slots, const std::string& name) noexcept
+  explicit Cache(usize n_slots, const std::string& name, usize eviction_candidates) noexcept
       : n_slots_{n_slots}
       , name_{name}
+      , eviction_candidates_{std::max<usize>(2, eviction_candidates)}
       , slots_{new batt::CpuCacheLineIsolated<Slot>[n_slots]}
   {
     initialize_status_codes();
 
     LLFS_VLOG(1) << "Cache(n_slots=" << n_slots << ")";
-    auto locked = this->free_pool_.lock();
     for (auto& isolated_slot : as_slice(this->slots_.get(), this->n_slots_)) {
       isolated_slot->set_cache_ptr(this);
-      locked->push_back(*isolated_slot.get());
     }
 
     this->metrics_.max_slots.set(n_slots);
@@ -133,10 +136,11 @@ class Cache : public boost::intrusive_ref_counter<Cache<K, V>>
     return this->metrics_;
   }
 
-  // Attempt to locate `key` in the cache.  If not found, attempt to allocate a slot (either from
-  // the free pool or by evicting an unpinned slot in LRU order) and fill it with the value returned
-  // by `factory`.  If the key is not found and a slot could not be allocated/evicted, return an
-  // empty PinnedSlot; else return a PinnedSlot that points ot the cached value.
+  // Attempt to locate `key` in the cache.  If not found, attempt to allocate a slot (either one
+  // that has never been used or by evicting an unpinned slot, approximately in LRU order) and fill
+  // it with the value returned by `factory`.  If the key is not found and a slot could not be
+  // allocated/evicted, return an empty PinnedSlot; else return a PinnedSlot that points ot the
+  // cached value.
   //
   // `factory` may be invoked with one or more internal locks held; therefore it MUST NOT invoke any
   // methods of this Cache object, directly or indirectly.
@@ -166,16 +170,11 @@ class Cache : public boost::intrusive_ref_counter<Cache<K, V>>
       this->metrics_.indexed_slots.set(locked_index->size());
     }
 
-    // Not found in the index.  Try grabbing a slot from the free pool.
+    // Not found in the index.  Try grabbing a slot that has never been used.
     //
-    {
-      auto locked_pool = this->free_pool_.lock();
-      if (!locked_pool->empty()) {
-        this->metrics_.alloc_count.fetch_add(1);
-        Slot& free_slot = locked_pool->front();
-        locked_pool->pop_front();
-        return this->fill_slot_and_insert(locked_index, free_slot, key, std::move(factory));
-      }
+    if (Slot* free_slot = this->allocate_unused()) {
+      this->metrics_.alloc_count.fetch_add(1);
+      return this->fill_slot_and_insert(locked_index, *free_slot, key, std::move(factory));
     }
 
     // No free slots; we must try to evict the least recently used one.
@@ -192,9 +191,17 @@ class Cache : public boost::intrusive_ref_counter<Cache<K, V>>
       this->metrics_.evict_count.fetch_add(1);
     }
 
-    // Erase the old key from the index, since this slot has been evicted.
+    // Erase the old key from the index, since this slot has been evicted.  The slot may have been
+    // cleared, or its key erased (and possibly re-inserted elsewhere) while it was pinned, so only
+    // remove the index entry if it still points at this slot.
     //
-    locked_index->erase(lru_slot->key());
+    if (lru_slot->has_key()) {
+      auto old_iter = locked_index->find(lru_slot->key());
+      if (old_iter != locked_index->end() && this->slots_[old_iter->second].get() == lru_slot) {
+        locked_index->erase(old_iter);
+        this->metrics_.indexed_slots.set(locked_index->size());
+      }
+    }
 
     return this->fill_slot_and_insert(locked_index, *lru_slot, key, std::move(factory));
   }
@@ -227,44 +234,81 @@ class Cache : public boost::intrusive_ref_counter<Cache<K, V>>
   }
 
  private:
-  using LRUList = boost::intrusive::list<Slot, boost::intrusive::base_hook<CacheLRUHook>>;
+  // Returns a slot that has never been filled, or nullptr if all slots have been handed out at
+  // least once.  Slots are never returned to this "free pool"; once in use, they are only
+  // recycled via eviction.
+  //
+  Slot* allocate_unused()
+  {
+    if (this->n_allocated_.load() < this->n_slots_) {
+      const usize allocated_i = this->n_allocated_.fetch_add(1);
+      if (allocated_i < this->n_slots_) {
+        return this->slots_[allocated_i].get();
+      }
+      this->n_allocated_.fetch_sub(1);
+    }
+    return nullptr;
+  }
 
-  // Iterate through slots in LRU order, trying to evict one.  The worst case number of times
-  // through this loop is the number of threads actively pinning a slot right now.
+  // Samples `eviction_candidates_` slots at random and tries to evict whichever one has the
+  // earliest latest-use time stamp; this is repeated up to n_slots times.  If no sample succeeds
+  // (or the cache is small enough that sampling would look at every slot anyway), falls back to
+  // scanning all slots, so that we only report the cache as full when every slot really is pinned.
   //
   Slot* evict_lru()
   {
-    auto locked_lru = this->lru_.lock();
+    thread_local std::default_random_engine rng{/*seed=*/std::random_device{}()};
+
+    const usize n_slots = std::min(this->n_allocated_.load(), this->n_slots_);
+    if (n_slots == 0) {
+      return nullptr;
+    }
+
+    std::uniform_int_distribution<usize> pick_slot{0, n_slots - 1};
 
-    for (Slot& lru_slot : *locked_lru) {
-      if (lru_slot.evict()) {
-        if (lru_slot.CacheLRUHook::is_linked()) {
-          locked_lru->erase(locked_lru->iterator_to(lru_slot));
-          BATT_CHECK(!lru_slot.CacheLRUHook::is_linked());
+    for (usize attempts = 0; n_slots > this->eviction_candidates_ && attempts < n_slots;
+         ++attempts) {
+      Slot* lru_slot = nullptr;
+      for (usize k = 0; k < this->eviction_candidates_; ++k) {
+        Slot* nth_slot = this->slots_[pick_slot(rng)].get();
+        if (nth_slot->is_pinned()) {
+          continue;
         }
-        return &lru_slot;
+        if (!lru_slot || nth_slot->get_latest_use() - lru_slot->get_latest_use() < 0) {
+          lru_slot = nth_slot;
+        }
+      }
+      if (lru_slot && lru_slot->evict()) {
+        return lru_slot;
+      }
+    }
+
+    Slot* lru_slot = nullptr;
+    for (usize i = 0; i < n_slots; ++i) {
+      Slot* nth_slot = this->slots_[i].get();
+      if (nth_slot->is_valid() && !nth_slot->is_pinned() &&
+          (!lru_slot || nth_slot->get_latest_use() - lru_slot->get_latest_use() < 0)) {
+        lru_slot = nth_slot;
       }
     }
+    if (lru_slot && lru_slot->evict()) {
+      return lru_slot;
+    }
     return nullptr;
   }
 
-  // Attempt to evict a specific slot; if this succeeds, clear the slot and move it to the LRU-end
-  // of the LRU list (to allow it to be filled next).
+  // Attempt to evict a specific slot; if this succeeds, clear the slot and mark it as the next one
+  // to be evicted (to allow it to be filled next).
   //
   bool evict_and_clear_slot(Slot* slot)
   {
-    auto locked_lru = this->lru_.lock();
-
     if (!slot->evict()) {
       return false;
     }
     this->metrics_.evict_count.fetch_add(1);
 
-    if (slot->CacheLRUHook::is_linked()) {
-      locked_lru->erase(locked_lru->iterator_to(*slot));
-    }
-    locked_lru->push_front(*slot);
     slot->clear();
+    slot->set_expired();
 
     return true;
   }
@@ -290,45 +334,15 @@ class Cache : public boost::intrusive_ref_counter<Cache<K, V>>
     return pinned;
   };
 
-  //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
-  //
-  template <typename, typename>
-  friend class AttachedCacheSlot;
-
-  void notify_pinned(Slot* slot, u64 expected_state)
-  {
-    auto locked_lru = this->lru_.lock();
-    if (slot->get_state() == expected_state && slot->CacheLRUHook::is_linked()) {
-      locked_lru->erase(locked_lru->iterator_to(*slot));
-    }
-  }
-
-  void notify_unpinned(Slot* slot, u64 expected_state)
-  {
-    auto locked_lru = this->lru_.lock();
-    if (slot->get_state() == expected_state) {
-      if (slot->CacheLRUHook::is_linked()) {
-        locked_lru->erase(locked_lru->iterator_to(*slot));
-      }
-      // Front is least recently used; back is most recently used.
-      //
-      if (slot->get_obsolete_hint()) {
-        locked_lru->push_front(*slot);
-      } else {
-        locked_lru->push_back(*slot);
-      }
-      BATT_CHECK(slot->CacheLRUHook::is_linked());
-    }
-  }
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
   const usize n_slots_;
   const std::string name_;
+  const usize eviction_candidates_;
   std::unique_ptr<batt::CpuCacheLineIsolated<Slot>[]> slots_;
   batt::Mutex<std::unordered_map<K, usize>> index_;
   Metrics metrics_;
-  batt::Mutex<LRUList> free_pool_;
-  batt::Mutex<LRUList> lru_;
+  std::atomic<usize> n_allocated_{0};
 };
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
@@ -401,6 +415,14 @@ class CacheSlot
     return *this->key_;
   }
 
+  // Returns true iff the slot currently holds a key (i.e., it has been filled and not cleared).
+  // Only meaningful while the slot is pinned or in an invalid state.
+  //
+  bool has_key() const noexcept
+  {
+    return bool{this->key_};
+  }
+
   // Returns the current value held in the slot, if valid; if the slot is invalid, behavior is
   // undefined.
   //
@@ -465,8 +487,8 @@ class CacheSlot
   // matching the currently stored key in the slot.  If the slot is in an invalid state or the key
   // doesn't match, the operation will fail and an empty/invalid value is returned.
   //
-  // A slot is removed from the cache's LRU list when its pin count goes from 0 -> 1, and placed
-  // back at the "most recently used" end of the LRU list when the pin count goes from 1 -> 0.
+  // When the pin count goes from 1 -> 0, the slot's latest-use time stamp is updated so that
+  // (approximate) LRU eviction will prefer other slots.
   //
   PinnedCacheSlot<K, V> acquire_pin(const K& key)
   {
@@ -499,8 +521,6 @@ class CacheSlot
       return {};
     }
 
-    // Unlink from the LRU list when going from pin_count 0 -> 1.
-    //
     if (newly_pinned) {
       this->notify_pinned(new_state);
     }
@@ -530,7 +550,7 @@ class CacheSlot
   }
 
   // Decrease the pin count by 1.  If this unpins the slot, then also remove a single weak ref and
-  // place this slot at the MRU end of the LRU list.
+  // mark this slot as most recently used.
   //
   void release_pin() noexcept
   {
@@ -614,8 +634,7 @@ class CacheSlot
     this->set_valid();
   }
 
-  // Get the current state word.  This is used to make sure we don't reorder LRU list operations
-  // when transitioning from pinned to unpinned (and vice versa).
+  // Get the current state word.
   //
   u64 get_state() const
   {
@@ -623,8 +642,8 @@ class CacheSlot
   }
 
   // Give a hint to the cache as to whether this slot is likely to be needed again in the future. If
-  // obsolete_hint is true, then when the slot is unpinned, it will be placed in the next-to-evict
-  // LRU position.
+  // obsolete_hint is true, then when the slot is unpinned, it is given a latest-use time stamp far
+  // in the past, making it the preferred eviction victim.
   //
   void set_obsolete_hint(bool hint)
   {
@@ -674,13 +693,26 @@ class CacheSlot
 // impact of declaring AttachedCacheSlot a friend of Cache.
 //
 template <typename K, typename V>
-class AttachedCacheSlot
-    : public CacheSlot<K, V>
-    , public CacheLRUHook
+class AttachedCacheSlot : public CacheSlot<K, V>
 {
  public:
   using CacheSlot<K, V>::CacheSlot;
 
+  // Returns the LRUClock time stamp of the last time this slot was unpinned.
+  //
+  i64 get_latest_use() const noexcept
+  {
+    return this->latest_use_.load();
+  }
+
+  // Sets the latest-use time stamp to a very old value, so this slot is evicted before any slot
+  // that was unpinned normally.
+  //
+  void set_expired() noexcept
+  {
+    this->latest_use_.store(LRUClock::read_global() - (i64{1} << 56));
+  }
+
   void set_cache_ptr(Cache<K, V>* cache)
   {
     this->cache_ = cache;
@@ -692,14 +724,17 @@ class AttachedCacheSlot
   }
 
  private:
-  void notify_pinned(u64 expected_state) override
+  void notify_pinned(u64 /*expected_state*/) override
   {
-    this->cache_->notify_pinned(this, expected_state);
   }
 
-  void notify_unpinned(u64 expected_state) override
+  void notify_unpinned(u64 /*expected_state*/) override
   {
-    this->cache_->notify_unpinned(this, expected_state);
+    if (this->get_obsolete_hint()) {
+      this->set_expired();
+    } else {
+      this->latest_use_.store(LRUClock::advance_local());
+    }
   }
 
   void notify_first_ref_acquired() override
@@ -713,6 +748,7 @@ class AttachedCacheSlot
   }
 
   Cache<K, V>* cache_ = nullptr;
+  std::atomic<i64> latest_use_{0};
 };
 
 namespace detail {
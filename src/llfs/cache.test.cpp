@@ -13,6 +13,9 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <string>
+#include <vector>
+
 namespace {
 
 using llfs::Cache;
@@ -214,4 +217,73 @@ TEST(CacheTest, Basic)
   }
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Verify that, when every slot can be considered, the slot that was unpinned least recently is
+// evicted first, and that erased and obsolete slots are preferred over all others.
+//
+TEST(CacheTest, EvictsLeastRecentlyUnpinned)
+{
+  auto p_c = Cache<int, std::string>::make_new(4, "Test", /*eviction_candidates=*/8);
+  auto& c = *p_c;
+
+  const auto insert = [&c](int key) {
+    return c.find_or_insert(key, [key] {
+      return std::make_shared<std::string>(std::to_string(key));
+    });
+  };
+
+  std::vector<CacheSlotRef<int, std::string>> refs;
+  {
+    std::vector<PinnedCacheSlot<int, std::string>> pins;
+    for (int key : {1, 2, 3, 4}) {
+      auto pinned = insert(key);
+      ASSERT_TRUE(pinned.ok());
+      refs.emplace_back(*pinned);
+      pins.emplace_back(std::move(*pinned));
+    }
+
+    // Unpin in the order 3, 1, 4, 2.
+    //
+    for (usize i : {2, 0, 3, 1}) {
+      pins[i] = {};
+    }
+  }
+  EXPECT_EQ(c.metrics().alloc_count.load(), 4u);
+
+  auto slot5 = insert(5);
+  ASSERT_TRUE(slot5.ok());
+  EXPECT_FALSE(refs[2].pin());
+  EXPECT_TRUE(refs[0].pin());
+
+  // Unpinning 1 again (above) made it the most recently used, so 4 goes next.
+  //
+  auto slot6 = insert(6);
+  ASSERT_TRUE(slot6.ok());
+  EXPECT_FALSE(refs[3].pin());
+
+  // An erased slot is reused before anything else.
+  //
+  *slot5 = {};
+  *slot6 = {};
+  EXPECT_TRUE(c.erase(2));
+
+  auto slot7 = insert(7);
+  ASSERT_TRUE(slot7.ok());
+  EXPECT_TRUE(refs[0].pin());
+
+  // So is a slot with the obsolete hint set.
+  //
+  {
+    auto pinned = refs[0].pin();
+    ASSERT_TRUE(pinned);
+    pinned.slot()->set_obsolete_hint(true);
+  }
+  auto slot8 = insert(8);
+  ASSERT_TRUE(slot8.ok());
+  EXPECT_FALSE(refs[0].pin());
+
+  EXPECT_EQ(c.metrics().alloc_count.load(), 4u);
+  EXPECT_EQ(c.metrics().evict_count.load(), 5u);
+}
+
 }  // namespace
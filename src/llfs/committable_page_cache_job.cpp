@@ -9,7 +9,9 @@
 #include <llfs/committable_page_cache_job.hpp>
 //
 
+#include <llfs/finalized_page_index.hpp>
 #include <llfs/trace_refs_recursive.hpp>
+#include <llfs/trace_span.hpp>
 
 namespace llfs {
 
@@ -27,6 +29,10 @@ namespace llfs {
 
   auto committable_job = CommittablePageCacheJob{std::move(job)};
 
+  // Make the job's new pages visible to the jobs after it in the pipeline.
+  //
+  committable_job.add_to_page_index();
+
   // Calculate page reference count updates for all devices.
   //
   BATT_ASSIGN_OK_RESULT(committable_job.ref_count_updates_,
@@ -43,6 +49,8 @@ CommittablePageCacheJob::CommittablePageCacheJob(
     , tracker_{new FinalizedJobTracker{this->job_}}
 {
   BATT_CHECK(this->job_->is_pruned());
+
+  this->tracker_->page_index_ = this->job_->page_index();
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -56,6 +64,7 @@ CommittablePageCacheJob::~CommittablePageCacheJob() noexcept
       }
       return PageCacheJobProgress::kCancelled;
     });
+    this->remove_from_page_index();
   }
 }
 
@@ -196,6 +205,8 @@ Status CommittablePageCacheJob::commit_impl(const JobCommitParams& params, u64 c
 {
   BATT_CHECK_NOT_NULLPTR(params.caller_uuid);
 
+  LLFS_TRACE_SPAN("commit", "commit_impl");
+
   bool success = false;
   const auto on_return = batt::finally([&] {
     if (!success) {
@@ -219,8 +230,9 @@ Status CommittablePageCacheJob::commit_impl(const JobCommitParams& params, u64 c
 
   // Write new pages.
   //
-  Status write_status = LLFS_COLLECT_LATENCY(job->cache().metrics().page_write_latency,  //
-                                             this->write_new_pages());
+  Status write_status = LLFS_COLLECT_LATENCY(
+      job->cache().metrics().page_write_latency,
+      LLFS_TRACE_SPAN_EXPR("commit", "write_new_pages", this->write_new_pages()));
   BATT_REQUIRE_OK(write_status);
 
   // Make sure the ref_count_updates_ is initialized!
@@ -232,12 +244,15 @@ Status CommittablePageCacheJob::commit_impl(const JobCommitParams& params, u64 c
   //
   Status pipeline_status =
       LLFS_COLLECT_LATENCY(this->job_->cache().metrics().pipeline_wait_latency,  //
-                           this->job_->await_base_job_durable());
+                           LLFS_TRACE_SPAN_EXPR("commit", "await_base_job_durable",
+                                                this->job_->await_base_job_durable()));
   BATT_REQUIRE_OK(pipeline_status);
 
   if (durable_caller_slot) {
     BATT_CHECK(slot_less_than(prev_caller_slot, params.caller_slot));
-    BATT_REQUIRE_OK(await_slot_offset(prev_caller_slot, *durable_caller_slot));
+    BATT_REQUIRE_OK(LLFS_TRACE_SPAN_EXPR(
+        "commit", "await_prev_caller_slot",
+        await_slot_offset(prev_caller_slot, *durable_caller_slot)));
   }
 
   // Update ref counts, keeping track of the sync point for each device's allocator; this allows the
@@ -245,14 +260,18 @@ Status CommittablePageCacheJob::commit_impl(const JobCommitParams& params, u64 c
   //
   BATT_ASSIGN_OK_RESULT(DeadPages dead_pages,
                         LLFS_COLLECT_LATENCY(job->cache().metrics().update_ref_counts_latency,
-                                             this->start_ref_count_updates(
-                                                 params, this->ref_count_updates_, callers)));
+                                             LLFS_TRACE_SPAN_EXPR(
+                                                 "commit", "start_ref_count_updates",
+                                                 this->start_ref_count_updates(
+                                                     params, this->ref_count_updates_, callers))));
 
   // Wait for all ref count updates to complete.
   //
   Status ref_count_status =
       LLFS_COLLECT_LATENCY(job->cache().metrics().ref_count_sync_latency,
-                           this->await_ref_count_updates(this->ref_count_updates_));
+                           LLFS_TRACE_SPAN_EXPR(
+                               "commit", "await_ref_count_updates",
+                               this->await_ref_count_updates(this->ref_count_updates_)));
   BATT_REQUIRE_OK(ref_count_status);
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -260,6 +279,11 @@ Status CommittablePageCacheJob::commit_impl(const JobCommitParams& params, u64 c
   //
   this->tracker_->progress_.set_value(PageCacheJobProgress::kDurable);
 
+  // Later jobs can now load our new pages from the cache like any others.
+  //
+  this->remove_from_page_index();
+  this->update_dedup_index();
+
   if (durable_caller_slot) {
     const slot_offset_type prev_durable_slot = durable_caller_slot->set_value(params.caller_slot);
     BATT_CHECK_EQ(prev_durable_slot, prev_caller_slot);
@@ -268,7 +292,8 @@ Status CommittablePageCacheJob::commit_impl(const JobCommitParams& params, u64 c
   // If there are any dead pages, assign their ownership to the recycler.
   //  - TODO [tastolfi 2021-06-12] this can be moved to its own pipeline stage/task.
   //
-  Status recycle_status = this->recycle_dead_pages(params, dead_pages);
+  Status recycle_status = LLFS_TRACE_SPAN_EXPR("commit", "recycle_dead_pages",
+                                               this->recycle_dead_pages(params, dead_pages));
   BATT_REQUIRE_OK(recycle_status);
 
   // Drop any deleted pages from storage.
@@ -277,7 +302,8 @@ Status CommittablePageCacheJob::commit_impl(const JobCommitParams& params, u64 c
   // never be able to recover the refcounts that must go down because the page is being dropped.
   // `PageDevice::drop` is idempotent because of the generation number.
   //
-  Status drop_status = this->drop_deleted_pages(callers);
+  Status drop_status = LLFS_TRACE_SPAN_EXPR("commit", "drop_deleted_pages",
+                                             this->drop_deleted_pages(callers));
   BATT_REQUIRE_OK(drop_status);
 
   LLFS_VLOG(1) << "commit(PageCacheJob): done";
@@ -348,9 +374,9 @@ Status CommittablePageCacheJob::WriteNewPagesContext::start()
     for (auto& p : this->job->get_new_pages()) {
       const PageId page_id = p.first;
 
-      // There's no need to write recovered pages, since they are already durable; skip.
+      // There's no need to write recovered or streamed pages, since they are already durable; skip.
       //
-      if (this->job->is_recovered_page(page_id)) {
+      if (this->job->is_recovered_page(page_id) || p.second.is_streamed()) {
         this->ops[i].get_handler()(batt::OkStatus());
         continue;
       }
@@ -359,7 +385,8 @@ Status CommittablePageCacheJob::WriteNewPagesContext::start()
       std::shared_ptr<const PageView> new_page_view = new_page.view();
       BATT_CHECK_NOT_NULLPTR(new_page_view);
       BATT_CHECK_EQ(page_id, new_page_view->page_id());
-      BATT_CHECK(this->job->get_already_pinned(page_id) != None) << BATT_INSPECT(page_id);
+      // Pages added via `PageCacheJob::write_new_page` aren't pinned (or in the cache); the job's
+      // view keeps their buffers alive until they are written.
 
       // Finalize the client uuid and slot that uniquely identifies this transaction, so we can
       // guarantee exactly-once side effects in the presence of crashes.
@@ -376,8 +403,8 @@ Status CommittablePageCacheJob::WriteNewPagesContext::start()
 
       this->ops[i].page_id = page_id;
 
-      this->job->cache().arena_for_page_id(page_id).device().write(new_page.const_buffer(),
-                                                                   this->ops[i].get_handler());
+      this->job->cache().write_page(
+          this->job->cache().prepare_page_for_write(new_page.write_image()), &this->ops[i]);
 
       this->total_byte_count += page_size;
       this->used_byte_count += used_size;
@@ -444,9 +471,10 @@ auto CommittablePageCacheJob::start_ref_count_updates(const JobCommitParams& par
     const PageArena& arena = this->job_->cache().arena_for_device_id(device_id);
     device_state.p_arena = &arena;
 
+    BATT_ASSIGN_OK_RESULT(PageAllocator * allocator, arena.try_allocator());
     BATT_ASSIGN_OK_RESULT(
         device_state.sync_point,
-        arena.allocator().update_page_ref_counts(
+        allocator->update_page_ref_counts(
             *params.caller_uuid, params.caller_slot, as_seq(device_state.ref_count_updates),
             /*dead_page_fn=*/
             [&dead_pages, recycle_depth = params.recycle_depth](PageId dead_page_id) {
@@ -485,7 +513,9 @@ Status CommittablePageCacheJob::await_ref_count_updates(const PageRefCountUpdate
 auto CommittablePageCacheJob::get_page_ref_count_updates(u64 /*callers*/) const
     -> StatusOr<PageRefCountUpdates>
 {
-  std::unordered_map<PageId, i32, PageId::Hash> ref_count_delta = this->job_->get_root_set_delta();
+  const auto& root_set_delta = this->job_->get_root_set_delta();
+  std::unordered_map<PageId, i32, PageId::Hash> ref_count_delta{root_set_delta.begin(),
+                                                                 root_set_delta.end()};
 
   // New pages start with a ref count value of 2; 1 for the client doing the allocation, and 1 for
   // the future garabage collector that will release any references held by that page.
@@ -512,6 +542,7 @@ auto CommittablePageCacheJob::get_page_ref_count_updates(u64 /*callers*/) const
   // Trace deleted pages non-recursively, decrementing the ref counts of all pages they directly
   // reference.
   //
+  std::vector<PageId> deleted_page_refs;
   for (const auto& p : this->job_->get_deleted_pages()) {
     // Sanity check; deleted pages should have a ref_count_delta of kRefCount_1_to_0.
     //
@@ -524,13 +555,16 @@ auto CommittablePageCacheJob::get_page_ref_count_updates(u64 /*callers*/) const
 
     // Decrement ref counts.
     //
-    p.second->trace_refs() | seq::for_each([&ref_count_delta, deleted_page_id](PageId id) {
+    deleted_page_refs.clear();
+    p.second->append_refs_and_delta_base(&deleted_page_refs);
+
+    for (const PageId& id : deleted_page_refs) {
       if (id) {
         LLFS_VLOG(1) << " decrementing ref count for page " << id
                      << " (because it was referenced from deleted page " << deleted_page_id << ")";
         ref_count_delta[id] -= 1;
       }
-    });
+    }
   }
 
   // Build the final map of PageRefCount vectors, one per device.
@@ -552,6 +586,55 @@ auto CommittablePageCacheJob::get_page_ref_count_updates(u64 /*callers*/) const
   return updates;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void CommittablePageCacheJob::add_to_page_index()
+{
+  FinalizedPageIndex* const page_index = this->tracker_->page_index().get();
+  if (!page_index) {
+    return;
+  }
+  this->for_each_new_page_id([&](PageId page_id) {
+    page_index->insert(page_id, this->tracker_);
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void CommittablePageCacheJob::remove_from_page_index()
+{
+  FinalizedPageIndex* const page_index = this->tracker_->page_index().get();
+  if (!page_index) {
+    return;
+  }
+  this->for_each_new_page_id([&](PageId page_id) {
+    page_index->erase(page_id, this->tracker_.get());
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void CommittablePageCacheJob::update_dedup_index()
+{
+  PageDedupIndex* const dedup_index = this->job_->cache().dedup_index();
+  if (!dedup_index) {
+    return;
+  }
+
+  for (const auto& [page_id, pinned_page] : this->job_->get_deleted_pages()) {
+    dedup_index->erase(page_id);
+  }
+
+  // Skip pages that were pruned after being added.
+  //
+  const auto& new_pages = this->job_->get_new_pages();
+  for (const auto& [page_id, key] : this->job_->get_dedup_keys()) {
+    if (new_pages.count(page_id) && !this->job_->is_recovered_page(page_id)) {
+      dedup_index->insert(key, page_id);
+    }
+  }
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 void CommittablePageCacheJob::hint_pages_obsolete(
@@ -577,14 +660,18 @@ Status CommittablePageCacheJob::recycle_dead_pages(const JobCommitParams& params
 
   BATT_CHECK_NOT_NULLPTR(params.recycler.pointer());
 
-  BATT_ASSIGN_OK_RESULT(
-      slot_offset_type recycler_sync_point,
-      params.recycler.recycle_pages(as_slice(dead_pages.ids), params.recycle_grant,
-                                    params.recycle_depth + 1));
+  StatusOr<slot_offset_type> recycler_sync_point = [&] {
+    if (params.defer_recycling && params.recycle_depth == -1) {
+      return params.recycler.recycle_pages_deferred(as_slice(dead_pages.ids));
+    }
+    return params.recycler.recycle_pages(as_slice(dead_pages.ids), params.recycle_grant,
+                                         params.recycle_depth + 1);
+  }();
+  BATT_REQUIRE_OK(recycler_sync_point);
 
   LLFS_VLOG(1) << "commit(PageCacheJob): waiting for PageRecycler sync point";
 
-  return params.recycler.await_flush(recycler_sync_point);
+  return params.recycler.await_flush(*recycler_sync_point);
   //
   // IMPORTANT: we must only finalize the job after making sure the list of dead pages is flushed to
   // the page recycler's log.
@@ -111,6 +111,17 @@ class CommittablePageCacheJob
    */
   BoxedSeq<page_device_id_int> page_device_ids() const;
 
+  /** \brief Invokes `fn(PageId)` for each new page to be written by this job.  Same as
+   * `new_page_ids()`, without allocating a type-erased sequence.
+   */
+  template <typename Fn>
+  void for_each_new_page_id(Fn&& fn) const
+  {
+    for (const auto& kv_pair : this->job_->get_new_pages()) {
+      fn(kv_pair.first);
+    }
+  }
+
   /** \brief Returns the number of new pages to be written when this job is committed.
    */
   usize new_page_count() const noexcept;
@@ -206,6 +217,15 @@ class CommittablePageCacheJob
 
   Status drop_deleted_pages(u64 callers);
 
+  void add_to_page_index();
+
+  void remove_from_page_index();
+
+  // Once the job is durable: removes the job's deleted pages from the cache's dedup index (if any)
+  // and adds the new pages that were added via PageCacheJob::pin_new_or_dedup.
+  //
+  void update_dedup_index();
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   std::shared_ptr<const PageCacheJob> job_;
@@ -42,6 +42,16 @@ namespace llfs {
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 
+// Set to 1 iff the compiler supports C++20 coroutines (see <llfs/coro.hpp>).
+//
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define LLFS_HAS_COROUTINES 1
+#else
+#define LLFS_HAS_COROUTINES 0
+#endif
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+
 // Set to 1 to disable crc generation for pages.
 //
 #define LLFS_DISABLE_PAGE_CRC 1
@@ -0,0 +1,199 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/contention_profiler.hpp>
+//
+
+#include <batteries/env.hpp>
+
+#include <boost/stacktrace.hpp>
+
+#include <algorithm>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+//
+class ContentionProfiler::State
+{
+ public:
+  struct StackStats {
+    u64 wait_count = 0;
+    u64 total_wait_usec = 0;
+    boost::stacktrace::stacktrace stack;
+  };
+
+  struct SiteStats {
+    u64 wait_count = 0;
+    u64 total_wait_usec = 0;
+    u64 max_wait_usec = 0;
+    u64 untracked_stack_count = 0;
+
+    // Keyed by the hash of the stack; waits at stacks with colliding hashes are merged.
+    //
+    std::unordered_map<usize, StackStats> stacks;
+  };
+
+  std::mutex mutex;
+
+  std::unordered_map<std::string_view, SiteStats> sites;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ ContentionProfiler& ContentionProfiler::instance()
+{
+  // Intentionally leaked so that locks can still be profiled during static destruction.
+  //
+  static ContentionProfiler* const instance_ = new ContentionProfiler{};
+
+  return *instance_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ std::atomic<i64>& ContentionProfiler::threshold_nsec() noexcept
+{
+  static std::atomic<i64> threshold_nsec_{
+      batt::getenv_as<i64>("LLFS_CONTENTION_PROFILE_THRESHOLD_USEC").value_or(0) * 1000};
+
+  return threshold_nsec_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+ContentionProfiler::ContentionProfiler() : state_{std::make_unique<State>()}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+ContentionProfiler::~ContentionProfiler() noexcept
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void ContentionProfiler::record_wait(const char* site, std::chrono::steady_clock::duration wait)
+{
+  const u64 wait_usec = std::max<i64>(
+      0, std::chrono::duration_cast<std::chrono::microseconds>(wait).count());
+
+  // Capture the stack before locking, skipping this function and ContentionScope's destructor.
+  //
+  boost::stacktrace::stacktrace stack{/*skip=*/2, /*max_depth=*/kMaxStackDepth};
+  const usize stack_hash = boost::stacktrace::hash_value(stack);
+
+  std::unique_lock<std::mutex> lock{this->state_->mutex};
+
+  State::SiteStats& site_stats = this->state_->sites[site];
+
+  site_stats.wait_count += 1;
+  site_stats.total_wait_usec += wait_usec;
+  site_stats.max_wait_usec = std::max(site_stats.max_wait_usec, wait_usec);
+
+  auto iter = site_stats.stacks.find(stack_hash);
+  if (iter == site_stats.stacks.end()) {
+    if (site_stats.stacks.size() >= kMaxStacksPerSite) {
+      site_stats.untracked_stack_count += 1;
+      return;
+    }
+    iter = site_stats.stacks.emplace(stack_hash, State::StackStats{}).first;
+    iter->second.stack = std::move(stack);
+  }
+
+  iter->second.wait_count += 1;
+  iter->second.total_wait_usec += wait_usec;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::vector<ContentionSiteReport> ContentionProfiler::report() const
+{
+  std::vector<ContentionSiteReport> result;
+  {
+    std::unique_lock<std::mutex> lock{this->state_->mutex};
+
+    for (const auto& [site, site_stats] : this->state_->sites) {
+      ContentionSiteReport& site_report = result.emplace_back(ContentionSiteReport{
+          .site = std::string{site},
+          .wait_count = site_stats.wait_count,
+          .total_wait_usec = site_stats.total_wait_usec,
+          .max_wait_usec = site_stats.max_wait_usec,
+          .untracked_stack_count = site_stats.untracked_stack_count,
+          .stacks = {},
+      });
+
+      for (const auto& [stack_hash, stack_stats] : site_stats.stacks) {
+        site_report.stacks.emplace_back(ContentionStackReport{
+            .wait_count = stack_stats.wait_count,
+            .total_wait_usec = stack_stats.total_wait_usec,
+            .stack = boost::stacktrace::to_string(stack_stats.stack),
+        });
+      }
+    }
+  }
+
+  const auto by_total_wait_desc = [](const auto& l, const auto& r) {
+    return l.total_wait_usec > r.total_wait_usec;
+  };
+
+  std::sort(result.begin(), result.end(), by_total_wait_desc);
+  for (ContentionSiteReport& site_report : result) {
+    std::sort(site_report.stacks.begin(), site_report.stacks.end(), by_total_wait_desc);
+  }
+
+  return result;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void ContentionProfiler::print_report(std::ostream& out, usize max_stacks_per_site) const
+{
+  for (ContentionSiteReport& site_report : this->report()) {
+    if (site_report.stacks.size() > max_stacks_per_site) {
+      site_report.stacks.resize(max_stacks_per_site);
+    }
+    out << site_report << std::endl;
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void ContentionProfiler::reset()
+{
+  std::unique_lock<std::mutex> lock{this->state_->mutex};
+
+  this->state_->sites.clear();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, const ContentionSiteReport& t)
+{
+  out << t.site << ": waits=" << t.wait_count << " total_wait_usec=" << t.total_wait_usec
+      << " max_wait_usec=" << t.max_wait_usec;
+
+  if (t.untracked_stack_count != 0) {
+    out << " untracked_stacks=" << t.untracked_stack_count;
+  }
+
+  for (const ContentionStackReport& stack_report : t.stacks) {
+    out << std::endl
+        << "  -- waits=" << stack_report.wait_count
+        << " total_wait_usec=" << stack_report.total_wait_usec << std::endl
+        << stack_report.stack;
+  }
+
+  return out;
+}
+
+}  // namespace llfs
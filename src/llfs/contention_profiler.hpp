@@ -0,0 +1,190 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_CONTENTION_PROFILER_HPP
+#define LLFS_CONTENTION_PROFILER_HPP
+
+#include <llfs/int_types.hpp>
+
+#include <batteries/utility.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace llfs {
+
+/** \brief Aggregated slow lock waits at a single stack (see ContentionProfiler).
+ */
+struct ContentionStackReport {
+  u64 wait_count;
+  u64 total_wait_usec;
+
+  /** \brief The symbolized stack of one of the waits, innermost frame first.
+   */
+  std::string stack;
+};
+
+/** \brief Aggregated slow lock waits for a single lock site (see ContentionProfiler).
+ */
+struct ContentionSiteReport {
+  std::string site;
+  u64 wait_count;
+  u64 total_wait_usec;
+  u64 max_wait_usec;
+
+  /** \brief The number of waits whose stack was not kept, because the site already had
+   * ContentionProfiler::kMaxStacksPerSite distinct stacks.
+   */
+  u64 untracked_stack_count;
+
+  /** \brief Distinct stacks, in descending order of total wait time.
+   */
+  std::vector<ContentionStackReport> stacks;
+};
+
+std::ostream& operator<<(std::ostream& out, const ContentionSiteReport& t);
+
+/** \brief Opt-in profiler for lock contention: every lock acquisition wrapped in
+ * LLFS_PROFILE_LOCK_WAIT that waits at least `threshold()` is charged to its site (a string
+ * literal naming the lock) and to the stack of the waiting thread.
+ *
+ * The profiler is disabled (threshold 0) unless the environment variable
+ * LLFS_CONTENTION_PROFILE_THRESHOLD_USEC is set, or set_threshold is called.  While disabled, a
+ * profiled lock costs one relaxed atomic load; while enabled, it also reads the clock twice.  Only
+ * waits over the threshold take the profiler's mutex and capture a stack, so their overhead is
+ * bounded by the time already lost waiting.
+ */
+class ContentionProfiler
+{
+ public:
+  static constexpr usize kMaxStacksPerSite = 32;
+  static constexpr usize kMaxStackDepth = 32;
+
+  /** \brief Returns the global instance.
+   */
+  static ContentionProfiler& instance();
+
+  /** \brief Returns the minimum wait time that is recorded; zero means profiling is disabled.
+   */
+  static std::chrono::nanoseconds threshold() noexcept
+  {
+    return std::chrono::nanoseconds{
+        ContentionProfiler::threshold_nsec().load(std::memory_order_relaxed)};
+  }
+
+  /** \brief Changes the recording threshold; pass zero to disable profiling.
+   */
+  static void set_threshold(std::chrono::nanoseconds threshold) noexcept
+  {
+    ContentionProfiler::threshold_nsec().store(threshold.count(), std::memory_order_relaxed);
+  }
+
+  static bool is_enabled() noexcept
+  {
+    return ContentionProfiler::threshold_nsec().load(std::memory_order_relaxed) != 0;
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  ContentionProfiler(const ContentionProfiler&) = delete;
+  ContentionProfiler& operator=(const ContentionProfiler&) = delete;
+
+  ~ContentionProfiler() noexcept;
+
+  /** \brief Charges a wait of `wait` to `site` and the calling thread's current stack.  `site`
+   * must have static storage duration (e.g., a string literal); sites with the same name are
+   * aggregated together.
+   */
+  void record_wait(const char* site, std::chrono::steady_clock::duration wait);
+
+  /** \brief Returns the stats for every site with at least one recorded wait, in descending order
+   * of total wait time.
+   */
+  std::vector<ContentionSiteReport> report() const;
+
+  /** \brief Prints `report()`, showing at most `max_stacks_per_site` stacks for each site.
+   */
+  void print_report(std::ostream& out, usize max_stacks_per_site = 4) const;
+
+  /** \brief Discards all recorded waits.
+   */
+  void reset();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  class State;
+
+  static std::atomic<i64>& threshold_nsec() noexcept;
+
+  ContentionProfiler();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  std::unique_ptr<State> state_;
+};
+
+/** \brief Measures the time from construction to destruction, and reports it to the
+ * ContentionProfiler if it exceeds the threshold.
+ */
+class ContentionScope
+{
+ public:
+  explicit ContentionScope(const char* site) noexcept
+      : site_{site}
+      , start_{ContentionProfiler::is_enabled() ? std::chrono::steady_clock::now()
+                                                : std::chrono::steady_clock::time_point{}}
+  {
+  }
+
+  ContentionScope(const ContentionScope&) = delete;
+  ContentionScope& operator=(const ContentionScope&) = delete;
+
+  ~ContentionScope() noexcept
+  {
+    if (this->start_ != std::chrono::steady_clock::time_point{}) {
+      const auto wait = std::chrono::steady_clock::now() - this->start_;
+      if (wait >= ContentionProfiler::threshold()) {
+        ContentionProfiler::instance().record_wait(this->site_, wait);
+      }
+    }
+  }
+
+ private:
+  const char* site_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/** \brief Returns `lock_fn()` (which should acquire and return a lock), charging the time it takes
+ * to `site` in the ContentionProfiler.
+ */
+template <typename LockFn>
+inline decltype(auto) profile_lock_wait(const char* site, LockFn&& lock_fn)
+{
+  // The scope is destroyed after the return value (i.e., the lock) has been initialized.
+  //
+  ContentionScope scope{site};
+  return BATT_FORWARD(lock_fn)();
+}
+
+}  // namespace llfs
+
+/** \brief Evaluates the lock-acquiring expression `expr` under the ContentionProfiler; e.g.:
+ *
+ * auto locked = LLFS_PROFILE_LOCK_WAIT("PageAllocator::state_", this->state_.lock());
+ */
+#define LLFS_PROFILE_LOCK_WAIT(site, expr)                                                         \
+  ::llfs::profile_lock_wait((site), [&]() -> decltype(auto) {                                      \
+    return expr;                                                                                   \
+  })
+
+#endif  // LLFS_CONTENTION_PROFILER_HPP
@@ -0,0 +1,157 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/contention_profiler.hpp>
+//
+#include <llfs/contention_profiler.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. Lock waits are not recorded while the profiler is disabled, nor when they are shorter than
+//     the threshold.
+//  2. A wait longer than the threshold is charged to its site and stack; waits on the same site
+//     from different call paths are kept as separate stacks, and reset() discards everything.
+
+using namespace llfs::int_types;
+
+using llfs::ContentionProfiler;
+using llfs::ContentionSiteReport;
+
+constexpr auto kHoldTime = std::chrono::milliseconds(20);
+
+// Locks `mutex` from a helper thread, holds it for kHoldTime, and calls `fn` (which is expected
+// to lock `mutex`) once the helper holds the lock.
+//
+template <typename Fn>
+void wait_behind_holder(std::mutex& mutex, Fn&& fn)
+{
+  std::atomic<bool> locked{false};
+  std::thread holder{[&] {
+    std::unique_lock<std::mutex> lock{mutex};
+    locked = true;
+    std::this_thread::sleep_for(kHoldTime);
+  }};
+  while (!locked) {
+    std::this_thread::yield();
+  }
+  fn();
+  holder.join();
+}
+
+class ContentionProfilerTest : public ::testing::Test
+{
+ public:
+  void SetUp() override
+  {
+    this->saved_threshold_ = ContentionProfiler::threshold();
+    ContentionProfiler::instance().reset();
+  }
+
+  void TearDown() override
+  {
+    ContentionProfiler::set_threshold(this->saved_threshold_);
+    ContentionProfiler::instance().reset();
+  }
+
+  std::chrono::nanoseconds saved_threshold_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Test Plan (1)
+//
+TEST_F(ContentionProfilerTest, BelowThresholdOrDisabled)
+{
+  std::mutex mutex;
+
+  ContentionProfiler::set_threshold(std::chrono::nanoseconds{0});
+  EXPECT_FALSE(ContentionProfiler::is_enabled());
+
+  wait_behind_holder(mutex, [&] {
+    auto lock = LLFS_PROFILE_LOCK_WAIT("test::mutex", std::unique_lock<std::mutex>{mutex});
+  });
+
+  ContentionProfiler::set_threshold(std::chrono::seconds{10});
+  EXPECT_TRUE(ContentionProfiler::is_enabled());
+
+  wait_behind_holder(mutex, [&] {
+    auto lock = LLFS_PROFILE_LOCK_WAIT("test::mutex", std::unique_lock<std::mutex>{mutex});
+  });
+
+  EXPECT_TRUE(ContentionProfiler::instance().report().empty());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Test Plan (2)
+//
+TEST_F(ContentionProfilerTest, SlowWaitsBySiteAndStack)
+{
+  std::mutex mutex;
+
+  ContentionProfiler::set_threshold(std::chrono::milliseconds{1});
+
+  // Uncontended; should not be recorded.
+  //
+  {
+    auto lock = LLFS_PROFILE_LOCK_WAIT("test::mutex", std::unique_lock<std::mutex>{mutex});
+    EXPECT_TRUE(lock.owns_lock());
+  }
+
+  wait_behind_holder(mutex, [&] {
+    auto lock = LLFS_PROFILE_LOCK_WAIT("test::mutex", std::unique_lock<std::mutex>{mutex});
+    EXPECT_TRUE(lock.owns_lock());
+  });
+
+  {
+    std::vector<ContentionSiteReport> report = ContentionProfiler::instance().report();
+
+    ASSERT_EQ(report.size(), 1u);
+    EXPECT_EQ(report[0].site, "test::mutex");
+    EXPECT_EQ(report[0].wait_count, 1u);
+    EXPECT_GE(report[0].total_wait_usec, 1000u);
+    EXPECT_EQ(report[0].max_wait_usec, report[0].total_wait_usec);
+    ASSERT_EQ(report[0].stacks.size(), 1u);
+    EXPECT_EQ(report[0].stacks[0].wait_count, 1u);
+  }
+
+  // Same site name, different call path.
+  //
+  wait_behind_holder(mutex, [&] {
+    std::unique_lock<std::mutex> lock =
+        LLFS_PROFILE_LOCK_WAIT("test::mutex", std::unique_lock<std::mutex>{mutex});
+  });
+
+  {
+    std::vector<ContentionSiteReport> report = ContentionProfiler::instance().report();
+
+    ASSERT_EQ(report.size(), 1u);
+    EXPECT_EQ(report[0].wait_count, 2u);
+    EXPECT_EQ(report[0].stacks.size(), 2u);
+    EXPECT_GE(report[0].stacks[0].total_wait_usec, report[0].stacks[1].total_wait_usec);
+
+    std::ostringstream oss;
+    ContentionProfiler::instance().print_report(oss);
+    EXPECT_THAT(oss.str(), ::testing::HasSubstr("test::mutex: waits=2"));
+  }
+
+  ContentionProfiler::instance().reset();
+
+  EXPECT_TRUE(ContentionProfiler::instance().report().empty());
+}
+
+}  // namespace
@@ -0,0 +1,114 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/coro.hpp>
+//
+
+#if LLFS_HAS_COROUTINES
+
+#include <batteries/math.hpp>
+
+#include <algorithm>
+#include <new>
+
+namespace llfs {
+namespace coro {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class FrameAllocator
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ usize FrameAllocator::size_class_of(usize size) noexcept
+{
+  const usize size_log2 = batt::log2_ceil(std::max<usize>(size, usize{1} << kMinSizeLog2));
+  if (size_log2 > kMaxSizeLog2) {
+    return kNumSizeClasses;
+  }
+  return size_log2 - kMinSizeLog2;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ FrameAllocator& FrameAllocator::thread_local_instance() noexcept
+{
+  thread_local FrameAllocator instance;
+  return instance;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ void* FrameAllocator::allocate(usize size)
+{
+  const usize size_class = size_class_of(size);
+  if (size_class == kNumSizeClasses) {
+    return ::operator new(size);
+  }
+
+  FrameAllocator& local = thread_local_instance();
+
+  FreeFrame* frame = local.free_lists_[size_class];
+  if (frame != nullptr) {
+    local.free_lists_[size_class] = frame->next;
+    local.free_counts_[size_class] -= 1;
+    return frame;
+  }
+
+  return ::operator new(usize{1} << (size_class + kMinSizeLog2));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ void FrameAllocator::deallocate(void* ptr, usize size) noexcept
+{
+  const usize size_class = size_class_of(size);
+  if (size_class == kNumSizeClasses) {
+    ::operator delete(ptr);
+    return;
+  }
+
+  FrameAllocator& local = thread_local_instance();
+
+  if (local.free_counts_[size_class] >= kMaxCachedPerClass) {
+    ::operator delete(ptr);
+    return;
+  }
+
+  auto* frame = new (ptr) FreeFrame{local.free_lists_[size_class]};
+  local.free_lists_[size_class] = frame;
+  local.free_counts_[size_class] += 1;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ usize FrameAllocator::cached_count(usize size) noexcept
+{
+  const usize size_class = size_class_of(size);
+  if (size_class == kNumSizeClasses) {
+    return 0;
+  }
+  return thread_local_instance().free_counts_[size_class];
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+FrameAllocator::~FrameAllocator() noexcept
+{
+  for (FreeFrame*& head : this->free_lists_) {
+    while (head != nullptr) {
+      FreeFrame* const next = head->next;
+      ::operator delete(head);
+      head = next;
+    }
+  }
+}
+
+}  // namespace coro
+}  // namespace llfs
+
+#endif  // LLFS_HAS_COROUTINES
@@ -0,0 +1,494 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_CORO_HPP
+#define LLFS_CORO_HPP
+
+#include <llfs/config.hpp>
+//
+
+#if LLFS_HAS_COROUTINES
+
+#include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/async/watch.hpp>
+#include <batteries/utility.hpp>
+
+#include <array>
+#include <coroutine>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+namespace llfs {
+namespace coro {
+
+/** \brief Per-thread cache of coroutine frames, bucketed by power-of-2 size class.
+ *
+ * All coroutine types in this namespace allocate their frames here, so a steady-state workload
+ * (e.g., many concurrent lookups, each started and finished over and over) reuses the same frames
+ * instead of calling the global allocator for each operation.  Frames may be freed on a different
+ * thread than the one that allocated them; they then join the freeing thread's cache.
+ */
+class FrameAllocator
+{
+ public:
+  /** \brief The smallest/largest size classes; frames larger than 2^kMaxSizeLog2 bytes are not
+   * cached.
+   */
+  static constexpr usize kMinSizeLog2 = 6;
+  static constexpr usize kMaxSizeLog2 = 14;
+  static constexpr usize kNumSizeClasses = kMaxSizeLog2 - kMinSizeLog2 + 1;
+
+  /** \brief The maximum number of free frames kept per size class per thread.
+   */
+  static constexpr usize kMaxCachedPerClass = 1024;
+
+  /** \brief Returns memory for a coroutine frame of (at least) `size` bytes.
+   */
+  static void* allocate(usize size);
+
+  /** \brief Returns memory obtained from `allocate(size)`.
+   */
+  static void deallocate(void* ptr, usize size) noexcept;
+
+  /** \brief Returns the number of free frames cached by the calling thread for frames of the given
+   * size.
+   */
+  static usize cached_count(usize size) noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  FrameAllocator() = default;
+
+  FrameAllocator(const FrameAllocator&) = delete;
+  FrameAllocator& operator=(const FrameAllocator&) = delete;
+
+  ~FrameAllocator() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  struct FreeFrame {
+    FreeFrame* next;
+  };
+
+  /** \brief Returns the size class index for `size`, or kNumSizeClasses if it is too large to be
+   * cached.
+   */
+  static usize size_class_of(usize size) noexcept;
+
+  static FrameAllocator& thread_local_instance() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  std::array<FreeFrame*, kNumSizeClasses> free_lists_{};
+  std::array<usize, kNumSizeClasses> free_counts_{};
+};
+
+template <typename T>
+class Task;
+
+namespace detail {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+/** \brief Allocates coroutine frames via FrameAllocator.
+ */
+struct FrameAllocated {
+  static void* operator new(usize size)
+  {
+    return FrameAllocator::allocate(size);
+  }
+
+  static void operator delete(void* ptr, usize size) noexcept
+  {
+    FrameAllocator::deallocate(ptr, size);
+  }
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+/** \brief The parts of Task<T>::promise_type that don't depend on T.
+ */
+class TaskPromiseBase : public FrameAllocated
+{
+ public:
+  /** \brief Resumes the awaiting coroutine (if any) when the task finishes.
+   */
+  struct FinalAwaiter {
+    bool await_ready() const noexcept
+    {
+      return false;
+    }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> finished) noexcept
+    {
+      std::coroutine_handle<> continuation = finished.promise().continuation_;
+      if (continuation) {
+        return continuation;
+      }
+      return std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept
+    {
+    }
+  };
+
+  // Tasks are lazy: they don't start running until they are awaited.
+  //
+  std::suspend_always initial_suspend() const noexcept
+  {
+    return {};
+  }
+
+  FinalAwaiter final_suspend() const noexcept
+  {
+    return {};
+  }
+
+  void unhandled_exception() noexcept
+  {
+    this->exception_ = std::current_exception();
+  }
+
+  void set_continuation(std::coroutine_handle<> continuation) noexcept
+  {
+    this->continuation_ = continuation;
+  }
+
+ protected:
+  void rethrow_if_exception()
+  {
+    if (this->exception_) {
+      std::rethrow_exception(std::move(this->exception_));
+    }
+  }
+
+ private:
+  std::coroutine_handle<> continuation_;
+  std::exception_ptr exception_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename T>
+class TaskPromise : public TaskPromiseBase
+{
+ public:
+  Task<T> get_return_object() noexcept;
+
+  template <typename U>
+  void return_value(U&& value)
+  {
+    this->value_.emplace(BATT_FORWARD(value));
+  }
+
+  T take_result()
+  {
+    this->rethrow_if_exception();
+    BATT_CHECK(this->value_);
+    return std::move(*this->value_);
+  }
+
+ private:
+  Optional<T> value_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <>
+class TaskPromise<void> : public TaskPromiseBase
+{
+ public:
+  Task<void> get_return_object() noexcept;
+
+  void return_void() const noexcept
+  {
+  }
+
+  void take_result()
+  {
+    this->rethrow_if_exception();
+  }
+};
+
+}  // namespace detail
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A lazily started coroutine producing a value of type T; run it by `co_await`-ing it from
+ * another coroutine, or via `coro::start`.
+ *
+ * Unlike a batt::Task, a coro::Task has no stack of its own: its state lives in a (recycled) frame
+ * whose size is fixed by the compiler, so very large numbers of them can be in flight at once.
+ */
+template <typename T>
+class [[nodiscard]] Task
+{
+ public:
+  using promise_type = detail::TaskPromise<T>;
+  using Handle = std::coroutine_handle<promise_type>;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  Task() = default;
+
+  explicit Task(Handle handle) noexcept : handle_{handle}
+  {
+  }
+
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+
+  Task(Task&& that) noexcept : handle_{std::exchange(that.handle_, nullptr)}
+  {
+  }
+
+  Task& operator=(Task&& that) noexcept
+  {
+    if (this != &that) {
+      this->reset();
+      this->handle_ = std::exchange(that.handle_, nullptr);
+    }
+    return *this;
+  }
+
+  ~Task() noexcept
+  {
+    this->reset();
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  bool is_valid() const noexcept
+  {
+    return bool{this->handle_};
+  }
+
+  bool is_done() const noexcept
+  {
+    return this->handle_ && this->handle_.done();
+  }
+
+  /** \brief Destroys the coroutine (if any); must not be called while the task is running.
+   */
+  void reset() noexcept
+  {
+    if (this->handle_) {
+      this->handle_.destroy();
+      this->handle_ = nullptr;
+    }
+  }
+
+  /** \brief Starts the task, resuming the awaiting coroutine with its result when it finishes.
+   */
+  auto operator co_await() && noexcept
+  {
+    struct Awaiter {
+      Handle handle;
+
+      bool await_ready() const noexcept
+      {
+        return false;
+      }
+
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+      {
+        this->handle.promise().set_continuation(awaiting);
+        return this->handle;
+      }
+
+      T await_resume()
+      {
+        return this->handle.promise().take_result();
+      }
+    };
+
+    BATT_CHECK(this->handle_) << "co_await on an invalid coro::Task";
+
+    return Awaiter{this->handle_};
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  Handle handle_;
+};
+
+namespace detail {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename T>
+inline Task<T> TaskPromise<T>::get_return_object() noexcept
+{
+  return Task<T>{std::coroutine_handle<TaskPromise<T>>::from_promise(*this)};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+inline Task<void> TaskPromise<void>::get_return_object() noexcept
+{
+  return Task<void>{std::coroutine_handle<TaskPromise<void>>::from_promise(*this)};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+/** \brief An eagerly started coroutine that destroys itself when it finishes; used by
+ * `coro::start`.
+ */
+struct Detached {
+  struct promise_type : FrameAllocated {
+    Detached get_return_object() const noexcept
+    {
+      return {};
+    }
+
+    std::suspend_never initial_suspend() const noexcept
+    {
+      return {};
+    }
+
+    std::suspend_never final_suspend() const noexcept
+    {
+      return {};
+    }
+
+    void return_void() const noexcept
+    {
+    }
+
+    void unhandled_exception() const noexcept
+    {
+      std::terminate();
+    }
+  };
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename T, typename Handler>
+inline Detached run_detached(Task<T> task, Handler handler)
+{
+  if constexpr (std::is_void_v<T>) {
+    co_await std::move(task);
+    std::move(handler)();
+  } else {
+    std::move(handler)(co_await std::move(task));
+  }
+}
+
+}  // namespace detail
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+/** \brief Starts running `task` on the calling thread (until its first suspension point); when it
+ * finishes (on whichever thread resumes it last), passes its result to `handler`.
+ *
+ * The signature of the handler is: `void(T)` (or `void()` if T is void).
+ */
+template <typename T, typename Handler>
+inline void start(Task<T>&& task, Handler&& handler)
+{
+  detail::run_detached<T, std::decay_t<Handler>>(std::move(task), BATT_FORWARD(handler));
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Adapts a callback-style async operation to a coroutine awaitable.
+ *
+ * `start_fn` is called with a handler when the awaiting coroutine suspends; the coroutine is
+ * resumed (on whichever thread invokes the handler) with the value passed to the handler, of type
+ * R.  The operation's state lives in the awaiting coroutine's frame, so no allocation is needed
+ * beyond whatever the underlying async API does.
+ */
+template <typename R, typename StartFn>
+class AsyncOp
+{
+ public:
+  explicit AsyncOp(StartFn&& start_fn) noexcept : start_fn_{BATT_FORWARD(start_fn)}
+  {
+  }
+
+  AsyncOp(const AsyncOp&) = delete;
+  AsyncOp& operator=(const AsyncOp&) = delete;
+
+  bool await_ready() const noexcept
+  {
+    return false;
+  }
+
+  void await_suspend(std::coroutine_handle<> awaiting)
+  {
+    this->awaiting_ = awaiting;
+
+    // If the handler is invoked before `start_fn` returns, the awaiting coroutine (and `this`) may
+    // be gone by the time it does; so call a local copy, and don't touch `this` afterwards.
+    //
+    StartFn start_fn = std::move(this->start_fn_);
+    std::move(start_fn)(Handler{this});
+  }
+
+  R await_resume()
+  {
+    BATT_CHECK(this->result_);
+    return std::move(*this->result_);
+  }
+
+ private:
+  struct Handler {
+    AsyncOp* op;
+
+    template <typename... Args>
+    void operator()(Args&&... args) const
+    {
+      this->op->result_.emplace(BATT_FORWARD(args)...);
+      this->op->awaiting_.resume();
+    }
+  };
+
+  StartFn start_fn_;
+  Optional<R> result_;
+  std::coroutine_handle<> awaiting_;
+};
+
+/** \brief Returns an AsyncOp awaitable for the given start function; see AsyncOp.
+ */
+template <typename R, typename StartFn>
+inline AsyncOp<R, std::decay_t<StartFn>> async_op(StartFn&& start_fn)
+{
+  return AsyncOp<R, std::decay_t<StartFn>>{std::decay_t<StartFn>{BATT_FORWARD(start_fn)}};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+/** \brief Suspends until `pred(watch.get_value())` is true, returning the value that satisfied
+ * it, or error status if the watch is closed first.
+ */
+template <typename T, typename Pred>
+inline Task<StatusOr<T>> await_watch(batt::Watch<T>& watch, Pred pred)
+{
+  T observed = watch.get_value();
+
+  while (!pred(observed)) {
+    StatusOr<T> next = co_await async_op<StatusOr<T>>([&watch, observed](auto&& handler) {
+      watch.async_wait(observed, BATT_FORWARD(handler));
+    });
+    if (!next.ok()) {
+      co_return next.status();
+    }
+    observed = *next;
+  }
+
+  co_return observed;
+}
+
+}  // namespace coro
+}  // namespace llfs
+
+#endif  // LLFS_HAS_COROUTINES
+
+#endif  // LLFS_CORO_HPP
@@ -0,0 +1,219 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/coro.hpp>
+//
+#include <llfs/coro.hpp>
+
+#if LLFS_HAS_COROUTINES
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace {
+
+// Test Plan:
+//  1. Tasks are lazy, can await other tasks, and deliver values (and exceptions) to the awaiter.
+//  2. AsyncOp suspends the coroutine until the handler passed to the start function is invoked,
+//     possibly from another thread, and resumes it with the handler's argument.
+//  3. Coroutine frames are recycled by FrameAllocator.
+//  4. await_watch resumes once the watched value satisfies the predicate, or with an error if the
+//     watch is closed.
+
+using namespace llfs::int_types;
+
+namespace coro = llfs::coro;
+
+using llfs::None;
+using llfs::Optional;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+coro::Task<int> add_one(int x, int* call_count)
+{
+  *call_count += 1;
+  co_return x + 1;
+}
+
+coro::Task<int> add_two(int x, int* call_count)
+{
+  const int y = co_await add_one(x, call_count);
+  co_return co_await add_one(y, call_count);
+}
+
+coro::Task<int> throw_error()
+{
+  throw std::runtime_error{"oops"};
+  co_return 0;
+}
+
+coro::Task<std::string> catch_error()
+{
+  try {
+    (void)co_await throw_error();
+  } catch (const std::runtime_error& e) {
+    co_return std::string{e.what()};
+  }
+  co_return std::string{};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST(CoroTest, TaskComposition)
+{
+  int call_count = 0;
+
+  coro::Task<int> task = add_two(40, &call_count);
+
+  // Nothing runs until the task is started.
+  //
+  EXPECT_TRUE(task.is_valid());
+  EXPECT_FALSE(task.is_done());
+  EXPECT_EQ(call_count, 0);
+
+  Optional<int> result;
+  coro::start(std::move(task), [&result](int value) {
+    result = value;
+  });
+
+  EXPECT_EQ(call_count, 2);
+  EXPECT_EQ(result, 42);
+
+  Optional<std::string> caught;
+  coro::start(catch_error(), [&caught](std::string what) {
+    caught = std::move(what);
+  });
+
+  EXPECT_EQ(caught, "oops");
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST(CoroTest, AsyncOp)
+{
+  std::function<void(llfs::StatusOr<i32>)> saved_handler;
+
+  const auto fake_read = [&saved_handler]() -> coro::Task<llfs::StatusOr<i32>> {
+    co_return co_await coro::async_op<llfs::StatusOr<i32>>([&saved_handler](auto&& handler) {
+      saved_handler = BATT_FORWARD(handler);
+    });
+  };
+
+  Optional<llfs::StatusOr<i32>> result;
+  coro::start(fake_read(), [&result](llfs::StatusOr<i32> value) {
+    result = std::move(value);
+  });
+
+  // The coroutine is suspended waiting for the "I/O" to complete.
+  //
+  ASSERT_TRUE(saved_handler);
+  EXPECT_FALSE(result);
+
+  // Complete the operation from another thread.
+  //
+  std::thread{[&saved_handler] {
+    saved_handler(llfs::StatusOr<i32>{512});
+  }}.join();
+
+  ASSERT_TRUE(result);
+  ASSERT_TRUE(result->ok()) << BATT_INSPECT(result->status());
+  EXPECT_EQ(**result, 512);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 3.
+//
+TEST(CoroTest, FrameAllocatorRecyclesFrames)
+{
+  constexpr usize kFrameSize = 200;
+
+  void* const first = coro::FrameAllocator::allocate(kFrameSize);
+  const usize cached_before = coro::FrameAllocator::cached_count(kFrameSize);
+
+  coro::FrameAllocator::deallocate(first, kFrameSize);
+  EXPECT_EQ(coro::FrameAllocator::cached_count(kFrameSize), cached_before + 1);
+
+  // Any size in the same size class reuses the cached frame.
+  //
+  void* const second = coro::FrameAllocator::allocate(kFrameSize + 20);
+  EXPECT_EQ(second, first);
+  EXPECT_EQ(coro::FrameAllocator::cached_count(kFrameSize), cached_before);
+
+  coro::FrameAllocator::deallocate(second, kFrameSize + 20);
+
+  // Frames that are too large are not cached.
+  //
+  constexpr usize kLargeSize = (usize{1} << coro::FrameAllocator::kMaxSizeLog2) + 1;
+  void* const large = coro::FrameAllocator::allocate(kLargeSize);
+  coro::FrameAllocator::deallocate(large, kLargeSize);
+  EXPECT_EQ(coro::FrameAllocator::cached_count(kLargeSize), 0u);
+
+  // Running many coroutines in a row recycles the same frames.
+  //
+  int call_count = 0;
+  for (int i = 0; i < 1000; ++i) {
+    coro::start(add_two(i, &call_count), [](int) {
+    });
+  }
+  EXPECT_EQ(call_count, 2000);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 4.
+//
+TEST(CoroTest, AwaitWatch)
+{
+  batt::Watch<i64> watch{0};
+
+  Optional<llfs::StatusOr<i64>> result;
+  coro::start(coro::await_watch(watch,
+                                [](i64 value) {
+                                  return value >= 10;
+                                }),
+              [&result](llfs::StatusOr<i64> value) {
+                result = std::move(value);
+              });
+
+  EXPECT_FALSE(result);
+
+  watch.set_value(5);
+  EXPECT_FALSE(result);
+
+  watch.set_value(12);
+  ASSERT_TRUE(result);
+  ASSERT_TRUE(result->ok()) << BATT_INSPECT(result->status());
+  EXPECT_EQ(**result, 12);
+
+  // Closing the watch wakes the waiter with an error.
+  //
+  result = None;
+  coro::start(coro::await_watch(watch,
+                                [](i64 value) {
+                                  return value >= 100;
+                                }),
+              [&result](llfs::StatusOr<i64> value) {
+                result = std::move(value);
+              });
+
+  EXPECT_FALSE(result);
+
+  watch.close();
+  ASSERT_TRUE(result);
+  EXPECT_FALSE(result->ok());
+}
+
+}  // namespace
+
+#endif  // LLFS_HAS_COROUTINES
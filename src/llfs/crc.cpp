@@ -7,6 +7,21 @@
 //+++++++++++-+-+--+----- --- -- -  -  -   -
 
 #include <llfs/crc.hpp>
+//
+
+#include <batteries/assert.hpp>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#define LLFS_CRC32C_X86 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define LLFS_CRC32C_ARM 1
+#endif
 
 namespace llfs {
 
@@ -16,4 +31,167 @@ boost::crc_basic<64> make_crc64()
                               false);
 }
 
+namespace {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+inline u64 load_u64(const u8* p) noexcept
+{
+  u64 value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// "Slicing-by-8" tables for the reflected Castagnoli polynomial; table[0] is the ordinary bytewise
+// table, and table[k][b] is the CRC of byte b followed by k zero bytes.
+//
+using Crc32cTables = std::array<std::array<u32, 256>, 8>;
+
+const Crc32cTables& crc32c_tables() noexcept
+{
+  static const Crc32cTables tables = [] {
+    static constexpr u32 kReflectedPoly = 0x82f63b78ul;
+
+    Crc32cTables t;
+    for (u32 b = 0; b < 256; ++b) {
+      u32 crc = b;
+      for (int i = 0; i < 8; ++i) {
+        crc = (crc >> 1) ^ ((crc & 1) ? kReflectedPoly : 0);
+      }
+      t[0][b] = crc;
+    }
+    for (u32 b = 0; b < 256; ++b) {
+      for (usize k = 1; k < t.size(); ++k) {
+        t[k][b] = (t[k - 1][b] >> 8) ^ t[0][t[k - 1][b] & 0xff];
+      }
+    }
+    return t;
+  }();
+
+  return tables;
+}
+
+#if LLFS_CRC32C_X86
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+__attribute__((target("sse4.2"))) u32 crc32c_update_hw(u32 crc, const u8* p, usize n) noexcept
+{
+  while (n > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+    crc = _mm_crc32_u8(crc, *p);
+    ++p, --n;
+  }
+
+  u64 crc64 = crc;
+  while (n >= 8) {
+    crc64 = _mm_crc32_u64(crc64, load_u64(p));
+    p += 8, n -= 8;
+  }
+  crc = static_cast<u32>(crc64);
+
+  while (n > 0) {
+    crc = _mm_crc32_u8(crc, *p);
+    ++p, --n;
+  }
+  return crc;
+}
+
+bool detect_crc32c_hw() noexcept
+{
+  return __builtin_cpu_supports("sse4.2");
+}
+
+#elif LLFS_CRC32C_ARM
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u32 crc32c_update_hw(u32 crc, const u8* p, usize n) noexcept
+{
+  while (n > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+    crc = __crc32cb(crc, *p);
+    ++p, --n;
+  }
+  while (n >= 8) {
+    crc = __crc32cd(crc, load_u64(p));
+    p += 8, n -= 8;
+  }
+  while (n > 0) {
+    crc = __crc32cb(crc, *p);
+    ++p, --n;
+  }
+  return crc;
+}
+
+bool detect_crc32c_hw() noexcept
+{
+  // The compiler was told the target has the CRC32 extension.
+  //
+  return true;
+}
+
+#else
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u32 crc32c_update_hw(u32, const u8*, usize) noexcept
+{
+  BATT_PANIC() << "no hardware CRC32C on this platform";
+  BATT_UNREACHABLE();
+}
+
+bool detect_crc32c_hw() noexcept
+{
+  return false;
+}
+
+#endif
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// `crc` here is the raw (pre/post-inverted) register value.
+//
+u32 crc32c_update_portable(u32 crc, const u8* p, usize n) noexcept
+{
+  const Crc32cTables& t = crc32c_tables();
+
+  while (n >= 8) {
+    const u64 word = load_u64(p) ^ crc;
+    crc = t[7][word & 0xff] ^ t[6][(word >> 8) & 0xff] ^ t[5][(word >> 16) & 0xff] ^
+          t[4][(word >> 24) & 0xff] ^ t[3][(word >> 32) & 0xff] ^ t[2][(word >> 40) & 0xff] ^
+          t[1][(word >> 48) & 0xff] ^ t[0][word >> 56];
+    p += 8, n -= 8;
+  }
+  while (n > 0) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+    ++p, --n;
+  }
+  return crc;
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool crc32c_is_hardware_accelerated() noexcept
+{
+  static const bool has_hw = detect_crc32c_hw();
+  return has_hw;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u32 crc32c_extend(u32 crc, const void* data, usize size) noexcept
+{
+  const u8* p = static_cast<const u8*>(data);
+
+  if (crc32c_is_hardware_accelerated()) {
+    return ~crc32c_update_hw(~crc, p, size);
+  }
+  return ~crc32c_update_portable(~crc, p, size);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u32 crc32c_extend_portable(u32 crc, const void* data, usize size) noexcept
+{
+  return ~crc32c_update_portable(~crc, static_cast<const u8*>(data), size);
+}
+
 }  // namespace llfs
@@ -10,12 +10,37 @@
 #ifndef LLFS_CRC_HPP
 #define LLFS_CRC_HPP
 
+#include <llfs/int_types.hpp>
+
 #include <boost/crc.hpp>
 
 namespace llfs {
 
 boost::crc_basic<64> make_crc64();
 
+/** \brief Returns the CRC32C (Castagnoli) of `size` bytes at `data`, continuing from `crc` (the
+ * value returned for the bytes before these, or 0 to start a new checksum).
+ *
+ * Uses the SSE4.2 (x86-64) or ARMv8 CRC32 instructions when the CPU has them, otherwise falls back
+ * to crc32c_extend_portable.
+ */
+u32 crc32c_extend(u32 crc, const void* data, usize size) noexcept;
+
+/** \brief Table-driven CRC32C; returns the same values as crc32c_extend on any CPU.
+ */
+u32 crc32c_extend_portable(u32 crc, const void* data, usize size) noexcept;
+
+/** \brief Returns true if crc32c_extend uses CPU instructions on this machine.
+ */
+bool crc32c_is_hardware_accelerated() noexcept;
+
+/** \brief Returns the CRC32C of `size` bytes at `data`.
+ */
+inline u32 crc32c(const void* data, usize size) noexcept
+{
+  return crc32c_extend(0, data, size);
+}
+
 }  // namespace llfs
 
 #endif  // LLFS_CRC_HPP
@@ -0,0 +1,74 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/crc.hpp>
+//
+#include <llfs/crc.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//
+//  1. crc32c and crc32c_extend_portable give the standard check value for "123456789", and 0 for
+//     no data.
+//  2. The accelerated and portable implementations agree for all lengths and alignments, including
+//     when a checksum is built up from several pieces.
+
+using namespace llfs::int_types;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(CrcTest, Crc32cCheckValue)
+{
+  constexpr std::string_view kCheckInput = "123456789";
+
+  EXPECT_EQ(llfs::crc32c(kCheckInput.data(), kCheckInput.size()), 0xe3069283u);
+  EXPECT_EQ(llfs::crc32c_extend_portable(0, kCheckInput.data(), kCheckInput.size()), 0xe3069283u);
+
+  EXPECT_EQ(llfs::crc32c(kCheckInput.data(), 0), 0u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(CrcTest, Crc32cImplementationsAgree)
+{
+  std::default_random_engine rng{/*seed=*/1};
+  std::uniform_int_distribution<int> pick_byte{0, 255};
+
+  std::vector<u8> data(4096 + 16);
+  for (u8& b : data) {
+    b = static_cast<u8>(pick_byte(rng));
+  }
+
+  for (usize offset = 0; offset < 16; ++offset) {
+    for (usize size = 0; size < 300; ++size) {
+      const u8* const begin = data.data() + offset;
+
+      const u32 expected = llfs::crc32c_extend_portable(0, begin, size);
+
+      ASSERT_EQ(llfs::crc32c(begin, size), expected) << BATT_INSPECT(offset) << BATT_INSPECT(size);
+
+      const usize split = size / 3;
+      ASSERT_EQ(llfs::crc32c_extend(llfs::crc32c(begin, split), begin + split, size - split),
+                expected)
+          << BATT_INSPECT(offset) << BATT_INSPECT(size);
+    }
+  }
+
+  EXPECT_EQ(llfs::crc32c(data.data(), data.size()),
+            llfs::crc32c_extend_portable(0, data.data(), data.size()));
+}
+
+}  // namespace
@@ -16,8 +16,120 @@
 #include <batteries/stream_util.hpp>
 #include <batteries/suppress.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
 namespace llfs {
 
+namespace {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Copies `size` bytes from `src` to `dst` using non-temporal stores for the 16-byte aligned part of
+// the destination (x86-64; a plain memcpy elsewhere).
+//
+void copy_non_temporal(void* dst, const void* src, usize size)
+{
+#if defined(__x86_64__)
+  u8* dst_bytes = static_cast<u8*>(dst);
+  const u8* src_bytes = static_cast<const u8*>(src);
+
+  const usize misalignment = reinterpret_cast<uintptr_t>(dst) % 16;
+  const usize head_size = std::min<usize>(size, (16 - misalignment) % 16);
+  std::memcpy(dst_bytes, src_bytes, head_size);
+  dst_bytes += head_size;
+  src_bytes += head_size;
+  size -= head_size;
+
+  for (; size >= 64; size -= 64, dst_bytes += 64, src_bytes += 64) {
+    const __m128i* const from = reinterpret_cast<const __m128i*>(src_bytes);
+    __m128i* const to = reinterpret_cast<__m128i*>(dst_bytes);
+    const __m128i v0 = _mm_loadu_si128(from + 0);
+    const __m128i v1 = _mm_loadu_si128(from + 1);
+    const __m128i v2 = _mm_loadu_si128(from + 2);
+    const __m128i v3 = _mm_loadu_si128(from + 3);
+    _mm_stream_si128(to + 0, v0);
+    _mm_stream_si128(to + 1, v1);
+    _mm_stream_si128(to + 2, v2);
+    _mm_stream_si128(to + 3, v3);
+  }
+  std::memcpy(dst_bytes, src_bytes, size);
+
+  // Non-temporal stores are weakly ordered; make them visible before any later stores.
+  //
+  _mm_sfence();
+#else
+  std::memcpy(dst, src, size);
+#endif
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ usize DataPacker::calibrate_min_parallel_copy_size(batt::WorkerPool& worker_pool)
+{
+  // Copy about this much data per measurement, so that each one takes long enough to time.
+  //
+  constexpr usize kBytesPerMeasurement = 16 * kMiB;
+
+  // Parallel must beat serial by this factor to count (so noise doesn't pick a size too small).
+  //
+  constexpr double kMinSpeedup = 1.1;
+
+  usize result = kMaxCalibratedParallelCopySize;
+
+  if (worker_pool.size() != 0) {
+    std::vector<u8> src(kMaxCalibratedParallelCopySize * 2, 0x5a);
+    std::vector<u8> dst(src.size());
+
+    // Read from the destination after each copy, so the copies can't be optimized away.
+    //
+    volatile u8 sink = 0;
+
+    const auto time_copies = [&](usize copy_size, const auto& copy_fn) {
+      const usize repeat = std::max<usize>(4, kBytesPerMeasurement / copy_size);
+
+      const auto start = std::chrono::steady_clock::now();
+      for (usize i = 0; i < repeat; ++i) {
+        copy_fn(copy_size);
+        sink = sink + dst[copy_size - 1];
+      }
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    for (usize task_size = kMinCalibratedParallelCopySize;
+         task_size <= kMaxCalibratedParallelCopySize; task_size *= 2) {
+      // Compare a copy of two tasks' worth of data, done in one piece vs. split in two.
+      //
+      const usize copy_size = task_size * 2;
+
+      const double serial_time = time_copies(copy_size, [&](usize n) {
+        std::memcpy(dst.data(), src.data(), n);
+      });
+
+      const double parallel_time = time_copies(copy_size, [&](usize n) {
+        batt::ScopedWorkContext work_context{worker_pool};
+        batt::parallel_copy(work_context, src.data(), src.data() + n, dst.data(),
+                            batt::TaskSize{task_size}, batt::TaskCount{2});
+      });
+
+      if (parallel_time * kMinSpeedup < serial_time) {
+        result = task_size;
+        break;
+      }
+    }
+  }
+
+  return result;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 DataPacker::DataPacker(const MutableBuffer& buffer) noexcept : buffer_{buffer}
@@ -29,6 +141,7 @@ DataPacker::DataPacker(const MutableBuffer& buffer) noexcept : buffer_{buffer}
 DataPacker::DataPacker(DataPacker&& that) noexcept
     : buffer_{that.buffer_}
     , arena_{this, that.arena_.avail_}
+    , data_ref_log_{that.data_ref_log_}
 {
   that.invalidate();
 }
@@ -40,6 +153,7 @@ DataPacker& DataPacker::operator=(DataPacker&& that) noexcept
   if (BATT_HINT_TRUE(this != &that)) {
     this->buffer_ = that.buffer_;
     this->arena_ = std::move(that.arena_);
+    this->data_ref_log_ = that.data_ref_log_;
     that.invalidate();
   }
   return *this;
@@ -355,7 +469,7 @@ Optional<std::string_view> DataPacker::pack_raw_data(const void* data, usize siz
   u8* const dst_begin = static_cast<u8*>(buf->data());
   {
     const batt::TaskCount max_tasks{this->worker_pool_->size() + 1};
-    const batt::TaskSize min_task_size{DataPacker::min_parallel_copy_size()};
+    const batt::TaskSize min_task_size{this->parallel_copy_task_size()};
 
     batt::ScopedWorkContext work_context{*this->worker_pool_};
 
@@ -368,6 +482,24 @@ Optional<std::string_view> DataPacker::pack_raw_data(const void* data, usize siz
   return std::string_view{static_cast<const char*>(buf->data()), buf->size()};
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<std::string_view> DataPacker::pack_raw_data(const void* data, usize size,
+                                                     UseNonTemporalCopy use_non_temporal_copy)
+{
+  if (!use_non_temporal_copy || size < DataPacker::kMinNonTemporalCopySize) {
+    return this->pack_raw_data(data, size);
+  }
+
+  Optional<MutableBuffer> buf = this->arena_.allocate_front(size);
+  if (!buf) {
+    return None;
+  }
+  copy_non_temporal(buf->data(), data, size);
+
+  return std::string_view{static_cast<const char*>(buf->data()), buf->size()};
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 Optional<DataPacker::Arena> DataPacker::reserve_arena(usize size)
@@ -375,6 +507,15 @@ Optional<DataPacker::Arena> DataPacker::reserve_arena(usize size)
   return this->arena_.reserve_back(size);
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize DataPacker::parallel_copy_task_size() const
+{
+  BATT_CHECK(this->worker_pool_);
+
+  return this->min_parallel_copy_size_.value_or(DataPacker::min_parallel_copy_size().load());
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 usize DataPacker::estimate_packed_data_size(usize size) const
@@ -417,10 +558,14 @@ const void* DataPacker::nocheck_pack_data_to(PackedBytes* dst, const void* data,
   dst->data_offset = packed - reinterpret_cast<const u8*>(dst);
   dst->data_size = size;
 
+  if (this->data_ref_log_) {
+    this->data_ref_log_->push_back(dst);
+  }
+
   BATT_CHECK_EQ(reinterpret_cast<const u8*>(dst) + dst->data_offset, const_cast<const u8*>(packed));
   {
     const batt::TaskCount max_tasks{this->worker_pool_->size() + 1};
-    const batt::TaskSize min_task_size{DataPacker::min_parallel_copy_size()};
+    const batt::TaskSize min_task_size{this->parallel_copy_task_size()};
 
     batt::ScopedWorkContext work_context{*this->worker_pool_};
 
@@ -475,6 +620,10 @@ const void* DataPacker::nocheck_pack_data_large(PackedBytes* dst, const void* da
   dst->data_offset = packed - reinterpret_cast<const u8*>(dst);
   dst->data_size = size;
 
+  if (this->data_ref_log_) {
+    this->data_ref_log_->push_back(dst);
+  }
+
   BATT_CHECK_EQ(reinterpret_cast<const u8*>(dst) + dst->data_offset, const_cast<const u8*>(packed));
 
   std::memcpy(packed, data, size);
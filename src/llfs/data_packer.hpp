@@ -17,6 +17,9 @@
 #include <llfs/data_packer_arena.hpp>
 #include <llfs/interval.hpp>
 #include <llfs/optional.hpp>
+#include <llfs/packed_columnar_array.hpp>
+#include <llfs/packed_front_coded_strings.hpp>
+#include <llfs/packed_sorted_u64s.hpp>
 #include <llfs/packed_variant.hpp>
 #include <llfs/seq.hpp>
 #include <llfs/slice.hpp>
@@ -28,7 +31,9 @@
 
 #include <boost/range/iterator_range.hpp>
 
+#include <atomic>
 #include <cstddef>
+#include <vector>
 
 namespace llfs {
 
@@ -47,6 +52,22 @@ class DataPacker
     return value;
   }
 
+  /** \brief Measures single-threaded memcpy against parallel_copy on `worker_pool` and returns
+   * the smallest task size (a power of 2, between kMinCalibratedParallelCopySize and
+   * kMaxCalibratedParallelCopySize) at which splitting a copy into tasks of that size was
+   * measurably faster.  Takes on the order of 100ms; meant to be called once per pool at startup,
+   * by whoever owns the pool, which then passes the result to `set_worker_pool` along with it.
+   */
+  static usize calibrate_min_parallel_copy_size(batt::WorkerPool& worker_pool);
+
+  static constexpr usize kMinCalibratedParallelCopySize = 8 * kKiB;
+  static constexpr usize kMaxCalibratedParallelCopySize = 4 * kMiB;
+
+  /** \brief Copies smaller than this are done with a regular memcpy, even if non-temporal stores
+   * are requested.
+   */
+  static constexpr usize kMinNonTemporalCopySize = 4 * kKiB;
+
   template <typename T>
   using ArrayPacker = BasicArrayPacker<T, DataPacker>;
 
@@ -206,6 +227,14 @@ class DataPacker
   [[nodiscard]] Optional<std::string_view> pack_raw_data(const void* data, usize size,
                                                          UseParallelCopy use_parallel_copy);
 
+  // Same as `pack_raw_data(data, size)`, but copies the data with non-temporal stores (which
+  // bypass the CPU caches) when `use_non_temporal_copy` is true, `size` is at least
+  // kMinNonTemporalCopySize, and the CPU supports them (x86-64); e.g. for bulk page images that
+  // are written out rather than read back.
+  //
+  [[nodiscard]] Optional<std::string_view> pack_raw_data(const void* data, usize size,
+                                                         UseNonTemporalCopy use_non_temporal_copy);
+
   template <typename U, typename IntT, typename PackedIntT>
   [[nodiscard]] bool pack_int_impl(U val)
   {
@@ -316,6 +345,29 @@ class DataPacker
     return ArrayPacker<T>{array, this};
   }
 
+  /** \brief Allocates a PackedColumnarArray of `item_count` records (all fields zeroed), to be
+   * filled in through its Row proxies or columns.
+   *
+   * \return nullptr if there is not enough space.
+   */
+  template <typename... Fields>
+  PackedColumnarArray<Fields...>* pack_columnar_array(
+      usize item_count, batt::StaticType<PackedColumnarArray<Fields...>> = {})
+  {
+    using ArrayT = PackedColumnarArray<Fields...>;
+
+    Optional<MutableBuffer> buf =
+        this->arena_.allocate_front(packed_columnar_array_size<Fields...>(item_count));
+    if (!buf) {
+      return nullptr;
+    }
+
+    auto* array = reinterpret_cast<ArrayT*>(buf->data());
+    array->initialize(item_count);
+
+    return array;
+  }
+
   template <typename... Ts, typename T>
   PackedVariantInstance<PackedVariant<Ts...>, T>* pack_variant(
       batt::StaticType<PackedVariant<Ts...>>, batt::StaticType<T>)
@@ -338,6 +390,45 @@ class DataPacker
     return this->arena_.pack_varint(n);
   }
 
+  u8* pack_varints(const batt::Slice<const u64>& values)
+  {
+    return this->arena_.pack_varints(values);
+  }
+
+  /** \brief Packs `values` as a frame-of-reference compressed PackedSortedU64s (see
+   * packed_sorted_u64s.hpp).  Values that are sorted or clustered take the least space.
+   *
+   * \return nullptr if there is not enough space.
+   */
+  PackedSortedU64s* pack_sorted_u64s(const batt::Slice<const u64>& values)
+  {
+    Optional<MutableBuffer> buf = this->arena_.allocate_front(packed_sizeof_sorted_u64s(values));
+    if (!buf) {
+      return nullptr;
+    }
+
+    return pack_sorted_u64s_to(*buf, values);
+  }
+
+  /** \brief Packs `keys` as a front-coded string array with a restart point every
+   * `restart_interval` keys (see packed_front_coded_strings.hpp).  Keys that are sorted and share
+   * long prefixes take the least space.
+   *
+   * \return nullptr if there is not enough space.
+   */
+  PackedFrontCodedStrings* pack_front_coded_strings(
+      const batt::Slice<const std::string_view>& keys,
+      usize restart_interval = PackedFrontCodedStrings::kDefaultRestartInterval)
+  {
+    Optional<MutableBuffer> buf =
+        this->arena_.allocate_front(packed_sizeof_front_coded_strings(keys, restart_interval));
+    if (!buf) {
+      return nullptr;
+    }
+
+    return pack_front_coded_strings_to(*buf, keys, restart_interval);
+  }
+
   Interval<isize> unused() const
   {
     return this->arena_.unused();
@@ -362,14 +453,21 @@ class DataPacker
     return this->buffer_begin() + this->buffer_.size();
   }
 
-  void set_worker_pool(batt::WorkerPool& worker_pool) noexcept
+  /** \brief Sets the pool used for parallel copies.  If `min_parallel_copy_size` is given (e.g.,
+   * the result of `calibrate_min_parallel_copy_size(worker_pool)`), it is used as the minimum task
+   * size for copies on this packer instead of the global `min_parallel_copy_size()`.
+   */
+  void set_worker_pool(batt::WorkerPool& worker_pool,
+                       batt::Optional<usize> min_parallel_copy_size = batt::None) noexcept
   {
     this->worker_pool_.emplace(worker_pool);
+    this->min_parallel_copy_size_ = min_parallel_copy_size;
   }
 
   void clear_worker_pool() noexcept
   {
     this->worker_pool_ = batt::None;
+    this->min_parallel_copy_size_ = batt::None;
   }
 
   batt::Optional<batt::WorkerPool&> worker_pool() const noexcept
@@ -377,11 +475,26 @@ class DataPacker
     return this->worker_pool_;
   }
 
+  /** \brief If `log` is non-null, every PackedBytes record whose data is later packed outside of
+   * the record itself (i.e. data larger than 4 bytes) is appended to `*log`, so that its
+   * `data_offset` can be fixed up if the packed regions are moved relative to each other (see
+   * DeferredDataPacker).  Pass nullptr to stop logging.
+   */
+  void set_data_ref_log(std::vector<PackedBytes*>* log) noexcept
+  {
+    this->data_ref_log_ = log;
+  }
+
  private:
   usize estimate_packed_data_size(usize size) const;
 
   usize estimate_packed_data_size(const PackedBytes& src) const;
 
+  // Returns the min_task_size for parallel copies on `this->worker_pool_` (which must be set): the
+  // size passed to `set_worker_pool`, if any, otherwise the global `min_parallel_copy_size()`.
+  //
+  usize parallel_copy_task_size() const;
+
   template <typename Policy>
   const void* nocheck_pack_data_to(PackedBytes* rec, const void* data, usize size, Arena* arena,
                                    batt::StaticType<Policy> = {});
@@ -413,6 +526,14 @@ class DataPacker
    * large data using parallelism.
    */
   batt::Optional<batt::WorkerPool&> worker_pool_ = batt::None;
+
+  /** \brief See `set_worker_pool`.
+   */
+  batt::Optional<usize> min_parallel_copy_size_ = batt::None;
+
+  /** \brief See `set_data_ref_log`.
+   */
+  std::vector<PackedBytes*>* data_ref_log_ = nullptr;
 };
 
 }  // namespace llfs
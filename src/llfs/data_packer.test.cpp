@@ -189,6 +189,102 @@ TEST(DataPackerTest, ParallelDataCopyFalse)
   run_parallel_copy_test(false, 0);
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// A minimum parallel copy size passed to set_worker_pool is used by that packer only, and copies
+// made with it are still correct.
+//
+TEST(DataPackerTest, PerPackerMinParallelCopySize)
+{
+  const usize global_size = llfs::DataPacker::min_parallel_copy_size();
+
+  std::vector<char> src_buffer(kDataCopySize);
+  for (usize i = 0; i < src_buffer.size(); ++i) {
+    src_buffer[i] = char(i * 13);
+  }
+
+  for (const llfs::Optional<usize> min_size : {llfs::Optional<usize>{llfs::None},
+                                               llfs::Optional<usize>{16 * kKiB},
+                                               llfs::Optional<usize>{kDataCopySize * 2}}) {
+    std::vector<char> dst_buffer(kDataCopySize + 100);
+
+    llfs::DataPacker packer{llfs::MutableBuffer{dst_buffer.data(), dst_buffer.size()}};
+    packer.set_worker_pool(batt::WorkerPool::default_pool(), min_size);
+
+    llfs::Optional<std::string_view> packed =
+        packer.pack_raw_data(src_buffer.data(), src_buffer.size(), llfs::UseParallelCopy{true});
+    ASSERT_TRUE(packed);
+    EXPECT_EQ(std::memcmp(packed->data(), src_buffer.data(), src_buffer.size()), 0)
+        << BATT_INSPECT(min_size);
+  }
+
+  // Nothing global was changed.
+  //
+  EXPECT_EQ(llfs::DataPacker::min_parallel_copy_size(), global_size);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Calibration picks a power of 2 in the calibrated range; parallel copies using the calibrated
+// size are still correct.
+//
+TEST(DataPackerTest, CalibrateMinParallelCopySize)
+{
+  batt::WorkerPool& pool = batt::WorkerPool::default_pool();
+
+  const usize size = llfs::DataPacker::calibrate_min_parallel_copy_size(pool);
+
+  EXPECT_GE(size, llfs::DataPacker::kMinCalibratedParallelCopySize);
+  EXPECT_LE(size, llfs::DataPacker::kMaxCalibratedParallelCopySize);
+  EXPECT_EQ(size & (size - 1), 0u);
+
+  std::vector<char> src_buffer(kDataCopySize);
+  for (usize i = 0; i < src_buffer.size(); ++i) {
+    src_buffer[i] = char(i * 7);
+  }
+  std::vector<char> dst_buffer(kDataCopySize + 100);
+
+  llfs::DataPacker packer{llfs::MutableBuffer{dst_buffer.data(), dst_buffer.size()}};
+  packer.set_worker_pool(pool, size);
+
+  llfs::Optional<std::string_view> packed =
+      packer.pack_raw_data(src_buffer.data(), src_buffer.size(), llfs::UseParallelCopy{true});
+  ASSERT_TRUE(packed);
+  EXPECT_EQ(std::memcmp(packed->data(), src_buffer.data(), src_buffer.size()), 0);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Non-temporal copies produce the same bytes as regular ones, for sizes below and above the
+// minimum and for every destination alignment.
+//
+TEST(DataPackerTest, NonTemporalCopy)
+{
+  std::vector<char> src_buffer(64 * kKiB + 77);
+  for (usize i = 0; i < src_buffer.size(); ++i) {
+    src_buffer[i] = char(i * 13 + 1);
+  }
+
+  for (usize size : {usize{0}, usize{100}, llfs::DataPacker::kMinNonTemporalCopySize,
+                     llfs::DataPacker::kMinNonTemporalCopySize + 63, src_buffer.size()}) {
+    for (usize offset = 0; offset < 16; ++offset) {
+      std::vector<char> dst_buffer(src_buffer.size() + 32, '\0');
+
+      llfs::DataPacker packer{llfs::MutableBuffer{dst_buffer.data(), dst_buffer.size()}};
+      ASSERT_TRUE(packer.pack_raw_data(src_buffer.data(), offset));
+
+      llfs::Optional<std::string_view> packed =
+          packer.pack_raw_data(src_buffer.data(), size, llfs::UseNonTemporalCopy{true});
+      ASSERT_TRUE(packed);
+      EXPECT_EQ(packed->data(), dst_buffer.data() + offset);
+      EXPECT_EQ(packed->size(), size);
+      EXPECT_EQ(std::memcmp(packed->data(), src_buffer.data(), size), 0)
+          << BATT_INSPECT(size) << BATT_INSPECT(offset);
+
+      // Bytes past the end are untouched.
+      //
+      EXPECT_EQ(dst_buffer[offset + size], '\0');
+    }
+  }
+}
+
 /*! \brief Runs a DataPacker (pack_record) test to check space allocation correctness.
  *
  * The function is allocating space for 'N' (='count') elements using a DataPacker object.
@@ -175,6 +175,26 @@ u8* DataPackerArena::pack_varint(u64 n)
   return dst_end;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u8* DataPackerArena::pack_varints(const batt::Slice<const u64>& values)
+{
+  if (this->full_) {
+    return nullptr;
+  }
+
+  u8* const avail_end = this->avail_.end();
+  u8* const dst_end = pack_varints_to(this->avail_.begin(), avail_end, values);
+  if (dst_end == nullptr) {
+    this->full_ = true;
+    return nullptr;
+  }
+
+  this->avail_ = boost::iterator_range<u8*>{dst_end, avail_end};
+
+  return dst_end;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 boost::iterator_range<u8*> DataPackerArena::nocheck_alloc_front(isize size)
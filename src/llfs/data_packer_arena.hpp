@@ -18,6 +18,7 @@
 #include <llfs/optional.hpp>
 
 #include <batteries/pointers.hpp>
+#include <batteries/slice.hpp>
 
 #include <boost/range/iterator_range.hpp>
 
@@ -92,6 +93,14 @@ class DataPackerArena
    */
   u8* pack_varint(u64 n);
 
+  /*! \brief Pack all of `values` as consecutive variable-length integers at the front of this
+   * arena.
+   *
+   * \return nullptr (packing none of them) if there isn't enough space for all of them; otherwise
+   * return pointer to the byte after the last packed var-int.
+   */
+  u8* pack_varints(const batt::Slice<const u64>& values);
+
  private:
   /*! \brief The DataPacker object with which this DataPackerArena is associated, for sanity
    * checking.
@@ -16,6 +16,8 @@
 
 namespace llfs {
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
 Optional<u64> DataReader::read_varint()
 {
   if (this->at_end_) {
@@ -36,4 +38,47 @@ Optional<u64> DataReader::read_varint()
   return None;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool DataReader::read_varints(const batt::Slice<u64>& values)
+{
+  if (this->at_end_) {
+    return false;
+  }
+
+  const u8* const unread_end = this->unread_.end();
+  const u8* const parse_end = unpack_varints_from(this->unread_.begin(), unread_end, values);
+
+  if (parse_end) {
+    this->unread_ = boost::iterator_range<const u8*>{parse_end, unread_end};
+    return true;
+  }
+
+  this->at_end_ = true;
+  return false;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+const PackedSortedU64s* DataReader::read_sorted_u64s()
+{
+  if (this->at_end_ || this->unread_.size() < sizeof(PackedSortedU64s)) {
+    this->at_end_ = true;
+    return nullptr;
+  }
+
+  const auto* packed = reinterpret_cast<const PackedSortedU64s*>(this->unread_.begin());
+
+  Status status = validate_packed_value(*packed, this->unread_.begin(), this->unread_.size());
+  if (!status.ok()) {
+    LLFS_DVLOG(1) << "read_sorted_u64s failed;" << BATT_INSPECT(status);
+    this->at_end_ = true;
+    return nullptr;
+  }
+
+  this->unread_.advance_begin(packed->size_in_bytes);
+
+  return packed;
+}
+
 }  // namespace llfs
@@ -21,11 +21,13 @@
 #include <llfs/int_types.hpp>
 #include <llfs/optional.hpp>
 #include <llfs/packed_bytes.hpp>
+#include <llfs/packed_sorted_u64s.hpp>
 #include <llfs/packed_variant.hpp>
 
 #include <llfs/logging.hpp>
 
 #include <batteries/assert.hpp>
+#include <batteries/slice.hpp>
 #include <batteries/type_traits.hpp>
 
 #include <boost/range/iterator_range.hpp>
@@ -203,7 +205,7 @@ class DataReader
   [[nodiscard]] bool read_variant(batt::StaticType<PackedVariant<Ts...>> t, Fn&& visitor_fn)
   {
     const auto* head = this->read_record(t);
-    if (!head) {
+    if (!head || head->which >= PackedVariant<Ts...>::kNumCases) {
       return false;
     }
     return head->visit_type([&visitor_fn, head, this](auto u) {
@@ -218,6 +220,18 @@ class DataReader
 
   Optional<u64> read_varint();
 
+  /** \brief Reads `values.size()` consecutive varints into `values`, using the word-at-a-time
+   * decoder (see unpack_varints_from).  Returns false (and sets the at-end flag, consuming nothing)
+   * if the unread data ends before all of them have been read.
+   */
+  [[nodiscard]] bool read_varints(const batt::Slice<u64>& values);
+
+  /** \brief Reads a PackedSortedU64s (as packed by DataPacker::pack_sorted_u64s) in place.
+   *
+   * \return nullptr if the unread data doesn't start with a valid PackedSortedU64s.
+   */
+  [[nodiscard]] const PackedSortedU64s* read_sorted_u64s();
+
   const u8* buffer_begin() const
   {
     return static_cast<const u8*>(this->buffer_.data());
@@ -0,0 +1,132 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/deferred_data_packer.hpp>
+//
+
+#include <batteries/assert.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ DeferredDataPacker::DeferredDataPacker(usize initial_capacity,
+                                                    usize max_capacity) noexcept
+    : max_capacity_{std::max(initial_capacity, max_capacity)}
+    , scratch_(std::max<usize>(initial_capacity, 1))
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+DataPacker& DeferredDataPacker::start()
+{
+  this->data_refs_.clear();
+  this->relocated_ = false;
+
+  this->packer_.emplace(MutableBuffer{this->scratch_.data(), this->scratch_.size()});
+  this->packer_->set_data_ref_log(&this->data_refs_);
+
+  return *this->packer_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool DeferredDataPacker::grow()
+{
+  if (this->scratch_.size() >= this->max_capacity_) {
+    return false;
+  }
+
+  // The packer refers to the old buffer; drop it before reallocating.
+  //
+  this->packer_ = None;
+  this->scratch_.resize(std::min(this->max_capacity_, this->scratch_.size() * 2));
+
+  return true;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize DeferredDataPacker::packed_size() const
+{
+  BATT_CHECK(this->packer_) << "packed_size() must be called after a successful pack()";
+
+  const Interval<isize> gap = this->packer_->unused();
+
+  return this->scratch_.size() - gap.size();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void DeferredDataPacker::relocate()
+{
+  BATT_CHECK(this->packer_) << "a DeferredDataPacker must be finalized after a successful pack()";
+
+  if (this->relocated_) {
+    return;
+  }
+  this->relocated_ = true;
+
+  const Interval<isize> gap = this->packer_->unused();
+  if (gap.empty()) {
+    return;
+  }
+
+  const u8* const base = this->scratch_.data();
+
+  // Maps an offset within the scratch buffer to its offset within the finalized result.
+  //
+  const auto finalized_offset = [&gap](isize offset) -> isize {
+    BATT_CHECK(offset <= gap.lower_bound || offset >= gap.upper_bound);
+    return (offset < gap.upper_bound) ? offset : (offset - gap.size());
+  };
+
+  for (PackedBytes* rec : this->data_refs_) {
+    const isize rec_offset = reinterpret_cast<const u8*>(rec) - base;
+    const isize data_offset = rec_offset + rec->data_offset.value();
+
+    const isize new_data_offset = finalized_offset(data_offset) - finalized_offset(rec_offset);
+    BATT_CHECK_GE(new_data_offset, 0);
+
+    rec->data_offset = new_data_offset;
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void DeferredDataPacker::finalize_to(const MutableBuffer& dst)
+{
+  BATT_CHECK_EQ(dst.size(), this->packed_size());
+
+  const std::array<ConstBuffer, 2> src = this->finalized_buffers();
+
+  u8* const dst_bytes = static_cast<u8*>(dst.data());
+  std::memcpy(dst_bytes, src[0].data(), src[0].size());
+  std::memcpy(dst_bytes + src[0].size(), src[1].data(), src[1].size());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::array<ConstBuffer, 2> DeferredDataPacker::finalized_buffers()
+{
+  this->relocate();
+
+  const Interval<isize> gap = this->packer_->unused();
+  const u8* const base = this->scratch_.data();
+
+  return {
+      ConstBuffer{base, static_cast<usize>(gap.lower_bound)},
+      ConstBuffer{base + gap.upper_bound, this->scratch_.size() - gap.upper_bound},
+  };
+}
+
+}  // namespace llfs
@@ -0,0 +1,151 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_DEFERRED_DATA_PACKER_HPP
+#define LLFS_DEFERRED_DATA_PACKER_HPP
+
+#include <llfs/buffer.hpp>
+#include <llfs/data_packer.hpp>
+#include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/packed_bytes.hpp>
+
+#include <array>
+#include <vector>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Packs variable-sized data without computing its packed size first.
+ *
+ * The usual way to pack an object is to compute `packed_sizeof(obj)`, allocate (or reserve) a
+ * buffer of exactly that size, and then pack into it, which traverses the object twice.  With a
+ * DeferredDataPacker, the object is packed once into a scratch buffer, after which its exact size
+ * is known (`packed_size()`); the result is then either copied into the destination buffer
+ * (`finalize_to`) or written directly from the scratch buffer (`finalized_buffers`).  The scratch
+ * buffer is kept, so packing many objects (one at a time) with the same DeferredDataPacker
+ * allocates only until the scratch buffer is large enough for the largest of them.
+ *
+ * A DataPacker allocates records from the front of its buffer and (most) data from the back, so
+ * the result in the scratch buffer has a gap between the two regions; finalizing removes the gap,
+ * fixing up the `data_offset` of every PackedBytes whose data was packed by the DataPacker (see
+ * DataPacker::set_data_ref_log).  The finalized bytes are identical to those produced by packing
+ * into a buffer of exactly `packed_size()` bytes.  Packed types that store other self-relative
+ * offsets from the front region into the back region can't be relocated this way and must not be
+ * packed with a DeferredDataPacker.
+ *
+ * If the scratch buffer is too small, its capacity is doubled and the pack function is called
+ * again (up to `max_capacity`).
+ */
+class DeferredDataPacker
+{
+ public:
+  static constexpr usize kDefaultInitialCapacity = 4 * kKiB;
+
+  // PackedBytes offsets are 24 bits, so larger buffers can't be packed reliably anyway.
+  //
+  static constexpr usize kDefaultMaxCapacity = 16 * kMiB;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  explicit DeferredDataPacker(usize initial_capacity = kDefaultInitialCapacity,
+                              usize max_capacity = kDefaultMaxCapacity) noexcept;
+
+  DeferredDataPacker(const DeferredDataPacker&) = delete;
+  DeferredDataPacker& operator=(const DeferredDataPacker&) = delete;
+
+  /** \brief The current size of the scratch buffer.
+   */
+  usize capacity() const
+  {
+    return this->scratch_.size();
+  }
+
+  /** \brief Calls `pack_fn(DataPacker&)` on a DataPacker over the (empty) scratch buffer; the
+   * function should return false if packing failed.  If packing ran out of space, the scratch
+   * buffer is doubled (up to `max_capacity`) and `pack_fn` is called again, so `pack_fn` must not
+   * have side effects other than packing.
+   *
+   * \return true if everything was packed; false if `pack_fn` failed for some reason other than a
+   * lack of space, or if it didn't fit into `max_capacity` bytes.
+   */
+  template <typename PackFn /* = bool(DataPacker&) */>
+  bool pack(PackFn&& pack_fn)
+  {
+    for (;;) {
+      DataPacker& packer = this->start();
+      const bool ok = pack_fn(packer);
+      if (ok && !packer.full()) {
+        return true;
+      }
+      if (!packer.full() || !this->grow()) {
+        this->packer_ = None;
+        return false;
+      }
+    }
+  }
+
+  /** \brief Packs `obj` with `pack_object`; see `pack`.
+   */
+  template <typename T>
+  bool pack_object(const T& obj)
+  {
+    return this->pack([&obj](DataPacker& packer) {
+      return ::llfs::pack_object(obj, &packer) != nullptr;
+    });
+  }
+
+  /** \brief The exact size of the packed result; must be called after a successful `pack`.
+   */
+  usize packed_size() const;
+
+  /** \brief Copies the packed result into `dst`, which must be exactly `packed_size()` bytes.
+   */
+  void finalize_to(const MutableBuffer& dst);
+
+  /** \brief Returns the packed result as two buffers (within the scratch buffer) that are to be
+   * written one after the other, e.g. as an iovec.  They remain valid until the next call to
+   * `pack`.  Since this fixes up the packed offsets in place, the scratch buffer no longer holds
+   * valid packed data (only the concatenation of the returned buffers does).
+   */
+  std::array<ConstBuffer, 2> finalized_buffers();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  // Creates a new DataPacker over the scratch buffer.
+  //
+  DataPacker& start();
+
+  // Doubles the size of the scratch buffer; returns false if it is already `max_capacity_`.
+  //
+  bool grow();
+
+  // Fixes up the offsets of the logged PackedBytes records for the removal of the gap between the
+  // front and back regions (idempotent).
+  //
+  void relocate();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const usize max_capacity_;
+
+  std::vector<u8> scratch_;
+
+  Optional<DataPacker> packer_;
+
+  // The PackedBytes records whose data was packed outside of the record.
+  //
+  std::vector<PackedBytes*> data_refs_;
+
+  bool relocated_ = false;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_DEFERRED_DATA_PACKER_HPP
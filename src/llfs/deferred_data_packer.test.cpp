@@ -0,0 +1,157 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/deferred_data_packer.hpp>
+//
+#include <llfs/deferred_data_packer.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/data_reader.hpp>
+#include <llfs/packed_array.hpp>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace llfs::int_types;
+
+// Packs `strings` as a PackedArray<PackedBytes> (records at the front, string data at the back).
+//
+bool pack_strings(const std::vector<std::string>& strings, llfs::DataPacker& packer)
+{
+  llfs::Optional<llfs::DataPacker::ArrayPacker<llfs::PackedBytes>> array =
+      packer.pack_array<llfs::PackedBytes>();
+  if (!array) {
+    return false;
+  }
+  for (const std::string& s : strings) {
+    if (!array->pack_item(std::string_view{s})) {
+      return false;
+    }
+  }
+  return array->finish() != nullptr;
+}
+
+// Packs `strings` the usual way: compute the size, then pack into a buffer of exactly that size.
+//
+std::vector<u8> pack_strings_two_pass(const std::vector<std::string>& strings)
+{
+  usize size = llfs::packed_array_size<llfs::PackedBytes>(strings.size());
+  for (const std::string& s : strings) {
+    size += llfs::packed_sizeof_str_data(s.size());
+  }
+
+  std::vector<u8> buffer(size);
+  llfs::DataPacker packer{llfs::MutableBuffer{buffer.data(), buffer.size()}};
+  BATT_CHECK(pack_strings(strings, packer));
+  BATT_CHECK_EQ(packer.space(), 0u);
+
+  return buffer;
+}
+
+std::vector<std::string> make_strings(usize count)
+{
+  std::vector<std::string> strings;
+  for (usize i = 0; i < count; ++i) {
+    // Mix inline (<= 4 bytes) and out-of-line strings.
+    //
+    strings.emplace_back(i % 7, char('a' + i % 26));
+    strings.back() += std::to_string(i * 1000003);
+  }
+  return strings;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(DeferredDataPackerTest, MatchesTwoPassPacking)
+{
+  llfs::DeferredDataPacker deferred{/*initial_capacity=*/64};
+
+  for (usize count : {0, 1, 3, 10, 100, 1000}) {
+    const std::vector<std::string> strings = make_strings(count);
+    const std::vector<u8> expected = pack_strings_two_pass(strings);
+
+    ASSERT_TRUE(deferred.pack([&strings](llfs::DataPacker& packer) {
+      return pack_strings(strings, packer);
+    }));
+
+    ASSERT_EQ(deferred.packed_size(), expected.size()) << BATT_INSPECT(count);
+    EXPECT_GE(deferred.capacity(), expected.size());
+
+    std::vector<u8> actual(deferred.packed_size());
+    deferred.finalize_to(llfs::MutableBuffer{actual.data(), actual.size()});
+
+    EXPECT_EQ(actual, expected) << BATT_INSPECT(count);
+
+    // Check that the finalized data can be read back.
+    //
+    const auto* packed =
+        reinterpret_cast<const llfs::PackedArray<llfs::PackedBytes>*>(actual.data());
+    ASSERT_EQ(packed->size(), strings.size());
+    for (usize i = 0; i < strings.size(); ++i) {
+      EXPECT_EQ(packed->items[i].as_str(), strings[i]);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(DeferredDataPackerTest, FinalizedBuffers)
+{
+  const std::vector<std::string> strings = make_strings(50);
+  const std::vector<u8> expected = pack_strings_two_pass(strings);
+
+  llfs::DeferredDataPacker deferred;
+  ASSERT_TRUE(deferred.pack([&strings](llfs::DataPacker& packer) {
+    return pack_strings(strings, packer);
+  }));
+
+  std::vector<u8> gathered;
+  for (const llfs::ConstBuffer& buffer : deferred.finalized_buffers()) {
+    const u8* bytes = static_cast<const u8*>(buffer.data());
+    gathered.insert(gathered.end(), bytes, bytes + buffer.size());
+  }
+
+  EXPECT_EQ(gathered, expected);
+
+  // Finalizing twice gives the same result.
+  //
+  std::vector<u8> copied(deferred.packed_size());
+  deferred.finalize_to(llfs::MutableBuffer{copied.data(), copied.size()});
+  EXPECT_EQ(copied, expected);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(DeferredDataPackerTest, Failure)
+{
+  const std::vector<std::string> strings = make_strings(1000);
+
+  // Too large for the max capacity.
+  //
+  llfs::DeferredDataPacker small{/*initial_capacity=*/64, /*max_capacity=*/1024};
+  EXPECT_FALSE(small.pack([&strings](llfs::DataPacker& packer) {
+    return pack_strings(strings, packer);
+  }));
+  EXPECT_EQ(small.capacity(), 1024u);
+
+  // Failures other than running out of space are not retried.
+  //
+  usize call_count = 0;
+  llfs::DeferredDataPacker deferred;
+  EXPECT_FALSE(deferred.pack([&call_count](llfs::DataPacker&) {
+    ++call_count;
+    return false;
+  }));
+  EXPECT_EQ(call_count, 1u);
+}
+
+}  // namespace
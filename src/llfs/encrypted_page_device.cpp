@@ -0,0 +1,158 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/encrypted_page_device.hpp>
+//
+
+#include <batteries/assert.hpp>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<std::unique_ptr<EncryptedPageDevice>> EncryptedPageDevice::make(
+    std::unique_ptr<PageDevice> device, const PageEncryptionKey& key)
+{
+  BATT_REQUIRE_OK(validate_page_encryption_key(key));
+
+  return std::make_unique<EncryptedPageDevice>(std::move(device), key);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ EncryptedPageDevice::EncryptedPageDevice(std::unique_ptr<PageDevice> device,
+                                                      const PageEncryptionKey& key) noexcept
+    : device_{std::move(device)}
+    , key_{std::make_shared<const PageEncryptionKey>(key)}
+{
+  BATT_CHECK_NOT_NULLPTR(this->device_);
+  BATT_CHECK_OK(validate_page_encryption_key(key));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageIdFactory EncryptedPageDevice::page_ids()
+{
+  return this->device_->page_ids();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageSize EncryptedPageDevice::page_size()
+{
+  return this->device_->page_size();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status EncryptedPageDevice::enable_registered_page_buffers(usize buffer_count)
+{
+  return this->device_->enable_registered_page_buffers(buffer_count);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool EncryptedPageDevice::prefetch_hint(PageId id)
+{
+  return this->device_->prefetch_hint(id);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::shared_ptr<PageBuffer>> EncryptedPageDevice::prepare(PageId page_id)
+{
+  return PageBuffer::allocate(this->page_size(), page_id);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void EncryptedPageDevice::write(std::shared_ptr<const PageBuffer>&& page_buffer,
+                                WriteHandler&& handler)
+{
+  BATT_CHECK_NOT_NULLPTR(page_buffer);
+
+  StatusOr<std::shared_ptr<PageBuffer>> encrypted = this->device_->prepare(page_buffer->page_id());
+  if (!encrypted.ok()) {
+    handler(encrypted.status());
+    return;
+  }
+
+  Status status = encrypt_page_payload(*this->key_, *page_buffer, encrypted->get());
+  if (!status.ok()) {
+    handler(status);
+    return;
+  }
+
+  metrics().encrypted_page_count.add(1);
+
+  this->device_->write(std::move(*encrypted), std::move(handler));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void EncryptedPageDevice::read(PageId id, ReadHandler&& handler)
+{
+  this->device_->read(id, this->make_decrypt_handler(std::move(handler)));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void EncryptedPageDevice::read_batch(const batt::Slice<const PageId>& ids,
+                                     std::vector<ReadHandler>&& handlers)
+{
+  for (ReadHandler& handler : handlers) {
+    handler = this->make_decrypt_handler(std::move(handler));
+  }
+  this->device_->read_batch(ids, std::move(handlers));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void EncryptedPageDevice::drop(PageId id, WriteHandler&& handler)
+{
+  this->device_->drop(id, std::move(handler));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto EncryptedPageDevice::make_decrypt_handler(ReadHandler&& handler) -> ReadHandler
+{
+  return [key = this->key_, handler = std::move(handler)](ReadResult&& result) mutable {
+    if (!result.ok()) {
+      handler(std::move(result));
+      return;
+    }
+
+    std::shared_ptr<const PageBuffer> page = std::move(*result);
+
+    // If we hold the only reference to the buffer, nobody else can observe it being decrypted in
+    // place.
+    //
+    std::shared_ptr<PageBuffer> decrypted;
+    if (page.use_count() == 1) {
+      decrypted = std::const_pointer_cast<PageBuffer>(std::move(page));
+    } else {
+      decrypted = PageBuffer::allocate(page->size(), page->page_id());
+      metrics().decrypt_copy_count.add(1);
+    }
+
+    const PageBuffer& src = page ? *page : *decrypted;
+
+    Status status = decrypt_page_payload(*key, src, decrypted.get());
+    if (!status.ok()) {
+      handler(status);
+      return;
+    }
+
+    metrics().decrypted_page_count.add(1);
+
+    handler(std::shared_ptr<const PageBuffer>{std::move(decrypted)});
+  };
+}
+
+}  // namespace llfs
@@ -0,0 +1,118 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_ENCRYPTED_PAGE_DEVICE_HPP
+#define LLFS_ENCRYPTED_PAGE_DEVICE_HPP
+
+#include <llfs/int_types.hpp>
+#include <llfs/metrics.hpp>
+#include <llfs/page_device.hpp>
+#include <llfs/page_encryption.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/status.hpp>
+
+#include <memory>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A PageDevice that encrypts the pages written to another device, and decrypts them as they
+ * are read (see encrypt_page_payload), so the pages of an arena are encrypted at rest with that
+ * arena's own key.  Only the page payload is encrypted; the PackedPageHeader is stored as is.
+ *
+ * A written page is encrypted into a buffer from the underlying device's `prepare` (so it can be
+ * one of that device's registered buffers); the caller's buffer, which the PageCache may go on
+ * using, is left untouched.  A page that was just read is decrypted in place if nothing else holds
+ * a reference to its buffer, and into a new buffer otherwise (e.g., for devices that return the
+ * buffer they store, such as MemoryPageDevice).  To share decrypted pages between processes,
+ * wrap this device in a SharedCachePageDevice, not the other way around: buffers from a
+ * SharedPageBufferCache are shared memory even when this process holds only one reference.
+ *
+ * `read_tail` reads and decrypts the whole page, since the tail of an XTS data unit can't be
+ * decrypted on its own.
+ */
+class EncryptedPageDevice : public PageDevice
+{
+ public:
+  struct Metrics {
+    /** \brief The number of pages encrypted by `write`.
+     */
+    CountMetric<u64> encrypted_page_count{0};
+
+    /** \brief The number of pages decrypted after being read.
+     */
+    CountMetric<u64> decrypted_page_count{0};
+
+    /** \brief The number of decrypted pages that had to be copied to a new buffer.
+     */
+    CountMetric<u64> decrypt_copy_count{0};
+  };
+
+  static Metrics& metrics()
+  {
+    static Metrics m_;
+    return m_;
+  }
+
+  /** \brief Returns an EncryptedPageDevice for `device`, or kInvalidArgument if `key` is not
+   * usable (see validate_page_encryption_key).
+   */
+  static StatusOr<std::unique_ptr<EncryptedPageDevice>> make(std::unique_ptr<PageDevice> device,
+                                                             const PageEncryptionKey& key);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  explicit EncryptedPageDevice(std::unique_ptr<PageDevice> device,
+                               const PageEncryptionKey& key) noexcept;
+
+  //----- --- -- -  -  -   -
+  // PageDevice interface
+
+  PageIdFactory page_ids() override;
+
+  PageSize page_size() override;
+
+  Status enable_registered_page_buffers(usize buffer_count) override;
+
+  bool prefetch_hint(PageId id) override;
+
+  StatusOr<std::shared_ptr<PageBuffer>> prepare(PageId page_id) override;
+
+  void write(std::shared_ptr<const PageBuffer>&& page_buffer, WriteHandler&& handler) override;
+
+  void read(PageId id, ReadHandler&& handler) override;
+
+  void read_batch(const batt::Slice<const PageId>& ids,
+                  std::vector<ReadHandler>&& handlers) override;
+
+  void drop(PageId id, WriteHandler&& handler) override;
+
+  //----- --- -- -  -  -   -
+
+  PageDevice& device() const
+  {
+    return *this->device_;
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  /** \brief Returns a read handler that decrypts the page before passing it to `handler`.
+   */
+  ReadHandler make_decrypt_handler(ReadHandler&& handler);
+
+  std::unique_ptr<PageDevice> device_;
+
+  // Shared with the read handlers, which may outlive this object.
+  //
+  std::shared_ptr<const PageEncryptionKey> key_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_ENCRYPTED_PAGE_DEVICE_HPP
@@ -0,0 +1,139 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/encrypted_page_device.hpp>
+//
+#include <llfs/encrypted_page_device.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/memory_page_device.hpp>
+#include <llfs/packed_page_header.hpp>
+#include <llfs/page_buffer.hpp>
+#include <llfs/page_layout.hpp>
+
+#include <cstring>
+#include <memory>
+
+namespace {
+
+using namespace llfs::int_types;
+
+// Test Plan:
+//  1. A page written through the device is stored encrypted by the underlying device and read
+//     back decrypted (with a valid checksum), through both read and read_batch; a buffer that the
+//     underlying device still holds is decrypted into a copy, leaving the stored image encrypted.
+//  2. make() rejects an unusable key.
+
+constexpr llfs::page_device_id_int kDeviceId = 1;
+constexpr i64 kCapacity = 4;
+constexpr u32 kPageSize = 4096;
+
+constexpr usize kHeaderSize = sizeof(llfs::PackedPageHeader);
+
+llfs::PageEncryptionKey make_test_key()
+{
+  llfs::PageEncryptionKey key;
+  for (usize i = 0; i < key.bytes.size(); ++i) {
+    key.bytes[i] = static_cast<u8>(i * 37 + 11);
+  }
+  return key;
+}
+
+llfs::PageDevice::ReadResult read_page(llfs::PageDevice& device, llfs::PageId page_id)
+{
+  llfs::PageDevice::ReadResult result{llfs::Status{batt::StatusCode::kUnknown}};
+  device.read(page_id, [&result](llfs::PageDevice::ReadResult r) {
+    result = std::move(r);
+  });
+  return result;
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+//
+TEST(EncryptedPageDeviceTest, WriteEncryptedReadDecrypted)
+{
+  llfs::StatusOr<std::unique_ptr<llfs::EncryptedPageDevice>> device =
+      llfs::EncryptedPageDevice::make(
+          std::make_unique<llfs::MemoryPageDevice>(kDeviceId, llfs::PageCount{kCapacity},
+                                                   llfs::PageSize{kPageSize}),
+          make_test_key());
+  ASSERT_TRUE(device.ok()) << BATT_INSPECT(device.status());
+
+  const llfs::PageId page_id = (*device)->page_ids().make_page_id(1, 1);
+
+  llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer = (*device)->prepare(page_id);
+  ASSERT_TRUE(buffer.ok()) << BATT_INSPECT(buffer.status());
+
+  llfs::MutableBuffer payload = (*buffer)->mutable_payload();
+  std::memset(payload.data(), 0x5a, payload.size());
+  ASSERT_TRUE(
+      llfs::finalize_page_header(buffer->get(), llfs::Interval<u64>{kPageSize, kPageSize}).ok());
+
+  const std::shared_ptr<const llfs::PageBuffer> original = *buffer;
+
+  llfs::Status write_status{batt::StatusCode::kUnknown};
+  (*device)->write(std::move(*buffer), [&write_status](llfs::Status status) {
+    write_status = status;
+  });
+  ASSERT_TRUE(write_status.ok()) << BATT_INSPECT(write_status);
+
+  // The caller's buffer isn't modified.
+  //
+  EXPECT_EQ(static_cast<const u8*>(original->const_payload().data())[0], 0x5a);
+
+  // The underlying device holds the encrypted image.
+  //
+  llfs::PageDevice::ReadResult stored = read_page((*device)->device(), page_id);
+  ASSERT_TRUE(stored.ok()) << BATT_INSPECT(stored.status());
+  EXPECT_EQ(std::memcmp(stored->get(), original.get(), kHeaderSize), 0);
+  EXPECT_NE(std::memcmp(stored->get(), original.get(), kPageSize), 0);
+
+  const u64 copies_before = llfs::EncryptedPageDevice::metrics().decrypt_copy_count.load();
+
+  llfs::PageDevice::ReadResult page = read_page(**device, page_id);
+  ASSERT_TRUE(page.ok()) << BATT_INSPECT(page.status());
+  EXPECT_EQ(std::memcmp(page->get(), original.get(), kPageSize), 0);
+  EXPECT_TRUE(llfs::verify_page_checksum(**page).ok());
+
+  EXPECT_EQ(llfs::EncryptedPageDevice::metrics().decrypt_copy_count.load() - copies_before, 1u);
+
+  // The stored image is still encrypted.
+  //
+  EXPECT_NE(std::memcmp(stored->get(), original.get(), kPageSize), 0);
+
+  std::vector<llfs::PageId> ids{page_id};
+  std::vector<llfs::PageDevice::ReadResult> results;
+  std::vector<llfs::PageDevice::ReadHandler> handlers;
+  handlers.emplace_back([&results](llfs::PageDevice::ReadResult r) {
+    results.emplace_back(std::move(r));
+  });
+  (*device)->read_batch(batt::as_slice(ids), std::move(handlers));
+
+  ASSERT_EQ(results.size(), 1u);
+  ASSERT_TRUE(results[0].ok()) << BATT_INSPECT(results[0].status());
+  EXPECT_EQ(std::memcmp(results[0]->get(), original.get(), kPageSize), 0);
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+//
+TEST(EncryptedPageDeviceTest, InvalidKey)
+{
+  llfs::PageEncryptionKey key;
+  key.bytes.fill(0);
+
+  EXPECT_EQ(llfs::EncryptedPageDevice::make(
+                std::make_unique<llfs::MemoryPageDevice>(kDeviceId, llfs::PageCount{kCapacity},
+                                                         llfs::PageSize{kPageSize}),
+                key)
+                .status(),
+            batt::StatusCode::kInvalidArgument);
+}
+
+}  // namespace
@@ -10,6 +10,7 @@
 //
 #include <llfs/config.hpp>
 #include <llfs/constants.hpp>
+#include <llfs/filesystem.hpp>
 
 #include <batteries/syscall_retry.hpp>
 
@@ -17,6 +18,7 @@
 
 #include <boost/algorithm/string/predicate.hpp>
 
+#include <algorithm>
 #include <cctype>
 #include <filesystem>
 #include <fstream>
@@ -28,6 +30,7 @@ FileLogDriver::Config FileLogDriver::default_config(const PageCacheOptions& opts
   return Config{
       .min_segment_split_size = 1 * kMiB,
       .max_size = opts.default_log_size(),
+      .segment_pool_size = 2,
   };
 }
 
@@ -35,7 +38,7 @@ FileLogDriver::Config FileLogDriver::default_config(const PageCacheOptions& opts
 
 StatusOr<std::unique_ptr<FileLogDevice>> FileLogDriver::initialize(
     const Location& location, const Config& config, batt::TaskScheduler& scheduler,
-    ConfirmThisWillEraseAllMyData confirm)
+    ConfirmThisWillEraseAllMyData confirm, const IoRing* io_ring)
 {
   initialize_status_codes();
 
@@ -61,7 +64,8 @@ StatusOr<std::unique_ptr<FileLogDevice>> FileLogDriver::initialize(
   //
   {
     std::ofstream ofs(location.config_file_path().string().c_str());
-    ofs << config.max_size << " " << config.min_segment_split_size;
+    ofs << config.max_size << " " << config.min_segment_split_size << " "
+        << config.segment_pool_size;
     if (!ofs.good()) {
       return ::llfs::make_status(::llfs::StatusCode::kFileLogDeviceConfigWriteFailed);
     }
@@ -74,14 +78,15 @@ StatusOr<std::unique_ptr<FileLogDevice>> FileLogDriver::initialize(
         BATT_CHECK_EQ(reader.data().size(), 0);
         return OkStatus();
       },
-      scheduler);
+      scheduler, io_ring);
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 StatusOr<std::unique_ptr<FileLogDevice>> FileLogDriver::recover(const Location& location,
                                                                 const LogScanFn& scan_fn,
-                                                                batt::TaskScheduler& scheduler)
+                                                                batt::TaskScheduler& scheduler,
+                                                                const IoRing* io_ring)
 {
   // Read configuration file.
   //
@@ -89,7 +94,9 @@ StatusOr<std::unique_ptr<FileLogDevice>> FileLogDriver::recover(const Location&
   {
     std::ifstream ifs(location.config_file_path().string().c_str());
     if (ifs.good()) {
-      ifs >> config.max_size >> config.min_segment_split_size;
+      // `segment_pool_size` was added later; it is left at its default if missing.
+      //
+      ifs >> config.max_size >> config.min_segment_split_size >> config.segment_pool_size;
       if (!ifs.good() && !ifs.eof()) {
         return ::llfs::make_status(::llfs::StatusCode::kFileLogDeviceConfigReadFailed);
       }
@@ -99,7 +106,7 @@ StatusOr<std::unique_ptr<FileLogDevice>> FileLogDriver::recover(const Location&
   // Create the device.
   //
   std::unique_ptr<FileLogDevice> log_device = std::make_unique<FileLogDevice>(
-      RingBuffer::TempFile{config.max_size}, location, config, scheduler);
+      RingBuffer::TempFile{config.max_size}, location, config, scheduler, io_ring);
 
   FileLogDriver& driver = log_device->driver().impl();
 
@@ -163,9 +170,16 @@ StatusOr<FileLogDriver::ActiveFile> FileLogDriver::recover_segments()
   fs::directory_iterator dir_iter(prefix_dir, ec);
   BATT_REQUIRE_OK(ec) << batt::LogLevel::kInfo
                       << "creating dir_iter from prefix_dir: " << prefix_dir;
+  u64 next_spare_id = 0;
   for (const auto& p : dir_iter) {
     std::string name = p.path().filename().string();
     LLFS_LOG_INFO() << "found file: " << name;
+    Optional<u64> spare_id = this->shared_state_.location.spare_id_from_segment_file_name(name);
+    if (spare_id) {
+      this->recovered_spare_files_.emplace_back(p.path().string());
+      next_spare_id = std::max(next_spare_id, *spare_id + 1);
+      continue;
+    }
     if (boost::algorithm::starts_with(name, prefix_base) &&
         boost::algorithm::ends_with(name, FileLogDriver::Location::segment_ext())) {
       Optional<SlotRange> slot_range =
@@ -180,6 +194,8 @@ StatusOr<FileLogDriver::ActiveFile> FileLogDriver::recover_segments()
   }
   LLFS_LOG_INFO() << "finished scanning log segments";
 
+  this->shared_state_.next_spare_id.store(next_spare_id);
+
   // Sort the segments by slot offset.
   //
   std::sort(segments.begin(), segments.end(),
@@ -259,10 +275,20 @@ void FileLogDriver::start_tasks(ActiveFile&& active_file)
   // Start the flush task.
   //
   BATT_CHECK(!this->flush_task_);
-  this->flush_task_.emplace(
-      this->scheduler_.schedule_task(),
-      FlushTaskMain{this->context_.buffer_, this->shared_state_, std::move(active_file)},
-      "FileLogDriver::flush_task");
+#ifndef LLFS_DISABLE_IO_URING
+  if (this->io_ring_) {
+    this->flush_task_.emplace(this->scheduler_.schedule_task(),
+                              IoRingFlushTaskMain{this->context_.buffer_, this->shared_state_,
+                                                  std::move(active_file), *this->io_ring_},
+                              "FileLogDriver::ioring_flush_task");
+  }
+#endif  // LLFS_DISABLE_IO_URING
+  if (!this->flush_task_) {
+    this->flush_task_.emplace(
+        this->scheduler_.schedule_task(),
+        FlushTaskMain{this->context_.buffer_, this->shared_state_, std::move(active_file)},
+        "FileLogDriver::flush_task");
+  }
 
   // Start the trim task.
   //
@@ -278,9 +304,11 @@ void FileLogDriver::start_tasks(ActiveFile&& active_file)
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
 FileLogDriver::FileLogDriver(LogStorageDriverContext& context, const Location& location,
-                             const Config& config, batt::TaskScheduler& scheduler) noexcept
+                             const Config& config, batt::TaskScheduler& scheduler,
+                             const IoRing* io_ring) noexcept
     : context_{context}
     , scheduler_{scheduler}
+    , io_ring_{io_ring}
     , shared_state_{location, config}
 {
 }
@@ -361,6 +389,10 @@ Status FileLogDriver::close()
 void FileLogDriver::trim_task_main()
 {
   const Status status = [&] {
+    // Prepare the spare segment files before we start trimming.
+    //
+    BATT_REQUIRE_OK(this->fill_segment_pool());
+
     // Trim as many segment files as we can, sleeping only when we have to.
     //
     for (;;) {
@@ -377,9 +409,13 @@ void FileLogDriver::trim_task_main()
         BATT_REQUIRE_OK(status);
       }
 
-      // Now we can safely trim the file!
+      // Now we can safely trim the file!  Keep it for reuse if the segment pool isn't full.
       //
-      {
+      if (this->shared_state_.spare_segment_file_count() <
+          this->shared_state_.config.segment_pool_size) {
+        auto status = this->recycle_segment(*oldest_segment);
+        BATT_REQUIRE_OK(status);
+      } else {
         auto status = oldest_segment->remove();
         BATT_REQUIRE_OK(status);
       }
@@ -389,4 +425,59 @@ void FileLogDriver::trim_task_main()
   LLFS_LOG_INFO() << "[FileLogDriver::trim_task_main] finished with status=" << status;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status FileLogDriver::fill_segment_pool()
+{
+  const usize pool_size = this->shared_state_.config.segment_pool_size;
+
+  // Reuse spare files left over from before the last shutdown/crash first; delete any extras.
+  //
+  std::vector<std::string> recovered_spare_files = std::move(this->recovered_spare_files_);
+  for (std::string& file_name : recovered_spare_files) {
+    if (this->shared_state_.spare_segment_file_count() < pool_size) {
+      BATT_REQUIRE_OK(this->shared_state_.add_spare_segment_file(std::move(file_name)));
+    } else {
+      BATT_REQUIRE_OK(delete_file(file_name));
+    }
+  }
+
+  while (this->shared_state_.spare_segment_file_count() < pool_size) {
+    std::string file_name =
+        this->shared_state_.location
+            .spare_segment_file_path(this->shared_state_.next_spare_id.fetch_add(1))
+            .string();
+
+    StatusOr<int> fd = create_file_read_write(file_name);
+    BATT_REQUIRE_OK(fd);
+    BATT_REQUIRE_OK(close_fd(*fd));
+
+    BATT_REQUIRE_OK(this->shared_state_.add_spare_segment_file(std::move(file_name)));
+  }
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status FileLogDriver::recycle_segment(const SegmentFile& segment)
+{
+  LLFS_VLOG(1) << "recycling log segment file: " << segment.file_name;
+
+  std::string spare_file_name =
+      this->shared_state_.location
+          .spare_segment_file_path(this->shared_state_.next_spare_id.fetch_add(1))
+          .string();
+
+  // Rename first, so that the trimmed data is never mistaken for a live segment if we crash while
+  // the file is being emptied.
+  //
+  const int retval = batt::syscall_retry([&] {
+    return ::rename(/*from=*/segment.file_name.c_str(), /*to=*/spare_file_name.c_str());
+  });
+  BATT_REQUIRE_OK(status_from_retval(retval));
+
+  return this->shared_state_.add_spare_segment_file(std::move(spare_file_name));
+}
+
 }  // namespace llfs
@@ -25,14 +25,17 @@
 #include <batteries/async/task_scheduler.hpp>
 #include <batteries/async/watch.hpp>
 
+#include <atomic>
 #include <cstddef>
 #include <deque>
 #include <functional>
 #include <string>
+#include <vector>
 
 namespace llfs {
 
 class FileLogDriver;
+class IoRing;
 
 using FileLogDevice = BasicRingBufferLogDevice<FileLogDriver>;
 
@@ -66,6 +69,16 @@ class FileLogDriver
       return "log.tdb_config";
     }
 
+    static std::string_view spare_segment_ext()
+    {
+      return ".tdbspare";
+    }
+
+    static std::string_view spare_segment_file_prefix()
+    {
+      return "spare_";
+    }
+
     //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
     Location() = default;
@@ -88,6 +101,10 @@ class FileLogDriver
 
     fs::path active_segment_file_path() const;
 
+    fs::path spare_segment_file_path(u64 spare_id) const;
+
+    Optional<u64> spare_id_from_segment_file_name(const std::string& name) const;
+
    private:
     fs::path parent_dir_;
   };
@@ -111,6 +128,13 @@ class FileLogDriver
     //
     std::size_t max_size;
 
+    // The number of empty, preallocated segment files to keep on hand.  When a new active segment
+    // is needed, one of these is renamed into place instead of creating a new file, and trimmed
+    // segments are recycled into the pool instead of being deleted; this keeps filesystem
+    // allocation off the flush path.  Zero disables the pool.
+    //
+    std::size_t segment_pool_size = 0;
+
     //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
   };
 
@@ -138,10 +162,14 @@ class FileLogDriver
 
   static Config default_config(const PageCacheOptions& opts);
 
+  // If `io_ring` is non-null, segment appends and syncs are done through it (see
+  // IoRingFlushTaskMain) instead of via blocking syscalls; the IoRing must outlive the device.
+  //
   static StatusOr<std::unique_ptr<FileLogDevice>> initialize(const Location& location,
                                                              const Config& config,
                                                              batt::TaskScheduler& scheduler,
-                                                             ConfirmThisWillEraseAllMyData confirm);
+                                                             ConfirmThisWillEraseAllMyData confirm,
+                                                             const IoRing* io_ring = nullptr);
 
   // Recover a closed or crashed log by loading whatever is possible into memory, creating a
   // LogDevice::Reader to access it, and executing `scan_fn` to validate the data.  `scan_fn` should
@@ -149,14 +177,18 @@ class FileLogDriver
   // returning the final device.  If the scan_fn returns a non-ok status, that is returned in place
   // of the recovered device.
   //
+  // See `initialize` for the meaning of `io_ring`.
+  //
   static StatusOr<std::unique_ptr<FileLogDevice>> recover(const Location& location,
                                                           const LogScanFn& scan_fn,
-                                                          batt::TaskScheduler& scheduler);
+                                                          batt::TaskScheduler& scheduler,
+                                                          const IoRing* io_ring = nullptr);
 
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
   explicit FileLogDriver(LogStorageDriverContext& context, const Location& location,
-                         const Config& config, batt::TaskScheduler& scheduler) noexcept;
+                         const Config& config, batt::TaskScheduler& scheduler,
+                         const IoRing* io_ring = nullptr) noexcept;
 
   ~FileLogDriver() noexcept;
 
@@ -217,17 +249,43 @@ class FileLogDriver
     batt::Watch<slot_offset_type> flush_pos;
     batt::Watch<slot_offset_type> commit_pos;
 
+    // The names of preallocated, empty segment files ready to become the next active segment.
+    //
+    batt::Mutex<std::vector<std::string>> spare_segment_files;
+
+    // Used to generate unique spare segment file names.
+    //
+    std::atomic<u64> next_spare_id{0};
+
     //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
     // Prepare all objects for shutdown.  This function MUST NOT block.
     //
     void halt();
+
+    // Removes and returns the name of a spare segment file, if there are any.  This function MUST
+    // NOT block on I/O.
+    //
+    Optional<std::string> take_spare_segment_file();
+
+    // Returns the current number of spare segment files.
+    //
+    usize spare_segment_file_count();
+
+    // Empties the named file, preallocates `config.min_segment_split_size` bytes of storage for it,
+    // and adds it to the pool of spare segment files.
+    //
+    Status add_spare_segment_file(std::string&& file_name);
   };
 
   // See <llfs/file_log_driver/flush_task_main.hpp>
   //
   class FlushTaskMain;
 
+  // See <llfs/file_log_driver/ioring_flush_task_main.hpp>
+  //
+  class IoRingFlushTaskMain;
+
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
   // Scans the log directory for segment files, loading them into the ring buffer.
@@ -238,6 +296,14 @@ class FileLogDriver
 
   void trim_task_main();
 
+  // Adds spare segment files (recovered or newly created) until the pool is full.
+  //
+  Status fill_segment_pool();
+
+  // Returns a trimmed segment's file to the pool of spare segment files.
+  //
+  Status recycle_segment(const SegmentFile& segment);
+
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
   // The ring buffer state.
@@ -248,10 +314,19 @@ class FileLogDriver
   //
   batt::TaskScheduler& scheduler_;
 
+  // If non-null, the flush task uses this to append to and sync the active segment file.
+  //
+  const IoRing* io_ring_;
+
   // Thread-safe shared state used to communicate with committers and trimmers.
   //
   ConcurrentSharedState shared_state_;
 
+  // Spare segment files found by `recover_segments`; these are emptied and added to the pool by
+  // the trim task.
+  //
+  std::vector<std::string> recovered_spare_files_;
+
   // Deletes old segment files when the trim pos is increased.
   //
   Optional<batt::Task> trim_task_;
@@ -268,21 +343,23 @@ class RecoverFileLogDeviceFactory : public LogDeviceFactory
 {
  public:
   explicit RecoverFileLogDeviceFactory(const FileLogDriver::Location& location,
-                                       batt::TaskScheduler& scheduler) noexcept
+                                       batt::TaskScheduler& scheduler,
+                                       const IoRing* io_ring = nullptr) noexcept
       : location_{location}
       , scheduler_{scheduler}
-
+      , io_ring_{io_ring}
   {
   }
 
   StatusOr<std::unique_ptr<LogDevice>> open_log_device(const LogScanFn& scan_fn) override
   {
-    return FileLogDriver::recover(this->location_, scan_fn, this->scheduler_);
+    return FileLogDriver::recover(this->location_, scan_fn, this->scheduler_, this->io_ring_);
   }
 
  private:
   FileLogDriver::Location location_;
   batt::TaskScheduler& scheduler_;
+  const IoRing* io_ring_;
 };
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
@@ -293,18 +370,20 @@ class InitializeFileLogDeviceFactory : public LogDeviceFactory
   explicit InitializeFileLogDeviceFactory(const FileLogDriver::Location& location,
                                           const FileLogDriver::Config& config,
                                           batt::TaskScheduler& scheduler,
-                                          ConfirmThisWillEraseAllMyData confirm) noexcept
+                                          ConfirmThisWillEraseAllMyData confirm,
+                                          const IoRing* io_ring = nullptr) noexcept
       : location_{location}
       , config_{config}
       , scheduler_{scheduler}
       , confirm_{confirm}
+      , io_ring_{io_ring}
   {
   }
 
   StatusOr<std::unique_ptr<LogDevice>> open_log_device(const LogScanFn& scan_fn) override
   {
-    auto device =
-        FileLogDriver::initialize(this->location_, this->config_, this->scheduler_, this->confirm_);
+    auto device = FileLogDriver::initialize(this->location_, this->config_, this->scheduler_,
+                                            this->confirm_, this->io_ring_);
     BATT_REQUIRE_OK(device);
 
     std::unique_ptr<LogDevice::Reader> reader =
@@ -323,11 +402,13 @@ class InitializeFileLogDeviceFactory : public LogDeviceFactory
   FileLogDriver::Config config_;
   batt::TaskScheduler& scheduler_;
   ConfirmThisWillEraseAllMyData confirm_;
+  const IoRing* io_ring_;
 };
 
 }  // namespace llfs
 
 #include <llfs/file_log_driver/active_file.hpp>
 #include <llfs/file_log_driver/flush_task_main.hpp>
+#include <llfs/file_log_driver/ioring_flush_task_main.hpp>
 
 #endif  // LLFS_FILE_LOG_DRIVER_HPP
@@ -13,8 +13,115 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <llfs/ioring.hpp>
+
+#include <batteries/async/runtime.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+
 namespace {
 
+// Test Plan:
+//  1. (SegmentFilenameParser, SpareSegmentFilenameParser) segment file names round-trip.
+//  2. (IoRingFlushPath) A FileLogDevice whose flush task runs over a real IoRing makes committed
+//     data durable (across several segment splits), and the data is recovered intact (also via the
+//     IoRing path) after the device is closed.
+//  3. (SegmentPoolRecycling) With a segment pool, a new log fills the pool with empty,
+//     preallocated spare files; the active file is taken from the pool when it is split; trimmed
+//     segments go back into the pool; and after recovery the spare files aren't mistaken for log
+//     data, and are used for the next active files.
+
+using namespace llfs::int_types;
+
+// A file in a FileLogDriver's directory.
+//
+struct LogDirFile {
+  enum struct Kind {
+    kActive,
+    kSegment,
+    kSpare,
+    kOther,
+  };
+
+  Kind kind;
+  ino_t inode;
+  off_t size;
+  blkcnt_t blocks;
+};
+
+std::vector<LogDirFile> list_log_dir(const llfs::FileLogDriver::Location& location)
+{
+  std::vector<LogDirFile> files;
+
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator{location.parent_dir(), ec}) {
+    // Files may be renamed while we look at them; just skip the ones that are gone.
+    //
+    struct stat st;
+    if (::stat(entry.path().c_str(), &st) != 0) {
+      continue;
+    }
+
+    const std::string name = entry.path().filename().string();
+
+    LogDirFile::Kind kind = LogDirFile::Kind::kOther;
+    if (entry.path() == location.active_segment_file_path()) {
+      kind = LogDirFile::Kind::kActive;
+    } else if (location.spare_id_from_segment_file_name(name)) {
+      kind = LogDirFile::Kind::kSpare;
+    } else if (location.slot_range_from_segment_file_name(name)) {
+      kind = LogDirFile::Kind::kSegment;
+    }
+
+    files.emplace_back(LogDirFile{
+        .kind = kind,
+        .inode = st.st_ino,
+        .size = st.st_size,
+        .blocks = st.st_blocks,
+    });
+  }
+
+  return files;
+}
+
+// Polls the log directory until `pred` returns true for its contents (or a few seconds pass);
+// returns the last contents seen.
+//
+template <typename Pred>
+std::vector<LogDirFile> await_log_dir(const llfs::FileLogDriver::Location& location, Pred&& pred)
+{
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+  std::vector<LogDirFile> files = list_log_dir(location);
+  while (!pred(files) && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    files = list_log_dir(location);
+  }
+  return files;
+}
+
+std::set<ino_t> inodes_of_kind(const std::vector<LogDirFile>& files, LogDirFile::Kind kind)
+{
+  std::set<ino_t> inodes;
+  for (const LogDirFile& file : files) {
+    if (file.kind == kind) {
+      inodes.insert(file.inode);
+    }
+  }
+  return inodes;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
 TEST(FileLogDriverTest, SegmentFilenameParser)
 {
   using llfs::FileLogDriver;
@@ -46,4 +153,331 @@ TEST(FileLogDriverTest, SegmentFilenameParser)
             (SlotRange{0xa, 0xa}));
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST(FileLogDriverTest, SpareSegmentFilenameParser)
+{
+  using llfs::FileLogDriver;
+  using llfs::None;
+
+  FileLogDriver::Location loc{"not_used_"};
+
+  EXPECT_EQ(loc.spare_segment_file_path(0x2a).filename().string(), "spare_0000002a.tdbspare");
+  EXPECT_EQ(*loc.spare_id_from_segment_file_name("spare_0000002a.tdbspare"), 0x2au);
+  EXPECT_EQ(*loc.spare_id_from_segment_file_name(
+                loc.spare_segment_file_path(12345).filename().string()),
+            12345u);
+  EXPECT_EQ(loc.spare_id_from_segment_file_name("spare_.tdbspare"), None);
+  EXPECT_EQ(loc.spare_id_from_segment_file_name("spare_00g1.tdbspare"), None);
+  EXPECT_EQ(loc.spare_id_from_segment_file_name("spare_0001.tdblog"), None);
+  EXPECT_EQ(loc.spare_id_from_segment_file_name("not_used_0000.0001.tdblog"), None);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 3.
+//
+TEST(FileLogDriverTest, SegmentPoolRecycling)
+{
+  using Kind = LogDirFile::Kind;
+
+  const llfs::FileLogDriver::Location location{
+      std::filesystem::path{"/tmp/llfs_FileLogDriverTest_SegmentPoolRecycling"}};
+
+  constexpr usize kPoolSize = 2;
+  constexpr usize kMinSplitSize = 8 * 1024;
+  constexpr usize kMaxSize = 64 * 1024;
+  constexpr usize kSlotSize = 100;
+  constexpr usize kSlotCount = 4 * kMaxSize / kSlotSize;
+  constexpr usize kSyncEvery = 37;
+
+  // Keep about this much data in the log, trimming the rest.
+  //
+  constexpr usize kRetainedSize = kMaxSize / 4;
+
+  const auto fill_byte = [](usize offset) -> char {
+    return char('a' + (offset / kSlotSize) % 26);
+  };
+
+  const auto count_of_kind = [](const std::vector<LogDirFile>& files, Kind kind) -> usize {
+    return std::count_if(files.begin(), files.end(), [kind](const LogDirFile& file) {
+      return file.kind == kind;
+    });
+  };
+
+  batt::TaskScheduler& scheduler = batt::Runtime::instance().default_scheduler();
+
+  llfs::StatusOr<std::unique_ptr<llfs::FileLogDevice>> device = llfs::FileLogDriver::initialize(
+      location,
+      llfs::FileLogDriver::Config{
+          .min_segment_split_size = kMinSplitSize,
+          .max_size = kMaxSize,
+          .segment_pool_size = kPoolSize,
+      },
+      scheduler, llfs::ConfirmThisWillEraseAllMyData::kYes);
+  ASSERT_TRUE(device.ok()) << BATT_INSPECT(device.status());
+
+  // The pool is filled (in the background) with empty files whose blocks are already allocated.
+  //
+  std::vector<LogDirFile> files = await_log_dir(location, [&](const std::vector<LogDirFile>& f) {
+    return count_of_kind(f, Kind::kSpare) == kPoolSize;
+  });
+  ASSERT_EQ(count_of_kind(files, Kind::kSpare), kPoolSize);
+
+  for (const LogDirFile& file : files) {
+    if (file.kind == Kind::kSpare) {
+      EXPECT_EQ(file.size, 0);
+      EXPECT_GE(usize(file.blocks) * 512, kMinSplitSize);
+    }
+  }
+
+  const std::set<ino_t> initial_spares = inodes_of_kind(files, Kind::kSpare);
+
+  // Write several times the capacity of the log, trimming as we go; keep track of every file that
+  // has been the active file or a segment.
+  //
+  std::set<ino_t> active_files;
+  std::set<ino_t> segment_files;
+  usize trim_pos = 0;
+  {
+    llfs::LogDevice::Writer& writer = (*device)->writer();
+
+    for (usize i = 0; i < kSlotCount; ++i) {
+      llfs::StatusOr<llfs::MutableBuffer> buffer = writer.prepare(kSlotSize);
+      ASSERT_TRUE(buffer.ok()) << BATT_INSPECT(buffer.status());
+      std::memset(buffer->data(), fill_byte(i * kSlotSize), kSlotSize);
+
+      llfs::StatusOr<llfs::slot_offset_type> commit_pos = writer.commit(kSlotSize);
+      ASSERT_TRUE(commit_pos.ok()) << BATT_INSPECT(commit_pos.status());
+
+      if (i % kSyncEvery == 0) {
+        llfs::Status sync_status = (*device)->sync(llfs::LogReadMode::kDurable,
+                                                   llfs::SlotUpperBoundAt{*commit_pos});
+        ASSERT_TRUE(sync_status.ok()) << BATT_INSPECT(sync_status);
+
+        files = list_log_dir(location);
+        const std::set<ino_t> active = inodes_of_kind(files, Kind::kActive);
+        const std::set<ino_t> segments = inodes_of_kind(files, Kind::kSegment);
+        active_files.insert(active.begin(), active.end());
+        segment_files.insert(segments.begin(), segments.end());
+
+        if (*commit_pos > trim_pos + kRetainedSize) {
+          trim_pos = *commit_pos - kRetainedSize;
+          ASSERT_TRUE((*device)->trim(trim_pos).ok());
+        }
+      }
+    }
+  }
+
+  // When the first active file was split, the next one came from the pool.
+  //
+  EXPECT_TRUE(std::any_of(initial_spares.begin(), initial_spares.end(), [&](ino_t inode) {
+    return active_files.count(inode) != 0;
+  }));
+
+  // Trimmed segments are put back into the pool (emptied, but with their blocks allocated).
+  //
+  files = await_log_dir(location, [&](const std::vector<LogDirFile>& f) {
+    const std::set<ino_t> spares = inodes_of_kind(f, Kind::kSpare);
+    return spares.size() == kPoolSize &&
+           std::any_of(spares.begin(), spares.end(), [&](ino_t inode) {
+             return segment_files.count(inode) != 0;
+           });
+  });
+  ASSERT_EQ(count_of_kind(files, Kind::kSpare), kPoolSize);
+
+  usize recycled_count = 0;
+  for (const LogDirFile& file : files) {
+    if (file.kind == Kind::kSpare && segment_files.count(file.inode)) {
+      ++recycled_count;
+      EXPECT_EQ(file.size, 0);
+      EXPECT_GE(usize(file.blocks) * 512, kMinSplitSize);
+    }
+  }
+  EXPECT_GT(recycled_count, 0u);
+
+  const std::set<ino_t> spares_before_recovery = inodes_of_kind(files, Kind::kSpare);
+
+  ASSERT_TRUE((*device)->close().ok());
+  device->reset();
+
+  // Recover the log: the spare files hold no log data, and they are taken back into the pool.
+  //
+  llfs::slot_offset_type recovered_begin = 0;
+  usize recovered_size = 0;
+  llfs::StatusOr<std::unique_ptr<llfs::FileLogDevice>> recovered = llfs::FileLogDriver::recover(
+      location,
+      [&](llfs::LogDevice::Reader& reader) -> llfs::StatusOr<llfs::slot_offset_type> {
+        recovered_begin = reader.slot_offset();
+        for (;;) {
+          const llfs::ConstBuffer data = reader.data();
+          if (data.size() == 0) {
+            break;
+          }
+          const char* bytes = static_cast<const char*>(data.data());
+          for (usize i = 0; i < data.size(); ++i) {
+            const usize offset = recovered_begin + recovered_size + i;
+            EXPECT_EQ(bytes[i], fill_byte(offset)) << BATT_INSPECT(offset);
+          }
+          recovered_size += data.size();
+          reader.consume(data.size());
+        }
+        return reader.slot_offset();
+      },
+      scheduler);
+
+  ASSERT_TRUE(recovered.ok()) << BATT_INSPECT(recovered.status());
+  EXPECT_LE(recovered_begin, trim_pos);
+  EXPECT_EQ(recovered_begin + recovered_size, kSlotCount * kSlotSize);
+
+  // Keep writing until the active file has been split a few times; the spare files from before
+  // the recovery are used (rather than new ones), and no extra spare files are left behind.
+  //
+  std::set<ino_t> active_after_recovery;
+  {
+    llfs::LogDevice::Writer& writer = (*recovered)->writer();
+
+    usize offset = recovered_begin + recovered_size;
+    for (usize i = 0; i < 3 * kMinSplitSize / kSlotSize; ++i, offset += kSlotSize) {
+      llfs::StatusOr<llfs::MutableBuffer> buffer = writer.prepare(kSlotSize);
+      ASSERT_TRUE(buffer.ok()) << BATT_INSPECT(buffer.status());
+      std::memset(buffer->data(), fill_byte(offset), kSlotSize);
+
+      llfs::StatusOr<llfs::slot_offset_type> commit_pos = writer.commit(kSlotSize);
+      ASSERT_TRUE(commit_pos.ok()) << BATT_INSPECT(commit_pos.status());
+
+      if (i % kSyncEvery == 0) {
+        llfs::Status sync_status = (*recovered)->sync(llfs::LogReadMode::kDurable,
+                                                      llfs::SlotUpperBoundAt{*commit_pos});
+        ASSERT_TRUE(sync_status.ok()) << BATT_INSPECT(sync_status);
+
+        files = list_log_dir(location);
+        const std::set<ino_t> active = inodes_of_kind(files, Kind::kActive);
+        active_after_recovery.insert(active.begin(), active.end());
+
+        EXPECT_LE(count_of_kind(files, Kind::kSpare), kPoolSize);
+
+        if (*commit_pos > trim_pos + kRetainedSize) {
+          trim_pos = *commit_pos - kRetainedSize;
+          ASSERT_TRUE((*recovered)->trim(trim_pos).ok());
+        }
+      }
+    }
+  }
+
+  EXPECT_TRUE(
+      std::any_of(spares_before_recovery.begin(), spares_before_recovery.end(), [&](ino_t inode) {
+        return active_after_recovery.count(inode) != 0;
+      }));
+
+  ASSERT_TRUE((*recovered)->close().ok());
+  recovered->reset();
+
+  std::filesystem::remove_all(location.parent_dir());
+}
+
+#ifndef LLFS_DISABLE_IO_URING
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST(FileLogDriverTest, IoRingFlushPath)
+{
+  const llfs::FileLogDriver::Location location{
+      std::filesystem::path{"/tmp/llfs_FileLogDriverTest_IoRingFlushPath"}};
+
+  constexpr usize kSlotSize = 100;
+  constexpr usize kSlotCount = 500;
+  constexpr usize kSyncEvery = 37;
+
+  const auto fill_byte = [](usize offset) -> char {
+    return char('a' + (offset / kSlotSize) % 26);
+  };
+
+  llfs::StatusOr<llfs::ScopedIoRing> io =
+      llfs::ScopedIoRing::make_new(llfs::MaxQueueDepth{64}, llfs::ThreadPoolSize{1});
+  ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+
+  batt::TaskScheduler& scheduler = batt::Runtime::instance().default_scheduler();
+
+  // kSlotCount * kSlotSize is several times min_segment_split_size, so the active file is split
+  // (and a spare segment file reused) a few times.
+  //
+  llfs::StatusOr<std::unique_ptr<llfs::FileLogDevice>> device = llfs::FileLogDriver::initialize(
+      location,
+      llfs::FileLogDriver::Config{
+          .min_segment_split_size = 8 * 1024,
+          .max_size = 128 * 1024,
+          .segment_pool_size = 1,
+      },
+      scheduler, llfs::ConfirmThisWillEraseAllMyData::kYes, &io->get_io_ring());
+  ASSERT_TRUE(device.ok()) << BATT_INSPECT(device.status());
+
+  {
+    llfs::LogDevice::Writer& writer = (*device)->writer();
+
+    for (usize i = 0; i < kSlotCount; ++i) {
+      llfs::StatusOr<llfs::MutableBuffer> buffer = writer.prepare(kSlotSize);
+      ASSERT_TRUE(buffer.ok()) << BATT_INSPECT(buffer.status());
+      std::memset(buffer->data(), fill_byte(i * kSlotSize), kSlotSize);
+
+      llfs::StatusOr<llfs::slot_offset_type> commit_pos = writer.commit(kSlotSize);
+      ASSERT_TRUE(commit_pos.ok()) << BATT_INSPECT(commit_pos.status());
+      ASSERT_EQ(*commit_pos, (i + 1) * kSlotSize);
+
+      // Mix waiting for durability with committing ahead of the flush task.
+      //
+      if (i % kSyncEvery == 0) {
+        llfs::Status sync_status = (*device)->sync(llfs::LogReadMode::kDurable,
+                                                   llfs::SlotUpperBoundAt{*commit_pos});
+        ASSERT_TRUE(sync_status.ok()) << BATT_INSPECT(sync_status);
+      }
+    }
+
+    llfs::Status sync_status = (*device)->sync(llfs::LogReadMode::kDurable,
+                                               llfs::SlotUpperBoundAt{kSlotCount * kSlotSize});
+    ASSERT_TRUE(sync_status.ok()) << BATT_INSPECT(sync_status);
+
+    EXPECT_EQ((*device)->slot_range(llfs::LogReadMode::kDurable),
+              (llfs::SlotRange{0, kSlotCount * kSlotSize}));
+
+    ASSERT_TRUE((*device)->close().ok());
+    device->reset();
+  }
+
+  // Recover the log and check that all the data is there.
+  //
+  usize recovered_size = 0;
+  llfs::StatusOr<std::unique_ptr<llfs::FileLogDevice>> recovered = llfs::FileLogDriver::recover(
+      location,
+      [&](llfs::LogDevice::Reader& reader) -> llfs::StatusOr<llfs::slot_offset_type> {
+        for (;;) {
+          const llfs::ConstBuffer data = reader.data();
+          if (data.size() == 0) {
+            break;
+          }
+          const char* bytes = static_cast<const char*>(data.data());
+          for (usize i = 0; i < data.size(); ++i) {
+            EXPECT_EQ(bytes[i], fill_byte(recovered_size + i)) << BATT_INSPECT(recovered_size + i);
+          }
+          recovered_size += data.size();
+          reader.consume(data.size());
+        }
+        return reader.slot_offset();
+      },
+      scheduler, &io->get_io_ring());
+
+  ASSERT_TRUE(recovered.ok()) << BATT_INSPECT(recovered.status());
+  EXPECT_EQ(recovered_size, kSlotCount * kSlotSize);
+  EXPECT_EQ((*recovered)->slot_range(llfs::LogReadMode::kDurable),
+            (llfs::SlotRange{0, kSlotCount * kSlotSize}));
+
+  ASSERT_TRUE((*recovered)->close().ok());
+  recovered->reset();
+
+  std::filesystem::remove_all(location.parent_dir());
+}
+
+#endif  // LLFS_DISABLE_IO_URING
+
 }  // namespace
@@ -10,6 +10,7 @@
 //
 
 #include <llfs/filesystem.hpp>
+#include <llfs/logging.hpp>
 
 #include <batteries/syscall_retry.hpp>
 
@@ -136,7 +137,8 @@ Status FileLogDriver::ActiveFile::append(ConstBuffer buffer)
   }));
 }
 
-StatusOr<FileLogDriver::SegmentFile> FileLogDriver::ActiveFile::split()
+StatusOr<FileLogDriver::SegmentFile> FileLogDriver::ActiveFile::split(
+    Optional<std::string> spare_file_name)
 {
   BATT_CHECK_NE(this->fd_, -1) << "split may only be called on an open ActiveFile!";
 
@@ -161,9 +163,29 @@ StatusOr<FileLogDriver::SegmentFile> FileLogDriver::ActiveFile::split()
   //
   this->slot_range_.lower_bound = this->slot_range_.upper_bound;
 
-  // Create a new active file for writing.
+  // Create a new active file for writing, preferring a preallocated spare file if we have one.
   //
-  StatusOr<int> new_fd = create_active_file(this->location_);
+  StatusOr<int> new_fd = [&]() -> StatusOr<int> {
+    if (spare_file_name) {
+      const fs::path active_file_path = this->location_.active_segment_file_path();
+
+      int retval = batt::syscall_retry([&] {
+        return ::rename(/*from=*/spare_file_name->c_str(), /*to=*/active_file_path.c_str());
+      });
+      if (retval == 0) {
+        StatusOr<int> fd = open_file_read_write(active_file_path.string());
+        if (fd.ok()) {
+          return fd;
+        }
+        LLFS_LOG_WARNING() << "Failed to open spare segment file; creating a new one: "
+                           << fd.status();
+      } else {
+        LLFS_LOG_WARNING() << "Failed to rename spare segment file " << *spare_file_name
+                           << "; creating a new one: " << status_from_retval(retval);
+      }
+    }
+    return create_active_file(this->location_);
+  }();
   BATT_REQUIRE_OK(new_fd);
 
   this->fd_ = *new_fd;
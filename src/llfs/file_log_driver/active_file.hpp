@@ -49,6 +49,21 @@ class FileLogDriver::ActiveFile
   //
   Status append(ConstBuffer buffer);
 
+  // Records that `byte_count` bytes have been written to the end of the file by some other means
+  // than `append` (e.g., via an IoRing).
+  //
+  void extend(u64 byte_count)
+  {
+    this->slot_range_.upper_bound += byte_count;
+  }
+
+  // The file descriptor of the active file; ownership is retained by this object.
+  //
+  int get_fd() const
+  {
+    return this->fd_;
+  }
+
   // Close the file; invalidates this object.
   //
   void close() noexcept;
@@ -67,9 +82,10 @@ class FileLogDriver::ActiveFile
     return this->slot_range_;
   }
 
-  // Finalize the contents of this file and move on to the next one.
+  // Finalize the contents of this file and move on to the next one.  If `spare_file_name` is
+  // given, that (empty) file becomes the new active file; otherwise a new file is created.
   //
-  StatusOr<SegmentFile> split();
+  StatusOr<SegmentFile> split(Optional<std::string> spare_file_name = None);
 
  private:
   // Create a new active file and return its file descriptor.
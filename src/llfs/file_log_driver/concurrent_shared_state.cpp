@@ -8,6 +8,14 @@
 
 #include <llfs/file_log_driver.hpp>
 
+#include <llfs/filesystem.hpp>
+#include <llfs/logging.hpp>
+
+#include <batteries/finally.hpp>
+#include <batteries/syscall_retry.hpp>
+
+#include <fcntl.h>
+
 namespace llfs {
 
 void FileLogDriver::ConcurrentSharedState::halt()
@@ -18,4 +26,50 @@ void FileLogDriver::ConcurrentSharedState::halt()
   this->segments.close();
 }
 
+Optional<std::string> FileLogDriver::ConcurrentSharedState::take_spare_segment_file()
+{
+  auto locked = this->spare_segment_files.lock();
+  if (locked->empty()) {
+    return None;
+  }
+  std::string file_name = std::move(locked->back());
+  locked->pop_back();
+  return file_name;
+}
+
+usize FileLogDriver::ConcurrentSharedState::spare_segment_file_count()
+{
+  return this->spare_segment_files.lock()->size();
+}
+
+Status FileLogDriver::ConcurrentSharedState::add_spare_segment_file(std::string&& file_name)
+{
+  StatusOr<int> fd = open_file_read_write(file_name);
+  BATT_REQUIRE_OK(fd);
+
+  const auto close_on_exit = batt::finally([&] {
+    close_fd(*fd).IgnoreError();
+  });
+
+  // Discard any old contents, then reserve space without changing the file size, so that the file
+  // still reads as an empty segment on recovery.
+  //
+  BATT_REQUIRE_OK(truncate_fd(*fd, 0));
+
+  const int retval = batt::syscall_retry([&] {
+    return ::fallocate(*fd, FALLOC_FL_KEEP_SIZE, /*offset=*/0,
+                       /*len=*/this->config.min_segment_split_size);
+  });
+  if (retval != 0) {
+    // Not all filesystems support fallocate; the file is still worth reusing.
+    //
+    LLFS_VLOG(1) << "fallocate failed for spare segment " << file_name << ": "
+                 << status_from_retval(retval);
+  }
+
+  this->spare_segment_files.lock()->emplace_back(std::move(file_name));
+
+  return OkStatus();
+}
+
 }  // namespace llfs
@@ -55,7 +55,8 @@ void FileLogDriver::FlushTaskMain::operator()()
       // Check to see if the active file is big enough to be split.
       //
       if (this->active_file_.size() >= this->shared_state_.config.min_segment_split_size) {
-        StatusOr<SegmentFile> next_segment = this->active_file_.split();
+        StatusOr<SegmentFile> next_segment =
+            this->active_file_.split(this->shared_state_.take_spare_segment_file());
         BATT_REQUIRE_OK(next_segment);
         BATT_REQUIRE_OK(this->shared_state_.segments.push(std::move(*next_segment)));
       }
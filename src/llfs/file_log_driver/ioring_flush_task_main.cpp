@@ -0,0 +1,164 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/file_log_driver.hpp>
+
+#ifndef LLFS_DISABLE_IO_URING
+
+#include <llfs/logging.hpp>
+
+namespace llfs {
+
+FileLogDriver::IoRingFlushTaskMain::IoRingFlushTaskMain(const RingBuffer& buffer,
+                                                        ConcurrentSharedState& shared_state,
+                                                        ActiveFile&& active_file,
+                                                        const IoRing& io_ring) noexcept
+    : buffer_{buffer}
+    , shared_state_{shared_state}
+    , active_file_{std::move(active_file)}
+    , io_ring_{&io_ring}
+{
+}
+
+void FileLogDriver::IoRingFlushTaskMain::operator()()
+{
+  this->open_ioring_file();
+
+  const Status status = [&] {
+    // `local_write_pos` is the end of the data appended to the active file; `flush_pos` trails it
+    // until the sync covering that data has completed.
+    //
+    auto local_commit_pos = this->shared_state_.commit_pos.get_value();
+    auto local_write_pos = this->shared_state_.flush_pos.get_value();
+    for (;;) {
+      ConstBuffer bytes_to_flush{this->buffer_.get(local_write_pos).data(),
+                                 slot_distance(local_write_pos, local_commit_pos)};
+
+      if (bytes_to_flush.size() == 0) {
+        // If a sync is still in flight, finish it rather than going to sleep; otherwise we've
+        // caught up, so wait for more data to flush.
+        //
+        if (this->pending_sync_) {
+          BATT_REQUIRE_OK(this->finish_sync());
+          local_commit_pos = this->shared_state_.commit_pos.get_value();
+          continue;
+        }
+        StatusOr<slot_offset_type> updated_commit_pos =
+            await_slot_offset(local_write_pos + 1, this->shared_state_.commit_pos);
+        BATT_REQUIRE_OK(updated_commit_pos);
+        local_commit_pos = *updated_commit_pos;
+        continue;
+      }
+
+      // Append the next batch while the previous sync (if any) is still in flight, then wait for
+      // that sync and start a new one covering the data just appended.
+      //
+      BATT_REQUIRE_OK(this->append(bytes_to_flush));
+      local_write_pos += bytes_to_flush.size();
+
+      BATT_REQUIRE_OK(this->finish_sync());
+      this->start_sync();
+
+      // Check to see if the active file is big enough to be split.  All data must be durable
+      // before the file is finalized.
+      //
+      if (this->active_file_.size() >= this->shared_state_.config.min_segment_split_size) {
+        BATT_REQUIRE_OK(this->finish_sync());
+        this->release_ioring_file();
+
+        StatusOr<SegmentFile> next_segment =
+            this->active_file_.split(this->shared_state_.take_spare_segment_file());
+        BATT_REQUIRE_OK(next_segment);
+
+        this->open_ioring_file();
+        BATT_REQUIRE_OK(this->shared_state_.segments.push(std::move(*next_segment)));
+      }
+
+      // Pick up whatever was committed while we were appending/syncing, so that it is appended
+      // while the sync just started is still in flight.
+      //
+      local_commit_pos = this->shared_state_.commit_pos.get_value();
+    }
+  }();
+
+  // Don't let the fd go away while a sync is still using it.
+  //
+  if (this->pending_sync_) {
+    this->pending_sync_->await().IgnoreError();
+    this->pending_sync_ = nullptr;
+  }
+  this->release_ioring_file();
+
+  LLFS_LOG_INFO() << "[FileLogDriver::ioring_flush_task_main] finished with status=" << status;
+}
+
+Status FileLogDriver::IoRingFlushTaskMain::append(ConstBuffer bytes)
+{
+  const i64 file_offset = BATT_CHECKED_CAST(i64, this->active_file_.size());
+
+  BATT_REQUIRE_OK(this->ioring_file_->write_all(file_offset, bytes));
+
+  this->active_file_.extend(bytes.size());
+
+  return OkStatus();
+}
+
+void FileLogDriver::IoRingFlushTaskMain::start_sync()
+{
+  BATT_CHECK_EQ(this->pending_sync_, nullptr);
+
+  auto done = batt::make_shared<batt::Latch<slot_offset_type>>();
+  const slot_offset_type flush_upper_bound = this->active_file_.slot_range().upper_bound;
+
+  this->ioring_file_->async_fdatasync([done, flush_upper_bound](StatusOr<i32> result) {
+    if (!result.ok()) {
+      done->set_error(result.status());
+    } else {
+      done->set_value(flush_upper_bound);
+    }
+  });
+
+  this->pending_sync_ = std::move(done);
+}
+
+Status FileLogDriver::IoRingFlushTaskMain::finish_sync()
+{
+  if (!this->pending_sync_) {
+    return OkStatus();
+  }
+
+  StatusOr<slot_offset_type> flush_upper_bound = this->pending_sync_->await();
+  this->pending_sync_ = nullptr;
+  BATT_REQUIRE_OK(flush_upper_bound);
+
+  // This task is the only updater of `flush_pos`.
+  //
+  this->shared_state_.flush_pos.set_value(*flush_upper_bound);
+
+  return OkStatus();
+}
+
+void FileLogDriver::IoRingFlushTaskMain::open_ioring_file()
+{
+  BATT_CHECK(!this->ioring_file_);
+
+  this->ioring_file_.emplace(*this->io_ring_, this->active_file_.get_fd());
+  this->ioring_file_->set_raw_io(false);
+}
+
+void FileLogDriver::IoRingFlushTaskMain::release_ioring_file()
+{
+  if (this->ioring_file_) {
+    this->ioring_file_->release();
+    this->ioring_file_ = None;
+  }
+}
+
+}  // namespace llfs
+
+#endif  // LLFS_DISABLE_IO_URING
@@ -0,0 +1,91 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_FILE_LOG_DRIVER_IORING_FLUSH_TASK_MAIN_HPP
+#define LLFS_FILE_LOG_DRIVER_IORING_FLUSH_TASK_MAIN_HPP
+
+#include <llfs/config.hpp>
+
+#ifndef LLFS_DISABLE_IO_URING
+
+#include <llfs/ioring_file.hpp>
+
+#include <batteries/async/latch.hpp>
+#include <batteries/shared_ptr.hpp>
+
+namespace llfs {
+
+// Variant of FlushTaskMain that appends to the active segment file and syncs it via an IoRing
+// instead of blocking syscalls.  The append of the next batch of committed data is pipelined with
+// the fdatasync of the previous batch, so at most one sync is in flight at a time.
+//
+class FileLogDriver::IoRingFlushTaskMain
+{
+ public:
+  explicit IoRingFlushTaskMain(const RingBuffer& buffer, ConcurrentSharedState& shared_state,
+                               ActiveFile&& active_file, const IoRing& io_ring) noexcept;
+
+  // The flush task main loop entry point.
+  //
+  void operator()();
+
+ private:  //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+  // Write all of `bytes` to the end of the active file.
+  //
+  Status append(ConstBuffer bytes);
+
+  // Submit an fdatasync for all data appended so far.
+  //
+  void start_sync();
+
+  // Wait for the in-flight sync (if any) to complete, then publish the new flush_pos.
+  //
+  Status finish_sync();
+
+  // Wraps the fd of `this->active_file_` in an IoRing::File.
+  //
+  void open_ioring_file();
+
+  // Stops `this->ioring_file_` from closing the fd owned by `this->active_file_`.
+  //
+  void release_ioring_file();
+
+  //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  // Read-only access to the ring buffer contents.
+  //
+  const RingBuffer& buffer_;
+
+  // Thread-safe shared state used to communicate with committers and trimmers.
+  //
+  ConcurrentSharedState& shared_state_;
+
+  // The current active segment file; this object owns the fd.
+  //
+  ActiveFile active_file_;
+
+  // Used to submit appends and syncs.
+  //
+  const IoRing* io_ring_;
+
+  // Refers to the fd of `this->active_file_`; the fd is released (not closed) when switching active
+  // files.
+  //
+  Optional<IoRing::File> ioring_file_;
+
+  // The sync currently in flight, if any; set to the log offset up to which data is durable once
+  // the sync completes.
+  //
+  batt::SharedPtr<batt::Latch<slot_offset_type>> pending_sync_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_DISABLE_IO_URING
+#endif  // LLFS_FILE_LOG_DRIVER_IORING_FLUSH_TASK_MAIN_HPP
@@ -15,6 +15,8 @@
 
 #include <cctype>
 #include <charconv>
+#include <iomanip>
+#include <sstream>
 
 namespace llfs {
 
@@ -34,6 +36,39 @@ fs::path FileLogDriver::Location::active_segment_file_path() const
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
+fs::path FileLogDriver::Location::spare_segment_file_path(u64 spare_id) const
+{
+  std::ostringstream oss;
+  oss << Location::spare_segment_file_prefix() << std::hex << std::setw(8) << std::setfill('0')
+      << spare_id << Location::spare_segment_ext();
+  return this->parent_dir_ / std::move(oss).str();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<u64> FileLogDriver::Location::spare_id_from_segment_file_name(
+    const std::string& name) const
+{
+  if (!boost::algorithm::starts_with(name, Location::spare_segment_file_prefix()) ||
+      !boost::algorithm::ends_with(name, Location::spare_segment_ext())) {
+    return None;
+  }
+
+  const char* const first = name.c_str() + Location::spare_segment_file_prefix().length();
+  const char* const last = name.c_str() + name.length() - Location::spare_segment_ext().length();
+  if (first >= last) {
+    return None;
+  }
+
+  u64 spare_id = 0;
+  std::from_chars_result result = std::from_chars(first, last, spare_id, /*base=*/16);
+  if (result.ec != std::errc() || result.ptr != last) {
+    return None;
+  }
+
+  return spare_id;
+}
+
 std::string FileLogDriver::Location::segment_file_name_from_slot_range(
     const SlotRange& slot_range) const
 {
@@ -30,7 +30,8 @@ namespace llfs {
 namespace fs = std::filesystem;
 
 // Reference implementation of PageDevice.  This is slow; not to be used in
-// production... for testing/development only!
+// production... for testing/development only!  (Where io_uring isn't available,
+// see PosixPageFileDevice.)
 //
 class FilesystemPageDevice : public PageDevice
 {
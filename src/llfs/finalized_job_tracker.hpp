@@ -24,6 +24,7 @@ namespace llfs {
 
 class CommittablePageCacheJob;
 class FinalizedJobTracker;
+class FinalizedPageIndex;
 class PageCacheJob;
 
 std::shared_ptr<const PageCacheJob> lock_job(const FinalizedJobTracker* tracker);
@@ -51,10 +52,19 @@ class FinalizedJobTracker : public boost::intrusive_ref_counter<FinalizedJobTrac
 
   void cancel();
 
+  // The page index of the pipeline the job belongs to (see PageCacheJob::set_page_index); may be
+  // nullptr.
+  //
+  const std::shared_ptr<FinalizedPageIndex>& page_index() const
+  {
+    return this->page_index_;
+  }
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
  private:
   std::weak_ptr<const PageCacheJob> job_;
   batt::Watch<PageCacheJobProgress> progress_;
+  std::shared_ptr<FinalizedPageIndex> page_index_;
 };
 
 }  //namespace llfs
@@ -71,6 +71,16 @@ u64 FinalizedPageCacheJob::job_id() const
   return job->job_id;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::shared_ptr<FinalizedPageIndex> FinalizedPageCacheJob::page_index() const
+{
+  if (!this->tracker_) {
+    return nullptr;
+  }
+  return this->tracker_->page_index();
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 void FinalizedPageCacheJob::prefetch_hint(PageId page_id) /*override*/
@@ -94,6 +104,21 @@ StatusOr<PinnedPage> FinalizedPageCacheJob::get_page_with_layout_in_job(
   return this->finalized_get(page_id, required_layout, ok_if_not_found);
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status FinalizedPageCacheJob::append_page_refs(PageId page_id,
+                                               std::vector<PageId>* refs) /*override*/
+{
+  // New pages of the job (including streamed ones, which are no longer pinned) can be traced
+  // without loading them.
+  //
+  const std::shared_ptr<const PageCacheJob> job = lock_job(this->tracker_.get());
+  if (job != nullptr && job->append_new_page_refs(page_id, refs)) {
+    return OkStatus();
+  }
+  return PageLoader::append_page_refs(page_id, refs);
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 void FinalizedPageCacheJob::finalized_prefetch_hint(PageId page_id, PageCache& cache) const
@@ -25,11 +25,13 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 namespace llfs {
 
 class PageCache;
 class CommittablePageCacheJob;
+class FinalizedPageIndex;
 
 class FinalizedPageCacheJob : public PageLoader
 {
@@ -57,6 +59,8 @@ class FinalizedPageCacheJob : public PageLoader
                                                    PinPageToJob pin_page_to_job,
                                                    OkIfNotFound ok_if_not_found) override;
 
+  Status append_page_refs(PageId page_id, std::vector<PageId>* refs) override;
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   void finalized_prefetch_hint(PageId page_id, PageCache& cache) const;
@@ -68,6 +72,10 @@ class FinalizedPageCacheJob : public PageLoader
 
   Status await_durable() const;
 
+  // Returns the page index of the job's pipeline, or nullptr if there is none.
+  //
+  std::shared_ptr<FinalizedPageIndex> page_index() const;
+
  private:
   explicit FinalizedPageCacheJob(boost::intrusive_ptr<FinalizedJobTracker>&& tracker) noexcept;
 
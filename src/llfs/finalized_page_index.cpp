@@ -0,0 +1,111 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/finalized_page_index.hpp>
+//
+
+#include <llfs/page_cache_job.hpp>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void FinalizedPageIndex::insert(PageId page_id,
+                                const boost::intrusive_ptr<FinalizedJobTracker>& tracker)
+{
+  Shard& shard = this->shard_for(page_id);
+  std::unique_lock<std::mutex> lock{shard.mutex};
+
+  shard.jobs[page_id] = tracker;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void FinalizedPageIndex::erase(PageId page_id, const FinalizedJobTracker* tracker)
+{
+  // Release the tracker outside the lock, in case this is the last reference to it.
+  //
+  boost::intrusive_ptr<FinalizedJobTracker> removed;
+  {
+    Shard& shard = this->shard_for(page_id);
+    std::unique_lock<std::mutex> lock{shard.mutex};
+
+    auto iter = shard.jobs.find(page_id);
+    if (iter != shard.jobs.end() && iter->second.get() == tracker) {
+      removed = std::move(iter->second);
+      shard.jobs.erase(iter);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+boost::intrusive_ptr<FinalizedJobTracker> FinalizedPageIndex::find(PageId page_id) const
+{
+  const Shard& shard = this->shard_for(page_id);
+  std::unique_lock<std::mutex> lock{shard.mutex};
+
+  auto iter = shard.jobs.find(page_id);
+  if (iter == shard.jobs.end()) {
+    return nullptr;
+  }
+  return iter->second;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<PinnedPage> FinalizedPageIndex::finalized_get(PageId page_id) const
+{
+  const boost::intrusive_ptr<FinalizedJobTracker> tracker = this->find(page_id);
+  if (tracker == nullptr) {
+    return Status{batt::StatusCode::kUnavailable};
+  }
+
+  const std::shared_ptr<const PageCacheJob> job = lock_job(tracker.get());
+  if (job == nullptr) {
+    if (tracker->get_progress() == PageCacheJobProgress::kCancelled) {
+      return Status{batt::StatusCode::kCancelled};
+    }
+    return Status{batt::StatusCode::kUnavailable};
+  }
+
+  Optional<PinnedPage> already_pinned = job->get_already_pinned(page_id);
+  if (already_pinned) {
+    return std::move(*already_pinned);
+  }
+
+  return Status{batt::StatusCode::kUnavailable};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize FinalizedPageIndex::size() const
+{
+  usize total = 0;
+  for (const batt::CpuCacheLineIsolated<Shard>& shard : this->shards_) {
+    std::unique_lock<std::mutex> lock{shard->mutex};
+    total += shard->jobs.size();
+  }
+  return total;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto FinalizedPageIndex::shard_for(PageId page_id) -> Shard&
+{
+  return *this->shards_[PageId::Hash{}(page_id) % kShardCount];
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto FinalizedPageIndex::shard_for(PageId page_id) const -> const Shard&
+{
+  return *this->shards_[PageId::Hash{}(page_id) % kShardCount];
+}
+
+}  // namespace llfs
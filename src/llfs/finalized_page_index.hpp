@@ -0,0 +1,97 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_FINALIZED_PAGE_INDEX_HPP
+#define LLFS_FINALIZED_PAGE_INDEX_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/finalized_job_tracker.hpp>
+#include <llfs/int_types.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/pinned_page.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/cpu_align.hpp>
+
+#include <array>
+#include <mutex>
+#include <unordered_map>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Maps the new pages of all the finalized-but-not-yet-durable jobs in a pipeline to the job
+ * that created them.
+ *
+ * Without an index, a job looks up pages created by its speculative predecessors by walking the
+ * chain of base jobs (see PageCacheJob::set_base_job), one job at a time; a miss walks the whole
+ * chain.  When an index is shared by all the jobs in a pipeline (PageCacheJob::set_page_index),
+ * each lookup instead goes straight to the producing job.
+ *
+ * A job's pages are added when it is finalized (CommittablePageCacheJob::from) and removed once
+ * the job is durable (or destroyed).  Entries are spread over a fixed number of shards, each with
+ * its own mutex, so that jobs on different threads don't contend on a single lock.
+ */
+class FinalizedPageIndex
+{
+ public:
+  static constexpr usize kShardCount = 16;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  FinalizedPageIndex() = default;
+
+  FinalizedPageIndex(const FinalizedPageIndex&) = delete;
+  FinalizedPageIndex& operator=(const FinalizedPageIndex&) = delete;
+
+  /** \brief Records that `page_id` was created by the job tracked by `tracker`.
+   */
+  void insert(PageId page_id, const boost::intrusive_ptr<FinalizedJobTracker>& tracker);
+
+  /** \brief Removes the entry for `page_id`, if it still refers to `tracker`.
+   */
+  void erase(PageId page_id, const FinalizedJobTracker* tracker);
+
+  /** \brief Returns the tracker of the job that created `page_id`, or nullptr if there is none.
+   */
+  boost::intrusive_ptr<FinalizedJobTracker> find(PageId page_id) const;
+
+  /** \brief Returns the page from the job that created it, if that job is still alive and has the
+   * page pinned.  Returns kUnavailable if the page should be loaded from the cache instead, or
+   * kCancelled if the producing job has been cancelled.
+   */
+  StatusOr<PinnedPage> finalized_get(PageId page_id) const;
+
+  /** \brief Returns the number of pages in the index.
+   */
+  usize size() const;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  struct Shard {
+    // Protects `jobs`.
+    //
+    mutable std::mutex mutex;
+
+    std::unordered_map<PageId, boost::intrusive_ptr<FinalizedJobTracker>, PageId::Hash> jobs;
+  };
+
+  Shard& shard_for(PageId page_id);
+
+  const Shard& shard_for(PageId page_id) const;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  std::array<batt::CpuCacheLineIsolated<Shard>, kShardCount> shards_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_FINALIZED_PAGE_INDEX_HPP
@@ -0,0 +1,81 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/finalized_page_index.hpp>
+//
+#include <llfs/finalized_page_index.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/page_cache_job.hpp>
+
+namespace {
+
+// Test Plan:
+//
+//  1. find returns the tracker a page was inserted with, and nullptr for unknown pages.
+//  2. erase only removes an entry if it still refers to the given tracker.
+//  3. finalized_get returns kUnavailable for unknown pages and pages whose job is gone, and
+//     kCancelled if the job was cancelled.
+
+using namespace llfs::int_types;
+
+using llfs::FinalizedJobTracker;
+using llfs::FinalizedPageIndex;
+using llfs::PageId;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(FinalizedPageIndexTest, InsertFindErase)
+{
+  FinalizedPageIndex index;
+
+  boost::intrusive_ptr<FinalizedJobTracker> tracker_a{new FinalizedJobTracker{nullptr}};
+  boost::intrusive_ptr<FinalizedJobTracker> tracker_b{new FinalizedJobTracker{nullptr}};
+
+  for (u64 i = 0; i < 100; ++i) {
+    index.insert(PageId{i}, (i % 2) ? tracker_a : tracker_b);
+  }
+  EXPECT_EQ(index.size(), 100u);
+
+  EXPECT_EQ(index.find(PageId{1}), tracker_a);
+  EXPECT_EQ(index.find(PageId{2}), tracker_b);
+  EXPECT_EQ(index.find(PageId{1000}), nullptr);
+
+  // Erasing with the wrong tracker is a no-op.
+  //
+  index.erase(PageId{1}, tracker_b.get());
+  EXPECT_EQ(index.find(PageId{1}), tracker_a);
+
+  for (u64 i = 1; i < 100; i += 2) {
+    index.erase(PageId{i}, tracker_a.get());
+  }
+  EXPECT_EQ(index.size(), 50u);
+  EXPECT_EQ(index.find(PageId{1}), nullptr);
+  EXPECT_EQ(index.find(PageId{2}), tracker_b);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(FinalizedPageIndexTest, FinalizedGetWithoutJob)
+{
+  FinalizedPageIndex index;
+
+  boost::intrusive_ptr<FinalizedJobTracker> tracker{new FinalizedJobTracker{nullptr}};
+  index.insert(PageId{7}, tracker);
+
+  EXPECT_EQ(index.finalized_get(PageId{8}).status(), batt::StatusCode::kUnavailable);
+  EXPECT_EQ(index.finalized_get(PageId{7}).status(), batt::StatusCode::kUnavailable);
+
+  tracker->cancel();
+
+  EXPECT_EQ(index.finalized_get(PageId{7}).status(), batt::StatusCode::kCancelled);
+}
+
+}  // namespace
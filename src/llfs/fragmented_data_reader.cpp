@@ -0,0 +1,163 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/fragmented_data_reader.hpp>
+//
+
+#include <llfs/varint.hpp>
+
+#include <batteries/assert.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+FragmentedDataReader::FragmentedDataReader(const batt::Slice<const ConstBuffer>& buffers) noexcept
+{
+  for (const ConstBuffer& buffer : buffers) {
+    if (buffer.size() != 0) {
+      this->buffers_.emplace_back(buffer);
+      this->total_size_ += buffer.size();
+    }
+  }
+  this->bytes_available_ = this->total_size_;
+  this->next_buffer();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<u64> FragmentedDataReader::read_varint()
+{
+  if (this->at_end_) {
+    return None;
+  }
+
+  // Common case: the varint ends within the current buffer.
+  //
+  {
+    const u8* const first = static_cast<const u8*>(this->unread_.data());
+    auto [n, parse_end] = unpack_varint_from(first, first + this->unread_.size());
+    if (BATT_HINT_TRUE(n && parse_end)) {
+      this->consume_within_buffer(parse_end - first);
+      return n;
+    }
+  }
+
+  // The varint straddles a buffer boundary (or is truncated).
+  //
+  u8 bytes[kMaxVarInt64Size];
+  const usize byte_count = std::min(this->bytes_available_, sizeof(bytes));
+  this->copy_to(bytes, byte_count);
+
+  auto [n, parse_end] = unpack_varint_from(bytes, bytes + byte_count);
+  if (!n || !parse_end) {
+    this->at_end_ = true;
+    return None;
+  }
+
+  this->consume(parse_end - bytes);
+  return n;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<ConstBuffer> FragmentedDataReader::read_length_prefixed()
+{
+  if (this->at_end_) {
+    return None;
+  }
+
+  // Save the reader state so that nothing is consumed if the unit is incomplete.
+  //
+  const usize saved_next_buffer_i = this->next_buffer_i_;
+  const ConstBuffer saved_unread = this->unread_;
+  const usize saved_bytes_available = this->bytes_available_;
+
+  Optional<u64> size = this->read_varint();
+  if (size) {
+    Optional<ConstBuffer> data = this->read_contiguous(*size);
+    if (data) {
+      return data;
+    }
+  }
+
+  this->next_buffer_i_ = saved_next_buffer_i;
+  this->unread_ = saved_unread;
+  this->bytes_available_ = saved_bytes_available;
+  this->at_end_ = true;
+
+  return None;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+ConstBuffer FragmentedDataReader::read_straddling(usize byte_count)
+{
+  BATT_CHECK_LE(byte_count, this->bytes_available_);
+
+  if (this->scratch_.size() < byte_count) {
+    this->scratch_.resize(byte_count);
+  }
+  this->copy_to(this->scratch_.data(), byte_count);
+  this->consume(byte_count);
+  this->bytes_copied_ += byte_count;
+
+  return ConstBuffer{this->scratch_.data(), byte_count};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void FragmentedDataReader::consume(usize byte_count)
+{
+  BATT_CHECK_LE(byte_count, this->bytes_available_);
+
+  while (byte_count > 0) {
+    const usize n = std::min(byte_count, this->unread_.size());
+    this->consume_within_buffer(n);
+    byte_count -= n;
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void FragmentedDataReader::next_buffer()
+{
+  if (this->next_buffer_i_ < this->buffers_.size()) {
+    this->unread_ = this->buffers_[this->next_buffer_i_];
+    ++this->next_buffer_i_;
+  } else {
+    this->unread_ = ConstBuffer{};
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void FragmentedDataReader::copy_to(u8* dst, usize byte_count) const
+{
+  BATT_CHECK_LE(byte_count, this->bytes_available_);
+
+  ConstBuffer src = this->unread_;
+  usize src_i = this->next_buffer_i_;
+
+  while (byte_count > 0) {
+    const usize n = std::min(byte_count, src.size());
+    std::memcpy(dst, src.data(), n);
+    dst += n;
+    byte_count -= n;
+    if (byte_count > 0) {
+      BATT_CHECK_LT(src_i, this->buffers_.size());
+      src = this->buffers_[src_i];
+      ++src_i;
+    }
+  }
+}
+
+}  // namespace llfs
@@ -0,0 +1,207 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_FRAGMENTED_DATA_READER_HPP
+#define LLFS_FRAGMENTED_DATA_READER_HPP
+
+#include <llfs/buffer.hpp>
+#include <llfs/data_reader.hpp>
+#include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
+
+#include <batteries/hint.hpp>
+#include <batteries/slice.hpp>
+#include <batteries/small_vec.hpp>
+#include <batteries/type_traits.hpp>
+
+#include <vector>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Reads packed data from a sequence of buffers as if they were one contiguous buffer, e.g.
+ * the BufferViews of an IoRingStreamBuffer::Fragment, or the two halves of a log region that wraps
+ * around the end of the ring.
+ *
+ * Records are returned in place (without copying) when they lie entirely within one of the
+ * buffers; only the ones that straddle a boundary between buffers are copied, into a scratch
+ * buffer owned by the reader.  A copied record is only valid until the next read that has to copy;
+ * records returned in place are valid for as long as the buffers passed in at construction.
+ *
+ * Packed records contain self-relative offsets (e.g. PackedBytes::data_offset), so a record along
+ * with all the data it refers to must be read as one contiguous unit: `read_contiguous` or
+ * `read_length_prefixed` (for varint-size-prefixed units such as log slots), optionally followed by
+ * a DataReader over the result (`read_contiguous_reader`).
+ */
+class FragmentedDataReader
+{
+ public:
+  static constexpr usize kMaxInlineBuffers = 4;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Creates a reader over the concatenation of `buffers`.
+   */
+  explicit FragmentedDataReader(const batt::Slice<const ConstBuffer>& buffers) noexcept;
+
+  /** \brief Creates a reader over the concatenation of the items produced by `seq`, each of which
+   * has `data()` and `size()` (e.g. `IoRingStreamBuffer::Fragment::as_seq()`).
+   */
+  template <typename BufferSeq>
+  static FragmentedDataReader from_seq(BufferSeq&& seq) noexcept
+  {
+    batt::SmallVec<ConstBuffer, kMaxInlineBuffers> buffers;
+    for (;;) {
+      auto next = seq.next();
+      if (!next) {
+        break;
+      }
+      buffers.emplace_back(ConstBuffer{next->data(), next->size()});
+    }
+    return FragmentedDataReader{batt::as_slice(buffers.data(), buffers.size())};
+  }
+
+  FragmentedDataReader(const FragmentedDataReader&) = delete;
+  FragmentedDataReader& operator=(const FragmentedDataReader&) = delete;
+
+  FragmentedDataReader(FragmentedDataReader&&) = default;
+  FragmentedDataReader& operator=(FragmentedDataReader&&) = default;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  usize bytes_consumed() const
+  {
+    return this->total_size_ - this->bytes_available_;
+  }
+
+  usize bytes_available() const
+  {
+    return this->bytes_available_;
+  }
+
+  bool at_end() const
+  {
+    return this->at_end_;
+  }
+
+  void reset_flags()
+  {
+    this->at_end_ = false;
+  }
+
+  /** \brief The total number of bytes copied into the scratch buffer so far (because they
+   * straddled a buffer boundary).
+   */
+  usize bytes_copied() const
+  {
+    return this->bytes_copied_;
+  }
+
+  /** \brief Reads the next `byte_count` bytes as one contiguous buffer.  Returns None (and sets the
+   * at-end flag, consuming nothing) if fewer than `byte_count` bytes are available.
+   */
+  Optional<ConstBuffer> read_contiguous(usize byte_count)
+  {
+    if (this->at_end_ || this->bytes_available_ < byte_count) {
+      this->at_end_ = true;
+      return None;
+    }
+    if (BATT_HINT_TRUE(byte_count <= this->unread_.size())) {
+      const ConstBuffer result{this->unread_.data(), byte_count};
+      this->consume_within_buffer(byte_count);
+      return result;
+    }
+    return this->read_straddling(byte_count);
+  }
+
+  /** \brief Reads the next `byte_count` bytes and returns a DataReader over them.
+   */
+  Optional<DataReader> read_contiguous_reader(usize byte_count)
+  {
+    Optional<ConstBuffer> data = this->read_contiguous(byte_count);
+    if (!data) {
+      return None;
+    }
+    return DataReader{*data};
+  }
+
+  /** \brief Reads a (fixed-size) packed record of type T.
+   */
+  template <typename T>
+  [[nodiscard]] const T* read_record(batt::StaticType<T> = {})
+  {
+    Optional<ConstBuffer> data = this->read_contiguous(sizeof(T));
+    if (!data) {
+      return nullptr;
+    }
+    return reinterpret_cast<const T*>(data->data());
+  }
+
+  [[nodiscard]] Optional<u64> read_varint();
+
+  /** \brief Reads a varint size `n` followed by `n` bytes (the framing of a log slot), returning
+   * the `n` bytes as one contiguous buffer.  Consumes nothing if the unit isn't complete.
+   */
+  [[nodiscard]] Optional<ConstBuffer> read_length_prefixed();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  // Copies the next `byte_count` bytes (which span more than one buffer) into the scratch buffer.
+  //
+  ConstBuffer read_straddling(usize byte_count);
+
+  // Consumes `byte_count` bytes, all of which are within `unread_`.
+  //
+  void consume_within_buffer(usize byte_count)
+  {
+    this->unread_ += byte_count;
+    this->bytes_available_ -= byte_count;
+    if (this->unread_.size() == 0) {
+      this->next_buffer();
+    }
+  }
+
+  // Consumes `byte_count` bytes, which may span any number of buffers.
+  //
+  void consume(usize byte_count);
+
+  // Moves `unread_` to the next non-empty buffer (or leaves it empty at the end).
+  //
+  void next_buffer();
+
+  // Copies the next `byte_count` bytes to `dst` without consuming them.
+  //
+  void copy_to(u8* dst, usize byte_count) const;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  batt::SmallVec<ConstBuffer, kMaxInlineBuffers> buffers_;
+
+  // The index in `buffers_` of the buffer after the one that `unread_` is in.
+  //
+  usize next_buffer_i_ = 0;
+
+  // The unread part of the current buffer.
+  //
+  ConstBuffer unread_;
+
+  usize total_size_ = 0;
+
+  usize bytes_available_ = 0;
+
+  bool at_end_ = false;
+
+  std::vector<u8> scratch_;
+
+  usize bytes_copied_ = 0;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_FRAGMENTED_DATA_READER_HPP
@@ -0,0 +1,180 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/fragmented_data_reader.hpp>
+//
+#include <llfs/fragmented_data_reader.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/data_packer.hpp>
+#include <llfs/varint.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace llfs::int_types;
+
+// Test Plan:
+//  1. Records within one buffer are returned in place; records that straddle a boundary are
+//     copied, and reading past the end fails without consuming anything.
+//  2. A stream of varint-prefixed slots, split at random points (including empty buffers), reads
+//     back the same slots; a truncated stream stops before the incomplete slot.
+//  3. A packed record with out-of-line data can be read with a DataReader after being read as a
+//     contiguous unit, even if it spans buffers.
+
+bool points_into(const llfs::ConstBuffer& buffer, const std::vector<u8>& storage)
+{
+  const u8* p = static_cast<const u8*>(buffer.data());
+  return p >= storage.data() && p + buffer.size() <= storage.data() + storage.size();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(FragmentedDataReaderTest, ZeroCopyAndStraddling)
+{
+  std::vector<u8> storage(32);
+  for (usize i = 0; i < storage.size(); ++i) {
+    storage[i] = static_cast<u8>(i);
+  }
+
+  const std::vector<llfs::ConstBuffer> buffers{
+      llfs::ConstBuffer{storage.data(), 10},
+      llfs::ConstBuffer{storage.data() + 10, 0},
+      llfs::ConstBuffer{storage.data() + 10, 22},
+  };
+  llfs::FragmentedDataReader reader{batt::as_slice(buffers)};
+
+  EXPECT_EQ(reader.bytes_available(), 32u);
+
+  llfs::Optional<llfs::ConstBuffer> first = reader.read_contiguous(8);
+  ASSERT_TRUE(first);
+  EXPECT_EQ(first->data(), storage.data());
+  EXPECT_EQ(reader.bytes_copied(), 0u);
+
+  // Straddles the first boundary.
+  //
+  const little_u32* second = reader.read_record<little_u32>();
+  ASSERT_NE(second, nullptr);
+  EXPECT_FALSE(points_into(llfs::ConstBuffer{second, sizeof(little_u32)}, storage));
+  EXPECT_EQ(second->value(), 0x0b0a0908u);
+  EXPECT_EQ(reader.bytes_copied(), 4u);
+  EXPECT_EQ(reader.bytes_consumed(), 12u);
+
+  llfs::Optional<llfs::ConstBuffer> third = reader.read_contiguous(20);
+  ASSERT_TRUE(third);
+  EXPECT_EQ(third->data(), storage.data() + 12);
+  EXPECT_EQ(reader.bytes_available(), 0u);
+  EXPECT_FALSE(reader.at_end());
+
+  EXPECT_FALSE(reader.read_contiguous(1));
+  EXPECT_TRUE(reader.at_end());
+  EXPECT_EQ(reader.bytes_copied(), 4u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(FragmentedDataReaderTest, LengthPrefixedSlots)
+{
+  std::default_random_engine rng{1};
+
+  for (usize trial = 0; trial < 500; ++trial) {
+    // Pack a stream of slots (varint size, then the slot body).
+    //
+    std::vector<std::string> slots;
+    std::vector<u8> stream;
+    const usize slot_count = rng() % 20;
+    for (usize i = 0; i < slot_count; ++i) {
+      const usize size = (i % 4 == 0) ? (rng() % 300) : (rng() % 10);
+      std::string slot;
+      for (usize j = 0; j < size; ++j) {
+        slot.push_back(static_cast<char>('a' + rng() % 26));
+      }
+
+      u8 header[llfs::kMaxVarInt64Size];
+      const u8* header_end = llfs::pack_varint_to(header, header + sizeof(header), size);
+      stream.insert(stream.end(), header, header_end);
+      stream.insert(stream.end(), slot.begin(), slot.end());
+      slots.emplace_back(std::move(slot));
+    }
+
+    // Split it at random points.
+    //
+    std::vector<llfs::ConstBuffer> buffers;
+    for (usize offset = 0; offset < stream.size();) {
+      const usize size = std::min<usize>(rng() % 40, stream.size() - offset);
+      buffers.emplace_back(stream.data() + offset, size);
+      offset += size;
+    }
+
+    {
+      llfs::FragmentedDataReader reader{batt::as_slice(buffers)};
+      for (const std::string& slot : slots) {
+        llfs::Optional<llfs::ConstBuffer> body = reader.read_length_prefixed();
+        ASSERT_TRUE(body) << BATT_INSPECT(trial);
+        EXPECT_EQ(std::string_view(static_cast<const char*>(body->data()), body->size()), slot);
+      }
+      EXPECT_EQ(reader.bytes_available(), 0u);
+      EXPECT_FALSE(reader.read_length_prefixed());
+    }
+
+    if (slots.empty()) {
+      continue;
+    }
+
+    // Drop the last byte; the last slot is now incomplete.
+    //
+    while (buffers.back().size() == 0) {
+      buffers.pop_back();
+    }
+    buffers.back() = llfs::ConstBuffer{buffers.back().data(), buffers.back().size() - 1};
+    {
+      llfs::FragmentedDataReader reader{batt::as_slice(buffers)};
+      for (usize i = 0; i + 1 < slots.size(); ++i) {
+        ASSERT_TRUE(reader.read_length_prefixed());
+      }
+      const usize bytes_available = reader.bytes_available();
+      EXPECT_FALSE(reader.read_length_prefixed());
+      EXPECT_EQ(reader.bytes_available(), bytes_available);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(FragmentedDataReaderTest, PackedRecordAcrossBuffers)
+{
+  const std::string str = "a string that is stored outside of its PackedBytes record";
+
+  std::vector<u8> storage(sizeof(llfs::PackedBytes) + str.size());
+  {
+    llfs::DataPacker packer{llfs::MutableBuffer{storage.data(), storage.size()}};
+    ASSERT_TRUE(packer.pack_string(str));
+  }
+
+  for (usize split = 0; split <= storage.size(); ++split) {
+    const std::vector<llfs::ConstBuffer> buffers{
+        llfs::ConstBuffer{storage.data(), split},
+        llfs::ConstBuffer{storage.data() + split, storage.size() - split},
+    };
+    llfs::FragmentedDataReader reader{batt::as_slice(buffers)};
+
+    llfs::Optional<llfs::DataReader> record_reader = reader.read_contiguous_reader(storage.size());
+    ASSERT_TRUE(record_reader);
+
+    llfs::Optional<std::string_view> unpacked = record_reader->read_string();
+    ASSERT_TRUE(unpacked);
+    EXPECT_EQ(*unpacked, str) << BATT_INSPECT(split);
+  }
+}
+
+}  // namespace
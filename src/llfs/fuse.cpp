@@ -7,9 +7,96 @@
 //+++++++++++-+-+--+----- --- -- -  -  -   -
 
 #include <llfs/fuse.hpp>
+//
+
+#include <batteries/checked_cast.hpp>
+#include <batteries/stream_util.hpp>
+
+#include <fstream>
 
 namespace llfs {
 
+namespace {
+
+#if FUSE_MAJOR_VERSION > 3 || (FUSE_MAJOR_VERSION == 3 && FUSE_MINOR_VERSION >= 18)
+constexpr bool kLibFuseSupportsIoUring = true;
+#else
+constexpr bool kLibFuseSupportsIoUring = false;
+#endif
+
+// The fuse kernel module parameter that enables FUSE over io_uring (Linux 6.14+).
+//
+constexpr const char* kFuseEnableUringParam = "/sys/module/fuse/parameters/enable_uring";
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, FuseTransport t)
+{
+  switch (t) {
+    case FuseTransport::kClassic:
+      return out << "kClassic";
+    case FuseTransport::kIoUring:
+      return out << "kIoUring";
+    case FuseTransport::kAuto:
+      return out << "kAuto";
+  }
+  return out << "(bad FuseTransport)";
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool fuse_io_uring_supported() noexcept
+{
+  if (!kLibFuseSupportsIoUring) {
+    return false;
+  }
+
+  // The parameter doesn't exist on kernels without FUSE over io_uring.
+  //
+  std::ifstream ifs{kFuseEnableUringParam};
+  char value = 'N';
+  if (!(ifs >> value)) {
+    return false;
+  }
+  return value == 'Y' || value == '1';
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+batt::StatusOr<FuseTransport> add_fuse_transport_args(fuse_args* args,
+                                                      const FuseConnectionOptions& options)
+{
+  const FuseTransport requested = options.transport.value_or(FuseTransport::kClassic);
+
+  if (requested == FuseTransport::kClassic) {
+    return FuseTransport::kClassic;
+  }
+
+  if (!fuse_io_uring_supported()) {
+    if (requested == FuseTransport::kIoUring) {
+      LLFS_LOG_WARNING() << "FUSE over io_uring requested, but not supported by libfuse or the"
+                         << " kernel (" << kFuseEnableUringParam << "); using kClassic";
+    }
+    return FuseTransport::kClassic;
+  }
+
+  if (fuse_opt_add_arg(args, "-oio_uring") != 0) {
+    return {batt::StatusCode::kResourceExhausted};
+  }
+  if (options.io_uring_queue_depth) {
+    const std::string depth_opt =
+        "-oio_uring_q_depth=" + std::to_string(*options.io_uring_queue_depth);
+
+    if (fuse_opt_add_arg(args, depth_opt.c_str()) != 0) {
+      return {batt::StatusCode::kResourceExhausted};
+    }
+  }
+
+  return FuseTransport::kIoUring;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 /*static*/ auto FuseImplBase::const_buffer_vec_from_bufv(const fuse_bufvec& bufv)
@@ -35,6 +122,177 @@ namespace llfs {
   return {std::move(vec)};
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ bool FuseImplBase::bufv_has_fd(const fuse_bufvec& bufv)
+{
+  for (usize i = bufv.idx; i < bufv.count; ++i) {
+    if (bufv.buf[i].flags & FUSE_BUF_IS_FD) {
+      return true;
+    }
+  }
+  return false;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ auto FuseImplBase::copy_bufv_to_owned_buffer(fuse_bufvec& bufv)
+    -> batt::StatusOr<OwnedConstBuffer>
+{
+  if (bufv.idx > bufv.count) {
+    return {batt::status_from_errno(EINVAL)};
+  }
+
+  usize size = 0;
+  for (usize i = bufv.idx; i < bufv.count; ++i) {
+    size += bufv.buf[i].size;
+  }
+  if (bufv.idx < bufv.count) {
+    size -= std::min<usize>(size, bufv.off);
+  }
+
+  OwnedConstBuffer result;
+  result.storage.reset(new char[std::max<usize>(size, 1)]);
+
+  fuse_bufvec dst;
+  std::memset(&dst, 0, sizeof(dst));
+  dst.count = 1;
+  dst.buf[0].size = size;
+  dst.buf[0].mem = result.storage.get();
+  dst.buf[0].fd = -1;
+
+  const ssize_t n_copied = fuse_buf_copy(&dst, &bufv, FUSE_BUF_SPLICE_MOVE);
+  if (n_copied < 0) {
+    return {batt::status_from_errno(-n_copied)};
+  }
+
+  result.buffer = batt::ConstBuffer{result.storage.get(), static_cast<usize>(n_copied)};
+
+  return {std::move(result)};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool FuseImplBase::enable_splice_io(bool splice_read)
+{
+  BATT_CHECK_NOT_NULLPTR(this->conn_) << "enable_splice_io must be called from init()";
+
+  const auto enable = [this](unsigned cap) {
+    if ((this->conn_->capable & cap) == cap) {
+      this->conn_->want |= cap;
+      return true;
+    }
+    return false;
+  };
+
+  const bool splice_write = enable(FUSE_CAP_SPLICE_WRITE);
+  if (splice_write) {
+    this->reply_data_flags_ = FUSE_BUF_SPLICE_MOVE;
+    enable(FUSE_CAP_SPLICE_MOVE);
+  }
+
+  if (splice_read) {
+    enable(FUSE_CAP_SPLICE_READ);
+  } else {
+    this->conn_->want &= ~FUSE_CAP_SPLICE_READ;
+  }
+
+  return splice_write;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void FuseImplBase::apply_connection_options()
+{
+  BATT_CHECK_NOT_NULLPTR(this->conn_) << "apply_connection_options must be called from init()";
+
+  const FuseConnectionOptions& options = this->connection_options_;
+
+  if (options.max_write) {
+    this->conn_->max_write = BATT_CHECKED_CAST(unsigned, *options.max_write);
+  }
+  if (options.max_read) {
+    this->conn_->max_read = BATT_CHECKED_CAST(unsigned, *options.max_read);
+  }
+  if (options.max_readahead) {
+    this->conn_->max_readahead = BATT_CHECKED_CAST(unsigned, *options.max_readahead);
+  }
+
+  const auto set_capability = [this](const char* name, unsigned cap,
+                                      const batt::Optional<bool>& want) {
+    if (!want) {
+      return;
+    }
+    if (!*want) {
+      this->conn_->want &= ~cap;
+    } else if ((this->conn_->capable & cap) == cap) {
+      this->conn_->want |= cap;
+    } else {
+      LLFS_LOG_WARNING() << name << " requested, but not supported by the kernel";
+    }
+  };
+
+  set_capability("FUSE_CAP_WRITEBACK_CACHE", FUSE_CAP_WRITEBACK_CACHE, options.writeback_cache);
+  set_capability("FUSE_CAP_PARALLEL_DIROPS", FUSE_CAP_PARALLEL_DIROPS, options.parallel_dirops);
+  set_capability("FUSE_CAP_ASYNC_READ", FUSE_CAP_ASYNC_READ, options.async_read);
+
+  LLFS_VLOG(1) << "FUSE connection:" << BATT_INSPECT(this->conn_->max_write)
+               << BATT_INSPECT(this->conn_->max_read) << BATT_INSPECT(this->conn_->max_readahead)
+               << " want=" << std::hex << this->conn_->want << std::dec;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+fuse_entry_param FuseImplBase::entry_with_cache_options(
+    const fuse_entry_param& entry) const noexcept
+{
+  fuse_entry_param result = entry;
+
+  result.entry_timeout = this->cache_options_.entry_timeout_sec.value_or(entry.entry_timeout);
+  result.attr_timeout = this->cache_options_.attr_timeout_sec.value_or(entry.attr_timeout);
+
+  return result;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+batt::Status FuseImplBase::notify_inval_inode(fuse_ino_t ino, off_t offset, off_t length)
+{
+  if (this->session_ == nullptr) {
+    return batt::OkStatus();
+  }
+
+  const int retval = fuse_lowlevel_notify_inval_inode(this->session_, ino, offset, length);
+
+  // -ENOENT means the kernel has nothing cached for `ino`.
+  //
+  if (retval != 0 && retval != -ENOENT) {
+    LLFS_VLOG(1) << "fuse_lowlevel_notify_inval_inode failed;" << BATT_INSPECT(ino)
+                 << BATT_INSPECT(retval);
+    return batt::status_from_errno(-retval);
+  }
+  return batt::OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+batt::Status FuseImplBase::notify_inval_entry(fuse_ino_t parent, const std::string_view& name)
+{
+  if (this->session_ == nullptr) {
+    return batt::OkStatus();
+  }
+
+  const int retval =
+      fuse_lowlevel_notify_inval_entry(this->session_, parent, name.data(), name.size());
+
+  if (retval != 0 && retval != -ENOENT) {
+    LLFS_VLOG(1) << "fuse_lowlevel_notify_inval_entry failed;" << BATT_INSPECT(parent)
+                 << BATT_INSPECT(batt::c_str_literal(name)) << BATT_INSPECT(retval);
+    return batt::status_from_errno(-retval);
+  }
+  return batt::OkStatus();
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 /*static*/ int FuseImplBase::errno_from_status(batt::Status status)
@@ -87,7 +345,7 @@ int FuseImplBase::invoke_fuse_reply_data(fuse_req_t req, const FuseConstBufferVe
   batt::SmallVec<char, 512> tmp_storage;
 
   tmp_storage.resize(sizeof(fuse_bufvec) - sizeof(fuse_buf) +
-                     sizeof(fuse_buf) * std::min<usize>(1, v.buffers.size()));
+                     sizeof(fuse_buf) * std::max<usize>(1, v.buffers.size()));
 
   std::memset(tmp_storage.data(), 0, tmp_storage.size());
 
@@ -135,9 +393,7 @@ int FuseImplBase::invoke_fuse_reply_data(fuse_req_t req, const FuseConstBufferVe
     }
   }
 
-  return fuse_reply_data(req, fbv, /*flags=*/(fuse_buf_copy_flags)0);
-  //                                                      ^
-  // TODO [tastolfi 2023-06-28] support fuse_buf_copy_flags
+  return fuse_reply_data(req, fbv, this->reply_data_flags_);
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -24,8 +24,17 @@
 
 #include <fuse_lowlevel.h>
 
+#include <algorithm>
+#include <atomic>
 #include <bitset>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <string_view>
+#include <thread>
+#include <vector>
 
 #include <errno.h>
 #include <pthread.h>
@@ -61,6 +70,95 @@ struct DumpFileMode {
 
 std::ostream& operator<<(std::ostream& out, const DumpFileMode t);
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+/** \brief How long the kernel may cache the results of lookups and getattrs.
+ *
+ * A timeout that is set overrides the one in every reply (entry_timeout/attr_timeout in
+ * fuse_entry_param, Attributes::timeout_sec); if it is None, the implementation's own timeout is
+ * used.  Long timeouts are only safe if the implementation invalidates the kernel's cache whenever
+ * something changes behind its back; see FuseImplBase::notify_inval_inode/notify_inval_entry.
+ */
+struct FuseCacheOptions {
+  batt::Optional<double> entry_timeout_sec;
+  batt::Optional<double> attr_timeout_sec;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+/** \brief How FuseSession exchanges requests and replies with the kernel.
+ */
+enum struct FuseTransport {
+  /** \brief One read(2) and one write(2) on /dev/fuse per request.
+   */
+  kClassic,
+
+  /** \brief FUSE over io_uring: libfuse registers a ring queue per CPU with the kernel and receives
+   * requests (and sends replies) as io_uring commands.  Requires Linux 6.14+ with the fuse module
+   * parameter enable_uring set, and libfuse 3.18+.
+   */
+  kIoUring,
+
+  /** \brief kIoUring if supported (see fuse_io_uring_supported()), else kClassic.
+   */
+  kAuto,
+};
+
+std::ostream& operator<<(std::ostream& out, FuseTransport t);
+
+/** \brief Connection parameters negotiated with the kernel when the file system is initialized.
+ *
+ * Fields that are None are left as libfuse/the kernel default them.  Capabilities are only enabled
+ * if the kernel supports them.
+ */
+struct FuseConnectionOptions {
+  /** \brief The maximum size of a write request (the kernel caps this at its max_pages limit,
+   * which is 128 KiB on older kernels and 1 MiB on newer ones).
+   */
+  batt::Optional<usize> max_write;
+
+  /** \brief The maximum size of a read request; FuseSession also passes this as the max_read
+   * mount option, as libfuse requires.
+   */
+  batt::Optional<usize> max_read;
+
+  /** \brief The maximum number of bytes the kernel reads ahead.
+   */
+  batt::Optional<usize> max_readahead;
+
+  /** \brief FUSE_CAP_WRITEBACK_CACHE: the kernel buffers writes in the page cache and sends them
+   * in large batches, and keeps track of file sizes/mtimes itself.
+   */
+  batt::Optional<bool> writeback_cache;
+
+  /** \brief FUSE_CAP_PARALLEL_DIROPS: allow concurrent lookups/readdirs in the same directory.
+   */
+  batt::Optional<bool> parallel_dirops;
+
+  /** \brief FUSE_CAP_ASYNC_READ: allow multiple outstanding reads on the same file.
+   */
+  batt::Optional<bool> async_read;
+
+  /** \brief The request transport; default is kClassic.
+   */
+  batt::Optional<FuseTransport> transport;
+
+  /** \brief The depth of each io_uring queue, if the kIoUring transport is selected.
+   */
+  batt::Optional<usize> io_uring_queue_depth;
+};
+
+/** \brief Returns true iff both the libfuse this was built against and the running kernel support
+ * FUSE over io_uring.
+ */
+bool fuse_io_uring_supported() noexcept;
+
+/** \brief Adds the mount/session options that select the transport requested by `options` to
+ * `args`, falling back to kClassic if io_uring is requested (or kAuto) but not supported.
+ *
+ * \return the transport that was selected (never kAuto)
+ */
+batt::StatusOr<FuseTransport> add_fuse_transport_args(fuse_args* args,
+                                                      const FuseConnectionOptions& options);
+
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 //
 class FuseImplBase
@@ -176,6 +274,20 @@ class FuseImplBase
    */
   static batt::StatusOr<ConstBufferVec> const_buffer_vec_from_bufv(const fuse_bufvec& bufv);
 
+  /** \brief Returns true iff any of the unconsumed buffers in `bufv` is a file descriptor (e.g.,
+   * the pipe into which the kernel has spliced the data of a write request).
+   */
+  static bool bufv_has_fd(const fuse_bufvec& bufv);
+
+  /** \brief Moves the unconsumed data in `bufv` into a newly allocated buffer, advancing `bufv`
+   * past it.
+   *
+   * This is how write data that arrives in a splice pipe (FUSE_CAP_SPLICE_READ) is consumed: the
+   * data is copied once, straight out of the pipe, and the pipe is drained before the request
+   * handler returns (libfuse reuses it for the next request).
+   */
+  static batt::StatusOr<OwnedConstBuffer> copy_bufv_to_owned_buffer(fuse_bufvec& bufv);
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   FuseImplBase() = default;
@@ -185,6 +297,84 @@ class FuseImplBase
 
   virtual ~FuseImplBase() = default;
 
+  /** \brief Asks the kernel to use splice for transferring file data, where it is capable of it;
+   * must be called from the derived class's `init()`.
+   *
+   * Read replies (FuseConstBufferVec) that reference a FileDataRef are then spliced from the file
+   * to the FUSE device, moving (rather than copying) the pages where possible.  If `splice_read` is
+   * true, the kernel is also allowed to splice the data of write requests into a pipe; see
+   * copy_bufv_to_owned_buffer.
+   *
+   * \return true iff splicing replies was enabled
+   */
+  bool enable_splice_io(bool splice_read = false);
+
+  /** \brief Sets the connection parameters to negotiate at init time; must be called before the
+   * FuseSession is created (i.e., from the implementation's constructor).
+   */
+  void set_connection_options(const FuseConnectionOptions& options) noexcept
+  {
+    this->connection_options_ = options;
+  }
+
+  const FuseConnectionOptions& connection_options() const noexcept
+  {
+    return this->connection_options_;
+  }
+
+  /** \brief Applies connection_options() to the connection being initialized; called just before
+   * the derived class's `init()`, which can still adjust the connection further.
+   */
+  void apply_connection_options();
+
+  /** \brief Sets the kernel cache timeouts used in replies from now on.
+   */
+  void set_cache_options(const FuseCacheOptions& options) noexcept
+  {
+    this->cache_options_ = options;
+  }
+
+  const FuseCacheOptions& cache_options() const noexcept
+  {
+    return this->cache_options_;
+  }
+
+  /** \brief Returns a copy of `entry` with the timeouts from cache_options() applied; used for
+   * lookup/create replies, and should be used by implementations for the entries they add with
+   * fuse_add_direntry_plus.
+   */
+  fuse_entry_param entry_with_cache_options(const fuse_entry_param& entry) const noexcept;
+
+  /** \brief Returns the attribute timeout to reply with, given the implementation's own.
+   */
+  double attr_timeout_with_cache_options(double timeout_sec) const noexcept
+  {
+    return this->cache_options_.attr_timeout_sec.value_or(timeout_sec);
+  }
+
+  /** \brief Called by FuseSession once the session for this file system has been created.
+   */
+  void set_session(fuse_session* session) noexcept
+  {
+    this->session_ = session;
+  }
+
+  /** \brief Tells the kernel to drop its cached attributes of inode `ino` and, unless `offset` is
+   * negative, the cached data in the range [offset, offset + length) (`length` == 0 means up to the
+   * end of the file).
+   *
+   * Like notify_inval_entry, this must not be called while handling a request that the kernel
+   * might be holding a lock on the same inode for (i.e., before replying to it); it is meant for
+   * changes made behind the kernel's back.  If there is no session (the file system isn't mounted)
+   * or the kernel doesn't have anything cached, this does nothing and returns OK.
+   */
+  batt::Status notify_inval_inode(fuse_ino_t ino, off_t offset = 0, off_t length = 0);
+
+  /** \brief Tells the kernel to drop its cached lookup of `name` in directory `parent`; see
+   * notify_inval_inode.
+   */
+  batt::Status notify_inval_entry(fuse_ino_t parent, const std::string_view& name);
+
   /** \brief
    */
   auto make_error_handler(fuse_req_t req)
@@ -199,14 +389,15 @@ class FuseImplBase
    */
   auto make_entry_handler(fuse_req_t req)
   {
-    return [req](batt::StatusOr<const fuse_entry_param*> result) {
+    return [req, this](batt::StatusOr<const fuse_entry_param*> result) {
       if (!result.ok()) {
         LLFS_VLOG(1) << BATT_INSPECT(req) << BATT_INSPECT(result.status());
         fuse_reply_err(req, FuseImplBase::errno_from_status(result.status()));
       } else {
         BATT_CHECK_NOT_NULLPTR(*result);
         LLFS_VLOG(1) << BATT_INSPECT(req) << " OK" << BATT_INSPECT(*result);
-        fuse_reply_entry(req, *result);
+        const fuse_entry_param entry = this->entry_with_cache_options(**result);
+        fuse_reply_entry(req, &entry);
       }
     };
   }
@@ -215,14 +406,15 @@ class FuseImplBase
    */
   auto make_attributes_handler(fuse_req_t req)
   {
-    return [req](batt::StatusOr<Attributes> result) {
+    return [req, this](batt::StatusOr<Attributes> result) {
       if (!result.ok()) {
         LLFS_VLOG(1) << BATT_INSPECT(req) << BATT_INSPECT(result.status());
         fuse_reply_err(req, FuseImplBase::errno_from_status(result.status()));
       } else {
         BATT_CHECK_NOT_NULLPTR(result->attr);
         LLFS_VLOG(1) << BATT_INSPECT(req) << " OK" << BATT_INSPECT(DumpStat{*result->attr});
-        fuse_reply_attr(req, result->attr, result->timeout_sec);
+        fuse_reply_attr(req, result->attr,
+                        this->attr_timeout_with_cache_options(result->timeout_sec));
       }
     };
   }
@@ -253,11 +445,12 @@ class FuseImplBase
    */
   auto make_create_handler(fuse_req_t req)
   {
-    return [req](const batt::StatusOr<FuseCreateReply>& result) {
+    return [req, this](const batt::StatusOr<FuseCreateReply>& result) {
       if (!result.ok()) {
         fuse_reply_err(req, FuseImplBase::errno_from_status(result.status()));
       } else {
-        fuse_reply_create(req, result->entry, result->fi);
+        const fuse_entry_param entry = this->entry_with_cache_options(*result->entry);
+        fuse_reply_create(req, &entry, result->fi);
       }
     };
   }
@@ -444,6 +637,18 @@ class FuseImplBase
 
  protected:
   fuse_conn_info* conn_ = nullptr;
+
+  // The flags passed to fuse_reply_data; set by enable_splice_io.
+  //
+  fuse_buf_copy_flags reply_data_flags_ = (fuse_buf_copy_flags)0;
+
+  FuseConnectionOptions connection_options_;
+
+  FuseCacheOptions cache_options_;
+
+  // The session this file system is served by, for kernel cache invalidation (nullptr if none).
+  //
+  fuse_session* session_ = nullptr;
 };
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
@@ -612,6 +817,21 @@ class FuseSession
 
     instance.impl_ = std::make_unique<Impl>(BATT_FORWARD(impl_args)...);
 
+    // libfuse only honors max_read if it is also given as a mount option.
+    //
+    if (instance.impl_->connection_options().max_read) {
+      const std::string max_read_opt =
+          "-omax_read=" + std::to_string(*instance.impl_->connection_options().max_read);
+
+      if (fuse_opt_add_arg(&instance.args_, max_read_opt.c_str()) != 0) {
+        return {batt::StatusCode::kResourceExhausted};
+      }
+    }
+
+    BATT_ASSIGN_OK_RESULT(instance.transport_,
+                          add_fuse_transport_args(&instance.args_,
+                                                  instance.impl_->connection_options()));
+
     instance.session_.reset(fuse_session_new(&instance.args_, Impl::get_fuse_lowlevel_ops(),
                                              sizeof(struct fuse_lowlevel_ops),
                                              instance.impl_.get()));
@@ -620,6 +840,7 @@ class FuseSession
       LLFS_LOG_ERROR() << "fuse_sesion_new returned NULL";
       return {batt::StatusCode::kInternal};
     }
+    instance.impl_->set_session(instance.session_.get());
 
     {
       const int retval = fuse_set_signal_handlers(instance.session_.get());
@@ -690,6 +911,51 @@ class FuseSession
     return fuse_session_loop_mt(this->session_.get(), &config);
   }
 
+  /** \brief Runs the session on a fixed set of `thread_count` reader threads (default: one per
+   * CPU), each of which reads requests from /dev/fuse into its own buffer and dispatches them
+   * straight to the FuseImpl handlers; blocks until the session exits.
+   *
+   * Unlike `run()` in multi-threaded mode, threads are never created or destroyed while the session
+   * is running, and each one has a stable index (see `current_thread_index()`) that the FuseImpl
+   * may use to keep per-thread state, e.g. one WorkQueue per reader (see WorkerTaskFuseImpl).
+   *
+   * \return 0 if the session exited normally, else the (negative) error code of the first failed
+   * read.
+   */
+  int run_reader_threads(usize thread_count = std::thread::hardware_concurrency()) noexcept
+  {
+    thread_count = std::max<usize>(thread_count, 1);
+
+    std::atomic<int> first_error{0};
+    std::vector<std::thread> threads;
+    {
+      std::unique_lock<std::mutex> lock{*this->mutex_};
+      for (usize i = 0; i < thread_count; ++i) {
+        threads.emplace_back([this, i, &first_error] {
+          FuseSession::current_thread_index_ref() = i;
+
+          const int retval = FuseSession::reader_loop(this->session_.get());
+          if (retval < 0) {
+            int expected = 0;
+            first_error.compare_exchange_strong(expected, retval);
+          }
+        });
+        this->reader_thread_ids_.emplace_back(threads.back().native_handle());
+      }
+    }
+
+    for (std::thread& t : threads) {
+      t.join();
+    }
+    {
+      std::unique_lock<std::mutex> lock{*this->mutex_};
+      this->reader_thread_ids_.clear();
+    }
+    fuse_session_reset(this->session_.get());
+
+    return first_error.load();
+  }
+
   void halt()
   {
     fuse_session_exit(this->session_.get());
@@ -698,14 +964,75 @@ class FuseSession
       if (this->run_thread_id_) {
         pthread_kill(this->run_thread_id_->load(), SIGPIPE);
       }
+      for (pthread_t thread_id : this->reader_thread_ids_) {
+        pthread_kill(thread_id, SIGPIPE);
+      }
     }
   }
 
+  /** \brief The transport selected when the session was created (never kAuto).
+   *
+   * With kIoUring, libfuse starts its own ring threads once the kernel has been initialized, and
+   * all requests other than FUSE_INIT are delivered on those threads, whichever of `run()` and
+   * `run_reader_threads()` is used.
+   */
+  FuseTransport transport() const noexcept
+  {
+    return this->transport_;
+  }
+
+  /** \brief Returns a small integer identifying the calling thread: for the threads started by
+   * `run_reader_threads`, the reader's index in [0, thread_count); for any other thread, a value
+   * assigned the first time it calls this function.
+   */
+  static usize current_thread_index() noexcept
+  {
+    return FuseSession::current_thread_index_ref();
+  }
+
  private:
   FuseSession(int argc, char* argv[]) noexcept : args_ FUSE_ARGS_INIT(argc, argv)
   {
   }
 
+  static usize& current_thread_index_ref() noexcept
+  {
+    static std::atomic<usize> next_index{0};
+    thread_local usize index = next_index.fetch_add(1);
+    return index;
+  }
+
+  // The body of each thread started by `run_reader_threads`; same as fuse_session_loop, but with a
+  // buffer per thread.
+  //
+  static int reader_loop(fuse_session* session) noexcept
+  {
+    struct fuse_buf buf;
+    std::memset(&buf, 0, sizeof(buf));
+
+    auto on_scope_exit = batt::finally([&] {
+      std::free(buf.mem);
+    });
+
+    int retval = 0;
+    while (!fuse_session_exited(session)) {
+      retval = fuse_session_receive_buf(session, &buf);
+      if (retval == -EINTR) {
+        continue;
+      }
+      if (retval <= 0) {
+        break;
+      }
+      fuse_session_process_buf(session, &buf);
+    }
+
+    // Stop the other readers too (e.g. after the file system is unmounted).
+    //
+    fuse_session_exit(session);
+
+    return std::min(retval, 0);
+  }
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   struct fuse_args args_;
@@ -718,9 +1045,15 @@ class FuseSession
 
   bool mounted_ = false;
 
+  FuseTransport transport_ = FuseTransport::kClassic;
+
   std::unique_ptr<std::mutex> mutex_ = std::make_unique<std::mutex>();
 
   std::unique_ptr<std::atomic<pthread_t>> run_thread_id_;
+
+  // The threads started by `run_reader_threads` (protected by `mutex_`).
+  //
+  std::vector<pthread_t> reader_thread_ids_;
 };
 
 }  //namespace llfs
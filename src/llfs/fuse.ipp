@@ -41,6 +41,7 @@ template <typename Derived>
   BATT_CHECK_NOT_NULLPTR(impl);
 
   impl->conn_ = conn;
+  impl->apply_connection_options();
   impl->derived_this()->init();
 }
 
@@ -1307,6 +1308,29 @@ template <typename Derived>
   BATT_CHECK_NOT_NULLPTR(fi);
   BATT_CHECK_NOT_NULLPTR(bufv);
 
+  // The data is in a splice pipe; drain it now, since libfuse reuses the pipe once we return.
+  //
+  if (FuseImplBase::bufv_has_fd(*bufv)) {
+    batt::StatusOr<FuseImplBase::OwnedConstBuffer> data =
+        FuseImplBase::copy_bufv_to_owned_buffer(*bufv);
+
+    if (!data.ok()) {
+      fuse_reply_err(req, FuseImplBase::errno_from_status(data.status()));
+      return;
+    }
+
+    FuseImplBase::ConstBufferVec buf_vec;
+    buf_vec.emplace_back(data->buffer);
+
+    impl->derived_this()->async_write_buf(
+        req, ino, buf_vec, FileOffset{offset}, FuseFileHandle{fi->fh},
+        [storage = std::shared_ptr<char[]>{std::move(data->storage)},
+         handler = impl->make_write_handler(req)](batt::StatusOr<usize> result) {
+          handler(result);
+        });
+    return;
+  }
+
   batt::StatusOr<FuseImplBase::ConstBufferVec> buf_vec =
       FuseImplBase::const_buffer_vec_from_bufv(*bufv);
 
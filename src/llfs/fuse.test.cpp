@@ -14,6 +14,13 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
 namespace {
 
 TEST(FuseTest, Test)
@@ -23,4 +30,170 @@ TEST(FuseTest, Test)
   ASSERT_NE(ops, nullptr);
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Write data that arrives in a pipe (as with FUSE_CAP_SPLICE_READ) is drained into an owned
+// buffer, and the bufvec is advanced past it.
+//
+TEST(FuseTest, CopyPipeBufvToOwnedBuffer)
+{
+  int fds[2];
+  ASSERT_EQ(::pipe(fds), 0);
+
+  const std::string_view data = "0123456789abcdef";
+  ASSERT_EQ(::write(fds[1], data.data(), data.size()), (ssize_t)data.size());
+
+  fuse_bufvec bufv;
+  std::memset(&bufv, 0, sizeof(bufv));
+  bufv.count = 1;
+  bufv.buf[0].size = data.size();
+  bufv.buf[0].flags = FUSE_BUF_IS_FD;
+  bufv.buf[0].fd = fds[0];
+
+  EXPECT_TRUE(llfs::FuseImplBase::bufv_has_fd(bufv));
+  EXPECT_FALSE(llfs::FuseImplBase::const_buffer_vec_from_bufv(bufv).ok());
+
+  batt::StatusOr<llfs::FuseImplBase::OwnedConstBuffer> copied =
+      llfs::FuseImplBase::copy_bufv_to_owned_buffer(bufv);
+
+  ASSERT_TRUE(copied.ok()) << BATT_INSPECT(copied.status());
+  EXPECT_EQ(std::string_view(static_cast<const char*>(copied->buffer.data()),
+                             copied->buffer.size()),
+            data);
+  EXPECT_EQ(bufv.idx, 1u);
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Cache timeouts that are set override the implementation's; unset ones don't.  Invalidation
+// without a session is a no-op.
+//
+TEST(FuseTest, CacheOptions)
+{
+  llfs::FuseImplBase impl;
+
+  fuse_entry_param entry;
+  std::memset(&entry, 0, sizeof(entry));
+  entry.ino = 7;
+  entry.entry_timeout = 1.0;
+  entry.attr_timeout = 2.0;
+
+  fuse_entry_param result = impl.entry_with_cache_options(entry);
+  EXPECT_EQ(result.ino, 7u);
+  EXPECT_EQ(result.entry_timeout, 1.0);
+  EXPECT_EQ(result.attr_timeout, 2.0);
+  EXPECT_EQ(impl.attr_timeout_with_cache_options(3.0), 3.0);
+
+  impl.set_cache_options(llfs::FuseCacheOptions{
+      .entry_timeout_sec = 60.0,
+      .attr_timeout_sec = batt::None,
+  });
+
+  result = impl.entry_with_cache_options(entry);
+  EXPECT_EQ(result.ino, 7u);
+  EXPECT_EQ(result.entry_timeout, 60.0);
+  EXPECT_EQ(result.attr_timeout, 2.0);
+  EXPECT_EQ(impl.attr_timeout_with_cache_options(3.0), 3.0);
+
+  impl.set_cache_options(llfs::FuseCacheOptions{
+      .entry_timeout_sec = batt::None,
+      .attr_timeout_sec = 30.0,
+  });
+
+  result = impl.entry_with_cache_options(entry);
+  EXPECT_EQ(result.entry_timeout, 1.0);
+  EXPECT_EQ(result.attr_timeout, 30.0);
+  EXPECT_EQ(impl.attr_timeout_with_cache_options(3.0), 30.0);
+
+  EXPECT_TRUE(impl.notify_inval_inode(7).ok());
+  EXPECT_TRUE(impl.notify_inval_entry(1, "name").ok());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Connection options set limits unconditionally, and enable capabilities only if the kernel has
+// them; unset options leave the connection alone.
+//
+TEST(FuseTest, ApplyConnectionOptions)
+{
+  struct TestImpl : llfs::FuseImplBase {
+    using llfs::FuseImplBase::conn_;
+  };
+
+  fuse_conn_info conn;
+  std::memset(&conn, 0, sizeof(conn));
+  conn.capable = FUSE_CAP_PARALLEL_DIROPS | FUSE_CAP_ASYNC_READ;
+  conn.want = FUSE_CAP_ASYNC_READ;
+  conn.max_write = 128 * 1024;
+  conn.max_readahead = 64 * 1024;
+
+  TestImpl impl;
+  impl.conn_ = &conn;
+
+  impl.apply_connection_options();
+
+  EXPECT_EQ(conn.want, unsigned{FUSE_CAP_ASYNC_READ});
+  EXPECT_EQ(conn.max_write, 128u * 1024);
+  EXPECT_EQ(conn.max_readahead, 64u * 1024);
+
+  impl.set_connection_options(llfs::FuseConnectionOptions{
+      .max_write = 1024 * 1024,
+      .max_read = batt::None,
+      .max_readahead = batt::None,
+      .writeback_cache = true,
+      .parallel_dirops = true,
+      .async_read = false,
+  });
+  impl.apply_connection_options();
+
+  EXPECT_EQ(conn.max_write, 1024u * 1024);
+  EXPECT_EQ(conn.max_readahead, 64u * 1024);
+  EXPECT_EQ(conn.want, unsigned{FUSE_CAP_PARALLEL_DIROPS});
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// add_fuse_transport_args adds the io_uring options only when io_uring is selected, and falls back
+// to the classic transport when it is not supported.
+//
+TEST(FuseTest, TransportArgs)
+{
+  const auto args_for = [](llfs::FuseTransport transport, llfs::FuseTransport* selected) {
+    fuse_args args = FUSE_ARGS_INIT(0, nullptr);
+
+    batt::StatusOr<llfs::FuseTransport> result =
+        llfs::add_fuse_transport_args(&args, llfs::FuseConnectionOptions{
+                                                 .transport = transport,
+                                                 .io_uring_queue_depth = 64,
+                                             });
+    EXPECT_TRUE(result.ok()) << BATT_INSPECT(result.status());
+    *selected = *result;
+
+    std::vector<std::string> strs(args.argv, args.argv + args.argc);
+    fuse_opt_free_args(&args);
+    return strs;
+  };
+
+  const llfs::FuseTransport supported = llfs::fuse_io_uring_supported()
+                                            ? llfs::FuseTransport::kIoUring
+                                            : llfs::FuseTransport::kClassic;
+
+  llfs::FuseTransport selected = llfs::FuseTransport::kAuto;
+
+  EXPECT_THAT(args_for(llfs::FuseTransport::kClassic, &selected), ::testing::IsEmpty());
+  EXPECT_EQ(selected, llfs::FuseTransport::kClassic);
+
+  for (llfs::FuseTransport requested :
+       {llfs::FuseTransport::kAuto, llfs::FuseTransport::kIoUring}) {
+    std::vector<std::string> args = args_for(requested, &selected);
+
+    EXPECT_EQ(selected, supported);
+    if (supported == llfs::FuseTransport::kIoUring) {
+      EXPECT_THAT(args, ::testing::Contains("-oio_uring"));
+      EXPECT_THAT(args, ::testing::Contains("-oio_uring_q_depth=64"));
+    } else {
+      EXPECT_THAT(args, ::testing::IsEmpty());
+    }
+  }
+}
+
 }  // namespace
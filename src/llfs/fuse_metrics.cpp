@@ -0,0 +1,105 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/fuse_metrics.hpp>
+//
+
+#include <batteries/env.hpp>
+#include <batteries/stream_util.hpp>
+
+#include <string>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::string_view fuse_opcode_name(FuseOpcode op) noexcept
+{
+  switch (op) {
+#define CASE_(enumerator, name)                                                                    \
+  case FuseOpcode::enumerator:                                                                     \
+    return name
+
+    CASE_(kLookup, "lookup");
+    CASE_(kForgetInode, "forget_inode");
+    CASE_(kGetAttributes, "get_attributes");
+    CASE_(kSetAttributes, "set_attributes");
+    CASE_(kReadlink, "readlink");
+    CASE_(kMakeNode, "make_node");
+    CASE_(kMakeDirectory, "make_directory");
+    CASE_(kUnlink, "unlink");
+    CASE_(kRemoveDirectory, "remove_directory");
+    CASE_(kSymbolicLink, "symbolic_link");
+    CASE_(kRename, "rename");
+    CASE_(kHardLink, "hard_link");
+    CASE_(kOpen, "open");
+    CASE_(kRead, "read");
+    CASE_(kWrite, "write");
+    CASE_(kFlush, "flush");
+    CASE_(kRelease, "release");
+    CASE_(kFsync, "fsync");
+    CASE_(kOpendir, "opendir");
+    CASE_(kReaddir, "readdir");
+    CASE_(kReleasedir, "releasedir");
+    CASE_(kFsyncdir, "fsyncdir");
+    CASE_(kStatfs, "statfs");
+    CASE_(kSetExtendedAttribute, "set_extended_attribute");
+    CASE_(kGetExtendedAttribute, "get_extended_attribute");
+    CASE_(kRemoveExtendedAttribute, "remove_extended_attribute");
+    CASE_(kCheckAccess, "check_access");
+    CASE_(kCreate, "create");
+    CASE_(kIoctl, "ioctl");
+    CASE_(kWriteBuf, "write_buf");
+    CASE_(kRetrieveReply, "retrieve_reply");
+    CASE_(kForgetMultipleInodes, "forget_multiple_inodes");
+    CASE_(kFileAllocate, "file_allocate");
+    CASE_(kReaddirplus, "readdirplus");
+
+#undef CASE_
+  }
+  return "(bad FuseOpcode)";
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, FuseOpcode op)
+{
+  return out << fuse_opcode_name(op);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ FuseMetrics& FuseMetrics::instance()
+{
+  // Intentionally leaked, so the metrics outlive any static objects that might use them.
+  //
+  static FuseMetrics* instance_ = new FuseMetrics;
+  return *instance_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+FuseMetrics::FuseMetrics() noexcept
+    : sampler{batt::getenv_as<u32>("LLFS_FUSE_METRICS_SAMPLE_RATE")
+                  .value_or(FuseMetrics::kDefaultSampleRate)}
+{
+  batt::MetricRegistry& registry = global_metric_registry();
+
+  for (usize i = 0; i < kNumFuseOpcodes; ++i) {
+    OpMetrics& m = this->ops_[i];
+    const std::string prefix = batt::to_string("Fuse_", static_cast<FuseOpcode>(i), "_");
+
+    registry.add(prefix + "count", m.count);
+    registry.add(prefix + "in_flight", m.in_flight);
+    registry.add(prefix + "queue_depth", m.queue_depth);
+    m.queue_latency.add_to_registry(registry, prefix + "queue_latency");
+    m.handler_latency.add_to_registry(registry, prefix + "handler_latency");
+  }
+}
+
+}  // namespace llfs
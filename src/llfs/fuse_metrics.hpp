@@ -0,0 +1,140 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_FUSE_METRICS_HPP
+#define LLFS_FUSE_METRICS_HPP
+
+#include <llfs/int_types.hpp>
+#include <llfs/metrics.hpp>
+
+#include <array>
+#include <ostream>
+#include <string_view>
+
+namespace llfs {
+
+/** \brief The FUSE operations dispatched by WorkerTaskFuseImpl, for per-operation metrics.
+ */
+enum struct FuseOpcode : u8 {
+  kLookup,
+  kForgetInode,
+  kGetAttributes,
+  kSetAttributes,
+  kReadlink,
+  kMakeNode,
+  kMakeDirectory,
+  kUnlink,
+  kRemoveDirectory,
+  kSymbolicLink,
+  kRename,
+  kHardLink,
+  kOpen,
+  kRead,
+  kWrite,
+  kFlush,
+  kRelease,
+  kFsync,
+  kOpendir,
+  kReaddir,
+  kReleasedir,
+  kFsyncdir,
+  kStatfs,
+  kSetExtendedAttribute,
+  kGetExtendedAttribute,
+  kRemoveExtendedAttribute,
+  kCheckAccess,
+  kCreate,
+  kIoctl,
+  kWriteBuf,
+  kRetrieveReply,
+  kForgetMultipleInodes,
+  kFileAllocate,
+  kReaddirplus,
+};
+
+constexpr usize kNumFuseOpcodes = static_cast<usize>(FuseOpcode::kReaddirplus) + 1;
+
+/** \brief Returns the lower_snake_case name of `op` (e.g. "get_attributes").
+ */
+std::string_view fuse_opcode_name(FuseOpcode op) noexcept;
+
+std::ostream& operator<<(std::ostream& out, FuseOpcode op);
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Process-wide request counters and latency histograms for FUSE operations, per opcode.
+ *
+ * For each request handled by a WorkerTaskFuseImpl, two intervals are measured:
+ *
+ *  - queue_latency: from the push of the request onto a WorkQueue until a worker starts it
+ *  - handler_latency: from the start of the request on the worker until the reply handler returns
+ *
+ * Together with the in-flight gauges, these separate time spent waiting for a worker from time
+ * spent in the filesystem implementation.  The time a request spends in the kernel's queue before
+ * libfuse reads it is not visible to the low-level API, so it is not measured here.
+ *
+ * Latencies are sampled (see LatencySampler) at the rate given by the environment variable
+ * LLFS_FUSE_METRICS_SAMPLE_RATE (default: 1, i.e. every request; 0 disables collection); the
+ * counters always cover every request.  All metrics are added to the global metric registry with
+ * the prefix "Fuse_<opcode>_".
+ */
+class FuseMetrics
+{
+ public:
+  static constexpr u32 kDefaultSampleRate = 1;
+
+  struct OpMetrics {
+    /** \brief The number of requests received.
+     */
+    CountMetric<u64> count;
+
+    /** \brief The number of requests which have been received but not replied to.
+     */
+    CountMetric<i64> in_flight;
+
+    /** \brief The number of requests waiting in a WorkQueue for a worker.
+     */
+    CountMetric<i64> queue_depth;
+
+    /** \brief See class comment.
+     */
+    LatencyHistogram queue_latency;
+
+    /** \brief See class comment.
+     */
+    LatencyHistogram handler_latency;
+  };
+
+  /** \brief Returns the global instance.
+   */
+  static FuseMetrics& instance();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  FuseMetrics(const FuseMetrics&) = delete;
+  FuseMetrics& operator=(const FuseMetrics&) = delete;
+
+  OpMetrics& op(FuseOpcode opcode) noexcept
+  {
+    return this->ops_[static_cast<usize>(opcode)];
+  }
+
+  /** \brief Decides which requests are timed.
+   */
+  LatencySampler sampler;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  FuseMetrics() noexcept;
+
+  std::array<OpMetrics, kNumFuseOpcodes> ops_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_FUSE_METRICS_HPP
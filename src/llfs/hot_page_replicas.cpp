@@ -0,0 +1,161 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/hot_page_replicas.hpp>
+//
+
+#include <llfs/numa.hpp>
+#include <llfs/page_cache_slot_pool.hpp>
+
+#include <batteries/math.hpp>
+#include <batteries/stream_util.hpp>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ HotPageReplicas::HotPageReplicas(std::string&& name, usize n_sets, usize slots_per_set,
+                                              u32 pin_threshold) noexcept
+    : name_{std::move(name)}
+    , table_size_{usize{1} << batt::log2_ceil(std::max<usize>(1, slots_per_set * 2))}
+    , pin_threshold_{std::max<u32>(1, pin_threshold)}
+{
+  BATT_CHECK_GT(n_sets, 0u);
+  BATT_CHECK_GT(slots_per_set, 0u);
+
+  this->sets_.resize(n_sets);
+  for (usize set_i = 0; set_i < n_sets; ++set_i) {
+    ReplicaSet& set = this->sets_[set_i];
+
+    set.pool = PageCacheSlot::Pool::make_new(
+        slots_per_set, batt::to_string(this->name_, "_replicas_", set_i),
+        PageCacheSlot::Pool::kDefaultEvictionCandidates, /*n_shards=*/1);
+
+    // Replica slots exist precisely because they are heavily contended, and the sets are small, so
+    // they are always worth isolating from each other in separate cache lines.
+    //
+    set.pool->set_cache_line_isolation(true);
+
+    set.table.reset(new std::atomic<usize>[this->table_size_]);
+    for (usize i = 0; i < this->table_size_; ++i) {
+      set.table[i].store(kInvalidIndex);
+    }
+  }
+
+  const auto metric_name = [this](std::string_view property) {
+    return batt::to_string("HotPageReplicas_", this->name_, "_", property);
+  };
+
+  this->metrics_.hit_count.add_to_registry(global_metric_registry(), metric_name("hit_count"));
+  this->metrics_.insert_count.add_to_registry(global_metric_registry(),
+                                              metric_name("insert_count"));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+HotPageReplicas::~HotPageReplicas() noexcept
+{
+  this->metrics_.hit_count.remove_from_registry(global_metric_registry());
+  this->metrics_.insert_count.remove_from_registry(global_metric_registry());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize HotPageReplicas::local_set_index() const noexcept
+{
+  if (this->sets_.size() == 1) {
+    return 0;
+  }
+  return current_cpu() % this->sets_.size();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCacheSlot::PinnedRef HotPageReplicas::find(PageId key) noexcept
+{
+  ReplicaSet& set = this->sets_[this->local_set_index()];
+
+  const usize slot_index = this->get_slot_index_ref(set, key).load(std::memory_order_acquire);
+  if (slot_index == kInvalidIndex) {
+    return {};
+  }
+
+  // The slot may have been reused for another page since it was stored in the table; acquire_pin
+  // checks the key.
+  //
+  PageCacheSlot::PinnedRef pinned = set.pool->get_slot(slot_index)->acquire_pin(key);
+  if (pinned) {
+    pinned.slot()->update_latest_use();
+    this->metrics_.hit_count.add(1);
+  }
+  return pinned;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool HotPageReplicas::maybe_insert(PageId key, u32 observed_pin_count,
+                                   const std::shared_ptr<const PageView>& view) noexcept
+{
+  if (observed_pin_count < this->pin_threshold_ || !view) {
+    return false;
+  }
+
+  ReplicaSet& set = this->sets_[this->local_set_index()];
+  std::atomic<usize>& slot_index_ref = this->get_slot_index_ref(set, key);
+
+  // Another thread on this set may have beaten us to it.
+  //
+  const usize observed_slot_index = slot_index_ref.load(std::memory_order_acquire);
+  if (observed_slot_index != kInvalidIndex &&
+      set.pool->get_slot(observed_slot_index)->acquire_pin(key)) {
+    return false;
+  }
+
+  PageCacheSlot* const slot = set.pool->allocate(/*preferred_shard=*/0);
+  if (!slot) {
+    return false;
+  }
+
+  PageCacheSlot::PinnedRef pinned = slot->fill(key);
+  pinned->set_value(batt::make_copy(view));
+  slot->publish_view(view);
+
+  // If we race with another inserter (or a replica of a page that maps to the same table entry),
+  // the last store wins; the loser's slot is never found again, and is eventually evicted.
+  //
+  slot_index_ref.store(slot->index(), std::memory_order_release);
+  this->metrics_.insert_count.add(1);
+
+  return true;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void HotPageReplicas::erase(PageId key) noexcept
+{
+  for (ReplicaSet& set : this->sets_) {
+    const usize slot_index = this->get_slot_index_ref(set, key).load(std::memory_order_acquire);
+    if (slot_index != kInvalidIndex) {
+      (void)set.pool->get_slot(slot_index)->evict_if_key_equals(key);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::atomic<usize>& HotPageReplicas::get_slot_index_ref(ReplicaSet& set, PageId key) noexcept
+{
+  // Mix the bits of the page id so that consecutive pages (and pages on different devices) land in
+  // different entries.
+  //
+  const u64 hash = key.int_value() * 0x9e3779b97f4a7c15ull;
+
+  return set.table[(hash >> 32) & (this->table_size_ - 1)];
+}
+
+}  //namespace llfs
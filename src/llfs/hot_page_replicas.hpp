@@ -0,0 +1,133 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_HOT_PAGE_REPLICAS_HPP
+#define LLFS_HOT_PAGE_REPLICAS_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/metrics.hpp>
+#include <llfs/page_cache_slot.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/page_view.hpp>
+
+#include <boost/intrusive_ptr.hpp>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llfs {
+
+/** \brief Per-CPU read-only replicas of the hottest pages of a PageDeviceCache.
+ *
+ * Pages that are pinned by many threads at once (e.g., the root and upper internal nodes of a tree)
+ * make the pin count of their PageCacheSlot a point of contention.  Since pages are immutable, we
+ * can instead give each replica set (one per CPU, by default) its own slot holding the same
+ * PageView; threads then pin the slot in their local set, so the pin count updates for a hot page
+ * are spread over many cache lines.
+ *
+ * A page is replicated into the calling thread's set as soon as a lookup observes that its primary
+ * slot is pinned by at least pin_threshold() holders at once.  Each set is a small, direct-mapped
+ * table backed by its own PageCacheSlot::Pool; replicas share the PageView (and therefore the page
+ * buffer) with the primary slot, so they cost one slot each, and are not charged to any byte
+ * budget.
+ */
+class HotPageReplicas
+{
+ public:
+  static constexpr usize kInvalidIndex = ~usize{0};
+
+  struct Metrics {
+    StripedCountMetric<u64> hit_count;
+    StripedCountMetric<u64> insert_count;
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Creates `n_sets` replica sets of `slots_per_set` slots each.  `name` is used for
+   * metrics.
+   */
+  explicit HotPageReplicas(std::string&& name, usize n_sets, usize slots_per_set,
+                           u32 pin_threshold) noexcept;
+
+  HotPageReplicas(const HotPageReplicas&) = delete;
+  HotPageReplicas& operator=(const HotPageReplicas&) = delete;
+
+  ~HotPageReplicas() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const Metrics& metrics() const noexcept
+  {
+    return this->metrics_;
+  }
+
+  /** \brief The minimum number of concurrent pins of a primary slot that causes a page to be
+   * replicated.
+   */
+  u32 pin_threshold() const noexcept
+  {
+    return this->pin_threshold_;
+  }
+
+  /** \brief Returns the number of replica sets.
+   */
+  usize set_count() const noexcept
+  {
+    return this->sets_.size();
+  }
+
+  /** \brief Returns the index of the replica set used by the calling thread.
+   */
+  usize local_set_index() const noexcept;
+
+  /** \brief Returns a pinned replica of the given page from the calling thread's set, or an empty
+   * PinnedRef if there is none.
+   */
+  PageCacheSlot::PinnedRef find(PageId key) noexcept;
+
+  /** \brief Replicates the given page into the calling thread's set if `observed_pin_count` (the
+   * pin count of the page's primary slot, as seen by a lookup that pinned it) is at least
+   * pin_threshold(); returns true iff a new replica was created.
+   *
+   * `view` must be the loaded (immutable) view of the page.
+   */
+  bool maybe_insert(PageId key, u32 observed_pin_count,
+                    const std::shared_ptr<const PageView>& view) noexcept;
+
+  /** \brief Evicts all replicas of the given page (in every set) that aren't currently pinned.
+   */
+  void erase(PageId key) noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  struct ReplicaSet {
+    boost::intrusive_ptr<PageCacheSlot::Pool> pool;
+    std::unique_ptr<std::atomic<usize>[]> table;
+  };
+
+  /** \brief Returns the table entry for `key` in the given set.
+   */
+  std::atomic<usize>& get_slot_index_ref(ReplicaSet& set, PageId key) noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const std::string name_;
+  const usize table_size_;
+  const u32 pin_threshold_;
+  std::vector<ReplicaSet> sets_;
+  Metrics metrics_;
+};
+
+}  //namespace llfs
+
+#endif  // LLFS_HOT_PAGE_REPLICAS_HPP
@@ -0,0 +1,89 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/hot_page_replicas.hpp>
+//
+#include <llfs/hot_page_replicas.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/opaque_page_view.hpp>
+#include <llfs/page_buffer.hpp>
+
+namespace {
+
+// Test Plan:
+//  1. A page is only replicated once its observed pin count reaches the threshold; after that,
+//     find returns a pinned replica holding the same view, and inserting it again does nothing.
+//  2. erase evicts unpinned replicas, but not pinned ones.
+//
+
+using namespace llfs::int_types;
+
+std::shared_ptr<const llfs::PageView> make_view(llfs::PageId page_id)
+{
+  return std::make_shared<llfs::OpaquePageView>(
+      llfs::PageBuffer::allocate(llfs::PageSize{4096}, page_id));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  1. Replicate only at the threshold.
+//
+TEST(HotPageReplicasTest, ReplicateAtThreshold)
+{
+  llfs::HotPageReplicas replicas{"Test", /*n_sets=*/1, /*slots_per_set=*/4, /*pin_threshold=*/3};
+
+  const llfs::PageId page_id{7};
+  const std::shared_ptr<const llfs::PageView> view = make_view(page_id);
+
+  EXPECT_FALSE(replicas.find(page_id));
+  EXPECT_FALSE(replicas.maybe_insert(page_id, /*observed_pin_count=*/2, view));
+  EXPECT_FALSE(replicas.find(page_id));
+
+  EXPECT_TRUE(replicas.maybe_insert(page_id, /*observed_pin_count=*/3, view));
+  EXPECT_EQ(replicas.metrics().insert_count.load(), 1u);
+  {
+    llfs::PageCacheSlot::PinnedRef replica = replicas.find(page_id);
+
+    ASSERT_TRUE(replica);
+    EXPECT_EQ(replica.key(), page_id);
+
+    llfs::StatusOr<std::shared_ptr<const llfs::PageView>> loaded = replica->await();
+    ASSERT_TRUE(loaded.ok());
+    EXPECT_EQ(loaded->get(), view.get());
+  }
+
+  EXPECT_FALSE(replicas.maybe_insert(page_id, /*observed_pin_count=*/10, view));
+  EXPECT_FALSE(replicas.find(llfs::PageId{8}));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  2. erase
+//
+TEST(HotPageReplicasTest, Erase)
+{
+  llfs::HotPageReplicas replicas{"Test", /*n_sets=*/1, /*slots_per_set=*/4, /*pin_threshold=*/1};
+
+  const llfs::PageId page_id{7};
+  ASSERT_TRUE(replicas.maybe_insert(page_id, /*observed_pin_count=*/1, make_view(page_id)));
+  {
+    llfs::PageCacheSlot::PinnedRef replica = replicas.find(page_id);
+    ASSERT_TRUE(replica);
+
+    replicas.erase(page_id);
+
+    EXPECT_TRUE(replicas.find(page_id));
+  }
+
+  replicas.erase(page_id);
+
+  EXPECT_FALSE(replicas.find(page_id));
+}
+
+}  // namespace
@@ -14,32 +14,241 @@
 #ifndef LLFS_DISABLE_IO_URING
 
 #include <llfs/logging.hpp>
+#include <llfs/numa.hpp>
 
 #include <batteries/assert.hpp>
+#include <batteries/finally.hpp>
 
 #include <sys/stat.h>
 #include <sys/types.h>
 
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 
 namespace llfs {
 
+namespace {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+/** \brief Records which queue (if any) of a multi-queue IoRing the current thread is servicing,
+ * inside IoRing::run_queue.
+ */
+struct LocalQueueBinding {
+  const void* queues = nullptr;
+  usize queue_index = 0;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+LocalQueueBinding& this_thread_queue_binding()
+{
+  thread_local LocalQueueBinding binding;
+  return binding;
+}
+
+}  //namespace
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 /*static*/ StatusOr<IoRing> IoRing::make_new(MaxQueueDepth entries) noexcept
 {
-  BATT_ASSIGN_OK_RESULT(std::unique_ptr<Impl> impl, Impl::make_new(entries));
+  return IoRing::make_new(entries, IoRingQueueCount{1});
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<IoRing> IoRing::make_new(MaxQueueDepth entries,
+                                             IoRingQueueCount n_queues) noexcept
+{
+  return IoRing::make_new(IoRingOptions::with_default_values()  //
+                              .set_queue_depth(entries)
+                              .set_queue_count(n_queues));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<IoRing> IoRing::make_new(const IoRingOptions& options) noexcept
+{
+  auto queues = std::make_unique<Queues>();
+
+  for (usize i = 0; i < std::max<usize>(1, options.queue_count()); ++i) {
+    BATT_ASSIGN_OK_RESULT(std::unique_ptr<Impl> impl, Impl::make_new(options));
+    queues->impls.emplace_back(std::move(impl));
+  }
+
+  return IoRing{std::move(queues)};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+IoRing::IoRing(std::unique_ptr<Queues>&& queues) noexcept : queues_{std::move(queues)}
+{
+  BATT_CHECK_NOT_NULLPTR(this->queues_);
+  BATT_CHECK(!this->queues_->impls.empty());
+
+  for (const std::unique_ptr<Impl>& impl : this->queues_->impls) {
+    BATT_CHECK(impl->is_valid());
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status IoRing::run_queue(usize queue_index) const noexcept
+{
+  BATT_CHECK_LT(queue_index, this->queue_count());
+
+  // Route submissions from this thread to the queue it is servicing for as long as we are inside
+  // run.
+  //
+  LocalQueueBinding& binding = this_thread_queue_binding();
+  const LocalQueueBinding saved_binding = binding;
+  auto on_scope_exit = batt::finally([&] {
+    binding = saved_binding;
+  });
+
+  binding.queues = this->queues_.get();
+  binding.queue_index = queue_index;
+
+  return this->queues_->impls[queue_index]->run();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto IoRing::local_impl_multi_queue() const noexcept -> Impl&
+{
+  const usize n_queues = this->queue_count();
+
+  const LocalQueueBinding& binding = this_thread_queue_binding();
+  if (binding.queues == this->queues_.get()) {
+    return *this->queues_->impls[binding.queue_index];
+  }
+
+  // The calling thread isn't one of our workers; pick the queue based on the CPU we are running on,
+  // so that (if the workers are pinned to cores) completions are handled nearby.
+  //
+  const int cpu = sched_getcpu();
+  const usize queue_index = (cpu < 0) ? 0 : (static_cast<usize>(cpu) % n_queues);
+
+  return *this->queues_->impls[queue_index];
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<usize> IoRing::register_buffers(batt::BoxedSeq<MutableBuffer>&& buffers,
+                                         bool update) const noexcept
+{
+  if (this->queue_count() == 1) {
+    return this->queues_->impls.front()->register_buffers(std::move(buffers), update);
+  }
+
+  std::unique_lock<std::mutex> lock{this->queues_->registration_mutex};
+
+  // The passed sequence can only be consumed once, so save a copy to pass to each queue.
+  //
+  const std::vector<MutableBuffer> buffers_vec = std::move(buffers) | seq::collect_vec();
+
+  Optional<usize> first_index;
+  for (const std::unique_ptr<Impl>& impl : this->queues_->impls) {
+    BATT_ASSIGN_OK_RESULT(usize index, impl->register_buffers(as_seq(buffers_vec)  //
+                                                                  | seq::decayed()   //
+                                                                  | seq::boxed(),
+                                                              update));
+    if (!first_index) {
+      first_index = index;
+    } else {
+      BATT_CHECK_EQ(*first_index, index) << "All queues must agree on registered buffer indices!";
+    }
+  }
+
+  return *first_index;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status IoRing::unregister_buffers() const noexcept
+{
+  std::unique_lock<std::mutex> lock{this->queues_->registration_mutex};
+
+  for (const std::unique_ptr<Impl>& impl : this->queues_->impls) {
+    BATT_REQUIRE_OK(impl->unregister_buffers());
+  }
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<struct io_uring_buf_ring*> IoRing::setup_buf_ring(u32 entries,
+                                                           u16 group_id) const noexcept
+{
+  if (this->queue_count() != 1) {
+    return {batt::StatusCode::kUnimplemented};
+  }
+  return this->queues_->impls.front()->setup_buf_ring(entries, group_id);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status IoRing::free_buf_ring(struct io_uring_buf_ring* buf_ring, u32 entries,
+                             u16 group_id) const noexcept
+{
+  BATT_CHECK_EQ(this->queue_count(), 1u);
 
-  return IoRing{std::move(impl)};
+  return this->queues_->impls.front()->free_buf_ring(buf_ring, entries, group_id);
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-IoRing::IoRing(std::unique_ptr<Impl>&& impl) noexcept : impl_{std::move(impl)}
+StatusOr<i32> IoRing::register_fd(i32 system_fd) const noexcept
 {
-  BATT_CHECK(this->impl_->is_valid());
+  if (this->queue_count() == 1) {
+    return this->queues_->impls.front()->register_fd(system_fd);
+  }
+
+  std::unique_lock<std::mutex> lock{this->queues_->registration_mutex};
+
+  const auto& impls = this->queues_->impls;
+  Optional<i32> first_user_fd;
+  usize n_registered = 0;
+
+  // If we fail part way through, undo the registration on the queues that succeeded.
+  //
+  auto revert_on_failure = batt::finally([&] {
+    for (usize i = 0; i < n_registered; ++i) {
+      impls[i]->unregister_fd(*first_user_fd).IgnoreError();
+    }
+  });
+
+  for (const std::unique_ptr<Impl>& impl : impls) {
+    BATT_ASSIGN_OK_RESULT(i32 user_fd, impl->register_fd(system_fd));
+    if (!first_user_fd) {
+      first_user_fd = user_fd;
+    }
+    ++n_registered;
+    BATT_CHECK_EQ(*first_user_fd, user_fd) << "All queues must agree on registered fd indices!";
+  }
+
+  revert_on_failure.cancel();
+
+  return *first_user_fd;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status IoRing::unregister_fd(i32 user_fd) const noexcept
+{
+  std::unique_lock<std::mutex> lock{this->queues_->registration_mutex};
+
+  Status status;
+  for (const std::unique_ptr<Impl>& impl : this->queues_->impls) {
+    status.Update(impl->unregister_fd(user_fd));
+  }
+  return status;
 }
 
 //#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
@@ -55,6 +264,61 @@ IoRing::IoRing(std::unique_ptr<Impl>&& impl) noexcept : impl_{std::move(impl)}
   return ScopedIoRing{std::make_unique<Impl>(std::move(*io), n_threads)};
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<ScopedIoRing> ScopedIoRing::make_new(MaxQueueDepth entries,
+                                                         ThreadPoolSize n_threads,
+                                                         IoRingQueueCount n_queues,
+                                                         PinThreadsToCores pin_threads) noexcept
+{
+  BATT_CHECK_GE(n_threads, n_queues) << "Each queue must have at least one thread to run it!";
+
+  StatusOr<IoRing> io = IoRing::make_new(entries, n_queues);
+  BATT_REQUIRE_OK(io);
+
+  return ScopedIoRing{std::make_unique<Impl>(std::move(*io), n_threads, pin_threads)};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<ScopedIoRing> ScopedIoRing::make_new(const IoRingOptions& options,
+                                                         ThreadPoolSize n_threads,
+                                                         PinThreadsToCores pin_threads) noexcept
+{
+  BATT_CHECK_GE(n_threads, std::max<usize>(1, options.queue_count()))
+      << "Each queue must have at least one thread to run it!";
+
+  StatusOr<IoRing> io = IoRing::make_new(options);
+  BATT_REQUIRE_OK(io);
+
+  return ScopedIoRing{std::make_unique<Impl>(std::move(*io), n_threads, pin_threads)};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<ScopedIoRing> ScopedIoRing::make_new_on_numa_node(const IoRingOptions& options,
+                                                                      ThreadPoolSize n_threads,
+                                                                      usize numa_node) noexcept
+{
+  BATT_CHECK_GE(n_threads, std::max<usize>(1, options.queue_count()))
+      << "Each queue must have at least one thread to run it!";
+
+  // The kernel allocates the ring's queues on the node of the thread that creates it.
+  //
+  StatusOr<IoRing> io{Status{batt::StatusCode::kUnknown}};
+  std::thread{[&] {
+    if (!pin_current_thread_to_numa_node(numa_node)) {
+      LLFS_LOG_WARNING() << "Failed to move IoRing setup to NUMA node" << BATT_INSPECT(numa_node);
+    }
+    io = IoRing::make_new(options);
+  }}.join();
+
+  BATT_REQUIRE_OK(io);
+
+  return ScopedIoRing{std::make_unique<Impl>(std::move(*io), n_threads, PinThreadsToCores{false},
+                                             numa_node)};
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 /*explicit*/ ScopedIoRing::ScopedIoRing(std::unique_ptr<Impl>&& impl) noexcept
@@ -90,7 +354,9 @@ void ScopedIoRing::join()
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-/*explicit*/ ScopedIoRing::Impl::Impl(IoRing&& io, ThreadPoolSize n_threads) noexcept
+/*explicit*/ ScopedIoRing::Impl::Impl(IoRing&& io, ThreadPoolSize n_threads,
+                                      PinThreadsToCores pin_threads,
+                                      Optional<usize> numa_node) noexcept
     : io_{std::move(io)}
     , threads_{}
     , halted_{false}
@@ -101,8 +367,8 @@ void ScopedIoRing::join()
   this->io_.on_work_started();
 
   for (usize i = 0; i < n_threads; ++i) {
-    this->threads_.emplace_back([this] {
-      this->io_thread_main();
+    this->threads_.emplace_back([this, i, pin_threads, numa_node] {
+      this->io_thread_main(i, pin_threads, numa_node);
     });
   }
 }
@@ -117,9 +383,29 @@ ScopedIoRing::Impl::~Impl() noexcept
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-void ScopedIoRing::Impl::io_thread_main()
+void ScopedIoRing::Impl::io_thread_main(usize thread_i, PinThreadsToCores pin_threads,
+                                        Optional<usize> numa_node)
 {
-  Status status = this->io_.run();
+  if (numa_node) {
+    if (!pin_current_thread_to_numa_node(*numa_node)) {
+      LLFS_LOG_WARNING() << "Failed to restrict IoRing thread to NUMA node"
+                         << BATT_INSPECT(thread_i) << BATT_INSPECT(*numa_node);
+    }
+  } else if (pin_threads) {
+    const usize n_cpus = std::max<usize>(1, std::thread::hardware_concurrency());
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(thread_i % n_cpus, &cpu_set);
+
+    const int retval = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    if (retval != 0) {
+      LLFS_LOG_WARNING() << "Failed to pin IoRing thread to CPU core: " << std::strerror(retval)
+                         << BATT_INSPECT(thread_i);
+    }
+  }
+
+  Status status = this->io_.run_queue(thread_i % this->io_.queue_count());
   LLFS_VLOG(1) << "ScopedIoRing::io_thread_main() exited with " << BATT_INSPECT(status);
 }
 
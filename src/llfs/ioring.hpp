@@ -18,6 +18,7 @@
 #include <llfs/buffer.hpp>
 #include <llfs/int_types.hpp>
 #include <llfs/ioring_impl.hpp>
+#include <llfs/optional.hpp>
 #include <llfs/status.hpp>
 #include <llfs/system_config.hpp>
 
@@ -34,10 +35,14 @@
 #include <sys/types.h>
 
 #include <atomic>
+#include <cerrno>
+#include <chrono>
 #include <functional>
 #include <iterator>
 #include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 namespace llfs {
 
@@ -52,12 +57,63 @@ class IoRing
 
   using Impl = IoRingImpl;
 
+  /** \brief While an object of this type is in scope, all operations submitted to the IoRing by the
+   * current thread are queued without entering the kernel; they are submitted together (with a
+   * single io_uring_submit call) when the outermost SubmitBatch goes out of scope.
+   *
+   * The current thread must not block waiting for the completion of an operation it submitted
+   * while a SubmitBatch is in scope, since that operation may not have been started yet!
+   */
+  class SubmitBatch
+  {
+   public:
+    explicit SubmitBatch(const IoRing& io_ring) noexcept
+        : impl_{&io_ring.local_impl()}
+        , active_{this->impl_->begin_submit_batch()}
+    {
+    }
+
+    SubmitBatch(const SubmitBatch&) = delete;
+    SubmitBatch& operator=(const SubmitBatch&) = delete;
+
+    ~SubmitBatch() noexcept
+    {
+      if (this->active_) {
+        this->impl_->end_submit_batch();
+      }
+    }
+
+   private:
+    Impl* impl_;
+    bool active_;
+  };
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   /** \brief Creates and returns a new io_uring with the specified maximum queue depth.
    */
   static StatusOr<IoRing> make_new(MaxQueueDepth entries) noexcept;
 
+  /** \brief Creates and returns a new multi-queue IoRing, comprised of `n_queues` independent
+   * io_urings, each with the specified maximum queue depth.
+   *
+   * In this mode, each thread that calls `run()` (or `run_queue()`) services the completions of a
+   * single queue, and each operation is submitted to the queue local to the calling thread: the
+   * queue serviced by that thread if it is one of this IoRing's workers, otherwise the queue
+   * selected by the CPU the thread is currently running on.  This removes the contention on a
+   * single shared ring (and its completion queue mutex) when many threads are doing I/O in
+   * parallel.
+   *
+   * Registered files and buffers are registered with every queue at the same index, so user_fd
+   * and buffer index values work no matter which queue an operation is routed to.
+   */
+  static StatusOr<IoRing> make_new(MaxQueueDepth entries, IoRingQueueCount n_queues) noexcept;
+
+  /** \brief Creates and returns a new IoRing using the given options; this is the only way to
+   * enable SQPOLL/IOPOLL mode (see IoRingOptions).
+   */
+  static StatusOr<IoRing> make_new(const IoRingOptions& options) noexcept;
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   /** \brief IoRing is move-only (no copying).
@@ -80,34 +136,66 @@ class IoRing
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
+  /** \brief Returns the options used to create this IoRing.
+   */
+  const IoRingOptions& options() const noexcept
+  {
+    return this->queues_->impls.front()->options();
+  }
+
+  /** \brief Returns the number of independent io_uring queues in this IoRing (1 unless created in
+   * multi-queue mode).
+   */
+  usize queue_count() const noexcept
+  {
+    return this->queues_->impls.size();
+  }
+
   /** \brief Wait for I/O completions and run their handlers while work count is non-zero and
    * this->stop() has not been called.
+   *
+   * In multi-queue mode, successive calls to run() (typically from different threads) are assigned
+   * to the queues in round-robin order; every queue must have at least one thread running it.
    */
   Status run() const noexcept
   {
-    return this->impl_->run();
+    if (this->queue_count() == 1) {
+      return this->queues_->impls.front()->run();
+    }
+    return this->run_queue(this->queues_->next_run_index.fetch_add(1) % this->queue_count());
   }
 
+  /** \brief Same as run(), except the caller explicitly chooses which queue to service; while this
+   * function is running, operations submitted by the calling thread are routed to the same queue.
+   */
+  Status run_queue(usize queue_index) const noexcept;
+
   /** \brief Resets the IoRing after calling `this->stop()`, so that `this->run()` can be called
    * again.
    */
   void reset() const noexcept
   {
-    this->impl_->reset();
+    for (const std::unique_ptr<Impl>& impl : this->queues_->impls) {
+      impl->reset();
+    }
   }
 
-  /** \brief Increments the work count.
+  /** \brief Increments the work count (of every queue).
    */
   void on_work_started() const noexcept
   {
-    this->impl_->on_work_started();
+    for (const std::unique_ptr<Impl>& impl : this->queues_->impls) {
+      impl->on_work_started();
+    }
   }
 
-  /** \brief Decrements the work count.
+  /** \brief Decrements the work count (of every queue).
    */
   void on_work_finished() const noexcept
   {
-    this->impl_->on_work_finished();
+    for (const std::unique_ptr<Impl>& impl : this->queues_->impls) {
+      impl->on_work_finished();
+    }
   }
 
   /** \brief Causes the passed handler to be executed inside `this->run()` on some thread, after
@@ -116,7 +204,33 @@ class IoRing
   template <typename Handler = void(StatusOr<i32>)>
   void post(Handler&& handler) const noexcept
   {
-    this->impl_->post(BATT_FORWARD(handler));
+    this->local_impl().post(BATT_FORWARD(handler));
+  }
+
+  /** \brief Causes the passed handler to be executed inside `this->run()` once (at least) the
+   * given duration has elapsed.  The handler is passed `0` if the timer expired normally, or an
+   * error status if the operation was cancelled.
+   */
+  template <typename Handler = void(StatusOr<i32>)>
+  void async_sleep(std::chrono::microseconds duration, Handler&& handler) const noexcept
+  {
+    const auto secs = std::chrono::duration_cast<std::chrono::seconds>(duration);
+    const auto nsecs = std::chrono::duration_cast<std::chrono::nanoseconds>(duration - secs);
+
+    this->submit(no_buffers(),
+                 SleepHandler<std::decay_t<Handler>>{
+                     {
+                         .tv_sec = secs.count(),
+                         .tv_nsec = nsecs.count(),
+                     },
+                     BATT_FORWARD(handler),
+                 },
+                 [](struct io_uring_sqe* sqe, auto& op) {
+                   // The timespec must remain valid until the SQE is submitted, so it lives inside
+                   // the handler.
+                   //
+                   io_uring_prep_timeout(sqe, &op.fn_.timeout, /*count=*/0, /*flags=*/0);
+                 });
   }
 
   template <typename Handler = void(StatusOr<i32>), typename BufferSequence>
@@ -124,53 +238,226 @@ class IoRing
               std::function<void(struct io_uring_sqe*, IoRingOpHandler<std::decay_t<Handler>>&)>&&
                   start_op) const noexcept
   {
-    this->impl_->submit(BATT_FORWARD(buffers), BATT_FORWARD(handler), std::move(start_op));
+    this->local_impl().submit(BATT_FORWARD(buffers), BATT_FORWARD(handler), std::move(start_op));
+  }
+
+  /** \brief Submits two operations as a linked chain; see IoRingImpl::submit_linked.
+   */
+  template <typename FirstHandler, typename SecondHandler, typename BufferSequence>
+  void submit_linked(
+      BufferSequence&& buffers, FirstHandler&& first_handler,
+      std::function<void(struct io_uring_sqe*, IoRingOpHandler<std::decay_t<FirstHandler>>&)>&&
+          start_first_op,
+      SecondHandler&& second_handler,
+      std::function<void(struct io_uring_sqe*, IoRingOpHandler<std::decay_t<SecondHandler>>&)>&&
+          start_second_op) const noexcept
+  {
+    this->local_impl().submit_linked(BATT_FORWARD(buffers), BATT_FORWARD(first_handler),
+                                     std::move(start_first_op), BATT_FORWARD(second_handler),
+                                     std::move(start_second_op));
+  }
+
+  /** \brief Submits an operation with a linked timeout; see IoRingImpl::submit_with_timeout.
+   */
+  template <typename Handler = void(StatusOr<i32>), typename BufferSequence, typename StartOp>
+  void submit_with_timeout(BufferSequence&& buffers, std::chrono::nanoseconds timeout,
+                           Handler&& handler, StartOp&& start_op) const noexcept
+  {
+    this->local_impl().submit_with_timeout(BATT_FORWARD(buffers), timeout, BATT_FORWARD(handler),
+                                           BATT_FORWARD(start_op));
+  }
+
+  /** \brief Asynchronously cancels all in-flight operations for the file descriptor `fd` (a
+   * registered "user_fd" if `fixed` is true); see IoRingImpl::async_cancel_fd.
+   *
+   * In multi-queue mode, a cancel request is submitted to every queue, and `handler` is invoked
+   * once, with the total number of operations cancelled.
+   */
+  template <typename Handler = void(StatusOr<i32>)>
+  void async_cancel_fd(i32 fd, bool fixed, Handler&& handler) const noexcept
+  {
+    if (this->queue_count() == 1) {
+      this->queues_->impls.front()->async_cancel_fd(fd, fixed, BATT_FORWARD(handler));
+      return;
+    }
+
+    struct State {
+      explicit State(Handler&& caller_handler, usize n_queues) noexcept
+          : handler{BATT_FORWARD(caller_handler)}
+          , n_pending{n_queues}
+      {
+      }
+
+      void finish(StatusOr<i32>&& result)
+      {
+        {
+          std::unique_lock<std::mutex> lock{this->mutex};
+          if (result.ok()) {
+            this->total += *result;
+          } else {
+            this->status.Update(result.status());
+          }
+        }
+        if (this->n_pending.fetch_sub(1) != 1) {
+          return;
+        }
+        if (!this->status.ok()) {
+          this->handler(StatusOr<i32>{this->status});
+        } else {
+          this->handler(StatusOr<i32>{this->total});
+        }
+      }
+
+      std::decay_t<Handler> handler;
+      std::atomic<usize> n_pending;
+      std::mutex mutex;
+      i32 total = 0;
+      Status status;
+    };
+
+    auto state = std::make_shared<State>(BATT_FORWARD(handler), this->queue_count());
+
+    for (const std::unique_ptr<Impl>& impl : this->queues_->impls) {
+      impl->async_cancel_fd(fd, fixed, [state](StatusOr<i32> result) {
+        state->finish(std::move(result));
+      });
+    }
   }
 
   void stop() const noexcept
   {
-    this->impl_->stop();
+    for (const std::unique_ptr<Impl>& impl : this->queues_->impls) {
+      impl->stop();
+    }
   }
 
-  StatusOr<usize> register_buffers(batt::BoxedSeq<MutableBuffer>&& buffers,
-                                   bool update = false) const noexcept
+  /** \brief Submits any operations that have been started but are being held in a submission
+   * queue because submission batching is enabled (see IoRingOptions::submit_batch_size).
+   */
+  void flush_submissions() const noexcept
   {
-    return this->impl_->register_buffers(std::move(buffers), update);
+    for (const std::unique_ptr<Impl>& impl : this->queues_->impls) {
+      impl->flush_submissions();
+    }
   }
 
-  /** \brief Unregisters all currently registered buffers.
+  /** \brief Returns the average number of operations submitted to the kernel per io_uring_submit
+   * call, across all queues.
    */
-  Status unregister_buffers() const noexcept
+  double average_submit_batch_size() const noexcept
   {
-    return this->impl_->unregister_buffers();
+    u64 n_submits = 0;
+    u64 n_ops = 0;
+    for (const std::unique_ptr<Impl>& impl : this->queues_->impls) {
+      n_submits += impl->metrics().submit_count.load();
+      n_ops += impl->metrics().submitted_op_count.load();
+    }
+    if (n_submits == 0) {
+      return 0;
+    }
+    return double(n_ops) / double(n_submits);
   }
 
+  /** \brief Returns the submission/completion metrics of the given queue.  These are also added
+   * to the global metric registry as IoRing_<N>_* (one N per queue).
+   */
+  const Impl::Metrics& queue_metrics(usize queue_index) const noexcept
+  {
+    BATT_CHECK_LT(queue_index, this->queue_count());
+    return this->queues_->impls[queue_index]->metrics();
+  }
+
+  StatusOr<usize> register_buffers(batt::BoxedSeq<MutableBuffer>&& buffers,
+                                   bool update = false) const noexcept;
+
+  /** \brief Unregisters all currently registered buffers.
+   */
+  Status unregister_buffers() const noexcept;
+
+  /** \brief Allocates and registers a provided buffer ring for buffer group `group_id`; see
+   * IoRingProvidedBufferRing.
+   *
+   * Only supported when this IoRing has a single queue (buffer rings belong to one io_uring);
+   * otherwise returns batt::StatusCode::kUnimplemented.
+   */
+  StatusOr<struct io_uring_buf_ring*> setup_buf_ring(u32 entries, u16 group_id) const noexcept;
+
+  /** \brief Unregisters and frees a buffer ring returned by `setup_buf_ring`.
+   */
+  Status free_buf_ring(struct io_uring_buf_ring* buf_ring, u32 entries,
+                       u16 group_id) const noexcept;
+
   /** \brief Registers the given file descriptor with the io_uring in kernel space, speeding
    * performance for repeated access to the same file.
    *
    * \return the "user_fd" that should be used to achieve faster syscalls in the future.
    */
-  StatusOr<i32> register_fd(i32 system_fd) const noexcept
-  {
-    return this->impl_->register_fd(system_fd);
-  }
+  StatusOr<i32> register_fd(i32 system_fd) const noexcept;
 
   /** \brief Unregisters the given "user_fd" that was previously returned by a call to
    * `IoRing::register_fd`.
    *
    * Behavior is undefined if a user_fd obtained from one IoRing is handed to another!
    */
-  Status unregister_fd(i32 user_fd) const noexcept
+  Status unregister_fd(i32 user_fd) const noexcept;
+
+ private:
+  /** \brief The io_uring queue(s) owned by an IoRing, along with the state shared between them;
+   * this is heap-allocated so that IoRing objects can be moved without invalidating the addresses
+   * used by threads inside run().
+   */
+  struct Queues {
+    /** \brief One Impl per queue; never empty.
+     */
+    std::vector<std::unique_ptr<Impl>> impls;
+
+    /** \brief Used to assign calls to run() to queues in round-robin order.
+     */
+    mutable std::atomic<usize> next_run_index{0};
+
+    /** \brief Serializes file/buffer registration so that all queues assign the same indices.
+     */
+    mutable std::mutex registration_mutex;
+  };
+
+  /** \brief Completion handler wrapper for `async_sleep`; holds the timeout value and translates
+   * the normal expiration result (-ETIME) into success.
+   */
+  template <typename Handler>
+  struct SleepHandler {
+    struct __kernel_timespec timeout;
+    Handler handler;
+
+    void operator()(StatusOr<i32> result)
+    {
+      if (result.status() == batt::status_from_errno(ETIME)) {
+        result = 0;
+      }
+      this->handler(std::move(result));
+    }
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  explicit IoRing(std::unique_ptr<Queues>&& queues) noexcept;
+
+  /** \brief Returns the queue to which operations submitted by the calling thread should be routed.
+   */
+  Impl& local_impl() const noexcept
   {
-    return this->impl_->unregister_fd(user_fd);
+    if (this->queue_count() == 1) {
+      return *this->queues_->impls.front();
+    }
+    return this->local_impl_multi_queue();
   }
 
- private:
-  explicit IoRing(std::unique_ptr<Impl>&& impl) noexcept;
+  /** \brief The multi-queue case of `local_impl()`.
+   */
+  Impl& local_impl_multi_queue() const noexcept;
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
-  std::unique_ptr<Impl> impl_;
+  std::unique_ptr<Queues> queues_;
 };
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
@@ -189,6 +476,30 @@ class ScopedIoRing
   //
   static StatusOr<ScopedIoRing> make_new(MaxQueueDepth entries, ThreadPoolSize n_threads) noexcept;
 
+  // Creates a new multi-queue IoRing (see IoRing::make_new) with `n_threads` worker threads; thread
+  // `i` services queue `i % n_queues`.  If `pin_threads` is true, thread `i` is also pinned to CPU
+  // core `i % std::thread::hardware_concurrency()`.
+  //
+  static StatusOr<ScopedIoRing> make_new(MaxQueueDepth entries, ThreadPoolSize n_threads,
+                                         IoRingQueueCount n_queues,
+                                         PinThreadsToCores pin_threads) noexcept;
+
+  // Creates a new IoRing from the given options (see IoRing::make_new) with `n_threads` worker
+  // threads, assigned to queues as above.
+  //
+  static StatusOr<ScopedIoRing> make_new(const IoRingOptions& options, ThreadPoolSize n_threads,
+                                         PinThreadsToCores pin_threads = PinThreadsToCores{
+                                             false}) noexcept;
+
+  // Creates a new IoRing from the given options with `n_threads` worker threads (assigned to queues
+  // as above), all restricted to the CPUs of NUMA node `numa_node` (see numa_node_cpus).  The ring
+  // itself is also created on a thread of that node, so that the kernel allocates its queues there.
+  // Use this to keep the I/O of a device on the node it is attached to (see numa_node_of_file).
+  //
+  static StatusOr<ScopedIoRing> make_new_on_numa_node(const IoRingOptions& options,
+                                                      ThreadPoolSize n_threads,
+                                                      usize numa_node) noexcept;
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
   // move-only, default constructible
   //
@@ -253,16 +564,20 @@ class ScopedIoRing::Impl
 
   // Create a new Impl with the given IoRing and a thread pool of the given size.
   //
-  explicit Impl(IoRing&& io, ThreadPoolSize n_threads) noexcept;
+  explicit Impl(IoRing&& io, ThreadPoolSize n_threads,
+                PinThreadsToCores pin_threads = PinThreadsToCores{false},
+                Optional<usize> numa_node = None) noexcept;
 
   // Gracefully shuts down the IoRing and thread pool, waiting for all threads to join before
   // returning.
   //
   ~Impl() noexcept;
 
-  // The thread function used by the contained thread pool; calls `IoRing::run()`
+  // The thread function used by the contained thread pool; calls `IoRing::run_queue()` for the
+  // queue assigned to the given thread index.  If `numa_node` is set, the thread is restricted to
+  // the CPUs of that node (instead of being pinned to a single core).
   //
-  void io_thread_main();
+  void io_thread_main(usize thread_i, PinThreadsToCores pin_threads, Optional<usize> numa_node);
 
   // Returns a reference to the IoRing.
   //
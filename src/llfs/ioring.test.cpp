@@ -16,6 +16,7 @@
 
 #include <llfs/filesystem.hpp>
 #include <llfs/ioring_file.hpp>
+#include <llfs/ioring_file_runtime_options.hpp>
 #include <llfs/page_view.hpp>
 #include <llfs/ring_buffer.hpp>
 
@@ -29,10 +30,13 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include <array>
+#include <chrono>
 #include <cstdlib>
 #include <random>
+#include <set>
 #include <thread>
 #include <vector>
 
@@ -200,6 +204,146 @@ TEST(IoRingTest, MultipleThreads)
   EXPECT_THAT((std::string_view{buffer.data(), message.size()}), ::testing::StrEq(message));
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(IoRingTest, MultiQueue)
+{
+  constexpr usize kNumQueues = 4;
+  constexpr usize kNumSubmitThreads = 8;
+  constexpr usize kNumPostsPerThread = 1000;
+
+  StatusOr<ScopedIoRing> scoped_io_ring = ScopedIoRing::make_new(
+      llfs::MaxQueueDepth{64}, llfs::ThreadPoolSize{kNumQueues},
+      llfs::IoRingQueueCount{kNumQueues}, llfs::PinThreadsToCores{true});
+
+  ASSERT_TRUE(scoped_io_ring.ok()) << BATT_INSPECT(scoped_io_ring.status());
+
+  const IoRing& io = scoped_io_ring->get_io_ring();
+
+  EXPECT_EQ(io.queue_count(), kNumQueues);
+
+  // Registered fds must work no matter which queue an operation lands on.
+  //
+  const auto file_path = "/tmp/llfs_ioring_multi_queue_test_file";
+
+  int fd = open(file_path, O_CREAT | O_RDWR, /*mode=*/0644);
+  ASSERT_GE(fd, 0) << std::strerror(errno);
+
+  IoRing::File f{io, fd};
+
+  f.set_raw_io(false);
+  ASSERT_TRUE(f.register_fd().ok());
+
+  std::string message = "Hello, Multi-Queue World.";
+
+  Status write_status = f.write_all(/*offset=*/0, ConstBuffer{message.data(), message.size()});
+
+  ASSERT_TRUE(write_status.ok()) << BATT_INSPECT(write_status);
+
+  // Post handlers from many threads (which will be spread across the queues by CPU); all of them
+  // must run.
+  //
+  Watch<usize> done_count{0};
+  {
+    std::vector<std::thread> submit_threads;
+    for (usize i = 0; i < kNumSubmitThreads; ++i) {
+      submit_threads.emplace_back([&io, &done_count] {
+        for (usize j = 0; j < kNumPostsPerThread; ++j) {
+          io.post([&done_count](StatusOr<i32> result) {
+            EXPECT_TRUE(result.ok()) << BATT_INSPECT(result.status());
+            done_count.fetch_add(1);
+          });
+        }
+      });
+    }
+    for (std::thread& t : submit_threads) {
+      t.join();
+    }
+  }
+
+  ASSERT_TRUE(done_count.await_equal(kNumSubmitThreads * kNumPostsPerThread).ok());
+
+  std::array<char, 512> buffer;
+
+  Status read_status = f.read_all(/*offset=*/0, MutableBuffer{buffer.data(), message.size()});
+
+  ASSERT_TRUE(read_status.ok()) << BATT_INSPECT(read_status);
+  EXPECT_THAT((std::string_view{buffer.data(), message.size()}), ::testing::StrEq(message));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(IoRingTest, SqPoll)
+{
+  StatusOr<ScopedIoRing> scoped_io_ring =
+      ScopedIoRing::make_new(llfs::IoRingOptions::with_default_values()  //
+                                 .set_queue_depth(llfs::MaxQueueDepth{64})
+                                 .set_sqpoll(true)
+                                 .set_sqpoll_idle_ms(10)
+                                 .set_sqpoll_cpu(0),
+                             llfs::ThreadPoolSize{1});
+
+  if (scoped_io_ring.status() == batt::status_from_errno(EPERM)) {
+    GTEST_SKIP() << "SQPOLL is not permitted for this process";
+  }
+  ASSERT_TRUE(scoped_io_ring.ok()) << BATT_INSPECT(scoped_io_ring.status());
+
+  const IoRing& io = scoped_io_ring->get_io_ring();
+
+  EXPECT_TRUE(io.options().sqpoll());
+  EXPECT_EQ(io.options().sqpoll_idle_ms(), 10u);
+
+  const auto file_path = "/tmp/llfs_ioring_sqpoll_test_file";
+
+  int fd = open(file_path, O_CREAT | O_RDWR, /*mode=*/0644);
+  ASSERT_GE(fd, 0) << std::strerror(errno);
+
+  IoRing::File f{io, fd};
+
+  f.set_raw_io(false);
+  ASSERT_TRUE(f.register_fd().ok());
+
+  std::string message = "Hello, Polling World.";
+
+  Status write_status = f.write_all(/*offset=*/0, ConstBuffer{message.data(), message.size()});
+
+  ASSERT_TRUE(write_status.ok()) << BATT_INSPECT(write_status);
+
+  std::array<char, 512> buffer;
+
+  Status read_status = f.read_all(/*offset=*/0, MutableBuffer{buffer.data(), message.size()});
+
+  ASSERT_TRUE(read_status.ok()) << BATT_INSPECT(read_status);
+  EXPECT_THAT((std::string_view{buffer.data(), message.size()}), ::testing::StrEq(message));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(IoRingTest, IoPollRequiresRawIo)
+{
+  StatusOr<IoRing> io = IoRing::make_new(llfs::IoRingOptions::with_default_values()  //
+                                             .set_queue_depth(llfs::MaxQueueDepth{64})
+                                             .set_iopoll(true));
+  ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+
+  EXPECT_TRUE(io->options().iopoll());
+
+  const auto file_path = "/tmp/llfs_ioring_iopoll_test_file";
+  {
+    int fd = open(file_path, O_CREAT | O_RDWR, /*mode=*/0644);
+    ASSERT_GE(fd, 0) << std::strerror(errno);
+    ::close(fd);
+  }
+
+  llfs::IoRingFileRuntimeOptions file_options =
+      llfs::IoRingFileRuntimeOptions::with_default_values(*io);
+  file_options.use_raw_io = false;
+
+  StatusOr<IoRing::File> file = llfs::open_ioring_file(file_path, file_options);
+
+  EXPECT_EQ(file.status(), batt::StatusCode::kInvalidArgument);
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 TEST(IoRingTest, StartStopWorkCount)
@@ -275,6 +419,379 @@ TEST(IoRingTest, EnqueueManyHandlers)
   }
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(IoRingTest, SlowHandlersSpreadAcrossThreads)
+{
+  constexpr usize kNumThreads = 4;
+  constexpr usize kNumHandlers = 64;
+
+  if (std::thread::hardware_concurrency() < 2) {
+    GTEST_SKIP() << "Completions are not sharded on a single CPU";
+  }
+
+  StatusOr<IoRing> io = IoRing::make_new(llfs::MaxQueueDepth{kNumHandlers});
+  ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+
+  io->on_work_started();
+
+  std::mutex mutex;
+  std::set<std::thread::id> handler_threads;
+  std::atomic<usize> counter{0};
+
+  for (usize i = 0; i < kNumHandlers; ++i) {
+    io->post([&](llfs::StatusOr<i32>) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      {
+        std::unique_lock<std::mutex> lock{mutex};
+        handler_threads.insert(std::this_thread::get_id());
+      }
+      counter++;
+    });
+  }
+
+  std::vector<std::thread> helper_threads;
+  for (usize i = 0; i < kNumThreads; ++i) {
+    helper_threads.emplace_back([&io] {
+      io->run().IgnoreError();
+    });
+  }
+
+  io->on_work_finished();
+
+  for (std::thread& t : helper_threads) {
+    t.join();
+  }
+
+  EXPECT_EQ(counter, kNumHandlers);
+  EXPECT_GT(handler_threads.size(), 1u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(IoRingTest, BatchedSubmission)
+{
+  constexpr usize kBatchSize = 16;
+  constexpr usize kNumHandlers = 100;
+
+  StatusOr<IoRing> io = IoRing::make_new(llfs::IoRingOptions::with_default_values()  //
+                                             .set_queue_depth(llfs::MaxQueueDepth{64})
+                                             .set_submit_batch_size(kBatchSize));
+  ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+
+  io->on_work_started();
+
+  std::atomic<usize> counter{0};
+
+  for (usize i = 0; i < kNumHandlers; ++i) {
+    io->post([&counter](llfs::StatusOr<i32>) {
+      counter++;
+    });
+  }
+
+  // Only full batches have been submitted so far.
+  //
+  EXPECT_DOUBLE_EQ(io->average_submit_batch_size(), double(kBatchSize));
+
+  Status status = batt::StatusCode::kUnknown;
+  std::thread helper_thread{[&io, &status] {
+    status = io->run();
+  }};
+
+  io->on_work_finished();
+  helper_thread.join();
+
+  EXPECT_TRUE(status.ok()) << BATT_INSPECT(status);
+  EXPECT_EQ(counter, kNumHandlers);
+
+  // The remainder is flushed by the run loop before it blocks.
+  //
+  const usize expected_submits = (kNumHandlers + kBatchSize - 1) / kBatchSize;
+
+  EXPECT_DOUBLE_EQ(io->average_submit_batch_size(), double(kNumHandlers) / expected_submits);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(IoRingTest, QueueMetrics)
+{
+  constexpr usize kNumHandlers = 100;
+
+  // Time every operation.
+  //
+  ASSERT_EQ(::setenv("LLFS_IORING_METRICS_SAMPLE_RATE", "1", /*overwrite=*/1), 0);
+  StatusOr<IoRing> io = IoRing::make_new(llfs::MaxQueueDepth{64});
+  ::unsetenv("LLFS_IORING_METRICS_SAMPLE_RATE");
+  ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+
+  io->on_work_started();
+
+  std::atomic<usize> counter{0};
+
+  for (usize i = 0; i < kNumHandlers; ++i) {
+    io->post([&counter](llfs::StatusOr<i32>) {
+      counter++;
+    });
+  }
+
+  Status status = batt::StatusCode::kUnknown;
+  std::thread helper_thread{[&io, &status] {
+    status = io->run();
+  }};
+
+  io->on_work_finished();
+  helper_thread.join();
+
+  EXPECT_TRUE(status.ok()) << BATT_INSPECT(status);
+  EXPECT_EQ(counter, kNumHandlers);
+
+  const llfs::IoRingImpl::Metrics& metrics = io->queue_metrics(0);
+
+  // Without submit batching, each post is submitted on its own.
+  //
+  EXPECT_EQ(metrics.submit_call_count.load(), kNumHandlers);
+  EXPECT_EQ(metrics.sq_ready_total.load(), kNumHandlers);
+  EXPECT_EQ(metrics.sq_ready_max.load(), 1u);
+  EXPECT_EQ(metrics.sq_full_count.load(), 0u);
+
+  EXPECT_GT(metrics.reap_count.load(), 0u);
+  EXPECT_GE(metrics.cq_ready_max.load(), 1u);
+
+  // Posted handlers are nops.
+  //
+  using OpKind = llfs::IoRingImpl::Metrics::OpKind;
+
+  EXPECT_EQ(metrics.op_latency[OpKind::kOther].latency().count.load(), kNumHandlers);
+  EXPECT_EQ(metrics.op_latency[OpKind::kRead].latency().count.load(), 0u);
+  EXPECT_EQ(metrics.op_latency[OpKind::kWrite].latency().count.load(), 0u);
+  EXPECT_EQ(metrics.dispatch_latency.latency().count.load(), kNumHandlers);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(IoRingTest, AsyncSleep)
+{
+  constexpr auto kDelay = std::chrono::milliseconds(20);
+
+  StatusOr<IoRing> io = IoRing::make_new(llfs::MaxQueueDepth{64});
+  ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+
+  llfs::StatusOr<i32> sleep_result = batt::StatusCode::kUnknown;
+  std::chrono::steady_clock::duration elapsed{0};
+
+  const auto start_time = std::chrono::steady_clock::now();
+
+  io->async_sleep(kDelay, [&](llfs::StatusOr<i32> result) {
+    elapsed = std::chrono::steady_clock::now() - start_time;
+    sleep_result = result;
+  });
+
+  Status status = io->run();
+
+  EXPECT_TRUE(status.ok()) << BATT_INSPECT(status);
+  ASSERT_TRUE(sleep_result.ok()) << BATT_INSPECT(sleep_result.status());
+  EXPECT_EQ(*sleep_result, 0);
+  EXPECT_GE(elapsed, kDelay);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(IoRingTest, AsyncFdatasync)
+{
+  StatusOr<IoRing> io = IoRing::make_new(llfs::MaxQueueDepth{64});
+  ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+
+  const auto file_path = "/tmp/llfs_ioring_fdatasync_test_file";
+
+  int fd = open(file_path, O_CREAT | O_TRUNC | O_RDWR, /*mode=*/0644);
+  ASSERT_GE(fd, 0) << std::strerror(errno);
+
+  IoRing::File f{*io, fd};
+  f.set_raw_io(false);
+
+  const std::string message = "Durable data.";
+
+  llfs::StatusOr<i32> write_result = batt::StatusCode::kUnknown;
+  llfs::StatusOr<i32> sync_result = batt::StatusCode::kUnknown;
+
+  f.async_write_some(/*offset=*/0, ConstBuffer{message.data(), message.size()},
+                     [&](llfs::StatusOr<i32> result) {
+                       write_result = result;
+                       f.async_fdatasync([&](llfs::StatusOr<i32> result) {
+                         sync_result = result;
+                       });
+                     });
+
+  Status status = io->run();
+
+  EXPECT_TRUE(status.ok()) << BATT_INSPECT(status);
+  ASSERT_TRUE(write_result.ok()) << BATT_INSPECT(write_result.status());
+  EXPECT_EQ(*write_result, (i32)message.size());
+  ASSERT_TRUE(sync_result.ok()) << BATT_INSPECT(sync_result.status());
+  EXPECT_EQ(*sync_result, 0);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(IoRingTest, AsyncWriteSomeDurable)
+{
+  StatusOr<IoRing> io = IoRing::make_new(llfs::MaxQueueDepth{64});
+  ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+
+  const auto file_path = "/tmp/llfs_ioring_write_durable_test_file";
+
+  int fd = open(file_path, O_CREAT | O_TRUNC | O_RDWR, /*mode=*/0644);
+  ASSERT_GE(fd, 0) << std::strerror(errno);
+
+  IoRing::File f{*io, fd};
+  f.set_raw_io(false);
+
+  const std::string message = "Durable data, in one chain.";
+
+  llfs::StatusOr<i32> fallocate_result = batt::StatusCode::kUnknown;
+  llfs::StatusOr<i32> write_result = batt::StatusCode::kUnknown;
+  llfs::StatusOr<i32> fsync_result = batt::StatusCode::kUnknown;
+  int write_handler_count = 0;
+
+  f.async_fallocate(/*mode=*/0, /*offset=*/0, /*length=*/4096, [&](llfs::StatusOr<i32> result) {
+    fallocate_result = result;
+    f.async_write_some_durable(/*offset=*/0, ConstBuffer{message.data(), message.size()},
+                               [&](llfs::StatusOr<i32> result) {
+                                 ++write_handler_count;
+                                 write_result = result;
+                                 f.async_fsync([&](llfs::StatusOr<i32> result) {
+                                   fsync_result = result;
+                                 });
+                               });
+  });
+
+  Status status = io->run();
+
+  EXPECT_TRUE(status.ok()) << BATT_INSPECT(status);
+  ASSERT_TRUE(fallocate_result.ok()) << BATT_INSPECT(fallocate_result.status());
+  EXPECT_EQ(write_handler_count, 1);
+  ASSERT_TRUE(write_result.ok()) << BATT_INSPECT(write_result.status());
+  EXPECT_EQ(*write_result, (i32)message.size());
+  ASSERT_TRUE(fsync_result.ok()) << BATT_INSPECT(fsync_result.status());
+  EXPECT_EQ(*fsync_result, 0);
+
+  struct stat file_stat;
+  ASSERT_EQ(fstat(fd, &file_stat), 0) << std::strerror(errno);
+  EXPECT_GE(file_stat.st_size, 4096);
+
+  std::string data(message.size(), '\0');
+  ASSERT_EQ(pread(fd, data.data(), data.size(), /*offset=*/0), (ssize_t)data.size());
+  EXPECT_EQ(data, message);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(IoRingTest, ReadWithTimeout)
+{
+  constexpr auto kTimeout = std::chrono::milliseconds(20);
+
+  StatusOr<IoRing> io = IoRing::make_new(llfs::MaxQueueDepth{64});
+  ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+
+  // Reads from an empty pipe block until data is written, so they are a reliable way to get an
+  // operation that is stuck.
+  //
+  int pipe_fds[2];
+  ASSERT_EQ(pipe(pipe_fds), 0) << std::strerror(errno);
+
+  IoRing::File f{*io, pipe_fds[0]};
+  f.set_raw_io(false);
+
+  std::array<char, 64> buffer;
+
+  llfs::StatusOr<i32> timed_out_result = batt::StatusCode::kUnknown;
+  std::chrono::steady_clock::duration elapsed{0};
+
+  const auto start_time = std::chrono::steady_clock::now();
+
+  f.async_read_some_with_timeout(/*offset=*/-1, MutableBuffer{buffer.data(), buffer.size()},
+                                 kTimeout, [&](llfs::StatusOr<i32> result) {
+                                   elapsed = std::chrono::steady_clock::now() - start_time;
+                                   timed_out_result = result;
+                                 });
+
+  Status status = io->run();
+
+  EXPECT_TRUE(status.ok()) << BATT_INSPECT(status);
+  EXPECT_EQ(timed_out_result.status(), batt::StatusCode::kDeadlineExceeded);
+  EXPECT_GE(elapsed, kTimeout);
+
+  // Once there is data, a read with a (generous) timeout succeeds normally.
+  //
+  const std::string message = "in time";
+  ASSERT_EQ(write(pipe_fds[1], message.data(), message.size()), (ssize_t)message.size());
+
+  llfs::StatusOr<i32> read_result = batt::StatusCode::kUnknown;
+
+  io->reset();
+  f.async_read_some_with_timeout(/*offset=*/-1, MutableBuffer{buffer.data(), buffer.size()},
+                                 std::chrono::seconds(10), [&](llfs::StatusOr<i32> result) {
+                                   read_result = result;
+                                 });
+
+  status = io->run();
+
+  EXPECT_TRUE(status.ok()) << BATT_INSPECT(status);
+  ASSERT_TRUE(read_result.ok()) << BATT_INSPECT(read_result.status());
+  EXPECT_EQ(std::string(buffer.data(), *read_result), message);
+
+  close(pipe_fds[1]);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(IoRingTest, CancelAll)
+{
+  StatusOr<IoRing> io = IoRing::make_new(llfs::MaxQueueDepth{64});
+  ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+
+  int pipe_fds[2];
+  ASSERT_EQ(pipe(pipe_fds), 0) << std::strerror(errno);
+
+  IoRing::File f{*io, pipe_fds[0]};
+  f.set_raw_io(false);
+
+  std::array<char, 64> buffer;
+
+  llfs::StatusOr<i32> read_result = batt::StatusCode::kUnknown;
+  llfs::StatusOr<i32> cancel_result = batt::StatusCode::kUnknown;
+
+  f.async_read_some(/*offset=*/-1, MutableBuffer{buffer.data(), buffer.size()},
+                    [&](llfs::StatusOr<i32> result) {
+                      read_result = result;
+                    });
+
+  // Give the read a chance to start (and block) before cancelling it.
+  //
+  io->async_sleep(std::chrono::milliseconds(10), [&](llfs::StatusOr<i32>) {
+    f.async_cancel_all([&](llfs::StatusOr<i32> result) {
+      cancel_result = result;
+    });
+  });
+
+  Status status = io->run();
+
+  EXPECT_TRUE(status.ok()) << BATT_INSPECT(status);
+
+  if (cancel_result.status() == batt::status_from_errno(EINVAL)) {
+    close(pipe_fds[1]);
+    GTEST_SKIP() << "The kernel does not support IORING_ASYNC_CANCEL_FD";
+  }
+
+  ASSERT_TRUE(cancel_result.ok()) << BATT_INSPECT(cancel_result.status());
+  EXPECT_EQ(*cancel_result, 1);
+  EXPECT_THAT(read_result.status(),
+              ::testing::AnyOf(::testing::Eq(batt::status_from_errno(ECANCELED)),
+                               ::testing::Eq(batt::status_from_errno(EINTR))));
+
+  close(pipe_fds[1]);
+}
+
 #ifdef BATT_PLATFORM_IS_LINUX
 //
 // Only compile/run this test on Linux because of the specific errno value it assumes (EBADF).
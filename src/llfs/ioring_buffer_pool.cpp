@@ -43,6 +43,17 @@ namespace llfs {
 {
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ IoRingBufferPool::IoRingBufferPool(const IoRing& io_ring, BufferCount count,
+                                                BufferSize size, CarvedUnits&& units) noexcept
+    : io_ring_{io_ring}
+    , buffer_count_{count}
+    , buffer_size_{size}
+    , storage_{std::move(units)}
+{
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 /*explicit*/ IoRingBufferPool::IoRingBufferPool(BufferVec&& borrowed_buffers) noexcept
@@ -152,6 +163,17 @@ batt::Status IoRingBufferPool::initialize() noexcept
         BATT_CHECK_EQ(borrowed.size(), this->buffer_count_);
         BATT_CHECK_EQ(borrowed.front().size(), this->buffer_size_);
 
+        return batt::OkStatus();
+      },
+
+      //----- --- -- -  -  -   -
+      [this](CarvedUnits& carved) -> batt::Status {
+        BATT_CHECK_GE(carved.size() * this->buffers_per_memory_unit_, this->buffer_count_);
+        for (Registered* p_registered : carved) {
+          BATT_CHECK_NOT_NULLPTR(p_registered);
+          BATT_CHECK_GE(p_registered->io_ring_index_, 0);
+        }
+
         return batt::OkStatus();
       });
 }
@@ -324,37 +346,50 @@ usize IoRingBufferPool::available() noexcept
 
   BATT_CHECK_LT(array_index_of_this, this->pool_->objects_.size()) << "Pool/object mismatch?";
 
+  // Carves this object's buffer out of the given registered memory unit (`registered_storage` may
+  // be a vector of unique_ptr or of raw pointers).
+  //
+  const auto init_from_memory_unit = [&](auto& registered_storage) {
+    // Find the registered memory that backs this object.
+    //
+    const isize memory_unit_i = array_index_of_this / this->pool_->buffers_per_memory_unit_;
+    Registered& registered = *registered_storage[memory_unit_i];
+
+    // Each memory unit (Registered buffer) can hold many user-visible buffers; figure out which
+    // one within the memory unit corresponds to `this`, and calculate the data offset based on
+    // that.
+    //
+    const isize index_within_unit = array_index_of_this % this->pool_->buffers_per_memory_unit_;
+    const isize offset_within_unit = index_within_unit * this->pool_->buffer_size_;
+    u8* const data_start = (u8*)(&registered.memory_) + offset_within_unit;
+
+    // Dump our calculations for debugging.
+    //
+    LLFS_DVLOG(1) << BATT_INSPECT(sizeof(ObjectStorage))           //
+                  << BATT_INSPECT(byte_offset_of_this_in_objects)  //
+                  << BATT_INSPECT(array_index_of_this)             //
+                  << BATT_INSPECT(memory_unit_i)                   //
+                  << BATT_INSPECT(index_within_unit)               //
+                  << BATT_INSPECT(offset_within_unit)              //
+                  << BATT_INSPECT(this->pool_->buffer_size_);
+
+    this->io_ring_index_ = registered.io_ring_index_;
+    this->buffer_ = batt::MutableBuffer{data_start, this->pool_->buffer_size_};
+  };
+
   batt::case_of(
       pool->storage_,
 
       //----- --- -- -  -  -   -
       [&](std::vector<std::unique_ptr<Registered>>& registered_storage)  //
       {
-        // Find the registered memory that backs this object.
-        //
-        const isize memory_unit_i = array_index_of_this / this->pool_->buffers_per_memory_unit_;
-        Registered& registered = *registered_storage[memory_unit_i];
-
-        // Each memory unit (Registered buffer) can hold many user-visible buffers; figure out which
-        // one within the memory unit corresponds to `this`, and calculate the data offset based on
-        // that.
-        //
-        const isize index_within_unit = array_index_of_this % this->pool_->buffers_per_memory_unit_;
-        const isize offset_within_unit = index_within_unit * this->pool_->buffer_size_;
-        u8* const data_start = (u8*)(&registered.memory_) + offset_within_unit;
-
-        // Dump our calculations for debugging.
-        //
-        LLFS_DVLOG(1) << BATT_INSPECT(sizeof(ObjectStorage))           //
-                      << BATT_INSPECT(byte_offset_of_this_in_objects)  //
-                      << BATT_INSPECT(array_index_of_this)             //
-                      << BATT_INSPECT(memory_unit_i)                   //
-                      << BATT_INSPECT(index_within_unit)               //
-                      << BATT_INSPECT(offset_within_unit)              //
-                      << BATT_INSPECT(this->pool_->buffer_size_);
-
-        this->io_ring_index_ = registered.io_ring_index_;
-        this->buffer_ = batt::MutableBuffer{data_start, this->pool_->buffer_size_};
+        init_from_memory_unit(registered_storage);
+      },
+
+      //----- --- -- -  -  -   -
+      [&](CarvedUnits& carved)  //
+      {
+        init_from_memory_unit(carved);
       },
 
       //----- --- -- -  -  -   -
@@ -30,6 +30,8 @@
 
 namespace llfs {
 
+class IoRingMultiSizeBufferPool;
+
 /** \brief An asychronous pool of buffers registered with an IoRing for fast I/O.
  *
  * Must be created via static IoRingBufferPool::make_new function.
@@ -248,6 +250,11 @@ class IoRingBufferPool
                                                      boost::intrusive::cache_last<true>,  //
                                                      boost::intrusive::constant_time_size<true>>;
 
+  /** \brief Memory units that are owned (and have already been registered with the IoRing) by some
+   * other object; see IoRingMultiSizeBufferPool.
+   */
+  using CarvedUnits = std::vector<Registered*>;
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   /** \brief Constructs, initializes, and returns a new IoRingBufferPool.
@@ -348,6 +355,8 @@ class IoRingBufferPool
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
  private:
+  friend class IoRingMultiSizeBufferPool;
+
   /** \brief Stash the passed pool pointer in thread-local storage; this is a hack used when freeing
    * a buffer to avoid relying on undefined behavior re: overlapped object lifetimes using the same
    * memory.
@@ -359,6 +368,12 @@ class IoRingBufferPool
   explicit IoRingBufferPool(const IoRing& io_ring, BufferCount count,
                             BufferSize size = BufferSize{Self::kMemoryUnitSize}) noexcept;
 
+  /** \brief Constructs a pool whose buffers are carved out of the given memory units (which must
+   * outlive the pool); used by IoRingMultiSizeBufferPool.
+   */
+  explicit IoRingBufferPool(const IoRing& io_ring, BufferCount count, BufferSize size,
+                            CarvedUnits&& units) noexcept;
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   /** \brief Called once inside make_new; registers the buffers with the IoRing.
@@ -403,9 +418,9 @@ class IoRingBufferPool
    */
   const usize buffers_per_memory_unit_ = Self::kMemoryUnitSize / this->buffer_size_;
 
-  /** \brief The registered/borrowed memory units.
+  /** \brief The registered/borrowed/carved memory units.
    */
-  std::variant<std::vector<std::unique_ptr<Registered>>, BufferVec> storage_;
+  std::variant<std::vector<std::unique_ptr<Registered>>, BufferVec, CarvedUnits> storage_;
 
   /** \brief Memory for the per-buffer tracking objects; each `ObjectStorage` can be constructed as
    * an instance of either the `Deallocated` or `Allocated` class.
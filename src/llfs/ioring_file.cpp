@@ -133,6 +133,47 @@ Status IoRing::File::read_all_fixed(i64 offset, MutableBuffer buffer, int buf_in
   return batt::OkStatus();
 }
 
+#if LLFS_HAS_COROUTINES
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+coro::Task<Status> IoRing::File::co_read_all(i64 offset, MutableBuffer buffer)
+{
+  while (buffer.size() != 0) {
+    StatusOr<i32> n_read = co_await this->co_read_some(offset, buffer);
+    if (!n_read.ok()) {
+      co_return n_read.status();
+    }
+    if (*n_read == 0) {
+      co_return batt::StatusCode::kOutOfRange;
+    }
+    offset += *n_read;
+    buffer += *n_read;
+  }
+  co_return batt::OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+coro::Task<Status> IoRing::File::co_write_all(i64 offset, ConstBuffer buffer)
+{
+  while (buffer.size() != 0) {
+    if (this->raw_io_) {
+      BATT_CHECK_EQ(batt::round_down_bits(Self::kBlockAlignmentLog2, offset), offset);
+      BATT_CHECK_EQ(batt::round_down_bits(Self::kBlockAlignmentLog2, buffer.size()), buffer.size());
+    }
+    StatusOr<i32> n_written = co_await this->co_write_some(offset, buffer);
+    if (!n_written.ok()) {
+      co_return n_written.status();
+    }
+    offset += *n_written;
+    buffer += *n_written;
+  }
+  co_return batt::OkStatus();
+}
+
+#endif  // LLFS_HAS_COROUTINES
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 int IoRing::File::release()
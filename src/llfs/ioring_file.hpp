@@ -14,8 +14,11 @@
 
 #ifndef LLFS_DISABLE_IO_URING
 
+#include <llfs/coro.hpp>
 #include <llfs/ioring.hpp>
 
+#include <cstring>
+
 namespace llfs {
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
@@ -81,6 +84,15 @@ class IoRing::File
   void async_read_some_fixed(i64 offset, const MutableBuffer& buffer, int buf_index,
                              Handler&& handler);
 
+  // Asynchronously reads up to `length` bytes from the file starting at the given offset, into a
+  // buffer chosen by the kernel (when the data arrives) from the provided buffer ring for
+  // `group_id` (see IoRingProvidedBufferRing).  Invokes `handler` from within `IoRing::run()` with
+  // error status or the number of bytes successfully read; the handler must call
+  // `IoRingImpl::current_completion_buffer_id()` to find out which buffer holds the data.
+  //
+  template <typename Handler = void(StatusOr<i32>)>
+  void async_read_some_select(i64 offset, usize length, u16 group_id, Handler&& handler);
+
   // Asynchronously writes the contents of `buffers` to the file starting at the given offset.
   // Invokes `handler` from within `IoRing::run()` with error status or the number of bytes
   // successfully written.
@@ -106,6 +118,75 @@ class IoRing::File
   void async_write_some_fixed(i64 offset, const ConstBuffer& buffer, int buf_index,
                               Handler&& handler);
 
+  // Asynchronously flushes all completed writes to this file to durable storage, without
+  // necessarily flushing metadata that isn't needed to read the data back (i.e., fdatasync).
+  // Invokes `handler` from within `IoRing::run()` with error status or 0 on success.
+  //
+  // NOTE: this only covers writes that have _completed_ before the sync is submitted; writes that
+  // are still in flight may or may not be included.
+  //
+  template <typename Handler = void(StatusOr<i32>)>
+  void async_fdatasync(Handler&& handler);
+
+  // Like `async_fdatasync`, but also flushes all file metadata (i.e., fsync).
+  //
+  template <typename Handler = void(StatusOr<i32>)>
+  void async_fsync(Handler&& handler);
+
+  // Asynchronously allocates (or, depending on `mode`, deallocates) disk space for the given byte
+  // range of the file; see fallocate(2).  Invokes `handler` from within `IoRing::run()` with error
+  // status or 0 on success.
+  //
+  template <typename Handler = void(StatusOr<i32>)>
+  void async_fallocate(int mode, i64 offset, i64 length, Handler&& handler);
+
+  // Asynchronously writes the contents of `buffer` to the file starting at the given offset, then
+  // flushes it to durable storage (as with `async_fdatasync`), submitting both as a single linked
+  // chain so that the sync starts as soon as the write completes, without a round trip through
+  // `IoRing::run()`.  Invokes `handler` (once) with error status or the number of bytes written,
+  // when both operations have completed.
+  //
+  // If the write is short, the sync is cancelled and `handler` is passed ECANCELED; a short write
+  // is not durable.
+  //
+  template <typename Handler = void(StatusOr<i32>)>
+  void async_write_some_durable(i64 offset, const ConstBuffer& buffer, Handler&& handler);
+
+  // Like `async_read_some(offset, buffer, handler)`, but if the read hasn't completed within
+  // `timeout`, it is cancelled and `handler` is passed batt::StatusCode::kDeadlineExceeded.
+  //
+  template <typename Handler = void(StatusOr<i32>)>
+  void async_read_some_with_timeout(i64 offset, const MutableBuffer& buffer,
+                                    std::chrono::nanoseconds timeout, Handler&& handler);
+
+  // Like `async_write_some(offset, buffer, handler)`, but if the write hasn't completed within
+  // `timeout`, it is cancelled and `handler` is passed batt::StatusCode::kDeadlineExceeded.
+  //
+  // NOTE: a cancelled write may have been partially applied.
+  //
+  template <typename Handler = void(StatusOr<i32>)>
+  void async_write_some_with_timeout(i64 offset, const ConstBuffer& buffer,
+                                     std::chrono::nanoseconds timeout, Handler&& handler);
+
+  // Asynchronously cancels all in-flight operations on this file (without closing it).  Each
+  // cancelled operation's handler is passed ECANCELED (or, if it was already running and could
+  // not be stopped, its normal result).  Invokes `handler` with the number of operations
+  // cancelled.
+  //
+  template <typename Handler = void(StatusOr<i32>)>
+  void async_cancel_all(Handler&& handler);
+
+  // Asynchronously issues a driver-specific passthrough command (IORING_OP_URING_CMD) to this
+  // file; `cmd_op` and the `cmd_size` bytes at `cmd` are interpreted by the driver (e.g. an NVMe
+  // generic char device, /dev/ngXnY).  Invokes `handler` with error status or the (non-negative)
+  // result of the command.
+  //
+  // Commands larger than 16 bytes require an IoRing created with IoRingOptions::big_entries; the
+  // command is copied into the submission queue entry, so `cmd` need not outlive this call.
+  //
+  template <typename Handler = void(StatusOr<i32>)>
+  void async_uring_cmd(u32 cmd_op, const void* cmd, usize cmd_size, Handler&& handler);
+
   // Writes the entire contents of `buffer` to the file at the given byte `offset`.  Blocking
   // call (using batt::Task::await).
   //
@@ -123,6 +204,31 @@ class IoRing::File
 
   Status read_all_fixed(i64 offset, MutableBuffer buffer, int buf_index);
 
+#if LLFS_HAS_COROUTINES
+  // Coroutine versions of `async_read_some`/`async_write_some`: `co_await file.co_read_some(...)`
+  // yields error status or the number of bytes transferred.
+  //
+  auto co_read_some(i64 offset, const MutableBuffer& buffer)
+  {
+    return coro::async_op<StatusOr<i32>>([this, offset, buffer](auto&& handler) {
+      this->async_read_some(offset, buffer, BATT_FORWARD(handler));
+    });
+  }
+
+  auto co_write_some(i64 offset, const ConstBuffer& buffer)
+  {
+    return coro::async_op<StatusOr<i32>>([this, offset, buffer](auto&& handler) {
+      this->async_write_some(offset, buffer, BATT_FORWARD(handler));
+    });
+  }
+
+  // Coroutine versions of `read_all`/`write_all`.
+  //
+  coro::Task<Status> co_read_all(i64 offset, MutableBuffer buffer);
+
+  coro::Task<Status> co_write_all(i64 offset, ConstBuffer buffer);
+#endif  // LLFS_HAS_COROUTINES
+
   // Releases ownership of the underlying file descriptor (fd), returning the previously owned
   // value.
   //
@@ -232,6 +338,26 @@ inline void IoRing::File::async_read_some_fixed(i64 offset, const MutableBuffer&
       });
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename Handler>
+inline void IoRing::File::async_read_some_select(i64 offset, usize length, u16 group_id,
+                                                 Handler&& handler)
+{
+  this->io_ring_->submit(
+      no_buffers(), BATT_FORWARD(handler),
+      [offset, length, group_id, this](struct io_uring_sqe* sqe, auto& /*op*/) {
+        if (this->registered_fd_ == -1) {
+          io_uring_prep_read(sqe, this->fd_, /*buf=*/nullptr, length, offset);
+        } else {
+          io_uring_prep_read(sqe, this->registered_fd_, /*buf=*/nullptr, length, offset);
+          sqe->flags |= IOSQE_FIXED_FILE;
+        }
+        sqe->flags |= IOSQE_BUFFER_SELECT;
+        sqe->buf_group = group_id;
+      });
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 template <typename ConstBufferSequence, typename Handler, typename>
@@ -291,6 +417,207 @@ inline void IoRing::File::async_write_some_fixed(i64 offset, const ConstBuffer&
       });
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename Handler>
+inline void IoRing::File::async_fdatasync(Handler&& handler)
+{
+  static const std::vector<ConstBuffer> empty;
+
+  this->io_ring_->submit(empty, BATT_FORWARD(handler),
+                         [this](struct io_uring_sqe* sqe, auto& /*op*/) {
+                           if (this->registered_fd_ == -1) {
+                             io_uring_prep_fsync(sqe, this->fd_, IORING_FSYNC_DATASYNC);
+                           } else {
+                             io_uring_prep_fsync(sqe, this->registered_fd_, IORING_FSYNC_DATASYNC);
+                             sqe->flags |= IOSQE_FIXED_FILE;
+                           }
+                         });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename Handler>
+inline void IoRing::File::async_fsync(Handler&& handler)
+{
+  static const std::vector<ConstBuffer> empty;
+
+  this->io_ring_->submit(empty, BATT_FORWARD(handler),
+                         [this](struct io_uring_sqe* sqe, auto& /*op*/) {
+                           if (this->registered_fd_ == -1) {
+                             io_uring_prep_fsync(sqe, this->fd_, /*fsync_flags=*/0);
+                           } else {
+                             io_uring_prep_fsync(sqe, this->registered_fd_, /*fsync_flags=*/0);
+                             sqe->flags |= IOSQE_FIXED_FILE;
+                           }
+                         });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename Handler>
+inline void IoRing::File::async_fallocate(int mode, i64 offset, i64 length, Handler&& handler)
+{
+  static const std::vector<ConstBuffer> empty;
+
+  this->io_ring_->submit(
+      empty, BATT_FORWARD(handler),
+      [mode, offset, length, this](struct io_uring_sqe* sqe, auto& /*op*/) {
+        if (this->registered_fd_ == -1) {
+          io_uring_prep_fallocate(sqe, this->fd_, mode, offset, length);
+        } else {
+          io_uring_prep_fallocate(sqe, this->registered_fd_, mode, offset, length);
+          sqe->flags |= IOSQE_FIXED_FILE;
+        }
+      });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename Handler>
+inline void IoRing::File::async_write_some_durable(i64 offset, const ConstBuffer& buffer,
+                                                   Handler&& handler)
+{
+  static const std::vector<ConstBuffer> empty;
+
+  // The two completion handlers may run on different threads, in either order; whichever runs
+  // second invokes the caller's handler.
+  //
+  struct State {
+    explicit State(Handler&& caller_handler) noexcept : handler{BATT_FORWARD(caller_handler)}
+    {
+    }
+
+    void finish()
+    {
+      if (this->n_pending.fetch_sub(1) != 1) {
+        return;
+      }
+      // The sync result only matters if the write succeeded.
+      //
+      if (this->write_result.ok() && !this->sync_result.ok()) {
+        this->handler(this->sync_result.status());
+      } else {
+        this->handler(std::move(this->write_result));
+      }
+    }
+
+    std::decay_t<Handler> handler;
+    StatusOr<i32> write_result{batt::StatusCode::kUnknown};
+    StatusOr<i32> sync_result{batt::StatusCode::kUnknown};
+    std::atomic<int> n_pending{2};
+  };
+
+  auto state = std::make_shared<State>(BATT_FORWARD(handler));
+
+  this->io_ring_->submit_linked(
+      empty,
+      [state](StatusOr<i32> result) {
+        state->write_result = std::move(result);
+        state->finish();
+      },
+      [&buffer, offset, this](struct io_uring_sqe* sqe, auto& /*op*/) {
+        if (this->registered_fd_ == -1) {
+          io_uring_prep_write(sqe, this->fd_, buffer.data(), buffer.size(), offset);
+        } else {
+          io_uring_prep_write(sqe, this->registered_fd_, buffer.data(), buffer.size(), offset);
+          sqe->flags |= IOSQE_FIXED_FILE;
+        }
+      },
+      [state](StatusOr<i32> result) {
+        state->sync_result = std::move(result);
+        state->finish();
+      },
+      [this](struct io_uring_sqe* sqe, auto& /*op*/) {
+        if (this->registered_fd_ == -1) {
+          io_uring_prep_fsync(sqe, this->fd_, IORING_FSYNC_DATASYNC);
+        } else {
+          io_uring_prep_fsync(sqe, this->registered_fd_, IORING_FSYNC_DATASYNC);
+          sqe->flags |= IOSQE_FIXED_FILE;
+        }
+      });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename Handler>
+inline void IoRing::File::async_read_some_with_timeout(i64 offset, const MutableBuffer& buffer,
+                                                       std::chrono::nanoseconds timeout,
+                                                       Handler&& handler)
+{
+  this->io_ring_->submit_with_timeout(
+      no_buffers(), timeout, BATT_FORWARD(handler),
+      [&buffer, offset, this](struct io_uring_sqe* sqe, auto& /*op*/) {
+        if (this->registered_fd_ == -1) {
+          io_uring_prep_read(sqe, this->fd_, buffer.data(), buffer.size(), offset);
+        } else {
+          io_uring_prep_read(sqe, this->registered_fd_, buffer.data(), buffer.size(), offset);
+          sqe->flags |= IOSQE_FIXED_FILE;
+        }
+      });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename Handler>
+inline void IoRing::File::async_write_some_with_timeout(i64 offset, const ConstBuffer& buffer,
+                                                        std::chrono::nanoseconds timeout,
+                                                        Handler&& handler)
+{
+  this->io_ring_->submit_with_timeout(
+      no_buffers(), timeout, BATT_FORWARD(handler),
+      [&buffer, offset, this](struct io_uring_sqe* sqe, auto& /*op*/) {
+        if (this->registered_fd_ == -1) {
+          io_uring_prep_write(sqe, this->fd_, buffer.data(), buffer.size(), offset);
+        } else {
+          io_uring_prep_write(sqe, this->registered_fd_, buffer.data(), buffer.size(), offset);
+          sqe->flags |= IOSQE_FIXED_FILE;
+        }
+      });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename Handler>
+inline void IoRing::File::async_cancel_all(Handler&& handler)
+{
+  if (this->registered_fd_ == -1) {
+    this->io_ring_->async_cancel_fd(this->fd_, /*fixed=*/false, BATT_FORWARD(handler));
+  } else {
+    this->io_ring_->async_cancel_fd(this->registered_fd_, /*fixed=*/true, BATT_FORWARD(handler));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename Handler>
+inline void IoRing::File::async_uring_cmd(u32 cmd_op, const void* cmd, usize cmd_size,
+                                          Handler&& handler)
+{
+  static const std::vector<ConstBuffer> empty;
+
+  // A regular SQE has 16 bytes of command payload; SQE128 extends it by another 64.
+  //
+  const usize max_cmd_size = this->io_ring_->options().big_entries() ? 80 : 16;
+  BATT_CHECK_LE(cmd_size, max_cmd_size);
+
+  this->io_ring_->submit(
+      empty, BATT_FORWARD(handler),
+      [cmd_op, cmd, cmd_size, max_cmd_size, this](struct io_uring_sqe* sqe, auto& /*op*/) {
+        const int fd = (this->registered_fd_ == -1) ? this->fd_ : this->registered_fd_;
+
+        io_uring_prep_rw(IORING_OP_URING_CMD, sqe, fd, /*addr=*/nullptr, /*len=*/0,
+                         /*offset=*/0);
+        sqe->cmd_op = cmd_op;
+        std::memset(sqe->cmd, 0, max_cmd_size);
+        std::memcpy(sqe->cmd, cmd, cmd_size);
+
+        if (this->registered_fd_ != -1) {
+          sqe->flags |= IOSQE_FIXED_FILE;
+        }
+      });
+}
+
 }  // namespace llfs
 
 #endif  // LLFS_DISABLE_IO_URING
@@ -13,6 +13,8 @@
 #include <llfs/ioring_file_runtime_options.hpp>
 //
 
+#include <llfs/logging.hpp>
+
 namespace llfs {
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -33,6 +35,12 @@ namespace llfs {
 StatusOr<IoRing::File> open_ioring_file(const std::string& file_name,
                                         const IoRingFileRuntimeOptions& file_options)
 {
+  if (file_options.io_ring.options().iopoll() && !file_options.use_raw_io) {
+    LLFS_LOG_ERROR() << "Files used with an IOPOLL IoRing must be opened with raw I/O (O_DIRECT)"
+                     << BATT_INSPECT_STR(file_name);
+    return {batt::StatusCode::kInvalidArgument};
+  }
+
   int flags = 0;
   {
     if (file_options.use_raw_io) {
@@ -22,11 +22,20 @@ struct IoRingFileRuntimeOptions {
   static IoRingFileRuntimeOptions with_default_values(const IoRing& io_ring);
 
   const IoRing& io_ring;
+
+  /** \brief Open files with O_DIRECT; this is required if `io_ring` was created with IOPOLL
+   * enabled (see IoRingOptions::iopoll).
+   */
   bool use_raw_io;
   bool allow_read;
   bool allow_write;
 };
 
+/** \brief Opens the named file for use with `file_options.io_ring`.
+ *
+ * Returns batt::StatusCode::kInvalidArgument if neither read nor write access is allowed, or if the
+ * IoRing polls for completions (IOPOLL) and `file_options.use_raw_io` is false.
+ */
 StatusOr<IoRing::File> open_ioring_file(const std::string& file_name,
                                         const IoRingFileRuntimeOptions& file_options);
 
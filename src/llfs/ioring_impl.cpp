@@ -12,11 +12,18 @@
 #ifndef LLFS_DISABLE_IO_URING
 
 #include <llfs/logging.hpp>
+#include <llfs/trace_span.hpp>
 
+#include <batteries/env.hpp>
 #include <batteries/finally.hpp>
+#include <batteries/stream_util.hpp>
 
 #include <sys/eventfd.h>
 
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
 namespace llfs {
 
 namespace {
@@ -42,16 +49,113 @@ StatusOr<i32> status_or_i32_from_uring_retval(int retval)
   return {retval};
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+/** \brief Per-thread state for IoRingImpl::begin_submit_batch/end_submit_batch.
+ */
+struct SubmitBatchState {
+  const IoRingImpl* impl = nullptr;
+  usize depth = 0;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+SubmitBatchState& this_thread_submit_batch()
+{
+  thread_local SubmitBatchState state;
+  return state;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+/** \brief The cqe flags of the completion handler currently being invoked by this thread (see
+ * IoRingImpl::current_completion_buffer_id).
+ */
+u32& this_thread_cqe_flags()
+{
+  thread_local u32 flags = 0;
+  return flags;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void clamp_min_metric(CountMetric<u64>& metric, u64 value)
+{
+  if (value > metric.load()) {
+    metric.set(value);
+  }
+}
+
 }  //namespace
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class IoRingImpl::Metrics
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ auto IoRingImpl::Metrics::op_kind_from_opcode(u8 opcode) noexcept -> OpKind
+{
+  switch (opcode) {
+    case IORING_OP_READV:
+    case IORING_OP_READ_FIXED:
+    case IORING_OP_READ:
+      return kRead;
+
+    case IORING_OP_WRITEV:
+    case IORING_OP_WRITE_FIXED:
+    case IORING_OP_WRITE:
+      return kWrite;
+
+    case IORING_OP_FSYNC:
+      return kFsync;
+
+    default:
+      break;
+  }
+  return kOther;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ const char* IoRingImpl::Metrics::op_kind_name(OpKind kind) noexcept
+{
+  switch (kind) {
+    case kRead:
+      return "read";
+    case kWrite:
+      return "write";
+    case kFsync:
+      return "fsync";
+    default:
+      break;
+  }
+  return "other";
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class IoRingImpl
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 /*static*/ auto IoRingImpl::make_new(MaxQueueDepth entries) noexcept
     -> StatusOr<std::unique_ptr<IoRingImpl>>
+{
+  return IoRingImpl::make_new(IoRingOptions::with_default_values().set_queue_depth(entries));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ auto IoRingImpl::make_new(const IoRingOptions& options) noexcept
+    -> StatusOr<std::unique_ptr<IoRingImpl>>
 {
   LLFS_VLOG(1) << "Creating new IoRingImpl";
   std::unique_ptr<IoRingImpl> impl{new IoRingImpl};
 
+  impl->completion_shards_ = std::vector<batt::CpuCacheLineIsolated<CompletionShard>>(
+      std::clamp<usize>(std::thread::hardware_concurrency(), 1, kMaxCompletionShards));
+
+  impl->options_ = options;
+  impl->metrics_.sampler.set_sample_rate(batt::getenv_as<u32>("LLFS_IORING_METRICS_SAMPLE_RATE")
+                                             .value_or(Metrics::kDefaultSampleRate));
+
   // Create the event_fd so we can wake the ioring completion event loop.
   {
     BATT_CHECK_EQ(impl->event_fd_, -1);
@@ -70,11 +174,34 @@ StatusOr<i32> status_or_i32_from_uring_retval(int retval)
   {
     BATT_CHECK(!impl->ring_init_);
 
-    LLFS_VLOG(1) << "Calling io_uring_queue_init(entries=" << entries << ")";
-    const int retval = io_uring_queue_init(entries, &impl->ring_, /*flags=*/0);
+    const usize entries = options.queue_depth();
+
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+
+    if (options.sqpoll()) {
+      params.flags |= IORING_SETUP_SQPOLL;
+      params.sq_thread_idle = options.sqpoll_idle_ms();
+      if (options.sqpoll_cpu()) {
+        params.flags |= IORING_SETUP_SQ_AFF;
+        params.sq_thread_cpu = *options.sqpoll_cpu();
+      }
+    }
+    if (options.iopoll()) {
+      params.flags |= IORING_SETUP_IOPOLL;
+    }
+    if (options.big_entries()) {
+      params.flags |= IORING_SETUP_SQE128 | IORING_SETUP_CQE32;
+    }
+
+    LLFS_VLOG(1) << "Calling io_uring_queue_init_params(entries=" << entries
+                 << ", sqpoll=" << options.sqpoll() << ", iopoll=" << options.iopoll()
+                 << ", big_entries=" << options.big_entries() << ")";
+    const int retval = io_uring_queue_init_params(entries, &impl->ring_, &params);
 
     BATT_REQUIRE_OK(status_from_uring_retval(retval))
-        << batt::LogLevel::kError << "failed io_uring_queue_init: " << std::strerror(-retval);
+        << batt::LogLevel::kError << "failed io_uring_queue_init_params: " << std::strerror(-retval)
+        << BATT_INSPECT(options.sqpoll()) << BATT_INSPECT(options.iopoll());
 
     impl->ring_init_ = true;
   }
@@ -90,11 +217,89 @@ StatusOr<i32> status_or_i32_from_uring_retval(int retval)
         << batt::LogLevel::kError << "failed io_uring_register_eventfd: " << std::strerror(-retval);
   }
 
+  impl->add_metrics_to_registry();
+
   LLFS_VLOG(1) << "IoRingImpl created";
 
   return {std::move(impl)};
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingImpl::add_metrics_to_registry()
+{
+  static std::atomic<usize> next_instance{0};
+
+  const usize instance = next_instance.fetch_add(1);
+  const auto metric_name = [instance](std::string_view property) {
+    return batt::to_string("IoRing_", instance, "_", property);
+  };
+
+#define ADD_METRIC_(n) global_metric_registry().add(metric_name(#n), this->metrics_.n)
+
+  ADD_METRIC_(submit_count);
+  ADD_METRIC_(submitted_op_count);
+  ADD_METRIC_(submit_call_count);
+  ADD_METRIC_(sq_ready_total);
+  ADD_METRIC_(sq_ready_max);
+  ADD_METRIC_(sq_full_count);
+  ADD_METRIC_(reap_count);
+  ADD_METRIC_(cq_ready_total);
+  ADD_METRIC_(cq_ready_max);
+  ADD_METRIC_(stashed_completion_count);
+  ADD_METRIC_(stolen_completion_count);
+
+#undef ADD_METRIC_
+
+  for (usize kind = 0; kind < Metrics::kNumOpKinds; ++kind) {
+    this->metrics_.op_latency[kind].add_to_registry(
+        global_metric_registry(),
+        metric_name(batt::to_string(Metrics::op_kind_name(Metrics::OpKind(kind)), "_latency")));
+  }
+  for (usize fd = 0; fd < Metrics::kMaxTrackedFds; ++fd) {
+    global_metric_registry().add(metric_name(batt::to_string("fd", fd, "_latency")),
+                                 this->metrics_.fixed_fd_latency[fd]);
+  }
+  this->metrics_.dispatch_latency.add_to_registry(global_metric_registry(),
+                                                  metric_name("dispatch_latency"));
+
+  this->metrics_registered_ = true;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingImpl::remove_metrics_from_registry()
+{
+  if (!this->metrics_registered_) {
+    return;
+  }
+  this->metrics_registered_ = false;
+
+  for (CountMetric<u64>* metric : {
+           &this->metrics_.submit_count,
+           &this->metrics_.submitted_op_count,
+           &this->metrics_.submit_call_count,
+           &this->metrics_.sq_ready_total,
+           &this->metrics_.sq_ready_max,
+           &this->metrics_.sq_full_count,
+           &this->metrics_.reap_count,
+           &this->metrics_.cq_ready_total,
+           &this->metrics_.cq_ready_max,
+           &this->metrics_.stashed_completion_count,
+           &this->metrics_.stolen_completion_count,
+       }) {
+    global_metric_registry().remove(*metric);
+  }
+
+  for (LatencyHistogram& histogram : this->metrics_.op_latency) {
+    histogram.remove_from_registry(global_metric_registry());
+  }
+  for (LatencyMetric& metric : this->metrics_.fixed_fd_latency) {
+    global_metric_registry().remove(metric);
+  }
+  this->metrics_.dispatch_latency.remove_from_registry(global_metric_registry());
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 bool IoRingImpl::is_valid() const noexcept
@@ -108,6 +313,8 @@ IoRingImpl::~IoRingImpl() noexcept
 {
   LLFS_DVLOG(1) << "IoRingImpl::~IoRingImpl()";
 
+  this->remove_metrics_from_registry();
+
   const bool prior_ring_init = this->ring_init_.exchange(false);
   LLFS_VLOG(1) << "Closing IoRing context: " << BATT_INSPECT(prior_ring_init);
   if (prior_ring_init) {
@@ -120,8 +327,10 @@ IoRingImpl::~IoRingImpl() noexcept
     ::close(prior_event_fd);
   }
 
-  batt::invoke_all_handlers(&this->completions_,  //
-                            StatusOr<i32>{::llfs::make_status(StatusCode::kIoRingShutDown)});
+  for (batt::CpuCacheLineIsolated<CompletionShard>& shard : this->completion_shards_) {
+    batt::invoke_all_handlers(&shard->completions,  //
+                              StatusOr<i32>{::llfs::make_status(StatusCode::kIoRingShutDown)});
+  }
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -150,6 +359,143 @@ bool IoRingImpl::can_run() const noexcept
   return this->work_count_ && !this->needs_reset_;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool IoRingImpl::begin_submit_batch() noexcept
+{
+  SubmitBatchState& state = this_thread_submit_batch();
+  if (state.impl != nullptr && state.impl != this) {
+    return false;
+  }
+  state.impl = this;
+  state.depth += 1;
+  return true;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingImpl::end_submit_batch() noexcept
+{
+  SubmitBatchState& state = this_thread_submit_batch();
+  BATT_CHECK_EQ(state.impl, this);
+  BATT_CHECK_GT(state.depth, 0u);
+
+  state.depth -= 1;
+  if (state.depth != 0) {
+    return;
+  }
+  state.impl = nullptr;
+
+  // Submit everything deferred during the batch with a single syscall.  Another thread may have
+  // already submitted our operations for us, so it's OK if nothing is submitted here.
+  //
+  auto lock = LLFS_PROFILE_LOCK_WAIT("IoRingImpl::ring_mutex_",
+                                     std::unique_lock<std::mutex>{this->ring_mutex_});
+  this->submit_with_lock(lock, /*min_count=*/0);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool IoRingImpl::is_submit_batch_active() const noexcept
+{
+  return this_thread_submit_batch().impl == this;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingImpl::flush_submissions() noexcept
+{
+  auto lock = LLFS_PROFILE_LOCK_WAIT("IoRingImpl::ring_mutex_",
+                                     std::unique_lock<std::mutex>{this->ring_mutex_});
+
+  if (io_uring_sq_ready(&this->ring_) != 0) {
+    this->submit_with_lock(lock, /*min_count=*/0);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingImpl::submit_with_lock(const std::unique_lock<std::mutex>&, usize min_count) noexcept
+{
+  TraceSpan span{"ioring", "submit"};
+
+  const u64 sq_ready = io_uring_sq_ready(&this->ring_);
+  this->metrics_.submit_call_count.add(1);
+  this->metrics_.sq_ready_total.add(sq_ready);
+  clamp_min_metric(this->metrics_.sq_ready_max, sq_ready);
+
+  const int retval = io_uring_submit(&this->ring_);
+  span.set_arg(retval);
+  BATT_CHECK_GE(retval, 0) << std::strerror(-retval);
+  BATT_CHECK_GE(static_cast<usize>(retval), min_count);
+
+  if (retval > 0) {
+    this->metrics_.submit_count.add(1);
+    this->metrics_.submitted_op_count.add(retval);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingImpl::reserve_sqes_with_lock(const std::unique_lock<std::mutex>& lock,
+                                        usize count) noexcept
+{
+  if (io_uring_sq_space_left(&this->ring_) < count) {
+    // The submission queue may be full of operations deferred by a submit batch; flush them.
+    //
+    this->metrics_.sq_full_count.add(1);
+    this->submit_with_lock(lock, /*min_count=*/0);
+  }
+  BATT_CHECK_GE(io_uring_sq_space_left(&this->ring_), count);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingImpl::finish_submit_with_lock(std::unique_lock<std::mutex>& lock, usize count) noexcept
+{
+  // If the current thread is batching submissions, we are done for now; the request will be
+  // submitted at the end of the batch (or by the next non-batched submit on any thread).
+  //
+  if (this->is_submit_batch_active()) {
+    return;
+  }
+
+  // In batching mode, leave the request in the submission queue until enough have built up (or
+  // until the run loop is about to block).
+  //
+  const usize batch_size = this->options_.submit_batch_size();
+  if (batch_size > 1) {
+    const usize pending_count = io_uring_sq_ready(&this->ring_);
+    if (pending_count < batch_size) {
+      lock.unlock();
+      this->on_submit_deferred(pending_count, count);
+      return;
+    }
+  }
+
+  // Finally, submit the request (plus any deferred requests that are ready).
+  //
+  this->submit_with_lock(lock, /*min_count=*/count);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingImpl::on_submit_deferred(usize pending_count, usize count) noexcept
+{
+  // If the event thread is (or is about to be) blocked, it may have already flushed the submission
+  // queue, in which case nobody would submit this operation; wake it up so it flushes again.  Only
+  // the first deferred operation(s) need to do this, since the event thread always flushes right
+  // before blocking.
+  //
+  // (The event thread sets event_blocked_ _before_ locking ring_mutex_ to flush, and we added our
+  // operation while holding ring_mutex_; so either the flush picked up our operation, or we see
+  // event_blocked_ == true here.)
+  //
+  if (pending_count == count && this->event_blocked_.load()) {
+    eventfd_write(this->event_fd_, 1);
+  }
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 Status IoRingImpl::run() noexcept
@@ -168,6 +514,10 @@ Status IoRingImpl::run() noexcept
   CompletionHandler* handler = nullptr;
   usize noop_count = 0;
 
+  // Completions are popped from this thread's home shard first; see pop_completion.
+  //
+  const usize home_shard = this->next_home_shard_.fetch_add(1) % this->completion_shards_.size();
+
   while (this->can_run()) {
     LLFS_DVLOG(1) << "IoRingImpl::run() top of loop;" << BATT_INSPECT(this->work_count_);
 
@@ -182,7 +532,7 @@ Status IoRingImpl::run() noexcept
     // The goal of the rest of the loop is to grab a completion handler to run.  First try the
     // direct approach...
     //
-    handler = this->pop_completion();
+    handler = this->pop_completion(home_shard);
     if (handler != nullptr) {
       noop_count = 0;
       continue;
@@ -225,7 +575,7 @@ Status IoRingImpl::run() noexcept
     } else {
       // Some other thread won the race to enter `event_wait_`; wait on `this->state_change_`.
       //
-      BATT_ASSIGN_OK_RESULT(handler, this->wait_for_completions());
+      BATT_ASSIGN_OK_RESULT(handler, this->wait_for_completions(home_shard));
     }
 
     // Some spurious wake-ups are fine, but only up to a point; if we execute the loop enough times
@@ -248,7 +598,7 @@ Status IoRingImpl::run() noexcept
   // If we are returning with a ready-to-run handler, stash it for later.
   //
   if (handler) {
-    this->stash_completion(&handler);
+    this->stash_completion(&handler, home_shard);
   }
 
   return OkStatus();
@@ -260,6 +610,23 @@ Status IoRingImpl::wait_for_ring_event()
 {
   LLFS_DVLOG(1) << "IoRingImpl::wait_for_ring_event()";
 
+  // With IOPOLL, completions are only moved from the device to the completion queue when some
+  // thread asks the kernel to reap events (the SQPOLL thread, if there is one, does this for us).
+  //
+  if (this->options_.iopoll() && !this->options_.sqpoll()) {
+    return this->poll_for_ring_event();
+  }
+
+  // Submit any batched operations before blocking, so we don't wait for completions of operations
+  // that have not been started.
+  //
+  this->event_blocked_.store(true);
+  auto on_scope_exit = batt::finally([&] {
+    this->event_blocked_.store(false);
+  });
+
+  this->flush_submissions();
+
   // Block on the event_fd until a completion event is available.
   //
   eventfd_t v;
@@ -282,24 +649,55 @@ Status IoRingImpl::wait_for_ring_event()
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-auto IoRingImpl::wait_for_completions() -> StatusOr<CompletionHandler*>
+Status IoRingImpl::poll_for_ring_event()
+{
+  LLFS_DVLOG(1) << "IoRingImpl::poll_for_ring_event()";
+
+  while (this->can_run()) {
+    if (io_uring_cq_ready(&this->ring_) != 0) {
+      break;
+    }
+
+    this->flush_submissions();
+
+    // Reap any completed polled I/O without blocking (min_complete=0).
+    //
+    const int retval = io_uring_enter(this->ring_.ring_fd, /*to_submit=*/0, /*min_complete=*/0,
+                                      IORING_ENTER_GETEVENTS, /*sig=*/nullptr);
+    if (retval < 0 && retval != -EINTR && retval != -EAGAIN) {
+      BATT_REQUIRE_OK(status_from_uring_retval(retval))
+          << batt::LogLevel::kError << "IoRingImpl::poll_for_ring_event() io_uring_enter failed";
+    }
+
+    if (io_uring_cq_ready(&this->ring_) == 0) {
+      std::this_thread::yield();
+    }
+  }
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto IoRingImpl::wait_for_completions(usize home_shard) -> StatusOr<CompletionHandler*>
 {
-  const auto is_unblocked = [this] {       // We aren't blocked if any of:
-    return !this->can_run()                //  - the run loop has been stopped
-           || !this->completions_.empty()  //  - there are completions to execute
-           || !this->event_wait_.load()    //  - no other thread is waiting for events
-        ;
+  const auto is_unblocked = [this] {                         // We aren't blocked if any of:
+    return !this->can_run()                                  //  - the run loop has been stopped
+           || this->queued_completion_count_.load() != 0     //  - there are completions to run
+           || !this->event_wait_.load()                      //  - no other thread is waiting
+        ;                                                    //    for events
   };
 
   //----- --- -- -  -  -   -
+  {
+    std::unique_lock<std::mutex> queue_lock{this->queue_mutex_};
 
-  std::unique_lock<std::mutex> queue_lock{this->queue_mutex_};
-
-  while (!is_unblocked()) {
-    this->state_change_.wait(queue_lock);
+    while (!is_unblocked()) {
+      this->state_change_.wait(queue_lock);
+    }
   }
 
-  return {this->pop_completion_with_lock(queue_lock)};
+  return {this->pop_completion(home_shard)};
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -311,26 +709,42 @@ void IoRingImpl::push_completion(CompletionHandler** handler)
   auto on_scope_exit = batt::finally([&] {
     *handler = nullptr;
   });
+
+  const usize shard_i = this->next_push_shard_.fetch_add(1) % this->completion_shards_.size();
+  CompletionShard& shard = *this->completion_shards_[shard_i];
+
+  this->queued_completion_count_.fetch_add(1);
   {
+    std::unique_lock<std::mutex> shard_lock{shard.mutex};
+    shard.completions.push_back(**handler);
+  }
+  {
+    // Waiters check queued_completion_count_ while holding queue_mutex_; see the comment in
+    // IoRingImpl::wake_all() for why we must lock it here before notifying.
+    //
     std::unique_lock<std::mutex> queue_lock{this->queue_mutex_};
-    this->completions_.push_back(**handler);
   }
   this->state_change_.notify_one();
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-void IoRingImpl::stash_completion(CompletionHandler** handler)
+void IoRingImpl::stash_completion(CompletionHandler** handler, usize home_shard)
 {
   BATT_ASSERT_NOT_NULLPTR(handler);
 
   auto on_scope_exit = batt::finally([&] {
     *handler = nullptr;
   });
+
+  CompletionShard& shard = *this->completion_shards_[home_shard];
+
+  this->queued_completion_count_.fetch_add(1);
   {
-    std::unique_lock<std::mutex> queue_lock{this->queue_mutex_};
-    this->completions_.push_front(**handler);
+    std::unique_lock<std::mutex> shard_lock{shard.mutex};
+    shard.completions.push_front(**handler);
   }
+  this->metrics_.stashed_completion_count.add(1);
 
   // We do not notify state_change_ here because this function is only called when this->can_run()
   // is false.
@@ -348,30 +762,60 @@ auto IoRingImpl::completion_from_cqe(struct io_uring_cqe* cqe) -> CompletionHand
   } else {
     handler->result.emplace(cqe->res);
   }
+  handler->cqe_flags = cqe->flags;
+
+  if (handler->submit_time != std::chrono::steady_clock::time_point{}) {
+    this->on_sampled_completion(handler);
+  }
 
   return handler;
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-auto IoRingImpl::pop_completion() -> CompletionHandler*
+void IoRingImpl::on_sampled_completion(CompletionHandler* handler) noexcept
 {
-  std::unique_lock<std::mutex> queue_lock{this->queue_mutex_};
+  handler->complete_time = std::chrono::steady_clock::now();
+
+  const auto elapsed = handler->complete_time - handler->submit_time;
+
+  this->metrics_.op_latency[Metrics::op_kind_from_opcode(handler->opcode)].update(elapsed);
 
-  return this->pop_completion_with_lock(queue_lock);
+  if (handler->fixed_fd >= 0 && static_cast<usize>(handler->fixed_fd) < Metrics::kMaxTrackedFds) {
+    this->metrics_.fixed_fd_latency[handler->fixed_fd].update(elapsed);
+  }
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-auto IoRingImpl::pop_completion_with_lock(std::unique_lock<std::mutex>&) -> CompletionHandler*
+auto IoRingImpl::pop_completion(usize home_shard) -> CompletionHandler*
 {
-  if (this->completions_.empty()) {
+  if (this->queued_completion_count_.load() == 0) {
     return nullptr;
   }
 
-  CompletionHandler& next = this->completions_.front();
-  this->completions_.pop_front();
-  return &next;
+  const usize n_shards = this->completion_shards_.size();
+
+  for (usize i = 0; i < n_shards; ++i) {
+    CompletionShard& shard = *this->completion_shards_[(home_shard + i) % n_shards];
+    CompletionHandler* next = nullptr;
+    {
+      std::unique_lock<std::mutex> shard_lock{shard.mutex};
+      if (!shard.completions.empty()) {
+        next = &shard.completions.front();
+        shard.completions.pop_front();
+      }
+    }
+    if (next != nullptr) {
+      this->queued_completion_count_.fetch_sub(1);
+      if (i != 0) {
+        this->metrics_.stolen_completion_count.add(1);
+      }
+      return next;
+    }
+  }
+
+  return nullptr;
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -388,7 +832,14 @@ StatusOr<usize> IoRingImpl::transfer_completions(CompletionHandler** handler_out
   usize count = 0;
   *handler_out = nullptr;
 
-  std::unique_lock<std::mutex> ring_lock{this->ring_mutex_};
+  auto ring_lock = LLFS_PROFILE_LOCK_WAIT("IoRingImpl::ring_mutex_",
+                                          std::unique_lock<std::mutex>{this->ring_mutex_});
+
+  const u64 cq_ready = io_uring_cq_ready(&this->ring_);
+  this->metrics_.reap_count.add(1);
+  this->metrics_.cq_ready_total.add(cq_ready);
+  clamp_min_metric(this->metrics_.cq_ready_max, cq_ready);
+
   for (; count < kMaxCount; ++count) {
     struct io_uring_cqe cqe;
     struct io_uring_cqe* p_cqe = nullptr;
@@ -460,6 +911,22 @@ void IoRingImpl::invoke_handler(CompletionHandler** handler) noexcept
   BATT_CHECK((*handler)->result);
 
   StatusOr<i32> result = *(*handler)->result;
+
+  if ((*handler)->complete_time != std::chrono::steady_clock::time_point{}) {
+    this->metrics_.dispatch_latency.update((*handler)->complete_time);
+  }
+
+  LLFS_TRACE_SPAN("ioring", "completion");
+
+  // Make the cqe flags visible to the handler (via current_completion_buffer_id) for the duration
+  // of the call.
+  //
+  u32& current_flags = this_thread_cqe_flags();
+  current_flags = (*handler)->cqe_flags;
+  auto on_handler_exit = batt::finally([&current_flags] {
+    current_flags = 0;
+  });
+
   try {
     LLFS_DVLOG(1) << "IoRingImpl::run() invoke_handler " << BATT_INSPECT(this->work_count_);
     //
@@ -555,6 +1022,47 @@ Status IoRingImpl::unregister_buffers_with_lock(const std::unique_lock<std::mute
   return OkStatus();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<struct io_uring_buf_ring*> IoRingImpl::setup_buf_ring(u32 entries, u16 group_id) noexcept
+{
+  std::unique_lock<std::mutex> lock{this->ring_mutex_};
+
+  int retval = 0;
+  struct io_uring_buf_ring* buf_ring =
+      io_uring_setup_buf_ring(&this->ring_, entries, group_id, /*flags=*/0, &retval);
+
+  if (buf_ring == nullptr) {
+    BATT_REQUIRE_OK(status_from_uring_retval(retval));
+    return {batt::StatusCode::kInternal};
+  }
+
+  return buf_ring;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status IoRingImpl::free_buf_ring(struct io_uring_buf_ring* buf_ring, u32 entries,
+                                 u16 group_id) noexcept
+{
+  std::unique_lock<std::mutex> lock{this->ring_mutex_};
+
+  const int retval = io_uring_free_buf_ring(&this->ring_, buf_ring, entries, group_id);
+
+  return status_from_uring_retval(retval);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ Optional<u16> IoRingImpl::current_completion_buffer_id() noexcept
+{
+  const u32 flags = this_thread_cqe_flags();
+  if ((flags & IORING_CQE_F_BUFFER) == 0) {
+    return None;
+  }
+  return static_cast<u16>(flags >> IORING_CQE_BUFFER_SHIFT);
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 StatusOr<i32> IoRingImpl::register_fd(i32 system_fd) noexcept
@@ -17,8 +17,11 @@
 
 #include <llfs/api_types.hpp>
 #include <llfs/buffer.hpp>
+#include <llfs/contention_profiler.hpp>
 #include <llfs/int_types.hpp>
 #include <llfs/ioring_op_handler.hpp>
+#include <llfs/ioring_options.hpp>
+#include <llfs/metrics.hpp>
 #include <llfs/optional.hpp>
 #include <llfs/seq.hpp>
 #include <llfs/status.hpp>
@@ -27,14 +30,20 @@
 
 #include <batteries/assert.hpp>
 #include <batteries/async/handler.hpp>
+#include <batteries/cpu_align.hpp>
 #include <batteries/static_assert.hpp>
 
 #include <liburing.h>
 
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
 #include <condition_variable>
 #include <iterator>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 namespace llfs {
 
@@ -43,6 +52,21 @@ class IoRingImpl
  public:
   struct CompletionHandlerBase : batt::DefaultHandlerBase {
     Optional<StatusOr<i32>> result;
+
+    // Set only for operations sampled by Metrics::sampler; the time the sqe was filled in, and the
+    // time its cqe was reaped.
+    //
+    std::chrono::steady_clock::time_point submit_time{};
+    std::chrono::steady_clock::time_point complete_time{};
+
+    // The opcode and fixed file index (or -1) of a sampled operation.
+    //
+    u8 opcode = 0;
+    i32 fixed_fd = -1;
+
+    // The `flags` field of the cqe for this operation (e.g., IORING_CQE_F_BUFFER).
+    //
+    u32 cqe_flags = 0;
   };
 
   using CompletionHandler = batt::BasicAbstractHandler<CompletionHandlerBase, StatusOr<i32>>;
@@ -55,10 +79,107 @@ class IoRingImpl
 
   using CompletionHandlerList = batt::BasicHandlerList<CompletionHandlerBase, StatusOr<i32>>;
 
+  struct Metrics {
+    /** \brief Operation kinds for which submit-to-complete latency is tracked separately.
+     */
+    enum OpKind : usize {
+      kRead = 0,
+      kWrite,
+      kFsync,
+      kOther,
+      kNumOpKinds,
+    };
+
+    /** \brief Operations on fixed file indices below this limit have their own latency metric.
+     */
+    static constexpr usize kMaxTrackedFds = 16;
+
+    static constexpr u32 kDefaultSampleRate = 64;
+
+    static OpKind op_kind_from_opcode(u8 opcode) noexcept;
+
+    static const char* op_kind_name(OpKind kind) noexcept;
+
+    //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+    /** \brief The number of io_uring_submit calls that submitted at least one operation.
+     */
+    CountMetric<u64> submit_count{0};
+
+    /** \brief The total number of operations submitted.
+     */
+    CountMetric<u64> submitted_op_count{0};
+
+    /** \brief The sum/max of the number of sqes waiting in the submission queue at each
+     * io_uring_submit call; sq_ready_total / submit_call_count is the average SQ occupancy.
+     */
+    CountMetric<u64> submit_call_count{0};
+    CountMetric<u64> sq_ready_total{0};
+    CountMetric<u64> sq_ready_max{0};
+
+    /** \brief The number of times the submission queue was found full when starting an operation
+     * (i.e., MaxQueueDepth was too small to hold all deferred submissions).
+     */
+    CountMetric<u64> sq_full_count{0};
+
+    /** \brief The sum/max of the number of cqes waiting in the completion queue each time the run
+     * loop reaped completions; a growing backlog means completion processing is falling behind.
+     */
+    CountMetric<u64> reap_count{0};
+    CountMetric<u64> cq_ready_total{0};
+    CountMetric<u64> cq_ready_max{0};
+
+    /** \brief The number of ready completions put back on the queue because run() was exiting.
+     */
+    CountMetric<u64> stashed_completion_count{0};
+
+    /** \brief The number of completions run by a thread other than the one whose completion shard
+     * they were queued on (see IoRingImpl::pop_completion).
+     */
+    CountMetric<u64> stolen_completion_count{0};
+
+    /** \brief Decides which operations are timed (env var LLFS_IORING_METRICS_SAMPLE_RATE,
+     * default: 64; 0 disables latency collection).
+     */
+    LatencySampler sampler{kDefaultSampleRate};
+
+    /** \brief Time from filling in the sqe to reaping the cqe, by operation kind.
+     */
+    std::array<LatencyHistogram, kNumOpKinds> op_latency;
+
+    /** \brief Time from filling in the sqe to reaping the cqe, by fixed file index.
+     */
+    std::array<LatencyMetric, kMaxTrackedFds> fixed_fd_latency;
+
+    /** \brief Time from reaping the cqe to invoking the completion handler.
+     */
+    LatencyHistogram dispatch_latency;
+
+    /** \brief Returns the average number of operations submitted per syscall.
+     */
+    double average_submit_batch_size() const
+    {
+      const u64 n_submits = this->submit_count.load();
+      if (n_submits == 0) {
+        return 0;
+      }
+      return double(this->submitted_op_count.load()) / double(n_submits);
+    }
+  };
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
+  /** \brief The maximum number of completion queue shards; see `run()`.
+   */
+  static constexpr usize kMaxCompletionShards = 16;
+
   static StatusOr<std::unique_ptr<IoRingImpl>> make_new(MaxQueueDepth entries) noexcept;
 
+  /** \brief Creates a new io_uring context using the given options; `options.queue_count()` is
+   * ignored (see IoRing::make_new).
+   */
+  static StatusOr<std::unique_ptr<IoRingImpl>> make_new(const IoRingOptions& options) noexcept;
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   // IoRingImpl is noncopyable.
@@ -74,6 +195,18 @@ class IoRingImpl
 
   bool is_valid() const noexcept;
 
+  /** \brief Returns the options used to create this object.
+   */
+  const IoRingOptions& options() const noexcept
+  {
+    return this->options_;
+  }
+
+  const Metrics& metrics() const noexcept
+  {
+    return this->metrics_;
+  }
+
   void on_work_started() noexcept;
 
   void on_work_finished() noexcept;
@@ -92,6 +225,40 @@ class IoRingImpl
               std::function<void(struct io_uring_sqe*, IoRingOpHandler<std::decay_t<Handler>>&)>&&
                   start_op) noexcept;
 
+  /** \brief Submits two operations as a linked chain (IOSQE_IO_LINK): the second is not started
+   * until the first completes, and if the first fails (or, for reads and writes, transfers fewer
+   * bytes than requested), the second completes with -ECANCELED without being started.  Each
+   * handler is invoked separately when its operation completes.
+   */
+  template <typename FirstHandler, typename SecondHandler, typename BufferSequence>
+  void submit_linked(
+      BufferSequence&& buffers, FirstHandler&& first_handler,
+      std::function<void(struct io_uring_sqe*, IoRingOpHandler<std::decay_t<FirstHandler>>&)>&&
+          start_first_op,
+      SecondHandler&& second_handler,
+      std::function<void(struct io_uring_sqe*, IoRingOpHandler<std::decay_t<SecondHandler>>&)>&&
+          start_second_op) noexcept;
+
+  /** \brief Submits an operation linked to a timeout (IORING_OP_LINK_TIMEOUT): if the operation
+   * has not completed within `timeout`, the kernel cancels it and `handler` is passed
+   * batt::StatusCode::kDeadlineExceeded; otherwise `handler` is passed the operation's result.
+   *
+   * `start_op` is invoked (synchronously) with the sqe and op handler, as for `submit`; the op
+   * handler type is an internal wrapper around `handler`, so `start_op` should be generic in its
+   * second argument.
+   */
+  template <typename Handler, typename BufferSequence, typename StartOp>
+  void submit_with_timeout(BufferSequence&& buffers, std::chrono::nanoseconds timeout,
+                           Handler&& handler, StartOp&& start_op) noexcept;
+
+  /** \brief Asynchronously cancels all in-flight operations submitted to this queue for the file
+   * descriptor `fd` (which is a registered "user_fd" if `fixed` is true), via
+   * IORING_OP_ASYNC_CANCEL.  Invokes `handler` with the number of operations cancelled (0 if
+   * there were none), or error status.
+   */
+  template <typename Handler>
+  void async_cancel_fd(i32 fd, bool fixed, Handler&& handler) noexcept;
+
   /** \brief Register buffers for faster I/O.
    *
    * If `update` is true, then returns the index of the first buffer in the new set, which is
@@ -101,12 +268,47 @@ class IoRingImpl
 
   Status unregister_buffers() noexcept;
 
+  /** \brief Allocates and registers a provided buffer ring (IORING_REGISTER_PBUF_RING) with
+   * `entries` slots (must be a power of 2) for buffer group `group_id`.
+   */
+  StatusOr<struct io_uring_buf_ring*> setup_buf_ring(u32 entries, u16 group_id) noexcept;
+
+  /** \brief Unregisters and frees a buffer ring returned by `setup_buf_ring`.
+   */
+  Status free_buf_ring(struct io_uring_buf_ring* buf_ring, u32 entries, u16 group_id) noexcept;
+
+  /** \brief When called from inside a completion handler, returns the id of the buffer the kernel
+   * selected for the operation (IOSQE_BUFFER_SELECT); returns None if no buffer was selected, or
+   * if the calling thread is not running a completion handler.
+   */
+  static Optional<u16> current_completion_buffer_id() noexcept;
+
   StatusOr<i32> register_fd(i32 system_fd) noexcept;
 
   Status unregister_fd(i32 user_fd) noexcept;
 
   bool can_run() const noexcept;
 
+  /** \brief Submits all operations that have been started but not yet submitted to the kernel
+   * (see IoRingOptions::submit_batch_size).
+   */
+  void flush_submissions() noexcept;
+
+  /** \brief Starts deferring the io_uring_submit syscall for all operations submitted by the
+   * calling thread, until the matching call to `end_submit_batch()`.
+   *
+   * Batches may be nested (by the same thread, on the same IoRingImpl).  If the calling thread is
+   * already batching submissions for a different IoRingImpl, this function has no effect and
+   * returns false; otherwise returns true.
+   */
+  bool begin_submit_batch() noexcept;
+
+  /** \brief Ends a submission batch started by `begin_submit_batch()` (which must have returned
+   * true); when the outermost batch ends, all deferred operations are submitted with a single
+   * syscall.
+   */
+  void end_submit_batch() noexcept;
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
  private:
   /** \brief Wraps the passed handler `fn` as a batt::HandlerImpl (batt::AbstractHandler) which
@@ -115,6 +317,42 @@ class IoRingImpl
   template <typename Fn, typename BufferSequence>
   static CompletionHandlerImpl<Fn>* wrap_handler(Fn&& fn, BufferSequence&& bufs);
 
+  /** \brief The state shared by the two completion handlers of `submit_with_timeout`; these may
+   * run on different threads, in either order, and whichever runs second invokes the caller's
+   * handler.  Also holds the timeout value, which must stay valid until the sqe is submitted.
+   */
+  template <typename Handler>
+  struct TimeoutState {
+    explicit TimeoutState(Handler&& caller_handler) noexcept
+        : handler{BATT_FORWARD(caller_handler)}
+    {
+    }
+
+    void finish()
+    {
+      if (this->n_pending.fetch_sub(1) != 1) {
+        return;
+      }
+      // The linked timeout completes with -ETIME only if it fired; if the operation failed as a
+      // result (it was cancelled or interrupted), report that as a missed deadline.  If the
+      // operation managed to complete anyway, its result stands.
+      //
+      const bool timed_out = (this->timeout_result.status() == batt::status_from_errno(ETIME));
+
+      if (timed_out && !this->op_result.ok()) {
+        this->handler(StatusOr<i32>{batt::StatusCode::kDeadlineExceeded});
+      } else {
+        this->handler(std::move(this->op_result));
+      }
+    }
+
+    struct __kernel_timespec timeout {};
+    std::decay_t<Handler> handler;
+    StatusOr<i32> op_result{batt::StatusCode::kUnknown};
+    StatusOr<i32> timeout_result{batt::StatusCode::kUnknown};
+    std::atomic<int> n_pending{2};
+  };
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   // Use static make_new to create instances of this class.
@@ -125,26 +363,82 @@ class IoRingImpl
 
   Status unregister_files_with_lock(const std::unique_lock<std::mutex>&) noexcept;
 
+  /** \brief Returns true iff the calling thread is inside a submit batch for this object.
+   */
+  bool is_submit_batch_active() const noexcept;
+
+  /** \brief Adds `this->metrics_` to the global registry as IoRing_<N>_*, where N is a
+   * process-wide sequence number.
+   */
+  void add_metrics_to_registry();
+
+  /** \brief Reverses add_metrics_to_registry (if it was called).
+   */
+  void remove_metrics_from_registry();
+
+  /** \brief Records the latency metrics for a sampled operation whose cqe was just reaped.
+   */
+  void on_sampled_completion(CompletionHandler* handler) noexcept;
+
+  /** \brief Makes sure there are at least `count` free entries in the submission queue, submitting
+   * deferred operations to make room if necessary.
+   */
+  void reserve_sqes_with_lock(const std::unique_lock<std::mutex>& lock, usize count) noexcept;
+
+  /** \brief Fills in the next sqe for the given operation (via `start_op`), attaches the handler,
+   * and increments the work count; returns the sqe.
+   */
+  template <typename Handler>
+  struct io_uring_sqe* prepare_sqe_with_lock(
+      const std::unique_lock<std::mutex>&, CompletionHandlerImpl<Handler>* op_handler,
+      std::function<void(struct io_uring_sqe*, IoRingOpHandler<std::decay_t<Handler>>&)>&
+          start_op) noexcept;
+
+  /** \brief Submits the `count` operations just prepared (maybe along with earlier deferred ones),
+   * unless submission is being deferred by a submit batch or IoRingOptions::submit_batch_size.
+   */
+  void finish_submit_with_lock(std::unique_lock<std::mutex>& lock, usize count) noexcept;
+
+  /** \brief Calls io_uring_submit, updating metrics; panics if fewer than `min_count` operations
+   * are submitted.
+   */
+  void submit_with_lock(const std::unique_lock<std::mutex>&, usize min_count) noexcept;
+
+  /** \brief Called after `count` operations are added to the submission queue but not submitted,
+   * because submission batching is enabled.  Wakes the thread blocked waiting for ring events (if
+   * any), so that it can submit them.
+   */
+  void on_submit_deferred(usize pending_count, usize count) noexcept;
+
   /** \brief Blocks the caller until the event_fd_ is signalled.
    *
    * Should be called without holding any locks.
    */
   Status wait_for_ring_event();
 
+  /** \brief Used in place of waiting for the event_fd_ when completions must be actively reaped
+   * from the device (IOPOLL without SQPOLL); spins until there is at least one completion event in
+   * the ring, or until the run loop is stopped.
+   *
+   * Should be called without holding any locks.
+   */
+  Status poll_for_ring_event();
+
   /** \brief Blocks the caller until one of the following is true:
    *
-   *  - There is at least one completion in the queue (this->completions_.empty() == false)
+   *  - There is at least one queued completion (this->queued_completion_count_ != 0)
    *  - No other thread is waiting on the ioring event (this->event_wait_ == false)
    *  - There is no work pending (this->work_count_ == 0)
    *  - stop() has been called (this->needs_reset_ == true)
    */
-  StatusOr<CompletionHandler*> wait_for_completions();
+  StatusOr<CompletionHandler*> wait_for_completions(usize home_shard);
 
   /** \brief Transfer up to `std::thread::hardware_concurrency()` completion events from the
-   * ioring completion queue to our local queue (this->completions_).
+   * ioring completion queue to our local queues (this->completion_shards_).
    *
-   * If successful, this function will wake up one or more other threads to process the
-   * completions.
+   * All but the last completion are spread round-robin over the completion shards, waking one
+   * waiting thread per completion; the last is returned via `handler_out`, to be run by the
+   * calling thread.
    */
   StatusOr<usize> transfer_completions(CompletionHandler** handler_out);
 
@@ -152,30 +446,28 @@ class IoRingImpl
    */
   CompletionHandler* completion_from_cqe(struct io_uring_cqe* cqe);
 
-  /** \brief Pushes *handler onto the back of `this->completions_`, waking one waiter.
+  /** \brief Pushes *handler onto the back of the next completion shard (round-robin), waking one
+   * waiter.
    *
    * Sets *handler to nullptr.
    */
   void push_completion(CompletionHandler** handler);
 
-  /** \brief Pushes the handler onto the front of `this->completions_`; do not call notify.
+  /** \brief Pushes the handler onto the front of the given completion shard; do not call notify.
    *
    * Sets *handler to nullptr.
    */
-  void stash_completion(CompletionHandler** handler);
+  void stash_completion(CompletionHandler** handler, usize home_shard);
 
-  /** \brief Tries to pop a single completed handler from the queue.
+  /** \brief Tries to pop a single completed handler, first from the front of `home_shard`, then
+   * (work stealing) from each of the other completion shards in turn.
    *
-   * This function never blocks; if the completion queue is empty, it just returns nullptr
+   * This function never blocks; if all completion shards are empty, it just returns nullptr
    * immediately.
    *
    * \return The popped completion if there is one, nullptr otherwise.
    */
-  CompletionHandler* pop_completion();
-
-  /** \brief Same as pop_completion(), but with the queue_mutex_ lock already held.
-   */
-  CompletionHandler* pop_completion_with_lock(std::unique_lock<std::mutex>&);
+  CompletionHandler* pop_completion(usize home_shard);
 
   /** \brief Invokes and deletes the handler, decrementing work count.
    *
@@ -201,7 +493,7 @@ class IoRingImpl
   //
   std::mutex ring_mutex_;
 
-  // Protects access to the completions_ queue.
+  // Used (with state_change_) to block threads waiting for completions; see wait_for_completions.
   //
   std::mutex queue_mutex_;
 
@@ -209,14 +501,50 @@ class IoRingImpl
   //
   std::condition_variable state_change_;
 
-  // List of handlers for completed operations.
+  // A queue of handlers for completed operations, along with the mutex that protects it.
+  //
+  struct CompletionShard {
+    std::mutex mutex;
+    CompletionHandlerList completions;
+  };
+
+  // Handlers for completed operations, split into (up to kMaxCompletionShards) independently
+  // locked queues so that threads in run() don't all contend on one lock; each thread has a home
+  // shard, and steals from the others when its own is empty.
   //
-  CompletionHandlerList completions_;
+  std::vector<batt::CpuCacheLineIsolated<CompletionShard>> completion_shards_;
+
+  // The total number of handlers in all completion shards; incremented before a handler is pushed
+  // and decremented after one is popped, so it may briefly overstate the number of queued
+  // handlers, but never understates it.
+  //
+  std::atomic<usize> queued_completion_count_{0};
+
+  // Used to assign home shards to threads entering run(), and to pick the shard for each pushed
+  // completion.
+  //
+  std::atomic<usize> next_home_shard_{0};
+  std::atomic<usize> next_push_shard_{0};
 
   // The first thread to enter the critical section will set this flag.
   //
   std::atomic<bool> event_wait_{false};
 
+  // Set by the thread waiting for ring events right before it flushes deferred submissions and
+  // blocks.
+  //
+  std::atomic<bool> event_blocked_{false};
+
+  Metrics metrics_;
+
+  // True iff metrics_ has been added to the global metric registry.
+  //
+  bool metrics_registered_ = false;
+
+  // The options passed to make_new.
+  //
+  IoRingOptions options_ = IoRingOptions::with_default_values();
+
   // The io_uring context.
   //
   struct io_uring ring_;
@@ -309,8 +637,109 @@ inline void IoRingImpl::submit(
   CompletionHandlerImpl<Handler>* op_handler =
       wrap_handler(BATT_FORWARD(handler), BATT_FORWARD(buffers));
 
-  std::unique_lock<std::mutex> lock{this->ring_mutex_};
+  auto lock = LLFS_PROFILE_LOCK_WAIT("IoRingImpl::ring_mutex_",
+                                     std::unique_lock<std::mutex>{this->ring_mutex_});
+
+  this->reserve_sqes_with_lock(lock, 1);
+  this->prepare_sqe_with_lock(lock, op_handler, start_op);
+  this->finish_submit_with_lock(lock, 1);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename FirstHandler, typename SecondHandler, typename BufferSequence>
+inline void IoRingImpl::submit_linked(
+    BufferSequence&& buffers, FirstHandler&& first_handler,
+    std::function<void(struct io_uring_sqe*, IoRingOpHandler<std::decay_t<FirstHandler>>&)>&&
+        start_first_op,
+    SecondHandler&& second_handler,
+    std::function<void(struct io_uring_sqe*, IoRingOpHandler<std::decay_t<SecondHandler>>&)>&&
+        start_second_op) noexcept
+{
+  CompletionHandlerImpl<FirstHandler>* first_op_handler =
+      wrap_handler(BATT_FORWARD(first_handler), BATT_FORWARD(buffers));
+
+  CompletionHandlerImpl<SecondHandler>* second_op_handler =
+      wrap_handler(BATT_FORWARD(second_handler), no_buffers());
+
+  auto lock = LLFS_PROFILE_LOCK_WAIT("IoRingImpl::ring_mutex_",
+                                     std::unique_lock<std::mutex>{this->ring_mutex_});
+
+  // Both sqes must be taken while we hold the lock, so that they are adjacent in the submission
+  // queue; that is what links them.
+  //
+  this->reserve_sqes_with_lock(lock, 2);
+
+  struct io_uring_sqe* first_sqe = this->prepare_sqe_with_lock(lock, first_op_handler,
+                                                               start_first_op);
+  first_sqe->flags |= IOSQE_IO_LINK;
+
+  this->prepare_sqe_with_lock(lock, second_op_handler, start_second_op);
+  this->finish_submit_with_lock(lock, 2);
+}
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename Handler, typename BufferSequence, typename StartOp>
+inline void IoRingImpl::submit_with_timeout(BufferSequence&& buffers,
+                                            std::chrono::nanoseconds timeout, Handler&& handler,
+                                            StartOp&& start_op) noexcept
+{
+  auto state = std::make_shared<TimeoutState<Handler>>(BATT_FORWARD(handler));
+
+  const auto secs = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+  const auto nsecs = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout - secs);
+
+  state->timeout.tv_sec = secs.count();
+  state->timeout.tv_nsec = nsecs.count();
+
+  struct __kernel_timespec* const timeout_spec = &state->timeout;
+
+  this->submit_linked(
+      BATT_FORWARD(buffers),
+      [state](StatusOr<i32> result) {
+        state->op_result = std::move(result);
+        state->finish();
+      },
+      BATT_FORWARD(start_op),
+      [state](StatusOr<i32> result) {
+        state->timeout_result = std::move(result);
+        state->finish();
+      },
+      [timeout_spec](struct io_uring_sqe* sqe, auto& /*op*/) {
+        io_uring_prep_link_timeout(sqe, timeout_spec, /*flags=*/0);
+      });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename Handler>
+inline void IoRingImpl::async_cancel_fd(i32 fd, bool fixed, Handler&& handler) noexcept
+{
+  this->submit(
+      no_buffers(),
+      [handler = BATT_FORWARD(handler)](StatusOr<i32> result) mutable {
+        // ENOENT means there was nothing to cancel.
+        //
+        if (result.status() == batt::status_from_errno(ENOENT)) {
+          result = 0;
+        }
+        handler(std::move(result));
+      },
+      [fd, fixed](struct io_uring_sqe* sqe, auto& /*op*/) {
+        const u32 flags = IORING_ASYNC_CANCEL_ALL | (fixed ? IORING_ASYNC_CANCEL_FD_FIXED : 0);
+        io_uring_prep_cancel_fd(sqe, fd, flags);
+      });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename Handler>
+inline struct io_uring_sqe* IoRingImpl::prepare_sqe_with_lock(
+    const std::unique_lock<std::mutex>&, CompletionHandlerImpl<Handler>* op_handler,
+    std::function<void(struct io_uring_sqe*, IoRingOpHandler<std::decay_t<Handler>>&)>&
+        start_op) noexcept
+{
   struct io_uring_sqe* sqe = io_uring_get_sqe(&this->ring_);
   BATT_CHECK_NOT_NULLPTR(sqe);
 
@@ -321,6 +750,12 @@ inline void IoRingImpl::submit(
   //
   start_op(sqe, op_handler->get_fn());
 
+  if (this->metrics_.sampler.sample()) {
+    op_handler->submit_time = std::chrono::steady_clock::now();
+    op_handler->opcode = sqe->opcode;
+    op_handler->fixed_fd = (sqe->flags & IOSQE_FIXED_FILE) ? sqe->fd : -1;
+  }
+
   // Set user data.
   //
   io_uring_sqe_set_data(sqe, static_cast<CompletionHandler*>(op_handler));
@@ -333,9 +768,7 @@ inline void IoRingImpl::submit(
   //
   LLFS_DVLOG(1) << "(submit) after; " << BATT_INSPECT(this->work_count_);
 
-  // Finally, submit the request.
-  //
-  BATT_CHECK_EQ(1, io_uring_submit(&this->ring_)) << std::strerror(errno);
+  return sqe;
 }
 
 }  //namespace llfs
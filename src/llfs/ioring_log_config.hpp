@@ -27,6 +27,11 @@ struct IoRingLogConfig {
   static constexpr usize kDefaultBlockSize = 16 * kKiB;
   static constexpr usize kDefaultPagesPerBlockLog2 = 5;
 
+  // The largest supported flush block (1mb).  Each flush op holds a buffer of this size, so the
+  // memory used by the log driver is `queue_depth * block_size`.
+  //
+  static constexpr usize kMaxPagesPerBlockLog2 = 11;
+
   static_assert((1ull << (kDefaultPagesPerBlockLog2 + kLogAtomicWriteSizeLog2)) ==
                     kDefaultBlockSize,
                 "");
@@ -56,6 +61,15 @@ struct IoRingLogConfig {
   //  | 5                        | 16kb                      |
   //  | 6                        | 32kb                      |
   //  | 7                        | 64kb                      |
+  //  | ...                      | ...                       |
+  //  | 9                        | 256kb                     |
+  //  | 10                       | 512kb                     |
+  //  | 11                       | 1mb                       |
+  //
+  // A flush only writes the 512-byte sectors of the block that have changed since the last flush
+  // (plus the head sector, which holds the PackedLogPageHeader), so larger blocks don't make small
+  // commits write more data; they let a large amount of committed data go out in a single write,
+  // and reduce the number of headers (and head writes) per byte of log.
   //
   usize pages_per_block_log2 = kDefaultPagesPerBlockLog2;
 
@@ -23,6 +23,7 @@
 #include <llfs/log_block_calculator.hpp>
 #include <llfs/metrics.hpp>
 #include <llfs/optional.hpp>
+#include <llfs/packed_log_page_buffer.hpp>
 #include <llfs/packed_log_page_header.hpp>
 
 #include <batteries/async/watch.hpp>
@@ -35,6 +36,8 @@ BATT_SUPPRESS("-Wunused-parameter")
 BATT_UNSUPPRESS()
 
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -67,6 +70,7 @@ class BasicIoRingLogDriver
     LatencyMetric flush_write_latency;
     CountMetric<u64> logical_bytes_flushed{0};
     CountMetric<u64> physical_bytes_flushed{0};
+    CountMetric<u64> background_init_count{0};
   };
 
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -113,6 +117,13 @@ class BasicIoRingLogDriver
     return await_slot_offset(flush_pos, this->flush_pos_);
   }
 
+#if LLFS_HAS_COROUTINES
+  coro::Task<StatusOr<slot_offset_type>> co_await_flush_pos(slot_offset_type flush_pos)
+  {
+    return co_await_slot_offset(flush_pos, this->flush_pos_);
+  }
+#endif  // LLFS_HAS_COROUTINES
+
   //----
 
   Status set_commit_pos(slot_offset_type commit_pos);
@@ -147,6 +158,11 @@ class BasicIoRingLogDriver
     return this->metrics_;
   }
 
+  const IoRingLogDriverOptions& options() const
+  {
+    return this->options_;
+  }
+
   const LogBlockCalculator& calculate() const
   {
     return this->calculate_;
@@ -167,6 +183,17 @@ class BasicIoRingLogDriver
 
   void wait_for_commit(slot_offset_type least_upper_bound);
 
+  /** \brief Invokes the passed handler on the IoRing thread after `delay_usec` microseconds; used
+   * by flush ops to hold a partially filled block while more commits arrive (group commit).
+   *
+   * \param handler A callable with signature void(StatusOr<i32>)
+   */
+  template <typename Handler = void(StatusOr<i32>)>
+  void async_wait_group_commit(u64 delay_usec, Handler&& handler)
+  {
+    this->ioring_.async_sleep(std::chrono::microseconds(delay_usec), BATT_FORWARD(handler));
+  }
+
   void poll_flush_state();
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -179,7 +206,21 @@ class BasicIoRingLogDriver
   template <typename Handler>
   void async_write_some(i64 log_offset, const ConstBuffer& data, i32 buf_index, Handler&& handler)
   {
-    this->file_.async_write_some_fixed(log_offset, data, buf_index, BATT_FORWARD(handler));
+    if (this->options_.background_init_blocks_ahead == 0) {
+      this->file_.async_write_some_fixed(log_offset, data, buf_index, BATT_FORWARD(handler));
+      return;
+    }
+
+    // Track foreground writes so that background block initialization can stay out of their way.
+    //
+    this->foreground_writes_in_flight_ += 1;
+    this->file_.async_write_some_fixed(
+        log_offset, data, buf_index,
+        [this, handler = BATT_FORWARD(handler)](const StatusOr<i32>& result) mutable {
+          this->foreground_writes_in_flight_ -= 1;
+          handler(result);
+          this->poll_background_init();
+        });
   }
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -223,6 +264,29 @@ class BasicIoRingLogDriver
     this->init_upper_bound_.async_wait(last_known_value, BATT_FORWARD(handler));
   }
 
+  /** \brief Returns true iff the given physical block is currently being formatted in the
+   * background; flush ops must not write to such a block until the background write finishes.
+   */
+  bool is_background_init_in_progress(LogBlockCalculator::PhysicalBlockIndex index) const
+  {
+    return this->background_init_block_ && *this->background_init_block_ == index;
+  }
+
+  /** \brief Invokes the passed handler once the in-progress background block initialization (see
+   * is_background_init_in_progress) has finished, successfully or not.  At most one handler may be
+   * waiting at a time.
+   *
+   * \param handler A callable with signature void(StatusOr<i32>)
+   */
+  template <typename Handler = void(StatusOr<i32>)>
+  void async_wait_background_init(Handler&& handler)
+  {
+    BATT_CHECK(this->background_init_block_);
+    BATT_CHECK(!this->background_init_waiter_);
+
+    this->background_init_waiter_.emplace(BATT_FORWARD(handler));
+  }
+
  private:
   using SlotOffsetHeap = boost::heap::d_ary_heap<slot_offset_type,                   //
                                                  boost::heap::arity<2>,              //
@@ -257,6 +321,13 @@ class BasicIoRingLogDriver
 
   void handle_commit_pos_update(const StatusOr<slot_offset_type>& updated_commit_pos);
 
+  // If background block initialization is enabled and the device is idle, starts writing an empty
+  // header to the next uninitialized block (if it is close enough to the flush position).
+  //
+  void poll_background_init();
+
+  void handle_background_init(const StatusOr<i32>& result);
+
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
   // Used to access the RingBuffer.
@@ -319,6 +390,15 @@ class BasicIoRingLogDriver
   bool commit_pos_listener_active_ = false;
   bool inside_poll_commit_state_ = false;
 
+  // Background block initialization state (see IoRingLogDriverOptions::
+  // background_init_blocks_ahead); only accessed on the IoRing thread once flushing has started.
+  //
+  usize foreground_writes_in_flight_ = 0;
+  Optional<usize> background_init_block_;
+  PackedLogPageBuffer background_init_buffer_;
+  batt::HandlerMemory<128> background_init_handler_memory_;
+  Optional<std::function<void(StatusOr<i32>)>> background_init_waiter_;
+
   Optional<FlushState> flush_state_;
   Metrics metrics_;
   Optional<batt::Task> flush_task_;
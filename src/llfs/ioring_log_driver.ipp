@@ -40,7 +40,8 @@ inline BasicIoRingLogDriver<FlushOpImpl>::BasicIoRingLogDriver(
     , config_{config}
     , options_{options}
     , calculate_{config, options}
-    , ioring_{*IoRing::make_new(MaxQueueDepth{this->calculate().queue_depth() * 2})}
+    , ioring_{*IoRing::make_new(MaxQueueDepth{std::max<usize>(
+          this->calculate().queue_depth() * 2, IoRingLogRecovery::kDefaultReadAheadBlocks)})}
     , file_{this->ioring_, fd}
     , flush_ops_(std::max(usize{2}, this->calculate().queue_depth()))
 //                        ^ we require at least two flush ops for lazy init:
@@ -132,11 +133,18 @@ inline Status BasicIoRingLogDriver<FlushOpImpl>::read_log_data()
     this->ioring_.reset();
   });
 
+  // Keep up to a full recovery window of block reads in flight at once, so that recovery is bound
+  // by disk bandwidth rather than per-read latency.
+  //
   IoRingLogRecovery recovery{
       this->config_, this->context_.buffer_,
-      /*read_data_fn=*/[this](i64 file_offset, MutableBuffer buffer) -> Status {
-        return this->file_.read_all(file_offset + this->config_.physical_offset, buffer);
-      }};
+      /*async_read_data_fn=*/
+      [this](i64 file_offset, MutableBuffer buffer,
+             std::function<void(StatusOr<i32>)>&& handler) {
+        this->file_.async_read_some(file_offset + this->config_.physical_offset, buffer,
+                                    std::move(handler));
+      },
+      /*read_ahead_blocks=*/IoRingLogRecovery::kDefaultReadAheadBlocks};
 
   LLFS_VLOG(1) << "Starting log recovery..." << BATT_INSPECT(this->name_);
   Status recovery_status = recovery.run();
@@ -284,6 +292,7 @@ inline void BasicIoRingLogDriver<FlushOpImpl>::flush_task_main()
     this->ioring_.on_work_started();
     this->poll_flush_state();
     this->poll_commit_state();
+    this->poll_background_init();
 
     // Run the IoRing on a background thread so as not to tie up the executor on which this task
     // is running.
@@ -429,6 +438,88 @@ inline void BasicIoRingLogDriver<FlushOpImpl>::handle_commit_pos_update(
       }));
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <template <typename> class FlushOpImpl>
+inline void BasicIoRingLogDriver<FlushOpImpl>::poll_background_init()
+{
+  const usize blocks_ahead = this->options_.background_init_blocks_ahead;
+
+  if (blocks_ahead == 0 || this->background_init_block_ ||
+      this->foreground_writes_in_flight_ != 0 || this->halt_requested_.load()) {
+    return;
+  }
+
+  // Once every block has been written at least once, there is nothing left to do.
+  //
+  const usize block_count = this->calculate().block_count();
+  const usize init_upper_bound = this->get_init_upper_bound();
+  if (init_upper_bound >= block_count) {
+    return;
+  }
+
+  // Blocks are only uninitialized during the first pass through the log, so physical and logical
+  // block indices are the same.
+  //
+  const usize flush_block_index =
+      this->calculate().physical_block_index_from(SlotLowerBoundAt{this->get_flush_pos()});
+
+  if (init_upper_bound >= flush_block_index + blocks_ahead) {
+    return;
+  }
+
+  this->background_init_block_ = init_upper_bound;
+
+  PackedLogPageHeader& header = this->background_init_buffer_.header;
+
+  this->background_init_buffer_.clear();
+  header.reset(/*slot_offset=*/init_upper_bound * this->calculate().block_capacity());
+  header.trim_pos = this->get_trim_pos();
+  header.flush_pos = this->get_flush_pos();
+  header.commit_pos = this->get_commit_pos();
+
+  LLFS_VLOG(1) << "(driver=" << this->name_ << ") background init of block " << init_upper_bound
+               << BATT_INSPECT(flush_block_index);
+
+  this->file_.async_write_some(
+      this->calculate().block_start_file_offset_from(
+          LogBlockCalculator::PhysicalBlockIndex{init_upper_bound}),
+      this->background_init_buffer_.as_const_buffer(),
+      make_custom_alloc_handler(this->background_init_handler_memory_,
+                                [this](const StatusOr<i32>& result) {
+                                  this->handle_background_init(result);
+                                }));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <template <typename> class FlushOpImpl>
+inline void BasicIoRingLogDriver<FlushOpImpl>::handle_background_init(const StatusOr<i32>& result)
+{
+  BATT_CHECK(this->background_init_block_);
+
+  const usize block_index = *this->background_init_block_;
+  this->background_init_block_ = None;
+
+  // A failed (or short) write just leaves the block to be initialized by its flush op.
+  //
+  if (result.ok() && *result == sizeof(PackedLogPageBuffer)) {
+    this->metrics_.background_init_count.add(1);
+    this->update_init_upper_bound(LogBlockCalculator::PhysicalBlockIndex{block_index + 1});
+  } else {
+    LLFS_VLOG(1) << "(driver=" << this->name_ << ") background init of block " << block_index
+                 << " failed: " << result;
+  }
+
+  if (this->background_init_waiter_) {
+    auto waiter = std::move(*this->background_init_waiter_);
+    this->background_init_waiter_ = None;
+    waiter(result);
+  }
+
+  this->poll_background_init();
+}
+
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 // class FlushState
 //
@@ -15,10 +15,204 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#ifndef LLFS_DISABLE_IO_URING
+
+#include <llfs/filesystem.hpp>
+#include <llfs/ioring.hpp>
+#include <llfs/ioring_log_device.hpp>
+#include <llfs/log_device_config.hpp>
+#include <llfs/packed_log_page_header.hpp>
+#include <llfs/storage_context.hpp>
+#include <llfs/uuid.hpp>
+#include <llfs/varint.hpp>
+
+#include <batteries/async/runtime.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+#endif  // LLFS_DISABLE_IO_URING
+
 namespace {
 
+// Test Plan:
+//  1. (BackgroundInitBlocksAhead) With background_init_blocks_ahead = N, a lazily initialized log
+//     formats the N - 1 blocks after the flush position in the background: the blocks have valid
+//     (empty) headers on disk and are counted in background_init_count.  Data appended across the
+//     pre-initialized blocks is recovered intact after the log is closed and reopened.
+
+using namespace batt::int_types;
+using namespace batt::constants;
+
 TEST(IoringLogDriver, Test)
 {
 }
 
+#ifndef LLFS_DISABLE_IO_URING
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST(IoringLogDriver, BackgroundInitBlocksAhead)
+{
+  static_assert(llfs::kFastIoRingLogDeviceInit,
+                "This test requires lazily initialized log blocks");
+
+  const std::filesystem::path kFilePath = "/tmp/llfs_IoringLogDriverTest_BackgroundInit.llfs";
+
+  constexpr usize kLogSize = 64 * kKiB;
+  constexpr usize kPagesPerBlockLog2 = 1;
+  constexpr usize kBlocksAhead = 4;
+  constexpr usize kSlotSize = 300;
+  constexpr usize kSlotHeaderSize = 2;
+  constexpr usize kSlotBodySize = kSlotSize - kSlotHeaderSize;
+
+  static_assert(llfs::packed_sizeof_varint(kSlotBodySize) == kSlotHeaderSize);
+
+  const auto slot_fill_byte = [](usize slot_i) -> char {
+    return char('a' + slot_i % 26);
+  };
+
+  const boost::uuids::uuid log_uuid = llfs::random_uuid();
+
+  llfs::StatusOr<llfs::ScopedIoRing> scoped_ioring =
+      llfs::ScopedIoRing::make_new(llfs::MaxQueueDepth{256}, llfs::ThreadPoolSize{1});
+  ASSERT_TRUE(scoped_ioring.ok()) << BATT_INSPECT(scoped_ioring.status());
+
+  auto storage_context = batt::make_shared<llfs::StorageContext>(
+      batt::Runtime::instance().default_scheduler(), scoped_ioring->get_io_ring());
+
+  std::filesystem::remove_all(kFilePath);
+
+  llfs::Status add_file_status = storage_context->add_new_file(
+      kFilePath, [&](llfs::StorageFileBuilder& builder) -> llfs::Status {
+        BATT_REQUIRE_OK(builder.add_object(llfs::LogDeviceConfigOptions{
+            .uuid = log_uuid,
+            .pages_per_block_log2 = kPagesPerBlockLog2,
+            .log_size = kLogSize,
+        }));
+        return llfs::OkStatus();
+      });
+  ASSERT_TRUE(add_file_status.ok()) << BATT_INSPECT(add_file_status);
+
+  const auto open_log = [&]() -> std::unique_ptr<llfs::IoRingLogDevice> {
+    llfs::StatusOr<std::unique_ptr<llfs::IoRingLogDeviceFactory>> factory =
+        storage_context->recover_object(batt::StaticType<llfs::PackedLogDeviceConfig>{}, log_uuid,
+                                        llfs::IoRingLogDriverOptions::with_default_values()
+                                            .set_name("test_log")
+                                            .set_queue_depth(2)
+                                            .set_background_init_blocks_ahead(kBlocksAhead));
+    BATT_CHECK_OK(factory);
+
+    llfs::StatusOr<std::unique_ptr<llfs::IoRingLogDevice>> log_device =
+        (**factory).open_ioring_log_device();
+    BATT_CHECK_OK(log_device);
+
+    return std::move(*log_device);
+  };
+
+  const auto append_slots = [&](llfs::IoRingLogDevice& log_device, usize count,
+                                usize* total_size) {
+    llfs::LogDevice::Writer& writer = log_device.writer();
+    for (usize i = 0; i < count; ++i) {
+      llfs::StatusOr<llfs::MutableBuffer> buffer = writer.prepare(kSlotSize);
+      BATT_CHECK_OK(buffer);
+
+      // Recovery parses slot headers (a varint body size) to find the flush position.
+      //
+      u8* const first = static_cast<u8*>(buffer->data());
+      u8* const body = llfs::pack_varint_to(first, first + kSlotSize, kSlotBodySize);
+      BATT_CHECK_EQ(body, first + kSlotHeaderSize);
+      std::memset(body, slot_fill_byte(*total_size / kSlotSize), kSlotBodySize);
+
+      BATT_CHECK_OK(writer.commit(kSlotSize));
+      *total_size += kSlotSize;
+    }
+    BATT_CHECK_OK(
+        log_device.sync(llfs::LogReadMode::kDurable, llfs::SlotUpperBoundAt{*total_size}));
+  };
+
+  usize total_size = 0;
+  {
+    std::unique_ptr<llfs::IoRingLogDevice> log_device = open_log();
+    llfs::IoRingLogDriver& driver = log_device->driver().impl();
+
+    const usize block_capacity = driver.calculate().block_capacity();
+    ASSERT_LT(kSlotSize, block_capacity);
+    ASSERT_GT(driver.calculate().block_count(), kBlocksAhead * 2);
+
+    // Write less than one block; the next blocks should then be formatted in the background.
+    //
+    append_slots(*log_device, 1, &total_size);
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (driver.get_init_upper_bound() < kBlocksAhead &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    EXPECT_EQ(driver.get_init_upper_bound(), kBlocksAhead);
+    EXPECT_EQ(driver.metrics().background_init_count.load(), kBlocksAhead - 1);
+
+    // The pre-initialized blocks have valid, empty headers on disk.
+    //
+    for (usize block_i = 1; block_i < kBlocksAhead; ++block_i) {
+      llfs::PackedLogPageHeader header;
+      llfs::StatusOr<llfs::ConstBuffer> read = llfs::read_file(
+          kFilePath.string(), llfs::MutableBuffer{&header, sizeof(header)},
+          driver.calculate().block_start_file_offset_from(
+              llfs::LogBlockCalculator::PhysicalBlockIndex{block_i}));
+
+      ASSERT_TRUE(read.ok()) << BATT_INSPECT(read.status());
+      ASSERT_EQ(read->size(), sizeof(header));
+      EXPECT_EQ(header.magic, llfs::PackedLogPageHeader::kMagic) << BATT_INSPECT(block_i);
+      EXPECT_EQ(header.slot_offset, block_i * block_capacity) << BATT_INSPECT(block_i);
+      EXPECT_EQ(header.commit_size, 0u) << BATT_INSPECT(block_i);
+    }
+
+    // Fill the pre-initialized blocks (and then some) with data.
+    //
+    append_slots(*log_device, (kBlocksAhead + 1) * block_capacity / kSlotSize, &total_size);
+
+    ASSERT_TRUE(log_device->close().ok());
+  }
+
+  // Reopen the log; all the data must be recovered, and nothing past it.
+  //
+  {
+    std::unique_ptr<llfs::IoRingLogDevice> log_device = open_log();
+
+    EXPECT_EQ(log_device->slot_range(llfs::LogReadMode::kDurable),
+              (llfs::SlotRange{0, total_size}));
+
+    std::unique_ptr<llfs::LogDevice::Reader> reader =
+        log_device->new_reader(/*slot_lower_bound=*/llfs::None, llfs::LogReadMode::kDurable);
+
+    usize offset = 0;
+    while (offset < total_size) {
+      llfs::ConstBuffer data = reader->data();
+      ASSERT_GT(data.size(), 0u);
+
+      const usize n = std::min(data.size(), total_size - offset);
+      const char* bytes = static_cast<const char*>(data.data());
+      for (usize i = 0; i < n; ++i) {
+        if ((offset + i) % kSlotSize >= kSlotHeaderSize) {
+          ASSERT_EQ(bytes[i], slot_fill_byte((offset + i) / kSlotSize)) << BATT_INSPECT(offset + i);
+        }
+      }
+      reader->consume(n);
+      offset += n;
+    }
+
+    ASSERT_TRUE(log_device->close().ok());
+  }
+
+  std::filesystem::remove_all(kFilePath);
+}
+
+#endif  // LLFS_DISABLE_IO_URING
+
 }  // namespace
@@ -15,6 +15,7 @@
 #include <batteries/math.hpp>
 #include <batteries/stream_util.hpp>
 
+#include <algorithm>
 #include <atomic>
 #include <string>
 
@@ -46,9 +47,36 @@ class IoRingLogDriverOptions
   //
   std::string name = batt::to_string("(anonymous log ", next_id(), ")");
 
-  // How long to wait for a full page worth of log data before flushing to disk.
+  // How long to wait for a full page worth of log data before flushing to disk (group commit).
+  // When non-zero, a flush op holding a partially filled log block waits up to this long for more
+  // commits to arrive before writing the block.  Zero disables the delay.
   //
-  u32 page_write_buffer_delay_usec = 0;  // TODO [tastolfi 2021-06-21] remove or implement
+  u32 page_write_buffer_delay_usec = 0;
+
+  // The fraction (0.0 - 1.0) of a log block's capacity which, once filled, causes the block to be
+  // written immediately, without waiting for `page_write_buffer_delay_usec` to elapse.
+  //
+  double page_write_buffer_fill_target = 1.0;
+
+  // If non-zero, the most data (in bytes) a block is held for before it is written, whatever
+  // `page_write_buffer_fill_target` works out to.  This keeps the group commit delay from growing
+  // with the block size when large log blocks are used.
+  //
+  u64 page_write_buffer_fill_target_bytes = 0;
+
+  // If true, the group commit delay tracks the average observed flush write latency (but is never
+  // longer than `page_write_buffer_delay_usec`), so that fast devices are not slowed down by a
+  // fixed delay tuned for slow ones.
+  //
+  bool page_write_buffer_adaptive_delay = false;
+
+  // When non-zero, the driver formats not-yet-initialized log blocks in the background, up to this
+  // many blocks ahead of the flush position, so that flush ops rarely have to initialize the next
+  // block themselves before committing a full one.  Background writes are issued one at a time and
+  // only while no flush writes are in flight.  This only matters for logs created lazily (see
+  // kFastIoRingLogDeviceInit), where only the first block is formatted up front.
+  //
+  usize background_init_blocks_ahead = 0;
 
   // How many log segments to flush in parallel.
   //
@@ -78,6 +106,36 @@ class IoRingLogDriverOptions
     this->name = name;
     return *this;
   }
+
+  Self& set_background_init_blocks_ahead(usize n)
+  {
+    this->background_init_blocks_ahead = n;
+    return *this;
+  }
+
+  Self& set_page_write_buffer_delay_usec(u32 usec)
+  {
+    this->page_write_buffer_delay_usec = usec;
+    return *this;
+  }
+
+  Self& set_page_write_buffer_fill_target(double fraction)
+  {
+    this->page_write_buffer_fill_target = std::clamp(fraction, 0.0, 1.0);
+    return *this;
+  }
+
+  Self& set_page_write_buffer_fill_target_bytes(u64 n)
+  {
+    this->page_write_buffer_fill_target_bytes = n;
+    return *this;
+  }
+
+  Self& set_page_write_buffer_adaptive_delay(bool adaptive)
+  {
+    this->page_write_buffer_adaptive_delay = adaptive;
+    return *this;
+  }
 };
 
 }  // namespace llfs
@@ -17,6 +17,8 @@
 #include <llfs/data_layout.hpp>
 #include <llfs/int_types.hpp>
 #include <llfs/ioring.hpp>
+#include <llfs/ioring_log_driver_options.hpp>
+#include <llfs/log_append_metrics.hpp>
 #include <llfs/log_block_calculator.hpp>
 #include <llfs/metrics.hpp>
 #include <llfs/packed_log_page_buffer.hpp>
@@ -52,7 +54,8 @@ class BasicIoRingLogFlushOp
 
   struct Metrics {
     LatencyMetric write_latency;
-    CountMetric<u64> bytes_written{0};
+    StripedCountMetric<u64> bytes_written;
+    StripedCountMetric<u64> group_commit_delay_count;
   };
 
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -238,6 +241,51 @@ class BasicIoRingLogFlushOp
     });
   }
 
+  //----- --- -- -  -  -   -
+
+  // Invoked to resume this flush op once the driver has finished formatting this op's current
+  // block in the background (see IoRingLogDriverOptions::background_init_blocks_ahead).
+  //
+  void handle_background_init(const StatusOr<i32>& result);
+
+  auto get_background_init_handler()
+  {
+    return make_custom_alloc_handler(this->handler_memory_, [this](const StatusOr<i32>& result) {
+      this->handle_background_init(result);
+    });
+  }
+
+  //----- --- -- -  -  -   -
+
+  // Returns how long (usec) this op should wait for more commits before flushing a partially
+  // filled block whose data would extend to `known_commit_pos`; 0 means flush right away.
+  //
+  u64 get_group_commit_delay_usec(slot_offset_type known_commit_pos) const;
+
+  // Suspends this op for `delay_usec` so that more commits can be collected into the current block.
+  // This op will resume inside handle_group_commit_timeout.
+  //
+  void delay_flush(u64 delay_usec);
+
+  void handle_group_commit_timeout(const StatusOr<i32>& result);
+
+  auto get_group_commit_timeout_handler()
+  {
+    return make_custom_alloc_handler(this->handler_memory_, [this](const StatusOr<i32>& result) {
+      this->handle_group_commit_timeout(result);
+    });
+  }
+
+  //----- --- -- -  -  -   -
+
+  // Starts timing an asynchronous write; see `write_timer_` and `write_sample_start_`.
+  //
+  void start_write_timer();
+
+  // Stops timing the current asynchronous write (if any).
+  //
+  void stop_write_timer();
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   Metrics metrics_;
@@ -274,10 +322,26 @@ class BasicIoRingLogFlushOp
   //
   u64 block_capacity_ = 0;
 
+  // Group commit policy, cached from the driver options (see IoRingLogDriverOptions).
+  //
+  u64 group_commit_max_delay_usec_ = 0;
+  u64 group_commit_fill_target_ = 0;
+  bool group_commit_adaptive_ = false;
+
+  // Set when a group commit delay has just elapsed, so that the next call to handle_commit flushes
+  // whatever data is available.
+  //
+  bool group_commit_delay_expired_ = false;
+
   // Active only during an asynchronous write (flush) operation.
   //
   Optional<LatencyTimer> write_timer_;
 
+  // Set during an asynchronous write selected by LogAppendMetrics::sampler; used to update
+  // LogAppendMetrics::device_write_latency.
+  //
+  Optional<std::chrono::steady_clock::time_point> write_sample_start_;
+
   // Temporary storage to save the `commit_size` field of the header while writing on behalf of
   // flush_trim_pos().
   //
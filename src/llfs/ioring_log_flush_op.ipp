@@ -18,6 +18,9 @@
 
 #include <llfs/metrics.hpp>
 
+#include <algorithm>
+#include <utility>
+
 namespace llfs {
 
 #define THIS_VLOG(lvl)                                                                             \
@@ -117,6 +120,19 @@ inline void BasicIoRingLogFlushOp<DriverImpl>::initialize(DriverImpl* driver)
 
   this->block_capacity_ = driver->calculate().block_capacity();
 
+  {
+    const IoRingLogDriverOptions& options = driver->options();
+
+    this->group_commit_max_delay_usec_ = options.page_write_buffer_delay_usec;
+    this->group_commit_fill_target_ = static_cast<u64>(
+        std::clamp(options.page_write_buffer_fill_target, 0.0, 1.0) * this->block_capacity_);
+    if (options.page_write_buffer_fill_target_bytes != 0) {
+      this->group_commit_fill_target_ =
+          std::min(this->group_commit_fill_target_, options.page_write_buffer_fill_target_bytes);
+    }
+    this->group_commit_adaptive_ = options.page_write_buffer_adaptive_delay;
+  }
+
   THIS_VLOG(1) << "initialized";
 
   const auto metric_name = [&](std::string_view property) {
@@ -127,7 +143,11 @@ inline void BasicIoRingLogFlushOp<DriverImpl>::initialize(DriverImpl* driver)
 #define ADD_METRIC_(n) global_metric_registry().add(metric_name(#n), this->metrics_.n)
 
   ADD_METRIC_(write_latency);
-  ADD_METRIC_(bytes_written);
+
+  this->metrics_.bytes_written.add_to_registry(global_metric_registry(),
+                                               metric_name("bytes_written"));
+  this->metrics_.group_commit_delay_count.add_to_registry(global_metric_registry(),
+                                                          metric_name("group_commit_delay_count"));
 
 #undef ADD_METRIC_
 
@@ -139,9 +159,10 @@ inline void BasicIoRingLogFlushOp<DriverImpl>::initialize(DriverImpl* driver)
 template <typename DriverImpl>
 inline BasicIoRingLogFlushOp<DriverImpl>::~BasicIoRingLogFlushOp() noexcept
 {
-  global_metric_registry()  //
-      .remove(this->metrics_.write_latency)
-      .remove(this->metrics_.bytes_written);
+  global_metric_registry().remove(this->metrics_.write_latency);
+
+  this->metrics_.bytes_written.remove_from_registry(global_metric_registry());
+  this->metrics_.group_commit_delay_count.remove_from_registry(global_metric_registry());
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -169,8 +190,23 @@ inline void BasicIoRingLogFlushOp<DriverImpl>::handle_commit(slot_offset_type kn
                << BATT_INSPECT(header->slot_offset) << BATT_INSPECT(header->commit_size)
                << BATT_INSPECT(known_flush_pos);
 
+  // If the driver is formatting our (uninitialized) block in the background, we must not write to
+  // it concurrently; wait for the background write to finish and then try again.
+  //
+  if (!this->is_current_log_block_initialized() &&
+      this->driver_->is_background_init_in_progress(this->get_current_log_block_index())) {
+    THIS_VLOG(1) << "waiting for background init of the current block";
+
+    this->debug_info_message_ = "await_background_init";
+
+    this->driver_->async_wait_background_init(this->get_background_init_handler());
+    return;
+  }
+
   const bool have_data_to_flush = slot_less_than(known_flush_pos, known_commit_pos);
 
+  const bool group_commit_delay_expired = std::exchange(this->group_commit_delay_expired_, false);
+
   // We should only suspend this op waiting for data if the current log block is known to be
   // initialized; otherwise we continue and flush whatever data we have (even if it is zero bytes)
   // to unblock the previous flush op.
@@ -185,6 +221,17 @@ inline void BasicIoRingLogFlushOp<DriverImpl>::handle_commit(slot_offset_type kn
     return;
   }
 
+  // Group commit: rather than writing a block that is only a little fuller than last time, give
+  // other committers a chance to add to it first.
+  //
+  if (have_data_to_flush && !group_commit_delay_expired) {
+    const u64 delay_usec = this->get_group_commit_delay_usec(known_commit_pos);
+    if (delay_usec != 0) {
+      this->delay_flush(delay_usec);
+      return;
+    }
+  }
+
   // This may be false if we are flushing in order to (lazily) initialize the current log block
   // header.
   //
@@ -206,6 +253,124 @@ inline void BasicIoRingLogFlushOp<DriverImpl>::handle_commit(slot_offset_type kn
   }
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename DriverImpl>
+inline void BasicIoRingLogFlushOp<DriverImpl>::handle_background_init(const StatusOr<i32>& result)
+{
+  THIS_VLOG(1) << "handle_background_init(result=" << result << ")";
+
+  this->debug_info_message_ = "await_background_init completed";
+
+  // Whether or not the background write succeeded, the block is ours again; if it failed, we will
+  // initialize it ourselves.
+  //
+  this->handle_commit(this->driver_->get_commit_pos());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename DriverImpl>
+inline u64 BasicIoRingLogFlushOp<DriverImpl>::get_group_commit_delay_usec(
+    slot_offset_type known_commit_pos) const
+{
+  if (this->group_commit_max_delay_usec_ == 0) {
+    return 0;
+  }
+
+  // An uninitialized block must be flushed right away to unblock the previous flush op.
+  //
+  if (!this->is_current_log_block_initialized()) {
+    return 0;
+  }
+
+  PackedLogPageHeader* const header = this->get_header();
+
+  const u64 available_size =
+      std::min<u64>(known_commit_pos - header->slot_offset, this->block_capacity_);
+
+  if (available_size >= this->group_commit_fill_target_) {
+    return 0;
+  }
+
+  if (!this->group_commit_adaptive_) {
+    return this->group_commit_max_delay_usec_;
+  }
+
+  // In adaptive mode, wait about as long as a write takes; commits that arrive in that time would
+  // otherwise have had to wait for the write anyway.
+  //
+  const u64 write_count = this->metrics_.write_latency.count.load();
+  if (write_count == 0) {
+    return this->group_commit_max_delay_usec_;
+  }
+
+  const u64 average_write_usec = this->metrics_.write_latency.total_usec.load() / write_count;
+
+  return std::min<u64>(average_write_usec, this->group_commit_max_delay_usec_);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename DriverImpl>
+inline void BasicIoRingLogFlushOp<DriverImpl>::delay_flush(u64 delay_usec)
+{
+  THIS_VLOG(1) << "delay_flush(" << delay_usec << "usec)";
+
+  this->debug_info_message_ = "group_commit_delay";
+
+  this->metrics_.group_commit_delay_count.add(1);
+
+  this->driver_->async_wait_group_commit(delay_usec, this->get_group_commit_timeout_handler());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename DriverImpl>
+inline void BasicIoRingLogFlushOp<DriverImpl>::start_write_timer()
+{
+  this->write_timer_.emplace(this->metrics_.write_latency);
+
+  if (LogAppendMetrics::instance().sampler.sample()) {
+    this->write_sample_start_ = std::chrono::steady_clock::now();
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename DriverImpl>
+inline void BasicIoRingLogFlushOp<DriverImpl>::stop_write_timer()
+{
+  this->write_timer_ = None;
+
+  if (this->write_sample_start_) {
+    LogAppendMetrics::instance().device_write_latency.update(*this->write_sample_start_);
+    this->write_sample_start_ = None;
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename DriverImpl>
+inline void BasicIoRingLogFlushOp<DriverImpl>::handle_group_commit_timeout(
+    const StatusOr<i32>& result)
+{
+  THIS_VLOG(1) << "handle_group_commit_timeout(result=" << result << ")";
+
+  this->debug_info_message_ = "group_commit_delay completed";
+
+  // If the timer failed (e.g., it was cancelled because the IoRing is shutting down), don't leave
+  // this op suspended: flush right away, as if the delay had expired; any error that caused the
+  // timer to fail will be reported by the write.
+  //
+  if (!result.ok()) {
+    LLFS_VLOG(1) << "group commit delay failed: " << result.status();
+  }
+
+  this->group_commit_delay_expired_ = true;
+  this->handle_commit(this->driver_->get_commit_pos());
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 template <typename DriverImpl>
@@ -300,7 +465,7 @@ inline void BasicIoRingLogFlushOp<DriverImpl>::flush_tail()
 
   const i64 dst_file_offset = this->file_offset_ + unflushed_tail_offset;
 
-  this->write_timer_.emplace(this->metrics_.write_latency);
+  this->start_write_timer();
 
   this->driver_->async_write_some(dst_file_offset, unflushed_tail_data,
                                   /*buf_index=*/this->self_index(), this->get_flush_tail_handler());
@@ -379,7 +544,7 @@ inline void BasicIoRingLogFlushOp<DriverImpl>::flush_trim_pos(slot_offset_type k
 
   auto head_data = ConstBuffer{this->page_block_.get(), kLogAtomicWriteSize};
 
-  this->write_timer_.emplace(this->metrics_.write_latency);
+  this->start_write_timer();
 
   this->driver_->async_write_some(this->file_offset_, head_data, /*buf_index=*/this->self_index(),
                                   this->get_flush_trim_pos_handler());
@@ -455,7 +620,7 @@ inline void BasicIoRingLogFlushOp<DriverImpl>::flush_head()
 
   auto head_data = ConstBuffer{this->page_block_.get(), kLogAtomicWriteSize};
 
-  this->write_timer_.emplace(this->metrics_.write_latency);
+  this->start_write_timer();
 
   this->driver_->async_write_some(this->file_offset_, head_data, /*buf_index=*/this->self_index(),
                                   this->get_flush_head_handler());
@@ -548,7 +713,7 @@ template <typename DriverImpl>
 inline bool BasicIoRingLogFlushOp<DriverImpl>::handle_errors(const StatusOr<i32>& result,
                                                              WritingPart writing_part)
 {
-  this->write_timer_ = None;
+  this->stop_write_timer();
 
   if (!result.ok()) {
     if (batt::status_is_retryable(result.status())) {
@@ -572,7 +737,7 @@ inline bool BasicIoRingLogFlushOp<DriverImpl>::handle_errors(const StatusOr<i32>
     return true;
   }
 
-  this->metrics_.bytes_written.fetch_add(*result);
+  this->metrics_.bytes_written.add(*result);
 
   return false;
 }
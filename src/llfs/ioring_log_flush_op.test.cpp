@@ -36,6 +36,7 @@
 #include <boost/functional/hash.hpp>
 #include <boost/operators.hpp>
 
+#include <chrono>
 #include <memory>
 #include <thread>
 #include <unordered_map>
@@ -326,6 +327,9 @@ class IoRingLogFlushOpModel
 
     // Now the calculator has everything it needs.
     //
+    this->driver_options_ =
+        llfs::IoRingLogDriverOptions::with_default_values().set_queue_depth(this->queue_depth_);
+
     this->calculate_.emplace(
         llfs::IoRingLogConfig{
             .logical_size = this->log_size_,
@@ -333,8 +337,7 @@ class IoRingLogFlushOpModel
             .physical_size = this->physical_size_,
             .pages_per_block_log2 = this->pages_per_block_log2_,
         },
-        llfs::IoRingLogDriverOptions::with_default_values()  //
-            .set_queue_depth(this->queue_depth_));
+        this->driver_options_);
   }
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -346,6 +349,9 @@ class IoRingLogFlushOpModel
     EXPECT_CALL(*this->driver_, calculate())  //
         .WillRepeatedly(::testing::ReturnRef(*this->calculate_));
 
+    EXPECT_CALL(*this->driver_, options())  //
+        .WillRepeatedly(::testing::ReturnRef(this->driver_options_));
+
     EXPECT_CALL(*this->driver_, get_trim_pos())  //
         .WillRepeatedly(::testing::Invoke([this] {
           BATT_CHECK(this->fake_log_);
@@ -370,6 +376,9 @@ class IoRingLogFlushOpModel
     EXPECT_CALL(*this->driver_, index_of_flush_op(&*this->op_))  //
         .WillRepeatedly(::testing::Return(this->op_index_));
 
+    EXPECT_CALL(*this->driver_, is_background_init_in_progress(::testing::_))  //
+        .WillRepeatedly(::testing::Return(false));
+
     EXPECT_CALL(*this->driver_, update_durable_trim_pos(::testing::_))  //
         .WillRepeatedly(::testing::Invoke([this](slot_offset_type trim_pos) {
           llfs::clamp_min_slot(this->fake_log_->durable_trim_pos, trim_pos);
@@ -606,6 +615,8 @@ class IoRingLogFlushOpModel
   const usize max_failures_ = 2;
   usize failure_count_ = 0;
 
+  llfs::IoRingLogDriverOptions driver_options_;
+
   Optional<llfs::LogBlockCalculator> calculate_;
 
   std::unordered_map<usize, std::unique_ptr<llfs::RingBuffer>> ring_buffer_cache_;
@@ -636,6 +647,353 @@ TEST(IoRingLogFlushOpTest, StateMachineSimulation)
   LLFS_LOG_INFO() << result << BATT_INSPECT(step_count);
 }
 
+// Group Commit Test Plan:
+//
+//  1. With page_write_buffer_delay_usec == 0 (the default), a small commit is written immediately.
+//  2. A commit below the fill target is delayed for page_write_buffer_delay_usec; when the timer
+//     fires (successfully or not), everything committed in the meantime is written in one go.
+//  3. A full block is written immediately, even when a delay is configured.
+//  4. page_write_buffer_fill_target_bytes lowers the fill target.
+//  5. In adaptive mode, the delay is the maximum until a write has completed, and the average
+//     write latency (capped at the maximum) after that.
+//
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+//
+class IoRingLogFlushOpGroupCommitTest : public ::testing::Test
+{
+ public:
+  using FlushOp = llfs::BasicIoRingLogFlushOp<::testing::StrictMock<llfs::MockIoRingLogDriver>>;
+
+  struct PendingWrite {
+    ConstBuffer data;
+    std::function<void(StatusOr<i32>)> handler;
+  };
+
+  struct PendingDelay {
+    u64 delay_usec;
+    std::function<void(StatusOr<i32>)> handler;
+  };
+
+  static constexpr u64 kLogSize = 4 * kKiB;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  // Creates the flush op-under-test using `this->driver_options`, and activates it.
+  //
+  void start_op()
+  {
+    this->calculate.emplace(
+        llfs::IoRingLogConfig{
+            .logical_size = kLogSize,
+            .physical_offset = 0,
+            .physical_size = llfs::LogBlockCalculator::disk_size_required_for_log_size(
+                kLogSize, llfs::kLogPageSize),
+            .pages_per_block_log2 = 0,
+        },
+        this->driver_options);
+
+    EXPECT_CALL(this->driver, calculate())  //
+        .WillRepeatedly(::testing::ReturnRef(*this->calculate));
+
+    EXPECT_CALL(this->driver, options())  //
+        .WillRepeatedly(::testing::ReturnRef(this->driver_options));
+
+    EXPECT_CALL(this->driver, get_trim_pos())  //
+        .WillRepeatedly(::testing::Return(0));
+
+    EXPECT_CALL(this->driver, get_flush_pos())  //
+        .WillRepeatedly(::testing::Return(0));
+
+    EXPECT_CALL(this->driver, get_commit_pos())  //
+        .WillRepeatedly(::testing::Invoke([this] {
+          return this->commit_pos;
+        }));
+
+    EXPECT_CALL(this->driver, get_data(::testing::_))  //
+        .WillRepeatedly(::testing::Invoke([](slot_offset_type slot_offset) {
+          return IoRingLogFlushOpModel::fake_log_data() + slot_offset;
+        }));
+
+    EXPECT_CALL(this->driver, name())  //
+        .WillRepeatedly(::testing::Return(llfs::MockIoRingLogDriver::default_name()));
+
+    EXPECT_CALL(this->driver, index_of_flush_op(::testing::_))  //
+        .WillRepeatedly(::testing::Return(0));
+
+    EXPECT_CALL(this->driver, is_background_init_in_progress(::testing::_))  //
+        .WillRepeatedly(::testing::Return(false));
+
+    EXPECT_CALL(this->driver, get_init_upper_bound())  //
+        .WillRepeatedly(::testing::Return(this->calculate->block_count()));
+
+    EXPECT_CALL(this->driver, update_init_upper_bound(::testing::_))  //
+        .WillRepeatedly(::testing::Return());
+
+    EXPECT_CALL(this->driver, update_durable_trim_pos(::testing::_))  //
+        .WillRepeatedly(::testing::Return());
+
+    EXPECT_CALL(this->driver, get_durable_trim_pos())  //
+        .WillRepeatedly(::testing::Return(0));
+
+    EXPECT_CALL(this->driver, poll_flush_state())  //
+        .WillRepeatedly(::testing::Return());
+
+    EXPECT_CALL(this->driver, wait_for_commit(::testing::_))
+        .WillRepeatedly(::testing::Invoke([this](slot_offset_type least_upper_bound) {
+          EXPECT_FALSE(this->waiting_for_commit);
+          this->waiting_for_commit = least_upper_bound;
+        }));
+
+    EXPECT_CALL(this->driver, async_write_some(::testing::_, ::testing::_, ::testing::_,
+                                               ::testing::_))
+        .WillRepeatedly(::testing::Invoke([this](i64 /*log_offset*/, const ConstBuffer& data,
+                                                 i32 /*buf_index*/,
+                                                 std::function<void(StatusOr<i32>)> handler) {
+          EXPECT_FALSE(this->pending_write);
+          this->pending_write.emplace(PendingWrite{data, std::move(handler)});
+        }));
+
+    EXPECT_CALL(this->driver, async_wait_group_commit(::testing::_, ::testing::_))
+        .WillRepeatedly(::testing::Invoke(
+            [this](u64 delay_usec, std::function<void(StatusOr<i32>)> handler) {
+              EXPECT_FALSE(this->pending_delay);
+              this->pending_delay.emplace(PendingDelay{delay_usec, std::move(handler)});
+            }));
+
+    this->op.emplace();
+    this->op->initialize(&this->driver);
+    this->op->activate();
+
+    ASSERT_EQ(this->waiting_for_commit, Optional<slot_offset_type>{1});
+  }
+
+  // Simulates appending `n` bytes to the log and waking up the op.
+  //
+  void commit(u64 n)
+  {
+    this->commit_pos += n;
+
+    if (this->waiting_for_commit && *this->waiting_for_commit <= this->commit_pos) {
+      this->waiting_for_commit = None;
+      this->op->handle_commit(this->commit_pos);
+    }
+  }
+
+  // Completes the pending group commit timer with the given result.
+  //
+  void expire_delay(StatusOr<i32> result = StatusOr<i32>{0})
+  {
+    ASSERT_TRUE(this->pending_delay);
+
+    auto handler = std::move(this->pending_delay->handler);
+    this->pending_delay = None;
+
+    handler(result);
+  }
+
+  // Completes the pending write successfully.
+  //
+  void complete_write()
+  {
+    ASSERT_TRUE(this->pending_write);
+
+    auto handler = std::move(this->pending_write->handler);
+    const i32 size = BATT_CHECKED_CAST(i32, this->pending_write->data.size());
+    this->pending_write = None;
+
+    handler(size);
+  }
+
+  u64 commit_size() const
+  {
+    return this->op->get_header()->commit_size;
+  }
+
+  u64 delay_count() const
+  {
+    return this->op->metrics().group_commit_delay_count.load();
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  llfs::IoRingLogDriverOptions driver_options =
+      llfs::IoRingLogDriverOptions::with_default_values().set_queue_depth(1);
+
+  Optional<llfs::LogBlockCalculator> calculate;
+
+  ::testing::StrictMock<llfs::MockIoRingLogDriver> driver;
+
+  Optional<FlushOp> op;
+
+  slot_offset_type commit_pos = 0;
+
+  Optional<slot_offset_type> waiting_for_commit;
+
+  Optional<PendingWrite> pending_write;
+
+  Optional<PendingDelay> pending_delay;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST_F(IoRingLogFlushOpGroupCommitTest, NoDelayByDefault)
+{
+  ASSERT_NO_FATAL_FAILURE(this->start_op());
+
+  this->commit(100);
+
+  ASSERT_TRUE(this->pending_write);
+  EXPECT_FALSE(this->pending_delay);
+  EXPECT_EQ(this->commit_size(), 100u);
+  EXPECT_EQ(this->delay_count(), 0u);
+
+  ASSERT_NO_FATAL_FAILURE(this->complete_write());
+
+  EXPECT_EQ(this->waiting_for_commit, Optional<slot_offset_type>{101});
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST_F(IoRingLogFlushOpGroupCommitTest, DelayBelowFillTarget)
+{
+  this->driver_options.set_page_write_buffer_delay_usec(500);
+
+  ASSERT_NO_FATAL_FAILURE(this->start_op());
+
+  this->commit(100);
+
+  ASSERT_TRUE(this->pending_delay);
+  EXPECT_EQ(this->pending_delay->delay_usec, 500u);
+  EXPECT_FALSE(this->pending_write);
+  EXPECT_EQ(this->delay_count(), 1u);
+
+  // Data committed while the op is delayed is picked up when the timer fires.
+  //
+  this->commit(100);
+
+  EXPECT_FALSE(this->pending_write);
+
+  ASSERT_NO_FATAL_FAILURE(this->expire_delay());
+
+  ASSERT_TRUE(this->pending_write);
+  EXPECT_EQ(this->commit_size(), 200u);
+
+  ASSERT_NO_FATAL_FAILURE(this->complete_write());
+
+  EXPECT_EQ(this->waiting_for_commit, Optional<slot_offset_type>{201});
+
+  // The next small commit is delayed again; a failed timer must not leave the op suspended.
+  //
+  this->commit(100);
+
+  ASSERT_TRUE(this->pending_delay);
+  EXPECT_EQ(this->delay_count(), 2u);
+
+  ASSERT_NO_FATAL_FAILURE(
+      this->expire_delay(StatusOr<i32>{Status{batt::StatusCode::kCancelled}}));
+
+  ASSERT_TRUE(this->pending_write);
+  EXPECT_EQ(this->commit_size(), 300u);
+  EXPECT_EQ(this->delay_count(), 2u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 3.
+//
+TEST_F(IoRingLogFlushOpGroupCommitTest, FullBlockFlushesImmediately)
+{
+  this->driver_options.set_page_write_buffer_delay_usec(500);
+
+  ASSERT_NO_FATAL_FAILURE(this->start_op());
+
+  const u64 block_capacity = this->calculate->block_capacity();
+
+  this->commit(block_capacity + 100);
+
+  ASSERT_TRUE(this->pending_write);
+  EXPECT_FALSE(this->pending_delay);
+  EXPECT_EQ(this->commit_size(), block_capacity);
+  EXPECT_EQ(this->delay_count(), 0u);
+
+  // Once the full block is durable, the op moves on to the next block, where the remaining 100
+  // bytes are below the fill target.
+  //
+  ASSERT_NO_FATAL_FAILURE(this->complete_write());
+
+  ASSERT_TRUE(this->pending_delay);
+  EXPECT_FALSE(this->pending_write);
+  EXPECT_EQ(this->delay_count(), 1u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 4.
+//
+TEST_F(IoRingLogFlushOpGroupCommitTest, FillTargetBytes)
+{
+  this->driver_options  //
+      .set_page_write_buffer_delay_usec(500)
+      .set_page_write_buffer_fill_target_bytes(256);
+
+  ASSERT_NO_FATAL_FAILURE(this->start_op());
+
+  this->commit(200);
+
+  ASSERT_TRUE(this->pending_delay);
+  EXPECT_FALSE(this->pending_write);
+  EXPECT_EQ(this->delay_count(), 1u);
+
+  ASSERT_NO_FATAL_FAILURE(this->expire_delay());
+  ASSERT_NO_FATAL_FAILURE(this->complete_write());
+
+  // The fill target is measured from the start of the block, so this commit reaches it.
+  //
+  this->commit(56);
+
+  ASSERT_TRUE(this->pending_write);
+  EXPECT_FALSE(this->pending_delay);
+  EXPECT_EQ(this->commit_size(), 256u);
+  EXPECT_EQ(this->delay_count(), 1u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 5.
+//
+TEST_F(IoRingLogFlushOpGroupCommitTest, AdaptiveDelay)
+{
+  constexpr u64 kMaxDelayUsec = 1000 * 1000;
+
+  this->driver_options  //
+      .set_page_write_buffer_delay_usec(kMaxDelayUsec)
+      .set_page_write_buffer_adaptive_delay(true);
+
+  ASSERT_NO_FATAL_FAILURE(this->start_op());
+
+  // No writes have completed yet, so there is no latency estimate: use the maximum.
+  //
+  this->commit(100);
+
+  ASSERT_TRUE(this->pending_delay);
+  EXPECT_EQ(this->pending_delay->delay_usec, kMaxDelayUsec);
+
+  ASSERT_NO_FATAL_FAILURE(this->expire_delay());
+  ASSERT_TRUE(this->pending_write);
+
+  // Make the write take (at least) 5ms.
+  //
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+  ASSERT_NO_FATAL_FAILURE(this->complete_write());
+
+  this->commit(100);
+
+  ASSERT_TRUE(this->pending_delay);
+  EXPECT_GE(this->pending_delay->delay_usec, 5000u);
+  EXPECT_LT(this->pending_delay->delay_usec, kMaxDelayUsec);
+  EXPECT_EQ(this->delay_count(), 2u);
+}
+
 }  // namespace
 
 #endif  // LLFS_DISABLE_IO_URING
@@ -17,6 +17,7 @@
 
 #include <llfs/buffer.hpp>
 #include <llfs/int_types.hpp>
+#include <llfs/ioring_log_driver_options.hpp>
 #include <llfs/ioring_log_flush_op.hpp>
 #include <llfs/ioring_log_flush_op.ipp>
 #include <llfs/log_block_calculator.hpp>
@@ -53,6 +54,8 @@ class MockIoRingLogDriver
 
   MOCK_METHOD(const LogBlockCalculator&, calculate, (), (const));
 
+  MOCK_METHOD(const IoRingLogDriverOptions&, options, (), (const));
+
   MOCK_METHOD(slot_offset_type, get_trim_pos, (), (const));
 
   MOCK_METHOD(slot_offset_type, get_flush_pos, (), (const));
@@ -73,6 +76,9 @@ class MockIoRingLogDriver
 
   MOCK_METHOD(void, wait_for_commit, (slot_offset_type least_upper_bound), ());
 
+  MOCK_METHOD(void, async_wait_group_commit,
+              (u64 delay_usec, std::function<void(StatusOr<i32>)> handler), ());
+
   MOCK_METHOD(void, poll_flush_state, (), ());
 
   MOCK_METHOD(void, update_init_upper_bound, (LogBlockCalculator::PhysicalBlockIndex), ());
@@ -82,6 +88,11 @@ class MockIoRingLogDriver
   MOCK_METHOD(void, async_wait_init_upper_bound,
               (usize last_known_value, std::function<void(StatusOr<usize>)> handler), ());
 
+  MOCK_METHOD(bool, is_background_init_in_progress, (LogBlockCalculator::PhysicalBlockIndex),
+              (const));
+
+  MOCK_METHOD(void, async_wait_background_init, (std::function<void(StatusOr<i32>)> handler), ());
+
   MOCK_METHOD(void, update_durable_trim_pos, (slot_offset_type pos), ());
 
   MOCK_METHOD(slot_offset_type, get_durable_trim_pos, (), (const));
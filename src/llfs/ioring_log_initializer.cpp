@@ -16,6 +16,8 @@
 
 #include <batteries/metrics/metric_collectors.hpp>
 
+#include <mutex>
+
 namespace llfs {
 
 template class BasicIoRingLogInitializer<IoRing>;
@@ -42,6 +44,14 @@ Status initialize_ioring_log_device(RawBlockFile& file, const IoRingLogConfig& c
     }();
 
     if (ioring_file) {
+      // The initializer registers its fd and buffers with the IoRing (replacing any that are
+      // already registered) and unregisters them when done, so two initializers can't share a
+      // ring; e.g. StorageFileBuilder::flush_all formats several logs in one file concurrently.
+      // Log init only writes a few blocks, so serializing all of them is cheap.
+      //
+      static std::mutex init_mutex;
+      std::unique_lock<std::mutex> init_lock{init_mutex};
+
       IoRingLogInitializer initializer{/*n_tasks=*/std::min<usize>(1024, n_blocks_to_init),
                                        *ioring_file, config, n_blocks_to_init};
 
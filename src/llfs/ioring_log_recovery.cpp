@@ -11,19 +11,47 @@
 #include <llfs/data_reader.hpp>
 #include <llfs/logging.hpp>
 
+#include <batteries/checked_cast.hpp>
+#include <batteries/finally.hpp>
 #include <batteries/stream_util.hpp>
 
+#include <algorithm>
+
 namespace llfs {
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 /*explicit*/ IoRingLogRecovery::IoRingLogRecovery(const IoRingLogConfig& config,
                                                   RingBuffer& ring_buffer, ReadDataFn&& read_data)
+    : IoRingLogRecovery{
+          config, ring_buffer,
+          /*async_read_data=*/
+          [read_data = std::move(read_data)](i64 file_offset, MutableBuffer dst_buffer,
+                                             std::function<void(StatusOr<i32>)>&& handler) {
+            Status status = read_data(file_offset, dst_buffer);
+            if (!status.ok()) {
+              handler(status);
+            } else {
+              handler(BATT_CHECKED_CAST(i32, dst_buffer.size()));
+            }
+          },
+          /*read_ahead_blocks=*/1}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ IoRingLogRecovery::IoRingLogRecovery(const IoRingLogConfig& config,
+                                                  RingBuffer& ring_buffer,
+                                                  AsyncReadDataFn&& async_read_data,
+                                                  usize read_ahead_blocks)
     : config_{config}
     , ring_buffer_{ring_buffer}
-    , read_data_{std::move(read_data)}
-    , block_storage_{
-          new PackedLogPageBuffer[this->config_.block_size() / sizeof(PackedLogPageBuffer)]}
+    , async_read_data_{std::move(async_read_data)}
+    , read_ahead_blocks_{std::max<usize>(1, read_ahead_blocks)}
+    , block_storage_{new PackedLogPageBuffer[this->read_ahead_blocks_ * this->config_.block_size() /
+                                             sizeof(PackedLogPageBuffer)]}
+    , block_reads_{new BlockRead[this->read_ahead_blocks_]}
 {
   BATT_CHECK_EQ(this->config_.block_size() % sizeof(PackedLogPageBuffer), 0u);
 }
@@ -32,36 +60,63 @@ namespace llfs {
 //
 Status IoRingLogRecovery::run()
 {
-  LLFS_VLOG(1) << "IoRingLogRecovery::run()";
-  i64 file_offset = 0;
+  LLFS_VLOG(1) << "IoRingLogRecovery::run()" << BATT_INSPECT(this->read_ahead_blocks_);
   Optional<slot_offset_type> old_trim_pos = this->trim_pos_;
 
   usize known_valid_blocks = 1;
   const usize block_count = this->config_.block_count();
   const usize wrap_around_size = block_count * this->config_.block_capacity();
 
-  for (usize block_i = 0; block_i < known_valid_blocks;
-       ++block_i, file_offset += this->config_.block_size()) {
-    //----- --- -- -  -  -   -
-    LLFS_VLOG(2) << "Reading " << BATT_INSPECT(block_i) << "/" << block_count << " from "
-                 << BATT_INSPECT(file_offset);
+  // Reads are started speculatively up to `read_ahead_blocks_` past the block currently being
+  // scanned; all of them must finish before we return, since they target our block storage.
+  //
+  usize next_block_to_read = 0;
+  usize next_block_to_await = 0;
 
+  const auto drain_reads = batt::finally([&] {
+    for (; next_block_to_await < next_block_to_read; ++next_block_to_await) {
+      this->await_block_read(next_block_to_await).IgnoreError();
+    }
+  });
+
+  for (usize block_i = 0; block_i < known_valid_blocks; ++block_i) {
+    //----- --- -- -  -  -   -
     BATT_CHECK_LE(known_valid_blocks, block_count);
 
-    // Read the next block into the buffer.
+    // Keep the read-ahead window full.  Reads past the end of the valid data are harmless; their
+    // results are ignored.
     //
-    Status read_status = this->read_data_(file_offset, this->block_buffer());
-    BATT_REQUIRE_OK(read_status);
+    while (next_block_to_read < block_count &&
+           next_block_to_read < block_i + this->read_ahead_blocks_) {
+      this->start_block_read(next_block_to_read);
+      ++next_block_to_read;
+    }
+
+    LLFS_VLOG(2) << "Reading " << BATT_INSPECT(block_i) << "/" << block_count << " from "
+                 << "file_offset=" << this->block_reads_[this->slot_of(block_i)].file_offset;
+
+    // Wait for the block to be read into the buffer and its header checked.
+    //
+    BATT_CHECK_EQ(next_block_to_await, block_i);
+    Status block_status = this->await_block_read(block_i);
+    ++next_block_to_await;
+
+    if (block_status == make_status(StatusCode::kLogBlockBadMagic)) {
+      LLFS_LOG_ERROR() << "Bad magic number;" << BATT_INSPECT(this->block_header(block_i));
+    }
+    BATT_REQUIRE_OK(block_status);
+
+    const PackedLogPageHeader& header = this->block_header(block_i);
 
     // Update the known_valid_blocks count.
     //
     if (known_valid_blocks < block_count) {
-      if (this->block_header().slot_offset >= wrap_around_size) {
+      if (header.slot_offset >= wrap_around_size) {
         LLFS_VLOG(1) << " -- block slot_offset over (" << BATT_INSPECT(wrap_around_size)
                      << " ); setting known_valid_blocks to " << BATT_INSPECT(block_count);
         known_valid_blocks = block_count;
       } else {
-        if (this->block_header().commit_size == this->config_.block_capacity()) {
+        if (header.commit_size == this->config_.block_capacity()) {
           BATT_CHECK_GT(block_i + 2, known_valid_blocks);
           LLFS_VLOG(2) << " -- block is full; known_valid_blocks = " << known_valid_blocks << " -> "
                        << (block_i + 2);
@@ -70,14 +125,9 @@ Status IoRingLogRecovery::run()
       }
     }
 
-    // Run data integrity checks.
-    //
-    Status block_valid = this->validate_block();
-    BATT_REQUIRE_OK(block_valid);
-
     // Update the trim position (this must be valid later when we find the "true" flush_pos).
     //
-    clamp_min_slot(&this->trim_pos_, this->block_header().trim_pos);
+    clamp_min_slot(&this->trim_pos_, header.trim_pos);
     if (this->trim_pos_ != old_trim_pos) {
       LLFS_VLOG(1) << "Updating trim_pos: " << old_trim_pos << " => " << this->trim_pos_;
       old_trim_pos = this->trim_pos_;
@@ -87,7 +137,7 @@ Status IoRingLogRecovery::run()
 
     // Copy data from this block into the ring buffer, if possible.
     //
-    this->recover_block_data();
+    this->recover_block_data(block_i);
   }
 
   // Scan recovered data to find the true flushed upper bound.
@@ -106,13 +156,102 @@ Status IoRingLogRecovery::run()
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-Status IoRingLogRecovery::validate_block() const
+void IoRingLogRecovery::start_block_read(usize block_i)
 {
-  if (this->block_header().magic != PackedLogPageHeader::kMagic) {
-    LLFS_LOG_ERROR() << "Bad magic number;" << BATT_INSPECT(this->block_header());
+  const usize slot = this->slot_of(block_i);
+  BlockRead& read = this->block_reads_[slot];
+
+  read.block_i = block_i;
+  read.file_offset = BATT_CHECKED_CAST(i64, block_i * this->config_.block_size());
+  read.remaining = this->block_buffer(block_i);
+  read.status = OkStatus();
+  read.done.store(false);
+
+  this->continue_block_read(slot);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingLogRecovery::continue_block_read(usize slot)
+{
+  BlockRead& read = this->block_reads_[slot];
+
+  this->async_read_data_(read.file_offset, read.remaining, [this, slot](StatusOr<i32> result) {
+    this->handle_block_read(slot, result);
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingLogRecovery::handle_block_read(usize slot, const StatusOr<i32>& result)
+{
+  BlockRead& read = this->block_reads_[slot];
+
+  if (!result.ok()) {
+    this->finish_block_read(slot, result.status());
+    return;
+  }
+
+  if (*result == 0) {
+    this->finish_block_read(slot, batt::StatusCode::kOutOfRange);
+    return;
+  }
+
+  BATT_CHECK_LE(static_cast<usize>(*result), read.remaining.size());
+
+  read.file_offset += *result;
+  read.remaining += *result;
+
+  if (read.remaining.size() != 0) {
+    this->continue_block_read(slot);
+    return;
+  }
+
+  // The whole block is loaded; check the header now, while other reads are still in flight.
+  //
+  this->finish_block_read(slot, this->validate_block(read.block_i));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingLogRecovery::finish_block_read(usize slot, Status status)
+{
+  BlockRead& read = this->block_reads_[slot];
+
+  read.status = std::move(status);
+  read.done.store(true);
+
+  this->read_completion_count_.fetch_add(1);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status IoRingLogRecovery::await_block_read(usize block_i)
+{
+  BlockRead& read = this->block_reads_[this->slot_of(block_i)];
+
+  for (;;) {
+    const u64 observed_count = this->read_completion_count_.get_value();
+    if (read.done.load()) {
+      break;
+    }
+    StatusOr<u64> new_count = this->read_completion_count_.await_not_equal(observed_count);
+    BATT_REQUIRE_OK(new_count);
+  }
+
+  return read.status;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status IoRingLogRecovery::validate_block(usize block_i) const
+{
+  const PackedLogPageHeader& header = this->block_header(block_i);
+
+  if (header.magic != PackedLogPageHeader::kMagic) {
     return make_status(StatusCode::kLogBlockBadMagic);
   }
-  if (this->block_header().commit_size > this->config_.block_capacity()) {
+  if (header.commit_size > this->config_.block_capacity()) {
     return make_status(StatusCode::kLogBlockCommitSizeOverflow);
   }
 
@@ -121,23 +260,27 @@ Status IoRingLogRecovery::validate_block() const
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-MutableBuffer IoRingLogRecovery::block_buffer()
+MutableBuffer IoRingLogRecovery::block_buffer(usize block_i)
 {
-  return MutableBuffer{(void*)this->block_storage_.get(), this->config_.block_size()};
+  return MutableBuffer{
+      (u8*)this->block_storage_.get() + this->slot_of(block_i) * this->config_.block_size(),
+      this->config_.block_size()};
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-const PackedLogPageHeader& IoRingLogRecovery::block_header() const
+const PackedLogPageHeader& IoRingLogRecovery::block_header(usize block_i) const
 {
-  return this->block_storage_[0].header;
+  const usize pages_per_block = this->config_.block_size() / sizeof(PackedLogPageBuffer);
+
+  return this->block_storage_[this->slot_of(block_i) * pages_per_block].header;
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-void IoRingLogRecovery::recover_block_data()
+void IoRingLogRecovery::recover_block_data(usize block_i)
 {
-  const auto& header = this->block_header();
+  const auto& header = this->block_header(block_i);
 
   LLFS_VLOG(1) << "IoRingLogRecovery::recover_block_data()" << BATT_INSPECT(header);
 
@@ -170,7 +313,7 @@ void IoRingLogRecovery::recover_block_data()
       .upper_bound = BATT_CHECKED_CAST(isize, end_offset),
   };
 
-  ConstBuffer data = this->block_payload();
+  ConstBuffer data = this->block_payload(block_i);
 
   // It may seem cumbersome to explicitly account for buffer wrap-around here, potentially
   // splitting our logical data slice into multiple parts, but handling that here helps prevent
@@ -297,10 +440,11 @@ void IoRingLogRecovery::recover_flush_pos()
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-ConstBuffer IoRingLogRecovery::block_payload() const
+ConstBuffer IoRingLogRecovery::block_payload(usize block_i) const
 {
-  return ConstBuffer{this->block_storage_.get(),
-                     sizeof(PackedLogPageHeader) + this->block_header().commit_size} +
+  const PackedLogPageHeader& header = this->block_header(block_i);
+
+  return ConstBuffer{&header, sizeof(PackedLogPageHeader) + header.commit_size} +
          sizeof(PackedLogPageHeader);
 }
 
@@ -20,20 +20,44 @@
 #include <llfs/slot_interval_map.hpp>
 #include <llfs/status.hpp>
 
+#include <batteries/async/watch.hpp>
+
+#include <atomic>
 #include <functional>
+#include <memory>
 
 namespace llfs {
 
 /*! \brief Manages log data and state recovery from on-disk information.
+ *
+ * Log blocks are read ahead of the recovery scan, up to `read_ahead_blocks` at a time; each block's
+ * header is validated as soon as its read completes, while the scan itself (which must process
+ * blocks in order) copies data into the ring buffer.
  */
 class IoRingLogRecovery
 {
  public:
   using ReadDataFn = std::function<Status(i64 file_offset, MutableBuffer dst_buffer)>;
 
+  /*! \brief Starts reading some prefix of `dst_buffer`; `handler` is passed the number of bytes
+   * read, or an error status.  The handler may be invoked on any thread.
+   */
+  using AsyncReadDataFn = std::function<void(i64 file_offset, MutableBuffer dst_buffer,
+                                             std::function<void(StatusOr<i32>)>&& handler)>;
+
+  static constexpr usize kDefaultReadAheadBlocks = 64;
+
+  /*! \brief Creates a recovery object that reads one block at a time using a blocking function.
+   */
   explicit IoRingLogRecovery(const IoRingLogConfig& config, RingBuffer& ring_buffer,
                              ReadDataFn&& read_data);
 
+  /*! \brief Creates a recovery object that keeps up to `read_ahead_blocks` block reads in flight.
+   */
+  explicit IoRingLogRecovery(const IoRingLogConfig& config, RingBuffer& ring_buffer,
+                             AsyncReadDataFn&& async_read_data,
+                             usize read_ahead_blocks = kDefaultReadAheadBlocks);
+
   Status run();
 
   slot_offset_type get_trim_pos() const
@@ -46,16 +70,51 @@ class IoRingLogRecovery
     return this->flush_pos_.value_or(this->get_trim_pos());
   }
 
+  usize read_ahead_blocks() const
+  {
+    return this->read_ahead_blocks_;
+  }
+
  private:
-  Status validate_block() const;
+  /*! \brief The state of an in-flight (or completed) read of a single log block.
+   */
+  struct BlockRead {
+    usize block_i = 0;
+    i64 file_offset = 0;
+    MutableBuffer remaining;
+    Status status;
+    std::atomic<bool> done{false};
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  usize slot_of(usize block_i) const
+  {
+    return block_i % this->read_ahead_blocks_;
+  }
 
-  MutableBuffer block_buffer();
+  void start_block_read(usize block_i);
 
-  const PackedLogPageHeader& block_header() const;
+  void continue_block_read(usize slot);
 
-  ConstBuffer block_payload() const;
+  void handle_block_read(usize slot, const StatusOr<i32>& result);
 
-  void recover_block_data();
+  void finish_block_read(usize slot, Status status);
+
+  // Blocks until the read of the given block completes; returns the read status, or the result of
+  // header validation if the read succeeded.
+  //
+  Status await_block_read(usize block_i);
+
+  Status validate_block(usize block_i) const;
+
+  MutableBuffer block_buffer(usize block_i);
+
+  const PackedLogPageHeader& block_header(usize block_i) const;
+
+  ConstBuffer block_payload(usize block_i) const;
+
+  void recover_block_data(usize block_i);
 
   void recover_flush_pos();
 
@@ -71,7 +130,11 @@ class IoRingLogRecovery
 
   // Callback used to read data into the block storage buffer; passed in at creation time.
   //
-  ReadDataFn read_data_;
+  AsyncReadDataFn async_read_data_;
+
+  // The maximum number of block reads in flight at once.
+  //
+  const usize read_ahead_blocks_;
 
   // The maximum trim_pos field value read from all valid block headers.
   //
@@ -81,10 +144,19 @@ class IoRingLogRecovery
   //
   Optional<slot_offset_type> flush_pos_;
 
-  // The memory used to load individual log blocks.
+  // The memory used to load individual log blocks; block `i` is loaded into slot
+  // `i % read_ahead_blocks_`.
   //
   std::unique_ptr<PackedLogPageBuffer[]> block_storage_;
 
+  // Per-slot read state.
+  //
+  std::unique_ptr<BlockRead[]> block_reads_;
+
+  // Incremented each time a block read completes, to wake up `await_block_read`.
+  //
+  batt::Watch<u64> read_completion_count_{0};
+
   SlotIntervalMap latest_slot_range_;
 
   SlotIntervalMap committed_data_;
@@ -0,0 +1,367 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/ioring_log_recovery.hpp>
+//
+#include <llfs/ioring_log_recovery.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/constants.hpp>
+#include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/packed_log_page_header.hpp>
+#include <llfs/ring_buffer.hpp>
+
+#include <batteries/checked_cast.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//
+//  1. Read-ahead reads completed in reverse order; reads of blocks past the valid data that fail
+//     (with an error or a bad header) are ignored.
+//  2. Short reads are continued until the block is full, including across read-ahead slot reuse.
+//  3. A short read followed by an error on the block being scanned fails recovery, but only after
+//     all in-flight reads have finished.
+//  4. A zero-byte read fails recovery with kOutOfRange.
+//  5. The blocking ReadDataFn constructor reads one block at a time.
+
+using namespace llfs::int_types;
+using namespace llfs::constants;
+
+using llfs::MutableBuffer;
+using llfs::None;
+using llfs::Optional;
+using llfs::Status;
+using llfs::StatusOr;
+
+constexpr usize kBlockCount = 8;
+
+const llfs::IoRingLogConfig kConfig{
+    .logical_size = 4 * kKiB,
+    .physical_offset = 0,
+    .physical_size = kBlockCount * llfs::kLogPageSize,
+    .pages_per_block_log2 = 0,
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// A simulated log device whose reads are completed explicitly by the test.
+//
+class FakeLogDisk
+{
+ public:
+  struct PendingRead {
+    i64 file_offset;
+    MutableBuffer dst;
+    std::function<void(StatusOr<i32>)> handler;
+  };
+
+  static constexpr auto kTimeout = std::chrono::seconds(10);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  explicit FakeLogDisk(const llfs::IoRingLogConfig& config) noexcept
+      : config_{config}
+      , image_(config.physical_size, 0)
+  {
+  }
+
+  // Writes a valid block header to the image.  All payload bytes are zero, so each byte of
+  // committed data is recovered as a single empty slot.
+  //
+  void write_block(usize block_i, u64 slot_offset, u64 commit_size)
+  {
+    u8* const block_data = this->image_.data() + block_i * this->config_.block_size();
+    auto* header = reinterpret_cast<llfs::PackedLogPageHeader*>(block_data);
+    header->reset(slot_offset);
+    header->commit_size = commit_size;
+  }
+
+  // Writes blocks [0, full_blocks) full and then one block with `tail_size` bytes; returns the
+  // expected recovered flush_pos.
+  //
+  u64 write_log(usize full_blocks, u64 tail_size)
+  {
+    const u64 block_capacity = this->config_.block_capacity();
+
+    for (usize block_i = 0; block_i < full_blocks; ++block_i) {
+      this->write_block(block_i, block_i * block_capacity, block_capacity);
+    }
+    this->write_block(full_blocks, full_blocks * block_capacity, tail_size);
+
+    return full_blocks * block_capacity + tail_size;
+  }
+
+  llfs::IoRingLogRecovery::AsyncReadDataFn async_read_fn()
+  {
+    return [this](i64 file_offset, MutableBuffer dst,
+                  std::function<void(StatusOr<i32>)>&& handler) {
+      std::unique_lock<std::mutex> lock{this->mutex_};
+      this->pending_.push_back(PendingRead{file_offset, dst, std::move(handler)});
+      this->cond_.notify_all();
+    };
+  }
+
+  llfs::IoRingLogRecovery::ReadDataFn read_fn()
+  {
+    return [this](i64 file_offset, MutableBuffer dst) -> Status {
+      this->copy_data(file_offset, dst);
+      return batt::OkStatus();
+    };
+  }
+
+  // Waits until `count` reads are pending.
+  //
+  void wait_for_pending(usize count)
+  {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+    BATT_CHECK(this->cond_.wait_for(lock, kTimeout, [&] {
+      return this->pending_.size() >= count;
+    })) << "Timed out waiting for reads;" << BATT_INSPECT(count);
+  }
+
+  // Waits for a read starting at `file_offset` and removes it from the pending set.
+  //
+  PendingRead take(i64 file_offset)
+  {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+
+    auto iter = this->pending_.end();
+    BATT_CHECK(this->cond_.wait_for(lock, kTimeout, [&] {
+      iter = std::find_if(this->pending_.begin(), this->pending_.end(),
+                          [&](const PendingRead& read) {
+                            return read.file_offset == file_offset;
+                          });
+      return iter != this->pending_.end();
+    })) << "Timed out waiting for read;" << BATT_INSPECT(file_offset);
+
+    PendingRead read = std::move(*iter);
+    this->pending_.erase(iter);
+    return read;
+  }
+
+  PendingRead take_block(usize block_i)
+  {
+    return this->take(BATT_CHECKED_CAST(i64, block_i * this->config_.block_size()));
+  }
+
+  // Completes `read` with the first `n` bytes it asked for (or all of them).
+  //
+  void complete(PendingRead&& read, Optional<usize> n = None)
+  {
+    const usize n_to_read = std::min(n.value_or(read.dst.size()), read.dst.size());
+
+    this->copy_data(read.file_offset, MutableBuffer{read.dst.data(), n_to_read});
+    read.handler(BATT_CHECKED_CAST(i32, n_to_read));
+  }
+
+  void fail(PendingRead&& read, Status status)
+  {
+    read.handler(status);
+  }
+
+  void complete_block(usize block_i)
+  {
+    this->complete(this->take_block(block_i));
+  }
+
+  usize pending_count() const
+  {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+    return this->pending_.size();
+  }
+
+ private:
+  void copy_data(i64 file_offset, MutableBuffer dst) const
+  {
+    BATT_CHECK_LE(file_offset + dst.size(), this->image_.size());
+    std::memcpy(dst.data(), this->image_.data() + file_offset, dst.size());
+  }
+
+  const llfs::IoRingLogConfig config_;
+
+  std::vector<u8> image_;
+
+  mutable std::mutex mutex_;
+
+  std::condition_variable cond_;
+
+  std::deque<PendingRead> pending_;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+//
+class IoRingLogRecoveryTest : public ::testing::Test
+{
+ public:
+  // Runs recovery on a background thread, so that the test thread can play the part of the device.
+  //
+  std::future<Status> start_recovery(usize read_ahead_blocks)
+  {
+    this->recovery.emplace(kConfig, this->ring_buffer, this->disk.async_read_fn(),
+                           read_ahead_blocks);
+
+    return std::async(std::launch::async, [this] {
+      return this->recovery->run();
+    });
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  FakeLogDisk disk{kConfig};
+
+  llfs::RingBuffer ring_buffer{llfs::RingBuffer::TempFile{.byte_size = kConfig.logical_size}};
+
+  Optional<llfs::IoRingLogRecovery> recovery;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST_F(IoRingLogRecoveryTest, ReadAheadOutOfOrder)
+{
+  const u64 expected_flush_pos = this->disk.write_log(/*full_blocks=*/3, /*tail_size=*/100);
+
+  std::future<Status> result = this->start_recovery(/*read_ahead_blocks=*/kBlockCount);
+
+  // The whole log fits in the read-ahead window, so every block read is started up front.
+  //
+  this->disk.wait_for_pending(kBlockCount);
+
+  // Blocks 4.. are past the valid data; they contain no header, or fail to read.
+  //
+  this->disk.fail(this->disk.take_block(7), Status{batt::StatusCode::kDataLoss});
+  this->disk.complete_block(6);
+  this->disk.fail(this->disk.take_block(5), Status{batt::StatusCode::kDataLoss});
+  this->disk.complete_block(4);
+
+  for (usize block_i = 4; block_i > 0; --block_i) {
+    this->disk.complete_block(block_i - 1);
+  }
+
+  ASSERT_TRUE(result.get().ok());
+
+  EXPECT_EQ(this->disk.pending_count(), 0u);
+  EXPECT_EQ(this->recovery->get_trim_pos(), 0u);
+  EXPECT_EQ(this->recovery->get_flush_pos(), expected_flush_pos);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST_F(IoRingLogRecoveryTest, ShortReads)
+{
+  const u64 expected_flush_pos = this->disk.write_log(/*full_blocks=*/3, /*tail_size=*/100);
+
+  std::future<Status> result = this->start_recovery(/*read_ahead_blocks=*/2);
+
+  this->disk.wait_for_pending(2);
+  EXPECT_EQ(this->disk.pending_count(), 2u);
+
+  // Block 1 finishes first; block 0 takes two reads.
+  //
+  this->disk.complete_block(1);
+  this->disk.complete(this->disk.take_block(0), /*n=*/100);
+  this->disk.complete(this->disk.take(100));
+
+  // Blocks 2 and 3 reuse the read-ahead slots of blocks 0 and 1.
+  //
+  this->disk.complete(this->disk.take_block(3), /*n=*/llfs::kLogAtomicWriteSize / 2);
+  this->disk.complete(this->disk.take_block(2));
+  this->disk.complete(this->disk.take(3 * kConfig.block_size() + llfs::kLogAtomicWriteSize / 2));
+
+  // Block 3 is the last valid block, but block 4 was started by then; recovery waits for it.
+  //
+  this->disk.fail(this->disk.take_block(4), Status{batt::StatusCode::kDataLoss});
+
+  ASSERT_TRUE(result.get().ok());
+
+  EXPECT_EQ(this->disk.pending_count(), 0u);
+  EXPECT_EQ(this->recovery->get_flush_pos(), expected_flush_pos);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 3.
+//
+TEST_F(IoRingLogRecoveryTest, ReadErrorDrainsInFlightReads)
+{
+  this->disk.write_log(/*full_blocks=*/3, /*tail_size=*/100);
+
+  std::future<Status> result = this->start_recovery(/*read_ahead_blocks=*/4);
+
+  this->disk.wait_for_pending(4);
+
+  this->disk.complete_block(0);
+  this->disk.complete(this->disk.take_block(1), /*n=*/200);
+  this->disk.fail(this->disk.take(kConfig.block_size() + 200),
+                  Status{batt::StatusCode::kDataLoss});
+
+  // The reads of blocks 2, 3 and 4 (started once block 0 was scanned) target the recovery's block
+  // storage, so run() must not return while they are in flight.
+  //
+  EXPECT_EQ(result.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+
+  this->disk.complete_block(3);
+  this->disk.complete_block(4);
+
+  EXPECT_EQ(result.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+
+  this->disk.complete_block(2);
+
+  EXPECT_EQ(result.get(), Status{batt::StatusCode::kDataLoss});
+
+  // No new reads were started after the error.
+  //
+  EXPECT_EQ(this->disk.pending_count(), 0u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 4.
+//
+TEST_F(IoRingLogRecoveryTest, ZeroByteRead)
+{
+  this->disk.write_log(/*full_blocks=*/0, /*tail_size=*/100);
+
+  std::future<Status> result = this->start_recovery(/*read_ahead_blocks=*/1);
+
+  this->disk.complete(this->disk.take_block(0), /*n=*/0);
+
+  EXPECT_EQ(result.get(), Status{batt::StatusCode::kOutOfRange});
+  EXPECT_EQ(this->disk.pending_count(), 0u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 5.
+//
+TEST_F(IoRingLogRecoveryTest, BlockingReadDataFn)
+{
+  const u64 expected_flush_pos = this->disk.write_log(/*full_blocks=*/5, /*tail_size=*/7);
+
+  llfs::IoRingLogRecovery blocking_recovery{kConfig, this->ring_buffer, this->disk.read_fn()};
+
+  EXPECT_EQ(blocking_recovery.read_ahead_blocks(), 1u);
+
+  ASSERT_TRUE(blocking_recovery.run().ok());
+
+  EXPECT_EQ(blocking_recovery.get_trim_pos(), 0u);
+  EXPECT_EQ(blocking_recovery.get_flush_pos(), expected_flush_pos);
+}
+
+}  // namespace
@@ -0,0 +1,389 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/ioring_log_stream_reader.hpp>
+//
+
+#ifndef LLFS_DISABLE_IO_URING
+
+#include <llfs/logging.hpp>
+#include <llfs/packed_log_page_header.hpp>
+#include <llfs/status_code.hpp>
+
+#include <batteries/case_of.hpp>
+
+#include <algorithm>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ IoRingLogStreamReader::IoRingLogStreamReader(IoRing::File& file,
+                                                          IoRingBufferPool& buffer_pool,
+                                                          const IoRingLogConfig& config,
+                                                          const SlotRange& slot_range,
+                                                          usize read_ahead_blocks) noexcept
+    : file_{file}
+    , buffer_pool_{buffer_pool}
+    , config_{config}
+    , read_ahead_blocks_{std::max<usize>(1, read_ahead_blocks)}
+    , slot_range_{slot_range}
+    , slot_offset_{slot_range.lower_bound}
+    , next_block_index_{slot_range.lower_bound / this->block_capacity_}
+{
+  BATT_CHECK_GE(this->buffer_pool_.buffer_size(), this->block_size_)
+      << "IoRingLogStreamReader requires pool buffers large enough to hold a log block";
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+IoRingLogStreamReader::~IoRingLogStreamReader() noexcept
+{
+  // Wait for any in-flight reads before the buffers go back to the pool.
+  //
+  for (BlockRead& block : this->blocks_) {
+    if (!block.ready) {
+      block.done->await().IgnoreError();
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool IoRingLogStreamReader::is_closed() /*override*/
+{
+  return false;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+ConstBuffer IoRingLogStreamReader::data() /*override*/
+{
+  if (this->in_gather()) {
+    const usize offset = slot_distance(this->gather_lower_bound_, this->slot_offset_);
+    return ConstBuffer{this->gather_buffer_.data() + offset, this->gather_buffer_.size() - offset};
+  }
+
+  if (!this->prepare_front().ok() || this->blocks_.empty()) {
+    return ConstBuffer{};
+  }
+
+  return this->front_payload();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+slot_offset_type IoRingLogStreamReader::slot_offset() /*override*/
+{
+  return this->slot_offset_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingLogStreamReader::consume(usize byte_count) /*override*/
+{
+  byte_count = std::min(this->data().size(), byte_count);
+  this->slot_offset_ += byte_count;
+
+  if (!this->gather_buffer_.empty() && !this->in_gather()) {
+    this->gather_buffer_.clear();
+  }
+
+  // Release any blocks we have consumed past and start reading more.
+  //
+  this->prepare_front().IgnoreError();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status IoRingLogStreamReader::await(ReaderEvent event) /*override*/
+{
+  const slot_offset_type min_upper_bound = batt::case_of(
+      event,
+
+      //----- --- -- -  -  -   -
+      [](const SlotUpperBoundAt& slot_upper_bound_at) -> slot_offset_type {
+        return slot_upper_bound_at.offset;
+      },
+
+      //----- --- -- -  -  -   -
+      [this](const BytesAvailable& bytes_available) -> slot_offset_type {
+        return this->slot_offset_ + bytes_available.size;
+      });
+
+  const usize available = this->data().size();
+  BATT_REQUIRE_OK(this->status_);
+
+  if (!slot_less_than(this->slot_offset_ + available, min_upper_bound)) {
+    return OkStatus();
+  }
+
+  if (slot_less_than(this->slot_range_.upper_bound, min_upper_bound)) {
+    return batt::StatusCode::kOutOfRange;
+  }
+
+  BATT_REQUIRE_OK(this->gather(min_upper_bound));
+
+  // The end of the committed data may have been found while gathering.
+  //
+  if (slot_less_than(this->slot_offset_ + this->data().size(), min_upper_bound)) {
+    return batt::StatusCode::kOutOfRange;
+  }
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingLogStreamReader::fill_read_ahead()
+{
+  while (this->status_.ok() && this->blocks_.size() < this->read_ahead_blocks_ &&
+         slot_less_than(this->next_block_index_ * this->block_capacity_,
+                        this->slot_range_.upper_bound)) {
+    // Only block waiting for a buffer if the reader would otherwise have nothing to read.
+    //
+    StatusOr<IoRingBufferPool::Buffer> buffer = this->blocks_.empty()
+                                                    ? this->buffer_pool_.await_allocate()
+                                                    : this->buffer_pool_.try_allocate();
+    if (!buffer.ok()) {
+      if (this->blocks_.empty()) {
+        this->status_ = buffer.status();
+      }
+      break;
+    }
+
+    const u64 logical_block_index = this->next_block_index_;
+    this->next_block_index_ += 1;
+
+    auto done = batt::make_shared<batt::Latch<i32>>();
+    const i64 file_offset = BATT_CHECKED_CAST(
+        i64, this->config_.physical_offset +
+                 (logical_block_index % this->block_count_) * this->block_size_);
+
+    // NOTE: the buffer must not be released while the read is in flight; see
+    // `discard_blocks_after_front` and the destructor.
+    //
+    this->file_.async_read_some_fixed(
+        file_offset, MutableBuffer{buffer->data(), this->block_size_}, buffer->index(),
+        [done](StatusOr<i32> result) {
+          if (!result.ok()) {
+            done->set_error(result.status());
+          } else {
+            done->set_value(*result);
+          }
+        });
+
+    this->blocks_.emplace_back(BlockRead{
+        .logical_block_index = logical_block_index,
+        .buffer = std::move(*buffer),
+        .done = std::move(done),
+    });
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status IoRingLogStreamReader::prepare_front()
+{
+  for (;;) {
+    BATT_REQUIRE_OK(this->status_);
+
+    // Drop blocks that have been consumed.
+    //
+    while (!this->blocks_.empty() && this->blocks_.front().ready &&
+           !slot_less_than(this->slot_offset_, this->blocks_.front().valid_range.upper_bound)) {
+      this->blocks_.pop_front();
+    }
+
+    this->fill_read_ahead();
+    BATT_REQUIRE_OK(this->status_);
+
+    if (this->blocks_.empty()) {
+      return OkStatus();
+    }
+
+    if (!this->blocks_.front().ready) {
+      Status status = this->finish_front_read();
+      if (!status.ok()) {
+        this->status_ = status;
+        return status;
+      }
+      continue;
+    }
+
+    return OkStatus();
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status IoRingLogStreamReader::finish_front_read()
+{
+  BlockRead& front = this->blocks_.front();
+  BATT_CHECK(!front.ready);
+
+  StatusOr<i32> n_read = front.done->await();
+  BATT_REQUIRE_OK(n_read);
+
+  // Finish short reads synchronously.
+  //
+  if (BATT_CHECKED_CAST(usize, *n_read) < this->block_size_) {
+    const i64 file_offset = BATT_CHECKED_CAST(
+        i64, this->config_.physical_offset +
+                 (front.logical_block_index % this->block_count_) * this->block_size_);
+
+    BATT_REQUIRE_OK(this->file_.read_all_fixed(
+        file_offset + *n_read,
+        MutableBuffer{static_cast<char*>(front.buffer.data()) + *n_read,
+                      this->block_size_ - *n_read},
+        front.buffer.index()));
+  }
+
+  const auto& header = *static_cast<const PackedLogPageHeader*>(front.buffer.data());
+  if (header.magic != PackedLogPageHeader::kMagic) {
+    return make_status(StatusCode::kLogBlockBadMagic);
+  }
+  if (header.commit_size > this->block_capacity_) {
+    return make_status(StatusCode::kLogBlockCommitSizeOverflow);
+  }
+
+  const slot_offset_type block_lower_bound = front.logical_block_index * this->block_capacity_;
+  const slot_offset_type block_upper_bound =
+      slot_min(block_lower_bound + this->block_capacity_, this->slot_range_.upper_bound);
+
+  front.ready = true;
+
+  // A block left over from an older generation of the log holds no data for this stream.
+  //
+  if (header.slot_offset != block_lower_bound) {
+    front.valid_range = SlotRange{block_lower_bound, block_lower_bound};
+  } else {
+    front.valid_range = SlotRange{
+        .lower_bound = slot_max(block_lower_bound, this->slot_range_.lower_bound),
+        .upper_bound = slot_min(block_lower_bound + header.commit_size, block_upper_bound),
+    };
+  }
+
+  // If this block doesn't have all the data we expected, it marks the end of the stream; discard
+  // any read-ahead past it.
+  //
+  if (slot_less_than(front.valid_range.upper_bound, block_upper_bound)) {
+    LLFS_VLOG(1) << "IoRingLogStreamReader: end of committed data found before end of range;"
+                 << BATT_INSPECT(front.valid_range) << BATT_INSPECT(this->slot_range_);
+
+    this->slot_range_.upper_bound = front.valid_range.upper_bound;
+    this->next_block_index_ = front.logical_block_index + 1;
+    this->discard_blocks_after_front();
+  }
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingLogStreamReader::discard_blocks_after_front()
+{
+  while (this->blocks_.size() > 1) {
+    BlockRead& back = this->blocks_.back();
+    if (!back.ready) {
+      back.done->await().IgnoreError();
+    }
+    this->blocks_.pop_back();
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+ConstBuffer IoRingLogStreamReader::front_payload() const
+{
+  const BlockRead& front = this->blocks_.front();
+  BATT_CHECK(front.ready);
+
+  const slot_offset_type lower_bound = slot_max(this->slot_offset_, front.valid_range.lower_bound);
+  if (!slot_less_than(lower_bound, front.valid_range.upper_bound)) {
+    return ConstBuffer{};
+  }
+
+  const usize offset_in_block = sizeof(PackedLogPageHeader) +
+                                slot_distance(front.logical_block_index * this->block_capacity_,
+                                              lower_bound);
+
+  return ConstBuffer{static_cast<const char*>(front.buffer.data()) + offset_in_block,
+                     slot_distance(lower_bound, front.valid_range.upper_bound)};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status IoRingLogStreamReader::gather(slot_offset_type min_upper_bound)
+{
+  std::vector<char> gathered;
+  const slot_offset_type gathered_lower_bound = this->slot_offset_;
+
+  const auto append = [&gathered](const ConstBuffer& bytes) {
+    const char* const first = static_cast<const char*>(bytes.data());
+    gathered.insert(gathered.end(), first, first + bytes.size());
+  };
+
+  // Start with the currently available data.
+  //
+  if (this->in_gather()) {
+    append(this->data());
+  } else if (!this->blocks_.empty() && this->blocks_.front().ready) {
+    append(this->front_payload());
+    this->blocks_.pop_front();
+  }
+
+  // Pull in whole blocks until we reach `min_upper_bound` or the end of the stream.
+  //
+  while (slot_less_than(gathered_lower_bound + gathered.size(), min_upper_bound)) {
+    this->fill_read_ahead();
+    BATT_REQUIRE_OK(this->status_);
+
+    if (this->blocks_.empty()) {
+      break;
+    }
+
+    if (!this->blocks_.front().ready) {
+      Status status = this->finish_front_read();
+      if (!status.ok()) {
+        this->status_ = status;
+        return status;
+      }
+    }
+
+    const BlockRead& front = this->blocks_.front();
+    if (front.valid_range.lower_bound != gathered_lower_bound + gathered.size()) {
+      // The committed data ended exactly at the previous block boundary.
+      //
+      break;
+    }
+
+    append(ConstBuffer{static_cast<const char*>(front.buffer.data()) + sizeof(PackedLogPageHeader),
+                       front.valid_range.size()});
+
+    const bool end_of_stream =
+        !slot_less_than(front.valid_range.upper_bound, this->slot_range_.upper_bound);
+
+    this->blocks_.pop_front();
+    if (end_of_stream) {
+      break;
+    }
+  }
+
+  this->gather_buffer_ = std::move(gathered);
+  this->gather_lower_bound_ = gathered_lower_bound;
+  this->gather_count_ += 1;
+
+  this->fill_read_ahead();
+
+  return OkStatus();
+}
+
+}  // namespace llfs
+
+#endif  // LLFS_DISABLE_IO_URING
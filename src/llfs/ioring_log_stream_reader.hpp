@@ -0,0 +1,243 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_IORING_LOG_STREAM_READER_HPP
+#define LLFS_IORING_LOG_STREAM_READER_HPP
+
+#include <llfs/config.hpp>
+//
+#ifndef LLFS_DISABLE_IO_URING
+
+#include <llfs/int_types.hpp>
+#include <llfs/ioring_buffer_pool.hpp>
+#include <llfs/ioring_file.hpp>
+#include <llfs/ioring_log_config.hpp>
+#include <llfs/log_device.hpp>
+#include <llfs/slot.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/async/latch.hpp>
+#include <batteries/shared_ptr.hpp>
+
+#include <deque>
+#include <vector>
+
+namespace llfs {
+
+/** \brief Implementation of LogDevice::Reader that streams a durable slot range of an IoRing log
+ * directly from its on-disk blocks, without loading the whole log into a RingBuffer.
+ *
+ * Log blocks are read (up to `read_ahead_blocks` at a time) into buffers allocated from an
+ * IoRingBufferPool, and `data()` returns a view of the payload of the current block that points
+ * straight into the pooled buffer.  Each buffer is returned to the pool as soon as the reader
+ * consumes past the end of its block.  Only when `await` asks for data that straddles a block
+ * boundary are the bytes copied, into a private contiguous buffer (the same strategy as
+ * IoRingStreamBuffer::Fragment::gather).
+ *
+ * NOTE: unlike most Reader implementations, the memory returned by `data()` may change after a
+ * call to `await` or `consume`, though the bytes at a given slot offset never do.
+ *
+ * The stream ends at the upper bound of the slot range passed in at construction time, or earlier
+ * if a block is found whose committed data doesn't reach that far.  This class is not
+ * thread-safe.
+ */
+class IoRingLogStreamReader : public LogDevice::Reader
+{
+ public:
+  using ReaderEvent = LogDevice::ReaderEvent;
+
+  /** \brief The default number of log blocks to read ahead of the reader.
+   */
+  static constexpr usize kDefaultReadAheadBlocks = 8;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Creates a reader for `slot_range` of the log described by `config`, stored in `file`.
+   * Buffers are allocated from `buffer_pool`, whose buffer size must be at least the log block
+   * size.  `file` and `buffer_pool` must outlive this object.
+   */
+  explicit IoRingLogStreamReader(IoRing::File& file, IoRingBufferPool& buffer_pool,
+                                 const IoRingLogConfig& config, const SlotRange& slot_range,
+                                 usize read_ahead_blocks = kDefaultReadAheadBlocks) noexcept;
+
+  /** \brief Waits for any in-flight block reads to complete.
+   */
+  ~IoRingLogStreamReader() noexcept;
+
+  /** \brief Disable copy/move construction.
+   */
+  IoRingLogStreamReader(const IoRingLogStreamReader&) = delete;
+
+  /** \brief Disable copy/move assignment.
+   */
+  IoRingLogStreamReader& operator=(const IoRingLogStreamReader&) = delete;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Always returns false (for IoRingLogStreamReader).
+   */
+  bool is_closed() override;
+
+  /** \brief The currently available data, starting at `slot_offset()`.  Blocks until the block
+   * containing `slot_offset()` has been read, if necessary.  Returns an empty buffer at the end of
+   * the stream or if a read failed (see `await`).
+   */
+  ConstBuffer data() override;
+
+  /** \brief The current offset in bytes of this reader, relative to the start of the log.
+   */
+  slot_offset_type slot_offset() override;
+
+  /** \brief Releases ownership of some prefix of `data()` (possibly all of it), returning the
+   * buffers of any blocks that have been fully consumed to the pool.
+   *
+   * The passed `byte_count` is automatically truncated to the current remaining size of data.
+   */
+  void consume(usize byte_count) override;
+
+  /** \brief Wait until `data()` covers the specified event.
+   *
+   * Returns `batt::StatusCode::kOutOfRange` if the event is past the end of the stream, or the
+   * error status of any failed block read.
+   */
+  Status await(ReaderEvent event) override;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief The upper bound of the readable slot range; this may drop below the value passed in at
+   * construction time if the end of the committed data is found earlier.
+   */
+  slot_offset_type slot_upper_bound() const noexcept
+  {
+    return this->slot_range_.upper_bound;
+  }
+
+  /** \brief The number of block reads currently buffered (in flight or completed).
+   */
+  usize buffered_block_count() const noexcept
+  {
+    return this->blocks_.size();
+  }
+
+  /** \brief The number of times data straddling a block boundary had to be copied.
+   */
+  u64 gather_count() const noexcept
+  {
+    return this->gather_count_;
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  /** \brief A single buffered log block.
+   */
+  struct BlockRead {
+    /** \brief The logical index of the block (slot offset / block capacity).
+     */
+    u64 logical_block_index;
+
+    /** \brief The pooled buffer into which the block is read.
+     */
+    IoRingBufferPool::Buffer buffer;
+
+    /** \brief Set to the result of the initial read by the IoRing completion handler.
+     */
+    batt::SharedPtr<batt::Latch<i32>> done;
+
+    /** \brief Set once the read has finished and the block header has been validated.
+     */
+    bool ready = false;
+
+    /** \brief The slot range of the readable part of the payload; only valid when `ready`.
+     */
+    SlotRange valid_range{0, 0};
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Starts reading blocks until `read_ahead_blocks_` are buffered, the pool runs dry, or
+   * the end of the slot range is reached.  Waits for a buffer only if none are buffered.
+   */
+  void fill_read_ahead();
+
+  /** \brief Drops consumed blocks, issues more reads, and waits for the front block (if any) to
+   * become ready.
+   */
+  Status prepare_front();
+
+  /** \brief Finishes reading (if short) and validates the front block.
+   */
+  Status finish_front_read();
+
+  /** \brief Drops all buffered blocks except the front one, waiting for any in-flight reads.
+   */
+  void discard_blocks_after_front();
+
+  /** \brief Returns the unconsumed part of the front block's valid payload.
+   */
+  ConstBuffer front_payload() const;
+
+  /** \brief Copies data from `slot_offset()` up to at least `min_upper_bound` (or the end of the
+   * stream) into `this->gather_buffer_`.
+   */
+  Status gather(slot_offset_type min_upper_bound);
+
+  /** \brief Returns true iff `data()` is currently served from `this->gather_buffer_`.
+   */
+  bool in_gather() const noexcept
+  {
+    return !this->gather_buffer_.empty() &&
+           slot_less_than(this->slot_offset_,
+                          this->gather_lower_bound_ + this->gather_buffer_.size());
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  IoRing::File& file_;
+  IoRingBufferPool& buffer_pool_;
+  const IoRingLogConfig config_;
+  const usize block_size_ = this->config_.block_size();
+  const usize block_capacity_ = this->config_.block_capacity();
+  const usize block_count_ = this->config_.block_count();
+  const usize read_ahead_blocks_;
+
+  /** \brief The slot range of the stream.
+   */
+  SlotRange slot_range_;
+
+  /** \brief The current read position.
+   */
+  slot_offset_type slot_offset_;
+
+  /** \brief The logical index of the next block to read.
+   */
+  u64 next_block_index_;
+
+  /** \brief Buffered blocks, in slot order.
+   */
+  std::deque<BlockRead> blocks_;
+
+  /** \brief Data copied from multiple blocks so it can be returned as a single contiguous buffer.
+   */
+  std::vector<char> gather_buffer_;
+
+  /** \brief The slot offset of the first byte of `this->gather_buffer_`.
+   */
+  slot_offset_type gather_lower_bound_ = 0;
+
+  /** \brief Set to the first error encountered; once set, the stream is stuck.
+   */
+  Status status_;
+
+  u64 gather_count_ = 0;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_DISABLE_IO_URING
+#endif  // LLFS_IORING_LOG_STREAM_READER_HPP
@@ -0,0 +1,232 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/ioring_log_stream_reader.hpp>
+//
+#include <llfs/ioring_log_stream_reader.hpp>
+
+#ifndef LLFS_DISABLE_IO_URING
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/constants.hpp>
+#include <llfs/packed_log_page_header.hpp>
+
+#include <batteries/async/simple_executor.hpp>
+#include <batteries/async/task.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <functional>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//
+//  1. Reading whole blocks at a time never copies; data() points into pooled buffers, which are
+//     all returned to the pool afterwards.  The stream wraps around the physical end of the log.
+//  2. Slots that straddle block boundaries are gathered correctly.
+//  3. The stream ends early at a block that is only partially committed.
+//
+
+using namespace llfs::int_types;
+using namespace llfs::constants;
+
+constexpr usize kBlockCount = 8;
+constexpr usize kPoolSize = 4;
+
+const char* const kTestFilePath = "/tmp/llfs_ioring_log_stream_reader_test_file";
+
+char expected_byte(llfs::slot_offset_type slot_offset)
+{
+  return static_cast<char>((slot_offset * 7) ^ (slot_offset >> 9));
+}
+
+class IoRingLogStreamReaderTest : public ::testing::Test
+{
+ public:
+  void SetUp() override
+  {
+    this->fd_ = ::open(kTestFilePath, O_CREAT | O_TRUNC | O_RDWR, /*mode=*/0644);
+    ASSERT_GE(this->fd_, 0) << std::strerror(errno);
+  }
+
+  void TearDown() override
+  {
+    if (this->fd_ != -1) {
+      ::close(this->fd_);
+    }
+  }
+
+  // Writes the given logical block to its physical location in the test file.
+  //
+  void write_block(u64 logical_block_index, usize commit_size)
+  {
+    std::vector<char> block(this->config_.block_size(), 0);
+
+    auto* header = reinterpret_cast<llfs::PackedLogPageHeader*>(block.data());
+    header->reset(logical_block_index * this->config_.block_capacity());
+    header->commit_size = commit_size;
+
+    for (usize i = 0; i < commit_size; ++i) {
+      block[sizeof(llfs::PackedLogPageHeader) + i] = expected_byte(header->slot_offset + i);
+    }
+
+    const off_t offset = (logical_block_index % kBlockCount) * this->config_.block_size();
+    ASSERT_EQ(::pwrite(this->fd_, block.data(), block.size(), offset), (ssize_t)block.size());
+  }
+
+  // Runs `fn` with a new reader for `slot_range` inside a Task.
+  //
+  void with_reader(const llfs::SlotRange& slot_range,
+                   const std::function<void(llfs::IoRingLogStreamReader&, llfs::IoRingBufferPool&)>&
+                       fn)
+  {
+    batt::SimpleExecutionContext ctx;
+
+    batt::Task task{ctx.get_executor(), [&] {
+                      llfs::StatusOr<llfs::ScopedIoRing> io = llfs::ScopedIoRing::make_new(
+                          llfs::MaxQueueDepth{64}, llfs::ThreadPoolSize{1});
+                      ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+
+                      llfs::StatusOr<std::unique_ptr<llfs::IoRingBufferPool>> pool =
+                          llfs::IoRingBufferPool::make_new(
+                              io->get_io_ring(), llfs::BufferCount{kPoolSize},
+                              llfs::BufferSize{this->config_.block_size()});
+                      ASSERT_TRUE(pool.ok()) << BATT_INSPECT(pool.status());
+
+                      const int fd = this->fd_;
+                      this->fd_ = -1;
+                      llfs::IoRing::File file{io->get_io_ring(), fd};
+                      {
+                        llfs::IoRingLogStreamReader reader{file, **pool, this->config_,
+                                                           slot_range, kPoolSize};
+                        fn(reader, **pool);
+                      }
+                      EXPECT_EQ((*pool)->available(), kPoolSize);
+                    }};
+
+    ctx.run();
+    task.join();
+  }
+
+  llfs::IoRingLogConfig config_{
+      .logical_size = 4 * kKiB * (kBlockCount - 1),
+      .physical_offset = 0,
+      .physical_size = 4 * kKiB * kBlockCount,
+      .pages_per_block_log2 = 3,
+  };
+
+  const usize capacity_ = this->config_.block_capacity();
+
+  int fd_ = -1;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  1. Reading whole blocks at a time never copies.
+//
+TEST_F(IoRingLogStreamReaderTest, ZeroCopyWholeBlocks)
+{
+  for (u64 i = 6; i <= 10; ++i) {
+    this->write_block(i, (i == 10) ? 1000 : this->capacity_);
+  }
+
+  const llfs::SlotRange slot_range{6 * this->capacity_ + 100, 10 * this->capacity_ + 1000};
+
+  this->with_reader(slot_range, [&](llfs::IoRingLogStreamReader& reader,
+                                    llfs::IoRingBufferPool& pool) {
+    usize blocks_seen = 0;
+    for (;;) {
+      llfs::ConstBuffer data = reader.data();
+      if (data.size() == 0) {
+        break;
+      }
+      ++blocks_seen;
+
+      EXPECT_LE(reader.buffered_block_count(), kPoolSize);
+      EXPECT_LE(pool.available(), kPoolSize - 1);
+
+      const char* bytes = static_cast<const char*>(data.data());
+      for (usize i = 0; i < data.size(); ++i) {
+        ASSERT_EQ(bytes[i], expected_byte(reader.slot_offset() + i)) << BATT_INSPECT(i);
+      }
+      reader.consume(data.size());
+    }
+
+    EXPECT_EQ(blocks_seen, 5u);
+    EXPECT_EQ(reader.slot_offset(), slot_range.upper_bound);
+    EXPECT_EQ(reader.gather_count(), 0u);
+    EXPECT_EQ(reader.await(llfs::BytesAvailable{.size = 1}), batt::StatusCode::kOutOfRange);
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  2. Slots that straddle block boundaries are gathered correctly.
+//
+TEST_F(IoRingLogStreamReaderTest, GatherAcrossBlocks)
+{
+  for (u64 i = 0; i <= 5; ++i) {
+    this->write_block(i, (i == 5) ? 17 : this->capacity_);
+  }
+
+  const llfs::SlotRange slot_range{0, 5 * this->capacity_ + 17};
+
+  this->with_reader(slot_range, [&](llfs::IoRingLogStreamReader& reader,
+                                    llfs::IoRingBufferPool&) {
+    for (usize n = 0;; ++n) {
+      const usize slot_size = 1 + (n * 997) % (2 * this->capacity_);
+
+      llfs::Status status = reader.await(llfs::BytesAvailable{.size = slot_size});
+      if (status == batt::StatusCode::kOutOfRange) {
+        EXPECT_LT(llfs::slot_distance(reader.slot_offset(), slot_range.upper_bound), slot_size);
+        break;
+      }
+      ASSERT_TRUE(status.ok()) << BATT_INSPECT(status);
+
+      llfs::ConstBuffer data = reader.data();
+      ASSERT_GE(data.size(), slot_size);
+
+      const char* bytes = static_cast<const char*>(data.data());
+      for (usize i = 0; i < slot_size; ++i) {
+        ASSERT_EQ(bytes[i], expected_byte(reader.slot_offset() + i)) << BATT_INSPECT(i);
+      }
+      reader.consume(slot_size);
+    }
+
+    EXPECT_GT(reader.gather_count(), 0u);
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  3. The stream ends early at a block that is only partially committed.
+//
+TEST_F(IoRingLogStreamReaderTest, EndsAtPartialBlock)
+{
+  for (u64 i = 0; i <= 2; ++i) {
+    this->write_block(i, (i == 1) ? 50 : this->capacity_);
+  }
+
+  const llfs::SlotRange slot_range{0, 3 * this->capacity_};
+
+  this->with_reader(slot_range, [&](llfs::IoRingLogStreamReader& reader,
+                                    llfs::IoRingBufferPool&) {
+    EXPECT_EQ(reader.await(llfs::SlotUpperBoundAt{.offset = this->capacity_ + 50}),
+              llfs::OkStatus());
+    EXPECT_EQ(reader.slot_upper_bound(), this->capacity_ + 50);
+    EXPECT_EQ(reader.await(llfs::SlotUpperBoundAt{.offset = this->capacity_ + 51}),
+              batt::StatusCode::kOutOfRange);
+  });
+}
+
+}  // namespace
+
+#endif  // LLFS_DISABLE_IO_URING
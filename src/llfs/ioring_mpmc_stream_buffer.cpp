@@ -0,0 +1,247 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/ioring_mpmc_stream_buffer.hpp>
+//
+
+#include <batteries/checked_cast.hpp>
+#include <batteries/hint.hpp>
+#include <batteries/math.hpp>
+
+#include <algorithm>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class IoRingMpmcStreamBuffer
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<std::unique_ptr<IoRingMpmcStreamBuffer>> IoRingMpmcStreamBuffer::make_new(
+    IoRingBufferPool& buffer_pool, BufferCount buffer_count, usize ring_capacity)
+{
+  if (buffer_count == 0 || ring_capacity == 0) {
+    return {batt::StatusCode::kInvalidArgument};
+  }
+
+  BATT_ASSIGN_OK_RESULT(IoRingBufferPool::BufferVec buffers,
+                        buffer_pool.await_allocate(buffer_count));
+
+  return {std::unique_ptr<IoRingMpmcStreamBuffer>{
+      new IoRingMpmcStreamBuffer{std::move(buffers), ring_capacity}}};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ IoRingMpmcStreamBuffer::IoRingMpmcStreamBuffer(IoRingBufferPool::BufferVec&& buffers,
+                                                            usize ring_capacity) noexcept
+    : private_buffer_pool_{std::move(buffers)}
+    , capacity_mask_{(u64{1} << batt::log2_ceil(ring_capacity)) - 1}
+    , slots_{new batt::CpuCacheLineIsolated<Slot>[this->capacity_mask_ + 1]}
+{
+  for (u64 pos = 0; pos <= this->capacity_mask_; ++pos) {
+    this->slots_[pos]->sequence.store(pos, std::memory_order_relaxed);
+  }
+  this->push_pos_->store(0);
+  this->pop_pos_->store(0);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+IoRingMpmcStreamBuffer::~IoRingMpmcStreamBuffer() noexcept
+{
+  // Release any views still in the ring before the private pool (which owns the buffers they
+  // reference) is destroyed.
+  //
+  while (this->try_pop()) {
+    continue;
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize IoRingMpmcStreamBuffer::view_count() const noexcept
+{
+  // Read pop_pos first so that we never observe pop_pos > push_pos.
+  //
+  const u64 observed_pop_pos = this->pop_pos_->load();
+  const u64 observed_push_pos = this->push_pos_->load();
+
+  return BATT_CHECKED_CAST(usize, observed_push_pos - observed_pop_pos);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingMpmcStreamBuffer::close()
+{
+  this->closed_.store(true);
+  this->commit_count_.close();
+  this->consume_count_.close();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto IoRingMpmcStreamBuffer::prepare() -> StatusOr<PreparedView>
+{
+  if (this->closed_.load()) {
+    return {batt::StatusCode::kClosed};
+  }
+
+  BATT_ASSIGN_OK_RESULT(IoRingBufferPool::Buffer buffer,
+                        this->private_buffer_pool_.await_allocate());
+
+  MutableBuffer slice = buffer.get();
+
+  return PreparedView{std::move(buffer), slice};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status IoRingMpmcStreamBuffer::commit(BufferView&& view)
+{
+  for (;;) {
+    if (this->closed_.load()) {
+      return {batt::StatusCode::kClosed};
+    }
+
+    // Read the consume count *before* trying to push, so that if the ring is full, any pop that
+    // happens after our attempt will wake us up.
+    //
+    const i64 observed_consume_count = this->consume_count_.get_value();
+
+    if (this->try_commit(view)) {
+      return OkStatus();
+    }
+
+    BATT_REQUIRE_OK(this->consume_count_.await_not_equal(observed_consume_count));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool IoRingMpmcStreamBuffer::try_commit(BufferView& view)
+{
+  BATT_CHECK_EQ(std::addressof(view.buffer.pool()), std::addressof(this->private_buffer_pool_))
+      << "IoRingMpmcStreamBuffer::commit only accepts buffer view objects for buffers returned "
+         "from IoRingMpmcStreamBuffer::prepare on the same stream.";
+
+  if (this->closed_.load() || !this->try_push(view)) {
+    return false;
+  }
+  this->commit_count_.fetch_add(1);
+
+  return true;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto IoRingMpmcStreamBuffer::consume() -> StatusOr<BufferView>
+{
+  for (;;) {
+    // Read the commit count *before* trying to pop; see comment in commit().
+    //
+    const i64 observed_commit_count = this->commit_count_.get_value();
+
+    Optional<BufferView> view = this->try_consume();
+    if (view) {
+      return {std::move(*view)};
+    }
+
+    StatusOr<i64> new_commit_count = this->commit_count_.await_not_equal(observed_commit_count);
+    if (BATT_HINT_FALSE(!new_commit_count.ok())) {
+      // The stream is closed; views committed before the close must still be delivered.
+      //
+      view = this->try_consume();
+      if (view) {
+        return {std::move(*view)};
+      }
+      return new_commit_count.status();
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto IoRingMpmcStreamBuffer::try_consume() -> Optional<BufferView>
+{
+  Optional<BufferView> view = this->try_pop();
+  if (view) {
+    this->consume_count_.fetch_add(1);
+  }
+  return view;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool IoRingMpmcStreamBuffer::try_push(BufferView& view) noexcept
+{
+  u64 pos = this->push_pos_->load(std::memory_order_relaxed);
+
+  for (;;) {
+    Slot& slot = *this->slots_[pos & this->capacity_mask_];
+
+    const u64 sequence = slot.sequence.load(std::memory_order_acquire);
+    const i64 delta = static_cast<i64>(sequence - pos);
+
+    if (delta == 0) {
+      // The slot is free for position `pos`; try to claim it.
+      //
+      if (this->push_pos_->compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        slot.view.emplace(std::move(view));
+        slot.sequence.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+      // `pos` was updated by the failed CAS; retry.
+
+    } else if (delta < 0) {
+      // The slot still holds the view from one lap ago; the ring is full.
+      //
+      return false;
+
+    } else {
+      // Another producer claimed `pos`; catch up.
+      //
+      pos = this->push_pos_->load(std::memory_order_relaxed);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto IoRingMpmcStreamBuffer::try_pop() noexcept -> Optional<BufferView>
+{
+  u64 pos = this->pop_pos_->load(std::memory_order_relaxed);
+
+  for (;;) {
+    Slot& slot = *this->slots_[pos & this->capacity_mask_];
+
+    const u64 sequence = slot.sequence.load(std::memory_order_acquire);
+    const i64 delta = static_cast<i64>(sequence - (pos + 1));
+
+    if (delta == 0) {
+      // The slot holds the view for position `pos`; try to claim it.
+      //
+      if (this->pop_pos_->compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        Optional<BufferView> result = std::move(slot.view);
+        slot.view = None;
+        slot.sequence.store(pos + this->capacity_mask_ + 1, std::memory_order_release);
+        return result;
+      }
+
+    } else if (delta < 0) {
+      // The producer for `pos` hasn't published yet (or never claimed it); the ring is empty.
+      //
+      return None;
+
+    } else {
+      pos = this->pop_pos_->load(std::memory_order_relaxed);
+    }
+  }
+}
+
+}  //namespace llfs
@@ -0,0 +1,190 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_IORING_MPMC_STREAM_BUFFER_HPP
+#define LLFS_IORING_MPMC_STREAM_BUFFER_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/ioring_buffer_pool.hpp>
+#include <llfs/ioring_buffer_view.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/async/watch.hpp>
+#include <batteries/cpu_align.hpp>
+
+#include <atomic>
+#include <memory>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+//
+/** \brief A multi-producer/multi-consumer stream of IoRing pooled buffer slices.
+ *
+ * Unlike IoRingStreamBuffer, which is a single byte stream, this class transfers whole
+ * BufferView messages: each call to commit enqueues one view, and each call to consume dequeues
+ * one view.  Views committed by a single producer are consumed in the order they were committed;
+ * there is no ordering between views committed by different producers.
+ *
+ * Committed views are held in a bounded lock-free ring (one sequence number per slot), so
+ * producers and consumers only contend on the ring positions, never on a shared lock.  Blocking
+ * (when the ring is full or empty) is done by awaiting a pair of batt::Watch counters.
+ *
+ * All public member functions are safe to call concurrently.
+ */
+class IoRingMpmcStreamBuffer
+{
+ public:
+  using BufferView = IoRingConstBufferView;
+  using PreparedView = IoRingMutableBufferView;
+
+  /** \brief Creates a new stream that reserves `buffer_count` buffers from `buffer_pool` for use
+   * by IoRingMpmcStreamBuffer::prepare, and can hold up to `ring_capacity` (rounded up to the
+   * next power of 2) committed views.  Blocks until the reserved buffers are available.
+   */
+  static StatusOr<std::unique_ptr<IoRingMpmcStreamBuffer>> make_new(IoRingBufferPool& buffer_pool,
+                                                                     BufferCount buffer_count,
+                                                                     usize ring_capacity);
+
+  /** \brief IoRingMpmcStreamBuffer is not copyable.
+   */
+  IoRingMpmcStreamBuffer(const IoRingMpmcStreamBuffer&) = delete;
+
+  /** \brief IoRingMpmcStreamBuffer is not copyable.
+   */
+  IoRingMpmcStreamBuffer& operator=(const IoRingMpmcStreamBuffer&) = delete;
+
+  ~IoRingMpmcStreamBuffer() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief The maximum number of committed views the ring can hold.
+   */
+  usize ring_capacity() const noexcept
+  {
+    return this->capacity_mask_ + 1;
+  }
+
+  /** \brief The size of the buffers in the pool from which this stream allocates.
+   */
+  usize buffer_size() const noexcept
+  {
+    return this->private_buffer_pool_.buffer_size();
+  }
+
+  /** \brief Returns the number of committed views that have not yet been consumed.  This is only
+   * a snapshot; the value may be stale by the time it is returned.
+   */
+  usize view_count() const noexcept;
+
+  /** \brief Closes the stream for writing; views already committed can still be consumed.  Once
+   * the ring is drained, consumers receive batt::StatusCode::kClosed.
+   *
+   * Views committed concurrently with close() may or may not be delivered; close the stream only
+   * after all producers have finished.
+   */
+  void close();
+
+  /** \brief Returns true iff close() has been called.
+   */
+  bool is_closed() const noexcept
+  {
+    return this->closed_.load();
+  }
+
+  /** \brief Allocates a buffer from the stream's reserved pool of buffers.  Blocks until a buffer
+   * is available.
+   */
+  StatusOr<PreparedView> prepare();
+
+  /** \brief Enqueues `view`, which must be a (slice of a) buffer returned by `this->prepare()`.
+   * Blocks while the ring is full.  Returns batt::StatusCode::kClosed if the stream is closed.
+   */
+  Status commit(BufferView&& view);
+
+  /** \brief Enqueues `view` if the stream is open and there is room in the ring, returning true;
+   * otherwise returns false and leaves `view` unmodified.
+   */
+  bool try_commit(BufferView& view);
+
+  /** \brief Dequeues the next committed view.  Blocks while the ring is empty; returns
+   * batt::StatusCode::kClosed once the stream is closed and drained.
+   */
+  StatusOr<BufferView> consume();
+
+  /** \brief Dequeues the next committed view if one is available, without blocking.
+   */
+  Optional<BufferView> try_consume();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  struct Slot {
+    /** \brief Equal to the ring position that may next claim this slot: `pos` when the slot is
+     * free for the producer at `pos`, `pos + 1` when it holds the view for the consumer at `pos`.
+     */
+    std::atomic<u64> sequence{0};
+
+    Optional<BufferView> view;
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  explicit IoRingMpmcStreamBuffer(IoRingBufferPool::BufferVec&& buffers,
+                                  usize ring_capacity) noexcept;
+
+  /** \brief Lock-free enqueue; moves from `view` only on success.
+   */
+  bool try_push(BufferView& view) noexcept;
+
+  /** \brief Lock-free dequeue.
+   */
+  Optional<BufferView> try_pop() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief A subpool of the pool passed to make_new; this->prepare allocates from here.
+   */
+  IoRingBufferPool private_buffer_pool_;
+
+  /** \brief One less than the ring capacity (a power of 2).
+   */
+  const u64 capacity_mask_;
+
+  /** \brief The ring of committed views.
+   */
+  std::unique_ptr<batt::CpuCacheLineIsolated<Slot>[]> slots_;
+
+  /** \brief The next ring position to be claimed by a producer.
+   */
+  batt::CpuCacheLineIsolated<std::atomic<u64>> push_pos_;
+
+  /** \brief The next ring position to be claimed by a consumer.
+   */
+  batt::CpuCacheLineIsolated<std::atomic<u64>> pop_pos_;
+
+  /** \brief Incremented after each successful push; consumers wait on this when the ring is
+   * empty.
+   */
+  batt::Watch<i64> commit_count_{0};
+
+  /** \brief Incremented after each successful pop; producers wait on this when the ring is full.
+   */
+  batt::Watch<i64> consume_count_{0};
+
+  /** \brief Set by this->close().
+   */
+  std::atomic<bool> closed_{false};
+};
+
+}  //namespace llfs
+
+#endif  // LLFS_IORING_MPMC_STREAM_BUFFER_HPP
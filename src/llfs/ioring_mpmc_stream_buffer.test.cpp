@@ -0,0 +1,227 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/ioring_mpmc_stream_buffer.hpp>
+//
+#include <llfs/ioring_mpmc_stream_buffer.hpp>
+
+#include <llfs/ioring_stream_buffer.test.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. make_new rejects a zero buffer count or ring capacity, and rounds the capacity up to a
+//     power of 2.
+//  2. A single producer's views are consumed in commit order; try_commit fails when the ring is
+//     full and try_consume returns None when it is empty.
+//  3. close() rejects new commits/prepares, but views committed before the close are still
+//     delivered; then consume returns kClosed.
+//  4. Many producer threads and many consumer threads: every committed message is consumed
+//     exactly once.
+
+using namespace llfs::int_types;
+
+using llfs::IoRingMpmcStreamBuffer;
+using llfs::testing::IoringStreamBufferTest;
+
+using IoringMpmcStreamBufferTest = IoringStreamBufferTest;
+
+constexpr usize kMessageSize = 8;
+
+// Prepares a buffer (if needed) and commits the next `kMessageSize` bytes of it, holding
+// `(producer, seq)`.
+//
+void commit_message(IoRingMpmcStreamBuffer& stream,
+                    llfs::Optional<llfs::IoRingMutableBufferView>& prepared, u32 producer, u32 seq)
+{
+  if (!prepared || prepared->size() < kMessageSize) {
+    // Release our reference to the old buffer first so it can be recycled.
+    //
+    prepared = llfs::None;
+
+    llfs::StatusOr<llfs::IoRingMutableBufferView> view = stream.prepare();
+    ASSERT_TRUE(view.ok()) << BATT_INSPECT(view.status());
+    prepared.emplace(std::move(*view));
+  }
+
+  std::memcpy(prepared->data(), &producer, sizeof(u32));
+  std::memcpy(static_cast<u8*>(prepared->data()) + sizeof(u32), &seq, sizeof(u32));
+
+  llfs::Status status = stream.commit(prepared->split(kMessageSize));
+  ASSERT_TRUE(status.ok()) << BATT_INSPECT(status);
+}
+
+std::pair<u32, u32> parse_message(const IoRingMpmcStreamBuffer::BufferView& view)
+{
+  BATT_CHECK_EQ(view.slice.size(), kMessageSize);
+
+  std::pair<u32, u32> message;
+  std::memcpy(&message.first, view.slice.data(), sizeof(u32));
+  std::memcpy(&message.second, static_cast<const u8*>(view.slice.data()) + sizeof(u32),
+              sizeof(u32));
+  return message;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST_F(IoringMpmcStreamBufferTest, MakeNew)
+{
+  EXPECT_EQ(IoRingMpmcStreamBuffer::make_new(*this->buffer_pool_, llfs::BufferCount{0}, 4).status(),
+            batt::StatusCode::kInvalidArgument);
+
+  EXPECT_EQ(IoRingMpmcStreamBuffer::make_new(*this->buffer_pool_, llfs::BufferCount{1}, 0).status(),
+            batt::StatusCode::kInvalidArgument);
+
+  llfs::StatusOr<std::unique_ptr<IoRingMpmcStreamBuffer>> stream =
+      IoRingMpmcStreamBuffer::make_new(*this->buffer_pool_, llfs::BufferCount{2}, 5);
+
+  ASSERT_TRUE(stream.ok()) << BATT_INSPECT(stream.status());
+
+  EXPECT_EQ((*stream)->ring_capacity(), 8u);
+  EXPECT_EQ((*stream)->buffer_size(), this->buffer_size_);
+  EXPECT_EQ((*stream)->view_count(), 0u);
+  EXPECT_FALSE((*stream)->is_closed());
+  EXPECT_EQ(this->buffer_pool_->in_use(), 2u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST_F(IoringMpmcStreamBufferTest, SingleProducerOrderAndFull)
+{
+  llfs::StatusOr<std::unique_ptr<IoRingMpmcStreamBuffer>> stream =
+      IoRingMpmcStreamBuffer::make_new(*this->buffer_pool_, llfs::BufferCount{1}, 4);
+
+  ASSERT_TRUE(stream.ok()) << BATT_INSPECT(stream.status());
+
+  EXPECT_FALSE((*stream)->try_consume());
+
+  llfs::Optional<llfs::IoRingMutableBufferView> prepared;
+  for (u32 seq = 0; seq < 4; ++seq) {
+    ASSERT_NO_FATAL_FAILURE(commit_message(**stream, prepared, /*producer=*/0, seq));
+  }
+  EXPECT_EQ((*stream)->view_count(), 4u);
+
+  // The ring is full.
+  //
+  IoRingMpmcStreamBuffer::BufferView extra = prepared->split(kMessageSize);
+  EXPECT_FALSE((*stream)->try_commit(extra));
+  EXPECT_EQ(extra.slice.size(), kMessageSize);
+
+  for (u32 seq = 0; seq < 4; ++seq) {
+    llfs::StatusOr<IoRingMpmcStreamBuffer::BufferView> view = (*stream)->consume();
+    ASSERT_TRUE(view.ok()) << BATT_INSPECT(view.status());
+    EXPECT_EQ(parse_message(*view), std::make_pair(u32{0}, seq));
+  }
+
+  EXPECT_FALSE((*stream)->try_consume());
+  EXPECT_TRUE((*stream)->try_commit(extra));
+  EXPECT_TRUE((*stream)->try_consume());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 3.
+//
+TEST_F(IoringMpmcStreamBufferTest, CloseDrains)
+{
+  llfs::StatusOr<std::unique_ptr<IoRingMpmcStreamBuffer>> stream =
+      IoRingMpmcStreamBuffer::make_new(*this->buffer_pool_, llfs::BufferCount{1}, 4);
+
+  ASSERT_TRUE(stream.ok()) << BATT_INSPECT(stream.status());
+
+  llfs::Optional<llfs::IoRingMutableBufferView> prepared;
+  ASSERT_NO_FATAL_FAILURE(commit_message(**stream, prepared, /*producer=*/0, /*seq=*/7));
+
+  (*stream)->close();
+
+  EXPECT_TRUE((*stream)->is_closed());
+  EXPECT_EQ((*stream)->prepare().status(), batt::StatusCode::kClosed);
+  EXPECT_EQ((*stream)->commit(prepared->split(kMessageSize)), batt::StatusCode::kClosed);
+
+  llfs::StatusOr<IoRingMpmcStreamBuffer::BufferView> view = (*stream)->consume();
+  ASSERT_TRUE(view.ok()) << BATT_INSPECT(view.status());
+  EXPECT_EQ(parse_message(*view), std::make_pair(u32{0}, u32{7}));
+
+  EXPECT_EQ((*stream)->consume().status(), batt::StatusCode::kClosed);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 4.
+//
+TEST_F(IoringMpmcStreamBufferTest, ManyProducersManyConsumers)
+{
+  constexpr u32 kNumProducers = 4;
+  constexpr u32 kNumConsumers = 3;
+  constexpr u32 kMessagesPerProducer = 2000;
+
+  llfs::StatusOr<std::unique_ptr<IoRingMpmcStreamBuffer>> stream =
+      IoRingMpmcStreamBuffer::make_new(*this->buffer_pool_, this->buffer_count_, 16);
+
+  ASSERT_TRUE(stream.ok()) << BATT_INSPECT(stream.status());
+
+  std::mutex received_mutex;
+  std::multiset<std::pair<u32, u32>> received;
+
+  std::vector<std::thread> consumers;
+  for (u32 i = 0; i < kNumConsumers; ++i) {
+    consumers.emplace_back([&] {
+      std::vector<std::pair<u32, u32>> local;
+      for (;;) {
+        llfs::StatusOr<IoRingMpmcStreamBuffer::BufferView> view = (*stream)->consume();
+        if (!view.ok()) {
+          EXPECT_EQ(view.status(), batt::StatusCode::kClosed);
+          break;
+        }
+        local.emplace_back(parse_message(*view));
+      }
+      std::unique_lock<std::mutex> lock{received_mutex};
+      received.insert(local.begin(), local.end());
+    });
+  }
+
+  std::vector<std::thread> producers;
+  for (u32 producer = 0; producer < kNumProducers; ++producer) {
+    producers.emplace_back([&, producer] {
+      llfs::Optional<llfs::IoRingMutableBufferView> prepared;
+      for (u32 seq = 0; seq < kMessagesPerProducer; ++seq) {
+        commit_message(**stream, prepared, producer, seq);
+      }
+    });
+  }
+
+  for (std::thread& t : producers) {
+    t.join();
+  }
+  (*stream)->close();
+
+  for (std::thread& t : consumers) {
+    t.join();
+  }
+
+  std::multiset<std::pair<u32, u32>> expected;
+  for (u32 producer = 0; producer < kNumProducers; ++producer) {
+    for (u32 seq = 0; seq < kMessagesPerProducer; ++seq) {
+      expected.emplace(producer, seq);
+    }
+  }
+
+  EXPECT_EQ(received, expected);
+}
+
+}  // namespace
@@ -0,0 +1,208 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/ioring_multi_size_buffer_pool.hpp>
+//
+
+#include <llfs/seq.hpp>
+
+#include <algorithm>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<std::unique_ptr<IoRingMultiSizeBufferPool>> IoRingMultiSizeBufferPool::make_new(
+    const IoRing& io_ring, std::vector<SizeClass> size_classes) noexcept
+{
+  if (size_classes.empty()) {
+    return {batt::StatusCode::kInvalidArgument};
+  }
+
+  std::sort(size_classes.begin(), size_classes.end(), [](const SizeClass& l, const SizeClass& r) {
+    return l.buffer_size < r.buffer_size;
+  });
+
+  for (usize i = 0; i < size_classes.size(); ++i) {
+    const usize buffer_size = size_classes[i].buffer_size;
+    if (buffer_size == 0 || buffer_size > IoRingBufferPool::kMemoryUnitSize) {
+      return {batt::StatusCode::kInvalidArgument};
+    }
+    if (i > 0 && size_classes[i - 1].buffer_size == buffer_size) {
+      return {batt::StatusCode::kInvalidArgument};
+    }
+  }
+
+  std::unique_ptr<IoRingMultiSizeBufferPool> p_pool{new IoRingMultiSizeBufferPool{io_ring}};
+
+  Status status = p_pool->initialize(size_classes);
+  BATT_REQUIRE_OK(status);
+
+  return p_pool;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ IoRingMultiSizeBufferPool::IoRingMultiSizeBufferPool(const IoRing& io_ring) noexcept
+    : io_ring_{io_ring}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+IoRingMultiSizeBufferPool::~IoRingMultiSizeBufferPool() noexcept
+{
+  // Each sub-pool checks on destruction that all of its buffers have been returned; destroy them
+  // explicitly before the memory they are carved from.
+  //
+  this->pools_.clear();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status IoRingMultiSizeBufferPool::initialize(const std::vector<SizeClass>& size_classes) noexcept
+{
+  // Figure out how many whole memory units each size class needs.
+  //
+  std::vector<usize> units_per_class;
+  for (const SizeClass& size_class : size_classes) {
+    const usize buffers_per_unit = IoRingBufferPool::kMemoryUnitSize / size_class.buffer_size;
+    units_per_class.emplace_back((size_class.buffer_count + buffers_per_unit - 1) /
+                                 buffers_per_unit);
+  }
+
+  // Allocate the buffer memory for all size classes.
+  //
+  for (usize n_units : units_per_class) {
+    for (usize i = 0; i < n_units; ++i) {
+      this->units_.emplace_back(std::make_unique<IoRingBufferPool::Registered>());
+    }
+  }
+
+  // Register all memory units with the IoRing in one call.
+  //
+  if (!this->units_.empty()) {
+    StatusOr<usize> begin_index = this->io_ring_.register_buffers(
+        as_seq(this->units_)  //
+            | seq::map([](auto& p_registered) {
+                return batt::MutableBuffer{&(p_registered->memory_),
+                                           IoRingBufferPool::kMemoryUnitSize};
+              })  //
+            | seq::boxed(),
+        /*update=*/true);
+
+    BATT_REQUIRE_OK(begin_index);
+
+    for (auto& p_registered : this->units_) {
+      p_registered->io_ring_index_ = i32(*begin_index);
+      *begin_index += 1;
+    }
+  }
+
+  // Carve the memory units into per-size-class sub-pools.
+  //
+  usize next_unit = 0;
+  for (usize class_i = 0; class_i < size_classes.size(); ++class_i) {
+    IoRingBufferPool::CarvedUnits carved;
+    for (usize i = 0; i < units_per_class[class_i]; ++i) {
+      carved.emplace_back(this->units_[next_unit].get());
+      ++next_unit;
+    }
+
+    std::unique_ptr<IoRingBufferPool> p_sub_pool{
+        new IoRingBufferPool{this->io_ring_, size_classes[class_i].buffer_count,
+                             size_classes[class_i].buffer_size, std::move(carved)}};
+
+    Status status = p_sub_pool->initialize();
+    BATT_REQUIRE_OK(status);
+
+    this->pools_.emplace_back(std::move(p_sub_pool));
+  }
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+IoRingBufferPool* IoRingMultiSizeBufferPool::find_best_fit(usize size) const noexcept
+{
+  auto iter = std::lower_bound(this->pools_.begin(), this->pools_.end(), size,
+                               [](const std::unique_ptr<IoRingBufferPool>& p_pool, usize size) {
+                                 return p_pool->buffer_size() < size;
+                               });
+
+  if (iter == this->pools_.end()) {
+    return nullptr;
+  }
+  return iter->get();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto IoRingMultiSizeBufferPool::try_allocate(usize size) -> StatusOr<Buffer>
+{
+  IoRingBufferPool* const best_fit = this->find_best_fit(size);
+  if (!best_fit) {
+    return {batt::StatusCode::kInvalidArgument};
+  }
+
+  auto iter = std::find_if(this->pools_.begin(), this->pools_.end(),
+                           [best_fit](const std::unique_ptr<IoRingBufferPool>& p_pool) {
+                             return p_pool.get() == best_fit;
+                           });
+
+  for (; iter != this->pools_.end(); ++iter) {
+    StatusOr<Buffer> buffer = (*iter)->try_allocate();
+    if (buffer.ok()) {
+      return buffer;
+    }
+  }
+
+  return {batt::StatusCode::kResourceExhausted};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto IoRingMultiSizeBufferPool::await_allocate(usize size) -> StatusOr<Buffer>
+{
+  StatusOr<Buffer> buffer = this->try_allocate(size);
+  if (buffer.ok() || buffer.status() != batt::StatusCode::kResourceExhausted) {
+    return buffer;
+  }
+
+  // Nothing is free right now; wait for a buffer of the best fit size.
+  //
+  IoRingBufferPool* const best_fit = this->find_best_fit(size);
+  BATT_CHECK_NOT_NULLPTR(best_fit);
+
+  return best_fit->await_allocate();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize IoRingMultiSizeBufferPool::in_use() const noexcept
+{
+  usize total = 0;
+  for (const std::unique_ptr<IoRingBufferPool>& p_pool : this->pools_) {
+    total += p_pool->in_use();
+  }
+  return total;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize IoRingMultiSizeBufferPool::available() const noexcept
+{
+  usize total = 0;
+  for (const std::unique_ptr<IoRingBufferPool>& p_pool : this->pools_) {
+    total += p_pool->available();
+  }
+  return total;
+}
+
+}  //namespace llfs
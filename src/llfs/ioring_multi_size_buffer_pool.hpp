@@ -0,0 +1,157 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_IORING_MULTI_SIZE_BUFFER_POOL_HPP
+#define LLFS_IORING_MULTI_SIZE_BUFFER_POOL_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/api_types.hpp>
+#include <llfs/ioring.hpp>
+#include <llfs/ioring_buffer_pool.hpp>
+#include <llfs/status.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace llfs {
+
+/** \brief A pool of IoRing-registered buffers in several size classes, all carved out of a single
+ * registered region.
+ *
+ * Each size class is an IoRingBufferPool that owns a whole number of memory units (see
+ * IoRingBufferPool::kMemoryUnitSize); all memory units are registered with the IoRing in a single
+ * call, which keeps the number of registrations and the amount of pinned memory down when a
+ * component needs buffers of more than one size.
+ *
+ * Must be created via static IoRingMultiSizeBufferPool::make_new function.
+ */
+class IoRingMultiSizeBufferPool
+{
+ public:
+  using Self = IoRingMultiSizeBufferPool;
+  using Buffer = IoRingBufferPool::Buffer;
+
+  /** \brief The configuration of one size class.
+   */
+  struct SizeClass {
+    BufferSize buffer_size;
+    BufferCount buffer_count;
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Constructs, initializes, and returns a new IoRingMultiSizeBufferPool.
+   *
+   * Returns batt::StatusCode::kInvalidArgument if `size_classes` is empty, if it contains the same
+   * buffer size more than once, or if any buffer size is zero or larger than
+   * IoRingBufferPool::kMemoryUnitSize.
+   */
+  static StatusOr<std::unique_ptr<IoRingMultiSizeBufferPool>> make_new(
+      const IoRing& io_ring, std::vector<SizeClass> size_classes) noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  IoRingMultiSizeBufferPool(const IoRingMultiSizeBufferPool&) = delete;
+  IoRingMultiSizeBufferPool& operator=(const IoRingMultiSizeBufferPool&) = delete;
+
+  ~IoRingMultiSizeBufferPool() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const IoRing& get_io_ring() const noexcept
+  {
+    return this->io_ring_;
+  }
+
+  /** \brief Returns the number of size classes in this pool.
+   */
+  usize size_class_count() const noexcept
+  {
+    return this->pools_.size();
+  }
+
+  /** \brief Returns the sub-pool for the i-th size class; size classes are sorted by buffer size,
+   * smallest first.
+   */
+  IoRingBufferPool& size_class(usize i) const noexcept
+  {
+    return *this->pools_[i];
+  }
+
+  /** \brief Returns the buffer size of the largest size class.
+   */
+  BufferSize max_buffer_size() const noexcept
+  {
+    return this->pools_.back()->buffer_size();
+  }
+
+  /** \brief Returns the total number of memory units registered with the IoRing by this pool.
+   */
+  usize memory_unit_count() const noexcept
+  {
+    return this->units_.size();
+  }
+
+  /** \brief Returns the sub-pool with the smallest buffer size that is at least `size`, or nullptr
+   * if `size` is larger than all size classes.
+   */
+  IoRingBufferPool* find_best_fit(usize size) const noexcept;
+
+  /** \brief Attempts to allocate a buffer of at least `size` bytes without blocking.
+   *
+   * The best fit size class is tried first, then each larger class in order.  Returns
+   * batt::StatusCode::kResourceExhausted if no buffer is available, or
+   * batt::StatusCode::kInvalidArgument if `size` is larger than all size classes.
+   */
+  auto try_allocate(usize size) -> StatusOr<Buffer>;
+
+  /** \brief Blocks the current Task until a buffer of at least `size` bytes can be allocated.
+   *
+   * A buffer from a larger size class is returned if one is available right away; otherwise this
+   * waits on the best fit size class.  Returns batt::StatusCode::kInvalidArgument if `size` is
+   * larger than all size classes.
+   */
+  auto await_allocate(usize size) -> StatusOr<Buffer>;
+
+  /** \brief Returns the number of buffers (across all size classes) currently in use.
+   */
+  usize in_use() const noexcept;
+
+  /** \brief Returns the number of buffers (across all size classes) available for allocation.
+   */
+  usize available() const noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  explicit IoRingMultiSizeBufferPool(const IoRing& io_ring) noexcept;
+
+  /** \brief Allocates and registers the memory units, then creates a sub-pool per size class.
+   */
+  Status initialize(const std::vector<SizeClass>& size_classes) noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief The IoRing context for this pool.
+   */
+  const IoRing& io_ring_;
+
+  /** \brief The registered memory units shared by all size classes.  Declared before `pools_` so
+   * that the sub-pools are destroyed first.
+   */
+  std::vector<std::unique_ptr<IoRingBufferPool::Registered>> units_;
+
+  /** \brief One sub-pool per size class, sorted by buffer size (ascending).
+   */
+  std::vector<std::unique_ptr<IoRingBufferPool>> pools_;
+};
+
+}  //namespace llfs
+
+#endif  // LLFS_IORING_MULTI_SIZE_BUFFER_POOL_HPP
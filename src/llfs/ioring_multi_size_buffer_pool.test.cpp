@@ -0,0 +1,185 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/ioring_multi_size_buffer_pool.hpp>
+//
+#include <llfs/ioring_multi_size_buffer_pool.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/constants.hpp>
+
+#include <batteries/async/fake_execution_context.hpp>
+#include <batteries/async/fake_executor.hpp>
+
+namespace {
+
+// Test Plan:
+//  1. Invalid size class configurations are rejected.
+//  2. Allocations pick the best fit size class, spill over into larger classes when the best fit
+//     is exhausted, and all classes share one set of registered memory units.
+//  3. await_allocate blocks on the best fit class when nothing is free, and is unblocked when a
+//     buffer is released.
+
+using namespace llfs::int_types;
+using namespace llfs::constants;
+
+using llfs::BufferCount;
+using llfs::BufferSize;
+using llfs::IoRingMultiSizeBufferPool;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST(IoRingMultiSizeBufferPoolTest, InvalidSizeClasses)
+{
+  llfs::StatusOr<llfs::ScopedIoRing> io =
+      llfs::ScopedIoRing::make_new(llfs::MaxQueueDepth{16}, llfs::ThreadPoolSize{1});
+
+  ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+
+  EXPECT_EQ(IoRingMultiSizeBufferPool::make_new(io->get_io_ring(), {}).status(),
+            batt::StatusCode::kInvalidArgument);
+
+  EXPECT_EQ(IoRingMultiSizeBufferPool::make_new(
+                io->get_io_ring(),
+                {{BufferSize{llfs::IoRingBufferPool::kMemoryUnitSize * 2}, BufferCount{1}}})
+                .status(),
+            batt::StatusCode::kInvalidArgument);
+
+  EXPECT_EQ(IoRingMultiSizeBufferPool::make_new(io->get_io_ring(),
+                                                {{BufferSize{4 * kKiB}, BufferCount{1}},
+                                                 {BufferSize{4 * kKiB}, BufferCount{2}}})
+                .status(),
+            batt::StatusCode::kInvalidArgument);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST(IoRingMultiSizeBufferPoolTest, BestFit)
+{
+  llfs::StatusOr<llfs::ScopedIoRing> io =
+      llfs::ScopedIoRing::make_new(llfs::MaxQueueDepth{16}, llfs::ThreadPoolSize{1});
+
+  ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+
+  llfs::StatusOr<std::unique_ptr<IoRingMultiSizeBufferPool>> pool_status =
+      IoRingMultiSizeBufferPool::make_new(io->get_io_ring(),
+                                          {{BufferSize{1 * kMiB}, BufferCount{2}},
+                                           {BufferSize{4 * kKiB}, BufferCount{2}},
+                                           {BufferSize{64 * kKiB}, BufferCount{1}}});
+
+  ASSERT_TRUE(pool_status.ok()) << BATT_INSPECT(pool_status.status());
+
+  IoRingMultiSizeBufferPool& pool = **pool_status;
+
+  // Size classes are sorted; each one needs exactly one memory unit.
+  //
+  ASSERT_EQ(pool.size_class_count(), 3u);
+  EXPECT_EQ(pool.size_class(0).buffer_size(), 4 * kKiB);
+  EXPECT_EQ(pool.size_class(1).buffer_size(), 64 * kKiB);
+  EXPECT_EQ(pool.size_class(2).buffer_size(), 1 * kMiB);
+  EXPECT_EQ(pool.max_buffer_size(), 1 * kMiB);
+  EXPECT_EQ(pool.memory_unit_count(), 3u);
+  EXPECT_EQ(pool.available(), 5u);
+
+  EXPECT_EQ(pool.try_allocate(1 * kMiB + 1).status(), batt::StatusCode::kInvalidArgument);
+
+  std::vector<IoRingMultiSizeBufferPool::Buffer> buffers;
+
+  const auto allocate_and_expect_size = [&](usize size, usize expected_buffer_size) {
+    llfs::StatusOr<IoRingMultiSizeBufferPool::Buffer> buffer = pool.try_allocate(size);
+    ASSERT_TRUE(buffer.ok()) << BATT_INSPECT(buffer.status()) << BATT_INSPECT(size);
+    EXPECT_EQ(buffer->size(), expected_buffer_size);
+    EXPECT_GE(buffer->index(), 0);
+    buffers.emplace_back(std::move(*buffer));
+  };
+
+  allocate_and_expect_size(100, 4 * kKiB);
+  allocate_and_expect_size(4 * kKiB, 4 * kKiB);
+
+  // The smallest class is exhausted; the next request spills over to the 64KiB class.
+  //
+  allocate_and_expect_size(1, 64 * kKiB);
+  allocate_and_expect_size(1, 1 * kMiB);
+  allocate_and_expect_size(64 * kKiB + 1, 1 * kMiB);
+
+  EXPECT_EQ(pool.in_use(), 5u);
+  EXPECT_EQ(pool.available(), 0u);
+  EXPECT_EQ(pool.try_allocate(1).status(), batt::StatusCode::kResourceExhausted);
+
+  // All buffers are distinct.
+  //
+  for (usize i = 0; i < buffers.size(); ++i) {
+    for (usize j = i + 1; j < buffers.size(); ++j) {
+      EXPECT_NE(buffers[i], buffers[j]);
+    }
+  }
+
+  buffers.clear();
+
+  EXPECT_EQ(pool.in_use(), 0u);
+  EXPECT_EQ(pool.available(), 5u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 3.
+//
+TEST(IoRingMultiSizeBufferPoolTest, AwaitAllocateBlocksOnBestFit)
+{
+  batt::FakeExecutionContext ctx;
+
+  llfs::StatusOr<llfs::ScopedIoRing> io =
+      llfs::ScopedIoRing::make_new(llfs::MaxQueueDepth{16}, llfs::ThreadPoolSize{1});
+
+  ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+
+  llfs::StatusOr<std::unique_ptr<IoRingMultiSizeBufferPool>> pool_status =
+      IoRingMultiSizeBufferPool::make_new(io->get_io_ring(),
+                                          {{BufferSize{4 * kKiB}, BufferCount{1}},
+                                           {BufferSize{64 * kKiB}, BufferCount{1}}});
+
+  ASSERT_TRUE(pool_status.ok()) << BATT_INSPECT(pool_status.status());
+
+  IoRingMultiSizeBufferPool& pool = **pool_status;
+
+  llfs::StatusOr<IoRingMultiSizeBufferPool::Buffer> small = pool.try_allocate(1);
+  llfs::StatusOr<IoRingMultiSizeBufferPool::Buffer> large = pool.try_allocate(1);
+
+  ASSERT_TRUE(small.ok()) << BATT_INSPECT(small.status());
+  ASSERT_TRUE(large.ok()) << BATT_INSPECT(large.status());
+
+  llfs::StatusOr<IoRingMultiSizeBufferPool::Buffer> waited;
+
+  batt::Task task{ctx.get_executor(),
+                  [&] {
+                    waited = pool.await_allocate(1);
+                  },
+                  "IoRingMultiSizeBufferPoolTest.AwaitAllocateBlocksOnBestFit"};
+
+  ctx.poll();
+
+  EXPECT_FALSE(task.try_join());
+
+  // Releasing a buffer of the best fit size unblocks the waiter.
+  //
+  void* const small_ptr = small->data();
+  *small = {};
+
+  ctx.poll();
+
+  ASSERT_TRUE(task.try_join());
+
+  ASSERT_TRUE(waited.ok()) << BATT_INSPECT(waited.status());
+  EXPECT_EQ(waited->data(), small_ptr);
+  EXPECT_EQ(waited->size(), 4 * kKiB);
+}
+
+}  // namespace
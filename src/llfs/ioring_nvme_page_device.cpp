@@ -0,0 +1,406 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/ioring_nvme_page_device.hpp>
+//
+
+#if !defined(LLFS_DISABLE_IO_URING) && LLFS_HAS_NVME_PASSTHRU
+
+#include <llfs/logging.hpp>
+#include <llfs/trace_span.hpp>
+
+#include <batteries/checked_cast.hpp>
+#include <batteries/finally.hpp>
+#include <batteries/math.hpp>
+#include <batteries/syscall_retry.hpp>
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
+
+namespace llfs {
+
+namespace {
+
+// The Identify command (admin opcode 0x06) with CNS=0 returns the Identify Namespace data
+// structure; these are the byte offsets of the fields we need (NVMe Base Spec, Figure "Identify
+// Namespace Data Structure").
+//
+constexpr u8 kNvmeAdminIdentify = 0x06;
+constexpr usize kIdentifyDataSize = 4096;
+constexpr usize kIdentifyFlbasOffset = 26;
+constexpr usize kIdentifyLbafOffset = 128;
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<IoRingNvmePageDevice::NamespaceInfo> IoRingNvmePageDevice::identify_namespace(
+    int fd)
+{
+  const int nsid = batt::syscall_retry([&] {
+    return ::ioctl(fd, NVME_IOCTL_ID);
+  });
+  BATT_REQUIRE_OK(batt::status_from_retval(nsid));
+
+  alignas(4096) std::array<u8, kIdentifyDataSize> data;
+  data.fill(0);
+
+  struct nvme_admin_cmd cmd;
+  std::memset(&cmd, 0, sizeof(cmd));
+  cmd.opcode = kNvmeAdminIdentify;
+  cmd.nsid = nsid;
+  cmd.addr = reinterpret_cast<u64>(data.data());
+  cmd.data_len = data.size();
+  cmd.cdw10 = /*CNS=*/0;
+
+  const int retval = batt::syscall_retry([&] {
+    return ::ioctl(fd, NVME_IOCTL_ADMIN_CMD, &cmd);
+  });
+  BATT_REQUIRE_OK(batt::status_from_retval(retval));
+  if (retval != 0) {
+    LLFS_LOG_ERROR() << "NVMe Identify Namespace failed;" << BATT_INSPECT(nsid)
+                     << " nvme_status=0x" << std::hex << retval << std::dec;
+    return {batt::StatusCode::kInternal};
+  }
+
+  // FLBAS bits 3:0 are the low bits of the current LBA format index, bits 6:5 the high bits.
+  //
+  const u8 flbas = data[kIdentifyFlbasOffset];
+  const usize format_index = (flbas & 0xf) | (((flbas >> 5) & 0x3) << 4);
+
+  // Each LBA format descriptor is: metadata size (16 bits), LBA data size as a power of two
+  // (8 bits), relative performance (8 bits).
+  //
+  const u8* const lbaf = data.data() + kIdentifyLbafOffset + format_index * 4;
+  const u16 metadata_size = u16{lbaf[0]} | (u16{lbaf[1]} << 8);
+  const u8 lba_shift = lbaf[2];
+
+  if (metadata_size != 0) {
+    LLFS_LOG_ERROR() << "NVMe LBA formats with metadata are not supported;" << BATT_INSPECT(nsid)
+                     << BATT_INSPECT(metadata_size);
+    return {batt::StatusCode::kUnimplemented};
+  }
+  if (lba_shift < 9) {
+    LLFS_LOG_ERROR() << "Unexpected NVMe LBA size;" << BATT_INSPECT(nsid)
+                     << BATT_INSPECT((int)lba_shift);
+    return {batt::StatusCode::kInternal};
+  }
+
+  return NamespaceInfo{
+      .nsid = static_cast<u32>(nsid),
+      .lba_shift = lba_shift,
+  };
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ IoRingOptions IoRingNvmePageDevice::polled_ring_options(IoRingQueueCount queue_count)
+{
+  return IoRingOptions::with_default_values()  //
+      .set_queue_count(queue_count)
+      .set_big_entries(true)
+      .set_sqpoll(true)
+      .set_iopoll(true);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<std::unique_ptr<IoRingNvmePageDevice>> IoRingNvmePageDevice::open(
+    const IoRing& io_ring, const std::string& char_dev_path,
+    const FileOffsetPtr<PackedPageDeviceConfig>& config)
+{
+  if (!io_ring.options().big_entries()) {
+    LLFS_LOG_ERROR() << "IoRingNvmePageDevice requires an IoRing with big_entries (SQE128)";
+    return {batt::StatusCode::kFailedPrecondition};
+  }
+
+  // The char device doesn't go through the page cache, so O_DIRECT doesn't apply (and is
+  // rejected by the kernel); all transfers are direct regardless.  This is also why the file is
+  // opened here rather than with open_ioring_file, which (rightly, for block devices and regular
+  // files) insists on O_DIRECT for IOPOLL rings.
+  //
+  int fd = batt::syscall_retry([&] {
+    return ::open(char_dev_path.c_str(), O_RDWR);
+  });
+  BATT_REQUIRE_OK(batt::status_from_retval(fd));
+
+  // Close the fd on any error return below, until ownership passes to the IoRing::File.
+  //
+  auto close_fd = batt::finally([&fd] {
+    if (fd != -1) {
+      ::close(fd);
+    }
+  });
+
+  StatusOr<NamespaceInfo> ns = identify_namespace(fd);
+  BATT_REQUIRE_OK(ns);
+
+  const i64 lba_mask = (i64{1} << ns->lba_shift) - 1;
+  if (u16{config->page_size_log2} < ns->lba_shift ||
+      (config.absolute_page_0_offset() & lba_mask) != 0) {
+    LLFS_LOG_ERROR() << "Page device layout is not aligned to the NVMe LBA size;"
+                     << BATT_INSPECT_STR(char_dev_path) << BATT_INSPECT(ns->lba_shift)
+                     << BATT_INSPECT(u16{config->page_size_log2})
+                     << BATT_INSPECT(config.absolute_page_0_offset());
+    return {batt::StatusCode::kInvalidArgument};
+  }
+
+  StatusOr<IoRing::File> file = IoRing::File::open(io_ring, std::exchange(fd, -1));
+  BATT_REQUIRE_OK(file);
+
+  file->set_raw_io(true);
+
+  return std::make_unique<IoRingNvmePageDevice>(std::move(*file), config, *ns);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ struct nvme_uring_cmd IoRingNvmePageDevice::make_rw_cmd(u8 opcode,
+                                                                   const NamespaceInfo& ns,
+                                                                   const void* data, u32 data_len,
+                                                                   i64 byte_offset)
+{
+  const u64 lba_mask = (u64{1} << ns.lba_shift) - 1;
+  BATT_CHECK_GE(byte_offset, 0);
+  BATT_CHECK_EQ(static_cast<u64>(byte_offset) & lba_mask, 0u);
+  BATT_CHECK_EQ(data_len & lba_mask, 0u);
+  BATT_CHECK_GT(data_len, 0u);
+
+  const u64 slba = static_cast<u64>(byte_offset) >> ns.lba_shift;
+  const u32 nlb = data_len >> ns.lba_shift;
+
+  struct nvme_uring_cmd cmd;
+  std::memset(&cmd, 0, sizeof(cmd));
+
+  cmd.opcode = opcode;
+  cmd.nsid = ns.nsid;
+  cmd.addr = reinterpret_cast<u64>(data);
+  cmd.data_len = data_len;
+  cmd.cdw10 = static_cast<u32>(slba & 0xffffffffull);
+  cmd.cdw11 = static_cast<u32>(slba >> 32);
+  cmd.cdw12 = nlb - 1;  // NLB is 0's based.
+
+  return cmd;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+IoRingNvmePageDevice::IoRingNvmePageDevice(IoRing::File&& file,
+                                           const FileOffsetPtr<PackedPageDeviceConfig>& config,
+                                           const NamespaceInfo& ns) noexcept
+    : file_{std::move(file)}
+    , config_{config}
+    , page_ids_{PageCount{batt::checked_cast<u32>(this->config_->page_capacity())},
+                this->config_->device_id}
+    , ns_{ns}
+{
+  BATT_CHECK_GE(u16{this->config_->page_size_log2}, this->ns_.lba_shift);
+  this->max_transfer_size_ = std::max<usize>(this->max_transfer_size_,
+                                             usize{1} << this->ns_.lba_shift);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageIdFactory IoRingNvmePageDevice::page_ids()
+{
+  return this->page_ids_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageSize IoRingNvmePageDevice::page_size()
+{
+  return PageSize{batt::checked_cast<u32>(this->config_->page_size())};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::shared_ptr<PageBuffer>> IoRingNvmePageDevice::prepare(PageId page_id)
+{
+  StatusOr<u64> physical_page = this->get_physical_page(page_id);
+  BATT_REQUIRE_OK(physical_page);
+
+  return PageBuffer::allocate(this->page_size(), page_id);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingNvmePageDevice::write(std::shared_ptr<const PageBuffer>&& page_buffer,
+                                 WriteHandler&& handler)
+{
+  handler = trace_async_handler("page_device", "write", page_buffer->page_id().int_value(),
+                                std::move(handler));
+
+  StatusOr<i64> page_offset = this->get_byte_offset_of_page(page_buffer->page_id());
+  if (!page_offset.ok()) {
+    handler(page_offset.status());
+    return;
+  }
+
+  const PackedPageHeader& page_header = get_page_header(*page_buffer);
+  ConstBuffer data = page_buffer->const_buffer();
+  if (page_header.unused_end == page_header.size &&
+      page_header.unused_begin < page_header.unused_end) {
+    data = resize_buffer(data, batt::round_up_bits(this->ns_.lba_shift,
+                                                   page_header.unused_begin.value()));
+
+    BATT_CHECK_GE(page_header.unused_begin.value(), sizeof(PackedPageHeader));
+    BATT_CHECK_LE(data.size(), page_buffer->size());
+  }
+
+  metrics().page_write_count.add(1);
+
+  // The command only reads from this memory; MutableBuffer is just the common currency of
+  // `transfer`.
+  //
+  this->transfer(kNvmeCmdWrite, *page_offset,
+                 MutableBuffer{const_cast<void*>(data.data()), data.size()},
+                 std::move(page_buffer), std::move(handler));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingNvmePageDevice::read(PageId page_id, ReadHandler&& handler)
+{
+  LLFS_VLOG(1) << "IoRingNvmePageDevice::read(page_id=" << page_id << ")";
+
+  handler = trace_async_handler("page_device", "read", page_id.int_value(), std::move(handler));
+
+  StatusOr<i64> page_offset = this->get_byte_offset_of_page(page_id);
+  if (!page_offset.ok()) {
+    handler(page_offset.status());
+    return;
+  }
+
+  metrics().page_read_count.add(1);
+
+  std::shared_ptr<PageBuffer> page_buffer =
+      PageBuffer::allocate(this->page_size(), PageId{kInvalidPageId});
+
+  const MutableBuffer buffer = page_buffer->mutable_buffer();
+  std::shared_ptr<const PageBuffer> buffer_owner = page_buffer;
+
+  this->transfer(kNvmeCmdRead, *page_offset, buffer, std::move(buffer_owner),
+                 [this, page_id, page_buffer = std::move(page_buffer),
+                  handler = std::move(handler)](Status status) mutable {
+                   if (!status.ok()) {
+                     handler(status);
+                     return;
+                   }
+
+                   status = get_page_header(*page_buffer)
+                                .sanity_check(this->page_size(), page_id, this->page_ids_);
+                   if (!status.ok()) {
+                     // As with IoRingPageFileDevice, a bad generation means the page isn't there.
+                     //
+                     if (status == StatusCode::kPageHeaderBadGeneration) {
+                       status = batt::StatusCode::kNotFound;
+                     }
+                     handler(status);
+                     return;
+                   }
+
+                   handler(std::move(page_buffer));
+                 });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingNvmePageDevice::drop(PageId id, WriteHandler&& handler)
+{
+  // TODO [tastolfi 2021-06-11] - trim at device level?  (NVMe Dataset Management/Deallocate
+  // would be the natural fit here.)
+  (void)id;
+  handler(OkStatus());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingNvmePageDevice::transfer(u8 opcode, i64 byte_offset, MutableBuffer remaining,
+                                    std::shared_ptr<const PageBuffer>&& page_buffer,
+                                    WriteHandler&& handler)
+{
+  if (remaining.size() == 0) {
+    handler(OkStatus());
+    return;
+  }
+
+  const usize chunk_size = std::min(remaining.size(), this->max_transfer_size_);
+  const struct nvme_uring_cmd cmd = make_rw_cmd(opcode, this->ns_, remaining.data(),
+                                                BATT_CHECKED_CAST(u32, chunk_size), byte_offset);
+
+  metrics().command_count.add(1);
+
+  this->file_.async_uring_cmd(
+      NVME_URING_CMD_IO, &cmd, sizeof(cmd),
+      bind_handler(std::move(handler), [this, opcode, byte_offset, remaining, chunk_size,
+                                        page_buffer = std::move(page_buffer)](
+                                           WriteHandler&& handler, StatusOr<i32> result) mutable {
+        if (!result.ok()) {
+          if (batt::status_is_retryable(result.status())) {
+            this->transfer(opcode, byte_offset, remaining, std::move(page_buffer),
+                           std::move(handler));
+            return;
+          }
+          LLFS_LOG_WARNING() << "IoRingNvmePageDevice command failed;" << BATT_INSPECT((int)opcode)
+                             << BATT_INSPECT(byte_offset) << BATT_INSPECT(result.status());
+          handler(result.status());
+          return;
+        }
+
+        // A positive result is the NVMe completion status (status code type and status code);
+        // the command was delivered but the controller failed it.
+        //
+        if (*result != 0) {
+          metrics().nvme_error_count.add(1);
+          LLFS_LOG_WARNING() << "IoRingNvmePageDevice command failed;" << BATT_INSPECT((int)opcode)
+                             << BATT_INSPECT(byte_offset) << " nvme_status=0x" << std::hex
+                             << *result << std::dec;
+          handler(batt::status_from_errno(EIO));
+          return;
+        }
+
+        // NVMe commands are all-or-nothing; move on to the next chunk.
+        //
+        remaining += chunk_size;
+        this->transfer(opcode, byte_offset + chunk_size, remaining, std::move(page_buffer),
+                       std::move(handler));
+      }));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<u64> IoRingNvmePageDevice::get_physical_page(PageId page_id) const
+{
+  const i64 physical_page = this->page_ids_.get_physical_page(page_id);
+  if (physical_page >= this->config_->page_capacity() || physical_page < 0) {
+    return Status{batt::StatusCode::kOutOfRange};
+  }
+
+  return physical_page;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<i64> IoRingNvmePageDevice::get_byte_offset_of_page(PageId page_id) const
+{
+  const auto physical_page = this->get_physical_page(page_id);
+  BATT_REQUIRE_OK(physical_page);
+
+  return this->config_.absolute_page_0_offset() +
+         (static_cast<i64>(*physical_page) << u16{this->config_->page_size_log2});
+}
+
+}  // namespace llfs
+
+#endif  // !defined(LLFS_DISABLE_IO_URING) && LLFS_HAS_NVME_PASSTHRU
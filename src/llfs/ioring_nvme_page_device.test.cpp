@@ -0,0 +1,108 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/ioring_nvme_page_device.hpp>
+//
+#include <llfs/ioring_nvme_page_device.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#if !defined(LLFS_DISABLE_IO_URING) && LLFS_HAS_NVME_PASSTHRU
+
+#include <cstdio>
+
+namespace {
+
+using namespace llfs::int_types;
+
+using llfs::IoRingNvmePageDevice;
+
+// Test Plan:
+//  1. make_rw_cmd converts the byte range to a starting LBA and a 0's based block count, in the
+//     command dwords the NVMe spec assigns them, for both 512 byte and 4KiB LBA formats.
+//  2. identify_namespace fails cleanly (no crash, non-ok status) on a file that isn't an NVMe
+//     device.
+//  3. polled_ring_options turns on everything polled passthrough needs (big entries, SQPOLL,
+//     IOPOLL) and keeps the requested queue count.
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST(IoRingNvmePageDeviceTest, MakeRwCmd)
+{
+  alignas(4096) static u8 data[64 * 1024];
+
+  {
+    const IoRingNvmePageDevice::NamespaceInfo ns{.nsid = 1, .lba_shift = 9};
+
+    const struct nvme_uring_cmd cmd = IoRingNvmePageDevice::make_rw_cmd(
+        IoRingNvmePageDevice::kNvmeCmdRead, ns, data, /*data_len=*/8192, /*byte_offset=*/4096);
+
+    EXPECT_EQ(cmd.opcode, 0x02);
+    EXPECT_EQ(cmd.nsid, 1u);
+    EXPECT_EQ(cmd.addr, reinterpret_cast<u64>(data));
+    EXPECT_EQ(cmd.data_len, 8192u);
+    EXPECT_EQ(cmd.cdw10, 8u);
+    EXPECT_EQ(cmd.cdw11, 0u);
+    EXPECT_EQ(cmd.cdw12, 15u);
+    EXPECT_EQ(cmd.metadata, 0u);
+    EXPECT_EQ(cmd.metadata_len, 0u);
+  }
+  {
+    const IoRingNvmePageDevice::NamespaceInfo ns{.nsid = 7, .lba_shift = 12};
+
+    // An offset past 16TiB, so the starting LBA needs more than 32 bits.
+    //
+    const i64 byte_offset = (i64{1} << 44) + (i64{3} << 12);
+
+    const struct nvme_uring_cmd cmd = IoRingNvmePageDevice::make_rw_cmd(
+        IoRingNvmePageDevice::kNvmeCmdWrite, ns, data, /*data_len=*/sizeof(data), byte_offset);
+
+    EXPECT_EQ(cmd.opcode, 0x01);
+    EXPECT_EQ(cmd.nsid, 7u);
+    EXPECT_EQ(cmd.data_len, sizeof(data));
+    EXPECT_EQ(cmd.cdw10, 3u);
+    EXPECT_EQ(cmd.cdw11, 1u);
+    EXPECT_EQ(cmd.cdw12, 15u);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST(IoRingNvmePageDeviceTest, IdentifyNonNvmeFile)
+{
+  std::FILE* file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+
+  llfs::StatusOr<IoRingNvmePageDevice::NamespaceInfo> ns =
+      IoRingNvmePageDevice::identify_namespace(fileno(file));
+
+  EXPECT_FALSE(ns.ok());
+
+  std::fclose(file);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 3.
+//
+TEST(IoRingNvmePageDeviceTest, PolledRingOptions)
+{
+  const llfs::IoRingOptions options =
+      IoRingNvmePageDevice::polled_ring_options(llfs::IoRingQueueCount{4});
+
+  EXPECT_TRUE(options.big_entries());
+  EXPECT_TRUE(options.sqpoll());
+  EXPECT_TRUE(options.iopoll());
+  EXPECT_EQ(options.queue_count(), 4u);
+}
+
+}  // namespace
+
+#endif  // !defined(LLFS_DISABLE_IO_URING) && LLFS_HAS_NVME_PASSTHRU
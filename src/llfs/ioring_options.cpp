@@ -0,0 +1,32 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/ioring_options.hpp>
+//
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+IoRingOptions IoRingOptions::with_default_values()
+{
+  IoRingOptions opts;
+
+  opts.queue_depth_ = MaxQueueDepth{1024};
+  opts.queue_count_ = IoRingQueueCount{1};
+  opts.submit_batch_size_ = 1;
+  opts.sqpoll_ = false;
+  opts.sqpoll_idle_ms_ = 1000;
+  opts.sqpoll_cpu_ = None;
+  opts.iopoll_ = false;
+  opts.big_entries_ = false;
+
+  return opts;
+}
+
+}  // namespace llfs
@@ -0,0 +1,170 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_IORING_OPTIONS_HPP
+#define LLFS_IORING_OPTIONS_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/api_types.hpp>
+#include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
+
+#include <algorithm>
+
+namespace llfs {
+
+/** \brief Construction options for IoRing.
+ */
+class IoRingOptions
+{
+ public:
+  static IoRingOptions with_default_values();
+
+  /** \brief The maximum submission queue depth of each io_uring queue.
+   */
+  MaxQueueDepth queue_depth() const
+  {
+    return this->queue_depth_;
+  }
+
+  IoRingOptions& set_queue_depth(MaxQueueDepth entries)
+  {
+    this->queue_depth_ = entries;
+    return *this;
+  }
+
+  /** \brief The number of independent io_uring queues (see IoRing::make_new).
+   */
+  IoRingQueueCount queue_count() const
+  {
+    return this->queue_count_;
+  }
+
+  IoRingOptions& set_queue_count(IoRingQueueCount n_queues)
+  {
+    this->queue_count_ = n_queues;
+    return *this;
+  }
+
+  /** \brief The maximum number of operations that may build up in the submission queue before
+   * they are submitted to the kernel.
+   *
+   * If this is 1 (the default), every operation is submitted as soon as it is started.  Otherwise
+   * operations are submitted in batches: when this many are pending, when the run loop is about to
+   * block waiting for completions, or when `IoRing::flush_submissions()` is called, whichever
+   * happens first.
+   */
+  usize submit_batch_size() const
+  {
+    return this->submit_batch_size_;
+  }
+
+  IoRingOptions& set_submit_batch_size(usize n)
+  {
+    this->submit_batch_size_ = std::max<usize>(1, n);
+    return *this;
+  }
+
+  /** \brief If true, each queue is created with IORING_SETUP_SQPOLL: a kernel thread polls the
+   * submission queue, so submitting an operation does not require a syscall (as long as the poll
+   * thread is awake).
+   *
+   * NOTE: on kernels older than 5.11, SQPOLL requires CAP_SYS_ADMIN and only works with registered
+   * files.
+   */
+  bool sqpoll() const
+  {
+    return this->sqpoll_;
+  }
+
+  IoRingOptions& set_sqpoll(bool enabled)
+  {
+    this->sqpoll_ = enabled;
+    return *this;
+  }
+
+  /** \brief How long (in milliseconds) the SQPOLL kernel thread spins without any new submissions
+   * before going to sleep; ignored unless `sqpoll()` is true.
+   */
+  u32 sqpoll_idle_ms() const
+  {
+    return this->sqpoll_idle_ms_;
+  }
+
+  IoRingOptions& set_sqpoll_idle_ms(u32 idle_ms)
+  {
+    this->sqpoll_idle_ms_ = idle_ms;
+    return *this;
+  }
+
+  /** \brief If set, the SQPOLL kernel thread is pinned to this CPU (IORING_SETUP_SQ_AFF); ignored
+   * unless `sqpoll()` is true.
+   */
+  const Optional<u32>& sqpoll_cpu() const
+  {
+    return this->sqpoll_cpu_;
+  }
+
+  IoRingOptions& set_sqpoll_cpu(const Optional<u32>& cpu)
+  {
+    this->sqpoll_cpu_ = cpu;
+    return *this;
+  }
+
+  /** \brief If true, each queue is created with IORING_SETUP_IOPOLL: completions are reaped by
+   * polling the device instead of waiting for an interrupt.
+   *
+   * All files used with an IOPOLL ring must be opened with O_DIRECT (see
+   * IoRingFileRuntimeOptions::use_raw_io), and only reads and writes are supported.  Unless
+   * `sqpoll()` is also true, the thread waiting for completion events inside IoRing::run busy-polls
+   * the ring, trading a CPU core for lower latency.
+   */
+  bool iopoll() const
+  {
+    return this->iopoll_;
+  }
+
+  IoRingOptions& set_iopoll(bool enabled)
+  {
+    this->iopoll_ = enabled;
+    return *this;
+  }
+
+  /** \brief If true, each queue is created with IORING_SETUP_SQE128 | IORING_SETUP_CQE32, doubling
+   * the size of submission and completion queue entries.
+   *
+   * This is required for IORING_OP_URING_CMD commands whose payload doesn't fit in a regular SQE,
+   * such as NVMe passthrough (see IoRing::File::async_uring_cmd and IoRingNvmePageDevice).
+   */
+  bool big_entries() const
+  {
+    return this->big_entries_;
+  }
+
+  IoRingOptions& set_big_entries(bool enabled)
+  {
+    this->big_entries_ = enabled;
+    return *this;
+  }
+
+ private:
+  MaxQueueDepth queue_depth_;
+  IoRingQueueCount queue_count_;
+  usize submit_batch_size_;
+  bool sqpoll_;
+  u32 sqpoll_idle_ms_;
+  Optional<u32> sqpoll_cpu_;
+  bool iopoll_;
+  bool big_entries_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_IORING_OPTIONS_HPP
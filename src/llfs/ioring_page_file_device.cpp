@@ -10,20 +10,75 @@
 //
 
 #include <llfs/config.hpp>
+#include <llfs/page_id_factory.hpp>
+#include <llfs/trace_span.hpp>
 
 #ifndef LLFS_DISABLE_IO_URING
 
+#include <batteries/checked_cast.hpp>
+
+#include <algorithm>
+#include <utility>
+
+#include <errno.h>
+#include <fcntl.h>
+
 namespace llfs {
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-IoRingPageFileDevice::IoRingPageFileDevice(
-    IoRing::File&& file, const FileOffsetPtr<PackedPageDeviceConfig>& config) noexcept
+IoRingPageFileDevice::IoRingPageFileDevice(IoRing::File&& file,
+                                           const FileOffsetPtr<PackedPageDeviceConfig>& config,
+                                           const IoRingPageFileDeviceOptions& options) noexcept
     : file_{std::move(file)}
     , config_{config}
-    , page_ids_{PageCount{batt::checked_cast<u32>(this->config_->page_count.value())},
+    , page_ids_{PageCount{batt::checked_cast<u32>(this->config_->page_capacity())},
                 this->config_->device_id}
+    , max_coalesced_read_size_{options.max_coalesced_read_size}
+    , max_coalesced_write_size_{options.max_coalesced_write_size}
+    , max_concurrent_writes_{options.max_concurrent_writes}
+    , discard_batch_size_{options.discard_batch_size}
+{
+  BATT_CHECK_GT(this->max_concurrent_writes_, 0u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+IoRingPageFileDevice::~IoRingPageFileDevice() noexcept
+{
+  // Discards that haven't been issued yet are only hints, so they are dropped rather than issued
+  // (the IoRing may be on its way down); the ones in flight must still be waited for, since their
+  // callbacks refer to `this`.
+  //
+  std::unique_lock<std::mutex> lock{this->discard_mutex_};
+
+  this->pending_discards_.clear();
+  this->discards_done_.wait(lock, [this] {
+    return this->discard_ops_in_flight_ == 0;
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingPageFileDevice::close()
 {
+  std::vector<std::pair<u64, u64>> ranges;
+  {
+    std::unique_lock<std::mutex> lock{this->discard_mutex_};
+
+    this->discards_closing_ = true;
+    ranges = this->take_discard_batch_locked(/*force=*/true);
+  }
+
+  this->issue_discards(ranges);
+
+  // The discard callbacks refer to `this`, so the device can't go away until they are done.
+  //
+  std::unique_lock<std::mutex> lock{this->discard_mutex_};
+
+  this->discards_done_.wait(lock, [this] {
+    return this->discard_ops_in_flight_ == 0;
+  });
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -40,6 +95,28 @@ PageSize IoRingPageFileDevice::page_size()
   return PageSize{batt::checked_cast<u32>(this->config_->page_size())};
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status IoRingPageFileDevice::enable_registered_page_buffers(usize buffer_count)
+{
+  if (this->buffer_slab_) {
+    return {batt::StatusCode::kFailedPrecondition};
+  }
+
+  buffer_count = std::min<usize>(buffer_count, this->page_ids_.get_physical_page_count().value());
+  if (buffer_count == 0) {
+    return OkStatus();
+  }
+
+  StatusOr<std::shared_ptr<PageBufferSlab>> slab =
+      PageBufferSlab::make_new(this->file_.get_io_ring(), this->page_size(), buffer_count);
+  BATT_REQUIRE_OK(slab);
+
+  this->buffer_slab_ = std::move(*slab);
+
+  return OkStatus();
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 StatusOr<std::shared_ptr<PageBuffer>> IoRingPageFileDevice::prepare(PageId page_id)
@@ -47,13 +124,55 @@ StatusOr<std::shared_ptr<PageBuffer>> IoRingPageFileDevice::prepare(PageId page_
   StatusOr<u64> physical_page = this->get_physical_page(page_id);
   BATT_REQUIRE_OK(physical_page);
 
+  return this->allocate_page_buffer(page_id);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::shared_ptr<PageBuffer> IoRingPageFileDevice::allocate_page_buffer(PageId page_id)
+{
+  if (this->buffer_slab_) {
+    std::shared_ptr<PageBuffer> page_buffer = this->buffer_slab_->allocate(page_id);
+    if (page_buffer) {
+      return page_buffer;
+    }
+  }
   return PageBuffer::allocate(this->page_size(), page_id);
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<i32> IoRingPageFileDevice::buf_index_of(const PageBuffer* page_buffer) const
+{
+  if (!this->buffer_slab_) {
+    return None;
+  }
+  return this->buffer_slab_->buf_index_of(page_buffer);
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 void IoRingPageFileDevice::write(std::shared_ptr<const PageBuffer>&& page_buffer,
                                  WriteHandler&& handler)
+{
+  handler = trace_async_handler("page_device", "write", page_buffer->page_id().int_value(),
+                                std::move(handler));
+
+  if (this->discard_batch_size_ != 0) {
+    StatusOr<u64> physical_page = this->get_physical_page(page_buffer->page_id());
+    if (physical_page.ok() &&
+        this->defer_write_for_discard(*physical_page, page_buffer, handler)) {
+      return;
+    }
+  }
+
+  this->issue_write(std::move(page_buffer), std::move(handler));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingPageFileDevice::issue_write(std::shared_ptr<const PageBuffer>&& page_buffer,
+                                       WriteHandler&& handler)
 {
   StatusOr<i64> page_offset_in_file = this->get_file_offset_of_page(page_buffer->page_id());
   if (!page_offset_in_file.ok()) {
@@ -74,8 +193,160 @@ void IoRingPageFileDevice::write(std::shared_ptr<const PageBuffer>&& page_buffer
     return buffer;
   }();
 
-  this->write_some(*page_offset_in_file, std::move(page_buffer), remaining_data,
-                   std::move(handler));
+  // If write coalescing is disabled, there is no reason to queue anything.
+  //
+  const usize page_size = this->page_size();
+  if (this->max_coalesced_write_size_ < 2 * page_size) {
+    metrics().page_write_count.add(1);
+    metrics().write_op_count.add(1);
+
+    this->write_some(*page_offset_in_file, std::move(page_buffer), remaining_data,
+                     std::move(handler));
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock{this->write_mutex_};
+
+    this->pending_writes_.emplace_back(PendingWrite{
+        .file_offset = *page_offset_in_file,
+        .page_buffer = std::move(page_buffer),
+        .data = remaining_data,
+        .handler = std::move(handler),
+    });
+  }
+
+  this->start_pending_writes();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingPageFileDevice::start_pending_writes()
+{
+  const usize page_size = this->page_size();
+  const usize max_pages_per_write = std::max<usize>(1, this->max_coalesced_write_size_ / page_size);
+
+  // Each run is a sequence of writes to physically adjacent pages.
+  //
+  std::vector<std::vector<PendingWrite>> runs;
+  {
+    std::unique_lock<std::mutex> lock{this->write_mutex_};
+
+    if (this->pending_writes_.empty() ||
+        this->writes_in_flight_ >= this->max_concurrent_writes_) {
+      // If there are writes in flight, the next one to finish will pick up the queued writes.
+      //
+      return;
+    }
+
+    std::vector<PendingWrite> pending;
+    std::swap(pending, this->pending_writes_);
+
+    // Sort by file offset so that physically adjacent pages are next to each other.
+    //
+    std::sort(pending.begin(), pending.end(), [](const PendingWrite& l, const PendingWrite& r) {
+      return l.file_offset < r.file_offset;
+    });
+
+    for (PendingWrite& write : pending) {
+      // A page can only be appended to the current run if the previous page is written in full;
+      // otherwise there would be a gap in the data.
+      //
+      if (runs.empty() || runs.back().size() >= max_pages_per_write ||
+          write.file_offset != runs.back().back().file_offset + static_cast<i64>(page_size) ||
+          runs.back().back().data.size() != page_size) {
+        runs.emplace_back();
+      }
+      runs.back().emplace_back(std::move(write));
+    }
+
+    this->writes_in_flight_ += runs.size();
+  }
+
+  // Queue up all the writes, then submit them to the kernel together when `batch` goes out of
+  // scope.
+  //
+  IoRing::SubmitBatch batch{this->file_.get_io_ring()};
+
+  for (std::vector<PendingWrite>& run : runs) {
+    if (run.size() == 1) {
+      PendingWrite& write = run.front();
+
+      metrics().page_write_count.add(1);
+      metrics().write_op_count.add(1);
+
+      this->write_some(write.file_offset, std::move(write.page_buffer), write.data,
+                       [this, handler = std::move(write.handler)](Status status) {
+                         handler(status);
+                         this->finish_write_op();
+                       });
+    } else {
+      const i64 file_offset = run.front().file_offset;
+      this->write_coalesced(file_offset, std::move(run));
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingPageFileDevice::write_coalesced(i64 file_offset, std::vector<PendingWrite>&& pages)
+{
+  BATT_CHECK_GE(file_offset, 0);
+  BATT_CHECK_GT(pages.size(), 1u);
+
+  metrics().page_write_count.add(pages.size());
+  metrics().coalesced_write_page_count.add(pages.size());
+  metrics().write_op_count.add(1);
+
+  std::vector<ConstBuffer> buffers;
+  buffers.reserve(pages.size());
+  for (const PendingWrite& page : pages) {
+    buffers.emplace_back(page.data);
+  }
+
+  auto on_write = [this, file_offset, pages = std::move(pages)](StatusOr<i32> result) mutable {
+    if (!result.ok() && batt::status_is_retryable(result.status())) {
+      this->write_coalesced(file_offset, std::move(pages));
+      return;
+    }
+
+    // If the write failed, fall back to writing each page individually (so that errors are
+    // reported for the right pages); otherwise complete every page that was fully written, and
+    // finish writing any that weren't.  (`write_some` invokes the handler right away if there is no
+    // data left to write.)
+    //
+    usize n_written = result.ok() ? BATT_CHECKED_CAST(usize, *result) : 0;
+    i64 page_offset_in_file = file_offset;
+
+    for (PendingWrite& page : pages) {
+      const usize n_written_this_page = std::min(n_written, page.data.size());
+      n_written -= n_written_this_page;
+
+      this->write_some(page_offset_in_file + static_cast<i64>(n_written_this_page),
+                       std::move(page.page_buffer), page.data + n_written_this_page,
+                       std::move(page.handler));
+
+      page_offset_in_file += static_cast<i64>(page.data.size());
+    }
+
+    this->finish_write_op();
+  };
+
+  this->file_.async_write_some(file_offset, buffers, std::move(on_write));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingPageFileDevice::finish_write_op()
+{
+  {
+    std::unique_lock<std::mutex> lock{this->write_mutex_};
+
+    BATT_CHECK_GT(this->writes_in_flight_, 0u);
+    this->writes_in_flight_ -= 1;
+  }
+
+  this->start_pending_writes();
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -93,8 +364,9 @@ void IoRingPageFileDevice::write_some(i64 page_offset_in_file,
     return;
   }
 
-  this->file_.async_write_some(
-      page_offset_in_file, remaining_data,
+  const Optional<i32> buf_index = this->buf_index_of(page_buffer.get());
+
+  auto on_write =
       bind_handler(std::move(handler), [this, page_offset_in_file,
                                         page_buffer = std::move(page_buffer), remaining_data](
                                            WriteHandler&& handler, StatusOr<i32> result) mutable {
@@ -121,7 +393,14 @@ void IoRingPageFileDevice::write_some(i64 page_offset_in_file,
         //
         this->write_some(page_offset_in_file, std::move(page_buffer), remaining_data,
                          std::move(handler));
-      }));
+      });
+
+  if (buf_index) {
+    this->file_.async_write_some_fixed(page_offset_in_file, remaining_data, *buf_index,
+                                       std::move(on_write));
+  } else {
+    this->file_.async_write_some(page_offset_in_file, remaining_data, std::move(on_write));
+  }
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -130,6 +409,8 @@ void IoRingPageFileDevice::read(PageId page_id, ReadHandler&& handler)
 {
   LLFS_VLOG(1) << "IoRingPageFileDevice::read(page_id=" << page_id << ")";
 
+  handler = trace_async_handler("page_device", "read", page_id.int_value(), std::move(handler));
+
   StatusOr<i64> page_offset_in_file = this->get_file_offset_of_page(page_id);
   if (!page_offset_in_file.ok()) {
     LLFS_VLOG(1) << "bad page offset: " << BATT_INSPECT(page_id)
@@ -141,10 +422,147 @@ void IoRingPageFileDevice::read(PageId page_id, ReadHandler&& handler)
   const PageSize page_buffer_size = this->page_size();
   const usize n_read_so_far = 0;
 
-  this->read_some(page_id, *page_offset_in_file, PageBuffer::allocate(page_buffer_size),
+  metrics().page_read_count.add(1);
+  metrics().read_op_count.add(1);
+
+  this->read_some(page_id, *page_offset_in_file, this->allocate_page_buffer(PageId{kInvalidPageId}),
                   page_buffer_size, n_read_so_far, std::move(handler));
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingPageFileDevice::read_batch(const batt::Slice<const PageId>& ids,
+                                      std::vector<ReadHandler>&& handlers)
+{
+  BATT_CHECK_EQ(ids.size(), handlers.size());
+
+  const usize page_size = this->page_size();
+
+  // Resolve the file offset of each page, failing any that are invalid right away.  The page id
+  // layout is dispatched on once for the whole batch, so the per-page decoding uses constant masks.
+  //
+  std::vector<std::pair<i64, usize>> offset_and_index;
+  offset_and_index.reserve(ids.size());
+
+  with_static_page_id_factory(this->page_ids_, [&](const auto& page_ids) {
+    for (usize i = 0; i < ids.size(); ++i) {
+      StatusOr<i64> page_offset_in_file = this->get_file_offset_of_page(page_ids, ids[i]);
+      if (!page_offset_in_file.ok()) {
+        handlers[i](page_offset_in_file.status());
+        continue;
+      }
+      offset_and_index.emplace_back(*page_offset_in_file, i);
+    }
+  });
+
+  // Sort by file offset so that physically adjacent pages are next to each other.
+  //
+  std::sort(offset_and_index.begin(), offset_and_index.end());
+
+  // Queue up all the reads, then submit them to the kernel together when `batch` goes out of scope.
+  //
+  IoRing::SubmitBatch batch{this->file_.get_io_ring()};
+
+  const usize max_pages_per_read = std::max<usize>(1, this->max_coalesced_read_size_ / page_size);
+
+  for (usize first = 0; first < offset_and_index.size();) {
+    // Find the end of the run of contiguous pages starting at `first`.
+    //
+    usize last = first + 1;
+    while (last < offset_and_index.size() && last - first < max_pages_per_read &&
+           offset_and_index[last].first ==
+               offset_and_index[last - 1].first + static_cast<i64>(page_size)) {
+      ++last;
+    }
+
+    if (last - first == 1) {
+      const usize i = offset_and_index[first].second;
+      this->read(ids[i], std::move(handlers[i]));
+    } else {
+      std::vector<CoalescedPage> pages;
+      pages.reserve(last - first);
+      for (usize j = first; j < last; ++j) {
+        const usize i = offset_and_index[j].second;
+        pages.emplace_back(CoalescedPage{
+            .page_id = ids[i],
+            .page_buffer = this->allocate_page_buffer(PageId{kInvalidPageId}),
+            .handler = std::move(handlers[i]),
+        });
+      }
+      this->read_coalesced(offset_and_index[first].first, std::move(pages));
+    }
+
+    first = last;
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingPageFileDevice::read_coalesced(i64 file_offset, std::vector<CoalescedPage>&& pages)
+{
+  BATT_CHECK_GE(file_offset, 0);
+  BATT_CHECK_GT(pages.size(), 1u);
+
+  metrics().page_read_count.add(pages.size());
+  metrics().coalesced_page_count.add(pages.size());
+  metrics().read_op_count.add(1);
+
+  std::vector<MutableBuffer> buffers;
+  buffers.reserve(pages.size());
+  for (CoalescedPage& page : pages) {
+    buffers.emplace_back(page.page_buffer->mutable_buffer());
+  }
+
+  auto on_read = [this, file_offset, pages = std::move(pages)](StatusOr<i32> result) mutable {
+    if (!result.ok() && batt::status_is_retryable(result.status())) {
+      this->read_coalesced(file_offset, std::move(pages));
+      return;
+    }
+
+    const usize page_size = this->page_size();
+
+    // If the read failed, fall back to reading each page individually (so that errors are reported
+    // for the right pages); otherwise complete every page that was fully read, and re-read any that
+    // weren't (short reads should be rare, so we don't bother resuming partial pages).
+    //
+    usize n_read = result.ok() ? BATT_CHECKED_CAST(usize, *result) : 0;
+
+    for (usize i = 0; i < pages.size(); ++i) {
+      const usize n_read_this_page = std::min(n_read, page_size);
+      n_read -= n_read_this_page;
+
+      if (n_read_this_page == page_size) {
+        this->finish_coalesced_page(std::move(pages[i]));
+      } else {
+        this->read_some(pages[i].page_id, file_offset + static_cast<i64>(i * page_size),
+                        std::move(pages[i].page_buffer), page_size, /*n_read_so_far=*/0,
+                        std::move(pages[i].handler));
+      }
+    }
+  };
+
+  this->file_.async_read_some(file_offset, buffers, std::move(on_read));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingPageFileDevice::finish_coalesced_page(CoalescedPage&& page)
+{
+  Status status = get_page_header(*page.page_buffer)
+                      .sanity_check(this->page_size(), page.page_id, this->page_ids_);
+  if (!status.ok()) {
+    // As in read_some, a bad generation number means page not found.
+    //
+    if (status == StatusCode::kPageHeaderBadGeneration) {
+      status = batt::StatusCode::kNotFound;
+    }
+    page.handler(status);
+    return;
+  }
+
+  page.handler(std::move(page.page_buffer));
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 void IoRingPageFileDevice::read_some(PageId page_id, i64 page_offset_in_file,
@@ -157,8 +575,9 @@ void IoRingPageFileDevice::read_some(PageId page_id, i64 page_offset_in_file,
 
   MutableBuffer buffer = page_buffer->mutable_buffer() + n_read_so_far;
 
-  this->file_.async_read_some(
-      page_offset_in_file + n_read_so_far, buffer,
+  const Optional<i32> buf_index = this->buf_index_of(page_buffer.get());
+
+  auto on_read =
       bind_handler(std::move(handler), [this, page_id, page_offset_in_file,
                                         page_buffer = std::move(page_buffer), page_buffer_size,
                                         n_read_so_far](ReadHandler&& handler,
@@ -178,7 +597,14 @@ void IoRingPageFileDevice::read_some(PageId page_id, i64 page_offset_in_file,
           handler(result.status());
           return;
         }
-        BATT_CHECK_GT(*result, 0) << "We must either make progress or receive an error code!";
+
+        // The page runs past the end of the file (e.g., the re-read of a page cut short in a
+        // coalesced read).
+        //
+        if (*result == 0) {
+          handler(Status{batt::StatusCode::kOutOfRange});
+          return;
+        }
 
         // Sanity check the page header and fail fast if something looks wrong.
         //
@@ -214,6 +640,89 @@ void IoRingPageFileDevice::read_some(PageId page_id, i64 page_offset_in_file,
         //
         this->read_some(page_id, page_offset_in_file, std::move(page_buffer), page_buffer_size,
                         n_read_so_far, std::move(handler));
+      });
+
+  if (buf_index) {
+    this->file_.async_read_some_fixed(page_offset_in_file + n_read_so_far, buffer, *buf_index,
+                                      std::move(on_read));
+  } else {
+    this->file_.async_read_some(page_offset_in_file + n_read_so_far, buffer, std::move(on_read));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingPageFileDevice::read_tail(PageId page_id, usize byte_count, ReadTailHandler&& handler)
+{
+  StatusOr<i64> page_offset_in_file = this->get_file_offset_of_page(page_id);
+  if (!page_offset_in_file.ok()) {
+    handler(page_offset_in_file.status());
+    return;
+  }
+
+  const usize page_size = this->page_size();
+
+  byte_count = std::min(byte_count, page_size);
+
+  // The page size is a multiple of 512, so rounding the tail size up keeps both the file offset and
+  // the size of the read aligned.
+  //
+  const usize tail_size = std::min<usize>(batt::round_up_bits(9, byte_count), page_size);
+  const usize n_blocks = (tail_size + sizeof(PageBuffer::Block) - 1) / sizeof(PageBuffer::Block);
+
+  metrics().tail_read_count.add(1);
+  metrics().read_op_count.add(1);
+
+  this->read_tail_some(*page_offset_in_file + static_cast<i64>(page_size - tail_size),
+                       std::shared_ptr<PageBuffer::Block[]>{new PageBuffer::Block[n_blocks]},
+                       tail_size, byte_count, /*n_read_so_far=*/0, std::move(handler));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingPageFileDevice::read_tail_some(i64 tail_offset_in_file,
+                                          std::shared_ptr<PageBuffer::Block[]>&& tail_buffer,
+                                          usize tail_size, usize byte_count, usize n_read_so_far,
+                                          ReadTailHandler&& handler)
+{
+  u8* const tail_data = reinterpret_cast<u8*>(tail_buffer.get());
+  const MutableBuffer buffer{tail_data + n_read_so_far, tail_size - n_read_so_far};
+
+  this->file_.async_read_some(
+      tail_offset_in_file + n_read_so_far, buffer,
+      bind_handler(std::move(handler), [this, tail_offset_in_file,
+                                        tail_buffer = std::move(tail_buffer), tail_size, byte_count,
+                                        n_read_so_far](ReadTailHandler&& handler,
+                                                       StatusOr<i32> result) mutable {
+        if (!result.ok()) {
+          if (batt::status_is_retryable(result.status())) {
+            this->read_tail_some(tail_offset_in_file, std::move(tail_buffer), tail_size,
+                                 byte_count, n_read_so_far, std::move(handler));
+            return;
+          }
+          LLFS_LOG_WARNING() << "IoRingPageFileDevice::read_tail failed;"
+                             << BATT_INSPECT(tail_offset_in_file) << BATT_INSPECT(n_read_so_far);
+
+          handler(result.status());
+          return;
+        }
+        if (*result == 0) {
+          handler(Status{batt::StatusCode::kOutOfRange});
+          return;
+        }
+
+        n_read_so_far += *result;
+
+        if (n_read_so_far == tail_size) {
+          const u8* const tail_data = reinterpret_cast<const u8*>(tail_buffer.get());
+          handler(std::vector<u8>(tail_data + tail_size - byte_count, tail_data + tail_size));
+          return;
+        }
+
+        // The read was short; read again from the new stop point.
+        //
+        this->read_tail_some(tail_offset_in_file, std::move(tail_buffer), tail_size, byte_count,
+                             n_read_so_far, std::move(handler));
       }));
 }
 
@@ -221,17 +730,221 @@ void IoRingPageFileDevice::read_some(PageId page_id, i64 page_offset_in_file,
 //
 void IoRingPageFileDevice::drop(PageId id, WriteHandler&& handler)
 {
-  // TODO [tastolfi 2021-06-11] - trim at device level?
-  (void)id;
+  if (this->discard_batch_size_ != 0) {
+    StatusOr<u64> physical_page = this->get_physical_page(id);
+    if (physical_page.ok()) {
+      bool batch_ready = false;
+      {
+        std::unique_lock<std::mutex> lock{this->discard_mutex_};
+
+        if (this->discard_supported_) {
+          this->pending_discards_.insert(*physical_page);
+          batch_ready = this->pending_discards_.size() >= this->discard_batch_size_;
+        }
+      }
+      if (batch_ready) {
+        this->start_pending_discards(/*force=*/false);
+      }
+    }
+  }
+
+  // The discard is only a hint to the storage; the page is dropped as soon as it is queued.
+  //
   handler(OkStatus());
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingPageFileDevice::flush_discards()
+{
+  this->start_pending_discards(/*force=*/true);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool IoRingPageFileDevice::defer_write_for_discard(u64 physical_page,
+                                                   std::shared_ptr<const PageBuffer>& page_buffer,
+                                                   WriteHandler& handler)
+{
+  std::unique_lock<std::mutex> lock{this->discard_mutex_};
+
+  if (this->pending_discards_.erase(physical_page) != 0) {
+    metrics().discard_suppressed_count.add(1);
+  }
+
+  // The write may not be issued while the discard is in flight, since io_uring doesn't order the
+  // two; the discard could land after the write and wipe out the new page.
+  //
+  if (this->discards_in_flight_.count(physical_page) == 0) {
+    return false;
+  }
+
+  metrics().write_after_discard_count.add(1);
+
+  this->deferred_writes_.emplace_back(DeferredWrite{
+      .page_buffer = std::move(page_buffer),
+      .handler = std::move(handler),
+  });
+
+  return true;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingPageFileDevice::start_pending_discards(bool force)
+{
+  std::vector<std::pair<u64, u64>> ranges;
+  {
+    std::unique_lock<std::mutex> lock{this->discard_mutex_};
+
+    ranges = this->take_discard_batch_locked(force);
+  }
+
+  this->issue_discards(ranges);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::vector<std::pair<u64, u64>> IoRingPageFileDevice::take_discard_batch_locked(bool force)
+{
+  std::vector<std::pair<u64, u64>> ranges;
+
+  if (this->pending_discards_.empty() || this->discard_ops_in_flight_ != 0 ||
+      (!force && !this->discards_closing_ &&
+       this->pending_discards_.size() < this->discard_batch_size_)) {
+    // If a batch is in flight, it will pick up the queued pages when it is done.
+    //
+    return ranges;
+  }
+
+  std::vector<u64> pages(this->pending_discards_.begin(), this->pending_discards_.end());
+  this->pending_discards_.clear();
+
+  std::sort(pages.begin(), pages.end());
+
+  for (u64 physical_page : pages) {
+    if (ranges.empty() || physical_page != ranges.back().first + ranges.back().second) {
+      ranges.emplace_back(physical_page, 0);
+    }
+    ranges.back().second += 1;
+    this->discards_in_flight_.insert(physical_page);
+  }
+
+  metrics().discard_page_count.add(pages.size());
+  this->discard_ops_in_flight_ = ranges.size();
+
+  return ranges;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingPageFileDevice::issue_discards(const std::vector<std::pair<u64, u64>>& ranges)
+{
+  if (ranges.empty()) {
+    return;
+  }
+
+  const u16 page_size_log2 = this->config_->page_size_log2;
+
+  IoRing::SubmitBatch batch{this->file_.get_io_ring()};
+
+  for (const auto& [first_page, page_count] : ranges) {
+    const i64 file_offset =
+        this->config_.absolute_page_0_offset() + (static_cast<i64>(first_page) << page_size_log2);
+    const i64 length = static_cast<i64>(page_count) << page_size_log2;
+
+    metrics().discard_op_count.add(1);
+
+    // Capturing `this` is safe because close() waits for all discards to finish.
+    //
+    this->file_.async_fallocate(FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, file_offset, length,
+                                [this, file_offset, length](StatusOr<i32> result) {
+                                  if (!result.ok()) {
+                                    LLFS_LOG_WARNING()
+                                        << "IoRingPageFileDevice discard failed;"
+                                        << BATT_INSPECT(file_offset) << BATT_INSPECT(length)
+                                        << BATT_INSPECT(result.status());
+                                  }
+                                  this->finish_discard_op(result.status());
+                                });
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingPageFileDevice::finish_discard_op(const Status& status)
+{
+  std::vector<DeferredWrite> resumed_writes;
+  {
+    std::unique_lock<std::mutex> lock{this->discard_mutex_};
+
+    if (!status.ok()) {
+      metrics().discard_error_count.add(1);
+
+      if (status == batt::status_from_errno(EOPNOTSUPP)) {
+        this->discard_supported_ = false;
+        this->pending_discards_.clear();
+      }
+    }
+
+    BATT_CHECK_GT(this->discard_ops_in_flight_, 0u);
+    if (this->discard_ops_in_flight_ > 1) {
+      this->discard_ops_in_flight_ -= 1;
+      return;
+    }
+
+    // This is the last operation of the batch.  Its pages can be written again right away, but the
+    // batch stays counted as in flight until we are done here, so close() keeps waiting.
+    //
+    this->discards_in_flight_.clear();
+    std::swap(resumed_writes, this->deferred_writes_);
+  }
+
+  for (DeferredWrite& write : resumed_writes) {
+    this->issue_write(std::move(write.page_buffer), std::move(write.handler));
+  }
+
+  std::vector<std::pair<u64, u64>> ranges;
+  {
+    std::unique_lock<std::mutex> lock{this->discard_mutex_};
+
+    this->discard_ops_in_flight_ = 0;
+    ranges = this->take_discard_batch_locked(/*force=*/false);
+    if (ranges.empty()) {
+      this->discards_done_.notify_all();
+    }
+  }
+
+  // If there is another batch, it is already counted as in flight; `this` must not be touched
+  // otherwise, since close() may return as soon as the lock is released.
+  //
+  if (!ranges.empty()) {
+    this->issue_discards(ranges);
+  }
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 StatusOr<u64> IoRingPageFileDevice::get_physical_page(PageId page_id) const
 {
-  const i64 physical_page = this->page_ids_.get_physical_page(page_id);
-  if (physical_page > this->config_->page_count || physical_page < 0) {
+  return this->get_physical_page(this->page_ids_, page_id);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<i64> IoRingPageFileDevice::get_file_offset_of_page(PageId page_id) const
+{
+  return this->get_file_offset_of_page(this->page_ids_, page_id);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename PageIdFactoryT>
+StatusOr<u64> IoRingPageFileDevice::get_physical_page(const PageIdFactoryT& page_ids,
+                                                      PageId page_id) const
+{
+  const i64 physical_page = page_ids.get_physical_page(page_id);
+  if (physical_page >= this->config_->page_capacity() || physical_page < 0) {
     return Status{batt::StatusCode::kOutOfRange};
   }
 
@@ -240,9 +953,11 @@ StatusOr<u64> IoRingPageFileDevice::get_physical_page(PageId page_id) const
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-StatusOr<i64> IoRingPageFileDevice::get_file_offset_of_page(PageId page_id) const
+template <typename PageIdFactoryT>
+StatusOr<i64> IoRingPageFileDevice::get_file_offset_of_page(const PageIdFactoryT& page_ids,
+                                                            PageId page_id) const
 {
-  const auto physical_page = this->get_physical_page(page_id);
+  const auto physical_page = this->get_physical_page(page_ids, page_id);
   BATT_REQUIRE_OK(physical_page);
 
   return this->config_.absolute_page_0_offset() +
@@ -14,11 +14,21 @@
 
 #ifndef LLFS_DISABLE_IO_URING
 
+#include <llfs/constants.hpp>
 #include <llfs/file_offset_ptr.hpp>
 #include <llfs/ioring.hpp>
+#include <llfs/ioring_page_file_device_options.hpp>
+#include <llfs/metrics.hpp>
+#include <llfs/page_buffer_slab.hpp>
 #include <llfs/page_device.hpp>
 #include <llfs/page_device_config.hpp>
 
+#include <condition_variable>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 namespace llfs {
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
@@ -26,8 +36,76 @@ namespace llfs {
 class IoRingPageFileDevice : public PageDevice
 {
  public:
-  explicit IoRingPageFileDevice(IoRing::File&& file,
-                                const FileOffsetPtr<PackedPageDeviceConfig>& config) noexcept;
+  struct Metrics {
+    /** \brief The number of pages read.
+     */
+    CountMetric<u64> page_read_count{0};
+
+    /** \brief The number of read operations issued to the file; page_read_count / read_op_count is
+     * the average number of pages per read (the merge ratio).
+     */
+    CountMetric<u64> read_op_count{0};
+
+    /** \brief The number of pages read as part of a merged (multi-page) read operation.
+     */
+    CountMetric<u64> coalesced_page_count{0};
+
+    /** \brief The number of partial (tail-only) page reads; see read_tail.
+     */
+    CountMetric<u64> tail_read_count{0};
+
+    /** \brief The number of pages written.
+     */
+    CountMetric<u64> page_write_count{0};
+
+    /** \brief The number of write operations issued to the file (not counting retries of short
+     * writes); page_write_count / write_op_count is the average number of pages per write.
+     */
+    CountMetric<u64> write_op_count{0};
+
+    /** \brief The number of pages written as part of a merged (multi-page) write operation.
+     */
+    CountMetric<u64> coalesced_write_page_count{0};
+
+    /** \brief The number of dropped pages discarded at the device level (see drop).
+     */
+    CountMetric<u64> discard_page_count{0};
+
+    /** \brief The number of discard operations issued to the file; each covers a run of physically
+     * adjacent dropped pages.
+     */
+    CountMetric<u64> discard_op_count{0};
+
+    /** \brief The number of dropped pages that were written again before their discard was issued,
+     * so the discard was skipped.
+     */
+    CountMetric<u64> discard_suppressed_count{0};
+
+    /** \brief The number of page writes that had to wait for an in-flight discard of the same page.
+     */
+    CountMetric<u64> write_after_discard_count{0};
+
+    /** \brief The number of failed discard operations.
+     */
+    CountMetric<u64> discard_error_count{0};
+  };
+
+  static Metrics& metrics()
+  {
+    static Metrics m_;
+    return m_;
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  explicit IoRingPageFileDevice(
+      IoRing::File&& file, const FileOffsetPtr<PackedPageDeviceConfig>& config,
+      const IoRingPageFileDeviceOptions& options = IoRingPageFileDeviceOptions{}) noexcept;
+
+  /** \brief Waits for any discards in flight (see close); queued discards that haven't been issued
+   * are dropped.
+   */
+  ~IoRingPageFileDevice() noexcept;
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
@@ -35,26 +113,232 @@ class IoRingPageFileDevice : public PageDevice
 
   PageSize page_size() override;
 
+  Status enable_registered_page_buffers(usize buffer_count) override;
+
   StatusOr<std::shared_ptr<PageBuffer>> prepare(PageId page_id) override;
 
+  /** \brief Writes the page.
+   *
+   * While fewer than `max_concurrent_writes()` write operations are in flight, the write is issued
+   * right away.  Otherwise it is queued; when an in-flight write completes, all the queued writes
+   * (from any number of callers) are sorted by file offset and runs of physically adjacent pages
+   * are merged into a single vectored write (up to `max_coalesced_write_size()` bytes per write).
+   * Each page's handler is still invoked individually.
+   */
   void write(std::shared_ptr<const PageBuffer>&& page_buffer, WriteHandler&& handler) override;
 
   void read(PageId id, ReadHandler&& handler) override;
 
+  /** \brief Reads all the given pages, merging reads of pages that are physically adjacent in the
+   * file into a single vectored read (up to `max_coalesced_read_size()` bytes per read).
+   */
+  void read_batch(const batt::Slice<const PageId>& ids,
+                  std::vector<ReadHandler>&& handlers) override;
+
+  /** \brief Reads only the last `byte_count` bytes of the page (rounded up to a multiple of 512, so
+   * direct I/O alignment rules are satisfied).
+   */
+  void read_tail(PageId id, usize byte_count, ReadTailHandler&& handler) override;
+
+  usize max_coalesced_read_size() const
+  {
+    return this->max_coalesced_read_size_;
+  }
+
+  /** \brief Sets the limit on merged read size; a value less than or equal to the page size
+   * disables read coalescing.
+   */
+  void set_max_coalesced_read_size(usize n)
+  {
+    this->max_coalesced_read_size_ = n;
+  }
+
+  usize max_coalesced_write_size() const
+  {
+    return this->max_coalesced_write_size_;
+  }
+
+  /** \brief Sets the limit on merged write size; a value less than twice the page size disables
+   * write coalescing (all writes are issued right away).
+   */
+  void set_max_coalesced_write_size(usize n)
+  {
+    this->max_coalesced_write_size_ = n;
+  }
+
+  usize max_concurrent_writes() const
+  {
+    return this->max_concurrent_writes_;
+  }
+
+  /** \brief Sets the number of in-flight write operations at which page writes start being queued
+   * for merging.  Must be at least 1.
+   */
+  void set_max_concurrent_writes(usize n)
+  {
+    BATT_CHECK_GT(n, 0u);
+    this->max_concurrent_writes_ = n;
+  }
+
+  usize discard_batch_size() const
+  {
+    return this->discard_batch_size_;
+  }
+
+  /** \brief Sets the number of dropped pages to collect before discarding them at the device level;
+   * zero (the default) disables discards.  Must be set before the device is used (see
+   * IoRingPageFileDeviceOptions::discard_batch_size).
+   */
+  void set_discard_batch_size(usize n)
+  {
+    this->discard_batch_size_ = n;
+  }
+
+  /** \brief Completes right away.  If discards are enabled (see set_discard_batch_size), the page
+   * is also queued to be discarded, so that the storage under it can be reclaimed.
+   *
+   * Once `discard_batch_size()` pages are queued (and no discard batch is in flight), the queued
+   * pages are sorted, runs of physically adjacent pages are merged, and each run is deallocated
+   * with a single fallocate(FALLOC_FL_PUNCH_HOLE) (for a raw block device, the kernel turns this
+   * into a discard or write-zeroes command).  Only one batch is in flight at a time, which limits
+   * the rate of discards.
+   *
+   * A queued page that is written again before its batch is issued is taken off the queue; a write
+   * to a page whose discard is in flight is held until the discard completes.  If the file doesn't
+   * support hole punching, discards are turned off.
+   */
   void drop(PageId id, WriteHandler&& handler) override;
 
+  /** \brief Issues a discard batch for all queued dropped pages, even if there are fewer than
+   * `discard_batch_size()` (unless a batch is already in flight).
+   */
+  void flush_discards();
+
+  /** \brief Issues a discard batch for all queued dropped pages and waits for every discard to
+   * complete.
+   *
+   * Nothing else waits for discards (drop completes right away), so this (or the destructor) is
+   * what keeps them from outliving the device.  The IoRing must be running on some other thread if
+   * any discards are in flight.  The device must not be used after this is called.
+   */
+  void close();
+
  private:
+  /** \brief A single page that is part of a merged read.
+   */
+  struct CoalescedPage {
+    PageId page_id;
+    std::shared_ptr<PageBuffer> page_buffer;
+    ReadHandler handler;
+  };
+
+  /** \brief A page write waiting to be issued (possibly as part of a merged write).
+   */
+  struct PendingWrite {
+    i64 file_offset;
+    std::shared_ptr<const PageBuffer> page_buffer;
+
+    // The part of the page buffer that must be written; this may be shorter than the page if the
+    // end of the page is unused.
+    //
+    ConstBuffer data;
+
+    WriteHandler handler;
+  };
+
+  /** \brief A page write held until the in-flight discard of the same page completes.
+   */
+  struct DeferredWrite {
+    std::shared_ptr<const PageBuffer> page_buffer;
+    WriteHandler handler;
+  };
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
   StatusOr<u64> get_physical_page(PageId page_id) const;
 
   StatusOr<i64> get_file_offset_of_page(PageId page_id) const;
 
+  /** \brief Same as above, but decodes `page_id` using `page_ids`, which must be `this->page_ids_`
+   * or a StaticPageIdFactory made from it (see with_static_page_id_factory).
+   */
+  template <typename PageIdFactoryT>
+  StatusOr<u64> get_physical_page(const PageIdFactoryT& page_ids, PageId page_id) const;
+
+  template <typename PageIdFactoryT>
+  StatusOr<i64> get_file_offset_of_page(const PageIdFactoryT& page_ids, PageId page_id) const;
+
+  /** \brief Returns a buffer from `this->buffer_slab_` if one is available, otherwise allocates a
+   * new one with PageBuffer::allocate.
+   */
+  std::shared_ptr<PageBuffer> allocate_page_buffer(PageId page_id);
+
+  /** \brief Returns the fixed I/O `buf_index` for the given buffer, or None if it was not allocated
+   * from `this->buffer_slab_`.
+   */
+  Optional<i32> buf_index_of(const PageBuffer* page_buffer) const;
+
+  /** \brief Does the work of `write` once the page is no longer being discarded.
+   */
+  void issue_write(std::shared_ptr<const PageBuffer>&& page_buffer, WriteHandler&& handler);
+
+  /** \brief Takes the page off the discard queue, or (returning true) moves the write into
+   * `this->deferred_writes_` if its discard is in flight.
+   */
+  bool defer_write_for_discard(u64 physical_page, std::shared_ptr<const PageBuffer>& page_buffer,
+                               WriteHandler& handler);
+
+  /** \brief Issues the queued discards if there are at least `discard_batch_size()` of them (or
+   * any, if `force` is true or the device is closing) and no discard batch is in flight.
+   */
+  void start_pending_discards(bool force);
+
+  /** \brief Takes the queued discards that start_pending_discards should issue off the queue,
+   * returning them as (first page, page count) runs of physically adjacent pages.
+   * `this->discard_mutex_` must be held.
+   */
+  std::vector<std::pair<u64, u64>> take_discard_batch_locked(bool force);
+
+  /** \brief Issues a discard operation for each range returned by take_discard_batch_locked.
+   */
+  void issue_discards(const std::vector<std::pair<u64, u64>>& ranges);
+
+  /** \brief Called when a discard operation issued by `start_pending_discards` is done.
+   */
+  void finish_discard_op(const Status& status);
+
   void write_some(i64 page_offset_in_file, std::shared_ptr<const PageBuffer>&& page_buffer,
                   ConstBuffer remaining_data, WriteHandler&& handler);
 
+  /** \brief Issues all queued page writes (merging adjacent pages), unless
+   * `max_concurrent_writes()` write operations are already in flight.
+   */
+  void start_pending_writes();
+
+  /** \brief Writes `pages` (which must be contiguous in the file, starting at `file_offset`) with a
+   * single vectored write, then completes each page individually.
+   */
+  void write_coalesced(i64 file_offset, std::vector<PendingWrite>&& pages);
+
+  /** \brief Called when a write operation issued by `start_pending_writes` is done.
+   */
+  void finish_write_op();
+
   void read_some(PageId page_id, i64 page_offset_in_file, std::shared_ptr<PageBuffer>&& page_buffer,
                  usize page_buffer_size, usize n_read_so_far, ReadHandler&& handler);
 
+  void read_tail_some(i64 tail_offset_in_file, std::shared_ptr<PageBuffer::Block[]>&& tail_buffer,
+                      usize tail_size, usize byte_count, usize n_read_so_far,
+                      ReadTailHandler&& handler);
+
+  /** \brief Reads `pages` (which must be contiguous in the file, starting at `file_offset`) with a
+   * single vectored read, then completes each page individually.
+   */
+  void read_coalesced(i64 file_offset, std::vector<CoalescedPage>&& pages);
+
+  /** \brief Completes a page whose data has been fully read into its buffer by a merged read.
+   */
+  void finish_coalesced_page(CoalescedPage&& page);
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   // The backing file for this page device.  Could be a flat file or a raw block device.
@@ -68,6 +352,71 @@ class IoRingPageFileDevice : public PageDevice
   // Used to construct and parse PageIds for this device.
   //
   PageIdFactory page_ids_;
+
+  // Registered page buffers for fixed I/O; nullptr unless `enable_registered_page_buffers` has been
+  // called.
+  //
+  std::shared_ptr<PageBufferSlab> buffer_slab_;
+
+  // The limit on the size of merged reads.
+  //
+  usize max_coalesced_read_size_;
+
+  // The limit on the size of merged writes.
+  //
+  usize max_coalesced_write_size_;
+
+  // The number of in-flight write operations at which writes start being queued.
+  //
+  usize max_concurrent_writes_;
+
+  // Protects `pending_writes_` and `writes_in_flight_`.
+  //
+  std::mutex write_mutex_;
+
+  // Page writes queued to be merged.
+  //
+  std::vector<PendingWrite> pending_writes_;
+
+  // The number of write operations issued by `start_pending_writes` that haven't completed yet.
+  //
+  usize writes_in_flight_ = 0;
+
+  // The number of dropped pages collected before a discard batch is issued (0 = no discards).
+  //
+  usize discard_batch_size_;
+
+  // Protects all the members below.
+  //
+  std::mutex discard_mutex_;
+
+  // The physical pages dropped but not yet discarded.
+  //
+  std::unordered_set<u64> pending_discards_;
+
+  // The physical pages in the discard batch that is in flight.
+  //
+  std::unordered_set<u64> discards_in_flight_;
+
+  // The number of discard operations in the in-flight batch that haven't completed yet.
+  //
+  usize discard_ops_in_flight_ = 0;
+
+  // Writes to pages in `discards_in_flight_`, issued when the batch completes.
+  //
+  std::vector<DeferredWrite> deferred_writes_;
+
+  // Cleared if the file doesn't support hole punching.
+  //
+  bool discard_supported_ = true;
+
+  // Set by close(); from then on, queued discards are issued without waiting for a full batch.
+  //
+  bool discards_closing_ = false;
+
+  // Signalled when `discard_ops_in_flight_` drops to zero with nothing left to issue.
+  //
+  std::condition_variable discards_done_;
 };
 
 }  // namespace llfs
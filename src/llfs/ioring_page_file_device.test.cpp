@@ -0,0 +1,825 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/ioring_page_file_device.hpp>
+//
+#include <llfs/ioring_page_file_device.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#ifndef LLFS_DISABLE_IO_URING
+
+#include <llfs/packed_page_header.hpp>
+#include <llfs/page_buffer.hpp>
+
+#include <batteries/finally.hpp>
+
+#include <csignal>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace {
+
+using namespace llfs::int_types;
+
+// Test Plan:
+//  1. With at most one write in flight, writes queued behind it to physically adjacent pages are
+//     merged into one vectored write; the data of every page can be read back.
+//  2. Queued writes to pages that aren't adjacent, or that follow a page whose unused tail is not
+//     written, are issued as separate writes.
+//  3. If a merged write only partly succeeds (here, because the file size limit cuts it short),
+//     each page is completed individually: the pages before the limit succeed, the ones past it
+//     report an error, and the device keeps accepting writes afterwards.
+//  4. A write to a page whose discard is in flight is held until the discard completes, so the
+//     new data is not wiped out by the discard.
+//  5. Dropped pages are only discarded once discard_batch_size of them are queued; the batch is
+//     issued with one discard per run of adjacent pages, and the discarded pages can't be read.
+//  6. A queued page that is written again is taken off the discard queue; flush_discards issues a
+//     partial batch.
+//  7. close() issues the queued discards and waits for them to finish.
+//  8. read_batch hands all of its reads to the kernel with a single submit; reading the same pages
+//     one at a time takes one submit each.
+//  9. read_batch merges the reads of physically adjacent pages (requested in any order) into one
+//     vectored read; every handler gets its own page.
+// 10. Runs of adjacent pages are split into reads of at most max_coalesced_read_size bytes.
+// 11. Pages that aren't adjacent, and repeated ids, are read separately; every copy of a repeated
+//     id gets the page.
+// 12. If a merged read comes up short (here, because the file ends in the middle of the run), the
+//     fully read pages complete and the rest are re-read on their own, so only the pages past the
+//     end of the file fail.
+// 13. If a merged read fails, each page is re-read on its own and reports its own error.
+// 14. read_batch fails ids whose physical page is past the end of the device with kOutOfRange and
+//     reads the rest.
+
+constexpr u64 kPageSize = 4096;
+constexpr i64 kPageCount = 16;
+constexpr llfs::page_device_id_int kDeviceId = 5;
+
+class IoRingPageFileDeviceTest : public ::testing::Test
+{
+ public:
+  void SetUp() override
+  {
+    llfs::StatusOr<llfs::IoRing> io = llfs::IoRing::make_new(llfs::MaxQueueDepth{64});
+    ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+    this->io_.emplace(std::move(*io));
+
+    const int fd = ::open(this->file_name_.c_str(), O_CREAT | O_TRUNC | O_RDWR, /*mode=*/0644);
+    ASSERT_GE(fd, 0) << std::strerror(errno);
+
+    // Leave room for the config itself at the start of the file, as a StorageFile would.
+    //
+    const int retval = ::ftruncate(fd, kPageSize * (kPageCount + 1));
+    ::close(fd);
+    ASSERT_EQ(retval, 0) << std::strerror(errno);
+
+    std::memset(&this->config_, 0, sizeof(this->config_));
+
+    this->config_.page_0_offset = kPageSize;
+    this->config_.device_id = kDeviceId;
+    this->config_.page_count = kPageCount;
+    this->config_.page_size_log2 = 12;
+  }
+
+  void TearDown() override
+  {
+    this->device_ = nullptr;
+    ::unlink(this->file_name_.c_str());
+  }
+
+  void open_device(const llfs::IoRingPageFileDeviceOptions& options)
+  {
+    this->open_device_on(this->file_name_, O_RDWR, options);
+  }
+
+  // Opens the device on an arbitrary path (e.g., a directory, so that every read fails).
+  //
+  void open_device_on(const std::string& path, int flags,
+                      const llfs::IoRingPageFileDeviceOptions& options)
+  {
+    const int fd = ::open(path.c_str(), flags);
+    ASSERT_GE(fd, 0) << std::strerror(errno);
+
+    llfs::StatusOr<llfs::IoRing::File> file = llfs::IoRing::File::open(*this->io_, fd);
+    ASSERT_TRUE(file.ok()) << BATT_INSPECT(file.status());
+
+    this->device_ = std::make_unique<llfs::IoRingPageFileDevice>(
+        std::move(*file), llfs::FileOffsetPtr<llfs::PackedPageDeviceConfig>{this->config_, 0},
+        options);
+  }
+
+  // At most one write in flight, so that the writes issued after the first one are queued.
+  //
+  static llfs::IoRingPageFileDeviceOptions queued_write_options()
+  {
+    llfs::IoRingPageFileDeviceOptions options;
+    options.max_concurrent_writes = 1;
+    return options;
+  }
+
+  static llfs::IoRingPageFileDeviceOptions discard_options(usize batch_size)
+  {
+    llfs::IoRingPageFileDeviceOptions options;
+    options.discard_batch_size = batch_size;
+    return options;
+  }
+
+  void drop_page(llfs::PageId page_id)
+  {
+    llfs::Optional<llfs::Status> result;
+    this->device_->drop(page_id, [&result](llfs::Status status) {
+      result = status;
+    });
+
+    // Dropping a page completes right away, even if it is discarded.
+    //
+    ASSERT_TRUE(result);
+    EXPECT_TRUE(result->ok()) << BATT_INSPECT(*result);
+  }
+
+  // Runs the IoRing until all the I/O issued so far is done.
+  //
+  void run_io()
+  {
+    llfs::Status status = this->io_->run();
+    EXPECT_TRUE(status.ok()) << BATT_INSPECT(status);
+    this->io_->reset();
+  }
+
+  llfs::PageId page_id(i64 physical_page, u64 generation = 1)
+  {
+    return this->device_->page_ids().make_page_id(physical_page, generation);
+  }
+
+  // Starts writing the page (filled with `value`); the result is stored in `*result` once the I/O
+  // has run.
+  //
+  void start_write(llfs::PageId page_id, u8 value, llfs::Optional<llfs::Status>* result,
+                   llfs::Optional<usize> unused_begin = llfs::None)
+  {
+    llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer = this->device_->prepare(page_id);
+    ASSERT_TRUE(buffer.ok()) << BATT_INSPECT(buffer.status());
+
+    std::memset((*buffer)->mutable_payload().data(), value, (*buffer)->mutable_payload().size());
+    if (unused_begin) {
+      llfs::mutable_page_header(buffer->get())->unused_begin = *unused_begin;
+    }
+
+    this->device_->write(std::move(*buffer), [result](llfs::Status status) {
+      *result = status;
+    });
+  }
+
+  // Returns the first payload byte of the page.
+  //
+  llfs::StatusOr<u8> read_page(llfs::PageId page_id)
+  {
+    llfs::Optional<llfs::PageDevice::ReadResult> result;
+    this->device_->read(page_id, [&result](llfs::PageDevice::ReadResult page) {
+      result = std::move(page);
+    });
+    this->run_io();
+
+    EXPECT_TRUE(result);
+    BATT_REQUIRE_OK(*result);
+
+    return static_cast<const u8*>((**result)->const_payload().data())[0];
+  }
+
+  // Starts reading the pages with one call to read_batch; the first payload byte (or error) of
+  // each page is stored in `*results` once the I/O has run.
+  //
+  void start_read_batch(const std::vector<llfs::PageId>& page_ids,
+                        std::vector<llfs::Optional<llfs::StatusOr<u8>>>* results)
+  {
+    results->clear();
+    results->resize(page_ids.size());
+
+    std::vector<llfs::PageDevice::ReadHandler> handlers;
+    for (usize i = 0; i < page_ids.size(); ++i) {
+      handlers.emplace_back([results, i](llfs::PageDevice::ReadResult page) {
+        if (!page.ok()) {
+          (*results)[i] = page.status();
+        } else {
+          (*results)[i] = static_cast<const u8*>((*page)->const_payload().data())[0];
+        }
+      });
+    }
+
+    this->device_->read_batch(llfs::as_slice(page_ids), std::move(handlers));
+  }
+
+  // Writes the pages (page `i` filled with `value_base + i`) and waits for the writes to finish.
+  //
+  void write_pages(const std::vector<i64>& physical_pages, u8 value_base)
+  {
+    for (i64 i : physical_pages) {
+      llfs::Optional<llfs::Status> result;
+      this->start_write(this->page_id(i), value_base + i, &result);
+      this->run_io();
+
+      ASSERT_TRUE(result) << BATT_INSPECT(i);
+      ASSERT_TRUE(result->ok()) << BATT_INSPECT(i) << BATT_INSPECT(*result);
+    }
+  }
+
+  // The number of io_uring_submit calls made so far.
+  //
+  u64 submit_call_count() const
+  {
+    return this->io_->queue_metrics(0).submit_call_count.load();
+  }
+
+ protected:
+  const std::string file_name_ = "/tmp/llfs_IoRingPageFileDeviceTest.llfs";
+
+  llfs::PackedPageDeviceConfig config_;
+
+  llfs::Optional<llfs::IoRing> io_;
+
+  std::unique_ptr<llfs::IoRingPageFileDevice> device_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST_F(IoRingPageFileDeviceTest, AdjacentWritesCoalesce)
+{
+  this->open_device(queued_write_options());
+
+  auto& metrics = llfs::IoRingPageFileDevice::metrics();
+  const u64 write_ops_before = metrics.write_op_count.load();
+  const u64 coalesced_before = metrics.coalesced_write_page_count.load();
+
+  // The first write goes out right away; the rest (submitted out of order) wait for it.
+  //
+  std::vector<llfs::Optional<llfs::Status>> results(5);
+  this->start_write(this->page_id(0), 10, &results[0]);
+  this->start_write(this->page_id(4), 14, &results[4]);
+  this->start_write(this->page_id(2), 12, &results[2]);
+  this->start_write(this->page_id(1), 11, &results[1]);
+  this->start_write(this->page_id(3), 13, &results[3]);
+
+  EXPECT_EQ(metrics.write_op_count.load() - write_ops_before, 1u);
+
+  this->run_io();
+
+  for (usize i = 0; i < results.size(); ++i) {
+    ASSERT_TRUE(results[i]) << BATT_INSPECT(i);
+    EXPECT_TRUE(results[i]->ok()) << BATT_INSPECT(i) << BATT_INSPECT(*results[i]);
+  }
+
+  EXPECT_EQ(metrics.write_op_count.load() - write_ops_before, 2u);
+  EXPECT_EQ(metrics.coalesced_write_page_count.load() - coalesced_before, 4u);
+
+  for (i64 i = 0; i < 5; ++i) {
+    llfs::StatusOr<u8> value = this->read_page(this->page_id(i));
+    ASSERT_TRUE(value.ok()) << BATT_INSPECT(value.status()) << BATT_INSPECT(i);
+    EXPECT_EQ(*value, 10 + i);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST_F(IoRingPageFileDeviceTest, NonAdjacentWritesDoNotCoalesce)
+{
+  this->open_device(queued_write_options());
+
+  auto& metrics = llfs::IoRingPageFileDevice::metrics();
+  const u64 write_ops_before = metrics.write_op_count.load();
+  const u64 coalesced_before = metrics.coalesced_write_page_count.load();
+
+  // Queued behind page 0: pages 2 and 4 (not adjacent to anything), then pages 6 (only the first
+  // 512 bytes written), 7 and 8.  Page 6 ends in a gap, so only 7 and 8 can be merged.
+  //
+  std::vector<llfs::Optional<llfs::Status>> results(9);
+  this->start_write(this->page_id(0), 20, &results[0]);
+  this->start_write(this->page_id(2), 22, &results[2]);
+  this->start_write(this->page_id(4), 24, &results[4]);
+  this->start_write(this->page_id(6), 26, &results[6], /*unused_begin=*/512);
+  this->start_write(this->page_id(7), 27, &results[7]);
+  this->start_write(this->page_id(8), 28, &results[8]);
+
+  this->run_io();
+
+  for (i64 i : {0, 2, 4, 6, 7, 8}) {
+    ASSERT_TRUE(results[i]) << BATT_INSPECT(i);
+    EXPECT_TRUE(results[i]->ok()) << BATT_INSPECT(i) << BATT_INSPECT(*results[i]);
+  }
+
+  // Page 0, pages 2, 4 and 6 alone, and pages 7-8 merged.
+  //
+  EXPECT_EQ(metrics.write_op_count.load() - write_ops_before, 5u);
+  EXPECT_EQ(metrics.coalesced_write_page_count.load() - coalesced_before, 2u);
+
+  for (i64 i : {0, 2, 4, 6, 7, 8}) {
+    llfs::StatusOr<u8> value = this->read_page(this->page_id(i));
+    ASSERT_TRUE(value.ok()) << BATT_INSPECT(value.status()) << BATT_INSPECT(i);
+    EXPECT_EQ(*value, 20 + i);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 3.
+//
+TEST_F(IoRingPageFileDeviceTest, PartialWriteFailureFansOut)
+{
+  this->open_device(queued_write_options());
+
+  // Writing past the file size limit fails with EFBIG (instead of raising SIGXFSZ, once the signal
+  // is ignored); a write that crosses the limit is cut short.
+  //
+  const auto old_handler = std::signal(SIGXFSZ, SIG_IGN);
+  struct rlimit old_limit;
+  ASSERT_EQ(::getrlimit(RLIMIT_FSIZE, &old_limit), 0);
+
+  const auto restore_limit = batt::finally([&] {
+    ::setrlimit(RLIMIT_FSIZE, &old_limit);
+    std::signal(SIGXFSZ, old_handler);
+  });
+
+  // Pages 0-3 are below the limit; 4 and 5 are past it (the config takes up the first page).
+  //
+  struct rlimit limit = old_limit;
+  limit.rlim_cur = kPageSize * (1 + 4);
+  ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &limit), 0) << std::strerror(errno);
+
+  auto& metrics = llfs::IoRingPageFileDevice::metrics();
+  const u64 coalesced_before = metrics.coalesced_write_page_count.load();
+
+  std::vector<llfs::Optional<llfs::Status>> results(6);
+  this->start_write(this->page_id(0), 30, &results[0]);
+  for (i64 i = 2; i < 6; ++i) {
+    this->start_write(this->page_id(i), 30 + i, &results[i]);
+  }
+
+  this->run_io();
+
+  EXPECT_EQ(metrics.coalesced_write_page_count.load() - coalesced_before, 4u);
+
+  for (i64 i : {0, 2, 3}) {
+    ASSERT_TRUE(results[i]) << BATT_INSPECT(i);
+    EXPECT_TRUE(results[i]->ok()) << BATT_INSPECT(i) << BATT_INSPECT(*results[i]);
+  }
+  for (i64 i : {4, 5}) {
+    ASSERT_TRUE(results[i]) << BATT_INSPECT(i);
+    EXPECT_FALSE(results[i]->ok()) << BATT_INSPECT(i);
+  }
+
+  ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &old_limit), 0);
+
+  // No write is left in flight: a new write goes out right away and succeeds.
+  //
+  llfs::Optional<llfs::Status> rewrite_result;
+  this->start_write(this->page_id(4), 44, &rewrite_result);
+  this->run_io();
+
+  ASSERT_TRUE(rewrite_result);
+  EXPECT_TRUE(rewrite_result->ok()) << BATT_INSPECT(*rewrite_result);
+
+  for (i64 i : {0, 2, 3}) {
+    llfs::StatusOr<u8> value = this->read_page(this->page_id(i));
+    ASSERT_TRUE(value.ok()) << BATT_INSPECT(value.status()) << BATT_INSPECT(i);
+    EXPECT_EQ(*value, 30 + i);
+  }
+  {
+    llfs::StatusOr<u8> value = this->read_page(this->page_id(4));
+    ASSERT_TRUE(value.ok()) << BATT_INSPECT(value.status());
+    EXPECT_EQ(*value, 44);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 4.
+//
+TEST_F(IoRingPageFileDeviceTest, WriteAfterDiscardIsOrdered)
+{
+  this->open_device(discard_options(/*batch_size=*/1));
+
+  auto& metrics = llfs::IoRingPageFileDevice::metrics();
+  const u64 deferred_before = metrics.write_after_discard_count.load();
+
+  llfs::Optional<llfs::Status> first_write;
+  this->start_write(this->page_id(3), 50, &first_write);
+  this->run_io();
+
+  ASSERT_TRUE(first_write);
+  ASSERT_TRUE(first_write->ok()) << BATT_INSPECT(*first_write);
+
+  // Dropping the page issues its discard right away (the batch size is 1); the new generation of
+  // the page is written before the discard has completed.
+  //
+  this->drop_page(this->page_id(3));
+
+  llfs::Optional<llfs::Status> second_write;
+  this->start_write(this->page_id(3, /*generation=*/2), 51, &second_write);
+
+  EXPECT_EQ(metrics.write_after_discard_count.load() - deferred_before, 1u);
+  EXPECT_FALSE(second_write);
+
+  this->run_io();
+
+  ASSERT_TRUE(second_write);
+  EXPECT_TRUE(second_write->ok()) << BATT_INSPECT(*second_write);
+
+  llfs::StatusOr<u8> value = this->read_page(this->page_id(3, /*generation=*/2));
+  ASSERT_TRUE(value.ok()) << BATT_INSPECT(value.status());
+  EXPECT_EQ(*value, 51);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 5.
+//
+TEST_F(IoRingPageFileDeviceTest, DiscardBatching)
+{
+  this->open_device(discard_options(/*batch_size=*/3));
+
+  for (i64 i : {1, 2, 5}) {
+    llfs::Optional<llfs::Status> result;
+    this->start_write(this->page_id(i), 60 + i, &result);
+    this->run_io();
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result->ok()) << BATT_INSPECT(*result);
+  }
+
+  auto& metrics = llfs::IoRingPageFileDevice::metrics();
+  const u64 discard_ops_before = metrics.discard_op_count.load();
+  const u64 discard_pages_before = metrics.discard_page_count.load();
+  const u64 discard_errors_before = metrics.discard_error_count.load();
+
+  this->drop_page(this->page_id(5));
+  this->drop_page(this->page_id(1));
+
+  EXPECT_EQ(metrics.discard_op_count.load() - discard_ops_before, 0u);
+
+  // The third page fills the batch: pages 1-2 in one discard, page 5 in another.
+  //
+  this->drop_page(this->page_id(2));
+
+  EXPECT_EQ(metrics.discard_op_count.load() - discard_ops_before, 2u);
+  EXPECT_EQ(metrics.discard_page_count.load() - discard_pages_before, 3u);
+
+  this->run_io();
+
+  // If the file system can't punch holes, the discards fail (harmlessly) and the data stays.
+  //
+  if (metrics.discard_error_count.load() == discard_errors_before) {
+    for (i64 i : {1, 2, 5}) {
+      EXPECT_FALSE(this->read_page(this->page_id(i)).ok()) << BATT_INSPECT(i);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 6.
+//
+TEST_F(IoRingPageFileDeviceTest, DiscardSuppressedAndFlushed)
+{
+  this->open_device(discard_options(/*batch_size=*/2));
+
+  auto& metrics = llfs::IoRingPageFileDevice::metrics();
+  const u64 discard_ops_before = metrics.discard_op_count.load();
+  const u64 discard_pages_before = metrics.discard_page_count.load();
+  const u64 suppressed_before = metrics.discard_suppressed_count.load();
+  const u64 deferred_before = metrics.write_after_discard_count.load();
+
+  this->drop_page(this->page_id(4));
+
+  // Writing the page again takes it off the queue, so the next drop doesn't fill the batch.
+  //
+  llfs::Optional<llfs::Status> write_result;
+  this->start_write(this->page_id(4, /*generation=*/2), 70, &write_result);
+
+  EXPECT_EQ(metrics.discard_suppressed_count.load() - suppressed_before, 1u);
+  EXPECT_EQ(metrics.write_after_discard_count.load() - deferred_before, 0u);
+
+  this->drop_page(this->page_id(9));
+
+  EXPECT_EQ(metrics.discard_op_count.load() - discard_ops_before, 0u);
+
+  this->device_->flush_discards();
+
+  EXPECT_EQ(metrics.discard_op_count.load() - discard_ops_before, 1u);
+  EXPECT_EQ(metrics.discard_page_count.load() - discard_pages_before, 1u);
+
+  this->run_io();
+
+  ASSERT_TRUE(write_result);
+  ASSERT_TRUE(write_result->ok()) << BATT_INSPECT(*write_result);
+
+  llfs::StatusOr<u8> value = this->read_page(this->page_id(4, /*generation=*/2));
+  ASSERT_TRUE(value.ok()) << BATT_INSPECT(value.status());
+  EXPECT_EQ(*value, 70);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 7.
+//
+TEST_F(IoRingPageFileDeviceTest, CloseWaitsForDiscards)
+{
+  this->open_device(discard_options(/*batch_size=*/8));
+
+  auto& metrics = llfs::IoRingPageFileDevice::metrics();
+  const u64 discard_ops_before = metrics.discard_op_count.load();
+  const u64 discard_pages_before = metrics.discard_page_count.load();
+
+  this->drop_page(this->page_id(6));
+  this->drop_page(this->page_id(11));
+
+  EXPECT_EQ(metrics.discard_op_count.load() - discard_ops_before, 0u);
+
+  // close() blocks until the discards complete, so the IoRing has to run on another thread.
+  //
+  this->io_->on_work_started();
+  llfs::Status io_status;
+  std::thread io_thread{[this, &io_status] {
+    io_status = this->io_->run();
+  }};
+
+  this->device_->close();
+
+  EXPECT_EQ(metrics.discard_op_count.load() - discard_ops_before, 2u);
+  EXPECT_EQ(metrics.discard_page_count.load() - discard_pages_before, 2u);
+
+  this->device_ = nullptr;
+
+  this->io_->on_work_finished();
+  io_thread.join();
+
+  EXPECT_TRUE(io_status.ok()) << BATT_INSPECT(io_status);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 8.
+//
+TEST_F(IoRingPageFileDeviceTest, ReadBatchSubmitsOnce)
+{
+  this->open_device(llfs::IoRingPageFileDeviceOptions{});
+
+  // No two pages are adjacent, so each one gets a read of its own.
+  //
+  const std::vector<i64> physical_pages{1, 3, 5, 8, 12};
+  this->write_pages(physical_pages, 80);
+
+  std::vector<llfs::PageId> page_ids;
+  for (i64 i : physical_pages) {
+    page_ids.emplace_back(this->page_id(i));
+  }
+
+  auto& metrics = llfs::IoRingPageFileDevice::metrics();
+  const u64 read_ops_before = metrics.read_op_count.load();
+  const u64 submits_before = this->submit_call_count();
+
+  std::vector<llfs::Optional<llfs::StatusOr<u8>>> results;
+  this->start_read_batch(page_ids, &results);
+
+  EXPECT_EQ(metrics.read_op_count.load() - read_ops_before, physical_pages.size());
+  EXPECT_EQ(this->submit_call_count() - submits_before, 1u);
+
+  this->run_io();
+
+  for (usize i = 0; i < physical_pages.size(); ++i) {
+    ASSERT_TRUE(results[i]) << BATT_INSPECT(i);
+    ASSERT_TRUE(results[i]->ok()) << BATT_INSPECT(i) << BATT_INSPECT(results[i]->status());
+    EXPECT_EQ(**results[i], 80 + physical_pages[i]);
+  }
+
+  // Without a batch, every read is submitted by itself.
+  //
+  const u64 single_submits_before = this->submit_call_count();
+  std::vector<llfs::Optional<llfs::PageDevice::ReadResult>> single_results(page_ids.size());
+  for (usize i = 0; i < page_ids.size(); ++i) {
+    this->device_->read(page_ids[i], [&single_results, i](llfs::PageDevice::ReadResult page) {
+      single_results[i] = std::move(page);
+    });
+  }
+
+  EXPECT_EQ(this->submit_call_count() - single_submits_before, page_ids.size());
+
+  this->run_io();
+
+  for (usize i = 0; i < page_ids.size(); ++i) {
+    ASSERT_TRUE(single_results[i]) << BATT_INSPECT(i);
+    EXPECT_TRUE(single_results[i]->ok()) << BATT_INSPECT(i);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 9.
+//
+TEST_F(IoRingPageFileDeviceTest, AdjacentReadsCoalesce)
+{
+  this->open_device(llfs::IoRingPageFileDeviceOptions{});
+  this->write_pages({2, 3, 4, 5}, 90);
+
+  auto& metrics = llfs::IoRingPageFileDevice::metrics();
+  const u64 read_ops_before = metrics.read_op_count.load();
+  const u64 page_reads_before = metrics.page_read_count.load();
+  const u64 coalesced_before = metrics.coalesced_page_count.load();
+
+  const std::vector<i64> physical_pages{4, 2, 5, 3};
+  std::vector<llfs::PageId> page_ids;
+  for (i64 i : physical_pages) {
+    page_ids.emplace_back(this->page_id(i));
+  }
+
+  std::vector<llfs::Optional<llfs::StatusOr<u8>>> results;
+  this->start_read_batch(page_ids, &results);
+  this->run_io();
+
+  EXPECT_EQ(metrics.read_op_count.load() - read_ops_before, 1u);
+  EXPECT_EQ(metrics.page_read_count.load() - page_reads_before, 4u);
+  EXPECT_EQ(metrics.coalesced_page_count.load() - coalesced_before, 4u);
+
+  for (usize i = 0; i < physical_pages.size(); ++i) {
+    ASSERT_TRUE(results[i]) << BATT_INSPECT(i);
+    ASSERT_TRUE(results[i]->ok()) << BATT_INSPECT(i) << BATT_INSPECT(results[i]->status());
+    EXPECT_EQ(**results[i], 90 + physical_pages[i]) << BATT_INSPECT(i);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 10.
+//
+TEST_F(IoRingPageFileDeviceTest, CoalescedReadSizeLimit)
+{
+  this->open_device(llfs::IoRingPageFileDeviceOptions{});
+  this->device_->set_max_coalesced_read_size(2 * kPageSize);
+  this->write_pages({0, 1, 2, 3, 4}, 100);
+
+  auto& metrics = llfs::IoRingPageFileDevice::metrics();
+  const u64 read_ops_before = metrics.read_op_count.load();
+  const u64 coalesced_before = metrics.coalesced_page_count.load();
+
+  std::vector<llfs::PageId> page_ids;
+  for (i64 i = 0; i < 5; ++i) {
+    page_ids.emplace_back(this->page_id(i));
+  }
+
+  std::vector<llfs::Optional<llfs::StatusOr<u8>>> results;
+  this->start_read_batch(page_ids, &results);
+  this->run_io();
+
+  // Pages 0-1 and 2-3 merged, and page 4 alone.
+  //
+  EXPECT_EQ(metrics.read_op_count.load() - read_ops_before, 3u);
+  EXPECT_EQ(metrics.coalesced_page_count.load() - coalesced_before, 4u);
+
+  for (usize i = 0; i < page_ids.size(); ++i) {
+    ASSERT_TRUE(results[i]) << BATT_INSPECT(i);
+    ASSERT_TRUE(results[i]->ok()) << BATT_INSPECT(i) << BATT_INSPECT(results[i]->status());
+    EXPECT_EQ(**results[i], 100 + static_cast<i64>(i)) << BATT_INSPECT(i);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 11.
+//
+TEST_F(IoRingPageFileDeviceTest, NonAdjacentAndRepeatedReads)
+{
+  this->open_device(llfs::IoRingPageFileDeviceOptions{});
+  this->write_pages({1, 3, 6, 7}, 110);
+
+  auto& metrics = llfs::IoRingPageFileDevice::metrics();
+  const u64 read_ops_before = metrics.read_op_count.load();
+  const u64 page_reads_before = metrics.page_read_count.load();
+  const u64 coalesced_before = metrics.coalesced_page_count.load();
+
+  const std::vector<i64> physical_pages{3, 7, 1, 3, 6};
+  std::vector<llfs::PageId> page_ids;
+  for (i64 i : physical_pages) {
+    page_ids.emplace_back(this->page_id(i));
+  }
+
+  std::vector<llfs::Optional<llfs::StatusOr<u8>>> results;
+  this->start_read_batch(page_ids, &results);
+  this->run_io();
+
+  // Pages 1 and 3 (twice) alone, and pages 6-7 merged.
+  //
+  EXPECT_EQ(metrics.read_op_count.load() - read_ops_before, 4u);
+  EXPECT_EQ(metrics.page_read_count.load() - page_reads_before, 5u);
+  EXPECT_EQ(metrics.coalesced_page_count.load() - coalesced_before, 2u);
+
+  for (usize i = 0; i < physical_pages.size(); ++i) {
+    ASSERT_TRUE(results[i]) << BATT_INSPECT(i);
+    ASSERT_TRUE(results[i]->ok()) << BATT_INSPECT(i) << BATT_INSPECT(results[i]->status());
+    EXPECT_EQ(**results[i], 110 + physical_pages[i]) << BATT_INSPECT(i);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 12.
+//
+TEST_F(IoRingPageFileDeviceTest, ShortCoalescedReadFallsBack)
+{
+  this->open_device(llfs::IoRingPageFileDeviceOptions{});
+  this->write_pages({12, 13, 14, 15}, 120);
+
+  // Cut the file off half way through page 14 (the config takes up the first page).
+  //
+  ASSERT_EQ(::truncate(this->file_name_.c_str(), kPageSize * (1 + 14) + kPageSize / 2), 0)
+      << std::strerror(errno);
+
+  auto& metrics = llfs::IoRingPageFileDevice::metrics();
+  const u64 coalesced_before = metrics.coalesced_page_count.load();
+
+  std::vector<llfs::PageId> page_ids;
+  for (i64 i = 12; i < 16; ++i) {
+    page_ids.emplace_back(this->page_id(i));
+  }
+
+  std::vector<llfs::Optional<llfs::StatusOr<u8>>> results;
+  this->start_read_batch(page_ids, &results);
+  this->run_io();
+
+  EXPECT_EQ(metrics.coalesced_page_count.load() - coalesced_before, 4u);
+
+  for (usize i : {0, 1}) {
+    ASSERT_TRUE(results[i]) << BATT_INSPECT(i);
+    ASSERT_TRUE(results[i]->ok()) << BATT_INSPECT(i) << BATT_INSPECT(results[i]->status());
+    EXPECT_EQ(**results[i], 120 + 12 + static_cast<i64>(i)) << BATT_INSPECT(i);
+  }
+  for (usize i : {2, 3}) {
+    ASSERT_TRUE(results[i]) << BATT_INSPECT(i);
+    EXPECT_EQ(results[i]->status(), llfs::Status{batt::StatusCode::kOutOfRange}) << BATT_INSPECT(i);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 13.
+//
+TEST_F(IoRingPageFileDeviceTest, FailedCoalescedReadFallsBack)
+{
+  // Reading a directory fails (with EISDIR) no matter what.
+  //
+  this->open_device_on("/tmp", O_RDONLY | O_DIRECTORY, llfs::IoRingPageFileDeviceOptions{});
+
+  auto& metrics = llfs::IoRingPageFileDevice::metrics();
+  const u64 coalesced_before = metrics.coalesced_page_count.load();
+
+  const std::vector<llfs::PageId> page_ids{this->page_id(2), this->page_id(3), this->page_id(4)};
+
+  std::vector<llfs::Optional<llfs::StatusOr<u8>>> results;
+  this->start_read_batch(page_ids, &results);
+  this->run_io();
+
+  EXPECT_EQ(metrics.coalesced_page_count.load() - coalesced_before, 3u);
+
+  for (usize i = 0; i < page_ids.size(); ++i) {
+    ASSERT_TRUE(results[i]) << BATT_INSPECT(i);
+    EXPECT_FALSE(results[i]->ok()) << BATT_INSPECT(i);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 14.
+//
+TEST_F(IoRingPageFileDeviceTest, ReadBatchOutOfRangePage)
+{
+  this->open_device(llfs::IoRingPageFileDeviceOptions{});
+  this->write_pages({6, 7}, 60);
+
+  // The page id layout has room for more physical pages than the device holds, so this id decodes
+  // to a page past the end.
+  //
+  const llfs::PageIdFactory page_ids = this->device_->page_ids();
+
+  const llfs::PageId past_end_page_id{page_ids.make_page_id(6, 1).int_value() + kPageCount};
+  ASSERT_EQ(page_ids.get_physical_page(past_end_page_id), 6 + kPageCount);
+
+  const std::vector<llfs::PageId> page_ids_to_read{this->page_id(6), past_end_page_id,
+                                                   this->page_id(7)};
+
+  std::vector<llfs::Optional<llfs::StatusOr<u8>>> results;
+  this->start_read_batch(page_ids_to_read, &results);
+  this->run_io();
+
+  ASSERT_TRUE(results[0]);
+  ASSERT_TRUE(results[0]->ok()) << BATT_INSPECT(results[0]->status());
+  EXPECT_EQ(**results[0], 66);
+
+  ASSERT_TRUE(results[1]);
+  EXPECT_EQ(results[1]->status(), llfs::Status{batt::StatusCode::kOutOfRange});
+
+  ASSERT_TRUE(results[2]);
+  ASSERT_TRUE(results[2]->ok()) << BATT_INSPECT(results[2]->status());
+  EXPECT_EQ(**results[2], 67);
+}
+
+}  // namespace
+
+#endif  // LLFS_DISABLE_IO_URING
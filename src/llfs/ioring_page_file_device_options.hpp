@@ -0,0 +1,46 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_IORING_PAGE_FILE_DEVICE_OPTIONS_HPP
+#define LLFS_IORING_PAGE_FILE_DEVICE_OPTIONS_HPP
+
+#include <llfs/config.hpp>
+#include <llfs/constants.hpp>
+#include <llfs/int_types.hpp>
+
+namespace llfs {
+
+/** \brief Runtime (not stored in the config) options for IoRingPageFileDevice.
+ */
+struct IoRingPageFileDeviceOptions {
+  /** \brief The limit on the size of a single merged read (see IoRingPageFileDevice::read_batch);
+   * a value less than or equal to the page size disables read coalescing.
+   */
+  usize max_coalesced_read_size = 256 * kKiB;
+
+  /** \brief The limit on the size of a single merged write (see IoRingPageFileDevice::write); a
+   * value less than twice the page size disables write coalescing.
+   */
+  usize max_coalesced_write_size = 256 * kKiB;
+
+  /** \brief The number of write operations that may be in flight before further page writes are
+   * queued up to be merged.  Must be at least 1.
+   */
+  usize max_concurrent_writes = 16;
+
+  /** \brief The number of dropped pages collected before a batch of discards is issued; zero means
+   * dropped pages are not discarded at the device level (see IoRingPageFileDevice::drop).
+   */
+  usize discard_batch_size = 0;
+};
+
+
+}  // namespace llfs
+
+#endif  // LLFS_IORING_PAGE_FILE_DEVICE_OPTIONS_HPP
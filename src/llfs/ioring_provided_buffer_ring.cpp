@@ -0,0 +1,169 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/ioring_provided_buffer_ring.hpp>
+//
+
+#ifndef LLFS_DISABLE_IO_URING
+
+#include <batteries/math.hpp>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class IoRingProvidedBufferRing
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<std::unique_ptr<IoRingProvidedBufferRing>> IoRingProvidedBufferRing::make_new(
+    IoRingBufferPool& pool, BufferCount count, u16 group_id) noexcept
+{
+  if (count == 0 || count > Self::kMaxBufferCount) {
+    return {batt::StatusCode::kInvalidArgument};
+  }
+
+  IoRingBufferPool::BufferVec buffers;
+  while (buffers.size() < count) {
+    StatusOr<IoRingBufferPool::Buffer> buffer = pool.try_allocate();
+    BATT_REQUIRE_OK(buffer);
+
+    buffers.emplace_back(std::move(*buffer));
+  }
+
+  const u32 entries = u32{1} << batt::log2_ceil(count);
+
+  std::unique_ptr<IoRingProvidedBufferRing> p_ring{
+      new IoRingProvidedBufferRing{std::move(buffers), entries, group_id}};
+
+  Status status = p_ring->initialize();
+  BATT_REQUIRE_OK(status);
+
+  return p_ring;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ IoRingProvidedBufferRing::IoRingProvidedBufferRing(
+    IoRingBufferPool::BufferVec&& buffers, u32 entries, u16 group_id) noexcept
+    : io_ring_{buffers.front().pool().get_io_ring()}
+    , buffers_{std::move(buffers)}
+    , entries_{entries}
+    , group_id_{group_id}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+IoRingProvidedBufferRing::~IoRingProvidedBufferRing() noexcept
+{
+  BATT_CHECK_EQ(this->in_use_.load(), 0u)
+      << "Buffer ring was destroyed with some buffers still held";
+
+  if (this->buf_ring_ != nullptr) {
+    this->io_ring_.free_buf_ring(this->buf_ring_, this->entries_, this->group_id_)
+        .IgnoreError();
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status IoRingProvidedBufferRing::initialize() noexcept
+{
+  BATT_ASSIGN_OK_RESULT(this->buf_ring_, this->io_ring_.setup_buf_ring(this->entries_,  //
+                                                                           this->group_id_));
+
+  const int mask = io_uring_buf_ring_mask(this->entries_);
+
+  for (usize id = 0; id < this->buffers_.size(); ++id) {
+    const IoRingBufferPool::Buffer& buffer = this->buffers_[id];
+    io_uring_buf_ring_add(this->buf_ring_, buffer.data(), buffer.size(), static_cast<u16>(id), mask,
+                          /*buf_offset=*/id);
+  }
+  io_uring_buf_ring_advance(this->buf_ring_, this->buffers_.size());
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<IoRingProvidedBufferRing::Buffer> IoRingProvidedBufferRing::read_some(IoRing::File& file,
+                                                                               i64 offset)
+{
+  return batt::Task::await<StatusOr<Buffer>>([&](auto&& handler) {
+    this->async_read_some(file, offset, BATT_FORWARD(handler));
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<IoRingProvidedBufferRing::Buffer> IoRingProvidedBufferRing::take_selected_buffer(
+    const StatusOr<i32>& result) noexcept
+{
+  const Optional<u16> id = IoRingImpl::current_completion_buffer_id();
+
+  if (!result.ok()) {
+    // The kernel doesn't consume a buffer for a failed read, but put it back just in case.
+    //
+    if (id) {
+      this->recycle(*id);
+    }
+    return result.status();
+  }
+
+  if (!id) {
+    LLFS_LOG_ERROR() << "Read completed without a selected buffer!" << BATT_INSPECT(result);
+    return {batt::StatusCode::kInternal};
+  }
+  BATT_CHECK_LT(*id, this->buffers_.size());
+
+  this->in_use_.fetch_add(1);
+
+  return Buffer{this, *id, static_cast<usize>(*result)};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingProvidedBufferRing::recycle(u16 id) noexcept
+{
+  const IoRingBufferPool::Buffer& buffer = this->buffers_[id];
+  {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+
+    io_uring_buf_ring_add(this->buf_ring_, buffer.data(), buffer.size(), id,
+                          io_uring_buf_ring_mask(this->entries_), /*buf_offset=*/0);
+    io_uring_buf_ring_advance(this->buf_ring_, 1);
+  }
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class IoRingProvidedBufferRing::Buffer
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+ConstBuffer IoRingProvidedBufferRing::Buffer::get() const noexcept
+{
+  if (this->ring_ == nullptr) {
+    return ConstBuffer{nullptr, 0};
+  }
+  return ConstBuffer{this->ring_->buffers_[this->id_].data(), this->size_};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void IoRingProvidedBufferRing::Buffer::release() noexcept
+{
+  Self* const ring = std::exchange(this->ring_, nullptr);
+  if (ring != nullptr) {
+    ring->recycle(this->id_);
+    ring->in_use_.fetch_sub(1);
+  }
+}
+
+}  //namespace llfs
+
+#endif  // LLFS_DISABLE_IO_URING
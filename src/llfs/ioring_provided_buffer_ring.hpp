@@ -0,0 +1,248 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_IORING_PROVIDED_BUFFER_RING_HPP
+#define LLFS_IORING_PROVIDED_BUFFER_RING_HPP
+
+#include <llfs/config.hpp>
+
+#ifndef LLFS_DISABLE_IO_URING
+
+#include <llfs/api_types.hpp>
+#include <llfs/buffer.hpp>
+#include <llfs/int_types.hpp>
+#include <llfs/ioring.hpp>
+#include <llfs/ioring_buffer_pool.hpp>
+#include <llfs/ioring_file.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/async/task.hpp>
+
+#include <liburing.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace llfs {
+
+/** \brief A set of buffers (borrowed from an IoRingBufferPool) handed to the kernel as a provided
+ * buffer ring (IORING_REGISTER_PBUF_RING), so that reads only claim a buffer once their data
+ * arrives, rather than when they are submitted.
+ *
+ * Reads are started via `async_read_some`/`read_some`; each successful read yields a
+ * IoRingProvidedBufferRing::Buffer, which gives the buffer back to the kernel when it goes out of
+ * scope.  If no buffer is available when the data arrives, the read fails with ENOBUFS.
+ *
+ * Buffer rings belong to a single io_uring, so the IoRing must have exactly one queue.
+ */
+class IoRingProvidedBufferRing
+{
+ public:
+  using Self = IoRingProvidedBufferRing;
+
+  /** \brief The maximum number of buffers in a ring (a kernel limit).
+   */
+  static constexpr usize kMaxBufferCount = 32768;
+
+  //----- --- -- -  -  -   -
+  /** \brief A buffer selected by the kernel to hold the data for a completed read.  Move-only;
+   * returns the buffer to the ring when destroyed (or when `release()` is called).
+   */
+  class Buffer
+  {
+   public:
+    Buffer() = default;
+
+    explicit Buffer(Self* ring, u16 id, usize size) noexcept : ring_{ring}, id_{id}, size_{size}
+    {
+    }
+
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
+    Buffer(Buffer&& that) noexcept
+        : ring_{std::exchange(that.ring_, nullptr)}
+        , id_{that.id_}
+        , size_{that.size_}
+    {
+    }
+
+    Buffer& operator=(Buffer&& that) noexcept
+    {
+      if (this != &that) {
+        this->release();
+        this->ring_ = std::exchange(that.ring_, nullptr);
+        this->id_ = that.id_;
+        this->size_ = that.size_;
+      }
+      return *this;
+    }
+
+    ~Buffer() noexcept
+    {
+      this->release();
+    }
+
+    /** \brief Returns true iff this object holds a buffer.
+     */
+    bool is_valid() const noexcept
+    {
+      return this->ring_ != nullptr;
+    }
+
+    /** \brief The buffer id chosen by the kernel.
+     */
+    u16 id() const noexcept
+    {
+      return this->id_;
+    }
+
+    /** \brief The data read into this buffer.
+     */
+    ConstBuffer get() const noexcept;
+
+    const void* data() const noexcept
+    {
+      return this->get().data();
+    }
+
+    usize size() const noexcept
+    {
+      return this->size_;
+    }
+
+    /** \brief Gives the buffer back to the kernel; this object becomes invalid.
+     */
+    void release() noexcept;
+
+   private:
+    Self* ring_ = nullptr;
+    u16 id_ = 0;
+    usize size_ = 0;
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Creates a buffer ring for buffer group `group_id` out of `count` buffers taken from
+   * `pool` (which must have that many available, or batt::StatusCode::kResourceExhausted is
+   * returned).  The buffers are returned to the pool when the ring is destroyed.
+   */
+  static StatusOr<std::unique_ptr<IoRingProvidedBufferRing>> make_new(IoRingBufferPool& pool,
+                                                                      BufferCount count,
+                                                                      u16 group_id) noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  IoRingProvidedBufferRing(const IoRingProvidedBufferRing&) = delete;
+  IoRingProvidedBufferRing& operator=(const IoRingProvidedBufferRing&) = delete;
+
+  ~IoRingProvidedBufferRing() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const IoRing& get_io_ring() const noexcept
+  {
+    return this->io_ring_;
+  }
+
+  u16 group_id() const noexcept
+  {
+    return this->group_id_;
+  }
+
+  BufferSize buffer_size() const noexcept
+  {
+    return BufferSize{this->buffers_.front().size()};
+  }
+
+  BufferCount buffer_count() const noexcept
+  {
+    return BufferCount{this->buffers_.size()};
+  }
+
+  /** \brief Returns the number of buffers currently held by Buffer objects (i.e., not in the
+   * ring).
+   */
+  usize in_use() const noexcept
+  {
+    return this->in_use_.load();
+  }
+
+  /** \brief Starts a read of up to `buffer_size()` bytes at `offset` in `file`, using a buffer
+   * from this ring.  Invokes `handler` from within `IoRing::run()` with error status or the
+   * selected buffer.
+   *
+   * The signature of the handler is: `void (StatusOr<llfs::IoRingProvidedBufferRing::Buffer>)`.
+   */
+  template <typename Handler = void(StatusOr<Buffer>&&)>
+  void async_read_some(IoRing::File& file, i64 offset, Handler&& handler)
+  {
+    file.async_read_some_select(
+        offset, this->buffer_size(), this->group_id_,
+        batt::bind_handler(BATT_FORWARD(handler), [this](Handler&& handler, StatusOr<i32> result) {
+          BATT_FORWARD(handler)(this->take_selected_buffer(result));
+        }));
+  }
+
+  /** \brief Blocks the current Task until a read of up to `buffer_size()` bytes at `offset` in
+   * `file` completes, returning the selected buffer.
+   */
+  StatusOr<Buffer> read_some(IoRing::File& file, i64 offset);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  explicit IoRingProvidedBufferRing(IoRingBufferPool::BufferVec&& buffers, u32 entries,
+                                    u16 group_id) noexcept;
+
+  /** \brief Registers the ring with the kernel and adds all buffers to it.
+   */
+  Status initialize() noexcept;
+
+  /** \brief Called from a read completion handler; wraps the buffer chosen by the kernel.
+   */
+  StatusOr<Buffer> take_selected_buffer(const StatusOr<i32>& result) noexcept;
+
+  /** \brief Adds the given buffer back to the ring.
+   */
+  void recycle(u16 id) noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const IoRing& io_ring_;
+
+  /** \brief The buffers in the ring; the buffer id is the index into this vector.
+   */
+  IoRingBufferPool::BufferVec buffers_;
+
+  /** \brief The number of ring slots (a power of 2, at least `buffers_.size()`).
+   */
+  const u32 entries_;
+
+  const u16 group_id_;
+
+  /** \brief Serializes updates to the ring tail.
+   */
+  std::mutex mutex_;
+
+  /** \brief The ring shared with the kernel; set by `initialize()`.
+   */
+  struct io_uring_buf_ring* buf_ring_ = nullptr;
+
+  /** \brief The number of buffers currently held by Buffer objects.
+   */
+  std::atomic<usize> in_use_{0};
+};
+
+}  //namespace llfs
+
+#endif  // LLFS_DISABLE_IO_URING
+
+#endif  // LLFS_IORING_PROVIDED_BUFFER_RING_HPP
@@ -0,0 +1,132 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/ioring_provided_buffer_ring.hpp>
+//
+#include <llfs/ioring_provided_buffer_ring.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/constants.hpp>
+
+#include <batteries/async/simple_executor.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+namespace {
+
+// Test Plan:
+//  1. Reads through a provided buffer ring return the file data in kernel-selected buffers; when
+//     all buffers are held, reads fail with ENOBUFS, and releasing a buffer makes it available to
+//     the next read.  All buffers go back to the pool when the ring is destroyed.
+
+using namespace llfs::int_types;
+using namespace llfs::constants;
+
+using llfs::IoRingProvidedBufferRing;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST(IoRingProvidedBufferRingTest, ReadSome)
+{
+  const char* const file_path = "/tmp/llfs_ioring_provided_buffer_ring_test_file";
+  const usize kBufferSize = 4 * kKiB;
+
+  std::string content;
+  for (usize i = 0; i < kBufferSize * 4; ++i) {
+    content.push_back(static_cast<char>('a' + (i / kBufferSize)));
+  }
+
+  int fd = open(file_path, O_CREAT | O_TRUNC | O_RDWR, /*mode=*/0644);
+  ASSERT_GE(fd, 0) << std::strerror(errno);
+  ASSERT_EQ(pwrite(fd, content.data(), content.size(), /*offset=*/0), (ssize_t)content.size());
+
+  llfs::StatusOr<llfs::ScopedIoRing> io =
+      llfs::ScopedIoRing::make_new(llfs::MaxQueueDepth{16}, llfs::ThreadPoolSize{1});
+
+  ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+
+  llfs::IoRing::File file{io->get_io_ring(), fd};
+  file.set_raw_io(false);
+
+  llfs::StatusOr<std::unique_ptr<llfs::IoRingBufferPool>> pool = llfs::IoRingBufferPool::make_new(
+      io->get_io_ring(), llfs::BufferCount{4}, llfs::BufferSize{kBufferSize});
+
+  ASSERT_TRUE(pool.ok()) << BATT_INSPECT(pool.status());
+
+  batt::SimpleExecutionContext ctx;
+
+  batt::Task task{
+      ctx.get_executor(),
+      [&] {
+        llfs::StatusOr<std::unique_ptr<IoRingProvidedBufferRing>> ring =
+            IoRingProvidedBufferRing::make_new(**pool, llfs::BufferCount{2}, /*group_id=*/7);
+
+        ASSERT_TRUE(ring.ok()) << BATT_INSPECT(ring.status());
+        EXPECT_EQ((*ring)->buffer_size(), kBufferSize);
+        EXPECT_EQ((*ring)->buffer_count(), 2u);
+        EXPECT_EQ((*pool)->available(), 2u);
+
+        const auto expect_block = [&](const llfs::StatusOr<IoRingProvidedBufferRing::Buffer>& buf,
+                                      usize block_i) {
+          ASSERT_TRUE(buf.ok()) << BATT_INSPECT(buf.status());
+          ASSERT_EQ(buf->size(), kBufferSize);
+          EXPECT_EQ(std::string((const char*)buf->data(), buf->size()),
+                    content.substr(block_i * kBufferSize, kBufferSize));
+        };
+
+        llfs::StatusOr<IoRingProvidedBufferRing::Buffer> buf0 =
+            (*ring)->read_some(file, /*offset=*/0);
+        ASSERT_NO_FATAL_FAILURE(expect_block(buf0, 0));
+
+        llfs::StatusOr<IoRingProvidedBufferRing::Buffer> buf1 =
+            (*ring)->read_some(file, /*offset=*/kBufferSize);
+        ASSERT_NO_FATAL_FAILURE(expect_block(buf1, 1));
+
+        EXPECT_NE(buf0->id(), buf1->id());
+        EXPECT_EQ((*ring)->in_use(), 2u);
+
+        // Both buffers are held, so the kernel has nowhere to put the data.
+        //
+        llfs::StatusOr<IoRingProvidedBufferRing::Buffer> buf2 =
+            (*ring)->read_some(file, /*offset=*/kBufferSize * 2);
+        EXPECT_EQ(buf2.status(), batt::status_from_errno(ENOBUFS));
+
+        // Releasing a buffer makes it available again.
+        //
+        const u16 released_id = buf0->id();
+        buf0->release();
+        EXPECT_EQ((*ring)->in_use(), 1u);
+
+        buf2 = (*ring)->read_some(file, /*offset=*/kBufferSize * 2);
+        ASSERT_NO_FATAL_FAILURE(expect_block(buf2, 2));
+        EXPECT_EQ(buf2->id(), released_id);
+
+        buf1 = llfs::StatusOr<IoRingProvidedBufferRing::Buffer>{batt::StatusCode::kUnknown};
+        buf2 = llfs::StatusOr<IoRingProvidedBufferRing::Buffer>{batt::StatusCode::kUnknown};
+        EXPECT_EQ((*ring)->in_use(), 0u);
+
+        ring->reset();
+        EXPECT_EQ((*pool)->available(), 4u);
+      },
+      "IoRingProvidedBufferRingTest.ReadSome"};
+
+  ctx.run();
+  task.join();
+
+  file.close().IgnoreError();
+}
+
+}  // namespace
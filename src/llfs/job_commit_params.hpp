@@ -43,6 +43,11 @@ struct JobCommitParams {
   //
   batt::Grant* recycle_grant = nullptr;
   i32 recycle_depth = -1;
+
+  // If true, pages found to be dead by this job are passed to the recycler as deferred drops (see
+  // PageRecycler::recycle_pages_deferred).  Only applies to external callers (recycle_depth == -1).
+  //
+  bool defer_recycling = false;
 };
 
 }  // namespace llfs
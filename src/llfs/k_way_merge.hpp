@@ -0,0 +1,326 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_K_WAY_MERGE_HPP
+#define LLFS_K_WAY_MERGE_HPP
+
+#include <llfs/int_types.hpp>
+#include <llfs/key.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/page_loader.hpp>
+#include <llfs/pinned_page.hpp>
+#include <llfs/seq.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/utility.hpp>
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace llfs {
+
+/** \brief A Seq that merges k sorted input Seqs into one sorted Seq, using a loser tree.
+ *
+ * Each step costs one comparison per level of the tree (ceil(log2(k))), against the loser stored
+ * at that level; unlike a binary heap, only the path from the winner's leaf to the root is
+ * touched.  All the memory the merge needs is allocated by the constructor.  Items that compare
+ * equal are returned in input order (the merge is stable).
+ *
+ * `Order` is a strict weak ordering of the input items (by default KeyOrder, which compares
+ * `get_key(item)`).  As with PackedBPTrieKeySeq, the item returned by `peek()` or `next()` is only
+ * guaranteed to stay valid until the next call to `peek()` or `next()` after a `next()`: the merge
+ * doesn't advance the input an item came from until it is asked for the following item.
+ */
+template <typename InputSeq, typename Order = KeyOrder>
+class KWayMergeSeq
+{
+ public:
+  using Item = SeqItem<InputSeq>;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  explicit KWayMergeSeq(std::vector<InputSeq>&& inputs, Order order = Order{}) noexcept
+      : inputs_{std::move(inputs)}
+      , order_{std::move(order)}
+      , heads_(this->inputs_.size())
+      , tree_(this->inputs_.size())
+  {
+    const usize k = this->inputs_.size();
+    if (k == 0) {
+      return;
+    }
+
+    for (usize i = 0; i < k; ++i) {
+      this->heads_[i] = this->inputs_[i].peek();
+    }
+
+    // Play the initial tournament bottom-up: the leaves (inputs) are nodes [k, 2k), node `n` has
+    // children `2n` and `2n + 1`; each internal node keeps the loser of its match and passes the
+    // winner up.
+    //
+    std::vector<usize> winners(2 * k);
+    for (usize i = 0; i < k; ++i) {
+      winners[k + i] = i;
+    }
+    for (usize node = k - 1; node > 0; --node) {
+      const usize left = winners[2 * node];
+      const usize right = winners[2 * node + 1];
+      if (this->beats(left, right)) {
+        winners[node] = left;
+        this->tree_[node] = right;
+      } else {
+        winners[node] = right;
+        this->tree_[node] = left;
+      }
+    }
+    this->tree_[0] = winners[1];
+  }
+
+  KWayMergeSeq(const KWayMergeSeq&) = delete;
+  KWayMergeSeq& operator=(const KWayMergeSeq&) = delete;
+
+  KWayMergeSeq(KWayMergeSeq&&) = default;
+  KWayMergeSeq& operator=(KWayMergeSeq&&) = default;
+
+  /** \brief The number of input Seqs.
+   */
+  usize input_count() const noexcept
+  {
+    return this->inputs_.size();
+  }
+
+  /** \brief The input Seqs (e.g., to check for errors once the merge is done).
+   */
+  const std::vector<InputSeq>& inputs() const noexcept
+  {
+    return this->inputs_;
+  }
+
+  Optional<Item> peek()
+  {
+    this->settle();
+    if (this->inputs_.empty()) {
+      return None;
+    }
+    return this->heads_[this->tree_[0]];
+  }
+
+  Optional<Item> next()
+  {
+    this->settle();
+    if (this->inputs_.empty()) {
+      return None;
+    }
+
+    const usize winner = this->tree_[0];
+    if (!this->heads_[winner]) {
+      return None;
+    }
+
+    Optional<Item> item = this->inputs_[winner].next();
+    this->advance_pending_ = true;
+
+    return item;
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  // Returns true iff the head of input `a` should be returned before the head of input `b`.
+  // Exhausted inputs lose to everything.
+  //
+  bool beats(usize a, usize b) const
+  {
+    if (!this->heads_[a]) {
+      return false;
+    }
+    if (!this->heads_[b]) {
+      return true;
+    }
+    if (this->order_(*this->heads_[a], *this->heads_[b])) {
+      return true;
+    }
+    return a < b && !this->order_(*this->heads_[b], *this->heads_[a]);
+  }
+
+  // Refreshes the head of the last winner (consumed by `next()`) and replays its path to the root.
+  //
+  void settle()
+  {
+    if (!this->advance_pending_) {
+      return;
+    }
+    this->advance_pending_ = false;
+
+    usize winner = this->tree_[0];
+    this->heads_[winner] = this->inputs_[winner].peek();
+
+    const usize k = this->inputs_.size();
+    for (usize node = (k + winner) / 2; node > 0; node /= 2) {
+      if (this->beats(this->tree_[node], winner)) {
+        std::swap(this->tree_[node], winner);
+      }
+    }
+    this->tree_[0] = winner;
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  std::vector<InputSeq> inputs_;
+
+  Order order_;
+
+  // The current head item of each input (None if exhausted).
+  //
+  std::vector<Optional<Item>> heads_;
+
+  // tree_[0] is the index of the input whose head is the overall winner; tree_[n] for n in [1, k)
+  // is the loser of the match at internal node n.
+  //
+  std::vector<usize> tree_;
+
+  // True if `next()` has consumed the winner's head, but the input hasn't been advanced yet.
+  //
+  bool advance_pending_ = false;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+
+/** \brief The default number of pages a PageRunSeq prefetches ahead of the page it is reading.
+ */
+constexpr usize kPageRunDefaultReadahead = 2;
+
+/** \brief A Seq of the items of a sorted run stored in a list of pages, in page order.
+ *
+ * `items_fn` is called with each page (once it is loaded) and must return a Seq of the items in
+ * that page; the page stays pinned while its items are being consumed.  Whenever a page is loaded,
+ * the next `readahead` pages of the run are passed to `PageLoader::prefetch_hint`, so the loads of
+ * the pages a merge will need next overlap with the merge of the current ones.
+ *
+ * If a page fails to load, the Seq ends early; check `status()` once it is exhausted.  Items are
+ * valid until the next call to `peek()` or `next()` after a `next()`.
+ */
+template <typename ItemsFn>
+class PageRunSeq
+{
+ public:
+  using ItemSeq = std::decay_t<std::invoke_result_t<ItemsFn&, const PinnedPage&>>;
+  using Item = SeqItem<ItemSeq>;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  explicit PageRunSeq(PageLoader& loader, std::vector<PageId>&& page_ids, ItemsFn&& items_fn,
+                      usize readahead = kPageRunDefaultReadahead) noexcept
+      : loader_{&loader}
+      , page_ids_{std::move(page_ids)}
+      , items_fn_{std::move(items_fn)}
+      , readahead_{readahead}
+  {
+  }
+
+  PageRunSeq(PageRunSeq&&) = default;
+  PageRunSeq& operator=(PageRunSeq&&) = default;
+
+  /** \brief Returns the error that ended the Seq early, or OkStatus().
+   */
+  const Status& status() const noexcept
+  {
+    return this->status_;
+  }
+
+  Optional<Item> peek()
+  {
+    if (!this->load_items()) {
+      return None;
+    }
+    return this->items_->peek();
+  }
+
+  Optional<Item> next()
+  {
+    if (!this->load_items()) {
+      return None;
+    }
+    return this->items_->next();
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  // Makes sure `items_` is a non-empty Seq for the current page, loading pages as needed.  Returns
+  // false if the run is exhausted (or a page failed to load).
+  //
+  bool load_items()
+  {
+    while (!this->items_ || !this->items_->peek()) {
+      this->items_ = None;
+      this->page_ = PinnedPage{};
+
+      if (this->next_page_i_ == this->page_ids_.size() || !this->status_.ok()) {
+        return false;
+      }
+
+      const usize readahead_end = std::min(this->page_ids_.size(),
+                                           this->next_page_i_ + 1 + this->readahead_);
+      for (; this->prefetched_end_ < readahead_end; ++this->prefetched_end_) {
+        if (this->prefetched_end_ > this->next_page_i_) {
+          this->loader_->prefetch_hint(this->page_ids_[this->prefetched_end_]);
+        }
+      }
+
+      StatusOr<PinnedPage> loaded =
+          this->loader_->get_page(this->page_ids_[this->next_page_i_], OkIfNotFound{false});
+      this->next_page_i_ += 1;
+
+      if (!loaded.ok()) {
+        this->status_ = loaded.status();
+        return false;
+      }
+
+      this->page_ = std::move(*loaded);
+      this->items_.emplace(this->items_fn_(this->page_));
+    }
+    return true;
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  PageLoader* loader_;
+  std::vector<PageId> page_ids_;
+  ItemsFn items_fn_;
+  usize readahead_;
+
+  // The index (in `page_ids_`) of the next page to load, and of the first page not yet prefetched.
+  //
+  usize next_page_i_ = 0;
+  usize prefetched_end_ = 0;
+
+  PinnedPage page_;
+  Optional<ItemSeq> items_;
+  Status status_;
+};
+
+/** \brief Returns a PageRunSeq of the items of the pages `page_ids`; see PageRunSeq.
+ */
+template <typename ItemsFn>
+inline PageRunSeq<std::decay_t<ItemsFn>> page_run_seq(PageLoader& loader,
+                                                     std::vector<PageId>&& page_ids,
+                                                     ItemsFn&& items_fn,
+                                                     usize readahead = kPageRunDefaultReadahead)
+{
+  return PageRunSeq<std::decay_t<ItemsFn>>{loader, std::move(page_ids),
+                                           std::decay_t<ItemsFn>{BATT_FORWARD(items_fn)},
+                                           readahead};
+}
+
+}  // namespace llfs
+
+#endif  // LLFS_K_WAY_MERGE_HPP
@@ -0,0 +1,200 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/k_way_merge.hpp>
+//
+#include <llfs/k_way_merge.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/memory_page_cache.hpp>
+#include <llfs/page_cache_job.hpp>
+#include <llfs/page_graph_node.hpp>
+
+#include <batteries/async/runtime.hpp>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. Merging random sorted runs of keys (0 to 9 runs, some empty, with duplicate keys within and
+//     across runs) returns all keys in order, with equal keys in input order; peek() always
+//     returns what the following next() returns.
+//  2. Merging runs stored in pages (PageRunSeq over PageGraphNodeView pages, using the refs of
+//     each page as its items) returns the items of all the runs in order, and a run with a page
+//     that can't be loaded ends early with an error status.
+
+using namespace llfs::int_types;
+
+using llfs::KWayMergeSeq;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST(KWayMergeTest, MergeSortedRuns)
+{
+  std::default_random_engine rng{1};
+
+  for (usize iteration = 0; iteration < 1000; ++iteration) {
+    const usize k = std::uniform_int_distribution<usize>{0, 9}(rng);
+
+    // Each key is a letter followed by the index of the run it came from, so we can check that
+    // equal keys (compared by their first byte only) come out in input order.
+    //
+    std::vector<std::vector<std::string>> runs(k);
+    std::vector<std::string> expected;
+
+    for (usize i = 0; i < k; ++i) {
+      const usize n = std::uniform_int_distribution<usize>{0, 8}(rng);
+      for (usize j = 0; j < n; ++j) {
+        const char letter = static_cast<char>('a' + std::uniform_int_distribution<int>{0, 5}(rng));
+        runs[i].emplace_back(std::string(1, letter) + std::to_string(i));
+      }
+      std::sort(runs[i].begin(), runs[i].end());
+      expected.insert(expected.end(), runs[i].begin(), runs[i].end());
+    }
+
+    const auto by_first_byte = [](const std::string_view& left, const std::string_view& right) {
+      return left.front() < right.front();
+    };
+
+    std::stable_sort(expected.begin(), expected.end(), by_first_byte);
+
+    std::vector<llfs::BoxedSeq<std::string_view>> inputs;
+    for (const std::vector<std::string>& run : runs) {
+      inputs.emplace_back(llfs::as_seq(run)  //
+                          | llfs::seq::map([](const std::string& s) -> std::string_view {
+                              return s;
+                            })  //
+                          | llfs::seq::boxed());
+    }
+
+    KWayMergeSeq<llfs::BoxedSeq<std::string_view>, decltype(by_first_byte)> merge{
+        std::move(inputs), by_first_byte};
+
+    EXPECT_EQ(merge.input_count(), k);
+
+    std::vector<std::string> actual;
+    for (;;) {
+      llfs::Optional<std::string_view> peeked = merge.peek();
+      llfs::Optional<std::string_view> item = merge.next();
+
+      ASSERT_EQ(peeked, item);
+      if (!item) {
+        break;
+      }
+      actual.emplace_back(*item);
+    }
+
+    EXPECT_THAT(actual, ::testing::ElementsAreArray(expected)) << BATT_INSPECT(iteration);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST(KWayMergeTest, MergePageRuns)
+{
+  llfs::StatusOr<batt::SharedPtr<llfs::PageCache>> page_cache =
+      llfs::make_memory_page_cache(batt::Runtime::instance().default_scheduler(),
+                                   /*arena_sizes=*/
+                                   {
+                                       {llfs::PageCount{16}, llfs::PageSize{512}},
+                                   },
+                                   llfs::MaxRefsPerPage{8});
+
+  ASSERT_TRUE(page_cache.ok()) << BATT_INSPECT(page_cache.status());
+  ASSERT_TRUE(llfs::PageGraphNodeView::register_layout(**page_cache).ok());
+
+  std::unique_ptr<llfs::PageCacheJob> job = (*page_cache)->new_job();
+
+  // Builds a page whose refs are the given (fake) page ids, and returns its id.
+  //
+  const auto build_page = [&](const std::vector<u64>& items) -> llfs::PageId {
+    llfs::StatusOr<llfs::PageGraphNodeBuilder> builder =
+        llfs::PageGraphNodeBuilder::from_new_page(job->new_page(
+            llfs::PageSize{512}, batt::WaitForResource::kFalse,
+            llfs::PageGraphNodeView::page_layout_id(), llfs::Caller::Unknown,
+            /*cancel_token=*/llfs::None));
+    BATT_CHECK_OK(builder);
+
+    for (u64 item : items) {
+      BATT_CHECK(builder->add_page(llfs::PageId{item}));
+    }
+
+    llfs::StatusOr<llfs::PinnedPage> pinned = std::move(*builder).build(*job);
+    BATT_CHECK_OK(pinned);
+
+    return pinned->page_id();
+  };
+
+  // Three runs of two pages each; the items of run i are the numbers congruent to i mod 3.
+  //
+  std::vector<std::vector<llfs::PageId>> runs(3);
+  for (u64 i = 0; i < 3; ++i) {
+    runs[i].emplace_back(build_page({i, i + 3, i + 6}));
+    runs[i].emplace_back(build_page({i + 9, i + 12}));
+  }
+
+  const auto page_items = [](const llfs::PinnedPage& page) {
+    return page->trace_refs();
+  };
+
+  const auto by_value = [](const llfs::PageId& left, const llfs::PageId& right) {
+    return left.int_value() < right.int_value();
+  };
+
+  using RunSeq = llfs::PageRunSeq<std::decay_t<decltype(page_items)>>;
+  {
+    std::vector<RunSeq> inputs;
+    for (std::vector<llfs::PageId>& run : runs) {
+      inputs.emplace_back(llfs::page_run_seq(*job, batt::make_copy(run), page_items));
+    }
+
+    KWayMergeSeq<RunSeq, decltype(by_value)> merge{std::move(inputs), by_value};
+
+    std::vector<u64> actual;
+    while (llfs::Optional<llfs::PageId> item = merge.next()) {
+      actual.emplace_back(item->int_value());
+    }
+
+    EXPECT_THAT(actual, ::testing::ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14));
+
+    for (const RunSeq& input : merge.inputs()) {
+      EXPECT_TRUE(input.status().ok()) << BATT_INSPECT(input.status());
+    }
+  }
+
+  // A run whose second page was never written returns the items of its first page, then stops
+  // with an error.
+  //
+  {
+    const llfs::PageId bogus_page_id =
+        job->cache().arena_for_page_id(runs[0][0]).device().page_ids().make_page_id(
+            /*physical_page=*/15, /*generation=*/7);
+
+    RunSeq run = llfs::page_run_seq(*job, std::vector<llfs::PageId>{runs[0][0], bogus_page_id},
+                                    page_items);
+
+    std::vector<u64> actual;
+    while (llfs::Optional<llfs::PageId> item = run.next()) {
+      actual.emplace_back(item->int_value());
+    }
+
+    EXPECT_THAT(actual, ::testing::ElementsAre(0, 3, 6));
+    EXPECT_FALSE(run.status().ok());
+  }
+}
+
+}  // namespace
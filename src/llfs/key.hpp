@@ -13,8 +13,11 @@
 #include <llfs/int_types.hpp>
 #include <llfs/interval.hpp>
 
+#include <boost/endian/conversion.hpp>
 #include <boost/functional/hash.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <string_view>
 #include <variant>
@@ -62,6 +65,51 @@ inline const KeyView& get_key(const KeyView& key)
   return key;
 }
 
+// Returns the first 8 bytes of `key` as a big-endian integer (zero-padded if the key is shorter).
+// Comparing the prefixes of two keys orders them the same way as comparing the keys themselves,
+// except when the prefixes are equal; then the keys must be compared by
+// `compare_keys_after_prefix`.
+//
+inline u64 key_prefix_u64(const std::string_view& key)
+{
+  u64 word = 0;
+  if (key.size() >= sizeof(u64)) {
+    std::memcpy(&word, key.data(), sizeof(u64));
+  } else if (!key.empty()) {
+    std::memcpy(&word, key.data(), key.size());
+  }
+  return boost::endian::big_to_native(word);
+}
+
+// Three-way compares two keys whose prefixes (see `key_prefix_u64`) are known to be equal.
+//
+inline int compare_keys_after_prefix(const std::string_view& left, const std::string_view& right)
+{
+  const usize common_size = std::min(left.size(), right.size());
+  if (common_size > sizeof(u64)) {
+    const int result = __builtin_memcmp(left.data() + sizeof(u64), right.data() + sizeof(u64),
+                                        common_size - sizeof(u64));
+    if (result != 0) {
+      return result;
+    }
+  }
+  return (left.size() < right.size()) ? -1 : ((left.size() == right.size()) ? 0 : 1);
+}
+
+// Three-way compares two keys: returns a negative value if `left` orders before `right`, zero if
+// they are equal, and a positive value otherwise.  Keys that differ within their first 8 bytes
+// (the common case in a search) are ordered by a single integer compare.
+//
+inline int compare_keys(const std::string_view& left, const std::string_view& right)
+{
+  const u64 left_prefix = key_prefix_u64(left);
+  const u64 right_prefix = key_prefix_u64(right);
+  if (left_prefix != right_prefix) {
+    return (left_prefix < right_prefix) ? -1 : 1;
+  }
+  return compare_keys_after_prefix(left, right);
+}
+
 struct KeyOrder {
   template <typename L, typename R>
   bool operator()(const L& left, const R& right) const
@@ -71,11 +119,7 @@ struct KeyOrder {
 
   bool operator()(const std::string_view& left, const std::string_view& right) const
   {
-    if (left.size() < right.size()) {
-      return __builtin_memcmp(left.data(), right.data(), left.size()) <= 0;
-    } else {
-      return __builtin_memcmp(left.data(), right.data(), right.size()) < 0;
-    }
+    return compare_keys(left, right) < 0;
   }
 };
 
@@ -132,6 +176,39 @@ struct KeyRangeOrder : KeyOrder {
   }
 };
 
+// Returns the first element in [first, last) (sorted by KeyOrder) whose key is not less than `key`,
+// like `std::lower_bound(first, last, key, KeyOrder{})`.  The prefix of `key` is computed once for
+// the whole search, so each probe usually costs one integer compare.
+//
+template <typename Iter>
+inline Iter key_lower_bound(Iter first, Iter last, const KeyView& key)
+{
+  const u64 key_prefix = key_prefix_u64(key);
+
+  return std::partition_point(first, last, [&key, key_prefix](const auto& item) {
+    const KeyView item_key = get_key(item);
+    const u64 item_prefix = key_prefix_u64(item_key);
+    if (item_prefix != key_prefix) {
+      return item_prefix < key_prefix;
+    }
+    return compare_keys_after_prefix(item_key, key) < 0;
+  });
+}
+
+// Writes `key_lower_bound(first, last, key)` to `out` for each key in `keys`, which must be sorted
+// by KeyOrder; each search starts where the previous one ended.
+//
+template <typename Iter, typename KeysRange, typename OutIter>
+inline OutIter batch_key_lower_bound(Iter first, Iter last, const KeysRange& keys, OutIter out)
+{
+  for (const auto& key : keys) {
+    first = key_lower_bound(first, last, get_key(key));
+    *out = first;
+    ++out;
+  }
+  return out;
+}
+
 }  // namespace llfs
 
 #endif  // LLFS_KEY_HPP
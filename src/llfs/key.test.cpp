@@ -0,0 +1,108 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/key.hpp>
+//
+#include <llfs/key.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <batteries/stream_util.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. compare_keys/KeyOrder agree with std::string_view::compare on random keys, including keys
+//     that are shorter than, equal to, and longer than the 8-byte prefix, and keys that differ only
+//     by trailing zero bytes.
+//  2. key_lower_bound/batch_key_lower_bound return the same positions as std::lower_bound.
+
+using namespace llfs::int_types;
+
+// Returns a random key of up to 19 bytes drawn from a small alphabet (so that long common
+// prefixes are likely), including zero and 0xff bytes.
+//
+std::string random_key(std::default_random_engine& rng)
+{
+  static const char kAlphabet[] = {'\0', 'a', '\xff'};
+
+  std::string key(std::uniform_int_distribution<usize>{0, 19}(rng), '\0');
+  for (char& ch : key) {
+    ch = kAlphabet[std::uniform_int_distribution<usize>{0, 2}(rng)];
+  }
+  return key;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST(KeyTest, CompareKeys)
+{
+  std::default_random_engine rng{1};
+
+  for (usize i = 0; i < 100000; ++i) {
+    const std::string left = random_key(rng);
+    const std::string right = random_key(rng);
+
+    const int expected = std::string_view{left}.compare(right);
+    const int actual = llfs::compare_keys(left, right);
+
+    EXPECT_EQ(expected < 0, actual < 0) << BATT_INSPECT_STR(left) << BATT_INSPECT_STR(right);
+    EXPECT_EQ(expected == 0, actual == 0) << BATT_INSPECT_STR(left) << BATT_INSPECT_STR(right);
+    EXPECT_EQ(expected < 0, llfs::KeyOrder{}(left, right));
+  }
+
+  EXPECT_LT(llfs::compare_keys(std::string_view{"a", 1}, std::string_view{"a\0", 2}), 0);
+  EXPECT_GT(llfs::compare_keys(std::string_view{"abcdefgh\0", 9}, "abcdefgh"), 0);
+  EXPECT_EQ(llfs::compare_keys("", ""), 0);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST(KeyTest, LowerBound)
+{
+  std::default_random_engine rng{2};
+
+  std::vector<std::string> sorted_keys;
+  for (usize i = 0; i < 1000; ++i) {
+    sorted_keys.emplace_back(random_key(rng));
+  }
+  std::sort(sorted_keys.begin(), sorted_keys.end(), llfs::KeyOrder{});
+
+  std::vector<std::string> queries;
+  for (usize i = 0; i < 500; ++i) {
+    queries.emplace_back(random_key(rng));
+  }
+  std::sort(queries.begin(), queries.end(), llfs::KeyOrder{});
+
+  for (const std::string& query : queries) {
+    EXPECT_EQ(llfs::key_lower_bound(sorted_keys.begin(), sorted_keys.end(), query),
+              std::lower_bound(sorted_keys.begin(), sorted_keys.end(), query, llfs::KeyOrder{}));
+  }
+
+  std::vector<std::vector<std::string>::const_iterator> results;
+  llfs::batch_key_lower_bound(sorted_keys.cbegin(), sorted_keys.cend(), queries,
+                              std::back_inserter(results));
+
+  ASSERT_EQ(results.size(), queries.size());
+  for (usize i = 0; i < queries.size(); ++i) {
+    EXPECT_EQ(results[i], std::lower_bound(sorted_keys.cbegin(), sorted_keys.cend(), queries[i],
+                                           llfs::KeyOrder{}))
+        << BATT_INSPECT(i);
+  }
+}
+
+}  // namespace
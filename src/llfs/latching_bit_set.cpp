@@ -82,6 +82,14 @@ usize LatchingBitSet::first_missing() const noexcept
     }
 
     const u64 value = this->data()[index].load();
+
+    // A concurrent insert may have filled this word in since we read the level above it; in that
+    // case, start over from the top.
+    //
+    if (value == ~u64{0}) {
+      return this->first_missing();
+    }
+
     i32 first_zero_bit = [&] {
       if (value == 0) {
         return 0;
@@ -142,6 +150,68 @@ bool LatchingBitSet::insert(usize i) noexcept
   return changed;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool LatchingBitSet::insert_range(usize begin, usize end) noexcept
+{
+  BATT_CHECK_LE(begin, end);
+  BATT_CHECK_LE(end, this->upper_bound());
+
+  if (begin == end) {
+    return false;
+  }
+
+  bool changed = false;
+
+  const usize first_word_i = begin / 64;
+  const usize last_word_i = (end - 1) / 64;
+
+  for (usize word_i = first_word_i; word_i <= last_word_i; ++word_i) {
+    const usize lo_bit = (word_i == first_word_i) ? (begin % 64) : 0;
+    const usize hi_bit = (word_i == last_word_i) ? ((end - 1) % 64 + 1) : 64;
+
+    const u64 hi_mask = (hi_bit == 64) ? ~u64{0} : ((u64{1} << hi_bit) - 1);
+    const u64 lo_mask = (u64{1} << lo_bit) - 1;
+    const u64 mask = hi_mask & ~lo_mask;
+
+    const u64 old_value = this->data()[word_i].fetch_or(mask);
+    const u64 new_value = old_value | mask;
+
+    if (old_value == new_value) {
+      continue;
+    }
+    changed = true;
+
+    if (new_value == ~u64{0}) {
+      this->set_summary_bits(/*depth=*/1, word_i);
+    }
+  }
+
+  return changed;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void LatchingBitSet::set_summary_bits(usize depth, usize word_i) noexcept
+{
+  usize i = word_i;
+
+  for (; depth < this->start_of_level_.size(); ++depth) {
+    const u64 mask = u64{1} << (i % 64);
+    i = i / 64;
+
+    const u64 old_value = this->data()[this->start_of_level_[depth] + i].fetch_or(mask);
+    const u64 new_value = old_value | mask;
+
+    // If the bit was already set, whoever set it is responsible for the levels above; if the word
+    // isn't full yet, there is nothing more to do.
+    //
+    if (old_value == new_value || new_value != ~u64{0}) {
+      break;
+    }
+  }
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 bool LatchingBitSet::is_full() const noexcept
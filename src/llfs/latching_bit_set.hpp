@@ -40,6 +40,9 @@ class LatchingBitSet
   usize upper_bound() const noexcept;
 
   /** \brief Returns the index of the first unset (0) bit.
+   *
+   * This walks down the summary levels, so it is O(log_64(upper_bound)).  If there are concurrent
+   * inserts, the returned value is the first missing value at some point during the call.
    */
   usize first_missing() const noexcept;
 
@@ -54,6 +57,18 @@ class LatchingBitSet
    */
   bool insert(usize i) noexcept;
 
+  /** \brief Inserts all integers in the half-open range [begin, end), returning true iff at least
+   * one of them was not previously contained by the set.
+   *
+   * Whole words are set with a single atomic operation, so this is much faster than calling
+   * insert for each integer in the range.  Other threads may observe the range as partially
+   * inserted while this call is in progress.
+   *
+   * \param begin MUST be less than or equal to `end`
+   * \param end MUST be less than or equal to this->upper_bound(), or we PANIC.
+   */
+  bool insert_range(usize begin, usize end) noexcept;
+
   /** \brief Returns true iff all integers from 0 to this->upper_bound() - 1 (inclusive) are present
    * in the set.
    */
@@ -65,6 +80,11 @@ class LatchingBitSet
    */
   std::atomic<u64>* data() const noexcept;
 
+  /** \brief Sets the summary bit for word `word_i` of level `depth - 1`, which has just become
+   * full, and then continues up the summary levels for as long as more words become full.
+   */
+  void set_summary_bits(usize depth, usize word_i) noexcept;
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   /** \brief The number of bits stored in this set.
@@ -13,6 +13,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <vector>
 
 namespace {
@@ -127,4 +128,65 @@ TEST(LatchingBitSetTest, MultiLevelTest)
   }
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(LatchingBitSetTest, InsertRange)
+{
+  for (usize n : std::vector<usize>{
+           40,            // one level, partial word
+           277,           // a prime number
+           64 * 64,       // two full levels
+           7777,          // three levels, not full
+           64 * 64 * 64,  // three exactly full levels
+       }) {
+    llfs::LatchingBitSet s{n};
+
+    EXPECT_FALSE(s.insert_range(0, 0));
+    EXPECT_FALSE(s.insert_range(n, n));
+    EXPECT_EQ(s.first_missing(), 0u);
+
+    // Insert the upper half of the set first, with unaligned endpoints; first_missing should not
+    // move.
+    //
+    const usize mid = n / 2 + 3;
+
+    EXPECT_TRUE(s.insert_range(mid, n));
+    EXPECT_FALSE(s.insert_range(mid, n));
+    EXPECT_EQ(s.first_missing(), 0u);
+    EXPECT_FALSE(s.is_full());
+    EXPECT_FALSE(s.contains(mid - 1));
+    EXPECT_TRUE(s.contains(mid));
+    EXPECT_TRUE(s.contains(n - 1));
+
+    // Fill the lower half in a few chunks of different sizes.
+    //
+    usize next = 0;
+    for (usize chunk = 1; next < mid; chunk = chunk * 3 + 1) {
+      const usize chunk_end = std::min(mid, next + chunk);
+
+      EXPECT_TRUE(s.insert_range(next, chunk_end));
+      next = chunk_end;
+
+      if (next < mid) {
+        EXPECT_EQ(s.first_missing(), next);
+        EXPECT_FALSE(s.is_full());
+      }
+    }
+
+    EXPECT_EQ(s.first_missing(), n);
+    EXPECT_TRUE(s.is_full());
+    EXPECT_FALSE(s.insert_range(0, n));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(LatchingBitSetTest, InsertRangeDeath)
+{
+  llfs::LatchingBitSet s{100};
+
+  EXPECT_DEATH(s.insert_range(0, 101), ".*[Aa]ssert.*fail.*end.*<=.*upper_bound.*");
+  EXPECT_DEATH(s.insert_range(10, 9), ".*[Aa]ssert.*fail.*begin.*<=.*end.*");
+}
+
 }  // namespace
@@ -0,0 +1,372 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/lazy_page_device.hpp>
+//
+
+#include <llfs/logging.hpp>
+
+#include <batteries/assert.hpp>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ PageArena LazyPageDevice::make_arena(const PageIdFactory& page_ids, PageSize page_size,
+                                                batt::TaskScheduler& scheduler,
+                                                std::string&& name, RecoverFn&& recover_fn)
+{
+  return PageArena{std::make_unique<LazyPageDevice>(page_ids, page_size, scheduler,
+                                                    std::move(name), std::move(recover_fn))};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ LazyPageDevice::LazyPageDevice(const PageIdFactory& page_ids, PageSize page_size,
+                                            batt::TaskScheduler& scheduler, std::string&& name,
+                                            RecoverFn&& recover_fn) noexcept
+    : page_ids_{page_ids}
+    , page_size_{page_size}
+    , scheduler_{scheduler}
+    , name_{std::move(name)}
+    , recover_fn_{std::move(recover_fn)}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+LazyPageDevice::~LazyPageDevice() noexcept
+{
+  std::unique_ptr<batt::Task> task;
+  {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+    task = std::move(this->recovery_task_);
+  }
+  if (task) {
+    task->join();
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void LazyPageDevice::start_recovery()
+{
+  {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+
+    if (this->recovery_started_) {
+      return;
+    }
+    this->recovery_started_ = true;
+
+    if (!this->closed_) {
+      this->start_recovery_task_locked();
+      return;
+    }
+  }
+
+  // Don't recover an arena that has already been closed; fail anything waiting for it instead.
+  //
+  this->recovery_status_ = Status{batt::StatusCode::kClosed};
+  this->recovered_.set_value(true);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void LazyPageDevice::start_recovery_task_locked()
+{
+  metrics().recovery_start_count.add(1);
+
+  this->recovery_task_ = std::make_unique<batt::Task>(
+      this->scheduler_.schedule_task(),
+      [this] {
+        this->recover();
+      },
+      batt::to_string(this->name_, ".LazyPageDevice.recover"));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void LazyPageDevice::recover()
+{
+  LLFS_VLOG(1) << "LazyPageDevice: recovering " << this->name_;
+
+  StatusOr<PageArena> arena = this->recover_fn_();
+
+  Status status = arena.status();
+  if (status.ok() &&
+      (arena->device().page_ids() != this->page_ids_ ||
+       arena->device().page_size() != this->page_size_)) {
+    LLFS_LOG_ERROR() << "LazyPageDevice: the recovered device doesn't match its config;"
+                     << BATT_INSPECT(this->name_) << BATT_INSPECT(arena->device().get_id())
+                     << BATT_INSPECT(arena->device().page_size())
+                     << BATT_INSPECT(this->page_size_);
+    status = batt::StatusCode::kDataLoss;
+  }
+
+  if (status.ok()) {
+    Optional<usize> buffer_count;
+    {
+      std::unique_lock<std::mutex> lock{this->mutex_};
+      buffer_count = this->registered_buffer_count_;
+    }
+
+    if (buffer_count) {
+      Status buffers_status = arena->device().enable_registered_page_buffers(*buffer_count);
+      if (!buffers_status.ok()) {
+        LLFS_LOG_WARNING() << "LazyPageDevice: failed to enable registered page buffers;"
+                           << BATT_INSPECT(this->name_) << BATT_INSPECT(buffers_status);
+      }
+    }
+
+    this->arena_.emplace(std::move(*arena));
+
+    // If the arena was closed while it was being recovered, it must still be halted.
+    //
+    bool close_now = false;
+    {
+      std::unique_lock<std::mutex> lock{this->mutex_};
+      this->arena_available_ = true;
+      close_now = this->closed_;
+    }
+    if (close_now) {
+      this->arena_->close();
+    }
+  }
+
+  this->recovery_status_ = status;
+  this->recovered_.set_value(true);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool LazyPageDevice::is_recovered() const
+{
+  return this->recovered_.is_ready();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageArena& LazyPageDevice::await_recovered()
+{
+  StatusOr<PageArena*> arena = this->try_await_recovered();
+  BATT_CHECK_OK(arena) << "Lazy PageArena recovery failed;" << BATT_INSPECT(this->name_);
+
+  return **arena;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<PageArena*> LazyPageDevice::try_await_recovered()
+{
+  this->start_recovery();
+
+  BATT_REQUIRE_OK(this->recovered_.await());
+  BATT_REQUIRE_OK(this->recovery_status_);
+
+  return &*this->arena_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void LazyPageDevice::close()
+{
+  bool close_now = false;
+  {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+    if (this->closed_) {
+      return;
+    }
+    this->closed_ = true;
+    close_now = this->arena_available_;
+  }
+
+  // Otherwise, if recovery is still in progress, `recover()` will see `closed_` and halt the arena
+  // itself.
+  //
+  if (close_now) {
+    this->arena_->close();
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void LazyPageDevice::join()
+{
+  {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+    if (!this->recovery_started_) {
+      return;
+    }
+  }
+
+  this->recovered_.await().IgnoreError();
+
+  if (this->arena_) {
+    this->arena_->join();
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageIdFactory LazyPageDevice::page_ids()
+{
+  return this->page_ids_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageSize LazyPageDevice::page_size()
+{
+  return this->page_size_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status LazyPageDevice::enable_registered_page_buffers(usize buffer_count)
+{
+  {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+    if (!this->recovery_started_) {
+      this->registered_buffer_count_ = buffer_count;
+      return OkStatus();
+    }
+  }
+
+  PageArena& arena = this->await_recovered();
+
+  return arena.device().enable_registered_page_buffers(buffer_count);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool LazyPageDevice::prefetch_hint(PageId id)
+{
+  if (!this->is_recovered()) {
+    this->start_recovery();
+    return true;
+  }
+
+  if (!this->arena_) {
+    return true;
+  }
+
+  return this->arena_->device().prefetch_hint(id);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::shared_ptr<PageBuffer>> LazyPageDevice::prepare(PageId page_id)
+{
+  this->start_recovery();
+
+  BATT_REQUIRE_OK(this->recovered_.await());
+  BATT_REQUIRE_OK(this->recovery_status_);
+
+  return this->arena_->device().prepare(page_id);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void LazyPageDevice::write(std::shared_ptr<const PageBuffer>&& page_buffer,
+                           WriteHandler&& handler)
+{
+  this->async_get_device([page_buffer = std::move(page_buffer), handler = std::move(handler)](
+                             StatusOr<PageDevice*> device) mutable {
+    if (!device.ok()) {
+      handler(device.status());
+      return;
+    }
+    (*device)->write(std::move(page_buffer), std::move(handler));
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void LazyPageDevice::read(PageId id, ReadHandler&& handler)
+{
+  this->async_get_device(
+      [id, handler = std::move(handler)](StatusOr<PageDevice*> device) mutable {
+        if (!device.ok()) {
+          handler(device.status());
+          return;
+        }
+        (*device)->read(id, std::move(handler));
+      });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void LazyPageDevice::read_batch(const batt::Slice<const PageId>& ids,
+                                std::vector<ReadHandler>&& handlers)
+{
+  BATT_CHECK_EQ(ids.size(), handlers.size());
+
+  this->async_get_device([ids = std::vector<PageId>(ids.begin(), ids.end()),
+                          handlers = std::move(handlers)](StatusOr<PageDevice*> device) mutable {
+    if (!device.ok()) {
+      for (ReadHandler& handler : handlers) {
+        handler(device.status());
+      }
+      return;
+    }
+    (*device)->read_batch(batt::as_slice(ids), std::move(handlers));
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void LazyPageDevice::read_tail(PageId id, usize byte_count, ReadTailHandler&& handler)
+{
+  this->async_get_device(
+      [id, byte_count, handler = std::move(handler)](StatusOr<PageDevice*> device) mutable {
+        if (!device.ok()) {
+          handler(device.status());
+          return;
+        }
+        (*device)->read_tail(id, byte_count, std::move(handler));
+      });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void LazyPageDevice::drop(PageId id, WriteHandler&& handler)
+{
+  this->async_get_device(
+      [id, handler = std::move(handler)](StatusOr<PageDevice*> device) mutable {
+        if (!device.ok()) {
+          handler(device.status());
+          return;
+        }
+        (*device)->drop(id, std::move(handler));
+      });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void LazyPageDevice::async_get_device(std::function<void(StatusOr<PageDevice*>)>&& fn)
+{
+  if (!this->is_recovered()) {
+    metrics().queued_io_count.add(1);
+    this->start_recovery();
+  }
+
+  this->recovered_.async_get([this, fn = std::move(fn)](StatusOr<bool> result) mutable {
+    if (!result.ok()) {
+      fn(result.status());
+      return;
+    }
+    if (!this->recovery_status_.ok()) {
+      fn(this->recovery_status_);
+      return;
+    }
+    fn(&this->arena_->device());
+  });
+}
+
+}  // namespace llfs
@@ -0,0 +1,189 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_LAZY_PAGE_DEVICE_HPP
+#define LLFS_LAZY_PAGE_DEVICE_HPP
+
+#include <llfs/int_types.hpp>
+#include <llfs/metrics.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/page_arena.hpp>
+#include <llfs/page_device.hpp>
+#include <llfs/page_id_factory.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/async/latch.hpp>
+#include <batteries/async/task.hpp>
+#include <batteries/async/task_scheduler.hpp>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Stands in for the PageDevice of a PageArena that hasn't been recovered yet, so that the
+ * arena can be registered with a PageCache without opening its device or replaying its allocator
+ * log.  See StorageContext::set_lazy_arena_recovery.
+ *
+ * The page ids and page size come from the arena's config, so asking for them doesn't trigger
+ * recovery.  The first read, write, or drop (or the first call to PageArena::allocator) starts
+ * recovering the real arena on a background task; I/O issued before recovery finishes is queued
+ * and then passed on to the real device.  If recovery fails, queued and later I/O fails with the
+ * recovery error, as does PageArena::try_allocator (PageArena::allocator panics).
+ */
+class LazyPageDevice : public PageDevice
+{
+ public:
+  using RecoverFn = std::function<StatusOr<PageArena>()>;
+
+  struct Metrics {
+    /** \brief The number of arenas whose recovery has been started.
+     */
+    CountMetric<u64> recovery_start_count{0};
+
+    /** \brief The number of I/O requests queued to wait for recovery to finish.
+     */
+    CountMetric<u64> queued_io_count{0};
+  };
+
+  static Metrics& metrics()
+  {
+    static Metrics m_;
+    return m_;
+  }
+
+  /** \brief Creates a PageArena that calls `recover_fn` (on a task created with `scheduler`) the
+   * first time it is used.  The recovered arena must have the given page ids and page size.
+   */
+  static PageArena make_arena(const PageIdFactory& page_ids, PageSize page_size,
+                              batt::TaskScheduler& scheduler, std::string&& name,
+                              RecoverFn&& recover_fn);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  explicit LazyPageDevice(const PageIdFactory& page_ids, PageSize page_size,
+                          batt::TaskScheduler& scheduler, std::string&& name,
+                          RecoverFn&& recover_fn) noexcept;
+
+  /** \brief Waits for recovery to finish, if it was started.
+   */
+  ~LazyPageDevice() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Starts recovering the arena in the background, if that hasn't been done already.
+   */
+  void start_recovery();
+
+  /** \brief Returns true iff recovery has finished (whether or not it succeeded).
+   */
+  bool is_recovered() const;
+
+  /** \brief Starts recovery if necessary, waits for it to finish, and returns the recovered arena.
+   * Panics if recovery failed.
+   */
+  PageArena& await_recovered();
+
+  /** \brief Like await_recovered, but returns the recovery error instead of panicking.
+   */
+  StatusOr<PageArena*> try_await_recovered();
+
+  /** \brief Halts the recovered arena; if recovery hasn't been started, it never will be.  If
+   * recovery is in progress, the arena is halted as soon as it finishes.
+   */
+  void close();
+
+  /** \brief Waits for recovery (if started) to finish, then joins the recovered arena.
+   */
+  void join();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  PageIdFactory page_ids() override;
+
+  PageSize page_size() override;
+
+  /** \brief Remembers `buffer_count` and passes it on to the real device once it is recovered.
+   */
+  Status enable_registered_page_buffers(usize buffer_count) override;
+
+  /** \brief If the arena isn't recovered yet, just starts recovery and returns true (so the
+   * PageCache doesn't queue a read behind it); otherwise passes the hint on to the real device.
+   */
+  bool prefetch_hint(PageId id) override;
+
+  /** \brief Blocks until the arena is recovered.
+   */
+  StatusOr<std::shared_ptr<PageBuffer>> prepare(PageId page_id) override;
+
+  void write(std::shared_ptr<const PageBuffer>&& page_buffer, WriteHandler&& handler) override;
+
+  void read(PageId id, ReadHandler&& handler) override;
+
+  void read_batch(const batt::Slice<const PageId>& ids,
+                  std::vector<ReadHandler>&& handlers) override;
+
+  void read_tail(PageId id, usize byte_count, ReadTailHandler&& handler) override;
+
+  void drop(PageId id, WriteHandler&& handler) override;
+
+ private:
+  /** \brief Calls `fn` with the recovered device (or the recovery error) once recovery is
+   * finished; starts recovery if necessary.
+   */
+  void async_get_device(std::function<void(StatusOr<PageDevice*>)>&& fn);
+
+  /** \brief Launches the recovery task; `mutex_` must be held.
+   */
+  void start_recovery_task_locked();
+
+  /** \brief The body of the recovery task.
+   */
+  void recover();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const PageIdFactory page_ids_;
+  const PageSize page_size_;
+  batt::TaskScheduler& scheduler_;
+  const std::string name_;
+  RecoverFn recover_fn_;
+
+  // Set (to true) once `recovery_status_` and `arena_` are final.
+  //
+  batt::Latch<bool> recovered_;
+
+  // Written by the recovery task before `recovered_` is set.
+  //
+  Status recovery_status_;
+  Optional<PageArena> arena_;
+
+  // Protects the fields below.
+  //
+  std::mutex mutex_;
+
+  std::unique_ptr<batt::Task> recovery_task_;
+  bool recovery_started_ = false;
+  bool closed_ = false;
+
+  // Set once `arena_` has been emplaced (by the recovery task).
+  //
+  bool arena_available_ = false;
+
+  // The buffer count passed to `enable_registered_page_buffers` before recovery started.
+  //
+  Optional<usize> registered_buffer_count_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_LAZY_PAGE_DEVICE_HPP
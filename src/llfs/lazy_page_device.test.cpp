@@ -0,0 +1,206 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/lazy_page_device.hpp>
+//
+#include <llfs/lazy_page_device.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/memory_page_arena.hpp>
+#include <llfs/page_buffer.hpp>
+#include <llfs/page_cache.hpp>
+#include <llfs/page_cache_options.hpp>
+
+#include <batteries/async/runtime.hpp>
+
+#include <boost/uuid/uuid_generators.hpp>
+
+#include <atomic>
+#include <cstring>
+#include <future>
+#include <vector>
+
+namespace {
+
+using namespace llfs::int_types;
+
+// Test Plan:
+//  1. Asking for the page ids/size doesn't recover the arena; the first read does (once), and
+//     writes/reads are then passed on to the recovered device; allocator() waits for recovery.
+//  2. If recovery fails, I/O fails with the recovery error, as does try_allocator.
+//  3. An arena closed before it is used is never recovered; I/O fails with kClosed.
+//  4. A recovered device that doesn't match the config is treated as a recovery failure.
+//  5. A PageCache whose only arena fails to recover fails page allocation, attach/detach and
+//     deallocation with (or in spite of) the recovery error, rather than panicking.
+
+constexpr llfs::page_device_id_int kDeviceId = 7;
+constexpr u64 kPageCount = 8;
+constexpr u32 kPageSize = 4096;
+
+class LazyPageDeviceTest : public ::testing::Test
+{
+ public:
+  llfs::PageArena make_arena(llfs::PageSize recovered_page_size = llfs::PageSize{kPageSize},
+                             llfs::Status recovery_status = llfs::OkStatus())
+  {
+    return llfs::LazyPageDevice::make_arena(
+        this->page_ids_, llfs::PageSize{kPageSize}, this->scheduler(), "LazyPageDeviceTest",
+        [this, recovered_page_size, recovery_status]() -> llfs::StatusOr<llfs::PageArena> {
+          this->recover_count_.fetch_add(1);
+          BATT_REQUIRE_OK(recovery_status);
+
+          return llfs::make_memory_page_arena(this->scheduler(), llfs::PageCount{kPageCount},
+                                              recovered_page_size, "LazyPageDeviceTest.arena",
+                                              kDeviceId);
+        });
+  }
+
+  batt::TaskScheduler& scheduler()
+  {
+    return batt::Runtime::instance().default_scheduler();
+  }
+
+  llfs::PageDevice::ReadResult read_page(llfs::PageDevice& device, llfs::PageId page_id)
+  {
+    std::promise<llfs::PageDevice::ReadResult> result;
+    device.read(page_id, [&result](llfs::PageDevice::ReadResult page) {
+      result.set_value(std::move(page));
+    });
+    return result.get_future().get();
+  }
+
+  const llfs::PageIdFactory page_ids_{llfs::PageCount{kPageCount}, kDeviceId};
+
+  std::atomic<int> recover_count_{0};
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(LazyPageDeviceTest, RecoverOnFirstUse)
+{
+  llfs::PageArena arena = this->make_arena();
+
+  EXPECT_EQ(arena.id(), kDeviceId);
+  EXPECT_EQ(arena.device().page_ids(), this->page_ids_);
+  EXPECT_EQ(arena.device().page_size(), llfs::PageSize{kPageSize});
+  EXPECT_TRUE(arena.device().enable_registered_page_buffers(4).ok());
+  EXPECT_FALSE(arena.is_recovered());
+  EXPECT_EQ(this->recover_count_.load(), 0);
+
+  // The first read recovers the arena; the page was never written, so the read itself fails.
+  //
+  const llfs::PageId page_id = this->page_ids_.make_page_id(3, 1);
+
+  llfs::PageDevice::ReadResult missing = this->read_page(arena.device(), page_id);
+  EXPECT_FALSE(missing.ok());
+  EXPECT_TRUE(arena.is_recovered());
+  EXPECT_EQ(this->recover_count_.load(), 1);
+
+  llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer = arena.device().prepare(page_id);
+  ASSERT_TRUE(buffer.ok()) << BATT_INSPECT(buffer.status());
+  std::memset((*buffer)->mutable_payload().data(), 0x5a, (*buffer)->mutable_payload().size());
+
+  std::promise<llfs::Status> write_result;
+  arena.device().write(std::move(*buffer), [&write_result](llfs::Status status) {
+    write_result.set_value(status);
+  });
+  ASSERT_TRUE(write_result.get_future().get().ok());
+
+  llfs::PageDevice::ReadResult page = this->read_page(arena.device(), page_id);
+  ASSERT_TRUE(page.ok()) << BATT_INSPECT(page.status());
+  EXPECT_EQ(static_cast<const u8*>((*page)->const_payload().data())[0], 0x5a);
+
+  EXPECT_EQ(arena.allocator().get_device_id(), kDeviceId);
+  EXPECT_EQ(this->recover_count_.load(), 1);
+
+  arena.close();
+  arena.join();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(LazyPageDeviceTest, RecoveryFails)
+{
+  llfs::PageArena arena =
+      this->make_arena(llfs::PageSize{kPageSize}, llfs::Status{batt::StatusCode::kDataLoss});
+
+  EXPECT_EQ(this->read_page(arena.device(), this->page_ids_.make_page_id(0, 1)).status(),
+            batt::StatusCode::kDataLoss);
+
+  EXPECT_EQ(arena.device().prepare(this->page_ids_.make_page_id(0, 1)).status(),
+            batt::StatusCode::kDataLoss);
+
+  EXPECT_TRUE(arena.is_recovered());
+  EXPECT_EQ(arena.try_allocator().status(), batt::StatusCode::kDataLoss);
+  EXPECT_EQ(this->recover_count_.load(), 1);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(LazyPageDeviceTest, ClosedBeforeUse)
+{
+  llfs::PageArena arena = this->make_arena();
+
+  arena.close();
+
+  EXPECT_EQ(this->read_page(arena.device(), this->page_ids_.make_page_id(0, 1)).status(),
+            batt::StatusCode::kClosed);
+  EXPECT_EQ(this->recover_count_.load(), 0);
+
+  arena.join();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(LazyPageDeviceTest, MismatchedDevice)
+{
+  llfs::PageArena arena = this->make_arena(llfs::PageSize{kPageSize * 2});
+
+  EXPECT_EQ(this->read_page(arena.device(), this->page_ids_.make_page_id(0, 1)).status(),
+            batt::StatusCode::kDataLoss);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(LazyPageDeviceTest, PageCacheRecoveryFails)
+{
+  std::vector<llfs::PageArena> arenas;
+  arenas.emplace_back(
+      this->make_arena(llfs::PageSize{kPageSize}, llfs::Status{batt::StatusCode::kDataLoss}));
+
+  llfs::PageCacheOptions options = llfs::PageCacheOptions::with_default_values();
+  options.set_max_cached_pages_per_size(llfs::PageSize{kPageSize}, kPageCount);
+
+  llfs::StatusOr<batt::SharedPtr<llfs::PageCache>> cache =
+      llfs::PageCache::make_shared(std::move(arenas), options);
+  ASSERT_TRUE(cache.ok()) << BATT_INSPECT(cache.status());
+
+  EXPECT_EQ(this->recover_count_.load(), 0);
+
+  llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> page = (*cache)->allocate_page_of_size(
+      llfs::PageSize{kPageSize}, batt::WaitForResource::kFalse, /*callers=*/0, /*job_id=*/0);
+
+  EXPECT_EQ(page.status(), batt::StatusCode::kDataLoss);
+  EXPECT_EQ(this->recover_count_.load(), 1);
+
+  const boost::uuids::uuid user_id = boost::uuids::random_generator{}();
+
+  EXPECT_EQ((*cache)->attach(user_id, /*slot_offset=*/0), batt::StatusCode::kDataLoss);
+  EXPECT_EQ((*cache)->detach(user_id, /*slot_offset=*/0), batt::StatusCode::kDataLoss);
+
+  // Deallocation can't report an error, but it mustn't panic either.
+  //
+  (*cache)->deallocate_page(this->page_ids_.make_page_id(0, 1), /*callers=*/0, /*job_id=*/0);
+
+  (*cache)->close();
+  (*cache)->join();
+}
+
+}  // namespace
@@ -0,0 +1,43 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/log_append_metrics.hpp>
+//
+
+#include <batteries/env.hpp>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ LogAppendMetrics& LogAppendMetrics::instance()
+{
+  // Intentionally leaked, so the metrics outlive any static objects that might use them.
+  //
+  static LogAppendMetrics* instance_ = new LogAppendMetrics;
+  return *instance_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+LogAppendMetrics::LogAppendMetrics() noexcept
+    : sampler{batt::getenv_as<u32>("LLFS_LOG_APPEND_METRICS_SAMPLE_RATE")
+                  .value_or(LogAppendMetrics::kDefaultSampleRate)}
+{
+#define ADD_METRIC_(n) this->n.add_to_registry(global_metric_registry(), "LogAppend_" #n)
+
+  ADD_METRIC_(reserve_wait_latency);
+  ADD_METRIC_(prepare_latency);
+  ADD_METRIC_(commit_latency);
+  ADD_METRIC_(flush_wait_latency);
+  ADD_METRIC_(device_write_latency);
+
+#undef ADD_METRIC_
+}
+
+}  // namespace llfs
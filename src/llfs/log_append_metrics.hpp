@@ -0,0 +1,72 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_LOG_APPEND_METRICS_HPP
+#define LLFS_LOG_APPEND_METRICS_HPP
+
+#include <llfs/int_types.hpp>
+#include <llfs/metrics.hpp>
+
+namespace llfs {
+
+/** \brief Process-wide latency histograms for each stage of appending a slot to a log, from
+ * SlotWriter down to the device.
+ *
+ * All stages are sampled (see LatencySampler) at the rate given by the environment variable
+ * LLFS_LOG_APPEND_METRICS_SAMPLE_RATE (default: 64; 0 disables collection).  The histograms are
+ * added to the global metric registry with the prefix "LogAppend_".
+ */
+class LogAppendMetrics
+{
+ public:
+  static constexpr u32 kDefaultSampleRate = 64;
+
+  /** \brief Returns the global instance.
+   */
+  static LogAppendMetrics& instance();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  LogAppendMetrics(const LogAppendMetrics&) = delete;
+  LogAppendMetrics& operator=(const LogAppendMetrics&) = delete;
+
+  /** \brief Decides which appends (and device writes) are timed.
+   */
+  LatencySampler sampler;
+
+  /** \brief Time spent in SlotWriter::reserve waiting for a Grant.
+   */
+  LatencyHistogram reserve_wait_latency;
+
+  /** \brief Time from the start of SlotWriter::prepare (including waiting for the log writer) to
+   * the commit of the slot, i.e. the time spent packing the slot.
+   */
+  LatencyHistogram prepare_latency;
+
+  /** \brief Time spent in LogDevice::Writer::commit.
+   */
+  LatencyHistogram commit_latency;
+
+  /** \brief Time spent in SlotWriter::sync waiting for the flush pos to reach the requested offset.
+   */
+  LatencyHistogram flush_wait_latency;
+
+  /** \brief Time from the submission to the completion of each write issued by
+   * BasicIoRingLogFlushOp.
+   */
+  LatencyHistogram device_write_latency;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  LogAppendMetrics() noexcept;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_LOG_APPEND_METRICS_HPP
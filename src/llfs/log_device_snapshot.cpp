@@ -11,8 +11,84 @@
 
 #include <boost/functional/hash.hpp>
 
+#include <algorithm>
+#include <cstring>
+
 namespace llfs {
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+const std::vector<LogDeviceSnapshot::Chunk>& LogDeviceSnapshot::chunks() const
+{
+  static const std::vector<Chunk> empty;
+
+  if (!this->chunks_) {
+    return empty;
+  }
+  return *this->chunks_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void LogDeviceSnapshot::copy_to(void* dst) const
+{
+  u8* next = static_cast<u8*>(dst);
+  for (const Chunk& chunk : this->chunks()) {
+    std::memcpy(next, chunk.data, chunk.size);
+    next += chunk.size;
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+slot_offset_type LogDeviceSnapshot::share_chunks(const LogDeviceSnapshot& base,
+                                                 std::vector<Chunk>* chunks) const
+{
+  if (!base || base.history_id_ != this->history_id_ ||
+      slot_less_than(this->trim_pos_, base.trim_pos_)) {
+    return this->trim_pos_;
+  }
+
+  const slot_offset_type shared_end = slot_min(base.commit_pos_, this->commit_pos_);
+  slot_offset_type next = this->trim_pos_;
+
+  for (const Chunk& chunk : base.chunks()) {
+    const slot_offset_type begin = slot_max(chunk.offset, next);
+    const slot_offset_type end = slot_min(chunk.offset + chunk.size, shared_end);
+
+    if (!slot_less_than(begin, end)) {
+      continue;
+    }
+    BATT_CHECK_EQ(begin, next);
+
+    chunks->emplace_back(Chunk{
+        .offset = begin,
+        .storage = chunk.storage,
+        .data = chunk.data + slot_distance(chunk.offset, begin),
+        .size = slot_distance(begin, end),
+    });
+
+    next = end;
+  }
+
+  return next;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void LogDeviceSnapshot::merge_chunks()
+{
+  std::shared_ptr<u8[]> storage{new u8[this->size()]};
+  this->copy_to(storage.get());
+
+  this->chunks_ = std::make_shared<std::vector<Chunk>>(std::vector<Chunk>{Chunk{
+      .offset = this->trim_pos_,
+      .storage = storage,
+      .data = storage.get(),
+      .size = this->size(),
+  }});
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 usize LogDeviceSnapshot::compute_hash_value() const
@@ -22,7 +98,14 @@ usize LogDeviceSnapshot::compute_hash_value() const
   boost::hash_combine(seed, this->trim_pos());
   boost::hash_combine(seed, this->flush_pos());
   boost::hash_combine(seed, this->commit_pos());
-  boost::hash_range(seed, this->begin(), this->end());
+
+  // Hash byte-by-byte so the result doesn't depend on how the bytes are divided into chunks.
+  //
+  for (const Chunk& chunk : this->chunks()) {
+    for (const u8* byte = chunk.data; byte != chunk.data + chunk.size; ++byte) {
+      boost::hash_combine(seed, *byte);
+    }
+  }
 
   return seed;
 }
@@ -31,12 +114,46 @@ usize LogDeviceSnapshot::compute_hash_value() const
 //
 bool operator==(const LogDeviceSnapshot& l, const LogDeviceSnapshot& r)
 {
-  return l.trim_pos() == r.trim_pos()         //
-         && l.flush_pos() == r.flush_pos()    //
-         && l.commit_pos() == r.commit_pos()  //
-         && (l.bytes() == r.bytes()           //
-             || (l.size() == r.size() &&      //
-                 (0 == std::memcmp(l.bytes(), r.bytes(), l.size()))));
+  if (l.trim_pos() != r.trim_pos() || l.flush_pos() != r.flush_pos() ||
+      l.commit_pos() != r.commit_pos() || l.size() != r.size()) {
+    return false;
+  }
+
+  // Compare the bytes, walking both chunk sequences in step.
+  //
+  auto l_chunk = l.chunks().begin();
+  auto r_chunk = r.chunks().begin();
+  usize l_pos = 0;
+  usize r_pos = 0;
+  usize remaining = l.size();
+
+  while (remaining != 0) {
+    BATT_CHECK(l_chunk != l.chunks().end());
+    BATT_CHECK(r_chunk != r.chunks().end());
+
+    const usize n = std::min(l_chunk->size - l_pos, r_chunk->size - r_pos);
+    const u8* l_data = l_chunk->data + l_pos;
+    const u8* r_data = r_chunk->data + r_pos;
+
+    if (l_data != r_data && 0 != std::memcmp(l_data, r_data, n)) {
+      return false;
+    }
+
+    l_pos += n;
+    r_pos += n;
+    remaining -= n;
+
+    if (l_pos == l_chunk->size) {
+      ++l_chunk;
+      l_pos = 0;
+    }
+    if (r_pos == r_chunk->size) {
+      ++r_chunk;
+      r_pos = 0;
+    }
+  }
+
+  return true;
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
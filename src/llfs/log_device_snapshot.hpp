@@ -18,6 +18,7 @@
 #include <boost/operators.hpp>
 
 #include <memory>
+#include <vector>
 
 namespace llfs {
 
@@ -26,17 +27,57 @@ class LogDeviceSnapshot;
 usize hash_value(const LogDeviceSnapshot& s);
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
-//
+/** \brief A copy of the position variables and the active region of a ring buffer log device.
+ *
+ * The bytes are held as a sequence of immutable, reference-counted chunks.  Committed log bytes
+ * never change (until they are trimmed), so a snapshot taken with a `base` snapshot of the same
+ * log shares the chunks of `base` that are still inside the active region, and only copies the
+ * bytes committed since `base` was taken.  Copying a LogDeviceSnapshot never copies bytes.
+ */
 class LogDeviceSnapshot : public boost::equality_comparable<LogDeviceSnapshot>
 {
  public:
   friend usize hash_value(const LogDeviceSnapshot& s);
 
+  /** \brief A contiguous range of the snapshot's bytes, starting at slot offset `offset`.
+   */
+  struct Chunk {
+    slot_offset_type offset;
+
+    // Keeps `data` alive; may be shared with other snapshots.
+    //
+    std::shared_ptr<const u8[]> storage;
+
+    const u8* data;
+    usize size;
+
+    ConstBuffer as_buffer() const
+    {
+      return ConstBuffer{this->data, this->size};
+    }
+  };
+
+  /** \brief Once a snapshot has more chunks than this, they are merged into one.
+   */
+  static constexpr usize kMaxChunks = 16;
+
   template <typename Impl>
   static LogDeviceSnapshot from_device(BasicRingBufferLogDevice<Impl>& device, LogReadMode mode)
+  {
+    return from_device(device, mode, /*base=*/nullptr);
+  }
+
+  /** \brief Takes a snapshot of `device`, sharing bytes with `base` where possible (see class
+   * comment).  If `base` was not taken from the same log history (see
+   * LogStorageDriverContext::history_id_), this is the same as `from_device(device, mode)`.
+   */
+  template <typename Impl>
+  static LogDeviceSnapshot from_device(BasicRingBufferLogDevice<Impl>& device, LogReadMode mode,
+                                       const LogDeviceSnapshot* base)
   {
     LogDeviceSnapshot snapshot;
 
+    snapshot.history_id_ = device.history_id_.load();
     snapshot.trim_pos_ = device.driver().get_trim_pos();
     snapshot.flush_pos_ = device.driver().get_flush_pos();
     snapshot.commit_pos_ = [&] {
@@ -46,12 +87,31 @@ class LogDeviceSnapshot : public boost::equality_comparable<LogDeviceSnapshot>
       return device.driver().get_commit_pos();
     }();
 
-    ConstBuffer src = batt::resize_buffer(device.buffer_.get(snapshot.trim_pos_),
-                                          slot_distance(snapshot.trim_pos_, snapshot.commit_pos_));
+    auto chunks = std::make_shared<std::vector<Chunk>>();
+
+    const slot_offset_type copy_begin =
+        (base != nullptr) ? snapshot.share_chunks(*base, chunks.get()) : snapshot.trim_pos_;
+
+    ConstBuffer src = batt::resize_buffer(device.buffer_.get(copy_begin),
+                                          slot_distance(copy_begin, snapshot.commit_pos_));
+
+    if (src.size() != 0) {
+      std::shared_ptr<u8[]> storage{new u8[src.size()]};
+      std::memcpy(storage.get(), src.data(), src.size());
 
-    snapshot.byte_storage_.reset(new u8[src.size()]);
+      chunks->emplace_back(Chunk{
+          .offset = copy_begin,
+          .storage = storage,
+          .data = storage.get(),
+          .size = src.size(),
+      });
+    }
 
-    std::memcpy(snapshot.byte_storage_.get(), src.data(), src.size());
+    snapshot.chunks_ = std::move(chunks);
+
+    if (snapshot.chunks_->size() > kMaxChunks) {
+      snapshot.merge_chunks();
+    }
 
     snapshot.hash_value_ = snapshot.compute_hash_value();
 
@@ -90,38 +150,37 @@ class LogDeviceSnapshot : public boost::equality_comparable<LogDeviceSnapshot>
     return slot_distance(this->trim_pos(), this->commit_pos());
   }
 
-  const u8* bytes() const
-  {
-    return this->byte_storage_.get();
-  }
+  /** \brief The bytes of the snapshot (from trim_pos to commit_pos), in order.
+   */
+  const std::vector<Chunk>& chunks() const;
 
-  const u8* begin() const
-  {
-    return this->bytes();
-  }
-
-  const u8* end() const
-  {
-    return this->bytes() + this->size();
-  }
-
-  ConstBuffer as_buffer() const
-  {
-    return ConstBuffer{this->bytes(), this->size()};
-  }
+  /** \brief Copies the bytes of the snapshot to `dst`, which must be at least `this->size()` bytes.
+   */
+  void copy_to(void* dst) const;
 
   explicit operator bool() const noexcept
   {
-    return this->byte_storage_ != nullptr;
+    return this->chunks_ != nullptr;
   }
 
  private:
   usize compute_hash_value() const;
 
+  /** \brief Appends the parts of `base`'s chunks that are inside [this->trim_pos_,
+   * this->commit_pos_) to `chunks`, if `base` has the same history as `this`.  Returns the offset
+   * of the first byte not covered by the shared chunks.
+   */
+  slot_offset_type share_chunks(const LogDeviceSnapshot& base, std::vector<Chunk>* chunks) const;
+
+  /** \brief Replaces `this->chunks_` with a single chunk containing all bytes.
+   */
+  void merge_chunks();
+
+  u64 history_id_ = 0;
   slot_offset_type trim_pos_ = 0;
   slot_offset_type flush_pos_ = 0;
   slot_offset_type commit_pos_ = 0;
-  std::shared_ptr<u8[]> byte_storage_{nullptr};
+  std::shared_ptr<const std::vector<Chunk>> chunks_{nullptr};
   usize hash_value_ = this->compute_hash_value();
 };
 
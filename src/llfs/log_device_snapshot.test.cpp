@@ -0,0 +1,149 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/log_device_snapshot.hpp>
+//
+#include <llfs/log_device_snapshot.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/memory_log_device.hpp>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. A snapshot taken with a base shares the base's bytes that are still in the active region and
+//     is equal (and hashes equal) to a full snapshot; sharing stops once the base is trimmed away.
+//  2. After MemoryLogDevice::restore_snapshot, older snapshots are not used as a base.
+//  3. Many incremental snapshots don't accumulate more than kMaxChunks chunks.
+
+using namespace llfs::int_types;
+
+using llfs::LogDeviceSnapshot;
+using llfs::LogReadMode;
+
+constexpr usize kLogSize = 4096;
+
+// Appends `n` bytes of value `b` to `log`.
+//
+void append(llfs::MemoryLogDevice& log, usize n, u8 b)
+{
+  llfs::LogDevice::Writer& writer = log.writer();
+
+  llfs::StatusOr<llfs::MutableBuffer> buffer = writer.prepare(n);
+  BATT_CHECK_OK(buffer);
+
+  std::memset(buffer->data(), b, n);
+
+  BATT_CHECK_OK(writer.commit(n));
+}
+
+// Returns the bytes of `snapshot`, concatenated.
+//
+std::vector<u8> bytes_of(const LogDeviceSnapshot& snapshot)
+{
+  std::vector<u8> bytes(snapshot.size());
+  snapshot.copy_to(bytes.data());
+  return bytes;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST(LogDeviceSnapshotTest, ShareWithBase)
+{
+  llfs::MemoryLogDevice log{kLogSize};
+
+  append(log, 100, 'a');
+
+  const LogDeviceSnapshot base = LogDeviceSnapshot::from_device(log, LogReadMode::kDurable);
+
+  ASSERT_TRUE(base);
+  ASSERT_EQ(base.chunks().size(), 1u);
+
+  append(log, 50, 'b');
+  ASSERT_TRUE(log.trim(20).ok());
+
+  const LogDeviceSnapshot full = LogDeviceSnapshot::from_device(log, LogReadMode::kDurable);
+  const LogDeviceSnapshot incremental =
+      LogDeviceSnapshot::from_device(log, LogReadMode::kDurable, &base);
+
+  EXPECT_EQ(full.trim_pos(), 20u);
+  EXPECT_EQ(full.commit_pos(), 150u);
+  EXPECT_EQ(full, incremental);
+  EXPECT_EQ(hash_value(full), hash_value(incremental));
+  EXPECT_EQ(bytes_of(full), bytes_of(incremental));
+
+  ASSERT_EQ(incremental.chunks().size(), 2u);
+  EXPECT_EQ(incremental.chunks()[0].offset, 20u);
+  EXPECT_EQ(incremental.chunks()[0].size, 80u);
+  EXPECT_EQ(incremental.chunks()[0].data, base.chunks()[0].data + 20);
+  EXPECT_EQ(incremental.chunks()[1].offset, 100u);
+  EXPECT_EQ(incremental.chunks()[1].size, 50u);
+
+  // Once the base is entirely trimmed, nothing is shared.
+  //
+  ASSERT_TRUE(log.trim(120).ok());
+
+  const LogDeviceSnapshot after_trim =
+      LogDeviceSnapshot::from_device(log, LogReadMode::kDurable, &base);
+
+  ASSERT_EQ(after_trim.chunks().size(), 1u);
+  EXPECT_EQ(after_trim.chunks()[0].offset, 120u);
+  EXPECT_EQ(after_trim, LogDeviceSnapshot::from_device(log, LogReadMode::kDurable));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST(LogDeviceSnapshotTest, RestoreChangesHistory)
+{
+  llfs::MemoryLogDevice log{kLogSize};
+
+  append(log, 100, 'a');
+  const LogDeviceSnapshot first = LogDeviceSnapshot::from_device(log, LogReadMode::kDurable);
+
+  append(log, 100, 'b');
+  const LogDeviceSnapshot second = LogDeviceSnapshot::from_device(log, LogReadMode::kDurable);
+
+  // Go back to `first` and write different bytes at the same offsets as `second`.
+  //
+  log.restore_snapshot(first, LogReadMode::kDurable);
+  append(log, 100, 'c');
+
+  const LogDeviceSnapshot third =
+      LogDeviceSnapshot::from_device(log, LogReadMode::kDurable, &second);
+
+  EXPECT_EQ(third.chunks().size(), 1u);
+  EXPECT_NE(third, second);
+  EXPECT_EQ(bytes_of(third)[150], 'c');
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 3.
+//
+TEST(LogDeviceSnapshotTest, MergeChunks)
+{
+  llfs::MemoryLogDevice log{kLogSize};
+
+  LogDeviceSnapshot snapshot = LogDeviceSnapshot::from_device(log, LogReadMode::kDurable);
+
+  for (usize i = 0; i < LogDeviceSnapshot::kMaxChunks * 3; ++i) {
+    append(log, 10, static_cast<u8>('a' + i % 26));
+    snapshot = LogDeviceSnapshot::from_device(log, LogReadMode::kDurable, &snapshot);
+
+    ASSERT_LE(snapshot.chunks().size(), LogDeviceSnapshot::kMaxChunks);
+    ASSERT_EQ(snapshot, LogDeviceSnapshot::from_device(log, LogReadMode::kDurable));
+  }
+}
+
+}  // namespace
@@ -10,6 +10,7 @@
 #ifndef LLFS_LOG_STORAGE_DRIVER_CONTEXT_HPP
 #define LLFS_LOG_STORAGE_DRIVER_CONTEXT_HPP
 
+#include <llfs/int_types.hpp>
 #include <llfs/ring_buffer.hpp>
 
 #include <atomic>
@@ -17,12 +18,27 @@
 namespace llfs {
 
 struct LogStorageDriverContext {
+  /** \brief Returns a new, process-wide unique value for `history_id_`.
+   */
+  static u64 next_history_id() noexcept
+  {
+    static std::atomic<u64> next_id{1};
+    return next_id.fetch_add(1);
+  }
+
   explicit LogStorageDriverContext(const RingBuffer::Params& params) noexcept : buffer_{params}
   {
   }
 
   std::atomic<bool> closed_{false};
   RingBuffer buffer_;
+
+  // Identifies the contents of the log: committed bytes at a given slot offset never change while
+  // this value stays the same.  Anything that may rewrite committed bytes (e.g.
+  // MemoryLogDevice::restore_snapshot) must assign a new value.  Lets LogDeviceSnapshot share
+  // bytes between snapshots of the same log.
+  //
+  std::atomic<u64> history_id_{next_history_id()};
 };
 
 }  // namespace llfs
@@ -9,20 +9,57 @@
 #include <llfs/lru_clock.hpp>
 //
 
+#include <llfs/logging.hpp>
+
+#include <batteries/env.hpp>
+
+#include <algorithm>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define LLFS_LRU_CLOCK_X86 1
+#endif
+
 namespace llfs {
 
+namespace {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+LRUClock::Source choose_lru_clock_source()
+{
+  if (batt::getenv_as<int>("LLFS_LRU_CLOCK_TSC").value_or(0) == 0) {
+    return LRUClock::Source::kCounter;
+  }
+  if (!LRUClock::is_tsc_available()) {
+    LLFS_LOG_WARNING() << "LLFS_LRU_CLOCK_TSC is set, but this CPU has no invariant TSC; using the "
+                          "counter-based LRUClock";
+    return LRUClock::Source::kCounter;
+  }
+  return LRUClock::Source::kTsc;
+}
+
+}  // namespace
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 LRUClock::LocalCounter::LocalCounter() noexcept : value{0}
 {
-  LRUClock::instance().add_local_counter(*this);
+  // Timestamp counter based clocks don't need to be synchronized, so there is no need to register.
+  //
+  if (LRUClock::source() == LRUClock::Source::kCounter) {
+    LRUClock::instance().add_local_counter(*this);
+  }
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 LRUClock::LocalCounter::~LocalCounter() noexcept
 {
-  LRUClock::instance().remove_local_counter(*this);
+  if (this->LocalCounterHook::is_linked()) {
+    LRUClock::instance().remove_local_counter(*this);
+  }
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -49,6 +86,10 @@ LRUClock::LocalCounter::~LocalCounter() noexcept
 //
 /*static*/ i64 LRUClock::read_local() noexcept
 {
+  if (Self::source() == Source::kTsc) {
+    return std::max(Self::thread_local_counter().value.load(std::memory_order_relaxed),
+                    Self::read_tsc_ticks());
+  }
   return Self::thread_local_counter().value.load();
 }
 
@@ -56,6 +97,15 @@ LRUClock::LocalCounter::~LocalCounter() noexcept
 //
 /*static*/ i64 LRUClock::advance_local() noexcept
 {
+  if (Self::source() == Source::kTsc) {
+    // Only the current thread ever writes its counter in this mode, so there's no need for an
+    // atomic read-modify-write.
+    //
+    std::atomic<i64>& value = Self::thread_local_counter().value;
+    const i64 now = std::max(value.load(std::memory_order_relaxed), Self::read_tsc_ticks());
+    value.store(now + 1, std::memory_order_relaxed);
+    return now;
+  }
   return Self::thread_local_counter().value.fetch_add(1);
 }
 
@@ -63,17 +113,62 @@ LRUClock::LocalCounter::~LocalCounter() noexcept
 //
 /*static*/ i64 LRUClock::read_global() noexcept
 {
+  if (Self::source() == Source::kTsc) {
+    return Self::read_tsc_ticks();
+  }
   return Self::instance().read_observed_count();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ auto LRUClock::source() noexcept -> Source
+{
+  return Self::instance().source_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ bool LRUClock::is_tsc_available() noexcept
+{
+#if LLFS_LRU_CLOCK_X86
+  static const bool available = [] {
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+      return false;
+    }
+    // CPUID.80000007H:EDX[8] is the "invariant TSC" bit.
+    //
+    return (edx & (1u << 8)) != 0;
+  }();
+  return available;
+#else
+  return false;
+#endif
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ i64 LRUClock::read_tsc_ticks() noexcept
+{
+#if LLFS_LRU_CLOCK_X86
+  return static_cast<i64>(__rdtsc() >> Self::kTscShift);
+#else
+  return 0;
+#endif
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 LRUClock::LRUClock() noexcept
-    : sync_thread_{[this] {
-      this->run();
-    }}
+    : source_{choose_lru_clock_source()}
+    , adaptive_sync_{batt::getenv_as<int>("LLFS_LRU_CLOCK_ADAPTIVE_SYNC").value_or(0) != 0}
 {
-  this->sync_thread_.detach();
+  if (this->source_ == Source::kCounter) {
+    this->sync_thread_ = std::thread{[this] {
+      this->run();
+    }};
+    this->sync_thread_.detach();
+  }
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -89,12 +184,16 @@ void LRUClock::run() noexcept
       Self::kMaxSyncDelayUsec - Self::kMinSyncDelayUsec,
   };
 
+  // The extra delay added while idle (adaptive sync only).
+  //
+  i64 idle_delay_usec = 0;
+
   // Loop forever, waiting and synchronizing thread-local counters.
   //
   for (;;) {
     // Pick a delay with random jitter.
     //
-    const i64 delay_usec = Self::kMinSyncDelayUsec + pick_jitter(rng);
+    const i64 delay_usec = Self::kMinSyncDelayUsec + pick_jitter(rng) + idle_delay_usec;
 
     // Wait...
     //
@@ -102,17 +201,27 @@ void LRUClock::run() noexcept
 
     // Synchronize the thread-local counters; this will update this->observed_count_.
     //
-    this->sync_local_counters();
+    const bool advanced = this->sync_local_counters();
+
+    if (this->adaptive_sync_) {
+      if (advanced) {
+        idle_delay_usec = 0;
+      } else {
+        idle_delay_usec = std::min(Self::kMaxIdleSyncDelayUsec,
+                                   std::max(Self::kMinSyncDelayUsec, idle_delay_usec * 2));
+      }
+    }
   }
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-void LRUClock::sync_local_counters() noexcept
+bool LRUClock::sync_local_counters() noexcept
 {
   std::unique_lock<std::mutex> lock{this->mutex_};
 
-  i64 max_value = this->observed_count_;
+  const i64 prior_count = this->observed_count_.load();
+  i64 max_value = prior_count;
 
   // On the first pass, figure out the maximum counter value.
   //
@@ -123,7 +232,7 @@ void LRUClock::sync_local_counters() noexcept
   // Save the observed max counter value so that we continue to advance, even if all threads
   // terminate.
   //
-  this->observed_count_ = max_value;
+  this->observed_count_.store(max_value);
 
   // On the second pass, use CAS to make sure that all local counters are at least at the
   // `max_value` calculated above.
@@ -138,6 +247,8 @@ void LRUClock::sync_local_counters() noexcept
   }
 
   // Done!
+  //
+  return max_value != prior_count;
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -148,7 +259,7 @@ void LRUClock::add_local_counter(LocalCounter& counter) noexcept
 
   // Initialize the local counter to the max observed global value.
   //
-  counter.value.store(this->observed_count_);
+  counter.value.store(this->observed_count_.load());
 
   this->counter_list_.push_back(counter);
 }
@@ -161,7 +272,7 @@ void LRUClock::remove_local_counter(LocalCounter& counter) noexcept
 
   // Update the global max observed count (last reading from this local counter).
   //
-  this->observed_count_ = std::max(this->observed_count_, counter.value.load());
+  this->observed_count_.store(std::max(this->observed_count_.load(), counter.value.load()));
 
   this->counter_list_.erase(this->counter_list_.iterator_to(counter));
 }
@@ -170,9 +281,7 @@ void LRUClock::remove_local_counter(LocalCounter& counter) noexcept
 //
 i64 LRUClock::read_observed_count() noexcept
 {
-  std::unique_lock<std::mutex> lock{this->mutex_};
-
-  return this->observed_count_;
+  return this->observed_count_.load();
 }
 
 }  //namespace llfs
@@ -46,6 +46,19 @@ namespace llfs {
  *
  * Note: a regular thread never needs to block in order to simply acquire a logical timestamp; it
  * only needs to do so when it starts or stops.
+ *
+ * Two alternatives can be selected via environment variables (read once, when the clock is first
+ * used):
+ *
+ *  - LLFS_LRU_CLOCK_TSC=1 uses the (invariant) CPU timestamp counter, divided by 2^kTscShift, as
+ *    the clock; it is the same on all threads, so there is no sync thread and no counter list (and
+ *    therefore no mutex when threads start or stop).  Local values still advance by at least one
+ *    per call, so timestamps from a single thread remain strictly increasing.  If the CPU doesn't
+ *    have an invariant TSC, the counter-based clock is used instead.
+ *  - LLFS_LRU_CLOCK_ADAPTIVE_SYNC=1 makes the sync interval adaptive: each time a sync finds that
+ *    no counter has advanced, the delay before the next one is doubled (up to
+ *    kMaxIdleSyncDelayUsec), so an idle process doesn't wake up a thousand times a second; it drops
+ *    back to the normal interval as soon as any counter advances.
  */
 class LRUClock
 {
@@ -55,8 +68,17 @@ class LRUClock
   //----- --- -- -  -  -   -
   static constexpr i64 kMinSyncDelayUsec = 500;
   static constexpr i64 kMaxSyncDelayUsec = 1500;
+  static constexpr i64 kMaxIdleSyncDelayUsec = 100 * 1000;
+  static constexpr int kTscShift = 10;
   //----- --- -- -  -  -   -
 
+  /** \brief Where timestamps come from.
+   */
+  enum struct Source {
+    kCounter,
+    kTsc,
+  };
+
   class LocalCounter;
 
   /** \brief A linked-list node; this is the base type for LocalCounter.
@@ -107,6 +129,20 @@ class LRUClock
    */
   static i64 read_global() noexcept;
 
+  /** \brief Returns the source of timestamps for this process.
+   */
+  static Source source() noexcept;
+
+  /** \brief Returns true iff the CPU has an invariant timestamp counter (required for
+   * Source::kTsc).
+   */
+  static bool is_tsc_available() noexcept;
+
+  /** \brief Returns the current timestamp counter value divided by 2^kTscShift; only meaningful if
+   * is_tsc_available().
+   */
+  static i64 read_tsc_ticks() noexcept;
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
  private:
   LRUClock() noexcept;
@@ -122,8 +158,10 @@ class LRUClock
    *
    * This takes two passes through the list, so it's not 100% guaranteed that all counters will be
    * the same by the end.
+   *
+   * Returns true iff any counter had advanced since the last sync.
    */
-  void sync_local_counters() noexcept;
+  bool sync_local_counters() noexcept;
 
   /** \brief Adds the passed LocalCounter to the global list.
    */
@@ -140,14 +178,17 @@ class LRUClock
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
+  const Source source_;
+  const bool adaptive_sync_;
   std::mutex mutex_;
   LocalCounterList counter_list_;
   std::thread sync_thread_;
 
   // Keeps track of the synchronized counter value as it advances, so we don't go backwards if all
-  // the threads go away temporarily at some point.
+  // the threads go away temporarily at some point.  Only modified with `mutex_` held, but may be
+  // read without it.
   //
-  i64 observed_count_ = 0;
+  std::atomic<i64> observed_count_{0};
 };
 
 //#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
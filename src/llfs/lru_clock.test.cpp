@@ -31,6 +31,8 @@ namespace {
 //     - verify local monotonicity, global independence
 //  2. same as (1), but add at least one "slow" thread; verify that it jumps ahead after sleeping
 //  for the max sync delay.
+//  3. if the CPU has an invariant TSC, the scaled timestamp counter is non-decreasing and
+//     advance_local stays strictly increasing on a single thread.
 //
 //
 
@@ -227,4 +229,28 @@ TEST(LruClockTest, SyncUpdate128)
   run_sync_update_test(128);
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 3.
+//
+TEST(LruClockTest, TscTicksMonotonic)
+{
+  if (!llfs::LRUClock::is_tsc_available()) {
+    GTEST_SKIP() << "No invariant TSC on this CPU";
+  }
+
+  i64 prev_ticks = llfs::LRUClock::read_tsc_ticks();
+  i64 prev_local = llfs::LRUClock::advance_local();
+
+  for (usize i = 0; i < 100 * 1000; ++i) {
+    const i64 ticks = llfs::LRUClock::read_tsc_ticks();
+    const i64 local = llfs::LRUClock::advance_local();
+
+    ASSERT_GE(ticks, prev_ticks);
+    ASSERT_GT(local, prev_local);
+
+    prev_ticks = ticks;
+    prev_local = local;
+  }
+}
+
 }  // namespace
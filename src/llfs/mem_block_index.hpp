@@ -0,0 +1,144 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_MEM_BLOCK_INDEX_HPP
+#define LLFS_MEM_BLOCK_INDEX_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/atomic_shared_ptr.hpp>
+#include <llfs/int_types.hpp>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief The data blocks of an in-memory file, as a two-level radix array indexed by block
+ * number.
+ *
+ * Lookups (`find`) take no locks, so any number of readers can search the index in parallel with
+ * each other and with a writer.  The directory of leaves is immutable once published: it is
+ * replaced as a whole (copy-on-write) when a leaf is added or dropped, and each leaf's slots are
+ * individually atomic.  A block removed from the index stays alive for as long as some reader
+ * still holds it.
+ *
+ * Updates (`find_or_insert`, `truncate`) must be serialized by the caller.
+ */
+template <typename BlockT>
+class MemBlockIndex
+{
+ public:
+  static constexpr i32 kLeafSizeLog2 = 9;
+  static constexpr u64 kLeafSize = u64{1} << kLeafSizeLog2;
+
+  using Slot = AtomicSharedPtr<BlockT>;
+  using Leaf = std::array<Slot, kLeafSize>;
+
+  // Null entries are leaves with no blocks (i.e., holes in a sparse file).
+  //
+  using Directory = std::vector<std::shared_ptr<Leaf>>;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  MemBlockIndex() noexcept : directory_{std::make_shared<const Directory>()}
+  {
+  }
+
+  MemBlockIndex(const MemBlockIndex&) = delete;
+  MemBlockIndex& operator=(const MemBlockIndex&) = delete;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Returns the block with the given number, or nullptr if there is none.
+   */
+  std::shared_ptr<BlockT> find(u64 block_num) const
+  {
+    const std::shared_ptr<const Directory> directory = this->directory_.load();
+    const u64 leaf_index = block_num >> kLeafSizeLog2;
+
+    if (leaf_index >= directory->size() || (*directory)[leaf_index] == nullptr) {
+      return nullptr;
+    }
+
+    return (*(*directory)[leaf_index])[block_num & (kLeafSize - 1)].load();
+  }
+
+  /** \brief Returns the block with the given number, first inserting the block returned by
+   * `new_block_fn()` if there is none.
+   */
+  template <typename NewBlockFn>
+  std::shared_ptr<BlockT> find_or_insert(u64 block_num, NewBlockFn&& new_block_fn)
+  {
+    std::shared_ptr<const Directory> directory = this->directory_.load();
+    const u64 leaf_index = block_num >> kLeafSizeLog2;
+
+    if (leaf_index >= directory->size() || (*directory)[leaf_index] == nullptr) {
+      auto new_directory = std::make_shared<Directory>(*directory);
+      if (leaf_index >= new_directory->size()) {
+        new_directory->resize(leaf_index + 1);
+      }
+      (*new_directory)[leaf_index] = std::make_shared<Leaf>();
+
+      directory = new_directory;
+      this->directory_.store(std::move(new_directory));
+    }
+
+    Slot& slot = (*(*directory)[leaf_index])[block_num & (kLeafSize - 1)];
+
+    std::shared_ptr<BlockT> block = slot.load();
+    if (block == nullptr) {
+      block = new_block_fn();
+      slot.store(block);
+    }
+    return block;
+  }
+
+  /** \brief Removes all blocks numbered `block_count` and above.
+   */
+  void truncate(u64 block_count)
+  {
+    const std::shared_ptr<const Directory> directory = this->directory_.load();
+    const u64 leaf_count = (block_count + kLeafSize - 1) >> kLeafSizeLog2;
+
+    if (leaf_count < directory->size()) {
+      this->directory_.store(std::make_shared<const Directory>(
+          directory->begin(), directory->begin() + leaf_count));
+    }
+
+    // Clear the tail of the last remaining leaf.
+    //
+    const u64 first_cleared = block_count & (kLeafSize - 1);
+    if (first_cleared != 0 && leaf_count <= directory->size() &&
+        (*directory)[leaf_count - 1] != nullptr) {
+      Leaf& leaf = *(*directory)[leaf_count - 1];
+      for (u64 i = first_cleared; i < kLeafSize; ++i) {
+        leaf[i].store(nullptr);
+      }
+    }
+  }
+
+  /** \brief Returns the number of block numbers covered by leaves (an upper bound on the number of
+   * blocks).
+   */
+  u64 capacity() const
+  {
+    return this->directory_.load()->size() * kLeafSize;
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  AtomicSharedPtr<const Directory> directory_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_MEM_BLOCK_INDEX_HPP
@@ -0,0 +1,146 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/mem_block_index.hpp>
+//
+#include <llfs/mem_block_index.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. find_or_insert creates a block only if there isn't one (including in sparse leaves far past
+//     the last one); find returns exactly the inserted blocks.
+//  2. truncate drops every block at or past the new block count (at and between leaf
+//     boundaries), and a reader holding a dropped block keeps it alive.
+//  3. Readers searching the index concurrently with a writer that inserts and truncates only ever
+//     see null or a block holding its own block number.
+
+using namespace llfs::int_types;
+
+using Index = llfs::MemBlockIndex<u64>;
+
+constexpr u64 kLeafSize = Index::kLeafSize;
+
+std::shared_ptr<u64> insert(Index& index, u64 block_num)
+{
+  return index.find_or_insert(block_num, [block_num] {
+    return std::make_shared<u64>(block_num);
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(MemBlockIndexTest, FindOrInsert)
+{
+  Index index;
+
+  EXPECT_EQ(index.find(0), nullptr);
+  EXPECT_EQ(index.capacity(), 0u);
+
+  const std::vector<u64> block_nums = {0, 1, kLeafSize - 1, kLeafSize, 10 * kLeafSize + 7};
+
+  for (u64 block_num : block_nums) {
+    std::shared_ptr<u64> block = insert(index, block_num);
+    ASSERT_NE(block, nullptr);
+    EXPECT_EQ(*block, block_num);
+
+    // A second insert returns the existing block.
+    //
+    EXPECT_EQ(index.find_or_insert(block_num,
+                                   [] {
+                                     ADD_FAILURE() << "block should not be created twice";
+                                     return std::make_shared<u64>(0);
+                                   }),
+              block);
+  }
+
+  EXPECT_EQ(index.capacity(), 11 * kLeafSize);
+
+  for (u64 block_num = 0; block_num < index.capacity() + kLeafSize; ++block_num) {
+    const bool expected = std::find(block_nums.begin(), block_nums.end(), block_num) !=
+                          block_nums.end();
+    std::shared_ptr<u64> block = index.find(block_num);
+
+    EXPECT_EQ(block != nullptr, expected) << BATT_INSPECT(block_num);
+    if (block) {
+      EXPECT_EQ(*block, block_num);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(MemBlockIndexTest, Truncate)
+{
+  for (u64 new_block_count : {u64{0}, u64{1}, kLeafSize - 1, kLeafSize, kLeafSize + 1,
+                              2 * kLeafSize + 5}) {
+    Index index;
+    for (u64 block_num = 0; block_num < 3 * kLeafSize; ++block_num) {
+      insert(index, block_num);
+    }
+
+    std::shared_ptr<u64> held = index.find(3 * kLeafSize - 1);
+
+    index.truncate(new_block_count);
+
+    for (u64 block_num = 0; block_num < 3 * kLeafSize; ++block_num) {
+      EXPECT_EQ(index.find(block_num) != nullptr, block_num < new_block_count)
+          << BATT_INSPECT(block_num) << BATT_INSPECT(new_block_count);
+    }
+    EXPECT_LE(index.capacity(), std::max(new_block_count + kLeafSize - 1, u64{0}));
+
+    ASSERT_NE(held, nullptr);
+    EXPECT_EQ(*held, 3 * kLeafSize - 1);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(MemBlockIndexTest, ConcurrentReaders)
+{
+  constexpr u64 kMaxBlocks = 4 * kLeafSize;
+
+  Index index;
+  std::atomic<bool> done{false};
+
+  std::vector<std::thread> readers;
+  for (usize i = 0; i < 4; ++i) {
+    readers.emplace_back([&index, &done, i] {
+      u64 block_num = i;
+      while (!done.load()) {
+        std::shared_ptr<u64> block = index.find(block_num);
+        if (block) {
+          ASSERT_EQ(*block, block_num);
+        }
+        block_num = (block_num * 31 + 7) % kMaxBlocks;
+      }
+    });
+  }
+
+  for (usize round = 0; round < 200; ++round) {
+    for (u64 block_num = 0; block_num < kMaxBlocks; block_num += (round % 7) + 1) {
+      insert(index, block_num);
+    }
+    index.truncate((round * 37) % kMaxBlocks);
+  }
+
+  done.store(true);
+  for (std::thread& t : readers) {
+    t.join();
+  }
+}
+
+}  // namespace
@@ -7,6 +7,9 @@
 //+++++++++++-+-+--+----- --- -- -  -  -   -
 
 #include <llfs/mem_fuse.hpp>
+//
+
+#include <llfs/contention_profiler.hpp>
 
 namespace llfs {
 
@@ -22,7 +25,7 @@ fuse_ino_t MemoryFuseImpl::allocate_ino_int()
 FuseFileHandle MemoryFuseImpl::allocate_fh_int()
 {
   {
-    auto locked = this->state_.lock();
+    auto locked = LLFS_PROFILE_LOCK_WAIT("MemoryFuseImpl::state_", this->state_.lock());
 
     if (!locked->available_fhs_.empty()) {
       const FuseFileHandle fh = locked->available_fhs_.back();
@@ -37,7 +40,7 @@ FuseFileHandle MemoryFuseImpl::allocate_fh_int()
 //
 batt::StatusOr<batt::SharedPtr<MemInode>> MemoryFuseImpl::find_inode(fuse_ino_t ino)
 {
-  auto locked = this->state_.lock();
+  auto locked = this->inode_shard(ino).lock();
 
   auto iter = locked->inodes_.find(ino);
   if (iter == locked->inodes_.end()) {
@@ -51,7 +54,7 @@ batt::StatusOr<batt::SharedPtr<MemInode>> MemoryFuseImpl::find_inode(fuse_ino_t
 //
 batt::StatusOr<batt::SharedPtr<MemFileHandle>> MemoryFuseImpl::find_file_handle(FuseFileHandle fh)
 {
-  auto locked = this->state_.lock();
+  auto locked = this->file_handle_shard(fh.value()).lock();
 
   auto iter = locked->file_handles_.find(fh);
   if (iter == locked->file_handles_.end()) {
@@ -85,7 +88,7 @@ batt::StatusOr<batt::SharedPtr<MemInode>> MemoryFuseImpl::create_inode_impl(fuse
   BATT_REQUIRE_OK(parent_inode->add_child(name, batt::make_copy(new_inode)));
 
   {
-    auto locked = this->state_.lock();
+    auto locked = this->inode_shard(new_ino).lock();
     locked->inodes_.emplace(new_ino, new_inode);
   }
 
@@ -101,9 +104,9 @@ batt::Status MemoryFuseImpl::close_impl(FuseFileHandle fh)
   BATT_ASSIGN_OK_RESULT(batt::SharedPtr<MemFileHandle> file_handle, this->find_file_handle(fh));
 
   {
-    auto locked = this->state_.lock();
+    this->file_handle_shard(fh.value()).lock()->file_handles_.erase(fh);
 
-    locked->file_handles_.erase(fh);
+    auto locked = LLFS_PROFILE_LOCK_WAIT("MemoryFuseImpl::state_", this->state_.lock());
     locked->available_fhs_.emplace_back(fh);
 
     LLFS_VLOG(1) << "close_impl(" << fh << ")" << BATT_INSPECT_RANGE(locked->available_fhs_);
@@ -136,9 +139,10 @@ batt::Status MemoryFuseImpl::unlink_impl(fuse_req_t req, fuse_ino_t parent, cons
                         parent_inode->remove_child(name, is_dir, MemInode::RequireEmpty{is_dir}));
 
   if (child_inode.first) {
-    auto locked = this->state_.lock();
+    const fuse_ino_t child_ino = child_inode.second->get_ino();
+    auto locked = this->inode_shard(child_ino).lock();
 
-    locked->inodes_.erase(child_inode.second->get_ino());
+    locked->inodes_.erase(child_ino);
   }
 
   return batt::OkStatus();
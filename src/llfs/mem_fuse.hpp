@@ -20,9 +20,11 @@
 #include <batteries/shared_ptr.hpp>
 #include <batteries/suppress.hpp>
 
+#include <array>
 #include <cstring>
 #include <mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 namespace llfs {
@@ -39,15 +41,28 @@ class MemoryFuseImpl : public WorkerTaskFuseImpl<MemoryFuseImpl>
   std::atomic<fuse_ino_t> next_unused_ino_{FUSE_ROOT_ID + 1};
   std::atomic<u64> next_unused_fh_int_{3};
 
-  struct State {
+  /** \brief The number of independently locked shards in each of the inode and file handle
+   * tables; requests for different inodes/handles only contend if they hash to the same shard.
+   */
+  static constexpr usize kTableShardCount = 64;
+
+  struct InodeTableShard {
     std::unordered_map<fuse_ino_t, batt::SharedPtr<MemInode>> inodes_;
+  };
 
+  struct FileHandleTableShard {
     std::unordered_map<FuseFileHandle, batt::SharedPtr<MemFileHandle>, std::hash<u64>>
         file_handles_;
+  };
 
+  struct State {
     std::vector<FuseFileHandle> available_fhs_;
   };
 
+  std::array<batt::Mutex<InodeTableShard>, kTableShardCount> inode_shards_;
+
+  std::array<batt::Mutex<FileHandleTableShard>, kTableShardCount> file_handle_shards_;
+
   batt::Mutex<State> state_;
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -55,13 +70,23 @@ class MemoryFuseImpl : public WorkerTaskFuseImpl<MemoryFuseImpl>
   explicit MemoryFuseImpl(std::shared_ptr<WorkQueue>&& work_queue) noexcept
       : WorkerTaskFuseImpl<MemoryFuseImpl>{std::move(work_queue)}
   {
-    auto locked = this->state_.lock();
+    auto locked = this->inode_shard(FUSE_ROOT_ID).lock();
 
     locked->inodes_.emplace(
         FUSE_ROOT_ID,
         batt::make_shared<MemInode>(FUSE_ROOT_ID, MemInode::Category::kDirectory, /*mode=*/0755));
   }
 
+  batt::Mutex<InodeTableShard>& inode_shard(fuse_ino_t ino)
+  {
+    return this->inode_shards_[ino % kTableShardCount];
+  }
+
+  batt::Mutex<FileHandleTableShard>& file_handle_shard(u64 fh)
+  {
+    return this->file_handle_shards_[fh % kTableShardCount];
+  }
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   /** \brief
@@ -81,7 +106,7 @@ class MemoryFuseImpl : public WorkerTaskFuseImpl<MemoryFuseImpl>
   /** \brief
    */ // 3/44
   batt::StatusOr<const fuse_entry_param*> lookup(fuse_req_t req, fuse_ino_t parent,
-                                                 const std::string& name)
+                                                 const std::string_view& name)
   {
     LLFS_VLOG(1) << "MemoryFuseImpl::" << __FUNCTION__  //
                  << "(" << BATT_INSPECT(req)            //
@@ -92,7 +117,7 @@ class MemoryFuseImpl : public WorkerTaskFuseImpl<MemoryFuseImpl>
     BATT_ASSIGN_OK_RESULT(batt::SharedPtr<MemInode> parent_inode,  //
                           this->find_inode(parent));
 
-    return parent_inode->lookup_child(name);
+    return parent_inode->lookup_child(std::string{name});
   }
 
   /** \brief
@@ -172,7 +197,7 @@ class MemoryFuseImpl : public WorkerTaskFuseImpl<MemoryFuseImpl>
   /** \brief
    */ // 8/44
   batt::StatusOr<const fuse_entry_param*> make_node(fuse_req_t req, fuse_ino_t parent,
-                                                    const std::string& name, mode_t mode,
+                                                    const std::string_view& name, mode_t mode,
                                                     dev_t rdev)
   {
     LLFS_LOG_WARNING() << "MemoryFuseImpl::" << __FUNCTION__  //
@@ -186,7 +211,7 @@ class MemoryFuseImpl : public WorkerTaskFuseImpl<MemoryFuseImpl>
   /** \brief
    */ // 9/44
   batt::StatusOr<const fuse_entry_param*> make_directory(fuse_req_t req, fuse_ino_t parent,
-                                                         const std::string& name, mode_t mode)
+                                                         const std::string_view& name, mode_t mode)
   {
     LLFS_VLOG(1) << "MemoryFuseImpl::" << __FUNCTION__       //
                  << "(" << BATT_INSPECT(req)                 //
@@ -195,15 +220,16 @@ class MemoryFuseImpl : public WorkerTaskFuseImpl<MemoryFuseImpl>
                  << "," << BATT_INSPECT(DumpFileMode{mode})  //
                  << " )";
 
-    BATT_ASSIGN_OK_RESULT(batt::SharedPtr<MemInode> new_inode,
-                          this->create_inode_impl(parent, name, mode, MemInode::IsDir{true}));
+    BATT_ASSIGN_OK_RESULT(
+        batt::SharedPtr<MemInode> new_inode,
+        this->create_inode_impl(parent, std::string{name}, mode, MemInode::IsDir{true}));
 
     return {new_inode->get_fuse_entry_param()};
   }
 
   /** \brief
    */ // 10/44
-  batt::Status unlink(fuse_req_t req, fuse_ino_t parent, const std::string& name)
+  batt::Status unlink(fuse_req_t req, fuse_ino_t parent, const std::string_view& name)
   {
     LLFS_VLOG(1) << "MemoryFuseImpl::" << __FUNCTION__  //
                  << "(" << BATT_INSPECT(req)            //
@@ -212,12 +238,12 @@ class MemoryFuseImpl : public WorkerTaskFuseImpl<MemoryFuseImpl>
                  << " )";
     ;
 
-    return this->unlink_impl(req, parent, name, MemInode::IsDir{false});
+    return this->unlink_impl(req, parent, std::string{name}, MemInode::IsDir{false});
   }
 
   /** \brief
    */ // 11/44
-  batt::Status remove_directory(fuse_req_t req, fuse_ino_t parent, const std::string& name)
+  batt::Status remove_directory(fuse_req_t req, fuse_ino_t parent, const std::string_view& name)
   {
     LLFS_VLOG(1) << "MemoryFuseImpl::" << __FUNCTION__  //
                  << "(" << BATT_INSPECT(req)            //
@@ -225,13 +251,15 @@ class MemoryFuseImpl : public WorkerTaskFuseImpl<MemoryFuseImpl>
                  << "," << BATT_INSPECT_STR(name)       //
                  << " )";
 
-    return this->unlink_impl(req, parent, name, MemInode::IsDir{true});
+    return this->unlink_impl(req, parent, std::string{name}, MemInode::IsDir{true});
   }
 
   /** \brief
    */ // 12/44
-  batt::StatusOr<const fuse_entry_param*> symbolic_link(fuse_req_t req, const std::string& link,
-                                                        fuse_ino_t parent, const std::string& name)
+  batt::StatusOr<const fuse_entry_param*> symbolic_link(fuse_req_t req,
+                                                        const std::string_view& link,
+                                                        fuse_ino_t parent,
+                                                        const std::string_view& name)
   {
     LLFS_LOG_ERROR() << "MemoryFuseImpl::" << __FUNCTION__  //
                      << "("                                 //
@@ -243,8 +271,8 @@ class MemoryFuseImpl : public WorkerTaskFuseImpl<MemoryFuseImpl>
 
   /** \brief
    */ // 13/44
-  batt::Status rename(fuse_req_t req, fuse_ino_t parent, const std::string& name,
-                      fuse_ino_t newparent, const std::string& newname, unsigned int flags)
+  batt::Status rename(fuse_req_t req, fuse_ino_t parent, const std::string_view& name,
+                      fuse_ino_t newparent, const std::string_view& newname, unsigned int flags)
   {
     LLFS_LOG_ERROR() << "MemoryFuseImpl::" << __FUNCTION__  //
                      << "("                                 //
@@ -258,7 +286,7 @@ class MemoryFuseImpl : public WorkerTaskFuseImpl<MemoryFuseImpl>
    */ // 14/44
   batt::StatusOr<const fuse_entry_param*> hard_link(fuse_req_t req, fuse_ino_t ino,
                                                     fuse_ino_t newparent,
-                                                    const std::string& newname)
+                                                    const std::string_view& newname)
   {
     LLFS_LOG_ERROR() << "MemoryFuseImpl::" << __FUNCTION__  //
                      << "("                                 //
@@ -467,7 +495,7 @@ class MemoryFuseImpl : public WorkerTaskFuseImpl<MemoryFuseImpl>
   /** \brief
    */ // 27/44
   batt::StatusOr<FuseImplBase::FuseGetExtendedAttributeReply> get_extended_attribute(
-      fuse_req_t req, fuse_ino_t ino, const std::string& name, size_t size)
+      fuse_req_t req, fuse_ino_t ino, const std::string_view& name, size_t size)
   {
     LLFS_LOG_WARNING() << "MemoryFuseImpl::" << __FUNCTION__  //
                        << "("                                 //
@@ -479,7 +507,8 @@ class MemoryFuseImpl : public WorkerTaskFuseImpl<MemoryFuseImpl>
 
   /** \brief
    */ // 29/44
-  batt::Status remove_extended_attribute(fuse_req_t req, fuse_ino_t ino, const std::string& name)
+  batt::Status remove_extended_attribute(fuse_req_t req, fuse_ino_t ino,
+                                         const std::string_view& name)
   {
     LLFS_LOG_ERROR() << "MemoryFuseImpl::" << __FUNCTION__ << "("  //
                      << " )"
@@ -504,7 +533,7 @@ class MemoryFuseImpl : public WorkerTaskFuseImpl<MemoryFuseImpl>
   /** \brief
    */ // 31/44
   batt::StatusOr<FuseImplBase::FuseCreateReply> create(fuse_req_t req, fuse_ino_t parent,
-                                                       const std::string& name, mode_t mode,
+                                                       const std::string_view& name, mode_t mode,
                                                        const fuse_file_info& fi)
   {
     LLFS_VLOG(1) << "MemoryFuseImpl::" << __FUNCTION__       //
@@ -515,8 +544,9 @@ class MemoryFuseImpl : public WorkerTaskFuseImpl<MemoryFuseImpl>
                  << "," << BATT_INSPECT(fi)                  //
                  << " )";
 
-    BATT_ASSIGN_OK_RESULT(batt::SharedPtr<MemInode> new_inode,
-                          this->create_inode_impl(parent, name, mode, MemInode::IsDir{false}));
+    BATT_ASSIGN_OK_RESULT(
+        batt::SharedPtr<MemInode> new_inode,
+        this->create_inode_impl(parent, std::string{name}, mode, MemInode::IsDir{false}));
 
     BATT_ASSIGN_OK_RESULT(const fuse_file_info* opened_file_info,
                           this->open_inode_impl(batt::make_copy(new_inode), fi));
@@ -24,7 +24,7 @@ inline batt::StatusOr<const fuse_file_info*> MemoryFuseImpl::open_inode_impl(
   LLFS_VLOG(1) << "open_inode_impl, " << BATT_INSPECT(fh);
 
   {
-    auto locked = this->state_.lock();
+    auto locked = this->file_handle_shard(fh).lock();
 
     auto [fh_iter, inserted] = locked->file_handles_.emplace(
         fh, batt::make_shared<MemFileHandle>(fh, std::move(inode), fi,
@@ -14,9 +14,11 @@
 #include <gtest/gtest.h>
 
 #include <llfs/fuse.hpp>
+#include <llfs/fuse_metrics.hpp>
 #include <llfs/worker_task.hpp>
 
 #include <batteries/async/dump_tasks.hpp>
+#include <batteries/stream_util.hpp>
 
 #include <glog/logging.h>
 
@@ -27,6 +29,7 @@
 #include <iostream>
 #include <sstream>
 #include <thread>
+#include <vector>
 
 #include <sys/mount.h>
 
@@ -214,7 +217,11 @@ class MemFuseTest : public ::testing::Test
 
     this->fuse_session_thread_.emplace([this] {
       BATT_CHECK_NE(this->fuse_session_, batt::None);
-      this->fuse_session_->run();
+      if (this->use_reader_threads_) {
+        this->fuse_session_->run_reader_threads(/*thread_count=*/4);
+      } else {
+        this->fuse_session_->run();
+      }
     });
   }
 
@@ -279,6 +286,10 @@ class MemFuseTest : public ::testing::Test
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
+  // If true, run the FuseSession with FuseSession::run_reader_threads instead of run.
+  //
+  bool use_reader_threads_ = false;
+
   std::shared_ptr<llfs::WorkQueue> work_queue_;
 
   batt::Optional<std::thread> worker_task_thread_;
@@ -327,6 +338,11 @@ TEST_F(MemFuseTest, CreateFile)
     EXPECT_TRUE(files->empty());
   }
 
+  llfs::FuseMetrics::OpMetrics& create_metrics =
+      llfs::FuseMetrics::instance().op(llfs::FuseOpcode::kCreate);
+
+  const u64 create_count_before = create_metrics.count.load();
+
   // Create some files.
   {
     std::ofstream ofs{this->mountpoint_ / "file.txt"};
@@ -337,6 +353,10 @@ TEST_F(MemFuseTest, CreateFile)
     ofs << data2;
   }
 
+  // Each file creation should have been counted as a create request.
+  //
+  EXPECT_EQ(create_metrics.count.load(), create_count_before + 2);
+
   // Expect to find the file we created.
   {
     batt::StatusOr<std::vector<std::filesystem::directory_entry>> files = this->find_files();
@@ -408,4 +428,57 @@ TEST_F(MemFuseTest, CreateFile)
   }
 }
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+//
+class MemFuseReaderThreadsTest : public MemFuseTest
+{
+ public:
+  MemFuseReaderThreadsTest() noexcept
+  {
+    this->use_reader_threads_ = true;
+  }
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Files created and read concurrently through a session with several reader threads are all
+// there, with the right contents.
+//
+TEST_F(MemFuseReaderThreadsTest, ConcurrentCreateFiles)
+{
+  constexpr usize kNumThreads = 8;
+  constexpr usize kFilesPerThread = 16;
+
+  const auto file_name = [](usize thread_i, usize file_i) {
+    return batt::to_string("file_", thread_i, "_", file_i, ".txt");
+  };
+
+  std::vector<std::thread> threads;
+  for (usize thread_i = 0; thread_i < kNumThreads; ++thread_i) {
+    threads.emplace_back([&, thread_i] {
+      for (usize file_i = 0; file_i < kFilesPerThread; ++file_i) {
+        std::ofstream ofs{this->mountpoint_ / file_name(thread_i, file_i)};
+        ofs << file_name(thread_i, file_i);
+      }
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+
+  batt::StatusOr<std::vector<std::filesystem::directory_entry>> files = this->find_files();
+
+  ASSERT_TRUE(files.ok()) << BATT_INSPECT(files.status());
+  EXPECT_EQ(files->size(), kNumThreads * kFilesPerThread);
+
+  for (usize thread_i = 0; thread_i < kNumThreads; ++thread_i) {
+    for (usize file_i = 0; file_i < kFilesPerThread; ++file_i) {
+      std::ifstream ifs{this->mountpoint_ / file_name(thread_i, file_i)};
+      std::ostringstream oss;
+      oss << ifs.rdbuf();
+
+      EXPECT_EQ(oss.str(), file_name(thread_i, file_i));
+    }
+  }
+}
+
 }  // namespace
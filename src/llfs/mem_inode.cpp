@@ -51,7 +51,7 @@ auto MemInode::State::find_child_by_name(const std::string& child_name)
   if (child_iter == this->children_by_name_.end()) {
     return {batt::status_from_errno(ENOENT)};
   }
-  return child_iter->second;
+  return child_iter->second.inode;
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -112,37 +112,29 @@ batt::StatusOr<FuseImplBase::Attributes> MemInode::set_attributes(const struct s
     locked->entry_.attr.st_size = new_size;
 
     if (truncated) {
-      auto iter = locked->data_blocks_.lower_bound(new_size);
-
-      // Adjust iter, in case lower_bound overshot (we want the greatest lower bound).
+      // Clear out the truncated portion of the new last block, then drop the blocks past it.
       //
-      if (iter != locked->data_blocks_.begin() &&
-          (iter == locked->data_blocks_.end() || iter->first > new_size)) {
-        --iter;
-      }
+      const u64 last_block_pos = batt::round_down_bits(MemInode::kBlockBufferSizeLog2, new_size);
+      if (last_block_pos < new_size) {
+        std::shared_ptr<BlockBuffer> last_block =
+            this->data_blocks_.find(last_block_pos >> MemInode::kBlockBufferSizeLog2);
 
-      if (iter != locked->data_blocks_.end()) {
-        const u64 block_pos = iter->first;
-        if (iter->first < BATT_CHECKED_CAST(u64, attr->st_size)) {
-          // Clear out the truncated portion of the new last block.
-          //
-          const u64 block_offset = new_size - block_pos;
-          const usize n_to_clear =
-              std::min(iter->second->size() - block_offset, old_size - new_size);
+        if (last_block) {
+          const u64 block_offset = new_size - last_block_pos;
+          const usize n_to_clear = std::min(last_block->size() - block_offset, old_size - new_size);
 
           LLFS_VLOG(1) << BATT_INSPECT(block_offset) << BATT_INSPECT(n_to_clear)
-                       << BATT_INSPECT(iter->second->size() - block_offset)
+                       << BATT_INSPECT(last_block->size() - block_offset)
                        << BATT_INSPECT(old_size - new_size);
 
-          std::memset(iter->second->data() + block_offset, 0, n_to_clear);
-
-          // Move to iter to the next block before erasing.
-          //
-          ++iter;
+          std::memset(last_block->data() + block_offset, 0, n_to_clear);
         }
-        locked->data_blocks_.erase(iter, locked->data_blocks_.end());
       }
+      this->data_blocks_.truncate(
+          batt::round_up_bits(MemInode::kBlockBufferSizeLog2, new_size) >>
+          MemInode::kBlockBufferSizeLog2);
     }
+    this->data_size_.store(new_size);
   }
 
   if ((to_set & FUSE_SET_ATTR_ATIME) != 0) {
@@ -224,11 +216,16 @@ auto MemInode::readdir(fuse_req_t req, MemFileHandle& /*dh*/, size_t size, Diren
   {
     auto locked = this->state_.lock();
 
-    auto children_slice = batt::as_slice(locked->children_by_offset_);
-    children_slice.advance_begin(std::min<isize>(offset, children_slice.size()));
+    // Resume after the entry whose cookie is `offset` (0 is before the first entry).  All the
+    // entries that fit are packed, with their attributes for readdirplus, in one pass under the
+    // directory lock.
+    //
+    auto iter = locked->children_by_offset_.upper_bound(BATT_CHECKED_CAST(u64, offset.value()));
 
-    for (const auto& [child_inode, name] : children_slice) {
-      const auto next_offset = DirentOffset{offset + 1};
+    for (; iter != locked->children_by_offset_.end(); ++iter) {
+      const auto& [cookie, child] = *iter;
+      const auto& [child_inode, name] = child;
+      const auto next_offset = DirentOffset{BATT_CHECKED_CAST(off_t, cookie)};
 
       //----- --- -- -  -  -   -
       // TODO [tastolfi 2023-06-30] maybe do something like this?
@@ -238,7 +235,7 @@ auto MemInode::readdir(fuse_req_t req, MemFileHandle& /*dh*/, size_t size, Diren
       //----- --- -- -  -  -   -
 
       batt::Status pack_status = child_inode->state_.lock()->pack_as_fuse_dir_entry(
-          req, out_buf, dst_buf, name.c_str(), next_offset, plus_api);
+          req, out_buf, dst_buf, name, next_offset, plus_api);
 
       if (pack_status == batt::StatusCode::kResourceExhausted) {
         break;
@@ -255,8 +252,6 @@ auto MemInode::readdir(fuse_req_t req, MemFileHandle& /*dh*/, size_t size, Diren
       }
 
       BATT_REQUIRE_OK(pack_status);
-
-      offset = next_offset;
     }
   }
 
@@ -280,8 +275,11 @@ auto MemInode::add_child(const std::string& name, batt::SharedPtr<MemInode>&& ch
 
     BATT_REQUIRE_OK(child_inode->increment_link_refs(1));
 
-    locked->children_by_name_.emplace(name, child_inode);
-    locked->children_by_offset_.emplace_back(std::move(child_inode), name);
+    const u64 cookie = locked->next_cookie_;
+    locked->next_cookie_ += 1;
+
+    locked->children_by_name_.emplace(name, State::ChildEntry{child_inode, cookie});
+    locked->children_by_offset_.emplace(cookie, std::make_pair(std::move(child_inode), name));
 
     return batt::OkStatus();
   }
@@ -299,15 +297,12 @@ auto MemInode::remove_child(const std::string& name, IsDir is_dir, RequireEmpty
     return batt::status_from_errno(ENOENT);
   }
 
-  auto iter2 = std::find_if(locked->children_by_offset_.begin(), locked->children_by_offset_.end(),
-                            [iter](const std::pair<batt::SharedPtr<MemInode>, std::string>& entry) {
-                              return entry.first == iter->second;
-                            });
+  auto iter2 = locked->children_by_offset_.find(iter->second.cookie);
   if (iter2 == locked->children_by_offset_.end()) {
     return batt::status_from_errno(EIO);
   }
 
-  batt::SharedPtr<MemInode> child_inode = iter->second;
+  batt::SharedPtr<MemInode> child_inode = iter->second.inode;
 
   if (child_inode->is_dir() != is_dir) {
     return batt::status_from_errno(EINVAL);
@@ -341,7 +336,7 @@ usize MemInode::write(u64 offset, const batt::Slice<const batt::ConstBuffer>& bu
 
   const usize begin_offset = offset;
   for (const batt::ConstBuffer& buffer : buffers) {
-    locked->write_chunk(offset, buffer);
+    this->write_chunk(offset, buffer);
     offset += buffer.size();
   }
 
@@ -350,6 +345,7 @@ usize MemInode::write(u64 offset, const batt::Slice<const batt::ConstBuffer>& bu
   const auto written_upper_bound = BATT_CHECKED_CAST(i64, offset);
   if (written_upper_bound > locked->file_size()) {
     locked->file_size(written_upper_bound);
+    this->data_size_.store(offset);
   }
 
   return offset - begin_offset;
@@ -357,7 +353,7 @@ usize MemInode::write(u64 offset, const batt::Slice<const batt::ConstBuffer>& bu
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-void MemInode::State::write_chunk(u64 offset, batt::ConstBuffer buffer)
+void MemInode::write_chunk(u64 offset, batt::ConstBuffer buffer)
 {
   const u64 first_block_pos = batt::round_down_bits(MemInode::kBlockBufferSizeLog2, offset);
 
@@ -367,11 +363,12 @@ void MemInode::State::write_chunk(u64 offset, batt::ConstBuffer buffer)
 
     BATT_CHECK_GE(offset, block_pos);
 
-    auto& p_block_buf = this->data_blocks_[block_pos];
-    if (!p_block_buf) {
-      p_block_buf = std::make_shared<BlockBuffer>();
-      std::memset(p_block_buf->data(), 0, p_block_buf->size());
-    }
+    std::shared_ptr<BlockBuffer> p_block_buf = this->data_blocks_.find_or_insert(
+        block_pos >> MemInode::kBlockBufferSizeLog2, [] {
+          auto new_block = std::make_shared<BlockBuffer>();
+          std::memset(new_block->data(), 0, new_block->size());
+          return new_block;
+        });
 
     usize n_to_copy = std::min(buffer.size(), p_block_buf->size() - block_offset);
     std::memcpy(p_block_buf->data() + block_offset, buffer.data(), n_to_copy);
@@ -388,21 +385,26 @@ FuseImplBase::WithCleanup<batt::Slice<batt::ConstBuffer>> MemInode::read(u64 off
   std::vector<std::shared_ptr<BlockBuffer>> blocks;
   std::vector<batt::ConstBuffer> buffers;
 
-  {
-    auto locked = this->state_.lock();
+  const u64 file_size = this->data_size_.load();
 
-    while (count > 0) {
-      std::shared_ptr<BlockBuffer> p_block;
+  while (count > 0) {
+    std::shared_ptr<BlockBuffer> p_block;
 
-      batt::ConstBuffer chunk = locked->read_chunk(offset, count, &p_block);
-      if (chunk.size() == 0) {
-        break;
-      }
-      buffers.emplace_back(chunk);
+    batt::ConstBuffer chunk = this->read_chunk(offset, count, file_size, &p_block);
+    if (chunk.size() == 0) {
+      break;
+    }
+    buffers.emplace_back(chunk);
 
-      offset += buffers.back().size();
-      count -= buffers.back().size();
+    // Hold a reference to the block until the reply has been sent, in case the file is truncated
+    // in the meantime.
+    //
+    if (p_block) {
+      blocks.emplace_back(std::move(p_block));
     }
+
+    offset += buffers.back().size();
+    count -= buffers.back().size();
   }
 
   auto buffers_slice = batt::as_slice(buffers);
@@ -413,8 +415,8 @@ FuseImplBase::WithCleanup<batt::Slice<batt::ConstBuffer>> MemInode::read(u64 off
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-batt::ConstBuffer MemInode::State::read_chunk(u64 offset, usize count,
-                                              std::shared_ptr<BlockBuffer>* p_block_out)
+batt::ConstBuffer MemInode::read_chunk(u64 offset, usize count, u64 file_size,
+                                       std::shared_ptr<BlockBuffer>* p_block_out) const
 {
   static BlockBuffer zero_block;
   static const batt::ConstBuffer zero_buf = [] {
@@ -422,31 +424,33 @@ batt::ConstBuffer MemInode::State::read_chunk(u64 offset, usize count,
     return batt::ConstBuffer{zero_block.data(), zero_block.size()};
   }();
 
+  if (offset >= file_size) {
+    return batt::ConstBuffer{nullptr, 0};
+  }
+
   const u64 first_block_pos = batt::round_down_bits(MemInode::kBlockBufferSizeLog2, offset);
   const u64 first_block_offset = offset - first_block_pos;
 
   BATT_CHECK_GE(offset, first_block_pos);
 
   const batt::ConstBuffer data_block = [&] {
-    auto iter = this->data_blocks_.find(first_block_pos);
-    if (iter == this->data_blocks_.end()) {
+    std::shared_ptr<BlockBuffer> block =
+        this->data_blocks_.find(first_block_pos >> MemInode::kBlockBufferSizeLog2);
+    if (!block) {
       return zero_buf;
     }
 
-    BATT_CHECK_NOT_NULLPTR(iter->second);
+    const batt::ConstBuffer block_buf{block->data(), block->size()};
 
     if (p_block_out) {
-      *p_block_out = iter->second;
+      *p_block_out = std::move(block);
     }
 
-    return batt::ConstBuffer{
-        iter->second->data(),
-        iter->second->size(),
-    };
+    return block_buf;
   }();
 
   return batt::resize_buffer(data_block + first_block_offset,
-                             std::min(count, this->file_size() - offset));
+                             std::min<u64>(count, file_size - offset));
 }
 
 }  //namespace llfs
@@ -11,6 +11,7 @@
 #define LLFS_MEM_INODE_HPP
 
 #include <llfs/fuse.hpp>
+#include <llfs/mem_block_index.hpp>
 #include <llfs/mem_inode_base.hpp>
 
 #include <batteries/async/mutex.hpp>
@@ -21,6 +22,9 @@
 #include <batteries/status.hpp>
 #include <batteries/strong_typedef.hpp>
 
+#include <atomic>
+#include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -84,21 +88,49 @@ class MemInode : public MemInodeBase<MemInode>
 
   usize write(u64 offset, const batt::Slice<const batt::ConstBuffer>& buffers);
 
+  /** \brief Returns the file data in the given range (clipped to the file size).
+   *
+   * Reads don't lock the inode, so concurrent reads of the same file (at any offsets) proceed in
+   * parallel.
+   */
   FuseImplBase::WithCleanup<batt::Slice<batt::ConstBuffer>> read(u64 offset, usize count);
 
   //----- --- -- -  -  -   -
  private:
   void init_directory();
 
+  /** \brief Copies `buffer` into the file's data blocks at `offset`; the caller must hold the
+   * state lock.
+   */
+  void write_chunk(u64 offset, batt::ConstBuffer buffer);
+
+  /** \brief Returns the data at `offset`, up to the end of the block that contains it (or the end
+   * of the file, if that comes first); sets `*p_block_out` to the block, if there is one.
+   */
+  batt::ConstBuffer read_chunk(u64 offset, usize count, u64 file_size,
+                               std::shared_ptr<BlockBuffer>* p_block_out) const;
+
   //----- --- -- -  -  -   -
   struct State {
     fuse_entry_param entry_;
 
-    std::unordered_map<std::string, batt::SharedPtr<MemInode>> children_by_name_;
+    // (Directories only) A child entry, as found by name.  `cookie` is the entry's key in
+    // `children_by_offset_`, which is also the readdir offset that follows the entry.
+    //
+    struct ChildEntry {
+      batt::SharedPtr<MemInode> inode;
+      u64 cookie;
+    };
+
+    std::unordered_map<std::string, ChildEntry> children_by_name_;
 
-    std::vector<std::pair<batt::SharedPtr<MemInode>, std::string>> children_by_offset_;
+    // The directory entries in readdir order.  Cookies are assigned in increasing order as entries
+    // are added and never reused, so they stay valid as offsets while entries come and go: a
+    // readdir that resumes from a cookie sees every entry that was there all along exactly once.
+    //
+    std::map<u64, std::pair<batt::SharedPtr<MemInode>, std::string>> children_by_offset_;
 
-    std::map<u64, std::shared_ptr<BlockBuffer>> data_blocks_;
+    u64 next_cookie_ = 1;
 
     //----- --- -- -  -  -   -
 
@@ -110,11 +142,6 @@ class MemInode : public MemInodeBase<MemInode>
                                         batt::MutableBuffer& dst_buf, const std::string& name,
                                         DirentOffset offset, PlusApi plus_api) const;
 
-    void write_chunk(u64 offset, batt::ConstBuffer buffer);
-
-    batt::ConstBuffer read_chunk(u64 offset, usize count,
-                                 std::shared_ptr<BlockBuffer>* p_block_out);
-
     i64 file_size() const
     {
       return this->entry_.attr.st_size;
@@ -128,6 +155,15 @@ class MemInode : public MemInodeBase<MemInode>
 
   batt::Mutex<State> state_;
 
+  /** \brief The file data, indexed by block number (offset / kBlockBufferSize).  Updated only
+   * while holding the state lock; searched without it.
+   */
+  MemBlockIndex<BlockBuffer> data_blocks_;
+
+  /** \brief A copy of `entry_.attr.st_size`, so that reads don't need the state lock.
+   */
+  std::atomic<u64> data_size_{0};
+
   /** \brief See state flags above.
    */
   batt::Watch<u64> count_{0};
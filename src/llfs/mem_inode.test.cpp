@@ -0,0 +1,125 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/mem_inode.hpp>
+//
+#include <llfs/mem_inode.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/mem_file_handle.hpp>
+
+#include <cstring>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. Paging through a directory with readdir (a few entries per reply) returns every entry
+//     exactly once, in creation order, even when entries before and after the current position
+//     are removed and new ones are added between replies.
+
+using namespace llfs::int_types;
+
+using llfs::MemInode;
+
+// The layout of the entries added by fuse_add_direntry (struct fuse_dirent in linux/fuse.h).
+//
+struct Dirent {
+  u64 ino;
+  u64 off;
+  u32 namelen;
+  u32 type;
+};
+
+// Returns the names of the entries in a readdir reply, and sets `*last_offset` to the offset of
+// the last one.
+//
+std::vector<std::string> parse_dirents(const batt::ConstBuffer& buffer,
+                                       llfs::DirentOffset* last_offset)
+{
+  std::vector<std::string> names;
+
+  const char* next = static_cast<const char*>(buffer.data());
+  const char* const end = next + buffer.size();
+
+  while (next < end) {
+    Dirent dirent;
+    std::memcpy(&dirent, next, sizeof(dirent));
+
+    names.emplace_back(next + sizeof(Dirent), dirent.namelen);
+    *last_offset = llfs::DirentOffset{static_cast<off_t>(dirent.off)};
+
+    next += (sizeof(Dirent) + dirent.namelen + 7) & ~usize{7};
+  }
+
+  return names;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(MemInodeTest, ReaddirCookiesAreStable)
+{
+  auto dir = batt::make_shared<MemInode>(FUSE_ROOT_ID, MemInode::Category::kDirectory, 0755);
+
+  const auto new_file = [](fuse_ino_t ino) {
+    return batt::make_shared<MemInode>(ino, MemInode::Category::kRegularFile, 0644);
+  };
+
+  for (usize i = 0; i < 10; ++i) {
+    ASSERT_TRUE(dir->add_child("f" + std::to_string(i), new_file(100 + i)).ok());
+  }
+
+  fuse_file_info fi;
+  std::memset(&fi, 0, sizeof(fi));
+  llfs::MemFileHandle dh{/*fh=*/1, batt::make_copy(dir), fi, llfs::MemFileHandle::OpenDirState{}};
+
+  // Each entry takes 32 bytes ("fN" is 2 bytes, padded to 8 after the 24 byte header).
+  //
+  constexpr usize kReplySize = 64;
+
+  std::vector<std::string> names;
+  llfs::DirentOffset offset{0};
+
+  for (usize page = 0;; ++page) {
+    llfs::StatusOr<llfs::FuseImplBase::FuseReadDirData> reply =
+        dir->readdir(/*req=*/nullptr, dh, kReplySize, offset, llfs::PlusApi{false});
+
+    ASSERT_TRUE(reply.ok()) << BATT_INSPECT(reply.status());
+
+    const batt::ConstBuffer& buffer =
+        std::get<llfs::FuseImplBase::OwnedConstBuffer>(*reply).buffer;
+
+    if (buffer.size() == 0) {
+      break;
+    }
+
+    std::vector<std::string> page_names = parse_dirents(buffer, &offset);
+    names.insert(names.end(), page_names.begin(), page_names.end());
+
+    if (page == 0) {
+      EXPECT_THAT(page_names, ::testing::ElementsAre("f0", "f1"));
+
+      // Remove an entry that was already returned and one that wasn't, and add a new one.
+      //
+      ASSERT_TRUE(dir->remove_child("f0", MemInode::IsDir{false}, MemInode::RequireEmpty{false})
+                      .ok());
+      ASSERT_TRUE(dir->remove_child("f3", MemInode::IsDir{false}, MemInode::RequireEmpty{false})
+                      .ok());
+      ASSERT_TRUE(dir->add_child("f10", new_file(200)).ok());
+    }
+  }
+
+  EXPECT_THAT(names, ::testing::ElementsAre("f0", "f1", "f2", "f4", "f5", "f6", "f7", "f8", "f9",
+                                            "f10"));
+}
+
+}  // namespace
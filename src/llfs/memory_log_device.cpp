@@ -21,7 +21,7 @@ namespace llfs {
 //
 bool MemoryLogStorageDriver::is_auto_flush() const noexcept
 {
-  return this->flush_pos_ == &this->commit_pos_;
+  return this->auto_flush_;
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -35,18 +35,14 @@ void MemoryLogStorageDriver::set_auto_flush(bool on) noexcept
   }
 
   this->sync_flush_pos();
-  if (on) {
-    this->flush_pos_ = &this->commit_pos_;
-  } else {
-    this->flush_pos_ = &this->manual_flush_pos_;
-  }
+  this->auto_flush_ = on;
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 void MemoryLogStorageDriver::sync_flush_pos() noexcept
 {
-  this->manual_flush_pos_.set_value(this->commit_pos_.get_value());
+  this->manual_flush_pos_.set_value(this->get_commit_pos());
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -124,7 +120,12 @@ void MemoryLogDevice::restore_snapshot(const LogDeviceSnapshot& snapshot, LogRea
 
   MutableBuffer dst = ring_buffer.get_mut(snapshot.trim_pos());
 
-  std::memcpy(dst.data(), snapshot.bytes(), snapshot.size());
+  snapshot.copy_to(dst.data());
+
+  // Committed bytes may have been rewritten, so snapshots taken before this point must not share
+  // bytes with ones taken after.
+  //
+  this->history_id_.store(LogStorageDriverContext::next_history_id());
 }
 
 //#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
@@ -16,6 +16,8 @@
 
 #include <batteries/async/watch.hpp>
 
+#include <atomic>
+
 namespace llfs {
 
 class MemoryLogDeviceFactory;
@@ -23,7 +25,7 @@ class MemoryLogDeviceFactory;
 class MemoryLogStorageDriver /*Impl*/
 {
  public:
-  explicit MemoryLogStorageDriver(LogStorageDriverContext&) noexcept
+  explicit MemoryLogStorageDriver(LogStorageDriverContext& context) noexcept : context_{context}
   {
     // Verify default setting for auto-flush.
     //
@@ -55,29 +57,56 @@ class MemoryLogStorageDriver /*Impl*/
 
   slot_offset_type get_flush_pos() const
   {
-    return this->flush_pos_->get_value();
+    if (this->is_auto_flush()) {
+      return this->get_commit_pos();
+    }
+    return this->manual_flush_pos_.get_value();
   }
 
   StatusOr<slot_offset_type> await_flush_pos(slot_offset_type min_offset)
   {
-    return await_slot_offset(min_offset, *this->flush_pos_);
+    if (this->is_auto_flush()) {
+      return this->await_commit_pos(min_offset);
+    }
+    return await_slot_offset(min_offset, this->manual_flush_pos_);
+  }
+
+#if LLFS_HAS_COROUTINES
+  coro::Task<StatusOr<slot_offset_type>> co_await_flush_pos(slot_offset_type min_offset)
+  {
+    if (!this->is_auto_flush()) {
+      co_return co_await co_await_slot_offset(min_offset, this->manual_flush_pos_);
+    }
+
+    CommitPosWaiter waiter{this};
+
+    co_return co_await co_await_slot_offset(min_offset, this->commit_pos_);
   }
+#endif  // LLFS_HAS_COROUTINES
 
   //----
 
+  /** \brief Sets the commit pos.  This is the writer's hot path: `commit_pos_` (the Watch) is only
+   * updated if someone is waiting on it; otherwise this is a single atomic store.
+   */
   Status set_commit_pos(slot_offset_type commit_pos)
   {
-    this->commit_pos_.set_value(commit_pos);
+    this->latest_commit_pos_.store(commit_pos);
+    if (this->commit_pos_waiters_.load() != 0) {
+      clamp_min_slot(this->commit_pos_, commit_pos);
+    }
     return OkStatus();
   }
 
   slot_offset_type get_commit_pos() const
   {
-    return this->commit_pos_.get_value();
+    return this->latest_commit_pos_.load();
   }
 
   StatusOr<slot_offset_type> await_commit_pos(slot_offset_type min_offset)
   {
+    CommitPosWaiter waiter{this};
+
     return await_slot_offset(min_offset, this->commit_pos_);
   }
 
@@ -136,15 +165,59 @@ class MemoryLogStorageDriver /*Impl*/
  private:
   friend class LogTruncateAccess;
 
+  /** \brief Registers a waiter on `commit_pos_` for the lifetime of the object.
+   *
+   * The writer only publishes to `commit_pos_` while `commit_pos_waiters_` is non-zero, so a
+   * waiter first increments the count and then brings `commit_pos_` up to date itself; since both
+   * sides store and then load (seq_cst) the other's variable, either the writer sees the waiter or
+   * the waiter sees the writer's latest commit pos.
+   */
+  class CommitPosWaiter
+  {
+   public:
+    explicit CommitPosWaiter(MemoryLogStorageDriver* driver) noexcept : driver_{driver}
+    {
+      this->driver_->commit_pos_waiters_.fetch_add(1);
+      clamp_min_slot(this->driver_->commit_pos_, this->driver_->latest_commit_pos_.load());
+    }
+
+    CommitPosWaiter(const CommitPosWaiter&) = delete;
+    CommitPosWaiter& operator=(const CommitPosWaiter&) = delete;
+
+    ~CommitPosWaiter() noexcept
+    {
+      this->driver_->commit_pos_waiters_.fetch_sub(1);
+    }
+
+   private:
+    MemoryLogStorageDriver* driver_;
+  };
+
   void truncate(slot_offset_type truncate_pos)
   {
+    // Bytes past `truncate_pos` will be overwritten; see LogStorageDriverContext::history_id_.
+    //
+    this->context_.history_id_.store(LogStorageDriverContext::next_history_id());
+
+    this->latest_commit_pos_.store(truncate_pos);
     this->commit_pos_.set_value(truncate_pos);
   }
 
+  LogStorageDriverContext& context_;
+
   batt::Watch<slot_offset_type> trim_pos_{0};
   batt::Watch<slot_offset_type> manual_flush_pos_{0};
+
+  // The current commit pos; this is the source of truth.  `commit_pos_` lags behind it while there
+  // are no waiters (see CommitPosWaiter).
+  //
+  std::atomic<slot_offset_type> latest_commit_pos_{0};
+  std::atomic<usize> commit_pos_waiters_{0};
   batt::Watch<slot_offset_type> commit_pos_{0};
-  batt::Watch<slot_offset_type>* flush_pos_ = &this->commit_pos_;
+
+  // If true, the flush pos is the commit pos; otherwise it is `manual_flush_pos_`.
+  //
+  bool auto_flush_ = true;
 };
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
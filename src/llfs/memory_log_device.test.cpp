@@ -0,0 +1,116 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/memory_log_device.hpp>
+//
+#include <llfs/memory_log_device.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <thread>
+
+namespace {
+
+// Test Plan:
+//  1. A thread blocked in await_commit_pos (and sync(kDurable)) is woken once the writer commits
+//     past the awaited offset; commits before anyone waits are visible through get_commit_pos
+//     and get_flush_pos.
+//  2. With auto-flush off, flush pos follows flush_up_to_offset, not commit.
+
+using namespace llfs::int_types;
+
+constexpr usize kLogSize = 4096;
+
+// Appends `n` bytes to `log`, returning the new commit pos.
+//
+llfs::slot_offset_type append(llfs::MemoryLogDevice& log, usize n)
+{
+  llfs::LogDevice::Writer& writer = log.writer();
+
+  llfs::StatusOr<llfs::MutableBuffer> buffer = writer.prepare(n);
+  BATT_CHECK_OK(buffer);
+
+  std::memset(buffer->data(), 'a', n);
+
+  llfs::StatusOr<llfs::slot_offset_type> commit_pos = writer.commit(n);
+  BATT_CHECK_OK(commit_pos);
+
+  return *commit_pos;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST(MemoryLogDeviceTest, AwaitCommitPos)
+{
+  llfs::MemoryLogDevice log{kLogSize};
+
+  EXPECT_EQ(append(log, 10), 10u);
+  EXPECT_EQ(log.driver().get_commit_pos(), 10u);
+  EXPECT_EQ(log.driver().get_flush_pos(), 10u);
+  EXPECT_EQ(log.slot_range(llfs::LogReadMode::kDurable), (llfs::SlotRange{0, 10}));
+
+  // Already satisfied.
+  //
+  llfs::StatusOr<llfs::slot_offset_type> already = log.driver().await_commit_pos(5);
+  ASSERT_TRUE(already.ok());
+  EXPECT_EQ(*already, 10u);
+
+  llfs::StatusOr<llfs::slot_offset_type> commit_result;
+  llfs::Status sync_result;
+
+  std::thread commit_waiter{[&] {
+    commit_result = log.driver().await_commit_pos(100);
+  }};
+  std::thread sync_waiter{[&] {
+    sync_result = log.sync(llfs::LogReadMode::kDurable, llfs::SlotUpperBoundAt{.offset = 100});
+  }};
+
+  for (usize i = 0; i < 20; ++i) {
+    append(log, 10);
+    std::this_thread::yield();
+  }
+
+  commit_waiter.join();
+  sync_waiter.join();
+
+  ASSERT_TRUE(commit_result.ok()) << BATT_INSPECT(commit_result.status());
+  EXPECT_GE(*commit_result, 100u);
+  EXPECT_TRUE(sync_result.ok()) << BATT_INSPECT(sync_result);
+  EXPECT_EQ(log.driver().get_commit_pos(), 210u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST(MemoryLogDeviceTest, ManualFlush)
+{
+  llfs::MemoryLogDevice log{kLogSize};
+
+  llfs::MemoryLogStorageDriver& driver = log.driver().impl();
+
+  append(log, 10);
+  driver.set_auto_flush(false);
+  append(log, 20);
+
+  EXPECT_EQ(driver.get_commit_pos(), 30u);
+  EXPECT_EQ(driver.get_flush_pos(), 10u);
+  EXPECT_EQ(driver.unflushed_size(), 20u);
+
+  EXPECT_EQ(driver.flush_up_to_offset(25), 15u);
+  EXPECT_EQ(driver.get_flush_pos(), 25u);
+
+  driver.set_auto_flush(true);
+
+  EXPECT_EQ(driver.get_flush_pos(), 30u);
+  EXPECT_EQ(driver.unflushed_size(), 0u);
+}
+
+}  // namespace
@@ -17,12 +17,13 @@ namespace llfs {
 
 PageArena make_memory_page_arena(batt::TaskScheduler& scheduler, PageCount n_pages,
                                  PageSize page_size, std::string&& name,
-                                 page_device_id_int device_id)
+                                 page_device_id_int device_id,
+                                 const MemoryPageDeviceOptions& device_options)
 {
   const auto log_size = PageAllocator::calculate_log_size(n_pages, kDefaultMaxPoolAttachments);
 
   return PageArena{
-      std::make_unique<MemoryPageDevice>(device_id, n_pages, page_size),
+      std::make_unique<MemoryPageDevice>(device_id, n_pages, page_size, device_options),
       PageAllocator::recover_or_die(PageAllocatorRuntimeOptions{scheduler, name},
                                     PageIdFactory{n_pages, device_id},
                                     *std::make_unique<MemoryLogDeviceFactory>(log_size))};
@@ -11,6 +11,7 @@
 #define LLFS_MEMORY_PAGE_ARENA_HPP
 
 #include <llfs/int_types.hpp>
+#include <llfs/memory_page_device.hpp>
 #include <llfs/page_arena.hpp>
 #include <llfs/page_id_factory.hpp>
 #include <llfs/page_size.hpp>
@@ -23,7 +24,8 @@ namespace llfs {
 
 PageArena make_memory_page_arena(batt::TaskScheduler& scheduler, PageCount n_pages,
                                  PageSize page_size, std::string&& name,
-                                 page_device_id_int device_id);
+                                 page_device_id_int device_id,
+                                 const MemoryPageDeviceOptions& device_options = {});
 
 }  // namespace llfs
 
@@ -16,10 +16,24 @@ namespace llfs {
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 MemoryPageDevice::MemoryPageDevice(page_device_id_int device_id, PageCount capacity,
-                                   PageSize page_size) noexcept
+                                   PageSize page_size,
+                                   const MemoryPageDeviceOptions& options) noexcept
     : page_ids_{capacity, device_id}
     , page_size_{page_size}
 {
+  if (options.use_slab) {
+    StatusOr<std::shared_ptr<PageBufferSlab>> slab = PageBufferSlab::make_new(
+        page_size, capacity, UseHugePages{options.use_huge_pages});
+
+    if (slab.ok()) {
+      this->buffer_slab_ = std::move(*slab);
+    } else {
+      LLFS_LOG_WARNING() << "MemoryPageDevice: could not create page buffer slab; using the heap"
+                         << BATT_INSPECT(slab.status()) << BATT_INSPECT(device_id)
+                         << BATT_INSPECT(capacity) << BATT_INSPECT(page_size);
+    }
+  }
+
   this->state_.lock()->page_recs.resize(capacity);
   this->state_.lock()->recently_dropped.fill(PageId{kInvalidPageId});
 }
@@ -42,6 +56,12 @@ PageSize MemoryPageDevice::page_size()
 //
 StatusOr<std::shared_ptr<PageBuffer>> MemoryPageDevice::prepare(PageId page_id)
 {
+  if (this->buffer_slab_) {
+    std::shared_ptr<PageBuffer> page_buffer = this->buffer_slab_->allocate(page_id);
+    if (page_buffer) {
+      return page_buffer;
+    }
+  }
   return PageBuffer::allocate(this->page_size_, page_id);
 }
 
@@ -11,6 +11,7 @@
 #define LLFS_MEMORY_PAGE_DEVICE_HPP
 
 #include <llfs/int_types.hpp>
+#include <llfs/page_buffer_slab.hpp>
 #include <llfs/page_device.hpp>
 #include <llfs/page_size.hpp>
 #include <llfs/status.hpp>
@@ -26,11 +27,36 @@
 
 namespace llfs {
 
+struct MemoryPageDeviceOptions {
+  /** \brief If true, the buffers returned by `prepare` (which become the stored pages once they
+   * are written) are allocated from a PageBufferSlab with room for every page of the device, rather
+   * than from the heap.  If the slab can't be created, or all its buffers are in use (e.g., because
+   * readers still hold dropped pages), buffers are allocated from the heap.
+   */
+  bool use_slab = false;
+
+  /** \brief If true (and `use_slab` is true), ask for the slab to be backed by huge pages.
+   */
+  bool use_huge_pages = false;
+};
+
+/** \brief A PageDevice that keeps pages in memory.
+ *
+ * Since pages are immutable once written, the device stores the PageBuffer passed to `write`
+ * itself, and `read` returns a reference to that same buffer; reading a page never copies it.
+ */
 class MemoryPageDevice : public PageDevice
 {
  public:
-  explicit MemoryPageDevice(page_device_id_int device_id, PageCount capacity,
-                            PageSize page_size) noexcept;
+  explicit MemoryPageDevice(page_device_id_int device_id, PageCount capacity, PageSize page_size,
+                            const MemoryPageDeviceOptions& options = {}) noexcept;
+
+  /** \brief Returns the slab that page buffers are allocated from, or nullptr if there is none.
+   */
+  const std::shared_ptr<PageBufferSlab>& buffer_slab() const
+  {
+    return this->buffer_slab_;
+  }
 
   PageIdFactory page_ids() override;
 
@@ -58,6 +84,11 @@ class MemoryPageDevice : public PageDevice
 
   const PageIdFactory page_ids_;
   const PageSize page_size_;
+
+  // If not null, `prepare` allocates page buffers from here.
+  //
+  std::shared_ptr<PageBufferSlab> buffer_slab_;
+
   batt::Mutex<State> state_;
 };
 
@@ -13,10 +13,109 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <llfs/page_buffer.hpp>
+
+#include <vector>
+
 namespace {
 
+using namespace llfs::int_types;
+
+// Test Plan:
+//  1. Reading a page returns the buffer that was written, not a copy.
+//  2. With `use_slab`, prepared buffers come from the device's slab until it runs out, and then
+//     from the heap.
+
+constexpr llfs::page_device_id_int kDeviceId = 1;
+constexpr i64 kCapacity = 4;
+constexpr u32 kPageSize = 4096;
+
+llfs::Status write_page(llfs::PageDevice& device, std::shared_ptr<llfs::PageBuffer>&& buffer)
+{
+  llfs::Status result;
+  device.write(std::move(buffer), [&result](llfs::Status status) {
+    result = status;
+  });
+  return result;
+}
+
 TEST(MemoryPageDeviceTest, Basic)
 {
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(MemoryPageDeviceTest, ReadReturnsStoredBuffer)
+{
+  llfs::MemoryPageDevice device{kDeviceId, llfs::PageCount{kCapacity}, llfs::PageSize{kPageSize}};
+
+  const llfs::PageId page_id = device.page_ids().make_page_id(2, 1);
+
+  llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer = device.prepare(page_id);
+  ASSERT_TRUE(buffer.ok()) << BATT_INSPECT(buffer.status());
+
+  const llfs::PageBuffer* const written = buffer->get();
+
+  ASSERT_TRUE(write_page(device, std::move(*buffer)).ok());
+
+  for (int i = 0; i < 2; ++i) {
+    llfs::PageDevice::ReadResult result;
+    device.read(page_id, [&result](llfs::PageDevice::ReadResult r) {
+      result = std::move(r);
+    });
+    ASSERT_TRUE(result.ok()) << BATT_INSPECT(result.status());
+    EXPECT_EQ(result->get(), written);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(MemoryPageDeviceTest, SlabBackedBuffers)
+{
+  llfs::MemoryPageDevice device{kDeviceId, llfs::PageCount{kCapacity}, llfs::PageSize{kPageSize},
+                                llfs::MemoryPageDeviceOptions{
+                                    .use_slab = true,
+                                    .use_huge_pages = true,
+                                }};
+
+  const std::shared_ptr<llfs::PageBufferSlab>& slab = device.buffer_slab();
+  ASSERT_NE(slab, nullptr);
+  EXPECT_EQ(slab->buffer_count(), static_cast<usize>(kCapacity));
+
+  // Slab buffers are never registered for fixed I/O.
+  //
+  std::vector<std::shared_ptr<llfs::PageBuffer>> buffers;
+  for (i64 i = 0; i < kCapacity; ++i) {
+    llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer =
+        device.prepare(device.page_ids().make_page_id(i, 1));
+    ASSERT_TRUE(buffer.ok());
+    EXPECT_TRUE(slab->contains(buffer->get()));
+    EXPECT_FALSE(slab->buf_index_of(buffer->get()));
+    EXPECT_EQ((*buffer)->size(), kPageSize);
+    buffers.emplace_back(std::move(*buffer));
+  }
+  EXPECT_EQ(slab->free_count(), 0u);
+
+  // The slab is exhausted, so the next buffer comes from the heap.
+  //
+  llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> extra =
+      device.prepare(device.page_ids().make_page_id(0, 2));
+  ASSERT_TRUE(extra.ok());
+  EXPECT_FALSE(slab->contains(extra->get()));
+
+  // Written pages keep their slab buffers; dropping the other references doesn't free them.
+  //
+  const llfs::PageId page_id = buffers[1]->page_id();
+  ASSERT_TRUE(write_page(device, std::move(buffers[1])).ok());
+  buffers.clear();
+  EXPECT_EQ(slab->free_count(), static_cast<usize>(kCapacity - 1));
+
+  llfs::Status drop_status;
+  device.drop(page_id, [&drop_status](llfs::Status status) {
+    drop_status = status;
+  });
+  ASSERT_TRUE(drop_status.ok());
+  EXPECT_EQ(slab->free_count(), static_cast<usize>(kCapacity));
+}
+
 }  // namespace
@@ -0,0 +1,248 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/memory_pressure_monitor.hpp>
+//
+
+#include <llfs/logging.hpp>
+#include <llfs/page_cache.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/stream_util.hpp>
+#include <batteries/syscall_retry.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ auto MemoryPressureMonitor::Options::with_default_values() -> Options
+{
+  return Options{
+      .pressure_file = MemoryPressureMonitor::default_pressure_file(),
+      .stall_threshold_usec = 150 * 1000,
+      .window_usec = 1000 * 1000,
+      .shrink_factor = 0.75,
+      .grow_factor = 1.125,
+      .min_cache_bytes = 64 * kMiB,
+      .regrow_delay_usec = 30 * 1000 * 1000,
+  };
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ std::string MemoryPressureMonitor::default_pressure_file()
+{
+  // Under cgroup v2, /proc/self/cgroup has a single line "0::<path>".
+  //
+  std::ifstream ifs{"/proc/self/cgroup"};
+  std::string line;
+  while (std::getline(ifs, line)) {
+    if (line.rfind("0::", 0) == 0) {
+      std::string file = batt::to_string("/sys/fs/cgroup", line.substr(3), "/memory.pressure");
+      if (::access(file.c_str(), R_OK | W_OK) == 0) {
+        return file;
+      }
+    }
+  }
+  return "/proc/pressure/memory";
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ u64 MemoryPressureMonitor::shrunk_cache_bytes(u64 current_bytes,
+                                                         const Options& options)
+{
+  const u64 shrunk = static_cast<u64>(static_cast<double>(current_bytes) * options.shrink_factor);
+
+  return std::min(current_bytes, std::max(shrunk, options.min_cache_bytes));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ u64 MemoryPressureMonitor::grown_cache_bytes(u64 current_bytes, u64 target_bytes,
+                                                        const Options& options)
+{
+  if (current_bytes >= target_bytes) {
+    return current_bytes;
+  }
+  const u64 grown = static_cast<u64>(static_cast<double>(current_bytes) * options.grow_factor);
+
+  return std::min(target_bytes, std::max(grown, current_bytes + 1));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<std::unique_ptr<MemoryPressureMonitor>> MemoryPressureMonitor::start(
+    PageCache& cache, const Options& options)
+{
+  BATT_CHECK_GT(options.shrink_factor, 0.0);
+  BATT_CHECK_LT(options.shrink_factor, 1.0);
+  BATT_CHECK_GT(options.grow_factor, 1.0);
+
+  const u64 target_bytes = cache.cache_bytes_limit();
+  if (target_bytes == 0) {
+    return {batt::StatusCode::kFailedPrecondition};
+  }
+
+  const int fd = batt::syscall_retry([&] {
+    return ::open(options.pressure_file.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  });
+  BATT_REQUIRE_OK(batt::status_from_retval(fd));
+
+  // The trigger must be written in a single write call; it stays installed until the fd is closed.
+  //
+  const std::string trigger =
+      batt::to_string("some ", options.stall_threshold_usec, " ", options.window_usec);
+
+  const ssize_t n_written = batt::syscall_retry([&] {
+    return ::write(fd, trigger.c_str(), trigger.size() + 1);
+  });
+  if (n_written < 0) {
+    const Status status = batt::status_from_retval(n_written);
+    ::close(fd);
+    LLFS_LOG_WARNING() << "Failed to install PSI trigger;" << BATT_INSPECT(options.pressure_file)
+                       << BATT_INSPECT(trigger) << BATT_INSPECT(status);
+    return status;
+  }
+
+  return std::unique_ptr<MemoryPressureMonitor>{
+      new MemoryPressureMonitor{cache, options, fd, target_bytes}};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ MemoryPressureMonitor::MemoryPressureMonitor(PageCache& cache, const Options& options,
+                                                          int fd, u64 target_bytes) noexcept
+    : cache_{cache}
+    , options_{options}
+    , fd_{fd}
+    , target_bytes_{target_bytes}
+{
+  const auto metric_name = [](std::string_view property) {
+    return batt::to_string("MemoryPressure_", property);
+  };
+
+#define ADD_METRIC_(n) global_metric_registry().add(metric_name(#n), this->metrics_.n)
+
+  ADD_METRIC_(pressure_event_count);
+  ADD_METRIC_(shrink_count);
+  ADD_METRIC_(grow_count);
+
+#undef ADD_METRIC_
+
+  this->thread_ = std::thread{[this] {
+    this->run();
+  }};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+MemoryPressureMonitor::~MemoryPressureMonitor() noexcept
+{
+  this->halt();
+  this->join();
+
+  ::close(this->fd_);
+
+  global_metric_registry()  //
+      .remove(this->metrics_.pressure_event_count)
+      .remove(this->metrics_.shrink_count)
+      .remove(this->metrics_.grow_count);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MemoryPressureMonitor::halt()
+{
+  this->halt_requested_.store(true);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MemoryPressureMonitor::join()
+{
+  if (this->thread_.joinable()) {
+    this->thread_.join();
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MemoryPressureMonitor::run()
+{
+  using Clock = std::chrono::steady_clock;
+
+  const auto regrow_delay = std::chrono::microseconds{this->options_.regrow_delay_usec};
+
+  Clock::time_point last_change = Clock::now();
+
+  const auto resize = [&](u64 new_bytes, CountMetric<u64>& counter) {
+    const u64 old_bytes = this->cache_.cache_bytes_limit();
+    if (new_bytes == old_bytes) {
+      return;
+    }
+    Status status = this->cache_.resize_cache(new_bytes);
+    if (!status.ok()) {
+      LLFS_LOG_WARNING() << "MemoryPressureMonitor: resize failed;" << BATT_INSPECT(status)
+                         << BATT_INSPECT(old_bytes) << BATT_INSPECT(new_bytes);
+      return;
+    }
+    counter.add(1);
+    LLFS_VLOG(1) << "MemoryPressureMonitor: resized cache;" << BATT_INSPECT(old_bytes)
+                 << BATT_INSPECT(new_bytes);
+  };
+
+  while (!this->halt_requested_.load()) {
+    pollfd pfd{.fd = this->fd_, .events = POLLPRI, .revents = 0};
+
+    const int n_ready = ::poll(&pfd, 1, kPollIntervalMsec);
+    if (n_ready < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LLFS_LOG_ERROR() << "MemoryPressureMonitor: poll failed; " << std::strerror(errno);
+      break;
+    }
+
+    if (n_ready > 0) {
+      if (pfd.revents & POLLERR) {
+        // The cgroup went away.
+        //
+        LLFS_LOG_WARNING() << "MemoryPressureMonitor: PSI file closed by the kernel;"
+                           << BATT_INSPECT(this->options_.pressure_file);
+        break;
+      }
+      if (pfd.revents & POLLPRI) {
+        this->metrics_.pressure_event_count.add(1);
+        resize(shrunk_cache_bytes(this->cache_.cache_bytes_limit(), this->options_),
+               this->metrics_.shrink_count);
+        last_change = Clock::now();
+      }
+      continue;
+    }
+
+    if (Clock::now() - last_change >= regrow_delay) {
+      resize(grown_cache_bytes(this->cache_.cache_bytes_limit(), this->target_bytes_,
+                               this->options_),
+             this->metrics_.grow_count);
+      last_change = Clock::now();
+    }
+  }
+}
+
+}  // namespace llfs
@@ -0,0 +1,159 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_MEMORY_PRESSURE_MONITOR_HPP
+#define LLFS_MEMORY_PRESSURE_MONITOR_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/metrics.hpp>
+#include <llfs/status.hpp>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace llfs {
+
+class PageCache;
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Shrinks a PageCache (see PageCache::resize_cache) when the kernel reports memory
+ * pressure, and grows it back once the pressure has gone away.
+ *
+ * Pressure is detected with a Linux pressure stall information (PSI) trigger: the monitor writes
+ * "some <stall_threshold_usec> <window_usec>" to a memory.pressure file and waits (on a dedicated
+ * thread, since poll blocks) for the kernel to signal that tasks in the cgroup stalled on memory
+ * for at least that long within one window.  Each such event shrinks the cache by
+ * `Options::shrink_factor`, down to `Options::min_cache_bytes`.  After `Options::regrow_delay_usec`
+ * without an event, the cache grows by `Options::grow_factor` (per quiet period), up to the size it
+ * had when the monitor was started.
+ */
+class MemoryPressureMonitor
+{
+ public:
+  struct Options {
+    // The PSI file to watch; see default_pressure_file().
+    //
+    std::string pressure_file;
+
+    // A pressure event fires when tasks stall on memory for this long in one window.
+    //
+    i64 stall_threshold_usec;
+
+    // The PSI trigger window; the kernel requires 500ms..10s.
+    //
+    i64 window_usec;
+
+    // Each pressure event multiplies the cache size by this (0 < shrink_factor < 1).
+    //
+    double shrink_factor;
+
+    // Each quiet period multiplies the cache size by this (grow_factor > 1).
+    //
+    double grow_factor;
+
+    // The cache is never shrunk below this many bytes.
+    //
+    u64 min_cache_bytes;
+
+    // The time without pressure events before the cache grows again.
+    //
+    i64 regrow_delay_usec;
+
+    //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+    static Options with_default_values();
+  };
+
+  struct Metrics {
+    // PSI trigger events received.
+    //
+    CountMetric<u64> pressure_event_count{0};
+
+    // Times the cache was shrunk or grown.
+    //
+    CountMetric<u64> shrink_count{0};
+    CountMetric<u64> grow_count{0};
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Returns the memory.pressure file of the cgroup (v2) this process belongs to, or the
+   * system-wide /proc/pressure/memory if it can't be determined.
+   */
+  static std::string default_pressure_file();
+
+  /** \brief Returns the cache size after a pressure event, given the current size.
+   */
+  static u64 shrunk_cache_bytes(u64 current_bytes, const Options& options);
+
+  /** \brief Returns the cache size after a quiet period, given the current size and the size the
+   * cache had when monitoring started.
+   */
+  static u64 grown_cache_bytes(u64 current_bytes, u64 target_bytes, const Options& options);
+
+  /** \brief Installs the PSI trigger and starts monitoring; the cache must have a byte budget (see
+   * PageCacheOptions::max_cache_bytes), whose current value is the size the monitor grows back to.
+   *
+   * Returns an error if the cache has no byte budget, or if the trigger can't be set up (e.g.,
+   * because the kernel doesn't support PSI, or the file isn't writable).
+   */
+  static StatusOr<std::unique_ptr<MemoryPressureMonitor>> start(PageCache& cache,
+                                                                const Options& options);
+
+  MemoryPressureMonitor(const MemoryPressureMonitor&) = delete;
+  MemoryPressureMonitor& operator=(const MemoryPressureMonitor&) = delete;
+
+  /** \brief Halts and joins the monitor thread, and closes the PSI file.
+   */
+  ~MemoryPressureMonitor() noexcept;
+
+  const Metrics& metrics() const noexcept
+  {
+    return this->metrics_;
+  }
+
+  /** \brief Tells the monitor thread to stop; it notices within one poll interval.
+   */
+  void halt();
+
+  /** \brief Waits for the monitor thread to stop; `halt()` must have been called first.
+   */
+  void join();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  // How often the monitor thread wakes up (even without events) to check for halt and regrowth.
+  //
+  static constexpr int kPollIntervalMsec = 100;
+
+  explicit MemoryPressureMonitor(PageCache& cache, const Options& options, int fd,
+                                 u64 target_bytes) noexcept;
+
+  // The body of the monitor thread.
+  //
+  void run();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  PageCache& cache_;
+  const Options options_;
+  const int fd_;
+  const u64 target_bytes_;
+  Metrics metrics_;
+  std::atomic<bool> halt_requested_{false};
+  std::thread thread_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_MEMORY_PRESSURE_MONITOR_HPP
@@ -0,0 +1,93 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/memory_pressure_monitor.hpp>
+//
+#include <llfs/memory_pressure_monitor.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/memory_page_cache.hpp>
+#include <llfs/page_cache.hpp>
+
+#include <batteries/async/runtime.hpp>
+
+namespace {
+
+// Test Plan:
+//  1. shrunk_cache_bytes scales the size down by shrink_factor, but never below min_cache_bytes
+//     (or above the current size).
+//  2. grown_cache_bytes scales the size up by grow_factor until it reaches the target.
+//  3. start fails with kFailedPrecondition if the cache has no byte budget (and resize_cache fails
+//     the same way).
+
+using namespace llfs::int_types;
+
+using llfs::MemoryPressureMonitor;
+
+MemoryPressureMonitor::Options test_options()
+{
+  MemoryPressureMonitor::Options options = MemoryPressureMonitor::Options::with_default_values();
+  options.shrink_factor = 0.5;
+  options.grow_factor = 2.0;
+  options.min_cache_bytes = 1000;
+  return options;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Test Plan (1)
+//
+TEST(MemoryPressureMonitorTest, Shrink)
+{
+  const MemoryPressureMonitor::Options options = test_options();
+
+  EXPECT_EQ(MemoryPressureMonitor::shrunk_cache_bytes(8000, options), 4000u);
+  EXPECT_EQ(MemoryPressureMonitor::shrunk_cache_bytes(1500, options), 1000u);
+  EXPECT_EQ(MemoryPressureMonitor::shrunk_cache_bytes(1000, options), 1000u);
+  EXPECT_EQ(MemoryPressureMonitor::shrunk_cache_bytes(500, options), 500u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Test Plan (2)
+//
+TEST(MemoryPressureMonitorTest, Grow)
+{
+  const MemoryPressureMonitor::Options options = test_options();
+
+  EXPECT_EQ(MemoryPressureMonitor::grown_cache_bytes(1000, /*target_bytes=*/8000, options), 2000u);
+  EXPECT_EQ(MemoryPressureMonitor::grown_cache_bytes(5000, /*target_bytes=*/8000, options), 8000u);
+  EXPECT_EQ(MemoryPressureMonitor::grown_cache_bytes(8000, /*target_bytes=*/8000, options), 8000u);
+  EXPECT_EQ(MemoryPressureMonitor::grown_cache_bytes(9000, /*target_bytes=*/8000, options), 9000u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Test Plan (3)
+//
+TEST(MemoryPressureMonitorTest, RequiresByteBudget)
+{
+  llfs::StatusOr<batt::SharedPtr<llfs::PageCache>> page_cache =
+      llfs::make_memory_page_cache(batt::Runtime::instance().default_scheduler(),
+                                   /*arena_sizes=*/
+                                   {
+                                       {llfs::PageCount{16}, llfs::PageSize{4096}},
+                                   },
+                                   llfs::MaxRefsPerPage{0});
+
+  ASSERT_TRUE(page_cache.ok()) << BATT_INSPECT(page_cache.status());
+
+  EXPECT_EQ((*page_cache)->cache_bytes_limit(), 0u);
+  EXPECT_EQ((*page_cache)->resize_cache(4096), batt::StatusCode::kFailedPrecondition);
+
+  llfs::StatusOr<std::unique_ptr<MemoryPressureMonitor>> monitor =
+      MemoryPressureMonitor::start(**page_cache, test_options());
+
+  EXPECT_EQ(monitor.status(), batt::StatusCode::kFailedPrecondition);
+}
+
+}  // namespace
@@ -0,0 +1,83 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/metrics.hpp>
+//
+
+#include <batteries/stream_util.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize striped_metric_thread_index() noexcept
+{
+  static std::atomic<usize> next_index{0};
+  thread_local const usize index = next_index.fetch_add(1);
+
+  return index;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 LatencyHistogram::quantile_upper_bound_usec(double q) const noexcept
+{
+  std::array<u64, kNumBuckets> counts;
+  u64 total = 0;
+  for (usize i = 0; i < kNumBuckets; ++i) {
+    counts[i] = this->buckets_[i].load();
+    total += counts[i];
+  }
+  if (total == 0) {
+    return 0;
+  }
+
+  // The (1-based) rank of the sample we are looking for.
+  //
+  const u64 rank = std::max<u64>(1, static_cast<u64>(std::ceil(std::clamp(q, 0.0, 1.0) * total)));
+
+  u64 seen = 0;
+  for (usize i = 0; i < kNumBuckets; ++i) {
+    seen += counts[i];
+    if (seen >= rank) {
+      return u64{1} << i;
+    }
+  }
+  return u64{1} << (kNumBuckets - 1);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void LatencyHistogram::add_to_registry(batt::MetricRegistry& registry, std::string_view name)
+{
+  registry.add(name, this->latency_);
+
+  for (usize i = 0; i < kNumBuckets; ++i) {
+    if (i + 1 < kNumBuckets) {
+      registry.add(batt::to_string(name, "_lt_", u64{1} << i, "us"), this->buckets_[i]);
+    } else {
+      registry.add(batt::to_string(name, "_lt_inf"), this->buckets_[i]);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void LatencyHistogram::remove_from_registry(batt::MetricRegistry& registry)
+{
+  registry.remove(this->latency_);
+
+  for (CountMetric<u64>& bucket : this->buckets_) {
+    registry.remove(bucket);
+  }
+}
+
+}  // namespace llfs
@@ -10,12 +10,22 @@
 #ifndef LLFS_METRICS_HPP
 #define LLFS_METRICS_HPP
 
+#include <llfs/int_types.hpp>
+
+#include <batteries/cpu_align.hpp>
 #include <batteries/metrics/metric_collectors.hpp>
 #include <batteries/metrics/metric_registry.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string_view>
+
 namespace llfs {
 
 using ::batt::CountMetric;
+using ::batt::GaugeMetric;
 using ::batt::global_metric_registry;
 using ::batt::LatencyMetric;
 using ::batt::LatencyTimer;
@@ -23,6 +33,208 @@ using ::batt::LatencyTimer;
 #define LLFS_COLLECT_LATENCY BATT_COLLECT_LATENCY
 #define LLFS_COLLECT_LATENCY_N BATT_COLLECT_LATENCY_N
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A LatencyMetric plus a histogram of the individual samples, bucketed by powers of two
+ * (in microseconds).
+ *
+ * Bucket 0 counts samples under 1 usec; bucket i (0 < i < kNumBuckets - 1) counts samples in the
+ * range [2^(i-1), 2^i) usec; the last bucket counts everything else.
+ */
+class LatencyHistogram
+{
+ public:
+  static constexpr usize kNumBuckets = 26;
+
+  /** \brief Returns the bucket index for a sample of `usec` microseconds.
+   */
+  static usize bucket_from_usec(u64 usec) noexcept
+  {
+    if (usec == 0) {
+      return 0;
+    }
+    return std::min<usize>(kNumBuckets - 1, 64 - __builtin_clzll(usec));
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  LatencyHistogram() = default;
+
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  /** \brief Records the time elapsed since `start`.
+   */
+  void update(std::chrono::steady_clock::time_point start) noexcept
+  {
+    this->update(std::chrono::steady_clock::now() - start);
+  }
+
+  /** \brief Records a sample of the given duration.
+   */
+  void update(std::chrono::steady_clock::duration elapsed) noexcept
+  {
+    this->latency_.update(elapsed);
+
+    const auto usec = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    this->buckets_[bucket_from_usec(usec < 0 ? 0 : static_cast<u64>(usec))].add(1);
+  }
+
+  /** \brief The total count and latency of all samples.
+   */
+  const LatencyMetric& latency() const noexcept
+  {
+    return this->latency_;
+  }
+
+  /** \brief The number of samples in bucket `i`.
+   */
+  u64 bucket_count(usize i) const noexcept
+  {
+    return this->buckets_[i].load();
+  }
+
+  /** \brief Returns an upper bound (in microseconds) on the `q`-quantile (0 <= q <= 1) of the
+   * samples recorded so far: the exclusive upper limit of the bucket that contains it, so the
+   * estimate is within a factor of 2.  Samples in the last bucket are treated as being in
+   * [2^(kNumBuckets-2), 2^(kNumBuckets-1)) usec.  Returns 0 if there are no samples.
+   */
+  u64 quantile_upper_bound_usec(double q) const noexcept;
+
+  /** \brief Registers the total latency as `name` and each bucket as `name`_lt_<N>us (or
+   * `name`_lt_inf).
+   */
+  void add_to_registry(batt::MetricRegistry& registry, std::string_view name);
+
+  /** \brief Removes all metrics added by `add_to_registry`.
+   */
+  void remove_from_registry(batt::MetricRegistry& registry);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  LatencyMetric latency_;
+  std::array<CountMetric<u64>, kNumBuckets> buckets_;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Selects roughly one out of every `sample_rate` events (per thread) for latency
+ * collection, so that instrumentation can stay on hot paths.  A sample rate of 0 disables
+ * sampling; 1 samples every event.
+ */
+class LatencySampler
+{
+ public:
+  explicit LatencySampler(u32 sample_rate) noexcept : sample_rate_{sample_rate}
+  {
+  }
+
+  u32 sample_rate() const noexcept
+  {
+    return this->sample_rate_.load(std::memory_order_relaxed);
+  }
+
+  void set_sample_rate(u32 sample_rate) noexcept
+  {
+    this->sample_rate_.store(sample_rate, std::memory_order_relaxed);
+  }
+
+  /** \brief Returns true if the current event should be timed.
+   */
+  bool sample() const noexcept
+  {
+    const u32 rate = this->sample_rate();
+    if (rate <= 1) {
+      return rate == 1;
+    }
+    thread_local u32 counter = 0;
+    return (++counter % rate) == 0;
+  }
+
+ private:
+  std::atomic<u32> sample_rate_;
+};
+
+/** \brief Returns a small integer that identifies the calling thread, assigned in order of first
+ * use; used to pick a stripe in StripedCountMetric.
+ */
+usize striped_metric_thread_index() noexcept;
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A counter that many threads can update concurrently without fighting over a single
+ * cache line.
+ *
+ * Each update goes to one of `kNumStripes` cache-line-isolated atomics, chosen by the calling
+ * thread (see LRUClock::LocalCounter for the same idea applied to logical time stamps).  Once a
+ * stripe has accumulated `kPublishInterval` or more, the updating thread moves its value into a
+ * single shared CountMetric, which is what gets exported through the MetricRegistry; so exported
+ * values lag the true count by less than `kNumStripes * kPublishInterval`.  `load()` adds up all
+ * the stripes, so it is exact whenever no updates are in progress.
+ */
+template <typename T>
+class StripedCountMetric
+{
+ public:
+  static constexpr usize kNumStripes = 32;
+  static constexpr T kPublishInterval = 64;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  StripedCountMetric() = default;
+
+  StripedCountMetric(const StripedCountMetric&) = delete;
+  StripedCountMetric& operator=(const StripedCountMetric&) = delete;
+
+  void add(T delta) noexcept
+  {
+    std::atomic<T>& stripe = *this->stripes_[striped_metric_thread_index() % kNumStripes];
+
+    if (stripe.fetch_add(delta, std::memory_order_relaxed) + delta >= kPublishInterval) {
+      this->published_.add(stripe.exchange(0, std::memory_order_relaxed));
+    }
+  }
+
+  StripedCountMetric& operator++() noexcept
+  {
+    this->add(1);
+    return *this;
+  }
+
+  StripedCountMetric& operator+=(T delta) noexcept
+  {
+    this->add(delta);
+    return *this;
+  }
+
+  /** \brief Returns the current total.
+   */
+  T load() const noexcept
+  {
+    T total = this->published_.load();
+    for (const batt::CpuCacheLineIsolated<std::atomic<T>>& stripe : this->stripes_) {
+      total += stripe->load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  /** \brief Registers the (periodically published) total as `name`.
+   */
+  void add_to_registry(batt::MetricRegistry& registry, std::string_view name)
+  {
+    registry.add(name, this->published_);
+  }
+
+  /** \brief Removes the metric added by `add_to_registry`.
+   */
+  void remove_from_registry(batt::MetricRegistry& registry)
+  {
+    registry.remove(this->published_);
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  std::array<batt::CpuCacheLineIsolated<std::atomic<T>>, kNumStripes> stripes_{};
+  CountMetric<T> published_{0};
+};
+
 }  // namespace llfs
 
 #endif  // LLFS_METRICS_HPP
@@ -0,0 +1,214 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/metrics.hpp>
+//
+#include <llfs/metrics.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/fuse_metrics.hpp>
+#include <llfs/log_append_metrics.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//
+//  1. LatencyHistogram::bucket_from_usec maps samples to power-of-two buckets, saturating at the
+//     last bucket.
+//  2. LatencyHistogram::update records both the total latency and the bucket counts.
+//  3. LatencySampler selects every N-th event for rate N; rate 0 selects none.
+//  4. LogAppendMetrics is a single global instance.
+//  5. FuseMetrics is a single global instance, with separate metrics for each opcode.
+//  6. StripedCountMetric::load is exact after concurrent updates from many threads, and each
+//     thread gets its own stripe index.
+//  7. LatencyHistogram::quantile_upper_bound_usec returns the upper limit of the bucket holding
+//     the requested quantile (0 if there are no samples).
+//
+
+using namespace llfs::int_types;
+
+using llfs::LatencyHistogram;
+using llfs::LatencySampler;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  1. bucket_from_usec maps samples to power-of-two buckets.
+//
+TEST(LatencyHistogramTest, BucketFromUsec)
+{
+  EXPECT_EQ(LatencyHistogram::bucket_from_usec(0), 0u);
+  EXPECT_EQ(LatencyHistogram::bucket_from_usec(1), 1u);
+  EXPECT_EQ(LatencyHistogram::bucket_from_usec(2), 2u);
+  EXPECT_EQ(LatencyHistogram::bucket_from_usec(3), 2u);
+  EXPECT_EQ(LatencyHistogram::bucket_from_usec(4), 3u);
+  EXPECT_EQ(LatencyHistogram::bucket_from_usec(1023), 10u);
+  EXPECT_EQ(LatencyHistogram::bucket_from_usec(1024), 11u);
+  EXPECT_EQ(LatencyHistogram::bucket_from_usec(u64{1} << 40), LatencyHistogram::kNumBuckets - 1);
+  EXPECT_EQ(LatencyHistogram::bucket_from_usec(~u64{0}), LatencyHistogram::kNumBuckets - 1);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  2. update records both the total latency and the bucket counts.
+//
+TEST(LatencyHistogramTest, Update)
+{
+  LatencyHistogram histogram;
+
+  histogram.update(std::chrono::microseconds(0));
+  histogram.update(std::chrono::microseconds(5));
+  histogram.update(std::chrono::microseconds(6));
+  histogram.update(std::chrono::seconds(1000));
+
+  EXPECT_EQ(histogram.latency().count.load(), 4u);
+  EXPECT_EQ(histogram.latency().total_usec.load(), 1000u * 1000 * 1000 + 11);
+
+  EXPECT_EQ(histogram.bucket_count(0), 1u);
+  EXPECT_EQ(histogram.bucket_count(3), 2u);
+  EXPECT_EQ(histogram.bucket_count(LatencyHistogram::kNumBuckets - 1), 1u);
+
+  u64 total = 0;
+  for (usize i = 0; i < LatencyHistogram::kNumBuckets; ++i) {
+    total += histogram.bucket_count(i);
+  }
+  EXPECT_EQ(total, 4u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  3. LatencySampler selects every N-th event for rate N; rate 0 selects none.
+//
+TEST(LatencySamplerTest, SampleRate)
+{
+  for (u32 rate : {0u, 1u, 2u, 7u}) {
+    LatencySampler sampler{rate};
+    EXPECT_EQ(sampler.sample_rate(), rate);
+
+    usize sampled = 0;
+    for (usize i = 0; i < 70; ++i) {
+      if (sampler.sample()) {
+        ++sampled;
+      }
+    }
+    EXPECT_EQ(sampled, (rate == 0) ? 0u : 70 / rate) << BATT_INSPECT(rate);
+  }
+
+  LatencySampler sampler{0};
+  sampler.set_sample_rate(1);
+  EXPECT_TRUE(sampler.sample());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  4. LogAppendMetrics is a single global instance.
+//
+TEST(LogAppendMetricsTest, GlobalInstance)
+{
+  llfs::LogAppendMetrics& metrics = llfs::LogAppendMetrics::instance();
+
+  EXPECT_EQ(&metrics, &llfs::LogAppendMetrics::instance());
+
+  const u64 count_before = metrics.commit_latency.latency().count.load();
+  metrics.commit_latency.update(std::chrono::microseconds(3));
+
+  EXPECT_EQ(llfs::LogAppendMetrics::instance().commit_latency.latency().count.load(),
+            count_before + 1);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  5. FuseMetrics is a single global instance, with separate metrics for each opcode.
+//  6. StripedCountMetric::load is exact after concurrent updates from many threads, and each
+//     thread gets its own stripe index.
+//  7. LatencyHistogram::quantile_upper_bound_usec returns the upper limit of the bucket holding
+//     the requested quantile (0 if there are no samples).
+//
+TEST(FuseMetricsTest, GlobalInstance)
+{
+  llfs::FuseMetrics& metrics = llfs::FuseMetrics::instance();
+
+  EXPECT_EQ(&metrics, &llfs::FuseMetrics::instance());
+  EXPECT_NE(&metrics.op(llfs::FuseOpcode::kLookup), &metrics.op(llfs::FuseOpcode::kReaddirplus));
+
+  EXPECT_EQ(llfs::fuse_opcode_name(llfs::FuseOpcode::kLookup), "lookup");
+  EXPECT_EQ(llfs::fuse_opcode_name(llfs::FuseOpcode::kGetAttributes), "get_attributes");
+  EXPECT_EQ(llfs::fuse_opcode_name(llfs::FuseOpcode::kReaddirplus), "readdirplus");
+
+  llfs::LatencyHistogram& read_latency = metrics.op(llfs::FuseOpcode::kRead).handler_latency;
+
+  const u64 count_before = read_latency.latency().count.load();
+  read_latency.update(std::chrono::microseconds(5));
+
+  EXPECT_EQ(read_latency.latency().count.load(), count_before + 1);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(StripedCountMetricTest, ConcurrentAdd)
+{
+  constexpr usize kNumThreads = 8;
+  constexpr u64 kAddsPerThread = 100000;
+
+  llfs::StripedCountMetric<u64> metric;
+  EXPECT_EQ(metric.load(), 0u);
+
+  std::vector<usize> thread_index(kNumThreads);
+  std::vector<std::thread> threads;
+  for (usize thread_i = 0; thread_i < kNumThreads; ++thread_i) {
+    threads.emplace_back([&metric, &thread_index, thread_i] {
+      thread_index[thread_i] = llfs::striped_metric_thread_index();
+      for (u64 i = 0; i < kAddsPerThread; ++i) {
+        ++metric;
+      }
+      metric += 3;
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+
+  EXPECT_EQ(metric.load(), kNumThreads * (kAddsPerThread + 3));
+
+  std::sort(thread_index.begin(), thread_index.end());
+  EXPECT_EQ(std::unique(thread_index.begin(), thread_index.end()), thread_index.end());
+  EXPECT_NE(thread_index[0], llfs::striped_metric_thread_index());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  7. quantile_upper_bound_usec returns the upper limit of the bucket holding the quantile.
+//
+TEST(LatencyHistogramTest, QuantileUpperBound)
+{
+  LatencyHistogram histogram;
+
+  EXPECT_EQ(histogram.quantile_upper_bound_usec(0.95), 0u);
+
+  // 95 samples of 5us (bucket [4, 8)) and 5 samples of 1000us (bucket [512, 1024)).
+  //
+  for (int i = 0; i < 95; ++i) {
+    histogram.update(std::chrono::microseconds(5));
+  }
+  for (int i = 0; i < 5; ++i) {
+    histogram.update(std::chrono::microseconds(1000));
+  }
+
+  EXPECT_EQ(histogram.quantile_upper_bound_usec(0.0), 8u);
+  EXPECT_EQ(histogram.quantile_upper_bound_usec(0.5), 8u);
+  EXPECT_EQ(histogram.quantile_upper_bound_usec(0.9), 8u);
+  EXPECT_EQ(histogram.quantile_upper_bound_usec(0.99), 1024u);
+  EXPECT_EQ(histogram.quantile_upper_bound_usec(1.0), 1024u);
+
+  histogram.update(std::chrono::seconds(1000));
+
+  EXPECT_EQ(histogram.quantile_upper_bound_usec(1.0),
+            u64{1} << (LatencyHistogram::kNumBuckets - 1));
+}
+
+}  // namespace
@@ -0,0 +1,328 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/mirrored_page_device.hpp>
+//
+
+#include <llfs/logging.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/utility.hpp>
+
+#include <boost/asio/steady_timer.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief The state of one (possibly hedged) read.
+ */
+struct MirroredPageDevice::ReadState {
+  explicit ReadState(PageId page_id, ReadHandler&& handler,
+                     const boost::asio::any_io_executor& executor) noexcept
+      : page_id{page_id}
+      , handler{std::move(handler)}
+      , timer{executor}
+  {
+  }
+
+  const PageId page_id;
+
+  /** \brief Protects all the fields below.
+   */
+  std::mutex mutex;
+
+  /** \brief The caller's handler; set to nullptr once it has been (or is about to be) invoked.
+   */
+  ReadHandler handler;
+
+  /** \brief Fires when it is time to send the backup read.
+   */
+  boost::asio::steady_timer timer;
+
+  /** \brief The replica the read was sent to first.
+   */
+  usize first_replica = 0;
+
+  /** \brief Whether the read has been sent to each replica, and when.
+   */
+  std::array<bool, kNumReplicas> started{};
+  std::array<std::chrono::steady_clock::time_point, kNumReplicas> start_time{};
+
+  /** \brief The number of replica reads that have been started but not finished.
+   */
+  usize pending_count = 0;
+
+  /** \brief The first error returned by a replica, if any.
+   */
+  Status first_error;
+};
+
+namespace {
+
+/** \brief Joins the completions of the same write (or drop) on every replica.
+ */
+struct JoinState {
+  explicit JoinState(PageDevice::WriteHandler&& handler) noexcept : handler{std::move(handler)}
+  {
+  }
+
+  void finish(Status status)
+  {
+    {
+      std::unique_lock<std::mutex> lock{this->mutex};
+      this->status.Update(status);
+    }
+    if (this->pending_count.fetch_sub(1) == 1) {
+      this->handler(this->status);
+    }
+  }
+
+  PageDevice::WriteHandler handler;
+  std::atomic<usize> pending_count{MirroredPageDevice::kNumReplicas};
+  std::mutex mutex;
+  Status status;
+};
+
+}  // namespace
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class MirroredPageDevice
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ MirroredPageDevice::MirroredPageDevice(
+    batt::TaskScheduler& scheduler, std::unique_ptr<PageDevice> primary,
+    std::unique_ptr<PageDevice> secondary, const MirroredPageDeviceOptions& options) noexcept
+    : scheduler_{scheduler}
+    , replicas_{{std::move(primary), std::move(secondary)}}
+    , options_{options}
+{
+  BATT_CHECK_NOT_NULLPTR(this->replicas_[0]);
+  BATT_CHECK_NOT_NULLPTR(this->replicas_[1]);
+  BATT_CHECK(this->replicas_[0]->page_ids() == this->replicas_[1]->page_ids())
+      << "both replicas must use the same PageIds";
+  BATT_CHECK_EQ(this->replicas_[0]->page_size(), this->replicas_[1]->page_size());
+  BATT_CHECK_LE(this->options_.min_hedge_delay, this->options_.max_hedge_delay);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageIdFactory MirroredPageDevice::page_ids()
+{
+  return this->replicas_[0]->page_ids();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageSize MirroredPageDevice::page_size()
+{
+  return this->replicas_[0]->page_size();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::shared_ptr<PageBuffer>> MirroredPageDevice::prepare(PageId page_id)
+{
+  return this->replicas_[0]->prepare(page_id);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MirroredPageDevice::write(std::shared_ptr<const PageBuffer>&& page_buffer,
+                               WriteHandler&& handler)
+{
+  BATT_CHECK_NOT_NULLPTR(page_buffer);
+
+  auto state = std::make_shared<JoinState>(std::move(handler));
+
+  this->replicas_[0]->write(batt::make_copy(page_buffer), [state](Status status) {
+    state->finish(status);
+  });
+  this->replicas_[1]->write(std::move(page_buffer), [state](Status status) {
+    state->finish(status);
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MirroredPageDevice::drop(PageId page_id, WriteHandler&& handler)
+{
+  auto state = std::make_shared<JoinState>(std::move(handler));
+
+  for (const std::unique_ptr<PageDevice>& replica : this->replicas_) {
+    replica->drop(page_id, [state](Status status) {
+      state->finish(status);
+    });
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MirroredPageDevice::read(PageId page_id, ReadHandler&& handler)
+{
+  auto state =
+      std::make_shared<ReadState>(page_id, std::move(handler), this->scheduler_.schedule_task());
+
+  const usize first = this->preferred_replica();
+  {
+    std::unique_lock<std::mutex> lock{state->mutex};
+
+    state->first_replica = first;
+    state->timer.expires_after(this->hedge_delay(first));
+    state->timer.async_wait([this, state](const boost::system::error_code& ec) {
+      if (!ec) {
+        this->on_hedge_timer(state);
+      }
+    });
+  }
+
+  this->start_replica_read(state, first);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize MirroredPageDevice::preferred_replica() const noexcept
+{
+  // A replica with no samples yet is tried first, so that it starts collecting them.
+  //
+  std::array<u64, kNumReplicas> total_usec;
+  std::array<u64, kNumReplicas> count;
+  for (usize i = 0; i < kNumReplicas; ++i) {
+    const LatencyMetric& latency = this->metrics_.read_latency[i].latency();
+    total_usec[i] = latency.total_usec.load();
+    count[i] = latency.count.load();
+    if (count[i] == 0) {
+      return i;
+    }
+  }
+
+  const double mean0 = double(total_usec[0]) / double(count[0]);
+  const double mean1 = double(total_usec[1]) / double(count[1]);
+
+  return (mean1 < mean0) ? 1 : 0;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::chrono::microseconds MirroredPageDevice::hedge_delay(usize i) const noexcept
+{
+  const LatencyHistogram& histogram = this->metrics_.read_latency[i];
+
+  if (histogram.latency().count.load() < this->options_.min_latency_samples) {
+    return this->options_.max_hedge_delay;
+  }
+
+  const std::chrono::microseconds observed{
+      histogram.quantile_upper_bound_usec(this->options_.hedge_quantile)};
+
+  return std::clamp(observed, this->options_.min_hedge_delay, this->options_.max_hedge_delay);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MirroredPageDevice::start_replica_read(const std::shared_ptr<ReadState>& state, usize i)
+{
+  {
+    std::unique_lock<std::mutex> lock{state->mutex};
+
+    if (!state->handler || state->started[i]) {
+      return;
+    }
+    state->started[i] = true;
+    state->start_time[i] = std::chrono::steady_clock::now();
+    state->pending_count += 1;
+  }
+
+  LLFS_VLOG(1) << "MirroredPageDevice: reading " << state->page_id << " from replica " << i;
+
+  this->replicas_[i]->read(state->page_id, [this, state, i](ReadResult result) {
+    this->finish_replica_read(state, i, std::move(result));
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MirroredPageDevice::finish_replica_read(const std::shared_ptr<ReadState>& state, usize i,
+                                             ReadResult&& result)
+{
+  ReadHandler handler;
+  bool failover = false;
+  {
+    std::unique_lock<std::mutex> lock{state->mutex};
+
+    state->pending_count -= 1;
+
+    if (result.ok()) {
+      this->metrics_.read_latency[i].update(state->start_time[i]);
+    }
+
+    if (!state->handler) {
+      // The other replica already answered; discard this result.
+      //
+      return;
+    }
+
+    if (result.ok()) {
+      handler = std::exchange(state->handler, nullptr);
+      if (i != state->first_replica) {
+        this->metrics_.backup_win_count.add(1);
+      }
+    } else {
+      state->first_error.Update(result.status());
+
+      const usize other = kNumReplicas - 1 - i;
+      if (!state->started[other]) {
+        failover = true;
+      } else if (state->pending_count == 0) {
+        handler = std::exchange(state->handler, nullptr);
+        result = state->first_error;
+      } else {
+        // Wait for the other replica.
+        //
+        return;
+      }
+    }
+
+    // Either way, there is no need for a (further) backup read.
+    //
+    state->timer.cancel();
+  }
+
+  if (failover) {
+    this->metrics_.failover_count.add(1);
+    this->start_replica_read(state, kNumReplicas - 1 - i);
+    return;
+  }
+
+  handler(std::move(result));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MirroredPageDevice::on_hedge_timer(const std::shared_ptr<ReadState>& state)
+{
+  usize backup = 0;
+  {
+    std::unique_lock<std::mutex> lock{state->mutex};
+
+    backup = kNumReplicas - 1 - state->first_replica;
+    if (!state->handler || state->started[backup]) {
+      return;
+    }
+  }
+
+  this->metrics_.hedged_read_count.add(1);
+  this->start_replica_read(state, backup);
+}
+
+}  // namespace llfs
@@ -0,0 +1,159 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_MIRRORED_PAGE_DEVICE_HPP
+#define LLFS_MIRRORED_PAGE_DEVICE_HPP
+
+#include <llfs/int_types.hpp>
+#include <llfs/metrics.hpp>
+#include <llfs/page_device.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/async/task_scheduler.hpp>
+
+#include <array>
+#include <chrono>
+#include <memory>
+
+namespace llfs {
+
+struct MirroredPageDeviceOptions {
+  /** \brief The backup read is issued once the first one has been outstanding for longer than
+   * this quantile of the first replica's observed read latency.
+   */
+  double hedge_quantile = 0.95;
+
+  /** \brief Lower bound on the hedge delay, so that a very fast replica doesn't cause a backup
+   * read for every page.
+   */
+  std::chrono::microseconds min_hedge_delay{50};
+
+  /** \brief Upper bound on the hedge delay; also used until a replica has `min_latency_samples`
+   * samples.
+   */
+  std::chrono::microseconds max_hedge_delay{50 * 1000};
+
+  /** \brief The number of successful reads a replica must have before its latency distribution is
+   * used to set the hedge delay.
+   */
+  u64 min_latency_samples = 64;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A PageDevice that keeps a copy of every page on each of two replica devices, and serves
+ * each read from one replica, hedging with a backup read from the other if the first is slow.
+ *
+ * Both replicas must have the same `page_ids()` and `page_size()`.  Writes and drops go to both
+ * replicas and complete when both have completed (with the first error, if any).
+ *
+ * A read is first sent to the replica with the lower mean read latency.  If it hasn't completed
+ * after the hedge delay (that replica's `hedge_quantile` latency, clamped to
+ * [min_hedge_delay, max_hedge_delay]), the same read is sent to the other replica, and the first
+ * successful result is returned; if the first read fails, the other replica is tried right away.
+ * The losing read is not cancelled (PageDevice has no cancellation API): its result is discarded
+ * when it arrives, but its latency is still recorded.
+ */
+class MirroredPageDevice : public PageDevice
+{
+ public:
+  static constexpr usize kNumReplicas = 2;
+
+  struct Metrics {
+    /** \brief The read latency of each replica (successful reads only, including reads whose
+     * result was discarded).
+     */
+    std::array<LatencyHistogram, kNumReplicas> read_latency;
+
+    /** \brief The number of reads for which a backup read was issued because the first was slow.
+     */
+    CountMetric<u64> hedged_read_count{0};
+
+    /** \brief The number of hedged reads where the backup read finished first.
+     */
+    CountMetric<u64> backup_win_count{0};
+
+    /** \brief The number of reads retried on the other replica because the first one failed.
+     */
+    CountMetric<u64> failover_count{0};
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Creates a mirrored device; the hedge timers run on executors from `scheduler`.
+   */
+  explicit MirroredPageDevice(batt::TaskScheduler& scheduler, std::unique_ptr<PageDevice> primary,
+                              std::unique_ptr<PageDevice> secondary,
+                              const MirroredPageDeviceOptions& options = {}) noexcept;
+
+  //----- --- -- -  -  -   -
+  // PageDevice interface
+
+  PageIdFactory page_ids() override;
+
+  PageSize page_size() override;
+
+  StatusOr<std::shared_ptr<PageBuffer>> prepare(PageId page_id) override;
+
+  void write(std::shared_ptr<const PageBuffer>&& page_buffer, WriteHandler&& handler) override;
+
+  void read(PageId id, ReadHandler&& handler) override;
+
+  void drop(PageId id, WriteHandler&& handler) override;
+
+  //----- --- -- -  -  -   -
+
+  /** \brief Returns replica `i` (0 is the primary, 1 the secondary).
+   */
+  PageDevice& replica(usize i) const
+  {
+    return *this->replicas_[i];
+  }
+
+  const Metrics& metrics() const
+  {
+    return this->metrics_;
+  }
+
+  /** \brief Returns the replica to which the next read will be sent first.
+   */
+  usize preferred_replica() const noexcept;
+
+  /** \brief Returns how long a read sent to replica `i` may be outstanding before a backup read is
+   * sent to the other replica.
+   */
+  std::chrono::microseconds hedge_delay(usize i) const noexcept;
+
+ private:
+  struct ReadState;
+
+  /** \brief Sends the read for `state` to replica `i`, unless it has already been sent there or
+   * the read is already finished.
+   */
+  void start_replica_read(const std::shared_ptr<ReadState>& state, usize i);
+
+  /** \brief Called when the read for `state` from replica `i` completes.
+   */
+  void finish_replica_read(const std::shared_ptr<ReadState>& state, usize i, ReadResult&& result);
+
+  /** \brief Called when the hedge timer for `state` expires.
+   */
+  void on_hedge_timer(const std::shared_ptr<ReadState>& state);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  batt::TaskScheduler& scheduler_;
+  const std::array<std::unique_ptr<PageDevice>, kNumReplicas> replicas_;
+  const MirroredPageDeviceOptions options_;
+  Metrics metrics_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_MIRRORED_PAGE_DEVICE_HPP
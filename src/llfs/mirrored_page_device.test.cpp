@@ -0,0 +1,298 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/mirrored_page_device.hpp>
+//
+#include <llfs/mirrored_page_device.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/memory_page_device.hpp>
+#include <llfs/page_buffer.hpp>
+
+#include <batteries/async/runtime.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+using namespace llfs::int_types;
+
+// Test Plan:
+//  1. Writes and drops go to both replicas; reads return the page.
+//  2. If the first replica stalls, a backup read is sent to the other replica after the hedge
+//     delay, and its result is returned; the stalled read's result is discarded when it arrives.
+//  3. If the first replica fails, the read is retried on the other one right away.
+//  4. The hedge delay falls back to max_hedge_delay until there are enough samples, and then
+//     follows the observed latency, clamped to [min_hedge_delay, max_hedge_delay].
+
+constexpr u64 kPageSize = 4096;
+constexpr u64 kPageCount = 16;
+constexpr llfs::page_device_id_int kDeviceId = 3;
+
+/** \brief A MemoryPageDevice whose reads can be made to stall until released.
+ */
+class StallablePageDevice : public llfs::MemoryPageDevice
+{
+ public:
+  using llfs::MemoryPageDevice::MemoryPageDevice;
+
+  void read(llfs::PageId page_id, ReadHandler&& handler) override
+  {
+    {
+      std::unique_lock<std::mutex> lock{this->mutex_};
+      if (this->stalled_) {
+        this->stalled_reads_.emplace_back(page_id, std::move(handler));
+        return;
+      }
+    }
+    llfs::MemoryPageDevice::read(page_id, std::move(handler));
+  }
+
+  void stall()
+  {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+    this->stalled_ = true;
+  }
+
+  usize stalled_read_count()
+  {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+    return this->stalled_reads_.size();
+  }
+
+  void release()
+  {
+    std::vector<std::pair<llfs::PageId, ReadHandler>> reads;
+    {
+      std::unique_lock<std::mutex> lock{this->mutex_};
+      this->stalled_ = false;
+      std::swap(reads, this->stalled_reads_);
+    }
+    for (auto& [page_id, handler] : reads) {
+      llfs::MemoryPageDevice::read(page_id, std::move(handler));
+    }
+  }
+
+ private:
+  std::mutex mutex_;
+  bool stalled_ = false;
+  std::vector<std::pair<llfs::PageId, ReadHandler>> stalled_reads_;
+};
+
+class MirroredPageDeviceTest : public ::testing::Test
+{
+ public:
+  void create_device(const llfs::MirroredPageDeviceOptions& options)
+  {
+    auto primary = std::make_unique<StallablePageDevice>(kDeviceId, llfs::PageCount{kPageCount},
+                                                         llfs::PageSize{kPageSize});
+    auto secondary = std::make_unique<StallablePageDevice>(kDeviceId, llfs::PageCount{kPageCount},
+                                                           llfs::PageSize{kPageSize});
+    this->primary_ = primary.get();
+    this->secondary_ = secondary.get();
+
+    this->device_.emplace(batt::Runtime::instance().default_scheduler(), std::move(primary),
+                          std::move(secondary), options);
+  }
+
+  llfs::PageId page_id(usize physical_page) const
+  {
+    return llfs::PageIdFactory{llfs::PageCount{kPageCount}, kDeviceId}.make_page_id(physical_page,
+                                                                                   1);
+  }
+
+  llfs::Status write_page(llfs::PageDevice& device, llfs::PageId page_id)
+  {
+    llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer = device.prepare(page_id);
+    BATT_REQUIRE_OK(buffer);
+
+    llfs::MutableBuffer payload = (*buffer)->mutable_payload();
+    std::memset(payload.data(), static_cast<char>(page_id.int_value()), payload.size());
+
+    llfs::Status result;
+    device.write(std::move(*buffer), [&result](llfs::Status status) {
+      result = status;
+    });
+    return result;
+  }
+
+  // Starts a read, returning a future for its result; fails the test if the handler is called
+  // more than once.
+  //
+  std::future<llfs::PageDevice::ReadResult> start_read(llfs::PageDevice& device,
+                                                       llfs::PageId page_id)
+  {
+    auto promise = std::make_shared<std::promise<llfs::PageDevice::ReadResult>>();
+    auto call_count = std::make_shared<std::atomic<int>>(0);
+
+    std::future<llfs::PageDevice::ReadResult> future = promise->get_future();
+
+    device.read(page_id, [promise, call_count](llfs::PageDevice::ReadResult result) {
+      ASSERT_EQ(call_count->fetch_add(1), 0);
+      promise->set_value(std::move(result));
+    });
+
+    return future;
+  }
+
+  llfs::Status read_page(llfs::PageDevice& device, llfs::PageId page_id)
+  {
+    std::future<llfs::PageDevice::ReadResult> future = this->start_read(device, page_id);
+
+    if (future.wait_for(std::chrono::seconds(10)) != std::future_status::ready) {
+      return batt::StatusCode::kDeadlineExceeded;
+    }
+
+    llfs::PageDevice::ReadResult result = future.get();
+    BATT_REQUIRE_OK(result);
+
+    EXPECT_EQ((*result)->page_id(), page_id);
+    EXPECT_EQ(static_cast<const char*>((*result)->const_payload().data())[0],
+              static_cast<char>(page_id.int_value()));
+
+    return llfs::OkStatus();
+  }
+
+  llfs::Status drop_page(llfs::PageDevice& device, llfs::PageId page_id)
+  {
+    llfs::Status result;
+    device.drop(page_id, [&result](llfs::Status status) {
+      result = status;
+    });
+    return result;
+  }
+
+  StallablePageDevice* primary_ = nullptr;
+  StallablePageDevice* secondary_ = nullptr;
+  llfs::Optional<llfs::MirroredPageDevice> device_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST_F(MirroredPageDeviceTest, WriteReadDrop)
+{
+  this->create_device(llfs::MirroredPageDeviceOptions{});
+  llfs::MirroredPageDevice& device = *this->device_;
+
+  EXPECT_TRUE(device.page_ids() == this->primary_->page_ids());
+  EXPECT_EQ(device.page_size(), this->primary_->page_size());
+
+  for (usize i = 0; i < 4; ++i) {
+    ASSERT_TRUE(this->write_page(device, this->page_id(i)).ok());
+  }
+
+  for (usize i = 0; i < 4; ++i) {
+    EXPECT_TRUE(this->read_page(*this->primary_, this->page_id(i)).ok()) << BATT_INSPECT(i);
+    EXPECT_TRUE(this->read_page(*this->secondary_, this->page_id(i)).ok()) << BATT_INSPECT(i);
+    EXPECT_TRUE(this->read_page(device, this->page_id(i)).ok()) << BATT_INSPECT(i);
+  }
+
+  ASSERT_TRUE(this->drop_page(device, this->page_id(0)).ok());
+
+  EXPECT_EQ(this->read_page(*this->primary_, this->page_id(0)), batt::StatusCode::kNotFound);
+  EXPECT_EQ(this->read_page(*this->secondary_, this->page_id(0)), batt::StatusCode::kNotFound);
+  EXPECT_EQ(this->read_page(device, this->page_id(0)), batt::StatusCode::kNotFound);
+
+  EXPECT_EQ(device.metrics().hedged_read_count.load(), 0u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST_F(MirroredPageDeviceTest, HedgeStalledRead)
+{
+  this->create_device(llfs::MirroredPageDeviceOptions{
+      .min_hedge_delay = std::chrono::milliseconds(1),
+      .max_hedge_delay = std::chrono::milliseconds(1),
+  });
+  llfs::MirroredPageDevice& device = *this->device_;
+
+  ASSERT_TRUE(this->write_page(device, this->page_id(5)).ok());
+
+  const usize first = device.preferred_replica();
+  StallablePageDevice* const stalled = (first == 0) ? this->primary_ : this->secondary_;
+
+  stalled->stall();
+
+  EXPECT_TRUE(this->read_page(device, this->page_id(5)).ok());
+  EXPECT_EQ(stalled->stalled_read_count(), 1u);
+  EXPECT_EQ(device.metrics().hedged_read_count.load(), 1u);
+  EXPECT_EQ(device.metrics().backup_win_count.load(), 1u);
+
+  // The late result is discarded (start_read's handler checks it is only called once), but its
+  // latency is still recorded.
+  //
+  const u64 samples_before = device.metrics().read_latency[first].latency().count.load();
+  stalled->release();
+  EXPECT_EQ(device.metrics().read_latency[first].latency().count.load(), samples_before + 1);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 3.
+//
+TEST_F(MirroredPageDeviceTest, FailoverOnError)
+{
+  this->create_device(llfs::MirroredPageDeviceOptions{});
+  llfs::MirroredPageDevice& device = *this->device_;
+
+  ASSERT_TRUE(this->write_page(device, this->page_id(2)).ok());
+
+  // Remove the page from whichever replica will be asked first.
+  //
+  const usize first = device.preferred_replica();
+  ASSERT_TRUE(this->drop_page(device.replica(first), this->page_id(2)).ok());
+
+  EXPECT_TRUE(this->read_page(device, this->page_id(2)).ok());
+  EXPECT_EQ(device.metrics().failover_count.load(), 1u);
+  EXPECT_EQ(device.metrics().hedged_read_count.load(), 0u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 4.
+//
+TEST_F(MirroredPageDeviceTest, HedgeDelay)
+{
+  const llfs::MirroredPageDeviceOptions options{
+      .hedge_quantile = 0.95,
+      .min_hedge_delay = std::chrono::microseconds(2),
+      .max_hedge_delay = std::chrono::seconds(1),
+      .min_latency_samples = 8,
+  };
+  this->create_device(options);
+  llfs::MirroredPageDevice& device = *this->device_;
+
+  EXPECT_EQ(device.hedge_delay(0), options.max_hedge_delay);
+
+  ASSERT_TRUE(this->write_page(device, this->page_id(1)).ok());
+
+  // Reads from a MemoryPageDevice complete in far less than max_hedge_delay.
+  //
+  for (usize i = 0; i < 32; ++i) {
+    ASSERT_TRUE(this->read_page(device, this->page_id(1)).ok());
+  }
+
+  // Most of the reads went to one replica.
+  //
+  const auto sample_count = [&](usize i) {
+    return device.metrics().read_latency[i].latency().count.load();
+  };
+  const usize busiest = (sample_count(0) >= sample_count(1)) ? 0 : 1;
+
+  EXPECT_GE(sample_count(busiest), options.min_latency_samples);
+  EXPECT_LT(device.hedge_delay(busiest), options.max_hedge_delay);
+  EXPECT_GE(device.hedge_delay(busiest), options.min_hedge_delay);
+}
+
+}  // namespace
@@ -0,0 +1,270 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/mmap_page_device.hpp>
+//
+
+#include <llfs/filesystem.hpp>
+#include <llfs/logging.hpp>
+#include <llfs/packed_page_header.hpp>
+#include <llfs/page_buffer.hpp>
+#include <llfs/status_code.hpp>
+#include <llfs/system_config.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/checked_cast.hpp>
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cerrno>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+//
+class MmapPageDevice::Mapping
+{
+ public:
+  explicit Mapping(const void* data, usize size) noexcept : data_{data}, size_{size}
+  {
+  }
+
+  Mapping(const Mapping&) = delete;
+  Mapping& operator=(const Mapping&) = delete;
+
+  ~Mapping() noexcept
+  {
+    ::munmap(const_cast<void*>(this->data_), this->size_);
+  }
+
+  const u8* data() const noexcept
+  {
+    return static_cast<const u8*>(this->data_);
+  }
+
+  usize size() const noexcept
+  {
+    return this->size_;
+  }
+
+ private:
+  const void* const data_;
+  const usize size_;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<std::unique_ptr<MmapPageDevice>> MmapPageDevice::open(
+    const std::string& file_name, const FileOffsetPtr<const PackedPageDeviceConfig&>& config,
+    const MmapPageDeviceOptions& options)
+{
+  // Page buffers returned by `read` point into the mapping, so every page must be as aligned as a
+  // PageBuffer (the mapping itself starts on a memory page boundary).
+  //
+  if (config.absolute_page_0_offset() % alignof(PageBuffer) != 0) {
+    return Status{batt::StatusCode::kInvalidArgument};
+  }
+
+  StatusOr<int> fd = open_file_read_only(file_name);
+  BATT_REQUIRE_OK(fd);
+
+  const i64 end_of_pages = config.absolute_page_0_offset() +
+                           (config->page_capacity() << u16{config->page_size_log2});
+
+  StatusOr<i64> file_size = sizeof_fd(*fd);
+  if (!file_size.ok()) {
+    close_fd(*fd).IgnoreError();
+    return file_size.status();
+  }
+
+  // The device is read-only, so it can't grow the file the way the other file devices do.
+  //
+  if (*file_size < end_of_pages) {
+    close_fd(*fd).IgnoreError();
+    return Status{batt::StatusCode::kOutOfRange};
+  }
+
+  const usize mapped_size = BATT_CHECKED_CAST(usize, end_of_pages);
+
+  void* const mapped = ::mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, *fd, 0);
+  const int mmap_errno = errno;
+
+  // The mapping keeps its own reference to the file.
+  //
+  close_fd(*fd).IgnoreError();
+
+  if (mapped == MAP_FAILED) {
+    return batt::status_from_errno(mmap_errno);
+  }
+
+  if (options.random_access) {
+    // madvise is only a hint; if it fails, faults just read ahead as usual.
+    //
+    if (::madvise(mapped, mapped_size, MADV_RANDOM) != 0) {
+      LLFS_LOG_WARNING() << "MmapPageDevice: madvise(MADV_RANDOM) failed" << BATT_INSPECT(errno);
+    }
+  }
+
+  auto mapping = std::make_shared<const Mapping>(mapped, mapped_size);
+
+  return std::unique_ptr<MmapPageDevice>{new MmapPageDevice{std::move(mapping), config}};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ MmapPageDevice::MmapPageDevice(
+    std::shared_ptr<const Mapping>&& mapping,
+    const FileOffsetPtr<const PackedPageDeviceConfig&>& config) noexcept
+    : mapping_{std::move(mapping)}
+    , config_{config}
+    , page_ids_{PageCount{BATT_CHECKED_CAST(u64, config->page_capacity())},
+                BATT_CHECKED_CAST(page_device_id_int, config->device_id.value())}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageIdFactory MmapPageDevice::page_ids()
+{
+  return this->page_ids_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageSize MmapPageDevice::page_size()
+{
+  return PageSize{BATT_CHECKED_CAST(u32, this->config_->page_size())};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool MmapPageDevice::prefetch_hint(PageId id)
+{
+  StatusOr<const u8*> page_data = this->get_page_data(id);
+  if (!page_data.ok()) {
+    return false;
+  }
+
+  // madvise needs a memory page-aligned address.
+  //
+  const usize page_offset = *page_data - this->mapping_->data();
+  const usize advise_begin = round_down_to_page_size_multiple(page_offset);
+  const usize advise_end = page_offset + this->page_size();
+
+  const int retval = ::madvise(const_cast<u8*>(this->mapping_->data()) + advise_begin,
+                               advise_end - advise_begin, MADV_WILLNEED);
+  if (retval != 0) {
+    return false;
+  }
+
+  metrics().prefetch_advice_count.add(1);
+  return true;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::shared_ptr<PageBuffer>> MmapPageDevice::prepare(PageId /*page_id*/)
+{
+  return Status{batt::StatusCode::kFailedPrecondition};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MmapPageDevice::write(std::shared_ptr<const PageBuffer>&& /*page_buffer*/,
+                           WriteHandler&& handler)
+{
+  handler(Status{batt::StatusCode::kFailedPrecondition});
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MmapPageDevice::read(PageId id, ReadHandler&& handler)
+{
+  StatusOr<const u8*> page_data = this->get_page_data(id);
+  if (!page_data.ok()) {
+    handler(page_data.status());
+    return;
+  }
+
+  metrics().page_read_count.add(1);
+
+  // The returned buffer shares ownership of the mapping (but doesn't own the page memory itself).
+  //
+  std::shared_ptr<const PageBuffer> page_buffer{this->mapping_,
+                                                reinterpret_cast<const PageBuffer*>(*page_data)};
+
+  Status status =
+      get_page_header(*page_buffer).sanity_check(this->page_size(), id, this->page_ids_);
+  if (!status.ok()) {
+    // As in IoRingPageFileDevice, report a page that has since been rewritten as not found.
+    //
+    if (status == StatusCode::kPageHeaderBadGeneration) {
+      handler(Status{batt::StatusCode::kNotFound});
+    } else {
+      handler(status);
+    }
+    return;
+  }
+
+  handler(std::move(page_buffer));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MmapPageDevice::read_tail(PageId id, usize byte_count, ReadTailHandler&& handler)
+{
+  StatusOr<const u8*> page_data = this->get_page_data(id);
+  if (!page_data.ok()) {
+    handler(page_data.status());
+    return;
+  }
+
+  metrics().tail_read_count.add(1);
+
+  // Only the memory pages holding the tail are touched.
+  //
+  const usize page_size = this->page_size();
+  const usize n = std::min<usize>(byte_count, page_size);
+  const u8* const tail_begin = *page_data + page_size - n;
+
+  handler(std::vector<u8>(tail_begin, tail_begin + n));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MmapPageDevice::drop(PageId id, WriteHandler&& handler)
+{
+  // As in IoRingPageFileDevice, there is nothing to do.
+  //
+  (void)id;
+  handler(OkStatus());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<const u8*> MmapPageDevice::get_page_data(PageId page_id) const
+{
+  const i64 physical_page = this->page_ids_.get_physical_page(page_id);
+  if (physical_page >= this->config_->page_capacity() || physical_page < 0) {
+    return Status{batt::StatusCode::kOutOfRange};
+  }
+
+  const usize file_offset = BATT_CHECKED_CAST(
+      usize, this->config_.absolute_page_0_offset() +
+                 (physical_page << u16{this->config_->page_size_log2}));
+
+  BATT_CHECK_LE(file_offset + (usize{1} << u16{this->config_->page_size_log2}),
+                this->mapping_->size());
+
+  return this->mapping_->data() + file_offset;
+}
+
+}  // namespace llfs
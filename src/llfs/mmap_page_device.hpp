@@ -0,0 +1,114 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_MMAP_PAGE_DEVICE_HPP
+#define LLFS_MMAP_PAGE_DEVICE_HPP
+
+#include <llfs/file_offset_ptr.hpp>
+#include <llfs/int_types.hpp>
+#include <llfs/metrics.hpp>
+#include <llfs/page_device.hpp>
+#include <llfs/page_device_config.hpp>
+#include <llfs/status.hpp>
+
+#include <memory>
+#include <string>
+
+namespace llfs {
+
+struct MmapPageDeviceOptions {
+  /** \brief If true, the kernel is told (MADV_RANDOM) not to read ahead around each page fault;
+   * this suits point lookups, which would otherwise pull in neighbouring pages nobody asked for.
+   * Pages named by `prefetch_hint` are still read ahead.
+   */
+  bool random_access = true;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A read-only PageDevice that maps a page file into memory and returns page buffers that
+ * point straight into the mapping, for arenas that are never written again (e.g., snapshots).
+ *
+ * The layout of the file is the same as for IoRingPageFileDevice and PosixPageFileDevice (it is
+ * described by a PackedPageDeviceConfig).  Reads complete on the calling thread without copying;
+ * the kernel page cache holds the page data, and each returned buffer keeps the mapping alive, so
+ * buffers may outlive the device.  `prefetch_hint` is implemented with MADV_WILLNEED.
+ *
+ * `prepare` and `write` fail with `batt::StatusCode::kFailedPrecondition`; `drop` does nothing,
+ * as for the other file-backed devices.
+ */
+class MmapPageDevice : public PageDevice
+{
+ public:
+  struct Metrics {
+    /** \brief The number of pages read from the mapping.
+     */
+    CountMetric<u64> page_read_count{0};
+
+    /** \brief The number of page tails read from the mapping (see PageDevice::read_tail).
+     */
+    CountMetric<u64> tail_read_count{0};
+
+    /** \brief The number of prefetch hints passed on to the kernel.
+     */
+    CountMetric<u64> prefetch_advice_count{0};
+  };
+
+  static Metrics& metrics()
+  {
+    static Metrics m_;
+    return m_;
+  }
+
+  /** \brief Opens and maps the file containing the page device described by `config`.  The file
+   * must already hold all the pages of the device.
+   */
+  static StatusOr<std::unique_ptr<MmapPageDevice>> open(
+      const std::string& file_name, const FileOffsetPtr<const PackedPageDeviceConfig&>& config,
+      const MmapPageDeviceOptions& options = MmapPageDeviceOptions{});
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  PageIdFactory page_ids() override;
+
+  PageSize page_size() override;
+
+  bool prefetch_hint(PageId id) override;
+
+  StatusOr<std::shared_ptr<PageBuffer>> prepare(PageId page_id) override;
+
+  void write(std::shared_ptr<const PageBuffer>&& page_buffer, WriteHandler&& handler) override;
+
+  void read(PageId id, ReadHandler&& handler) override;
+
+  void read_tail(PageId id, usize byte_count, ReadTailHandler&& handler) override;
+
+  void drop(PageId id, WriteHandler&& handler) override;
+
+ private:
+  /** \brief The mapped file; unmapped when the device and all the buffers read from it are gone.
+   */
+  class Mapping;
+
+  explicit MmapPageDevice(std::shared_ptr<const Mapping>&& mapping,
+                          const FileOffsetPtr<const PackedPageDeviceConfig&>& config) noexcept;
+
+  /** \brief Returns the page with the given id, without checking its header.
+   */
+  StatusOr<const u8*> get_page_data(PageId page_id) const;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const std::shared_ptr<const Mapping> mapping_;
+  const FileOffsetPtr<PackedPageDeviceConfig> config_;
+  const PageIdFactory page_ids_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_MMAP_PAGE_DEVICE_HPP
@@ -0,0 +1,226 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/mmap_page_device.hpp>
+//
+#include <llfs/mmap_page_device.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/filesystem.hpp>
+#include <llfs/page_buffer.hpp>
+#include <llfs/posix_page_file_device.hpp>
+
+#include <cstring>
+#include <future>
+#include <vector>
+
+namespace {
+
+using namespace llfs::int_types;
+
+// Test Plan:
+//  1. Pages written with PosixPageFileDevice can be read from the mapping without copying (the
+//     returned buffer points into the mapping, and stays valid after the device is destroyed);
+//     reading a page with the wrong generation fails with kNotFound; page ids past the end of the
+//     device are kOutOfRange; prepare/write fail.
+//  2. read_tail returns the end of the page; prefetch_hint is handled by the device.
+//  3. Opening a file that is too small to hold all the pages fails.
+
+constexpr u64 kPageSize = 4096;
+constexpr i64 kPageCount = 16;
+constexpr llfs::page_device_id_int kDeviceId = 5;
+
+class MmapPageDeviceTest : public ::testing::Test
+{
+ public:
+  void SetUp() override
+  {
+    llfs::delete_file(this->file_name_).IgnoreError();
+    ASSERT_TRUE(llfs::truncate_file(this->file_name_, 0).ok());
+
+    std::memset(&this->config_, 0, sizeof(this->config_));
+
+    this->config_.page_0_offset = kPageSize;
+    this->config_.device_id = kDeviceId;
+    this->config_.page_count = kPageCount;
+    this->config_.page_size_log2 = 12;
+  }
+
+  void TearDown() override
+  {
+    llfs::delete_file(this->file_name_).IgnoreError();
+  }
+
+  llfs::FileOffsetPtr<const llfs::PackedPageDeviceConfig&> config() const
+  {
+    return llfs::FileOffsetPtr<const llfs::PackedPageDeviceConfig&>{this->config_, 0};
+  }
+
+  // Writes pages 0, 2, 4, ... (generation 1), each filled with its physical page number + 1.
+  //
+  std::vector<llfs::PageId> write_pages()
+  {
+    std::vector<llfs::PageId> page_ids;
+
+    llfs::StatusOr<std::unique_ptr<llfs::PosixPageFileDevice>> writer =
+        llfs::PosixPageFileDevice::open(this->file_name_, this->config());
+    EXPECT_TRUE(writer.ok()) << BATT_INSPECT(writer.status());
+    if (!writer.ok()) {
+      return page_ids;
+    }
+
+    const llfs::PageIdFactory ids = (*writer)->page_ids();
+
+    for (i64 i = 0; i < kPageCount; i += 2) {
+      const llfs::PageId page_id = ids.make_page_id(i, 1);
+
+      llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer = (*writer)->prepare(page_id);
+      EXPECT_TRUE(buffer.ok());
+      if (!buffer.ok()) {
+        break;
+      }
+      std::memset((*buffer)->mutable_payload().data(), i + 1,
+                  (*buffer)->mutable_payload().size());
+
+      std::promise<llfs::Status> result;
+      (*writer)->write(std::move(*buffer), [&result](llfs::Status status) {
+        result.set_value(status);
+      });
+      EXPECT_TRUE(result.get_future().get().ok());
+
+      page_ids.emplace_back(page_id);
+    }
+
+    return page_ids;
+  }
+
+  std::unique_ptr<llfs::MmapPageDevice> open_device()
+  {
+    llfs::StatusOr<std::unique_ptr<llfs::MmapPageDevice>> device =
+        llfs::MmapPageDevice::open(this->file_name_, this->config());
+
+    EXPECT_TRUE(device.ok()) << BATT_INSPECT(device.status());
+    if (!device.ok()) {
+      return nullptr;
+    }
+    return std::move(*device);
+  }
+
+  // Reads complete on the calling thread, so the result is available as soon as `read` returns.
+  //
+  llfs::PageDevice::ReadResult read_page(llfs::PageDevice& device, llfs::PageId page_id)
+  {
+    llfs::PageDevice::ReadResult result{llfs::Status{batt::StatusCode::kUnknown}};
+    device.read(page_id, [&result](llfs::PageDevice::ReadResult page) {
+      result = std::move(page);
+    });
+    return result;
+  }
+
+ protected:
+  const std::string file_name_ = "/tmp/llfs_MmapPageDeviceTest.llfs";
+
+  llfs::PackedPageDeviceConfig config_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(MmapPageDeviceTest, ReadFromMapping)
+{
+  const std::vector<llfs::PageId> page_ids = this->write_pages();
+  ASSERT_EQ(page_ids.size(), static_cast<usize>(kPageCount / 2));
+
+  std::shared_ptr<const llfs::PageBuffer> kept_page;
+  {
+    std::unique_ptr<llfs::MmapPageDevice> device = this->open_device();
+    ASSERT_NE(device, nullptr);
+
+    const llfs::PageIdFactory ids = device->page_ids();
+
+    for (const llfs::PageId page_id : page_ids) {
+      llfs::PageDevice::ReadResult page = this->read_page(*device, page_id);
+      ASSERT_TRUE(page.ok()) << BATT_INSPECT(page.status()) << BATT_INSPECT(page_id);
+      EXPECT_EQ((*page)->page_id(), page_id);
+      EXPECT_EQ(static_cast<const u8*>((*page)->const_payload().data())[0],
+                ids.get_physical_page(page_id) + 1);
+    }
+
+    // Reading the same page twice returns the same memory: the page isn't copied.
+    //
+    llfs::PageDevice::ReadResult first = this->read_page(*device, page_ids[1]);
+    llfs::PageDevice::ReadResult second = this->read_page(*device, page_ids[1]);
+    ASSERT_TRUE(first.ok());
+    ASSERT_TRUE(second.ok());
+    EXPECT_EQ(first->get(), second->get());
+
+    kept_page = std::move(*first);
+
+    EXPECT_EQ(this->read_page(*device, ids.make_page_id(0, 2)).status(),
+              batt::StatusCode::kNotFound);
+
+    EXPECT_EQ(this->read_page(*device, ids.make_page_id(kPageCount, 1)).status(),
+              batt::StatusCode::kOutOfRange);
+
+    EXPECT_EQ(device->prepare(ids.make_page_id(1, 1)).status(),
+              batt::StatusCode::kFailedPrecondition);
+
+    llfs::Status write_status;
+    device->write(std::move(kept_page), [&write_status](llfs::Status status) {
+      write_status = status;
+    });
+    EXPECT_EQ(write_status, batt::StatusCode::kFailedPrecondition);
+
+    kept_page = std::move(*second);
+  }
+
+  // The buffer keeps the mapping alive.
+  //
+  ASSERT_NE(kept_page, nullptr);
+  EXPECT_EQ(kept_page->page_id(), page_ids[1]);
+  EXPECT_EQ(static_cast<const u8*>(kept_page->const_payload().data())[0], 3u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(MmapPageDeviceTest, ReadTailAndPrefetch)
+{
+  const std::vector<llfs::PageId> page_ids = this->write_pages();
+  ASSERT_FALSE(page_ids.empty());
+
+  std::unique_ptr<llfs::MmapPageDevice> device = this->open_device();
+  ASSERT_NE(device, nullptr);
+
+  const u64 advice_before = llfs::MmapPageDevice::metrics().prefetch_advice_count.load();
+
+  EXPECT_TRUE(device->prefetch_hint(page_ids[2]));
+  EXPECT_FALSE(device->prefetch_hint(device->page_ids().make_page_id(kPageCount, 1)));
+
+  EXPECT_EQ(llfs::MmapPageDevice::metrics().prefetch_advice_count.load() - advice_before, 1u);
+
+  llfs::PageDevice::ReadTailResult tail{llfs::Status{batt::StatusCode::kUnknown}};
+  device->read_tail(page_ids[2], 100, [&tail](llfs::PageDevice::ReadTailResult result) {
+    tail = std::move(result);
+  });
+  ASSERT_TRUE(tail.ok()) << BATT_INSPECT(tail.status());
+  EXPECT_THAT(*tail, ::testing::Each(::testing::Eq(5u)));
+  EXPECT_EQ(tail->size(), 100u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(MmapPageDeviceTest, FileTooSmall)
+{
+  ASSERT_TRUE(llfs::truncate_file(this->file_name_, kPageSize * kPageCount).ok());
+
+  EXPECT_EQ(llfs::MmapPageDevice::open(this->file_name_, this->config()).status(),
+            batt::StatusCode::kOutOfRange);
+}
+
+}  // namespace
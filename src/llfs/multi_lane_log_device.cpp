@@ -0,0 +1,739 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/multi_lane_log_device.hpp>
+//
+
+#include <batteries/case_of.hpp>
+#include <batteries/checked_cast.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<std::unique_ptr<MultiLaneLogDevice>> MultiLaneLogDevice::open(
+    std::vector<std::unique_ptr<LogDevice>>&& lanes)
+{
+  std::unique_ptr<MultiLaneLogDevice> device{new MultiLaneLogDevice{std::move(lanes)}};
+
+  BATT_REQUIRE_OK(device->recover());
+
+  return device;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ MultiLaneLogDevice::MultiLaneLogDevice(
+    std::vector<std::unique_ptr<LogDevice>>&& lanes) noexcept
+{
+  BATT_CHECK(!lanes.empty());
+
+  for (std::unique_ptr<LogDevice>& lane_device : lanes) {
+    BATT_CHECK_NOT_NULLPTR(lane_device);
+
+    auto lane = std::make_unique<Lane>();
+    lane->device = std::move(lane_device);
+    this->lanes_.emplace_back(std::move(lane));
+  }
+
+  for (usize i = 0; i < this->lanes_.size(); ++i) {
+    this->lanes_[i]->writer = std::make_unique<LaneWriter>(this, i);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+MultiLaneLogDevice::~MultiLaneLogDevice() noexcept
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status MultiLaneLogDevice::recover()
+{
+  struct RecoveredRecord {
+    usize lane_index;
+    Record record;
+    u32 epoch;
+  };
+
+  std::vector<RecoveredRecord> recovered;
+
+  // Scan the durable contents of each lane.
+  //
+  for (usize lane_index = 0; lane_index < this->lanes_.size(); ++lane_index) {
+    Lane& lane = *this->lanes_[lane_index];
+
+    const SlotRange lane_slot_range = lane.device->slot_range(LogReadMode::kDurable);
+    lane.trim_pos = lane_slot_range.lower_bound;
+
+    std::unique_ptr<LogDevice::Reader> reader =
+        lane.device->new_reader(lane_slot_range.lower_bound, LogReadMode::kDurable);
+
+    while (slot_less_than(reader->slot_offset(), lane_slot_range.upper_bound)) {
+      const slot_offset_type record_lower_bound = reader->slot_offset();
+      const usize available = slot_distance(record_lower_bound, lane_slot_range.upper_bound);
+      if (available < kHeaderSize) {
+        return {batt::StatusCode::kDataLoss};
+      }
+
+      BATT_REQUIRE_OK(reader->await(BytesAvailable{.size = kHeaderSize}));
+
+      PackedLaneRecordHeader header;
+      std::memcpy(&header, reader->data().data(), kHeaderSize);
+
+      const usize record_size = kHeaderSize + header.size.value();
+      if (record_size > available) {
+        return {batt::StatusCode::kDataLoss};
+      }
+
+      BATT_REQUIRE_OK(reader->await(BytesAvailable{.size = record_size}));
+      reader->consume(record_size);
+
+      const slot_offset_type slot_lower_bound = header.slot_offset.value();
+
+      recovered.emplace_back(RecoveredRecord{
+          .lane_index = lane_index,
+          .record =
+              Record{
+                  .slot_range = SlotRange{slot_lower_bound, slot_lower_bound + header.size.value()},
+                  .lane_range = SlotRange{record_lower_bound, record_lower_bound + record_size},
+                  .orphan = false,
+              },
+          .epoch = header.epoch.value(),
+      });
+    }
+  }
+
+  // A record is an orphan if a later epoch started writing at or below its upper bound: that
+  // means it was beyond the recovered prefix of the merged stream when that epoch began.
+  //
+  std::map<u32, slot_offset_type> epoch_lower_bound;
+  for (const RecoveredRecord& r : recovered) {
+    auto [iter, inserted] = epoch_lower_bound.emplace(r.epoch, r.record.slot_range.lower_bound);
+    if (!inserted && slot_less_than(r.record.slot_range.lower_bound, iter->second)) {
+      iter->second = r.record.slot_range.lower_bound;
+    }
+  }
+
+  std::map<u32, slot_offset_type> orphan_bound;
+  {
+    Optional<slot_offset_type> bound;
+    for (auto iter = epoch_lower_bound.rbegin(); iter != epoch_lower_bound.rend(); ++iter) {
+      if (bound) {
+        orphan_bound.emplace(iter->first, *bound);
+        bound = slot_min(*bound, iter->second);
+      } else {
+        bound = iter->second;
+      }
+    }
+  }
+
+  std::vector<RecoveredRecord*> valid;
+  for (RecoveredRecord& r : recovered) {
+    auto iter = orphan_bound.find(r.epoch);
+    if (iter != orphan_bound.end() &&
+        slot_less_than(iter->second, r.record.slot_range.upper_bound)) {
+      r.record.orphan = true;
+    } else {
+      valid.emplace_back(&r);
+    }
+  }
+
+  // The merged stream is the contiguous prefix of the remaining records; anything after the first
+  // gap is also an orphan.
+  //
+  std::stable_sort(valid.begin(), valid.end(), [](RecoveredRecord* left, RecoveredRecord* right) {
+    return slot_less_than(left->record.slot_range.lower_bound,
+                          right->record.slot_range.lower_bound);
+  });
+
+  const slot_offset_type lower_bound =
+      valid.empty() ? slot_offset_type{0} : valid.front()->record.slot_range.lower_bound;
+
+  slot_offset_type upper_bound = lower_bound;
+  for (RecoveredRecord* r : valid) {
+    if (r->record.slot_range.lower_bound == upper_bound) {
+      upper_bound = r->record.slot_range.upper_bound;
+    } else {
+      r->record.orphan = true;
+    }
+  }
+
+  // Rebuild the index; everything recovered is durable, and therefore already merged.
+  //
+  for (const RecoveredRecord& r : recovered) {
+    this->lanes_[r.lane_index]->records.emplace_back(r.record);
+  }
+  for (const std::unique_ptr<Lane>& lane : this->lanes_) {
+    lane->merged_count[0] = lane->records.size();
+    lane->merged_count[1] = lane->records.size();
+  }
+
+  this->epoch_ = epoch_lower_bound.empty() ? 0 : (epoch_lower_bound.rbegin()->first + 1);
+  this->lower_bound_.store(lower_bound);
+  this->next_slot_offset_.store(upper_bound);
+  this->merge_pos_[0].set_value(upper_bound);
+  this->merge_pos_[1].set_value(upper_bound);
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+LogDevice::Writer& MultiLaneLogDevice::lane_writer(usize lane_index)
+{
+  BATT_CHECK_LT(lane_index, this->lanes_.size());
+
+  return *this->lanes_[lane_index]->writer;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+LogDevice& MultiLaneLogDevice::lane_device(usize lane_index)
+{
+  BATT_CHECK_LT(lane_index, this->lanes_.size());
+
+  return *this->lanes_[lane_index]->device;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 MultiLaneLogDevice::capacity() const
+{
+  u64 total = 0;
+  for (const std::unique_ptr<Lane>& lane : this->lanes_) {
+    total += lane->device->capacity();
+  }
+  return total;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 MultiLaneLogDevice::size() const
+{
+  return slot_distance(this->lower_bound_.load(), this->merge_pos_[0].get_value());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status MultiLaneLogDevice::trim(slot_offset_type slot_lower_bound)
+{
+  std::unique_lock<std::mutex> merge_lock{this->merge_mutex_};
+
+  slot_lower_bound = slot_min(slot_lower_bound, this->merge_pos_[0].get_value());
+  if (!slot_less_than(this->lower_bound_.load(), slot_lower_bound)) {
+    return OkStatus();
+  }
+  this->lower_bound_.store(slot_lower_bound);
+
+  // The record that ends at the durable merge position is the only persistent record of how far the
+  // merged stream has advanced; if it were trimmed along with everything before it, recovery would
+  // find empty lanes and restart the stream at offset 0.  So it is always kept, even when the whole
+  // stream is trimmed.
+  //
+  const slot_offset_type durable_pos = this->merge_pos_[1].get_value();
+
+  for (const std::unique_ptr<Lane>& lane : this->lanes_) {
+    Optional<slot_offset_type> new_trim_pos;
+    {
+      std::unique_lock<std::mutex> lane_lock{lane->mutex};
+
+      // Only drop records that no longer matter to either the speculative or the durable stream.
+      //
+      const usize droppable = std::min(lane->merged_count[0], lane->merged_count[1]);
+      usize dropped = 0;
+      while (dropped < droppable) {
+        const Record& front = lane->records.front();
+        if (!front.orphan && (slot_less_than(slot_lower_bound, front.slot_range.upper_bound) ||
+                              front.slot_range.upper_bound == durable_pos)) {
+          break;
+        }
+        new_trim_pos = front.lane_range.upper_bound;
+        lane->records.pop_front();
+        ++dropped;
+      }
+      lane->merged_count[0] -= dropped;
+      lane->merged_count[1] -= dropped;
+    }
+
+    if (new_trim_pos && slot_less_than(lane->trim_pos, *new_trim_pos)) {
+      lane->trim_pos = *new_trim_pos;
+      BATT_REQUIRE_OK(lane->device->trim(*new_trim_pos));
+    }
+  }
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::unique_ptr<LogDevice::Reader> MultiLaneLogDevice::new_reader(
+    Optional<slot_offset_type> slot_lower_bound, LogReadMode mode)
+{
+  return std::make_unique<ReaderImpl>(this, slot_lower_bound.value_or(this->lower_bound_.load()),
+                                      mode);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+SlotRange MultiLaneLogDevice::slot_range(LogReadMode mode)
+{
+  this->update_merge_pos();
+
+  return SlotRange{
+      this->lower_bound_.load(),
+      this->merge_pos_[MultiLaneLogDevice::index_of_mode(mode)].get_value(),
+  };
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+LogDevice::Writer& MultiLaneLogDevice::writer()
+{
+  return this->lane_writer(0);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status MultiLaneLogDevice::close()
+{
+  this->closed_.store(true);
+  this->merge_pos_[0].close();
+  this->merge_pos_[1].close();
+
+  Status status;
+  for (const std::unique_ptr<Lane>& lane : this->lanes_) {
+    Status lane_status = lane->device->close();
+    if (status.ok()) {
+      status = lane_status;
+    }
+  }
+  return status;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status MultiLaneLogDevice::sync(LogReadMode mode, SlotUpperBoundAt event)
+{
+  StatusOr<slot_offset_type> merge_pos = this->await_merge_pos(mode, event.offset);
+  BATT_REQUIRE_OK(merge_pos);
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MultiLaneLogDevice::add_record(usize lane_index, const Record& record)
+{
+  {
+    Lane& lane = *this->lanes_[lane_index];
+    std::unique_lock<std::mutex> lane_lock{lane.mutex};
+    lane.records.emplace_back(record);
+  }
+  this->update_merge_pos();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MultiLaneLogDevice::update_merge_pos()
+{
+  this->merge_requests_.fetch_add(1);
+
+  for (;;) {
+    std::unique_lock<std::mutex> merge_lock{this->merge_mutex_, std::try_to_lock};
+    if (!merge_lock.owns_lock()) {
+      // The current owner of the lock will notice our request after it releases the lock.
+      //
+      return;
+    }
+
+    const u64 observed_requests = this->merge_requests_.load();
+    this->advance_merge_pos_locked();
+    merge_lock.unlock();
+
+    if (this->merge_requests_.load() == observed_requests) {
+      return;
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MultiLaneLogDevice::advance_merge_pos_locked()
+{
+  std::vector<slot_offset_type> lane_flush_pos(this->lanes_.size());
+  for (usize i = 0; i < this->lanes_.size(); ++i) {
+    lane_flush_pos[i] = this->lanes_[i]->device->slot_range(LogReadMode::kDurable).upper_bound;
+  }
+
+  for (usize mode_index : {0, 1}) {
+    const slot_offset_type prior_pos = this->merge_pos_[mode_index].get_value();
+    slot_offset_type pos = prior_pos;
+
+    // Keep making passes over the lanes until none of them has the record at `pos`.
+    //
+    bool advanced = true;
+    while (advanced) {
+      advanced = false;
+      for (usize i = 0; i < this->lanes_.size(); ++i) {
+        Lane& lane = *this->lanes_[i];
+        std::unique_lock<std::mutex> lane_lock{lane.mutex};
+
+        usize& merged_count = lane.merged_count[mode_index];
+        while (merged_count < lane.records.size()) {
+          const Record& next = lane.records[merged_count];
+          if (!next.orphan) {
+            if (next.slot_range.lower_bound != pos) {
+              break;
+            }
+            if (mode_index == 1 && slot_less_than(lane_flush_pos[i], next.lane_range.upper_bound)) {
+              break;
+            }
+            pos = next.slot_range.upper_bound;
+            advanced = true;
+          }
+          ++merged_count;
+        }
+      }
+    }
+
+    if (pos != prior_pos) {
+      this->merge_pos_[mode_index].set_value(pos);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<slot_offset_type> MultiLaneLogDevice::await_merge_pos(LogReadMode mode,
+                                                               slot_offset_type min_offset)
+{
+  const usize mode_index = MultiLaneLogDevice::index_of_mode(mode);
+
+  for (;;) {
+    this->update_merge_pos();
+
+    const slot_offset_type pos = this->merge_pos_[mode_index].get_value();
+    if (!slot_less_than(pos, min_offset)) {
+      return pos;
+    }
+    if (this->closed_.load()) {
+      return {batt::StatusCode::kClosed};
+    }
+
+    if (mode_index == 0) {
+      return await_slot_offset(min_offset, this->merge_pos_[0]);
+    }
+
+    // If the record at the durable upper bound has been committed, ask its lane to flush it;
+    // otherwise wait for it to be committed.
+    //
+    Optional<std::pair<usize, slot_offset_type>> unflushed = this->find_unflushed(pos);
+    if (unflushed) {
+      BATT_REQUIRE_OK(this->lanes_[unflushed->first]->device->sync(
+          LogReadMode::kDurable, SlotUpperBoundAt{.offset = unflushed->second}));
+    } else {
+      BATT_REQUIRE_OK(await_slot_offset(pos + 1, this->merge_pos_[0]));
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto MultiLaneLogDevice::find_record(slot_offset_type slot_offset,
+                                     std::vector<slot_offset_type>& lane_cursors)
+    -> Optional<RecordLocation>
+{
+  for (usize i = 0; i < this->lanes_.size(); ++i) {
+    Lane& lane = *this->lanes_[i];
+    std::unique_lock<std::mutex> lane_lock{lane.mutex};
+
+    auto iter = std::lower_bound(lane.records.begin(), lane.records.end(), lane_cursors[i],
+                                 [](const Record& record, slot_offset_type lane_offset) {
+                                   return slot_less_than(record.lane_range.lower_bound,
+                                                         lane_offset);
+                                 });
+
+    // Within a lane, (non-orphan) records are in global slot order, so skip over any that end at
+    // or before `slot_offset`; they will never be needed again.
+    //
+    for (; iter != lane.records.end(); ++iter) {
+      if (!iter->orphan && slot_less_than(slot_offset, iter->slot_range.upper_bound)) {
+        break;
+      }
+      lane_cursors[i] = iter->lane_range.upper_bound;
+    }
+
+    if (iter != lane.records.end() && !slot_less_than(slot_offset, iter->slot_range.lower_bound)) {
+      return RecordLocation{
+          .lane_index = i,
+          .record = *iter,
+      };
+    }
+  }
+
+  return None;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<std::pair<usize, slot_offset_type>> MultiLaneLogDevice::find_unflushed(
+    slot_offset_type slot_offset)
+{
+  std::unique_lock<std::mutex> merge_lock{this->merge_mutex_};
+
+  for (usize i = 0; i < this->lanes_.size(); ++i) {
+    Lane& lane = *this->lanes_[i];
+    std::unique_lock<std::mutex> lane_lock{lane.mutex};
+
+    for (usize j = lane.merged_count[1]; j < lane.records.size(); ++j) {
+      const Record& record = lane.records[j];
+      if (record.orphan) {
+        continue;
+      }
+      if (record.slot_range.lower_bound == slot_offset) {
+        return std::make_pair(i, record.lane_range.upper_bound);
+      }
+      break;
+    }
+  }
+
+  return None;
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class MultiLaneLogDevice::LaneWriter
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ MultiLaneLogDevice::LaneWriter::LaneWriter(MultiLaneLogDevice* device,
+                                                       usize lane_index) noexcept
+    : device_{device}
+    , lane_index_{lane_index}
+    , lane_writer_{device->lanes_[lane_index]->device->writer()}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 MultiLaneLogDevice::LaneWriter::space() const
+{
+  const u64 lane_space = this->lane_writer_.space();
+
+  return (lane_space > kHeaderSize) ? (lane_space - kHeaderSize) : 0;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+slot_offset_type MultiLaneLogDevice::LaneWriter::slot_offset()
+{
+  return this->device_->next_slot_offset_.load();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<MutableBuffer> MultiLaneLogDevice::LaneWriter::prepare(usize byte_count, usize head_room)
+{
+  StatusOr<MutableBuffer> buffer = this->lane_writer_.prepare(kHeaderSize + byte_count, head_room);
+  BATT_REQUIRE_OK(buffer);
+
+  this->prepared_header_ = reinterpret_cast<PackedLaneRecordHeader*>(buffer->data());
+
+  return MutableBuffer{static_cast<char*>(buffer->data()) + kHeaderSize, byte_count};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<slot_offset_type> MultiLaneLogDevice::LaneWriter::commit(usize byte_count)
+{
+  BATT_CHECK_NOT_NULLPTR(this->prepared_header_);
+
+  // This is the only point at which lanes synchronize with each other.
+  //
+  const slot_offset_type slot_lower_bound =
+      this->device_->next_slot_offset_.fetch_add(byte_count);
+
+  this->prepared_header_->slot_offset = slot_lower_bound;
+  this->prepared_header_->size = BATT_CHECKED_CAST(u32, byte_count);
+  this->prepared_header_->epoch = this->device_->epoch_;
+  this->prepared_header_ = nullptr;
+
+  const usize record_size = kHeaderSize + byte_count;
+
+  StatusOr<slot_offset_type> lane_upper_bound = this->lane_writer_.commit(record_size);
+  BATT_REQUIRE_OK(lane_upper_bound);
+
+  const slot_offset_type slot_upper_bound = slot_lower_bound + byte_count;
+
+  this->device_->add_record(this->lane_index_,
+                            Record{
+                                .slot_range = SlotRange{slot_lower_bound, slot_upper_bound},
+                                .lane_range = SlotRange{*lane_upper_bound - record_size,
+                                                        *lane_upper_bound},
+                                .orphan = false,
+                            });
+
+  return slot_upper_bound;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status MultiLaneLogDevice::LaneWriter::await(LogDevice::WriterEvent event)
+{
+  return this->lane_writer_.await(event);
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class MultiLaneLogDevice::ReaderImpl
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ MultiLaneLogDevice::ReaderImpl::ReaderImpl(MultiLaneLogDevice* device,
+                                                       slot_offset_type slot_lower_bound,
+                                                       LogReadMode mode) noexcept
+    : device_{device}
+    , mode_{mode}
+    , slot_offset_{slot_lower_bound}
+{
+  for (const std::unique_ptr<Lane>& lane : this->device_->lanes_) {
+    this->lane_readers_.emplace_back(lane->device->new_reader(/*slot_lower_bound=*/None, mode));
+    this->lane_cursors_.emplace_back(this->lane_readers_.back()->slot_offset());
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool MultiLaneLogDevice::ReaderImpl::is_closed()
+{
+  return this->device_->closed_.load();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+ConstBuffer MultiLaneLogDevice::ReaderImpl::data()
+{
+  this->device_->update_merge_pos();
+
+  for (;;) {
+    StatusOr<bool> appended = this->append_next(/*wait=*/false);
+    if (!appended.ok() || !*appended) {
+      break;
+    }
+  }
+
+  return ConstBuffer{this->buffer_.data() + this->consumed_,
+                     this->buffer_.size() - this->consumed_};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+slot_offset_type MultiLaneLogDevice::ReaderImpl::slot_offset()
+{
+  return this->slot_offset_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MultiLaneLogDevice::ReaderImpl::consume(usize byte_count)
+{
+  byte_count = std::min(byte_count, this->buffer_.size() - this->consumed_);
+
+  this->consumed_ += byte_count;
+  this->slot_offset_ += byte_count;
+
+  if (this->consumed_ == this->buffer_.size()) {
+    this->buffer_.clear();
+    this->consumed_ = 0;
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status MultiLaneLogDevice::ReaderImpl::await(LogDevice::ReaderEvent event)
+{
+  return batt::case_of(
+      event,
+      [&](const SlotUpperBoundAt& slot_upper_bound_at) -> Status {
+        while (slot_less_than(this->buffered_upper_bound(), slot_upper_bound_at.offset)) {
+          StatusOr<bool> appended = this->append_next(/*wait=*/true);
+          BATT_REQUIRE_OK(appended);
+        }
+        return OkStatus();
+      },
+      [&](const BytesAvailable& bytes_available) -> Status {
+        while (this->buffer_.size() - this->consumed_ < bytes_available.size) {
+          StatusOr<bool> appended = this->append_next(/*wait=*/true);
+          BATT_REQUIRE_OK(appended);
+        }
+        return OkStatus();
+      });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<bool> MultiLaneLogDevice::ReaderImpl::append_next(bool wait)
+{
+  const slot_offset_type slot_lower_bound = this->buffered_upper_bound();
+  const usize mode_index = MultiLaneLogDevice::index_of_mode(this->mode_);
+
+  if (!slot_less_than(slot_lower_bound, this->device_->merge_pos_[mode_index].get_value())) {
+    if (!wait) {
+      return false;
+    }
+    StatusOr<slot_offset_type> merge_pos =
+        this->device_->await_merge_pos(this->mode_, slot_lower_bound + 1);
+    BATT_REQUIRE_OK(merge_pos);
+  }
+
+  Optional<RecordLocation> location =
+      this->device_->find_record(slot_lower_bound, this->lane_cursors_);
+  if (!location) {
+    // The record must have been trimmed.
+    //
+    return {batt::StatusCode::kOutOfRange};
+  }
+
+  const Record& record = location->record;
+  LogDevice::Reader& lane_reader = *this->lane_readers_[location->lane_index];
+
+  const slot_offset_type payload_lower_bound =
+      record.lane_range.lower_bound + kHeaderSize +
+      slot_distance(record.slot_range.lower_bound, slot_lower_bound);
+
+  const usize byte_count = slot_distance(slot_lower_bound, record.slot_range.upper_bound);
+
+  // Skip over the header and any records which are not part of the merged stream.
+  //
+  if (slot_less_than(lane_reader.slot_offset(), payload_lower_bound)) {
+    BATT_REQUIRE_OK(lane_reader.await(SlotUpperBoundAt{.offset = payload_lower_bound}));
+    lane_reader.consume(slot_distance(lane_reader.slot_offset(), payload_lower_bound));
+  }
+  BATT_CHECK_EQ(lane_reader.slot_offset(), payload_lower_bound);
+
+  BATT_REQUIRE_OK(lane_reader.await(BytesAvailable{.size = byte_count}));
+
+  if (this->consumed_ != 0 && this->consumed_ >= this->buffer_.size() / 2) {
+    this->buffer_.erase(this->buffer_.begin(), this->buffer_.begin() + this->consumed_);
+    this->consumed_ = 0;
+  }
+
+  const char* bytes = static_cast<const char*>(lane_reader.data().data());
+  this->buffer_.insert(this->buffer_.end(), bytes, bytes + byte_count);
+  lane_reader.consume(byte_count);
+
+  return true;
+}
+
+}  // namespace llfs
@@ -0,0 +1,355 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_MULTI_LANE_LOG_DEVICE_HPP
+#define LLFS_MULTI_LANE_LOG_DEVICE_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/log_device.hpp>
+#include <llfs/slot.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/async/watch.hpp>
+#include <batteries/static_assert.hpp>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Frames each slot written to a lane of a MultiLaneLogDevice.  This is the "commit record"
+ * that fixes the position of the slot in the merged (global) slot stream.
+ */
+struct PackedLaneRecordHeader {
+  /** \brief The global slot offset of the first payload byte of this record.
+   */
+  little_u64 slot_offset;
+
+  /** \brief The number of payload bytes following this header.
+   */
+  little_u32 size;
+
+  /** \brief The recovery epoch in which this record was written; see MultiLaneLogDevice.
+   */
+  little_u32 epoch;
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedLaneRecordHeader), 16);
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A LogDevice composed of K independent write lanes whose slots are merged into a single,
+ * totally ordered slot stream.
+ *
+ * Each lane is a separate LogDevice (e.g. an IoRingLogDevice on its own block range, with its own
+ * flush ops), with its own LaneWriter.  Committing a slot through a LaneWriter reserves its range
+ * in the global slot stream with a single atomic fetch-add, then commits the payload to the lane,
+ * framed by a PackedLaneRecordHeader; so writers on different lanes never wait for each other.
+ *
+ * The merged stream is readable (in a given LogReadMode) up to the first global offset whose slot
+ * hasn't yet been committed (or made durable) in its lane.  Readers copy each slot out of its lane
+ * into a private buffer, so the merged stream doesn't need to be materialized anywhere.
+ *
+ * Recovery: if the process crashes while slots are in flight on several lanes, some slots may be
+ * durable in their lanes while an earlier slot (in global order) was lost.  With respect to the
+ * merged stream, such "orphan" slots were never durable, so they are discarded: writing resumes at
+ * the end of the recovered contiguous prefix.  Each record carries the recovery epoch in which it
+ * was written, so the orphans of an earlier epoch can be told apart from the (overlapping) slots
+ * written after it on subsequent recoveries.
+ *
+ * NOTE: because each lane is trimmed at a record boundary, slots just below the last trim point may
+ * reappear after recovery.  In particular, the last durable record is never trimmed: it is what
+ * lets recovery resume the merged stream at its old upper bound after the stream has been trimmed
+ * all the way to the end.
+ */
+class MultiLaneLogDevice : public LogDevice
+{
+ public:
+  class LaneWriter;
+  class ReaderImpl;
+
+  static constexpr usize kHeaderSize = sizeof(PackedLaneRecordHeader);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Recovers a MultiLaneLogDevice from the durable contents of `lanes`, which must have
+   * been written by a MultiLaneLogDevice with the same lanes (or be empty).
+   */
+  static StatusOr<std::unique_ptr<MultiLaneLogDevice>> open(
+      std::vector<std::unique_ptr<LogDevice>>&& lanes);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  ~MultiLaneLogDevice() noexcept;
+
+  /** \brief The number of write lanes.
+   */
+  usize lane_count() const noexcept
+  {
+    return this->lanes_.size();
+  }
+
+  /** \brief Returns the Writer for the given lane.  Each lane may be used by a different task (or
+   * thread) concurrently, but there can only be one user of a given lane at a time.
+   */
+  LogDevice::Writer& lane_writer(usize lane_index);
+
+  /** \brief Returns the LogDevice backing the given lane.
+   */
+  LogDevice& lane_device(usize lane_index);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+  // LogDevice interface
+
+  u64 capacity() const override;
+
+  u64 size() const override;
+
+  /** \brief Trims the merged stream; each lane is trimmed up to its first record that is not wholly
+   * below `slot_lower_bound` (or may still be needed by the durable stream).  The record that ends
+   * at the durable upper bound is always kept, so that recovery can't move the stream backwards.
+   */
+  Status trim(slot_offset_type slot_lower_bound) override;
+
+  std::unique_ptr<LogDevice::Reader> new_reader(Optional<slot_offset_type> slot_lower_bound,
+                                                LogReadMode mode) override;
+
+  SlotRange slot_range(LogReadMode mode) override;
+
+  /** \brief Returns the writer for lane 0.
+   */
+  LogDevice::Writer& writer() override;
+
+  Status close() override;
+
+  Status sync(LogReadMode mode, SlotUpperBoundAt event) override;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  /** \brief The in-memory index entry for a single lane record.
+   */
+  struct Record {
+    /** \brief The payload's place in the merged slot stream.
+     */
+    SlotRange slot_range;
+
+    /** \brief The location of the record (including header) in the lane.
+     */
+    SlotRange lane_range;
+
+    /** \brief Set (by recovery) if this record is not part of the merged stream.
+     */
+    bool orphan;
+  };
+
+  /** \brief Identifies a record for readers.
+   */
+  struct RecordLocation {
+    usize lane_index;
+    Record record;
+  };
+
+  /** \brief The per-lane state.
+   */
+  struct Lane {
+    std::unique_ptr<LogDevice> device;
+
+    std::unique_ptr<LaneWriter> writer;
+
+    /** \brief Protects `records`.
+     */
+    std::mutex mutex;
+
+    /** \brief All records not yet trimmed from the lane, in lane order.
+     */
+    std::deque<Record> records;
+
+    /** \brief For each of speculative (0) and durable (1): the number of records at the front of
+     * `records` which have been merged (or skipped, if they are orphans).  Protected by
+     * `MultiLaneLogDevice::merge_mutex_`.
+     */
+    usize merged_count[2] = {0, 0};
+
+    /** \brief The last lane offset passed to `device->trim`.  Protected by `merge_mutex_`.
+     */
+    slot_offset_type trim_pos = 0;
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  static usize index_of_mode(LogReadMode mode) noexcept
+  {
+    return (mode == LogReadMode::kDurable) ? 1 : 0;
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  explicit MultiLaneLogDevice(std::vector<std::unique_ptr<LogDevice>>&& lanes) noexcept;
+
+  /** \brief Scans the lanes to rebuild the record index and the merged stream.
+   */
+  Status recover();
+
+  /** \brief Adds a newly committed record to the index, then advances the merged stream.
+   */
+  void add_record(usize lane_index, const Record& record);
+
+  /** \brief Advances the merged stream as far as possible.  If another thread is already doing
+   * this, it is asked to do another pass instead of waiting for it.
+   */
+  void update_merge_pos();
+
+  /** \brief Advances `merge_pos_` for both modes.  Caller must hold `merge_mutex_`.
+   */
+  void advance_merge_pos_locked();
+
+  /** \brief Blocks until the stream of the given mode reaches `min_offset`, asking lanes to flush
+   * if necessary.  Returns the new upper bound.
+   */
+  StatusOr<slot_offset_type> await_merge_pos(LogReadMode mode, slot_offset_type min_offset);
+
+  /** \brief Finds the record containing global `slot_offset`.  `lane_cursors` holds the lane
+   * offset below which each lane has already been searched, and is updated.
+   */
+  Optional<RecordLocation> find_record(slot_offset_type slot_offset,
+                                       std::vector<slot_offset_type>& lane_cursors);
+
+  /** \brief If the record at global `slot_offset` has been committed to its lane but is not yet
+   * part of the durable stream, returns its lane index and lane upper bound.
+   */
+  Optional<std::pair<usize, slot_offset_type>> find_unflushed(slot_offset_type slot_offset);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  std::vector<std::unique_ptr<Lane>> lanes_;
+
+  /** \brief The recovery epoch written to all new records.
+   */
+  u32 epoch_ = 0;
+
+  /** \brief The global offset at which the next slot will be reserved.
+   */
+  std::atomic<slot_offset_type> next_slot_offset_{0};
+
+  /** \brief Serializes advancement of the merged stream, and trimming.
+   */
+  std::mutex merge_mutex_;
+
+  /** \brief Incremented each time a merge pass is requested; see `update_merge_pos`.
+   */
+  std::atomic<u64> merge_requests_{0};
+
+  /** \brief The trimmed lower bound of the merged stream.  Only modified under `merge_mutex_`.
+   */
+  std::atomic<slot_offset_type> lower_bound_{0};
+
+  /** \brief The upper bound of the merged stream, for speculative (0) and durable (1) reads.
+   */
+  batt::Watch<slot_offset_type> merge_pos_[2];
+
+  std::atomic<bool> closed_{false};
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief The Writer for a single lane of a MultiLaneLogDevice.
+ */
+class MultiLaneLogDevice::LaneWriter : public LogDevice::Writer
+{
+ public:
+  explicit LaneWriter(MultiLaneLogDevice* device, usize lane_index) noexcept;
+
+  /** \brief The space available in this lane, minus the space used by one record header.
+   */
+  u64 space() const override;
+
+  /** \brief The global slot offset that the next slot committed by _any_ lane will be given.
+   */
+  slot_offset_type slot_offset() override;
+
+  StatusOr<MutableBuffer> prepare(usize byte_count, usize head_room = 0) override;
+
+  /** \brief Reserves the next `byte_count` bytes of the merged stream and commits the record to the
+   * lane.  Returns the global slot upper bound of the committed slot.
+   *
+   * If committing to the lane fails, the reserved range is never filled, so the merged stream will
+   * stop at that point.
+   */
+  StatusOr<slot_offset_type> commit(usize byte_count) override;
+
+  /** \brief Waits on the lane's writer.
+   */
+  Status await(LogDevice::WriterEvent event) override;
+
+ private:
+  MultiLaneLogDevice* device_;
+  usize lane_index_;
+  LogDevice::Writer& lane_writer_;
+
+  /** \brief The header location of the most recently prepared record.
+   */
+  PackedLaneRecordHeader* prepared_header_ = nullptr;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Reads the merged slot stream of a MultiLaneLogDevice.
+ *
+ * Slots are copied from the lanes into a private buffer; the memory returned by `data()` may
+ * therefore change after a call to `await`, though the bytes at a given slot offset never do.
+ */
+class MultiLaneLogDevice::ReaderImpl : public LogDevice::Reader
+{
+ public:
+  explicit ReaderImpl(MultiLaneLogDevice* device, slot_offset_type slot_lower_bound,
+                      LogReadMode mode) noexcept;
+
+  bool is_closed() override;
+
+  /** \brief Returns all data currently available without blocking.
+   */
+  ConstBuffer data() override;
+
+  slot_offset_type slot_offset() override;
+
+  void consume(usize byte_count) override;
+
+  Status await(LogDevice::ReaderEvent event) override;
+
+ private:
+  /** \brief The global offset of the end of the buffered data.
+   */
+  slot_offset_type buffered_upper_bound() const noexcept
+  {
+    return this->slot_offset_ + (this->buffer_.size() - this->consumed_);
+  }
+
+  /** \brief Copies the next slot (or the rest of the current one) into the buffer.  Returns false
+   * if `wait` is false and the slot is not yet available.
+   */
+  StatusOr<bool> append_next(bool wait);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  MultiLaneLogDevice* device_;
+  LogReadMode mode_;
+  slot_offset_type slot_offset_;
+  std::vector<std::unique_ptr<LogDevice::Reader>> lane_readers_;
+  std::vector<slot_offset_type> lane_cursors_;
+  std::vector<char> buffer_;
+  usize consumed_ = 0;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_MULTI_LANE_LOG_DEVICE_HPP
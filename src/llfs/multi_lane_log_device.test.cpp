@@ -0,0 +1,311 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/multi_lane_log_device.hpp>
+//
+#include <llfs/multi_lane_log_device.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/log_device_snapshot.hpp>
+#include <llfs/memory_log_device.hpp>
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//
+//  1. Slots committed to different lanes are read back as one stream, in commit order, in both
+//     speculative and durable modes.
+//  2. Concurrent writers on separate lanes (one thread per lane) produce a gap-free merged stream.
+//  3. Recovery discards slots that are durable in their lane but follow a lost slot, and keeps
+//     discarding them after new slots are written over their range.
+//  4. Trimming the merged stream trims each lane at a record boundary.
+//  5. Trimming the entire stream, then recovering, resumes the stream at its old upper bound.
+//
+
+using namespace llfs::int_types;
+
+using llfs::MultiLaneLogDevice;
+
+constexpr usize kLaneSize = 64 * 1024;
+
+std::vector<std::unique_ptr<llfs::LogDevice>> make_lanes(usize count)
+{
+  std::vector<std::unique_ptr<llfs::LogDevice>> lanes;
+  for (usize i = 0; i < count; ++i) {
+    lanes.emplace_back(std::make_unique<llfs::MemoryLogDevice>(kLaneSize));
+  }
+  return lanes;
+}
+
+// Commits `payload` as a single slot via `writer`; returns the new slot upper bound.
+//
+llfs::slot_offset_type append(llfs::LogDevice::Writer& writer, const std::string& payload)
+{
+  llfs::StatusOr<llfs::MutableBuffer> buffer = writer.prepare(payload.size());
+  BATT_CHECK_OK(buffer);
+  std::memcpy(buffer->data(), payload.data(), payload.size());
+
+  llfs::StatusOr<llfs::slot_offset_type> slot_upper_bound = writer.commit(payload.size());
+  BATT_CHECK_OK(slot_upper_bound);
+
+  return *slot_upper_bound;
+}
+
+// Reads the entire merged stream in the given mode.
+//
+std::string read_all(llfs::LogDevice& device, llfs::LogReadMode mode)
+{
+  const llfs::SlotRange slot_range = device.slot_range(mode);
+
+  std::unique_ptr<llfs::LogDevice::Reader> reader = device.new_reader(llfs::None, mode);
+  BATT_CHECK_OK(reader->await(llfs::SlotUpperBoundAt{.offset = slot_range.upper_bound}));
+
+  llfs::ConstBuffer data = reader->data();
+  BATT_CHECK_EQ(reader->slot_offset(), slot_range.lower_bound);
+  BATT_CHECK_EQ(data.size(), slot_range.size());
+
+  return std::string{static_cast<const char*>(data.data()), data.size()};
+}
+
+// Writes a raw record (as a MultiLaneLogDevice would) directly to a lane.
+//
+void append_raw_record(llfs::LogDevice& lane, llfs::slot_offset_type slot_offset,
+                       const std::string& payload, u32 epoch)
+{
+  llfs::PackedLaneRecordHeader header;
+  header.slot_offset = slot_offset;
+  header.size = payload.size();
+  header.epoch = epoch;
+
+  std::string record{reinterpret_cast<const char*>(&header), sizeof(header)};
+  record += payload;
+
+  append(lane.writer(), record);
+}
+
+// Recovers a new MultiLaneLogDevice from the durable contents of the lanes of `device`.
+//
+std::unique_ptr<MultiLaneLogDevice> reopen(MultiLaneLogDevice& device)
+{
+  std::vector<std::unique_ptr<llfs::LogDevice>> lanes;
+  for (usize i = 0; i < device.lane_count(); ++i) {
+    auto& lane = dynamic_cast<llfs::MemoryLogDevice&>(device.lane_device(i));
+    lanes.emplace_back(std::make_unique<llfs::MemoryLogDevice>(
+        kLaneSize, llfs::LogDeviceSnapshot::from_device(lane, llfs::LogReadMode::kDurable),
+        llfs::LogReadMode::kDurable));
+  }
+
+  llfs::StatusOr<std::unique_ptr<MultiLaneLogDevice>> reopened =
+      MultiLaneLogDevice::open(std::move(lanes));
+  BATT_CHECK_OK(reopened);
+
+  return std::move(*reopened);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  1. Slots committed to different lanes are read back as one stream, in commit order.
+//
+TEST(MultiLaneLogDeviceTest, MergeInCommitOrder)
+{
+  llfs::StatusOr<std::unique_ptr<MultiLaneLogDevice>> device =
+      MultiLaneLogDevice::open(make_lanes(3));
+  ASSERT_TRUE(device.ok()) << BATT_INSPECT(device.status());
+
+  std::string expected;
+  for (usize i = 0; i < 40; ++i) {
+    const usize lane_index = (i * 7 + i / 5) % 3;
+    const std::string payload = batt::to_string("slot ", i, " on lane ", lane_index, ";");
+
+    EXPECT_EQ((*device)->lane_writer(lane_index).slot_offset(), expected.size());
+
+    expected += payload;
+    EXPECT_EQ(append((*device)->lane_writer(lane_index), payload), expected.size());
+  }
+
+  for (llfs::LogReadMode mode : {llfs::LogReadMode::kSpeculative, llfs::LogReadMode::kDurable}) {
+    EXPECT_EQ((*device)->slot_range(mode), (llfs::SlotRange{0, expected.size()}));
+    EXPECT_EQ(read_all(**device, mode), expected);
+  }
+  EXPECT_EQ((*device)->size(), expected.size());
+
+  // Reading from the middle of a slot works too.
+  //
+  std::unique_ptr<llfs::LogDevice::Reader> reader =
+      (*device)->new_reader(/*slot_lower_bound=*/3, llfs::LogReadMode::kSpeculative);
+
+  ASSERT_TRUE(reader->await(llfs::BytesAvailable{.size = expected.size() - 3}).ok());
+  EXPECT_EQ(std::string(static_cast<const char*>(reader->data().data()), reader->data().size()),
+            expected.substr(3));
+
+  EXPECT_TRUE((*device)->close().ok());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  2. Concurrent writers on separate lanes produce a gap-free merged stream.
+//
+TEST(MultiLaneLogDeviceTest, ConcurrentLanes)
+{
+  constexpr usize kNumLanes = 4;
+  constexpr usize kSlotsPerLane = 500;
+
+  llfs::StatusOr<std::unique_ptr<MultiLaneLogDevice>> device =
+      MultiLaneLogDevice::open(make_lanes(kNumLanes));
+  ASSERT_TRUE(device.ok()) << BATT_INSPECT(device.status());
+
+  std::vector<std::thread> threads;
+  for (usize lane_index = 0; lane_index < kNumLanes; ++lane_index) {
+    threads.emplace_back([&device, lane_index] {
+      for (u32 seq = 0; seq < kSlotsPerLane; ++seq) {
+        const u32 slot[2] = {static_cast<u32>(lane_index), seq};
+        append((*device)->lane_writer(lane_index),
+               std::string(reinterpret_cast<const char*>(slot), sizeof(slot)));
+      }
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+
+  const std::string merged = read_all(**device, llfs::LogReadMode::kDurable);
+  ASSERT_EQ(merged.size(), kNumLanes * kSlotsPerLane * sizeof(u32) * 2);
+
+  // Each lane's slots must appear in order, and none may be missing.
+  //
+  std::vector<u32> next_seq(kNumLanes, 0);
+  for (usize i = 0; i < merged.size(); i += sizeof(u32) * 2) {
+    u32 slot[2];
+    std::memcpy(slot, merged.data() + i, sizeof(slot));
+
+    ASSERT_LT(slot[0], kNumLanes);
+    EXPECT_EQ(slot[1], next_seq[slot[0]]);
+    next_seq[slot[0]] = slot[1] + 1;
+  }
+  EXPECT_THAT(next_seq, ::testing::Each(kSlotsPerLane));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  3. Recovery discards orphaned slots.
+//
+TEST(MultiLaneLogDeviceTest, RecoveryDiscardsOrphans)
+{
+  std::vector<std::unique_ptr<llfs::LogDevice>> lanes = make_lanes(2);
+
+  // Simulate a crash during which the slot at [10, 20) was lost, but the one after it survived.
+  //
+  append_raw_record(*lanes[0], 0, "0123456789", /*epoch=*/0);
+  append_raw_record(*lanes[1], 20, "ORPHAN----", /*epoch=*/0);
+
+  llfs::StatusOr<std::unique_ptr<MultiLaneLogDevice>> device =
+      MultiLaneLogDevice::open(std::move(lanes));
+  ASSERT_TRUE(device.ok()) << BATT_INSPECT(device.status());
+
+  EXPECT_EQ((*device)->slot_range(llfs::LogReadMode::kDurable), (llfs::SlotRange{0, 10}));
+  EXPECT_EQ(read_all(**device, llfs::LogReadMode::kDurable), "0123456789");
+
+  // New slots are written over the range of the orphan, on both lanes.
+  //
+  EXPECT_EQ(append((*device)->lane_writer(0), "abcdefghijklmno"), 25u);
+  EXPECT_EQ(append((*device)->lane_writer(1), "XYZ"), 28u);
+
+  const std::string expected = "0123456789abcdefghijklmnoXYZ";
+  EXPECT_EQ(read_all(**device, llfs::LogReadMode::kDurable), expected);
+
+  // The orphan must stay buried across (repeated) recovery.
+  //
+  std::unique_ptr<MultiLaneLogDevice> reopened = reopen(**device);
+  EXPECT_EQ(read_all(*reopened, llfs::LogReadMode::kDurable), expected);
+
+  EXPECT_EQ(append(reopened->lane_writer(1), "!"), 29u);
+
+  std::unique_ptr<MultiLaneLogDevice> reopened2 = reopen(*reopened);
+  EXPECT_EQ(read_all(*reopened2, llfs::LogReadMode::kDurable), expected + "!");
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  4. Trimming the merged stream trims each lane at a record boundary.
+//
+TEST(MultiLaneLogDeviceTest, Trim)
+{
+  llfs::StatusOr<std::unique_ptr<MultiLaneLogDevice>> device =
+      MultiLaneLogDevice::open(make_lanes(2));
+  ASSERT_TRUE(device.ok()) << BATT_INSPECT(device.status());
+
+  append((*device)->lane_writer(0), "aaaa");  // [0, 4)
+  append((*device)->lane_writer(1), "bbbb");  // [4, 8)
+  append((*device)->lane_writer(0), "cccc");  // [8, 12)
+  append((*device)->lane_writer(1), "dddd");  // [12, 16)
+
+  // Trimming in the middle of [4, 8) only drops the first record of lane 0.
+  //
+  ASSERT_TRUE((*device)->trim(6).ok());
+
+  EXPECT_EQ((*device)->slot_range(llfs::LogReadMode::kDurable), (llfs::SlotRange{6, 16}));
+  EXPECT_EQ((*device)->lane_device(0).slot_range(llfs::LogReadMode::kDurable).lower_bound,
+            MultiLaneLogDevice::kHeaderSize + 4);
+  EXPECT_EQ((*device)->lane_device(1).slot_range(llfs::LogReadMode::kDurable).lower_bound, 0u);
+
+  // After recovery, the stream starts at the first remaining record.
+  //
+  std::unique_ptr<MultiLaneLogDevice> reopened = reopen(**device);
+  EXPECT_EQ(reopened->slot_range(llfs::LogReadMode::kDurable), (llfs::SlotRange{4, 16}));
+  EXPECT_EQ(read_all(*reopened, llfs::LogReadMode::kDurable), "bbbbccccdddd");
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  5. Trimming the entire stream, then recovering, resumes the stream at its old upper bound.
+//
+TEST(MultiLaneLogDeviceTest, FullTrimThenRecover)
+{
+  llfs::StatusOr<std::unique_ptr<MultiLaneLogDevice>> device =
+      MultiLaneLogDevice::open(make_lanes(2));
+  ASSERT_TRUE(device.ok()) << BATT_INSPECT(device.status());
+
+  append((*device)->lane_writer(0), "aaaa");  // [0, 4)
+  append((*device)->lane_writer(1), "bbbb");  // [4, 8)
+  append((*device)->lane_writer(0), "cccc");  // [8, 12)
+  append((*device)->lane_writer(1), "dddd");  // [12, 16)
+
+  ASSERT_TRUE((*device)->trim(16).ok());
+  EXPECT_EQ((*device)->slot_range(llfs::LogReadMode::kDurable), (llfs::SlotRange{16, 16}));
+
+  // Only the last record ([12, 16), on lane 1) is left in the lanes.
+  //
+  EXPECT_EQ((*device)->lane_device(0).slot_range(llfs::LogReadMode::kDurable).size(), 0u);
+  EXPECT_EQ((*device)->lane_device(1).slot_range(llfs::LogReadMode::kDurable).size(),
+            MultiLaneLogDevice::kHeaderSize + 4);
+
+  EXPECT_TRUE((*device)->close().ok());
+
+  // The stream must not restart at 0; the last record may reappear (it was only trimmed up to a
+  // record boundary), but new slots must continue after it.
+  //
+  std::unique_ptr<MultiLaneLogDevice> reopened = reopen(**device);
+  EXPECT_EQ(reopened->slot_range(llfs::LogReadMode::kDurable), (llfs::SlotRange{12, 16}));
+
+  EXPECT_EQ(reopened->lane_writer(0).slot_offset(), 16u);
+  EXPECT_EQ(append(reopened->lane_writer(0), "eeee"), 20u);
+  EXPECT_EQ(append(reopened->lane_writer(1), "ff"), 22u);
+
+  ASSERT_TRUE(reopened->trim(22).ok());
+
+  std::unique_ptr<MultiLaneLogDevice> reopened2 = reopen(*reopened);
+  EXPECT_EQ(reopened2->slot_range(llfs::LogReadMode::kDurable), (llfs::SlotRange{20, 22}));
+  EXPECT_EQ(read_all(*reopened2, llfs::LogReadMode::kDurable), "ff");
+
+  EXPECT_EQ(append(reopened2->lane_writer(0), "g"), 23u);
+  EXPECT_EQ(read_all(*reopened2, llfs::LogReadMode::kDurable), "ffg");
+}
+
+}  // namespace
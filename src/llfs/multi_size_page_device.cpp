@@ -0,0 +1,249 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/multi_size_page_device.hpp>
+//
+
+#include <llfs/logging.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/checked_cast.hpp>
+
+namespace llfs {
+
+namespace {
+
+// The smallest page size supported by a MultiSizePageDevice; also the granularity of its
+// BuddyAllocator.
+//
+constexpr u64 kMinPageSize = 512;
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ MultiSizePageDevice::MultiSizePageDevice(
+    u64 capacity_bytes, const batt::Slice<const SizeClassConfig>& size_classes) noexcept
+    : capacity_bytes_{capacity_bytes}
+    , extents_{capacity_bytes, kMinPageSize}
+{
+  BATT_CHECK(!size_classes.empty());
+
+  for (const SizeClassConfig& config : size_classes) {
+    const u64 page_size = config.page_size;
+
+    BATT_CHECK_GE(page_size, kMinPageSize);
+    BATT_CHECK_EQ(page_size & (page_size - 1), 0u) << "page sizes must be powers of two";
+    BATT_CHECK_LE(page_size, capacity_bytes);
+
+    for (const std::unique_ptr<SizeClass>& prev : this->size_classes_) {
+      BATT_CHECK_NE(prev->page_size(), config.page_size) << "duplicate size class";
+      BATT_CHECK_NE(prev->page_ids().get_device_id(), config.device_id) << "duplicate device id";
+    }
+
+    this->size_classes_.emplace_back(std::make_unique<SizeClass>(this, config));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 MultiSizePageDevice::bytes_free()
+{
+  return this->extents_.lock()->bytes_free();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageDevice& MultiSizePageDevice::size_class(usize i)
+{
+  BATT_CHECK_LT(i, this->size_classes_.size());
+
+  return *this->size_classes_[i];
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageDevice* MultiSizePageDevice::find_size_class(PageSize page_size)
+{
+  for (const std::unique_ptr<SizeClass>& size_class : this->size_classes_) {
+    if (size_class->page_size() == page_size) {
+      return size_class.get();
+    }
+  }
+  return nullptr;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<u64> MultiSizePageDevice::find_extent(PageId page_id)
+{
+  const page_device_id_int device_id = PageIdFactory::get_device_id(page_id);
+
+  for (const std::unique_ptr<SizeClass>& size_class : this->size_classes_) {
+    if (size_class->page_ids().get_device_id() == device_id) {
+      return size_class->find_extent(page_id);
+    }
+  }
+  return None;
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class MultiSizePageDevice::SizeClass
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ MultiSizePageDevice::SizeClass::SizeClass(MultiSizePageDevice* device,
+                                                       const SizeClassConfig& config) noexcept
+    : device_{device}
+    , page_ids_{PageCount{device->capacity_bytes() / config.page_size}, config.device_id}
+    , page_size_{config.page_size}
+{
+  this->state_.lock()->page_recs.resize(this->page_ids_.get_physical_page_count());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageIdFactory MultiSizePageDevice::SizeClass::page_ids()
+{
+  return this->page_ids_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageSize MultiSizePageDevice::SizeClass::page_size()
+{
+  return this->page_size_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::shared_ptr<PageBuffer>> MultiSizePageDevice::SizeClass::prepare(PageId page_id)
+{
+  return PageBuffer::allocate(this->page_size_, page_id);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MultiSizePageDevice::SizeClass::write(std::shared_ptr<const PageBuffer>&& buffer,
+                                           WriteHandler&& handler)
+{
+  BATT_CHECK_NOT_NULLPTR(buffer);
+
+  auto result = [&]() -> Status {
+    const auto physical_page = this->page_ids_.get_physical_page(buffer->page_id());
+    const auto generation = this->page_ids_.get_generation(buffer->page_id());
+
+    auto locked = this->state_.lock();
+
+    LLFS_VLOG(1) << "write " << BATT_INSPECT(physical_page) << BATT_INSPECT(generation)
+                 << BATT_INSPECT(buffer->page_id()) << BATT_INSPECT(this->page_size_);
+
+    BATT_CHECK_LT(physical_page, batt::checked_cast<i64>(locked->page_recs.size()));
+    PageRec& rec = locked->page_recs[physical_page];
+    BATT_CHECK(this->page_ids_.generation_less_than(rec.generation, generation))
+        << "\n  current generation = " << rec.generation
+        << "\n  write generation =   " << generation;
+
+    // A physical page that is overwritten without being dropped keeps its extent.
+    //
+    if (!rec.extent) {
+      rec.extent = this->device_->extents_.lock()->allocate(this->page_size_);
+      if (!rec.extent) {
+        return {batt::StatusCode::kResourceExhausted};
+      }
+    }
+
+    rec.page = std::move(buffer);
+    rec.generation = generation;
+
+    return OkStatus();
+  }();
+
+  handler(result);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MultiSizePageDevice::SizeClass::read(PageId page_id, ReadHandler&& handler)
+{
+  auto result = [&]() -> StatusOr<std::shared_ptr<const PageBuffer>> {
+    const auto physical_page = this->page_ids_.get_physical_page(page_id);
+    const auto requested_generation = this->page_ids_.get_generation(page_id);
+
+    auto locked = this->state_.lock();
+
+    BATT_CHECK_LT(physical_page, batt::checked_cast<i64>(locked->page_recs.size()));
+    const PageRec& rec = locked->page_recs[physical_page];
+    if (rec.generation != requested_generation || rec.page == nullptr) {
+      LLFS_VLOG(1) << "failing read with `kNotFound`;" << BATT_INSPECT(page_id)
+                   << BATT_INSPECT(requested_generation) << BATT_INSPECT(rec.generation)
+                   << BATT_INSPECT((const void*)rec.page.get());
+      return Status{batt::StatusCode::kNotFound};
+    }
+
+    return rec.page;
+  }();
+
+  BATT_CHECK(handler);
+  std::move(handler)(result);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void MultiSizePageDevice::SizeClass::drop(PageId page_id, WriteHandler&& handler)
+{
+  auto result = [&]() -> Status {
+    const auto physical_page = this->page_ids_.get_physical_page(page_id);
+    const auto generation_to_drop = this->page_ids_.get_generation(page_id);
+
+    LLFS_VLOG(1) << "drop " << BATT_INSPECT(physical_page) << BATT_INSPECT(generation_to_drop)
+                 << BATT_INSPECT(page_id) << BATT_INSPECT(this->page_size_);
+
+    auto locked = this->state_.lock();
+
+    BATT_CHECK_LT(physical_page, batt::checked_cast<i64>(locked->page_recs.size()));
+    PageRec& rec = locked->page_recs[physical_page];
+
+    // As in MemoryPageDevice, a generation mismatch means the physical page has already been
+    // reallocated, so there is nothing to drop.
+    //
+    if (rec.generation == generation_to_drop) {
+      rec.page = nullptr;
+      if (rec.extent) {
+        this->device_->extents_.lock()->free(*rec.extent, this->page_size_);
+        rec.extent = None;
+      }
+    } else {
+      LLFS_VLOG(1) << " -- skipping drop " << BATT_INSPECT(page_id)
+                   << BATT_INSPECT(rec.generation) << BATT_INSPECT(generation_to_drop);
+    }
+
+    return OkStatus();
+  }();
+
+  handler(result);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<u64> MultiSizePageDevice::SizeClass::find_extent(PageId page_id)
+{
+  const auto physical_page = this->page_ids_.get_physical_page(page_id);
+  const auto generation = this->page_ids_.get_generation(page_id);
+
+  auto locked = this->state_.lock();
+
+  BATT_CHECK_LT(physical_page, batt::checked_cast<i64>(locked->page_recs.size()));
+  const PageRec& rec = locked->page_recs[physical_page];
+  if (rec.generation != generation || rec.page == nullptr) {
+    return None;
+  }
+  return rec.extent;
+}
+
+}  // namespace llfs
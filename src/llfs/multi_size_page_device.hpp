@@ -0,0 +1,138 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_MULTI_SIZE_PAGE_DEVICE_HPP
+#define LLFS_MULTI_SIZE_PAGE_DEVICE_HPP
+
+#include <llfs/buddy_allocator.hpp>
+#include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/page_device.hpp>
+#include <llfs/page_size.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/async/mutex.hpp>
+#include <batteries/slice.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief An in-memory page device with several page sizes that share one pool of capacity.
+ *
+ * Each size class is exposed as its own PageDevice (see `size_class(i)`), with its own device id
+ * and therefore its own PageIdFactory bits, so that it can back a separate PageArena.  Unlike a
+ * set of MemoryPageDevice objects, the size classes do not each own a fixed number of pages:
+ * writing a page takes an extent of the page's size from a BuddyAllocator for the whole device,
+ * and dropping the page gives it back.  Space freed by one size class is thus available to all the
+ * others, e.g. sixteen dropped 4 KiB pages (when buddies) can be reused as one 64 KiB page.
+ *
+ * Because any one size class may use all of the capacity, each class's PageIdFactory has
+ * `capacity_bytes / page_size` physical pages; the PageAllocator for a class may therefore hand
+ * out ids that can't be written because the pool is full, in which case `write` fails with
+ * `batt::StatusCode::kResourceExhausted`.
+ */
+class MultiSizePageDevice
+{
+ public:
+  struct SizeClassConfig {
+    page_device_id_int device_id;
+    PageSize page_size;
+  };
+
+  class SizeClass;
+
+  /** \brief Creates a device with `capacity_bytes` of (shared) capacity and one size class per
+   * element of `size_classes`.  Page sizes must be powers of two, at least 512 bytes, and no larger
+   * than `capacity_bytes`; device ids must be unique.
+   */
+  explicit MultiSizePageDevice(u64 capacity_bytes,
+                               const batt::Slice<const SizeClassConfig>& size_classes) noexcept;
+
+  MultiSizePageDevice(const MultiSizePageDevice&) = delete;
+  MultiSizePageDevice& operator=(const MultiSizePageDevice&) = delete;
+
+  u64 capacity_bytes() const
+  {
+    return this->capacity_bytes_;
+  }
+
+  /** \brief The number of bytes not currently used by any size class.
+   */
+  u64 bytes_free();
+
+  usize size_class_count() const
+  {
+    return this->size_classes_.size();
+  }
+
+  /** \brief Returns the PageDevice for size class `i` (in the order passed to the constructor).
+   */
+  PageDevice& size_class(usize i);
+
+  /** \brief Returns the PageDevice whose page size is `page_size`, or nullptr if there is none.
+   */
+  PageDevice* find_size_class(PageSize page_size);
+
+  /** \brief Returns the offset within the device of the extent holding `page_id`, or None if the
+   * page isn't currently written.
+   */
+  Optional<u64> find_extent(PageId page_id);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  const u64 capacity_bytes_;
+  batt::Mutex<BuddyAllocator> extents_;
+  std::vector<std::unique_ptr<SizeClass>> size_classes_;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief The PageDevice for a single page size of a MultiSizePageDevice.
+ */
+class MultiSizePageDevice::SizeClass : public PageDevice
+{
+ public:
+  explicit SizeClass(MultiSizePageDevice* device, const SizeClassConfig& config) noexcept;
+
+  PageIdFactory page_ids() override;
+
+  PageSize page_size() override;
+
+  StatusOr<std::shared_ptr<PageBuffer>> prepare(PageId page_id) override;
+
+  void write(std::shared_ptr<const PageBuffer>&& buffer, WriteHandler&& handler) override;
+
+  void read(PageId page_id, ReadHandler&& handler) override;
+
+  void drop(PageId page_id, WriteHandler&& handler) override;
+
+  Optional<u64> find_extent(PageId page_id);
+
+ private:
+  struct PageRec {
+    std::shared_ptr<const PageBuffer> page;
+    page_generation_int generation = 0;
+    Optional<u64> extent;
+  };
+
+  struct State {
+    std::vector<PageRec> page_recs;
+  };
+
+  MultiSizePageDevice* const device_;
+  const PageIdFactory page_ids_;
+  const PageSize page_size_;
+  batt::Mutex<State> state_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_MULTI_SIZE_PAGE_DEVICE_HPP
@@ -0,0 +1,196 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/multi_size_page_device.hpp>
+//
+#include <llfs/multi_size_page_device.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/page_buffer.hpp>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+using namespace llfs::int_types;
+
+// Test Plan:
+//  1. Each size class reports its own page size and device id; pages written to one class can be
+//     read back, and reads of dropped pages or stale generations fail with kNotFound.
+//  2. When one size class has used all the capacity, writes to the others fail with
+//     kResourceExhausted; dropping pages from the first class makes room for the others.
+
+constexpr u64 kSmallPageSize = 4096;
+constexpr u64 kLargePageSize = 16384;
+
+llfs::Status write_page(llfs::PageDevice& device, llfs::PageId page_id, char fill)
+{
+  llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer = device.prepare(page_id);
+  BATT_REQUIRE_OK(buffer);
+
+  llfs::MutableBuffer payload = (*buffer)->mutable_payload();
+  std::memset(payload.data(), fill, payload.size());
+
+  llfs::Status result;
+  device.write(std::move(*buffer), [&result](llfs::Status status) {
+    result = status;
+  });
+  return result;
+}
+
+llfs::StatusOr<char> read_page(llfs::PageDevice& device, llfs::PageId page_id)
+{
+  llfs::StatusOr<std::shared_ptr<const llfs::PageBuffer>> result;
+  device.read(page_id, [&result](llfs::PageDevice::ReadResult r) {
+    result = std::move(r);
+  });
+  BATT_REQUIRE_OK(result);
+
+  return static_cast<const char*>((*result)->const_payload().data())[0];
+}
+
+void expect_page_data(llfs::PageDevice& device, llfs::PageId page_id, char fill)
+{
+  llfs::StatusOr<char> data = read_page(device, page_id);
+  ASSERT_TRUE(data.ok()) << BATT_INSPECT(data.status()) << BATT_INSPECT(page_id);
+  EXPECT_EQ(*data, fill);
+}
+
+llfs::Status drop_page(llfs::PageDevice& device, llfs::PageId page_id)
+{
+  llfs::Status result;
+  device.drop(page_id, [&result](llfs::Status status) {
+    result = status;
+  });
+  return result;
+}
+
+class MultiSizePageDeviceTest : public ::testing::Test
+{
+ public:
+  static constexpr u64 kCapacity = 64 * 1024;
+
+  MultiSizePageDeviceTest()
+      : configs_{{/*device_id=*/3, llfs::PageSize{kSmallPageSize}},
+                 {/*device_id=*/4, llfs::PageSize{kLargePageSize}}}
+      , device_{kCapacity, batt::as_slice(this->configs_)}
+  {
+  }
+
+  llfs::PageDevice& small()
+  {
+    return this->device_.size_class(0);
+  }
+
+  llfs::PageDevice& large()
+  {
+    return this->device_.size_class(1);
+  }
+
+  std::vector<llfs::MultiSizePageDevice::SizeClassConfig> configs_;
+  llfs::MultiSizePageDevice device_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(MultiSizePageDeviceTest, ReadWriteDrop)
+{
+  EXPECT_EQ(this->device_.size_class_count(), 2u);
+  EXPECT_EQ(this->small().page_size(), kSmallPageSize);
+  EXPECT_EQ(this->large().page_size(), kLargePageSize);
+  EXPECT_EQ(this->small().page_ids().get_device_id(), 3u);
+  EXPECT_EQ(this->large().page_ids().get_device_id(), 4u);
+  EXPECT_EQ(this->small().page_ids().get_physical_page_count(), kCapacity / kSmallPageSize);
+  EXPECT_EQ(this->device_.find_size_class(llfs::PageSize{kLargePageSize}), &this->large());
+  EXPECT_EQ(this->device_.find_size_class(llfs::PageSize{8192}), nullptr);
+
+  const llfs::PageId small_id = this->small().page_ids().make_page_id(5, 1);
+  const llfs::PageId large_id = this->large().page_ids().make_page_id(0, 1);
+
+  ASSERT_TRUE(write_page(this->small(), small_id, 'a').ok());
+  ASSERT_TRUE(write_page(this->large(), large_id, 'b').ok());
+
+  EXPECT_EQ(this->device_.bytes_free(), kCapacity - kSmallPageSize - kLargePageSize);
+  EXPECT_TRUE(this->device_.find_extent(small_id));
+  EXPECT_TRUE(this->device_.find_extent(large_id));
+
+  expect_page_data(this->small(), small_id, 'a');
+  expect_page_data(this->large(), large_id, 'b');
+
+  const llfs::PageId stale_id = this->small().page_ids().make_page_id(5, 2);
+  EXPECT_EQ(read_page(this->small(), stale_id).status(), batt::StatusCode::kNotFound);
+
+  ASSERT_TRUE(drop_page(this->small(), small_id).ok());
+
+  EXPECT_EQ(read_page(this->small(), small_id).status(), batt::StatusCode::kNotFound);
+  EXPECT_FALSE(this->device_.find_extent(small_id));
+  EXPECT_EQ(this->device_.bytes_free(), kCapacity - kLargePageSize);
+
+  // Overwriting a page with a newer generation reuses its extent.
+  //
+  const llfs::Optional<u64> large_extent = this->device_.find_extent(large_id);
+  const llfs::PageId next_large_id = this->large().page_ids().advance_generation(large_id);
+
+  ASSERT_TRUE(write_page(this->large(), next_large_id, 'c').ok());
+
+  expect_page_data(this->large(), next_large_id, 'c');
+  EXPECT_EQ(this->device_.find_extent(next_large_id), large_extent);
+  EXPECT_EQ(this->device_.bytes_free(), kCapacity - kLargePageSize);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(MultiSizePageDeviceTest, SharedCapacity)
+{
+  const usize small_count = kCapacity / kSmallPageSize;
+
+  std::vector<llfs::PageId> small_ids;
+  for (usize i = 0; i < small_count; ++i) {
+    small_ids.emplace_back(this->small().page_ids().make_page_id(i, 1));
+    ASSERT_TRUE(write_page(this->small(), small_ids.back(), 's').ok());
+  }
+  EXPECT_EQ(this->device_.bytes_free(), 0u);
+
+  const llfs::PageId large_id = this->large().page_ids().make_page_id(0, 1);
+  EXPECT_EQ(write_page(this->large(), large_id, 'L'), batt::StatusCode::kResourceExhausted);
+  EXPECT_EQ(read_page(this->large(), large_id).status(), batt::StatusCode::kNotFound);
+
+  // Drop every other small page: half the capacity is free, but no 16 KiB-aligned range is entirely
+  // free, so a large page still doesn't fit.
+  //
+  for (usize i = 0; i < small_count; i += 2) {
+    ASSERT_TRUE(drop_page(this->small(), small_ids[i]).ok());
+  }
+  EXPECT_EQ(this->device_.bytes_free(), kCapacity / 2);
+  EXPECT_EQ(write_page(this->large(), large_id, 'L'), batt::StatusCode::kResourceExhausted);
+
+  // Drop the small pages whose extents make up the first large extent.
+  //
+  for (usize i = 0; i < small_count; i += 2) {
+    const llfs::Optional<u64> extent = this->device_.find_extent(small_ids[i + 1]);
+    ASSERT_TRUE(extent);
+    if (*extent < kLargePageSize) {
+      ASSERT_TRUE(drop_page(this->small(), small_ids[i + 1]).ok());
+    }
+  }
+
+  ASSERT_TRUE(write_page(this->large(), large_id, 'L').ok());
+  expect_page_data(this->large(), large_id, 'L');
+  EXPECT_EQ(this->device_.find_extent(large_id), llfs::Optional<u64>{0});
+
+  // The remaining small pages are unaffected.
+  //
+  for (usize i = kLargePageSize / kSmallPageSize + 1; i < small_count; i += 2) {
+    expect_page_data(this->small(), small_ids[i], 's');
+  }
+}
+
+}  // namespace
@@ -0,0 +1,340 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/multi_volume_job.hpp>
+//
+
+#include <llfs/appendable_job.hpp>
+#include <llfs/committable_page_cache_job.hpp>
+#include <llfs/logging.hpp>
+#include <llfs/page_write_op.hpp>
+#include <llfs/volume_metadata_refresher.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/finally.hpp>
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::vector<SlotRange>> append_multi_volume_job(std::unique_ptr<PageCacheJob>&& job,
+                                                         std::vector<MultiVolumeJobPart>&& parts,
+                                                         batt::WaitForResource wait_for_log_space)
+{
+  if (!job || parts.empty()) {
+    return {batt::StatusCode::kInvalidArgument};
+  }
+  {
+    std::unordered_set<const Volume*> distinct_volumes;
+    for (const MultiVolumeJobPart& part : parts) {
+      if (part.volume == nullptr || &part.volume->cache() != &job->cache() ||
+          !distinct_volumes.emplace(part.volume).second) {
+        return {batt::StatusCode::kInvalidArgument};
+      }
+    }
+  }
+
+  Volume& coordinator = *parts.front().volume;
+
+  // The roots of every participant are roots of the shared job; they are also recorded in the
+  // coordinator's link slot so that recovery can recalculate the job's ref counts.
+  //
+  std::vector<PageId> participant_root_ids;
+  for (usize i = 1; i < parts.size(); ++i) {
+    trace_refs(parts[i].user_data)  //
+        | seq::filter([](const PageId& page_id) {
+            return page_id.is_valid();
+          })  //
+        | seq::for_each([&](const PageId& page_id) {
+            participant_root_ids.emplace_back(page_id);
+            job->new_root(page_id);
+          });
+  }
+
+  StatusOr<AppendableJob> appendable =
+      make_appendable_job(std::move(job), batt::make_copy(parts.front().user_data));
+
+  BATT_REQUIRE_OK(appendable);
+
+  if (appendable->job.page_device_count() == 0) {
+    return {batt::StatusCode::kInvalidArgument};
+  }
+
+  // The coordinator's write policy applies to the whole job.
+  //
+  const bool write_new_pages_early = coordinator.should_write_new_pages_early(appendable->job);
+  if (write_new_pages_early) {
+    BATT_REQUIRE_OK(appendable->job.start_writing_new_pages());
+  }
+
+  // The per-Volume state of the job.
+  //
+  struct PreparedPart {
+    Optional<PrepareJob> prepare_job;
+    usize link_slot_size = 0;
+    Optional<batt::Grant> grant;
+    Optional<SlotReadLock> trim_lock;
+    Optional<PendingSlotRing::Ticket> pending_job;
+    Optional<SlotParseWithPayload<const PackedPrepareJob*>> prepare_slot;
+    slot_offset_type link_slot_upper_bound = 0;
+  };
+
+  std::vector<PreparedPart> prepared(parts.size());
+
+  // Every prepare slot is pending until it is committed or rolled back (or this call fails), and
+  // protected from trimming until then.
+  //
+  const auto retire_pending_jobs = batt::finally([&] {
+    for (usize i = 0; i < parts.size(); ++i) {
+      if (prepared[i].pending_job) {
+        parts[i].volume->metadata_refresher_->remove_pending_job(*prepared[i].pending_job);
+      }
+    }
+  });
+
+  // The commit decision is made at the coordinator's prepare slot.
+  //
+  Optional<slot_offset_type> decision_slot;
+
+  // The coordinator's previous user slot; its ref count updates must follow those of its earlier
+  // jobs.
+  //
+  Optional<slot_offset_type> prev_user_slot;
+
+  // Once the coordinator's prepare slot is written, later jobs of the coordinator wait (in commit)
+  // for `coordinator.durable_user_slot_` to reach `decision_slot`; so every failure from then on
+  // must resolve this job, one way or another, before returning.
+  //
+  const auto abort_job = [&](const Status& status) -> Status {
+    if (!prev_user_slot) {
+      return status;
+    }
+
+    LLFS_LOG_WARNING() << "append_multi_volume_job: rolling back after error"
+                       << BATT_INSPECT(status) << BATT_INSPECT(decision_slot);
+
+    const Status rollback_status = [&]() -> Status {
+      // No early page writes may still be in flight once the new pages are dropped.
+      //
+      if (write_new_pages_early) {
+        appendable->job.write_new_pages().IgnoreError();
+      }
+      BATT_REQUIRE_OK(parallel_drop_pages(appendable->job.new_page_ids() | seq::collect_vec(),
+                                          coordinator.cache(), appendable->job.job_id(),
+                                          Caller::Unknown));
+
+      // Roll back every prepare slot (using the log space reserved for its commit slot), and make
+      // sure the rollbacks are durable before any later job of the coordinator can update ref
+      // counts; otherwise recovery could take that update as this job's commit decision.
+      //
+      for (usize i = 0; i < parts.size(); ++i) {
+        PreparedPart& part = prepared[i];
+        if (!part.prepare_slot) {
+          continue;
+        }
+        StatusOr<SlotRange> rollback_slot = parts[i].volume->slot_writer_->append(
+            *part.grant, PackedRollbackJob{
+                             .prepare_slot = part.prepare_slot->slot.offset.lower_bound,
+                         });
+        BATT_REQUIRE_OK(rollback_slot);
+
+        BATT_REQUIRE_OK(parts[i].volume->slot_writer_->sync(
+            LogReadMode::kDurable, SlotUpperBoundAt{rollback_slot->upper_bound}));
+      }
+
+      BATT_REQUIRE_OK(await_slot_offset(*prev_user_slot, coordinator.durable_user_slot_));
+      return OkStatus();
+    }();
+
+    if (rollback_status.ok()) {
+      coordinator.durable_user_slot_.set_value(*decision_slot);
+    } else {
+      // The job can only be resolved by recovery now; fail the coordinator's later jobs instead of
+      // leaving them waiting forever.
+      //
+      LLFS_LOG_ERROR() << "append_multi_volume_job: rollback failed; the coordinator must be "
+                          "recovered before it can commit more jobs"
+                       << BATT_INSPECT(rollback_status) << BATT_INSPECT(decision_slot);
+
+      coordinator.durable_user_slot_.close();
+    }
+
+    return status;
+  };
+
+  // Build every prepare slot and reserve the log space for all the Volumes before appending
+  // anything, so that a lack of log space can't fail the job halfway through phase 1.
+  //
+  for (usize i = 0; i < parts.size(); ++i) {
+    Volume& volume = *parts[i].volume;
+    PreparedPart& part = prepared[i];
+    const bool is_coordinator = (i == 0);
+
+    part.prepare_job.emplace(prepare(*appendable));
+    if (!is_coordinator) {
+      // A participant's prepare has only its own user data (and root refs), plus the devices that
+      // recovery must check for the commit decision.
+      //
+      part.prepare_job->new_page_ids = seq::Empty<PageId>{} | seq::boxed();
+      part.prepare_job->deleted_page_ids = seq::Empty<PageId>{} | seq::boxed();
+      part.prepare_job->user_data = parts[i].user_data;
+    }
+
+    // The link size only depends on the number of extra roots, so we can calculate it before we
+    // know the prepare slot.
+    //
+    const usize extra_root_count = is_coordinator ? participant_root_ids.size() : 0;
+    part.link_slot_size = packed_sizeof_slot_with_payload_size(
+        sizeof(PackedPrepareJobLink) + packed_array_size<PackedPageId>(extra_root_count));
+
+    // The last slot is either the commit or the rollback.
+    //
+    const usize resolve_slot_size = std::max(packed_sizeof_commit_slot(*part.prepare_job),
+                                             packed_sizeof_slot(PackedRollbackJob{}));
+
+    StatusOr<batt::Grant> grant =
+        volume.reserve(packed_sizeof_slot(*part.prepare_job) + part.link_slot_size +
+                           resolve_slot_size,
+                       wait_for_log_space);
+
+    BATT_REQUIRE_OK(grant);
+    part.grant.emplace(std::move(*grant));
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+  // Phase 1: Append a prepare and link slot to each Volume, coordinator first.
+  //
+  for (usize i = 0; i < parts.size(); ++i) {
+    Volume& volume = *parts[i].volume;
+    PreparedPart& part = prepared[i];
+    const bool is_coordinator = (i == 0);
+
+    StatusOr<SlotParseWithPayload<const PackedPrepareJob*>> prepare_slot =
+        volume.slot_writer_->typed_append(
+            *part.grant, std::move(*part.prepare_job),
+            [&volume, &part, &prev_user_slot, is_coordinator](StatusOr<SlotRange> slot_range) {
+              if (slot_range.ok()) {
+                part.trim_lock.emplace(BATT_OK_RESULT_OR_PANIC(volume.trim_control_->lock_slots(
+                    *slot_range, "append_multi_volume_job")));
+
+                part.pending_job =
+                    volume.metadata_refresher_->add_pending_job(slot_range->lower_bound);
+
+                // Only the coordinator updates ref counts, so only its user slot sequence
+                // advances.
+                //
+                if (is_coordinator) {
+                  prev_user_slot = volume.latest_user_slot_.exchange(slot_range->lower_bound);
+                }
+              }
+              return slot_range;
+            });
+
+    if (!prepare_slot.ok()) {
+      return abort_job(prepare_slot.status());
+    }
+    part.prepare_slot.emplace(std::move(*prepare_slot));
+
+    const slot_offset_type prepare_slot_offset = part.prepare_slot->slot.offset.lower_bound;
+    if (is_coordinator) {
+      BATT_CHECK(prev_user_slot);
+      decision_slot = prepare_slot_offset;
+    }
+
+    StatusOr<SlotRange> link_slot = volume.slot_writer_->append(
+        *part.grant, PrepareJobLink{
+                         .decision_uuid = coordinator.get_volume_uuid(),
+                         .prepare_slot = prepare_slot_offset,
+                         .decision_slot = *decision_slot,
+                         .extra_root_page_ids = is_coordinator ? participant_root_ids
+                                                               : std::vector<PageId>{},
+                     });
+
+    if (!link_slot.ok()) {
+      return abort_job(link_slot.status());
+    }
+    part.link_slot_upper_bound = link_slot->upper_bound;
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+  // Phase 2: Wait for all the prepare/link slots to be flushed.  The flushes of the different logs
+  // proceed concurrently, so this takes about as long as the slowest one.
+  //
+  for (usize i = 0; i < parts.size(); ++i) {
+    Status sync_status = parts[i].volume->slot_writer_->sync(
+        LogReadMode::kDurable, SlotUpperBoundAt{prepared[i].link_slot_upper_bound});
+
+    if (!sync_status.ok()) {
+      return abort_job(sync_status);
+    }
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+  // Phase 3: Commit the job as the coordinator.  Once any ref count update is durable, the job
+  // will be committed by recovery in all Volumes.
+  //
+  const JobCommitParams params{
+      .caller_uuid = &coordinator.get_volume_uuid(),
+      .caller_slot = *decision_slot,
+      .recycler = as_ref(*coordinator.recycler_),
+      .recycle_grant = nullptr,
+      .recycle_depth = -1,
+  };
+
+  Status commit_status = commit(std::move(appendable->job), params, Caller::Unknown,
+                                *prev_user_slot, &coordinator.durable_user_slot_);
+
+  if (!commit_status.ok()) {
+    // Some ref count updates may already be durable, so the job can't be rolled back here; only
+    // recovery can tell whether it was committed.
+    //
+    LLFS_LOG_ERROR() << "append_multi_volume_job: commit failed; the coordinator must be recovered "
+                        "before it can commit more jobs"
+                     << BATT_INSPECT(commit_status) << BATT_INSPECT(decision_slot);
+
+    coordinator.durable_user_slot_.close();
+    return commit_status;
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+  // Phase 4: Write the commit slots; these needn't be flushed before returning, since the decision
+  // is already durable.
+  //
+  std::vector<SlotRange> result;
+  result.reserve(parts.size());
+
+  for (usize i = 0; i < parts.size(); ++i) {
+    Volume& volume = *parts[i].volume;
+    PreparedPart& part = prepared[i];
+
+    const slot_offset_type prepare_slot_offset = part.prepare_slot->slot.offset.lower_bound;
+
+    StatusOr<SlotRange> commit_slot = volume.slot_writer_->append(
+        *part.grant, CommitJob{
+                         .prepare_slot_offset = prepare_slot_offset,
+                         .packed_prepare = part.prepare_slot->payload,
+                     });
+
+    BATT_REQUIRE_OK(commit_slot);
+
+    result.emplace_back(SlotRange{
+        .lower_bound = prepare_slot_offset,
+        .upper_bound = commit_slot->upper_bound,
+    });
+  }
+
+  LLFS_VLOG(1) << "append_multi_volume_job: committed" << BATT_INSPECT(parts.size())
+               << BATT_INSPECT(decision_slot);
+
+  return result;
+}
+
+}  // namespace llfs
@@ -0,0 +1,74 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_MULTI_VOLUME_JOB_HPP
+#define LLFS_MULTI_VOLUME_JOB_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/packable_ref.hpp>
+#include <llfs/page_cache_job.hpp>
+#include <llfs/slot.hpp>
+#include <llfs/status.hpp>
+#include <llfs/volume.hpp>
+
+#include <batteries/async/types.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief One Volume's share of a multi-Volume job: the user data to append to its root log.
+ */
+struct MultiVolumeJobPart {
+  Volume* volume;
+  PackableRef user_data;
+};
+
+/** \brief Atomically commits `job` across several Volumes, appending `parts[i].user_data` to the
+ * root log of `parts[i].volume`.  Either all the user slots are committed, or none are.
+ *
+ * `parts[0].volume` is the *coordinator*; all other Volumes are *participants*.  The protocol is:
+ *
+ *  1. Append a PackedPrepareJob + PackedPrepareJobLink to every Volume.  The coordinator's prepare
+ *     carries the new/deleted pages of the job (which are written just once, as for
+ *     Volume::append); each participant's prepare carries only its user data and root refs.
+ *  2. Flush all the root logs (concurrently; one flush per log).
+ *  3. Commit the PageCacheJob as the coordinator.  The coordinator's PageAllocator ref count
+ *     updates are the (durable) commit decision for all Volumes.
+ *  4. Append a PackedCommitJob to every Volume, without waiting for it to be flushed.
+ *
+ * When a Volume recovers a multi-Volume job that has no commit/rollback slot, it looks at the
+ * PageAllocator attachment of the coordinator (named by the PackedPrepareJobLink) to decide the
+ * job's fate, just as Volume::recover does for its own jobs.  Because this relies on the
+ * coordinator's attachment user slot, all the Volumes that took part in a multi-Volume job must be
+ * recovered before new jobs are appended to the coordinator.
+ *
+ * All the Volumes must be distinct and use the same PageCache as `job`.  `job` must touch at least
+ * one PageDevice (i.e., it must have new, deleted, or root pages); otherwise there is no
+ * PageAllocator to hold the commit decision, and batt::StatusCode::kInvalidArgument is returned.
+ *
+ * The required log space is reserved from each Volume (see Volume::reserve) before anything is
+ * appended.  If a later step fails before the commit decision is made, the new pages are dropped
+ * and a PackedRollbackJob is written (and flushed) to every Volume that has a prepare slot.  If
+ * that fails too, or the commit itself fails, only recovery can resolve the job; until then, the
+ * coordinator's later jobs fail instead of waiting for it.
+ *
+ * On success, returns the slot range (from prepare to commit) of the job in each Volume's log, in
+ * the order of `parts`.
+ */
+StatusOr<std::vector<SlotRange>> append_multi_volume_job(std::unique_ptr<PageCacheJob>&& job,
+                                                         std::vector<MultiVolumeJobPart>&& parts,
+                                                         batt::WaitForResource wait_for_log_space);
+
+}  // namespace llfs
+
+#endif  // LLFS_MULTI_VOLUME_JOB_HPP
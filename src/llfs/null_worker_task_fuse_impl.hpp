@@ -16,6 +16,8 @@
 
 #include <batteries/suppress.hpp>
 
+#include <string_view>
+
 namespace llfs {
 
 BATT_SUPPRESS_IF_GCC("-Wunused-parameter")
@@ -51,7 +53,7 @@ class NullWorkerTaskFuseImpl : public WorkerTaskFuseImpl<NullWorkerTaskFuseImpl>
   /** \brief
    */ // 3/44
   batt::StatusOr<const fuse_entry_param*> lookup(fuse_req_t req, fuse_ino_t parent,
-                                                 const std::string& name)
+                                                 const std::string_view& name)
   {
     return {batt::StatusCode::kUnimplemented};
   }
@@ -89,7 +91,7 @@ class NullWorkerTaskFuseImpl : public WorkerTaskFuseImpl<NullWorkerTaskFuseImpl>
   /** \brief
    */ // 8/44
   batt::StatusOr<const fuse_entry_param*> make_node(fuse_req_t req, fuse_ino_t parent,
-                                                    const std::string& name, mode_t mode,
+                                                    const std::string_view& name, mode_t mode,
                                                     dev_t rdev)
   {
     return {batt::StatusCode::kUnimplemented};
@@ -98,37 +100,39 @@ class NullWorkerTaskFuseImpl : public WorkerTaskFuseImpl<NullWorkerTaskFuseImpl>
   /** \brief
    */ // 9/44
   batt::StatusOr<const fuse_entry_param*> make_directory(fuse_req_t req, fuse_ino_t parent,
-                                                         const std::string& name, mode_t mode)
+                                                         const std::string_view& name, mode_t mode)
   {
     return {batt::StatusCode::kUnimplemented};
   }
 
   /** \brief
    */ // 10/44
-  batt::Status unlink(fuse_req_t req, fuse_ino_t parent, const std::string& name)
+  batt::Status unlink(fuse_req_t req, fuse_ino_t parent, const std::string_view& name)
   {
     return {batt::StatusCode::kUnimplemented};
   }
 
   /** \brief
    */ // 11/44
-  batt::Status remove_directory(fuse_req_t req, fuse_ino_t parent, const std::string& name)
+  batt::Status remove_directory(fuse_req_t req, fuse_ino_t parent, const std::string_view& name)
   {
     return {batt::StatusCode::kUnimplemented};
   }
 
   /** \brief
    */ // 12/44
-  batt::StatusOr<const fuse_entry_param*> symbolic_link(fuse_req_t req, const std::string& link,
-                                                        fuse_ino_t parent, const std::string& name)
+  batt::StatusOr<const fuse_entry_param*> symbolic_link(fuse_req_t req,
+                                                        const std::string_view& link,
+                                                        fuse_ino_t parent,
+                                                        const std::string_view& name)
   {
     return {batt::StatusCode::kUnimplemented};
   }
 
   /** \brief
    */ // 13/44
-  batt::Status rename(fuse_req_t req, fuse_ino_t parent, const std::string& name,
-                      fuse_ino_t newparent, const std::string& newname, unsigned int flags)
+  batt::Status rename(fuse_req_t req, fuse_ino_t parent, const std::string_view& name,
+                      fuse_ino_t newparent, const std::string_view& newname, unsigned int flags)
   {
     return {batt::StatusCode::kUnimplemented};
   }
@@ -137,7 +141,7 @@ class NullWorkerTaskFuseImpl : public WorkerTaskFuseImpl<NullWorkerTaskFuseImpl>
    */ // 14/44
   batt::StatusOr<const fuse_entry_param*> hard_link(fuse_req_t req, fuse_ino_t ino,
                                                     fuse_ino_t newparent,
-                                                    const std::string& newname)
+                                                    const std::string_view& newname)
   {
     return {batt::StatusCode::kUnimplemented};
   }
@@ -234,14 +238,15 @@ class NullWorkerTaskFuseImpl : public WorkerTaskFuseImpl<NullWorkerTaskFuseImpl>
   /** \brief
    */ // 27/44
   batt::StatusOr<FuseImplBase::FuseGetExtendedAttributeReply> get_extended_attribute(
-      fuse_req_t req, fuse_ino_t ino, const std::string& name, size_t size)
+      fuse_req_t req, fuse_ino_t ino, const std::string_view& name, size_t size)
   {
     return {batt::StatusCode::kUnimplemented};
   }
 
   /** \brief
    */ // 29/44
-  batt::Status remove_extended_attribute(fuse_req_t req, fuse_ino_t ino, const std::string& name)
+  batt::Status remove_extended_attribute(fuse_req_t req, fuse_ino_t ino,
+                                         const std::string_view& name)
   {
     return {batt::StatusCode::kUnimplemented};
   }
@@ -256,7 +261,7 @@ class NullWorkerTaskFuseImpl : public WorkerTaskFuseImpl<NullWorkerTaskFuseImpl>
   /** \brief
    */ // 31/44
   batt::StatusOr<FuseImplBase::FuseCreateReply> create(fuse_req_t req, fuse_ino_t parent,
-                                                       const std::string& name, mode_t mode,
+                                                       const std::string_view& name, mode_t mode,
                                                        fuse_file_info* fi)
   {
     return {batt::StatusCode::kUnimplemented};
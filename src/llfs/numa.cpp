@@ -0,0 +1,254 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/numa.hpp>
+//
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+#ifdef LLFS_PLATFORM_IS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+#endif
+
+namespace llfs {
+
+namespace {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+/** \brief Parses a sysfs cpu/node list (e.g. "0-3,8,10-11") and returns one plus the maximum value
+ * found, or 1 if the list could not be parsed.
+ */
+usize parse_sysfs_list_upper_bound(const std::string& list)
+{
+  usize upper_bound = 0;
+  usize value = 0;
+  bool in_number = false;
+
+  for (const char ch : list) {
+    if (ch >= '0' && ch <= '9') {
+      value = value * 10 + (ch - '0');
+      in_number = true;
+    } else {
+      if (in_number) {
+        upper_bound = std::max(upper_bound, value + 1);
+      }
+      value = 0;
+      in_number = false;
+    }
+  }
+  if (in_number) {
+    upper_bound = std::max(upper_bound, value + 1);
+  }
+
+  return std::max<usize>(upper_bound, 1);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+/** \brief Parses a sysfs cpu/node list (e.g. "0-3,8,10-11") and returns all the values in it, in
+ * the order listed; stops at the first thing that isn't a number, comma or range.
+ */
+std::vector<usize> parse_sysfs_list(const std::string& list)
+{
+  std::vector<usize> values;
+
+  usize pos = 0;
+  const auto parse_number = [&](usize* value) -> bool {
+    const usize start = pos;
+    *value = 0;
+    while (pos < list.size() && list[pos] >= '0' && list[pos] <= '9') {
+      *value = *value * 10 + (list[pos] - '0');
+      ++pos;
+    }
+    return pos != start;
+  };
+
+  while (pos < list.size()) {
+    usize first = 0;
+    if (!parse_number(&first)) {
+      break;
+    }
+    usize last = first;
+    if (pos < list.size() && list[pos] == '-') {
+      ++pos;
+      if (!parse_number(&last) || last < first) {
+        break;
+      }
+    }
+    for (usize value = first; value <= last; ++value) {
+      values.emplace_back(value);
+    }
+    if (pos >= list.size() || list[pos] != ',') {
+      break;
+    }
+    ++pos;
+  }
+
+  return values;
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize numa_node_count() noexcept
+{
+  static const usize count = [] {
+    std::ifstream ifs{"/sys/devices/system/node/online"};
+    std::string list;
+    if (!ifs.good() || !std::getline(ifs, list)) {
+      return usize{1};
+    }
+    return parse_sysfs_list_upper_bound(list);
+  }();
+
+  return count;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize current_numa_node() noexcept
+{
+  // The number of calls between refreshes of the cached node id.
+  //
+  static constexpr u32 kRefreshInterval = 1024;
+
+  const usize node_count = numa_node_count();
+  if (node_count == 1) {
+    return 0;
+  }
+
+  thread_local usize cached_node = 0;
+  thread_local u32 calls_until_refresh = 0;
+
+  if (calls_until_refresh == 0) {
+    calls_until_refresh = kRefreshInterval;
+#ifdef LLFS_PLATFORM_IS_LINUX
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+      cached_node = node % node_count;
+    }
+#endif
+  }
+  --calls_until_refresh;
+
+  return cached_node;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize current_cpu() noexcept
+{
+  // The number of calls between refreshes of the cached cpu id.
+  //
+  static constexpr u32 kRefreshInterval = 1024;
+
+  thread_local usize cached_cpu = 0;
+  thread_local u32 calls_until_refresh = 0;
+
+  if (calls_until_refresh == 0) {
+    calls_until_refresh = kRefreshInterval;
+#ifdef LLFS_PLATFORM_IS_LINUX
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+      cached_cpu = cpu;
+    }
+#endif
+  }
+  --calls_until_refresh;
+
+  return cached_cpu;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::vector<usize> numa_node_cpus(usize node) noexcept
+{
+  std::ifstream ifs{"/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"};
+  std::string list;
+  if (!ifs.good() || !std::getline(ifs, list)) {
+    return {};
+  }
+  return parse_sysfs_list(list);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<usize> numa_node_of_file(const std::string& file_name) noexcept
+{
+#ifdef LLFS_PLATFORM_IS_LINUX
+  struct stat file_stat;
+  if (::stat(file_name.c_str(), &file_stat) != 0) {
+    return None;
+  }
+
+  // For a block device (e.g. /dev/nvme0n1) we want the device itself; for a regular file, the
+  // device of the filesystem it lives on.
+  //
+  const dev_t dev = S_ISBLK(file_stat.st_mode) ? file_stat.st_rdev : file_stat.st_dev;
+
+  std::error_code ec;
+  std::filesystem::path path = std::filesystem::canonical(
+      "/sys/dev/block/" + std::to_string(major(dev)) + ":" + std::to_string(minor(dev)), ec);
+  if (ec) {
+    return None;
+  }
+
+  // Partitions and namespaces don't have a numa_node of their own; their controller (or its PCI
+  // device) does.
+  //
+  const std::filesystem::path sys_devices{"/sys/devices"};
+  for (; path != sys_devices && path.has_relative_path(); path = path.parent_path()) {
+    std::ifstream ifs{path / "numa_node"};
+    long node = -1;
+    if (ifs.good() && (ifs >> node) && node >= 0) {
+      if (static_cast<usize>(node) >= numa_node_count()) {
+        return None;
+      }
+      return static_cast<usize>(node);
+    }
+  }
+#endif
+  return None;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool pin_current_thread_to_numa_node(usize node) noexcept
+{
+#ifdef LLFS_PLATFORM_IS_LINUX
+  const std::vector<usize> cpus = numa_node_cpus(node);
+
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+
+  bool any_cpus = false;
+  for (usize cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &cpu_set);
+      any_cpus = true;
+    }
+  }
+
+  return any_cpus && pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#else
+  return false;
+#endif
+}
+
+}  // namespace llfs
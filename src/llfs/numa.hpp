@@ -0,0 +1,68 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_NUMA_HPP
+#define LLFS_NUMA_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
+
+#include <string>
+#include <vector>
+
+namespace llfs {
+
+/** \brief Returns the number of NUMA nodes on this host.
+ *
+ * This is read once from sysfs (/sys/devices/system/node/online) and cached; if the information is
+ * not available (e.g. on non-Linux platforms or inside some containers), returns 1.
+ */
+usize numa_node_count() noexcept;
+
+/** \brief Returns the NUMA node of the CPU the calling thread is currently running on.
+ *
+ * The result is cached per-thread and refreshed periodically, so it is cheap enough to call on hot
+ * paths; it may be briefly stale if the thread migrates between nodes.  Always returns a value in
+ * the range [0, numa_node_count()).
+ */
+usize current_numa_node() noexcept;
+
+/** \brief Returns the CPU the calling thread is currently running on.
+ *
+ * Like current_numa_node, this is cached per-thread and refreshed periodically, so it may be
+ * briefly stale; returns 0 if the information is not available.
+ */
+usize current_cpu() noexcept;
+
+/** \brief Returns the CPUs of the given NUMA node, in ascending order.
+ *
+ * This is read from sysfs (/sys/devices/system/node/node<N>/cpulist); returns an empty vector if
+ * the information is not available.
+ */
+std::vector<usize> numa_node_cpus(usize node) noexcept;
+
+/** \brief Returns the NUMA node closest to the storage device that holds the given file (or of the
+ * given block device, e.g. an NVMe namespace), or None if it isn't known.
+ *
+ * The node is found by walking up the sysfs device path of the block device (/sys/dev/block/M:m)
+ * to the first ancestor (typically the PCI device of the NVMe controller) with a non-negative
+ * `numa_node`.  Files on non-block filesystems (tmpfs, network filesystems, etc.) return None.
+ */
+Optional<usize> numa_node_of_file(const std::string& file_name) noexcept;
+
+/** \brief Restricts the calling thread to the CPUs of the given NUMA node; returns false (leaving
+ * the thread's affinity unchanged) if the node's CPUs aren't known or the affinity can't be set.
+ */
+bool pin_current_thread_to_numa_node(usize node) noexcept;
+
+}  // namespace llfs
+
+#endif  // LLFS_NUMA_HPP
@@ -62,6 +62,12 @@ BoxedSeq<PageId> OpaquePageView::trace_refs() const /*override*/
   return seq::Empty<PageId>{} | seq::boxed();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void OpaquePageView::append_refs(std::vector<PageId>* /*refs*/) const /*override*/
+{
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 Optional<KeyView> OpaquePageView::min_key() const /*override*/
@@ -37,6 +37,10 @@ class OpaquePageView : public PageView
   //
   BoxedSeq<PageId> trace_refs() const override;
 
+  // Opaque pages have no refs, so this does nothing.
+  //
+  void append_refs(std::vector<PageId>* refs) const override;
+
   // Returns the minimum key value contained within this page.
   //
   Optional<KeyView> min_key() const override;
@@ -0,0 +1,245 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/optimistic_read_epoch.hpp>
+//
+
+#include <batteries/assert.hpp>
+
+#include <algorithm>
+#include <shared_mutex>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+OptimisticReadEpoch::LocalEpoch::LocalEpoch() noexcept
+{
+  OptimisticReadEpoch& epoch = OptimisticReadEpoch::instance();
+
+  std::unique_lock<std::shared_mutex> lock{epoch.epoch_list_mutex_};
+  epoch.epoch_list_.push_back(*this);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+OptimisticReadEpoch::LocalEpoch::~LocalEpoch() noexcept
+{
+  BATT_CHECK_EQ(this->depth, 0u);
+
+  OptimisticReadEpoch& epoch = OptimisticReadEpoch::instance();
+
+  // Release views outside the locks, since freeing them may take a while.
+  //
+  std::vector<std::shared_ptr<const PageView>> to_release;
+  {
+    std::unique_lock<std::shared_mutex> lock{epoch.epoch_list_mutex_};
+    {
+      std::unique_lock<std::mutex> retired_lock{this->retired_mutex};
+      epoch.collect_locked(&this->retired, &to_release);
+
+      // Hand whatever readers can still see over to the other threads.
+      //
+      if (!this->retired.empty()) {
+        std::unique_lock<std::mutex> orphan_lock{epoch.orphan_mutex_};
+        for (RetiredView& retired : this->retired) {
+          epoch.orphaned_.emplace_back(std::move(retired));
+        }
+        this->retired.clear();
+        epoch.has_orphans_.store(true);
+      }
+    }
+    epoch.epoch_list_.erase(epoch.epoch_list_.iterator_to(*this));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+OptimisticReadEpoch::Guard::Guard() noexcept : local_{OptimisticReadEpoch::thread_local_epoch()}
+{
+  if (this->local_.depth++ != 0) {
+    return;
+  }
+
+  this->local_.value.store(
+      OptimisticReadEpoch::instance().global_epoch_.load(std::memory_order_acquire),
+      std::memory_order_relaxed);
+
+  // Our epoch must be visible to retire() before we read any published view; this pairs with the
+  // fence in retire().
+  //
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+OptimisticReadEpoch::Guard::~Guard() noexcept
+{
+  BATT_CHECK_GT(this->local_.depth, 0u);
+
+  if (--this->local_.depth == 0) {
+    // Release: everything read inside the Guard happens before the view can be freed.
+    //
+    this->local_.value.store(0, std::memory_order_release);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ auto OptimisticReadEpoch::instance() noexcept -> Self&
+{
+  // Leak instance_ to avoid shutdown destructor ordering issues (thread-local LocalEpoch objects
+  // unregister themselves when their thread exits).
+  //
+  static Self* instance_ = new Self;
+
+  return *instance_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ auto OptimisticReadEpoch::thread_local_epoch() noexcept -> LocalEpoch&
+{
+  thread_local LocalEpoch epoch_;
+
+  return epoch_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void OptimisticReadEpoch::retire(std::shared_ptr<const PageView>&& view) noexcept
+{
+  if (!view) {
+    return;
+  }
+
+  // The caller has unpublished `view`; now either a reader that loads the published view will see
+  // that, or its epoch is no greater than the one we read below (and it will be seen by any later
+  // scan).  This pairs with the fence in Guard().
+  //
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  const u64 epoch = this->global_epoch_.load();
+
+  LocalEpoch& local = Self::thread_local_epoch();
+  {
+    std::unique_lock<std::mutex> retired_lock{local.retired_mutex};
+
+    local.retired.emplace_back(epoch, std::move(view));
+    if (local.retired.size() < kReclaimBatchSize) {
+      return;
+    }
+  }
+
+  // Release views outside the locks, since freeing them may take a while.
+  //
+  std::vector<std::shared_ptr<const PageView>> to_release;
+  {
+    std::shared_lock<std::shared_mutex> lock{this->epoch_list_mutex_};
+
+    this->reclaim_locked(local, &to_release);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize OptimisticReadEpoch::reclaim() noexcept
+{
+  std::vector<std::shared_ptr<const PageView>> to_release;
+  {
+    std::shared_lock<std::shared_mutex> lock{this->epoch_list_mutex_};
+
+    for (LocalEpoch& local : this->epoch_list_) {
+      this->reclaim_locked(local, &to_release);
+    }
+  }
+  return this->retired_count();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize OptimisticReadEpoch::retired_count() noexcept
+{
+  usize count = 0;
+  {
+    std::shared_lock<std::shared_mutex> lock{this->epoch_list_mutex_};
+
+    for (LocalEpoch& local : this->epoch_list_) {
+      std::unique_lock<std::mutex> retired_lock{local.retired_mutex};
+      count += local.retired.size();
+    }
+    {
+      std::unique_lock<std::mutex> orphan_lock{this->orphan_mutex_};
+      count += this->orphaned_.size();
+    }
+  }
+  return count;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 OptimisticReadEpoch::min_active_epoch_locked() const noexcept
+{
+  u64 min_active_epoch = ~u64{0};
+  for (const LocalEpoch& local : this->epoch_list_) {
+    const u64 value = local.value.load();
+    if (value != 0) {
+      min_active_epoch = std::min(min_active_epoch, value);
+    }
+  }
+  return min_active_epoch;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void OptimisticReadEpoch::collect_locked(
+    std::vector<RetiredView>* retired,
+    std::vector<std::shared_ptr<const PageView>>* to_release) const noexcept
+{
+  if (retired->empty()) {
+    return;
+  }
+
+  // A view retired at epoch E can only have been seen by readers whose epoch is <= E.
+  //
+  const u64 min_active_epoch = this->min_active_epoch_locked();
+
+  const auto is_visible = [min_active_epoch](const RetiredView& view) {
+    return view.first >= min_active_epoch;
+  };
+
+  const auto first_released = std::stable_partition(retired->begin(), retired->end(), is_visible);
+
+  for (auto iter = first_released; iter != retired->end(); ++iter) {
+    to_release->emplace_back(std::move(iter->second));
+  }
+  retired->erase(first_released, retired->end());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void OptimisticReadEpoch::reclaim_locked(
+    LocalEpoch& local, std::vector<std::shared_ptr<const PageView>>* to_release) noexcept
+{
+  // Readers that enter from now on can't hold back the views retired so far.
+  //
+  this->global_epoch_.fetch_add(1);
+
+  {
+    std::unique_lock<std::mutex> retired_lock{local.retired_mutex};
+    this->collect_locked(&local.retired, to_release);
+  }
+
+  if (this->has_orphans_.load()) {
+    std::unique_lock<std::mutex> orphan_lock{this->orphan_mutex_};
+    this->collect_locked(&this->orphaned_, to_release);
+    this->has_orphans_.store(!this->orphaned_.empty());
+  }
+}
+
+}  //namespace llfs
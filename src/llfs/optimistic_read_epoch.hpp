@@ -0,0 +1,190 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_OPTIMISTIC_READ_EPOCH_HPP
+#define LLFS_OPTIMISTIC_READ_EPOCH_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/page_view.hpp>
+
+#include <boost/intrusive/list.hpp>
+#include <boost/intrusive/list_hook.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+namespace llfs {
+
+/** \brief Epoch-based reclamation for the page views that PageCacheSlot hands out to optimistic
+ * (pin-free) readers; see PageCacheSlot::begin_optimistic_read.
+ *
+ * A thread announces that it is reading by creating a Guard, which copies the global epoch into a
+ * thread-local counter; readers never write to memory shared with other threads, so hot pages don't
+ * cause contention.  When a slot stops publishing a view (because it is being refilled or cleared),
+ * the view is retired: it is tagged with the current epoch and added to the retiring thread's own
+ * list.  A retired view is released once no thread is inside a Guard that was entered at or before
+ * its epoch, since only those readers can possibly have seen it.
+ *
+ * Each thread reclaims its own list once it holds kReclaimBatchSize views (and all lists are
+ * reclaimed on demand, by reclaim()); only then is the global epoch advanced and the other threads'
+ * counters scanned, so retiring a view usually costs one uncontended lock.  Retired views are no
+ * longer charged to the cache's byte budget, so Guards must only be held for short, non-blocking
+ * reads; a Guard held for a long time keeps every view retired in the meantime alive.
+ *
+ * Like LRUClock, the thread-local state is kept in a global linked list; it is locked exclusively
+ * only when a thread first uses the epoch and when it exits (handing any views it still holds to a
+ * shared list of orphans), and shared otherwise.
+ */
+class OptimisticReadEpoch
+{
+ public:
+  using Self = OptimisticReadEpoch;
+
+  /** \brief The number of views a thread retires between reclaims of its list.
+   */
+  static constexpr usize kReclaimBatchSize = 64;
+
+  /** \brief A retired view, with the epoch at which it was retired.
+   */
+  using RetiredView = std::pair<u64, std::shared_ptr<const PageView>>;
+
+  class LocalEpoch;
+
+  /** \brief A linked-list node; this is the base type for LocalEpoch.
+   */
+  using LocalEpochHook = boost::intrusive::list_base_hook<boost::intrusive::tag<LocalEpoch>>;
+
+  /** \brief The per-thread reader state, and the views retired by the thread.
+   */
+  class LocalEpoch : public LocalEpochHook
+  {
+   public:
+    explicit LocalEpoch() noexcept;
+
+    ~LocalEpoch() noexcept;
+
+    /** \brief The global epoch when the current thread's outermost Guard was created, or 0 if the
+     * thread isn't in a Guard.
+     */
+    std::atomic<u64> value{0};
+
+    /** \brief The number of active (nested) Guards on the current thread; only accessed by that
+     * thread.
+     */
+    usize depth = 0;
+
+    /** \brief Protects `retired`; only contended when another thread calls reclaim().
+     */
+    std::mutex retired_mutex;
+
+    /** \brief The views retired by this thread that haven't been released yet.
+     */
+    std::vector<RetiredView> retired;
+  };
+
+  /** \brief Alias for the LocalEpoch linked-list collection type.
+   */
+  using LocalEpochList =
+      boost::intrusive::list<LocalEpoch, boost::intrusive::base_hook<LocalEpochHook>>;
+
+  /** \brief Marks the current thread as doing an optimistic read for the lifetime of this object;
+   * no view that was published when the Guard was created will be released until it is destroyed.
+   * Guards may be nested.
+   */
+  class Guard
+  {
+   public:
+    Guard() noexcept;
+
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+
+    ~Guard() noexcept;
+
+   private:
+    LocalEpoch& local_;
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Returns a reference to the global instance.
+   */
+  static Self& instance() noexcept;
+
+  /** \brief Returns a reference to the current thread's epoch object.
+   */
+  static LocalEpoch& thread_local_epoch() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Keeps `view` alive until every Guard that might have seen it is gone, then releases it
+   * (as part of a later batch; see kReclaimBatchSize).  Does nothing if `view` is nullptr.
+   *
+   * The caller must already have stopped publishing `view` to new readers.
+   */
+  void retire(std::shared_ptr<const PageView>&& view) noexcept;
+
+  /** \brief Releases all retired views (of all threads) that are no longer visible to any reader;
+   * returns the number of views still waiting to be released.
+   */
+  usize reclaim() noexcept;
+
+  /** \brief Returns the number of retired views waiting to be released.
+   */
+  usize retired_count() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  OptimisticReadEpoch() = default;
+
+  /** \brief Returns the smallest epoch of any thread that is inside a Guard (or ~0 if there is
+   * none); `epoch_list_mutex_` must be held (shared or exclusive).
+   */
+  u64 min_active_epoch_locked() const noexcept;
+
+  /** \brief Moves the views in `retired` that no reader can see to `to_release`; the lock protecting
+   * `retired` and `epoch_list_mutex_` must be held.
+   */
+  void collect_locked(std::vector<RetiredView>* retired,
+                      std::vector<std::shared_ptr<const PageView>>* to_release) const noexcept;
+
+  /** \brief Reclaims `local`'s views and (if there are any) the orphaned views;
+   * `epoch_list_mutex_` must be held (shared or exclusive).
+   */
+  void reclaim_locked(LocalEpoch& local,
+                      std::vector<std::shared_ptr<const PageView>>* to_release) noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  // Advanced each time a batch of views is reclaimed; 0 is reserved for "not reading."
+  //
+  std::atomic<u64> global_epoch_{1};
+
+  // Protects `epoch_list_`: locked exclusively to add or remove a thread, shared to scan the epochs
+  // of all threads.  Always locked before any LocalEpoch::retired_mutex, or `orphan_mutex_`.
+  //
+  std::shared_mutex epoch_list_mutex_;
+  LocalEpochList epoch_list_;
+
+  // Views left behind by threads that exited before they could be released.
+  //
+  std::mutex orphan_mutex_;
+  std::vector<RetiredView> orphaned_;
+  std::atomic<bool> has_orphans_{false};
+};
+
+}  //namespace llfs
+
+#endif  // LLFS_OPTIMISTIC_READ_EPOCH_HPP
@@ -0,0 +1,410 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PACKED_COLUMNAR_ARRAY_HPP
+#define LLFS_PACKED_COLUMNAR_ARRAY_HPP
+
+#include <llfs/data_layout.hpp>
+#include <llfs/define_packed_type.hpp>
+#include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/unpack_cast.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/slice.hpp>
+#include <batteries/static_assert.hpp>
+#include <batteries/utility.hpp>
+
+#include <array>
+#include <cstring>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A packed array of records stored as a "struct of arrays": the values of each field are
+ * stored contiguously (one column per field), in the order of `Fields`.
+ *
+ * Compared to PackedArray<T> of a packed struct, a scan that only reads one field touches only
+ * that field's column, and the column is a dense array of one fixed-size type, so that loops over
+ * it (e.g., `count_if` and `find_first_if` below) can be vectorized by the compiler.
+ *
+ * Each column starts at a multiple of kColumnAlign bytes from the start of the array header, so
+ * if the array itself is placed at an aligned address, so are all its columns.
+ *
+ * Element access goes through a proxy (`Row`/`ConstRow`), so `array[i].get<I>()` reads field I of
+ * record i in place.
+ *
+ * Each field type must be a fixed-size packed type (e.g. little_u32, PackedPageId).  To declare a
+ * columnar array by unpacked field types instead, use `PackedColumnarArrayFor<Ts...>`.
+ */
+template <typename... Fields>
+struct PackedColumnarArray {
+  static_assert(sizeof...(Fields) > 0, "PackedColumnarArray must have at least one field");
+  static_assert((std::is_trivially_copyable_v<Fields> && ...),
+                "PackedColumnarArray fields must be fixed-size packed types");
+
+  static constexpr usize kFieldCount = sizeof...(Fields);
+
+  /** \brief The alignment (relative to the start of the array header) of each column.
+   */
+  static constexpr usize kColumnAlign = 8;
+
+  template <usize I>
+  using Field = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Returns the size in bytes of one column of `item_count` items, including the padding
+   * that aligns the next column.
+   */
+  static constexpr usize column_size(usize field_size, usize item_count)
+  {
+    return (field_size * item_count + kColumnAlign - 1) & ~(kColumnAlign - 1);
+  }
+
+  /** \brief Returns the byte offset of column `I` from the start of the array header.
+   */
+  template <usize I>
+  static constexpr usize column_offset(usize item_count)
+  {
+    static_assert(I < kFieldCount, "");
+
+    constexpr std::array<usize, kFieldCount> field_sizes{sizeof(Fields)...};
+
+    usize offset = 8 /*== sizeof(PackedColumnarArray)*/;
+    for (usize j = 0; j < I; ++j) {
+      offset += column_size(field_sizes[j], item_count);
+    }
+    return offset;
+  }
+
+  /** \brief Returns the total packed size of an array of `item_count` records.
+   */
+  static constexpr usize packed_size(usize item_count)
+  {
+    return 8 /*== sizeof(PackedColumnarArray)*/ + (column_size(sizeof(Fields), item_count) + ...);
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief A reference to one record of a mutable array.
+   */
+  class Row
+  {
+   public:
+    explicit Row(PackedColumnarArray* array, usize index) noexcept : array_{array}, index_{index}
+    {
+    }
+
+    template <usize I>
+    Field<I>& get() const
+    {
+      return this->array_->template column_data<I>()[this->index_];
+    }
+
+    /** \brief Assigns all the fields of this record, in order.
+     */
+    template <typename... Args>
+    void set(Args&&... args) const
+    {
+      static_assert(sizeof...(Args) == kFieldCount, "set() must be passed a value for each field");
+      this->set_impl(std::index_sequence_for<Args...>{}, BATT_FORWARD(args)...);
+    }
+
+    usize index() const
+    {
+      return this->index_;
+    }
+
+   private:
+    template <usize... I, typename... Args>
+    void set_impl(std::index_sequence<I...>, Args&&... args) const
+    {
+      ((this->template get<I>() = BATT_FORWARD(args)), ...);
+    }
+
+    PackedColumnarArray* array_;
+    usize index_;
+  };
+
+  /** \brief A reference to one record of a const array.
+   */
+  class ConstRow
+  {
+   public:
+    explicit ConstRow(const PackedColumnarArray* array, usize index) noexcept
+        : array_{array}
+        , index_{index}
+    {
+    }
+
+    template <usize I>
+    const Field<I>& get() const
+    {
+      return this->array_->template column_data<I>()[this->index_];
+    }
+
+    usize index() const
+    {
+      return this->index_;
+    }
+
+   private:
+    const PackedColumnarArray* array_;
+    usize index_;
+  };
+
+  /** \brief Iterates over the records of the array (as Row or ConstRow proxies).
+   */
+  template <typename ArrayPtrT, typename RowT>
+  class RowIterator
+  {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = RowT;
+    using difference_type = isize;
+    using pointer = void;
+    using reference = RowT;
+
+    explicit RowIterator(ArrayPtrT array, usize index) noexcept : array_{array}, index_{index}
+    {
+    }
+
+    RowT operator*() const
+    {
+      return RowT{this->array_, this->index_};
+    }
+
+    RowIterator& operator++()
+    {
+      ++this->index_;
+      return *this;
+    }
+
+    RowIterator operator++(int)
+    {
+      RowIterator prev = *this;
+      ++this->index_;
+      return prev;
+    }
+
+    friend bool operator==(const RowIterator& l, const RowIterator& r)
+    {
+      return l.array_ == r.array_ && l.index_ == r.index_;
+    }
+
+    friend bool operator!=(const RowIterator& l, const RowIterator& r)
+    {
+      return !(l == r);
+    }
+
+   private:
+    ArrayPtrT array_;
+    usize index_;
+  };
+
+  using iterator = RowIterator<PackedColumnarArray*, Row>;
+  using const_iterator = RowIterator<const PackedColumnarArray*, ConstRow>;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  little_u24 item_count;
+  u8 pad;
+  little_u32 size_in_bytes{0};
+
+  // This struct must never be copied since that would invalidate the columns.
+  //
+  PackedColumnarArray(const PackedColumnarArray&) = delete;
+  PackedColumnarArray& operator=(const PackedColumnarArray&) = delete;
+
+  /** \brief Sets the item count and zeroes the columns; the caller must have allocated
+   * `packed_size(count_arg)` bytes starting at `this`.
+   */
+  template <typename I>
+  void initialize(I count_arg)
+  {
+    const usize count = count_arg;
+    std::memset(this, 0, packed_size(count));
+    this->item_count = count_arg;
+
+    BATT_CHECK_EQ(count_arg, this->item_count.value());
+  }
+
+  usize size() const
+  {
+    return this->item_count;
+  }
+
+  bool empty() const
+  {
+    return this->item_count == 0;
+  }
+
+  template <usize I>
+  Field<I>* column_data()
+  {
+    return reinterpret_cast<Field<I>*>(reinterpret_cast<u8*>(this) +
+                                       column_offset<I>(this->size()));
+  }
+
+  template <usize I>
+  const Field<I>* column_data() const
+  {
+    return reinterpret_cast<const Field<I>*>(reinterpret_cast<const u8*>(this) +
+                                             column_offset<I>(this->size()));
+  }
+
+  /** \brief Returns the values of field `I` of all records, in order.
+   */
+  template <usize I>
+  batt::Slice<Field<I>> column()
+  {
+    return batt::as_slice(this->column_data<I>(), this->size());
+  }
+
+  template <usize I>
+  batt::Slice<const Field<I>> column() const
+  {
+    return batt::as_slice(this->column_data<I>(), this->size());
+  }
+
+  Row operator[](usize index)
+  {
+    return Row{this, index};
+  }
+
+  ConstRow operator[](usize index) const
+  {
+    return ConstRow{this, index};
+  }
+
+  iterator begin()
+  {
+    return iterator{this, 0};
+  }
+
+  iterator end()
+  {
+    return iterator{this, this->size()};
+  }
+
+  const_iterator begin() const
+  {
+    return const_iterator{this, 0};
+  }
+
+  const_iterator end() const
+  {
+    return const_iterator{this, this->size()};
+  }
+
+  /** \brief Returns the number of records whose field `I` satisfies `pred`.
+   *
+   * The loop body is branch-free, so that it vectorizes for simple predicates (e.g. comparisons).
+   */
+  template <usize I, typename Pred>
+  usize count_if(Pred&& pred) const
+  {
+    const Field<I>* values = this->column_data<I>();
+    const usize n = this->size();
+
+    usize count = 0;
+    for (usize i = 0; i < n; ++i) {
+      count += static_cast<usize>(static_cast<bool>(pred(values[i])));
+    }
+    return count;
+  }
+
+  /** \brief Returns the index of the first record whose field `I` satisfies `pred`, or None.
+   *
+   * The column is scanned in branch-free blocks of kScanBlockSize values, so that the predicate is
+   * evaluated for a whole block at once (vectorized for simple predicates); only the first block
+   * with a match is then searched item by item.
+   */
+  template <usize I, typename Pred>
+  Optional<usize> find_first_if(Pred&& pred) const
+  {
+    constexpr usize kScanBlockSize = 16;
+
+    const Field<I>* values = this->column_data<I>();
+    const usize n = this->size();
+
+    usize i = 0;
+    for (; i + kScanBlockSize <= n; i += kScanBlockSize) {
+      u32 mask = 0;
+      for (usize j = 0; j < kScanBlockSize; ++j) {
+        mask |= static_cast<u32>(static_cast<bool>(pred(values[i + j]))) << j;
+      }
+      if (mask != 0) {
+        return i + __builtin_ctz(mask);
+      }
+    }
+    for (; i < n; ++i) {
+      if (pred(values[i])) {
+        return i;
+      }
+    }
+    return None;
+  }
+
+  void initialize_size_in_bytes(usize size_in_bytes)
+  {
+    this->size_in_bytes = size_in_bytes;
+  }
+
+  Optional<usize> get_size_in_bytes() const
+  {
+    return this->size_in_bytes;
+  }
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedColumnarArray<little_u64>), 8);
+BATT_STATIC_ASSERT_EQ((sizeof(PackedColumnarArray<little_u32, little_u32, little_u64>)), 8);
+
+/** \brief The PackedColumnarArray whose columns hold the packed types of `Ts...` (see
+ * LLFS_DEFINE_PACKED_TYPE_FOR).
+ */
+template <typename... Ts>
+using PackedColumnarArrayFor = PackedColumnarArray<PackedTypeFor<Ts>...>;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+template <typename... Fields>
+inline usize packed_columnar_array_size(usize item_count,
+                                        batt::StaticType<PackedColumnarArray<Fields...>> = {})
+{
+  const little_u24 packed_count = item_count;
+
+  BATT_ASSERT_EQ(static_cast<usize>(packed_count.value()), item_count);
+
+  return PackedColumnarArray<Fields...>::packed_size(item_count);
+}
+
+template <typename... Fields>
+inline usize packed_sizeof(const PackedColumnarArray<Fields...>& a)
+{
+  return PackedColumnarArray<Fields...>::packed_size(a.size());
+}
+
+template <typename... Fields>
+batt::Status validate_packed_value(const PackedColumnarArray<Fields...>& a,
+                                   const void* buffer_data, usize buffer_size)
+{
+  BATT_REQUIRE_OK(validate_packed_struct(a, buffer_data, buffer_size));
+  BATT_REQUIRE_OK(validate_packed_byte_range(&a, packed_sizeof(a), buffer_data, buffer_size));
+
+  return batt::OkStatus();
+}
+
+}  // namespace llfs
+
+#endif  // LLFS_PACKED_COLUMNAR_ARRAY_HPP
@@ -0,0 +1,153 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/packed_columnar_array.hpp>
+//
+#include <llfs/packed_columnar_array.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/data_packer.hpp>
+#include <llfs/int_types.hpp>
+
+#include <batteries/static_assert.hpp>
+
+#include <vector>
+
+namespace {
+
+using namespace llfs::int_types;
+
+// Test Plan:
+//  1. Layout: columns are contiguous, aligned, and in field order.
+//  2. Pack via DataPacker, fill via Row proxies, read back via rows, columns, and iterators.
+//  3. count_if/find_first_if agree with a simple scan (block and tail paths).
+//  4. validate_packed_value rejects a truncated buffer.
+
+using LeafSlots = llfs::PackedColumnarArray<little_u32, little_u32, little_u64>;
+
+BATT_STATIC_ASSERT_TYPE_EQ((llfs::PackedColumnarArrayFor<u32, u32, u64>), LeafSlots);
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PackedColumnarArrayTest, Layout)
+{
+  EXPECT_EQ(LeafSlots::column_offset<0>(5), 8u);
+  EXPECT_EQ(LeafSlots::column_offset<1>(5), 8u + 24u);
+  EXPECT_EQ(LeafSlots::column_offset<2>(5), 8u + 24u + 24u);
+  EXPECT_EQ(LeafSlots::packed_size(5), 8u + 24u + 24u + 40u);
+
+  EXPECT_EQ(LeafSlots::packed_size(0), 8u);
+  EXPECT_EQ(LeafSlots::packed_size(2), 8u + 8u + 8u + 16u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PackedColumnarArrayTest, PackAndRead)
+{
+  constexpr usize kCount = 37;
+
+  std::vector<u8> buffer(LeafSlots::packed_size(kCount) + 64);
+  llfs::DataPacker packer{llfs::MutableBuffer{buffer.data(), buffer.size()}};
+
+  LeafSlots* packed = packer.pack_columnar_array(kCount, batt::StaticType<LeafSlots>{});
+  ASSERT_NE(packed, nullptr);
+  ASSERT_EQ(packed->size(), kCount);
+  EXPECT_EQ(llfs::packed_sizeof(*packed), LeafSlots::packed_size(kCount));
+
+  for (usize i = 0; i < kCount; ++i) {
+    (*packed)[i].set(i * 3, i * 5, u64{1} << 40 | i);
+  }
+
+  const LeafSlots& const_packed = *packed;
+  for (usize i = 0; i < kCount; ++i) {
+    EXPECT_EQ(const_packed[i].get<0>(), i * 3);
+    EXPECT_EQ(const_packed[i].get<1>(), i * 5);
+    EXPECT_EQ(const_packed[i].get<2>(), u64{1} << 40 | i);
+  }
+
+  batt::Slice<const little_u32> value_offsets = const_packed.column<1>();
+  ASSERT_EQ(value_offsets.size(), kCount);
+  for (usize i = 0; i < kCount; ++i) {
+    EXPECT_EQ(value_offsets[i], i * 5);
+  }
+
+  usize expected_index = 0;
+  for (LeafSlots::ConstRow row : const_packed) {
+    EXPECT_EQ(row.index(), expected_index);
+    EXPECT_EQ(row.get<0>(), expected_index * 3);
+    ++expected_index;
+  }
+  EXPECT_EQ(expected_index, kCount);
+
+  for (LeafSlots::Row row : *packed) {
+    row.get<2>() = row.index();
+  }
+  EXPECT_EQ(const_packed[kCount - 1].get<2>(), kCount - 1);
+
+  // One more array of this size must not fit into the remaining space.
+  //
+  EXPECT_EQ(packer.pack_columnar_array(kCount, batt::StaticType<LeafSlots>{}), nullptr);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PackedColumnarArrayTest, Scan)
+{
+  for (usize count : {0, 1, 15, 16, 17, 100}) {
+    std::vector<u8> buffer(LeafSlots::packed_size(count));
+    llfs::DataPacker packer{llfs::MutableBuffer{buffer.data(), buffer.size()}};
+
+    LeafSlots* packed = packer.pack_columnar_array(count, batt::StaticType<LeafSlots>{});
+    ASSERT_NE(packed, nullptr);
+
+    for (usize i = 0; i < count; ++i) {
+      (*packed)[i].set(0, 0, (i * 7919) % 101);
+    }
+
+    for (u64 threshold : {0, 1, 50, 100, 101}) {
+      usize expected_count = 0;
+      llfs::Optional<usize> expected_first;
+      for (usize i = 0; i < count; ++i) {
+        const bool match = (i * 7919) % 101 >= threshold;
+        if (match) {
+          ++expected_count;
+          if (!expected_first) {
+            expected_first = i;
+          }
+        }
+      }
+
+      const auto pred = [threshold](const little_u64& seq) {
+        return seq >= threshold;
+      };
+
+      EXPECT_EQ(packed->count_if<2>(pred), expected_count) << BATT_INSPECT(count);
+      EXPECT_EQ(packed->find_first_if<2>(pred), expected_first) << BATT_INSPECT(count);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PackedColumnarArrayTest, Validate)
+{
+  constexpr usize kCount = 10;
+
+  std::vector<u8> buffer(LeafSlots::packed_size(kCount));
+  llfs::DataPacker packer{llfs::MutableBuffer{buffer.data(), buffer.size()}};
+
+  LeafSlots* packed = packer.pack_columnar_array(kCount, batt::StaticType<LeafSlots>{});
+  ASSERT_NE(packed, nullptr);
+
+  EXPECT_TRUE(llfs::validate_packed_value(*packed, buffer.data(), buffer.size()).ok());
+  EXPECT_FALSE(llfs::validate_packed_value(*packed, buffer.data(), buffer.size() - 1).ok());
+}
+
+}  // namespace
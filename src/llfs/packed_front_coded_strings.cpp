@@ -0,0 +1,297 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/packed_front_coded_strings.hpp>
+//
+
+#include <llfs/status_code.hpp>
+#include <llfs/unpack_cast.hpp>
+#include <llfs/varint.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/checked_cast.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace llfs {
+
+namespace {
+
+// Returns the length of the common prefix of `a` and `b`.
+//
+inline usize shared_prefix_size(const std::string_view& a, const std::string_view& b)
+{
+  const usize n = std::min(a.size(), b.size());
+  return std::mismatch(a.begin(), a.begin() + n, b.begin()).first - a.begin();
+}
+
+inline usize restart_count_for(usize count, usize restart_interval)
+{
+  return (count + restart_interval - 1) / restart_interval;
+}
+
+// Parses the two varints at the start of an entry; returns nullptr if they aren't within
+// [entry, last).
+//
+inline const u8* parse_entry_header(const u8* entry, const u8* last, u64* shared_size,
+                                    u64* suffix_size)
+{
+  Optional<u64> n;
+  std::tie(n, entry) = unpack_varint_from(entry, last);
+  if (!n || !entry) {
+    return nullptr;
+  }
+  *shared_size = *n;
+
+  std::tie(n, entry) = unpack_varint_from(entry, last);
+  if (!n || !entry) {
+    return nullptr;
+  }
+  *suffix_size = *n;
+
+  return entry;
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize packed_sizeof_front_coded_strings(const batt::Slice<const std::string_view>& keys,
+                                        usize restart_interval)
+{
+  BATT_CHECK_GT(restart_interval, 0u);
+
+  usize total = sizeof(PackedFrontCodedStrings) +
+                restart_count_for(keys.size(), restart_interval) * sizeof(little_u32);
+
+  std::string_view prev;
+  for (usize i = 0; i < keys.size(); ++i) {
+    const std::string_view& key = keys[i];
+    const usize shared = (i % restart_interval == 0) ? 0 : shared_prefix_size(prev, key);
+    const usize suffix = key.size() - shared;
+
+    total += packed_sizeof_varint(shared) + packed_sizeof_varint(suffix) + suffix;
+    prev = key;
+  }
+
+  return total;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PackedFrontCodedStrings* pack_front_coded_strings_to(
+    const MutableBuffer& dst, const batt::Slice<const std::string_view>& keys,
+    usize restart_interval)
+{
+  BATT_CHECK_GT(restart_interval, 0u);
+  BATT_CHECK_LE(restart_interval, std::numeric_limits<u16>::max());
+  BATT_CHECK_EQ(dst.size(), packed_sizeof_front_coded_strings(keys, restart_interval));
+
+  const usize restart_count = restart_count_for(keys.size(), restart_interval);
+
+  auto* packed = static_cast<PackedFrontCodedStrings*>(dst.data());
+  packed->item_count = BATT_CHECKED_CAST(u32, keys.size());
+  packed->size_in_bytes = BATT_CHECKED_CAST(u32, dst.size());
+  packed->restart_count = BATT_CHECKED_CAST(u32, restart_count);
+  packed->restart_interval = BATT_CHECKED_CAST(u16, restart_interval);
+  packed->reserved_ = 0;
+
+  u8* const dst_begin = static_cast<u8*>(dst.data());
+  u8* const dst_end = dst_begin + dst.size();
+  auto* restart_offsets = reinterpret_cast<little_u32*>(packed + 1);
+
+  u8* next = dst_begin + sizeof(PackedFrontCodedStrings) + restart_count * sizeof(little_u32);
+
+  std::string_view prev;
+  for (usize i = 0; i < keys.size(); ++i) {
+    const std::string_view& key = keys[i];
+    usize shared = 0;
+    if (i % restart_interval == 0) {
+      restart_offsets[i / restart_interval] = BATT_CHECKED_CAST(u32, next - dst_begin);
+    } else {
+      shared = shared_prefix_size(prev, key);
+    }
+    const usize suffix = key.size() - shared;
+
+    next = pack_varint_to(next, dst_end, shared);
+    BATT_CHECK_NOT_NULLPTR(next);
+    next = pack_varint_to(next, dst_end, suffix);
+    BATT_CHECK_NOT_NULLPTR(next);
+
+    BATT_CHECK_LE(suffix, usize(dst_end - next));
+    if (suffix != 0) {
+      std::memcpy(next, key.data() + shared, suffix);
+    }
+    next += suffix;
+
+    prev = key;
+  }
+
+  BATT_CHECK_EQ(next, dst_end);
+
+  return packed;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+const u8* PackedFrontCodedStrings::decode_entry(const u8* entry, std::string* key) const
+{
+  u64 shared_size = 0, suffix_size = 0;
+  entry = parse_entry_header(entry, this->entries_end(), &shared_size, &suffix_size);
+
+  BATT_ASSERT_NOT_NULLPTR(entry);
+  BATT_ASSERT_LE(shared_size, key->size());
+
+  key->resize(shared_size);
+  key->append(reinterpret_cast<const char*>(entry), suffix_size);
+
+  return entry + suffix_size;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::string_view PackedFrontCodedStrings::restart_key(usize restart_i) const
+{
+  BATT_ASSERT_LT(restart_i, this->restart_count);
+
+  const u8* entry = reinterpret_cast<const u8*>(this) + this->restart_offsets()[restart_i];
+
+  u64 shared_size = 0, suffix_size = 0;
+  entry = parse_entry_header(entry, this->entries_end(), &shared_size, &suffix_size);
+
+  BATT_ASSERT_NOT_NULLPTR(entry);
+  BATT_ASSERT_EQ(shared_size, 0u);
+
+  return std::string_view{reinterpret_cast<const char*>(entry), suffix_size};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::string PackedFrontCodedStrings::get(usize index) const
+{
+  BATT_CHECK_LT(index, this->size());
+
+  const usize restart_i = index / this->restart_interval;
+  const u8* entry = reinterpret_cast<const u8*>(this) + this->restart_offsets()[restart_i];
+
+  std::string key;
+  for (usize i = restart_i * this->restart_interval; i <= index; ++i) {
+    entry = this->decode_entry(entry, &key);
+  }
+
+  return key;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize PackedFrontCodedStrings::lower_bound(const std::string_view& key) const
+{
+  // Find the first restart point whose key is not less than `key`; the answer is either in the
+  // block of entries before it or is that restart point.
+  //
+  usize lo = 0;
+  usize hi = this->restart_count;
+  while (lo < hi) {
+    const usize mid = lo + (hi - lo) / 2;
+    if (this->restart_key(mid) < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  const usize next_restart_i = lo;
+  if (next_restart_i == 0) {
+    return 0;
+  }
+
+  const usize restart_i = next_restart_i - 1;
+  const usize first = restart_i * this->restart_interval;
+  const usize last = std::min<usize>(this->size(), first + this->restart_interval);
+
+  // The restart key is less than `key`, so start with the entry after it.
+  //
+  const u8* entry = reinterpret_cast<const u8*>(this) + this->restart_offsets()[restart_i];
+  std::string current;
+  entry = this->decode_entry(entry, &current);
+
+  for (usize i = first + 1; i < last; ++i) {
+    entry = this->decode_entry(entry, &current);
+    if (!(current < key)) {
+      return i;
+    }
+  }
+
+  return last;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<usize> PackedFrontCodedStrings::find(const std::string_view& key) const
+{
+  const usize i = this->lower_bound(key);
+  if (i == this->size() || this->get(i) != key) {
+    return None;
+  }
+  return i;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status validate_packed_value(const PackedFrontCodedStrings& packed, const void* buffer_data,
+                             usize buffer_size)
+{
+  BATT_REQUIRE_OK(validate_packed_struct(packed, buffer_data, buffer_size));
+  BATT_REQUIRE_OK(
+      validate_packed_byte_range(&packed, packed.size_in_bytes, buffer_data, buffer_size));
+
+  const usize count = packed.size();
+  const usize restart_interval = packed.restart_interval;
+
+  if (restart_interval == 0 || packed.restart_count != restart_count_for(count, restart_interval) ||
+      sizeof(PackedFrontCodedStrings) + usize{packed.restart_count} * sizeof(little_u32) >
+          packed.size_in_bytes) {
+    return make_status(StatusCode::kPackedFrontCodedStringsBadData);
+  }
+
+  // Walk all the entries, checking that they are within bounds, that each shares no more than the
+  // size of the string before it, and that the restart points are where the table says.
+  //
+  const u8* const packed_begin = reinterpret_cast<const u8*>(&packed);
+  const u8* const entries_end = packed.entries_end();
+  const little_u32* const restart_offsets = packed.restart_offsets();
+
+  const u8* entry = packed.entries_begin();
+  u64 prev_size = 0;
+  for (usize i = 0; i < count; ++i) {
+    if (i % restart_interval == 0 &&
+        restart_offsets[i / restart_interval] != usize(entry - packed_begin)) {
+      return make_status(StatusCode::kPackedFrontCodedStringsBadData);
+    }
+
+    u64 shared_size = 0, suffix_size = 0;
+    entry = parse_entry_header(entry, entries_end, &shared_size, &suffix_size);
+    if (!entry || shared_size > prev_size || (i % restart_interval == 0 && shared_size != 0) ||
+        suffix_size > u64(entries_end - entry)) {
+      return make_status(StatusCode::kPackedFrontCodedStringsBadData);
+    }
+
+    entry += suffix_size;
+    prev_size = shared_size + suffix_size;
+  }
+
+  if (entry != entries_end) {
+    return make_status(StatusCode::kPackedFrontCodedStringsBadData);
+  }
+
+  return OkStatus();
+}
+
+}  // namespace llfs
@@ -0,0 +1,157 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PACKED_FRONT_CODED_STRINGS_HPP
+#define LLFS_PACKED_FRONT_CODED_STRINGS_HPP
+
+#include <llfs/buffer.hpp>
+#include <llfs/data_layout.hpp>
+#include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/slice.hpp>
+#include <batteries/static_assert.hpp>
+
+#include <string>
+#include <string_view>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A front-coded array of (sorted) strings.
+ *
+ * Each string is stored as the length of the prefix it shares with the string before it, followed
+ * by the rest of the string (the suffix).  Every `restart_interval`-th string is a restart point:
+ * it is stored in full (shared length 0), and its offset is recorded in the restart table, so that
+ * lookups can binary-search the restart points and then decode at most `restart_interval` entries.
+ *
+ * Layout:
+ *
+ *   PackedFrontCodedStrings header (16 bytes)
+ *   little_u32 restart_offsets[restart_count] (byte offsets from the start of the header)
+ *   entries: varint shared_size, varint suffix_size, suffix bytes
+ *
+ * Sorted keys with long common prefixes take much less space than a PackedArray<PackedBytes>.
+ * Compared to a BPTrie, lookups decode more bytes, but sequential scans are cheap and the packed
+ * structure is simple to build.  Any sequence of strings can be packed and read back by index;
+ * `lower_bound` and `find` require that they were sorted.
+ */
+struct PackedFrontCodedStrings {
+  static constexpr usize kDefaultRestartInterval = 16;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  little_u32 item_count;
+  little_u32 size_in_bytes;
+  little_u32 restart_count;
+  little_u16 restart_interval;
+  little_u16 reserved_;
+
+  // This struct must never be copied since that would invalidate the restart offsets.
+  //
+  PackedFrontCodedStrings(const PackedFrontCodedStrings&) = delete;
+  PackedFrontCodedStrings& operator=(const PackedFrontCodedStrings&) = delete;
+
+  usize size() const
+  {
+    return this->item_count;
+  }
+
+  bool empty() const
+  {
+    return this->item_count == 0;
+  }
+
+  const little_u32* restart_offsets() const
+  {
+    return reinterpret_cast<const little_u32*>(this + 1);
+  }
+
+  /** \brief Returns the string at restart point `restart_i` (i.e., item `restart_i *
+   * restart_interval`) in place.
+   */
+  std::string_view restart_key(usize restart_i) const;
+
+  /** \brief Returns the string at `index`, which must be less than `size()`.
+   */
+  std::string get(usize index) const;
+
+  /** \brief Returns the index of the first string that is not less than `key` (or `size()` if there
+   * is none).  Only valid if the strings were sorted when packed.
+   */
+  usize lower_bound(const std::string_view& key) const;
+
+  /** \brief Returns the index of `key`, or None if it isn't present.  Only valid if the strings
+   * were sorted when packed.
+   */
+  Optional<usize> find(const std::string_view& key) const;
+
+  /** \brief Calls `fn(index, key)` for each string in order; `key` is only valid during the call.
+   */
+  template <typename Fn /* = void(usize index, std::string_view key) */>
+  void for_each(Fn&& fn) const
+  {
+    std::string key;
+    const u8* next = this->entries_begin();
+    for (usize i = 0; i < this->size(); ++i) {
+      next = this->decode_entry(next, &key);
+      fn(i, std::string_view{key});
+    }
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const u8* entries_begin() const
+  {
+    return reinterpret_cast<const u8*>(this->restart_offsets() + this->restart_count);
+  }
+
+  const u8* entries_end() const
+  {
+    return reinterpret_cast<const u8*>(this) + this->size_in_bytes;
+  }
+
+  /** \brief Decodes the entry at `entry`, replacing the suffix of `key` (which must hold the string
+   * before it), and returns a pointer to the next entry.
+   */
+  const u8* decode_entry(const u8* entry, std::string* key) const;
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedFrontCodedStrings), 16);
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+/** \brief Returns the size of the PackedFrontCodedStrings representation of `keys`.
+ */
+usize packed_sizeof_front_coded_strings(
+    const batt::Slice<const std::string_view>& keys,
+    usize restart_interval = PackedFrontCodedStrings::kDefaultRestartInterval);
+
+/** \brief Packs `keys` into `dst`, which must be exactly `packed_sizeof_front_coded_strings(keys,
+ * restart_interval)` bytes, and returns the packed array.
+ */
+PackedFrontCodedStrings* pack_front_coded_strings_to(
+    const MutableBuffer& dst, const batt::Slice<const std::string_view>& keys,
+    usize restart_interval = PackedFrontCodedStrings::kDefaultRestartInterval);
+
+inline usize packed_sizeof(const PackedFrontCodedStrings& packed)
+{
+  return packed.size_in_bytes;
+}
+
+/** \brief Checks that the restart table and all entries of `packed` are consistent and lie entirely
+ * within the given buffer.
+ */
+Status validate_packed_value(const PackedFrontCodedStrings& packed, const void* buffer_data,
+                             usize buffer_size);
+
+}  // namespace llfs
+
+#endif  // LLFS_PACKED_FRONT_CODED_STRINGS_HPP
@@ -0,0 +1,203 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/packed_front_coded_strings.hpp>
+//
+#include <llfs/packed_front_coded_strings.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/data_packer.hpp>
+#include <llfs/packed_array.hpp>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace llfs::int_types;
+
+// Test Plan:
+//  1. Round trip (get, for_each) for various counts and restart intervals.
+//  2. lower_bound and find agree with std::lower_bound on the sorted keys, for present keys,
+//     absent keys, and keys before/after all of them.
+//  3. Keys with long shared prefixes pack much smaller than a PackedArray<PackedBytes>.
+//  4. validate_packed_value rejects truncated or corrupted data.
+
+std::vector<std::string> make_sorted_keys(usize count, std::default_random_engine& rng)
+{
+  std::uniform_int_distribution<u32> pick_row{0, 99999};
+
+  std::vector<std::string> keys;
+  for (usize i = 0; i < count; ++i) {
+    std::string key = "tenant/0042/table/users/row/" + std::to_string(pick_row(rng));
+    if (i % 5 == 0) {
+      key.resize(key.size() / 2);
+    }
+    keys.emplace_back(std::move(key));
+  }
+  std::sort(keys.begin(), keys.end());
+
+  return keys;
+}
+
+std::vector<u8> pack_keys(const std::vector<std::string>& keys, usize restart_interval)
+{
+  const std::vector<std::string_view> views(keys.begin(), keys.end());
+
+  std::vector<u8> buffer(
+      llfs::packed_sizeof_front_coded_strings(batt::as_slice(views), restart_interval));
+
+  llfs::DataPacker packer{llfs::MutableBuffer{buffer.data(), buffer.size()}};
+  BATT_CHECK_NOT_NULLPTR(packer.pack_front_coded_strings(batt::as_slice(views), restart_interval));
+  BATT_CHECK_EQ(packer.space(), 0u);
+
+  return buffer;
+}
+
+const llfs::PackedFrontCodedStrings& as_packed(const std::vector<u8>& buffer)
+{
+  return *reinterpret_cast<const llfs::PackedFrontCodedStrings*>(buffer.data());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PackedFrontCodedStringsTest, RoundTrip)
+{
+  std::default_random_engine rng{1};
+
+  for (usize count : {0, 1, 2, 15, 16, 17, 500}) {
+    for (usize restart_interval : {1, 2, 16, 64}) {
+      const std::vector<std::string> keys = make_sorted_keys(count, rng);
+      const std::vector<u8> buffer = pack_keys(keys, restart_interval);
+      const llfs::PackedFrontCodedStrings& packed = as_packed(buffer);
+
+      ASSERT_TRUE(llfs::validate_packed_value(packed, buffer.data(), buffer.size()).ok());
+      ASSERT_EQ(packed.size(), count);
+
+      for (usize i = 0; i < count; ++i) {
+        ASSERT_EQ(packed.get(i), keys[i]) << BATT_INSPECT(i) << BATT_INSPECT(restart_interval);
+      }
+
+      std::vector<std::string> scanned;
+      packed.for_each([&scanned](usize i, std::string_view key) {
+        EXPECT_EQ(i, scanned.size());
+        scanned.emplace_back(key);
+      });
+      EXPECT_EQ(scanned, keys);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PackedFrontCodedStringsTest, LowerBoundAndFind)
+{
+  std::default_random_engine rng{2};
+
+  for (usize count : {0, 1, 16, 17, 300}) {
+    for (usize restart_interval : {1, 4, 16}) {
+      const std::vector<std::string> keys = make_sorted_keys(count, rng);
+      const std::vector<u8> buffer = pack_keys(keys, restart_interval);
+      const llfs::PackedFrontCodedStrings& packed = as_packed(buffer);
+
+      std::vector<std::string> queries = make_sorted_keys(100, rng);
+      queries.insert(queries.end(), keys.begin(), keys.end());
+      queries.emplace_back("");
+      queries.emplace_back("zzz");
+
+      for (const std::string& query : queries) {
+        const usize expected = std::lower_bound(keys.begin(), keys.end(), query) - keys.begin();
+        ASSERT_EQ(packed.lower_bound(query), expected)
+            << BATT_INSPECT(count) << BATT_INSPECT(restart_interval) << BATT_INSPECT(query);
+
+        llfs::Optional<usize> found = packed.find(query);
+        if (expected < keys.size() && keys[expected] == query) {
+          ASSERT_TRUE(found);
+          EXPECT_EQ(*found, expected);
+        } else {
+          EXPECT_FALSE(found);
+        }
+      }
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PackedFrontCodedStringsTest, Compression)
+{
+  std::default_random_engine rng{3};
+
+  const std::vector<std::string> keys = make_sorted_keys(1000, rng);
+
+  usize array_size = llfs::packed_array_size<llfs::PackedBytes>(keys.size());
+  for (const std::string& key : keys) {
+    array_size += llfs::packed_sizeof_str_data(key.size());
+  }
+
+  const usize packed_size = pack_keys(keys, llfs::PackedFrontCodedStrings::kDefaultRestartInterval)
+                                .size();
+
+  EXPECT_LT(packed_size * 3, array_size) << BATT_INSPECT(packed_size) << BATT_INSPECT(array_size);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PackedFrontCodedStringsTest, Validate)
+{
+  std::default_random_engine rng{4};
+
+  const std::vector<std::string> keys = make_sorted_keys(40, rng);
+  const std::vector<u8> buffer = pack_keys(keys, /*restart_interval=*/8);
+
+  // Truncated.
+  //
+  EXPECT_FALSE(
+      llfs::validate_packed_value(as_packed(buffer), buffer.data(), buffer.size() - 1).ok());
+  {
+    std::vector<u8> truncated = buffer;
+    truncated.pop_back();
+    auto& packed = *reinterpret_cast<llfs::PackedFrontCodedStrings*>(truncated.data());
+    packed.size_in_bytes = packed.size_in_bytes - 1;
+    EXPECT_FALSE(llfs::validate_packed_value(packed, truncated.data(), truncated.size()).ok());
+  }
+
+  // Bad restart table.
+  //
+  {
+    std::vector<u8> corrupt = buffer;
+    auto& packed = *reinterpret_cast<llfs::PackedFrontCodedStrings*>(corrupt.data());
+    packed.restart_count = packed.restart_count + 1;
+    EXPECT_FALSE(llfs::validate_packed_value(packed, corrupt.data(), corrupt.size()).ok());
+  }
+  {
+    std::vector<u8> corrupt = buffer;
+    auto* restart_offsets = reinterpret_cast<little_u32*>(corrupt.data() +
+                                                          sizeof(llfs::PackedFrontCodedStrings));
+    restart_offsets[2] = restart_offsets[2] + 1;
+    EXPECT_FALSE(
+        llfs::validate_packed_value(as_packed(corrupt), corrupt.data(), corrupt.size()).ok());
+  }
+
+  // A shared prefix longer than the previous key.
+  //
+  {
+    std::vector<u8> corrupt = buffer;
+    const llfs::PackedFrontCodedStrings& packed = as_packed(corrupt);
+    const usize second_entry_offset =
+        (packed.entries_begin() - corrupt.data()) + 2 + packed.restart_key(0).size();
+    corrupt[second_entry_offset] = 0x7f;
+    EXPECT_FALSE(llfs::validate_packed_value(packed, corrupt.data(), corrupt.size()).ok());
+  }
+}
+
+}  // namespace
@@ -13,6 +13,19 @@
 
 namespace llfs {
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, PageChecksumType t)
+{
+  switch (t) {
+    case PageChecksumType::kLegacyCrc64:
+      return out << "LegacyCrc64";
+    case PageChecksumType::kCrc32c:
+      return out << "Crc32c";
+  }
+  return out << "PageChecksumType{" << static_cast<int>(t) << "}";
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 Status PackedPageHeader::sanity_check(PageSize page_size, PageId page_id,
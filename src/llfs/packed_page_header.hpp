@@ -25,6 +25,21 @@ namespace llfs {
 
 struct PackedPageHeader;
 
+/** \brief The algorithm used to compute PackedPageHeader::crc32.
+ */
+enum struct PageChecksumType : u8 {
+  // The low 32 bits of the (boost, bytewise) CRC64 of the page; all pages written before
+  // PackedPageHeader::checksum_info was added use this.
+  //
+  kLegacyCrc64 = 0,
+
+  // CRC32C (Castagnoli), computed with the SSE4.2/ARMv8 CRC32 instructions where available.
+  //
+  kCrc32c = 1,
+};
+
+std::ostream& operator<<(std::ostream& out, PageChecksumType t);
+
 std::ostream& operator<<(std::ostream& out, const PackedPageHeader& t);
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -33,6 +48,12 @@ struct PackedPageHeader {
   static constexpr u64 kMagic = 0x35f2e78c6a06fc2bull;
   static constexpr u32 kCrc32NotSet = 0xdeadcc32ul;
 
+  // The upper 24 bits of `checksum_info` when it is set; anything else (including the bytes of the
+  // old user slot in pages written before this field existed) means kLegacyCrc64.
+  //
+  static constexpr u32 kChecksumInfoMagic = 0xc5c32c00ul;
+  static constexpr u32 kChecksumInfoMagicMask = 0xffffff00ul;
+
   u32 unused_size() const noexcept
   {
     BATT_CHECK_LE(this->unused_begin, this->unused_end) << *this;
@@ -47,13 +68,28 @@ struct PackedPageHeader {
   Status sanity_check(PageSize page_size, PageId page_id,
                       const PageIdFactory& id_factory) const noexcept;
 
+  PageChecksumType checksum_type() const noexcept
+  {
+    const u32 info = this->checksum_info.value();
+    if ((info & kChecksumInfoMagicMask) != kChecksumInfoMagic) {
+      return PageChecksumType::kLegacyCrc64;
+    }
+    return static_cast<PageChecksumType>(info & ~kChecksumInfoMagicMask);
+  }
+
+  void set_checksum_type(PageChecksumType type) noexcept
+  {
+    this->checksum_info = kChecksumInfoMagic | static_cast<u32>(type);
+  }
+
   big_u64 magic;
   PackedPageId page_id;
   PageLayoutId layout_id;
   little_u32 crc32;
   little_u32 unused_begin;
   little_u32 unused_end;
-  PackedPageUserSlot user_slot_DEPRECATED;
+  little_u32 checksum_info;
+  little_u8 reserved_[20];
   little_u32 size;
 };
 
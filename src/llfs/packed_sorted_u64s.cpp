@@ -0,0 +1,256 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/packed_sorted_u64s.hpp>
+//
+
+#include <llfs/status_code.hpp>
+#include <llfs/unpack_cast.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/checked_cast.hpp>
+
+#include <algorithm>
+
+namespace llfs {
+
+namespace {
+
+// Returns the number of bits needed to store `n` (0 for n == 0).
+//
+inline usize bits_needed(u64 n)
+{
+  return (n == 0) ? 0 : (64 - __builtin_clzll(n));
+}
+
+// Returns the number of bytes of delta bit fields for `count` values of `bit_width` bits.
+//
+inline usize delta_bytes(usize count, usize bit_width)
+{
+  return (count * bit_width + 7) / 8;
+}
+
+// Returns the base (smallest value) and delta bit width of the given block of values.
+//
+std::pair<u64, usize> block_params(const u64* first, const u64* last)
+{
+  const auto [min_it, max_it] = std::minmax_element(first, last);
+  return {*min_it, bits_needed(*max_it - *min_it)};
+}
+
+// Decodes `count` deltas of a byte-aligned width; this loop can be vectorized by the compiler.
+//
+template <typename LittleT>
+void unpack_aligned_deltas(const u8* src, u64 base, usize count, u64* out)
+{
+  const LittleT* deltas = reinterpret_cast<const LittleT*>(src);
+  for (usize i = 0; i < count; ++i) {
+    out[i] = base + deltas[i].value();
+  }
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize packed_sizeof_sorted_u64s(const batt::Slice<const u64>& values)
+{
+  const usize count = values.size();
+  const usize block_count =
+      (count + PackedSortedU64s::kBlockSize - 1) / PackedSortedU64s::kBlockSize;
+
+  usize total = sizeof(PackedSortedU64s) + block_count * sizeof(PackedSortedU64sBlock) +
+                PackedSortedU64s::kTrailingPadSize;
+
+  for (usize first = 0; first < count; first += PackedSortedU64s::kBlockSize) {
+    const usize last = std::min(count, first + PackedSortedU64s::kBlockSize);
+    const usize bit_width = block_params(values.begin() + first, values.begin() + last).second;
+
+    total += delta_bytes(last - first, bit_width);
+  }
+
+  return total;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PackedSortedU64s* pack_sorted_u64s_to(const MutableBuffer& dst,
+                                      const batt::Slice<const u64>& values)
+{
+  BATT_CHECK_EQ(dst.size(), packed_sizeof_sorted_u64s(values));
+
+  std::memset(dst.data(), 0, dst.size());
+
+  auto* packed = static_cast<PackedSortedU64s*>(dst.data());
+  packed->item_count = BATT_CHECKED_CAST(u32, values.size());
+  packed->size_in_bytes = BATT_CHECKED_CAST(u32, dst.size());
+
+  auto* blocks = reinterpret_cast<PackedSortedU64sBlock*>(packed + 1);
+  u8* const data_begin = static_cast<u8*>(dst.data());
+  u8* data = reinterpret_cast<u8*>(blocks + packed->block_count());
+
+  const usize count = values.size();
+  for (usize first = 0; first < count; first += PackedSortedU64s::kBlockSize) {
+    const usize last = std::min(count, first + PackedSortedU64s::kBlockSize);
+    const auto [base, bit_width] = block_params(values.begin() + first, values.begin() + last);
+
+    PackedSortedU64sBlock& block = blocks[first / PackedSortedU64s::kBlockSize];
+    block.base = base;
+    block.data_offset = BATT_CHECKED_CAST(u32, data - data_begin);
+    block.bit_width = BATT_CHECKED_CAST(u8, bit_width);
+
+    // The destination is zeroed, so each delta can be OR-ed in, a byte at a time (little-endian
+    // bit order).
+    //
+    usize bit_pos = 0;
+    for (usize i = first; i < last; ++i) {
+      const u64 delta = values[i] - base;
+      for (usize written = 0; written < bit_width;) {
+        const usize shift = bit_pos % 8;
+        const usize n = std::min(8 - shift, bit_width - written);
+
+        data[bit_pos / 8] |= static_cast<u8>(((delta >> written) & ((u64{1} << n) - 1)) << shift);
+
+        written += n;
+        bit_pos += n;
+      }
+    }
+    data += delta_bytes(last - first, bit_width);
+  }
+
+  BATT_CHECK_EQ(data + PackedSortedU64s::kTrailingPadSize, data_begin + dst.size());
+
+  return packed;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize PackedSortedU64s::unpack_block(usize block_i, u64* out) const
+{
+  BATT_ASSERT_LT(block_i, this->block_count());
+
+  const PackedSortedU64sBlock& block = this->blocks()[block_i];
+  const usize first = block_i * kBlockSize;
+  const usize count = std::min(kBlockSize, this->size() - first);
+  const u64 base = block.base;
+  const u8* src = reinterpret_cast<const u8*>(this) + block.data_offset;
+
+  switch (block.bit_width) {
+    case 0:
+      std::fill(out, out + count, base);
+      break;
+    case 8:
+      unpack_aligned_deltas<little_u8>(src, base, count, out);
+      break;
+    case 16:
+      unpack_aligned_deltas<little_u16>(src, base, count, out);
+      break;
+    case 32:
+      unpack_aligned_deltas<little_u32>(src, base, count, out);
+      break;
+    case 64:
+      unpack_aligned_deltas<little_u64>(src, base, count, out);
+      break;
+    default:
+      for (usize i = 0; i < count; ++i) {
+        out[i] = this->get(first + i);
+      }
+      break;
+  }
+
+  return count;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PackedSortedU64s::unpack_to(const batt::Slice<u64>& out) const
+{
+  BATT_CHECK_EQ(out.size(), this->size());
+
+  u64* dst = out.begin();
+  for (usize block_i = 0; block_i < this->block_count(); ++block_i) {
+    dst += this->unpack_block(block_i, dst);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize PackedSortedU64s::lower_bound(u64 key) const
+{
+  // Since the values are sorted, the base of each block is its first value.  Find the first block
+  // whose base is not less than `key`; the answer is either in the block before it or is the first
+  // value of that block.
+  //
+  const PackedSortedU64sBlock* const blocks_begin = this->blocks();
+  const PackedSortedU64sBlock* const blocks_end = blocks_begin + this->block_count();
+
+  const PackedSortedU64sBlock* next_block =
+      std::partition_point(blocks_begin, blocks_end, [key](const PackedSortedU64sBlock& block) {
+        return block.base < key;
+      });
+
+  const usize next_block_i = next_block - blocks_begin;
+  if (next_block_i == 0) {
+    return 0;
+  }
+
+  usize lo = (next_block_i - 1) * kBlockSize;
+  usize hi = std::min(this->size(), next_block_i * kBlockSize);
+
+  while (lo < hi) {
+    const usize mid = lo + (hi - lo) / 2;
+    if (this->get(mid) < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status validate_packed_value(const PackedSortedU64s& packed, const void* buffer_data,
+                             usize buffer_size)
+{
+  BATT_REQUIRE_OK(validate_packed_struct(packed, buffer_data, buffer_size));
+  BATT_REQUIRE_OK(
+      validate_packed_byte_range(&packed, packed.size_in_bytes, buffer_data, buffer_size));
+
+  // Check that the block table, the deltas of each block, and the padding are where they would be
+  // if `packed` had been produced by `pack_sorted_u64s_to`.
+  //
+  const usize count = packed.size();
+  const usize block_count = packed.block_count();
+
+  usize expected_offset = sizeof(PackedSortedU64s) + block_count * sizeof(PackedSortedU64sBlock);
+  if (expected_offset > packed.size_in_bytes) {
+    return make_status(StatusCode::kPackedSortedU64sBadData);
+  }
+
+  const PackedSortedU64sBlock* blocks = packed.blocks();
+  for (usize block_i = 0; block_i < block_count; ++block_i) {
+    const PackedSortedU64sBlock& block = blocks[block_i];
+    const usize block_size =
+        std::min(PackedSortedU64s::kBlockSize, count - block_i * PackedSortedU64s::kBlockSize);
+
+    if (block.bit_width > 64 || block.data_offset != expected_offset) {
+      return make_status(StatusCode::kPackedSortedU64sBadData);
+    }
+    expected_offset += delta_bytes(block_size, block.bit_width);
+  }
+
+  if (expected_offset + PackedSortedU64s::kTrailingPadSize != packed.size_in_bytes) {
+    return make_status(StatusCode::kPackedSortedU64sBadData);
+  }
+
+  return OkStatus();
+}
+
+}  // namespace llfs
@@ -0,0 +1,177 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PACKED_SORTED_U64S_HPP
+#define LLFS_PACKED_SORTED_U64S_HPP
+
+#include <llfs/buffer.hpp>
+#include <llfs/data_layout.hpp>
+#include <llfs/int_types.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/slice.hpp>
+#include <batteries/static_assert.hpp>
+
+#include <boost/endian/conversion.hpp>
+
+#include <cstring>
+
+namespace llfs {
+
+/** \brief The header of one block of a PackedSortedU64s.
+ */
+struct PackedSortedU64sBlock {
+  /** \brief The smallest value in the block; every value is stored as its difference from this.
+   */
+  little_u64 base;
+
+  /** \brief The byte offset (from the start of the PackedSortedU64s) of the block's deltas.
+   */
+  little_u32 data_offset;
+
+  /** \brief The number of bits of each delta in the block (0..64).
+   */
+  u8 bit_width;
+
+  u8 reserved_[3];
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedSortedU64sBlock), 16);
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A frame-of-reference compressed array of u64 values.
+ *
+ * The values are split into blocks of kBlockSize values.  Each block stores the smallest of its
+ * values as the base, and the differences of its values from the base as a dense array of
+ * fixed-width little-endian bit fields; the width is the number of bits of the largest difference.
+ * Any sequence of values can be packed, but those that are sorted or clustered (page ids of one
+ * device, slot offsets, ...) take up much less space than an array of little_u64.
+ *
+ * Layout:
+ *
+ *   PackedSortedU64s header (8 bytes)
+ *   PackedSortedU64sBlock[block_count()]
+ *   delta bit fields of block 0, block 1, ... (each block's deltas start on a byte boundary)
+ *   kTrailingPadSize zero bytes
+ *
+ * Any value can be read in O(1) time via `get(i)`.  The padding lets each delta be read with one
+ * (unaligned) 8-byte load plus at most one more byte, without checking for the end of the data.
+ */
+struct PackedSortedU64s {
+  /** \brief The number of values per block.
+   */
+  static constexpr usize kBlockSize = 64;
+
+  /** \brief The number of zero bytes after the delta bit fields.
+   */
+  static constexpr usize kTrailingPadSize = 8;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  little_u32 item_count;
+  little_u32 size_in_bytes;
+
+  // This struct must never be copied since that would invalidate the blocks.
+  //
+  PackedSortedU64s(const PackedSortedU64s&) = delete;
+  PackedSortedU64s& operator=(const PackedSortedU64s&) = delete;
+
+  usize size() const
+  {
+    return this->item_count;
+  }
+
+  bool empty() const
+  {
+    return this->item_count == 0;
+  }
+
+  usize block_count() const
+  {
+    return (this->size() + kBlockSize - 1) / kBlockSize;
+  }
+
+  const PackedSortedU64sBlock* blocks() const
+  {
+    return reinterpret_cast<const PackedSortedU64sBlock*>(this + 1);
+  }
+
+  /** \brief Returns the value at `index`, which must be less than `size()`.
+   */
+  u64 get(usize index) const
+  {
+    const PackedSortedU64sBlock& block = this->blocks()[index / kBlockSize];
+    const usize bit_width = block.bit_width;
+    const usize bit_offset = (index % kBlockSize) * bit_width;
+
+    const u8* p = reinterpret_cast<const u8*>(this) + block.data_offset + bit_offset / 8;
+    const usize shift = bit_offset % 8;
+
+    u64 word;
+    std::memcpy(&word, p, sizeof(word));
+    word = boost::endian::little_to_native(word) >> shift;
+
+    // The delta may extend into the ninth byte if it is wider than 64 - shift bits.
+    //
+    if (shift + bit_width > 64) {
+      word |= u64{p[8]} << (64 - shift);
+    }
+
+    const u64 mask = (bit_width == 64) ? ~u64{0} : ((u64{1} << bit_width) - 1);
+
+    return block.base + (word & mask);
+  }
+
+  u64 operator[](usize index) const
+  {
+    return this->get(index);
+  }
+
+  /** \brief Decodes all the values of block `block_i` into `out`, which must have room for
+   * kBlockSize values; returns the number of values in the block.
+   */
+  usize unpack_block(usize block_i, u64* out) const;
+
+  /** \brief Decodes all values into `out`, which must be of size `size()`.
+   */
+  void unpack_to(const batt::Slice<u64>& out) const;
+
+  /** \brief Returns the index of the first value that is not less than `key` (or `size()` if there
+   * is none).  Only valid if the values were sorted (ascending) when packed.
+   */
+  usize lower_bound(u64 key) const;
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedSortedU64s), 8);
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+/** \brief Returns the size of the PackedSortedU64s representation of `values`.
+ */
+usize packed_sizeof_sorted_u64s(const batt::Slice<const u64>& values);
+
+/** \brief Packs `values` into `dst`, which must be exactly `packed_sizeof_sorted_u64s(values)`
+ * bytes, and returns the packed array.
+ */
+PackedSortedU64s* pack_sorted_u64s_to(const MutableBuffer& dst,
+                                      const batt::Slice<const u64>& values);
+
+inline usize packed_sizeof(const PackedSortedU64s& packed)
+{
+  return packed.size_in_bytes;
+}
+
+/** \brief Checks that `packed` is consistent and lies entirely within the given buffer.
+ */
+Status validate_packed_value(const PackedSortedU64s& packed, const void* buffer_data,
+                             usize buffer_size);
+
+}  // namespace llfs
+
+#endif  // LLFS_PACKED_SORTED_U64S_HPP
@@ -0,0 +1,206 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/packed_sorted_u64s.hpp>
+//
+#include <llfs/packed_sorted_u64s.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/data_packer.hpp>
+#include <llfs/data_reader.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace llfs::int_types;
+
+// Test Plan:
+//  1. Round trip (get, unpack_to) for empty, partial-block, and multi-block inputs, with sorted,
+//     clustered, constant, and full-range values (all delta widths, including 0 and 64).
+//  2. lower_bound agrees with std::lower_bound on sorted inputs.
+//  3. Sorted page-id-like values pack much smaller than an array of little_u64.
+//  4. DataReader::read_sorted_u64s reads back what DataPacker::pack_sorted_u64s packed, and
+//     rejects truncated or corrupted data.
+
+std::vector<u8> pack_values(const std::vector<u64>& values)
+{
+  std::vector<u8> buffer(llfs::packed_sizeof_sorted_u64s(batt::as_slice(values)));
+  llfs::DataPacker packer{llfs::MutableBuffer{buffer.data(), buffer.size()}};
+
+  llfs::PackedSortedU64s* packed = packer.pack_sorted_u64s(batt::as_slice(values));
+  BATT_CHECK_NOT_NULLPTR(packed);
+  BATT_CHECK_EQ(packer.space(), 0u);
+
+  return buffer;
+}
+
+void verify_round_trip(const std::vector<u64>& values)
+{
+  const std::vector<u8> buffer = pack_values(values);
+  const auto& packed = *reinterpret_cast<const llfs::PackedSortedU64s*>(buffer.data());
+
+  ASSERT_TRUE(llfs::validate_packed_value(packed, buffer.data(), buffer.size()).ok());
+  ASSERT_EQ(packed.size(), values.size());
+
+  for (usize i = 0; i < values.size(); ++i) {
+    ASSERT_EQ(packed.get(i), values[i]) << BATT_INSPECT(i) << BATT_INSPECT(values.size());
+  }
+
+  std::vector<u64> unpacked(values.size());
+  packed.unpack_to(batt::as_slice(unpacked));
+  EXPECT_EQ(unpacked, values);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PackedSortedU64sTest, RoundTrip)
+{
+  std::default_random_engine rng{1};
+
+  for (usize count : {0, 1, 2, 63, 64, 65, 200, 1000}) {
+    // Sorted, with gaps of various sizes.
+    //
+    for (u64 max_gap : {0u, 1u, 200u, 65535u, 1u << 30}) {
+      std::uniform_int_distribution<u64> pick_gap{0, max_gap};
+      std::vector<u64> values;
+      u64 next = u64{7} << 40;
+      for (usize i = 0; i < count; ++i) {
+        values.push_back(next);
+        next += pick_gap(rng);
+      }
+      verify_round_trip(values);
+    }
+
+    // Clustered (unsorted) and full-range random values; the latter need 64-bit deltas.
+    //
+    std::uniform_int_distribution<u64> pick_offset{0, 4095};
+    std::uniform_int_distribution<u64> pick_any;
+    std::vector<u64> clustered, random;
+    for (usize i = 0; i < count; ++i) {
+      clustered.push_back(u64{123456789} + pick_offset(rng));
+      random.push_back(pick_any(rng));
+    }
+    random.push_back(0);
+    random.push_back(~u64{0});
+
+    verify_round_trip(clustered);
+    verify_round_trip(random);
+  }
+
+  // Every delta width.
+  //
+  for (usize bit_width = 0; bit_width <= 64; ++bit_width) {
+    const u64 max_delta = (bit_width == 64) ? ~u64{0} : ((u64{1} << bit_width) - 1);
+    std::vector<u64> values;
+    for (usize i = 0; i < 100; ++i) {
+      values.push_back((i % 3 == 0) ? 0 : (max_delta - i % 5 * (max_delta / 7)));
+    }
+    verify_round_trip(values);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PackedSortedU64sTest, LowerBound)
+{
+  std::default_random_engine rng{2};
+  std::uniform_int_distribution<u64> pick_value{0, 10000};
+
+  for (usize count : {0, 1, 63, 64, 65, 500}) {
+    std::vector<u64> values;
+    for (usize i = 0; i < count; ++i) {
+      values.push_back(pick_value(rng));
+    }
+    std::sort(values.begin(), values.end());
+
+    const std::vector<u8> buffer = pack_values(values);
+    const auto& packed = *reinterpret_cast<const llfs::PackedSortedU64s*>(buffer.data());
+
+    for (u64 key = 0; key <= 10001; key += 7) {
+      const usize expected = std::lower_bound(values.begin(), values.end(), key) - values.begin();
+      ASSERT_EQ(packed.lower_bound(key), expected) << BATT_INSPECT(count) << BATT_INSPECT(key);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PackedSortedU64sTest, Compression)
+{
+  // Page ids of one device with a small generation, allocated mostly in order.
+  //
+  std::vector<u64> values;
+  for (u64 i = 0; i < 1000; ++i) {
+    values.push_back((u64{3} << 56) | (u64{1} << 32) | (i * 3));
+  }
+
+  const usize packed_size = llfs::packed_sizeof_sorted_u64s(batt::as_slice(values));
+  const usize array_size = llfs::packed_array_size<little_u64>(values.size());
+
+  EXPECT_LT(packed_size * 3, array_size) << BATT_INSPECT(packed_size) << BATT_INSPECT(array_size);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PackedSortedU64sTest, DataReader)
+{
+  std::vector<u64> first_values, second_values;
+  for (u64 i = 0; i < 150; ++i) {
+    first_values.push_back(1000 + i * i);
+    second_values.push_back(i % 10);
+  }
+
+  std::vector<u8> buffer(llfs::packed_sizeof_sorted_u64s(batt::as_slice(first_values)) +
+                         llfs::packed_sizeof_sorted_u64s(batt::as_slice(second_values)));
+  {
+    llfs::DataPacker packer{llfs::MutableBuffer{buffer.data(), buffer.size()}};
+    ASSERT_NE(packer.pack_sorted_u64s(batt::as_slice(first_values)), nullptr);
+    ASSERT_NE(packer.pack_sorted_u64s(batt::as_slice(second_values)), nullptr);
+    EXPECT_EQ(packer.pack_sorted_u64s(batt::as_slice(second_values)), nullptr);
+  }
+  {
+    llfs::DataReader reader{llfs::ConstBuffer{buffer.data(), buffer.size()}};
+
+    const llfs::PackedSortedU64s* first = reader.read_sorted_u64s();
+    const llfs::PackedSortedU64s* second = reader.read_sorted_u64s();
+    ASSERT_NE(first, nullptr);
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(reader.bytes_available(), 0u);
+
+    std::vector<u64> unpacked(first->size());
+    first->unpack_to(batt::as_slice(unpacked));
+    EXPECT_EQ(unpacked, first_values);
+
+    unpacked.resize(second->size());
+    second->unpack_to(batt::as_slice(unpacked));
+    EXPECT_EQ(unpacked, second_values);
+
+    EXPECT_EQ(reader.read_sorted_u64s(), nullptr);
+  }
+  {
+    llfs::DataReader reader{llfs::ConstBuffer{buffer.data(), 20}};
+    EXPECT_EQ(reader.read_sorted_u64s(), nullptr);
+  }
+  {
+    // Corrupt the data offset of the second block.
+    //
+    std::vector<u8> corrupt = buffer;
+    auto* blocks = reinterpret_cast<llfs::PackedSortedU64sBlock*>(corrupt.data() + 8);
+    blocks[1].data_offset = blocks[1].data_offset + 1;
+
+    llfs::DataReader reader{llfs::ConstBuffer{corrupt.data(), corrupt.size()}};
+    EXPECT_EQ(reader.read_sorted_u64s(), nullptr);
+  }
+}
+
+}  // namespace
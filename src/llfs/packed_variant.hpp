@@ -17,15 +17,47 @@
 
 #include <batteries/assert.hpp>
 #include <batteries/static_assert.hpp>
-#include <batteries/static_dispatch.hpp>
+#include <batteries/hint.hpp>
 #include <batteries/tuples.hpp>
 #include <batteries/utility.hpp>
 
 #include <limits>
 #include <tuple>
+#include <type_traits>
+#include <utility>
 
 namespace llfs {
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// The jump table used by PackedVariant::visit_type: entry `i` invokes the visitor with
+// `batt::StaticType<std::tuple_element_t<i, TupleT>>`.
+//
+template <typename TupleT, typename FnRef,
+          typename Indices = std::make_index_sequence<std::tuple_size_v<TupleT>>>
+struct PackedVariantDispatchTable;
+
+template <typename... Ts, typename FnRef, usize... kIndex>
+struct PackedVariantDispatchTable<std::tuple<Ts...>, FnRef, std::index_sequence<kIndex...>> {
+  static_assert(sizeof...(Ts) > 0, "An empty PackedVariant can not be visited");
+
+  using Fn = std::remove_reference_t<FnRef>;
+
+  template <usize kCase>
+  using CaseType = batt::StaticType<std::tuple_element_t<kCase, std::tuple<Ts...>>>;
+
+  using Result = decltype(std::declval<FnRef>()(CaseType<0>{}));
+
+  template <usize kCase>
+  static Result invoke_case(Fn& fn)
+  {
+    return static_cast<FnRef>(fn)(CaseType<kCase>{});
+  }
+
+  using CaseFn = Result (*)(Fn&);
+
+  static constexpr CaseFn kCaseFns[sizeof...(Ts)] = {&invoke_case<kIndex>...};
+};
+
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 //
 template <typename... Ts>
@@ -62,6 +94,13 @@ struct PackedVariant {
     this->which = n;
   }
 
+  /** \brief Invokes `visitor` with a const reference to the packed case value.
+   *
+   * Dispatches through a constexpr table of per-case functions (one indirect call), so the cost
+   * does not grow with the number of case types.  The result type is that of the visitor for the
+   * first case type; the results for all other cases must convert to it.  Panics if `which` is out
+   * of range (see `validate_packed_value`).
+   */
   template <typename Fn>
   decltype(auto) visit(Fn&& visitor) const
   {
@@ -73,10 +112,48 @@ struct PackedVariant {
     });
   }
 
+  /** \brief Same as `visit(visitor)`, except that the check for the case `HotT` (which should be
+   * the most frequent one) is inlined ahead of the table dispatch.
+   */
+  template <typename HotT, typename Fn>
+  decltype(auto) visit(batt::StaticType<HotT> hot_type, Fn&& visitor) const
+  {
+    const void* value_ptr = this + 1;
+
+    return this->visit_type(hot_type,
+                            [value_ptr, &visitor](auto static_type) mutable -> decltype(auto) {
+                              using T = typename decltype(static_type)::type;
+                              return BATT_FORWARD(visitor)(*reinterpret_cast<const T*>(value_ptr));
+                            });
+  }
+
+  /** \brief Invokes `visitor` with `batt::StaticType<T>{}`, where T is the case type; dispatches
+   * the same way as `visit`.
+   */
   template <typename Fn>
   decltype(auto) visit_type(Fn&& visitor) const
   {
-    return batt::static_dispatch<tuple_type>(this->which.value(), BATT_FORWARD(visitor));
+    using Table = PackedVariantDispatchTable<tuple_type, Fn&&>;
+
+    const usize i = this->which.value();
+    BATT_CHECK_LT(i, kNumCases) << "PackedVariant case out-of-bounds";
+
+    return Table::kCaseFns[i](visitor);
+  }
+
+  template <typename HotT, typename Fn>
+  decltype(auto) visit_type(batt::StaticType<HotT> hot_type, Fn&& visitor) const
+  {
+    using Table = PackedVariantDispatchTable<tuple_type, Fn&&>;
+    using Result = typename Table::Result;
+
+    constexpr usize kHotIndex = batt::TupleIndexOf_v<tuple_type, HotT>;
+    static_assert(kHotIndex < kNumCases, "HotT is not one of the case types of this PackedVariant");
+
+    if (BATT_HINT_TRUE(this->which.value() == kHotIndex)) {
+      return static_cast<Result>(BATT_FORWARD(visitor)(hot_type));
+    }
+    return this->visit_type(BATT_FORWARD(visitor));
   }
 
   /** \brief If the variant case is the given type, returns a pointer to the packed T; else returns
@@ -166,6 +243,10 @@ batt::Status validate_packed_value(const PackedVariant<Ts...>& var, const void*
     return ::llfs::make_status(StatusCode::kUnpackCastVariantStructOutOfBounds);
   }
 
+  if (var.which >= PackedVariant<Ts...>::kNumCases) {
+    return ::llfs::make_status(StatusCode::kBadPackedVariant);
+  }
+
   return var.visit([&](const auto& case_instance) {
     return ::llfs_validate_packed_value_helper(case_instance,
                                                ConstBuffer{buffer_data, buffer_size});
@@ -108,4 +108,49 @@ TEST_F(PackedVariantTest, UnpackCastFailCastDataOOB)
       this->overflow_error_case(this->n64, llfs::StatusCode::kUnpackCastWrongIntegerSize, 1u));
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(PackedVariantTest, VisitHotType)
+{
+  ASSERT_NO_FATAL_FAILURE(this->pack_value(this->n32));
+
+  const Var& var = *reinterpret_cast<const Var*>(this->buffer.data());
+
+  // The hot type matches the case.
+  //
+  EXPECT_EQ(var.visit(batt::StaticType<llfs::little_u32>{},
+                      [](auto value) -> u64 {
+                        return value;
+                      }),
+            this->n32.value());
+
+  // The hot type doesn't match the case; falls back to the jump table.
+  //
+  EXPECT_EQ(var.visit(batt::StaticType<llfs::little_u64>{},
+                      [](auto value) -> u64 {
+                        return value;
+                      }),
+            this->n32.value());
+
+  EXPECT_EQ(var.visit_type(batt::StaticType<llfs::little_u16>{},
+                           [](auto static_type) -> usize {
+                             return sizeof(typename decltype(static_type)::type);
+                           }),
+            sizeof(llfs::little_u32));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(PackedVariantTest, UnpackCastFailBadCase)
+{
+  ASSERT_NO_FATAL_FAILURE(this->pack_value(this->n64));
+
+  this->buffer[0] = Var::kNumCases;
+
+  llfs::StatusOr<const Var&> unpacked = llfs::unpack_cast<Var>(this->buffer);
+
+  ASSERT_FALSE(unpacked.ok());
+  EXPECT_EQ(unpacked.status(), llfs::StatusCode::kBadPackedVariant);
+}
+
 }  // namespace
@@ -9,6 +9,7 @@
 #include <llfs/page_allocator.hpp>
 //
 
+#include <llfs/contention_profiler.hpp>
 #include <llfs/data_packer.hpp>
 #include <llfs/data_reader.hpp>
 #include <llfs/metrics.hpp>
@@ -20,6 +21,9 @@
 #include <boost/range/irange.hpp>
 #include <boost/uuid/uuid_io.hpp>
 
+#include <algorithm>
+#include <unordered_map>
+
 namespace llfs {
 
 u64 PageAllocator::calculate_log_size(u64 physical_page_count, u64 max_attachments)
@@ -64,10 +68,28 @@ StatusOr<std::unique_ptr<PageAllocator>> PageAllocator::recover(
 
   // Create a State object to collect recovered events from the log.
   //
-  auto recovered_state = std::make_unique<PageAllocator::State>(page_ids, /*max_attachments=*/64);
+  auto recovered_state = std::make_unique<PageAllocator::State>(page_ids, /*max_attachments=*/64,
+                                                                runtime_options.page_count);
 
   PageAllocator::Metrics metrics;
 
+  // If there is a snapshot file, load it now; since the log alone is always sufficient to recover
+  // the allocator, a snapshot that can't be loaded is ignored.
+  //
+  std::unique_ptr<PageAllocatorSnapshot> snapshot;
+  if (runtime_options.snapshot_file_name) {
+    StatusOr<std::unique_ptr<PageAllocatorSnapshot>> opened =
+        PageAllocatorSnapshot::open(*runtime_options.snapshot_file_name, page_ids);
+
+    if (opened.ok()) {
+      snapshot = std::move(*opened);
+    } else {
+      LLFS_LOG_WARNING() << "Could not load PageAllocator snapshot; doing a full log replay"
+                         << BATT_INSPECT(runtime_options.snapshot_file_name)
+                         << BATT_INSPECT(opened.status());
+    }
+  }
+
   // For each recovered event in the log, update the state machine.
   //
   auto process_recovered_event = [&recovered_state](const SlotParse& slot,
@@ -80,7 +102,34 @@ StatusOr<std::unique_ptr<PageAllocator>> PageAllocator::recover(
   // Read the log, scanning its contents.
   //
   StatusOr<std::unique_ptr<LogDevice>> recovered_log = log_device_factory.open_log_device(
-      [&process_recovered_event](LogDevice::Reader& log_reader) -> StatusOr<slot_offset_type> {
+      [&](LogDevice::Reader& log_reader) -> StatusOr<slot_offset_type> {
+        // The snapshot can only be used if the log still contains its slot offset; if the log has
+        // been trimmed past that point, it is newer than the snapshot anyhow.
+        //
+        if (snapshot && !slot_less_than(snapshot->slot_offset(), log_reader.slot_offset())) {
+          BATT_REQUIRE_OK(recovered_state->recover(*snapshot));
+
+          // Skip the part of the log covered by the snapshot.
+          //
+          while (slot_less_than(log_reader.slot_offset(), snapshot->slot_offset())) {
+            const usize n_to_skip = std::min<usize>(
+                log_reader.data().size(),
+                slot_distance(log_reader.slot_offset(), snapshot->slot_offset()));
+
+            if (n_to_skip == 0) {
+              LLFS_LOG_ERROR() << "The PageAllocator log ends before the snapshot slot offset!"
+                               << BATT_INSPECT(log_reader.slot_offset())
+                               << BATT_INSPECT(snapshot->slot_offset());
+              return ::llfs::make_status(StatusCode::kPageAllocatorSnapshotMismatch);
+            }
+            log_reader.consume(n_to_skip);
+          }
+
+          LLFS_VLOG(1) << "PageAllocator recovered snapshot: "
+                       << BATT_INSPECT(snapshot->slot_offset())
+                       << BATT_INSPECT(snapshot->entries().size());
+        }
+
         TypedSlotReader<PackedPageAllocatorEvent> slot_reader{log_reader};
 
         BATT_ASSIGN_OK_RESULT(usize slots_recovered, slot_reader.run(batt::WaitForResource::kFalse,
@@ -139,10 +188,14 @@ PageAllocator::PageAllocator(batt::TaskScheduler& scheduler, std::string_view na
     return batt::to_string("PageAllocator_", this->name_, "_", property);
   };
 
-#define ADD_METRIC_(n) global_metric_registry().add(metric_name(#n), this->metrics_.n)
+#define ADD_METRIC_(n) this->metrics_.n.add_to_registry(global_metric_registry(), metric_name(#n))
 
   ADD_METRIC_(pages_allocated);
   ADD_METRIC_(pages_freed);
+  ADD_METRIC_(extents_allocated);
+  ADD_METRIC_(extent_fallbacks);
+  ADD_METRIC_(txn_batches);
+  ADD_METRIC_(txns_coalesced);
 
 #undef ADD_METRIC_
 }
@@ -156,9 +209,16 @@ PageAllocator::~PageAllocator() noexcept
   this->halt();
   this->join();
 
-  global_metric_registry()  //
-      .remove(this->metrics_.pages_allocated)
-      .remove(this->metrics_.pages_freed);
+  for (StripedCountMetric<u64>* metric : {
+           &this->metrics_.pages_allocated,
+           &this->metrics_.pages_freed,
+           &this->metrics_.extents_allocated,
+           &this->metrics_.extent_fallbacks,
+           &this->metrics_.txn_batches,
+           &this->metrics_.txns_coalesced,
+       }) {
+    metric->remove_from_registry(global_metric_registry());
+  }
 }
 
 void PageAllocator::halt() noexcept
@@ -196,12 +256,25 @@ StatusOr<PageId> PageAllocator::allocate_page(batt::WaitForResource wait_for_res
   }
 
   for (;;) {
+    // Fast path: allocate from the current CPU's free page cache, without locking the state.
+    //
+    Optional<PageId> cached_page_id = this->state_.no_lock().allocate_cached_page();
+    if (cached_page_id) {
+      this->metrics_.pages_allocated.add(1);
+      return *cached_page_id;
+    }
     {
-      auto locked = this->state_.lock();
-      Optional<PageId> page_id = locked->get()->allocate_page();
-      if (page_id) {
-        this->metrics_.pages_allocated.fetch_add(1);
-        return *page_id;
+      auto locked = LLFS_PROFILE_LOCK_WAIT("PageAllocator::state_", this->state_.lock());
+      if (locked->get()->free_pool_shard_count() != 0) {
+        if (locked->get()->refill_free_page_cache() != 0) {
+          continue;
+        }
+      } else {
+        Optional<PageId> page_id = locked->get()->allocate_page();
+        if (page_id) {
+          this->metrics_.pages_allocated.add(1);
+          return *page_id;
+        }
       }
       LLFS_LOG_INFO_FIRST_N(1) << "Unable to allocate page (pool is empty)"
                                << "; device=" << (**locked).page_ids().get_device_id();
@@ -227,8 +300,91 @@ StatusOr<PageId> PageAllocator::allocate_page(batt::WaitForResource wait_for_res
 void PageAllocator::deallocate_page(PageId page_id)
 {
   LLFS_VLOG(1) << "page deallocated: " << page_id;
-  this->state_.lock()->get()->deallocate_page(page_id);
-  this->metrics_.pages_freed.fetch_add(1);
+  if (!this->state_.no_lock().deallocate_cached_page(page_id)) {
+    LLFS_PROFILE_LOCK_WAIT("PageAllocator::state_", this->state_.lock())
+        ->get()
+        ->deallocate_page(page_id);
+  }
+  this->metrics_.pages_freed.add(1);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageAllocator::grow(PageCount new_page_count)
+{
+  auto locked = LLFS_PROFILE_LOCK_WAIT("PageAllocator::state_", this->state_.lock());
+  return locked->get()->grow(new_page_count);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::vector<PageId>> PageAllocator::allocate_extent(
+    PageCount count, batt::WaitForResource wait_for_resource, const batt::CancelToken& cancel_token)
+{
+  if (count.value() > this->state_.no_lock().page_device_capacity()) {
+    return {batt::StatusCode::kInvalidArgument};
+  }
+
+  // See allocate_page.
+  //
+  if (wait_for_resource == batt::WaitForResource::kFalse) {
+    if (BATT_HINT_FALSE(this->recovering_user_count_.get_value() > 0)) {
+      return {batt::StatusCode::kUnavailable};
+    }
+  } else {
+    BATT_REQUIRE_OK(this->recovering_user_count_.await_equal(0));
+  }
+
+  {
+    auto locked = LLFS_PROFILE_LOCK_WAIT("PageAllocator::state_", this->state_.lock());
+    Optional<std::vector<PageId>> extent = locked->get()->allocate_extent(count);
+    if (extent) {
+      this->metrics_.pages_allocated.add(count.value());
+      this->metrics_.extents_allocated.add(1);
+      return {std::move(*extent)};
+    }
+  }
+
+  // The free pool is fragmented (or some of it is held in per-CPU caches); allocate the pages one
+  // at a time.
+  //
+  this->metrics_.extent_fallbacks.add(1);
+
+  std::vector<PageId> page_ids;
+  page_ids.reserve(count.value());
+
+  while (page_ids.size() < count.value()) {
+    StatusOr<PageId> page_id = this->allocate_page(wait_for_resource, cancel_token);
+    if (!page_id.ok()) {
+      this->deallocate_extent(page_ids);
+      return page_id.status();
+    }
+    page_ids.emplace_back(*page_id);
+  }
+
+  const PageIdFactory& page_ids_factory = this->state_.no_lock().page_ids();
+  std::sort(page_ids.begin(), page_ids.end(), [&page_ids_factory](PageId left, PageId right) {
+    return page_ids_factory.get_physical_page(left) < page_ids_factory.get_physical_page(right);
+  });
+
+  return {std::move(page_ids)};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageAllocator::deallocate_extent(const std::vector<PageId>& page_ids)
+{
+  if (page_ids.empty()) {
+    return;
+  }
+  {
+    auto locked = LLFS_PROFILE_LOCK_WAIT("PageAllocator::state_", this->state_.lock());
+    for (PageId page_id : page_ids) {
+      LLFS_VLOG(1) << "page deallocated: " << page_id;
+      locked->get()->deallocate_page(page_id);
+    }
+  }
+  this->metrics_.pages_freed.add(page_ids.size());
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -289,6 +445,282 @@ std::pair<i32, slot_offset_type> PageAllocator::get_ref_count(PageId id)
   return {info.ref_count, info.learned_upper_bound};
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageAllocatorRefCountStatus PageAllocator::get_ref_count_status(PageId id)
+{
+  return this->state_->get_ref_count_status(id);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<slot_offset_type> PageAllocator::commit_txn(PendingTxn* txn)
+{
+  {
+    std::unique_lock<std::mutex> lock{this->txn_queue_mutex_};
+    this->txn_queue_.emplace_back(txn);
+    if (this->txn_leader_active_) {
+      lock.unlock();
+      return txn->done.await();
+    }
+    this->txn_leader_active_ = true;
+  }
+
+  // We are the leader; keep committing batches until no more calls are waiting.  Our own call is
+  // in the first batch.
+  //
+  std::vector<PendingTxn*> batch;
+  for (;;) {
+    batch.clear();
+    {
+      std::unique_lock<std::mutex> lock{this->txn_queue_mutex_};
+      if (this->txn_queue_.empty()) {
+        this->txn_leader_active_ = false;
+        break;
+      }
+      std::swap(batch, this->txn_queue_);
+    }
+    this->commit_txn_batch(batch);
+  }
+
+  return txn->done.await();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageAllocator::commit_txn_batch(const std::vector<PendingTxn*>& batch)
+{
+  // NOTE: once a call is done, its PendingTxn may go away at any time, so we only look at the
+  // calls that haven't been committed yet.
+  //
+  usize first = 0;
+  while (first < batch.size()) {
+    usize last = first + 1;
+    usize n_ref_counts = batch[first]->ref_counts.size();
+
+    while (last < batch.size() && last - first < kMaxCoalescedTxns &&
+           batch[last]->user_id == batch[first]->user_id &&
+           n_ref_counts + batch[last]->ref_counts.size() <= kMaxCoalescedRefCounts) {
+      n_ref_counts += batch[last]->ref_counts.size();
+      ++last;
+    }
+
+    this->commit_coalesced_txns(batt::as_slice(batch.data() + first, last - first));
+    first = last;
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+namespace {
+
+// Packs a txn with the given user slot and ref count deltas into a newly allocated `buffer`.
+//
+PackedPageAllocatorTxn* pack_txn(const boost::uuids::uuid& user_id, slot_offset_type user_slot,
+                                 const std::vector<PageRefCount>& ref_counts,
+                                 std::unique_ptr<u8[]>* buffer)
+{
+  const usize op_size = packed_sizeof_page_allocator_txn(ref_counts.size());
+
+  buffer->reset(new u8[op_size]);
+  DataPacker packer{MutableBuffer{buffer->get(), op_size}};
+  auto* txn = packer.pack_record<PackedPageAllocatorTxn>();
+  BATT_CHECK_NOT_NULLPTR(txn);
+
+  txn->user_slot.user_id = user_id;
+  txn->user_slot.slot_offset = user_slot;
+  txn->user_index = PageAllocatorState::kInvalidUserIndex;
+  txn->ref_counts.initialize(0u);
+
+  BasicArrayPacker<PackedPageRefCount, DataPacker> packed_ref_counts{&txn->ref_counts, &packer};
+  for (const PageRefCount& prc : ref_counts) {
+    BATT_CHECK(packed_ref_counts.pack_item(prc));
+  }
+
+  return txn;
+}
+
+// Appends the deltas of `ref_counts` to `dst`, keeping only the last delta for each page (see
+// PageAllocator::update_page_ref_counts).
+//
+void append_last_delta_per_page(const std::vector<PageRefCount>& ref_counts,
+                                std::vector<PageRefCount>* dst)
+{
+  std::unordered_map<PageId, usize, PageId::Hash> last_index;
+  for (usize i = 0; i < ref_counts.size(); ++i) {
+    last_index[ref_counts[i].page_id] = i;
+  }
+  for (usize i = 0; i < ref_counts.size(); ++i) {
+    if (last_index[ref_counts[i].page_id] == i) {
+      dst->emplace_back(ref_counts[i]);
+    }
+  }
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageAllocator::commit_coalesced_txns(batt::Slice<PendingTxn* const> txns)
+{
+  BATT_CHECK(!txns.empty());
+
+  std::unique_ptr<u8[]> buffer;
+  std::unordered_set<PageId, PageId::Hash> claimed;
+
+  // A single call is committed exactly as it would be without batching.
+  //
+  if (txns.size() == 1) {
+    PendingTxn* const pending = txns.front();
+    PackedPageAllocatorTxn* const txn =
+        pack_txn(pending->user_id, pending->user_slot, pending->ref_counts, &buffer);
+
+    StatusOr<slot_offset_type> result = this->update(*txn);
+    if (result.ok()) {
+      this->find_dead_pages(pending, txn->user_index, &claimed);
+    }
+    pending->done.set_value(result);
+    return;
+  }
+
+  // Packs the concatenated deltas of all calls for which `accepted` is true, with the user slot of
+  // the last of these.
+  //
+  const auto pack_coalesced = [&](const std::vector<bool>& accepted) {
+    std::vector<PageRefCount> ref_counts;
+    slot_offset_type user_slot = txns.front()->user_slot;
+    for (usize i = 0; i < txns.size(); ++i) {
+      if (accepted[i]) {
+        append_last_delta_per_page(txns[i]->ref_counts, &ref_counts);
+        user_slot = txns[i]->user_slot;
+      }
+    }
+    return pack_txn(txns.front()->user_id, user_slot, ref_counts, &buffer);
+  };
+
+  // The calls whose deltas were actually applied by the committed txn; only these may claim dead
+  // pages (a duplicate's ref counts may have reached 1 because of some other update).
+  //
+  std::vector<bool> applied(txns.size(), false);
+
+  const StatusOr<slot_offset_type> result = [&]() -> StatusOr<slot_offset_type> {
+    std::vector<bool> accepted(txns.size(), true);
+    PackedPageAllocatorTxn* txn = pack_coalesced(accepted);
+
+    const usize reserve_size = packed_sizeof_slot(*txn) + packed_sizeof_checkpoint(*txn);
+
+    StatusOr<batt::Grant> slot_grant =
+        this->slot_writer_.reserve(reserve_size, batt::WaitForResource::kTrue);
+    BATT_REQUIRE_OK(slot_grant);
+
+    StatusOr<SlotRange> commit_slot;
+    {
+      auto locked_state = LLFS_PROFILE_LOCK_WAIT("PageAllocator::state_", this->state_.lock());
+      State* state = locked_state->get();
+
+      // Drop the calls that are duplicates, either of calls already learned or of earlier calls in
+      // this batch.  If all are duplicates, `txn` is left as is; its user slot is then not greater
+      // than the attachment's, so `propose_coalesced` will return kNoChange.
+      //
+      Optional<PageAllocatorAttachmentStatus> attachment =
+          state->get_client_attachment_status(txns.front()->user_id);
+      if (attachment) {
+        accepted.assign(txns.size(), false);
+        slot_offset_type last_user_slot = attachment->user_slot;
+        for (usize i = 0; i < txns.size(); ++i) {
+          if (slot_less_than(last_user_slot, txns[i]->user_slot)) {
+            accepted[i] = true;
+            last_user_slot = txns[i]->user_slot;
+          }
+        }
+        const usize n_accepted = std::count(accepted.begin(), accepted.end(), true);
+        if (n_accepted != 0 && n_accepted != txns.size()) {
+          txn = pack_coalesced(accepted);
+        }
+      }
+
+      const State::ProposalStatus proposal_status = state->propose_coalesced(txn);
+
+      if (proposal_status == State::ProposalStatus::kInvalid_NotAttached) {
+        return ::llfs::make_status(StatusCode::kPageAllocatorNotAttached);
+      }
+
+      if (proposal_status == State::ProposalStatus::kValid) {
+        // Merging may have shrunk the txn; give back what we won't need.
+        //
+        const usize needed_size = packed_sizeof_slot(*txn) + packed_sizeof_checkpoint(*txn);
+        BATT_CHECK_LE(needed_size, slot_grant->size());
+        {
+          StatusOr<batt::Grant> excess = slot_grant->spend(slot_grant->size() - needed_size);
+          BATT_CHECK_OK(excess);
+        }
+
+        commit_slot = this->slot_writer_.append(*slot_grant, *txn);
+        BATT_REQUIRE_OK(commit_slot);
+
+        state->learn(*commit_slot, *txn, this->metrics_);
+
+        this->metrics_.txn_batches.add(1);
+        this->metrics_.txns_coalesced.add(txns.size());
+
+        applied = accepted;
+      } else {
+        BATT_CHECK_EQ(proposal_status, State::ProposalStatus::kNoChange);
+      }
+    }
+
+    for (usize i = 0; i < txns.size(); ++i) {
+      if (applied[i]) {
+        this->find_dead_pages(txns[i], txn->user_index, &claimed);
+      }
+    }
+
+    if (!commit_slot.ok()) {
+      return this->log_device_->slot_range(LogReadMode::kDurable).upper_bound;
+    }
+
+    // Take whatever was left over from the slot grant and allow it to be used for checkpoints.
+    //
+    this->checkpoint_grant_.subsume(std::move(*slot_grant));
+
+    return commit_slot->upper_bound;
+  }();
+
+  for (PendingTxn* pending : txns) {
+    pending->done.set_value(result);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageAllocator::find_dead_pages(PendingTxn* txn, u32 user_index,
+                                    std::unordered_set<PageId, PageId::Hash>* claimed) const
+{
+  const StateNoLock& state = this->state_.no_lock();
+
+  // Select only the pages from this set of updates that are now at ref_count==1, meaning they are
+  // ready for GC.  If ref_count is 1, that means the current call has removed the last reference
+  // to a page, so we can be sure there are no race conditions.  Each page is claimed by at most
+  // one call in a batch.
+  //
+  for (const PageRefCount& delta : txn->ref_counts) {
+    if (delta.ref_count < 0 && delta.ref_count != kRefCount_1_to_0) {
+      const PageAllocatorRefCountStatus page_status = state.get_ref_count_status(delta.page_id);
+
+      if (page_status.ref_count == 1 &&            //
+          page_status.user_index == user_index &&  //
+          page_status.page_id == delta.page_id) {
+        BATT_CHECK_EQ(PageIdFactory::get_device_id(delta.page_id),
+                      state.page_ids().get_device_id());
+
+        if (claimed->insert(delta.page_id).second) {
+          txn->dead_pages.emplace_back(delta.page_id);
+        }
+      }
+    }
+  }
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 BoxedSeq<PageRefCount> PageAllocator::page_ref_counts()
@@ -303,6 +735,30 @@ BoxedSeq<PageRefCount> PageAllocator::page_ref_counts()
          | seq::boxed();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<slot_offset_type> PageAllocator::write_snapshot(std::string_view file_name)
+{
+  std::vector<PackedPageAllocatorSnapshotEntry> entries;
+  slot_offset_type snapshot_slot = 0;
+  {
+    auto locked = LLFS_PROFILE_LOCK_WAIT("PageAllocator::state_", this->state_.lock());
+
+    entries = locked->get()->snapshot_entries();
+    snapshot_slot = locked->get()->learned_upper_bound();
+  }
+
+  // The snapshot must never be ahead of the durable log, or recovery would skip events that were
+  // lost.
+  //
+  BATT_REQUIRE_OK(this->sync(snapshot_slot));
+
+  BATT_REQUIRE_OK(PageAllocatorSnapshot::write_file(file_name, this->state_.no_lock().page_ids(),
+                                                    snapshot_slot, entries));
+
+  return snapshot_slot;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 void PageAllocator::checkpoint_task_main()
@@ -339,14 +795,27 @@ void PageAllocator::checkpoint_task_main()
       const auto slice_grant_before = slice_grant->size();
 
       slot_offset_type prior_learned_slot = this->state_->learned_upper_bound();
+
+      // Capture the least recently updated objects, then pack their refresh events without
+      // holding the state lock, so that allocator updates aren't blocked while the slice is built.
+      //
+      State::CheckpointSlice slice = [&] {
+        BATT_DEBUG_INFO("lock state (snapshot)");
+        auto locked = LLFS_PROFILE_LOCK_WAIT("PageAllocator::state_", this->state_.lock());
+        return locked->get()->snapshot_checkpoint_slice(slice_grant->size());
+      }();
+
+      BATT_REQUIRE_OK(State::pack_checkpoint_slice(this->slot_writer_, *slice_grant, slice));
+
+      // Appending the slice to the log (and dropping any entries that went stale in the meantime)
+      // is the only step that must be serialized with allocator updates.
+      //
       {
-        BATT_DEBUG_INFO("lock state");
-        auto locked = this->state_.lock();
+        BATT_DEBUG_INFO("lock state (commit)");
+        auto locked = LLFS_PROFILE_LOCK_WAIT("PageAllocator::state_", this->state_.lock());
 
-        // Tell the locked state machine to write out a batch of checkpoint slice data.
-        //
         auto write_checkpoint_status =
-            locked->get()->write_checkpoint_slice(this->slot_writer_, *slice_grant);
+            locked->get()->commit_checkpoint_slice(slice, *slice_grant);
         BATT_REQUIRE_OK(write_checkpoint_status);
 
         new_trim_pos = *write_checkpoint_status;
@@ -420,7 +889,7 @@ Status PageAllocator::sync(slot_offset_type min_slot)
 //
 std::vector<PageAllocatorAttachmentStatus> PageAllocator::get_all_clients_attachment_status() const
 {
-  auto locked = this->state_.lock();
+  auto locked = LLFS_PROFILE_LOCK_WAIT("PageAllocator::state_", this->state_.lock());
   return locked->get()->get_all_clients_attachment_status();
 }
 
@@ -429,7 +898,7 @@ std::vector<PageAllocatorAttachmentStatus> PageAllocator::get_all_clients_attach
 Optional<PageAllocatorAttachmentStatus> PageAllocator::get_client_attachment_status(
     const boost::uuids::uuid& uuid) const
 {
-  auto locked = this->state_.lock();
+  auto locked = LLFS_PROFILE_LOCK_WAIT("PageAllocator::state_", this->state_.lock());
   return locked->get()->get_client_attachment_status(uuid);
 }
 
@@ -24,12 +24,14 @@
 #include <llfs/slot_writer.hpp>
 
 #include <batteries/async/cancel_token.hpp>
+#include <batteries/async/latch.hpp>
 #include <batteries/async/mutex.hpp>
 #include <batteries/async/runtime.hpp>
 #include <batteries/async/task_scheduler.hpp>
 #include <batteries/async/types.hpp>
 #include <batteries/async/watch.hpp>
 #include <batteries/do_nothing.hpp>
+#include <batteries/slice.hpp>
 
 #include <boost/functional/hash.hpp>
 #include <boost/preprocessor/cat.hpp>
@@ -38,7 +40,9 @@
 #include <atomic>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <unordered_set>
+#include <vector>
 
 namespace llfs {
 
@@ -96,6 +100,39 @@ class PageAllocator
   //
   void deallocate_page(PageId id);
 
+  // Remove `count` physically contiguous pages from the free pool (returned in physical order), so
+  // they can be written and read with a single large I/O, but don't increment their refcounts yet.
+  // If the free pool has no contiguous run of that size (i.e., it is fragmented), falls back to
+  // allocating `count` pages individually (returned in physical order).
+  //
+  StatusOr<std::vector<PageId>> allocate_extent(
+      PageCount count, batt::WaitForResource wait_for_resource,
+      const batt::CancelToken& cancel_token = batt::CancelToken::none());
+
+  // Return the given pages to the (central) free pool without updating their refcounts; this
+  // allows contiguous runs to form again, unlike calling `deallocate_page` for each.
+  //
+  void deallocate_extent(const std::vector<PageId>& page_ids);
+
+  // Puts more of the device's pages into service, online: physical pages below `new_page_count`
+  // that were held in reserve (see PageAllocatorConfigOptions::max_page_count) are added to the
+  // free pool.  The page id layout is unchanged, so existing page ids stay valid.  Returns
+  // kOutOfRange if `new_page_count` exceeds the capacity of the page id space; shrinking is not
+  // supported (a smaller count is ignored).
+  //
+  // The new page count is not recorded durably by the allocator itself: pages that have been
+  // allocated are always recovered, but the caller must repeat the call after recovery (or update
+  // the configured page count) to bring the remaining new pages back into service.
+  //
+  Status grow(PageCount new_page_count);
+
+  // Returns the number of pages currently in service.
+  //
+  u64 page_count() const
+  {
+    return this->state_.no_lock().page_device_capacity();
+  }
+
   /** \brief Called by attached users to indicate they have successfully recovered.
    */
   Status notify_user_recovered(const boost::uuids::uuid& user_id);
@@ -105,6 +142,11 @@ class PageAllocator
   //
   std::pair<i32, slot_offset_type> get_ref_count(PageId id);
 
+  /** \brief Returns the current status of the physical page of `id`; `page_id` in the result has
+   * the current generation of the page, so a stale id can be detected by comparing it with `id`.
+   */
+  PageAllocatorRefCountStatus get_ref_count_status(PageId id);
+
   // Updates the index synchronously by applying the specified event.  Must be one of the event
   // types enumerated in page_device_event_types.hpp.
   // TODO [tastolfi 2023-03-22] deprecate public usage of this function!
@@ -132,6 +174,12 @@ class PageAllocator
    * sequence, then only the **last** such item will have any effect on the PageAllocator state.
    * Callers of this function must combine the deltas for each page_id prior to passing the
    * sequence, if that is the desired behavior.
+   *
+   * Concurrent calls are coalesced: while one batch of updates is being appended to the log, newly
+   * arriving calls are queued, and the next batch merges the queued calls of each user into a
+   * single txn (with each page's deltas applied in call order, and the user slot of the last call).
+   * Calls whose `user_slot` is not greater than that of an earlier call from the same user are
+   * treated as duplicates, exactly as if they had been applied one at a time.
    */
   template <typename PageRefCountSeq, typename GarbageCollectFn = DoNothing>
   StatusOr<slot_offset_type> update_page_ref_counts(
@@ -163,6 +211,12 @@ class PageAllocator
   //
   BoxedSeq<PageRefCount> page_ref_counts();
 
+  // Writes a snapshot of the current state of the allocator to the named file, so that a later
+  // recovery (with `PageAllocatorRuntimeOptions::snapshot_file_name` set) only needs to replay the
+  // log after the returned slot offset.  The log is flushed up to that offset first.
+  //
+  StatusOr<slot_offset_type> write_snapshot(std::string_view file_name);
+
   auto debug_info()
   {
     return [this](std::ostream& out) {
@@ -211,10 +265,53 @@ class PageAllocator
                          std::unique_ptr<LogDevice> log_device,
                          std::unique_ptr<State> recovered_state) noexcept;
 
+  // Queued call to `update_page_ref_counts`; see `commit_txn`.
+  //
+  struct PendingTxn {
+    boost::uuids::uuid user_id;
+    slot_offset_type user_slot;
+    std::vector<PageRefCount> ref_counts;
+
+    // The pages for which this call must invoke its garbage collection function; set (along with
+    // `done`) by the batch leader.
+    //
+    std::vector<PageId> dead_pages;
+
+    // Set to the result of the update when the batch containing this call is done.
+    //
+    batt::Latch<slot_offset_type> done;
+  };
+
+  // The maximum number of calls merged into a single txn, and the maximum total number of ref
+  // count deltas in the merged calls (a single larger call is always committed on its own).
+  //
+  static constexpr usize kMaxCoalescedTxns = 64;
+  static constexpr usize kMaxCoalescedRefCounts = 4096;
+
   void learner_task_main();
 
   void checkpoint_task_main();
 
+  // Queues `txn` for the next batch and waits for it to be done.  If no other thread is currently
+  // committing a batch, the caller becomes the leader, committing batches until the queue is
+  // empty.
+  //
+  StatusOr<slot_offset_type> commit_txn(PendingTxn* txn);
+
+  // Commits the queued calls in `batch`, in order, merging consecutive calls from the same user.
+  //
+  void commit_txn_batch(const std::vector<PendingTxn*>& batch);
+
+  // Commits `txns` (all from the same user) as a single txn; sets `dead_pages` and `done` for each.
+  //
+  void commit_coalesced_txns(batt::Slice<PendingTxn* const> txns);
+
+  // Sets `txn->dead_pages` to the pages whose ref count was decremented to 1 by `txn`, and which
+  // are not already claimed by an earlier call in the same batch (see `update_page_ref_counts`).
+  //
+  void find_dead_pages(PendingTxn* txn, u32 user_index,
+                       std::unordered_set<PageId, PageId::Hash>* claimed) const;
+
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
   // Metrics for this allocator.
@@ -266,6 +363,12 @@ class PageAllocator
   batt::Mutex<std::unordered_set<boost::uuids::uuid, boost::hash<boost::uuids::uuid>>>
       recovering_users_;
 
+  // Calls to `update_page_ref_counts` waiting for the next batch; see `commit_txn`.
+  //
+  std::mutex txn_queue_mutex_;
+  std::vector<PendingTxn*> txn_queue_;
+  bool txn_leader_active_ = false;
+
   // Writes checkpoint data so the log can be trimmed.
   //
   batt::Task checkpoint_task_;
@@ -354,66 +457,29 @@ inline StatusOr<slot_offset_type> PageAllocator::update_page_ref_counts(
     const boost::uuids::uuid& user_id, slot_offset_type user_slot,
     PageRefCountSeq&& ref_count_updates, GarbageCollectFn&& garbage_collect_fn)
 {
-  const std::size_t op_size =
-      packed_sizeof_page_allocator_txn(batt::make_copy(ref_count_updates) | seq::count());
-
-  std::unique_ptr<u8[]> buffer{new u8[op_size]};
-  DataPacker packer{MutableBuffer{buffer.get(), op_size}};
-  auto* txn = packer.pack_record<PackedPageAllocatorTxn>();
-  BATT_CHECK_NOT_NULLPTR(txn);
-
-  txn->user_slot.user_id = user_id;
-  txn->user_slot.slot_offset = user_slot;
-  txn->user_index = PageAllocatorState::kInvalidUserIndex;
-  txn->ref_counts.initialize(0u);
-
-  BasicArrayPacker<PackedPageRefCount, DataPacker> packed_ref_counts{&txn->ref_counts, &packer};
-  batt::make_copy(ref_count_updates) | seq::for_each([&packed_ref_counts](const PageRefCount& prc) {
-    BATT_CHECK(packed_ref_counts.pack_item(prc));
+  PendingTxn txn{
+      .user_id = user_id,
+      .user_slot = user_slot,
+      .ref_counts = {},
+      .dead_pages = {},
+      .done = {},
+  };
+
+  BATT_FORWARD(ref_count_updates) | seq::for_each([&txn](const PageRefCount& prc) {
+    txn.ref_counts.emplace_back(prc);
   });
 
-  LLFS_VLOG(2) << "updating ref counts: " << batt::dump_range(txn->ref_counts, batt::Pretty::True);
+  LLFS_VLOG(2) << "updating ref counts: " << batt::dump_range(txn.ref_counts, batt::Pretty::True);
 
-  StatusOr<slot_offset_type> update_status = this->update(*txn);
+  StatusOr<slot_offset_type> update_status = this->commit_txn(&txn);
   BATT_REQUIRE_OK(update_status);
 
-  {
-    auto& state = this->state_.no_lock();
-
-    BATT_FORWARD(ref_count_updates) |
-
-        // Select only the pages from this set of updates that are now at ref_count==1, meaning
-        // they are ready for GC.  If ref_count is 1, that means the current call has removed the
-        // last reference to a page, so we can be sure there are no race conditions.
-        //
-        seq::filter_map([&state, txn](const PageRefCount& delta) -> Optional<PageId> {
-          if (delta.ref_count < 0 && delta.ref_count != kRefCount_1_to_0) {
-            const PageAllocatorRefCountStatus page_status =
-                state.get_ref_count_status(delta.page_id);
-
-            if (page_status.ref_count == 1 &&                 //
-                page_status.user_index == txn->user_index &&  //
-                page_status.page_id == delta.page_id) {
-              BATT_CHECK_EQ(PageIdFactory::get_device_id(delta.page_id),
-                            state.page_ids().get_device_id());
-              return delta.page_id;
-            }
-          }
-          return None;
-        }) |
-
-        // Call the user-supplied function.
-        //
-        seq::for_each(BATT_FORWARD(garbage_collect_fn));
+  // Call the user-supplied function for each page that is now ready for GC.
+  //
+  for (const PageId& page_id : txn.dead_pages) {
+    garbage_collect_fn(page_id);
   }
 
-  LLFS_VLOG(2) << [&](std::ostream& out) {
-    auto& state = this->state_.no_lock();
-    for (const auto& prc : txn->ref_counts) {
-      out << prc << " -> " << state.get_ref_count_status(prc.page_id.unpack()).ref_count << ", ";
-    }
-  };
-
   return update_status;
 }
 
@@ -13,6 +13,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <llfs/filesystem.hpp>
 #include <llfs/log_device_snapshot.hpp>
 #include <llfs/memory_log_device.hpp>
 #include <llfs/testing/fake_log_device.hpp>
@@ -26,8 +27,11 @@
 
 #include <boost/uuid/uuid_generators.hpp>
 
+#include <atomic>
 #include <functional>
+#include <mutex>
 #include <random>
+#include <thread>
 #include <unordered_set>
 
 namespace {
@@ -1319,4 +1323,524 @@ TEST(PageAllocatorTest, CancelAllocate)
   }
 }
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Many threads allocating and deallocating at once (through the per-CPU free page caches) never
+// receive the same page twice, and afterwards a single thread can allocate every page (i.e., pages
+// cached by other CPUs are rebalanced).
+//
+TEST(PageAllocatorTest, ConcurrentAllocateDeallocate)
+{
+  constexpr usize kNumPages = 256;
+  constexpr usize kMaxAttachments = 64;
+  constexpr usize kNumThreads = 8;
+  constexpr usize kNumIterations = 2000;
+  static const usize kLogSize = llfs::PageAllocator::calculate_log_size(kNumPages, kMaxAttachments);
+
+  const llfs::PageAllocatorRuntimeOptions options{
+      .scheduler = batt::Runtime::instance().default_scheduler(),
+      .name = "TestAllocator",
+  };
+
+  const llfs::PageIdFactory id_factory{llfs::PageCount{kNumPages}, /*device_id=*/0};
+
+  batt::StatusOr<std::unique_ptr<llfs::PageAllocator>> page_allocator_status =
+      llfs::PageAllocator::recover(options, id_factory,
+                                   *std::make_unique<llfs::MemoryLogDeviceFactory>(kLogSize));
+
+  ASSERT_TRUE(page_allocator_status.ok()) << BATT_INSPECT(page_allocator_status.status());
+
+  llfs::PageAllocator& page_allocator = **page_allocator_status;
+
+  std::mutex in_use_mutex;
+  std::unordered_set<page_id_int> in_use;
+
+  std::vector<std::thread> threads;
+  for (usize thread_i = 0; thread_i < kNumThreads; ++thread_i) {
+    threads.emplace_back([&, thread_i] {
+      std::default_random_engine rng{thread_i};
+      std::vector<PageId> held;
+
+      for (usize i = 0; i < kNumIterations; ++i) {
+        if (held.empty() || (rng() % 2 == 0)) {
+          StatusOr<PageId> page_id = page_allocator.allocate_page(batt::WaitForResource::kFalse);
+          if (!page_id.ok()) {
+            BATT_CHECK_EQ(page_id.status(), batt::StatusCode::kResourceExhausted);
+            continue;
+          }
+          {
+            std::unique_lock<std::mutex> lock{in_use_mutex};
+            BATT_CHECK(in_use.emplace(id_factory.get_physical_page(*page_id)).second)
+                << BATT_INSPECT(*page_id);
+          }
+          held.emplace_back(*page_id);
+
+        } else {
+          const usize k = rng() % held.size();
+          std::swap(held[k], held.back());
+          {
+            std::unique_lock<std::mutex> lock{in_use_mutex};
+            BATT_CHECK_EQ(in_use.erase(id_factory.get_physical_page(held.back())), 1u);
+          }
+          page_allocator.deallocate_page(held.back());
+          held.pop_back();
+        }
+      }
+
+      for (PageId page_id : held) {
+        {
+          std::unique_lock<std::mutex> lock{in_use_mutex};
+          BATT_CHECK_EQ(in_use.erase(id_factory.get_physical_page(page_id)), 1u);
+        }
+        page_allocator.deallocate_page(page_id);
+      }
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+
+  EXPECT_TRUE(in_use.empty());
+  EXPECT_EQ(page_allocator.free_pool_size(), kNumPages);
+
+  std::unordered_set<page_id_int> allocated;
+  for (usize i = 0; i < kNumPages; ++i) {
+    StatusOr<PageId> page_id = page_allocator.allocate_page(batt::WaitForResource::kFalse);
+    ASSERT_TRUE(page_id.ok()) << BATT_INSPECT(page_id.status()) << BATT_INSPECT(i);
+    EXPECT_TRUE(allocated.emplace(id_factory.get_physical_page(*page_id)).second);
+  }
+  EXPECT_EQ(page_allocator.free_pool_size(), 0u);
+  EXPECT_EQ(page_allocator.allocate_page(batt::WaitForResource::kFalse).status(),
+            batt::StatusCode::kResourceExhausted);
+
+  page_allocator.halt();
+  page_allocator.join();
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// allocate_extent returns physically contiguous pages when the free pool has a long enough run,
+// and falls back to scattered pages when it is fragmented.
+//
+TEST(PageAllocatorTest, AllocateExtent)
+{
+  constexpr usize kNumPages = 256;
+  constexpr usize kMaxAttachments = 64;
+  static const usize kLogSize = llfs::PageAllocator::calculate_log_size(kNumPages, kMaxAttachments);
+
+  const llfs::PageAllocatorRuntimeOptions options{
+      .scheduler = batt::Runtime::instance().default_scheduler(),
+      .name = "TestAllocator",
+  };
+
+  const llfs::PageIdFactory id_factory{llfs::PageCount{kNumPages}, /*device_id=*/0};
+
+  batt::StatusOr<std::unique_ptr<llfs::PageAllocator>> page_allocator_status =
+      llfs::PageAllocator::recover(options, id_factory,
+                                   *std::make_unique<llfs::MemoryLogDeviceFactory>(kLogSize));
+
+  ASSERT_TRUE(page_allocator_status.ok()) << BATT_INSPECT(page_allocator_status.status());
+
+  llfs::PageAllocator& page_allocator = **page_allocator_status;
+
+  const auto is_contiguous = [&](const std::vector<PageId>& page_ids) {
+    for (usize i = 1; i < page_ids.size(); ++i) {
+      if (id_factory.get_physical_page(page_ids[i]) !=
+          id_factory.get_physical_page(page_ids[i - 1]) + 1) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  // Allocate the whole device as a sequence of contiguous extents.
+  //
+  std::vector<std::vector<PageId>> extents;
+  for (usize i = 0; i < kNumPages / 16; ++i) {
+    StatusOr<std::vector<PageId>> extent =
+        page_allocator.allocate_extent(PageCount{16}, batt::WaitForResource::kFalse);
+    ASSERT_TRUE(extent.ok()) << BATT_INSPECT(extent.status());
+    ASSERT_EQ(extent->size(), 16u);
+    EXPECT_TRUE(is_contiguous(*extent));
+
+    extents.emplace_back(std::move(*extent));
+  }
+  EXPECT_EQ(page_allocator.free_pool_size(), 0u);
+  EXPECT_EQ(page_allocator.allocate_extent(PageCount{1}, batt::WaitForResource::kFalse).status(),
+            batt::StatusCode::kResourceExhausted);
+
+  // Free every other page of each extent, so that no two free pages are adjacent.
+  //
+  for (const std::vector<PageId>& extent : extents) {
+    std::vector<PageId> to_free;
+    for (usize i = 0; i < extent.size(); i += 2) {
+      to_free.emplace_back(extent[i]);
+    }
+    page_allocator.deallocate_extent(to_free);
+  }
+  EXPECT_EQ(page_allocator.free_pool_size(), kNumPages / 2);
+
+  // A 4-page extent must now be scattered.
+  //
+  StatusOr<std::vector<PageId>> scattered =
+      page_allocator.allocate_extent(PageCount{4}, batt::WaitForResource::kFalse);
+  ASSERT_TRUE(scattered.ok()) << BATT_INSPECT(scattered.status());
+  ASSERT_EQ(scattered->size(), 4u);
+  EXPECT_FALSE(is_contiguous(*scattered));
+  EXPECT_EQ(page_allocator.free_pool_size(), kNumPages / 2 - 4);
+
+  // Failing to allocate a scattered extent releases the pages it did get.
+  //
+  EXPECT_EQ(page_allocator.allocate_extent(PageCount{kNumPages / 2}, batt::WaitForResource::kFalse)
+                .status(),
+            batt::StatusCode::kResourceExhausted);
+  EXPECT_EQ(page_allocator.free_pool_size(), kNumPages / 2 - 4);
+
+  // Freeing a whole extent makes it available again as a contiguous run.
+  //
+  page_allocator.deallocate_extent(*scattered);
+
+  std::vector<PageId> odd_pages;
+  for (usize i = 1; i < extents[3].size(); i += 2) {
+    odd_pages.emplace_back(extents[3][i]);
+  }
+  page_allocator.deallocate_extent(odd_pages);
+
+  StatusOr<std::vector<PageId>> reformed =
+      page_allocator.allocate_extent(PageCount{16}, batt::WaitForResource::kFalse);
+  ASSERT_TRUE(reformed.ok()) << BATT_INSPECT(reformed.status());
+  EXPECT_TRUE(is_contiguous(*reformed));
+  EXPECT_EQ(id_factory.get_physical_page(reformed->front()),
+            id_factory.get_physical_page(extents[3].front()));
+
+  page_allocator.halt();
+  page_allocator.join();
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Concurrent calls to update_page_ref_counts from the same user (which may be coalesced into a
+// single txn) are applied exactly once if accepted, and not at all if they arrive after a call
+// with a greater user slot; deltas to a shared (hot) page are summed across calls, while only the
+// last delta for a page within one call has any effect.
+//
+TEST(PageAllocatorTest, ConcurrentUpdateRefCounts)
+{
+  constexpr usize kNumThreads = 8;
+  constexpr usize kCallsPerThread = 50;
+  constexpr usize kNumCalls = kNumThreads * kCallsPerThread;
+  constexpr usize kNumPages = kNumCalls + 1;
+  constexpr usize kMaxAttachments = 64;
+  static const usize kLogSize = llfs::PageAllocator::calculate_log_size(kNumPages, kMaxAttachments);
+
+  const llfs::PageAllocatorRuntimeOptions options{
+      .scheduler = batt::Runtime::instance().default_scheduler(),
+      .name = "TestAllocator",
+  };
+
+  const llfs::PageIdFactory id_factory{llfs::PageCount{kNumPages}, /*device_id=*/0};
+
+  batt::StatusOr<std::unique_ptr<llfs::PageAllocator>> page_allocator_status =
+      llfs::PageAllocator::recover(options, id_factory,
+                                   *std::make_unique<llfs::MemoryLogDeviceFactory>(kLogSize));
+
+  ASSERT_TRUE(page_allocator_status.ok()) << BATT_INSPECT(page_allocator_status.status());
+
+  llfs::PageAllocator& page_allocator = **page_allocator_status;
+
+  const boost::uuids::uuid user_id = boost::uuids::random_generator{}();
+  ASSERT_TRUE(page_allocator.attach_user(user_id, /*user_slot=*/0).ok());
+
+  // Page 0 is the hot page; page `1 + i` is only updated by call `i`.  Start all pages at 2.
+  //
+  {
+    std::vector<PageRefCount> updates;
+    for (page_id_int page_index = 0; page_index < kNumPages; ++page_index) {
+      updates.emplace_back(PageRefCount{.page_id = PageId{page_index}, .ref_count = +2});
+    }
+    ASSERT_TRUE(
+        page_allocator.update_page_ref_counts(user_id, /*user_slot=*/1, llfs::as_seq(updates))
+            .ok());
+  }
+
+  std::atomic<usize> next_call{0};
+  std::vector<std::thread> threads;
+  for (usize thread_i = 0; thread_i < kNumThreads; ++thread_i) {
+    threads.emplace_back([&] {
+      for (usize j = 0; j < kCallsPerThread; ++j) {
+        const usize call_i = next_call.fetch_add(1);
+        const std::vector<PageRefCount> updates{
+            PageRefCount{.page_id = PageId{0}, .ref_count = +5},
+            PageRefCount{.page_id = PageId{1 + call_i}, .ref_count = +1},
+            PageRefCount{.page_id = PageId{0}, .ref_count = +1},
+        };
+        StatusOr<slot_offset_type> result = page_allocator.update_page_ref_counts(
+            user_id, /*user_slot=*/2 + call_i, llfs::as_seq(updates));
+        BATT_CHECK_OK(result);
+      }
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+
+  usize n_accepted = 0;
+  for (usize call_i = 0; call_i < kNumCalls; ++call_i) {
+    const i32 ref_count = page_allocator.get_ref_count(PageId{1 + call_i}).first;
+    ASSERT_THAT(ref_count, ::testing::AnyOf(2, 3)) << BATT_INSPECT(call_i);
+    n_accepted += (ref_count == 3) ? 1 : 0;
+  }
+
+  // The call with the greatest user slot can never be a duplicate.
+  //
+  EXPECT_EQ(page_allocator.get_ref_count(PageId{kNumCalls}).first, 3);
+  EXPECT_GT(n_accepted, 0u);
+  EXPECT_EQ(page_allocator.get_ref_count(PageId{0}).first, 2 + static_cast<i32>(n_accepted));
+
+  Optional<PageAllocatorAttachmentStatus> attachment =
+      page_allocator.get_client_attachment_status(user_id);
+  ASSERT_TRUE(attachment);
+  EXPECT_EQ(attachment->user_slot, 1 + kNumCalls);
+
+  page_allocator.halt();
+  page_allocator.join();
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Recovering from a snapshot file (plus the log after the snapshot) gives the same state as a full
+// log replay; a corrupt snapshot file is ignored.
+//
+TEST(PageAllocatorTest, RecoverFromSnapshotFile)
+{
+  constexpr usize kNumPages = 64;
+  constexpr usize kMaxAttachments = 64;
+  static const usize kLogSize = llfs::PageAllocator::calculate_log_size(kNumPages, kMaxAttachments);
+
+  const std::string snapshot_file_name = "/tmp/llfs_page_allocator_snapshot_test_file";
+  llfs::delete_file(snapshot_file_name).IgnoreError();
+
+  const llfs::PageIdFactory id_factory{llfs::PageCount{kNumPages}, /*device_id=*/0};
+
+  auto p_mem_log = std::make_unique<llfs::MemoryLogDevice>(kLogSize);
+  llfs::MemoryLogDevice* const mem_log = p_mem_log.get();
+
+  batt::StatusOr<std::unique_ptr<llfs::PageAllocator>> page_allocator_status =
+      llfs::PageAllocator::recover(
+          PageAllocatorRuntimeOptions{batt::Runtime::instance().default_scheduler(), "Test"},
+          id_factory, *std::make_unique<llfs::BasicLogDeviceFactory>([&p_mem_log] {
+            return std::move(p_mem_log);
+          }));
+
+  ASSERT_TRUE(page_allocator_status.ok()) << BATT_INSPECT(page_allocator_status.status());
+
+  llfs::PageAllocator& page_allocator = **page_allocator_status;
+
+  const boost::uuids::uuid user_id = boost::uuids::random_generator{}();
+  ASSERT_TRUE(page_allocator.attach_user(user_id, /*user_slot=*/0).ok());
+
+  std::array<i32, kNumPages> expected_ref_count;
+  expected_ref_count.fill(0);
+
+  slot_offset_type user_slot = 0;
+  slot_offset_type last_update = 0;
+
+  const auto update_pages = [&](usize first_page, usize last_page) {
+    std::vector<PageRefCount> updates;
+    for (usize page_i = first_page; page_i < last_page; ++page_i) {
+      const i32 delta = (expected_ref_count[page_i] == 0) ? +2 : +1;
+      updates.emplace_back(PageRefCount{.page_id = PageId{page_i}, .ref_count = delta});
+      expected_ref_count[page_i] += delta;
+    }
+    user_slot += 1;
+    StatusOr<slot_offset_type> updated =
+        page_allocator.update_page_ref_counts(user_id, user_slot, llfs::as_seq(updates));
+    ASSERT_TRUE(updated.ok()) << BATT_INSPECT(updated.status());
+    last_update = *updated;
+  };
+
+  for (usize i = 0; i < kNumPages; ++i) {
+    update_pages(i, kNumPages);
+  }
+
+  StatusOr<slot_offset_type> snapshot_slot = page_allocator.write_snapshot(snapshot_file_name);
+  ASSERT_TRUE(snapshot_slot.ok()) << BATT_INSPECT(snapshot_slot.status());
+  EXPECT_FALSE(llfs::slot_less_than(*snapshot_slot, last_update));
+
+  {
+    StatusOr<std::unique_ptr<llfs::PageAllocatorSnapshot>> snapshot =
+        llfs::PageAllocatorSnapshot::open(snapshot_file_name, id_factory);
+
+    ASSERT_TRUE(snapshot.ok()) << BATT_INSPECT(snapshot.status());
+    EXPECT_EQ((*snapshot)->slot_offset(), *snapshot_slot);
+    EXPECT_EQ((*snapshot)->entries().size(), kNumPages + /*attachments=*/1);
+  }
+
+  // Some more updates after the snapshot, which must be recovered from the log.
+  //
+  for (usize i = 0; i < kNumPages / 2; ++i) {
+    update_pages(0, i + 1);
+  }
+  ASSERT_TRUE(page_allocator.sync(last_update).ok());
+
+  const LogDeviceSnapshot log_snapshot =
+      LogDeviceSnapshot::from_device(*mem_log, LogReadMode::kDurable);
+
+  page_allocator.halt();
+  page_allocator.join();
+
+  const auto recover_and_verify = [&](const Optional<std::string>& snapshot_file_name) {
+    batt::StatusOr<std::unique_ptr<llfs::PageAllocator>> recovered = llfs::PageAllocator::recover(
+        PageAllocatorRuntimeOptions{
+            .scheduler = batt::Runtime::instance().default_scheduler(),
+            .name = "Test",
+            .snapshot_file_name = snapshot_file_name,
+        },
+        id_factory, *std::make_unique<llfs::BasicLogDeviceFactory>([&log_snapshot] {
+          auto mem_log2 = std::make_unique<llfs::MemoryLogDevice>(kLogSize);
+          mem_log2->restore_snapshot(log_snapshot, LogReadMode::kDurable);
+          return mem_log2;
+        }));
+
+    ASSERT_TRUE(recovered.ok()) << BATT_INSPECT(recovered.status());
+
+    for (usize page_i = 0; page_i < kNumPages; ++page_i) {
+      EXPECT_EQ((*recovered)->get_ref_count(PageId{page_i}).first, expected_ref_count[page_i])
+          << BATT_INSPECT(page_i) << BATT_INSPECT(snapshot_file_name);
+    }
+
+    Optional<PageAllocatorAttachmentStatus> attachment =
+        (*recovered)->get_client_attachment_status(user_id);
+    ASSERT_TRUE(attachment);
+    EXPECT_EQ(attachment->user_slot, user_slot);
+
+    (*recovered)->halt();
+    (*recovered)->join();
+  };
+
+  recover_and_verify(None);
+  recover_and_verify(snapshot_file_name);
+
+  // Corrupt the snapshot; recovery should fall back to a full replay.
+  //
+  {
+    StatusOr<int> fd =
+        llfs::open_file_read_write(snapshot_file_name, llfs::OpenForAppend{false});
+    ASSERT_TRUE(fd.ok()) << BATT_INSPECT(fd.status());
+
+    const char garbage[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    EXPECT_TRUE(llfs::write_fd(*fd, llfs::ConstBuffer{garbage, sizeof(garbage)},
+                               /*offset=*/sizeof(llfs::PackedPageAllocatorSnapshotHeader) + 8)
+                    .ok());
+    EXPECT_TRUE(llfs::close_fd(*fd).ok());
+
+    EXPECT_EQ(llfs::PageAllocatorSnapshot::open(snapshot_file_name, id_factory).status(),
+              llfs::make_status(llfs::StatusCode::kPageAllocatorSnapshotBadCrc));
+  }
+  recover_and_verify(snapshot_file_name);
+
+  llfs::delete_file(snapshot_file_name).IgnoreError();
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// An allocator recovered with fewer pages in service than its PageIdFactory addresses can be grown
+// online up to (but not beyond) the factory's capacity; pages allocated from the grown range are
+// recovered (growing the allocator again as needed) even if recovery starts from the old count.
+//
+TEST(PageAllocatorTest, Grow)
+{
+  constexpr usize kInitialPages = 32;
+  constexpr usize kGrownPages = 64;
+  constexpr usize kMaxPages = 128;
+  constexpr usize kMaxAttachments = 64;
+  static const usize kLogSize = llfs::PageAllocator::calculate_log_size(kMaxPages, kMaxAttachments);
+
+  const llfs::PageIdFactory id_factory{llfs::PageCount{kMaxPages}, /*device_id=*/0};
+
+  const PageAllocatorRuntimeOptions options{
+      .scheduler = batt::Runtime::instance().default_scheduler(),
+      .name = "Test",
+      .snapshot_file_name = None,
+      .page_count = PageCount{kInitialPages},
+  };
+
+  auto p_mem_log = std::make_unique<llfs::MemoryLogDevice>(kLogSize);
+  llfs::MemoryLogDevice* const mem_log = p_mem_log.get();
+
+  batt::StatusOr<std::unique_ptr<llfs::PageAllocator>> page_allocator_status =
+      llfs::PageAllocator::recover(options, id_factory,
+                                   *std::make_unique<llfs::BasicLogDeviceFactory>([&p_mem_log] {
+                                     return std::move(p_mem_log);
+                                   }));
+
+  ASSERT_TRUE(page_allocator_status.ok()) << BATT_INSPECT(page_allocator_status.status());
+
+  llfs::PageAllocator& page_allocator = **page_allocator_status;
+
+  EXPECT_EQ(page_allocator.page_count(), kInitialPages);
+  EXPECT_EQ(page_allocator.free_pool_size(), kInitialPages);
+
+  // Use up all the pages in service.
+  //
+  for (usize i = 0; i < kInitialPages; ++i) {
+    ASSERT_TRUE(page_allocator.allocate_page(batt::WaitForResource::kFalse).ok());
+  }
+  EXPECT_EQ(page_allocator.allocate_page(batt::WaitForResource::kFalse).status(),
+            batt::StatusCode::kResourceExhausted);
+
+  // Growing past the capacity of the id space fails; shrinking is ignored.
+  //
+  EXPECT_EQ(page_allocator.grow(PageCount{kMaxPages + 1}), batt::StatusCode::kOutOfRange);
+  EXPECT_TRUE(page_allocator.grow(PageCount{kInitialPages / 2}).ok());
+  EXPECT_EQ(page_allocator.page_count(), kInitialPages);
+
+  ASSERT_TRUE(page_allocator.grow(PageCount{kGrownPages}).ok());
+
+  EXPECT_EQ(page_allocator.page_count(), kGrownPages);
+  EXPECT_EQ(page_allocator.free_pool_size(), kGrownPages - kInitialPages);
+
+  // Allocate (and give a ref count to) a page from the grown range.
+  //
+  StatusOr<PageId> new_page = page_allocator.allocate_page(batt::WaitForResource::kFalse);
+  ASSERT_TRUE(new_page.ok()) << BATT_INSPECT(new_page.status());
+
+  const i64 new_physical_page = id_factory.get_physical_page(*new_page);
+  EXPECT_GE(new_physical_page, static_cast<i64>(kInitialPages));
+  EXPECT_LT(new_physical_page, static_cast<i64>(kGrownPages));
+
+  const boost::uuids::uuid user_id = boost::uuids::random_generator{}();
+  ASSERT_TRUE(page_allocator.attach_user(user_id, /*user_slot=*/0).ok());
+
+  std::vector<PageRefCount> updates{PageRefCount{.page_id = *new_page, .ref_count = +2}};
+  StatusOr<slot_offset_type> updated =
+      page_allocator.update_page_ref_counts(user_id, /*user_slot=*/1, llfs::as_seq(updates));
+  ASSERT_TRUE(updated.ok()) << BATT_INSPECT(updated.status());
+  ASSERT_TRUE(page_allocator.sync(*updated).ok());
+
+  EXPECT_EQ(page_allocator.get_ref_count(*new_page).first, 2);
+
+  const LogDeviceSnapshot log_snapshot =
+      LogDeviceSnapshot::from_device(*mem_log, LogReadMode::kDurable);
+
+  page_allocator.halt();
+  page_allocator.join();
+
+  // Recover with the original page count.
+  //
+  batt::StatusOr<std::unique_ptr<llfs::PageAllocator>> recovered = llfs::PageAllocator::recover(
+      options, id_factory, *std::make_unique<llfs::BasicLogDeviceFactory>([&log_snapshot] {
+        auto mem_log2 = std::make_unique<llfs::MemoryLogDevice>(kLogSize);
+        mem_log2->restore_snapshot(log_snapshot, LogReadMode::kDurable);
+        return mem_log2;
+      }));
+
+  ASSERT_TRUE(recovered.ok()) << BATT_INSPECT(recovered.status());
+
+  EXPECT_EQ((*recovered)->page_count(), static_cast<u64>(new_physical_page + 1));
+  EXPECT_EQ((*recovered)->get_ref_count(*new_page).first, 2);
+
+  ASSERT_TRUE((*recovered)->grow(PageCount{kGrownPages}).ok());
+  EXPECT_EQ((*recovered)->page_count(), kGrownPages);
+  EXPECT_EQ((*recovered)->free_pool_size(), kGrownPages - 1);
+
+  (*recovered)->halt();
+  (*recovered)->join();
+}
+
 }  // namespace
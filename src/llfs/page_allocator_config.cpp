@@ -17,6 +17,8 @@
 #include <batteries/case_of.hpp>
 #include <batteries/stream_util.hpp>
 
+#include <algorithm>
+
 namespace llfs {
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -27,6 +29,7 @@ namespace llfs {
       .uuid = None,
       .max_attachments = 64,
       .page_count = PageCount{0},
+      .max_page_count = None,
       .log_device = CreateNewLogDeviceWithDefaultSize{},
       .page_size_log2 = PageSizeLog2{0},
       .page_device = LinkToNewPageDevice{},
@@ -52,8 +55,17 @@ Status configure_storage_object(StorageFileBuilder::Transaction& txn,
   p_allocator_config->page_count = options.page_count;
   p_allocator_config->page_size_log2 = options.page_size_log2;
 
+  // The log must be able to hold the state of every page the allocator may be grown to.
+  //
+  const bool reserve_capacity =
+      options.max_page_count && *options.max_page_count > options.page_count;
+  const PageCount page_capacity = reserve_capacity ? *options.max_page_count : options.page_count;
+
+  p_allocator_config->max_page_count =
+      reserve_capacity ? BATT_CHECKED_CAST(u32, page_capacity.value()) : 0;
+
   const auto minimum_log_size =
-      PageAllocator::calculate_log_size(options.page_count, options.max_attachments);
+      PageAllocator::calculate_log_size(page_capacity, options.max_attachments);
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
   // Create or link to log device.
@@ -111,6 +123,10 @@ Status configure_storage_object(StorageFileBuilder::Transaction& txn,
               return {batt::StatusCode::kInvalidArgument};
             }
 
+            if (create_new.options.max_page_count != options.max_page_count) {
+              return {batt::StatusCode::kInvalidArgument};
+            }
+
             if (create_new.options.page_size_log2 != options.page_size_log2) {
               // TODO [tastolfi 2022-07-27] custom code
               return {batt::StatusCode::kInvalidArgument};
@@ -151,12 +167,21 @@ StatusOr<std::unique_ptr<PageAllocator>> recover_storage_object(
 
   BATT_REQUIRE_OK(log_factory);
 
+  const auto page_count =
+      PageCount{BATT_CHECKED_CAST(PageCount::value_type, p_allocator_config->page_count.value())};
+
+  // The page id layout is determined by the full (reserved) capacity of the device, so that it
+  // doesn't change when the allocator is grown; only the first `page_count` pages are in service.
+  //
   const auto page_ids = PageIdFactory{
-      PageCount{BATT_CHECKED_CAST(PageCount::value_type, p_allocator_config->page_count.value())},
+      std::max(page_count, PageCount{p_allocator_config->max_page_count.value()}),
       p_allocator_config->page_device_id,
   };
 
-  return PageAllocator::recover(allocator_options, page_ids, **log_factory);
+  PageAllocatorRuntimeOptions options = allocator_options;
+  options.page_count = page_count;
+
+  return PageAllocator::recover(options, page_ids, **log_factory);
 }
 
 }  // namespace llfs
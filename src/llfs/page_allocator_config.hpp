@@ -74,6 +74,12 @@ struct PageAllocatorConfigOptions {
   //
   PageCount page_count;
 
+  // If set (and greater than `page_count`), the number of pages the allocator may later be grown to
+  // (see PageAllocator::grow); the log is sized for this many pages.  Must match the
+  // `max_page_count` of the page device.
+  //
+  Optional<PageCount> max_page_count;
+
   // Options for the log device that stores the state of this page allocator.
   //
   NestedLogDeviceConfig log_device;
@@ -92,6 +98,7 @@ inline bool operator==(const PageAllocatorConfigOptions& l, const PageAllocatorC
   return l.uuid == r.uuid                           //
          && l.max_attachments == r.max_attachments  //
          && l.page_count == r.page_count            //
+         && l.max_page_count == r.max_page_count    //
          && l.log_device == r.log_device            //
          && l.page_size_log2 == r.page_size_log2    //
          && l.page_device == r.page_device;
@@ -169,9 +176,10 @@ struct PackedPageAllocatorConfig : PackedConfigSlotHeader {
   //
   little_u32 page_device_id;
 
-  // Reserved for future use.
+  // The number of pages the allocator may be grown to, or 0 if this is the same as `page_count`
+  // (see PageAllocatorConfigOptions::max_page_count).
   //
-  little_u8 pad2_[4];
+  little_u32 max_page_count;
 };
 
 BATT_STATIC_ASSERT_EQ(sizeof(PackedPageAllocatorConfig), PackedPageAllocatorConfig::kSize);
@@ -14,9 +14,22 @@
 
 namespace llfs {
 
+/** \brief Event counts for a PageAllocator; striped (see StripedCountMetric) since pages are
+ * allocated and freed from many threads at once.
+ */
 struct PageAllocatorMetrics {
-  CountMetric<u64> pages_allocated{0};
+  StripedCountMetric<u64> pages_allocated;
+  StripedCountMetric<u64> pages_freed;
+  StripedCountMetric<u64> extents_allocated;
+  StripedCountMetric<u64> extent_fallbacks;
+  StripedCountMetric<u64> txn_batches;
+  StripedCountMetric<u64> txns_coalesced;
+};
   CountMetric<u64> pages_freed{0};
+  CountMetric<u64> extents_allocated{0};
+  CountMetric<u64> extent_fallbacks{0};
+  CountMetric<u64> txn_batches{0};
+  CountMetric<u64> txns_coalesced{0};
 };
 
 }  // namespace llfs
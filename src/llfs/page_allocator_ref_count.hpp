@@ -64,6 +64,10 @@ class PageAllocatorRefCount
  public:
   static constexpr u32 kInvalidUserIndex = ~u32{0};
 
+  /** \brief Value of `get_free_pool_shard()` when this object is not in a free page cache shard.
+   */
+  static constexpr u32 kNoFreePoolShard = ~u32{0};
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   using Self = PageAllocatorRefCount;
@@ -140,10 +144,27 @@ class PageAllocatorRefCount
     return this->generation_.fetch_sub(1) - 1;
   }
 
+  /** \brief Returns the index of the free page cache shard whose list this object is linked into,
+   * or kNoFreePoolShard if it is in the central free pool (or not free).  Only modified while
+   * holding the lock of that shard.
+   */
+  u32 get_free_pool_shard() const noexcept
+  {
+    return this->free_pool_shard_.load();
+  }
+
+  /** \brief Sets the value returned by `get_free_pool_shard()`.
+   */
+  void set_free_pool_shard(u32 shard_index) noexcept
+  {
+    this->free_pool_shard_.store(shard_index);
+  }
+
  private:
   std::atomic<page_generation_int> generation_{0};
   std::atomic<i32> count_{0};
   std::atomic<u32> last_modified_by_user_index_{Self::kInvalidUserIndex};
+  std::atomic<u32> free_pool_shard_{Self::kNoFreePoolShard};
 };
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -10,13 +10,30 @@
 #ifndef LLFS_PAGE_ALLOCATOR_RUNTIME_OPTIONS_HPP
 #define LLFS_PAGE_ALLOCATOR_RUNTIME_OPTIONS_HPP
 
+#include <llfs/optional.hpp>
+#include <llfs/page_size.hpp>
+
 #include <batteries/async/task_scheduler.hpp>
 
+#include <string>
+#include <string_view>
+
 namespace llfs {
 
 struct PageAllocatorRuntimeOptions {
   batt::TaskScheduler& scheduler;
   std::string_view name;
+
+  // If set, the PageAllocator snapshot file (see PageAllocator::write_snapshot) to recover from;
+  // recovery falls back to a full log replay if the file doesn't exist.
+  //
+  Optional<std::string> snapshot_file_name = None;
+
+  // If set, the number of pages (starting from physical page 0) the allocator hands out on
+  // recovery; the rest of the pages addressable by its PageIdFactory are held in reserve until the
+  // allocator is grown (see PageAllocator::grow).  If None, all pages are in service.
+  //
+  Optional<PageCount> page_count = None;
 };
 
 }  // namespace llfs
@@ -0,0 +1,237 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_allocator_snapshot.hpp>
+//
+
+#include <llfs/crc.hpp>
+#include <llfs/filesystem.hpp>
+#include <llfs/logging.hpp>
+#include <llfs/status_code.hpp>
+
+#include <batteries/checked_cast.hpp>
+#include <batteries/finally.hpp>
+#include <batteries/syscall_retry.hpp>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ PackedPageAllocatorSnapshotEntry PackedPageAllocatorSnapshotEntry::from(
+    slot_offset_type last_update, const PackedPageRefCountRefresh& refresh)
+{
+  PackedPageAllocatorSnapshotEntry entry;
+  std::memset(&entry, 0, sizeof(entry));
+
+  entry.last_update = last_update;
+  entry.kind = Kind::kRefCount;
+  entry.user_index = refresh.user_index;
+  entry.page_id = refresh.page_id;
+  entry.ref_count = refresh.ref_count;
+
+  return entry;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ PackedPageAllocatorSnapshotEntry PackedPageAllocatorSnapshotEntry::from(
+    slot_offset_type last_update, const PackedPageAllocatorAttach& attach)
+{
+  PackedPageAllocatorSnapshotEntry entry;
+  std::memset(&entry, 0, sizeof(entry));
+
+  entry.last_update = last_update;
+  entry.kind = Kind::kAttachment;
+  entry.user_index = attach.user_index;
+  entry.user_slot = attach.user_slot;
+
+  return entry;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::variant<PackedPageRefCountRefresh, PackedPageAllocatorAttach>
+PackedPageAllocatorSnapshotEntry::to_event() const
+{
+  if (this->kind == Kind::kRefCount) {
+    return PackedPageRefCountRefresh{
+        .page_id = this->page_id,
+        .ref_count = this->ref_count,
+        .user_index = this->user_index,
+    };
+  }
+
+  return PackedPageAllocatorAttach{
+      .user_slot = this->user_slot,
+      .user_index = this->user_index,
+  };
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 PackedPageAllocatorSnapshotHeader::true_crc64() const
+{
+  auto crc64 = make_crc64();
+  crc64.process_bytes(this, sizeof(PackedPageAllocatorSnapshotHeader) - sizeof(little_u64));
+  return crc64.checksum();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ Status PageAllocatorSnapshot::write_file(
+    std::string_view file_name, const PageIdFactory& page_ids, slot_offset_type slot_offset,
+    const std::vector<PackedPageAllocatorSnapshotEntry>& entries)
+{
+  const usize entries_size = sizeof(PackedPageAllocatorSnapshotEntry) * entries.size();
+
+  PackedPageAllocatorSnapshotHeader header;
+  std::memset(&header, 0, sizeof(header));
+
+  header.magic = PackedPageAllocatorSnapshotHeader::kMagic;
+  header.version = PackedPageAllocatorSnapshotHeader::kVersion;
+  header.page_device_id = page_ids.get_device_id();
+  header.page_count = page_ids.get_physical_page_count().value();
+  header.slot_offset = slot_offset;
+  header.entry_count = entries.size();
+  {
+    auto crc64 = make_crc64();
+    crc64.process_bytes(entries.data(), entries_size);
+    header.entries_crc64 = crc64.checksum();
+  }
+  header.crc64 = header.true_crc64();
+
+  // Write the whole snapshot to a temporary file and sync it before renaming it over the old one,
+  // so that a valid snapshot file is never partially overwritten.
+  //
+  const std::string tmp_file_name = std::string{file_name} + ".tmp";
+
+  // A stale temporary file from an earlier failed attempt would make create_file_read_write fail.
+  //
+  delete_file(tmp_file_name).IgnoreError();
+
+  StatusOr<int> fd = create_file_read_write(tmp_file_name, OpenForAppend{false});
+  BATT_REQUIRE_OK(fd);
+  {
+    auto on_scope_exit = batt::finally([&] {
+      close_fd(*fd).IgnoreError();
+    });
+
+    BATT_REQUIRE_OK(write_fd(*fd, ConstBuffer{&header, sizeof(header)}, /*offset=*/0));
+    BATT_REQUIRE_OK(write_fd(*fd, ConstBuffer{entries.data(), entries_size},
+                             /*offset=*/sizeof(header)));
+
+    BATT_REQUIRE_OK(batt::status_from_retval(batt::syscall_retry([&] {
+      return ::fsync(*fd);
+    })));
+  }
+
+  const int retval = batt::syscall_retry([&] {
+    return std::rename(/*from=*/tmp_file_name.c_str(), /*to=*/std::string{file_name}.c_str());
+  });
+  BATT_REQUIRE_OK(batt::status_from_retval(retval));
+
+  LLFS_VLOG(1) << "wrote PageAllocator snapshot: " << BATT_INSPECT(file_name)
+               << BATT_INSPECT(slot_offset) << BATT_INSPECT(entries.size());
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<std::unique_ptr<PageAllocatorSnapshot>> PageAllocatorSnapshot::open(
+    std::string_view file_name, const PageIdFactory& page_ids)
+{
+  StatusOr<int> fd = open_file_read_only(file_name);
+  BATT_REQUIRE_OK(fd);
+
+  auto on_scope_exit = batt::finally([&] {
+    close_fd(*fd).IgnoreError();
+  });
+
+  StatusOr<i64> file_size = sizeof_fd(*fd);
+  BATT_REQUIRE_OK(file_size);
+
+  if (*file_size < (i64)sizeof(PackedPageAllocatorSnapshotHeader)) {
+    return ::llfs::make_status(StatusCode::kPageAllocatorSnapshotBadMagic);
+  }
+
+  // The mapping stays valid after the file is closed.
+  //
+  void* const mapped_data = ::mmap(nullptr, *file_size, PROT_READ, MAP_SHARED, *fd, /*offset=*/0);
+  if (mapped_data == MAP_FAILED) {
+    return batt::status_from_retval(-1);
+  }
+
+  std::unique_ptr<PageAllocatorSnapshot> snapshot{
+      new PageAllocatorSnapshot{mapped_data, BATT_CHECKED_CAST(usize, *file_size)}};
+
+  const PackedPageAllocatorSnapshotHeader& header = snapshot->header();
+
+  if (header.magic != PackedPageAllocatorSnapshotHeader::kMagic ||
+      sizeof(PackedPageAllocatorSnapshotHeader) +
+              header.entry_count * sizeof(PackedPageAllocatorSnapshotEntry) !=
+          snapshot->mapped_size_) {
+    return ::llfs::make_status(StatusCode::kPageAllocatorSnapshotBadMagic);
+  }
+
+  if (header.crc64 != header.true_crc64()) {
+    return ::llfs::make_status(StatusCode::kPageAllocatorSnapshotBadCrc);
+  }
+  {
+    batt::Slice<const PackedPageAllocatorSnapshotEntry> entries = snapshot->entries();
+
+    auto crc64 = make_crc64();
+    crc64.process_bytes(entries.begin(), entries.size() * sizeof(PackedPageAllocatorSnapshotEntry));
+    if (header.entries_crc64 != crc64.checksum()) {
+      return ::llfs::make_status(StatusCode::kPageAllocatorSnapshotBadCrc);
+    }
+  }
+
+  if (header.page_device_id != page_ids.get_device_id() ||
+      header.page_count != page_ids.get_physical_page_count().value()) {
+    return ::llfs::make_status(StatusCode::kPageAllocatorSnapshotMismatch);
+  }
+
+  return snapshot;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ PageAllocatorSnapshot::PageAllocatorSnapshot(const void* mapped_data,
+                                                         usize mapped_size) noexcept
+    : mapped_data_{mapped_data}
+    , mapped_size_{mapped_size}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageAllocatorSnapshot::~PageAllocatorSnapshot() noexcept
+{
+  LLFS_WARN_IF_NOT_OK(batt::status_from_retval(batt::syscall_retry([&] {
+    return ::munmap(const_cast<void*>(this->mapped_data_), this->mapped_size_);
+  })));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+batt::Slice<const PackedPageAllocatorSnapshotEntry> PageAllocatorSnapshot::entries() const noexcept
+{
+  const auto* first = reinterpret_cast<const PackedPageAllocatorSnapshotEntry*>(
+      static_cast<const char*>(this->mapped_data_) + sizeof(PackedPageAllocatorSnapshotHeader));
+
+  return batt::as_slice(first, this->header().entry_count);
+}
+
+}  // namespace llfs
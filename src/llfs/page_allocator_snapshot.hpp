@@ -0,0 +1,209 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_ALLOCATOR_SNAPSHOT_HPP
+#define LLFS_PAGE_ALLOCATOR_SNAPSHOT_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/packed_page_id.hpp>
+#include <llfs/packed_page_user_slot.hpp>
+#include <llfs/page_allocator_events.hpp>
+#include <llfs/page_id_factory.hpp>
+#include <llfs/slot.hpp>
+#include <llfs/status.hpp>
+#include <llfs/version.hpp>
+
+#include <batteries/slice.hpp>
+#include <batteries/static_assert.hpp>
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A single object (page ref count or attachment) captured in a PageAllocator snapshot file.
+ *
+ * Entries are stored in the order of the PageAllocatorState LRU list, so that recovering them in
+ * file order rebuilds the LRU exactly as it was.
+ */
+struct PackedPageAllocatorSnapshotEntry {
+  enum Kind : u32 {
+    kRefCount = 1,
+    kAttachment = 2,
+  };
+
+  /** \brief Packs the given checkpoint event, captured at `last_update`.
+   */
+  static PackedPageAllocatorSnapshotEntry from(slot_offset_type last_update,
+                                               const PackedPageRefCountRefresh& refresh);
+
+  static PackedPageAllocatorSnapshotEntry from(slot_offset_type last_update,
+                                               const PackedPageAllocatorAttach& attach);
+
+  /** \brief Returns the checkpoint event for this entry (the inverse of `from`).
+   */
+  std::variant<PackedPageRefCountRefresh, PackedPageAllocatorAttach> to_event() const;
+
+  // byte 0 +++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief The slot offset at which the object was last updated.
+   */
+  little_u64 last_update;
+
+  /** \brief One of the Kind values above.
+   */
+  little_u32 kind;
+
+  /** \brief The last modifier of the page (kRefCount), or the attachment number (kAttachment).
+   */
+  little_u32 user_index;
+
+  // byte 16 +++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief (kRefCount only) The page id, including its current generation.
+   */
+  PackedPageId page_id;
+
+  /** \brief (kRefCount only) The ref count of the page.
+   */
+  little_i32 ref_count;
+
+  /** \brief Reserved for future use.
+   */
+  little_u32 reserved_;
+
+  // byte 32 +++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief (kAttachment only) The attached user and its last known slot.
+   */
+  PackedPageUserSlot user_slot;
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedPageAllocatorSnapshotEntry), 56);
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief The header at the start of a PageAllocator snapshot file; it is followed immediately by
+ * `entry_count` instances of PackedPageAllocatorSnapshotEntry.
+ */
+struct PackedPageAllocatorSnapshotHeader {
+  static constexpr u64 kMagic = 0x8e3b4c1f6a05d927ull;
+
+  static constexpr u64 kVersion = make_version_u64(0, 1, 0);
+
+  // byte 0 +++++++++++-+-+--+----- --- -- -  -  -   -
+
+  // Must always be PackedPageAllocatorSnapshotHeader::kMagic.
+  //
+  big_u64 magic;
+
+  // The version of the snapshot format.
+  //
+  big_u64 version;
+
+  // The page device the snapshot was taken from.
+  //
+  little_u64 page_device_id;
+
+  // The number of physical pages in that device.
+  //
+  little_u64 page_count;
+
+  // The learned upper bound of the PageAllocator log when the snapshot was taken; recovering the
+  // snapshot replaces replaying the log up to this slot offset.
+  //
+  little_u64 slot_offset;
+
+  // The number of entries following this header.
+  //
+  little_u64 entry_count;
+
+  // The crc64 of all the entries.
+  //
+  little_u64 entries_crc64;
+
+  // The crc64 of this struct, excluding this field.
+  //
+  little_u64 crc64;
+
+  // Returns the true CRC64 of this structure.
+  //
+  u64 true_crc64() const;
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedPageAllocatorSnapshotHeader), 64);
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A read-only, memory-mapped PageAllocator snapshot file.
+ *
+ * A snapshot holds the state of every object on the PageAllocatorState LRU list (i.e., everything
+ * that a full replay of the log would recover) as of a given slot offset of the allocator's log.
+ * During recovery, the snapshot entries are applied first and only the log after that slot offset
+ * is replayed, so recovery time no longer depends on how much of the log has accumulated since the
+ * last trim.
+ *
+ * Snapshot files are written atomically (to a temporary file which is renamed over the old one), so
+ * a crash while writing a snapshot leaves the previous snapshot (if any) intact.
+ */
+class PageAllocatorSnapshot
+{
+ public:
+  /** \brief Writes a new snapshot file, replacing any existing file with the same name.
+   */
+  static Status write_file(std::string_view file_name, const PageIdFactory& page_ids,
+                           slot_offset_type slot_offset,
+                           const std::vector<PackedPageAllocatorSnapshotEntry>& entries);
+
+  /** \brief Maps the named snapshot file into memory and verifies its header and CRCs, and that it
+   * was taken from the page device described by `page_ids`.
+   */
+  static StatusOr<std::unique_ptr<PageAllocatorSnapshot>> open(std::string_view file_name,
+                                                               const PageIdFactory& page_ids);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  PageAllocatorSnapshot(const PageAllocatorSnapshot&) = delete;
+  PageAllocatorSnapshot& operator=(const PageAllocatorSnapshot&) = delete;
+
+  /** \brief Unmaps the file.
+   */
+  ~PageAllocatorSnapshot() noexcept;
+
+  /** \brief The log slot offset at which the snapshot was taken.
+   */
+  slot_offset_type slot_offset() const noexcept
+  {
+    return this->header().slot_offset;
+  }
+
+  /** \brief The snapshot entries, in LRU order.
+   */
+  batt::Slice<const PackedPageAllocatorSnapshotEntry> entries() const noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  explicit PageAllocatorSnapshot(const void* mapped_data, usize mapped_size) noexcept;
+
+  const PackedPageAllocatorSnapshotHeader& header() const noexcept
+  {
+    return *static_cast<const PackedPageAllocatorSnapshotHeader*>(this->mapped_data_);
+  }
+
+  const void* mapped_data_;
+  usize mapped_size_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_PAGE_ALLOCATOR_SNAPSHOT_HPP
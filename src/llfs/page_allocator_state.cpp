@@ -11,6 +11,9 @@
 
 #include <llfs/logging.hpp>
 
+#include <algorithm>
+#include <limits>
+
 namespace llfs {
 
 using Metrics = PageAllocatorMetrics;
@@ -19,13 +22,16 @@ using Metrics = PageAllocatorMetrics;
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 
-PageAllocatorState::PageAllocatorState(const PageIdFactory& page_ids, u64 max_attachments) noexcept
-    : PageAllocatorStateNoLock{page_ids}
+PageAllocatorState::PageAllocatorState(const PageIdFactory& page_ids, u64 max_attachments,
+                                       Optional<PageCount> page_count) noexcept
+    : PageAllocatorStateNoLock{page_ids, page_count}
     , attachment_by_index_(max_attachments)
+    , free_run_index_(
+          (this->max_page_device_capacity() + kFreeRunChunkSize - 1) / kFreeRunChunkSize, 0)
 {
   for (PageAllocatorRefCount& ref_count_obj : this->page_ref_counts()) {
     BATT_CHECK_EQ(ref_count_obj.get_count(), 0);
-    this->free_pool_.push_back(ref_count_obj);
+    this->push_central_free_page(ref_count_obj);
   }
   this->free_pool_size_.set_value(this->free_pool_.size());
 
@@ -45,64 +51,130 @@ PageAllocatorState::~PageAllocatorState() noexcept
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-StatusOr<slot_offset_type> PageAllocatorState::write_checkpoint_slice(
-    TypedSlotWriter<PackedPageAllocatorEvent>& slot_writer, batt::Grant& slice_grant)
+auto PageAllocatorState::snapshot_checkpoint_slice(usize max_byte_count) const -> CheckpointSlice
 {
-  const usize n_active = this->lru_.size();
-  usize n_refreshed = 0;
+  CheckpointSlice slice;
+  usize byte_count = 0;
 
-  while (!this->lru_.empty() && n_refreshed < n_active) {
-    PageAllocatorLRUBase* oldest_object = &this->lru_.front();
+  for (const PageAllocatorLRUBase& lru_obj : this->lru_) {
+    PageAllocatorLRUBase* const obj = const_cast<PageAllocatorLRUBase*>(&lru_obj);
 
-    batt::StatusOr<SlotRange> slot_range;
+    CheckpointSliceEntry entry{
+        .obj = obj,
+        .last_update = obj->last_update(),
+        .event = PackedPageRefCountRefresh{},
+        .op = None,
+    };
 
-    if (this->is_ref_count(oldest_object)) {
-      PageAllocatorRefCount* const ref_count_obj =
-          static_cast<PageAllocatorRefCount*>(oldest_object);
+    if (this->is_ref_count(obj)) {
+      const PageAllocatorRefCount* const ref_count_obj = static_cast<PageAllocatorRefCount*>(obj);
 
       const page_id_int physical_page = this->index_of(ref_count_obj);
       const page_generation_int generation = ref_count_obj->get_generation();
-      const u32 user_index = ref_count_obj->get_last_modified_by();
-
-      slot_range = slot_writer.append(
-          slice_grant,
-          PackedPageRefCountRefresh{
-              .page_id =
-                  {
-                      .id_val = this->page_ids_.make_page_id(physical_page, generation).int_value(),
-                  },
-              .ref_count = ref_count_obj->get_count(),
-              .user_index = user_index,
-          });
 
+      entry.event = PackedPageRefCountRefresh{
+          .page_id =
+              {
+                  .id_val = this->page_ids_.make_page_id(physical_page, generation).int_value(),
+              },
+          .ref_count = ref_count_obj->get_count(),
+          .user_index = ref_count_obj->get_last_modified_by(),
+      };
     } else {
-      PageAllocatorAttachment* const attachment =
-          static_cast<PageAllocatorAttachment*>(oldest_object);
-
-      slot_range =
-          slot_writer.append(slice_grant, PackedPageAllocatorAttach{
-                                              .user_slot =
-                                                  PackedPageUserSlot{
-                                                      .user_id = attachment->get_user_id(),
-                                                      .slot_offset = attachment->get_user_slot(),
-                                                  },
-                                              .user_index = attachment->get_user_index(),
-                                          });
+      const PageAllocatorAttachment* const attachment = static_cast<PageAllocatorAttachment*>(obj);
+
+      entry.event = PackedPageAllocatorAttach{
+          .user_slot =
+              PackedPageUserSlot{
+                  .user_id = attachment->get_user_id(),
+                  .slot_offset = attachment->get_user_slot(),
+              },
+          .user_index = attachment->get_user_index(),
+      };
+    }
+
+    byte_count += std::visit(
+        [](const auto& event) {
+          return packed_sizeof_slot(event);
+        },
+        entry.event);
+
+    if (byte_count > max_byte_count) {
+      break;
     }
+    slice.emplace_back(std::move(entry));
+  }
+
+  return slice;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ Status PageAllocatorState::pack_checkpoint_slice(
+    TypedSlotWriter<PackedPageAllocatorEvent>& slot_writer, batt::Grant& slice_grant,
+    CheckpointSlice& slice)
+{
+  for (usize i = 0; i < slice.size(); ++i) {
+    CheckpointSliceEntry& entry = slice[i];
 
-    if (!slot_range.ok() &&
-        slot_range.status() == ::llfs::make_status(StatusCode::kSlotGrantTooSmall)) {
+    StatusOr<SlotWriter::ConcurrentAppend> op = std::visit(
+        [&](const auto& event) {
+          return slot_writer.prepare_concurrent_append(slice_grant, event);
+        },
+        entry.event);
+
+    if (!op.ok() && op.status() == ::llfs::make_status(StatusCode::kSlotGrantTooSmall)) {
+      slice.erase(slice.begin() + i, slice.end());
       break;
     }
-    BATT_REQUIRE_OK(slot_range);
+    BATT_REQUIRE_OK(op);
+
+    entry.op.emplace(std::move(*op));
+  }
 
-    n_refreshed += 1;
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<slot_offset_type> PageAllocatorState::commit_checkpoint_slice(CheckpointSlice& slice,
+                                                                       batt::Grant& slice_grant)
+{
+  // Submit all the refreshes that are still valid before waiting for any of them, so they are
+  // written to the log together.
+  //
+  Status status;
+  usize n_submitted = 0;
+  for (CheckpointSliceEntry& entry : slice) {
+    BATT_CHECK(entry.op);
+    if (!status.ok() || !this->is_current(entry)) {
+      entry.op->cancel(slice_grant);
+      entry.op = None;
+      continue;
+    }
+    status.Update(entry.op->submit());
+    n_submitted += 1;
+  }
+
+  // Every submitted op must be waited for, even after an error, since the SlotWriter holds a
+  // pointer to each until it is published.
+  //
+  for (CheckpointSliceEntry& entry : slice) {
+    if (!entry.op) {
+      continue;
+    }
+    StatusOr<SlotRange> slot_range = entry.op->await_published();
+    if (!slot_range.ok()) {
+      status.Update(slot_range.status());
+      continue;
+    }
 
     // Do this after the refresh so we don't think an object has been updated when there is no
     // record of the update in the log.
     //
-    this->set_last_update(oldest_object, *slot_range);
+    this->set_last_update(entry.obj, *slot_range);
   }
+  BATT_REQUIRE_OK(status);
 
   const slot_offset_type new_trim_pos = [&] {
     if (this->lru_.empty()) {
@@ -111,11 +183,54 @@ StatusOr<slot_offset_type> PageAllocatorState::write_checkpoint_slice(
     return this->lru_.front().last_update();
   }();
 
-  LLFS_VLOG(1) << "wrote checkpoint slice (new_trim_pos=" << new_trim_pos << ")";
+  LLFS_VLOG(1) << "wrote checkpoint slice (new_trim_pos=" << new_trim_pos
+               << ", refreshed=" << n_submitted << "/" << slice.size() << ")";
 
   return new_trim_pos;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::vector<PackedPageAllocatorSnapshotEntry> PageAllocatorState::snapshot_entries() const
+{
+  const CheckpointSlice slice =
+      this->snapshot_checkpoint_slice(/*max_byte_count=*/std::numeric_limits<usize>::max());
+
+  std::vector<PackedPageAllocatorSnapshotEntry> entries;
+  entries.reserve(slice.size());
+
+  for (const CheckpointSliceEntry& entry : slice) {
+    entries.emplace_back(std::visit(
+        [&entry](const auto& event) {
+          return PackedPageAllocatorSnapshotEntry::from(entry.last_update, event);
+        },
+        entry.event));
+  }
+
+  return entries;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageAllocatorState::recover(const PageAllocatorSnapshot& snapshot)
+{
+  BATT_CHECK(this->lru_.empty()) << "Snapshots can only be recovered into a new state object!";
+
+  for (const PackedPageAllocatorSnapshotEntry& entry : snapshot.entries()) {
+    const SlotRange slot_offset{entry.last_update, entry.last_update};
+
+    BATT_REQUIRE_OK(std::visit(
+        [&](const auto& event) {
+          return this->recover(slot_offset, event);
+        },
+        entry.to_event()));
+  }
+
+  this->update_learned_upper_bound(snapshot.slot_offset());
+
+  return OkStatus();
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 boost::iterator_range<PageAllocatorRefCount*> PageAllocatorState::page_ref_counts()
@@ -139,69 +254,233 @@ Optional<PageId> PageAllocatorState::allocate_page()
   if (this->free_pool_.empty()) {
     return None;
   }
-  PageAllocatorRefCount& ref_count_obj = [&]() -> decltype(auto) {
-    if (kPageAllocPolicy == kFirstInFirstOut) {
-      PageAllocatorRefCount& ref_count_obj = this->free_pool_.front();
-      this->free_pool_.pop_front();
-      return ref_count_obj;
-    } else if (kPageAllocPolicy == kFirstInLastOut) {
-      PageAllocatorRefCount& ref_count_obj = this->free_pool_.back();
-      this->free_pool_.pop_back();
-      return ref_count_obj;
-    } else {
-      BATT_PANIC() << "undefined kPageAllocPolicy";
-      BATT_UNREACHABLE();
-    }
-  }();
+  PageAllocatorRefCount& ref_count_obj = this->pop_central_free_page();
   this->free_pool_size_.fetch_sub(1);
 
-  const isize physical_page = this->index_of(&ref_count_obj);
-  const page_generation_int generation = ref_count_obj.advance_generation();
-  const PageId page_id = this->page_ids_.make_page_id(physical_page, generation);
+  return this->make_allocated_page_id(ref_count_obj);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageAllocatorState::deallocate_page(PageId page_id)
+{
+  PageAllocatorRefCount& ref_count_obj = this->prepare_deallocated_page(page_id);
 
-  BATT_CHECK_EQ(ref_count_obj.get_count(), 0)
-      << BATT_INSPECT(physical_page) << BATT_INSPECT(generation) << BATT_INSPECT(page_id);
+  this->push_central_free_page(ref_count_obj);
+  this->free_pool_size_.fetch_add(1);
+
+  // If we were called because the current CPU's cache is full, spill half of it so that the next
+  // deallocations can be cached again.
+  //
+  if (!this->free_pool_shards_.empty()) {
+    FreePoolShard& shard = *this->free_pool_shards_[this->current_free_pool_shard_index()];
+
+    std::unique_lock<std::mutex> lock{shard.mutex};
+    while (shard.pages.size() > kFreePageCacheMaxSize / 2) {
+      PageAllocatorRefCount& spilled = shard.pages.front();
+      shard.pages.pop_front();
+      spilled.set_free_pool_shard(PageAllocatorRefCount::kNoFreePoolShard);
+      this->push_central_free_page(spilled);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize PageAllocatorState::refill_free_page_cache()
+{
+  if (this->free_pool_shards_.empty()) {
+    return 0;
+  }
+
+  const usize shard_count = this->free_pool_shards_.size();
+  const usize shard_index = this->current_free_pool_shard_index();
+
+  // Take a batch from the central pool first.
+  //
+  PageAllocatorFreePoolList batch;
+  while (batch.size() < kFreePageCacheRefillSize && !this->free_pool_.empty()) {
+    PageAllocatorStateNoLock::push_free_page_last(batch, this->pop_central_free_page());
+  }
+
+  // If the central pool is empty, rebalance by stealing half of the first non-empty shard.
+  //
+  for (usize i = 1; i < shard_count && batch.empty(); ++i) {
+    FreePoolShard& victim = *this->free_pool_shards_[(shard_index + i) % shard_count];
+
+    std::unique_lock<std::mutex> lock{victim.mutex};
+    const usize steal_count = (victim.pages.size() + 1) / 2;
+    for (usize n = 0; n < steal_count; ++n) {
+      PageAllocatorRefCount& stolen = PageAllocatorStateNoLock::pop_free_page(victim.pages);
+      stolen.set_free_pool_shard(PageAllocatorRefCount::kNoFreePoolShard);
+      PageAllocatorStateNoLock::push_free_page_last(batch, stolen);
+    }
+  }
 
-  BATT_CHECK_EQ(physical_page, this->page_ids_.get_physical_page(page_id))
-      << std::hex << BATT_INSPECT(page_id)
-      << BATT_INSPECT(this->page_ids_.get_physical_page(page_id)) << BATT_INSPECT(physical_page)
-      << BATT_INSPECT(generation) << BATT_INSPECT(this->page_device_capacity());
+  FreePoolShard& shard = *this->free_pool_shards_[shard_index];
 
-  BATT_CHECK_EQ(generation, this->page_ids_.get_generation(page_id));
+  std::unique_lock<std::mutex> lock{shard.mutex};
+  while (!batch.empty()) {
+    PageAllocatorRefCount& obj = PageAllocatorStateNoLock::pop_free_page(batch);
+    obj.set_free_pool_shard(shard_index);
+    PageAllocatorStateNoLock::push_free_page_last(shard.pages, obj);
+  }
 
-  return page_id;
+  return shard.pages.size();
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-void PageAllocatorState::deallocate_page(PageId page_id)
+Optional<std::vector<PageId>> PageAllocatorState::allocate_extent(PageCount count)
 {
-  const page_id_int physical_page = this->page_ids_.get_physical_page(page_id);
+  const u64 n = count.value();
+  const u64 capacity = this->page_device_capacity();
+
+  if (n == 0 || n > capacity || this->free_pool_.size() < n) {
+    return None;
+  }
 
-  BATT_CHECK_LT(physical_page, this->page_device_capacity());
+  // Returns the first physical page of a run of `n` central free pages within [begin, end).
+  //
+  const auto find_run = [&](u64 begin, u64 end) -> Optional<u64> {
+    u64 run_start = begin;
+    u64 run_length = 0;
+    u64 page = begin;
 
-  PageAllocatorRefCount& ref_count_obj = this->page_ref_counts_[physical_page];
+    while (page < end) {
+      const u64 chunk_begin = page / kFreeRunChunkSize * kFreeRunChunkSize;
+      const u64 chunk_end = std::min(chunk_begin + kFreeRunChunkSize, capacity);
+      const u64 chunk_free = this->free_run_index_[page / kFreeRunChunkSize];
 
-  BATT_CHECK_EQ(ref_count_obj.get_count(), 0);
-  BATT_CHECK_GT(ref_count_obj.get_generation(), 0);
-  BATT_CHECK(!ref_count_obj.PageAllocatorFreePoolHook::is_linked());
+      // Skip over chunks that are entirely allocated...
+      //
+      if (chunk_free == 0) {
+        run_length = 0;
+        page = chunk_end;
+        continue;
+      }
 
-  // It should be safe to revert the generation count increment we did when allocating this page
-  // because no one is allowed to reference a page once it is deallocated, so the invariant that
-  // PageId and durable page data are 1-to-1 is maintained.  This also allows us to make some
-  // helpful assumptions about what must be true when generation is >0, i.e., we can assume that the
-  // page header has been written at least once, so during recovery it is safe to try to read the
-  // pages in a half-committed Volume transaction instead of automatically invaliding the
-  // transaction, forcing the application layer to retry.
+      // ...and across chunks that are entirely free.
+      //
+      if (page == chunk_begin && chunk_free == chunk_end - chunk_begin && chunk_end <= end) {
+        if (run_length == 0) {
+          run_start = page;
+        }
+        run_length += chunk_end - chunk_begin;
+        if (run_length >= n) {
+          return run_start;
+        }
+        page = chunk_end;
+        continue;
+      }
+
+      if (this->is_central_free_page(page)) {
+        if (run_length == 0) {
+          run_start = page;
+        }
+        run_length += 1;
+        if (run_length == n) {
+          return run_start;
+        }
+      } else {
+        run_length = 0;
+      }
+      page += 1;
+    }
+
+    return None;
+  };
+
+  // Next-fit: search from the end of the last extent, then wrap around.
   //
-  // IMPORTANT: the implementation of `recover_page` and the initialization algorithms for certain
-  // PageDevice types depend on this line, and vice-versa!  Consider the "big-picture" implications
-  // before changing!!
+  const u64 cursor = std::min<u64>(this->extent_search_cursor_, capacity);
+
+  Optional<u64> run_start = find_run(cursor, capacity);
+  if (!run_start) {
+    run_start = find_run(0, std::min<u64>(cursor + n - 1, capacity));
+  }
+  if (!run_start) {
+    return None;
+  }
+  this->extent_search_cursor_ = *run_start + n;
+
+  std::vector<PageId> page_ids;
+  page_ids.reserve(n);
+
+  for (u64 physical_page = *run_start; physical_page < *run_start + n; ++physical_page) {
+    PageAllocatorRefCount& ref_count_obj = this->page_ref_counts_[physical_page];
+    this->erase_central_free_page(ref_count_obj);
+    page_ids.emplace_back(this->make_allocated_page_id(ref_count_obj));
+  }
+  this->free_pool_size_.fetch_sub(n);
+
+  return page_ids;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageAllocatorState::grow(PageCount new_page_count)
+{
+  const u64 old_count = this->page_device_capacity();
+  const u64 new_count = new_page_count.value();
+
+  if (new_count > this->max_page_device_capacity()) {
+    return {batt::StatusCode::kOutOfRange};
+  }
+  if (new_count <= old_count) {
+    return OkStatus();
+  }
+
+  // Publish the new count first, so that lock-free readers accept ids of the new pages by the time
+  // they can be allocated.
   //
-  ref_count_obj.revert_generation();
+  this->page_count_.store(new_count, std::memory_order_release);
 
-  this->free_pool_.push_back(ref_count_obj);
-  this->free_pool_size_.fetch_add(1);
+  for (u64 physical_page = old_count; physical_page < new_count; ++physical_page) {
+    PageAllocatorRefCount& ref_count_obj = this->page_ref_counts_[physical_page];
+    BATT_CHECK_EQ(ref_count_obj.get_count(), 0);
+    this->push_central_free_page(ref_count_obj);
+  }
+  this->free_pool_size_.fetch_add(new_count - old_count);
+
+  LLFS_VLOG(1) << "(device=" << this->page_ids_.get_device_id() << ") grew from " << old_count
+               << " to " << new_count << " pages";
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageAllocatorState::push_central_free_page(PageAllocatorRefCount& obj)
+{
+  this->free_pool_.push_back(obj);
+  this->free_run_index_[this->index_of(&obj) / kFreeRunChunkSize] += 1;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageAllocatorRefCount& PageAllocatorState::pop_central_free_page()
+{
+  PageAllocatorRefCount& obj = PageAllocatorStateNoLock::pop_free_page(this->free_pool_);
+  this->free_run_index_[this->index_of(&obj) / kFreeRunChunkSize] -= 1;
+  return obj;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageAllocatorState::erase_central_free_page(PageAllocatorRefCount& obj)
+{
+  this->free_pool_.erase(this->free_pool_.iterator_to(obj));
+  this->free_run_index_[this->index_of(&obj) / kFreeRunChunkSize] -= 1;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool PageAllocatorState::is_central_free_page(u64 physical_page) const
+{
+  const PageAllocatorRefCount& obj = this->page_ref_counts_[physical_page];
+  return obj.PageAllocatorFreePoolHook::is_linked() &&
+         obj.get_free_pool_shard() == PageAllocatorRefCount::kNoFreePoolShard;
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -415,6 +694,10 @@ Status PageAllocatorState::recover(const SlotRange& slot_offset,
   const page_id_int physical_page = this->page_ids_.get_physical_page(page_id);
   const page_id_int generation = this->page_ids_.get_generation(page_id);
 
+  // A page past the initial page count means the allocator was grown before it was recovered.
+  //
+  BATT_REQUIRE_OK(this->grow(PageCount{physical_page + 1}));
+
   PageAllocatorRefCount* obj = &this->page_ref_counts_[physical_page];
 
   BATT_CHECK_GE(packed.ref_count, 0)
@@ -467,6 +750,54 @@ PageAllocatorState::ProposalStatus PageAllocatorState::propose(PackedPageAllocat
   return status;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageAllocatorState::ProposalStatus PageAllocatorState::propose_coalesced(
+    PackedPageAllocatorTxn* txn)
+{
+  Optional<u32> user_index = this->get_attachment_num(txn->user_slot.user_id);
+  if (!user_index) {
+    return ProposalStatus::kInvalid_NotAttached;
+  }
+  BATT_CHECK_EQ(txn->user_index, PageAllocatorState::kInvalidUserIndex);
+  txn->user_index = *user_index;
+
+  const ProposalStatus status = this->propose_exactly_once(
+      const_cast<const PackedPageAllocatorTxn*>(txn)->user_slot, AllowAttach::kFalse);
+
+  if (status != ProposalStatus::kValid) {
+    return status;
+  }
+
+  // Maps physical page to the index of its merged entry in `txn->ref_counts`.
+  //
+  std::unordered_map<page_id_int, usize> merged_index;
+  merged_index.reserve(txn->ref_counts.size());
+
+  usize n_merged = 0;
+  for (usize i = 0; i < txn->ref_counts.size(); ++i) {
+    const PackedPageRefCount delta = txn->ref_counts[i];
+    const page_id_int physical_page = this->page_ids_.get_physical_page(delta.page_id.unpack());
+
+    auto [iter, inserted] = merged_index.emplace(physical_page, n_merged);
+    if (inserted) {
+      PackedPageRefCount& merged = txn->ref_counts[n_merged];
+      merged.page_id = delta.page_id;
+      merged.ref_count = this->calculate_new_ref_count(delta);
+      n_merged += 1;
+    } else {
+      PackedPageRefCount& merged = txn->ref_counts[iter->second];
+      const i32 new_count = this->calculate_new_ref_count(
+          delta, merged.ref_count, this->page_ids_.get_generation(merged.page_id.unpack()));
+      merged.page_id = delta.page_id;
+      merged.ref_count = new_count;
+    }
+  }
+  txn->ref_counts.item_count = n_merged;
+
+  return status;
+}
+
 //----- --- -- -  -  -   -
 
 void PageAllocatorState::learn(const SlotRange& slot_offset, const PackedPageAllocatorTxn& txn,
@@ -519,6 +850,11 @@ void PageAllocatorState::process_txn(
     const page_id_int physical_page = ids.get_physical_page(page_id);
     const page_id_int new_generation = ids.get_generation(page_id);
 
+    if (kInsideRecovery) {
+      // See the comment in `recover` (PackedPageRefCountRefresh).
+      //
+      BATT_CHECK_OK(this->grow(PageCount{physical_page + 1}));
+    }
     BATT_CHECK_LT(physical_page, this->page_device_capacity());
     PageAllocatorRefCount* const obj = &this->page_ref_counts_[physical_page];
 
@@ -536,9 +872,9 @@ void PageAllocatorState::process_txn(
       // Update metrics for alloc/free.
       //
       if (old_count == 0 && prc.ref_count >= 2 && old_generation < new_generation) {
-        metrics->pages_allocated.fetch_add(1);
+        metrics->pages_allocated.add(1);
       } else if (prc.ref_count == 0 && old_count > 0) {
-        metrics->pages_freed.fetch_add(1);
+        metrics->pages_freed.add(1);
       }
     }
 
@@ -645,18 +981,28 @@ i32 PageAllocatorState::calculate_new_ref_count(const PackedPageRefCount& delta)
   const page_id_int physical_page = this->page_ids_.get_physical_page(page_id);
   const PageAllocatorRefCount& obj = this->page_ref_counts_[physical_page];
 
+  return this->calculate_new_ref_count(delta, obj.get_count(), obj.get_generation());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+i32 PageAllocatorState::calculate_new_ref_count(const PackedPageRefCount& delta, i32 old_count,
+                                                page_generation_int old_generation) const
+{
+  const PageId page_id = delta.page_id.unpack();
+  const page_id_int physical_page = this->page_ids_.get_physical_page(page_id);
+  const PageAllocatorRefCount& obj = this->page_ref_counts_[physical_page];
+
   const page_generation_int new_generation = this->page_ids_.get_generation(page_id);
-  const page_generation_int old_generation = obj.get_generation();
 
   BATT_CHECK_GE(new_generation, old_generation) << "page generation went backwards!";
 
-  const i32 old_count = obj.get_count();
   i32 new_count = -1;  // set below...
 
   // Special case for 1 -> 0.
   //
   if (delta.ref_count == kRefCount_1_to_0) {
-    BATT_CHECK_EQ(obj.get_generation(), new_generation);
+    BATT_CHECK_EQ(old_generation, new_generation);
     new_count = 0;
   } else {
     new_count = old_count + delta.ref_count;
@@ -690,6 +1036,27 @@ bool PageAllocatorState::is_ref_count(const PageAllocatorLRUBase* obj) const
          obj < &this->page_ref_counts_[this->page_device_capacity()];
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool PageAllocatorState::is_current(const CheckpointSliceEntry& entry) const
+{
+  // Attachments may have been destroyed since the snapshot, so we must not dereference `entry.obj`
+  // until we know it is still in the attachment map.
+  //
+  if (!this->is_ref_count(entry.obj)) {
+    const auto& attach = std::get<PackedPageAllocatorAttach>(entry.event);
+    auto iter = this->attachments_.find(attach.user_slot.user_id);
+    if (iter == this->attachments_.end() || iter->second.get() != entry.obj) {
+      return false;
+    }
+  }
+
+  // A new object at the same address will have a newer `last_update`.
+  //
+  return entry.obj->PageAllocatorLRUHook::is_linked() &&
+         entry.obj->last_update() == entry.last_update;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 std::vector<PageAllocatorAttachmentStatus> PageAllocatorState::get_all_clients_attachment_status()
@@ -720,13 +1087,29 @@ void PageAllocatorState::update_free_pool_status(PageAllocatorRefCount* obj)
 {
   if (obj->get_count() == 0) {
     if (!obj->PageAllocatorFreePoolHook::is_linked()) {
-      this->free_pool_.push_back(*obj);
+      this->push_central_free_page(*obj);
       this->free_pool_size_.fetch_add(1);
     }
 
-  } else if (obj->PageAllocatorFreePoolHook::is_linked()) {
-    this->free_pool_.erase(this->free_pool_.iterator_to(*obj));
-    this->free_pool_size_.fetch_sub(1);
+  } else {
+    const u32 shard_index = obj->get_free_pool_shard();
+    if (shard_index != PageAllocatorRefCount::kNoFreePoolShard) {
+      // The page is in a free page cache shard; it may be allocated from there concurrently, so
+      // check again under the shard lock.
+      //
+      FreePoolShard& shard = *this->free_pool_shards_[shard_index];
+
+      std::unique_lock<std::mutex> lock{shard.mutex};
+      if (obj->get_free_pool_shard() == shard_index) {
+        shard.pages.erase(shard.pages.iterator_to(*obj));
+        obj->set_free_pool_shard(PageAllocatorRefCount::kNoFreePoolShard);
+        this->free_pool_size_.fetch_sub(1);
+      }
+
+    } else if (obj->PageAllocatorFreePoolHook::is_linked()) {
+      this->erase_central_free_page(*obj);
+      this->free_pool_size_.fetch_sub(1);
+    }
   }
 }
 
@@ -18,6 +18,7 @@
 #include <llfs/page_allocator_ref_count.hpp>
 #include <llfs/page_allocator_state_no_lock.hpp>
 
+#include <llfs/page_allocator_snapshot.hpp>
 #include <llfs/page_id_factory.hpp>
 #include <llfs/slot.hpp>
 #include <llfs/slot_writer.hpp>
@@ -28,6 +29,8 @@
 
 #include <unordered_map>
 #include <unordered_set>
+#include <variant>
+#include <vector>
 
 namespace llfs {
 
@@ -44,6 +47,33 @@ class PageAllocatorState : public PageAllocatorStateNoLock
   //
   using ThreadSafeBase = PageAllocatorStateNoLock;
 
+  // The number of physical pages summarized by each entry of the free-run index.
+  //
+  static constexpr u64 kFreeRunChunkSize = 64;
+
+  // An object captured for a checkpoint slice, along with the refresh event that will be written
+  // for it; see `snapshot_checkpoint_slice`.
+  //
+  struct CheckpointSliceEntry {
+    // The object to refresh.
+    //
+    PageAllocatorLRUBase* obj;
+
+    // The value of `obj->last_update()` when the snapshot was taken.
+    //
+    slot_offset_type last_update;
+
+    // The refresh event.
+    //
+    std::variant<PackedPageRefCountRefresh, PackedPageAllocatorAttach> event;
+
+    // The packed (but not yet committed) slot for `event`; set by `pack_checkpoint_slice`.
+    //
+    Optional<TypedSlotWriter<PackedPageAllocatorEvent>::ConcurrentAppend> op;
+  };
+
+  using CheckpointSlice = std::vector<CheckpointSliceEntry>;
+
   enum struct ProposalStatus : int {
     kNoChange = 0,
     kValid = 1,
@@ -74,7 +104,8 @@ class PageAllocatorState : public PageAllocatorStateNoLock
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
-  explicit PageAllocatorState(const PageIdFactory& ids, u64 max_attachments) noexcept;
+  explicit PageAllocatorState(const PageIdFactory& ids, u64 max_attachments,
+                              Optional<PageCount> page_count = None) noexcept;
 
   PageAllocatorState(const PageAllocatorState&) = delete;
   PageAllocatorState& operator=(const PageAllocatorState&) = delete;
@@ -83,18 +114,69 @@ class PageAllocatorState : public PageAllocatorStateNoLock
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
+  // Allocates a page from the central free pool.
+  //
   Optional<PageId> allocate_page();
 
+  // Returns a page to the central free pool; if the current CPU's free page cache is over half
+  // full, the excess is spilled back to the central pool too (see deallocate_cached_page).
+  //
   void deallocate_page(PageId page_id);
 
-  // Write index objects to the log in LRU order until we have written a minimum of
-  // `min_byte_count`.
+  // Moves a batch of pages from the central free pool into the free page cache of the current CPU.
+  // If the central pool is empty, steals half of the pages of another shard instead.  Returns the
+  // number of pages now in the current CPU's shard (0 if there are no free pages left at all, or
+  // caching is disabled).
+  //
+  usize refill_free_page_cache();
+
+  // Allocates `count` physically contiguous pages from the central free pool, returning their ids
+  // in physical page order; returns None if the central pool has no such run (the free page caches
+  // are not searched).
+  //
+  Optional<std::vector<PageId>> allocate_extent(PageCount count);
+
+  // Puts the reserved pages up to (but not including) physical page `new_page_count` into service,
+  // adding them to the central free pool.  Does nothing if `new_page_count` is not greater than the
+  // current page count; returns kOutOfRange if it exceeds the capacity of `page_ids()`.
+  //
+  Status grow(PageCount new_page_count);
+
+  // Writing a checkpoint slice is split into three steps, so that the state lock need not be held
+  // while the slice is being packed:
+  //
+  //  1. `snapshot_checkpoint_slice` (with the lock held) captures the least recently updated
+  //     objects, up to `max_byte_count` bytes of refresh events;
+  //  2. `pack_checkpoint_slice` (without the lock) packs an event for each of these into its own
+  //     SlotWriter::ConcurrentAppend, spending from `slice_grant`;
+  //  3. `commit_checkpoint_slice` (with the lock held again) drops all entries whose object has
+  //     been updated (or removed) since the snapshot, writes the rest to the log as a single batch,
+  //     and moves them to the back of the LRU.
+  //
+  // Step 3 must be done under the same lock as all other appends to the log, so that a refresh
+  // can never be written after a newer update of the same object.
+  //
+  CheckpointSlice snapshot_checkpoint_slice(usize max_byte_count) const;
+
+  static Status pack_checkpoint_slice(TypedSlotWriter<PackedPageAllocatorEvent>& slot_writer,
+                                      batt::Grant& slice_grant, CheckpointSlice& slice);
+
+  // Returns the slot offset of the new least recently updated object (this is the new safe trim
+  // offset).  Unused grant from dropped entries is returned to `slice_grant`.
   //
-  // Return the slot offset of the new least recently updated object (this is the new safe trim
-  // offset).
+  StatusOr<slot_offset_type> commit_checkpoint_slice(CheckpointSlice& slice,
+                                                     batt::Grant& slice_grant);
+
+  // Returns a snapshot entry for every object on the LRU list, in LRU order; the caller must also
+  // capture `learned_upper_bound()` under the same lock.  See PageAllocatorSnapshot.
   //
-  StatusOr<slot_offset_type> write_checkpoint_slice(
-      TypedSlotWriter<PackedPageAllocatorEvent>& slot_writer, batt::Grant& slice_grant);
+  std::vector<PackedPageAllocatorSnapshotEntry> snapshot_entries() const;
+
+  // Recovers the objects captured by `snapshot`; must be called on a new state object, before any
+  // log slots are recovered.  Afterwards, only the log slots after `snapshot.slot_offset()` need to
+  // be recovered.
+  //
+  Status recover(const PageAllocatorSnapshot& snapshot);
 
   //----- --- -- -  -  -   -
   // PackedPageAllocatorAttach event handlers.
@@ -147,6 +229,14 @@ class PageAllocatorState : public PageAllocatorStateNoLock
    */
   ProposalStatus propose(PackedPageAllocatorTxn* op);
 
+  /** \brief Like `propose(PackedPageAllocatorTxn*)`, except that `op->ref_counts` may contain
+   * several deltas for the same page; e.g., the concatenated deltas of several txns from the same
+   * user.  The deltas for each page are applied in order and merged into a single entry (at the
+   * position of the page's first delta) holding the final ref count, so `op->ref_counts` may
+   * shrink.
+   */
+  ProposalStatus propose_coalesced(PackedPageAllocatorTxn* op);
+
   void learn(const SlotRange& slot_offset, const PackedPageAllocatorTxn& op, PageAllocatorMetrics&);
 
   Status recover(const SlotRange& slot_offset, const PackedPageAllocatorTxn& op);
@@ -224,10 +314,26 @@ class PageAllocatorState : public PageAllocatorStateNoLock
   //
   void set_last_update(PageAllocatorLRUBase* obj, const SlotRange& slot_offset);
 
+  // Add/remove `obj` to/from the central free pool, keeping `free_run_index_` up to date.  These
+  // are the only functions that modify `free_pool_`.
+  //
+  void push_central_free_page(PageAllocatorRefCount& obj);
+  PageAllocatorRefCount& pop_central_free_page();
+  void erase_central_free_page(PageAllocatorRefCount& obj);
+
+  // Returns true iff the given physical page is in the central free pool.
+  //
+  bool is_central_free_page(u64 physical_page) const;
+
   // Returns true iff `obj` is an PageAllocatorRefCount belonging to _this_ PageAllocator.
   //
   bool is_ref_count(const PageAllocatorLRUBase* obj) const;
 
+  // Returns true iff the object captured by `entry` is still tracked by this state and hasn't been
+  // updated since the snapshot was taken.
+  //
+  bool is_current(const CheckpointSliceEntry& entry) const;
+
   // Returns a range of all the page ref counts in this index.
   //
   boost::iterator_range<PageAllocatorRefCount*> page_ref_counts();
@@ -244,6 +350,12 @@ class PageAllocatorState : public PageAllocatorStateNoLock
   //
   i32 calculate_new_ref_count(const PackedPageRefCount& delta) const;
 
+  // Returns the new ref count that will result from applying the delta to a page whose current
+  // count and generation are the passed values (rather than those of its ref count object).
+  //
+  i32 calculate_new_ref_count(const PackedPageRefCount& delta, i32 old_count,
+                              page_generation_int old_generation) const;
+
   /** \brief If the given ref count object has a positive ref count but *is* in the free pool, then
    * this function removes it; otherwise if the object has a zero ref count but is *not* in the free
    * pool, adds it.
@@ -271,6 +383,15 @@ class PageAllocatorState : public PageAllocatorStateNoLock
   // The current assignment of attachment number (i.e. user_index) to uuid (user_id).
   //
   std::vector<batt::Optional<boost::uuids::uuid>> attachment_by_index_;
+
+  // The free-run index used by `allocate_extent`: for each chunk of kFreeRunChunkSize physical
+  // pages, the number of those pages that are in the central free pool.
+  //
+  std::vector<u32> free_run_index_;
+
+  // The physical page at which the next extent search starts.
+  //
+  u64 extent_search_cursor_ = 0;
 };
 
 }  // namespace llfs
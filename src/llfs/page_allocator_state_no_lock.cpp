@@ -9,13 +9,39 @@
 #include <llfs/page_allocator_state_no_lock.hpp>
 //
 
+#include <batteries/env.hpp>
+
+#include <sched.h>
+
+#include <algorithm>
+#include <thread>
+
 namespace llfs {
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-PageAllocatorStateNoLock::PageAllocatorStateNoLock(const PageIdFactory& ids) noexcept
+/*static*/ usize PageAllocatorStateNoLock::default_free_pool_shard_count() noexcept
+{
+  static const usize count_ = [] {
+    const usize default_count = std::clamp<usize>(std::thread::hardware_concurrency(), 1, 16);
+    return batt::getenv_as<usize>("LLFS_PAGE_ALLOCATOR_FREE_POOL_SHARDS").value_or(default_count);
+  }();
+  return count_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageAllocatorStateNoLock::PageAllocatorStateNoLock(const PageIdFactory& ids,
+                                                   Optional<PageCount> page_count) noexcept
     : page_ids_{ids}
+    , page_count_{page_count.value_or(ids.get_physical_page_count())}
 {
+  BATT_CHECK_LE(this->page_count_.load(), this->max_page_device_capacity());
+
+  const usize shard_count = PageAllocatorStateNoLock::default_free_pool_shard_count();
+  for (usize i = 0; i < shard_count; ++i) {
+    this->free_pool_shards_.emplace_back(std::make_unique<FreePoolShard>());
+  }
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -54,6 +80,13 @@ Status PageAllocatorStateNoLock::await_free_page()
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 u64 PageAllocatorStateNoLock::page_device_capacity() const noexcept
+{
+  return this->page_count_.load(std::memory_order_acquire);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 PageAllocatorStateNoLock::max_page_device_capacity() const noexcept
 {
   return this->page_ids_.get_physical_page_count();
 }
@@ -108,6 +141,148 @@ void PageAllocatorStateNoLock::halt() noexcept
   this->free_pool_size_.close();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<PageId> PageAllocatorStateNoLock::allocate_cached_page() noexcept
+{
+  if (this->free_pool_shards_.empty()) {
+    return None;
+  }
+
+  const usize shard_index = this->current_free_pool_shard_index();
+  FreePoolShard& shard = *this->free_pool_shards_[shard_index];
+
+  PageAllocatorRefCount* ref_count_obj = nullptr;
+  {
+    std::unique_lock<std::mutex> lock{shard.mutex};
+    if (shard.pages.empty()) {
+      return None;
+    }
+    ref_count_obj = &PageAllocatorStateNoLock::pop_free_page(shard.pages);
+    ref_count_obj->set_free_pool_shard(PageAllocatorRefCount::kNoFreePoolShard);
+  }
+  this->free_pool_size_.fetch_sub(1);
+
+  return this->make_allocated_page_id(*ref_count_obj);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool PageAllocatorStateNoLock::deallocate_cached_page(PageId page_id) noexcept
+{
+  if (this->free_pool_shards_.empty()) {
+    return false;
+  }
+
+  const usize shard_index = this->current_free_pool_shard_index();
+  FreePoolShard& shard = *this->free_pool_shards_[shard_index];
+  {
+    std::unique_lock<std::mutex> lock{shard.mutex};
+    if (shard.pages.size() >= kFreePageCacheMaxSize) {
+      return false;
+    }
+    PageAllocatorRefCount& ref_count_obj = this->prepare_deallocated_page(page_id);
+    ref_count_obj.set_free_pool_shard(shard_index);
+    shard.pages.push_back(ref_count_obj);
+  }
+  this->free_pool_size_.fetch_add(1);
+
+  return true;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ PageAllocatorRefCount& PageAllocatorStateNoLock::pop_free_page(
+    PageAllocatorFreePoolList& pool)
+{
+  BATT_CHECK(!pool.empty());
+
+  if (kPageAllocPolicy == kFirstInFirstOut) {
+    PageAllocatorRefCount& ref_count_obj = pool.front();
+    pool.pop_front();
+    return ref_count_obj;
+  } else if (kPageAllocPolicy == kFirstInLastOut) {
+    PageAllocatorRefCount& ref_count_obj = pool.back();
+    pool.pop_back();
+    return ref_count_obj;
+  } else {
+    BATT_PANIC() << "undefined kPageAllocPolicy";
+    BATT_UNREACHABLE();
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ void PageAllocatorStateNoLock::push_free_page_last(PageAllocatorFreePoolList& pool,
+                                                              PageAllocatorRefCount& obj)
+{
+  if (kPageAllocPolicy == kFirstInFirstOut) {
+    pool.push_back(obj);
+  } else {
+    pool.push_front(obj);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize PageAllocatorStateNoLock::current_free_pool_shard_index() const noexcept
+{
+  const int cpu = sched_getcpu();
+  return (cpu < 0) ? 0 : (static_cast<usize>(cpu) % this->free_pool_shards_.size());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageId PageAllocatorStateNoLock::make_allocated_page_id(PageAllocatorRefCount& ref_count_obj) const
+{
+  const isize physical_page = this->index_of(&ref_count_obj);
+  const page_generation_int generation = ref_count_obj.advance_generation();
+  const PageId page_id = this->page_ids_.make_page_id(physical_page, generation);
+
+  BATT_CHECK_EQ(ref_count_obj.get_count(), 0)
+      << BATT_INSPECT(physical_page) << BATT_INSPECT(generation) << BATT_INSPECT(page_id);
+
+  BATT_CHECK_EQ(physical_page, this->page_ids_.get_physical_page(page_id))
+      << std::hex << BATT_INSPECT(page_id)
+      << BATT_INSPECT(this->page_ids_.get_physical_page(page_id)) << BATT_INSPECT(physical_page)
+      << BATT_INSPECT(generation) << BATT_INSPECT(this->page_device_capacity());
+
+  BATT_CHECK_EQ(generation, this->page_ids_.get_generation(page_id));
+
+  return page_id;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageAllocatorRefCount& PageAllocatorStateNoLock::prepare_deallocated_page(PageId page_id) const
+{
+  const page_id_int physical_page = this->page_ids_.get_physical_page(page_id);
+
+  BATT_CHECK_LT(physical_page, this->page_device_capacity());
+
+  PageAllocatorRefCount& ref_count_obj = this->page_ref_counts_[physical_page];
+
+  BATT_CHECK_EQ(ref_count_obj.get_count(), 0);
+  BATT_CHECK_GT(ref_count_obj.get_generation(), 0);
+  BATT_CHECK(!ref_count_obj.PageAllocatorFreePoolHook::is_linked());
+
+  // It should be safe to revert the generation count increment we did when allocating this page
+  // because no one is allowed to reference a page once it is deallocated, so the invariant that
+  // PageId and durable page data are 1-to-1 is maintained.  This also allows us to make some
+  // helpful assumptions about what must be true when generation is >0, i.e., we can assume that the
+  // page header has been written at least once, so during recovery it is safe to try to read the
+  // pages in a half-committed Volume transaction instead of automatically invaliding the
+  // transaction, forcing the application layer to retry.
+  //
+  // IMPORTANT: the implementation of `recover_page` and the initialization algorithms for certain
+  // PageDevice types depend on this line, and vice-versa!  Consider the "big-picture" implications
+  // before changing!!
+  //
+  ref_count_obj.revert_generation();
+
+  return ref_count_obj;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 isize PageAllocatorStateNoLock::index_of(const PageAllocatorRefCount* ref_count_obj) const
@@ -12,13 +12,18 @@
 
 #include <llfs/page_allocator_ref_count.hpp>
 
+#include <llfs/config.hpp>
 #include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
 #include <llfs/page_id_factory.hpp>
 #include <llfs/slot.hpp>
 #include <llfs/status.hpp>
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <utility>
+#include <vector>
 
 namespace llfs {
 
@@ -29,7 +34,29 @@ namespace llfs {
 class PageAllocatorStateNoLock
 {
  public:
-  explicit PageAllocatorStateNoLock(const PageIdFactory& ids) noexcept;
+  /** \brief The number of pages moved at once from the central free pool to a free page cache
+   * shard.
+   */
+  static constexpr usize kFreePageCacheRefillSize = 32;
+
+  /** \brief The maximum number of pages held by a single free page cache shard; once a shard is
+   * full, half of it is spilled back to the central free pool.
+   */
+  static constexpr usize kFreePageCacheMaxSize = 2 * kFreePageCacheRefillSize;
+
+  /** \brief Returns the number of free page cache shards to create for each PageAllocator.
+   * Defaults to the number of CPUs (at most 16); may be overridden by setting the environment
+   * variable LLFS_PAGE_ALLOCATOR_FREE_POOL_SHARDS (0 disables the caches).
+   */
+  static usize default_free_pool_shard_count() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Creates a state for the pages addressable by `ids`, of which the first `page_count`
+   * (default: all) are in service; the rest are held in reserve for PageAllocatorState::grow.
+   */
+  explicit PageAllocatorStateNoLock(const PageIdFactory& ids,
+                                    Optional<PageCount> page_count = None) noexcept;
 
   const PageIdFactory& page_ids() const;
 
@@ -42,15 +69,74 @@ class PageAllocatorStateNoLock
   template <typename HandlerFn = void(Status)>
   void async_wait_free_page(HandlerFn&& handler);
 
+  /** \brief The number of pages in service, i.e. that may be allocated.
+   */
   u64 page_device_capacity() const noexcept;
 
+  /** \brief The number of pages the allocator can be grown to without changing its page id layout
+   * (the capacity of `page_ids()`).
+   */
+  u64 max_page_device_capacity() const noexcept;
+
   u64 free_pool_size() noexcept;
 
   PageAllocatorRefCountStatus get_ref_count_status(PageId id) const noexcept;
 
   void halt() noexcept;
 
+  /** \brief Allocates a page from the free page cache shard of the current CPU, without locking
+   * the PageAllocatorState.  Returns None if the shard is empty.
+   */
+  Optional<PageId> allocate_cached_page() noexcept;
+
+  /** \brief Returns `page_id` to the free page cache shard of the current CPU, without locking the
+   * PageAllocatorState.  Returns false (and does nothing) if the shard is full, in which case the
+   * page must be deallocated via PageAllocatorState::deallocate_page.
+   */
+  bool deallocate_cached_page(PageId page_id) noexcept;
+
+  /** \brief The number of free page cache shards (0 if disabled).
+   */
+  usize free_pool_shard_count() const noexcept
+  {
+    return this->free_pool_shards_.size();
+  }
+
  protected:
+  /** \brief A per-CPU cache of free pages.  Pages in a shard are still counted in
+   * `free_pool_size_` and stay linked (via PageAllocatorFreePoolHook) while cached, so that the
+   * rest of the allocator sees them as free.
+   */
+  struct alignas(64) FreePoolShard {
+    std::mutex mutex;
+    PageAllocatorFreePoolList pages;
+  };
+
+  /** \brief Removes and returns the next page to allocate from `pool` (which must be non-empty),
+   * according to kPageAllocPolicy.
+   */
+  static PageAllocatorRefCount& pop_free_page(PageAllocatorFreePoolList& pool);
+
+  /** \brief Adds `obj` to `pool` so that it will be allocated after all pages currently in
+   * `pool`, according to kPageAllocPolicy.
+   */
+  static void push_free_page_last(PageAllocatorFreePoolList& pool, PageAllocatorRefCount& obj);
+
+  /** \brief Returns the free page cache shard index for the current CPU.  The shard count must be
+   * non-zero.
+   */
+  usize current_free_pool_shard_index() const noexcept;
+
+  /** \brief Advances the generation of `ref_count_obj` (which must have just been removed from a
+   * free pool) and returns the PageId of the newly allocated page.
+   */
+  PageId make_allocated_page_id(PageAllocatorRefCount& ref_count_obj) const;
+
+  /** \brief Verifies that `page_id` may be deallocated, reverts its generation, and returns its
+   * ref count object, which the caller must add to a free pool.
+   */
+  PageAllocatorRefCount& prepare_deallocated_page(PageId page_id) const;
+
   // Returns the index of `ref_count` in the `page_ref_counts_` array (which is also the physical
   // page number for that page's device).  Panic if `ref_count` is not in our ref counts array.
   //
@@ -68,10 +154,22 @@ class PageAllocatorStateNoLock
   //
   const PageIdFactory page_ids_;
 
-  // The array of page ref counts, indexed by the page id.
+  // The number of pages in service (a prefix of the pages addressable by the device); only
+  // increases, and only while holding the state lock.
+  //
+  std::atomic<u64> page_count_;
+
+  // The array of page ref counts, indexed by the page id; sized for every page addressable by the
+  // device, so that growing the allocator never moves it.
   //
   const std::unique_ptr<PageAllocatorRefCount[]> page_ref_counts_{
-      new PageAllocatorRefCount[this->page_device_capacity()]};
+      new PageAllocatorRefCount[this->max_page_device_capacity()]};
+
+  // The free page cache shards; a page may be moved into or out of a shard only while holding its
+  // mutex, and moved between a shard and the central free pool (see PageAllocatorState) only while
+  // also holding the state lock.  Lock order: state, then shard (never two shards at once).
+  //
+  std::vector<std::unique_ptr<FreePoolShard>> free_pool_shards_;
 };
 
 }  // namespace llfs
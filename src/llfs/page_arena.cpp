@@ -0,0 +1,86 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_arena.hpp>
+//
+
+#include <llfs/lazy_page_device.hpp>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ PageArena::PageArena(std::unique_ptr<LazyPageDevice> lazy_device) noexcept
+    : device_{nullptr}
+    , allocator_{nullptr}
+    , lazy_device_{lazy_device.get()}
+{
+  this->device_ = std::move(lazy_device);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool PageArena::is_recovered() const
+{
+  return this->lazy_device_ == nullptr || this->lazy_device_->is_recovered();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageArena::start_recovery()
+{
+  if (this->lazy_device_ != nullptr) {
+    this->lazy_device_->start_recovery();
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageArena::close()
+{
+  if (this->lazy_device_ != nullptr) {
+    this->lazy_device_->close();
+    return;
+  }
+  // this->device_->close();  TODO [tastolfi 2021-04-07]
+  this->allocator_->halt();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageArena::join()
+{
+  if (this->lazy_device_ != nullptr) {
+    this->lazy_device_->join();
+    return;
+  }
+  // this->device_->join();  TODO [tastolfi 2021-04-07]
+  this->allocator_->join();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageAllocator& PageArena::lazy_allocator() const
+{
+  return this->lazy_device_->await_recovered().allocator();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<PageAllocator*> PageArena::try_allocator() const
+{
+  if (this->lazy_device_ == nullptr) {
+    return this->allocator_.get();
+  }
+
+  BATT_ASSIGN_OK_RESULT(PageArena * recovered, this->lazy_device_->try_await_recovered());
+
+  return &recovered->allocator();
+}
+
+}  // namespace llfs
@@ -14,8 +14,13 @@
 #include <llfs/page_buffer.hpp>
 #include <llfs/page_device.hpp>
 
+#include <memory>
+#include <utility>
+
 namespace llfs {
 
+class LazyPageDevice;
+
 // A page storage device with a log-structured allocation index.
 //
 class PageArena
@@ -28,11 +33,28 @@ class PageArena
   {
   }
 
+  // Creates an arena whose device and allocator are recovered the first time they are used; see
+  // LazyPageDevice.
+  //
+  explicit PageArena(std::unique_ptr<LazyPageDevice> lazy_device) noexcept;
+
   PageArena(const PageArena&) = delete;
   PageArena& operator=(const PageArena&) = delete;
 
-  PageArena(PageArena&&) = default;
-  PageArena& operator=(PageArena&&) = default;
+  PageArena(PageArena&& that) noexcept
+      : device_{std::move(that.device_)}
+      , allocator_{std::move(that.allocator_)}
+      , lazy_device_{std::exchange(that.lazy_device_, nullptr)}
+  {
+  }
+
+  PageArena& operator=(PageArena&& that) noexcept
+  {
+    this->device_ = std::move(that.device_);
+    this->allocator_ = std::move(that.allocator_);
+    this->lazy_device_ = std::exchange(that.lazy_device_, nullptr);
+    return *this;
+  }
 
   page_device_id_int id() const
   {
@@ -44,26 +66,44 @@ class PageArena
     return *this->device_;
   }
 
+  // If the arena is lazy and hasn't been recovered yet, this blocks until it is (and panics if
+  // recovery fails).
+  //
   PageAllocator& allocator() const
   {
+    if (this->lazy_device_ != nullptr) {
+      return this->lazy_allocator();
+    }
     return *this->allocator_;
   }
 
-  void close()
-  {
-    // this->device_->close();  TODO [tastolfi 2021-04-07]
-    this->allocator_->halt();
-  }
+  // Like allocator(), but returns the recovery error of a lazy arena instead of panicking.  This
+  // still blocks until a lazy arena is recovered.
+  //
+  StatusOr<PageAllocator*> try_allocator() const;
 
-  void join()
-  {
-    // this->device_->join();  TODO [tastolfi 2021-04-07]
-    this->allocator_->join();
-  }
+  // Returns false iff this is a lazy arena whose recovery hasn't finished.
+  //
+  bool is_recovered() const;
+
+  // If this is a lazy arena, starts recovering it in the background (if it hasn't been already);
+  // otherwise does nothing.
+  //
+  void start_recovery();
+
+  void close();
+
+  void join();
 
  private:
+  PageAllocator& lazy_allocator() const;
+
   std::unique_ptr<PageDevice> device_;
   std::unique_ptr<PageAllocator> allocator_;
+
+  // Set iff the arena was created lazily; points to the same object as `device_`.
+  //
+  LazyPageDevice* lazy_device_ = nullptr;
 };
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
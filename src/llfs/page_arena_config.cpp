@@ -18,6 +18,8 @@
 #include <batteries/case_of.hpp>
 #include <batteries/checked_cast.hpp>
 
+#include <algorithm>
+
 namespace llfs {
 
 BATT_PRINT_OBJECT_IMPL(PackedPageArenaConfig,
@@ -38,6 +40,7 @@ Status configure_storage_object(StorageFileBuilder::Transaction& txn,
 
   Optional<page_device_id_int> page_device_id;
   Optional<i64> page_count;
+  Optional<i64> page_capacity;
   Optional<u16> page_size_log2;
   bool link_new_page_device = false;
 
@@ -100,6 +103,7 @@ Status configure_storage_object(StorageFileBuilder::Transaction& txn,
 
             page_device_id = p_page_device_config->device_id;
             page_count = p_page_device_config->page_count;
+            page_capacity = p_page_device_config->page_capacity();
             page_size_log2 = p_page_device_config->page_size_log2;
 
             return p_page_device_config->uuid;
@@ -155,6 +159,17 @@ Status configure_storage_object(StorageFileBuilder::Transaction& txn,
               return {batt::StatusCode::kInvalidArgument};
             }
 
+            const i64 allocator_page_capacity = std::max<i64>(
+                p_allocator_config->page_count, p_allocator_config->max_page_count);
+
+            if (page_capacity && allocator_page_capacity != *page_capacity) {
+              LLFS_LOG_ERROR() << "Cross-validation failed: max_page_count values not equal;"
+                               << BATT_INSPECT(allocator_page_capacity)
+                               << BATT_INSPECT(*page_capacity);
+
+              return {batt::StatusCode::kInvalidArgument};
+            }
+
             return p_allocator_config->uuid;
           },
 
@@ -174,7 +189,8 @@ StatusOr<PageArena> recover_storage_object(
     const FileOffsetPtr<const PackedPageArenaConfig&>& p_config,  //
     const PageAllocatorRuntimeOptions& allocator_options,         //
     const IoRingLogDriverOptions& allocator_log_options,          //
-    const IoRingFileRuntimeOptions& page_device_file_options)
+    const IoRingFileRuntimeOptions& page_device_file_options,     //
+    const IoRingPageFileDeviceOptions& page_device_options)
 {
   StatusOr<std::unique_ptr<PageAllocator>> page_allocator = storage_context->recover_object(
       batt::StaticType<PackedPageAllocatorConfig>{}, p_config->page_allocator_uuid,
@@ -183,7 +199,8 @@ StatusOr<PageArena> recover_storage_object(
 
   StatusOr<std::unique_ptr<PageDevice>> page_device =
       storage_context->recover_object(batt::StaticType<PackedPageDeviceConfig>{},
-                                      p_config->page_device_uuid, page_device_file_options);
+                                      p_config->page_device_uuid, page_device_file_options,
+                                      page_device_options);
   BATT_REQUIRE_OK(page_device);
 
   auto arena = PageArena{
@@ -37,7 +37,8 @@ StatusOr<PageArena> recover_storage_object(                       //
     const FileOffsetPtr<const PackedPageArenaConfig&>& p_config,  //
     const PageAllocatorRuntimeOptions& allocator_options,         //
     const IoRingLogDriverOptions& allocator_log_options,          //
-    const IoRingFileRuntimeOptions& page_device_file_options);
+    const IoRingFileRuntimeOptions& page_device_file_options,     //
+    const IoRingPageFileDeviceOptions& page_device_options);
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 //
@@ -101,6 +101,16 @@ void PageBuffer::set_page_id(PageId id)
     Block* blocks = new Block[n_blocks];
     obj = reinterpret_cast<PageBuffer*>(blocks);
   }();
+
+  PageBuffer::initialize(obj, page_size, page_id);
+
+  return std::shared_ptr<PageBuffer>{obj};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ void PageBuffer::initialize(PageBuffer* obj, PageSize page_size, PageId page_id)
+{
   {
     PackedPageHeader* header = mutable_page_header(obj);
     header->size = page_size;
@@ -111,8 +121,6 @@ void PageBuffer::set_page_id(PageId id)
   }
 
   obj->set_page_id(page_id);
-
-  return std::shared_ptr<PageBuffer>{obj};
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
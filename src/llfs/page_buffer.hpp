@@ -88,6 +88,12 @@ class PageBuffer
   MutableBuffer mutable_payload();
 
  private:
+  friend class PageBufferSlab;
+
+  // Initializes the page header of a newly allocated PageBuffer.
+  //
+  static void initialize(PageBuffer* obj, PageSize size, PageId page_id);
+
   Block blocks_[1];
 };
 
@@ -0,0 +1,249 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_buffer_slab.hpp>
+//
+
+#include <llfs/logging.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/checked_cast.hpp>
+#include <batteries/math.hpp>
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+
+namespace llfs {
+
+namespace {
+
+// Huge page backed slabs are rounded up to a multiple of the (x86-64/arm64 default) 2MiB huge page
+// size, so the last huge page is not shared with other allocations.
+//
+constexpr i32 kHugePageSizeLog2 = 21;
+
+// Maps an anonymous region of (at least) `size` bytes for a slab; on success, `size` is updated to
+// the size actually mapped, and `huge_page_backed` is set to whether the kernel accepted the
+// request for huge pages.
+//
+StatusOr<void*> map_slab_memory(usize& size, UseHugePages use_huge_pages, bool& huge_page_backed)
+{
+  huge_page_backed = false;
+
+  if (use_huge_pages) {
+    size = batt::round_up_bits(kHugePageSizeLog2, size);
+  }
+
+  // Huge page backed slabs must start on a huge page boundary; over-allocate by one huge page and
+  // unmap the unaligned head and the tail.
+  //
+  const usize alignment = use_huge_pages ? (usize{1} << kHugePageSizeLog2) : 0;
+
+  void* const mapped = ::mmap(nullptr, size + alignment, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, /*fd=*/-1, 0);
+  if (mapped == MAP_FAILED) {
+    return batt::status_from_errno(errno);
+  }
+
+  u8* memory = static_cast<u8*>(mapped);
+
+  if (use_huge_pages) {
+    u8* const aligned = reinterpret_cast<u8*>(
+        batt::round_up_bits(kHugePageSizeLog2, reinterpret_cast<uintptr_t>(memory)));
+
+    const usize head = aligned - memory;
+    if (head != 0) {
+      ::munmap(memory, head);
+    }
+    if (alignment - head != 0) {
+      ::munmap(aligned + size, alignment - head);
+    }
+    memory = aligned;
+  }
+
+  if (use_huge_pages) {
+#ifdef MADV_HUGEPAGE
+    if (::madvise(memory, size, MADV_HUGEPAGE) == 0) {
+      huge_page_backed = true;
+    } else {
+      LLFS_LOG_WARNING() << "madvise(MADV_HUGEPAGE) failed; the slab will use normal pages"
+                         << BATT_INSPECT(errno);
+    }
+#endif
+  }
+
+  return memory;
+}
+
+// Returns an error if a slab of `buffer_count` buffers of `page_size` can't be created.
+//
+Status validate_slab_size(PageSize page_size, usize buffer_count)
+{
+  if (buffer_count == 0 || page_size < sizeof(PageBuffer) ||
+      page_size > PageBufferSlab::kMaxChunkSize || page_size % sizeof(PageBuffer::Block) != 0) {
+    return {batt::StatusCode::kInvalidArgument};
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
+#ifndef LLFS_DISABLE_IO_URING
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<std::shared_ptr<PageBufferSlab>> PageBufferSlab::make_new(
+    const IoRing& io_ring, PageSize page_size, usize buffer_count) noexcept
+{
+  StatusOr<std::shared_ptr<PageBufferSlab>> slab =
+      PageBufferSlab::make_new(page_size, buffer_count);
+  BATT_REQUIRE_OK(slab);
+
+  const usize chunk_size = (*slab)->buffers_per_chunk_ * page_size;
+  const usize chunk_count =
+      (buffer_count + (*slab)->buffers_per_chunk_ - 1) / (*slab)->buffers_per_chunk_;
+
+  std::vector<MutableBuffer> chunks;
+  for (usize i = 0; i < chunk_count; ++i) {
+    const usize offset = i * chunk_size;
+    const usize size = std::min(chunk_size, buffer_count * page_size - offset);
+    chunks.emplace_back(static_cast<u8*>((*slab)->memory_) + offset, size);
+  }
+
+  StatusOr<usize> first_buf_index =
+      io_ring.register_buffers(as_seq(chunks) | seq::decayed() | seq::boxed(), /*update=*/true);
+
+  BATT_REQUIRE_OK(first_buf_index);
+
+  (*slab)->first_buf_index_ = BATT_CHECKED_CAST(i32, *first_buf_index);
+
+  return slab;
+}
+
+#endif  // LLFS_DISABLE_IO_URING
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<std::shared_ptr<PageBufferSlab>> PageBufferSlab::make_new(
+    PageSize page_size, usize buffer_count, UseHugePages use_huge_pages) noexcept
+{
+  BATT_REQUIRE_OK(validate_slab_size(page_size, buffer_count));
+
+  usize memory_size = buffer_count * page_size;
+
+  bool huge_page_backed = false;
+
+  StatusOr<void*> memory = map_slab_memory(memory_size, use_huge_pages, huge_page_backed);
+  BATT_REQUIRE_OK(memory);
+
+  return std::shared_ptr<PageBufferSlab>{
+      new PageBufferSlab{page_size, buffer_count, *memory, memory_size, huge_page_backed}};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ PageBufferSlab::PageBufferSlab(PageSize page_size, usize buffer_count, void* memory,
+                                            usize memory_size, bool huge_page_backed) noexcept
+    : page_size_{page_size}
+    , buffer_count_{buffer_count}
+    , buffers_per_chunk_{std::max<usize>(1, kMaxChunkSize / page_size)}
+    , memory_{memory}
+    , memory_size_{memory_size}
+    , huge_page_backed_{huge_page_backed}
+{
+  BATT_CHECK_EQ(page_size % sizeof(PageBuffer::Block), 0u);
+  BATT_CHECK_GE(memory_size, buffer_count * page_size);
+
+  this->free_list_.reserve(buffer_count);
+  for (usize i = buffer_count; i > 0; --i) {
+    this->free_list_.emplace_back(
+        reinterpret_cast<PageBuffer*>(static_cast<u8*>(this->memory_) + (i - 1) * page_size));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageBufferSlab::~PageBufferSlab() noexcept
+{
+  // Every buffer allocated from this slab holds a reference to it, so they must all have been
+  // returned by now.
+  //
+  BATT_CHECK_EQ(this->free_list_.size(), this->buffer_count_);
+
+  ::munmap(this->memory_, this->memory_size_);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool PageBufferSlab::contains(const PageBuffer* page_buffer) const noexcept
+{
+  const u8* const begin = static_cast<const u8*>(this->memory_);
+  const u8* const end = begin + this->buffer_count_ * this->page_size_;
+  const u8* const ptr = reinterpret_cast<const u8*>(page_buffer);
+
+  return ptr >= begin && ptr < end;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize PageBufferSlab::free_count() const noexcept
+{
+  std::unique_lock<std::mutex> lock{this->mutex_};
+  return this->free_list_.size();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::shared_ptr<PageBuffer> PageBufferSlab::allocate(PageId page_id) noexcept
+{
+  PageBuffer* obj = nullptr;
+  {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+    if (this->free_list_.empty()) {
+      return nullptr;
+    }
+    obj = this->free_list_.back();
+    this->free_list_.pop_back();
+  }
+
+  PageBuffer::initialize(obj, this->page_size_, page_id);
+
+  return std::shared_ptr<PageBuffer>{obj, [slab = this->shared_from_this()](PageBuffer* p) {
+                                       slab->release(p);
+                                     }};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<i32> PageBufferSlab::buf_index_of(const PageBuffer* page_buffer) const noexcept
+{
+  if (this->first_buf_index_ < 0 || !this->contains(page_buffer)) {
+    return None;
+  }
+
+  const usize buffer_i = (reinterpret_cast<const u8*>(page_buffer) -
+                          static_cast<const u8*>(this->memory_)) /
+                         this->page_size_;
+
+  return this->first_buf_index_ + BATT_CHECKED_CAST(i32, buffer_i / this->buffers_per_chunk_);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageBufferSlab::release(PageBuffer* page_buffer) noexcept
+{
+  BATT_CHECK(this->contains(page_buffer));
+
+  std::unique_lock<std::mutex> lock{this->mutex_};
+  this->free_list_.emplace_back(page_buffer);
+}
+
+}  // namespace llfs
@@ -0,0 +1,162 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_BUFFER_SLAB_HPP
+#define LLFS_PAGE_BUFFER_SLAB_HPP
+
+#include <llfs/config.hpp>
+//
+
+#include <llfs/constants.hpp>
+#include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/page_buffer.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/page_size.hpp>
+#include <llfs/status.hpp>
+
+#ifndef LLFS_DISABLE_IO_URING
+#include <llfs/ioring.hpp>
+#endif  // LLFS_DISABLE_IO_URING
+
+#include <batteries/strong_typedef.hpp>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace llfs {
+
+BATT_STRONG_TYPEDEF(bool, UseHugePages);
+
+/** \brief A fixed-size set of same-sized PageBuffers carved out of one contiguous (anonymous,
+ * mmap'ed) region of memory.  The memory may be registered with an IoRing, so that page I/O on
+ * these buffers can use IORING_OP_READ_FIXED/WRITE_FIXED (which saves the kernel from pinning the
+ * user pages on every I/O), and/or backed by transparent huge pages, so that a large slab of
+ * long-lived buffers (e.g., the pages of a MemoryPageDevice) costs fewer TLB entries.
+ *
+ * The slab memory is registered as one or more io_uring buffers (each at most kMaxChunkSize
+ * bytes).  PageBuffers allocated from the slab hold a reference to it, and are returned to the
+ * slab when the last reference to them goes away; the slab memory is freed once the slab itself and
+ * all the buffers allocated from it have been released.
+ *
+ * NOTE: the registration is not removed from the IoRing when the slab is freed (IoRing only
+ * supports unregistering all buffers at once).
+ */
+class PageBufferSlab : public std::enable_shared_from_this<PageBufferSlab>
+{
+ public:
+  /** \brief The maximum size of a single registered buffer; the kernel limit is 1GiB.
+   */
+  static constexpr usize kMaxChunkSize = 64 * kMiB;
+
+  /** \brief Allocates memory for `buffer_count` pages of size `page_size` and registers it with
+   * `io_ring`.
+   */
+#ifndef LLFS_DISABLE_IO_URING
+  static StatusOr<std::shared_ptr<PageBufferSlab>> make_new(const IoRing& io_ring,
+                                                            PageSize page_size,
+                                                            usize buffer_count) noexcept;
+#endif  // LLFS_DISABLE_IO_URING
+
+  /** \brief Allocates memory for `buffer_count` pages of size `page_size`, without registering it
+   * for fixed I/O.  If `use_huge_pages` is true, the kernel is asked to back the slab with huge
+   * pages (this is only advice; it is not an error if huge pages aren't available).
+   */
+  static StatusOr<std::shared_ptr<PageBufferSlab>> make_new(
+      PageSize page_size, usize buffer_count,
+      UseHugePages use_huge_pages = UseHugePages{false}) noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  PageBufferSlab(const PageBufferSlab&) = delete;
+  PageBufferSlab& operator=(const PageBufferSlab&) = delete;
+
+  ~PageBufferSlab() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  PageSize page_size() const noexcept
+  {
+    return this->page_size_;
+  }
+
+  usize buffer_count() const noexcept
+  {
+    return this->buffer_count_;
+  }
+
+  /** \brief Returns true if the kernel accepted the request to back this slab with huge pages.
+   */
+  bool is_huge_page_backed() const noexcept
+  {
+    return this->huge_page_backed_;
+  }
+
+  /** \brief Returns true iff `page_buffer` was allocated from this slab.
+   */
+  bool contains(const PageBuffer* page_buffer) const noexcept;
+
+  /** \brief Returns the number of buffers currently available for allocation.
+   */
+  usize free_count() const noexcept;
+
+  /** \brief Returns a new PageBuffer from the slab, initialized as by PageBuffer::allocate; returns
+   * nullptr if all the slab's buffers are in use.
+   */
+  std::shared_ptr<PageBuffer> allocate(PageId page_id = PageId{kInvalidPageId}) noexcept;
+
+  /** \brief If `page_buffer` was allocated from this slab and the slab is registered with an
+   * IoRing, returns the `buf_index` to use for fixed I/O on it; otherwise returns None.
+   */
+  Optional<i32> buf_index_of(const PageBuffer* page_buffer) const noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  /** \brief Creates a slab that owns `memory` (a region of `memory_size` bytes returned by mmap).
+   */
+  explicit PageBufferSlab(PageSize page_size, usize buffer_count, void* memory, usize memory_size,
+                          bool huge_page_backed) noexcept;
+
+  /** \brief Returns `page_buffer` to the free list; called when the last reference to it goes away.
+   */
+  void release(PageBuffer* page_buffer) noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const PageSize page_size_;
+
+  const usize buffer_count_;
+
+  // The number of page buffers in each registered chunk.
+  //
+  const usize buffers_per_chunk_;
+
+  // The slab memory; unmapped when the slab is destroyed.
+  //
+  void* const memory_;
+  const usize memory_size_;
+  const bool huge_page_backed_;
+
+  // The `buf_index` of the first registered chunk, or -1 if the slab isn't registered.
+  //
+  i32 first_buf_index_ = -1;
+
+  // Protects free_list_.
+  //
+  mutable std::mutex mutex_;
+
+  // The buffers available for allocation.
+  //
+  std::vector<PageBuffer*> free_list_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_PAGE_BUFFER_SLAB_HPP
@@ -0,0 +1,186 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_buffer_slab.hpp>
+//
+#include <llfs/page_buffer_slab.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/filesystem.hpp>
+#include <llfs/ioring_file.hpp>
+
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//
+//  1. Allocate all buffers from a slab; each has a valid buf_index, and once the slab is exhausted
+//     allocate returns nullptr.  Releasing a buffer makes it available again.
+//  2. Buffers not allocated from the slab have no buf_index.
+//  3. Slab buffers can be used for fixed-buffer reads.
+//  4. The slab stays alive as long as any of its buffers does.
+//  5. A slab that isn't registered with an IoRing (optionally huge page backed) allocates buffers
+//     the same way, but they have no buf_index.
+//
+
+using namespace llfs::int_types;
+
+constexpr usize kTestBufferCount = 8;
+constexpr llfs::PageSize kTestPageSize{4096};
+
+class PageBufferSlabTest : public ::testing::Test
+{
+ public:
+  void SetUp() override
+  {
+    llfs::StatusOr<llfs::ScopedIoRing> io =
+        llfs::ScopedIoRing::make_new(llfs::MaxQueueDepth{16}, llfs::ThreadPoolSize{1});
+
+    ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+    this->io_ = std::move(*io);
+
+    llfs::StatusOr<std::shared_ptr<llfs::PageBufferSlab>> slab = llfs::PageBufferSlab::make_new(
+        this->io_.get_io_ring(), kTestPageSize, kTestBufferCount);
+
+    ASSERT_TRUE(slab.ok()) << BATT_INSPECT(slab.status());
+    this->slab_ = std::move(*slab);
+  }
+
+  llfs::ScopedIoRing io_;
+  std::shared_ptr<llfs::PageBufferSlab> slab_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  1. Allocate all buffers from a slab...
+//
+TEST_F(PageBufferSlabTest, AllocateAndRelease)
+{
+  EXPECT_EQ(this->slab_->buffer_count(), kTestBufferCount);
+  EXPECT_EQ(this->slab_->free_count(), kTestBufferCount);
+
+  std::vector<std::shared_ptr<llfs::PageBuffer>> buffers;
+  for (usize i = 0; i < kTestBufferCount; ++i) {
+    std::shared_ptr<llfs::PageBuffer> page_buffer = this->slab_->allocate();
+    ASSERT_NE(page_buffer, nullptr);
+
+    EXPECT_EQ(page_buffer->size(), kTestPageSize);
+    EXPECT_TRUE(this->slab_->buf_index_of(page_buffer.get()));
+
+    buffers.emplace_back(std::move(page_buffer));
+  }
+
+  EXPECT_EQ(this->slab_->free_count(), 0u);
+  EXPECT_EQ(this->slab_->allocate(), nullptr);
+
+  buffers.pop_back();
+
+  EXPECT_EQ(this->slab_->free_count(), 1u);
+  EXPECT_NE(this->slab_->allocate(), nullptr);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  2. Buffers not allocated from the slab have no buf_index.
+//
+TEST_F(PageBufferSlabTest, NotFromSlab)
+{
+  std::shared_ptr<llfs::PageBuffer> page_buffer = llfs::PageBuffer::allocate(kTestPageSize);
+
+  EXPECT_FALSE(this->slab_->buf_index_of(page_buffer.get()));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  3. Slab buffers can be used for fixed-buffer reads.
+//
+TEST_F(PageBufferSlabTest, FixedRead)
+{
+  const std::string_view kExpectPrefix = "//#=##=##=#==#=#==#===#+==#+==========+";
+
+  std::shared_ptr<llfs::PageBuffer> page_buffer = this->slab_->allocate();
+  ASSERT_NE(page_buffer, nullptr);
+
+  llfs::Optional<i32> buf_index = this->slab_->buf_index_of(page_buffer.get());
+  ASSERT_TRUE(buf_index);
+
+  llfs::StatusOr<int> fd = llfs::open_file_read_only(__FILE__);
+  ASSERT_TRUE(fd.ok()) << BATT_INSPECT(fd.status());
+
+  llfs::IoRing::File file{this->io_.get_io_ring(), *fd};
+
+  llfs::Status read_status = file.read_all_fixed(
+      0, llfs::MutableBuffer{page_buffer->mutable_buffer().data(), kExpectPrefix.size()},
+      *buf_index);
+
+  ASSERT_TRUE(read_status.ok()) << BATT_INSPECT(read_status);
+
+  EXPECT_THAT((std::string_view{(const char*)page_buffer->const_buffer().data(),
+                                kExpectPrefix.size()}),
+              ::testing::StrEq(kExpectPrefix));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  4. The slab stays alive as long as any of its buffers does.
+//
+TEST_F(PageBufferSlabTest, BuffersOutliveSlabHandle)
+{
+  std::shared_ptr<llfs::PageBuffer> page_buffer = this->slab_->allocate();
+  ASSERT_NE(page_buffer, nullptr);
+
+  std::weak_ptr<llfs::PageBufferSlab> weak_slab = this->slab_;
+  this->slab_ = nullptr;
+
+  EXPECT_FALSE(weak_slab.expired());
+
+  page_buffer = nullptr;
+
+  EXPECT_TRUE(weak_slab.expired());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  5. A slab that isn't registered with an IoRing...
+//
+TEST(PageBufferSlabUnregisteredTest, AllocateAndRelease)
+{
+  for (bool use_huge_pages : {false, true}) {
+    llfs::StatusOr<std::shared_ptr<llfs::PageBufferSlab>> slab = llfs::PageBufferSlab::make_new(
+        kTestPageSize, kTestBufferCount, llfs::UseHugePages{use_huge_pages});
+
+    ASSERT_TRUE(slab.ok()) << BATT_INSPECT(slab.status());
+    if (!use_huge_pages) {
+      EXPECT_FALSE((*slab)->is_huge_page_backed());
+    }
+
+    std::vector<std::shared_ptr<llfs::PageBuffer>> buffers;
+    for (usize i = 0; i < kTestBufferCount; ++i) {
+      std::shared_ptr<llfs::PageBuffer> page_buffer = (*slab)->allocate();
+      ASSERT_NE(page_buffer, nullptr);
+
+      EXPECT_EQ(page_buffer->size(), kTestPageSize);
+      EXPECT_TRUE((*slab)->contains(page_buffer.get()));
+      EXPECT_FALSE((*slab)->buf_index_of(page_buffer.get()));
+
+      // The memory is writable.
+      //
+      const llfs::MutableBuffer payload = page_buffer->mutable_payload();
+      std::memset(payload.data(), 0xab, payload.size());
+
+      buffers.emplace_back(std::move(page_buffer));
+    }
+
+    EXPECT_EQ((*slab)->allocate(), nullptr);
+
+    buffers.clear();
+    EXPECT_EQ((*slab)->free_count(), kTestBufferCount);
+  }
+}
+
+}  // namespace
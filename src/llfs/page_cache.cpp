@@ -12,12 +12,23 @@
 #include <llfs/committable_page_cache_job.hpp>
 #include <llfs/memory_log_device.hpp>
 #include <llfs/metrics.hpp>
+#include <llfs/numa.hpp>
 #include <llfs/page_cache_job.hpp>
+#include <llfs/page_cache_warm_start.hpp>
+#include <llfs/page_ref_summary.hpp>
+#include <llfs/page_scrubber.hpp>
 #include <llfs/status_code.hpp>
 
+#include <batteries/async/runtime.hpp>
+#include <batteries/small_vec.hpp>
+
 #include <boost/range/irange.hpp>
 #include <boost/uuid/random_generator.hpp>  // TODO [tastolfi 2021-04-05] remove me
 
+#include <algorithm>
+#include <random>
+#include <thread>
+
 namespace llfs {
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -82,6 +93,57 @@ Status PageCache::PageDeleterImpl::delete_pages(const Slice<const PageToRecycle>
   return OkStatus();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCache::PageDeleterImpl::prefetch_pages(
+    const Slice<const PageToRecycle>& to_delete) /*override*/
+{
+  batt::SmallVec<PageId, 64> page_ids;
+  for (const PageToRecycle& next_page : to_delete) {
+    page_ids.emplace_back(next_page.page_id);
+  }
+
+  // The pages are dead, so once they have been traced (by `delete_pages`) they will never be used
+  // again; don't let them push live pages out of the cache.
+  //
+  this->page_cache_.prefetch_hints(as_slice(page_ids), PrefetchPriority::kRecycle);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+double PageCache::PageDeleterImpl::free_page_ratio() /*override*/
+{
+  double min_ratio = 1.0;
+
+  for (PageDeviceEntry* entry : this->page_cache_.all_devices()) {
+    BATT_CHECK_NOT_NULLPTR(entry);
+
+    const u64 capacity = entry->arena.device().capacity().value();
+    if (capacity == 0) {
+      continue;
+    }
+
+    // Don't force a lazily recovered arena to be recovered just to ask how full it is; no pages
+    // can have been allocated from it (or freed to it) yet.
+    //
+    if (!entry->arena.is_recovered()) {
+      continue;
+    }
+
+    // An arena whose (lazy) recovery failed has nothing to allocate.
+    //
+    StatusOr<PageAllocator*> allocator = entry->arena.try_allocator();
+    if (!allocator.ok()) {
+      continue;
+    }
+
+    min_ratio = std::min(min_ratio, static_cast<double>((*allocator)->free_pool_size()) /
+                                        static_cast<double>(capacity));
+  }
+
+  return min_ratio;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 /*static*/ StatusOr<std::shared_ptr<PageCache>> PageCache::make_shared(
@@ -111,6 +173,53 @@ PageCache::PageCache(std::vector<PageArena>&& storage_pool,
     max_page_device_id = std::max(max_page_device_id, arena.device().get_id());
   }
 
+  const usize n_shards = this->options_.numa_sharded_slot_pools()
+                             ? numa_node_count()
+                             : PageCacheSlot::Pool::kDefaultShardCount;
+
+  const auto new_slot_pool = [&](usize n_slots, std::string&& name, u64 max_bytes) {
+    boost::intrusive_ptr<PageCacheSlot::Pool> pool = PageCacheSlot::Pool::make_new(
+        n_slots, std::move(name),
+        /*eviction_candidates=*/PageCacheSlot::Pool::kDefaultEvictionCandidates, n_shards,
+        max_bytes);
+
+    if (this->options_.scan_resistant_admission()) {
+      pool->set_admission_filter(std::make_unique<FrequencySketchAdmissionFilter>(n_slots));
+    }
+    if (this->options_.clock_pro_eviction()) {
+      pool->set_eviction_policy(PageCacheSlot::Pool::EvictionPolicy::kClockPro);
+    }
+    if (this->options_.cache_line_isolated_slots()) {
+      pool->set_cache_line_isolation(true);
+    }
+    return pool;
+  };
+
+  // If there is a byte budget for the whole cache, all page sizes share a single pool, with enough
+  // slots to fill the (resizable) budget with pages of the smallest size.
+  //
+  if (this->options_.max_cache_bytes() != 0 && !storage_pool.empty()) {
+    u64 min_page_size = ~u64{0};
+    for (const PageArena& arena : storage_pool) {
+      min_page_size = std::min<u64>(min_page_size, arena.device().page_size());
+    }
+
+    // Reserve enough slots to grow to the resizable limit; slots aren't constructed (and their
+    // memory isn't touched) until they are needed.
+    //
+    this->shared_cache_slot_pool_ = new_slot_pool(
+        /*n_slots=*/std::max<u64>(1, this->options_.max_resizable_cache_bytes() / min_page_size),
+        /*name=*/"shared",
+        /*max_bytes=*/this->options_.max_cache_bytes());
+
+    for (const PageArena& arena : storage_pool) {
+      const auto page_size_log2 = batt::log2_ceil(arena.device().page_size());
+      BATT_CHECK_LT(page_size_log2, kMaxPageSizeLog2);
+
+      this->cache_slot_pool_by_page_size_log2_[page_size_log2] = this->shared_cache_slot_pool_;
+    }
+  }
+
   // Populate this->page_devices_.
   //
   this->page_devices_.resize(max_page_device_id + 1);
@@ -126,19 +235,74 @@ PageCache::PageCache(std::vector<PageArena>&& storage_pool,
     // Create a slot pool for this page size if we haven't already done so.
     //
     if (!this->cache_slot_pool_by_page_size_log2_[page_size_log2]) {
-      this->cache_slot_pool_by_page_size_log2_[page_size_log2] = PageCacheSlot::Pool::make_new(
+      this->cache_slot_pool_by_page_size_log2_[page_size_log2] = new_slot_pool(
           /*n_slots=*/this->options_.max_cached_pages_per_size_log2[page_size_log2],
-          /*name=*/batt::to_string("size_", u64{1} << page_size_log2));
+          /*name=*/batt::to_string("size_", u64{1} << page_size_log2),
+          /*max_bytes=*/0);
     }
 
     BATT_CHECK_EQ(this->page_devices_[device_id], nullptr)
         << "Duplicate entries found for the same device id!" << BATT_INSPECT(device_id);
 
+    if (this->options_.registered_page_buffers_per_device() != 0) {
+      Status status = arena.device().enable_registered_page_buffers(
+          this->options_.registered_page_buffers_per_device());
+      if (!status.ok()) {
+        LLFS_LOG_WARNING() << "Failed to enable registered page buffers; " << BATT_INSPECT(status)
+                           << BATT_INSPECT(device_id);
+      }
+    }
+
     this->page_devices_[device_id] = std::make_unique<PageDeviceEntry>(            //
         std::move(arena),                                                          //
         batt::make_copy(this->cache_slot_pool_by_page_size_log2_[page_size_log2])  //
     );
 
+    if (this->options_.hot_page_replica_pin_threshold() != 0) {
+      const usize n_sets = this->options_.hot_page_replica_sets() != 0
+                               ? this->options_.hot_page_replica_sets()
+                               : std::max<usize>(1, std::thread::hardware_concurrency());
+
+      this->page_devices_[device_id]->cache.enable_hot_page_replicas(
+          n_sets, this->options_.hot_page_replica_slots(),
+          this->options_.hot_page_replica_pin_threshold());
+    }
+
+    if (this->options_.page_validation_policy() == PageValidationPolicy::kFull ||
+        this->options_.page_validation_policy() == PageValidationPolicy::kFirstLoadOnly) {
+      const usize bitmap_words =
+          (this->page_devices_[device_id]->arena.device().capacity().value() + 63) / 64;
+
+      this->page_devices_[device_id]->validated_pages.reset(new std::atomic<u64>[bitmap_words]);
+      for (usize i = 0; i < bitmap_words; ++i) {
+        this->page_devices_[device_id]->validated_pages[i].store(0);
+      }
+    }
+
+    if (this->options_.page_filter_index()) {
+      PageDeviceEntry& entry = *this->page_devices_[device_id];
+
+      entry.page_filters = std::make_unique<PageFilterTable>(entry.arena.device().page_ids());
+
+      // The filters from the file remain useful even if it can't be opened for appending any more,
+      // so a failure here is not fatal; newly built filters just won't survive a restart.
+      //
+      if (this->options_.page_filter_file_dir()) {
+        const std::string file_name = batt::to_string(*this->options_.page_filter_file_dir(),
+                                                      "/page_filters.", device_id, ".llfs");
+
+        StatusOr<std::unique_ptr<PageFilterFile>> file = PageFilterFile::open(
+            file_name, entry.arena.device().page_ids(), entry.page_filters.get());
+
+        if (file.ok()) {
+          entry.page_filter_file = std::move(*file);
+        } else {
+          LLFS_LOG_WARNING() << "Failed to open page filter file; " << BATT_INSPECT(file_name)
+                             << BATT_INSPECT(file.status());
+        }
+      }
+    }
+
     // We will sort these later.
     //
     this->page_devices_by_page_size_.emplace_back(this->page_devices_[device_id].get());
@@ -180,8 +344,80 @@ PageCache::PageCache(std::vector<PageArena>&& storage_pool,
   ADD_METRIC_(pipeline_wait_latency);
   ADD_METRIC_(update_ref_counts_latency);
   ADD_METRIC_(ref_count_sync_latency);
+  ADD_METRIC_(prefetch_issue_count);
+  ADD_METRIC_(prefetch_drop_count);
+  ADD_METRIC_(prefetch_hit_count);
+  ADD_METRIC_(prefetch_device_hint_count);
+  ADD_METRIC_(ref_summary_hit_count);
+  ADD_METRIC_(ref_summary_miss_count);
+  ADD_METRIC_(compressed_page_write_count);
+  ADD_METRIC_(compression_saved_bytes);
+  ADD_METRIC_(decompressed_page_count);
+  ADD_METRIC_(delta_page_write_count);
+  ADD_METRIC_(delta_saved_bytes);
+  ADD_METRIC_(materialized_delta_page_count);
+  ADD_METRIC_(validated_page_count);
+  ADD_METRIC_(page_validation_failure_count);
+  ADD_METRIC_(page_filter_build_count);
+  ADD_METRIC_(page_filter_build_drop_count);
 
 #undef ADD_METRIC_
+
+  if (this->options_.page_validation_policy() == PageValidationPolicy::kBackgroundScrub) {
+    this->scrubber_ = std::make_unique<PageScrubber>(
+        *this, batt::Runtime::instance().default_scheduler(),
+        PageScrubber::Options{
+            .pages_per_second = this->options_.background_scrub_pages_per_second(),
+        });
+  }
+
+  if (this->options_.page_filter_index()) {
+    this->page_filter_builder_.emplace(
+        batt::Runtime::instance().default_scheduler().schedule_task(),
+        [this] {
+          this->page_filter_builder_task_main();
+        },
+        "PageCache::page_filter_builder");
+  }
+
+  if (this->options_.warm_start_file()) {
+    this->warm_start_ = std::make_unique<PageCacheWarmStart>(
+        *this, batt::Runtime::instance().default_scheduler(),
+        PageCacheWarmStart::Options{
+            .file_name = *this->options_.warm_start_file(),
+            .save_interval_sec = this->options_.warm_start_save_interval_sec(),
+            .max_pages = this->options_.warm_start_max_pages(),
+            .max_in_flight = this->options_.warm_start_max_in_flight(),
+        });
+  }
+
+  // Tracing is a diagnostic aid; if the trace file can't be created, just run without it.
+  //
+  if (this->options_.page_cache_trace_file()) {
+    StatusOr<std::unique_ptr<PageCacheTraceRecorder>> recorder = PageCacheTraceRecorder::open(
+        *this->options_.page_cache_trace_file(), this->options_.page_cache_trace_buffer_size());
+
+    if (recorder.ok()) {
+      this->trace_recorder_ = std::move(*recorder);
+    } else {
+      LLFS_LOG_WARNING() << "Failed to open page cache trace file; "
+                         << BATT_INSPECT(*this->options_.page_cache_trace_file())
+                         << BATT_INSPECT(recorder.status());
+    }
+  }
+
+  if (this->options_.access_stats_sample_interval() != 0) {
+    this->access_stats_ = std::make_unique<PageCacheAccessStats>(PageCacheAccessStats::Options{
+        .sample_interval = this->options_.access_stats_sample_interval(),
+        .max_key_ranges = this->options_.access_stats_max_key_ranges(),
+        .key_prefix_size = this->options_.access_stats_key_prefix_size(),
+    });
+  }
+
+  if (this->options_.dedup_index_max_entries() != 0) {
+    this->dedup_index_ =
+        std::make_unique<PageDedupIndex>(this->options_.dedup_index_max_entries());
+  }
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -200,7 +436,23 @@ PageCache::~PageCache() noexcept
       .remove(this->metrics_.page_write_latency)
       .remove(this->metrics_.pipeline_wait_latency)
       .remove(this->metrics_.update_ref_counts_latency)
-      .remove(this->metrics_.ref_count_sync_latency);
+      .remove(this->metrics_.ref_count_sync_latency)
+      .remove(this->metrics_.prefetch_issue_count)
+      .remove(this->metrics_.prefetch_drop_count)
+      .remove(this->metrics_.prefetch_hit_count)
+      .remove(this->metrics_.prefetch_device_hint_count)
+      .remove(this->metrics_.ref_summary_hit_count)
+      .remove(this->metrics_.ref_summary_miss_count)
+      .remove(this->metrics_.compressed_page_write_count)
+      .remove(this->metrics_.compression_saved_bytes)
+      .remove(this->metrics_.decompressed_page_count)
+      .remove(this->metrics_.delta_page_write_count)
+      .remove(this->metrics_.delta_saved_bytes)
+      .remove(this->metrics_.materialized_delta_page_count)
+      .remove(this->metrics_.validated_page_count)
+      .remove(this->metrics_.page_validation_failure_count)
+      .remove(this->metrics_.page_filter_build_count)
+      .remove(this->metrics_.page_filter_build_drop_count);
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -210,6 +462,95 @@ const PageCacheOptions& PageCache::options() const
   return this->options_;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageCache::resize_cache(u64 max_bytes)
+{
+  if (!this->shared_cache_slot_pool_) {
+    return Status{batt::StatusCode::kFailedPrecondition};
+  }
+  if (max_bytes == 0 || max_bytes > this->options_.max_resizable_cache_bytes()) {
+    return Status{batt::StatusCode::kInvalidArgument};
+  }
+
+  if (!this->shared_cache_slot_pool_->set_max_bytes(max_bytes)) {
+    LLFS_VLOG(1) << "PageCache::resize_cache: too many pinned pages to shrink right away;"
+                 << BATT_INSPECT(max_bytes)
+                 << BATT_INSPECT(this->shared_cache_slot_pool_->bytes_in_use());
+  }
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 PageCache::cache_bytes_limit() const
+{
+  if (!this->shared_cache_slot_pool_) {
+    return 0;
+  }
+  return this->shared_cache_slot_pool_->max_bytes();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 PageCache::cache_bytes_in_use() const
+{
+  if (this->shared_cache_slot_pool_) {
+    return this->shared_cache_slot_pool_->bytes_in_use();
+  }
+
+  u64 total = 0;
+  for (const boost::intrusive_ptr<PageCacheSlot::Pool>& pool :
+       this->cache_slot_pool_by_page_size_log2_) {
+    if (pool) {
+      total += pool->bytes_in_use();
+    }
+  }
+  return total;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::vector<PageId> PageCache::hot_pages(usize max_count) const
+{
+  std::vector<PageDeviceCache::CachedPage> cached_pages;
+  for (PageDeviceEntry* entry : this->all_devices()) {
+    entry->cache.append_cached_pages(&cached_pages);
+  }
+
+  // Most recent first; compare time stamps by their difference, since they may wrap.
+  //
+  const auto more_recent = [](const PageDeviceCache::CachedPage& l,
+                              const PageDeviceCache::CachedPage& r) {
+    return l.latest_use - r.latest_use > 0;
+  };
+
+  if (max_count != 0 && cached_pages.size() > max_count) {
+    std::nth_element(cached_pages.begin(), cached_pages.begin() + max_count, cached_pages.end(),
+                     more_recent);
+    cached_pages.resize(max_count);
+  }
+  std::sort(cached_pages.begin(), cached_pages.end(), more_recent);
+
+  std::vector<PageId> page_ids;
+  page_ids.reserve(cached_pages.size());
+  for (const PageDeviceCache::CachedPage& page : cached_pages) {
+    page_ids.emplace_back(page.page_id);
+  }
+  return page_ids;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageCache::start_warm_start()
+{
+  if (!this->warm_start_) {
+    return Status{batt::StatusCode::kFailedPrecondition};
+  }
+  return this->warm_start_->start_restore();
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 bool PageCache::register_page_layout(const PageLayoutId& layout_id, const PageReader& reader)
@@ -249,10 +590,95 @@ batt::Status PageCache::register_page_reader(const PageLayoutId& layout_id, cons
   return batt::OkStatus();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCache::set_page_compression(const PageLayoutId& layout_id, PageCompression compression)
+{
+  auto locked = this->page_compression_.lock();
+  if (compression == PageCompression::kNone) {
+    locked->erase(layout_id);
+  } else {
+    (*locked)[layout_id] = compression;
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCompression PageCache::get_page_compression(const PageLayoutId& layout_id) const
+{
+  auto locked = this->page_compression_.lock();
+  auto iter = locked->find(layout_id);
+  if (iter == locked->end()) {
+    return PageCompression::kNone;
+  }
+  return iter->second;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCache::set_page_priority(const PageLayoutId& layout_id, PageCachePriority priority)
+{
+  auto locked = this->page_priority_.lock();
+  if (priority == PageCachePriority::kNormal) {
+    locked->erase(layout_id);
+  } else {
+    (*locked)[layout_id] = priority;
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCachePriority PageCache::get_page_priority(const PageLayoutId& layout_id) const
+{
+  auto locked = this->page_priority_.lock();
+  auto iter = locked->find(layout_id);
+  if (iter == locked->end()) {
+    return PageCachePriority::kNormal;
+  }
+  return iter->second;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::shared_ptr<const PageBuffer> PageCache::prepare_page_for_write(
+    std::shared_ptr<const PageBuffer>&& page)
+{
+  // A page that is (re)written must be checked again the next time it is read.
+  //
+  this->set_page_validated(get_page_header(*page).page_id.unpack(), false);
+
+  const PageCompression compression =
+      this->get_page_compression(get_page_header(*page).layout_id);
+
+  if (compression == PageCompression::kNone) {
+    return std::move(page);
+  }
+
+  std::shared_ptr<const PageBuffer> compressed = compress_page(*page, compression);
+  if (!compressed) {
+    return std::move(page);
+  }
+
+  this->metrics_.compressed_page_write_count.add(1);
+  this->metrics_.compression_saved_bytes.add(
+      get_page_header(*page).used_size() - get_page_header(*compressed).used_size());
+
+  return compressed;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 void PageCache::close()
 {
+  if (this->scrubber_) {
+    this->scrubber_->halt();
+  }
+  // Halting the warm start helper saves the hot page list, so do it before closing the devices.
+  //
+  if (this->warm_start_) {
+    this->warm_start_->halt();
+  }
+  this->page_filter_build_queue_.close();
   for (const std::unique_ptr<PageDeviceEntry>& entry : this->page_devices_) {
     if (entry) {
       entry->arena.close();
@@ -264,6 +690,16 @@ void PageCache::close()
 //
 void PageCache::join()
 {
+  if (this->scrubber_) {
+    this->scrubber_->join();
+  }
+  if (this->warm_start_) {
+    this->warm_start_->join();
+  }
+  if (this->page_filter_builder_) {
+    this->page_filter_builder_->join();
+    this->page_filter_builder_ = None;
+  }
   for (const std::unique_ptr<PageDeviceEntry>& entry : this->page_devices_) {
     if (entry) {
       entry->arena.join();
@@ -304,13 +740,27 @@ StatusOr<std::shared_ptr<PageBuffer>> PageCache::allocate_page_of_size_log2(
 
   Slice<PageDeviceEntry* const> device_entries = this->devices_with_page_size_log2(size_log2);
 
+  // Set if an arena couldn't be used at all (because its lazy recovery failed); returned if no
+  // other arena has room for the page.
+  //
+  Status arena_error;
+
   // TODO [tastolfi 2021-09-08] If the caller wants to wait, which device should we wait on?  First
   // available? Random?  Round-Robin?
   //
   for (auto wait_arg : {batt::WaitForResource::kFalse, batt::WaitForResource::kTrue}) {
     for (PageDeviceEntry* device_entry : device_entries) {
       PageArena& arena = device_entry->arena;
-      StatusOr<PageId> page_id = arena.allocator().allocate_page(wait_arg, cancel_token);
+
+      StatusOr<PageAllocator*> allocator = arena.try_allocator();
+      if (!allocator.ok()) {
+        LLFS_LOG_WARNING() << "Failed to allocate page (arena recovery failed): "
+                           << BATT_INSPECT(arena.id()) << BATT_INSPECT(allocator.status());
+        arena_error.Update(allocator.status());
+        continue;
+      }
+
+      StatusOr<PageId> page_id = (*allocator)->allocate_page(wait_arg, cancel_token);
       if (!page_id.ok()) {
         if (page_id.status() == batt::StatusCode::kResourceExhausted) {
           const u64 page_size = u64{1} << size_log2;
@@ -324,6 +774,10 @@ StatusOr<std::shared_ptr<PageBuffer>> PageCache::allocate_page_of_size_log2(
 
       LLFS_VLOG(1) << "allocated page " << *page_id;
 
+      // Any older generation of this physical page is now gone for good.
+      //
+      device_entry->cache.record_latest_generation(*page_id);
+
       this->track_new_page_event(NewPageTracker{
           .ts = 0,
           .job_id = job_id,
@@ -342,6 +796,8 @@ StatusOr<std::shared_ptr<PageBuffer>> PageCache::allocate_page_of_size_log2(
     }
   }
 
+  BATT_REQUIRE_OK(arena_error);
+
   LLFS_LOG_WARNING() << "No arena with free space could be found";
   return Status{batt::StatusCode::kUnavailable};  // TODO [tastolfi 2021-10-20]
 }
@@ -360,7 +816,13 @@ void PageCache::deallocate_page(PageId page_id, u64 callers, u64 job_id)
       .event_id = (int)NewPageTracker::Event::kDeallocate,
   });
 
-  this->arena_for_page_id(page_id).allocator().deallocate_page(page_id);
+  StatusOr<PageAllocator*> allocator = this->arena_for_page_id(page_id).try_allocator();
+  if (allocator.ok()) {
+    (*allocator)->deallocate_page(page_id);
+  } else {
+    LLFS_LOG_ERROR() << "Failed to deallocate page (arena recovery failed): "
+                     << BATT_INSPECT(page_id) << BATT_INSPECT(allocator.status());
+  }
   this->purge(page_id, callers | Caller::PageCache_deallocate_page, job_id);
 }
 
@@ -386,7 +848,8 @@ Status PageCache::attach(const boost::uuids::uuid& user_id, slot_offset_type slo
 
   for (PageDeviceEntry* entry : this->all_devices()) {
     BATT_CHECK_NOT_NULLPTR(entry);
-    auto arena_status = entry->arena.allocator().attach_user(user_id, slot_offset);
+    BATT_ASSIGN_OK_RESULT(PageAllocator * allocator, entry->arena.try_allocator());
+    auto arena_status = allocator->attach_user(user_id, slot_offset);
     BATT_REQUIRE_OK(arena_status);
     attached_arenas.emplace_back(&entry->arena);
   }
@@ -402,7 +865,8 @@ Status PageCache::detach(const boost::uuids::uuid& user_id, slot_offset_type slo
 {
   for (PageDeviceEntry* entry : this->all_devices()) {
     BATT_CHECK_NOT_NULLPTR(entry);
-    auto arena_status = entry->arena.allocator().detach_user(user_id, slot_offset);
+    BATT_ASSIGN_OK_RESULT(PageAllocator * allocator, entry->arena.try_allocator());
+    auto arena_status = allocator->detach_user(user_id, slot_offset);
     BATT_REQUIRE_OK(arena_status);
   }
   //
@@ -415,7 +879,95 @@ Status PageCache::detach(const boost::uuids::uuid& user_id, slot_offset_type slo
 //
 void PageCache::prefetch_hint(PageId page_id)
 {
-  (void)this->find_page_in_cache(page_id, /*require_tag=*/None, OkIfNotFound{false});
+  this->prefetch_hint_with_priority(page_id, PrefetchPriority::kNormal);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCache::prefetch_hints(const Slice<const PageId>& page_ids, PrefetchPriority priority)
+{
+  for (PageId page_id : page_ids) {
+    this->prefetch_hint_with_priority(page_id, priority);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCache::prefetch_hint_with_priority(PageId page_id, PrefetchPriority priority)
+{
+  if (!page_id) {
+    return;
+  }
+
+  PageDeviceEntry* const entry = this->get_device_for_page(page_id);
+  if (!entry) {
+    return;
+  }
+
+  // Some devices (e.g., MmapPageDevice) can prefetch on their own more cheaply than we can by
+  // loading the page into a cache slot.
+  //
+  if (entry->arena.device().prefetch_hint(page_id)) {
+    this->metrics_.prefetch_device_hint_count.add(1);
+    return;
+  }
+
+  // Reserve a spot in the device's prefetch queue up front; if the queue is full, drop the hint.
+  //
+  const usize max_in_flight = this->options_.max_prefetch_in_flight_per_device();
+  if (entry->prefetch_in_flight.fetch_add(1) >= max_in_flight) {
+    entry->prefetch_in_flight.fetch_sub(1);
+    this->metrics_.prefetch_drop_count.add(1);
+    return;
+  }
+
+  bool read_started = false;
+
+  // We intentionally drop the returned PinnedRef; the read handler holds its own pin until the load
+  // completes, and the prefetch hint protects the slot from eviction for a while after that.
+  //
+  (void)entry->cache.find_or_insert(page_id, [&](const PageCacheSlot::PinnedRef& pinned_slot) {
+    read_started = true;
+
+    // Dead pages loaded by the recycler are always low priority, whatever their layout.
+    //
+    Optional<PageCachePriority> page_priority;
+    if (priority == PrefetchPriority::kRecycle) {
+      pinned_slot.slot()->set_low_priority_prefetch_hint();
+      page_priority = PageCachePriority::kLow;
+    } else {
+      pinned_slot.slot()->set_prefetch_hint();
+    }
+    this->metrics_.prefetch_issue_count.add(1);
+
+    // Prefetches are speculative (e.g., readahead can predict pages that were never written), so
+    // a missing page is not worth logging.
+    //
+    PageDevice::ReadHandler handler = this->make_page_read_handler(
+        pinned_slot, /*required_layout=*/None, OkIfNotFound{true}, page_priority);
+
+    entry->arena.device().read(
+        page_id, [entry, handler = std::move(handler)](
+                     StatusOr<std::shared_ptr<const PageBuffer>>&& result) mutable {
+          handler(std::move(result));
+          entry->prefetch_in_flight.fetch_sub(1);
+        });
+  });
+
+  // If the page was already cached (or we couldn't get a slot), release our queue reservation.
+  //
+  if (!read_started) {
+    entry->prefetch_in_flight.fetch_sub(1);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCache::note_page_used(const PageCacheSlot::PinnedRef& pinned_slot)
+{
+  if (pinned_slot && pinned_slot.slot()->consume_prefetch_hint()) {
+    this->metrics_.prefetch_hit_count.add(1);
+  }
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -445,6 +997,30 @@ Slice<PageCache::PageDeviceEntry* const> PageCache::devices_with_page_size_log2(
   return this->page_devices_by_page_size_log2_[size_log2];
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCache::write_page(std::shared_ptr<const PageBuffer>&& page, PageWriteOp* op)
+{
+  PageDeviceEntry* const entry = this->get_device_for_page(op->page_id);
+  BATT_CHECK_NOT_NULLPTR(entry)
+      << "the specified page_id's device is not in the storage pool for this cache";
+
+  entry->writes_in_flight.fetch_add(1);
+  op->writes_in_flight = &entry->writes_in_flight;
+
+  entry->arena.device().write(std::move(page), op->get_handler());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize PageCache::page_writes_in_flight(page_device_id_int device_id) const
+{
+  if (device_id >= this->page_devices_.size() || !this->page_devices_[device_id]) {
+    return 0;
+  }
+  return this->page_devices_[device_id]->writes_in_flight.load();
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 const PageArena& PageCache::arena_for_page_id(PageId page_id) const
@@ -479,35 +1055,97 @@ StatusOr<PinnedPage> PageCache::put_view(std::shared_ptr<const PageView>&& view,
     return {::llfs::make_status(StatusCode::kPutViewUnknownLayoutId)};
   }
 
-  const PageView* p_view = view.get();
-  const PageId page_id = view->page_id();
-
-  PageDeviceEntry* const entry = this->get_device_for_page(page_id);
+  PageDeviceEntry* const entry = this->get_device_for_page(view->page_id());
   BATT_CHECK_NOT_NULLPTR(entry);
 
-  // Attempt to insert the new page view into the cache.
-  //
-  batt::StatusOr<PageCacheSlot::PinnedRef> pinned_cache_slot =
-      entry->cache.find_or_insert(page_id, [&view](const PageCacheSlot::PinnedRef& pinned_ref) {
-        pinned_ref->set_value(std::move(view));
-      });
+  return this->put_view_on_device(entry, std::move(view), callers, job_id);
+}
 
-  this->track_new_page_event(NewPageTracker{
-      .ts = 0,
-      .job_id = job_id,
-      .page_id = page_id,
-      .callers = callers,
-      .event_id = pinned_cache_slot.ok() ? (int)NewPageTracker::Event::kPutView_Ok
-                                         : (int)NewPageTracker::Event::kPutView_Fail,
-  });
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::vector<StatusOr<PinnedPage>> PageCache::put_views(
+    const Slice<std::shared_ptr<const PageView>>& views, u64 callers, u64 job_id)
+{
+  std::vector<StatusOr<PinnedPage>> pages(views.size(), Status{batt::StatusCode::kUnknown});
 
-  // If no slots are available, clients should back off and retry.
+  // Check all the layouts first, taking the reader map lock only once.  Views that fail the check
+  // get an invalid page id below, so they are skipped by indices_by_device.
+  //
+  std::vector<PageId> page_ids;
+  page_ids.reserve(views.size());
+  {
+    auto locked_readers = this->page_readers_->lock();
+
+    for (usize i = 0; i < views.size(); ++i) {
+      const std::shared_ptr<const PageView>& view = views[i];
+      BATT_CHECK_NOT_NULLPTR(view);
+
+      if (view->get_page_layout_id() != view->header().layout_id) {
+        pages[i] = ::llfs::make_status(StatusCode::kPageHeaderBadLayoutId);
+        page_ids.emplace_back();
+      } else if (locked_readers->count(view->get_page_layout_id()) == 0) {
+        pages[i] = ::llfs::make_status(StatusCode::kPutViewUnknownLayoutId);
+        page_ids.emplace_back();
+      } else {
+        page_ids.emplace_back(view->page_id());
+      }
+    }
+  }
+
+  // Insert the pages one device at a time.
+  //
+  PageDeviceEntry* entry = nullptr;
+  for (usize i : indices_by_device(as_slice(page_ids))) {
+    if (entry == nullptr || entry->arena.id() != PageIdFactory::get_device_id(page_ids[i])) {
+      entry = this->get_device_for_page(page_ids[i]);
+      BATT_CHECK_NOT_NULLPTR(entry);
+    }
+    pages[i] = this->put_view_on_device(entry, std::move(views[i]), callers, job_id);
+  }
+
+  return pages;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<PinnedPage> PageCache::put_view_on_device(PageDeviceEntry* entry,
+                                                   std::shared_ptr<const PageView>&& view,
+                                                   u64 callers, u64 job_id)
+{
+  const PageView* p_view = view.get();
+  const PageId page_id = view->page_id();
+
+  // `view` is moved into the cache slot below; keep a reference if its filter is to be built.
+  //
+  std::shared_ptr<const PageView> view_to_filter = entry->page_filters ? view : nullptr;
+
+  // Attempt to insert the new page view into the cache.
+  //
+  batt::StatusOr<PageCacheSlot::PinnedRef> pinned_cache_slot =
+      entry->cache.find_or_insert(page_id, [&view](const PageCacheSlot::PinnedRef& pinned_ref) {
+        pinned_ref->set_value(std::move(view));
+      });
+
+  this->track_new_page_event(NewPageTracker{
+      .ts = 0,
+      .job_id = job_id,
+      .page_id = page_id,
+      .callers = callers,
+      .event_id = pinned_cache_slot.ok() ? (int)NewPageTracker::Event::kPutView_Ok
+                                         : (int)NewPageTracker::Event::kPutView_Fail,
+  });
+
+  // If no slots are available, clients should back off and retry.
   //
   BATT_REQUIRE_OK(pinned_cache_slot);
 
   PinnedPage pinned_page{p_view, std::move(*pinned_cache_slot)};
   BATT_CHECK(bool{pinned_page});
 
+  if (view_to_filter) {
+    this->queue_page_filter_build(view_to_filter);
+  }
+
   return pinned_page;
 }
 
@@ -516,21 +1154,67 @@ StatusOr<PinnedPage> PageCache::put_view(std::shared_ptr<const PageView>&& view,
 void PageCache::purge(PageId page_id, u64 callers, u64 job_id)
 {
   if (page_id.is_valid()) {
-    this->track_new_page_event(NewPageTracker{
-        .ts = 0,
-        .job_id = job_id,
-        .page_id = page_id,
-        .callers = callers,
-        .event_id = (int)NewPageTracker::Event::kPurge,
-    });
-
     PageDeviceEntry* const entry = this->get_device_for_page(page_id);
     BATT_CHECK_NOT_NULLPTR(entry);
 
-    entry->cache.erase(page_id);
+    this->purge_on_device(entry, page_id, callers, job_id);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCache::purge_pages(const Slice<const PageId>& page_ids, u64 callers, u64 job_id)
+{
+  PageDeviceEntry* entry = nullptr;
+  for (usize i : indices_by_device(page_ids)) {
+    if (entry == nullptr || entry->arena.id() != PageIdFactory::get_device_id(page_ids[i])) {
+      entry = this->get_device_for_page(page_ids[i]);
+      BATT_CHECK_NOT_NULLPTR(entry);
+    }
+    this->purge_on_device(entry, page_ids[i], callers, job_id);
   }
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCache::purge_on_device(PageDeviceEntry* entry, PageId page_id, u64 callers,
+                                u64 job_id)
+{
+  this->track_new_page_event(NewPageTracker{
+      .ts = 0,
+      .job_id = job_id,
+      .page_id = page_id,
+      .callers = callers,
+      .event_id = (int)NewPageTracker::Event::kPurge,
+  });
+
+  entry->cache.erase(page_id);
+  entry->cache.record_latest_generation(entry->cache.page_ids().advance_generation(page_id));
+
+  if (entry->page_filters) {
+    entry->page_filters->erase(page_id);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ std::vector<usize> PageCache::indices_by_device(const Slice<const PageId>& page_ids)
+{
+  std::vector<usize> indices;
+  indices.reserve(page_ids.size());
+  for (usize i = 0; i < page_ids.size(); ++i) {
+    if (page_ids[i].is_valid()) {
+      indices.emplace_back(i);
+    }
+  }
+
+  std::stable_sort(indices.begin(), indices.end(), [&page_ids](usize l, usize r) {
+    return PageIdFactory::get_device_id(page_ids[l]) < PageIdFactory::get_device_id(page_ids[r]);
+  });
+
+  return indices;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 PageCache::PageDeviceEntry* PageCache::get_device_for_page(PageId page_id)
@@ -543,6 +1227,28 @@ PageCache::PageDeviceEntry* PageCache::get_device_for_page(PageId page_id)
   return this->page_devices_[device_id].get();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<PageCacheSlot::OptimisticRead> PageCache::begin_optimistic_read(
+    PageId page_id, const OptimisticReadEpoch::Guard& guard)
+{
+  if (!page_id || !this->options_.optimistic_reads()) {
+    return None;
+  }
+
+  PageDeviceEntry* const entry = this->get_device_for_page(page_id);
+  if (!entry) {
+    return None;
+  }
+
+  PageCacheSlot* const slot = entry->cache.peek(page_id);
+  if (!slot) {
+    return None;
+  }
+
+  return slot->begin_optimistic_read(page_id, guard);
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 StatusOr<PinnedPage> PageCache::get_page_with_layout_in_job(
@@ -559,21 +1265,267 @@ StatusOr<PinnedPage> PageCache::get_page_with_layout_in_job(
     return ::llfs::make_status(StatusCode::kPageIdInvalid);
   }
 
-  BATT_ASSIGN_OK_RESULT(PageCacheSlot::PinnedRef pinned_slot,  //
-                        this->find_page_in_cache(page_id, require_layout, ok_if_not_found));
+  const bool sample_access = this->access_stats_ && this->access_stats_->should_sample();
+  const auto start_time = (this->trace_recorder_ || sample_access)
+                              ? std::chrono::steady_clock::now()
+                              : std::chrono::steady_clock::time_point{};
+  bool inserted = false;
+
+  BATT_ASSIGN_OK_RESULT(
+      PageCacheSlot::PinnedRef pinned_slot,  //
+      this->find_page_in_cache(page_id, require_layout, ok_if_not_found, &inserted));
+
+  this->note_page_used(pinned_slot);
 
   BATT_ASSIGN_OK_RESULT(StatusOr<std::shared_ptr<const PageView>> loaded,  //
                         pinned_slot->await());
 
   BATT_CHECK_EQ(loaded->get() != nullptr, bool{pinned_slot});
 
+  if (this->options_.optimistic_reads()) {
+    pinned_slot.slot()->publish_view(*loaded);
+  }
+
+  if (this->options_.hot_page_replica_pin_threshold() != 0) {
+    this->get_device_for_page(page_id)->cache.maybe_replicate(pinned_slot, *loaded);
+  }
+
+  if (this->trace_recorder_) {
+    this->trace_recorder_->record(page_id, /*hit=*/!inserted, start_time);
+  }
+  if (sample_access && *loaded) {
+    this->access_stats_->record(**loaded, /*hit=*/!inserted, start_time);
+  }
+
   return PinnedPage{loaded->get(), std::move(pinned_slot)};
 }
 
+#if LLFS_HAS_COROUTINES
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+coro::Task<StatusOr<PinnedPage>> PageCache::co_get_page(PageId page_id,
+                                                         Optional<PageLayoutId> required_layout,
+                                                         OkIfNotFound ok_if_not_found)
+{
+  ++this->metrics_.get_count;
+
+  if (!page_id) {
+    co_return ::llfs::make_status(StatusCode::kPageIdInvalid);
+  }
+
+  StatusOr<PageCacheSlot::PinnedRef> pinned_slot =
+      this->find_page_in_cache(page_id, required_layout, ok_if_not_found, /*inserted=*/nullptr);
+
+  if (!pinned_slot.ok()) {
+    co_return pinned_slot.status();
+  }
+
+  this->note_page_used(*pinned_slot);
+
+  StatusOr<std::shared_ptr<const PageView>> loaded =
+      co_await coro::async_op<StatusOr<std::shared_ptr<const PageView>>>(
+          [latch = pinned_slot->get()](auto&& handler) {
+            latch->async_get(BATT_FORWARD(handler));
+          });
+
+  if (!loaded.ok()) {
+    co_return loaded.status();
+  }
+
+  BATT_CHECK_EQ(loaded->get() != nullptr, bool{*pinned_slot});
+
+  if (this->options_.optimistic_reads()) {
+    pinned_slot->slot()->publish_view(*loaded);
+  }
+
+  if (this->options_.hot_page_replica_pin_threshold() != 0) {
+    this->get_device_for_page(page_id)->cache.maybe_replicate(*pinned_slot, *loaded);
+  }
+
+  co_return PinnedPage{loaded->get(), std::move(*pinned_slot)};
+}
+
+#endif  // LLFS_HAS_COROUTINES
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::vector<StatusOr<PinnedPage>> PageCache::get_pages(
+    const Slice<const PageId>& page_ids, const Optional<PageLayoutId>& required_layout,
+    PinPageToJob pin_page_to_job, OkIfNotFound ok_if_not_found)
+{
+  std::vector<StatusOr<PinnedPage>> pages;
+  pages.reserve(page_ids.size());
+
+  if (bool_from(pin_page_to_job, /*default_value=*/false)) {
+    pages.resize(page_ids.size(), Status{batt::StatusCode::kUnimplemented});
+    return pages;
+  }
+
+  this->metrics_.get_count.add(page_ids.size());
+
+  // The reads that need to be issued for cache misses, grouped by device.
+  //
+  struct DeviceReadBatch {
+    PageDeviceEntry* entry;
+    std::vector<PageId> ids;
+    std::vector<PageDevice::ReadHandler> handlers;
+  };
+  std::vector<DeviceReadBatch> read_batches;
+
+  // Phase 1: find (or insert) the cache slot for every page, collecting the reads for any slots we
+  // inserted.
+  //
+  std::vector<batt::StatusOr<PageCacheSlot::PinnedRef>> pinned_slots;
+  pinned_slots.reserve(page_ids.size());
+
+  // Which of `pinned_slots` we inserted (i.e., cache misses); only needed for tracing and access
+  // stats.
+  //
+  const auto start_time = (this->trace_recorder_ || this->access_stats_)
+                              ? std::chrono::steady_clock::now()
+                              : std::chrono::steady_clock::time_point{};
+  std::vector<bool> inserted(page_ids.size(), false);
+
+  for (const PageId& page_id : page_ids) {
+    if (!page_id) {
+      pinned_slots.emplace_back(::llfs::make_status(StatusCode::kPageIdInvalid));
+      continue;
+    }
+
+    // Fail ids for devices this cache doesn't have, rather than taking down the whole batch.
+    //
+    PageDeviceEntry* const entry = this->get_device_for_page(page_id);
+    if (!entry) {
+      pinned_slots.emplace_back(::llfs::make_status(StatusCode::kPageIdInvalid));
+      continue;
+    }
+
+    pinned_slots.emplace_back(
+        entry->cache.find_or_insert(page_id, [&](const PageCacheSlot::PinnedRef& pinned_slot) {
+          inserted[pinned_slots.size()] = true;
+          auto iter = std::find_if(read_batches.begin(), read_batches.end(),
+                                   [entry](const DeviceReadBatch& batch) {
+                                     return batch.entry == entry;
+                                   });
+          if (iter == read_batches.end()) {
+            iter = read_batches.insert(read_batches.end(), DeviceReadBatch{entry, {}, {}});
+          }
+          iter->ids.emplace_back(page_id);
+          iter->handlers.emplace_back(
+              this->make_page_read_handler(pinned_slot, required_layout, ok_if_not_found));
+        }));
+  }
+
+  // Phase 2: issue all reads, one batch per device.
+  //
+  for (DeviceReadBatch& batch : read_batches) {
+    batch.entry->arena.device().read_batch(as_slice(batch.ids), std::move(batch.handlers));
+  }
+
+  // Phase 3: wait for all the pages to load.
+  //
+  for (usize i = 0; i < pinned_slots.size(); ++i) {
+    batt::StatusOr<PageCacheSlot::PinnedRef>& pinned_slot = pinned_slots[i];
+    if (!pinned_slot.ok()) {
+      pages.emplace_back(pinned_slot.status());
+      continue;
+    }
+    this->note_page_used(*pinned_slot);
+
+    StatusOr<std::shared_ptr<const PageView>> loaded = (*pinned_slot)->await();
+    if (!loaded.ok()) {
+      pages.emplace_back(loaded.status());
+      continue;
+    }
+
+    BATT_CHECK_EQ(loaded->get() != nullptr, bool{*pinned_slot});
+
+    if (this->options_.optimistic_reads()) {
+      pinned_slot->slot()->publish_view(*loaded);
+    }
+
+    if (this->options_.hot_page_replica_pin_threshold() != 0) {
+      this->get_device_for_page(page_ids[i])->cache.maybe_replicate(*pinned_slot, *loaded);
+    }
+
+    if (this->trace_recorder_) {
+      this->trace_recorder_->record(page_ids[i], /*hit=*/!inserted[i], start_time);
+    }
+    if (this->access_stats_ && *loaded && this->access_stats_->should_sample()) {
+      this->access_stats_->record(**loaded, /*hit=*/!inserted[i], start_time);
+    }
+
+    pages.emplace_back(PinnedPage{loaded->get(), std::move(*pinned_slot)});
+  }
+
+  return pages;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageCache::append_page_refs(PageId page_id, std::vector<PageId>* refs)
+{
+  if (!page_id) {
+    return ::llfs::make_status(StatusCode::kPageIdInvalid);
+  }
+
+  PageDeviceEntry* const entry = this->get_device_for_page(page_id);
+  BATT_CHECK_NOT_NULLPTR(entry);
+
+  // If the page is already in the cache (or on its way), there is no point reading anything.
+  //
+  {
+    PageCacheSlot::PinnedRef pinned_slot = entry->cache.find(page_id);
+    if (pinned_slot) {
+      StatusOr<std::shared_ptr<const PageView>> loaded = pinned_slot->await();
+      if (loaded.ok()) {
+        (*loaded)->append_refs_and_delta_base(refs);
+        return OkStatus();
+      }
+    }
+  }
+
+  // Otherwise try to read just the summary of the page's refs from the end of the page; the first
+  // read covers most summaries, but if the summary turns out to be larger, read the rest of it.
+  //
+  usize read_size = kDefaultPageRefSummaryReadSize;
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    PageDevice::ReadTailResult tail = entry->arena.device().await_read_tail(page_id, read_size);
+    if (!tail.ok()) {
+      break;
+    }
+
+    const ConstBuffer tail_buffer{tail->data(), tail->size()};
+
+    StatusOr<std::vector<PageId>> summary_refs = read_page_ref_summary(tail_buffer, page_id);
+    if (summary_refs.ok()) {
+      this->metrics_.ref_summary_hit_count.add(1);
+      refs->insert(refs->end(), summary_refs->begin(), summary_refs->end());
+      return OkStatus();
+    }
+    if (summary_refs.status() != batt::StatusCode::kOutOfRange) {
+      break;
+    }
+
+    StatusOr<usize> summary_size = get_page_ref_summary_size(tail_buffer, page_id);
+    if (!summary_size.ok() || *summary_size <= read_size) {
+      break;
+    }
+    read_size = *summary_size;
+  }
+
+  // No usable summary; fall back on loading the whole page.
+  //
+  this->metrics_.ref_summary_miss_count.add(1);
+
+  return PageLoader::append_page_refs(page_id, refs);
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 auto PageCache::find_page_in_cache(PageId page_id, const Optional<PageLayoutId>& required_layout,
-                                   OkIfNotFound ok_if_not_found)
+                                   OkIfNotFound ok_if_not_found, bool* inserted)
     -> batt::StatusOr<PageCacheSlot::PinnedRef>
 {
   if (!page_id) {
@@ -584,6 +1536,9 @@ auto PageCache::find_page_in_cache(PageId page_id, const Optional<PageLayoutId>&
   BATT_CHECK_NOT_NULLPTR(entry);
 
   return entry->cache.find_or_insert(page_id, [&](const PageCacheSlot::PinnedRef& pinned_slot) {
+    if (inserted) {
+      *inserted = true;
+    }
     this->async_load_page_into_slot(pinned_slot, required_layout, ok_if_not_found);
   });
 }
@@ -600,89 +1555,348 @@ void PageCache::async_load_page_into_slot(const PageCacheSlot::PinnedRef& pinned
   BATT_CHECK_NOT_NULLPTR(entry);
 
   entry->arena.device().read(
-      page_id,
-      /*read_handler=*/[this, required_layout, ok_if_not_found,
+      page_id, this->make_page_read_handler(pinned_slot, required_layout, ok_if_not_found));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageDevice::ReadHandler PageCache::make_page_read_handler(
+    const PageCacheSlot::PinnedRef& pinned_slot, const Optional<PageLayoutId>& required_layout,
+    OkIfNotFound ok_if_not_found, Optional<PageCachePriority> priority)
+{
+  return [this, required_layout, ok_if_not_found, priority,
 
-                        // Save the metrics and start time so we can record read latency etc.
-                        //
-                        start_time = std::chrono::steady_clock::now(),
+          // Save the metrics and start time so we can record read latency etc.
+          //
+          start_time = std::chrono::steady_clock::now(),
 
-                        // Keep a copy of pinned_slot while loading the page to limit the
-                        // amount of churn under heavy read loads.
-                        //
-                        pinned_slot = batt::make_copy(pinned_slot)
+          // Keep a copy of pinned_slot while loading the page to limit the
+          // amount of churn under heavy read loads.
+          //
+          pinned_slot = batt::make_copy(pinned_slot)
 
   ](StatusOr<std::shared_ptr<const PageBuffer>>&& result) mutable {
-        const PageId page_id = pinned_slot.key();
-        auto* p_metrics = &this->metrics_;
-        auto page_readers = this->page_readers_;
+    const PageId page_id = pinned_slot.key();
+    auto* p_metrics = &this->metrics_;
 
-        BATT_DEBUG_INFO("PageCache::find_page_in_cache - read handler");
+    BATT_DEBUG_INFO("PageCache::find_page_in_cache - read handler");
 
-        auto cleanup = batt::finally([&] {
-          pinned_slot = {};
-        });
+    auto cleanup = batt::finally([&] {
+      pinned_slot = {};
+    });
 
-        batt::Latch<std::shared_ptr<const PageView>>* latch = pinned_slot.value();
-        BATT_CHECK_NOT_NULLPTR(latch);
-
-        if (!result.ok()) {
-          if (!ok_if_not_found) {
-            LLFS_LOG_WARNING() << "recent events for" << BATT_INSPECT(page_id)
-                               << BATT_INSPECT(ok_if_not_found) << " (now=" << this->history_end_
-                               << "):"
-                               << batt::dump_range(
-                                      this->find_new_page_events(page_id) | seq::collect_vec(),
-                                      batt::Pretty::True);
-          }
-          latch->set_value(result.status());
-          return;
-        }
-        p_metrics->page_read_latency.update(start_time);
-
-        // Page read succeeded!  Find the right typed reader.
-        //
-        std::shared_ptr<const PageBuffer>& page_data = *result;
-        p_metrics->total_bytes_read.add(page_data->size());
-
-        PageLayoutId layout_id = get_page_header(*page_data).layout_id;
-        if (required_layout) {
-          if (*required_layout != layout_id) {
-            latch->set_value(::llfs::make_status(StatusCode::kPageHeaderBadLayoutId));
-            return;
-          }
-        }
+    batt::Latch<std::shared_ptr<const PageView>>* latch = pinned_slot.value();
+    BATT_CHECK_NOT_NULLPTR(latch);
+
+    if (!result.ok()) {
+      if (!ok_if_not_found) {
+        LLFS_LOG_WARNING() << "recent events for" << BATT_INSPECT(page_id)
+                           << BATT_INSPECT(ok_if_not_found) << " (now=" << this->history_end_
+                           << "):"
+                           << batt::dump_range(
+                                  this->find_new_page_events(page_id) | seq::collect_vec(),
+                                  batt::Pretty::True);
+      }
+      latch->set_value(result.status());
+      return;
+    }
+    p_metrics->page_read_latency.update(start_time);
 
-        PageReader reader_for_layout;
-        {
-          auto locked = page_readers->lock();
-          auto iter = locked->find(layout_id);
-          if (iter == locked->end()) {
-            LLFS_LOG_ERROR() << "Unknown page layout: "
-                             << batt::c_str_literal(
-                                    std::string_view{(const char*)&layout_id, sizeof(layout_id)})
-                             << BATT_INSPECT(page_id);
-            latch->set_value(make_status(StatusCode::kNoReaderForPageViewType));
-            return;
-          }
-          reader_for_layout = iter->second.page_reader;
-        }
-        // ^^ Release the page_readers mutex ASAP
+    // Page read succeeded!  Find the right typed reader.
+    //
+    std::shared_ptr<const PageBuffer>& page_data = *result;
+    p_metrics->total_bytes_read.add(page_data->size());
 
-        StatusOr<std::shared_ptr<const PageView>> page_view =
-            reader_for_layout(std::move(page_data));
-        if (page_view.ok()) {
-          BATT_CHECK_EQ(page_view->use_count(), 1u);
-        }
-        latch->set_value(std::move(page_view));
-      });
+    // The cache only holds uncompressed pages.
+    //
+    if (is_compressed_page(*page_data)) {
+      StatusOr<std::shared_ptr<const PageBuffer>> decompressed =
+          decompress_page(std::move(page_data));
+      if (!decompressed.ok()) {
+        LLFS_LOG_ERROR() << "Failed to decompress page: " << BATT_INSPECT(page_id)
+                         << BATT_INSPECT(decompressed.status());
+        latch->set_value(decompressed.status());
+        return;
+      }
+      page_data = std::move(*decompressed);
+      p_metrics->decompressed_page_count.add(1);
+    }
+
+    // Delta pages are materialized from their base page, which may have to be loaded first.
+    //
+    if (is_delta_page(*page_data)) {
+      this->async_materialize_delta_page(std::move(pinned_slot), std::move(page_data),
+                                         required_layout, priority);
+      return;
+    }
+
+    this->finish_page_load(pinned_slot, std::move(page_data), required_layout, priority,
+                           /*delta_base=*/PageId{}, /*delta_depth=*/0);
+  };
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-bool PageCache::page_might_contain_key(PageId /*page_id*/, const KeyView& /*key*/) const
+void PageCache::async_materialize_delta_page(PageCacheSlot::PinnedRef&& pinned_slot,
+                                             std::shared_ptr<const PageBuffer>&& delta,
+                                             const Optional<PageLayoutId>& required_layout,
+                                             Optional<PageCachePriority> priority)
 {
-  return true;
+  const PageId page_id = pinned_slot.key();
+  const PageId base_id = get_delta_page_base_id(*delta);
+
+  batt::Latch<std::shared_ptr<const PageView>>* latch = pinned_slot.value();
+  BATT_CHECK_NOT_NULLPTR(latch);
+
+  if (!base_id || base_id == page_id || !this->get_device_for_page(base_id)) {
+    LLFS_LOG_ERROR() << "Delta page has a bad base page: " << BATT_INSPECT(page_id)
+                     << BATT_INSPECT(base_id);
+    latch->set_value(::llfs::make_status(StatusCode::kPageDeltaBadData));
+    return;
+  }
+
+  StatusOr<PageCacheSlot::PinnedRef> pinned_base =
+      this->find_page_in_cache(base_id, /*required_layout=*/None, OkIfNotFound{false});
+
+  if (!pinned_base.ok()) {
+    latch->set_value(pinned_base.status());
+    return;
+  }
+
+  batt::Latch<std::shared_ptr<const PageView>>* base_latch = pinned_base->value();
+  BATT_CHECK_NOT_NULLPTR(base_latch);
+
+  // The base page stays pinned until the delta page has been materialized.
+  //
+  base_latch->async_get([this, required_layout, priority, base_id,
+                         pinned_slot = std::move(pinned_slot),
+                         pinned_base = std::move(*pinned_base), delta = std::move(delta)](
+                            StatusOr<std::shared_ptr<const PageView>> base_view) mutable {
+    batt::Latch<std::shared_ptr<const PageView>>* delta_latch = pinned_slot.value();
+
+    if (!base_view.ok()) {
+      LLFS_LOG_ERROR() << "Failed to load the base of a delta page: "
+                       << BATT_INSPECT(pinned_slot.key()) << BATT_INSPECT(base_id)
+                       << BATT_INSPECT(base_view.status());
+      delta_latch->set_value(base_view.status());
+      return;
+    }
+
+    StatusOr<std::shared_ptr<const PageBuffer>> materialized =
+        apply_page_delta(*delta, (*base_view)->page_buffer());
+
+    if (!materialized.ok()) {
+      LLFS_LOG_ERROR() << "Failed to materialize delta page: " << BATT_INSPECT(pinned_slot.key())
+                       << BATT_INSPECT(base_id) << BATT_INSPECT(materialized.status());
+      delta_latch->set_value(materialized.status());
+      return;
+    }
+    this->metrics_.materialized_delta_page_count.add(1);
+
+    const u16 delta_depth = get_delta_page_depth(*delta);
+    delta = nullptr;
+    pinned_base = {};
+
+    this->finish_page_load(pinned_slot, std::move(*materialized), required_layout, priority,
+                           base_id, delta_depth);
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCache::finish_page_load(const PageCacheSlot::PinnedRef& pinned_slot,
+                                 std::shared_ptr<const PageBuffer>&& page_data,
+                                 const Optional<PageLayoutId>& required_layout,
+                                 Optional<PageCachePriority> priority, PageId delta_base,
+                                 u16 delta_depth)
+{
+  const PageId page_id = pinned_slot.key();
+
+  batt::Latch<std::shared_ptr<const PageView>>* latch = pinned_slot.value();
+  BATT_CHECK_NOT_NULLPTR(latch);
+
+  if (this->should_validate_page_on_load(page_id)) {
+    Status validated = verify_page_checksum(*page_data);
+    if (!validated.ok()) {
+      LLFS_LOG_ERROR() << "Page failed validation: " << BATT_INSPECT(page_id)
+                       << BATT_INSPECT(validated);
+      this->metrics_.page_validation_failure_count.add(1);
+      latch->set_value(validated);
+      return;
+    }
+    this->metrics_.validated_page_count.add(1);
+    this->set_page_validated(page_id, true);
+  }
+
+  PageLayoutId layout_id = get_page_header(*page_data).layout_id;
+  if (required_layout) {
+    if (*required_layout != layout_id) {
+      latch->set_value(::llfs::make_status(StatusCode::kPageHeaderBadLayoutId));
+      return;
+    }
+  }
+
+  PageReader reader_for_layout;
+  {
+    auto locked = this->page_readers_->lock();
+    auto iter = locked->find(layout_id);
+    if (iter == locked->end()) {
+      LLFS_LOG_ERROR() << "Unknown page layout: "
+                       << batt::c_str_literal(
+                              std::string_view{(const char*)&layout_id, sizeof(layout_id)})
+                       << BATT_INSPECT(page_id);
+      latch->set_value(make_status(StatusCode::kNoReaderForPageViewType));
+      return;
+    }
+    reader_for_layout = iter->second.page_reader;
+  }
+  // ^^ Release the page_readers mutex ASAP
+
+  StatusOr<std::shared_ptr<const PageView>> page_view =
+      reader_for_layout(std::move(page_data));
+  if (page_view.ok()) {
+    BATT_CHECK_EQ(page_view->use_count(), 1u);
+
+    if (delta_base) {
+      (*page_view)->set_delta_base(delta_base, delta_depth);
+    }
+
+    this->queue_page_filter_build(*page_view);
+
+    pinned_slot.slot()->set_priority(priority.value_or(this->get_page_priority(layout_id)));
+  }
+  latch->set_value(std::move(page_view));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool PageCache::should_validate_page_on_load(PageId page_id)
+{
+  switch (this->options_.page_validation_policy()) {
+    case PageValidationPolicy::kSampled: {
+      thread_local std::default_random_engine rng{std::random_device{}()};
+      return std::bernoulli_distribution{this->options_.page_validation_sample_rate()}(rng);
+    }
+
+    case PageValidationPolicy::kFull:
+    case PageValidationPolicy::kFirstLoadOnly: {
+      PageDeviceEntry* const entry = this->get_device_for_page(page_id);
+      if (entry == nullptr || !entry->validated_pages) {
+        return true;
+      }
+      return !entry->is_page_validated(entry->arena.device().page_ids().get_physical_page(page_id));
+    }
+
+    case PageValidationPolicy::kBackgroundScrub:
+      return false;
+  }
+  BATT_PANIC() << "bad PageValidationPolicy: " << this->options_.page_validation_policy();
+  BATT_UNREACHABLE();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCache::set_page_validated(PageId page_id, bool validated)
+{
+  PageDeviceEntry* const entry = this->get_device_for_page(page_id);
+  if (entry == nullptr || !entry->validated_pages) {
+    return;
+  }
+  entry->set_page_validated(entry->arena.device().page_ids().get_physical_page(page_id),
+                            validated);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool PageCache::page_might_contain_key(PageId page_id, const KeyView& key) const
+{
+  std::shared_ptr<PageFilter> filter = this->find_page_filter(page_id);
+  if (filter == nullptr) {
+    return true;
+  }
+  return filter->might_contain_key(key);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::shared_ptr<PageFilter> PageCache::find_page_filter(PageId page_id) const
+{
+  const page_device_id_int device_id = PageIdFactory::get_device_id(page_id);
+  if (!page_id.is_valid() || device_id >= this->page_devices_.size() ||
+      this->page_devices_[device_id] == nullptr ||
+      this->page_devices_[device_id]->page_filters == nullptr) {
+    return nullptr;
+  }
+  return this->page_devices_[device_id]->page_filters->find(page_id);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCache::queue_page_filter_build(const std::shared_ptr<const PageView>& view)
+{
+  PageDeviceEntry* const entry = this->get_device_for_page(view->page_id());
+  if (entry == nullptr || entry->page_filters == nullptr ||
+      entry->page_filters->find(view->page_id()) != nullptr) {
+    return;
+  }
+
+  // Holding on to the views of too many pages (which can't be evicted from the cache until their
+  // builds are done) would defeat the cache; so drop the request instead.  The filter will be
+  // built the next time the page is loaded.
+  //
+  if (this->page_filter_build_queue_depth_.fetch_add(1) >=
+      this->options_.max_page_filter_build_queue_depth()) {
+    this->page_filter_build_queue_depth_.fetch_sub(1);
+    this->metrics_.page_filter_build_drop_count.add(1);
+    return;
+  }
+
+  if (!this->page_filter_build_queue_.push(batt::make_copy(view)).ok()) {
+    this->page_filter_build_queue_depth_.fetch_sub(1);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCache::page_filter_builder_task_main()
+{
+  for (;;) {
+    StatusOr<std::shared_ptr<const PageView>> next = this->page_filter_build_queue_.await_next();
+    if (!next.ok()) {
+      break;
+    }
+    this->page_filter_build_queue_depth_.fetch_sub(1);
+
+    const std::shared_ptr<const PageView>& view = *next;
+    PageDeviceEntry* const entry = this->get_device_for_page(view->page_id());
+    BATT_CHECK_NOT_NULLPTR(entry);
+    BATT_CHECK_NOT_NULLPTR(entry->page_filters);
+
+    std::shared_ptr<PageFilter> filter = view->build_filter();
+    if (filter == nullptr) {
+      continue;
+    }
+    BATT_CHECK_EQ(filter->page_id(), view->page_id());
+
+    if (entry->page_filter_file) {
+      Status appended = entry->page_filter_file->append(*filter);
+      if (!appended.ok()) {
+        LLFS_LOG_WARNING() << "Failed to persist page filter; " << BATT_INSPECT(view->page_id())
+                           << BATT_INSPECT(appended);
+      }
+    }
+
+    entry->page_filters->update(std::move(filter));
+    this->metrics_.page_filter_build_count.add(1);
+
+    // If the page was purged while its filter was being built, purge() may have already erased the
+    // (old) filter; don't leave the new one behind.  purge() marks the page stale before it erases
+    // the filter, so one of us always gets it.
+    //
+    if (entry->cache.is_known_stale(view->page_id())) {
+      entry->page_filters->erase(view->page_id());
+    }
+  }
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
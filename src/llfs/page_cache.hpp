@@ -15,17 +15,27 @@
 #include <llfs/api_types.hpp>
 #include <llfs/cache.hpp>
 #include <llfs/caller.hpp>
+#include <llfs/coro.hpp>
 #include <llfs/log_device.hpp>
 #include <llfs/metrics.hpp>
+#include <llfs/optimistic_read_epoch.hpp>
 #include <llfs/optional.hpp>
 #include <llfs/page_allocator.hpp>
 #include <llfs/page_arena.hpp>
 #include <llfs/page_buffer.hpp>
+#include <llfs/page_cache_access_stats.hpp>
 #include <llfs/page_cache_metrics.hpp>
 #include <llfs/page_cache_options.hpp>
+#include <llfs/page_cache_priority.hpp>
+#include <llfs/page_cache_trace.hpp>
+#include <llfs/page_compression.hpp>
+#include <llfs/page_dedup_index.hpp>
+#include <llfs/page_delta.hpp>
 #include <llfs/page_device.hpp>
 #include <llfs/page_device_cache.hpp>
 #include <llfs/page_filter.hpp>
+#include <llfs/page_filter_file.hpp>
+#include <llfs/page_filter_table.hpp>
 #include <llfs/page_id_slot.hpp>
 #include <llfs/page_loader.hpp>
 #include <llfs/page_reader.hpp>
@@ -42,6 +52,8 @@
 #include <batteries/async/cancel_token.hpp>
 #include <batteries/async/latch.hpp>
 #include <batteries/async/mutex.hpp>
+#include <batteries/async/queue.hpp>
+#include <batteries/async/task.hpp>
 
 #include <functional>
 #include <iomanip>
@@ -55,7 +67,10 @@
 namespace llfs {
 
 class PageCacheJob;
+class PageCacheWarmStart;
+class PageScrubber;
 struct JobCommitParams;
+struct PageWriteOp;
 
 struct NewPageTracker {
   enum struct Event {
@@ -97,6 +112,23 @@ inline std::ostream& operator<<(std::ostream& out, const NewPageTracker& t)
 class PageCache : public PageLoader
 {
  public:
+  /** \brief How a page loaded by a prefetch hint should be treated by the cache until it is first
+   * used.
+   */
+  enum struct PrefetchPriority {
+    /** \brief The page is protected from eviction for a short grace period; see
+     * PageCacheSlot::set_prefetch_hint.
+     */
+    kNormal,
+
+    /** \brief The page is only needed briefly by a background task (e.g., the PageRecycler, which
+     * loads dead pages to trace their refs); it is made the first candidate for eviction, so that
+     * it doesn't displace the pages the application is actually using.  See
+     * PageCacheSlot::set_low_priority_prefetch_hint.
+     */
+    kRecycle,
+  };
+
   struct PageReaderFromFile {
     PageReader page_reader;
     const char* file;
@@ -109,7 +141,8 @@ class PageCache : public PageLoader
     explicit PageDeviceEntry(PageArena&& arena,
                              boost::intrusive_ptr<PageCacheSlot::Pool>&& slot_pool) noexcept
         : arena{std::move(arena)}
-        , cache{this->arena.device().page_ids(), std::move(slot_pool)}
+        , cache{this->arena.device().page_ids(), this->arena.device().page_size(),
+                std::move(slot_pool)}
     {
     }
 
@@ -118,9 +151,51 @@ class PageCache : public PageLoader
     PageArena arena;
 
     /** \brief A per-device page cache; shares a PageCacheSlot::Pool with all other PageDeviceEntry
-     * objects that have the same page size.
+     * objects that have the same page size (or with all of them, if
+     * PageCacheOptions::max_cache_bytes() is set).
      */
     PageDeviceCache cache;
+
+    /** \brief The number of prefetch reads currently in flight for this device; bounded by
+     * PageCacheOptions::max_prefetch_in_flight_per_device().
+     */
+    std::atomic<usize> prefetch_in_flight{0};
+
+    /** \brief The number of page writes started by PageCache::write_page that haven't completed
+     * yet for this device.
+     */
+    std::atomic<usize> writes_in_flight{0};
+
+    /** \brief One bit per physical page, set once the page has been validated since it was last
+     * written; only allocated under PageValidationPolicy::kFull and kFirstLoadOnly.
+     */
+    std::unique_ptr<std::atomic<u64>[]> validated_pages;
+
+    bool is_page_validated(i64 physical_page) const
+    {
+      return (this->validated_pages[physical_page / 64].load() &
+              (u64{1} << (physical_page % 64))) != 0;
+    }
+
+    void set_page_validated(i64 physical_page, bool validated)
+    {
+      const u64 mask = u64{1} << (physical_page % 64);
+      if (validated) {
+        this->validated_pages[physical_page / 64].fetch_or(mask);
+      } else {
+        this->validated_pages[physical_page / 64].fetch_and(~mask);
+      }
+    }
+
+    /** \brief The latest filter of each page on the device; only allocated if
+     * PageCacheOptions::page_filter_index() is true.
+     */
+    std::unique_ptr<PageFilterTable> page_filters;
+
+    /** \brief Where newly built filters for `page_filters` are persisted; only opened if
+     * PageCacheOptions::page_filter_file_dir() is set.
+     */
+    std::unique_ptr<PageFilterFile> page_filter_file;
   };
 
   class PageDeleterImpl : public PageDeleter
@@ -132,6 +207,10 @@ class PageCache : public PageLoader
                         slot_offset_type caller_slot, batt::Grant& recycle_grant,
                         i32 recycle_depth) override;
 
+    void prefetch_pages(const Slice<const PageToRecycle>& to_delete) override;
+
+    double free_page_ratio() override;
+
    private:
     PageCache& page_cache_;
   };
@@ -164,6 +243,43 @@ class PageCache : public PageLoader
   batt::Status register_page_reader(const PageLayoutId& layout_id, const char* file, int line,
                                     const PageReader& reader);
 
+  /** \brief Sets how pages with the given layout are compressed when they are written (the default
+   * is PageCompression::kNone).  This can be changed at any time; pages are decompressed as they
+   * are read regardless of this setting.
+   */
+  void set_page_compression(const PageLayoutId& layout_id, PageCompression compression);
+
+  /** \brief Returns the compression used for newly written pages with the given layout.
+   */
+  PageCompression get_page_compression(const PageLayoutId& layout_id) const;
+
+  /** \brief Sets the cache priority of pages with the given layout (the default is
+   * PageCachePriority::kNormal); e.g., the internal nodes of an index can be kept cached in favor
+   * of its leaves.  Only pages loaded after this call are affected.
+   */
+  void set_page_priority(const PageLayoutId& layout_id, PageCachePriority priority);
+
+  /** \brief Returns the cache priority of pages with the given layout.
+   */
+  PageCachePriority get_page_priority(const PageLayoutId& layout_id) const;
+
+  /** \brief Returns the image of `page` that should be written to its PageDevice: a compressed copy
+   * if compression is enabled for the page's layout (and saves space), otherwise `page` itself.
+   */
+  std::shared_ptr<const PageBuffer> prepare_page_for_write(
+      std::shared_ptr<const PageBuffer>&& page);
+
+  /** \brief Writes `page` (as returned by `prepare_page_for_write`) to the PageDevice of
+   * `op->page_id`, reporting the result to `op`.  The write is counted in the device's
+   * PageDeviceEntry::writes_in_flight until it completes.
+   */
+  void write_page(std::shared_ptr<const PageBuffer>&& page, PageWriteOp* op);
+
+  /** \brief Returns the number of writes started by `write_page` for the given device that haven't
+   * completed yet; 0 if the device isn't in the storage pool.
+   */
+  usize page_writes_in_flight(page_device_id_int device_id) const;
+
   void close();
 
   void join();
@@ -211,14 +327,79 @@ class PageCache : public PageLoader
   // Gives a hint to the cache to fetch the pages for the given ids in the background because we are
   // going to need them soon.
   //
+  // If the page isn't already cached, a read is started (unless the per-device limit on in-flight
+  // prefetches has been reached, in which case the hint is dropped) and the slot is marked as
+  // "prefetched, not yet used," which protects it from eviction for a short grace period.
+  //
   void prefetch_hint(PageId page_id) override;
 
+  // Issues prefetch hints for all the given pages, with the given priority, before returning.  The
+  // reads for all pages are started up front, so they can proceed concurrently.
+  //
+  void prefetch_hints(const Slice<const PageId>& page_ids, PrefetchPriority priority);
+
   // Loads the specified page or retrieves from cache.
   //
   StatusOr<PinnedPage> get_page_with_layout_in_job(PageId page_id,
                                                    const Optional<PageLayoutId>& required_layout,
                                                    PinPageToJob pin_page_to_job,
                                                    OkIfNotFound ok_if_not_found) override;
+
+#if LLFS_HAS_COROUTINES
+  // Coroutine version of `get_page_with_layout`: if the page must be loaded, the calling coroutine
+  // is suspended (rather than blocking a batt::Task) until the load completes, and is resumed on
+  // the thread that completes it.
+  //
+  coro::Task<StatusOr<PinnedPage>> co_get_page(PageId page_id,
+                                               Optional<PageLayoutId> required_layout,
+                                               OkIfNotFound ok_if_not_found);
+#endif  // LLFS_HAS_COROUTINES
+
+  // Starts a pin-free (seqlock-style) read of the given page, if it is in the cache and has been
+  // loaded via get_page; see PageCacheSlot::begin_optimistic_read for the rules the reader must
+  // follow.  Returns None if the page can't be read this way (always, unless
+  // PageCacheOptions::optimistic_reads() is on).
+  //
+  Optional<PageCacheSlot::OptimisticRead> begin_optimistic_read(
+      PageId page_id, const OptimisticReadEpoch::Guard& guard);
+
+  // Runs `fn` on the cached view of `page_id` without pinning it; returns the result if the read
+  // was valid (the page wasn't evicted while `fn` ran), or None if the caller must retry (or fall
+  // back on get_page).  `fn` must be short, must not block, and must tolerate reading a page that
+  // is concurrently being evicted (its result is discarded in that case).
+  //
+  template <typename Fn, typename R = std::invoke_result_t<Fn&, const PageView&>>
+  Optional<R> try_read_page_optimistic(PageId page_id, Fn&& fn)
+  {
+    const OptimisticReadEpoch::Guard guard;
+
+    const Optional<PageCacheSlot::OptimisticRead> read =
+        this->begin_optimistic_read(page_id, guard);
+    if (!read) {
+      return None;
+    }
+
+    R result = fn(*read->view);
+
+    if (!read->slot->validate_optimistic_read(*read)) {
+      return None;
+    }
+    return result;
+  }
+
+  // Loads a batch of pages, retrieving as many as possible from cache; all misses on the same
+  // device are submitted to the PageDevice together (see PageDevice::read_batch).
+  //
+  std::vector<StatusOr<PinnedPage>> get_pages(const Slice<const PageId>& page_ids,
+                                              const Optional<PageLayoutId>& required_layout,
+                                              PinPageToJob pin_page_to_job,
+                                              OkIfNotFound ok_if_not_found) override;
+
+  // Appends the outgoing refs of a page to `*refs`; uses the cached PageView if there is one,
+  // otherwise tries to read only the page's ref summary (see page_ref_summary.hpp) from the end of
+  // the page, falling back on loading the whole page (into the cache) if it doesn't have one.
+  //
+  Status append_page_refs(PageId page_id, std::vector<PageId>* refs) override;
   //
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
@@ -232,8 +413,38 @@ class PageCache : public PageLoader
    */
   void purge(PageId id_val, u64 callers, u64 job_id);
 
+  //----- --- -- -  -  -   -
+  /** \brief Inserts a batch of newly built PageViews into the cache; equivalent to calling put_view
+   * for each element of `views` (in order), except that the layout ids of all views are checked
+   * under a single lock and the pages are inserted one device at a time.
+   *
+   * The views are moved out of `views`.  The returned vector has one entry per view, in the same
+   * order.
+   */
+  std::vector<StatusOr<PinnedPage>> put_views(const Slice<std::shared_ptr<const PageView>>& views,
+                                              u64 callers, u64 job_id);
+
+  //----- --- -- -  -  -   -
+  /** \brief Removes all cached data for the specified pages; equivalent to calling purge for each
+   * page, except that the pages are purged one device at a time.  Invalid page ids are ignored.
+   */
+  void purge_pages(const Slice<const PageId>& page_ids, u64 callers, u64 job_id);
+
+  //----- --- -- -  -  -   -
+  /** \brief Returns false if the specified page definitely doesn't contain `key`, according to the
+   * page's filter; returns true if it might, or if its filter isn't known (e.g., because
+   * PageCacheOptions::page_filter_index() is off, or the filter hasn't been built yet).
+   *
+   * This never loads the page.
+   */
   bool page_might_contain_key(PageId id, const KeyView& key) const;
 
+  //----- --- -- -  -  -   -
+  /** \brief Returns the filter of the given page from the page filter index, or nullptr if there
+   * isn't one (see PageCacheOptions::page_filter_index).
+   */
+  std::shared_ptr<PageFilter> find_page_filter(PageId page_id) const;
+
   BoxedSeq<NewPageTracker> find_new_page_events(PageId page_id) const;
 
   void track_new_page_event(const NewPageTracker& tracker);
@@ -243,6 +454,68 @@ class PageCache : public PageLoader
     return this->metrics_;
   }
 
+  /** \brief Returns the sampled per-layout and per-key-range lookup stats, or nullptr if they are
+   * disabled (see PageCacheOptions::access_stats_sample_interval).
+   */
+  const PageCacheAccessStats* access_stats() const
+  {
+    return this->access_stats_.get();
+  }
+
+  /** \brief Returns the content index of recently committed pages, or nullptr if deduplication is
+   * disabled (see PageCacheOptions::dedup_index_max_entries).
+   */
+  PageDedupIndex* dedup_index() const
+  {
+    return this->dedup_index_.get();
+  }
+
+  //----- --- -- -  -  -   -
+  /** \brief Changes the byte budget of the cache at runtime (e.g., in response to memory pressure
+   * from other processes on the host).
+   *
+   * Only supported when the cache was created with a byte budget (see
+   * PageCacheOptions::max_cache_bytes); returns batt::StatusCode::kFailedPrecondition otherwise.
+   * `max_bytes` must be non-zero and at most PageCacheOptions::max_resizable_cache_bytes(), or
+   * batt::StatusCode::kInvalidArgument is returned.
+   *
+   * Shrinking evicts unpinned pages right away; if too many pages are pinned, the rest are evicted
+   * as the pins are released and new pages are loaded.
+   */
+  Status resize_cache(u64 max_bytes);
+
+  /** \brief Returns the current byte budget of the cache, or 0 if it has none (see resize_cache).
+   */
+  u64 cache_bytes_limit() const;
+
+  /** \brief Returns the total size of the pages in all cache slot pools.
+   */
+  u64 cache_bytes_in_use() const;
+
+  //----- --- -- -  -  -   -
+  /** \brief Returns the ids of the pages currently in the cache, most recently used first; if
+   * `max_count` is non-zero, only that many are returned.
+   */
+  std::vector<PageId> hot_pages(usize max_count) const;
+
+  //----- --- -- -  -  -   -
+  /** \brief Starts reloading the pages listed in PageCacheOptions::warm_start_file() (written by an
+   * earlier PageCache, see PageCacheWarmStart) in the background.
+   *
+   * Must be called after all page layouts have been registered.  Returns
+   * batt::StatusCode::kFailedPrecondition if warm_start_file() isn't set, or the error if the file
+   * can't be read (e.g., batt::StatusCode::kNotFound on first start).
+   */
+  Status start_warm_start();
+
+  /** \brief Returns the warm start helper, or nullptr if PageCacheOptions::warm_start_file() isn't
+   * set.
+   */
+  const PageCacheWarmStart* warm_start() const
+  {
+    return this->warm_start_.get();
+  }
+
   const PageCacheSlot::Pool::Metrics& metrics_for_page_size(PageSize page_size) const
   {
     const i32 page_size_log2 = batt::log2_ceil(page_size);
@@ -261,6 +534,11 @@ class PageCache : public PageLoader
   using PageLayoutReaderMap =
       std::unordered_map<PageLayoutId, PageReaderFromFile, PageLayoutId::Hash>;
 
+  using PageCompressionMap =
+      std::unordered_map<PageLayoutId, PageCompression, PageLayoutId::Hash>;
+
+  using PagePriorityMap = std::unordered_map<PageLayoutId, PageCachePriority, PageLayoutId::Hash>;
+
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
   explicit PageCache(std::vector<PageArena>&& storage_pool,
@@ -276,6 +554,25 @@ class PageCache : public PageLoader
    */
   PageDeviceEntry* get_device_for_page(PageId page_id);
 
+  //----- --- -- -  -  -   -
+  /** \brief Returns the indices of `page_ids` (skipping invalid ones), stably sorted by device id;
+   * used by the batched operations to visit the pages one device at a time.
+   */
+  static std::vector<usize> indices_by_device(const Slice<const PageId>& page_ids);
+
+  //----- --- -- -  -  -   -
+  /** \brief Implements put_view/put_views once `view` has been validated and the device entry for
+   * its page has been found.
+   */
+  StatusOr<PinnedPage> put_view_on_device(PageDeviceEntry* entry,
+                                          std::shared_ptr<const PageView>&& view, u64 callers,
+                                          u64 job_id);
+
+  //----- --- -- -  -  -   -
+  /** \brief Implements purge/purge_pages once the device entry for `page_id` has been found.
+   */
+  void purge_on_device(PageDeviceEntry* entry, PageId page_id, u64 callers, u64 job_id);
+
   //----- --- -- -  -  -   -
   /** \brief Attempts to find the specified page (`page_id`) in the cache; if successful, the cache
    * slot is pinned (so it can't be evicted) and a pinned reference is returned.  Otherwise, we
@@ -291,9 +588,13 @@ class PageCache : public PageLoader
    *
    * \param ok_if_not_found Controls whether page-not-found log messages (WARNING) are emitted if
    * the page isn't found; ok_if_not_found == false -> emit log warnings, ... == true -> don't
+   *
+   * \param inserted If not nullptr, set to true if the page wasn't in the cache (so a read was
+   * started)
    */
   batt::StatusOr<PageCacheSlot::PinnedRef> find_page_in_cache(
-      PageId page_id, const Optional<PageLayoutId>& required_layout, OkIfNotFound ok_if_not_found);
+      PageId page_id, const Optional<PageLayoutId>& required_layout, OkIfNotFound ok_if_not_found,
+      bool* inserted = nullptr);
 
   //----- --- -- -  -  -   -
   /** \brief Populates the passed PageCacheSlot asynchronously by attempting to read the page from
@@ -309,6 +610,72 @@ class PageCache : public PageLoader
                                  const Optional<PageLayoutId>& required_layout,
                                  OkIfNotFound ok_if_not_found);
 
+  //----- --- -- -  -  -   -
+  /** \brief Returns a PageDevice read handler that parses the page data and sets the Latch value
+   * of the passed slot; used by `async_load_page_into_slot` and `get_pages`.
+   *
+   * The returned handler holds a pin on the slot until it is invoked.  The slot's cache priority is
+   * set to `priority` if present, otherwise to the priority of the page's layout.
+   */
+  PageDevice::ReadHandler make_page_read_handler(const PageCacheSlot::PinnedRef& pinned_slot,
+                                                 const Optional<PageLayoutId>& required_layout,
+                                                 OkIfNotFound ok_if_not_found,
+                                                 Optional<PageCachePriority> priority = None);
+
+  //----- --- -- -  -  -   -
+  /** \brief Loads the base page of the delta page image `delta` (see page_delta.hpp), then
+   * materializes the page and finishes loading it into the passed slot (`finish_page_load`).
+   */
+  void async_materialize_delta_page(PageCacheSlot::PinnedRef&& pinned_slot,
+                                    std::shared_ptr<const PageBuffer>&& delta,
+                                    const Optional<PageLayoutId>& required_layout,
+                                    Optional<PageCachePriority> priority);
+
+  //----- --- -- -  -  -   -
+  /** \brief Validates and parses the (uncompressed, materialized) contents of a page that has been
+   * read, and sets the Latch value of the passed slot; the second half of the handler returned by
+   * `make_page_read_handler`.  If the page was materialized from a delta image, `delta_base` and
+   * `delta_depth` are recorded in its PageView (see PageView::set_delta_base).
+   */
+  void finish_page_load(const PageCacheSlot::PinnedRef& pinned_slot,
+                        std::shared_ptr<const PageBuffer>&& page_data,
+                        const Optional<PageLayoutId>& required_layout,
+                        Optional<PageCachePriority> priority, PageId delta_base, u16 delta_depth);
+
+  //----- --- -- -  -  -   -
+  /** \brief Returns true if the checksum of the given page should be checked now that it has been
+   * read, according to PageCacheOptions::page_validation_policy().
+   */
+  bool should_validate_page_on_load(PageId page_id);
+
+  //----- --- -- -  -  -   -
+  /** \brief Records (for PageValidationPolicy::kFull and kFirstLoadOnly) whether the given page
+   * has been validated since it was last written.
+   */
+  void set_page_validated(PageId page_id, bool validated);
+
+  //----- --- -- -  -  -   -
+  /** \brief Implements prefetch_hint/prefetch_hints for a single page.
+   */
+  void prefetch_hint_with_priority(PageId page_id, PrefetchPriority priority);
+
+  //----- --- -- -  -  -   -
+  /** \brief Updates the prefetch hit count if the passed slot was loaded by `prefetch_hint` and
+   * this is the first time it has been used since then.
+   */
+  void note_page_used(const PageCacheSlot::PinnedRef& pinned_slot);
+
+  //----- --- -- -  -  -   -
+  /** \brief Queues the given page to have its filter built on the page filter builder task (if
+   * the page filter index is enabled and the page doesn't already have a filter).
+   */
+  void queue_page_filter_build(const std::shared_ptr<const PageView>& view);
+
+  //----- --- -- -  -  -   -
+  /** \brief The body of the page filter builder task.
+   */
+  void page_filter_builder_task_main();
+
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
   // The configuration passed in at creation time.
@@ -338,24 +705,52 @@ class PageCache : public PageLoader
   std::array<boost::intrusive_ptr<PageCacheSlot::Pool>, kMaxPageSizeLog2>
       cache_slot_pool_by_page_size_log2_;
 
+  // The pool shared by all page sizes, if PageCacheOptions::max_cache_bytes() is set.
+  //
+  boost::intrusive_ptr<PageCacheSlot::Pool> shared_cache_slot_pool_;
+
   // A thread-safe shared map from PageLayoutId to PageReader function; layouts must be registered
   // with the PageCache so that we trace references during page recycling (aka garbage collection).
   //
   std::shared_ptr<batt::Mutex<PageLayoutReaderMap>> page_readers_;
 
-  //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
-  // TODO [tastolfi 2021-09-08] We need something akin to the PageRecycler/PageAllocator to durably
-  // store page filters so we can cache those and do fast exclusion tests.  This may belong at a
-  // higher level, however...
+  // The layouts for which compression is enabled (see `set_page_compression`).
   //
-  //  bool update_page_filter(std::shared_ptr<PageFilter>&& new_filter);
-  //  void build_page_filter(PinnedPage&& page);
-  //  Slice<Mutex<std::shared_ptr<PageFilter>>> leaf_page_filters();
-  //  void page_filter_builder_task_main();
+  mutable batt::Mutex<PageCompressionMap> page_compression_;
+
+  // The layouts whose pages have a cache priority other than kNormal (see `set_page_priority`).
   //
-  //  Queue<PinnedPage<>> page_filter_build_queue_;
-  //  Task page_filter_builder_;
-  //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+  mutable batt::Mutex<PagePriorityMap> page_priority_;
+
+  // Checks cold pages in the background, under PageValidationPolicy::kBackgroundScrub.
+  //
+  std::unique_ptr<PageScrubber> scrubber_;
+
+  // Saves and restores the hot page list (see PageCacheOptions::warm_start_file).
+  //
+  std::unique_ptr<PageCacheWarmStart> warm_start_;
+
+  // Pages waiting for their filters to be built, and the number of them.
+  //
+  batt::Queue<std::shared_ptr<const PageView>> page_filter_build_queue_;
+  std::atomic<usize> page_filter_build_queue_depth_{0};
+
+  // Builds page filters for the page filter index (see PageCacheOptions::page_filter_index).
+  //
+  Optional<batt::Task> page_filter_builder_;
+
+  // Records every page lookup, if PageCacheOptions::page_cache_trace_file() is set.
+  //
+  std::unique_ptr<PageCacheTraceRecorder> trace_recorder_;
+
+  // Samples lookups by layout and key range, if PageCacheOptions::access_stats_sample_interval()
+  // is non-zero.
+  //
+  std::unique_ptr<PageCacheAccessStats> access_stats_;
+
+  // Maps page contents to page ids, if PageCacheOptions::dedup_index_max_entries() is non-zero.
+  //
+  std::unique_ptr<PageDedupIndex> dedup_index_;
 
   std::array<NewPageTracker, 16384> history_;
   std::atomic<isize> history_end_{0};
@@ -0,0 +1,725 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_cache.hpp>
+//
+#include <llfs/page_cache.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/memory_log_device.hpp>
+#include <llfs/memory_page_arena.hpp>
+#include <llfs/memory_page_cache.hpp>
+#include <llfs/opaque_page_view.hpp>
+#include <llfs/packed_page_header.hpp>
+#include <llfs/page_cache_job.hpp>
+#include <llfs/page_cache_options.hpp>
+#include <llfs/page_allocator.hpp>
+#include <llfs/page_filter.hpp>
+#include <llfs/page_id_factory.hpp>
+#include <llfs/page_write_op.hpp>
+#include <llfs/status_code.hpp>
+#include <llfs/testing/fake_page_device.hpp>
+
+#include <batteries/async/runtime.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//
+//  1. put_views inserts views for pages on different devices, in any order, and returns one
+//     pinned page per view in input order; each page can then be found in the cache without
+//     being loaded.
+//  2. put_views reports a view whose header has the wrong layout id, and a view whose layout isn't
+//     registered, without affecting the other views in the batch.
+//  3. purge_pages removes a batch of pages (on different devices) from the cache, leaves the
+//     others alone, and ignores invalid page ids.
+//  4. With PageCacheOptions::optimistic_reads on, try_read_page_optimistic reads a page once it has
+//     been loaded through get_page, without pinning it, and returns None for pages that aren't
+//     cached (or have been purged); with the default options it always returns None.
+//  5. With the page filter index on, the filter of a page written through a PageCacheJob is built
+//     in the background, and page_might_contain_key keeps answering from it after the page has
+//     been evicted, without loading the page; loading a page that has no filter builds one, and
+//     purge drops it.
+//  6. get_pages returns one result per id, in input order, for a batch that mixes cached pages
+//     and pages that have to be read, on both devices; the pages read are cached afterwards.
+//  7. get_pages reports invalid ids, ids for a device the cache doesn't have, pages that were
+//     never written, and pages whose layout has no reader, each in its own result, without
+//     affecting the other pages in the batch.
+//  8. write_page counts each write as in flight on its device until it completes, whether it
+//     succeeds or fails.
+
+using namespace llfs::int_types;
+
+constexpr llfs::PageSize kSmallPageSize{4096};
+constexpr llfs::PageSize kLargePageSize{8192};
+constexpr usize kPagesPerDevice = 4;
+
+// An opaque page whose layout is never registered with the cache.
+//
+class UnregisteredPageView : public llfs::OpaquePageView
+{
+ public:
+  static const llfs::PageLayoutId& page_layout_id() noexcept
+  {
+    static const llfs::PageLayoutId id_ = llfs::PageLayoutId::from_str("(unreg)");
+    return id_;
+  }
+
+  using llfs::OpaquePageView::OpaquePageView;
+
+  llfs::PageLayoutId get_page_layout_id() const override
+  {
+    return UnregisteredPageView::page_layout_id();
+  }
+};
+
+class PageCacheTest : public ::testing::Test
+{
+ public:
+  void SetUp() override
+  {
+    llfs::PageCacheOptions options = llfs::PageCacheOptions::with_default_values();
+    options.set_max_cached_pages_per_size(kSmallPageSize, kPagesPerDevice)
+        .set_max_cached_pages_per_size(kLargePageSize, kPagesPerDevice)
+        .set_optimistic_reads(true);
+
+    std::vector<llfs::PageArena> arenas;
+    arenas.emplace_back(llfs::make_memory_page_arena(batt::Runtime::instance().default_scheduler(),
+                                                     llfs::PageCount{kPagesPerDevice},
+                                                     kSmallPageSize, "Arena0", /*device_id=*/0));
+    arenas.emplace_back(llfs::make_memory_page_arena(batt::Runtime::instance().default_scheduler(),
+                                                     llfs::PageCount{kPagesPerDevice},
+                                                     kLargePageSize, "Arena1", /*device_id=*/1));
+
+    llfs::StatusOr<batt::SharedPtr<llfs::PageCache>> page_cache =
+        llfs::PageCache::make_shared(std::move(arenas), options);
+    ASSERT_TRUE(page_cache.ok()) << BATT_INSPECT(page_cache.status());
+
+    this->cache_ = std::move(*page_cache);
+
+    BATT_CHECK_OK(llfs::OpaquePageView::register_layout(*this->cache_));
+  }
+
+  // Returns the id of a page on the given device.
+  //
+  llfs::PageId page_id(llfs::page_device_id_int device_id, i64 physical_page)
+  {
+    return this->cache_->arena_for_device_id(device_id).device().page_ids().make_page_id(
+        physical_page, /*generation=*/1);
+  }
+
+  // Builds a view of a new page with id `page_id`, whose header claims the layout `layout_id`.
+  //
+  template <typename ViewT = llfs::OpaquePageView>
+  std::shared_ptr<const llfs::PageView> make_view(
+      llfs::PageId page_id, const llfs::PageLayoutId& layout_id = ViewT::page_layout_id())
+  {
+    const llfs::PageSize page_size =
+        this->cache_->arena_for_page_id(page_id).device().page_size();
+
+    std::shared_ptr<llfs::PageBuffer> buffer = llfs::PageBuffer::allocate(page_size, page_id);
+    llfs::mutable_page_header(buffer.get())->layout_id = layout_id;
+
+    return std::make_shared<ViewT>(std::move(buffer));
+  }
+
+  // Writes a page whose header claims the layout `layout_id` to its device, without caching it.
+  //
+  void write_to_device(llfs::PageId page_id,
+                       const llfs::PageLayoutId& layout_id = llfs::OpaquePageView::page_layout_id())
+  {
+    llfs::PageDevice& device = this->cache_->arena_for_page_id(page_id).device();
+
+    llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer = device.prepare(page_id);
+    ASSERT_TRUE(buffer.ok()) << BATT_INSPECT(buffer.status());
+    llfs::mutable_page_header(buffer->get())->layout_id = layout_id;
+
+    // MemoryPageDevice completes writes right away.
+    //
+    llfs::Optional<llfs::Status> result;
+    device.write(std::move(*buffer), [&result](llfs::Status status) {
+      result = status;
+    });
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result->ok()) << BATT_INSPECT(*result);
+  }
+
+  std::vector<llfs::StatusOr<llfs::PinnedPage>> get_pages(const std::vector<llfs::PageId>& page_ids)
+  {
+    return this->cache_->get_pages(llfs::as_slice(page_ids), /*required_layout=*/llfs::None,
+                                   llfs::PinPageToJob::kFalse, llfs::OkIfNotFound{true});
+  }
+
+  // Returns the cached view of the page, if there is one; never loads the page.
+  //
+  const llfs::PageView* find_cached(llfs::PageId page_id)
+  {
+    llfs::StatusOr<llfs::PinnedPage> pinned =
+        this->cache_->get_page(page_id, llfs::OkIfNotFound{true});
+    if (!pinned.ok()) {
+      return nullptr;
+    }
+    return pinned->get();
+  }
+
+  batt::SharedPtr<llfs::PageCache> cache_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST_F(PageCacheTest, PutViews)
+{
+  // Interleave the two devices, so the batch has to be regrouped.
+  //
+  const std::vector<llfs::PageId> page_ids{
+      this->page_id(1, 0), this->page_id(0, 0), this->page_id(1, 1),
+      this->page_id(0, 1), this->page_id(0, 2),
+  };
+
+  std::vector<std::shared_ptr<const llfs::PageView>> views;
+  std::vector<const llfs::PageView*> expected;
+  for (llfs::PageId id : page_ids) {
+    views.emplace_back(this->make_view(id));
+    expected.emplace_back(views.back().get());
+  }
+
+  std::vector<llfs::StatusOr<llfs::PinnedPage>> pinned = this->cache_->put_views(
+      llfs::as_slice(views), llfs::Caller::Unknown, /*job_id=*/0);
+
+  ASSERT_EQ(pinned.size(), page_ids.size());
+  for (usize i = 0; i < page_ids.size(); ++i) {
+    ASSERT_TRUE(pinned[i].ok()) << BATT_INSPECT(i) << BATT_INSPECT(pinned[i].status());
+    EXPECT_EQ(pinned[i]->get(), expected[i]);
+    EXPECT_EQ(pinned[i]->page_id(), page_ids[i]);
+    EXPECT_EQ(views[i], nullptr) << "the views should be moved into the cache";
+  }
+
+  pinned.clear();
+
+  // The pages were never written, so finding them at all means they came from the cache.
+  //
+  for (usize i = 0; i < page_ids.size(); ++i) {
+    EXPECT_EQ(this->find_cached(page_ids[i]), expected[i]) << BATT_INSPECT(i);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST_F(PageCacheTest, PutViewsReportsBadViews)
+{
+  const llfs::PageId good_id = this->page_id(0, 0);
+  const llfs::PageId mislabeled_id = this->page_id(1, 0);
+  const llfs::PageId unregistered_id = this->page_id(0, 1);
+
+  std::vector<std::shared_ptr<const llfs::PageView>> views{
+      this->make_view(good_id),
+      this->make_view(mislabeled_id, UnregisteredPageView::page_layout_id()),
+      this->make_view<UnregisteredPageView>(unregistered_id),
+  };
+
+  std::vector<llfs::StatusOr<llfs::PinnedPage>> pinned = this->cache_->put_views(
+      llfs::as_slice(views), llfs::Caller::Unknown, /*job_id=*/0);
+
+  ASSERT_EQ(pinned.size(), 3u);
+
+  EXPECT_TRUE(pinned[0].ok()) << BATT_INSPECT(pinned[0].status());
+  EXPECT_EQ(pinned[1].status(), llfs::make_status(llfs::StatusCode::kPageHeaderBadLayoutId));
+  EXPECT_EQ(pinned[2].status(), llfs::make_status(llfs::StatusCode::kPutViewUnknownLayoutId));
+
+  pinned.clear();
+
+  EXPECT_NE(this->find_cached(good_id), nullptr);
+  EXPECT_EQ(this->find_cached(mislabeled_id), nullptr);
+  EXPECT_EQ(this->find_cached(unregistered_id), nullptr);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 3.
+//
+TEST_F(PageCacheTest, PurgePages)
+{
+  const std::vector<llfs::PageId> page_ids{
+      this->page_id(0, 0), this->page_id(1, 0), this->page_id(0, 1),
+      this->page_id(1, 1), this->page_id(0, 2),
+  };
+
+  std::vector<std::shared_ptr<const llfs::PageView>> views;
+  for (llfs::PageId id : page_ids) {
+    views.emplace_back(this->make_view(id));
+  }
+  {
+    std::vector<llfs::StatusOr<llfs::PinnedPage>> pinned = this->cache_->put_views(
+        llfs::as_slice(views), llfs::Caller::Unknown, /*job_id=*/0);
+    for (const llfs::StatusOr<llfs::PinnedPage>& page : pinned) {
+      ASSERT_TRUE(page.ok()) << BATT_INSPECT(page.status());
+    }
+  }
+
+  const std::vector<llfs::PageId> to_purge{
+      page_ids[3],
+      llfs::PageId{},
+      page_ids[0],
+      page_ids[2],
+  };
+  this->cache_->purge_pages(llfs::as_slice(to_purge), llfs::Caller::Unknown, /*job_id=*/0);
+
+  EXPECT_EQ(this->find_cached(page_ids[0]), nullptr);
+  EXPECT_NE(this->find_cached(page_ids[1]), nullptr);
+  EXPECT_EQ(this->find_cached(page_ids[2]), nullptr);
+  EXPECT_EQ(this->find_cached(page_ids[3]), nullptr);
+  EXPECT_NE(this->find_cached(page_ids[4]), nullptr);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 4.
+//
+TEST_F(PageCacheTest, TryReadPageOptimistic)
+{
+  const llfs::PageId page_id = this->page_id(1, 2);
+  const llfs::PageId other_id = this->page_id(0, 3);
+
+  const auto read_page_id = [](const llfs::PageView& view) {
+    return view.page_id();
+  };
+
+  std::vector<std::shared_ptr<const llfs::PageView>> views{this->make_view(page_id)};
+  {
+    std::vector<llfs::StatusOr<llfs::PinnedPage>> pinned = this->cache_->put_views(
+        llfs::as_slice(views), llfs::Caller::Unknown, /*job_id=*/0);
+    ASSERT_TRUE(pinned[0].ok()) << BATT_INSPECT(pinned[0].status());
+  }
+
+  // put_views doesn't publish the view; get_page does.
+  //
+  EXPECT_EQ(this->cache_->try_read_page_optimistic(page_id, read_page_id), llfs::None);
+
+  ASSERT_NE(this->find_cached(page_id), nullptr);
+
+  EXPECT_EQ(this->cache_->try_read_page_optimistic(page_id, read_page_id),
+            llfs::Optional<llfs::PageId>{page_id});
+
+  EXPECT_EQ(this->cache_->try_read_page_optimistic(other_id, read_page_id), llfs::None);
+  EXPECT_EQ(this->cache_->try_read_page_optimistic(llfs::PageId{}, read_page_id), llfs::None);
+
+  const std::vector<llfs::PageId> to_purge{page_id};
+  this->cache_->purge_pages(llfs::as_slice(to_purge), llfs::Caller::Unknown, /*job_id=*/0);
+
+  EXPECT_EQ(this->cache_->try_read_page_optimistic(page_id, read_page_id), llfs::None);
+
+  // By default, get_page doesn't publish anything.
+  //
+  batt::SharedPtr<llfs::PageCache> default_cache = llfs::make_memory_page_cache(
+      batt::Runtime::instance().default_scheduler(),
+      /*arena_sizes=*/{{llfs::PageCount{kPagesPerDevice}, kSmallPageSize}},
+      llfs::MaxRefsPerPage{1});
+  ASSERT_TRUE(llfs::OpaquePageView::register_layout(*default_cache).ok());
+
+  const llfs::PageId default_id =
+      default_cache->arena_for_device_id(0).device().page_ids().make_page_id(1, /*generation=*/1);
+  {
+    std::shared_ptr<llfs::PageBuffer> buffer =
+        llfs::PageBuffer::allocate(kSmallPageSize, default_id);
+    llfs::mutable_page_header(buffer.get())->layout_id = llfs::OpaquePageView::page_layout_id();
+
+    std::vector<std::shared_ptr<const llfs::PageView>> default_views{
+        std::make_shared<llfs::OpaquePageView>(std::move(buffer))};
+    std::vector<llfs::StatusOr<llfs::PinnedPage>> pinned = default_cache->put_views(
+        llfs::as_slice(default_views), llfs::Caller::Unknown, /*job_id=*/0);
+    ASSERT_TRUE(pinned[0].ok()) << BATT_INSPECT(pinned[0].status());
+  }
+  ASSERT_TRUE(default_cache->get_page(default_id, llfs::OkIfNotFound{false}).ok());
+
+  EXPECT_EQ(default_cache->try_read_page_optimistic(default_id, read_page_id), llfs::None);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+// A filter that contains exactly one key.
+//
+class ExactKeyPageFilter : public llfs::PageFilter
+{
+ public:
+  explicit ExactKeyPageFilter(llfs::PageId page_id, std::string key) noexcept
+      : llfs::PageFilter{page_id}
+      , key_{std::move(key)}
+  {
+  }
+
+  bool might_contain_key(const llfs::KeyView& key) override
+  {
+    return key == this->key_;
+  }
+
+ private:
+  std::string key_;
+};
+
+// A page that holds a single key: a length byte, then the key, at the start of its payload.
+//
+class KeyedPageView : public llfs::OpaquePageView
+{
+ public:
+  static const llfs::PageLayoutId& page_layout_id() noexcept
+  {
+    static const llfs::PageLayoutId id_ = llfs::PageLayoutId::from_str("(keyed)");
+    return id_;
+  }
+
+  static llfs::PageReader page_reader() noexcept
+  {
+    return [](std::shared_ptr<const llfs::PageBuffer> buffer)
+               -> llfs::StatusOr<std::shared_ptr<const llfs::PageView>> {
+      return {std::make_shared<KeyedPageView>(std::move(buffer))};
+    };
+  }
+
+  static void pack_key(llfs::MutableBuffer payload, const std::string& key)
+  {
+    BATT_CHECK_LT(key.size(), std::min<usize>(payload.size(), 256));
+
+    u8* const bytes = static_cast<u8*>(payload.data());
+    bytes[0] = static_cast<u8>(key.size());
+    std::memcpy(bytes + 1, key.data(), key.size());
+  }
+
+  using llfs::OpaquePageView::OpaquePageView;
+
+  llfs::PageLayoutId get_page_layout_id() const override
+  {
+    return KeyedPageView::page_layout_id();
+  }
+
+  std::shared_ptr<llfs::PageFilter> build_filter() const override
+  {
+    const char* const bytes = static_cast<const char*>(this->const_payload().data());
+    return std::make_shared<ExactKeyPageFilter>(
+        this->page_id(), std::string(bytes + 1, static_cast<u8>(bytes[0])));
+  }
+};
+
+class PageFilterIndexTest : public ::testing::Test
+{
+ public:
+  static constexpr usize kPageCount = 8;
+  static constexpr usize kMaxCachedPages = 2;
+
+  void SetUp() override
+  {
+    llfs::PageCacheOptions options = llfs::PageCacheOptions::with_default_values();
+    options.set_max_cached_pages_per_size(kSmallPageSize, kMaxCachedPages)
+        .set_page_filter_index(true);
+
+    std::vector<llfs::PageArena> arenas;
+    arenas.emplace_back(llfs::make_memory_page_arena(batt::Runtime::instance().default_scheduler(),
+                                                     llfs::PageCount{kPageCount}, kSmallPageSize,
+                                                     "Arena0", /*device_id=*/0));
+
+    llfs::StatusOr<batt::SharedPtr<llfs::PageCache>> page_cache =
+        llfs::PageCache::make_shared(std::move(arenas), options);
+    ASSERT_TRUE(page_cache.ok()) << BATT_INSPECT(page_cache.status());
+
+    this->cache_ = std::move(*page_cache);
+
+    ASSERT_TRUE(this->cache_
+                    ->register_page_reader(KeyedPageView::page_layout_id(), __FILE__, __LINE__,
+                                           KeyedPageView::page_reader())
+                    .ok());
+  }
+
+  // Writes a page holding `key` to the device through a job; the page stays in the cache.
+  //
+  llfs::PageId write_page(const std::string& key)
+  {
+    std::unique_ptr<llfs::PageCacheJob> job = this->cache_->new_job();
+
+    llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer =
+        job->new_page(kSmallPageSize, batt::WaitForResource::kFalse,
+                      KeyedPageView::page_layout_id(), llfs::Caller::Unknown,
+                      /*cancel_token=*/llfs::None);
+    BATT_CHECK_OK(buffer);
+
+    const llfs::PageId page_id = (*buffer)->page_id();
+    KeyedPageView::pack_key((*buffer)->mutable_payload(), key);
+
+    BATT_CHECK_OK(
+        job->pin_new(std::make_shared<KeyedPageView>(std::move(*buffer)), llfs::Caller::Unknown));
+    BATT_CHECK_OK(job->stream_new_pages());
+
+    return page_id;
+  }
+
+  // Waits (up to a few seconds) for the filter of the given page to be built.
+  //
+  std::shared_ptr<llfs::PageFilter> await_filter(llfs::PageId page_id)
+  {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+    std::shared_ptr<llfs::PageFilter> filter = this->cache_->find_page_filter(page_id);
+    while (filter == nullptr && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      filter = this->cache_->find_page_filter(page_id);
+    }
+    return filter;
+  }
+
+  llfs::PageCache::PageDeviceEntry& device_entry(llfs::PageId page_id) const
+  {
+    for (llfs::PageCache::PageDeviceEntry* entry : this->cache_->all_devices()) {
+      if (entry->arena.id() == llfs::PageIdFactory::get_device_id(page_id)) {
+        return *entry;
+      }
+    }
+    BATT_PANIC() << "no device for " << BATT_INSPECT(page_id);
+    BATT_UNREACHABLE();
+  }
+
+  bool is_cached(llfs::PageId page_id) const
+  {
+    const std::vector<llfs::PageId> hot_pages = this->cache_->hot_pages(/*max_count=*/0);
+    return std::find(hot_pages.begin(), hot_pages.end(), page_id) != hot_pages.end();
+  }
+
+  batt::SharedPtr<llfs::PageCache> cache_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 5.
+//
+TEST_F(PageFilterIndexTest, FiltersOutliveCachedPages)
+{
+  const llfs::PageId apple_id = this->write_page("apple");
+
+  ASSERT_NE(this->await_filter(apple_id), nullptr);
+  EXPECT_TRUE(this->cache_->page_might_contain_key(apple_id, "apple"));
+  EXPECT_FALSE(this->cache_->page_might_contain_key(apple_id, "banana"));
+
+  // Push the page out of the (two page) cache by writing others.
+  //
+  std::vector<llfs::PageId> other_ids;
+  while (this->is_cached(apple_id) && other_ids.size() + 1 < kPageCount) {
+    other_ids.emplace_back(this->write_page("other"));
+  }
+  ASSERT_FALSE(this->is_cached(apple_id)) << BATT_INSPECT(other_ids.size());
+
+  // The filter still answers, and asking doesn't load the page.
+  //
+  EXPECT_NE(this->cache_->find_page_filter(apple_id), nullptr);
+  EXPECT_TRUE(this->cache_->page_might_contain_key(apple_id, "apple"));
+  EXPECT_FALSE(this->cache_->page_might_contain_key(apple_id, "banana"));
+  EXPECT_FALSE(this->is_cached(apple_id));
+
+  for (llfs::PageId id : other_ids) {
+    ASSERT_NE(this->await_filter(id), nullptr);
+    EXPECT_FALSE(this->cache_->page_might_contain_key(id, "apple"));
+    EXPECT_TRUE(this->cache_->page_might_contain_key(id, "other"));
+  }
+
+  // Forget the filter and drop the page from the cache (as if the cache had been restarted, since
+  // filters aren't persisted here); purge() can't be used for this, since it marks the page dead.
+  // Loading the page from the device then builds its filter again.
+  //
+  {
+    llfs::PageCache::PageDeviceEntry& entry = this->device_entry(apple_id);
+    entry.cache.erase(apple_id);
+    entry.page_filters->erase(apple_id);
+  }
+  EXPECT_EQ(this->cache_->find_page_filter(apple_id), nullptr);
+  EXPECT_TRUE(this->cache_->page_might_contain_key(apple_id, "banana"));
+  {
+    llfs::StatusOr<llfs::PinnedPage> loaded =
+        this->cache_->get_page(apple_id, llfs::OkIfNotFound{false});
+    ASSERT_TRUE(loaded.ok()) << BATT_INSPECT(loaded.status());
+  }
+
+  ASSERT_NE(this->await_filter(apple_id), nullptr);
+  EXPECT_TRUE(this->cache_->page_might_contain_key(apple_id, "apple"));
+  EXPECT_FALSE(this->cache_->page_might_contain_key(apple_id, "banana"));
+
+  // Purging the page drops its filter; with no filter, any key might be there.
+  //
+  this->cache_->purge(apple_id, llfs::Caller::Unknown, /*job_id=*/0);
+
+  EXPECT_EQ(this->cache_->find_page_filter(apple_id), nullptr);
+  EXPECT_TRUE(this->cache_->page_might_contain_key(apple_id, "banana"));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 6.
+//
+TEST_F(PageCacheTest, GetPagesMixesHitsAndMisses)
+{
+  const std::vector<llfs::PageId> cached_ids{this->page_id(0, 0), this->page_id(1, 0)};
+  const std::vector<llfs::PageId> stored_ids{this->page_id(1, 1), this->page_id(0, 1),
+                                             this->page_id(0, 2)};
+
+  std::vector<std::shared_ptr<const llfs::PageView>> views;
+  std::vector<const llfs::PageView*> cached_views;
+  for (llfs::PageId id : cached_ids) {
+    views.emplace_back(this->make_view(id));
+    cached_views.emplace_back(views.back().get());
+  }
+  {
+    std::vector<llfs::StatusOr<llfs::PinnedPage>> pinned = this->cache_->put_views(
+        llfs::as_slice(views), llfs::Caller::Unknown, /*job_id=*/0);
+    for (const llfs::StatusOr<llfs::PinnedPage>& page : pinned) {
+      ASSERT_TRUE(page.ok()) << BATT_INSPECT(page.status());
+    }
+  }
+  for (llfs::PageId id : stored_ids) {
+    this->write_to_device(id);
+  }
+
+  // Interleave hits and misses on both devices.
+  //
+  const std::vector<llfs::PageId> page_ids{
+      stored_ids[0], cached_ids[0], stored_ids[1], cached_ids[1], stored_ids[2],
+  };
+
+  std::vector<llfs::StatusOr<llfs::PinnedPage>> pages = this->get_pages(page_ids);
+
+  ASSERT_EQ(pages.size(), page_ids.size());
+  for (usize i = 0; i < page_ids.size(); ++i) {
+    ASSERT_TRUE(pages[i].ok()) << BATT_INSPECT(i) << BATT_INSPECT(pages[i].status());
+    EXPECT_EQ(pages[i]->page_id(), page_ids[i]) << BATT_INSPECT(i);
+  }
+
+  // The hits are the views that were already cached...
+  //
+  EXPECT_EQ(pages[1]->get(), cached_views[0]);
+  EXPECT_EQ(pages[3]->get(), cached_views[1]);
+
+  // ...and the misses are cached now.
+  //
+  for (usize i : {0, 2, 4}) {
+    EXPECT_EQ(this->find_cached(page_ids[i]), pages[i]->get()) << BATT_INSPECT(i);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 7.
+//
+TEST_F(PageCacheTest, GetPagesReportsErrorsPerPage)
+{
+  const llfs::PageId cached_id = this->page_id(1, 2);
+  const llfs::PageId stored_id = this->page_id(0, 3);
+  const llfs::PageId never_written_id = this->page_id(1, 3);
+  const llfs::PageId unreadable_id = this->page_id(0, 2);
+  const llfs::PageId unknown_device_id =
+      llfs::PageIdFactory{llfs::PageCount{kPagesPerDevice}, /*page_device_id=*/7}.make_page_id(
+          0, /*generation=*/1);
+
+  std::vector<std::shared_ptr<const llfs::PageView>> views{this->make_view(cached_id)};
+  const llfs::PageView* const cached_view = views[0].get();
+  {
+    std::vector<llfs::StatusOr<llfs::PinnedPage>> pinned = this->cache_->put_views(
+        llfs::as_slice(views), llfs::Caller::Unknown, /*job_id=*/0);
+    ASSERT_TRUE(pinned[0].ok()) << BATT_INSPECT(pinned[0].status());
+  }
+  this->write_to_device(stored_id);
+  this->write_to_device(unreadable_id, UnregisteredPageView::page_layout_id());
+
+  const std::vector<llfs::PageId> page_ids{
+      unknown_device_id, cached_id, llfs::PageId{}, never_written_id, stored_id, unreadable_id,
+  };
+
+  std::vector<llfs::StatusOr<llfs::PinnedPage>> pages = this->get_pages(page_ids);
+
+  ASSERT_EQ(pages.size(), page_ids.size());
+
+  EXPECT_EQ(pages[0].status(), llfs::make_status(llfs::StatusCode::kPageIdInvalid));
+  EXPECT_EQ(pages[2].status(), llfs::make_status(llfs::StatusCode::kPageIdInvalid));
+  EXPECT_EQ(pages[3].status(), llfs::Status{batt::StatusCode::kNotFound});
+  EXPECT_EQ(pages[5].status(), llfs::make_status(llfs::StatusCode::kNoReaderForPageViewType));
+
+  for (usize i : {1, 4}) {
+    ASSERT_TRUE(pages[i].ok()) << BATT_INSPECT(i) << BATT_INSPECT(pages[i].status());
+    EXPECT_EQ(pages[i]->page_id(), page_ids[i]) << BATT_INSPECT(i);
+  }
+  EXPECT_EQ(pages[1]->get(), cached_view);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 8.
+//
+TEST(PageCacheWriteTest, WritesInFlight)
+{
+  // A device whose writes complete only when the test says so.
+  //
+  auto fake_device = std::make_unique<llfs::testing::FakePageDevice>();
+  fake_device->page_id_factory =
+      llfs::PageIdFactory{llfs::PageCount{kPagesPerDevice}, /*page_device_id=*/0};
+  fake_device->device_page_size = kSmallPageSize;
+
+  llfs::testing::FakePageDevice* const device = fake_device.get();
+  const llfs::PageIdFactory page_ids = device->page_ids();
+
+  const auto log_size = llfs::PageAllocator::calculate_log_size(page_ids.get_physical_page_count(),
+                                                                llfs::kDefaultMaxPoolAttachments);
+
+  std::vector<llfs::PageArena> arenas;
+  arenas.emplace_back(
+      std::move(fake_device),
+      llfs::PageAllocator::recover_or_die(
+          llfs::PageAllocatorRuntimeOptions{batt::Runtime::instance().default_scheduler(),
+                                            "FakeArena"},
+          page_ids, *std::make_unique<llfs::MemoryLogDeviceFactory>(log_size)));
+
+  llfs::PageCacheOptions options = llfs::PageCacheOptions::with_default_values();
+  options.set_max_cached_pages_per_size(kSmallPageSize, kPagesPerDevice);
+
+  llfs::StatusOr<batt::SharedPtr<llfs::PageCache>> cache =
+      llfs::PageCache::make_shared(std::move(arenas), options);
+  ASSERT_TRUE(cache.ok()) << BATT_INSPECT(cache.status());
+
+  constexpr usize kNumWrites = 3;
+
+  batt::Watch<i64> done_counter{0};
+  std::unique_ptr<llfs::PageWriteOp[]> ops =
+      llfs::PageWriteOp::allocate_array(kNumWrites, done_counter);
+
+  for (usize i = 0; i < kNumWrites; ++i) {
+    ops[i].page_id = page_ids.make_page_id(i, /*generation=*/1);
+
+    llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer = device->prepare(ops[i].page_id);
+    ASSERT_TRUE(buffer.ok()) << BATT_INSPECT(buffer.status());
+
+    (*cache)->write_page(std::move(*buffer), &ops[i]);
+  }
+
+  EXPECT_EQ((*cache)->page_writes_in_flight(0), kNumWrites);
+  ASSERT_EQ(device->pending_ops.size(), kNumWrites);
+
+  // Fail the middle write first, then let the others succeed.
+  //
+  device->pending_ops[1](llfs::Status{batt::StatusCode::kInternal});
+
+  EXPECT_EQ((*cache)->page_writes_in_flight(0), kNumWrites - 1);
+  EXPECT_EQ(ops[1].result, llfs::Status{batt::StatusCode::kInternal});
+
+  device->pending_ops[0](llfs::OkStatus());
+  device->pending_ops[2](llfs::OkStatus());
+
+  EXPECT_EQ((*cache)->page_writes_in_flight(0), 0u);
+  EXPECT_EQ(done_counter.get_value(), static_cast<i64>(kNumWrites));
+  EXPECT_TRUE(ops[0].result.ok()) << BATT_INSPECT(ops[0].result);
+  EXPECT_TRUE(ops[2].result.ok()) << BATT_INSPECT(ops[2].result);
+}
+
+}  // namespace
@@ -0,0 +1,198 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_cache_access_stats.hpp>
+//
+
+#include <llfs/page_view.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/stream_util.hpp>
+
+#include <algorithm>
+
+namespace llfs {
+
+namespace {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void add_lookup(PageCacheAccessCounts* counts, bool hit, u64 wait_usec)
+{
+  if (hit) {
+    counts->hits += 1;
+  } else {
+    counts->misses += 1;
+  }
+  counts->total_wait_usec += wait_usec;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::string_view key_prefix(const KeyView& key, usize prefix_size)
+{
+  return key.substr(0, prefix_size);
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ PageCacheAccessStats::PageCacheAccessStats(const Options& options) noexcept
+    : options_{options}
+{
+  BATT_CHECK_NE(this->options_.sample_interval, 0u);
+
+  this->key_ranges_.reserve(this->options_.max_key_ranges);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheAccessStats::record(const PageView& view, bool hit,
+                                  std::chrono::steady_clock::time_point start_time)
+{
+  const auto now = std::chrono::steady_clock::now();
+  const u64 wait_usec = static_cast<u64>(std::max<i64>(
+      0, std::chrono::duration_cast<std::chrono::microseconds>(now - start_time).count()));
+
+  this->record(view.get_page_layout_id(), view.min_key(), view.max_key(), hit, wait_usec);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheAccessStats::record(const PageLayoutId& layout_id, const Optional<KeyView>& min_key,
+                                  const Optional<KeyView>& max_key, bool hit, u64 wait_usec)
+{
+  std::unique_lock<std::mutex> lock{this->mutex_};
+
+  {
+    auto iter = std::find_if(this->layouts_.begin(), this->layouts_.end(),
+                             [&layout_id](const PageCacheLayoutAccessStats& stats) {
+                               return stats.layout_id == layout_id;
+                             });
+    if (iter == this->layouts_.end()) {
+      iter = this->layouts_.insert(this->layouts_.end(), PageCacheLayoutAccessStats{
+                                                              .layout_id = layout_id,
+                                                              .counts = {},
+                                                          });
+    }
+    add_lookup(&iter->counts, hit, wait_usec);
+  }
+
+  if (!min_key || !max_key || this->options_.max_key_ranges == 0) {
+    return;
+  }
+
+  const std::string_view min_prefix = key_prefix(*min_key, this->options_.key_prefix_size);
+  const std::string_view max_prefix = key_prefix(*max_key, this->options_.key_prefix_size);
+
+  auto iter = std::find_if(this->key_ranges_.begin(), this->key_ranges_.end(),
+                           [&](const PageCacheKeyRangeAccessStats& stats) {
+                             return stats.layout_id == layout_id &&
+                                    stats.min_key_prefix == min_prefix &&
+                                    stats.max_key_prefix == max_prefix;
+                           });
+
+  if (iter != this->key_ranges_.end()) {
+    add_lookup(&iter->counts, hit, wait_usec);
+    return;
+  }
+
+  if (this->key_ranges_.size() < this->options_.max_key_ranges) {
+    PageCacheKeyRangeAccessStats& stats = this->key_ranges_.emplace_back();
+    stats.layout_id = layout_id;
+    stats.min_key_prefix = min_prefix;
+    stats.max_key_prefix = max_prefix;
+    add_lookup(&stats.counts, hit, wait_usec);
+    return;
+  }
+
+  // The table is full; only misses may displace a tracked range (the one with the fewest misses),
+  // whose miss count the new range inherits.
+  //
+  if (hit) {
+    return;
+  }
+
+  iter = std::min_element(this->key_ranges_.begin(), this->key_ranges_.end(),
+                          [](const PageCacheKeyRangeAccessStats& l,
+                             const PageCacheKeyRangeAccessStats& r) {
+                            return l.counts.misses < r.counts.misses;
+                          });
+
+  const u64 inherited_misses = iter->counts.misses;
+
+  iter->layout_id = layout_id;
+  iter->min_key_prefix = min_prefix;
+  iter->max_key_prefix = max_prefix;
+  iter->counts = PageCacheAccessCounts{};
+  iter->counts.misses = inherited_misses;
+  iter->max_miss_overcount = inherited_misses;
+  add_lookup(&iter->counts, hit, wait_usec);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCacheAccessReport PageCacheAccessStats::report() const
+{
+  PageCacheAccessReport report;
+  report.sample_interval = this->options_.sample_interval;
+  {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+
+    report.layouts = this->layouts_;
+    report.key_ranges = this->key_ranges_;
+  }
+
+  std::stable_sort(report.layouts.begin(), report.layouts.end(),
+                   [](const PageCacheLayoutAccessStats& l, const PageCacheLayoutAccessStats& r) {
+                     return l.counts.misses > r.counts.misses;
+                   });
+
+  std::stable_sort(report.key_ranges.begin(), report.key_ranges.end(),
+                   [](const PageCacheKeyRangeAccessStats& l,
+                      const PageCacheKeyRangeAccessStats& r) {
+                     return l.counts.misses > r.counts.misses;
+                   });
+
+  return report;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheAccessStats::reset()
+{
+  std::unique_lock<std::mutex> lock{this->mutex_};
+
+  this->layouts_.clear();
+  this->key_ranges_.clear();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, const PageCacheAccessReport& t)
+{
+  out << "PageCacheAccessReport{.sample_interval=" << t.sample_interval << ", .layouts={";
+  for (const PageCacheLayoutAccessStats& stats : t.layouts) {
+    out << "{.layout_id=" << stats.layout_id << ", .hits=" << stats.counts.hits
+        << ", .misses=" << stats.counts.misses
+        << ", .total_wait_usec=" << stats.counts.total_wait_usec << "},";
+  }
+  out << "}, .key_ranges={";
+  for (const PageCacheKeyRangeAccessStats& stats : t.key_ranges) {
+    out << "{.layout_id=" << stats.layout_id
+        << ", .min_key_prefix=" << batt::c_str_literal(stats.min_key_prefix)
+        << ", .max_key_prefix=" << batt::c_str_literal(stats.max_key_prefix)
+        << ", .hits=" << stats.counts.hits << ", .misses=" << stats.counts.misses
+        << ", .max_miss_overcount=" << stats.max_miss_overcount
+        << ", .total_wait_usec=" << stats.counts.total_wait_usec << "},";
+  }
+  return out << "},}";
+}
+
+}  // namespace llfs
@@ -0,0 +1,175 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_CACHE_ACCESS_STATS_HPP
+#define LLFS_PAGE_CACHE_ACCESS_STATS_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/key.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/page_layout_id.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace llfs {
+
+class PageView;
+
+/** \brief Counts of the sampled lookups attributed to one layout or key range.
+ */
+struct PageCacheAccessCounts {
+  u64 hits = 0;
+  u64 misses = 0;
+
+  /** \brief The total time callers spent waiting for these pages, in microseconds.
+   */
+  u64 total_wait_usec = 0;
+
+  u64 lookups() const
+  {
+    return this->hits + this->misses;
+  }
+};
+
+/** \brief Sampled lookups of pages with a given layout.
+ */
+struct PageCacheLayoutAccessStats {
+  PageLayoutId layout_id;
+  PageCacheAccessCounts counts;
+};
+
+/** \brief Sampled lookups of pages covering a given key range (truncated to a prefix of
+ * PageCacheAccessStats::Options::key_prefix_size bytes).
+ */
+struct PageCacheKeyRangeAccessStats {
+  PageLayoutId layout_id;
+  std::string min_key_prefix;
+  std::string max_key_prefix;
+  PageCacheAccessCounts counts;
+
+  /** \brief An upper bound on how much `counts.misses` overstates the true number of sampled
+   * misses for this range; the table is a Space-Saving sketch, so a range that displaced another
+   * one inherits its count.  Hits are only counted while the range is in the table.
+   */
+  u64 max_miss_overcount = 0;
+};
+
+/** \brief A snapshot of PageCacheAccessStats.
+ */
+struct PageCacheAccessReport {
+  /** \brief One of every `sample_interval` lookups was sampled.
+   */
+  u32 sample_interval = 0;
+
+  /** \brief Ordered by descending number of misses.
+   */
+  std::vector<PageCacheLayoutAccessStats> layouts;
+
+  /** \brief The key ranges that caused the most (sampled) misses, in descending order.
+   */
+  std::vector<PageCacheKeyRangeAccessStats> key_ranges;
+};
+
+std::ostream& operator<<(std::ostream& out, const PageCacheAccessReport& t);
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Attributes a sample of PageCache lookups (hit or miss, and how long the caller waited) to
+ * the layout and key range (PageView::min_key/max_key) of the page, so that the key ranges causing
+ * the most cache misses can be found without recording every lookup (compare
+ * PageCacheTraceRecorder).
+ *
+ * Key ranges are tracked in a fixed-size Space-Saving heavy-hitters table weighted by misses: a
+ * miss on an untracked range replaces the tracked range with the fewest misses.  Every range whose
+ * share of the sampled misses is more than 1/max_key_ranges is guaranteed to be in the table.
+ *
+ * `should_sample` is a single relaxed atomic increment; only sampled lookups take the mutex.
+ */
+class PageCacheAccessStats
+{
+ public:
+  struct Options {
+    /** \brief Sample one of every this many lookups; must be non-zero.
+     */
+    u32 sample_interval;
+
+    /** \brief The size of the key range table.
+     */
+    usize max_key_ranges;
+
+    /** \brief Page min/max keys are truncated to this many bytes, so that pages covering nearby
+     * parts of the key space are counted together.
+     */
+    usize key_prefix_size;
+  };
+
+  explicit PageCacheAccessStats(const Options& options) noexcept;
+
+  PageCacheAccessStats(const PageCacheAccessStats&) = delete;
+  PageCacheAccessStats& operator=(const PageCacheAccessStats&) = delete;
+
+  const Options& options() const
+  {
+    return this->options_;
+  }
+
+  /** \brief Returns true iff the current lookup should be passed to `record`.
+   */
+  bool should_sample() noexcept
+  {
+    return this->lookup_count_.fetch_add(1, std::memory_order_relaxed) %
+               this->options_.sample_interval ==
+           0;
+  }
+
+  /** \brief Records a sampled lookup of `view` that started at `start_time`.
+   */
+  void record(const PageView& view, bool hit, std::chrono::steady_clock::time_point start_time);
+
+  /** \brief Records a sampled lookup of a page with the given layout and keys.  Pages without keys
+   * are only counted in the per-layout stats.
+   */
+  void record(const PageLayoutId& layout_id, const Optional<KeyView>& min_key,
+              const Optional<KeyView>& max_key, bool hit, u64 wait_usec);
+
+  /** \brief Returns the current stats.
+   */
+  PageCacheAccessReport report() const;
+
+  /** \brief Clears all stats.
+   */
+  void reset();
+
+ private:
+  const Options options_;
+
+  std::atomic<u64> lookup_count_{0};
+
+  // Protects everything below.
+  //
+  mutable std::mutex mutex_;
+
+  // There are only a handful of layouts, so these are searched linearly.
+  //
+  std::vector<PageCacheLayoutAccessStats> layouts_;
+
+  // The Space-Saving table (at most `options_.max_key_ranges` entries).
+  //
+  std::vector<PageCacheKeyRangeAccessStats> key_ranges_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_PAGE_CACHE_ACCESS_STATS_HPP
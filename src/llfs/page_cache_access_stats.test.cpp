@@ -0,0 +1,159 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_cache_access_stats.hpp>
+//
+#include <llfs/page_cache_access_stats.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace {
+
+// Test Plan:
+//
+//  1. (Sampling) should_sample returns true for exactly one of every `sample_interval` calls.
+//  2. (LayoutsAndRanges) Lookups are attributed to their layout, and to their key range (truncated
+//     to the configured prefix size); pages without keys only count towards their layout.
+//  3. (HeavyHitters) With many more distinct ranges than table entries, the ranges that cause most
+//     of the misses are reported first, with true miss counts within the reported overcount.
+
+using llfs::PageCacheAccessReport;
+using llfs::PageCacheAccessStats;
+using llfs::PageLayoutId;
+
+using namespace llfs::int_types;
+
+const PageLayoutId kLeafLayout = PageLayoutId::from_str("leaf____");
+const PageLayoutId kNodeLayout = PageLayoutId::from_str("node____");
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageCacheAccessStatsTest, Sampling)
+{
+  PageCacheAccessStats stats{PageCacheAccessStats::Options{
+      .sample_interval = 7,
+      .max_key_ranges = 4,
+      .key_prefix_size = 8,
+  }};
+
+  usize sampled = 0;
+  for (usize i = 0; i < 700; ++i) {
+    if (stats.should_sample()) {
+      ++sampled;
+    }
+  }
+
+  EXPECT_EQ(sampled, 100u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageCacheAccessStatsTest, LayoutsAndRanges)
+{
+  PageCacheAccessStats stats{PageCacheAccessStats::Options{
+      .sample_interval = 1,
+      .max_key_ranges = 4,
+      .key_prefix_size = 3,
+  }};
+
+  // The first two pages have the same 3-byte key prefixes, so they are counted as one range.
+  //
+  stats.record(kLeafLayout, std::string_view{"apple"}, std::string_view{"apricot"},
+               /*hit=*/false, /*wait_usec=*/100);
+  stats.record(kLeafLayout, std::string_view{"appetite"}, std::string_view{"aprons"},
+               /*hit=*/true, /*wait_usec=*/1);
+  stats.record(kLeafLayout, std::string_view{"banana"}, std::string_view{"cherry"},
+               /*hit=*/false, /*wait_usec=*/50);
+  stats.record(kNodeLayout, llfs::None, llfs::None, /*hit=*/false, /*wait_usec=*/10);
+  stats.record(kNodeLayout, llfs::None, llfs::None, /*hit=*/false, /*wait_usec=*/10);
+  stats.record(kNodeLayout, llfs::None, llfs::None, /*hit=*/false, /*wait_usec=*/10);
+
+  const PageCacheAccessReport report = stats.report();
+
+  EXPECT_EQ(report.sample_interval, 1u);
+
+  ASSERT_EQ(report.layouts.size(), 2u);
+  EXPECT_EQ(report.layouts[0].layout_id, kNodeLayout);
+  EXPECT_EQ(report.layouts[0].counts.misses, 3u);
+  EXPECT_EQ(report.layouts[0].counts.hits, 0u);
+  EXPECT_EQ(report.layouts[0].counts.total_wait_usec, 30u);
+  EXPECT_EQ(report.layouts[1].layout_id, kLeafLayout);
+  EXPECT_EQ(report.layouts[1].counts.misses, 2u);
+  EXPECT_EQ(report.layouts[1].counts.hits, 1u);
+  EXPECT_EQ(report.layouts[1].counts.total_wait_usec, 151u);
+
+  ASSERT_EQ(report.key_ranges.size(), 2u);
+  EXPECT_EQ(report.key_ranges[0].layout_id, kLeafLayout);
+  EXPECT_EQ(report.key_ranges[0].min_key_prefix, "app");
+  EXPECT_EQ(report.key_ranges[0].max_key_prefix, "apr");
+  EXPECT_EQ(report.key_ranges[0].counts.misses, 1u);
+  EXPECT_EQ(report.key_ranges[0].counts.hits, 1u);
+  EXPECT_EQ(report.key_ranges[0].max_miss_overcount, 0u);
+  EXPECT_EQ(report.key_ranges[1].min_key_prefix, "ban");
+  EXPECT_EQ(report.key_ranges[1].max_key_prefix, "che");
+
+  stats.reset();
+
+  EXPECT_TRUE(stats.report().layouts.empty());
+  EXPECT_TRUE(stats.report().key_ranges.empty());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageCacheAccessStatsTest, HeavyHitters)
+{
+  constexpr usize kNumHotRanges = 3;
+  constexpr usize kNumColdRanges = 200;
+  constexpr usize kHotMissesPerRound = 5;
+  constexpr usize kNumRounds = 20;
+
+  PageCacheAccessStats stats{PageCacheAccessStats::Options{
+      .sample_interval = 1,
+      .max_key_ranges = 8,
+      .key_prefix_size = 16,
+  }};
+
+  const auto key = [](const char* kind, usize i) {
+    return std::string{kind} + std::to_string(i);
+  };
+
+  // Interleave the misses on the hot ranges with single misses on many cold ranges.
+  //
+  for (usize round = 0; round < kNumRounds; ++round) {
+    for (usize i = 0; i < kNumHotRanges; ++i) {
+      const std::string min_key = key("hot", i);
+      for (usize j = 0; j < kHotMissesPerRound; ++j) {
+        stats.record(kLeafLayout, std::string_view{min_key}, std::string_view{min_key},
+                     /*hit=*/false, /*wait_usec=*/0);
+      }
+    }
+    for (usize i = 0; i < kNumColdRanges / kNumRounds; ++i) {
+      const std::string min_key = key("cold", round * (kNumColdRanges / kNumRounds) + i);
+      stats.record(kLeafLayout, std::string_view{min_key}, std::string_view{min_key},
+                   /*hit=*/false, /*wait_usec=*/0);
+    }
+  }
+
+  const PageCacheAccessReport report = stats.report();
+
+  ASSERT_EQ(report.key_ranges.size(), 8u);
+
+  for (usize i = 0; i < kNumHotRanges; ++i) {
+    EXPECT_THAT(report.key_ranges[i].min_key_prefix, ::testing::StartsWith("hot"));
+
+    const u64 true_misses = kHotMissesPerRound * kNumRounds;
+    EXPECT_GE(report.key_ranges[i].counts.misses, true_misses);
+    EXPECT_LE(report.key_ranges[i].counts.misses - report.key_ranges[i].max_miss_overcount,
+              true_misses);
+  }
+}
+
+}  // namespace
@@ -0,0 +1,146 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_cache_admission_filter.hpp>
+//
+
+#include <batteries/math.hpp>
+
+#include <algorithm>
+
+namespace llfs {
+
+namespace {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+/** \brief 64-bit finalizer from SplitMix64; gives good avalanche behavior for sequential page ids.
+ */
+inline u64 mix_page_id_bits(u64 x)
+{
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ FrequencySketchAdmissionFilter::FrequencySketchAdmissionFilter(usize n_slots) noexcept
+    : width_{usize{1} << batt::log2_ceil(std::max<usize>(n_slots, kCountersPerWord))}
+    , n_words_{(this->width_ * kDepth) / kCountersPerWord}
+    , sample_size_{std::max<u64>(n_slots, 1) * kDefaultSampleSizeFactor}
+    , words_{new std::atomic<u64>[this->n_words_]}
+{
+  for (usize i = 0; i < this->n_words_; ++i) {
+    this->words_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize FrequencySketchAdmissionFilter::counter_index(u64 hash, usize row) const noexcept
+{
+  // Derive an independent hash for each row by re-mixing with a per-row seed; width_ is a power of
+  // 2, so we can just mask off the low bits.
+  //
+  const u64 row_hash = mix_page_id_bits(hash + (row + 1) * 0x9e3779b97f4a7c15ull);
+  return row * this->width_ + (row_hash & (this->width_ - 1));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void FrequencySketchAdmissionFilter::increment_counter(usize counter_i) noexcept
+{
+  std::atomic<u64>& word = this->words_[counter_i / kCountersPerWord];
+  const usize shift = (counter_i % kCountersPerWord) * 4;
+
+  u64 observed = word.load(std::memory_order_relaxed);
+  for (;;) {
+    if (((observed >> shift) & kMaxCount) == kMaxCount) {
+      return;
+    }
+    if (word.compare_exchange_weak(observed, observed + (u64{1} << shift),
+                                   std::memory_order_relaxed)) {
+      return;
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 FrequencySketchAdmissionFilter::load_counter(usize counter_i) const noexcept
+{
+  const u64 word = this->words_[counter_i / kCountersPerWord].load(std::memory_order_relaxed);
+  return (word >> ((counter_i % kCountersPerWord) * 4)) & kMaxCount;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 FrequencySketchAdmissionFilter::estimate(PageId page_id) const noexcept
+{
+  const u64 hash = mix_page_id_bits(page_id.int_value());
+
+  u64 min_count = kMaxCount;
+  for (usize row = 0; row < kDepth; ++row) {
+    min_count = std::min(min_count, this->load_counter(this->counter_index(hash, row)));
+  }
+  return min_count;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void FrequencySketchAdmissionFilter::record_access(PageId page_id) /*override*/
+{
+  if (!page_id.is_valid()) {
+    return;
+  }
+
+  const u64 hash = mix_page_id_bits(page_id.int_value());
+  for (usize row = 0; row < kDepth; ++row) {
+    this->increment_counter(this->counter_index(hash, row));
+  }
+
+  // Only the thread that crosses the sample size boundary does the aging, so it happens at most
+  // once per sample period.
+  //
+  if (this->additions_.fetch_add(1, std::memory_order_relaxed) + 1 == this->sample_size_) {
+    this->age();
+    this->additions_.fetch_sub(this->sample_size_ / 2, std::memory_order_relaxed);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool FrequencySketchAdmissionFilter::should_admit(PageId candidate, PageId victim) /*override*/
+{
+  if (!victim.is_valid()) {
+    return true;
+  }
+  return this->estimate(candidate) > this->estimate(victim);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void FrequencySketchAdmissionFilter::age() noexcept
+{
+  // After shifting, mask off the high bit of each 4-bit counter to discard the bit that spilled in
+  // from the neighboring counter.
+  //
+  constexpr u64 kHalveMask = 0x7777777777777777ull;
+
+  for (usize i = 0; i < this->n_words_; ++i) {
+    u64 observed = this->words_[i].load(std::memory_order_relaxed);
+    while (!this->words_[i].compare_exchange_weak(observed, (observed >> 1) & kHalveMask,
+                                                  std::memory_order_relaxed)) {
+    }
+  }
+}
+
+}  // namespace llfs
@@ -0,0 +1,134 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_CACHE_ADMISSION_FILTER_HPP
+#define LLFS_PAGE_CACHE_ADMISSION_FILTER_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/page_id.hpp>
+
+#include <atomic>
+#include <memory>
+
+namespace llfs {
+
+/** \brief Decides whether a newly loaded page is allowed to displace an existing cached page.
+ *
+ * An admission filter is consulted by PageCacheSlot::Pool whenever it must evict a valid page to
+ * make room for a new one.  If the filter rejects the new page, the pool places it in one of a small
+ * number of "probation" slots instead of evicting the chosen victim, so that a single large scan
+ * can't flush the whole working set.
+ *
+ * Implementations must be thread-safe.
+ */
+class PageCacheAdmissionFilter
+{
+ public:
+  PageCacheAdmissionFilter(const PageCacheAdmissionFilter&) = delete;
+  PageCacheAdmissionFilter& operator=(const PageCacheAdmissionFilter&) = delete;
+
+  virtual ~PageCacheAdmissionFilter() = default;
+
+  /** \brief Notifies the filter of a lookup for the given page (hit or miss).
+   */
+  virtual void record_access(PageId page_id) = 0;
+
+  /** \brief Returns true iff `candidate` should be cached in place of `victim`.
+   */
+  virtual bool should_admit(PageId candidate, PageId victim) = 0;
+
+ protected:
+  PageCacheAdmissionFilter() = default;
+};
+
+/** \brief A TinyLFU-style admission filter that estimates recent access frequency with a compact
+ * count-min sketch.
+ *
+ * Each page is mapped to one 4-bit counter in each of `kDepth` rows; the estimated frequency is the
+ * minimum of these counters.  To keep the estimates biased towards recent history, all counters are
+ * halved every time the total number of recorded accesses reaches the sample size (by default, ten
+ * times the number of cache slots).
+ */
+class FrequencySketchAdmissionFilter : public PageCacheAdmissionFilter
+{
+ public:
+  /** \brief The number of independent hash rows in the sketch.
+   */
+  static constexpr usize kDepth = 4;
+
+  /** \brief The number of 4-bit counters packed into each atomic word.
+   */
+  static constexpr usize kCountersPerWord = 16;
+
+  /** \brief The maximum value of a single counter.
+   */
+  static constexpr u64 kMaxCount = 15;
+
+  /** \brief The default ratio of the aging sample size to the number of tracked cache slots.
+   */
+  static constexpr usize kDefaultSampleSizeFactor = 10;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Creates a new sketch sized for a cache of `n_slots` pages.
+   */
+  explicit FrequencySketchAdmissionFilter(usize n_slots) noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Returns the estimated (recent) access frequency of the given page, in [0, kMaxCount].
+   */
+  u64 estimate(PageId page_id) const noexcept;
+
+  /** \brief Returns the number of counters in each hash row.
+   */
+  usize width() const noexcept
+  {
+    return this->width_;
+  }
+
+  //----- --- -- -  -  -   -
+  // PageCacheAdmissionFilter interface
+
+  void record_access(PageId page_id) override;
+
+  bool should_admit(PageId candidate, PageId victim) override;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  /** \brief Returns the flat counter index of `page_id` in the given hash row.
+   */
+  usize counter_index(u64 hash, usize row) const noexcept;
+
+  /** \brief Atomically increments the given counter unless it is saturated.
+   */
+  void increment_counter(usize counter_i) noexcept;
+
+  /** \brief Returns the value of the given counter.
+   */
+  u64 load_counter(usize counter_i) const noexcept;
+
+  /** \brief Halves all counters in the sketch.
+   */
+  void age() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const usize width_;
+  const usize n_words_;
+  const u64 sample_size_;
+  std::unique_ptr<std::atomic<u64>[]> words_;
+  std::atomic<u64> additions_{0};
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_PAGE_CACHE_ADMISSION_FILTER_HPP
@@ -0,0 +1,140 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_cache_admission_filter.hpp>
+//
+#include <llfs/page_cache_admission_filter.hpp>
+
+#include <llfs/page_cache_slot.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <batteries/utility.hpp>
+
+namespace {
+
+using namespace llfs::int_types;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(FrequencySketchAdmissionFilterTest, EstimateAndSaturate)
+{
+  llfs::FrequencySketchAdmissionFilter filter{/*n_slots=*/1024};
+
+  EXPECT_EQ(filter.width(), 1024u);
+  EXPECT_EQ(filter.estimate(llfs::PageId{7}), 0u);
+
+  for (u64 i = 1; i <= 5; ++i) {
+    filter.record_access(llfs::PageId{7});
+    EXPECT_GE(filter.estimate(llfs::PageId{7}), i);
+  }
+
+  for (usize i = 0; i < 100; ++i) {
+    filter.record_access(llfs::PageId{7});
+  }
+  EXPECT_EQ(filter.estimate(llfs::PageId{7}), llfs::FrequencySketchAdmissionFilter::kMaxCount);
+
+  // Invalid page ids are ignored.
+  //
+  filter.record_access(llfs::PageId{});
+  EXPECT_TRUE(filter.should_admit(llfs::PageId{7}, llfs::PageId{}));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(FrequencySketchAdmissionFilterTest, ScanDoesNotDisplaceHotPage)
+{
+  llfs::FrequencySketchAdmissionFilter filter{/*n_slots=*/1024};
+
+  const llfs::PageId hot_page{0xabcdef};
+  for (usize i = 0; i < 8; ++i) {
+    filter.record_access(hot_page);
+  }
+
+  // Each page in a sequential scan is seen only once, so it must never displace the hot page.
+  //
+  for (u64 i = 0; i < 1000; ++i) {
+    const llfs::PageId scan_page{i};
+    filter.record_access(scan_page);
+    EXPECT_FALSE(filter.should_admit(scan_page, hot_page)) << BATT_INSPECT(i);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(FrequencySketchAdmissionFilterTest, Aging)
+{
+  constexpr usize kNumSlots = 64;
+
+  llfs::FrequencySketchAdmissionFilter filter{kNumSlots};
+
+  const llfs::PageId page{42};
+  for (usize i = 0; i < 12; ++i) {
+    filter.record_access(page);
+  }
+  const u64 before = filter.estimate(page);
+  EXPECT_GE(before, 12u);
+
+  // Record enough other accesses to trigger at least one aging pass.
+  //
+  for (u64 i = 0; i < kNumSlots * llfs::FrequencySketchAdmissionFilter::kDefaultSampleSizeFactor;
+       ++i) {
+    filter.record_access(llfs::PageId{1000 + i});
+  }
+
+  EXPECT_LT(filter.estimate(page), before);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(FrequencySketchAdmissionFilterTest, PoolRejectsColdCandidate)
+{
+  constexpr usize kNumSlots = 4;
+
+  boost::intrusive_ptr<llfs::PageCacheSlot::Pool> pool =
+      llfs::PageCacheSlot::Pool::make_new(kNumSlots, std::string{"AdmissionFilterTestPool"});
+
+  // Use an oversized sketch so that hash collisions can't affect the outcome of this test.
+  //
+  pool->set_admission_filter(std::make_unique<llfs::FrequencySketchAdmissionFilter>(1024));
+
+  llfs::PageCacheAdmissionFilter* filter = pool->admission_filter();
+  ASSERT_NE(filter, nullptr);
+
+  // Fill the pool with hot pages.
+  //
+  for (usize i = 0; i < kNumSlots; ++i) {
+    llfs::PageCacheSlot* slot = pool->allocate();
+    ASSERT_NE(slot, nullptr);
+    for (usize j = 0; j < 4; ++j) {
+      filter->record_access(llfs::PageId{i});
+    }
+    (void)slot->fill(llfs::PageId{i});
+  }
+
+  // A cold page must be rejected; the first rejection seeds the (single-entry) probation ring with
+  // the victim, and all later rejections reuse that same slot.
+  //
+  filter->record_access(llfs::PageId{100});
+  llfs::PageCacheSlot* first = pool->allocate(/*preferred_shard=*/0, llfs::PageId{100});
+  ASSERT_NE(first, nullptr);
+  (void)first->fill(llfs::PageId{100});
+
+  EXPECT_EQ(pool->metrics().reject_count.load(), 1u);
+
+  for (u64 i = 101; i < 110; ++i) {
+    filter->record_access(llfs::PageId{i});
+    llfs::PageCacheSlot* next = pool->allocate(/*preferred_shard=*/0, llfs::PageId{i});
+    ASSERT_NE(next, nullptr);
+    EXPECT_EQ(next, first);
+    (void)next->fill(llfs::PageId{i});
+  }
+}
+
+}  // namespace
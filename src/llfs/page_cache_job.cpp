@@ -9,10 +9,12 @@
 #include <llfs/page_cache_job.hpp>
 //
 
+#include <llfs/page_write_op.hpp>
 #include <llfs/trace_refs_recursive.hpp>
 
 #include <batteries/async/backoff.hpp>
 
+#include <algorithm>
 #include <atomic>
 
 namespace llfs {
@@ -74,6 +76,9 @@ void PageCacheJob::set_base_job(const FinalizedPageCacheJob& base_job)
 {
   this->base_job_ = base_job;
   this->base_job_id_ = base_job.job_id();
+  if (!this->page_index_) {
+    this->page_index_ = base_job.page_index();
+  }
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -96,7 +101,8 @@ bool PageCacheJob::is_page_new_and_pinned(PageId page_id) const
 {
   auto iter = this->new_pages_.find(page_id);
   return (iter != this->new_pages_.end()) &&
-         (iter->second.has_view() || this->deferred_new_pages_.count(page_id));
+         (iter->second.has_view() || iter->second.is_streamed() ||
+          this->deferred_new_pages_.count(page_id));
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -190,10 +196,249 @@ StatusOr<PinnedPage> PageCacheJob::pin_new_impl(
   // Add to the pinned set.
   //
   this->pinned_.emplace(id, *pinned_page);
+  this->unstreamed_pages_.emplace_back(id);
+
+  if (this->max_unstreamed_pages_ != 0 &&
+      this->unstreamed_pages_.size() >= this->max_unstreamed_pages_) {
+    BATT_REQUIRE_OK(this->stream_new_pages(this->streaming_retention_));
+  }
 
   return pinned_page;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<PinnedPage> PageCacheJob::pin_new_or_dedup(std::shared_ptr<PageView>&& page_view,
+                                                    u64 callers)
+{
+  BATT_CHECK_NOT_NULLPTR(page_view);
+
+  const PageId new_page_id = page_view->page_id();
+  const std::shared_ptr<const PageBuffer> new_page_data = page_view->data();
+  const Sha256 key = PageDedupIndex::content_key(*new_page_data);
+
+  // Returns `existing` (and deallocates the new page) if it has the same contents.
+  //
+  const auto use_existing = [&](const PinnedPage& existing) -> bool {
+    if (existing->page_id() == new_page_id ||
+        !PageDedupIndex::same_content(*existing->data(), *new_page_data)) {
+      return false;
+    }
+    this->new_pages_.erase(new_page_id);
+    this->cache_->deallocate_page(new_page_id, callers | Caller::PageCacheJob_pin_new,
+                                  this->job_id);
+    return true;
+  };
+
+  // First look for a page with the same contents among the ones added by this job.
+  //
+  {
+    auto iter = this->new_page_by_content_.find(key);
+    if (iter != this->new_page_by_content_.end()) {
+      Optional<PinnedPage> existing = this->get_already_pinned(iter->second);
+      if (existing && use_existing(*existing)) {
+        return *existing;
+      }
+    }
+  }
+
+  // Then in the index of committed pages.
+  //
+  PageDedupIndex* const dedup_index = this->cache_->dedup_index();
+  if (dedup_index) {
+    Optional<PageId> existing_id = dedup_index->find(key);
+    if (existing_id) {
+      StatusOr<PinnedPage> existing = this->get_page_with_layout_in_job(
+          *existing_id, /*required_layout=*/None, PinPageToJob::kTrue, OkIfNotFound{true});
+
+      if (existing.ok() && use_existing(*existing)) {
+        return existing;
+      }
+
+      // The indexed page is gone or has different contents (a hash collision); forget it.
+      //
+      dedup_index->erase(*existing_id);
+    }
+  }
+
+  StatusOr<PinnedPage> pinned_page = this->pin_new(std::move(page_view), callers);
+  BATT_REQUIRE_OK(pinned_page);
+
+  this->dedup_keys_.emplace(new_page_id, key);
+  this->new_page_by_content_.emplace(key, new_page_id);
+
+  return pinned_page;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<PinnedPage> PageCacheJob::pin_new_as_delta(std::shared_ptr<PageView>&& page_view,
+                                                    const PinnedPage& base, u64 callers)
+{
+  BATT_CHECK_NOT_NULLPTR(page_view);
+
+  const PageId page_id = page_view->page_id();
+
+  auto iter = this->new_pages_.find(page_id);
+  BATT_CHECK_NE(iter, this->new_pages_.end())
+      << "pin_new_as_delta called on a page that was not allocated by this job!";
+
+  // Only start or extend a chain while it is shorter than the limit; otherwise write the page in
+  // full, which starts a new chain.
+  //
+  if (base && base->page_id() != page_id && this->deleted_pages_.count(base->page_id()) == 0 &&
+      base->delta_depth() < this->cache_->options().max_delta_chain_depth()) {
+    std::shared_ptr<const PageBuffer> delta = encode_page_delta(
+        page_view->page_buffer(), base->page_buffer(), base->page_id(), base->delta_depth());
+
+    if (delta) {
+      PageCacheMetrics& metrics = this->cache_->metrics();
+      metrics.delta_page_write_count.add(1);
+      metrics.delta_saved_bytes.add(page_view->header().used_size() -
+                                    get_page_header(*delta).used_size());
+
+      page_view->set_delta_base(base->page_id(), get_delta_page_depth(*delta));
+
+      // Set the image before pinning the page, since `pin_new` may stream (write) it right away.
+      //
+      iter->second.set_write_image(std::move(delta));
+    }
+  }
+
+  return this->pin_new(std::move(page_view), callers);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageCacheJob::write_new_page(std::shared_ptr<PageView>&& page_view)
+{
+  BATT_CHECK_NOT_NULLPTR(page_view);
+
+  const PageId id = page_view->page_id();
+
+  auto iter = this->new_pages_.find(id);
+  BATT_CHECK_NE(iter, this->new_pages_.end())
+      << "write_new_page called on a page that was not allocated by this job!";
+
+  this->pruned_ = false;
+  bool set_view_ok = iter->second.set_view(std::move(page_view));
+  BATT_CHECK(set_view_ok) << "write_new_page called multiple times for the same page!";
+
+  this->unstreamed_pages_.emplace_back(id);
+
+  if (this->max_unstreamed_pages_ != 0 &&
+      this->unstreamed_pages_.size() >= this->max_unstreamed_pages_) {
+    BATT_REQUIRE_OK(this->stream_new_pages(this->streaming_retention_));
+  }
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageCacheJob::stream_new_pages(StreamedPageRetention retention)
+{
+  // Collect the pages to write, skipping any that have been pruned since they were pinned.
+  //
+  std::vector<std::shared_ptr<const PageBuffer>> to_write;
+  for (const PageId& page_id : this->unstreamed_pages_) {
+    auto iter = this->new_pages_.find(page_id);
+    if (iter == this->new_pages_.end() || !iter->second.has_view() ||
+        this->is_recovered_page(page_id)) {
+      continue;
+    }
+    to_write.emplace_back(iter->second.write_image());
+  }
+  this->unstreamed_pages_.clear();
+
+  if (to_write.empty()) {
+    return OkStatus();
+  }
+
+  // Submit the writes for each device in physical page order, so that pages allocated together are
+  // written as close to sequentially as the device allows.
+  //
+  const auto physical_order = [this](const std::shared_ptr<const PageBuffer>& buffer) {
+    const PageId page_id = buffer->page_id();
+    return std::make_pair(
+        PageIdFactory::get_device_id(page_id),
+        this->cache_->arena_for_page_id(page_id).device().page_ids().get_physical_page(page_id));
+  };
+  std::sort(to_write.begin(), to_write.end(),
+            [&physical_order](const auto& left, const auto& right) {
+              return physical_order(left) < physical_order(right);
+            });
+
+  LLFS_VLOG(1) << "PageCacheJob::stream_new_pages(): writing " << to_write.size() << " pages";
+
+  batt::Watch<i64> done_counter{0};
+  std::unique_ptr<PageWriteOp[]> ops = PageWriteOp::allocate_array(to_write.size(), done_counter);
+
+  usize total_byte_count = 0;
+  usize used_byte_count = 0;
+
+  for (usize i = 0; i < to_write.size(); ++i) {
+    const PageId page_id = to_write[i]->page_id();
+    {
+      const PackedPageHeader& page_header = get_page_header(*to_write[i]);
+      total_byte_count += page_header.size;
+      used_byte_count += page_header.used_size();
+    }
+
+    ops[i].page_id = page_id;
+
+    this->cache_->write_page(this->cache_->prepare_page_for_write(std::move(to_write[i])),
+                             &ops[i]);
+  }
+
+  // The ops refer to `done_counter`, so we must not return until all of them have completed; since
+  // nothing closes `done_counter`, this can't fail.
+  //
+  BATT_CHECK_OK(done_counter.await_true([n_ops = to_write.size()](i64 n) {
+    return n == (i64)n_ops;
+  }));
+
+  this->cache_->metrics().total_bytes_written += total_byte_count;
+  this->cache_->metrics().used_bytes_written += used_byte_count;
+  this->cache_->metrics().total_write_ops += total_byte_count / 4096;
+
+  // Release everything the job holds for the pages that were written.  Failed pages are left as
+  // they are, to be written again when the job is committed.
+  //
+  Status status = OkStatus();
+  for (usize i = 0; i < to_write.size(); ++i) {
+    const PageId page_id = ops[i].page_id;
+    if (!ops[i].result.ok()) {
+      status.Update(ops[i].result);
+      continue;
+    }
+
+    auto iter = this->pinned_.find(page_id);
+    if (iter != this->pinned_.end()) {
+      if (retention == StreamedPageRetention::kHintObsolete) {
+        iter->second.hint_obsolete();
+      }
+      this->pinned_.erase(iter);
+    }
+
+    NewPage& new_page = this->new_pages_.find(page_id)->second;
+    std::vector<PageId> refs;
+    new_page.view()->append_refs_and_delta_base(&refs);
+    new_page.mark_streamed(std::move(refs));
+    this->streamed_page_count_ += 1;
+  }
+
+  return status;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheJob::enable_streaming(usize max_unstreamed_pages, StreamedPageRetention retention)
+{
+  this->max_unstreamed_pages_ = max_unstreamed_pages;
+  this->streaming_retention_ = retention;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 void PageCacheJob::pin_new_if_needed(PageId page_id,
@@ -248,7 +493,15 @@ StatusOr<PinnedPage> PageCacheJob::get_page_with_layout_in_job(
   // If not pinned, then check to see if its a new page that hasn't been built yet.
   {
     auto iter = this->new_pages_.find(page_id);
-    if (iter != this->new_pages_.end()) {
+    if (iter != this->new_pages_.end() && iter->second.is_streamed()) {
+      // Streamed pages have been durably written; load them like any other page below, but don't
+      // pin them to the job unless the caller explicitly asks for it (releasing them is the whole
+      // point of streaming).
+      //
+      if (pin_page_to_job == PinPageToJob::kDefault) {
+        pin_page_to_job = PinPageToJob::kFalse;
+      }
+    } else if (iter != this->new_pages_.end()) {
       NewPage& new_page = iter->second;
 
       if (!new_page.has_view()) {
@@ -260,6 +513,17 @@ StatusOr<PinnedPage> PageCacheJob::get_page_with_layout_in_job(
         }
       }
 
+      // Pages added via `write_new_page` are only inserted into the cache once they are asked for.
+      //
+      if (new_page.has_view()) {
+        StatusOr<PinnedPage> pinned_page =
+            this->cache_->put_view(new_page.view(), Caller::PageCacheJob_pin_new, this->job_id);
+        BATT_REQUIRE_OK(pinned_page);
+
+        this->pinned_.emplace(page_id, *pinned_page);
+        return pinned_page;
+      }
+
       BATT_CHECK(new_page.has_view()) << "If the page has a view associated with it, then it "
                                          "should have been pinned to the job already "
                                          "inside `pin_new`; possible race condition?  (remember, "
@@ -282,9 +546,57 @@ StatusOr<PinnedPage> PageCacheJob::get_page_with_layout_in_job(
     this->pin(batt::make_copy(*pinned_page));
   }
 
+  // Let the readahead engine (if enabled) see the page and prefetch whatever it predicts is next.
+  //
+  if (pinned_page.ok() && this->readahead_) {
+    const PageIdFactory page_ids = this->cache_->arena_for_page_id(page_id).device().page_ids();
+    for (PageId ahead_page_id : this->readahead_->observe(page_id, page_ids)) {
+      this->prefetch_hint(ahead_page_id);
+    }
+  }
+
   return pinned_page;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheJob::enable_readahead(usize max_window)
+{
+  this->readahead_ = std::make_unique<SequentialReadahead>(
+      /*min_window=*/SequentialReadahead::kDefaultMinWindow, max_window);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageCacheJob::append_page_refs(PageId page_id, std::vector<PageId>* refs) /*override*/
+{
+  if (this->append_new_page_refs(page_id, refs)) {
+    return OkStatus();
+  }
+  return PageLoader::append_page_refs(page_id, refs);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool PageCacheJob::append_new_page_refs(PageId page_id, std::vector<PageId>* refs) const
+{
+  auto iter = this->new_pages_.find(page_id);
+  if (iter == this->new_pages_.end()) {
+    return false;
+  }
+
+  const NewPage& new_page = iter->second;
+  if (new_page.is_streamed()) {
+    refs->insert(refs->end(), new_page.streamed_refs().begin(), new_page.streamed_refs().end());
+    return true;
+  }
+  if (new_page.has_view()) {
+    new_page.view()->append_refs_and_delta_base(refs);
+    return true;
+  }
+  return false;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 Optional<PinnedPage> PageCacheJob::get_already_pinned(PageId page_id) const
@@ -302,8 +614,12 @@ StatusOr<PinnedPage> PageCacheJob::const_get(PageId page_id,
                                              const Optional<PageLayoutId>& required_layout,
                                              OkIfNotFound ok_if_not_found) const
 {
+  // With a page index we can go straight to the job that created the page (if there is one), rather
+  // than walking the chain of base jobs.
+  //
   StatusOr<PinnedPage> pinned_page =
-      this->base_job_.finalized_get(page_id, required_layout, ok_if_not_found);
+      this->page_index_ ? this->page_index_->finalized_get(page_id)
+                        : this->base_job_.finalized_get(page_id, required_layout, ok_if_not_found);
   if (pinned_page.status() != batt::StatusCode::kUnavailable) {
     return pinned_page;
   }
@@ -324,7 +640,15 @@ void PageCacheJob::const_prefetch_hint(PageId page_id) const
   if (!this->pinned_.count(page_id) && !this->new_pages_.count(page_id) &&
       !this->deleted_pages_.count(page_id)) {
     BATT_DEBUG_INFO(BATT_INSPECT(page_id) << std::dec << BATT_INSPECT(this->job_id));
-    this->base_job_.finalized_prefetch_hint(page_id, this->cache());
+    if (this->page_index_) {
+      // Pages pinned by an earlier job in the pipeline are already in memory.
+      //
+      if (!this->page_index_->finalized_get(page_id).ok()) {
+        this->cache_->prefetch_hint(page_id);
+      }
+    } else {
+      this->base_job_.finalized_prefetch_hint(page_id, this->cache());
+    }
   }
 }
 
@@ -500,4 +824,15 @@ std::shared_ptr<PageBuffer> PageCacheJob::NewPage::buffer() const
   return this->buffer_;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheJob::NewPage::mark_streamed(std::vector<PageId>&& refs)
+{
+  this->buffer_ = nullptr;
+  this->view_ = None;
+  this->write_image_ = nullptr;
+  this->streamed_refs_ = std::move(refs);
+  this->streamed_ = true;
+}
+
 }  // namespace llfs
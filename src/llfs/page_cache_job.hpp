@@ -11,19 +11,25 @@
 #define LLFS_PAGE_CACHE_JOB_HPP
 
 #include <llfs/finalized_page_cache_job.hpp>
+#include <llfs/finalized_page_index.hpp>
 #include <llfs/method_binder.hpp>
 #include <llfs/page_cache.hpp>
+#include <llfs/page_cache_job_arena.hpp>
 #include <llfs/page_id.hpp>
 #include <llfs/page_loader.hpp>
+#include <llfs/page_readahead.hpp>
 #include <llfs/page_size.hpp>
 #include <llfs/pinned_page.hpp>
+#include <llfs/sha256.hpp>
 
 #include <batteries/async/backoff.hpp>
 
 #include <functional>
 #include <memory>
+#include <memory_resource>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #define JOB_DEBUG(job)                                                                             \
   if (::llfs::PageCache::job_debug_on())                                                           \
@@ -31,6 +37,19 @@
 
 namespace llfs {
 
+// What to do with the cached copy of a new page once it has been written by
+// `PageCacheJob::stream_new_pages`.
+//
+enum struct StreamedPageRetention : u8 {
+  // Leave the page in the cache, to be evicted under the normal replacement policy.
+  //
+  kKeepInCache = 0,
+
+  // Hint to the cache that the page is unlikely to be needed again soon, so it is evicted first.
+  //
+  kHintObsolete = 1,
+};
+
 class PageCacheJob : public PageLoader
 {
  public:
@@ -40,6 +59,11 @@ class PageCacheJob : public PageLoader
   //
   using DeferredNewPageFn = std::function<std::shared_ptr<PageView>()>;
 
+  // The job's maps from PageId, all allocated from the job's arena (see PageCacheJobArena).
+  //
+  template <typename T>
+  using PageIdMap = std::pmr::unordered_map<PageId, T, PageId::Hash>;
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
   // A lazily-built new page in the context of this job.
   //
@@ -58,11 +82,47 @@ class PageCacheJob : public PageLoader
 
     std::shared_ptr<PageBuffer> buffer() const;
 
+    // Drops the buffer and view of a page that has been durably written by `stream_new_pages`,
+    // keeping only the ids of the pages it references (`refs`) so it needn't be reloaded to trace
+    // it on commit; from now on the page is loaded (through the cache) like any existing page.
+    //
+    void mark_streamed(std::vector<PageId>&& refs);
+
+    bool is_streamed() const
+    {
+      return this->streamed_;
+    }
+
+    // The page ids referenced by a streamed page (see `mark_streamed`).
+    //
+    const std::vector<PageId>& streamed_refs() const
+    {
+      return this->streamed_refs_;
+    }
+
     std::shared_ptr<const PageBuffer> const_buffer() const
     {
       return this->view()->data();
     }
 
+    // Sets the image to write in place of the page's buffer (see `PageCacheJob::pin_new_as_delta`).
+    //
+    void set_write_image(std::shared_ptr<const PageBuffer>&& image)
+    {
+      this->write_image_ = std::move(image);
+    }
+
+    // The image of the page to write to its PageDevice: the one passed to `set_write_image`, if
+    // any, otherwise the page's buffer.
+    //
+    std::shared_ptr<const PageBuffer> write_image() const
+    {
+      if (this->write_image_) {
+        return this->write_image_;
+      }
+      return this->const_buffer();
+    }
+
     const PackedPageHeader& const_page_header() const
     {
       return get_page_header(*this->const_buffer());
@@ -71,6 +131,9 @@ class PageCacheJob : public PageLoader
    private:
     std::shared_ptr<PageBuffer> buffer_;
     Optional<std::shared_ptr<const PageView>> view_;
+    std::shared_ptr<const PageBuffer> write_image_;
+    std::vector<PageId> streamed_refs_;
+    bool streamed_ = false;
   };
 
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -106,8 +169,25 @@ class PageCacheJob : public PageLoader
   // between `this` and `base_job` on commmit will be guaranteed to preserve consistency on crash
   // recovery.
   //
+  // If this job has no page index (see `set_page_index`), it inherits the one of `base_job`.
+  //
   void set_base_job(const FinalizedPageCacheJob& base_job);
 
+  // Use `page_index` to find pages created by the (finalized, not yet durable) jobs before this
+  // one, instead of walking the chain of base jobs.  The index is shared by all the jobs in a
+  // pipeline; this job's new pages are added to it when the job is finalized (see
+  // CommittablePageCacheJob::from), and removed once it is durable.
+  //
+  void set_page_index(std::shared_ptr<FinalizedPageIndex> page_index)
+  {
+    this->page_index_ = std::move(page_index);
+  }
+
+  const std::shared_ptr<FinalizedPageIndex>& page_index() const
+  {
+    return this->page_index_;
+  }
+
   Status await_base_job_durable() const;
 
   // Returns true iff the given page id refers to a new page allocated within the scope of this job
@@ -116,7 +196,7 @@ class PageCacheJob : public PageLoader
   bool is_page_new(PageId page_id) const;
 
   // Returns true iff `this->is_new_page(page_id)` and `pin_new` has been invoked to pin the fully
-  // built page view to the job.
+  // built page view to the job (or the built page has since been written by `stream_new_pages`).
   //
   bool is_page_new_and_pinned(PageId page_id) const;
 
@@ -160,6 +240,41 @@ class PageCacheJob : public PageLoader
         });
   }
 
+  // Like `pin_new`, except that if a page with the same contents (see PageDedupIndex::content_key)
+  // was already pinned by this job or is in the cache's dedup index (see
+  // PageCacheOptions::dedup_index_max_entries), the new page is deallocated and the existing page
+  // is pinned to the job and returned instead; the caller must then refer to the returned page's
+  // id, not the new one.  The new page is only written (and, once this job is durable, added to
+  // the dedup index) if no match is found.
+  //
+  // A page found through the dedup index must stay live until this job commits; only enable the
+  // index if pages that new jobs may reference are not concurrently being deleted.
+  //
+  StatusOr<PinnedPage> pin_new_or_dedup(std::shared_ptr<PageView>&& page_view, u64 callers);
+
+  // Like `pin_new`, except that the page is written as a delta against `base` (see page_delta.hpp)
+  // if that is smaller than the full page and the chain of deltas leading to `base` is shorter
+  // than PageCacheOptions::max_delta_chain_depth.  Otherwise the page is written in full.
+  //
+  // A delta page holds a ref to its base page (see PageView::append_refs_and_delta_base), so the
+  // base stays live for as long as the delta page does; `base` must therefore not be deleted by
+  // this job.
+  //
+  StatusOr<PinnedPage> pin_new_as_delta(std::shared_ptr<PageView>&& page_view,
+                                        const PinnedPage& base, u64 callers);
+
+  // Bulk-load variant of `pin_new`: adds the built page to the job *without* inserting it into the
+  // cache.  The page is written by the next call to `stream_new_pages` (automatically, if streaming
+  // is enabled) or on commit, whichever comes first; it is only inserted into the cache if it is
+  // loaded through the job before then.  Use `pin_new` instead to fill the cache as pages are
+  // built.
+  //
+  // Later jobs in a pipeline (see `set_base_job`) can only load such a page once it has been
+  // written, so call `stream_new_pages` before finalizing a job with pages that later jobs may
+  // need before this one is durable.
+  //
+  Status write_new_page(std::shared_ptr<PageView>&& page_view);
+
   // Register a previously allocated page (returned by `this->new_page`) to be pinned the first time
   // it is requested.
   //
@@ -195,6 +310,46 @@ class PageCacheJob : public PageLoader
   //
   void unpin_all();
 
+  // Writes all new pages added (via `pin_new` or `write_new_page`) since the last call, in physical
+  // page order per device, waits for the writes to finish, and then drops the job's pins and
+  // buffers for the pages that were written successfully.  This bounds the memory used by a job
+  // with a very large number of new pages: a streamed page stays in the cache only as long as the
+  // cache's replacement policy allows, and is reloaded from its device if it is needed again.  The
+  // job keeps the ids of the pages each streamed page references, so tracing the new pages on
+  // commit doesn't reload them.
+  //
+  // Streamed pages are not written again on commit.  Writing a page early is safe, since the page
+  // doesn't become reachable until the job's ref count updates are durable.  If a write fails, the
+  // page stays buffered (it will be written on commit) and the error is returned.
+  //
+  Status stream_new_pages(StreamedPageRetention retention = StreamedPageRetention::kKeepInCache);
+
+  // Turn on streaming mode: whenever `max_unstreamed_pages` new pages have been pinned to the job
+  // without being streamed, `pin_new` (or `write_new_page`) calls `stream_new_pages(retention)`.
+  //
+  void enable_streaming(usize max_unstreamed_pages,
+                        StreamedPageRetention retention = StreamedPageRetention::kKeepInCache);
+
+  // Returns the number of new pages written by `stream_new_pages` so far.
+  //
+  usize streamed_page_count() const
+  {
+    return this->streamed_page_count_;
+  }
+
+  // Turn on sequential readahead for pages loaded through this job: whenever the pages loaded via
+  // `get_page_with_layout_in_job` form a sequential or strided pattern on some device, pages ahead
+  // of the reader are passed to `prefetch_hint`.  See SequentialReadahead.
+  //
+  void enable_readahead(usize max_window = SequentialReadahead::kDefaultMaxWindow);
+
+  // Returns the readahead engine for this job, or nullptr if readahead is not enabled.
+  //
+  const SequentialReadahead* readahead() const
+  {
+    return this->readahead_.get();
+  }
+
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
   // PageLoader interface
   //
@@ -216,11 +371,22 @@ class PageCacheJob : public PageLoader
                                                    const Optional<PageLayoutId>& required_layout,
                                                    PinPageToJob pin_page_to_job,
                                                    OkIfNotFound ok_if_not_found) override;
+
+  // Uses the view or the recorded refs of new pages (see `append_new_page_refs`); other pages are
+  // loaded as usual.
+  //
+  Status append_page_refs(PageId page_id, std::vector<PageId>* refs) override;
   //
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
   Optional<PinnedPage> get_already_pinned(PageId page_id) const;
 
+  // If `page_id` is a new page of this job whose view (or, once it has been streamed, whose list of
+  // refs) is still held by the job, appends the ids it references to `*refs` and returns true;
+  // otherwise returns false, leaving `*refs` unchanged.
+  //
+  bool append_new_page_refs(PageId page_id, std::vector<PageId>* refs) const;
+
   void const_prefetch_hint(PageId page_id) const;
 
   StatusOr<PinnedPage> const_get(PageId page_id, const Optional<PageLayoutId>& required_layout,
@@ -296,17 +462,17 @@ class PageCacheJob : public PageLoader
     return this->pruned_;
   }
 
-  const std::unordered_map<PageId, NewPage, PageId::Hash>& get_new_pages() const
+  const PageIdMap<NewPage>& get_new_pages() const
   {
     return this->new_pages_;
   }
 
-  const std::unordered_map<PageId, PinnedPage, PageId::Hash>& get_deleted_pages() const
+  const PageIdMap<PinnedPage>& get_deleted_pages() const
   {
     return this->deleted_pages_;
   }
 
-  const std::unordered_map<PageId, i32, PageId::Hash>& get_root_set_delta() const
+  const PageIdMap<i32>& get_root_set_delta() const
   {
     return this->root_set_delta_;
   }
@@ -316,6 +482,13 @@ class PageCacheJob : public PageLoader
     return this->recovered_pages_.count(page_id) != 0;
   }
 
+  // The content keys of the new pages added via `pin_new_or_dedup`.
+  //
+  const PageIdMap<Sha256>& get_dedup_keys() const
+  {
+    return this->dedup_keys_;
+  }
+
   LLFS_METHOD_BINDER(PageCacheJob, prefetch_hint, Prefetch);
   LLFS_METHOD_BINDER(PageCacheJob, get_page_slot, Get);
 
@@ -323,17 +496,40 @@ class PageCacheJob : public PageLoader
 
  private:
   PageCache* const cache_;
-  std::unordered_map<PageId, PinnedPage, PageId::Hash> pinned_;
-  std::unordered_map<PageId, NewPage, PageId::Hash> new_pages_;
-  std::unordered_map<PageId, PinnedPage, PageId::Hash> deleted_pages_;
-  std::unordered_map<PageId, i32, PageId::Hash> root_set_delta_;
-  std::unordered_map<PageId, std::function<auto()->std::shared_ptr<PageView>>, PageId::Hash>
-      deferred_new_pages_;
-  std::unordered_set<PageId, PageId::Hash> recovered_pages_;
+
+  // Backs all the containers below; must be declared before them so it outlives them.
+  //
+  PageCacheJobArena arena_;
+
+  PageIdMap<PinnedPage> pinned_{this->arena_.resource()};
+  PageIdMap<NewPage> new_pages_{this->arena_.resource()};
+  PageIdMap<PinnedPage> deleted_pages_{this->arena_.resource()};
+  PageIdMap<i32> root_set_delta_{this->arena_.resource()};
+  PageIdMap<std::function<auto()->std::shared_ptr<PageView>>> deferred_new_pages_{
+      this->arena_.resource()};
+  std::pmr::unordered_set<PageId, PageId::Hash> recovered_pages_{this->arena_.resource()};
+
+  // Content keys of new pages added via `pin_new_or_dedup`, in both directions.
+  //
+  PageIdMap<Sha256> dedup_keys_{this->arena_.resource()};
+  std::pmr::unordered_map<Sha256, PageId, boost::hash<Sha256>> new_page_by_content_{
+      this->arena_.resource()};
+
+  // New pages pinned since the last call to `stream_new_pages`.
+  //
+  std::pmr::vector<PageId> unstreamed_pages_{this->arena_.resource()};
+
+  // Streaming mode is enabled iff this is non-zero; see `enable_streaming`.
+  //
+  usize max_unstreamed_pages_ = 0;
+  StreamedPageRetention streaming_retention_ = StreamedPageRetention::kKeepInCache;
+  usize streamed_page_count_ = 0;
   bool pruned_ = false;
   std::ostringstream debug_;
   FinalizedPageCacheJob base_job_;
   u64 base_job_id_{0};
+  std::shared_ptr<FinalizedPageIndex> page_index_;
+  std::unique_ptr<SequentialReadahead> readahead_;
 };
 
 }  // namespace llfs
@@ -0,0 +1,72 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_cache_job_arena.hpp>
+//
+
+#include <vector>
+
+namespace llfs {
+
+namespace {
+
+// The initial arena buffers available for reuse on this thread.
+//
+std::vector<std::unique_ptr<u8[]>>& thread_buffer_pool()
+{
+  thread_local std::vector<std::unique_ptr<u8[]>> pool_;
+  return pool_;
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ std::unique_ptr<u8[]> PageCacheJobArena::acquire_buffer()
+{
+  std::vector<std::unique_ptr<u8[]>>& pool = thread_buffer_pool();
+  if (pool.empty()) {
+    return std::unique_ptr<u8[]>{new u8[kInitialBufferSize]};
+  }
+
+  std::unique_ptr<u8[]> buffer = std::move(pool.back());
+  pool.pop_back();
+
+  return buffer;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ void PageCacheJobArena::release_buffer(std::unique_ptr<u8[]>&& buffer)
+{
+  std::vector<std::unique_ptr<u8[]>>& pool = thread_buffer_pool();
+  if (pool.size() < kMaxPooledBuffersPerThread) {
+    pool.emplace_back(std::move(buffer));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCacheJobArena::PageCacheJobArena() noexcept
+    : buffer_{PageCacheJobArena::acquire_buffer()}
+    , resource_{this->buffer_.get(), kInitialBufferSize, std::pmr::new_delete_resource()}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCacheJobArena::~PageCacheJobArena() noexcept
+{
+  // Free any chunks allocated from the heap before the initial buffer can be reused.
+  //
+  this->resource_.release();
+
+  PageCacheJobArena::release_buffer(std::move(this->buffer_));
+}
+
+}  // namespace llfs
@@ -0,0 +1,84 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_CACHE_JOB_ARENA_HPP
+#define LLFS_PAGE_CACHE_JOB_ARENA_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/constants.hpp>
+#include <llfs/int_types.hpp>
+
+#include <memory>
+#include <memory_resource>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A monotonic memory arena for the internal containers of a single PageCacheJob.
+ *
+ * Memory is handed out from an initial buffer (and, if that runs out, from geometrically growing
+ * chunks allocated from the heap); nothing is freed until the arena is destroyed, at which point
+ * everything is released at once.  The initial buffers are recycled through a per-thread pool, so
+ * a job that fits in its initial buffer doesn't touch the general heap at all for its bookkeeping.
+ *
+ * Like PageCacheJob itself, this class is not thread-safe.
+ */
+class PageCacheJobArena
+{
+ public:
+  /** \brief The size of the initial buffer of each arena.
+   */
+  static constexpr usize kInitialBufferSize = 16 * kKiB;
+
+  /** \brief The maximum number of initial buffers kept for reuse by each thread.
+   */
+  static constexpr usize kMaxPooledBuffersPerThread = 64;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  PageCacheJobArena() noexcept;
+
+  PageCacheJobArena(const PageCacheJobArena&) = delete;
+  PageCacheJobArena& operator=(const PageCacheJobArena&) = delete;
+
+  /** \brief Releases all memory allocated from the arena and returns the initial buffer to the
+   * pool.  All containers using the arena must have been destroyed first.
+   */
+  ~PageCacheJobArena() noexcept;
+
+  /** \brief The memory resource to use for containers owned by the job.
+   */
+  std::pmr::memory_resource* resource() noexcept
+  {
+    return &this->resource_;
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  // Takes an initial buffer from the calling thread's pool, or allocates a new one.
+  //
+  static std::unique_ptr<u8[]> acquire_buffer();
+
+  // Returns an initial buffer to the calling thread's pool (or frees it, if the pool is full).
+  //
+  static void release_buffer(std::unique_ptr<u8[]>&& buffer);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  // Must be declared before (so it is initialized before) `resource_`.
+  //
+  std::unique_ptr<u8[]> buffer_;
+
+  std::pmr::monotonic_buffer_resource resource_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_PAGE_CACHE_JOB_ARENA_HPP
@@ -0,0 +1,67 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_cache_job_arena.hpp>
+//
+#include <llfs/page_cache_job_arena.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/page_id.hpp>
+
+#include <memory_resource>
+#include <unordered_map>
+
+namespace {
+
+// Test Plan:
+//
+//  1. Containers using the arena work past the size of the initial buffer.
+//  2. The initial buffer of a destroyed arena is reused by the next arena created on the same
+//     thread.
+
+using namespace llfs::int_types;
+
+using llfs::PageCacheJobArena;
+using llfs::PageId;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageCacheJobArenaTest, GrowsPastInitialBuffer)
+{
+  PageCacheJobArena arena;
+  std::pmr::unordered_map<PageId, i32, PageId::Hash> m{arena.resource()};
+
+  const usize n = PageCacheJobArena::kInitialBufferSize;
+  for (usize i = 0; i < n; ++i) {
+    m[PageId{i}] = static_cast<i32>(i);
+  }
+
+  ASSERT_EQ(m.size(), n);
+  for (usize i = 0; i < n; ++i) {
+    EXPECT_EQ(m[PageId{i}], static_cast<i32>(i));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageCacheJobArenaTest, ReusesInitialBuffer)
+{
+  void* first_alloc = nullptr;
+  {
+    PageCacheJobArena arena;
+    first_alloc = arena.resource()->allocate(64);
+  }
+  {
+    PageCacheJobArena arena;
+    EXPECT_EQ(arena.resource()->allocate(64), first_alloc);
+  }
+}
+
+}  // namespace
@@ -26,6 +26,22 @@ struct PageCacheMetrics {
   CountMetric<u64> leaf_write_count = 0;
   CountMetric<u64> total_write_ops = 0;
   CountMetric<u64> total_read_ops = 0;
+  CountMetric<u64> prefetch_issue_count = 0;
+  CountMetric<u64> prefetch_drop_count = 0;
+  CountMetric<u64> prefetch_hit_count = 0;
+  CountMetric<u64> prefetch_device_hint_count = 0;
+  CountMetric<u64> ref_summary_hit_count = 0;
+  CountMetric<u64> ref_summary_miss_count = 0;
+  CountMetric<u64> compressed_page_write_count = 0;
+  CountMetric<u64> compression_saved_bytes = 0;
+  CountMetric<u64> decompressed_page_count = 0;
+  CountMetric<u64> delta_page_write_count = 0;
+  CountMetric<u64> delta_saved_bytes = 0;
+  CountMetric<u64> materialized_delta_page_count = 0;
+  CountMetric<u64> validated_page_count = 0;
+  CountMetric<u64> page_validation_failure_count = 0;
+  CountMetric<u64> page_filter_build_count = 0;
+  CountMetric<u64> page_filter_build_drop_count = 0;
   LatencyMetric allocate_page_alloc_latency;
   LatencyMetric allocate_page_insert_latency;
   LatencyMetric page_write_latency;
@@ -11,6 +11,23 @@
 
 namespace llfs {
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, PageValidationPolicy t)
+{
+  switch (t) {
+    case PageValidationPolicy::kFull:
+      return out << "Full";
+    case PageValidationPolicy::kSampled:
+      return out << "Sampled";
+    case PageValidationPolicy::kFirstLoadOnly:
+      return out << "FirstLoadOnly";
+    case PageValidationPolicy::kBackgroundScrub:
+      return out << "BackgroundScrub";
+  }
+  return out << "PageValidationPolicy{" << static_cast<int>(t) << "}";
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 PageCacheOptions PageCacheOptions::with_default_values()
@@ -19,6 +36,35 @@ PageCacheOptions PageCacheOptions::with_default_values()
 
   opts.default_log_size_ = 64 * kMiB;
   opts.max_cached_pages_per_size_log2.fill(0);
+  opts.numa_sharded_slot_pools_ = false;
+  opts.scan_resistant_admission_ = false;
+  opts.clock_pro_eviction_ = false;
+  opts.cache_line_isolated_slots_ = false;
+  opts.max_cache_bytes_ = 0;
+  opts.max_resizable_cache_bytes_ = 0;
+  opts.max_prefetch_in_flight_per_device_ = 64;
+  opts.registered_page_buffers_per_device_ = 0;
+  opts.page_validation_policy_ = PageValidationPolicy::kFull;
+  opts.page_validation_sample_rate_ = 0.01;
+  opts.background_scrub_pages_per_second_ = 100;
+  opts.page_filter_index_ = false;
+  opts.max_page_filter_build_queue_depth_ = 4096;
+  opts.page_filter_file_dir_ = None;
+  opts.page_cache_trace_file_ = None;
+  opts.page_cache_trace_buffer_size_ = 64 * kKiB;
+  opts.warm_start_file_ = None;
+  opts.warm_start_save_interval_sec_ = 300;
+  opts.warm_start_max_pages_ = 0;
+  opts.warm_start_max_in_flight_ = 8;
+  opts.hot_page_replica_pin_threshold_ = 0;
+  opts.hot_page_replica_sets_ = 0;
+  opts.hot_page_replica_slots_ = 64;
+  opts.access_stats_sample_interval_ = 0;
+  opts.access_stats_max_key_ranges_ = 64;
+  opts.access_stats_key_prefix_size_ = 16;
+  opts.dedup_index_max_entries_ = 0;
+  opts.max_delta_chain_depth_ = 4;
+  opts.optimistic_reads_ = false;
 
   // Assume that 512..8192 are node sizes; allow a million nodes to be cached.
   //
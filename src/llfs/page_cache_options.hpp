@@ -13,15 +13,50 @@
 #include <llfs/config.hpp>
 #include <llfs/constants.hpp>
 #include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
 #include <llfs/page_size.hpp>
 
 #include <batteries/assert.hpp>
 #include <batteries/math.hpp>
 
+#include <algorithm>
 #include <array>
+#include <ostream>
+#include <string>
 
 namespace llfs {
 
+/** \brief When the PageCache checks the checksums of the pages it reads (see
+ * verify_page_checksum).
+ */
+enum struct PageValidationPolicy {
+  // Every page read from a device is checked, except that a page this cache has already verified
+  // since it was last written isn't checked again when it is reloaded; only a rewrite (see
+  // PageCache::prepare_page_for_write) makes the cache check it again.  Corruption of a page at
+  // rest after its first check is left to kBackgroundScrub.
+  //
+  kFull,
+
+  // A random sample of page reads (PageCacheOptions::page_validation_sample_rate of them) is
+  // checked.
+  //
+  kSampled,
+
+  // Each page is checked the first time it is read after being written (or after the cache is
+  // created); reloading a page that was evicted from the cache doesn't check it again.  This now
+  // checks the same reads as kFull; the name is kept for existing configurations.
+  //
+  kFirstLoadOnly,
+
+  // Pages aren't checked when they are read; instead, a background PageScrubber task slowly reads
+  // and checks the pages on all devices that aren't in the cache (see
+  // PageCacheOptions::background_scrub_pages_per_second).
+  //
+  kBackgroundScrub,
+};
+
+std::ostream& operator<<(std::ostream& out, PageValidationPolicy t);
+
 class PageCacheOptions
 {
  public:
@@ -41,10 +76,472 @@ class PageCacheOptions
     return *this;
   }
 
+  /** \brief If true, each per-page-size cache slot pool is split into one shard per NUMA node.
+   */
+  bool numa_sharded_slot_pools() const
+  {
+    return this->numa_sharded_slot_pools_;
+  }
+
+  PageCacheOptions& set_numa_sharded_slot_pools(bool enabled)
+  {
+    this->numa_sharded_slot_pools_ = enabled;
+    return *this;
+  }
+
+  /** \brief If true, each cache slot pool uses a frequency-sketch admission filter so that large
+   * one-time scans don't displace frequently used pages.
+   */
+  bool scan_resistant_admission() const
+  {
+    return this->scan_resistant_admission_;
+  }
+
+  PageCacheOptions& set_scan_resistant_admission(bool enabled)
+  {
+    this->scan_resistant_admission_ = enabled;
+    return *this;
+  }
+
+  /** \brief If true, each cache slot pool chooses eviction victims with a CLOCK-Pro style hand
+   * sweep (see PageCacheSlot::Pool::EvictionPolicy::kClockPro) instead of random sampling.
+   */
+  bool clock_pro_eviction() const
+  {
+    return this->clock_pro_eviction_;
+  }
+
+  PageCacheOptions& set_clock_pro_eviction(bool enabled)
+  {
+    this->clock_pro_eviction_ = enabled;
+    return *this;
+  }
+
+  /** \brief If true, each slot in the cache slot pools is padded out to its own CPU cache line(s)
+   * to avoid false sharing between neighboring slots (see
+   * PageCacheSlot::Pool::set_cache_line_isolation).  If false (the default), slots are packed
+   * tightly, which saves up to a cache line of memory per cached page.
+   */
+  bool cache_line_isolated_slots() const
+  {
+    return this->cache_line_isolated_slots_;
+  }
+
+  PageCacheOptions& set_cache_line_isolated_slots(bool enabled)
+  {
+    this->cache_line_isolated_slots_ = enabled;
+    return *this;
+  }
+
+  /** \brief If non-zero, all page sizes share a single cache slot pool whose total size (the sum of
+   * the page sizes of the cached pages) is limited to this many bytes; larger pages are then
+   * preferred for eviction.  If zero (the default), each page size has its own pool, limited only
+   * by max_cached_pages_per_size_log2.
+   */
+  u64 max_cache_bytes() const
+  {
+    return this->max_cache_bytes_;
+  }
+
+  PageCacheOptions& set_max_cache_bytes(u64 n)
+  {
+    this->max_cache_bytes_ = n;
+    return *this;
+  }
+
+  /** \brief The largest size the cache can be grown to at runtime (see PageCache::resize_cache);
+   * cache slots for this many bytes (of the smallest page size) are reserved up front.  Only used
+   * if max_cache_bytes() is non-zero; if this is smaller than max_cache_bytes(), max_cache_bytes()
+   * is the limit.
+   */
+  u64 max_resizable_cache_bytes() const
+  {
+    return std::max(this->max_resizable_cache_bytes_, this->max_cache_bytes_);
+  }
+
+  PageCacheOptions& set_max_resizable_cache_bytes(u64 n)
+  {
+    this->max_resizable_cache_bytes_ = n;
+    return *this;
+  }
+
+  /** \brief The maximum number of prefetch reads (see PageCache::prefetch_hint) that may be in
+   * flight at any one time for a single PageDevice; prefetch hints beyond this limit are dropped.
+   */
+  usize max_prefetch_in_flight_per_device() const
+  {
+    return this->max_prefetch_in_flight_per_device_;
+  }
+
+  PageCacheOptions& set_max_prefetch_in_flight_per_device(usize n)
+  {
+    this->max_prefetch_in_flight_per_device_ = n;
+    return *this;
+  }
+
+  /** \brief The number of page buffers each PageDevice should allocate from memory registered for
+   * fixed-buffer I/O (see PageDevice::enable_registered_page_buffers); 0 (the default) disables
+   * registered page buffers.
+   *
+   * When a device's registered buffers are all in use (e.g., because they are held by the cache),
+   * it falls back to ordinary PageBuffer allocation.
+   */
+  usize registered_page_buffers_per_device() const
+  {
+    return this->registered_page_buffers_per_device_;
+  }
+
+  PageCacheOptions& set_registered_page_buffers_per_device(usize n)
+  {
+    this->registered_page_buffers_per_device_ = n;
+    return *this;
+  }
+
+  /** \brief Controls which page reads have their checksums checked; see PageValidationPolicy.
+   * The default is kFull.
+   */
+  PageValidationPolicy page_validation_policy() const
+  {
+    return this->page_validation_policy_;
+  }
+
+  PageCacheOptions& set_page_validation_policy(PageValidationPolicy policy)
+  {
+    this->page_validation_policy_ = policy;
+    return *this;
+  }
+
+  /** \brief The fraction (0..1) of page reads that are checked under
+   * PageValidationPolicy::kSampled.
+   */
+  double page_validation_sample_rate() const
+  {
+    return this->page_validation_sample_rate_;
+  }
+
+  PageCacheOptions& set_page_validation_sample_rate(double rate)
+  {
+    BATT_CHECK_GE(rate, 0.0);
+    BATT_CHECK_LE(rate, 1.0);
+    this->page_validation_sample_rate_ = rate;
+    return *this;
+  }
+
+  /** \brief The maximum rate at which the background scrubber reads pages, under
+   * PageValidationPolicy::kBackgroundScrub.
+   */
+  double background_scrub_pages_per_second() const
+  {
+    return this->background_scrub_pages_per_second_;
+  }
+
+  PageCacheOptions& set_background_scrub_pages_per_second(double rate)
+  {
+    BATT_CHECK_GT(rate, 0.0);
+    this->background_scrub_pages_per_second_ = rate;
+    return *this;
+  }
+
+  /** \brief If true, the PageCache builds the filter (see PageView::build_filter) of each page it
+   * writes or loads on a background task, and keeps the filters of all pages (even those that
+   * have been evicted from the cache) so that PageCache::page_might_contain_key can answer without
+   * loading the page.
+   */
+  bool page_filter_index() const
+  {
+    return this->page_filter_index_;
+  }
+
+  PageCacheOptions& set_page_filter_index(bool enabled)
+  {
+    this->page_filter_index_ = enabled;
+    return *this;
+  }
+
+  /** \brief The maximum number of pages waiting for their filters to be built (when
+   * page_filter_index() is true); beyond this, new pages are skipped (and their filters are built
+   * the next time they are loaded).
+   */
+  usize max_page_filter_build_queue_depth() const
+  {
+    return this->max_page_filter_build_queue_depth_;
+  }
+
+  PageCacheOptions& set_max_page_filter_build_queue_depth(usize n)
+  {
+    this->max_page_filter_build_queue_depth_ = n;
+    return *this;
+  }
+
+  /** \brief If set (and page_filter_index() is true), the page filters that are built for each
+   * PageDevice are also appended to a file in this directory (see PageFilterFile), from which they
+   * are all loaded when the PageCache is created.
+   */
+  const Optional<std::string>& page_filter_file_dir() const
+  {
+    return this->page_filter_file_dir_;
+  }
+
+  PageCacheOptions& set_page_filter_file_dir(const Optional<std::string>& dir)
+  {
+    this->page_filter_file_dir_ = dir;
+    return *this;
+  }
+
+  /** \brief If set, every page lookup (PageCache::get_page, get_pages) is recorded in this file
+   * (see PageCacheTraceRecorder), for offline analysis with replay_page_cache_trace.
+   */
+  const Optional<std::string>& page_cache_trace_file() const
+  {
+    return this->page_cache_trace_file_;
+  }
+
+  PageCacheOptions& set_page_cache_trace_file(const Optional<std::string>& file_name)
+  {
+    this->page_cache_trace_file_ = file_name;
+    return *this;
+  }
+
+  /** \brief The number of records held in memory by the trace recorder (when
+   * page_cache_trace_file() is set); records are written out each time half of them are filled.
+   */
+  usize page_cache_trace_buffer_size() const
+  {
+    return this->page_cache_trace_buffer_size_;
+  }
+
+  PageCacheOptions& set_page_cache_trace_buffer_size(usize n)
+  {
+    BATT_CHECK_GE(n, 2u);
+    this->page_cache_trace_buffer_size_ = n;
+    return *this;
+  }
+
+  /** \brief If set, the ids of the hottest pages in the cache are periodically written to this
+   * file (see PageCacheWarmStart), so that PageCache::start_warm_start can reload them after a
+   * restart.
+   */
+  const Optional<std::string>& warm_start_file() const
+  {
+    return this->warm_start_file_;
+  }
+
+  PageCacheOptions& set_warm_start_file(const Optional<std::string>& file_name)
+  {
+    this->warm_start_file_ = file_name;
+    return *this;
+  }
+
+  /** \brief How often the hot page list is written to warm_start_file(), in seconds; it is also
+   * written when the PageCache is closed.
+   */
+  double warm_start_save_interval_sec() const
+  {
+    return this->warm_start_save_interval_sec_;
+  }
+
+  PageCacheOptions& set_warm_start_save_interval_sec(double interval)
+  {
+    BATT_CHECK_GT(interval, 0.0);
+    this->warm_start_save_interval_sec_ = interval;
+    return *this;
+  }
+
+  /** \brief The maximum number of pages in the hot page list (the most recently used ones are
+   * kept); 0 means every cached page.
+   */
+  usize warm_start_max_pages() const
+  {
+    return this->warm_start_max_pages_;
+  }
+
+  PageCacheOptions& set_warm_start_max_pages(usize n)
+  {
+    this->warm_start_max_pages_ = n;
+    return *this;
+  }
+
+  /** \brief The maximum number of page reads in flight while the hot page list is being reloaded.
+   */
+  usize warm_start_max_in_flight() const
+  {
+    return this->warm_start_max_in_flight_;
+  }
+
+  PageCacheOptions& set_warm_start_max_in_flight(usize n)
+  {
+    BATT_CHECK_GT(n, 0u);
+    this->warm_start_max_in_flight_ = n;
+    return *this;
+  }
+
+  /** \brief If non-zero, pages whose cache slot is seen pinned by at least this many holders at
+   * once are replicated into per-CPU replica sets (see HotPageReplicas), so that hot pages (e.g.,
+   * tree roots) don't make every core contend on a single pin count.  0 (the default) disables
+   * replication.
+   */
+  u32 hot_page_replica_pin_threshold() const
+  {
+    return this->hot_page_replica_pin_threshold_;
+  }
+
+  PageCacheOptions& set_hot_page_replica_pin_threshold(u32 n)
+  {
+    this->hot_page_replica_pin_threshold_ = n;
+    return *this;
+  }
+
+  /** \brief The number of replica sets per device when hot page replication is enabled; 0 (the
+   * default) means one per CPU.
+   */
+  usize hot_page_replica_sets() const
+  {
+    return this->hot_page_replica_sets_;
+  }
+
+  PageCacheOptions& set_hot_page_replica_sets(usize n)
+  {
+    this->hot_page_replica_sets_ = n;
+    return *this;
+  }
+
+  /** \brief The number of pages each replica set can hold.
+   */
+  usize hot_page_replica_slots() const
+  {
+    return this->hot_page_replica_slots_;
+  }
+
+  PageCacheOptions& set_hot_page_replica_slots(usize n)
+  {
+    BATT_CHECK_GT(n, 0u);
+    this->hot_page_replica_slots_ = n;
+    return *this;
+  }
+
+  /** \brief If non-zero, one of every this many page lookups is sampled to attribute cache hits,
+   * misses and wait time to page layouts and key ranges (see PageCacheAccessStats and
+   * PageCache::access_stats()).  0 (the default) disables sampling.
+   */
+  u32 access_stats_sample_interval() const
+  {
+    return this->access_stats_sample_interval_;
+  }
+
+  PageCacheOptions& set_access_stats_sample_interval(u32 n)
+  {
+    this->access_stats_sample_interval_ = n;
+    return *this;
+  }
+
+  /** \brief The number of key ranges tracked by the access stats (the most frequently missed ones
+   * are kept).
+   */
+  usize access_stats_max_key_ranges() const
+  {
+    return this->access_stats_max_key_ranges_;
+  }
+
+  PageCacheOptions& set_access_stats_max_key_ranges(usize n)
+  {
+    this->access_stats_max_key_ranges_ = n;
+    return *this;
+  }
+
+  /** \brief Page min/max keys are truncated to this many bytes when attributing lookups to key
+   * ranges.
+   */
+  usize access_stats_key_prefix_size() const
+  {
+    return this->access_stats_key_prefix_size_;
+  }
+
+  PageCacheOptions& set_access_stats_key_prefix_size(usize n)
+  {
+    this->access_stats_key_prefix_size_ = n;
+    return *this;
+  }
+
+  /** \brief If non-zero, the PageCache keeps a PageDedupIndex of up to this many recently
+   * committed pages, which PageCacheJob::pin_new_or_dedup consults to avoid writing pages that are
+   * byte-identical to existing ones.  0 (the default) disables deduplication.
+   */
+  usize dedup_index_max_entries() const
+  {
+    return this->dedup_index_max_entries_;
+  }
+
+  PageCacheOptions& set_dedup_index_max_entries(usize n)
+  {
+    this->dedup_index_max_entries_ = n;
+    return *this;
+  }
+
+  /** \brief The longest chain of delta pages that PageCacheJob::pin_new_as_delta may create (i.e.,
+   * the most delta images that have to be applied to materialize a page); a page whose base is
+   * already at this depth is written in full instead, which starts a new chain.  0 disables delta
+   * pages.
+   */
+  u16 max_delta_chain_depth() const
+  {
+    return this->max_delta_chain_depth_;
+  }
+
+  PageCacheOptions& set_max_delta_chain_depth(u16 depth)
+  {
+    this->max_delta_chain_depth_ = depth;
+    return *this;
+  }
+
+  /** \brief If true, pages loaded through get_page (or get_pages) are published to pin-free readers
+   * (see PageCache::try_read_page_optimistic).  A published view outlives its slot's eviction until
+   * no optimistic reader can still see it (see OptimisticReadEpoch), which costs some work on every
+   * eviction; so this is off by default, and try_read_page_optimistic always returns None.
+   */
+  bool optimistic_reads() const
+  {
+    return this->optimistic_reads_;
+  }
+
+  PageCacheOptions& set_optimistic_reads(bool enabled)
+  {
+    this->optimistic_reads_ = enabled;
+    return *this;
+  }
+
   std::array<usize, kMaxPageSizeLog2> max_cached_pages_per_size_log2;
 
  private:
   u64 default_log_size_;
+  bool numa_sharded_slot_pools_;
+  bool scan_resistant_admission_;
+  bool clock_pro_eviction_;
+  bool cache_line_isolated_slots_;
+  u64 max_cache_bytes_;
+  u64 max_resizable_cache_bytes_;
+  usize max_prefetch_in_flight_per_device_;
+  usize registered_page_buffers_per_device_;
+  PageValidationPolicy page_validation_policy_;
+  double page_validation_sample_rate_;
+  double background_scrub_pages_per_second_;
+  bool page_filter_index_;
+  usize max_page_filter_build_queue_depth_;
+  Optional<std::string> page_filter_file_dir_;
+  Optional<std::string> page_cache_trace_file_;
+  usize page_cache_trace_buffer_size_;
+  Optional<std::string> warm_start_file_;
+  double warm_start_save_interval_sec_;
+  usize warm_start_max_pages_;
+  usize warm_start_max_in_flight_;
+  u32 hot_page_replica_pin_threshold_;
+  usize hot_page_replica_sets_;
+  usize hot_page_replica_slots_;
+  u32 access_stats_sample_interval_;
+  usize access_stats_max_key_ranges_;
+  usize access_stats_key_prefix_size_;
+  usize dedup_index_max_entries_;
+  u16 max_delta_chain_depth_;
+  bool optimistic_reads_;
 };
 
 }  // namespace llfs
@@ -0,0 +1,29 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_cache_priority.hpp>
+//
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, PageCachePriority t)
+{
+  switch (t) {
+    case PageCachePriority::kLow:
+      return out << "Low";
+    case PageCachePriority::kNormal:
+      return out << "Normal";
+    case PageCachePriority::kHigh:
+      return out << "High";
+  }
+  return out << "(bad:PageCachePriority)" << (int)t;
+}
+
+}  //namespace llfs
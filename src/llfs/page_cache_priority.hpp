@@ -0,0 +1,45 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_CACHE_PRIORITY_HPP
+#define LLFS_PAGE_CACHE_PRIORITY_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+
+#include <ostream>
+
+namespace llfs {
+
+// How valuable a cached page is, relative to other pages; biases eviction in PageCacheSlot::Pool.
+// The priority of a page comes from its layout (see PageCache::set_page_priority), except that
+// pages prefetched by the recycler are always kLow.
+//
+enum struct PageCachePriority : u8 {
+  // Pages that are unlikely to be used again soon (e.g., pages loaded by the recycler); these are
+  // evicted before any kNormal or kHigh page.
+  //
+  kLow = 0,
+
+  // The default.
+  //
+  kNormal = 1,
+
+  // Pages that are used much more often than their recency alone would suggest (e.g., the internal
+  // nodes of an index); these stay cached for a while after they would otherwise be evicted.
+  //
+  kHigh = 2,
+};
+
+std::ostream& operator<<(std::ostream& out, PageCachePriority t);
+
+}  //namespace llfs
+
+#endif  // LLFS_PAGE_CACHE_PRIORITY_HPP
@@ -162,6 +162,12 @@ void PageCacheSlot::extend_pin() noexcept
 void PageCacheSlot::update_latest_use() noexcept
 {
   this->latest_use_.store(LRUClock::advance_local());
+
+  // Check with a plain load first so that repeated hits don't need an atomic read-modify-write.
+  //
+  if ((this->clock_state_.load(std::memory_order_relaxed) & Self::kClockReferenced) == 0) {
+    this->clock_state_.fetch_or(Self::kClockReferenced);
+  }
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -169,6 +175,7 @@ void PageCacheSlot::update_latest_use() noexcept
 void PageCacheSlot::set_obsolete_hint() noexcept
 {
   this->latest_use_.store(LRUClock::read_global() - (i64{1} << 56));
+  this->clock_state_.fetch_and(static_cast<u8>(~Self::kClockReferenced));
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -178,6 +185,47 @@ i64 PageCacheSlot::get_latest_use() const noexcept
   return this->latest_use_.load();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheSlot::set_priority(PageCachePriority priority) noexcept
+{
+  this->priority_.store(priority, std::memory_order_relaxed);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCachePriority PageCacheSlot::priority() const noexcept
+{
+  return this->priority_.load(std::memory_order_relaxed);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheSlot::set_prefetch_hint() noexcept
+{
+  this->prefetch_hint_.store(true);
+  this->latest_use_.store(LRUClock::advance_local() + kPrefetchGracePeriod);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheSlot::set_low_priority_prefetch_hint() noexcept
+{
+  this->prefetch_hint_.store(true);
+  this->set_obsolete_hint();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool PageCacheSlot::consume_prefetch_hint() noexcept
+{
+  // Check with a plain load first so that the common (not prefetched) case doesn't dirty the cache
+  // line.
+  //
+  return this->prefetch_hint_.load(std::memory_order_relaxed) &&
+         this->prefetch_hint_.exchange(false);
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 void PageCacheSlot::release_pin() noexcept
@@ -221,6 +269,8 @@ bool PageCacheSlot::evict() noexcept
     const auto target_state = observed_state & ~kValidMask;
     if (this->state_.compare_exchange_weak(observed_state, target_state)) {
       BATT_CHECK(!this->is_valid());
+      this->generation_.fetch_add(1, std::memory_order_release);
+      this->release_charge();
       return true;
     }
   }
@@ -258,6 +308,8 @@ bool PageCacheSlot::evict_if_key_equals(PageId key) noexcept
 
     if (this->state_.compare_exchange_weak(observed_state, target_state)) {
       BATT_CHECK(!Self::is_valid());
+      this->generation_.fetch_add(1, std::memory_order_release);
+      this->release_charge();
       return true;
     }
   }
@@ -271,8 +323,15 @@ auto PageCacheSlot::fill(PageId key) noexcept -> PinnedRef
   BATT_CHECK(key.is_valid());
 
   this->key_ = key;
+  this->retire_published_view();
   this->value_.emplace();
-  this->update_latest_use();
+  this->prefetch_hint_.store(false);
+  this->set_priority(PageCachePriority::kNormal);
+
+  // Don't call update_latest_use, since loading a page doesn't count as a reference (see
+  // kClockReferenced); the pool sets the initial CLOCK state when the slot is allocated.
+  //
+  this->latest_use_.store(LRUClock::advance_local());
 
   auto observed_state = this->state_.fetch_add(kPinCountDelta) + kPinCountDelta;
   BATT_CHECK_EQ(observed_state & Self::kOverflowMask, 0);
@@ -291,10 +350,89 @@ void PageCacheSlot::clear() noexcept
   BATT_CHECK(!this->is_valid());
 
   this->key_ = PageId{};
+  this->retire_published_view();
   this->value_ = None;
   this->set_valid();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheSlot::publish_view(const std::shared_ptr<const PageView>& view) noexcept
+{
+  BATT_CHECK(this->is_pinned());
+
+  if (!view || this->published_view_.load(std::memory_order_relaxed) != nullptr) {
+    return;
+  }
+
+  // Only the caller that wins the race to publish may set the owning reference; it is read again
+  // only by fill/clear, which can't run until this slot is unpinned and evicted.
+  //
+  const PageView* expected = nullptr;
+  if (this->published_view_.compare_exchange_strong(expected, view.get(),
+                                                    std::memory_order_release)) {
+    this->published_view_owner_ = view;
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto PageCacheSlot::begin_optimistic_read(PageId key, const OptimisticReadEpoch::Guard& /*guard*/)
+    const noexcept -> Optional<OptimisticRead>
+{
+  // Read the generation *before* checking anything else; if the slot is evicted at any point after
+  // this, validate_optimistic_read will fail.
+  //
+  const u64 generation = this->generation_.load(std::memory_order_acquire);
+
+  if (!Self::is_valid(this->state_.load(std::memory_order_acquire))) {
+    return None;
+  }
+
+  const PageView* const view = this->published_view_.load(std::memory_order_acquire);
+  if (view == nullptr || view->page_id() != key) {
+    return None;
+  }
+
+  return OptimisticRead{
+      .slot = this,
+      .view = view,
+      .generation = generation,
+  };
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool PageCacheSlot::validate_optimistic_read(const OptimisticRead& read) const noexcept
+{
+  // Make sure all the reads done under the optimistic read happen before we re-check the
+  // generation.
+  //
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  return read.slot == this && this->generation_.load(std::memory_order_relaxed) == read.generation;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheSlot::retire_published_view() noexcept
+{
+  // Nothing is published unless PageCacheOptions::optimistic_reads() is on; skip the fence (in
+  // OptimisticReadEpoch::retire) in the common case.
+  //
+  if (!this->published_view_owner_) {
+    return;
+  }
+
+  // Optimistic readers that started before the eviction may still be reading the old view, so it
+  // can't be released until they are done.
+  //
+  this->published_view_.store(nullptr, std::memory_order_relaxed);
+
+  OptimisticReadEpoch::instance().retire(std::move(this->published_view_owner_));
+  this->published_view_owner_ = nullptr;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 void PageCacheSlot::notify_first_ref_acquired()
@@ -317,4 +455,14 @@ void PageCacheSlot::set_valid()
   BATT_CHECK(!this->is_valid(observed_state)) << "Must go from an invalid state to valid!";
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheSlot::release_charge() noexcept
+{
+  const usize charged_size = this->charged_size_.exchange(0, std::memory_order_relaxed);
+  if (charged_size != 0) {
+    this->pool_.release_bytes(charged_size);
+  }
+}
+
 }  //namespace llfs
@@ -14,7 +14,9 @@
 //
 #include <llfs/int_types.hpp>
 #include <llfs/lru_clock.hpp>
+#include <llfs/optimistic_read_epoch.hpp>
 #include <llfs/optional.hpp>
+#include <llfs/page_cache_priority.hpp>
 #include <llfs/page_id.hpp>
 #include <llfs/page_view.hpp>
 
@@ -94,6 +96,21 @@ class PageCacheSlot
    */
   static constexpr u64 kValidMask = 1;
 
+  /** \brief The number of logical timestamp ticks by which a newly prefetched slot's latest use time
+   * is moved into the future, to protect the slot from eviction until it is first used.
+   */
+  static constexpr i64 kPrefetchGracePeriod = 4096;
+
+  /** \brief Bits of the CLOCK state of a slot (only used by pools whose eviction policy is
+   * EvictionPolicy::kClockPro): set each time the slot is used...
+   */
+  static constexpr u8 kClockReferenced = 1;
+
+  /** \brief ...and set while the slot holds a "hot" page, i.e. one that was used again after it
+   * was loaded (or that was reloaded shortly after being evicted).
+   */
+  static constexpr u8 kClockHot = 2;
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   // Forward-declarations of member types.
@@ -102,6 +119,14 @@ class PageCacheSlot
   class AtomicRef;  // defined in <llfs/page_cache_slot_atomic_ref.hpp>
   class PinnedRef;  // defined in <llfs/page_cache_slot_pinned_ref.hpp>
 
+  /** \brief A snapshot taken by begin_optimistic_read; see validate_optimistic_read.
+   */
+  struct OptimisticRead {
+    const PageCacheSlot* slot;
+    const PageView* view;
+    u64 generation;
+  };
+
   using Self = PageCacheSlot;
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -262,6 +287,7 @@ class PageCacheSlot
   /** \brief Updates the latest use logical timestamp for this object, to make eviction less likely.
    *
    * Only has an effect if the "obsolete hint" (see set_obsolete_hint, get_obsolete_hint) is false.
+   * Also sets the slot's CLOCK reference bit (see kClockReferenced).
    */
   void update_latest_use() noexcept;
 
@@ -275,6 +301,76 @@ class PageCacheSlot
    */
   i64 get_latest_use() const noexcept;
 
+  /** \brief Sets the cache priority of the page in this slot (see PageCachePriority); called once
+   * the page has been loaded.  Reset to kNormal by fill.
+   */
+  void set_priority(PageCachePriority priority) noexcept;
+
+  /** \brief Returns the cache priority of the page in this slot.
+   */
+  PageCachePriority priority() const noexcept;
+
+  /** \brief Marks this slot as "prefetched, not yet used."
+   *
+   * The latest use LTS is set kPrefetchGracePeriod ticks into the future, giving the slot a short
+   * grace period from eviction so that it survives until the reader that requested the prefetch
+   * gets to it.
+   */
+  void set_prefetch_hint() noexcept;
+
+  /** \brief Like set_prefetch_hint, but for pages that will be used once, soon, and then never
+   * again.
+   *
+   * Instead of a grace period, the latest use LTS is set to a very old value (as by
+   * set_obsolete_hint), so that while it waits to be used, the slot is evicted before any slot
+   * holding a page that was actually used.
+   */
+  void set_low_priority_prefetch_hint() noexcept;
+
+  /** \brief Clears the prefetch hint (see set_prefetch_hint); returns true iff the hint was set.
+   *
+   * This is called when a prefetched page is first used (a prefetch "hit") and when a prefetched
+   * slot is evicted without being used (a prefetch "waste").
+   */
+  bool consume_prefetch_hint() noexcept;
+
+  /** \brief Returns the number of bytes charged to the pool for this slot's current contents (see
+   * Pool::allocate); the charge is released when the slot is evicted.
+   */
+  usize charged_size() const noexcept
+  {
+    return this->charged_size_.load(std::memory_order_relaxed);
+  }
+
+  //----- --- -- -  -  -   -
+  /** \brief Makes the loaded view of this slot available to optimistic (pin-free) readers; see
+   * begin_optimistic_read.
+   *
+   * Must be called with the slot pinned, and `view` must be the value of the slot's Latch.  Only
+   * the first call after each fill has any effect.
+   */
+  void publish_view(const std::shared_ptr<const PageView>& view) noexcept;
+
+  /** \brief Starts a seqlock-style read of the page `key` without pinning the slot.
+   *
+   * Returns None if the slot doesn't currently hold a published view of `key` (in which case the
+   * caller should fall back on pinning the slot).  Otherwise the returned view may be read, but
+   * nothing derived from it may be trusted (or used to follow pointers outside the page) until
+   * validate_optimistic_read returns true; if it returns false, the slot was evicted during the
+   * read, and the results must be thrown away.
+   *
+   * The view stays alive for as long as `guard` does, even if the slot is evicted and reused (see
+   * OptimisticReadEpoch), so the guard must outlive every use of the view; it must also be short
+   * lived, since it delays the release of all views retired while it exists.
+   */
+  Optional<OptimisticRead> begin_optimistic_read(PageId key,
+                                                 const OptimisticReadEpoch::Guard& guard) const
+      noexcept;
+
+  /** \brief Returns true iff the slot has not been evicted since `read` was started.
+   */
+  bool validate_optimistic_read(const OptimisticRead& read) const noexcept;
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
  private:
   /** \brief The implementation of acquire_pin; returns true iff successful.
@@ -293,6 +389,16 @@ class PageCacheSlot
    */
   void set_valid();
 
+  /** \brief Returns this slot's charged size (if any) to the pool; called when the slot is evicted.
+   */
+  void release_charge() noexcept;
+
+  /** \brief Stops publishing the current view to optimistic readers (see publish_view), and hands
+   * it to OptimisticReadEpoch to be released once no reader can see it; called when the slot is
+   * filled or cleared, which is only allowed after it has been evicted.
+   */
+  void retire_published_view() noexcept;
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   Pool& pool_;
@@ -301,6 +407,30 @@ class PageCacheSlot
   std::atomic<u64> state_{0};
   std::atomic<u64> ref_count_{0};
   std::atomic<i64> latest_use_{0};
+  std::atomic<usize> charged_size_{0};
+
+  // Incremented each time the slot is evicted; used to validate optimistic reads.
+  //
+  std::atomic<u64> generation_{0};
+
+  // The single-byte fields are grouped together so they share one word instead of each being
+  // padded out to 8 bytes (every byte counts here, since a large cache has millions of slots).
+  //
+  std::atomic<bool> prefetch_hint_{false};
+
+  // kClockReferenced | kClockHot; see Pool::evict_clock_pro.
+  //
+  std::atomic<u8> clock_state_{0};
+
+  // See set_priority.
+  //
+  std::atomic<PageCachePriority> priority_{PageCachePriority::kNormal};
+
+  // The view read by begin_optimistic_read (set by publish_view), and the reference that keeps it
+  // alive.  When the slot is refilled or cleared, the reference is retired to OptimisticReadEpoch.
+  //
+  std::atomic<const PageView*> published_view_{nullptr};
+  std::shared_ptr<const PageView> published_view_owner_;
 };
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
@@ -13,8 +13,16 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <llfs/opaque_page_view.hpp>
+#include <llfs/optimistic_read_epoch.hpp>
+#include <llfs/page_buffer.hpp>
+
 #include <batteries/utility.hpp>
 
+#include <memory>
+#include <thread>
+#include <vector>
+
 namespace {
 
 // Test Plan:
@@ -46,6 +54,41 @@ namespace {
 //     c. Valid + Filled + Pinned
 //  8. update_latest_use
 //  9. set_obsolete_hint
+// 10. Sharded pool: allocation prefers the requested shard, then steals from others when full
+// 11. set_prefetch_hint protects a slot from eviction until the hint is consumed
+// 12. Evicting a prefetched slot that was never used counts as prefetch waste
+// 13. set_low_priority_prefetch_hint makes a slot the first to be evicted
+// 14. Byte-budgeted pool:
+//     a. charges beyond max_bytes evict other slots, even if there are unused slots
+//     b. evicting a slot releases its charge
+//     c. allocate returns nullptr (and undoes the charge) if all other slots are pinned
+//     d. larger pages are evicted before smaller, less recently used ones
+// 15. set_max_bytes resizes a pool at runtime: shrinking evicts unpinned slots right away, growing
+//     lets more pages be charged
+// 16. Optimistic reads:
+//     a. fail until a view is published, and for the wrong key
+//     b. succeed (and validate) while the slot is unpinned but not evicted
+//     c. fail to validate if the slot is evicted during the read
+//     d. fail after the slot is refilled, until the new view is published
+//     e. a view retired during a read stays alive until the reader's Guard is gone
+//     f. with no readers, the view of a cleared slot is released by the next reclaim
+//     g. a thread's retired views are released once it has retired a full batch, and views left
+//        behind by a thread that has exited are released by a later reclaim
+// 17. EvictionPolicy::kClockPro:
+//     a. referenced slots get a second chance (and are promoted to hot); unreferenced cold slots
+//        are evicted in clock order
+//     b. a page reloaded while its key is in the test table starts out hot
+//     c. set_eviction_policy panics once slots have been allocated
+// 18. PageCachePriority:
+//     a. a kLow slot is evicted before an older kNormal slot; a kHigh slot outlives a newer
+//        kNormal slot; fill resets the priority to kNormal
+//     b. under kClockPro, a cold kHigh slot is promoted instead of evicted, and a referenced kLow
+//        slot is evicted anyway
+// 19. Slot layout:
+//     a. by default, slots are packed back to back (no cache line padding)
+//     b. set_cache_line_isolation(true) puts each slot in its own cache line(s); index_of and
+//        get_slot still agree
+//     c. set_cache_line_isolation panics once slots have been allocated
 //
 
 using namespace llfs::int_types;
@@ -424,4 +467,646 @@ TEST_F(PageCacheSlotTest, LatestUse)
   EXPECT_LT(t2 - t1, 0);
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 10. Sharded pool: allocation prefers the requested shard, then steals from others when full
+//
+TEST(PageCacheSlotPoolTest, ShardedAllocate)
+{
+  constexpr usize kNumShards = 2;
+  constexpr usize kSlotsPerShard = 4;
+
+  boost::intrusive_ptr<llfs::PageCacheSlot::Pool> pool = llfs::PageCacheSlot::Pool::make_new(
+      /*n_slots=*/kNumShards * kSlotsPerShard, batt::make_copy(kTestPoolName),
+      /*eviction_candidates=*/llfs::PageCacheSlot::Pool::kDefaultEvictionCandidates,
+      /*n_shards=*/kNumShards);
+
+  EXPECT_EQ(pool->shard_count(), kNumShards);
+  EXPECT_LT(pool->local_shard_index(), kNumShards);
+
+  // The first kSlotsPerShard allocations from shard 1 should come from the upper half of the pool.
+  //
+  for (usize i = 0; i < kSlotsPerShard; ++i) {
+    llfs::PageCacheSlot* slot = pool->allocate(/*preferred_shard=*/1);
+
+    ASSERT_NE(slot, nullptr);
+    EXPECT_EQ(slot->index(), kSlotsPerShard + i);
+  }
+  EXPECT_EQ(pool->metrics().steal_count.load(), 0u);
+
+  // Shard 1 is now full and none of its slots are evictable (they are all Invalid), so the next
+  // allocation must be stolen from shard 0.
+  //
+  {
+    llfs::PageCacheSlot* slot = pool->allocate(/*preferred_shard=*/1);
+
+    ASSERT_NE(slot, nullptr);
+    EXPECT_EQ(slot->index(), 0u);
+    EXPECT_EQ(pool->metrics().steal_count.load(), 1u);
+  }
+
+  // Allocating from shard 0 directly is not a steal.
+  //
+  for (usize i = 1; i < kSlotsPerShard; ++i) {
+    llfs::PageCacheSlot* slot = pool->allocate(/*preferred_shard=*/0);
+
+    ASSERT_NE(slot, nullptr);
+    EXPECT_EQ(slot->index(), i);
+  }
+  EXPECT_EQ(pool->metrics().steal_count.load(), 1u);
+
+  // Now the whole pool is full of un-evictable slots.
+  //
+  EXPECT_EQ(pool->allocate(/*preferred_shard=*/0), nullptr);
+  EXPECT_EQ(pool->allocate(/*preferred_shard=*/1), nullptr);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 11. set_prefetch_hint protects a slot from eviction until the hint is consumed
+//
+TEST_F(PageCacheSlotTest, PrefetchHintGracePeriod)
+{
+  std::vector<llfs::PageCacheSlot*> slots;
+  for (usize i = 0; i < kNumTestSlots; ++i) {
+    llfs::PageCacheSlot* slot = this->pool_->allocate();
+    ASSERT_NE(slot, nullptr);
+    (void)slot->fill(llfs::PageId{i + 1});
+    slots.emplace_back(slot);
+  }
+
+  llfs::PageCacheSlot* const prefetched_slot = slots[0];
+  prefetched_slot->set_prefetch_hint();
+
+  // Churn through the rest of the pool a few times; the prefetched slot should never be chosen for
+  // eviction, since its latest use time is in the (near) future.
+  //
+  for (usize i = 0; i < kNumTestSlots * 4; ++i) {
+    llfs::PageCacheSlot* evicted = this->pool_->allocate();
+
+    ASSERT_NE(evicted, nullptr);
+    EXPECT_NE(evicted, prefetched_slot);
+
+    (void)evicted->fill(llfs::PageId{kNumTestSlots + i + 1});
+  }
+
+  EXPECT_TRUE(prefetched_slot->is_valid());
+  EXPECT_EQ(prefetched_slot->key(), llfs::PageId{1});
+  EXPECT_EQ(this->pool_->metrics().prefetch_waste_count.load(), 0u);
+
+  EXPECT_TRUE(prefetched_slot->consume_prefetch_hint());
+  EXPECT_FALSE(prefetched_slot->consume_prefetch_hint());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 12. Evicting a prefetched slot that was never used counts as prefetch waste
+//
+TEST(PageCacheSlotPoolTest, PrefetchWaste)
+{
+  boost::intrusive_ptr<llfs::PageCacheSlot::Pool> pool =
+      llfs::PageCacheSlot::Pool::make_new(/*n_slots=*/1, batt::make_copy(kTestPoolName));
+
+  llfs::PageCacheSlot* slot = pool->allocate();
+  ASSERT_NE(slot, nullptr);
+  (void)slot->fill(llfs::PageId{1});
+  slot->set_prefetch_hint();
+
+  EXPECT_EQ(pool->allocate(), slot);
+  EXPECT_EQ(pool->metrics().prefetch_waste_count.load(), 1u);
+
+  // Re-filling the slot clears the hint.
+  //
+  (void)slot->fill(llfs::PageId{2});
+
+  EXPECT_FALSE(slot->consume_prefetch_hint());
+  EXPECT_EQ(pool->allocate(), slot);
+  EXPECT_EQ(pool->metrics().prefetch_waste_count.load(), 1u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 13. set_low_priority_prefetch_hint makes a slot the first to be evicted
+//
+TEST(PageCacheSlotPoolTest, LowPriorityPrefetchEvictedFirst)
+{
+  boost::intrusive_ptr<llfs::PageCacheSlot::Pool> pool =
+      llfs::PageCacheSlot::Pool::make_new(/*n_slots=*/2, batt::make_copy(kTestPoolName));
+
+  llfs::PageCacheSlot* used_slot = pool->allocate();
+  ASSERT_NE(used_slot, nullptr);
+  (void)used_slot->fill(llfs::PageId{1});
+
+  // The low-priority prefetch is more recent than `used_slot`, but it should still be evicted
+  // first.
+  //
+  llfs::PageCacheSlot* prefetched_slot = pool->allocate();
+  ASSERT_NE(prefetched_slot, nullptr);
+  (void)prefetched_slot->fill(llfs::PageId{2});
+  prefetched_slot->set_low_priority_prefetch_hint();
+
+  EXPECT_LT(prefetched_slot->get_latest_use(), used_slot->get_latest_use());
+
+  EXPECT_EQ(pool->allocate(), prefetched_slot);
+  EXPECT_EQ(pool->metrics().prefetch_waste_count.load(), 1u);
+  EXPECT_TRUE(used_slot->is_valid());
+  EXPECT_EQ(used_slot->key(), llfs::PageId{1});
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 14a. charges beyond max_bytes evict other slots, even if there are unused slots
+//
+TEST(PageCacheSlotPoolTest, ByteBudgetEviction)
+{
+  boost::intrusive_ptr<llfs::PageCacheSlot::Pool> pool = llfs::PageCacheSlot::Pool::make_new(
+      /*n_slots=*/4, batt::make_copy(kTestPoolName),
+      /*eviction_candidates=*/llfs::PageCacheSlot::Pool::kDefaultEvictionCandidates,
+      /*n_shards=*/1, /*max_bytes=*/8192);
+
+  EXPECT_EQ(pool->max_bytes(), 8192u);
+
+  for (usize i = 0; i < 2; ++i) {
+    llfs::PageCacheSlot* slot = pool->allocate(0, llfs::PageId{}, /*charged_size=*/4096);
+    ASSERT_NE(slot, nullptr);
+    (void)slot->fill(llfs::PageId{i + 1});
+    EXPECT_EQ(slot->charged_size(), 4096u);
+  }
+  EXPECT_EQ(pool->bytes_in_use(), 8192u);
+  EXPECT_EQ(pool->metrics().size_evict_count.load(), 0u);
+
+  llfs::PageCacheSlot* third_slot = pool->allocate(0, llfs::PageId{}, /*charged_size=*/4096);
+  ASSERT_NE(third_slot, nullptr);
+  (void)third_slot->fill(llfs::PageId{3});
+
+  EXPECT_EQ(pool->bytes_in_use(), 8192u);
+  EXPECT_EQ(pool->metrics().size_evict_count.load(), 1u);
+  EXPECT_EQ(pool->metrics().charged_bytes.load(), 3 * 4096u);
+  EXPECT_EQ(pool->metrics().released_bytes.load(), 4096u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 14b. evicting a slot releases its charge
+//
+TEST(PageCacheSlotPoolTest, EvictReleasesCharge)
+{
+  boost::intrusive_ptr<llfs::PageCacheSlot::Pool> pool =
+      llfs::PageCacheSlot::Pool::make_new(/*n_slots=*/2, batt::make_copy(kTestPoolName));
+
+  EXPECT_EQ(pool->max_bytes(), 0u);
+
+  llfs::PageCacheSlot* slot = pool->allocate(0, llfs::PageId{}, /*charged_size=*/512);
+  ASSERT_NE(slot, nullptr);
+  (void)slot->fill(llfs::PageId{1});
+
+  EXPECT_EQ(pool->bytes_in_use(), 512u);
+
+  EXPECT_TRUE(slot->evict_if_key_equals(llfs::PageId{1}));
+  EXPECT_EQ(slot->charged_size(), 0u);
+  EXPECT_EQ(pool->bytes_in_use(), 0u);
+  EXPECT_EQ(pool->metrics().released_bytes.load(), 512u);
+
+  // Evicting again (after clear) must not release anything more.
+  //
+  slot->clear();
+  EXPECT_TRUE(slot->evict());
+  EXPECT_EQ(pool->bytes_in_use(), 0u);
+  EXPECT_EQ(pool->metrics().released_bytes.load(), 512u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 14c. allocate returns nullptr (and undoes the charge) if all other slots are pinned
+//
+TEST(PageCacheSlotPoolTest, ByteBudgetAllPinned)
+{
+  boost::intrusive_ptr<llfs::PageCacheSlot::Pool> pool = llfs::PageCacheSlot::Pool::make_new(
+      /*n_slots=*/4, batt::make_copy(kTestPoolName),
+      /*eviction_candidates=*/llfs::PageCacheSlot::Pool::kDefaultEvictionCandidates,
+      /*n_shards=*/1, /*max_bytes=*/8192);
+
+  std::vector<llfs::PageCacheSlot::PinnedRef> pins;
+  for (usize i = 0; i < 2; ++i) {
+    llfs::PageCacheSlot* slot = pool->allocate(0, llfs::PageId{}, /*charged_size=*/4096);
+    ASSERT_NE(slot, nullptr);
+    pins.emplace_back(slot->fill(llfs::PageId{i + 1}));
+  }
+
+  EXPECT_EQ(pool->allocate(0, llfs::PageId{}, /*charged_size=*/4096), nullptr);
+  EXPECT_EQ(pool->bytes_in_use(), 8192u);
+
+  // Once a pin is released, there is room again.
+  //
+  pins.pop_back();
+
+  llfs::PageCacheSlot* slot = pool->allocate(0, llfs::PageId{}, /*charged_size=*/4096);
+  EXPECT_NE(slot, nullptr);
+  EXPECT_EQ(pool->bytes_in_use(), 8192u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 14d. larger pages are evicted before smaller, less recently used ones
+//
+TEST(PageCacheSlotPoolTest, ByteBudgetPrefersLargePages)
+{
+  boost::intrusive_ptr<llfs::PageCacheSlot::Pool> pool = llfs::PageCacheSlot::Pool::make_new(
+      /*n_slots=*/2, batt::make_copy(kTestPoolName),
+      /*eviction_candidates=*/llfs::PageCacheSlot::Pool::kDefaultEvictionCandidates,
+      /*n_shards=*/1, /*max_bytes=*/1024 * 1024);
+
+  llfs::PageCacheSlot* small_slot = pool->allocate(0, llfs::PageId{}, /*charged_size=*/4096);
+  ASSERT_NE(small_slot, nullptr);
+  (void)small_slot->fill(llfs::PageId{1});
+
+  llfs::PageCacheSlot* large_slot = pool->allocate(0, llfs::PageId{}, /*charged_size=*/65536);
+  ASSERT_NE(large_slot, nullptr);
+  (void)large_slot->fill(llfs::PageId{2});
+
+  ASSERT_LT(small_slot->get_latest_use(), large_slot->get_latest_use());
+
+  EXPECT_EQ(pool->allocate(0, llfs::PageId{}, /*charged_size=*/4096), large_slot);
+  EXPECT_TRUE(small_slot->is_valid());
+  EXPECT_EQ(small_slot->key(), llfs::PageId{1});
+  EXPECT_EQ(pool->bytes_in_use(), 2 * 4096u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 15. set_max_bytes resizes a pool at runtime
+//
+TEST(PageCacheSlotPoolTest, SetMaxBytes)
+{
+  boost::intrusive_ptr<llfs::PageCacheSlot::Pool> pool = llfs::PageCacheSlot::Pool::make_new(
+      /*n_slots=*/4, batt::make_copy(kTestPoolName),
+      /*eviction_candidates=*/llfs::PageCacheSlot::Pool::kDefaultEvictionCandidates,
+      /*n_shards=*/1, /*max_bytes=*/4 * 4096);
+
+  llfs::PageCacheSlot::PinnedRef pinned;
+  for (usize i = 0; i < 4; ++i) {
+    llfs::PageCacheSlot* slot = pool->allocate(0, llfs::PageId{}, /*charged_size=*/4096);
+    ASSERT_NE(slot, nullptr);
+    if (i == 0) {
+      pinned = slot->fill(llfs::PageId{i + 1});
+    } else {
+      (void)slot->fill(llfs::PageId{i + 1});
+    }
+  }
+  EXPECT_EQ(pool->bytes_in_use(), 4 * 4096u);
+
+  // Shrink to two pages; everything but the pinned slot can be evicted.
+  //
+  EXPECT_TRUE(pool->set_max_bytes(2 * 4096));
+  EXPECT_EQ(pool->max_bytes(), 2 * 4096u);
+  EXPECT_EQ(pool->metrics().max_bytes.load(), 2 * 4096u);
+  EXPECT_LE(pool->bytes_in_use(), 2 * 4096u);
+
+  // Shrinking below the pinned slot can't be done right away.
+  //
+  EXPECT_FALSE(pool->set_max_bytes(1));
+  EXPECT_EQ(pool->bytes_in_use(), 4096u);
+  EXPECT_EQ(pool->allocate(0, llfs::PageId{}, /*charged_size=*/4096), nullptr);
+
+  // Grow back; pages can be charged again.
+  //
+  EXPECT_TRUE(pool->set_max_bytes(4 * 4096));
+
+  llfs::PageCacheSlot* slot = pool->allocate(0, llfs::PageId{}, /*charged_size=*/4096);
+  ASSERT_NE(slot, nullptr);
+  (void)slot->fill(llfs::PageId{10});
+
+  EXPECT_EQ(pool->bytes_in_use(), 2 * 4096u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 16. Optimistic reads
+//
+TEST_F(PageCacheSlotTest, OptimisticRead)
+{
+  const auto make_view = [](llfs::PageId page_id) -> std::shared_ptr<const llfs::PageView> {
+    return std::make_shared<llfs::OpaquePageView>(
+        llfs::PageBuffer::allocate(llfs::PageSize{4096}, page_id));
+  };
+
+  const llfs::OptimisticReadEpoch::Guard guard;
+
+  llfs::PageCacheSlot* slot = this->pool_->allocate();
+  const std::shared_ptr<const llfs::PageView> view1 = make_view(llfs::PageId{1});
+  {
+    llfs::PageCacheSlot::PinnedRef pinned = slot->fill(llfs::PageId{1});
+    pinned->set_value(batt::make_copy(view1));
+
+    // a. Nothing has been published yet.
+    //
+    EXPECT_FALSE(slot->begin_optimistic_read(llfs::PageId{1}, guard));
+
+    slot->publish_view(view1);
+  }
+  EXPECT_FALSE(slot->is_pinned());
+  EXPECT_FALSE(slot->begin_optimistic_read(llfs::PageId{2}, guard));
+
+  // b. The slot is unpinned but still valid.
+  //
+  {
+    llfs::Optional<llfs::PageCacheSlot::OptimisticRead> read =
+        slot->begin_optimistic_read(llfs::PageId{1}, guard);
+
+    ASSERT_TRUE(read);
+    EXPECT_EQ(read->view, view1.get());
+    EXPECT_EQ(read->view->page_id(), llfs::PageId{1});
+    EXPECT_TRUE(slot->validate_optimistic_read(*read));
+    EXPECT_FALSE(slot->is_pinned());
+  }
+
+  // c. Evict the slot in the middle of a read.
+  //
+  {
+    llfs::Optional<llfs::PageCacheSlot::OptimisticRead> read =
+        slot->begin_optimistic_read(llfs::PageId{1}, guard);
+
+    ASSERT_TRUE(read);
+    EXPECT_TRUE(slot->evict());
+    EXPECT_FALSE(slot->validate_optimistic_read(*read));
+    EXPECT_FALSE(slot->begin_optimistic_read(llfs::PageId{1}, guard));
+  }
+
+  // d. Refill the slot with another page.
+  //
+  {
+    const std::shared_ptr<const llfs::PageView> view2 = make_view(llfs::PageId{2});
+
+    llfs::PageCacheSlot::PinnedRef pinned = slot->fill(llfs::PageId{2});
+    pinned->set_value(batt::make_copy(view2));
+
+    EXPECT_FALSE(slot->begin_optimistic_read(llfs::PageId{1}, guard));
+    EXPECT_FALSE(slot->begin_optimistic_read(llfs::PageId{2}, guard));
+
+    slot->publish_view(view2);
+
+    llfs::Optional<llfs::PageCacheSlot::OptimisticRead> read =
+        slot->begin_optimistic_read(llfs::PageId{2}, guard);
+
+    ASSERT_TRUE(read);
+    EXPECT_EQ(read->view, view2.get());
+    EXPECT_TRUE(slot->validate_optimistic_read(*read));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 16. (e, f, g) Optimistic read reclamation
+//
+TEST_F(PageCacheSlotTest, OptimisticReadReclaim)
+{
+  const auto fill_and_publish = [](llfs::PageCacheSlot* slot,
+                                   llfs::PageId page_id) -> std::weak_ptr<const llfs::PageView> {
+    const std::shared_ptr<const llfs::PageView> view = std::make_shared<llfs::OpaquePageView>(
+        llfs::PageBuffer::allocate(llfs::PageSize{4096}, page_id));
+
+    llfs::PageCacheSlot::PinnedRef pinned = slot->fill(page_id);
+    pinned->set_value(batt::make_copy(view));
+    slot->publish_view(view);
+
+    return view;
+  };
+
+  llfs::PageCacheSlot* slot = this->pool_->allocate();
+
+  // e. A reader's Guard keeps the view alive after it is retired; it is released once the Guard is
+  //    gone.
+  //
+  const std::weak_ptr<const llfs::PageView> view1 = fill_and_publish(slot, llfs::PageId{1});
+  {
+    const llfs::OptimisticReadEpoch::Guard guard;
+
+    llfs::Optional<llfs::PageCacheSlot::OptimisticRead> read =
+        slot->begin_optimistic_read(llfs::PageId{1}, guard);
+    ASSERT_TRUE(read);
+
+    ASSERT_TRUE(slot->evict());
+    slot->clear();
+
+    EXPECT_FALSE(view1.expired());
+    EXPECT_EQ(read->view->page_id(), llfs::PageId{1});
+    EXPECT_FALSE(slot->validate_optimistic_read(*read));
+  }
+  EXPECT_FALSE(view1.expired());
+  EXPECT_EQ(llfs::OptimisticReadEpoch::instance().reclaim(), 0u);
+  EXPECT_TRUE(view1.expired());
+
+  // f. With no readers, the view of a cleared slot is released by the next reclaim.
+  //
+  ASSERT_TRUE(slot->evict());
+
+  const std::weak_ptr<const llfs::PageView> view2 = fill_and_publish(slot, llfs::PageId{2});
+  EXPECT_FALSE(view2.expired());
+
+  ASSERT_TRUE(slot->evict());
+  slot->clear();
+
+  EXPECT_EQ(llfs::OptimisticReadEpoch::instance().retired_count(), 1u);
+  EXPECT_EQ(llfs::OptimisticReadEpoch::instance().reclaim(), 0u);
+  EXPECT_TRUE(view2.expired());
+
+  const auto make_view = [](llfs::PageId page_id) -> std::shared_ptr<const llfs::PageView> {
+    return std::make_shared<llfs::OpaquePageView>(
+        llfs::PageBuffer::allocate(llfs::PageSize{4096}, page_id));
+  };
+
+  // g. A full batch is released without calling reclaim...
+  //
+  std::vector<std::weak_ptr<const llfs::PageView>> batch;
+  std::thread{[&] {
+    for (usize i = 0; i < llfs::OptimisticReadEpoch::kReclaimBatchSize; ++i) {
+      std::shared_ptr<const llfs::PageView> view = make_view(llfs::PageId{100 + i});
+      batch.emplace_back(view);
+      llfs::OptimisticReadEpoch::instance().retire(std::move(view));
+    }
+    for (const std::weak_ptr<const llfs::PageView>& view : batch) {
+      EXPECT_TRUE(view.expired());
+    }
+  }}.join();
+
+  EXPECT_EQ(llfs::OptimisticReadEpoch::instance().retired_count(), 0u);
+
+  // ...and a view that a reader may still see outlives the thread that retired it.
+  //
+  std::weak_ptr<const llfs::PageView> orphan;
+  {
+    const llfs::OptimisticReadEpoch::Guard guard;
+
+    std::thread{[&] {
+      std::shared_ptr<const llfs::PageView> view = make_view(llfs::PageId{3});
+      orphan = view;
+      llfs::OptimisticReadEpoch::instance().retire(std::move(view));
+    }}.join();
+
+    EXPECT_FALSE(orphan.expired());
+    EXPECT_EQ(llfs::OptimisticReadEpoch::instance().reclaim(), 1u);
+    EXPECT_FALSE(orphan.expired());
+  }
+  EXPECT_EQ(llfs::OptimisticReadEpoch::instance().reclaim(), 0u);
+  EXPECT_TRUE(orphan.expired());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 17. EvictionPolicy::kClockPro
+//
+TEST(PageCacheSlotPoolTest, ClockProEviction)
+{
+  boost::intrusive_ptr<llfs::PageCacheSlot::Pool> pool =
+      llfs::PageCacheSlot::Pool::make_new(/*n_slots=*/4, batt::make_copy(kTestPoolName));
+
+  pool->set_eviction_policy(llfs::PageCacheSlot::Pool::EvictionPolicy::kClockPro);
+
+  std::vector<llfs::PageCacheSlot*> slots;
+  for (usize i = 0; i < 4; ++i) {
+    slots.emplace_back(pool->allocate());
+    ASSERT_NE(slots.back(), nullptr);
+    (void)slots.back()->fill(llfs::PageId{i + 1});
+  }
+
+  // a. Slot 0 was used again; the hand skips (and promotes) it, and evicts slot 1.
+  //
+  slots[0]->update_latest_use();
+
+  EXPECT_EQ(pool->allocate(), slots[1]);
+  (void)slots[1]->fill(llfs::PageId{5});
+
+  // b. Page 2 was just evicted from slot 1, so it comes back hot...
+  //
+  EXPECT_EQ(pool->allocate(0, llfs::PageId{2}), slots[2]);
+  (void)slots[2]->fill(llfs::PageId{2});
+  EXPECT_EQ(pool->metrics().clock_test_hit_count.load(), 1u);
+
+  EXPECT_EQ(pool->allocate(), slots[3]);
+  (void)slots[3]->fill(llfs::PageId{6});
+
+  // ...and page 1 is still hot, so the hand demotes it and evicts page 5 instead.
+  //
+  EXPECT_EQ(pool->allocate(), slots[1]);
+
+  EXPECT_EQ(slots[0]->key(), llfs::PageId{1});
+  EXPECT_EQ(slots[2]->key(), llfs::PageId{2});
+
+  // Now both hot pages have been passed over once without being used.  Page 2 is demoted, and page
+  // 6 (cold) is evicted.
+  //
+  (void)slots[1]->fill(llfs::PageId{7});
+  EXPECT_EQ(pool->allocate(), slots[3]);
+
+  // c.
+  //
+  EXPECT_DEATH(pool->set_eviction_policy(llfs::PageCacheSlot::Pool::EvictionPolicy::kSampledLru),
+               ".*eviction policy must be set before any slots are allocated.*");
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 18a. PageCachePriority biases sampled LRU eviction
+//
+TEST(PageCacheSlotPoolTest, PriorityBiasesEviction)
+{
+  boost::intrusive_ptr<llfs::PageCacheSlot::Pool> pool =
+      llfs::PageCacheSlot::Pool::make_new(/*n_slots=*/2, batt::make_copy(kTestPoolName));
+
+  llfs::PageCacheSlot* old_slot = pool->allocate();
+  ASSERT_NE(old_slot, nullptr);
+  (void)old_slot->fill(llfs::PageId{1});
+
+  llfs::PageCacheSlot* new_slot = pool->allocate();
+  ASSERT_NE(new_slot, nullptr);
+  (void)new_slot->fill(llfs::PageId{2});
+
+  EXPECT_EQ(new_slot->priority(), llfs::PageCachePriority::kNormal);
+  EXPECT_LT(old_slot->get_latest_use(), new_slot->get_latest_use());
+
+  // The newer slot is evicted first if it is low priority...
+  //
+  new_slot->set_priority(llfs::PageCachePriority::kLow);
+
+  EXPECT_EQ(pool->allocate(), new_slot);
+  (void)new_slot->fill(llfs::PageId{3});
+  EXPECT_EQ(new_slot->priority(), llfs::PageCachePriority::kNormal);
+
+  // ...and so is a newer slot whose older neighbor is high priority.
+  //
+  old_slot->set_priority(llfs::PageCachePriority::kHigh);
+  EXPECT_LT(old_slot->get_latest_use(), new_slot->get_latest_use());
+
+  EXPECT_EQ(pool->allocate(), new_slot);
+  EXPECT_EQ(old_slot->key(), llfs::PageId{1});
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 18b. PageCachePriority under EvictionPolicy::kClockPro
+//
+TEST(PageCacheSlotPoolTest, PriorityClockPro)
+{
+  boost::intrusive_ptr<llfs::PageCacheSlot::Pool> pool =
+      llfs::PageCacheSlot::Pool::make_new(/*n_slots=*/4, batt::make_copy(kTestPoolName));
+
+  pool->set_eviction_policy(llfs::PageCacheSlot::Pool::EvictionPolicy::kClockPro);
+
+  std::vector<llfs::PageCacheSlot*> slots;
+  for (usize i = 0; i < 4; ++i) {
+    slots.emplace_back(pool->allocate());
+    ASSERT_NE(slots.back(), nullptr);
+    (void)slots.back()->fill(llfs::PageId{i + 1});
+  }
+
+  // Slot 0 is cold and unreferenced, but high priority; the hand promotes it and evicts slot 1.
+  //
+  slots[0]->set_priority(llfs::PageCachePriority::kHigh);
+
+  EXPECT_EQ(pool->allocate(), slots[1]);
+  (void)slots[1]->fill(llfs::PageId{5});
+  EXPECT_EQ(slots[0]->key(), llfs::PageId{1});
+
+  // Slot 2 was used again, but it is low priority, so it is evicted anyway.
+  //
+  slots[2]->update_latest_use();
+  slots[2]->set_priority(llfs::PageCachePriority::kLow);
+
+  EXPECT_EQ(pool->allocate(), slots[2]);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 19. Slot layout
+//
+TEST(PageCacheSlotPoolTest, CacheLineIsolation)
+{
+  constexpr usize kCacheLineSize = alignof(batt::CpuCacheLineIsolated<llfs::PageCacheSlot>);
+
+  for (bool isolated : {false, true}) {
+    boost::intrusive_ptr<llfs::PageCacheSlot::Pool> pool =
+        llfs::PageCacheSlot::Pool::make_new(/*n_slots=*/4, batt::make_copy(kTestPoolName));
+
+    // a.
+    //
+    EXPECT_FALSE(pool->cache_line_isolation());
+    EXPECT_EQ(pool->slot_stride(), sizeof(llfs::PageCacheSlot));
+
+    // b.
+    //
+    pool->set_cache_line_isolation(isolated);
+    EXPECT_EQ(pool->cache_line_isolation(), isolated);
+
+    std::vector<llfs::PageCacheSlot*> slots;
+    for (usize i = 0; i < 4; ++i) {
+      slots.emplace_back(pool->allocate());
+      ASSERT_NE(slots.back(), nullptr);
+      EXPECT_EQ(pool->index_of(slots.back()), i);
+      EXPECT_EQ(pool->get_slot(i), slots.back());
+      EXPECT_EQ(slots.back()->index(), i);
+    }
+
+    const usize stride = reinterpret_cast<const char*>(slots[1]) -  //
+                         reinterpret_cast<const char*>(slots[0]);
+
+    EXPECT_EQ(stride, pool->slot_stride());
+    if (isolated) {
+      EXPECT_EQ(stride % kCacheLineSize, 0u);
+      EXPECT_EQ(reinterpret_cast<std::uintptr_t>(slots[0]) % kCacheLineSize, 0u);
+    } else {
+      EXPECT_EQ(stride, sizeof(llfs::PageCacheSlot));
+    }
+
+    // c.
+    //
+    EXPECT_DEATH(pool->set_cache_line_isolation(!isolated),
+                 ".*Cache line isolation must be set before any slots are allocated.*");
+  }
+}
+
 }  // namespace
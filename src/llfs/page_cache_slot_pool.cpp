@@ -9,6 +9,11 @@
 #include <llfs/page_cache_slot.hpp>
 //
 
+#include <llfs/numa.hpp>
+
+#include <batteries/small_vec.hpp>
+
+#include <new>
 #include <random>
 
 namespace llfs {
@@ -16,31 +21,60 @@ namespace llfs {
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 /*explicit*/ PageCacheSlot::Pool::Pool(usize n_slots, std::string&& name,
-                                       usize eviction_candidates) noexcept
+                                       usize eviction_candidates, usize n_shards,
+                                       u64 max_bytes) noexcept
     : n_slots_{n_slots}
     , eviction_candidates_{std::min<usize>(n_slots, std::max<usize>(2, eviction_candidates))}
     , name_{std::move(name)}
-    , slot_storage_{new SlotStorage[n_slots]}
+    , n_shards_{std::max<usize>(1, std::min(n_slots, n_shards))}
+    , shards_{new batt::CpuCacheLineIsolated<Shard>[this->n_shards_]}
+    , max_bytes_{max_bytes}
 {
+  this->allocate_slot_storage();
+
   this->metrics_.max_slots.set(n_slots);
+  this->metrics_.max_bytes.set(max_bytes);
+
+  // Divide the slots as evenly as possible amongst the shards.  Note that we never construct slots
+  // until they are allocated, so the memory for each shard's slots will be first touched (and
+  // therefore placed, under the default Linux policy) by a thread on the shard's local node.
+  //
+  for (usize shard_i = 0; shard_i < this->n_shards_; ++shard_i) {
+    Shard& shard = *this->shards_[shard_i];
+    shard.begin_index = n_slots * shard_i / this->n_shards_;
+    shard.n_slots = (n_slots * (shard_i + 1) / this->n_shards_) - shard.begin_index;
+  }
 
   const auto metric_name = [this](std::string_view property) {
     return batt::to_string("Cache_", this->name_, "_", property);
   };
 
 #define ADD_METRIC_(n) global_metric_registry().add(metric_name(#n), this->metrics_.n)
+#define ADD_STRIPED_METRIC_(n)                                                                     \
+  this->metrics_.n.add_to_registry(global_metric_registry(), metric_name(#n))
 
   ADD_METRIC_(max_slots);
   ADD_METRIC_(indexed_slots);
-  ADD_METRIC_(query_count);
-  ADD_METRIC_(hit_count);
-  ADD_METRIC_(stale_count);
-  ADD_METRIC_(alloc_count);
-  ADD_METRIC_(evict_count);
-  ADD_METRIC_(insert_count);
-  ADD_METRIC_(erase_count);
-  ADD_METRIC_(full_count);
-
+  ADD_METRIC_(max_bytes);
+  ADD_METRIC_(charged_bytes);
+  ADD_METRIC_(released_bytes);
+  ADD_STRIPED_METRIC_(query_count);
+  ADD_STRIPED_METRIC_(hit_count);
+  ADD_STRIPED_METRIC_(stale_count);
+  ADD_STRIPED_METRIC_(alloc_count);
+  ADD_STRIPED_METRIC_(evict_count);
+  ADD_STRIPED_METRIC_(insert_count);
+  ADD_STRIPED_METRIC_(erase_count);
+  ADD_STRIPED_METRIC_(full_count);
+  ADD_STRIPED_METRIC_(steal_count);
+  ADD_STRIPED_METRIC_(admit_count);
+  ADD_STRIPED_METRIC_(reject_count);
+  ADD_STRIPED_METRIC_(prefetch_waste_count);
+  ADD_STRIPED_METRIC_(size_evict_count);
+  ADD_STRIPED_METRIC_(clock_test_hit_count);
+  ADD_STRIPED_METRIC_(known_stale_count);
+
+#undef ADD_STRIPED_METRIC_
 #undef ADD_METRIC_
 }
 
@@ -49,28 +83,47 @@ namespace llfs {
 PageCacheSlot::Pool::~Pool() noexcept
 {
   if (this->slot_storage_) {
-    const usize n_to_delete = this->n_constructed_.get_value();
-    BATT_CHECK_EQ(n_to_delete, this->n_allocated_.load());
-
-    for (usize i = 0; i < n_to_delete; ++i) {
-      BATT_DEBUG_INFO("Destructing slot " << i << BATT_INSPECT(n_to_delete)
-                                          << BATT_INSPECT(this->n_allocated_.load())
-                                          << BATT_INSPECT(this->n_slots_));
-      this->get_slot(i)->~PageCacheSlot();
+    for (usize shard_i = 0; shard_i < this->n_shards_; ++shard_i) {
+      Shard& shard = *this->shards_[shard_i];
+      const usize n_to_delete = shard.n_constructed.get_value();
+      BATT_CHECK_EQ(n_to_delete, shard.n_allocated.load());
+
+      for (usize i = shard.begin_index; i < shard.begin_index + n_to_delete; ++i) {
+        BATT_DEBUG_INFO("Destructing slot " << i << BATT_INSPECT(n_to_delete)
+                                            << BATT_INSPECT(shard_i)
+                                            << BATT_INSPECT(shard.n_allocated.load())
+                                            << BATT_INSPECT(this->n_slots_));
+        this->get_slot(i)->~PageCacheSlot();
+      }
     }
   }
 
-  global_metric_registry()
+  global_metric_registry()  //
       .remove(this->metrics_.max_slots)
       .remove(this->metrics_.indexed_slots)
-      .remove(this->metrics_.query_count)
-      .remove(this->metrics_.hit_count)
-      .remove(this->metrics_.stale_count)
-      .remove(this->metrics_.alloc_count)
-      .remove(this->metrics_.evict_count)
-      .remove(this->metrics_.insert_count)
-      .remove(this->metrics_.erase_count)
-      .remove(this->metrics_.full_count);
+      .remove(this->metrics_.max_bytes)
+      .remove(this->metrics_.charged_bytes)
+      .remove(this->metrics_.released_bytes);
+
+  for (StripedCountMetric<u64>* metric : {
+           &this->metrics_.query_count,
+           &this->metrics_.hit_count,
+           &this->metrics_.stale_count,
+           &this->metrics_.alloc_count,
+           &this->metrics_.evict_count,
+           &this->metrics_.insert_count,
+           &this->metrics_.erase_count,
+           &this->metrics_.full_count,
+           &this->metrics_.steal_count,
+           &this->metrics_.admit_count,
+           &this->metrics_.reject_count,
+           &this->metrics_.prefetch_waste_count,
+           &this->metrics_.size_evict_count,
+           &this->metrics_.clock_test_hit_count,
+           &this->metrics_.known_stale_count,
+       }) {
+    metric->remove_from_registry(global_metric_registry());
+  }
 
   LLFS_VLOG(1) << "PageCacheSlot::Pool::~Pool()";
 }
@@ -81,30 +134,183 @@ PageCacheSlot* PageCacheSlot::Pool::get_slot(usize i) noexcept
 {
   BATT_CHECK_LT(i, this->n_slots_);
 
-  return std::addressof(*this->slots()[i]);
+  return std::launder(reinterpret_cast<PageCacheSlot*>(this->slot_storage_addr(i)));
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 PageCacheSlot* PageCacheSlot::Pool::allocate() noexcept
 {
-  if (this->n_allocated_.load() < this->n_slots_) {
-    const usize allocated_i = this->n_allocated_.fetch_add(1);
-    if (allocated_i < this->n_slots_) {
-      void* storage_addr = this->slots() + allocated_i;
+  return this->allocate(this->local_shard_index());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCacheSlot* PageCacheSlot::Pool::allocate(usize preferred_shard) noexcept
+{
+  return this->allocate(preferred_shard, /*candidate_key=*/PageId{});
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCacheSlot* PageCacheSlot::Pool::allocate(usize preferred_shard, PageId candidate_key) noexcept
+{
+  return this->allocate(preferred_shard, candidate_key, /*charged_size=*/0);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCacheSlot* PageCacheSlot::Pool::allocate(usize preferred_shard, PageId candidate_key,
+                                             usize charged_size) noexcept
+{
+  preferred_shard %= this->n_shards_;
+
+  PageCacheSlot* slot = nullptr;
+
+  // Try the preferred shard first; only if it is completely full and we can't evict anything from
+  // it, fall back on the other shards.
+  //
+  for (usize k = 0; k < this->n_shards_; ++k) {
+    Shard& shard = *this->shards_[(preferred_shard + k) % this->n_shards_];
+
+    slot = this->allocate_unused(shard);
+    if (!slot) {
+      slot = this->evict_lru(shard, candidate_key);
+    }
+    if (slot) {
+      if (k != 0) {
+        this->metrics_.steal_count.add(1);
+      }
+      if (this->eviction_policy_ == EvictionPolicy::kClockPro) {
+        this->reset_clock_state(shard, slot, candidate_key);
+      }
+      break;
+    }
+  }
+
+  if (!slot || charged_size == 0) {
+    return slot;
+  }
+
+  // Charge the new slot; if that puts us over budget, evict more (preferring larger pages) to make
+  // room.
+  //
+  BATT_CHECK_EQ(slot->charged_size_.load(), 0u);
+
+  this->metrics_.charged_bytes.add(charged_size);
+  slot->charged_size_.store(charged_size);
+
+  const u64 prior_bytes_in_use = this->bytes_in_use_.fetch_add(charged_size);
+  const u64 max_bytes = this->max_bytes_.load();
+
+  if (max_bytes != 0 && prior_bytes_in_use + charged_size > max_bytes &&
+      !this->evict_to_byte_budget(preferred_shard)) {
+    //
+    // Undo the charge and hand the slot back to the pool in the cleared state (valid with no key,
+    // so it is the first to be evicted next time).
+    //
+    slot->release_charge();
+    slot->clear();
+    return nullptr;
+  }
+
+  return slot;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheSlot::Pool::set_admission_filter(std::unique_ptr<PageCacheAdmissionFilter>&& filter)
+{
+  for (usize shard_i = 0; shard_i < this->n_shards_; ++shard_i) {
+    Shard& shard = *this->shards_[shard_i];
+
+    BATT_CHECK_EQ(shard.n_allocated.load(), 0u)
+        << "The admission filter must be set before any slots are allocated!";
+
+    shard.n_probation_slots = std::max<usize>(1, shard.n_slots * kProbationSlotsPerMille / 1000);
+    shard.probation_slots.reset(new std::atomic<usize>[shard.n_probation_slots]);
+    for (usize i = 0; i < shard.n_probation_slots; ++i) {
+      shard.probation_slots[i].store(~usize{0});
+    }
+  }
+
+  this->admission_filter_ = std::move(filter);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheSlot::Pool::set_cache_line_isolation(bool enabled)
+{
+  for (usize shard_i = 0; shard_i < this->n_shards_; ++shard_i) {
+    BATT_CHECK_EQ(this->shards_[shard_i]->n_allocated.load(), 0u)
+        << "Cache line isolation must be set before any slots are allocated!";
+  }
+
+  const usize new_stride = enabled ? kIsolatedSlotStride : kCompactSlotStride;
+  if (new_stride != this->slot_stride_) {
+    this->slot_stride_ = new_stride;
+    this->allocate_slot_storage();
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheSlot::Pool::set_eviction_policy(EvictionPolicy policy)
+{
+  for (usize shard_i = 0; shard_i < this->n_shards_; ++shard_i) {
+    Shard& shard = *this->shards_[shard_i];
+
+    BATT_CHECK_EQ(shard.n_allocated.load(), 0u)
+        << "The eviction policy must be set before any slots are allocated!";
+
+    if (policy == EvictionPolicy::kClockPro) {
+      // CLOCK-Pro remembers at most as many non-resident (test) pages as there are slots.
+      //
+      shard.n_test_keys = std::max<usize>(1, shard.n_slots);
+      shard.test_keys.reset(new std::atomic<u64>[shard.n_test_keys]);
+      for (usize i = 0; i < shard.n_test_keys; ++i) {
+        shard.test_keys[i].store(kInvalidPageId);
+      }
+    } else {
+      shard.n_test_keys = 0;
+      shard.test_keys = nullptr;
+    }
+  }
+
+  this->eviction_policy_ = policy;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize PageCacheSlot::Pool::local_shard_index() const noexcept
+{
+  if (this->n_shards_ == 1) {
+    return 0;
+  }
+  return current_numa_node() % this->n_shards_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCacheSlot* PageCacheSlot::Pool::allocate_unused(Shard& shard) noexcept
+{
+  if (shard.n_allocated.load() < shard.n_slots) {
+    const usize allocated_i = shard.n_allocated.fetch_add(1);
+    if (allocated_i < shard.n_slots) {
+      void* storage_addr = this->slot_storage_addr(shard.begin_index + allocated_i);
       PageCacheSlot* const new_slot = new (storage_addr) PageCacheSlot{*this};
-      this->n_constructed_.fetch_add(1);
+      shard.n_constructed.fetch_add(1);
       return new_slot;
     }
-    const usize reverted = this->n_allocated_.fetch_sub(1);
-    BATT_CHECK_GE(reverted, this->n_slots_);
+    const usize reverted = shard.n_allocated.fetch_sub(1);
+    BATT_CHECK_GE(reverted, shard.n_slots);
     //
     // continue...
   }
 
-  BATT_CHECK_OK(this->n_constructed_.await_equal(this->n_slots_));
+  BATT_CHECK_OK(shard.n_constructed.await_equal(shard.n_slots));
 
-  return this->evict_lru();
+  return nullptr;
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -114,7 +320,9 @@ usize PageCacheSlot::Pool::index_of(const PageCacheSlot* slot) noexcept
   BATT_CHECK_NOT_NULLPTR(slot);
   BATT_CHECK_EQ(std::addressof(slot->pool()), this);
 
-  const usize index = batt::CpuCacheLineIsolated<PageCacheSlot>::pointer_from(slot) - this->slots();
+  const usize index = static_cast<usize>(reinterpret_cast<const u8*>(slot) -
+                                         reinterpret_cast<const u8*>(this->slot_storage_.get())) /
+                      this->slot_stride_;
 
   BATT_CHECK_LT(index, this->n_slots_);
 
@@ -123,33 +331,52 @@ usize PageCacheSlot::Pool::index_of(const PageCacheSlot* slot) noexcept
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-batt::CpuCacheLineIsolated<PageCacheSlot>* PageCacheSlot::Pool::slots() noexcept
+void* PageCacheSlot::Pool::slot_storage_addr(usize i) noexcept
 {
-  return reinterpret_cast<batt::CpuCacheLineIsolated<PageCacheSlot>*>(this->slot_storage_.get());
+  return reinterpret_cast<u8*>(this->slot_storage_.get()) + i * this->slot_stride_;
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-PageCacheSlot* PageCacheSlot::Pool::evict_lru()
+void PageCacheSlot::Pool::allocate_slot_storage()
 {
+  // The storage is never touched until slots are constructed in it, so (re-)allocating it is cheap.
+  //
+  const usize n_bytes = this->n_slots_ * this->slot_stride_;
+  this->slot_storage_.reset(new SlotStorage[(n_bytes + sizeof(SlotStorage) - 1) /
+                                            sizeof(SlotStorage)]);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCacheSlot* PageCacheSlot::Pool::evict_lru(Shard& shard, PageId candidate_key)
+{
+  if (this->eviction_policy_ == EvictionPolicy::kClockPro) {
+    return this->evict_clock_pro(shard, candidate_key);
+  }
+
   thread_local std::default_random_engine rng{/*seed=*/std::random_device{}()};
 
-  const usize n_slots = this->n_constructed_.get_value();
+  const usize n_slots = shard.n_constructed.get_value();
+  const usize base_i = shard.begin_index;
 
   if (n_slots == 0) {
     return nullptr;
   }
 
   if (n_slots == 1) {
-    PageCacheSlot* only_slot = this->get_slot(0);
+    PageCacheSlot* only_slot = this->get_slot(base_i);
     if (only_slot->evict()) {
+      if (only_slot->consume_prefetch_hint()) {
+        this->metrics_.prefetch_waste_count.add(1);
+      }
       return only_slot;
     }
     return nullptr;
   }
 
-  // Pick k slots at random and try to evict whichever one has the least (earliest) latest use
-  // logical time stamp.
+  // Pick k slots at random and try to evict whichever one has the lowest eviction priority (i.e.,
+  // the least (earliest) latest use logical time stamp, if there is no byte budget).
   //
   std::uniform_int_distribution<usize> pick_first_slot{0, n_slots - 1};
   std::uniform_int_distribution<usize> pick_second_slot{0, n_slots - 2};
@@ -163,10 +390,10 @@ PageCacheSlot* PageCacheSlot::Pool::evict_lru()
     }
     BATT_CHECK_NE(first_slot_i, second_slot_i);
 
-    PageCacheSlot* first_slot = this->get_slot(first_slot_i);
-    PageCacheSlot* second_slot = this->get_slot(second_slot_i);
+    PageCacheSlot* first_slot = this->get_slot(base_i + first_slot_i);
+    PageCacheSlot* second_slot = this->get_slot(base_i + second_slot_i);
     PageCacheSlot* lru_slot = [&] {
-      if (first_slot->get_latest_use() - second_slot->get_latest_use() < 0) {
+      if (this->eviction_priority(first_slot) - this->eviction_priority(second_slot) < 0) {
         return first_slot;
       }
       return second_slot;
@@ -177,19 +404,31 @@ PageCacheSlot* PageCacheSlot::Pool::evict_lru()
     //
     for (usize k = 2; k < this->eviction_candidates_; ++k) {
       usize nth_slot_i = pick_first_slot(rng);
-      PageCacheSlot* nth_slot = this->get_slot(nth_slot_i);
+      PageCacheSlot* nth_slot = this->get_slot(base_i + nth_slot_i);
       lru_slot = [&] {
-        if (nth_slot->get_latest_use() - lru_slot->get_latest_use() < 0) {
+        if (this->eviction_priority(nth_slot) - this->eviction_priority(lru_slot) < 0) {
           return nth_slot;
         }
         return lru_slot;
       }();
     }
 
+    // Give the admission filter (if any) a chance to protect the victim we picked.
+    //
+    if (this->admission_filter_ && candidate_key.is_valid()) {
+      lru_slot = this->apply_admission_filter(shard, candidate_key, lru_slot);
+    }
+
     // Fingers crossed!
     //
     if (lru_slot->evict()) {
-      this->metrics_.evict_count.fetch_add(1);
+      this->metrics_.evict_count.add(1);
+
+      // If the page was prefetched but nobody ever asked for it, the prefetch was wasted.
+      //
+      if (lru_slot->consume_prefetch_hint()) {
+        this->metrics_.prefetch_waste_count.add(1);
+      }
       return lru_slot;
     }
   }
@@ -197,4 +436,266 @@ PageCacheSlot* PageCacheSlot::Pool::evict_lru()
   return nullptr;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCacheSlot* PageCacheSlot::Pool::evict_clock_pro(Shard& shard, PageId candidate_key)
+{
+  const usize n_slots = shard.n_constructed.get_value();
+  const usize base_i = shard.begin_index;
+
+  if (n_slots == 0) {
+    return nullptr;
+  }
+
+  const usize max_hot = shard.n_slots * kClockProMaxHotPerMille / 1000;
+
+  // Slots marked with set_obsolete_hint, and PageCachePriority::kLow slots, are evicted as soon as
+  // the hand reaches them, whatever their CLOCK state.
+  //
+  const i64 obsolete_before = LRUClock::read_global() - (i64{1} << 55);
+
+  for (usize step = 0; step < n_slots * 3; ++step) {
+    PageCacheSlot* slot = this->get_slot(base_i + shard.clock_hand.fetch_add(1) % n_slots);
+
+    if (slot->is_pinned() || !slot->is_valid()) {
+      continue;
+    }
+
+    u8 state = slot->clock_state_.load();
+
+    const PageCachePriority priority = slot->priority();
+
+    if (priority != PageCachePriority::kLow && slot->get_latest_use() - obsolete_before >= 0) {
+      if ((state & PageCacheSlot::kClockReferenced) != 0) {
+        //
+        // Referenced since the hand last passed: give the slot a second chance.  A cold slot is
+        // also promoted to hot, if there is room.
+        //
+        if ((state & PageCacheSlot::kClockHot) == 0 && shard.n_hot.load() < max_hot &&
+            slot->clock_state_.compare_exchange_strong(state, PageCacheSlot::kClockHot)) {
+          shard.n_hot.fetch_add(1);
+        } else {
+          slot->clock_state_.fetch_and(static_cast<u8>(~PageCacheSlot::kClockReferenced));
+        }
+        continue;
+      }
+
+      if ((state & PageCacheSlot::kClockHot) != 0) {
+        //
+        // Hot, but not referenced since the hand last passed: demote to cold.
+        //
+        if (slot->clock_state_.compare_exchange_strong(state, 0)) {
+          shard.n_hot.fetch_sub(1);
+        }
+        continue;
+      }
+
+      if (priority == PageCachePriority::kHigh && shard.n_hot.load() < max_hot &&
+          step < n_slots * 2) {
+        //
+        // Cold and unreferenced, but high priority: promote it to hot instead of evicting it, so
+        // that it gets another full round of the hand.  Not on the last round, so that a shard
+        // full of high priority slots still yields a victim.
+        //
+        if (slot->clock_state_.compare_exchange_strong(state, PageCacheSlot::kClockHot)) {
+          shard.n_hot.fetch_add(1);
+        }
+        continue;
+      }
+    }
+
+    // Cold and unreferenced (or obsolete, or low priority); this is our victim.  Give the admission
+    // filter (if any) a chance to protect it.
+    //
+    PageCacheSlot* victim = slot;
+    if (this->admission_filter_ && candidate_key.is_valid()) {
+      victim = this->apply_admission_filter(shard, candidate_key, victim);
+    }
+
+    if (victim->evict()) {
+      this->metrics_.evict_count.add(1);
+
+      if (victim->consume_prefetch_hint()) {
+        this->metrics_.prefetch_waste_count.add(1);
+      }
+
+      // Start the test period for the evicted page.  The slot is ours now (it is invalid until the
+      // caller fills it), so it's safe to read its key.
+      //
+      const PageId evicted_key = victim->key();
+      if (evicted_key.is_valid()) {
+        shard.test_keys[Self::test_key_index(shard, evicted_key)].store(evicted_key.int_value());
+      }
+      return victim;
+    }
+  }
+
+  return nullptr;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheSlot::Pool::reset_clock_state(Shard& shard, PageCacheSlot* slot,
+                                            PageId candidate_key) noexcept
+{
+  u8 new_state = 0;
+
+  if (candidate_key.is_valid() && shard.n_test_keys != 0) {
+    std::atomic<u64>& test_key = shard.test_keys[Self::test_key_index(shard, candidate_key)];
+    u64 expected = candidate_key.int_value();
+
+    if (test_key.load() == expected && test_key.compare_exchange_strong(expected, kInvalidPageId)) {
+      this->metrics_.clock_test_hit_count.add(1);
+
+      if (shard.n_hot.load() < shard.n_slots * kClockProMaxHotPerMille / 1000) {
+        new_state = PageCacheSlot::kClockHot;
+      }
+    }
+  }
+
+  const u8 old_state = slot->clock_state_.exchange(new_state);
+
+  if ((old_state & PageCacheSlot::kClockHot) != 0) {
+    shard.n_hot.fetch_sub(1);
+  }
+  if ((new_state & PageCacheSlot::kClockHot) != 0) {
+    shard.n_hot.fetch_add(1);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ usize PageCacheSlot::Pool::test_key_index(const Shard& shard, PageId key) noexcept
+{
+  // Fibonacci hashing, so that keys that differ only in their high (device/generation) bits are
+  // still spread out.
+  //
+  return ((key.int_value() * 0x9e3779b97f4a7c15ull) >> 17) % shard.n_test_keys;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+i64 PageCacheSlot::Pool::eviction_priority(const PageCacheSlot* slot) const noexcept
+{
+  i64 priority = slot->get_latest_use();
+
+  if (this->max_bytes_.load() != 0) {
+    const usize charged_size = slot->charged_size();
+    if (charged_size != 0) {
+      priority += static_cast<i64>(this->n_slots_ * kSizeBonusUnit /
+                                   std::max<usize>(charged_size, kSizeBonusUnit));
+    }
+  }
+
+  switch (slot->priority()) {
+    case PageCachePriority::kLow:
+      priority -= kLowPriorityPenalty;
+      break;
+    case PageCachePriority::kNormal:
+      break;
+    case PageCachePriority::kHigh:
+      priority += static_cast<i64>(this->n_slots_) * kHighPriorityBonusPerSlot;
+      break;
+  }
+
+  return priority;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool PageCacheSlot::Pool::evict_to_byte_budget(usize preferred_shard) noexcept
+{
+  // The victims stay in the Invalid state (so we can't pick them again) until we are done; some of
+  // them may have been cleared slots that free no bytes.
+  //
+  batt::SmallVec<PageCacheSlot*, 8> victims;
+
+  while (this->bytes_in_use_.load() > this->max_bytes_.load() &&
+         victims.size() < this->n_slots_) {
+    PageCacheSlot* victim = nullptr;
+    for (usize k = 0; k < this->n_shards_ && !victim; ++k) {
+      victim = this->evict_lru(*this->shards_[(preferred_shard + k) % this->n_shards_],
+                               /*candidate_key=*/PageId{});
+    }
+    if (!victim) {
+      break;
+    }
+    victims.emplace_back(victim);
+    this->metrics_.size_evict_count.add(1);
+  }
+
+  for (PageCacheSlot* victim : victims) {
+    victim->clear();
+  }
+
+  return this->bytes_in_use_.load() <= this->max_bytes_.load();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool PageCacheSlot::Pool::set_max_bytes(u64 max_bytes) noexcept
+{
+  const u64 old_max_bytes = this->max_bytes_.exchange(max_bytes);
+  this->metrics_.max_bytes.set(max_bytes);
+
+  LLFS_VLOG(1) << "PageCacheSlot::Pool::set_max_bytes(" << max_bytes << ")"
+               << BATT_INSPECT(this->name_) << BATT_INSPECT(old_max_bytes)
+               << BATT_INSPECT(this->bytes_in_use());
+
+  if (max_bytes == 0 || this->bytes_in_use() <= max_bytes) {
+    return true;
+  }
+  return this->evict_to_byte_budget(this->local_shard_index());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheSlot::Pool::release_bytes(usize charged_size) noexcept
+{
+  this->bytes_in_use_.fetch_sub(charged_size);
+  this->metrics_.released_bytes.add(charged_size);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCacheSlot* PageCacheSlot::Pool::apply_admission_filter(Shard& shard, PageId candidate_key,
+                                                          PageCacheSlot* victim)
+{
+  // We must pin the victim in order to safely read its key.
+  //
+  PageId victim_key;
+  {
+    PageCacheSlot::PinnedRef pinned = victim->acquire_pin(PageId{}, /*ignore_key=*/true);
+    if (!pinned) {
+      return victim;
+    }
+    victim_key = pinned.key();
+  }
+
+  if (this->admission_filter_->should_admit(candidate_key, victim_key)) {
+    this->metrics_.admit_count.add(1);
+    return victim;
+  }
+  this->metrics_.reject_count.add(1);
+
+  // The candidate was rejected; recycle the oldest probation slot (FIFO order) instead of the
+  // victim.  If the probation slot can't be evicted (it is pinned or not yet in use), replace it with
+  // the victim; this is how the probation ring fills up initially.
+  //
+  std::atomic<usize>& probation_entry =
+      shard.probation_slots[shard.probation_next.fetch_add(1) % shard.n_probation_slots];
+
+  const usize probation_slot_i = probation_entry.load();
+  if (probation_slot_i != ~usize{0}) {
+    PageCacheSlot* probation_slot = this->get_slot(probation_slot_i);
+    if (probation_slot != victim && !probation_slot->is_pinned() && probation_slot->is_valid()) {
+      return probation_slot;
+    }
+  }
+
+  probation_entry.store(this->index_of(victim));
+
+  return victim;
+}
+
 }  //namespace llfs
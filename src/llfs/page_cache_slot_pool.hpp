@@ -11,43 +11,131 @@
 #endif
 
 #include <llfs/metrics.hpp>
+#include <llfs/page_cache_admission_filter.hpp>
+
+#include <batteries/cpu_align.hpp>
+
+#include <memory>
 
 namespace llfs {
 
 /** \brief A pool of PageCacheSlot objects.
  *
  * Used to construct a PageDeviceCache.
+ *
+ * The slots in a pool may optionally be partitioned into a number of shards (typically one per NUMA
+ * node).  Each shard owns a contiguous range of slot indices and does its own allocation and
+ * eviction, so that threads running on different nodes don't contend on the same counters or touch
+ * each other's (remote) slot memory.  A shard only steals slots from other shards when it is full
+ * and can't evict any of its own slots.
+ *
+ * Victims are chosen according to the pool's EvictionPolicy (see set_eviction_policy).
  */
 class PageCacheSlot::Pool : public boost::intrusive_ref_counter<Pool>
 {
  public:
   using Self = Pool;
 
+  /** \brief How a pool chooses which slot to evict when it is full.
+   */
+  enum struct EvictionPolicy {
+    /** \brief Sample `eviction_candidates` random slots and evict the one with the lowest eviction
+     * priority (approximate LRU, or GreedyDual-Size with a byte budget).  This is the default.
+     */
+    kSampledLru,
+
+    /** \brief A single-hand variant of CLOCK-Pro.  Each shard sweeps its slots in order with a
+     * clock hand, giving referenced slots a second chance (see PageCacheSlot::kClockReferenced).
+     * Slots are split into "hot" and "cold": only cold, unreferenced slots are evicted; a
+     * referenced cold slot is promoted to hot, and an unreferenced hot slot is demoted to cold.
+     * The keys of recently evicted cold pages are remembered (the "test" period); a page that is
+     * loaded again while its key is still remembered starts out hot.
+     */
+    kClockPro,
+  };
+
   /** \brief The default number of randomly-selected slots to consider when trying to evict a slot
    * that hasn't been accessed recently.
    */
   static constexpr usize kDefaultEvictionCandidates = 8;
 
-  /** \brief Aligned storage type for a single PageCacheSlot.  We allocate an array of this type
-   * when constructing a Pool object, then construct the individual slots via placement-new as they
-   * are needed.
+  /** \brief The default number of shards per pool.
    */
-  using SlotStorage = std::aligned_storage_t<sizeof(batt::CpuCacheLineIsolated<PageCacheSlot>),
+  static constexpr usize kDefaultShardCount = 1;
+
+  /** \brief When an admission filter is installed, this is the fraction (in parts per thousand) of
+   * each shard's slots that may be used to hold pages rejected by the filter.
+   */
+  static constexpr usize kProbationSlotsPerMille = 10;
+
+  /** \brief Aligned storage for one CPU cache line's worth of slot memory.  We allocate an array of
+   * this type large enough for all the slots when constructing a Pool object, then construct the
+   * individual slots via placement-new as they are needed.
+   */
+  using SlotStorage = std::aligned_storage_t<alignof(batt::CpuCacheLineIsolated<PageCacheSlot>),
                                              alignof(batt::CpuCacheLineIsolated<PageCacheSlot>)>;
 
-  /** \brief Observability metrics for a cache slot pool.
+  /** \brief The distance in bytes between adjacent slots by default: slots are packed back to back,
+   * so neighboring slots may share a cache line.
+   */
+  static constexpr usize kCompactSlotStride = sizeof(PageCacheSlot);
+
+  /** \brief The distance in bytes between adjacent slots when cache line isolation is enabled (see
+   * set_cache_line_isolation).
+   */
+  static constexpr usize kIsolatedSlotStride = sizeof(batt::CpuCacheLineIsolated<PageCacheSlot>);
+
+  /** \brief When the pool has a byte budget, each slot's eviction priority (its latest use logical
+   * time stamp) is boosted by up to `n_slots` ticks, in inverse proportion to the slot's charged
+   * size in units of this many bytes (see eviction_priority).
+   */
+  static constexpr usize kSizeBonusUnit = 4096;
+
+  /** \brief The eviction priority of a PageCachePriority::kHigh slot is boosted by this many ticks
+   * per slot in the pool, so that it outlives roughly that many rounds of the pool's slots.
+   */
+  static constexpr i64 kHighPriorityBonusPerSlot = 4;
+
+  /** \brief The eviction priority of a PageCachePriority::kLow slot is lowered by this many ticks,
+   * which puts it behind every kNormal slot but ahead of slots with an obsolete hint.
+   */
+  static constexpr i64 kLowPriorityPenalty = i64{1} << 54;
+
+  /** \brief Under EvictionPolicy::kClockPro, the maximum fraction (in parts per thousand) of each
+   * shard's slots that may be hot at the same time.
+   */
+  static constexpr usize kClockProMaxHotPerMille = 750;
+
+  /** \brief Pool metrics; the event counters are striped (see StripedCountMetric) because they
+   * are updated by every thread that uses the cache.
+   *
+   * `charged_bytes - released_bytes` is the number of bytes currently charged to the pool's slots
+   * (see bytes_in_use()); `size_evict_count` counts evictions beyond the one needed to free a slot,
+   * done to stay within `max_bytes`.  `known_stale_count` counts lookups that failed without any
+   * I/O because the requested generation of the page is known to be out of date (see
+   * PageDeviceCache::is_known_stale).
    */
   struct Metrics {
     CountMetric<u64> max_slots{0};
     CountMetric<u64> indexed_slots{0};
-    CountMetric<u64> query_count{0};
-    CountMetric<u64> hit_count{0};
-    CountMetric<u64> stale_count{0};
-    CountMetric<u64> alloc_count{0};
-    CountMetric<u64> evict_count{0};
-    CountMetric<u64> insert_count{0};
-    CountMetric<u64> erase_count{0};
-    CountMetric<u64> full_count{0};
+    CountMetric<u64> max_bytes{0};
+    CountMetric<u64> charged_bytes{0};
+    CountMetric<u64> released_bytes{0};
+    StripedCountMetric<u64> size_evict_count;
+    StripedCountMetric<u64> query_count;
+    StripedCountMetric<u64> hit_count;
+    StripedCountMetric<u64> stale_count;
+    StripedCountMetric<u64> alloc_count;
+    StripedCountMetric<u64> evict_count;
+    StripedCountMetric<u64> insert_count;
+    StripedCountMetric<u64> erase_count;
+    StripedCountMetric<u64> full_count;
+    StripedCountMetric<u64> steal_count;
+    StripedCountMetric<u64> admit_count;
+    StripedCountMetric<u64> reject_count;
+    StripedCountMetric<u64> prefetch_waste_count;
+    StripedCountMetric<u64> clock_test_hit_count;
+    StripedCountMetric<u64> known_stale_count;
   };
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -85,12 +173,133 @@ class PageCacheSlot::Pool : public boost::intrusive_ref_counter<Pool>
    */
   PageCacheSlot* allocate() noexcept;
 
+  /** \brief Same as `allocate()`, except the caller explicitly chooses which shard to try first.
+   *
+   * `preferred_shard` is taken modulo this->shard_count().  If the preferred shard has no free or
+   * evictable slots, the remaining shards are tried in round-robin order.
+   */
+  PageCacheSlot* allocate(usize preferred_shard) noexcept;
+
+  /** \brief Same as `allocate(preferred_shard)`, but also passes the key that will be stored in the
+   * returned slot, so that the admission filter (if any) can decide whether it may displace the
+   * eviction victim.
+   */
+  PageCacheSlot* allocate(usize preferred_shard, PageId candidate_key) noexcept;
+
+  /** \brief Same as `allocate(preferred_shard, candidate_key)`, but also charges `charged_size`
+   * bytes (typically the page size) to the returned slot until it is next evicted.
+   *
+   * If the pool has a byte budget (max_bytes() != 0) and the charge would exceed it, further slots
+   * are evicted until the pool is back within budget; if that isn't possible (because too many
+   * slots are pinned), the charge is undone and nullptr is returned.
+   */
+  PageCacheSlot* allocate(usize preferred_shard, PageId candidate_key,
+                          usize charged_size) noexcept;
+
+  /** \brief Installs an admission filter for this pool.
+   *
+   * Must be called before any slots are allocated from the pool, or we will panic.
+   */
+  void set_admission_filter(std::unique_ptr<PageCacheAdmissionFilter>&& filter);
+
+  /** \brief Sets the eviction policy for this pool (the default is EvictionPolicy::kSampledLru).
+   *
+   * Must be called before any slots are allocated from the pool, or we will panic.
+   */
+  void set_eviction_policy(EvictionPolicy policy);
+
+  /** \brief Enables or disables cache line isolation of the slots in this pool (disabled by
+   * default).
+   *
+   * When enabled, each slot is padded out to a whole number of CPU cache lines so that threads
+   * updating the atomic state of neighboring slots never contend on the same line (false sharing).
+   * This costs up to a cache line of memory per slot, so it is only worth enabling for small
+   * pools of heavily contended slots.
+   *
+   * Must be called before any slots are allocated from the pool, or we will panic.
+   */
+  void set_cache_line_isolation(bool enabled);
+
+  /** \brief Returns true iff the slots of this pool are isolated from each other in separate cache
+   * lines (see set_cache_line_isolation).
+   */
+  bool cache_line_isolation() const noexcept
+  {
+    return this->slot_stride_ == kIsolatedSlotStride;
+  }
+
+  /** \brief Returns the distance in bytes between adjacent slots in this pool; this is the memory
+   * cost of each slot (not counting the cached page itself).
+   */
+  usize slot_stride() const noexcept
+  {
+    return this->slot_stride_;
+  }
+
+  /** \brief Returns the eviction policy of this pool.
+   */
+  EvictionPolicy eviction_policy() const noexcept
+  {
+    return this->eviction_policy_;
+  }
+
+  /** \brief Returns the admission filter for this pool, or nullptr if none is installed.
+   */
+  PageCacheAdmissionFilter* admission_filter() const noexcept
+  {
+    return this->admission_filter_.get();
+  }
+
+  /** \brief Returns the total number of slots in this pool.
+   */
+  usize n_slots() const noexcept
+  {
+    return this->n_slots_;
+  }
+
+  /** \brief Returns the number of shards in this pool (always at least 1).
+   */
+  usize shard_count() const noexcept
+  {
+    return this->n_shards_;
+  }
+
+  /** \brief Returns the index of the shard local to the calling thread; this is the shard used by
+   * `allocate()` (with no args).
+   */
+  usize local_shard_index() const noexcept;
+
   /** \brief Returns the index of the specified slot object.
    *
    * If `slot` does not belong to this pool, behavior is undefined!
    */
   usize index_of(const PageCacheSlot* slot) noexcept;
 
+  /** \brief Returns the byte budget of this pool; 0 means unlimited (only the number of slots is
+   * limited).
+   */
+  u64 max_bytes() const noexcept
+  {
+    return this->max_bytes_.load();
+  }
+
+  /** \brief Changes the byte budget of this pool (see max_bytes()); this is how a cache is resized
+   * at runtime.
+   *
+   * When the budget shrinks, unpinned slots are evicted right away until the pool fits; returns
+   * false if that wasn't possible because too many slots are pinned.  In that case the new budget
+   * still applies, and is enforced as slots are allocated and pins are released.  The budget can't
+   * grow the pool beyond its number of slots.
+   */
+  bool set_max_bytes(u64 max_bytes) noexcept;
+
+  /** \brief Returns the total number of bytes charged to the slots of this pool.
+   */
+  u64 bytes_in_use() const noexcept
+  {
+    return this->bytes_in_use_.load();
+  }
+
   /** \brief Returns the metrics for this pool.
    */
   const Metrics& metrics() const
@@ -100,30 +309,151 @@ class PageCacheSlot::Pool : public boost::intrusive_ref_counter<Pool>
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
  private:
-  /** \brief Constructs a new Pool with capacity for `n_slots` cached pages.
+  friend class PageCacheSlot;
+  friend class PageDeviceCache;
+
+  /** \brief A contiguous sub-range of the slots in a pool, with its own allocation counters.
+   */
+  struct Shard {
+    /** \brief The index of the first slot in this shard.
+     */
+    usize begin_index = 0;
+
+    /** \brief The number of slots in this shard.
+     */
+    usize n_slots = 0;
+
+    /** \brief The number of slots allocated (or being allocated) from this shard.
+     */
+    std::atomic<usize> n_allocated{0};
+
+    /** \brief The number of slots in this shard whose constructor has completed.
+     */
+    batt::Watch<usize> n_constructed{0};
+
+    /** \brief Ring of slot indices holding pages that were rejected by the admission filter; only
+     * used if the pool has an admission filter.
+     */
+    std::unique_ptr<std::atomic<usize>[]> probation_slots;
+
+    /** \brief The size of `probation_slots`.
+     */
+    usize n_probation_slots = 0;
+
+    /** \brief The next position in `probation_slots` to reuse (modulo n_probation_slots).
+     */
+    std::atomic<usize> probation_next{0};
+
+    /** \brief The position of the clock hand (modulo n_slots); only used by
+     * EvictionPolicy::kClockPro.
+     */
+    std::atomic<usize> clock_hand{0};
+
+    /** \brief The number of hot slots in this shard (EvictionPolicy::kClockPro only).
+     */
+    std::atomic<usize> n_hot{0};
+
+    /** \brief Direct-mapped table of the keys (PageId::int_value()) of recently evicted cold
+     * pages; only allocated for EvictionPolicy::kClockPro.
+     */
+    std::unique_ptr<std::atomic<u64>[]> test_keys;
+
+    /** \brief The size of `test_keys`.
+     */
+    usize n_test_keys = 0;
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Constructs a new Pool with capacity for `n_slots` cached pages, divided evenly amongst
+   * `n_shards` shards.  If `max_bytes` is non-zero, the total size charged to the slots (see
+   * allocate) is also limited to that many bytes.
    */
   explicit Pool(usize n_slots, std::string&& name,
-                usize eviction_candidates = Self::kDefaultEvictionCandidates) noexcept;
+                usize eviction_candidates = Self::kDefaultEvictionCandidates,
+                usize n_shards = Self::kDefaultShardCount, u64 max_bytes = 0) noexcept;
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
-  batt::CpuCacheLineIsolated<PageCacheSlot>* slots() noexcept;
+  /** \brief Returns the address of the storage for the slot at index `i`.
+   */
+  void* slot_storage_addr(usize i) noexcept;
 
-  /** \brief Tries to find a slot that hasn't been used in a while to evict.
+  /** \brief (Re-)allocates the storage for all slots, with the current slot stride.
+   */
+  void allocate_slot_storage();
+
+  /** \brief Constructs a never-before-used slot from the given shard, if there are any left;
+   * otherwise returns nullptr.
+   */
+  PageCacheSlot* allocate_unused(Shard& shard) noexcept;
+
+  /** \brief Tries to find a slot in the given shard that hasn't been used in a while to evict.
    *
-   * Will keep on looping until it has made one attempt for each slot in the cache.  At that point,
+   * Will keep on looping until it has made one attempt for each slot in the shard.  At that point,
    * we just give up and return nullptr.
+   *
+   * If the eviction policy is kClockPro, this calls evict_clock_pro instead.
+   */
+  PageCacheSlot* evict_lru(Shard& shard, PageId candidate_key);
+
+  /** \brief The EvictionPolicy::kClockPro version of evict_lru; gives up after the clock hand has
+   * passed over every slot in the shard three times (enough to clear, demote, and then evict a
+   * referenced hot slot).
+   */
+  PageCacheSlot* evict_clock_pro(Shard& shard, PageId candidate_key);
+
+  /** \brief Sets the initial CLOCK state of a newly allocated `slot` from `shard`: hot if
+   * `candidate_key` was evicted recently enough to still be in the shard's test table, cold
+   * otherwise.
+   */
+  void reset_clock_state(Shard& shard, PageCacheSlot* slot, PageId candidate_key) noexcept;
+
+  /** \brief Returns the index of `key` in shard.test_keys.
+   */
+  static usize test_key_index(const Shard& shard, PageId key) noexcept;
+
+  /** \brief Consults the admission filter to decide whether `candidate_key` may displace the page in
+   * `victim`; returns the slot that should be evicted instead (which may be `victim` itself).
+   */
+  PageCacheSlot* apply_admission_filter(Shard& shard, PageId candidate_key,
+                                        PageCacheSlot* victim);
+
+  /** \brief Returns the value compared when choosing an eviction victim amongst sampled slots; the
+   * slot with the lowest value is evicted.
+   *
+   * Without a byte budget, this is just the latest use time stamp (approximate LRU).  With a byte
+   * budget, it is a GreedyDual-Size priority with uniform miss cost: the latest use time stamp
+   * (which plays the role of GDS's inflation value) plus a bonus inversely proportional to the
+   * slot's size, so that (all else being equal) large pages are evicted before small ones.
+   *
+   * Either way, the slot's PageCachePriority then adds kHighPriorityBonusPerSlot * n_slots (kHigh)
+   * or subtracts kLowPriorityPenalty (kLow).
+   */
+  i64 eviction_priority(const PageCacheSlot* slot) const noexcept;
+
+  /** \brief Evicts (and clears) unpinned slots, starting with `preferred_shard`, until
+   * bytes_in_use() <= max_bytes(); returns false if that can't be done.
+   */
+  bool evict_to_byte_budget(usize preferred_shard) noexcept;
+
+  /** \brief Called by PageCacheSlot when a slot with a non-zero charged size is evicted.
    */
-  PageCacheSlot* evict_lru();
+  void release_bytes(usize charged_size) noexcept;
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   const usize n_slots_;
   const usize eviction_candidates_;
   const std::string name_;
+  usize slot_stride_ = kCompactSlotStride;
   std::unique_ptr<SlotStorage[]> slot_storage_;
-  std::atomic<usize> n_allocated_{0};
-  batt::Watch<usize> n_constructed_{0};
+  const usize n_shards_;
+  std::unique_ptr<batt::CpuCacheLineIsolated<Shard>[]> shards_;
+  std::unique_ptr<PageCacheAdmissionFilter> admission_filter_;
+  EvictionPolicy eviction_policy_ = EvictionPolicy::kSampledLru;
+  std::atomic<u64> max_bytes_;
+  std::atomic<u64> bytes_in_use_{0};
   Metrics metrics_;
 };
 
@@ -0,0 +1,203 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_cache_trace.hpp>
+//
+
+#include <llfs/filesystem.hpp>
+#include <llfs/logging.hpp>
+
+#include <batteries/finally.hpp>
+#include <batteries/math.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::vector<PageCacheTraceEvent>> read_page_cache_trace(std::string_view file_name)
+{
+  StatusOr<i64> file_size = sizeof_file(file_name);
+  BATT_REQUIRE_OK(file_size);
+
+  const usize n_records = BATT_CHECKED_CAST(usize, *file_size) / sizeof(PackedPageCacheTraceRecord);
+
+  std::vector<PackedPageCacheTraceRecord> packed(n_records);
+  BATT_REQUIRE_OK(read_file(
+      file_name, MutableBuffer{packed.data(), n_records * sizeof(PackedPageCacheTraceRecord)}));
+
+  std::vector<PageCacheTraceEvent> events;
+  events.reserve(n_records);
+
+  for (const PackedPageCacheTraceRecord& record : packed) {
+    events.emplace_back(PageCacheTraceEvent{
+        .timestamp_nsec = record.timestamp_nsec,
+        .page_id = record.page_id.as_page_id(),
+        .wait_usec = record.wait_usec,
+        .hit = (record.hit != 0),
+    });
+  }
+
+  return events;
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class PageCacheTraceRecorder
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<std::unique_ptr<PageCacheTraceRecorder>> PageCacheTraceRecorder::open(
+    std::string_view file_name, usize capacity)
+{
+  BATT_CHECK_GE(capacity, 2u);
+
+  // create_file_read_write fails if the file already exists.
+  //
+  delete_file(file_name).IgnoreError();
+
+  StatusOr<int> fd = create_file_read_write(file_name, OpenForAppend{false});
+  BATT_REQUIRE_OK(fd);
+
+  return {std::unique_ptr<PageCacheTraceRecorder>{new PageCacheTraceRecorder{
+      std::string{file_name}, *fd, usize{1} << batt::log2_ceil(capacity)}}};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCacheTraceRecorder::PageCacheTraceRecorder(std::string&& file_name, int fd,
+                                               usize capacity) noexcept
+    : file_name_{std::move(file_name)}
+    , fd_{fd}
+    , start_time_{std::chrono::steady_clock::now()}
+    , capacity_{capacity}
+    , entries_{new Entry[capacity]}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCacheTraceRecorder::~PageCacheTraceRecorder() noexcept
+{
+  Status status = this->flush();
+  if (!status.ok()) {
+    LLFS_LOG_WARNING() << "Failed to flush page cache trace; " << BATT_INSPECT(this->file_name_)
+                       << BATT_INSPECT(status);
+  }
+  close_fd(this->fd_).IgnoreError();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheTraceRecorder::record(PageId page_id, bool hit,
+                                    std::chrono::steady_clock::time_point start_time)
+{
+  const auto now = std::chrono::steady_clock::now();
+  const u64 i = this->next_.fetch_add(1);
+  Entry& entry = this->entries_[i & (this->capacity_ - 1)];
+
+  entry.seq.store(2 * i + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  entry.record.timestamp_nsec =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(start_time - this->start_time_).count();
+  entry.record.page_id = PackedPageId::from(page_id);
+  entry.record.wait_usec = static_cast<u32>(std::min<i64>(
+      std::chrono::duration_cast<std::chrono::microseconds>(now - start_time).count(),
+      std::numeric_limits<u32>::max()));
+  entry.record.hit = hit ? 1 : 0;
+  std::memset(entry.record.reserved_, 0, sizeof(entry.record.reserved_));
+
+  entry.seq.store(2 * i + 2, std::memory_order_release);
+
+  // Whoever completes each half of the ring writes it out.
+  //
+  if (((i + 1) & (this->capacity_ / 2 - 1)) == 0) {
+    Status status = this->flush();
+    if (!status.ok()) {
+      LLFS_LOG_WARNING() << "Failed to flush page cache trace; "
+                         << BATT_INSPECT(this->file_name_) << BATT_INSPECT(status);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageCacheTraceRecorder::flush()
+{
+  std::unique_lock<std::mutex> lock{this->flush_mutex_};
+
+  const u64 end = this->next_.load();
+  u64 begin = this->flushed_;
+
+  // Anything more than a full ring behind has been overwritten.
+  //
+  if (end - begin > this->capacity_) {
+    this->dropped_count_.fetch_add(end - this->capacity_ - begin);
+    begin = end - this->capacity_;
+  }
+
+  std::vector<PackedPageCacheTraceRecord> records;
+  records.reserve(end - begin);
+
+  u64 i = begin;
+  for (; i < end; ++i) {
+    const Entry& entry = this->entries_[i & (this->capacity_ - 1)];
+
+    const u64 seq_before = entry.seq.load(std::memory_order_acquire);
+
+    // Record `i` has been claimed but not finished yet; pick up from here next time.
+    //
+    if (seq_before < 2 * i + 2) {
+      break;
+    }
+
+    PackedPageCacheTraceRecord record = entry.record;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const u64 seq_after = entry.seq.load(std::memory_order_relaxed);
+
+    if (seq_before != 2 * i + 2 || seq_after != seq_before) {
+      this->dropped_count_.fetch_add(1);
+      continue;
+    }
+    records.emplace_back(record);
+  }
+
+  this->flushed_ = i;
+
+  if (records.empty()) {
+    return OkStatus();
+  }
+
+  const usize n_bytes = records.size() * sizeof(PackedPageCacheTraceRecord);
+  BATT_REQUIRE_OK(write_fd(this->fd_, ConstBuffer{records.data(), n_bytes}, this->file_offset_));
+
+  this->file_offset_ += n_bytes;
+  this->flushed_count_.fetch_add(records.size());
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 PageCacheTraceRecorder::flushed_count() const
+{
+  return this->flushed_count_.load();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 PageCacheTraceRecorder::dropped_count() const
+{
+  return this->dropped_count_.load();
+}
+
+}  // namespace llfs
@@ -0,0 +1,159 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_CACHE_TRACE_HPP
+#define LLFS_PAGE_CACHE_TRACE_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/packed_page_id.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/static_assert.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief One page lookup in a PageCache trace file (see PageCacheOptions::page_cache_trace_file).
+ * A trace file is just an array of these.
+ */
+struct PackedPageCacheTraceRecord {
+  /** \brief When the lookup started, in nanoseconds since the trace was opened.
+   */
+  little_u64 timestamp_nsec;
+
+  /** \brief The page that was looked up.
+   */
+  PackedPageId page_id;
+
+  /** \brief How long the caller waited for the page to be available (i.e., the read, for a miss),
+   * in microseconds.
+   */
+  little_u32 wait_usec;
+
+  /** \brief 1 if the page was already in the cache (or being loaded), 0 if the lookup started a
+   * read.
+   */
+  little_u8 hit;
+
+  little_u8 reserved_[3];
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedPageCacheTraceRecord), 24);
+
+/** \brief An unpacked PackedPageCacheTraceRecord.
+ */
+struct PageCacheTraceEvent {
+  u64 timestamp_nsec;
+  PageId page_id;
+  u32 wait_usec;
+  bool hit;
+};
+
+/** \brief Reads all the records in a trace file written by PageCacheTraceRecorder.  A partial
+ * record at the end of the file is ignored.
+ */
+StatusOr<std::vector<PageCacheTraceEvent>> read_page_cache_trace(std::string_view file_name);
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Records PageCache lookups into a fixed-size in-memory ring buffer, which is appended to
+ * a trace file each time half of it has been filled (and when the recorder is destroyed).
+ *
+ * `record` is lock-free: it claims the next ring entry with a single atomic increment.  If the
+ * ring wraps around before some entries have been written out (or while they are still being
+ * written), those records are dropped rather than blocking the caller; see `dropped_count`.
+ */
+class PageCacheTraceRecorder
+{
+ public:
+  static constexpr usize kDefaultCapacity = 64 * 1024;
+
+  /** \brief Creates (or truncates) the trace file with the given name.  `capacity` (the number of
+   * records in the ring) is rounded up to a power of 2.
+   */
+  static StatusOr<std::unique_ptr<PageCacheTraceRecorder>> open(
+      std::string_view file_name, usize capacity = kDefaultCapacity);
+
+  PageCacheTraceRecorder(const PageCacheTraceRecorder&) = delete;
+  PageCacheTraceRecorder& operator=(const PageCacheTraceRecorder&) = delete;
+
+  /** \brief Flushes any remaining records and closes the file.
+   */
+  ~PageCacheTraceRecorder() noexcept;
+
+  /** \brief Adds a record for a lookup of `page_id` that started at `start_time`.  Safe to call
+   * concurrently.
+   */
+  void record(PageId page_id, bool hit, std::chrono::steady_clock::time_point start_time);
+
+  /** \brief Appends all records added since the last flush to the trace file.
+   */
+  Status flush();
+
+  /** \brief The number of records written to the file so far.
+   */
+  u64 flushed_count() const;
+
+  /** \brief The number of records that were overwritten (or still being written) before they
+   * could be flushed.
+   */
+  u64 dropped_count() const;
+
+ private:
+  struct Entry {
+    // 2*i+1 while record `i` is being written to this entry, 2*i+2 once it is complete.
+    //
+    std::atomic<u64> seq{0};
+    PackedPageCacheTraceRecord record;
+  };
+
+  explicit PageCacheTraceRecorder(std::string&& file_name, int fd, usize capacity) noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const std::string file_name_;
+
+  const int fd_;
+
+  const std::chrono::steady_clock::time_point start_time_;
+
+  const usize capacity_;
+
+  std::unique_ptr<Entry[]> entries_;
+
+  // The index of the next record to be added.
+  //
+  std::atomic<u64> next_{0};
+
+  // Protects `flushed_`, `file_offset_`, and the file.
+  //
+  mutable std::mutex flush_mutex_;
+
+  u64 flushed_ = 0;
+
+  u64 file_offset_ = 0;
+
+  std::atomic<u64> flushed_count_{0};
+
+  std::atomic<u64> dropped_count_{0};
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_PAGE_CACHE_TRACE_HPP
@@ -0,0 +1,126 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_cache_trace.hpp>
+//
+#include <llfs/page_cache_trace.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/filesystem.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//
+//  1. (RoundTrip) Records added to a recorder whose ring wraps around several times are all read
+//     back from the file, in order, once the recorder is destroyed.
+//  2. (Concurrent) Records added from several threads at once are either written to the file or
+//     counted as dropped; none are lost or corrupted.
+
+using llfs::PageCacheTraceEvent;
+using llfs::PageCacheTraceRecorder;
+using llfs::PageId;
+
+using namespace llfs::int_types;
+
+const std::string kTraceFileName = "/tmp/llfs_page_cache_trace_test_file";
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageCacheTraceTest, RoundTrip)
+{
+  constexpr usize kNumRecords = 1000;
+  {
+    llfs::StatusOr<std::unique_ptr<PageCacheTraceRecorder>> recorder =
+        PageCacheTraceRecorder::open(kTraceFileName, /*capacity=*/64);
+    ASSERT_TRUE(recorder.ok()) << BATT_INSPECT(recorder.status());
+
+    for (usize i = 0; i < kNumRecords; ++i) {
+      (*recorder)->record(PageId{i}, /*hit=*/(i % 3 != 0), std::chrono::steady_clock::now());
+    }
+    EXPECT_EQ((*recorder)->dropped_count(), 0u);
+  }
+
+  llfs::StatusOr<std::vector<PageCacheTraceEvent>> events =
+      llfs::read_page_cache_trace(kTraceFileName);
+  ASSERT_TRUE(events.ok()) << BATT_INSPECT(events.status());
+  ASSERT_EQ(events->size(), kNumRecords);
+
+  for (usize i = 0; i < kNumRecords; ++i) {
+    EXPECT_EQ((*events)[i].page_id, PageId{i});
+    EXPECT_EQ((*events)[i].hit, (i % 3 != 0));
+    if (i > 0) {
+      EXPECT_LE((*events)[i - 1].timestamp_nsec, (*events)[i].timestamp_nsec);
+    }
+  }
+
+  llfs::delete_file(kTraceFileName).IgnoreError();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageCacheTraceTest, Concurrent)
+{
+  constexpr usize kNumThreads = 4;
+  constexpr usize kRecordsPerThread = 10000;
+
+  u64 flushed_count = 0;
+  u64 dropped_count = 0;
+  {
+    llfs::StatusOr<std::unique_ptr<PageCacheTraceRecorder>> recorder =
+        PageCacheTraceRecorder::open(kTraceFileName, /*capacity=*/256);
+    ASSERT_TRUE(recorder.ok()) << BATT_INSPECT(recorder.status());
+
+    std::vector<std::thread> threads;
+    for (usize thread_i = 0; thread_i < kNumThreads; ++thread_i) {
+      threads.emplace_back([&recorder, thread_i] {
+        for (usize i = 0; i < kRecordsPerThread; ++i) {
+          (*recorder)->record(PageId{(thread_i << 32) | i}, /*hit=*/true,
+                              std::chrono::steady_clock::now());
+        }
+      });
+    }
+    for (std::thread& t : threads) {
+      t.join();
+    }
+
+    ASSERT_TRUE((*recorder)->flush().ok());
+
+    flushed_count = (*recorder)->flushed_count();
+    dropped_count = (*recorder)->dropped_count();
+  }
+
+  EXPECT_EQ(flushed_count + dropped_count, kNumThreads * kRecordsPerThread);
+
+  llfs::StatusOr<std::vector<PageCacheTraceEvent>> events =
+      llfs::read_page_cache_trace(kTraceFileName);
+  ASSERT_TRUE(events.ok()) << BATT_INSPECT(events.status());
+  EXPECT_EQ(events->size(), flushed_count);
+
+  // The records from each thread appear in the order they were added.
+  //
+  std::vector<i64> last_i(kNumThreads, -1);
+  for (const PageCacheTraceEvent& event : *events) {
+    const usize thread_i = event.page_id.int_value() >> 32;
+    const i64 i = event.page_id.int_value() & 0xffffffffull;
+
+    ASSERT_LT(thread_i, kNumThreads);
+    EXPECT_GT(i, last_i[thread_i]);
+    last_i[thread_i] = i;
+  }
+
+  llfs::delete_file(kTraceFileName).IgnoreError();
+}
+
+}  // namespace
@@ -0,0 +1,510 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_cache_trace_replay.hpp>
+//
+
+#include <llfs/page_cache_admission_filter.hpp>
+#include <llfs/page_cache_slot_pool.hpp>
+
+#include <batteries/stream_util.hpp>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <algorithm>
+#include <array>
+#include <list>
+#include <random>
+#include <unordered_map>
+
+namespace llfs {
+
+namespace {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Exact LRU.
+//
+class LruSimulator
+{
+ public:
+  explicit LruSimulator(usize capacity) noexcept : capacity_{capacity}
+  {
+  }
+
+  // Returns true iff `page_id` was in the cache.
+  //
+  bool access(PageId page_id)
+  {
+    auto iter = this->index_.find(page_id);
+    if (iter != this->index_.end()) {
+      this->lru_.splice(this->lru_.end(), this->lru_, iter->second);
+      return true;
+    }
+
+    if (this->lru_.size() == this->capacity_) {
+      this->index_.erase(this->lru_.front());
+      this->lru_.pop_front();
+    }
+    this->index_.emplace(page_id, this->lru_.insert(this->lru_.end(), page_id));
+
+    return false;
+  }
+
+ private:
+  const usize capacity_;
+
+  // Least recently used at the front.
+  //
+  std::list<PageId> lru_;
+
+  std::unordered_map<PageId, std::list<PageId>::iterator, PageId::Hash> index_;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Mirrors the eviction (and, optionally, admission) logic of PageCacheSlot::Pool for a single
+// shard, with a fixed random seed so results are repeatable.
+//
+class SampledLruSimulator
+{
+ public:
+  explicit SampledLruSimulator(usize capacity, bool scan_resistant) noexcept
+      : slots_(capacity)
+      , filter_{scan_resistant ? std::make_unique<FrequencySketchAdmissionFilter>(capacity)
+                               : nullptr}
+      , probation_slots_(
+            std::max<usize>(1, capacity * PageCacheSlot::Pool::kProbationSlotsPerMille / 1000),
+            kInvalidIndex)
+  {
+  }
+
+  bool access(PageId page_id)
+  {
+    const u64 now = ++this->clock_;
+
+    if (this->filter_) {
+      this->filter_->record_access(page_id);
+    }
+
+    auto iter = this->index_.find(page_id);
+    if (iter != this->index_.end()) {
+      this->slots_[iter->second].latest_use = now;
+      return true;
+    }
+
+    usize slot_i = this->n_allocated_;
+    if (slot_i < this->slots_.size()) {
+      ++this->n_allocated_;
+    } else {
+      slot_i = this->pick_victim(page_id);
+      this->index_.erase(this->slots_[slot_i].key);
+    }
+
+    this->slots_[slot_i] = Slot{
+        .key = page_id,
+        .latest_use = now,
+    };
+    this->index_.emplace(page_id, slot_i);
+
+    return false;
+  }
+
+ private:
+  static constexpr usize kInvalidIndex = ~usize{0};
+
+  struct Slot {
+    PageId key;
+    u64 latest_use;
+  };
+
+  usize pick_victim(PageId candidate)
+  {
+    const usize n_slots = this->slots_.size();
+    if (n_slots == 1) {
+      return 0;
+    }
+
+    std::uniform_int_distribution<usize> pick_first_slot{0, n_slots - 1};
+    std::uniform_int_distribution<usize> pick_second_slot{0, n_slots - 2};
+
+    const usize first_slot_i = pick_first_slot(this->rng_);
+    usize second_slot_i = pick_second_slot(this->rng_);
+    if (second_slot_i >= first_slot_i) {
+      ++second_slot_i;
+    }
+
+    const auto older = [this](usize a, usize b) {
+      return (this->slots_[a].latest_use < this->slots_[b].latest_use) ? a : b;
+    };
+
+    usize lru_slot_i = older(first_slot_i, second_slot_i);
+    for (usize k = 2; k < PageCacheSlot::Pool::kDefaultEvictionCandidates; ++k) {
+      lru_slot_i = older(pick_first_slot(this->rng_), lru_slot_i);
+    }
+
+    if (!this->filter_ || this->filter_->should_admit(candidate, this->slots_[lru_slot_i].key)) {
+      return lru_slot_i;
+    }
+
+    // Rejected: recycle the oldest probation slot instead (see
+    // PageCacheSlot::Pool::apply_admission_filter).
+    //
+    usize& probation_entry =
+        this->probation_slots_[this->probation_next_++ % this->probation_slots_.size()];
+
+    if (probation_entry != kInvalidIndex && probation_entry != lru_slot_i) {
+      return probation_entry;
+    }
+    probation_entry = lru_slot_i;
+
+    return lru_slot_i;
+  }
+
+  std::vector<Slot> slots_;
+  usize n_allocated_ = 0;
+  u64 clock_ = 0;
+  std::default_random_engine rng_{/*seed=*/1};
+  std::unordered_map<PageId, usize, PageId::Hash> index_;
+  std::unique_ptr<FrequencySketchAdmissionFilter> filter_;
+  std::vector<usize> probation_slots_;
+  usize probation_next_ = 0;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Adaptive Replacement Cache: T1/T2 hold cached pages seen once/more than once, B1/B2 remember
+// pages recently evicted from each, and the target size `p` of T1 adapts to hits in the ghost
+// lists.
+//
+class ArcSimulator
+{
+ public:
+  explicit ArcSimulator(usize capacity) noexcept : capacity_{capacity}
+  {
+  }
+
+  bool access(PageId page_id)
+  {
+    auto iter = this->index_.find(page_id);
+    const ListId where = (iter == this->index_.end()) ? kNone : iter->second.list;
+
+    if (where == kT1 || where == kT2) {
+      this->move_to(iter, kT2);
+      return true;
+    }
+
+    const usize c = this->capacity_;
+
+    if (where == kB1) {
+      this->p_ = std::min(c, this->p_ + std::max<usize>(1, this->size(kB2) / this->size(kB1)));
+      this->replace(/*in_b2=*/false);
+      this->move_to(iter, kT2);
+
+    } else if (where == kB2) {
+      const usize delta = std::max<usize>(1, this->size(kB1) / this->size(kB2));
+      this->p_ = (this->p_ > delta) ? this->p_ - delta : 0;
+      this->replace(/*in_b2=*/true);
+      this->move_to(iter, kT2);
+
+    } else {
+      const usize l1 = this->size(kT1) + this->size(kB1);
+      const usize total = l1 + this->size(kT2) + this->size(kB2);
+
+      if (l1 == c) {
+        if (this->size(kT1) < c) {
+          this->drop_lru(kB1);
+          this->replace(/*in_b2=*/false);
+        } else {
+          this->drop_lru(kT1);
+        }
+      } else if (total >= c) {
+        if (total == 2 * c) {
+          this->drop_lru(kB2);
+        }
+        this->replace(/*in_b2=*/false);
+      }
+
+      std::list<PageId>& t1 = this->lists_[kT1];
+      this->index_.emplace(page_id, Entry{kT1, t1.insert(t1.end(), page_id)});
+    }
+
+    return false;
+  }
+
+ private:
+  enum ListId : usize {
+    kT1 = 0,
+    kT2,
+    kB1,
+    kB2,
+    kNone,
+  };
+
+  struct Entry {
+    ListId list;
+    std::list<PageId>::iterator pos;
+  };
+
+  using Index = std::unordered_map<PageId, Entry, PageId::Hash>;
+
+  usize size(ListId list) const
+  {
+    return this->lists_[list].size();
+  }
+
+  void move_to(Index::iterator iter, ListId dst)
+  {
+    std::list<PageId>& dst_list = this->lists_[dst];
+    dst_list.splice(dst_list.end(), this->lists_[iter->second.list], iter->second.pos);
+    iter->second.list = dst;
+  }
+
+  void drop_lru(ListId list)
+  {
+    if (this->lists_[list].empty()) {
+      return;
+    }
+    this->index_.erase(this->lists_[list].front());
+    this->lists_[list].pop_front();
+  }
+
+  // Evicts the LRU page of T1 or T2 into the corresponding ghost list.
+  //
+  void replace(bool in_b2)
+  {
+    const usize t1_size = this->size(kT1);
+    if (t1_size > 0 && (t1_size > this->p_ || (in_b2 && t1_size == this->p_))) {
+      this->move_to(this->index_.find(this->lists_[kT1].front()), kB1);
+    } else if (!this->lists_[kT2].empty()) {
+      this->move_to(this->index_.find(this->lists_[kT2].front()), kB2);
+    }
+  }
+
+  const usize capacity_;
+  usize p_ = 0;
+  std::array<std::list<PageId>, 4> lists_;
+  Index index_;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Mirrors PageCacheSlot::Pool::evict_clock_pro (and reset_clock_state) for a single shard.
+//
+class ClockProSimulator
+{
+ public:
+  explicit ClockProSimulator(usize capacity) noexcept
+      : slots_(capacity)
+      , max_hot_{capacity * PageCacheSlot::Pool::kClockProMaxHotPerMille / 1000}
+      , test_keys_(capacity, PageId{})
+  {
+  }
+
+  bool access(PageId page_id)
+  {
+    auto iter = this->index_.find(page_id);
+    if (iter != this->index_.end()) {
+      this->slots_[iter->second].referenced = true;
+      return true;
+    }
+
+    usize slot_i = this->n_allocated_;
+    if (slot_i < this->slots_.size()) {
+      ++this->n_allocated_;
+    } else {
+      slot_i = this->pick_victim();
+
+      const PageId evicted_key = this->slots_[slot_i].key;
+      this->index_.erase(evicted_key);
+      this->test_key(evicted_key) = evicted_key;
+    }
+
+    Slot& slot = this->slots_[slot_i];
+    if (slot.hot) {
+      --this->n_hot_;
+    }
+
+    PageId& test_key = this->test_key(page_id);
+    const bool hot = (test_key == page_id) && (this->n_hot_ < this->max_hot_);
+    if (test_key == page_id) {
+      test_key = PageId{};
+    }
+    if (hot) {
+      ++this->n_hot_;
+    }
+
+    slot = Slot{
+        .key = page_id,
+        .referenced = false,
+        .hot = hot,
+    };
+    this->index_.emplace(page_id, slot_i);
+
+    return false;
+  }
+
+ private:
+  struct Slot {
+    PageId key;
+    bool referenced;
+    bool hot;
+  };
+
+  usize pick_victim()
+  {
+    for (;;) {
+      const usize slot_i = this->hand_++ % this->slots_.size();
+      Slot& slot = this->slots_[slot_i];
+
+      if (slot.referenced) {
+        slot.referenced = false;
+        if (!slot.hot && this->n_hot_ < this->max_hot_) {
+          slot.hot = true;
+          ++this->n_hot_;
+        }
+      } else if (slot.hot) {
+        slot.hot = false;
+        --this->n_hot_;
+      } else {
+        return slot_i;
+      }
+    }
+  }
+
+  PageId& test_key(PageId key)
+  {
+    return this->test_keys_[((key.int_value() * 0x9e3779b97f4a7c15ull) >> 17) %
+                            this->test_keys_.size()];
+  }
+
+  std::vector<Slot> slots_;
+  usize n_allocated_ = 0;
+  usize hand_ = 0;
+  usize n_hot_ = 0;
+  const usize max_hot_;
+  std::vector<PageId> test_keys_;
+  std::unordered_map<PageId, usize, PageId::Hash> index_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename Simulator>
+u64 count_misses(const Slice<const PageCacheTraceEvent>& trace, Simulator&& simulator)
+{
+  u64 miss_count = 0;
+  for (const PageCacheTraceEvent& event : trace) {
+    if (!simulator.access(event.page_id)) {
+      ++miss_count;
+    }
+  }
+  return miss_count;
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, PageCacheReplayPolicy t)
+{
+  switch (t) {
+    case PageCacheReplayPolicy::kLru:
+      return out << "Lru";
+    case PageCacheReplayPolicy::kSampledLru:
+      return out << "SampledLru";
+    case PageCacheReplayPolicy::kScanResistant:
+      return out << "ScanResistant";
+    case PageCacheReplayPolicy::kArc:
+      return out << "Arc";
+    case PageCacheReplayPolicy::kClockPro:
+      return out << "ClockPro";
+  }
+  return out << "PageCacheReplayPolicy{" << static_cast<int>(t) << "}";
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<PageCacheReplayPolicy> parse_page_cache_replay_policy(std::string_view name)
+{
+  for (PageCacheReplayPolicy policy : {
+           PageCacheReplayPolicy::kLru,
+           PageCacheReplayPolicy::kSampledLru,
+           PageCacheReplayPolicy::kScanResistant,
+           PageCacheReplayPolicy::kArc,
+           PageCacheReplayPolicy::kClockPro,
+       }) {
+    if (boost::algorithm::iequals(name, batt::to_string(policy))) {
+      return policy;
+    }
+  }
+  return {batt::StatusCode::kInvalidArgument};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, const PageCacheReplayResult& t)
+{
+  return out << "PageCacheReplayResult{.policy=" << t.policy << ", .cache_size=" << t.cache_size
+             << ", .access_count=" << t.access_count << ", .miss_count=" << t.miss_count
+             << ", .miss_ratio=" << t.miss_ratio() << ",}";
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCacheReplayResult replay_page_cache_trace(const Slice<const PageCacheTraceEvent>& trace,
+                                              PageCacheReplayPolicy policy, usize cache_size)
+{
+  BATT_CHECK_GT(cache_size, 0u);
+
+  PageCacheReplayResult result{
+      .policy = policy,
+      .cache_size = cache_size,
+      .access_count = trace.size(),
+      .miss_count = 0,
+  };
+
+  switch (policy) {
+    case PageCacheReplayPolicy::kLru:
+      result.miss_count = count_misses(trace, LruSimulator{cache_size});
+      break;
+
+    case PageCacheReplayPolicy::kSampledLru:
+      result.miss_count =
+          count_misses(trace, SampledLruSimulator{cache_size, /*scan_resistant=*/false});
+      break;
+
+    case PageCacheReplayPolicy::kScanResistant:
+      result.miss_count =
+          count_misses(trace, SampledLruSimulator{cache_size, /*scan_resistant=*/true});
+      break;
+
+    case PageCacheReplayPolicy::kArc:
+      result.miss_count = count_misses(trace, ArcSimulator{cache_size});
+      break;
+
+    case PageCacheReplayPolicy::kClockPro:
+      result.miss_count = count_misses(trace, ClockProSimulator{cache_size});
+      break;
+  }
+
+  return result;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::vector<PageCacheReplayResult> page_cache_miss_ratio_curve(
+    const Slice<const PageCacheTraceEvent>& trace, PageCacheReplayPolicy policy,
+    const std::vector<usize>& cache_sizes)
+{
+  std::vector<PageCacheReplayResult> curve;
+  curve.reserve(cache_sizes.size());
+
+  for (usize cache_size : cache_sizes) {
+    curve.emplace_back(replay_page_cache_trace(trace, policy, cache_size));
+  }
+
+  return curve;
+}
+
+}  // namespace llfs
@@ -0,0 +1,89 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_CACHE_TRACE_REPLAY_HPP
+#define LLFS_PAGE_CACHE_TRACE_REPLAY_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/page_cache_trace.hpp>
+#include <llfs/slice.hpp>
+#include <llfs/status.hpp>
+
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace llfs {
+
+/** \brief The eviction policies that a PageCache trace can be replayed against.
+ */
+enum struct PageCacheReplayPolicy {
+  // Exact least-recently-used.
+  //
+  kLru,
+
+  // The policy used by PageCacheSlot::Pool: evict the least recently used of a few randomly chosen
+  // slots.
+  //
+  kSampledLru,
+
+  // kSampledLru plus the FrequencySketchAdmissionFilter and probation slots used when
+  // PageCacheOptions::scan_resistant_admission() is on.
+  //
+  kScanResistant,
+
+  // Adaptive Replacement Cache (Megiddo and Modha).
+  //
+  kArc,
+
+  // The CLOCK-Pro variant used by PageCacheSlot::Pool when PageCacheOptions::clock_pro_eviction()
+  // is on.
+  //
+  kClockPro,
+};
+
+std::ostream& operator<<(std::ostream& out, PageCacheReplayPolicy t);
+
+/** \brief Parses the names printed by operator<< above (case-insensitive).
+ */
+StatusOr<PageCacheReplayPolicy> parse_page_cache_replay_policy(std::string_view name);
+
+/** \brief The outcome of replaying a trace with one policy and cache size.
+ */
+struct PageCacheReplayResult {
+  PageCacheReplayPolicy policy;
+  usize cache_size;
+  u64 access_count;
+  u64 miss_count;
+
+  double miss_ratio() const
+  {
+    return (this->access_count == 0) ? 0.0 : double(this->miss_count) / double(this->access_count);
+  }
+};
+
+std::ostream& operator<<(std::ostream& out, const PageCacheReplayResult& t);
+
+/** \brief Replays the page lookups in `trace` against a simulated cache of `cache_size` pages
+ * using the given policy.  The hit/miss outcomes recorded in the trace are ignored.
+ */
+PageCacheReplayResult replay_page_cache_trace(const Slice<const PageCacheTraceEvent>& trace,
+                                              PageCacheReplayPolicy policy, usize cache_size);
+
+/** \brief Replays `trace` once for each of the given cache sizes, producing a miss-ratio curve.
+ */
+std::vector<PageCacheReplayResult> page_cache_miss_ratio_curve(
+    const Slice<const PageCacheTraceEvent>& trace, PageCacheReplayPolicy policy,
+    const std::vector<usize>& cache_sizes);
+
+}  // namespace llfs
+
+#endif  // LLFS_PAGE_CACHE_TRACE_REPLAY_HPP
@@ -0,0 +1,158 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_cache_trace_replay.hpp>
+//
+#include <llfs/page_cache_trace_replay.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//
+//  1. (Cyclic) Looping over one more page than fits in the cache misses every time under exact
+//     LRU; one more slot leaves only the compulsory misses.
+//  2. (ScanResistance) A hot set interleaved with a long one-time scan: the scan-resistant policy,
+//     ARC and CLOCK-Pro miss less than plain (sampled) LRU.
+//  3. (MissRatioCurve) The LRU miss ratio never goes up as the cache grows, and reaches the
+//     compulsory miss ratio once everything fits.
+//  4. (ParsePolicy) Policy names round-trip through parse_page_cache_replay_policy.
+
+using llfs::PageCacheReplayPolicy;
+using llfs::PageCacheReplayResult;
+using llfs::PageCacheTraceEvent;
+using llfs::PageId;
+
+using namespace llfs::int_types;
+
+void add_access(std::vector<PageCacheTraceEvent>* trace, u64 page)
+{
+  trace->emplace_back(PageCacheTraceEvent{
+      .timestamp_nsec = trace->size(),
+      .page_id = PageId{page},
+      .wait_usec = 0,
+      .hit = false,
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageCacheTraceReplayTest, Cyclic)
+{
+  constexpr usize kCacheSize = 100;
+
+  std::vector<PageCacheTraceEvent> trace;
+  for (usize round = 0; round < 20; ++round) {
+    for (u64 page = 0; page <= kCacheSize; ++page) {
+      add_access(&trace, page);
+    }
+  }
+
+  const PageCacheReplayResult too_small = llfs::replay_page_cache_trace(
+      llfs::as_slice(trace), PageCacheReplayPolicy::kLru, kCacheSize);
+  const PageCacheReplayResult big_enough = llfs::replay_page_cache_trace(
+      llfs::as_slice(trace), PageCacheReplayPolicy::kLru, kCacheSize + 1);
+
+  EXPECT_EQ(too_small.access_count, trace.size());
+  EXPECT_EQ(too_small.miss_count, trace.size());
+  EXPECT_EQ(big_enough.miss_count, kCacheSize + 1);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageCacheTraceReplayTest, ScanResistance)
+{
+  constexpr usize kCacheSize = 1000;
+  constexpr u64 kHotPages = 500;
+  constexpr u64 kScanBase = 1000000;
+
+  std::default_random_engine rng{/*seed=*/7};
+  std::uniform_int_distribution<u64> pick_hot_page{0, kHotPages - 1};
+
+  std::vector<PageCacheTraceEvent> trace;
+  u64 scan_page = kScanBase;
+  for (usize i = 0; i < 200000; ++i) {
+    if (i % 2 == 0) {
+      add_access(&trace, pick_hot_page(rng));
+    } else {
+      add_access(&trace, scan_page++);
+    }
+  }
+
+  const auto miss_ratio = [&](PageCacheReplayPolicy policy) {
+    return llfs::replay_page_cache_trace(llfs::as_slice(trace), policy, kCacheSize).miss_ratio();
+  };
+
+  const double sampled_lru = miss_ratio(PageCacheReplayPolicy::kSampledLru);
+  const double scan_resistant = miss_ratio(PageCacheReplayPolicy::kScanResistant);
+  const double arc = miss_ratio(PageCacheReplayPolicy::kArc);
+  const double clock_pro = miss_ratio(PageCacheReplayPolicy::kClockPro);
+
+  EXPECT_LT(scan_resistant, sampled_lru) << BATT_INSPECT(scan_resistant);
+  EXPECT_LT(arc, sampled_lru) << BATT_INSPECT(arc);
+  EXPECT_LT(clock_pro, sampled_lru) << BATT_INSPECT(clock_pro);
+
+  // Every scan access is a compulsory miss, so nothing can do better than 50%.
+  //
+  EXPECT_GE(scan_resistant, 0.5);
+  EXPECT_GE(arc, 0.5);
+  EXPECT_GE(clock_pro, 0.5);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageCacheTraceReplayTest, MissRatioCurve)
+{
+  constexpr u64 kNumPages = 256;
+
+  std::default_random_engine rng{/*seed=*/3};
+  std::geometric_distribution<u64> pick_page{0.02};
+
+  std::vector<PageCacheTraceEvent> trace;
+  for (usize i = 0; i < 50000; ++i) {
+    add_access(&trace, pick_page(rng) % kNumPages);
+  }
+
+  const std::vector<PageCacheReplayResult> curve = llfs::page_cache_miss_ratio_curve(
+      llfs::as_slice(trace), PageCacheReplayPolicy::kLru, {8, 16, 32, 64, 128, 256});
+
+  ASSERT_EQ(curve.size(), 6u);
+  for (usize i = 1; i < curve.size(); ++i) {
+    EXPECT_LE(curve[i].miss_count, curve[i - 1].miss_count) << BATT_INSPECT(curve[i]);
+  }
+  EXPECT_LE(curve.back().miss_count, kNumPages);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageCacheTraceReplayTest, ParsePolicy)
+{
+  for (PageCacheReplayPolicy policy : {
+           PageCacheReplayPolicy::kLru,
+           PageCacheReplayPolicy::kSampledLru,
+           PageCacheReplayPolicy::kScanResistant,
+           PageCacheReplayPolicy::kArc,
+           PageCacheReplayPolicy::kClockPro,
+       }) {
+    llfs::StatusOr<PageCacheReplayPolicy> parsed =
+        llfs::parse_page_cache_replay_policy(batt::to_string(policy));
+    ASSERT_TRUE(parsed.ok());
+    EXPECT_EQ(*parsed, policy);
+  }
+
+  EXPECT_EQ(llfs::parse_page_cache_replay_policy("arc").value_or(PageCacheReplayPolicy::kLru),
+            PageCacheReplayPolicy::kArc);
+  EXPECT_FALSE(llfs::parse_page_cache_replay_policy("fifo").ok());
+}
+
+}  // namespace
@@ -0,0 +1,366 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_cache_warm_start.hpp>
+//
+
+#include <llfs/crc.hpp>
+#include <llfs/filesystem.hpp>
+#include <llfs/logging.hpp>
+#include <llfs/page_cache.hpp>
+#include <llfs/status_code.hpp>
+
+#include <batteries/checked_cast.hpp>
+#include <batteries/finally.hpp>
+#include <batteries/syscall_retry.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <tuple>
+
+namespace llfs {
+
+namespace {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCache::PageDeviceEntry* find_device(PageCache& cache, PageId page_id)
+{
+  for (PageCache::PageDeviceEntry* entry : cache.all_devices()) {
+    if (entry->arena.id() == PageIdFactory::get_device_id(page_id)) {
+      return entry;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status write_page_cache_hot_list(std::string_view file_name, const Slice<const PageId>& page_ids)
+{
+  std::vector<PackedPageId> packed_ids;
+  packed_ids.reserve(page_ids.size());
+  for (PageId page_id : page_ids) {
+    packed_ids.emplace_back(PackedPageId::from(page_id));
+  }
+  const usize packed_ids_size = packed_ids.size() * sizeof(PackedPageId);
+
+  PackedPageCacheHotListHeader header;
+  header.magic = PackedPageCacheHotListHeader::kMagic;
+  header.version = PackedPageCacheHotListHeader::kVersion;
+  header.page_count = packed_ids.size();
+  {
+    auto crc64 = make_crc64();
+    crc64.process_bytes(packed_ids.data(), packed_ids_size);
+    header.page_ids_crc64 = crc64.checksum();
+  }
+
+  // Write to a temporary file and rename it over the old one, so that a crash while saving never
+  // leaves a partial list behind.  The list is only a hint, so we don't bother to fsync it.
+  //
+  const std::string tmp_file_name = std::string{file_name} + ".tmp";
+
+  delete_file(tmp_file_name).IgnoreError();
+
+  StatusOr<int> fd = create_file_read_write(tmp_file_name, OpenForAppend{false});
+  BATT_REQUIRE_OK(fd);
+  {
+    auto on_scope_exit = batt::finally([&] {
+      close_fd(*fd).IgnoreError();
+    });
+
+    BATT_REQUIRE_OK(write_fd(*fd, ConstBuffer{&header, sizeof(header)}, /*offset=*/0));
+    if (packed_ids_size != 0) {
+      BATT_REQUIRE_OK(write_fd(*fd, ConstBuffer{packed_ids.data(), packed_ids_size},
+                               /*offset=*/sizeof(header)));
+    }
+  }
+
+  const int retval = batt::syscall_retry([&] {
+    return std::rename(/*from=*/tmp_file_name.c_str(), /*to=*/std::string{file_name}.c_str());
+  });
+  BATT_REQUIRE_OK(batt::status_from_retval(retval));
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::vector<PageId>> read_page_cache_hot_list(std::string_view file_name)
+{
+  StatusOr<i64> file_size = sizeof_file(file_name);
+  BATT_REQUIRE_OK(file_size);
+
+  if (*file_size < (i64)sizeof(PackedPageCacheHotListHeader)) {
+    return ::llfs::make_status(StatusCode::kPageCacheHotListBadData);
+  }
+
+  PackedPageCacheHotListHeader header;
+  BATT_REQUIRE_OK(read_file(file_name, MutableBuffer{&header, sizeof(header)}));
+
+  if (header.magic != PackedPageCacheHotListHeader::kMagic ||
+      header.version != PackedPageCacheHotListHeader::kVersion ||
+      sizeof(PackedPageCacheHotListHeader) + header.page_count * sizeof(PackedPageId) !=
+          BATT_CHECKED_CAST(u64, *file_size)) {
+    return ::llfs::make_status(StatusCode::kPageCacheHotListBadData);
+  }
+
+  std::vector<PackedPageId> packed_ids(header.page_count);
+  const usize packed_ids_size = packed_ids.size() * sizeof(PackedPageId);
+
+  if (packed_ids_size != 0) {
+    BATT_REQUIRE_OK(read_file(file_name, MutableBuffer{packed_ids.data(), packed_ids_size},
+                              /*offset=*/sizeof(header)));
+  }
+  {
+    auto crc64 = make_crc64();
+    crc64.process_bytes(packed_ids.data(), packed_ids_size);
+    if (header.page_ids_crc64 != crc64.checksum()) {
+      return ::llfs::make_status(StatusCode::kPageCacheHotListBadData);
+    }
+  }
+
+  std::vector<PageId> page_ids;
+  page_ids.reserve(packed_ids.size());
+  for (const PackedPageId& packed_id : packed_ids) {
+    page_ids.emplace_back(packed_id.as_page_id());
+  }
+
+  return page_ids;
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class PageCacheWarmStart
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ PageCacheWarmStart::PageCacheWarmStart(PageCache& cache,
+                                                    batt::TaskScheduler& scheduler,
+                                                    const Options& options) noexcept
+    : cache_{cache}
+    , scheduler_{scheduler}
+    , options_{options}
+{
+  BATT_CHECK_GT(this->options_.save_interval_sec, 0.0);
+  BATT_CHECK_GT(this->options_.max_in_flight, 0u);
+
+  this->save_task_.emplace(
+      this->scheduler_.schedule_task(),
+      [this] {
+        this->save_task_main();
+      },
+      "PageCacheWarmStart::save_task");
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCacheWarmStart::~PageCacheWarmStart() noexcept
+{
+  this->halt();
+  this->join();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageCacheWarmStart::save()
+{
+  std::unique_lock<std::mutex> lock{this->save_mutex_};
+
+  const std::vector<PageId> page_ids = this->cache_.hot_pages(this->options_.max_pages);
+
+  BATT_REQUIRE_OK(write_page_cache_hot_list(this->options_.file_name, as_slice(page_ids)));
+
+  this->metrics_.save_count.add(1);
+  this->metrics_.saved_page_count.set(page_ids.size());
+
+  LLFS_VLOG(1) << "saved hot page list;" << BATT_INSPECT(this->options_.file_name)
+               << BATT_INSPECT(page_ids.size());
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageCacheWarmStart::start_restore()
+{
+  std::unique_lock<std::mutex> lock{this->restore_mutex_};
+
+  if (this->restore_started_ || this->halt_requested_.load()) {
+    return Status{batt::StatusCode::kFailedPrecondition};
+  }
+
+  StatusOr<std::vector<PageId>> page_ids = read_page_cache_hot_list(this->options_.file_name);
+  BATT_REQUIRE_OK(page_ids);
+
+  this->restore_started_ = true;
+
+  // Drop the pages that no longer exist; this only consults the in-memory allocator state, so it is
+  // much cheaper than finding out by reading the page.
+  //
+  struct RestorePage {
+    page_device_id_int device_id;
+    i64 physical_page;
+    PageId page_id;
+  };
+
+  std::vector<RestorePage> to_restore;
+  to_restore.reserve(page_ids->size());
+
+  for (PageId page_id : *page_ids) {
+    PageCache::PageDeviceEntry* const entry = find_device(this->cache_, page_id);
+    if (!entry) {
+      this->metrics_.stale_count.add(1);
+      continue;
+    }
+
+    StatusOr<PageAllocator*> allocator = entry->arena.try_allocator();
+    if (!allocator.ok()) {
+      this->metrics_.stale_count.add(1);
+      continue;
+    }
+
+    const PageAllocatorRefCountStatus status = (*allocator)->get_ref_count_status(page_id);
+
+    if (status.page_id != page_id || status.ref_count <= 0) {
+      this->metrics_.stale_count.add(1);
+      continue;
+    }
+
+    to_restore.emplace_back(RestorePage{
+        .device_id = entry->arena.id(),
+        .physical_page = entry->arena.device().page_ids().get_physical_page(page_id),
+        .page_id = page_id,
+    });
+  }
+
+  // Load the pages in physical order, which is kindest to the devices.
+  //
+  std::sort(to_restore.begin(), to_restore.end(), [](const RestorePage& l, const RestorePage& r) {
+    return std::tie(l.device_id, l.physical_page) < std::tie(r.device_id, r.physical_page);
+  });
+
+  this->restore_list_.clear();
+  for (const RestorePage& page : to_restore) {
+    this->restore_list_.emplace_back(page.page_id);
+  }
+
+  LLFS_VLOG(1) << "restoring hot page list;" << BATT_INSPECT(this->options_.file_name)
+               << BATT_INSPECT(page_ids->size()) << BATT_INSPECT(this->restore_list_.size());
+
+  const usize n_tasks = std::min(this->options_.max_in_flight, this->restore_list_.size());
+  for (usize i = 0; i < n_tasks; ++i) {
+    this->restore_tasks_.emplace_back(std::make_unique<batt::Task>(
+        this->scheduler_.schedule_task(),
+        [this] {
+          this->restore_task_main();
+        },
+        "PageCacheWarmStart::restore_task"));
+  }
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheWarmStart::halt()
+{
+  if (this->halt_requested_.exchange(true)) {
+    return;
+  }
+
+  Status status = this->save();
+  if (!status.ok()) {
+    LLFS_LOG_WARNING() << "Failed to save hot page list; "
+                       << BATT_INSPECT(this->options_.file_name) << BATT_INSPECT(status);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheWarmStart::join()
+{
+  if (this->save_task_) {
+    this->save_task_->join();
+    this->save_task_ = None;
+  }
+
+  std::unique_lock<std::mutex> lock{this->restore_mutex_};
+  for (const std::unique_ptr<batt::Task>& task : this->restore_tasks_) {
+    task->join();
+  }
+  this->restore_tasks_.clear();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheWarmStart::save_task_main()
+{
+  const i64 interval_usec = static_cast<i64>(this->options_.save_interval_sec * 1e6);
+
+  while (this->pace(interval_usec)) {
+    Status status = this->save();
+    if (!status.ok()) {
+      LLFS_LOG_WARNING() << "Failed to save hot page list; "
+                         << BATT_INSPECT(this->options_.file_name) << BATT_INSPECT(status);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageCacheWarmStart::restore_task_main()
+{
+  while (!this->halt_requested_.load()) {
+    const usize i = this->restore_next_.fetch_add(1);
+    if (i >= this->restore_list_.size()) {
+      break;
+    }
+    const PageId page_id = this->restore_list_[i];
+
+    // The application may have loaded the page already.
+    //
+    PageCache::PageDeviceEntry* const entry = find_device(this->cache_, page_id);
+    if (entry && entry->cache.find(page_id)) {
+      this->metrics_.cached_count.add(1);
+      continue;
+    }
+
+    StatusOr<PinnedPage> loaded = this->cache_.get_page(page_id, OkIfNotFound{true});
+    if (loaded.ok()) {
+      this->metrics_.restored_count.add(1);
+    } else {
+      this->metrics_.failed_count.add(1);
+      LLFS_VLOG(1) << "failed to restore page;" << BATT_INSPECT(page_id)
+                   << BATT_INSPECT(loaded.status());
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool PageCacheWarmStart::pace(i64 usec)
+{
+  // Sleep in short steps so that `halt()` takes effect promptly.
+  //
+  static constexpr i64 kMaxSleepUsec = 100 * 1000;
+
+  while (usec > 0 && !this->halt_requested_.load()) {
+    const i64 step = std::min(usec, kMaxSleepUsec);
+    batt::Task::sleep(boost::posix_time::microseconds(step));
+    usec -= step;
+  }
+
+  return !this->halt_requested_.load();
+}
+
+}  // namespace llfs
@@ -0,0 +1,215 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_CACHE_WARM_START_HPP
+#define LLFS_PAGE_CACHE_WARM_START_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/metrics.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/packed_page_id.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/slice.hpp>
+#include <llfs/status.hpp>
+#include <llfs/version.hpp>
+
+#include <batteries/async/task.hpp>
+#include <batteries/async/task_scheduler.hpp>
+#include <batteries/static_assert.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace llfs {
+
+class PageCache;
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief The header of a hot page list file (see PageCacheWarmStart); it is followed immediately
+ * by `page_count` instances of PackedPageId, hottest (most recently used) first.
+ */
+struct PackedPageCacheHotListHeader {
+  static constexpr u64 kMagic = 0x5f0d93a8c1e64b27ull;
+
+  static constexpr u64 kVersion = make_version_u64(0, 1, 0);
+
+  // Must always be PackedPageCacheHotListHeader::kMagic.
+  //
+  big_u64 magic;
+
+  // The version of the file format.
+  //
+  big_u64 version;
+
+  // The number of page ids following this header.
+  //
+  little_u64 page_count;
+
+  // The crc64 of the page ids.
+  //
+  little_u64 page_ids_crc64;
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedPageCacheHotListHeader), 32);
+
+/** \brief Writes `page_ids` to a hot page list file, replacing it atomically if it exists.
+ */
+Status write_page_cache_hot_list(std::string_view file_name, const Slice<const PageId>& page_ids);
+
+/** \brief Reads a hot page list file written by write_page_cache_hot_list; returns
+ * StatusCode::kPageCacheHotListBadData if the file is truncated or corrupt.
+ */
+StatusOr<std::vector<PageId>> read_page_cache_hot_list(std::string_view file_name);
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Saves the set of hot pages in a PageCache to a file from time to time, and reloads them
+ * after a restart so that the cache doesn't have to be re-warmed by foreground traffic.
+ *
+ * The saved list holds the ids of the cached pages, ranked by latest use time stamp (see
+ * PageCache::hot_pages).  To restore it, the pages that no longer exist (their generation has
+ * changed, or they were freed) are dropped, using only the in-memory state of the PageAllocator;
+ * the rest are sorted by physical page and loaded by a small, fixed number of tasks, so that at
+ * most `Options::max_in_flight` reads compete with foreground reads at any time.  Pages that are
+ * already in the cache (because the application loaded them first) are skipped.
+ */
+class PageCacheWarmStart
+{
+ public:
+  struct Options {
+    // The hot page list file.
+    //
+    std::string file_name;
+
+    // How often the list is saved, in seconds.
+    //
+    double save_interval_sec;
+
+    // The maximum number of pages in the list; 0 means no limit.
+    //
+    usize max_pages;
+
+    // The number of restore tasks (and therefore the maximum number of reads in flight).
+    //
+    usize max_in_flight;
+  };
+
+  struct Metrics {
+    // Times the list was saved, and the number of pages in the latest one.
+    //
+    CountMetric<u64> save_count{0};
+    CountMetric<u64> saved_page_count{0};
+
+    // Pages loaded by the restore tasks.
+    //
+    CountMetric<u64> restored_count{0};
+
+    // Pages in the restored list that no longer exist, or whose device is unknown.
+    //
+    CountMetric<u64> stale_count{0};
+
+    // Pages already in the cache when the restore tasks got to them.
+    //
+    CountMetric<u64> cached_count{0};
+
+    // Pages that failed to load.
+    //
+    CountMetric<u64> failed_count{0};
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Creates a warm start helper for `cache`, and starts the task that periodically saves
+   * the hot page list on `scheduler`.
+   */
+  explicit PageCacheWarmStart(PageCache& cache, batt::TaskScheduler& scheduler,
+                              const Options& options) noexcept;
+
+  PageCacheWarmStart(const PageCacheWarmStart&) = delete;
+  PageCacheWarmStart& operator=(const PageCacheWarmStart&) = delete;
+
+  /** \brief Halts and joins all tasks.
+   */
+  ~PageCacheWarmStart() noexcept;
+
+  const Metrics& metrics() const noexcept
+  {
+    return this->metrics_;
+  }
+
+  /** \brief Writes the current hot page list to the file.
+   */
+  Status save();
+
+  /** \brief Reads the hot page list from the file and starts loading the pages in the background.
+   *
+   * All page layouts must be registered with the PageCache first.  Returns the error if the file
+   * can't be read, or batt::StatusCode::kFailedPrecondition if called more than once or after
+   * halt().
+   */
+  Status start_restore();
+
+  /** \brief Tells all tasks to stop; on the first call, the hot page list is also saved one last
+   * time.
+   */
+  void halt();
+
+  /** \brief Waits for all tasks to stop; `halt()` must have been called first.
+   */
+  void join();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  // The body of the periodic save task.
+  //
+  void save_task_main();
+
+  // The body of each restore task.
+  //
+  void restore_task_main();
+
+  // Sleeps for `usec` microseconds, or until `halt()` is called; returns false if halted.
+  //
+  bool pace(i64 usec);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  PageCache& cache_;
+  batt::TaskScheduler& scheduler_;
+  const Options options_;
+  Metrics metrics_;
+  std::atomic<bool> halt_requested_{false};
+
+  // Serializes calls to save().
+  //
+  std::mutex save_mutex_;
+
+  // Protects `restore_started_` and `restore_tasks_`.
+  //
+  std::mutex restore_mutex_;
+  bool restore_started_ = false;
+
+  // The pages to restore (set before the restore tasks start, then read-only), and the index of the
+  // next one to load.
+  //
+  std::vector<PageId> restore_list_;
+  std::atomic<usize> restore_next_{0};
+
+  Optional<batt::Task> save_task_;
+  std::vector<std::unique_ptr<batt::Task>> restore_tasks_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_PAGE_CACHE_WARM_START_HPP
@@ -0,0 +1,142 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_cache_warm_start.hpp>
+//
+#include <llfs/page_cache_warm_start.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/filesystem.hpp>
+#include <llfs/page_device_cache.hpp>
+#include <llfs/status_code.hpp>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//
+//  1. (RoundTrip) A hot page list written by write_page_cache_hot_list is read back unchanged, in
+//     order; this includes the empty list.
+//  2. (BadData) Truncated or corrupted files are rejected with kPageCacheHotListBadData.
+//  3. (AppendCachedPages) PageDeviceCache::append_cached_pages returns every page in the cache, in
+//     physical order, with its latest use time stamp.
+
+using llfs::PageId;
+
+using namespace llfs::int_types;
+
+const std::string kHotListFileName = "/tmp/llfs_page_cache_warm_start_test_file";
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageCacheWarmStartTest, RoundTrip)
+{
+  for (usize n_pages : {0, 1, 1000}) {
+    std::vector<PageId> page_ids;
+    for (usize i = 0; i < n_pages; ++i) {
+      page_ids.emplace_back(PageId{(i * 7919) % 100003});
+    }
+
+    ASSERT_TRUE(llfs::write_page_cache_hot_list(kHotListFileName, batt::as_slice(page_ids)).ok());
+
+    llfs::StatusOr<std::vector<PageId>> read_ids = llfs::read_page_cache_hot_list(kHotListFileName);
+
+    ASSERT_TRUE(read_ids.ok()) << BATT_INSPECT(read_ids.status());
+    EXPECT_EQ(*read_ids, page_ids);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageCacheWarmStartTest, BadData)
+{
+  const std::vector<PageId> page_ids = {PageId{1}, PageId{2}, PageId{3}};
+
+  ASSERT_TRUE(llfs::write_page_cache_hot_list(kHotListFileName, batt::as_slice(page_ids)).ok());
+
+  llfs::StatusOr<i64> file_size = llfs::sizeof_file(kHotListFileName);
+  ASSERT_TRUE(file_size.ok());
+
+  // Flip a bit in one of the page ids.
+  //
+  {
+    llfs::StatusOr<int> fd =
+        llfs::open_file_read_write(kHotListFileName, llfs::OpenForAppend{false});
+    ASSERT_TRUE(fd.ok());
+
+    const u8 garbage = 0x40;
+    const u64 offset = *file_size - 3;
+    ASSERT_TRUE(llfs::write_fd(*fd, llfs::ConstBuffer{&garbage, 1}, offset).ok());
+    ASSERT_TRUE(llfs::close_fd(*fd).ok());
+  }
+  EXPECT_EQ(llfs::read_page_cache_hot_list(kHotListFileName).status(),
+            llfs::make_status(llfs::StatusCode::kPageCacheHotListBadData));
+
+  // Truncate the file.
+  //
+  ASSERT_TRUE(llfs::truncate_file(kHotListFileName, *file_size - 1).ok());
+
+  EXPECT_EQ(llfs::read_page_cache_hot_list(kHotListFileName).status(),
+            llfs::make_status(llfs::StatusCode::kPageCacheHotListBadData));
+
+  ASSERT_TRUE(llfs::truncate_file(kHotListFileName, 4).ok());
+
+  EXPECT_EQ(llfs::read_page_cache_hot_list(kHotListFileName).status(),
+            llfs::make_status(llfs::StatusCode::kPageCacheHotListBadData));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageCacheWarmStartTest, AppendCachedPages)
+{
+  const llfs::PageIdFactory page_ids{llfs::PageCount{16}, /*page_device_id=*/3};
+
+  llfs::PageDeviceCache cache{page_ids, /*page_size=*/4096,
+                              llfs::PageCacheSlot::Pool::make_new(/*n_slots=*/8, "test_pool")};
+
+  // Insert pages out of physical order.
+  //
+  const std::vector<i64> physical_pages = {9, 2, 14};
+  for (i64 physical_page : physical_pages) {
+    llfs::StatusOr<llfs::PageCacheSlot::PinnedRef> pinned = cache.find_or_insert(
+        page_ids.make_page_id(physical_page, /*generation=*/1),
+        [](const llfs::PageCacheSlot::PinnedRef&) {
+        });
+    ASSERT_TRUE(pinned.ok());
+  }
+
+  std::vector<llfs::PageDeviceCache::CachedPage> cached_pages;
+  cache.append_cached_pages(&cached_pages);
+
+  ASSERT_EQ(cached_pages.size(), 3u);
+  EXPECT_EQ(cached_pages[0].page_id, page_ids.make_page_id(2, 1));
+  EXPECT_EQ(cached_pages[1].page_id, page_ids.make_page_id(9, 1));
+  EXPECT_EQ(cached_pages[2].page_id, page_ids.make_page_id(14, 1));
+
+  // 9 was inserted first, then 2, then 14.
+  //
+  EXPECT_LT(cached_pages[1].latest_use, cached_pages[0].latest_use);
+  EXPECT_LT(cached_pages[0].latest_use, cached_pages[2].latest_use);
+
+  // Erased pages are no longer reported.
+  //
+  cache.erase(page_ids.make_page_id(9, 1));
+
+  cached_pages.clear();
+  cache.append_cached_pages(&cached_pages);
+
+  ASSERT_EQ(cached_pages.size(), 2u);
+  EXPECT_EQ(cached_pages[0].page_id, page_ids.make_page_id(2, 1));
+  EXPECT_EQ(cached_pages[1].page_id, page_ids.make_page_id(14, 1));
+}
+
+}  // namespace
@@ -0,0 +1,200 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_compression.hpp>
+//
+
+#include <llfs/packed_page_header.hpp>
+#include <llfs/status_code.hpp>
+
+#include <batteries/checked_cast.hpp>
+#include <batteries/math.hpp>
+
+#include <lz4.h>
+
+#include <cstring>
+
+namespace llfs {
+
+namespace {
+
+// The offset of the compressed data within a compressed page image.
+//
+constexpr usize kCompressedDataOffset =
+    sizeof(PackedPageHeader) + sizeof(PackedCompressedPageHeader);
+
+// Compressed images are only worth writing if they save at least one block of this size.
+//
+constexpr i32 kCompressionBlockSizeLog2 = 9;
+
+const PackedCompressedPageHeader& get_compressed_page_header(const PageBuffer& page)
+{
+  return *reinterpret_cast<const PackedCompressedPageHeader*>(
+      reinterpret_cast<const u8*>(&page) + sizeof(PackedPageHeader));
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, PageCompression t)
+{
+  switch (t) {
+    case PageCompression::kNone:
+      return out << "None";
+    case PageCompression::kLz4:
+      return out << "Lz4";
+  }
+  return out << "(bad:PageCompression)" << (int)t;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+const PageLayoutId& compressed_page_layout_id()
+{
+  static const PageLayoutId id_ = PageLayoutId::from_str("(cmpr.)");
+  return id_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool is_compressed_page(const PageBuffer& page)
+{
+  return get_page_header(page).layout_id == compressed_page_layout_id();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::shared_ptr<const PageBuffer> compress_page(const PageBuffer& page,
+                                                PageCompression compression)
+{
+  if (compression == PageCompression::kNone || is_compressed_page(page)) {
+    return nullptr;
+  }
+
+  const PackedPageHeader& header = get_page_header(page);
+  const usize page_size = header.size;
+  const usize unused_begin = header.unused_begin;
+  const usize unused_end = header.unused_end;
+
+  if (unused_begin < sizeof(PackedPageHeader) || unused_end > page_size ||
+      unused_end < kCompressedDataOffset) {
+    return nullptr;
+  }
+
+  const u8* const src = reinterpret_cast<const u8*>(&page);
+  const usize payload_size = unused_begin - sizeof(PackedPageHeader);
+
+  std::shared_ptr<PageBuffer> compressed = PageBuffer::allocate(
+      PageSize{BATT_CHECKED_CAST(u32, page_size)}, header.page_id.unpack());
+  u8* const dst = reinterpret_cast<u8*>(compressed.get());
+
+  // The compressed data must fit in front of the original unused region (so that the tail of the
+  // page can stay where it is).
+  //
+  const int compressed_size = LZ4_compress_default(
+      reinterpret_cast<const char*>(src + sizeof(PackedPageHeader)),
+      reinterpret_cast<char*>(dst + kCompressedDataOffset), BATT_CHECKED_CAST(int, payload_size),
+      BATT_CHECKED_CAST(int, unused_end - kCompressedDataOffset));
+
+  if (compressed_size <= 0) {
+    return nullptr;
+  }
+
+  const usize compressed_end = kCompressedDataOffset + compressed_size;
+  if (batt::round_up_bits(kCompressionBlockSizeLog2, compressed_end) >=
+      batt::round_up_bits(kCompressionBlockSizeLog2, unused_begin)) {
+    return nullptr;
+  }
+
+  // Zero the new unused region, so that no stale buffer contents are written to the device, then
+  // copy the tail of the page (if any) to its original offset.
+  //
+  std::memset(dst + compressed_end, 0, unused_end - compressed_end);
+  std::memcpy(dst + unused_end, src + unused_end, page_size - unused_end);
+
+  PackedCompressedPageHeader* const compressed_header =
+      reinterpret_cast<PackedCompressedPageHeader*>(dst + sizeof(PackedPageHeader));
+  std::memset(compressed_header, 0, sizeof(PackedCompressedPageHeader));
+  compressed_header->layout_id = header.layout_id;
+  compressed_header->unused_begin = unused_begin;
+  compressed_header->unused_end = unused_end;
+  compressed_header->compressed_size = compressed_size;
+  compressed_header->compression = static_cast<u8>(compression);
+
+  PackedPageHeader* const new_header = mutable_page_header(compressed.get());
+  *new_header = header;
+  new_header->layout_id = compressed_page_layout_id();
+  new_header->unused_begin = compressed_end;
+  new_header->unused_end = unused_end;
+
+  return compressed;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::shared_ptr<const PageBuffer>> decompress_page(
+    std::shared_ptr<const PageBuffer>&& page)
+{
+  if (!is_compressed_page(*page)) {
+    return {std::move(page)};
+  }
+
+  const PackedPageHeader& header = get_page_header(*page);
+  const PackedCompressedPageHeader& compressed_header = get_compressed_page_header(*page);
+
+  const usize page_size = header.size;
+  const usize unused_begin = compressed_header.unused_begin;
+  const usize unused_end = compressed_header.unused_end;
+  const usize compressed_size = compressed_header.compressed_size;
+
+  if (unused_begin < sizeof(PackedPageHeader) || unused_begin > unused_end ||
+      unused_end > page_size || unused_end != header.unused_end ||
+      kCompressedDataOffset + compressed_size != header.unused_begin) {
+    return ::llfs::make_status(StatusCode::kPageDecompressFailed);
+  }
+
+  const u8* const src = reinterpret_cast<const u8*>(page.get());
+
+  std::shared_ptr<PageBuffer> decompressed = PageBuffer::allocate(
+      PageSize{BATT_CHECKED_CAST(u32, page_size)}, header.page_id.unpack());
+  u8* const dst = reinterpret_cast<u8*>(decompressed.get());
+
+  const usize payload_size = unused_begin - sizeof(PackedPageHeader);
+
+  switch (static_cast<PageCompression>(compressed_header.compression.value())) {
+    case PageCompression::kLz4: {
+      const int n_decompressed = LZ4_decompress_safe(
+          reinterpret_cast<const char*>(src + kCompressedDataOffset),
+          reinterpret_cast<char*>(dst + sizeof(PackedPageHeader)),
+          BATT_CHECKED_CAST(int, compressed_size), BATT_CHECKED_CAST(int, payload_size));
+
+      if (n_decompressed < 0 || static_cast<usize>(n_decompressed) != payload_size) {
+        return ::llfs::make_status(StatusCode::kPageDecompressFailed);
+      }
+      break;
+    }
+
+    case PageCompression::kNone:
+    default:
+      return ::llfs::make_status(StatusCode::kPageDecompressFailed);
+  }
+
+  std::memset(dst + unused_begin, 0, unused_end - unused_begin);
+  std::memcpy(dst + unused_end, src + unused_end, page_size - unused_end);
+
+  PackedPageHeader* const new_header = mutable_page_header(decompressed.get());
+  *new_header = header;
+  new_header->layout_id = compressed_header.layout_id;
+  new_header->unused_begin = unused_begin;
+  new_header->unused_end = unused_end;
+
+  return {std::move(decompressed)};
+}
+
+}  // namespace llfs
@@ -0,0 +1,85 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_COMPRESSION_HPP
+#define LLFS_PAGE_COMPRESSION_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/page_buffer.hpp>
+#include <llfs/page_layout_id.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/static_assert.hpp>
+
+#include <memory>
+#include <ostream>
+
+namespace llfs {
+
+// How the payload of a page is compressed when it is written to its PageDevice.  Pages are always
+// decompressed as they are read, so the cache (and all PageView implementations) only ever see
+// uncompressed pages.  See PageCache::set_page_compression.
+//
+enum struct PageCompression : u8 {
+  kNone = 0,
+  kLz4 = 1,
+};
+
+std::ostream& operator<<(std::ostream& out, PageCompression t);
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// The on-device image of a compressed page is:
+//
+//  - The PackedPageHeader of the original page, except that `layout_id` is set to
+//    `compressed_page_layout_id()` and the unused region starts right after the compressed data.
+//  - A PackedCompressedPageHeader, which saves the original layout id and unused region.
+//  - The compressed bytes of the original page between the PackedPageHeader and the start of the
+//    original unused region.
+//  - The bytes of the original page after its unused region, at their original offsets (this keeps
+//    data at the tail of the page, e.g. page ref summaries, readable without decompressing).
+//
+// Since the unused region of a compressed image is larger, devices that only write the used prefix
+// of a page (e.g., IoRingPageFileDevice) write shorter extents for compressed pages.
+//
+struct PackedCompressedPageHeader {
+  PageLayoutId layout_id;
+  little_u32 unused_begin;
+  little_u32 unused_end;
+  little_u32 compressed_size;
+  little_u8 compression;
+  little_u8 reserved_[11];
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedCompressedPageHeader), 32);
+
+// The layout id written in the PackedPageHeader of compressed page images.
+//
+const PageLayoutId& compressed_page_layout_id();
+
+// Returns true iff `page` is a compressed page image.
+//
+bool is_compressed_page(const PageBuffer& page);
+
+// Returns a compressed copy of `page`, or nullptr if `compression` is kNone or compressing the page
+// wouldn't save at least one 512-byte block.
+//
+std::shared_ptr<const PageBuffer> compress_page(const PageBuffer& page,
+                                                PageCompression compression);
+
+// If `page` is a compressed page image, returns the original (decompressed) page; otherwise returns
+// `page` unchanged.
+//
+StatusOr<std::shared_ptr<const PageBuffer>> decompress_page(
+    std::shared_ptr<const PageBuffer>&& page);
+
+}  // namespace llfs
+
+#endif  // LLFS_PAGE_COMPRESSION_HPP
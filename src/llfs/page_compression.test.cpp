@@ -0,0 +1,286 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_compression.hpp>
+//
+#include <llfs/page_compression.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/memory_page_cache.hpp>
+#include <llfs/opaque_page_view.hpp>
+#include <llfs/packed_page_header.hpp>
+#include <llfs/page_cache_job.hpp>
+#include <llfs/page_id_factory.hpp>
+#include <llfs/page_layout.hpp>
+
+#include <batteries/async/runtime.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//
+//  1. A compressible page round-trips through compress_page/decompress_page, including the bytes
+//     after its unused region, and the compressed image has a larger unused region.
+//  2. A page that doesn't compress is not compressed.
+//  3. decompress_page passes uncompressed pages through unchanged.
+//  4. A corrupt compressed image fails to decompress.
+//  5. With compression enabled for a layout, a page written through a PageCache is stored
+//     compressed (with its unused region zeroed); once it is evicted, loading it again through the
+//     cache gives back the original page.
+
+using namespace llfs::int_types;
+
+constexpr usize kTestPageSize = 64 * 1024;
+constexpr usize kTestTailSize = 100;
+
+const llfs::PageLayoutId& test_layout_id()
+{
+  static const llfs::PageLayoutId id_ = llfs::PageLayoutId::from_str("(test)");
+  return id_;
+}
+
+// Builds a page whose payload is filled by `fill_fn(offset) -> u8` up to `used_size`, with a tail
+// of `kTestTailSize` bytes at the end of the page.
+//
+template <typename FillFn>
+std::shared_ptr<llfs::PageBuffer> make_test_page(usize used_size, FillFn&& fill_fn)
+{
+  std::shared_ptr<llfs::PageBuffer> page =
+      llfs::PageBuffer::allocate(llfs::PageSize{kTestPageSize}, llfs::PageId{42});
+
+  u8* const bytes = reinterpret_cast<u8*>(page.get());
+  for (usize i = sizeof(llfs::PackedPageHeader); i < used_size; ++i) {
+    bytes[i] = fill_fn(i);
+  }
+  for (usize i = kTestPageSize - kTestTailSize; i < kTestPageSize; ++i) {
+    bytes[i] = static_cast<u8>(i * 7);
+  }
+
+  llfs::mutable_page_header(page.get())->layout_id = test_layout_id();
+  BATT_CHECK_OK(llfs::finalize_page_header(
+      page.get(), llfs::Interval<u64>{used_size, kTestPageSize - kTestTailSize}));
+
+  return page;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageCompressionTest, RoundTrip)
+{
+  const usize used_size = kTestPageSize / 2;
+  std::shared_ptr<llfs::PageBuffer> page = make_test_page(used_size, [](usize i) {
+    return static_cast<u8>((i / 64) % 8);
+  });
+
+  std::shared_ptr<const llfs::PageBuffer> compressed =
+      llfs::compress_page(*page, llfs::PageCompression::kLz4);
+
+  ASSERT_NE(compressed, nullptr);
+  EXPECT_TRUE(llfs::is_compressed_page(*compressed));
+  EXPECT_FALSE(llfs::is_compressed_page(*page));
+  EXPECT_LT(llfs::get_page_header(*compressed).used_size(),
+            llfs::get_page_header(*page).used_size());
+  EXPECT_EQ(llfs::get_page_header(*compressed).page_id.as_page_id(), llfs::PageId{42});
+
+  // The unused region of the compressed image is all zeros.
+  //
+  {
+    const llfs::PackedPageHeader& compressed_header = llfs::get_page_header(*compressed);
+    const u8* const compressed_bytes = reinterpret_cast<const u8*>(compressed.get());
+
+    EXPECT_TRUE(std::all_of(compressed_bytes + compressed_header.unused_begin,
+                            compressed_bytes + compressed_header.unused_end, [](u8 b) {
+                              return b == 0;
+                            }));
+  }
+
+  batt::StatusOr<std::shared_ptr<const llfs::PageBuffer>> decompressed =
+      llfs::decompress_page(batt::make_copy(compressed));
+
+  ASSERT_TRUE(decompressed.ok()) << BATT_INSPECT(decompressed.status());
+
+  const llfs::PackedPageHeader& header = llfs::get_page_header(**decompressed);
+  EXPECT_EQ(header.layout_id, test_layout_id());
+  EXPECT_EQ(header.unused_begin.value(), used_size);
+  EXPECT_EQ(header.unused_end.value(), kTestPageSize - kTestTailSize);
+
+  const u8* const expected = reinterpret_cast<const u8*>(page.get());
+  const u8* const actual = reinterpret_cast<const u8*>(decompressed->get());
+
+  EXPECT_EQ(std::memcmp(expected, actual, used_size), 0);
+  EXPECT_EQ(std::memcmp(expected + kTestPageSize - kTestTailSize,
+                        actual + kTestPageSize - kTestTailSize, kTestTailSize),
+            0);
+
+  // The tail is also where it was in the compressed image.
+  //
+  EXPECT_EQ(std::memcmp(expected + kTestPageSize - kTestTailSize,
+                        reinterpret_cast<const u8*>(compressed.get()) + kTestPageSize -
+                            kTestTailSize,
+                        kTestTailSize),
+            0);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageCompressionTest, IncompressiblePage)
+{
+  std::default_random_engine rng{1};
+  std::uniform_int_distribution<int> pick_byte{0, 255};
+
+  std::shared_ptr<llfs::PageBuffer> page = make_test_page(kTestPageSize / 2, [&](usize) {
+    return static_cast<u8>(pick_byte(rng));
+  });
+
+  EXPECT_EQ(llfs::compress_page(*page, llfs::PageCompression::kLz4), nullptr);
+  EXPECT_EQ(llfs::compress_page(*page, llfs::PageCompression::kNone), nullptr);
+
+  std::shared_ptr<const llfs::PageBuffer> const_page = page;
+  batt::StatusOr<std::shared_ptr<const llfs::PageBuffer>> passed_through =
+      llfs::decompress_page(batt::make_copy(const_page));
+
+  ASSERT_TRUE(passed_through.ok());
+  EXPECT_EQ(*passed_through, const_page);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageCompressionTest, CorruptImage)
+{
+  std::shared_ptr<llfs::PageBuffer> page = make_test_page(kTestPageSize / 2, [](usize) {
+    return u8{0};
+  });
+
+  std::shared_ptr<const llfs::PageBuffer> compressed =
+      llfs::compress_page(*page, llfs::PageCompression::kLz4);
+  ASSERT_NE(compressed, nullptr);
+
+  // Truncate the compressed data.
+  //
+  std::shared_ptr<llfs::PageBuffer> corrupt =
+      llfs::PageBuffer::allocate(llfs::PageSize{kTestPageSize}, llfs::PageId{42});
+  std::memcpy(corrupt.get(), compressed.get(), kTestPageSize);
+
+  auto* compressed_header = reinterpret_cast<llfs::PackedCompressedPageHeader*>(
+      reinterpret_cast<u8*>(corrupt.get()) + sizeof(llfs::PackedPageHeader));
+  compressed_header->compressed_size = compressed_header->compressed_size - 1;
+  llfs::mutable_page_header(corrupt.get())->unused_begin =
+      llfs::get_page_header(*corrupt).unused_begin - 1;
+
+  batt::StatusOr<std::shared_ptr<const llfs::PageBuffer>> decompressed =
+      llfs::decompress_page(std::shared_ptr<const llfs::PageBuffer>{corrupt});
+
+  EXPECT_FALSE(decompressed.ok());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageCompressionTest, PageCacheRoundTrip)
+{
+  constexpr llfs::PageSize kCachePageSize{4096};
+
+  llfs::StatusOr<batt::SharedPtr<llfs::PageCache>> page_cache =
+      llfs::make_memory_page_cache(batt::Runtime::instance().default_scheduler(),
+                                   /*arena_sizes=*/
+                                   {
+                                       {llfs::PageCount{4}, kCachePageSize},
+                                   },
+                                   llfs::MaxRefsPerPage{1});
+  ASSERT_TRUE(page_cache.ok()) << BATT_INSPECT(page_cache.status());
+
+  llfs::PageCache& cache = **page_cache;
+
+  ASSERT_TRUE(llfs::OpaquePageView::register_layout(cache).ok());
+  cache.set_page_compression(llfs::OpaquePageView::page_layout_id(), llfs::PageCompression::kLz4);
+
+  const u64 compressed_writes_before = cache.metrics().compressed_page_write_count.load();
+  const u64 decompressed_before = cache.metrics().decompressed_page_count.load();
+
+  // 1. Write a compressible page.
+  //
+  std::unique_ptr<llfs::PageCacheJob> job = cache.new_job();
+
+  llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer =
+      job->new_page(kCachePageSize, batt::WaitForResource::kFalse,
+                    llfs::OpaquePageView::page_layout_id(), llfs::Caller::Unknown,
+                    /*cancel_token=*/llfs::None);
+  ASSERT_TRUE(buffer.ok()) << BATT_INSPECT(buffer.status());
+
+  const llfs::PageId page_id = (*buffer)->page_id();
+  {
+    llfs::MutableBuffer payload = (*buffer)->mutable_payload();
+    u8* const bytes = static_cast<u8*>(payload.data());
+    for (usize i = 0; i < payload.size(); ++i) {
+      bytes[i] = static_cast<u8>((i / 64) % 8);
+    }
+  }
+  const llfs::ConstBuffer original_payload = (*buffer)->const_payload();
+  const std::vector<u8> expected(static_cast<const u8*>(original_payload.data()),
+                                 static_cast<const u8*>(original_payload.data()) +
+                                     original_payload.size());
+
+  ASSERT_TRUE(job->pin_new(std::make_shared<llfs::OpaquePageView>(std::move(*buffer)),
+                           llfs::Caller::Unknown)
+                  .ok());
+  ASSERT_TRUE(job->stream_new_pages().ok());
+
+  EXPECT_EQ(cache.metrics().compressed_page_write_count.load() - compressed_writes_before, 1u);
+
+  // The device holds the compressed image, with nothing but zeros in its unused region.
+  //
+  {
+    std::promise<llfs::PageDevice::ReadResult> read_result;
+    cache.arena_for_page_id(page_id).device().read(
+        page_id, [&read_result](llfs::PageDevice::ReadResult result) {
+          read_result.set_value(std::move(result));
+        });
+
+    llfs::PageDevice::ReadResult image = read_result.get_future().get();
+    ASSERT_TRUE(image.ok()) << BATT_INSPECT(image.status());
+    ASSERT_TRUE(llfs::is_compressed_page(**image));
+
+    const llfs::PackedPageHeader& header = llfs::get_page_header(**image);
+    const u8* const bytes = reinterpret_cast<const u8*>(image->get());
+
+    EXPECT_LT(header.used_size(), kCachePageSize / 2);
+    EXPECT_TRUE(std::all_of(bytes + header.unused_begin, bytes + header.unused_end, [](u8 b) {
+      return b == 0;
+    }));
+  }
+
+  // 2. Evict the page and load it again.  (Not with purge(), which marks the page dead, so that
+  // loading it again fails.)
+  //
+  job = nullptr;
+  for (llfs::PageCache::PageDeviceEntry* entry : cache.all_devices()) {
+    if (entry->arena.id() == llfs::PageIdFactory::get_device_id(page_id)) {
+      entry->cache.erase(page_id);
+    }
+  }
+
+  llfs::StatusOr<llfs::PinnedPage> loaded = cache.get_page(page_id, llfs::OkIfNotFound{false});
+  ASSERT_TRUE(loaded.ok()) << BATT_INSPECT(loaded.status());
+
+  EXPECT_EQ(cache.metrics().decompressed_page_count.load() - decompressed_before, 1u);
+  EXPECT_EQ((*loaded)->get_page_layout_id(), llfs::OpaquePageView::page_layout_id());
+  EXPECT_FALSE(llfs::is_compressed_page(loaded->page_buffer()));
+
+  const llfs::ConstBuffer loaded_payload = loaded->const_payload();
+  ASSERT_EQ(loaded_payload.size(), expected.size());
+  EXPECT_EQ(std::memcmp(loaded_payload.data(), expected.data(), expected.size()), 0);
+}
+
+}  // namespace
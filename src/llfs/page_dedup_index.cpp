@@ -0,0 +1,187 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_dedup_index.hpp>
+//
+
+#include <llfs/packed_page_header.hpp>
+#include <llfs/page_buffer.hpp>
+#include <llfs/seq.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace llfs {
+
+namespace {
+
+// The parts of `page_buffer` that are covered by PageDedupIndex::content_key: the layout id and
+// page size from the header, then the used regions of the page after the header.
+//
+std::array<ConstBuffer, 4> content_regions(const PackedPageHeader& header,
+                                           const PageBuffer& page_buffer)
+{
+  const ConstBuffer page = page_buffer.const_buffer();
+  const u8* const bytes = static_cast<const u8*>(page.data());
+
+  const usize header_end = sizeof(PackedPageHeader);
+  const usize size = std::min<usize>(header.size.value(), page.size());
+  const usize unused_end = std::clamp<usize>(header.unused_end.value(), header_end, size);
+  const usize unused_begin = std::clamp<usize>(header.unused_begin.value(), header_end, unused_end);
+
+  return {
+      ConstBuffer{&header.layout_id, sizeof(header.layout_id)},
+      ConstBuffer{&header.size, sizeof(header.size)},
+      ConstBuffer{bytes + header_end, unused_begin - header_end},
+      ConstBuffer{bytes + unused_end, size - unused_end},
+  };
+}
+
+}  // namespace
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class PageDedupIndex
+//
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ Sha256 PageDedupIndex::content_key(const PageBuffer& page_buffer)
+{
+  const std::array<ConstBuffer, 4> regions =
+      content_regions(get_page_header(page_buffer), page_buffer);
+
+  return compute_sha256(as_seq(regions.begin(), regions.end()) | batt::seq::decayed());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ bool PageDedupIndex::same_content(const PageBuffer& a, const PageBuffer& b)
+{
+  const std::array<ConstBuffer, 4> a_regions = content_regions(get_page_header(a), a);
+  const std::array<ConstBuffer, 4> b_regions = content_regions(get_page_header(b), b);
+
+  for (usize i = 0; i < a_regions.size(); ++i) {
+    if (a_regions[i].size() != b_regions[i].size() ||
+        0 != std::memcmp(a_regions[i].data(), b_regions[i].data(), a_regions[i].size())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ PageDedupIndex::PageDedupIndex(usize max_entries) noexcept : max_entries_{max_entries}
+{
+  BATT_CHECK_GT(this->max_entries_, 0u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<PageId> PageDedupIndex::find(const Sha256& key)
+{
+  this->metrics_.lookup_count.add(1);
+
+  std::unique_lock<std::mutex> lock{this->mutex_};
+
+  auto iter = this->page_by_key_.find(key);
+  if (iter == this->page_by_key_.end()) {
+    return None;
+  }
+
+  this->metrics_.hit_count.add(1);
+
+  return iter->second;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageDedupIndex::insert(const Sha256& key, PageId page_id)
+{
+  this->metrics_.insert_count.add(1);
+
+  std::unique_lock<std::mutex> lock{this->mutex_};
+
+  // If the page is already indexed (under any key), remove it first; it keeps its place in
+  // `insertion_order_`.
+  //
+  bool already_queued = false;
+  {
+    auto iter = this->key_by_page_.find(page_id);
+    if (iter != this->key_by_page_.end()) {
+      this->page_by_key_.erase(iter->second);
+      this->key_by_page_.erase(iter);
+      already_queued = true;
+    }
+  }
+
+  auto [iter, inserted] = this->page_by_key_.emplace(key, page_id);
+  if (!inserted) {
+    this->key_by_page_.erase(iter->second);
+    iter->second = page_id;
+  }
+  this->key_by_page_.emplace(page_id, key);
+  if (!already_queued) {
+    this->insertion_order_.emplace_back(page_id);
+  }
+
+  // Evict the oldest entries until we are within the limit.  Skip over stale entries in
+  // `insertion_order_` (pages that have been erased or re-inserted since), and compact the queue if
+  // it holds too many of them.
+  //
+  while (this->key_by_page_.size() > this->max_entries_) {
+    BATT_CHECK(!this->insertion_order_.empty());
+
+    const PageId oldest = this->insertion_order_.front();
+    this->insertion_order_.pop_front();
+
+    auto oldest_iter = this->key_by_page_.find(oldest);
+    if (oldest_iter != this->key_by_page_.end()) {
+      this->page_by_key_.erase(oldest_iter->second);
+      this->key_by_page_.erase(oldest_iter);
+      this->metrics_.evict_count.add(1);
+    }
+  }
+
+  if (this->insertion_order_.size() > this->max_entries_ * 2) {
+    std::deque<PageId> compacted;
+    for (const PageId& id : this->insertion_order_) {
+      if (this->key_by_page_.count(id)) {
+        compacted.emplace_back(id);
+      }
+    }
+    this->insertion_order_ = std::move(compacted);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageDedupIndex::erase(PageId page_id)
+{
+  std::unique_lock<std::mutex> lock{this->mutex_};
+
+  auto iter = this->key_by_page_.find(page_id);
+  if (iter == this->key_by_page_.end()) {
+    return;
+  }
+
+  this->page_by_key_.erase(iter->second);
+  this->key_by_page_.erase(iter);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize PageDedupIndex::size() const
+{
+  std::unique_lock<std::mutex> lock{this->mutex_};
+
+  return this->key_by_page_.size();
+}
+
+}  // namespace llfs
@@ -0,0 +1,106 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_DEDUP_INDEX_HPP
+#define LLFS_PAGE_DEDUP_INDEX_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/metrics.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/sha256.hpp>
+
+#include <boost/functional/hash.hpp>
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace llfs {
+
+class PageBuffer;
+
+/** \brief Maps the contents of recently committed pages to their ids, so that a PageCacheJob can
+ * reference an existing page instead of writing a byte-identical new one (see
+ * PageCacheJob::pin_new_or_dedup).
+ *
+ * Pages are keyed by the Sha256 of their layout id and everything after the page header except the
+ * unused region (see `content_key`), so two pages with the same contents but different ids map to
+ * the same key.  Only pages of committed (durable) jobs are added, and pages are removed when a job
+ * that deletes them commits; a match is always re-checked against the loaded page before use.
+ *
+ * The index holds at most `max_entries` pages; when it is full, the oldest entry is evicted.
+ * Safe to use concurrently.
+ */
+class PageDedupIndex
+{
+ public:
+  struct Metrics {
+    CountMetric<u64> lookup_count{0};
+    CountMetric<u64> hit_count{0};
+    CountMetric<u64> insert_count{0};
+    CountMetric<u64> evict_count{0};
+  };
+
+  /** \brief Returns the key under which a page with the contents of `page_buffer` is indexed.
+   */
+  static Sha256 content_key(const PageBuffer& page_buffer);
+
+  /** \brief Returns true iff the contents of `a` and `b` that are covered by `content_key` are
+   * equal.
+   */
+  static bool same_content(const PageBuffer& a, const PageBuffer& b);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  explicit PageDedupIndex(usize max_entries) noexcept;
+
+  PageDedupIndex(const PageDedupIndex&) = delete;
+  PageDedupIndex& operator=(const PageDedupIndex&) = delete;
+
+  /** \brief Returns the id of a page whose content key is `key`, if one is indexed.
+   */
+  Optional<PageId> find(const Sha256& key);
+
+  /** \brief Adds (or replaces) the page for `key`.
+   */
+  void insert(const Sha256& key, PageId page_id);
+
+  /** \brief Removes `page_id` from the index, if present.
+   */
+  void erase(PageId page_id);
+
+  usize size() const;
+
+  const Metrics& metrics() const noexcept
+  {
+    return this->metrics_;
+  }
+
+ private:
+  const usize max_entries_;
+
+  Metrics metrics_;
+
+  mutable std::mutex mutex_;
+
+  std::unordered_map<Sha256, PageId, boost::hash<Sha256>> page_by_key_;
+
+  std::unordered_map<PageId, Sha256, PageId::Hash> key_by_page_;
+
+  // Page ids in insertion order, for eviction; may contain ids that were since erased or replaced.
+  //
+  std::deque<PageId> insertion_order_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_PAGE_DEDUP_INDEX_HPP
@@ -0,0 +1,128 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_dedup_index.hpp>
+//
+#include <llfs/page_dedup_index.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/packed_page_header.hpp>
+#include <llfs/page_buffer.hpp>
+
+#include <cstring>
+
+namespace {
+
+// Test Plan:
+//  1. content_key / same_content ignore the page id (and the rest of the header) and the unused
+//     region, but not the layout id or the used payload bytes.
+//  2. find/insert/erase; inserting past max_entries evicts the oldest entries.
+
+using namespace llfs::int_types;
+
+using llfs::PageBuffer;
+using llfs::PageDedupIndex;
+using llfs::PageId;
+using llfs::PageSize;
+
+constexpr u32 kPageSize = 4096;
+
+// Returns a page with id `page_id` whose payload is `fill` (up to `used_size` bytes of the page)
+// followed by an unused region of garbage.
+//
+std::shared_ptr<PageBuffer> make_page(u64 page_id, char fill, u32 used_size = 1024)
+{
+  std::shared_ptr<PageBuffer> page = PageBuffer::allocate(PageSize{kPageSize}, PageId{page_id});
+
+  llfs::MutableBuffer payload = page->mutable_payload();
+  std::memset(payload.data(), static_cast<int>(page_id), payload.size());
+  std::memset(payload.data(), fill, used_size - sizeof(llfs::PackedPageHeader));
+
+  llfs::PackedPageHeader* header = llfs::mutable_page_header(page.get());
+  header->unused_begin = used_size;
+  header->unused_end = kPageSize;
+
+  return page;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST(PageDedupIndexTest, ContentKey)
+{
+  std::shared_ptr<PageBuffer> a = make_page(1, 'x');
+  std::shared_ptr<PageBuffer> b = make_page(2, 'x');
+  std::shared_ptr<PageBuffer> c = make_page(3, 'y');
+  std::shared_ptr<PageBuffer> d = make_page(4, 'x', /*used_size=*/2048);
+
+  EXPECT_EQ(PageDedupIndex::content_key(*a), PageDedupIndex::content_key(*b));
+  EXPECT_TRUE(PageDedupIndex::same_content(*a, *b));
+
+  EXPECT_NE(PageDedupIndex::content_key(*a), PageDedupIndex::content_key(*c));
+  EXPECT_FALSE(PageDedupIndex::same_content(*a, *c));
+
+  EXPECT_NE(PageDedupIndex::content_key(*a), PageDedupIndex::content_key(*d));
+  EXPECT_FALSE(PageDedupIndex::same_content(*a, *d));
+
+  llfs::mutable_page_header(b.get())->layout_id = llfs::PageLayoutId::from_str("(test01)");
+
+  EXPECT_NE(PageDedupIndex::content_key(*a), PageDedupIndex::content_key(*b));
+  EXPECT_FALSE(PageDedupIndex::same_content(*a, *b));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST(PageDedupIndexTest, FindInsertErase)
+{
+  PageDedupIndex index{/*max_entries=*/3};
+
+  const auto key = [](char fill) {
+    return PageDedupIndex::content_key(*make_page(100, fill));
+  };
+
+  EXPECT_FALSE(index.find(key('a')));
+
+  index.insert(key('a'), PageId{1});
+  index.insert(key('b'), PageId{2});
+
+  EXPECT_EQ(index.find(key('a')), PageId{1});
+  EXPECT_EQ(index.find(key('b')), PageId{2});
+  EXPECT_EQ(index.size(), 2u);
+
+  // Re-inserting a page under a new key replaces its old key.
+  //
+  index.insert(key('c'), PageId{2});
+
+  EXPECT_FALSE(index.find(key('b')));
+  EXPECT_EQ(index.find(key('c')), PageId{2});
+  EXPECT_EQ(index.size(), 2u);
+
+  index.erase(PageId{1});
+
+  EXPECT_FALSE(index.find(key('a')));
+  EXPECT_EQ(index.size(), 1u);
+
+  // Fill past the limit; the oldest entries go first.
+  //
+  index.insert(key('d'), PageId{3});
+  index.insert(key('e'), PageId{4});
+  index.insert(key('f'), PageId{5});
+
+  EXPECT_EQ(index.size(), 3u);
+  EXPECT_FALSE(index.find(key('c')));
+  EXPECT_EQ(index.find(key('d')), PageId{3});
+  EXPECT_EQ(index.find(key('e')), PageId{4});
+  EXPECT_EQ(index.find(key('f')), PageId{5});
+
+  EXPECT_EQ(index.metrics().evict_count.load(), 1u);
+}
+
+}  // namespace
@@ -37,6 +37,25 @@ class PageDeleter
                               slot_offset_type caller_slot, batt::Grant& recycle_grant,
                               i32 recycle_depth) = 0;
 
+  // Called by the PageRecycler as soon as a batch of pages has been prepared, possibly while
+  // `delete_pages` is still running for an earlier batch.  Implementations may use this to start
+  // loading the pages ahead of the call to `delete_pages` for the same batch.
+  //
+  virtual void prefetch_pages(const Slice<const PageToRecycle>& to_delete)
+  {
+    (void)to_delete;
+  }
+
+  // Returns the fraction (0.0 - 1.0) of pages that are free on the fullest of the page devices the
+  // recycler frees pages to.  The PageRecycler uses this to decide whether it must run flat out
+  // (see PageRecyclerOptions::urgent_free_page_percent).  The default implementation has no way to
+  // know, and reports that all pages are free.
+  //
+  virtual double free_page_ratio()
+  {
+    return 1.0;
+  }
+
   // Called to indicate that the PageRecycler identified by `caller_uuid` has drained its backlog of
   // pages to recycle.
   //
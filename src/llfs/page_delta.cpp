@@ -0,0 +1,275 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_delta.hpp>
+//
+
+#include <llfs/packed_page_header.hpp>
+#include <llfs/page_ref_summary.hpp>
+#include <llfs/status_code.hpp>
+
+#include <batteries/checked_cast.hpp>
+#include <batteries/math.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace llfs {
+
+namespace {
+
+// The offset of the patch within a delta page image.
+//
+constexpr usize kPatchOffset = sizeof(PackedPageHeader) + sizeof(PackedDeltaPageHeader);
+
+// Delta images are only worth writing if they save at least one block of this size.
+//
+constexpr i32 kDeltaBlockSizeLog2 = 9;
+
+const PackedDeltaPageHeader& get_delta_page_header(const PageBuffer& page)
+{
+  return *reinterpret_cast<const PackedDeltaPageHeader*>(reinterpret_cast<const u8*>(&page) +
+                                                         sizeof(PackedPageHeader));
+}
+
+// The number of bytes a device writes to store a page in full (the unused region is skipped).
+//
+usize full_write_size(usize unused_begin, usize unused_end, usize page_size)
+{
+  return batt::round_up_bits(kDeltaBlockSizeLog2, unused_begin) +
+         (page_size - batt::round_down_bits(kDeltaBlockSizeLog2, unused_end));
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+const PageLayoutId& delta_page_layout_id()
+{
+  static const PageLayoutId id_ = PageLayoutId::from_str("(delta)");
+  return id_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool is_delta_page(const PageBuffer& page)
+{
+  return get_page_header(page).layout_id == delta_page_layout_id();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageId get_delta_page_base_id(const PageBuffer& page)
+{
+  BATT_CHECK(is_delta_page(page));
+
+  return get_delta_page_header(page).base_page_id.unpack();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u16 get_delta_page_depth(const PageBuffer& page)
+{
+  BATT_CHECK(is_delta_page(page));
+
+  return get_delta_page_header(page).depth;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::shared_ptr<const PageBuffer> encode_page_delta(const PageBuffer& page, const PageBuffer& base,
+                                                    PageId base_id, u16 base_depth)
+{
+  if (is_delta_page(page) || base_depth == std::numeric_limits<u16>::max()) {
+    return nullptr;
+  }
+
+  const PackedPageHeader& header = get_page_header(page);
+  const usize page_size = header.size;
+  const usize unused_begin = header.unused_begin;
+  const usize unused_end = header.unused_end;
+
+  if (get_page_header(base).size != page_size || unused_begin < sizeof(PackedPageHeader) ||
+      unused_begin > unused_end || unused_end > page_size) {
+    return nullptr;
+  }
+
+  // The delta image must round up to fewer blocks than the full page, and not be larger than the
+  // used part of the full page.
+  //
+  const usize full_size = full_write_size(unused_begin, unused_end, page_size);
+  const usize block_size = usize{1} << kDeltaBlockSizeLog2;
+  if (full_size < kPatchOffset + block_size) {
+    return nullptr;
+  }
+  const usize max_end =
+      std::min(full_size - block_size, unused_begin + (page_size - unused_end));
+  if (max_end <= kPatchOffset) {
+    return nullptr;
+  }
+  const usize max_patch_size = max_end - kPatchOffset;
+
+  const u8* const src = reinterpret_cast<const u8*>(&page);
+  const u8* const base_bytes = reinterpret_cast<const u8*>(&base);
+
+  std::shared_ptr<PageBuffer> delta = PageBuffer::allocate(
+      PageSize{BATT_CHECKED_CAST(u32, page_size)}, header.page_id.unpack());
+  u8* const dst = reinterpret_cast<u8*>(delta.get());
+  u8* const patch = dst + kPatchOffset;
+  usize patch_size = 0;
+
+  // Appends a run that replaces the bytes in [begin, end); returns false if the patch got too big.
+  //
+  const auto append_run = [&](usize begin, usize end) -> bool {
+    const usize run_size = sizeof(PackedDeltaPageRun) + (end - begin);
+    if (patch_size + run_size > max_patch_size) {
+      return false;
+    }
+    auto* const run = reinterpret_cast<PackedDeltaPageRun*>(patch + patch_size);
+    run->offset = BATT_CHECKED_CAST(u32, begin);
+    run->size = BATT_CHECKED_CAST(u32, end - begin);
+    std::memcpy(run + 1, src + begin, end - begin);
+    patch_size += run_size;
+    return true;
+  };
+
+  // Appends runs for all the bytes in [begin, end) that differ from the base page.  Runs separated
+  // by no more equal bytes than the size of a run header are merged.
+  //
+  const auto diff_region = [&](usize begin, usize end) -> bool {
+    usize i = begin;
+    for (;;) {
+      while (i < end && src[i] == base_bytes[i]) {
+        ++i;
+      }
+      if (i == end) {
+        return true;
+      }
+
+      const usize run_begin = i;
+      usize run_end = i;
+      for (;;) {
+        while (run_end < end && src[run_end] != base_bytes[run_end]) {
+          ++run_end;
+        }
+        usize gap_end = run_end;
+        while (gap_end < end && src[gap_end] == base_bytes[gap_end] &&
+               gap_end - run_end <= sizeof(PackedDeltaPageRun)) {
+          ++gap_end;
+        }
+        if (gap_end == end || gap_end - run_end > sizeof(PackedDeltaPageRun)) {
+          break;
+        }
+        run_end = gap_end;
+      }
+
+      if (!append_run(run_begin, run_end)) {
+        return false;
+      }
+      i = run_end;
+    }
+  };
+
+  if (!diff_region(sizeof(PackedPageHeader), unused_begin) ||
+      !diff_region(unused_end, page_size)) {
+    return nullptr;
+  }
+
+  // Devices may write the unused region of the image too; make sure that whatever the buffer
+  // held there can't be mistaken for a page ref summary of this page (which wouldn't include the
+  // base page).
+  //
+  if (kPatchOffset + patch_size + sizeof(PackedPageRefSummaryTrailer) <= page_size) {
+    std::memset(dst + page_size - sizeof(PackedPageRefSummaryTrailer), 0,
+                sizeof(PackedPageRefSummaryTrailer));
+  }
+
+  PackedDeltaPageHeader* const delta_header =
+      reinterpret_cast<PackedDeltaPageHeader*>(dst + sizeof(PackedPageHeader));
+  std::memset(delta_header, 0, sizeof(PackedDeltaPageHeader));
+  delta_header->layout_id = header.layout_id;
+  delta_header->unused_begin = unused_begin;
+  delta_header->unused_end = unused_end;
+  delta_header->base_page_id = PackedPageId::from(base_id);
+  delta_header->patch_size = patch_size;
+  delta_header->depth = base_depth + 1;
+
+  PackedPageHeader* const new_header = mutable_page_header(delta.get());
+  *new_header = header;
+  new_header->layout_id = delta_page_layout_id();
+  new_header->unused_begin = kPatchOffset + patch_size;
+  new_header->unused_end = page_size;
+
+  return delta;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::shared_ptr<const PageBuffer>> apply_page_delta(const PageBuffer& delta,
+                                                             const PageBuffer& base)
+{
+  if (!is_delta_page(delta)) {
+    return ::llfs::make_status(StatusCode::kPageDeltaBadData);
+  }
+
+  const PackedPageHeader& header = get_page_header(delta);
+  const PackedDeltaPageHeader& delta_header = get_delta_page_header(delta);
+
+  const usize page_size = header.size;
+  const usize unused_begin = delta_header.unused_begin;
+  const usize unused_end = delta_header.unused_end;
+  const usize patch_size = delta_header.patch_size;
+
+  if (get_page_header(base).size != page_size ||
+      base.page_id() != delta_header.base_page_id.unpack() ||
+      unused_begin < sizeof(PackedPageHeader) || unused_begin > unused_end ||
+      unused_end > page_size || patch_size > page_size - kPatchOffset ||
+      kPatchOffset + patch_size != header.unused_begin) {
+    return ::llfs::make_status(StatusCode::kPageDeltaBadData);
+  }
+
+  const u8* const src = reinterpret_cast<const u8*>(&delta);
+
+  std::shared_ptr<PageBuffer> materialized = PageBuffer::allocate(
+      PageSize{BATT_CHECKED_CAST(u32, page_size)}, header.page_id.unpack());
+  u8* const dst = reinterpret_cast<u8*>(materialized.get());
+
+  std::memcpy(dst + sizeof(PackedPageHeader),
+              reinterpret_cast<const u8*>(&base) + sizeof(PackedPageHeader),
+              page_size - sizeof(PackedPageHeader));
+
+  const u8* const patch = src + kPatchOffset;
+  usize pos = 0;
+  while (pos < patch_size) {
+    if (patch_size - pos < sizeof(PackedDeltaPageRun)) {
+      return ::llfs::make_status(StatusCode::kPageDeltaBadData);
+    }
+    const auto* const run = reinterpret_cast<const PackedDeltaPageRun*>(patch + pos);
+    const usize offset = run->offset;
+    const usize size = run->size;
+    pos += sizeof(PackedDeltaPageRun);
+
+    if (offset < sizeof(PackedPageHeader) || offset > page_size || size > page_size - offset ||
+        size > patch_size - pos) {
+      return ::llfs::make_status(StatusCode::kPageDeltaBadData);
+    }
+    std::memcpy(dst + offset, patch + pos, size);
+    pos += size;
+  }
+
+  PackedPageHeader* const new_header = mutable_page_header(materialized.get());
+  *new_header = header;
+  new_header->layout_id = delta_header.layout_id;
+  new_header->unused_begin = unused_begin;
+  new_header->unused_end = unused_end;
+
+  return {std::move(materialized)};
+}
+
+}  // namespace llfs
@@ -0,0 +1,105 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_DELTA_HPP
+#define LLFS_PAGE_DELTA_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/packed_page_id.hpp>
+#include <llfs/page_buffer.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/page_layout_id.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/static_assert.hpp>
+
+#include <memory>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// A delta page image stores a page as a patch against another page (its "base"), so that a page
+// that differs from its predecessor by a few bytes doesn't have to be written in full.  The
+// on-device image of a delta page is:
+//
+//  - The PackedPageHeader of the original page, except that `layout_id` is set to
+//    `delta_page_layout_id()` and the unused region starts right after the patch and runs to the
+//    end of the page.
+//  - A PackedDeltaPageHeader, which saves the original layout id and unused region, and the id of
+//    the base page.
+//  - The patch: a sequence of PackedDeltaPageRun headers, each followed by `size` bytes that
+//    replace the bytes of the base page at `offset`.
+//
+// The original page is materialized by copying the base page and applying the patch.  Only the
+// bytes outside of the original page's unused region are guaranteed to be reproduced; the unused
+// region of a materialized page holds whatever the base page had there.
+//
+// Delta pages are always materialized as they are loaded into the cache, so PageView
+// implementations never see delta images.  See PageCacheJob::pin_new_as_delta.
+//
+struct PackedDeltaPageHeader {
+  PageLayoutId layout_id;
+  little_u32 unused_begin;
+  little_u32 unused_end;
+  PackedPageId base_page_id;
+  little_u32 patch_size;
+
+  // The number of delta images that must be applied to materialize this page (1 if the base page
+  // is stored in full).
+  //
+  little_u16 depth;
+
+  little_u8 reserved_[2];
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedDeltaPageHeader), 32);
+
+struct PackedDeltaPageRun {
+  little_u32 offset;
+  little_u32 size;
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedDeltaPageRun), 8);
+
+// The layout id written in the PackedPageHeader of delta page images.
+//
+const PageLayoutId& delta_page_layout_id();
+
+// Returns true iff `page` is a delta page image.
+//
+bool is_delta_page(const PageBuffer& page);
+
+// Returns the id of the base page of a delta page image.  `page` must be a delta page image.
+//
+PageId get_delta_page_base_id(const PageBuffer& page);
+
+// Returns the depth of a delta page image (see PackedDeltaPageHeader::depth).  `page` must be a
+// delta page image.
+//
+u16 get_delta_page_depth(const PageBuffer& page);
+
+// Returns a delta image of `page` against `base`, whose id is `base_id` and which is itself
+// materialized from `base_depth` delta images (0 if it is stored in full).  Returns nullptr if the
+// pages have different sizes or the delta image wouldn't save at least one 512-byte block over
+// writing `page` in full.
+//
+std::shared_ptr<const PageBuffer> encode_page_delta(const PageBuffer& page, const PageBuffer& base,
+                                                    PageId base_id, u16 base_depth);
+
+// Materializes the original page of the delta image `delta` by applying its patch to `base`, the
+// (materialized) contents of its base page.
+//
+StatusOr<std::shared_ptr<const PageBuffer>> apply_page_delta(const PageBuffer& delta,
+                                                             const PageBuffer& base);
+
+}  // namespace llfs
+
+#endif  // LLFS_PAGE_DELTA_HPP
@@ -0,0 +1,171 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_delta.hpp>
+//
+#include <llfs/page_delta.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/packed_page_header.hpp>
+#include <llfs/page_layout.hpp>
+
+#include <cstring>
+
+namespace {
+
+// Test Plan:
+//
+//  1. A page that differs from its base in a few bytes (in the payload and after the unused
+//     region) round-trips through encode_page_delta/apply_page_delta, and the delta image is
+//     smaller than the page.
+//  2. A page that differs too much from its base, or has a different size, is not delta-encoded.
+//  3. apply_page_delta rejects a base page other than the one the delta was made against, and a
+//     corrupt patch.
+
+using namespace llfs::int_types;
+
+constexpr usize kTestPageSize = 64 * 1024;
+constexpr usize kTestUsedSize = kTestPageSize / 2;
+constexpr usize kTestTailSize = 100;
+
+const llfs::PageLayoutId& test_layout_id()
+{
+  static const llfs::PageLayoutId id_ = llfs::PageLayoutId::from_str("(test)");
+  return id_;
+}
+
+// Builds a page with the given id whose bytes are `fill_fn(offset) -> u8`, used up to
+// `kTestUsedSize` and with a tail of `kTestTailSize` bytes at the end of the page.
+//
+template <typename FillFn>
+std::shared_ptr<llfs::PageBuffer> make_test_page(u64 page_id, FillFn&& fill_fn,
+                                                 usize page_size = kTestPageSize)
+{
+  std::shared_ptr<llfs::PageBuffer> page = llfs::PageBuffer::allocate(
+      llfs::PageSize{static_cast<u32>(page_size)}, llfs::PageId{page_id});
+
+  u8* const bytes = reinterpret_cast<u8*>(page.get());
+  for (usize i = sizeof(llfs::PackedPageHeader); i < page_size; ++i) {
+    bytes[i] = fill_fn(i);
+  }
+
+  llfs::mutable_page_header(page.get())->layout_id = test_layout_id();
+  BATT_CHECK_OK(llfs::finalize_page_header(
+      page.get(), llfs::Interval<u64>{kTestUsedSize, page_size - kTestTailSize}));
+
+  return page;
+}
+
+u8 base_byte(usize i)
+{
+  return static_cast<u8>(i * 31 + (i >> 8));
+}
+
+// Returns true iff `a` and `b` have the same header and the same bytes outside the unused region.
+//
+bool same_used_bytes(const llfs::PageBuffer& a, const llfs::PageBuffer& b)
+{
+  const llfs::PackedPageHeader& header = llfs::get_page_header(a);
+  const u8* const a_bytes = reinterpret_cast<const u8*>(&a);
+  const u8* const b_bytes = reinterpret_cast<const u8*>(&b);
+
+  return std::memcmp(a_bytes, b_bytes, header.unused_begin) == 0 &&
+         std::memcmp(a_bytes + header.unused_end, b_bytes + header.unused_end,
+                     header.size - header.unused_end) == 0;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST(PageDeltaTest, RoundTrip)
+{
+  std::shared_ptr<llfs::PageBuffer> base = make_test_page(1, base_byte);
+  std::shared_ptr<llfs::PageBuffer> page = make_test_page(2, [](usize i) -> u8 {
+    if (i == 1000 || (i >= 5000 && i < 5010) || i == 5015 || i == kTestPageSize - 10) {
+      return static_cast<u8>(~base_byte(i));
+    }
+    return base_byte(i);
+  });
+
+  ASSERT_FALSE(same_used_bytes(*base, *page));
+
+  std::shared_ptr<const llfs::PageBuffer> delta =
+      llfs::encode_page_delta(*page, *base, base->page_id(), /*base_depth=*/2);
+
+  ASSERT_NE(delta, nullptr);
+  EXPECT_TRUE(llfs::is_delta_page(*delta));
+  EXPECT_FALSE(llfs::is_delta_page(*page));
+  EXPECT_EQ(llfs::get_delta_page_base_id(*delta), base->page_id());
+  EXPECT_EQ(llfs::get_delta_page_depth(*delta), 3u);
+  EXPECT_EQ(delta->page_id(), page->page_id());
+  EXPECT_LT(llfs::get_page_header(*delta).used_size(), 512u);
+
+  llfs::StatusOr<std::shared_ptr<const llfs::PageBuffer>> materialized =
+      llfs::apply_page_delta(*delta, *base);
+
+  ASSERT_TRUE(materialized.ok()) << BATT_INSPECT(materialized.status());
+  EXPECT_EQ(llfs::get_page_header(**materialized).layout_id, test_layout_id());
+  EXPECT_TRUE(same_used_bytes(**materialized, *page));
+  EXPECT_TRUE(llfs::verify_page_checksum(**materialized).ok());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST(PageDeltaTest, NotWorthIt)
+{
+  std::shared_ptr<llfs::PageBuffer> base = make_test_page(1, base_byte);
+  std::shared_ptr<llfs::PageBuffer> page = make_test_page(2, [](usize i) -> u8 {
+    return static_cast<u8>(~base_byte(i));
+  });
+  std::shared_ptr<llfs::PageBuffer> small_base =
+      make_test_page(3, base_byte, /*page_size=*/kTestPageSize / 2 + 4096);
+
+  EXPECT_EQ(llfs::encode_page_delta(*page, *base, base->page_id(), 0), nullptr);
+  EXPECT_EQ(llfs::encode_page_delta(*base, *small_base, small_base->page_id(), 0), nullptr);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 3.
+//
+TEST(PageDeltaTest, BadData)
+{
+  std::shared_ptr<llfs::PageBuffer> base = make_test_page(1, base_byte);
+  std::shared_ptr<llfs::PageBuffer> page = make_test_page(2, [](usize i) -> u8 {
+    return (i == 2000) ? static_cast<u8>(~base_byte(i)) : base_byte(i);
+  });
+  std::shared_ptr<llfs::PageBuffer> other_base = make_test_page(3, base_byte);
+
+  std::shared_ptr<const llfs::PageBuffer> delta =
+      llfs::encode_page_delta(*page, *base, base->page_id(), 0);
+  ASSERT_NE(delta, nullptr);
+
+  EXPECT_EQ(llfs::apply_page_delta(*delta, *other_base).status(),
+            llfs::make_status(llfs::StatusCode::kPageDeltaBadData));
+
+  EXPECT_EQ(llfs::apply_page_delta(*page, *base).status(),
+            llfs::make_status(llfs::StatusCode::kPageDeltaBadData));
+
+  // Point the first run at the end of the page.
+  //
+  std::shared_ptr<llfs::PageBuffer> corrupt =
+      llfs::PageBuffer::allocate(llfs::PageSize{kTestPageSize}, page->page_id());
+  std::memcpy(corrupt.get(), delta.get(), kTestPageSize);
+
+  auto* const run = reinterpret_cast<llfs::PackedDeltaPageRun*>(
+      reinterpret_cast<u8*>(corrupt.get()) + sizeof(llfs::PackedPageHeader) +
+      sizeof(llfs::PackedDeltaPageHeader));
+  run->offset = static_cast<u32>(kTestPageSize);
+
+  EXPECT_EQ(llfs::apply_page_delta(*corrupt, *base).status(),
+            llfs::make_status(llfs::StatusCode::kPageDeltaBadData));
+}
+
+}  // namespace
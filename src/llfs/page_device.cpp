@@ -11,8 +11,54 @@
 
 #include <batteries/async/task.hpp>
 
+#include <algorithm>
+
 namespace llfs {
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageDevice::enable_registered_page_buffers(usize /*buffer_count*/)
+{
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool PageDevice::prefetch_hint(PageId /*id*/)
+{
+  return false;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageDevice::read_batch(const batt::Slice<const PageId>& ids,
+                            std::vector<PageDevice::ReadHandler>&& handlers)
+{
+  BATT_CHECK_EQ(ids.size(), handlers.size());
+
+  for (usize i = 0; i < ids.size(); ++i) {
+    this->read(ids[i], std::move(handlers[i]));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageDevice::read_tail(PageId id, usize byte_count, PageDevice::ReadTailHandler&& handler)
+{
+  this->read(id, [byte_count, handler = std::move(handler)](ReadResult&& result) mutable {
+    if (!result.ok()) {
+      handler(result.status());
+      return;
+    }
+
+    const ConstBuffer page_data = (*result)->const_buffer();
+    const usize n = std::min(byte_count, page_data.size());
+    const u8* const tail_begin = static_cast<const u8*>(page_data.data()) + page_data.size() - n;
+
+    handler(std::vector<u8>(tail_begin, tail_begin + n));
+  });
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 auto PageDevice::await_read(PageId id) -> ReadResult
@@ -22,4 +68,13 @@ auto PageDevice::await_read(PageId id) -> ReadResult
   });
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto PageDevice::await_read_tail(PageId id, usize byte_count) -> ReadTailResult
+{
+  return batt::Task::await<ReadTailResult>([id, byte_count, this](auto&& handler) {
+    this->read_tail(id, byte_count, BATT_FORWARD(handler));
+  });
+}
+
 }  // namespace llfs
@@ -19,11 +19,13 @@
 #include <llfs/logging.hpp>
 
 #include <batteries/assert.hpp>
+#include <batteries/slice.hpp>
 #include <batteries/stream_util.hpp>
 
 #include <functional>
 #include <memory>
 #include <tuple>
+#include <vector>
 
 namespace llfs {
 
@@ -36,6 +38,9 @@ class PageDevice
   using WriteHandler = std::function<void(PageDevice::WriteResult)>;
   using ReadHandler = std::function<void(PageDevice::ReadResult)>;
 
+  using ReadTailResult = StatusOr<std::vector<u8>>;
+  using ReadTailHandler = std::function<void(PageDevice::ReadTailResult)>;
+
   PageDevice(const PageDevice&) = delete;
   PageDevice& operator=(const PageDevice&) = delete;
 
@@ -65,6 +70,22 @@ class PageDevice
     };
   }
 
+  /** \brief Asks the device to allocate up to `buffer_count` page buffers from memory registered
+   * for fast (fixed-buffer) I/O, and to use them for the buffers returned by `prepare` and `read`
+   * while any are available.
+   *
+   * This is only an optimization hint; the default implementation does nothing.
+   */
+  virtual Status enable_registered_page_buffers(usize buffer_count);
+
+  /** \brief Tells the device that the given page is likely to be read soon.
+   *
+   * Returns true if the device took care of the hint itself (for example, by asking the kernel to
+   * read ahead part of a mapped file), in which case the PageCache doesn't start a prefetch read of
+   * its own.  The default implementation does nothing and returns false.
+   */
+  virtual bool prefetch_hint(PageId id);
+
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
   // Write phase
   //
@@ -78,10 +99,31 @@ class PageDevice
   //
   virtual void read(PageId id, PageDevice::ReadHandler&& handler) = 0;
 
+  /** \brief Starts reading all the pages in `ids`; `handlers[i]` is invoked with the result for
+   * `ids[i]`.
+   *
+   * Devices that can issue many reads more efficiently as a group (for example, with a single
+   * syscall) should override this function.  The default implementation just calls `read` for each
+   * page.
+   */
+  virtual void read_batch(const batt::Slice<const PageId>& ids,
+                          std::vector<PageDevice::ReadHandler>&& handlers);
+
+  /** \brief Reads only the last `byte_count` bytes of the given page (e.g., to load a page ref
+   * summary; see page_ref_summary.hpp).  `byte_count` is clamped to the page size.
+   *
+   * Unlike `read`, the page header is not available to sanity check the data, so callers must
+   * validate what they get back.  The default implementation reads the whole page and copies out
+   * the tail; devices that can read part of a page should override this function.
+   */
+  virtual void read_tail(PageId id, usize byte_count, PageDevice::ReadTailHandler&& handler);
+
   // Convenience; shortcut for Task::await(...)
   //
   PageDevice::ReadResult await_read(PageId id);
 
+  PageDevice::ReadTailResult await_read_tail(PageId id, usize byte_count);
+
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
   // Delete phase
   //
@@ -11,6 +11,12 @@
 
 #include <llfs/optional.hpp>
 
+#include <batteries/checked_cast.hpp>
+#include <batteries/math.hpp>
+#include <batteries/stream_util.hpp>
+
+#include <algorithm>
+
 namespace llfs {
 
 namespace {
@@ -28,11 +34,34 @@ struct NewSlot {
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 /*explicit*/ PageDeviceCache::PageDeviceCache(
-    const PageIdFactory& page_ids, boost::intrusive_ptr<PageCacheSlot::Pool>&& slot_pool) noexcept
+    const PageIdFactory& page_ids, usize page_size,
+    boost::intrusive_ptr<PageCacheSlot::Pool>&& slot_pool) noexcept
     : page_ids_{page_ids}
+    , page_size_{page_size}
     , slot_pool_{std::move(slot_pool)}
-    , cache_(this->page_ids_.get_physical_page_count(), kInvalidIndex)
 {
+  const usize n_physical_pages = this->page_ids_.get_physical_page_count().value();
+  const usize n_pool_slots = std::max<usize>(1, this->slot_pool_->n_slots());
+
+  this->negative_cache_size_log2_ =
+      batt::log2_ceil(std::max<usize>(kMinNegativeCacheSize, n_pool_slots));
+  this->negative_cache_.reset(
+      new std::atomic<page_id_int>[usize{1} << this->negative_cache_size_log2_]);
+  for (usize i = 0; i < (usize{1} << this->negative_cache_size_log2_); ++i) {
+    this->negative_cache_[i].store(kInvalidPageId, std::memory_order_relaxed);
+  }
+
+  if (n_physical_pages / kSparseIndexMinPagesPerSlot < n_pool_slots) {
+    this->cache_.resize(n_physical_pages, kInvalidIndex);
+    return;
+  }
+
+  const usize min_bucket_count =
+      (n_pool_slots * kSparseIndexEntriesPerSlot + kSparseIndexWays - 1) / kSparseIndexWays;
+
+  this->sparse_bucket_count_log2_ = batt::log2_ceil(min_bucket_count);
+  this->sparse_index_.reset(
+      new SparseIndexEntry[(usize{1} << this->sparse_bucket_count_log2_) * kSparseIndexWays]);
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -48,6 +77,29 @@ const PageIdFactory& PageDeviceCache::page_ids() const noexcept
   return this->page_ids_;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize PageDeviceCache::index_size_bytes() const noexcept
+{
+  if (this->sparse_index_) {
+    return (usize{1} << this->sparse_bucket_count_log2_) * kSparseIndexWays *
+           sizeof(SparseIndexEntry);
+  }
+  return this->cache_.size() * sizeof(usize);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageDeviceCache::enable_hot_page_replicas(usize n_sets, usize slots_per_set,
+                                               u32 pin_threshold)
+{
+  BATT_CHECK_EQ(this->replicas_, nullptr);
+
+  this->replicas_ = std::make_unique<HotPageReplicas>(
+      batt::to_string("Device", this->page_ids_.get_device_id()), n_sets, slots_per_set,
+      pin_threshold);
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 batt::StatusOr<PageCacheSlot::PinnedRef> PageDeviceCache::find_or_insert(
@@ -55,11 +107,28 @@ batt::StatusOr<PageCacheSlot::PinnedRef> PageDeviceCache::find_or_insert(
 {
   BATT_CHECK_EQ(PageIdFactory::get_device_id(key), this->page_ids_.get_device_id());
 
+  // Try the calling thread's replica of the page first, so that hot pages aren't all pinned via
+  // the same slot.
+  //
+  if (this->replicas_) {
+    PageCacheSlot::PinnedRef replica = this->replicas_->find(key);
+    if (replica) {
+      return {std::move(replica)};
+    }
+  }
+
   // Lookup the cache table entry for the given page id.
   //
   const i64 physical_page = this->page_ids_.get_physical_page(key);
   std::atomic<usize>& slot_index_ref = this->get_slot_index_ref(physical_page);
 
+  // Let the admission filter (if there is one) see every lookup, hit or miss.
+  //
+  PageCacheAdmissionFilter* const admission_filter = this->slot_pool_->admission_filter();
+  if (admission_filter) {
+    admission_filter->record_access(key);
+  }
+
   // Initialized lazily (at most once) below, only when we discover we might
   // need them.
   //
@@ -112,8 +181,20 @@ batt::StatusOr<PageCacheSlot::PinnedRef> PageDeviceCache::find_or_insert(
     // into the cache array.
     //
     if (!new_slot) {
+      // Don't bother loading a generation of the page that we already know to be gone.
+      //
+      if (this->is_known_stale(key)) {
+        this->slot_pool_->metrics_.known_stale_count.add(1);
+        return batt::Status{batt::StatusCode::kNotFound};
+      }
+
       new_slot.emplace();
-      new_slot->p_slot = this->slot_pool_->allocate();
+
+      // Prefer the shard local to this thread's NUMA node (if the pool is sharded).
+      //
+      new_slot->p_slot = this->slot_pool_->allocate(this->slot_pool_->local_shard_index(),
+                                                    /*candidate_key=*/key,
+                                                    /*charged_size=*/this->page_size_);
       if (!new_slot->p_slot) {
         return ::llfs::make_status(StatusCode::kCacheSlotsFull);
       }
@@ -145,16 +226,190 @@ batt::StatusOr<PageCacheSlot::PinnedRef> PageDeviceCache::find_or_insert(
   return {std::move(new_slot->pinned_ref)};
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCacheSlot::PinnedRef PageDeviceCache::find(PageId key)
+{
+  BATT_CHECK_EQ(PageIdFactory::get_device_id(key), this->page_ids_.get_device_id());
+
+  const std::atomic<usize>* slot_index_ref =
+      this->find_slot_index_ref(this->page_ids_.get_physical_page(key));
+  if (!slot_index_ref) {
+    return {};
+  }
+
+  const usize slot_index = slot_index_ref->load();
+  if (slot_index == kInvalidIndex) {
+    return {};
+  }
+
+  return this->slot_pool_->get_slot(slot_index)->acquire_pin(key);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageCacheSlot* PageDeviceCache::peek(PageId key)
+{
+  BATT_CHECK_EQ(PageIdFactory::get_device_id(key), this->page_ids_.get_device_id());
+
+  const std::atomic<usize>* slot_index_ref =
+      this->find_slot_index_ref(this->page_ids_.get_physical_page(key));
+  if (!slot_index_ref) {
+    return nullptr;
+  }
+
+  const usize slot_index = slot_index_ref->load();
+  if (slot_index == kInvalidIndex) {
+    return nullptr;
+  }
+
+  return this->slot_pool_->get_slot(slot_index);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageDeviceCache::record_latest_generation(PageId key) noexcept
+{
+  BATT_CHECK_EQ(PageIdFactory::get_device_id(key), this->page_ids_.get_device_id());
+
+  const i64 physical_page = this->page_ids_.get_physical_page(key);
+  const page_generation_int generation = this->page_ids_.get_generation(key);
+
+  std::atomic<page_id_int>& entry = this->get_negative_cache_entry(physical_page);
+  page_id_int observed = entry.load();
+
+  for (;;) {
+    // If the entry already holds the same or a newer generation of this page, there's nothing to
+    // do; if it holds some other page, we just replace it.
+    //
+    if (observed != kInvalidPageId &&
+        this->page_ids_.get_physical_page(PageId{observed}) == physical_page &&
+        !this->page_ids_.generation_less_than(this->page_ids_.get_generation(PageId{observed}),
+                                              generation)) {
+      return;
+    }
+    if (entry.compare_exchange_weak(observed, key.int_value())) {
+      return;
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool PageDeviceCache::is_known_stale(PageId key) const noexcept
+{
+  const i64 physical_page = this->page_ids_.get_physical_page(key);
+  const page_id_int observed =
+      this->get_negative_cache_entry(physical_page).load(std::memory_order_relaxed);
+
+  return observed != kInvalidPageId &&
+         this->page_ids_.get_physical_page(PageId{observed}) == physical_page &&
+         this->page_ids_.generation_less_than(this->page_ids_.get_generation(key),
+                                              this->page_ids_.get_generation(PageId{observed}));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageDeviceCache::append_cached_pages(std::vector<CachedPage>* out)
+{
+  const usize first_out = out->size();
+
+  const i64 n_index_entries = BATT_CHECKED_CAST(
+      i64, this->sparse_index_
+               ? (usize{1} << this->sparse_bucket_count_log2_) * kSparseIndexWays
+               : this->cache_.size());
+
+  for (i64 entry_i = 0; entry_i < n_index_entries; ++entry_i) {
+    i64 physical_page = entry_i;
+    usize slot_index = kInvalidIndex;
+
+    if (this->sparse_index_) {
+      const SparseIndexEntry& entry = this->sparse_index_[entry_i];
+      physical_page = entry.physical_page.load();
+      if (physical_page == SparseIndexEntry::kEmpty) {
+        continue;
+      }
+      slot_index = entry.slot_index.load();
+    } else {
+      slot_index = this->get_slot_index_ref(physical_page).load();
+    }
+
+    if (slot_index == kInvalidIndex) {
+      continue;
+    }
+
+    // We must pin the slot to read its key; the slot may since have been reused for another page
+    // (of this or any other device that shares the pool), so check that the key still matches.
+    //
+    PageCacheSlot* const slot = this->slot_pool_->get_slot(slot_index);
+    PageCacheSlot::PinnedRef pinned = slot->acquire_pin(PageId{}, /*ignore_key=*/true);
+    if (!pinned) {
+      continue;
+    }
+
+    const PageId key = pinned.key();
+    if (!key.is_valid() ||
+        PageIdFactory::get_device_id(key) != this->page_ids_.get_device_id() ||
+        this->page_ids_.get_physical_page(key) != physical_page) {
+      continue;
+    }
+
+    out->emplace_back(CachedPage{
+        .page_id = key,
+        .latest_use = slot->get_latest_use(),
+    });
+  }
+
+  // The sparse index is in hash order, and may (briefly) have more than one entry for the same
+  // page; put the pages we found in physical order and drop any duplicates.
+  //
+  if (this->sparse_index_) {
+    const auto by_physical_page = [this](const CachedPage& l, const CachedPage& r) {
+      const i64 l_physical_page = this->page_ids_.get_physical_page(l.page_id);
+      const i64 r_physical_page = this->page_ids_.get_physical_page(r.page_id);
+      return l_physical_page < r_physical_page ||
+             (l_physical_page == r_physical_page && l.page_id < r.page_id);
+    };
+    const auto same_page_id = [](const CachedPage& l, const CachedPage& r) {
+      return l.page_id == r.page_id;
+    };
+    std::sort(out->begin() + first_out, out->end(), by_physical_page);
+    out->erase(std::unique(out->begin() + first_out, out->end(), same_page_id), out->end());
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageDeviceCache::maybe_replicate(const PageCacheSlot::PinnedRef& pinned,
+                                      const std::shared_ptr<const PageView>& view)
+{
+  // Replicas live in their own pools, so anything not from the primary pool is already a replica.
+  //
+  if (!this->replicas_ || !pinned ||
+      std::addressof(pinned.slot()->pool()) != this->slot_pool_.get()) {
+    return;
+  }
+  this->replicas_->maybe_insert(pinned.key(), pinned.pin_count(), view);
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 void PageDeviceCache::erase(PageId key)
 {
   BATT_CHECK_EQ(PageIdFactory::get_device_id(key), this->page_ids_.get_device_id());
 
+  if (this->replicas_) {
+    this->replicas_->erase(key);
+  }
+
   // Lookup the cache table entry for the given page id.
   //
   const i64 physical_page = this->page_ids_.get_physical_page(key);
-  std::atomic<usize>& slot_index_ref = this->get_slot_index_ref(physical_page);
+  std::atomic<usize>* const p_slot_index_ref = this->find_slot_index_ref(physical_page);
+  if (!p_slot_index_ref) {
+    return;
+  }
+  std::atomic<usize>& slot_index_ref = *p_slot_index_ref;
 
   usize slot_index = slot_index_ref.load();
   if (slot_index == kInvalidIndex) {
@@ -196,6 +451,11 @@ void PageDeviceCache::erase(PageId key)
         if (observed_key == key) {
           slot->set_obsolete_hint();
         }
+      } else if (this->sparse_index_ &&
+                 this->page_ids_.get_physical_page(observed_key) != physical_page) {
+        // Sparse index entries can be reused for other physical pages while we look at them; this
+        // one no longer refers to `key`, so there is nothing to erase.
+        //
       } else {
         // The table contains an older or newer generation of the same physical page; leave it
         // alone!
@@ -214,9 +474,125 @@ std::atomic<usize>& PageDeviceCache::get_slot_index_ref(i64 physical_page)
   static_assert(sizeof(std::atomic<usize>) == sizeof(usize));
   static_assert(alignof(std::atomic<usize>) == alignof(usize));
 
-  BATT_CHECK_LT((usize)physical_page, this->cache_.size());
+  if (!this->sparse_index_) {
+    BATT_CHECK_LT((usize)physical_page, this->cache_.size());
+
+    return reinterpret_cast<std::atomic<usize>&>(this->cache_[physical_page]);
+  }
+
+  BATT_CHECK_LT((usize)physical_page, this->page_ids_.get_physical_page_count().value());
+
+  SparseIndexEntry* const bucket = this->get_sparse_bucket(physical_page);
+
+  for (;;) {
+    // Look for an existing entry, and at the same time pick the one to replace if there isn't one:
+    // an empty entry if possible, else the one whose slot was least recently used.
+    //
+    SparseIndexEntry* victim = nullptr;
+    i64 victim_physical_page = SparseIndexEntry::kEmpty;
+    i64 victim_priority = 0;
+
+    for (usize way = 0; way < kSparseIndexWays; ++way) {
+      SparseIndexEntry& entry = bucket[way];
+
+      const i64 observed_physical_page = entry.physical_page.load();
+      if (observed_physical_page == physical_page) {
+        return entry.slot_index;
+      }
+
+      if (victim && victim_physical_page == SparseIndexEntry::kEmpty) {
+        continue;
+      }
+
+      const i64 priority = (observed_physical_page == SparseIndexEntry::kEmpty)
+                               ? 0
+                               : this->sparse_entry_priority(entry);
+
+      if (!victim || observed_physical_page == SparseIndexEntry::kEmpty ||
+          priority - victim_priority < 0) {
+        victim = &entry;
+        victim_physical_page = observed_physical_page;
+        victim_priority = priority;
+      }
+    }
+
+    BATT_CHECK_NOT_NULLPTR(victim);
+
+    // Claim the victim entry; if someone else changed it in the meantime, start over.
+    //
+    if (victim->physical_page.compare_exchange_strong(victim_physical_page, physical_page)) {
+      victim->slot_index.store(kInvalidIndex);
+      return victim->slot_index;
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::atomic<usize>* PageDeviceCache::find_slot_index_ref(i64 physical_page)
+{
+  if (!this->sparse_index_) {
+    return &this->get_slot_index_ref(physical_page);
+  }
+
+  SparseIndexEntry* const bucket = this->get_sparse_bucket(physical_page);
+
+  for (usize way = 0; way < kSparseIndexWays; ++way) {
+    if (bucket[way].physical_page.load() == physical_page) {
+      return &bucket[way].slot_index;
+    }
+  }
+  return nullptr;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto PageDeviceCache::get_sparse_bucket(i64 physical_page) const noexcept -> SparseIndexEntry*
+{
+  if (this->sparse_bucket_count_log2_ == 0) {
+    return this->sparse_index_.get();
+  }
+
+  // Fibonacci hashing; the high bits of the product are the best mixed.
+  //
+  const u64 hash = static_cast<u64>(physical_page) * 0x9e3779b97f4a7c15ull;
+  const usize bucket_i = hash >> (64 - this->sparse_bucket_count_log2_);
+
+  return this->sparse_index_.get() + bucket_i * kSparseIndexWays;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::atomic<page_id_int>& PageDeviceCache::get_negative_cache_entry(
+    i64 physical_page) const noexcept
+{
+  // Fibonacci hashing, as for the sparse index.
+  //
+  const u64 hash = static_cast<u64>(physical_page) * 0x9e3779b97f4a7c15ull;
+  const usize entry_i = hash >> (64 - this->negative_cache_size_log2_);
+
+  return this->negative_cache_[entry_i];
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+i64 PageDeviceCache::sparse_entry_priority(const SparseIndexEntry& entry) noexcept
+{
+  // Entries that don't point at a (valid) slot are the first to go; otherwise, use the latest use
+  // time stamp of the slot.  The slot may have been reused for some other page since the entry was
+  // set, in which case its time stamp is meaningless here, but that is harmless.
+  //
+  const usize slot_index = entry.slot_index.load();
+  if (slot_index == kInvalidIndex) {
+    return LRUClock::read_global() - (i64{1} << 60);
+  }
+
+  const PageCacheSlot* const slot = this->slot_pool_->get_slot(slot_index);
+  if (!slot->is_valid()) {
+    return LRUClock::read_global() - (i64{1} << 60);
+  }
 
-  return reinterpret_cast<std::atomic<usize>&>(this->cache_[physical_page]);
+  return slot->get_latest_use();
 }
 
 }  //namespace llfs
@@ -12,6 +12,7 @@
 
 #include <llfs/config.hpp>
 //
+#include <llfs/hot_page_replicas.hpp>
 #include <llfs/int_types.hpp>
 #include <llfs/page_cache_slot.hpp>
 #include <llfs/page_id_factory.hpp>
@@ -34,15 +35,59 @@ namespace llfs {
  * shared among many different per-device caches.  If there is memory pressure, cached data may be
  * evicted (i.e. stolen) from a cache that hasn't accessed it in a while and given to another cache
  * that is using the same pool.  If the data is pinned, however, this will never happen.
+ *
+ * The index from physical page to cache slot is normally a flat array with one entry per physical
+ * page on the device.  For devices with many more pages than the pool has slots (at least
+ * kSparseIndexMinPagesPerSlot), a "sparse" index is used instead, whose size is proportional to the
+ * number of slots: a set-associative hash table of (physical page, slot index) entries with
+ * kSparseIndexWays entries per bucket.  When all the entries in a bucket are in use, inserting
+ * another physical page replaces the entry whose slot was least recently used.  Index entries are
+ * only ever hints (every lookup pins the slot and checks its key), so an entry being replaced or
+ * reused concurrently can cost a cache miss, but never return the wrong page.
+ *
+ * Each cache also has a small, lossy "negative" cache: a direct-mapped table that remembers the
+ * latest known generation of recently allocated and dropped physical pages (see
+ * record_latest_generation).  A lookup that misses the cache and asks for an older generation of
+ * one of these pages fails right away with batt::StatusCode::kNotFound (the same status the
+ * PageDevice would report) instead of allocating a slot and reading the device.  Entries are
+ * overwritten by other pages that hash to the same place, which only ever costs a device read.
  */
 class PageDeviceCache
 {
  public:
   static constexpr usize kInvalidIndex = ~usize{0};
 
+  /** \brief The number of entries per bucket in the sparse index; 4 entries fill one cache line.
+   */
+  static constexpr usize kSparseIndexWays = 4;
+
+  /** \brief The sparse index has (at least) this many entries per slot in the pool.
+   */
+  static constexpr usize kSparseIndexEntriesPerSlot = 2;
+
+  /** \brief Devices with at least this many physical pages per pool slot use a sparse index.
+   */
+  static constexpr usize kSparseIndexMinPagesPerSlot = 16;
+
+  /** \brief The minimum number of entries in the negative cache (see class comment); it otherwise
+   * has one entry per pool slot, rounded up to a power of 2.
+   */
+  static constexpr usize kMinNegativeCacheSize = 64;
+
+  /** \brief A page found in the cache by append_cached_pages.
+   */
+  struct CachedPage {
+    PageId page_id;
+    i64 latest_use;
+  };
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
-  explicit PageDeviceCache(const PageIdFactory& page_ids,
+  /** \brief Creates a cache for the device described by `page_ids`, whose pages are `page_size`
+   * bytes; each cached page is charged `page_size` bytes in `slot_pool` (see
+   * PageCacheSlot::Pool::max_bytes()).
+   */
+  explicit PageDeviceCache(const PageIdFactory& page_ids, usize page_size,
                            boost::intrusive_ptr<PageCacheSlot::Pool>&& slot_pool) noexcept;
 
   PageDeviceCache(const PageDeviceCache&) = delete;
@@ -61,30 +106,133 @@ class PageDeviceCache
    */
   const PageIdFactory& page_ids() const noexcept;
 
+  /** \brief Enables per-CPU replicas of hot pages (see HotPageReplicas); must be called before
+   * the cache is used.
+   */
+  void enable_hot_page_replicas(usize n_sets, usize slots_per_set, u32 pin_threshold);
+
+  /** \brief Returns the hot page replicas of this cache, or nullptr if they are not enabled.
+   */
+  const HotPageReplicas* hot_page_replicas() const noexcept
+  {
+    return this->replicas_.get();
+  }
+
+  /** \brief Returns true iff this cache uses a sparse index (see class comment).
+   */
+  bool has_sparse_index() const noexcept
+  {
+    return this->sparse_index_ != nullptr;
+  }
+
+  /** \brief Returns the number of bytes of memory used by the index.
+   */
+  usize index_size_bytes() const noexcept;
+
   /** \brief Returns a PinnedRef to the cache slot for the given page.
    *
    * If the specified page is was not present in the cache, then the initialize function will be
-   * called to start the process of loading the page data into the slot.
+   * called to start the process of loading the page data into the slot; unless the page is known
+   * to be stale (see is_known_stale), in which case batt::StatusCode::kNotFound is returned.
+   *
+   * If hot page replicas are enabled and the calling thread's replica set has a copy of the page,
+   * the returned PinnedRef refers to the replica.
    */
   batt::StatusOr<PageCacheSlot::PinnedRef> find_or_insert(
       PageId key, const std::function<void(const PageCacheSlot::PinnedRef&)>& initialize);
 
-  /** \brief Removes the specified key from this cache, if it is currently present.
+  /** \brief Returns a PinnedRef to the cache slot for the given page if it is already present in
+   * the cache; otherwise returns an empty PinnedRef.  Unlike find_or_insert, this never starts a
+   * load, and doesn't count as a use of the page (for the admission filter or for eviction order).
+   */
+  PageCacheSlot::PinnedRef find(PageId key);
+
+  /** \brief Returns the slot that most recently held the given page, without pinning it, or
+   * nullptr if there is none; the slot may since have been evicted and/or reused for another page.
+   * Used to start optimistic reads (see PageCacheSlot::begin_optimistic_read).
+   */
+  PageCacheSlot* peek(PageId key);
+
+  /** \brief Replicates the page pinned by `pinned` (a PinnedRef returned by find_or_insert, whose
+   * page has been loaded as `view`) into the calling thread's replica set if it is hot enough; does
+   * nothing if hot page replicas are not enabled, or `pinned` already refers to a replica.
+   */
+  void maybe_replicate(const PageCacheSlot::PinnedRef& pinned,
+                       const std::shared_ptr<const PageView>& view);
+
+  /** \brief Removes the specified key from this cache (and its replicas), if it is currently
+   * present.
    */
   void erase(PageId key);
 
+  /** \brief Records that the generation of `key` is the latest one of its physical page (e.g.,
+   * because the page was just allocated), so that lookups of older generations fail fast.  When a
+   * page is dropped, call this with the next generation (see PageIdFactory::advance_generation).
+   */
+  void record_latest_generation(PageId key) noexcept;
+
+  /** \brief Returns true iff a newer generation of the physical page of `key` is known (see
+   * record_latest_generation).  A false result doesn't mean that `key` is current.
+   */
+  bool is_known_stale(PageId key) const noexcept;
+
+  /** \brief Appends the id and latest use time stamp (see PageCacheSlot::get_latest_use) of every
+   * page currently in this cache to `out`, in physical page order.  Like find, this doesn't count
+   * as a use of the pages.
+   */
+  void append_cached_pages(std::vector<CachedPage>* out);
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
  private:
+  /** \brief An entry of the sparse index.
+   */
+  struct SparseIndexEntry {
+    static constexpr i64 kEmpty = -1;
+
+    std::atomic<i64> physical_page{kEmpty};
+    std::atomic<usize> slot_index{kInvalidIndex};
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
   /** \brief Returns a reference to the atomic cache slot index integer for the given physical page
-   * on the device for this cache.
+   * on the device for this cache, creating an index entry for it if necessary.
    */
   std::atomic<usize>& get_slot_index_ref(i64 physical_page);
 
+  /** \brief Returns a pointer to the atomic cache slot index integer for the given physical page,
+   * or nullptr if the (sparse) index has no entry for the page.
+   */
+  std::atomic<usize>* find_slot_index_ref(i64 physical_page);
+
+  /** \brief Returns the first entry of the sparse index bucket for `physical_page`.
+   */
+  SparseIndexEntry* get_sparse_bucket(i64 physical_page) const noexcept;
+
+  /** \brief Returns the negative cache entry for `physical_page`.
+   */
+  std::atomic<page_id_int>& get_negative_cache_entry(i64 physical_page) const noexcept;
+
+  /** \brief Returns the value used to choose which entry of a full sparse index bucket to replace
+   * (the lowest is replaced).
+   */
+  i64 sparse_entry_priority(const SparseIndexEntry& entry) noexcept;
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   const PageIdFactory page_ids_;
+  const usize page_size_;
   boost::intrusive_ptr<PageCacheSlot::Pool> slot_pool_;
   std::vector<usize> cache_;
+  std::unique_ptr<SparseIndexEntry[]> sparse_index_;
+  usize sparse_bucket_count_log2_ = 0;
+  std::unique_ptr<HotPageReplicas> replicas_;
+
+  // The negative cache (see class comment); each entry is the int value of the latest known PageId
+  // for some physical page, or kInvalidPageId.
+  //
+  std::unique_ptr<std::atomic<page_id_int>[]> negative_cache_;
+  usize negative_cache_size_log2_ = 0;
 };
 
 }  //namespace llfs
@@ -0,0 +1,199 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_device_cache.hpp>
+//
+#include <llfs/page_device_cache.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//
+//  1. (IndexKind) Small devices get a flat index; devices with many more pages than the pool has
+//     slots get a sparse index, whose size depends only on the number of slots.
+//  2. (SparseIndexLookups) With a sparse index, pages scattered across a huge device can be
+//     inserted, found again, and erased; lookups never return the wrong page, even after index
+//     entries have been replaced.
+//  3. (SparseIndexAppendCachedPages) append_cached_pages still returns pages in physical order.
+//  4. (NegativeCache) Once a newer generation of a page has been recorded, lookups of older
+//     generations fail with kNotFound without starting a load; the current and newer generations
+//     (and other pages) are unaffected, and recording an older generation changes nothing.
+
+using llfs::PageCacheSlot;
+using llfs::PageDeviceCache;
+using llfs::PageId;
+
+using namespace llfs::int_types;
+
+void no_op_initialize(const PageCacheSlot::PinnedRef&)
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageDeviceCacheTest, IndexKind)
+{
+  constexpr usize kNumSlots = 64;
+
+  {
+    const llfs::PageIdFactory page_ids{llfs::PageCount{kNumSlots * 4}, /*page_device_id=*/1};
+    PageDeviceCache cache{page_ids, /*page_size=*/4096,
+                          PageCacheSlot::Pool::make_new(kNumSlots, "flat_pool")};
+
+    EXPECT_FALSE(cache.has_sparse_index());
+    EXPECT_EQ(cache.index_size_bytes(), kNumSlots * 4 * sizeof(usize));
+  }
+
+  for (u64 n_pages : {u64{1} << 20, u64{1} << 32}) {
+    const llfs::PageIdFactory page_ids{llfs::PageCount{n_pages}, /*page_device_id=*/1};
+    PageDeviceCache cache{page_ids, /*page_size=*/4096,
+                          PageCacheSlot::Pool::make_new(kNumSlots, "sparse_pool")};
+
+    EXPECT_TRUE(cache.has_sparse_index());
+    EXPECT_GE(cache.index_size_bytes(), kNumSlots * PageDeviceCache::kSparseIndexEntriesPerSlot *
+                                            2 * sizeof(usize));
+    EXPECT_LE(cache.index_size_bytes(), 4096u);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageDeviceCacheTest, SparseIndexLookups)
+{
+  constexpr usize kNumSlots = 32;
+
+  const llfs::PageIdFactory page_ids{llfs::PageCount{u64{1} << 32}, /*page_device_id=*/2};
+  PageDeviceCache cache{page_ids, /*page_size=*/4096,
+                        PageCacheSlot::Pool::make_new(kNumSlots, "sparse_pool")};
+
+  ASSERT_TRUE(cache.has_sparse_index());
+
+  std::default_random_engine rng{/*seed=*/11};
+  std::uniform_int_distribution<i64> pick_physical_page{0, (i64{1} << 32) - 1};
+
+  std::vector<PageId> inserted;
+  for (usize i = 0; i < kNumSlots * 8; ++i) {
+    const PageId page_id = page_ids.make_page_id(pick_physical_page(rng), /*generation=*/1);
+
+    llfs::StatusOr<PageCacheSlot::PinnedRef> pinned =
+        cache.find_or_insert(page_id, &no_op_initialize);
+
+    ASSERT_TRUE(pinned.ok()) << BATT_INSPECT(pinned.status());
+    EXPECT_EQ(pinned->key(), page_id);
+
+    // A page that was just inserted can always be found.
+    //
+    PageCacheSlot::PinnedRef found = cache.find(page_id);
+    ASSERT_TRUE(found);
+    EXPECT_EQ(found.key(), page_id);
+
+    inserted.emplace_back(page_id);
+  }
+
+  // Most of the earlier pages have been evicted or had their index entries replaced, but any that
+  // are still found must be the right page.
+  //
+  usize found_count = 0;
+  for (const PageId& page_id : inserted) {
+    PageCacheSlot::PinnedRef found = cache.find(page_id);
+    if (found) {
+      EXPECT_EQ(found.key(), page_id);
+      ++found_count;
+    }
+  }
+  EXPECT_LE(found_count, kNumSlots);
+  EXPECT_GT(found_count, 0u);
+
+  // Erase the most recent page.
+  //
+  cache.erase(inserted.back());
+  EXPECT_FALSE(cache.find(inserted.back()));
+  EXPECT_EQ(cache.peek(inserted.back()), nullptr);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageDeviceCacheTest, SparseIndexAppendCachedPages)
+{
+  const llfs::PageIdFactory page_ids{llfs::PageCount{u64{1} << 24}, /*page_device_id=*/3};
+  PageDeviceCache cache{page_ids, /*page_size=*/4096,
+                        PageCacheSlot::Pool::make_new(/*n_slots=*/8, "sparse_pool")};
+
+  ASSERT_TRUE(cache.has_sparse_index());
+
+  const std::vector<i64> physical_pages = {9000000, 2, 140000};
+  for (i64 physical_page : physical_pages) {
+    ASSERT_TRUE(cache
+                    .find_or_insert(page_ids.make_page_id(physical_page, /*generation=*/1),
+                                    &no_op_initialize)
+                    .ok());
+  }
+
+  std::vector<PageDeviceCache::CachedPage> cached_pages;
+  cache.append_cached_pages(&cached_pages);
+
+  ASSERT_EQ(cached_pages.size(), 3u);
+  EXPECT_EQ(cached_pages[0].page_id, page_ids.make_page_id(2, 1));
+  EXPECT_EQ(cached_pages[1].page_id, page_ids.make_page_id(140000, 1));
+  EXPECT_EQ(cached_pages[2].page_id, page_ids.make_page_id(9000000, 1));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageDeviceCacheTest, NegativeCache)
+{
+  const llfs::PageIdFactory page_ids{llfs::PageCount{256}, /*page_device_id=*/4};
+  PageDeviceCache cache{page_ids, /*page_size=*/4096,
+                        PageCacheSlot::Pool::make_new(/*n_slots=*/8, "negative_pool")};
+
+  usize load_count = 0;
+  const auto count_loads = [&load_count](const PageCacheSlot::PinnedRef&) {
+    ++load_count;
+  };
+
+  const PageId gen1 = page_ids.make_page_id(/*physical_page=*/7, /*generation=*/1);
+  const PageId gen2 = page_ids.advance_generation(gen1);
+  const PageId gen3 = page_ids.advance_generation(gen2);
+
+  EXPECT_FALSE(cache.is_known_stale(gen1));
+
+  // Generation 1 is dropped.
+  //
+  cache.record_latest_generation(gen2);
+
+  EXPECT_TRUE(cache.is_known_stale(gen1));
+  EXPECT_FALSE(cache.is_known_stale(gen2));
+  EXPECT_FALSE(cache.is_known_stale(gen3));
+  EXPECT_FALSE(cache.is_known_stale(page_ids.make_page_id(/*physical_page=*/8, 1)));
+
+  llfs::StatusOr<PageCacheSlot::PinnedRef> stale = cache.find_or_insert(gen1, count_loads);
+  EXPECT_EQ(stale.status(), batt::StatusCode::kNotFound);
+  EXPECT_EQ(load_count, 0u);
+  EXPECT_EQ(cache.metrics().known_stale_count.load(), 1u);
+
+  llfs::StatusOr<PageCacheSlot::PinnedRef> current = cache.find_or_insert(gen2, count_loads);
+  ASSERT_TRUE(current.ok()) << BATT_INSPECT(current.status());
+  EXPECT_EQ(current->key(), gen2);
+  EXPECT_EQ(load_count, 1u);
+
+  // Recording an older generation doesn't undo what we know.
+  //
+  cache.record_latest_generation(gen1);
+  EXPECT_TRUE(cache.is_known_stale(gen1));
+
+  cache.record_latest_generation(gen3);
+  EXPECT_TRUE(cache.is_known_stale(gen2));
+}
+
+}  // namespace
@@ -19,14 +19,28 @@
 
 #include <boost/uuid/random_generator.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
 namespace llfs {
 
+namespace {
+
+// When page headers are initialized (see kFastIoRingPageDeviceInit), pages no larger than this are
+// written whole, several at a time.
+//
+constexpr u64 kMaxPageInitWriteSize = 1024 * 1024;
+
+}  // namespace
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 BATT_PRINT_OBJECT_IMPL(PackedPageDeviceConfig,  //
                        (page_0_offset)          //
                        (device_id)              //
                        (page_count)             //
+                       (max_page_count)         //
                        (page_size_log2)         //
                        (uuid)                   //
 )
@@ -38,7 +52,15 @@ Status configure_storage_object(StorageFileBuilder::Transaction& txn,
                                 const PageDeviceConfigOptions& options)
 {
   const i64 page_size = (i64{1} << options.page_size_log2);
-  const i64 pages_total_size = page_size * options.page_count;
+  const bool reserve_capacity =
+      options.max_page_count && *options.max_page_count > options.page_count;
+  const i64 page_capacity = BATT_CHECKED_CAST(
+      i64, (reserve_capacity ? *options.max_page_count : options.page_count).value());
+
+  // Reserve file space for the full capacity, so that the device can grow in place; only the first
+  // `page_count` pages are initialized below (the rest of the space stays sparse until used).
+  //
+  const i64 pages_total_size = page_size * page_capacity;
 
   const Interval<i64> pages_offset = txn.reserve_aligned(options.page_size_log2, pages_total_size);
 
@@ -49,6 +71,7 @@ Status configure_storage_object(StorageFileBuilder::Transaction& txn,
     p_config->device_id = *options.device_id;
   }
   p_config->page_count = options.page_count;
+  p_config->max_page_count = reserve_capacity ? page_capacity : 0;
   p_config->page_size_log2 = options.page_size_log2;
   p_config->uuid = options.uuid.value_or(boost::uuids::random_generator{}());
 
@@ -60,21 +83,34 @@ Status configure_storage_object(StorageFileBuilder::Transaction& txn,
     BATT_REQUIRE_OK(truncate_status);
 
     if (!kFastIoRingPageDeviceInit) {
-      // Initialize all the packed page headers.
+      // Initialize all the packed page headers.  Small pages are written whole, several per write
+      // (up to kMaxPageInitWriteSize bytes); larger pages get one header-sized write each.
       //
-      std::aligned_storage_t<512, 512> buffer;
-      std::memset(&buffer, 0, sizeof(buffer));
-
-      auto& page_header = reinterpret_cast<PackedPageHeader&>(buffer);
-      page_header.magic = PackedPageHeader::kMagic;
-      page_header.crc32 = PackedPageHeader::kCrc32NotSet;
-      page_header.page_id = PackedPageId{.id_val = kInvalidPageId};
+      using AlignedBlock = std::aligned_storage_t<512, 512>;
+
+      const u64 pages_per_write =
+          std::max<u64>(1, kMaxPageInitWriteSize / static_cast<u64>(page_size));
+      const usize page_stride = (pages_per_write == 1) ? sizeof(AlignedBlock) : page_size;
+
+      std::unique_ptr<AlignedBlock[]> buffer{
+          new AlignedBlock[pages_per_write * page_stride / sizeof(AlignedBlock)]};
+      std::memset(buffer.get(), 0, pages_per_write * page_stride);
+
+      for (u64 i = 0; i < pages_per_write; ++i) {
+        auto& page_header = *reinterpret_cast<PackedPageHeader*>(
+            reinterpret_cast<u8*>(buffer.get()) + i * page_stride);
+        page_header.magic = PackedPageHeader::kMagic;
+        page_header.crc32 = PackedPageHeader::kCrc32NotSet;
+        page_header.page_id = PackedPageId{.id_val = kInvalidPageId};
+      }
 
-      for (u64 page_i = 0; page_i < page_count; ++page_i) {
+      for (u64 page_i = 0; page_i < page_count; page_i += pages_per_write) {
+        const u64 n_pages = std::min<u64>(pages_per_write, page_count - page_i);
         const i64 page_offset = pages_offset.lower_bound + page_i * page_size;
-        LLFS_DVLOG(1) << "writing null page header | " << BATT_INSPECT(page_i)
-                      << BATT_INSPECT(page_offset);
-        Status status = write_all(file, page_offset, ConstBuffer{&buffer, sizeof(buffer)});
+        LLFS_DVLOG(1) << "writing null page headers | " << BATT_INSPECT(page_i)
+                      << BATT_INSPECT(n_pages) << BATT_INSPECT(page_offset);
+        Status status =
+            write_all(file, page_offset, ConstBuffer{buffer.get(), n_pages * page_stride});
         BATT_REQUIRE_OK(status);
       }
     }
@@ -88,14 +124,25 @@ Status configure_storage_object(StorageFileBuilder::Transaction& txn,
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 StatusOr<std::unique_ptr<PageDevice>> recover_storage_object(
-    const batt::SharedPtr<StorageContext>& /*storage_context*/, const std::string& file_name,
+    const batt::SharedPtr<StorageContext>& storage_context, const std::string& file_name,
     const FileOffsetPtr<const PackedPageDeviceConfig&>& p_config,
     const IoRingFileRuntimeOptions& file_options)
+{
+  return recover_storage_object(storage_context, file_name, p_config, file_options,
+                                IoRingPageFileDeviceOptions{});
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::unique_ptr<PageDevice>> recover_storage_object(
+    const batt::SharedPtr<StorageContext>& /*storage_context*/, const std::string& file_name,
+    const FileOffsetPtr<const PackedPageDeviceConfig&>& p_config,
+    const IoRingFileRuntimeOptions& file_options, const IoRingPageFileDeviceOptions& device_options)
 {
   StatusOr<IoRing::File> file = open_ioring_file(file_name, file_options);
   BATT_REQUIRE_OK(file);
 
-  return std::make_unique<IoRingPageFileDevice>(std::move(*file), p_config);
+  return std::make_unique<IoRingPageFileDevice>(std::move(*file), p_config, device_options);
 }
 
 }  // namespace llfs
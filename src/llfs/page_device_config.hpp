@@ -13,6 +13,7 @@
 #include <llfs/config.hpp>
 #include <llfs/int_types.hpp>
 #include <llfs/ioring_file_runtime_options.hpp>
+#include <llfs/ioring_page_file_device_options.hpp>
 #include <llfs/packed_config.hpp>
 #include <llfs/page_id_factory.hpp>
 #include <llfs/page_size.hpp>
@@ -24,6 +25,7 @@
 
 #include <boost/uuid/uuid.hpp>
 
+#include <algorithm>
 #include <ostream>
 #include <variant>
 
@@ -46,6 +48,12 @@ StatusOr<std::unique_ptr<PageDevice>> recover_storage_object(
     const FileOffsetPtr<const PackedPageDeviceConfig&>& p_config,
     const IoRingFileRuntimeOptions& file_options);
 
+StatusOr<std::unique_ptr<PageDevice>> recover_storage_object(
+    const batt::SharedPtr<StorageContext>& storage_context, const std::string& file_name,
+    const FileOffsetPtr<const PackedPageDeviceConfig&>& p_config,
+    const IoRingFileRuntimeOptions& file_options,
+    const IoRingPageFileDeviceOptions& device_options);
+
 #endif  // LLFS_DISABLE_IO_URING
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
@@ -66,6 +74,12 @@ struct PageDeviceConfigOptions {
   //
   PageCount page_count;
 
+  // If set (and greater than `page_count`), the device is formatted with file space and page id
+  // space for this many pages, so that it can later be grown (see PageAllocator::grow) to this size
+  // without reformatting.  Only the first `page_count` pages are initialized.
+  //
+  Optional<PageCount> max_page_count;
+
   // log2(the page size of the device)
   //
   PageSizeLog2 page_size_log2;
@@ -90,9 +104,10 @@ struct PageDeviceConfigOptions {
 
 inline bool operator==(const PageDeviceConfigOptions& l, const PageDeviceConfigOptions& r)
 {
-  return l.uuid == r.uuid                 //
-         && l.device_id == r.device_id    //
-         && l.page_count == r.page_count  //
+  return l.uuid == r.uuid                          //
+         && l.device_id == r.device_id             //
+         && l.page_count == r.page_count           //
+         && l.max_page_count == r.max_page_count   //
          && l.page_size_log2 == r.page_size_log2;
 }
 
@@ -179,9 +194,14 @@ struct PackedPageDeviceConfig : PackedConfigSlotHeader {
   //
   little_u16 page_size_log2;
 
+  // The number of pages for which file space and page id space are reserved, or 0 if this is the
+  // same as `page_count` (see PageDeviceConfigOptions::max_page_count).
+  //
+  little_i64 max_page_count;
+
   // Reserved for future use.
   //
-  little_u8 reserved_[18];
+  little_u8 reserved_[10];
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
@@ -189,6 +209,13 @@ struct PackedPageDeviceConfig : PackedConfigSlotHeader {
   {
     return usize{1} << this->page_size_log2.value();
   }
+
+  // Returns the number of pages addressable by this device, including those reserved for growth.
+  //
+  i64 page_capacity() const
+  {
+    return std::max<i64>(this->page_count, this->max_page_count);
+  }
 };
 
 BATT_STATIC_ASSERT_EQ(sizeof(PackedPageDeviceConfig), PackedPageDeviceConfig::kSize);
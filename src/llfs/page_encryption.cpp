@@ -0,0 +1,111 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_encryption.hpp>
+//
+
+#include <llfs/packed_page_header.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/checked_cast.hpp>
+
+#include <openssl/evp.h>
+
+#include <cstring>
+#include <memory>
+
+namespace llfs {
+
+namespace {
+
+// Encrypts (if `encrypt`) or decrypts the payload of `src` into `dst`.
+//
+Status transform_page_payload(const PageEncryptionKey& key, const PageBuffer& src,
+                              PageBuffer* dst, bool encrypt)
+{
+  BATT_CHECK_NOT_NULLPTR(dst);
+  BATT_CHECK_EQ(src.size(), dst->size());
+
+  const usize payload_offset = sizeof(PackedPageHeader);
+  const usize payload_size = src.size() - payload_offset;
+
+  const u8* const src_data = static_cast<const u8*>(src.const_buffer().data());
+  u8* const dst_data = static_cast<u8*>(dst->mutable_buffer().data());
+
+  if (src_data != dst_data) {
+    std::memcpy(dst_data, src_data, payload_offset);
+  }
+
+  // The XTS tweak is the (little-endian) PageId, zero-padded to the AES block size.
+  //
+  std::array<u8, 16> tweak;
+  tweak.fill(0);
+  const page_id_int page_id = src.page_id().int_value();
+  for (usize i = 0; i < sizeof(page_id); ++i) {
+    tweak[i] = static_cast<u8>(page_id >> (i * 8));
+  }
+
+  std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> ctx{EVP_CIPHER_CTX_new(),
+                                                                      &EVP_CIPHER_CTX_free};
+  if (!ctx) {
+    return {batt::StatusCode::kResourceExhausted};
+  }
+
+  if (EVP_CipherInit_ex(ctx.get(), EVP_aes_256_xts(), nullptr, key.bytes.data(), tweak.data(),
+                        encrypt ? 1 : 0) != 1) {
+    return {batt::StatusCode::kInvalidArgument};
+  }
+
+  // XTS must process the whole data unit in one update.
+  //
+  int n_out = 0;
+  if (EVP_CipherUpdate(ctx.get(), dst_data + payload_offset, &n_out, src_data + payload_offset,
+                       BATT_CHECKED_CAST(int, payload_size)) != 1 ||
+      static_cast<usize>(n_out) != payload_size) {
+    return {batt::StatusCode::kInternal};
+  }
+
+  int n_final = 0;
+  if (EVP_CipherFinal_ex(ctx.get(), dst_data + payload_offset + n_out, &n_final) != 1 ||
+      n_final != 0) {
+    return {batt::StatusCode::kInternal};
+  }
+
+  return OkStatus();
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status validate_page_encryption_key(const PageEncryptionKey& key)
+{
+  // OpenSSL refuses XTS keys whose two halves are the same.
+  //
+  const usize half = key.bytes.size() / 2;
+  if (std::memcmp(key.bytes.data(), key.bytes.data() + half, half) == 0) {
+    return {batt::StatusCode::kInvalidArgument};
+  }
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status encrypt_page_payload(const PageEncryptionKey& key, const PageBuffer& src, PageBuffer* dst)
+{
+  return transform_page_payload(key, src, dst, /*encrypt=*/true);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status decrypt_page_payload(const PageEncryptionKey& key, const PageBuffer& src, PageBuffer* dst)
+{
+  return transform_page_payload(key, src, dst, /*encrypt=*/false);
+}
+
+}  // namespace llfs
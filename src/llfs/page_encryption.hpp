@@ -0,0 +1,56 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_ENCRYPTION_HPP
+#define LLFS_PAGE_ENCRYPTION_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/page_buffer.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/status.hpp>
+
+#include <array>
+
+namespace llfs {
+
+// A key for AES-256-XTS page encryption: two independent 256-bit AES keys, back to back.  The two
+// halves must differ.
+//
+struct PageEncryptionKey {
+  std::array<u8, 64> bytes;
+};
+
+// Returns OkStatus iff `key` can be used to encrypt pages.
+//
+Status validate_page_encryption_key(const PageEncryptionKey& key);
+
+// Encrypts the payload of `src` (everything after its PackedPageHeader) into `dst`, which must be
+// the same size; the header is copied to `dst` unencrypted, so devices can still check it when the
+// page is read.  `src` and `dst` may be the same buffer.
+//
+// The cipher is AES-256-XTS (which OpenSSL runs with the AES-NI/VAES instructions where the CPU
+// has them), with the whole payload as a single data unit and the PageId (which includes the
+// generation) as the tweak, so the same data written to the same page twice encrypts differently
+// each time the page is reused.  XTS doesn't change the length of the data, so encrypted pages
+// have the same layout (and unused region) as the original ones.
+//
+// The page CRC (see finalize_page_header) covers the original page, so a page decrypted with the
+// wrong key fails checksum verification.
+//
+Status encrypt_page_payload(const PageEncryptionKey& key, const PageBuffer& src, PageBuffer* dst);
+
+// The inverse of encrypt_page_payload.  `src` and `dst` may be the same buffer.
+//
+Status decrypt_page_payload(const PageEncryptionKey& key, const PageBuffer& src, PageBuffer* dst);
+
+}  // namespace llfs
+
+#endif  // LLFS_PAGE_ENCRYPTION_HPP
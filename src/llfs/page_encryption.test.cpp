@@ -0,0 +1,140 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_encryption.hpp>
+//
+#include <llfs/page_encryption.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/packed_page_header.hpp>
+
+#include <cstring>
+#include <random>
+
+namespace {
+
+// Test Plan:
+//
+//  1. A page round-trips through encrypt_page_payload/decrypt_page_payload, both into another
+//     buffer and in place; the header is not encrypted and the payload is.
+//  2. The same data in a page with a different PageId (e.g., a new generation) encrypts
+//     differently.
+//  3. Decrypting with a different key doesn't recover the page.
+//  4. A key whose two halves are the same is rejected.
+
+using namespace llfs::int_types;
+
+constexpr usize kTestPageSize = 16 * 1024;
+
+llfs::PageEncryptionKey make_test_key(u32 seed)
+{
+  std::default_random_engine rng{seed};
+  std::uniform_int_distribution<int> pick_byte{0, 255};
+
+  llfs::PageEncryptionKey key;
+  for (u8& b : key.bytes) {
+    b = static_cast<u8>(pick_byte(rng));
+  }
+  return key;
+}
+
+std::shared_ptr<llfs::PageBuffer> make_test_page(llfs::PageId page_id)
+{
+  std::shared_ptr<llfs::PageBuffer> page =
+      llfs::PageBuffer::allocate(llfs::PageSize{kTestPageSize}, page_id);
+
+  u8* const bytes = reinterpret_cast<u8*>(page.get());
+  for (usize i = sizeof(llfs::PackedPageHeader); i < kTestPageSize; ++i) {
+    bytes[i] = static_cast<u8>(i * 13);
+  }
+  return page;
+}
+
+bool same_bytes(const llfs::PageBuffer& a, const llfs::PageBuffer& b, usize offset, usize size)
+{
+  return std::memcmp(reinterpret_cast<const u8*>(&a) + offset,
+                     reinterpret_cast<const u8*>(&b) + offset, size) == 0;
+}
+
+constexpr usize kHeaderSize = sizeof(llfs::PackedPageHeader);
+constexpr usize kPayloadSize = kTestPageSize - kHeaderSize;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageEncryptionTest, RoundTrip)
+{
+  const llfs::PageEncryptionKey key = make_test_key(1);
+  ASSERT_TRUE(llfs::validate_page_encryption_key(key).ok());
+
+  std::shared_ptr<llfs::PageBuffer> original = make_test_page(llfs::PageId{0x1234});
+  std::shared_ptr<llfs::PageBuffer> encrypted =
+      llfs::PageBuffer::allocate(llfs::PageSize{kTestPageSize});
+
+  ASSERT_TRUE(llfs::encrypt_page_payload(key, *original, encrypted.get()).ok());
+
+  EXPECT_TRUE(same_bytes(*original, *encrypted, 0, kHeaderSize));
+  EXPECT_FALSE(same_bytes(*original, *encrypted, kHeaderSize, kPayloadSize));
+  EXPECT_EQ(encrypted->page_id(), original->page_id());
+
+  std::shared_ptr<llfs::PageBuffer> decrypted =
+      llfs::PageBuffer::allocate(llfs::PageSize{kTestPageSize});
+
+  ASSERT_TRUE(llfs::decrypt_page_payload(key, *encrypted, decrypted.get()).ok());
+  EXPECT_TRUE(same_bytes(*original, *decrypted, 0, kTestPageSize));
+
+  // In place.
+  //
+  ASSERT_TRUE(llfs::decrypt_page_payload(key, *encrypted, encrypted.get()).ok());
+  EXPECT_TRUE(same_bytes(*original, *encrypted, 0, kTestPageSize));
+
+  ASSERT_TRUE(llfs::encrypt_page_payload(key, *encrypted, encrypted.get()).ok());
+  EXPECT_TRUE(same_bytes(*decrypted, *encrypted, 0, kHeaderSize));
+  EXPECT_FALSE(same_bytes(*decrypted, *encrypted, kHeaderSize, kPayloadSize));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageEncryptionTest, TweakedByPageId)
+{
+  const llfs::PageEncryptionKey key = make_test_key(2);
+
+  std::shared_ptr<llfs::PageBuffer> page_a = make_test_page(llfs::PageId{0x1000001});
+  std::shared_ptr<llfs::PageBuffer> page_b = make_test_page(llfs::PageId{0x2000001});
+
+  ASSERT_TRUE(llfs::encrypt_page_payload(key, *page_a, page_a.get()).ok());
+  ASSERT_TRUE(llfs::encrypt_page_payload(key, *page_b, page_b.get()).ok());
+
+  EXPECT_FALSE(same_bytes(*page_a, *page_b, kHeaderSize, kPayloadSize));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageEncryptionTest, WrongKey)
+{
+  std::shared_ptr<llfs::PageBuffer> original = make_test_page(llfs::PageId{7});
+  std::shared_ptr<llfs::PageBuffer> page = make_test_page(llfs::PageId{7});
+
+  ASSERT_TRUE(llfs::encrypt_page_payload(make_test_key(3), *page, page.get()).ok());
+  ASSERT_TRUE(llfs::decrypt_page_payload(make_test_key(4), *page, page.get()).ok());
+
+  EXPECT_FALSE(same_bytes(*original, *page, kHeaderSize, kPayloadSize));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageEncryptionTest, InvalidKey)
+{
+  llfs::PageEncryptionKey key;
+  key.bytes.fill(0x42);
+
+  EXPECT_EQ(llfs::validate_page_encryption_key(key), batt::StatusCode::kInvalidArgument);
+}
+
+}  // namespace
@@ -10,9 +10,12 @@
 //
 
 #include <llfs/pinned_page.hpp>
+#include <llfs/status_code.hpp>
 
 #include <batteries/case_of.hpp>
 
+#include <cstring>
+
 namespace llfs {
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -29,7 +32,7 @@ bool NullPageFilter::might_contain_key(const KeyView& /*key*/)
 PageBloomFilter::PageBloomFilter(PageId page_id, std::unique_ptr<u64[]> memory) noexcept
     : PageFilter{page_id}
     , memory_{std::move(memory)}
-    , filter_{reinterpret_cast<PackedBloomFilter*>(this->memory_.get())}
+    , filter_{aligned_filter(this->memory_.get())}
 {
 }
 
@@ -40,4 +43,68 @@ bool PageBloomFilter::might_contain_key(const KeyView& key)
   return filter_->might_contain(key);
 }
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageXorFilter::PageXorFilter(PageId page_id, std::unique_ptr<u64[]> memory) noexcept
+    : PageFilter{page_id}
+    , memory_{std::move(memory)}
+    , filter_{reinterpret_cast<PackedXorFilter*>(this->memory_.get())}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool PageXorFilter::might_contain_key(const KeyView& key)
+{
+  return this->filter_->might_contain(key);
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::shared_ptr<PageFilter>> unpack_page_filter(PageId page_id, PageFilterType type,
+                                                         const ConstBuffer& packed)
+{
+  const usize word_size = (packed.size() + sizeof(u64) - 1) / sizeof(u64);
+
+  switch (type) {
+    case PageFilterType::kNull:
+      return {std::make_shared<NullPageFilter>(page_id)};
+
+    case PageFilterType::kBloom: {
+      if (packed.size() < offsetof(PackedBloomFilter, words)) {
+        break;
+      }
+      std::unique_ptr<u64[]> memory{new u64[word_size + PageBloomFilter::kAlignmentPadWords]};
+      PackedBloomFilter* const filter = PageBloomFilter::aligned_filter(memory.get());
+      std::memcpy(filter, packed.data(), packed.size());
+
+      if (packed_sizeof(*filter) != packed.size()) {
+        break;
+      }
+      return {std::make_shared<PageBloomFilter>(page_id, std::move(memory))};
+    }
+
+    case PageFilterType::kXor: {
+      if (packed.size() < offsetof(PackedXorFilter, fingerprints)) {
+        break;
+      }
+      std::unique_ptr<u64[]> memory{new u64[word_size]};
+      auto* const filter = reinterpret_cast<PackedXorFilter*>(memory.get());
+      std::memcpy(filter, packed.data(), packed.size());
+
+      if ((filter->fingerprint_bits != 8 && filter->fingerprint_bits != 16) ||
+          packed_sizeof(*filter) != packed.size()) {
+        break;
+      }
+      return {std::make_shared<PageXorFilter>(page_id, std::move(memory))};
+    }
+  }
+
+  return {::llfs::make_status(StatusCode::kPageFilterBadData)};
+}
+
 }  // namespace llfs
@@ -11,13 +11,30 @@
 #define LLFS_PAGE_FILTER_HPP
 
 #include <llfs/bloom_filter.hpp>
+#include <llfs/buffer.hpp>
 #include <llfs/key.hpp>
 #include <llfs/page_device.hpp>
 #include <llfs/page_filter_policy.hpp>
 #include <llfs/slice.hpp>
+#include <llfs/status.hpp>
+#include <llfs/xor_filter.hpp>
+
+#include <batteries/case_of.hpp>
+
+#include <cstdint>
+#include <memory>
 
 namespace llfs {
 
+// Identifies the packed representation of a PageFilter (see PageFilter::packed_data); these values
+// are stored in PageFilterFile records, so they must not change.
+//
+enum struct PageFilterType : u8 {
+  kNull = 0,
+  kBloom = 1,
+  kXor = 2,
+};
+
 class PageFilter
 {
  public:
@@ -33,6 +50,19 @@ class PageFilter
 
   virtual bool might_contain_key(const KeyView& key) = 0;
 
+  // The type and packed representation of the filter, from which unpack_page_filter can recreate
+  // it.  Filters with nothing to store (e.g., NullPageFilter) return kNull and an empty buffer.
+  //
+  virtual PageFilterType filter_type() const
+  {
+    return PageFilterType::kNull;
+  }
+
+  virtual ConstBuffer packed_data() const
+  {
+    return ConstBuffer{nullptr, 0};
+  }
+
  protected:
   explicit PageFilter(PageId page_id) noexcept : page_id_{page_id} {};
 
@@ -61,15 +91,81 @@ class PageBloomFilter : public PageFilter
   static std::shared_ptr<PageBloomFilter> build(const BloomFilterParams& params, PageId page_id,
                                                 const GetKeyItems& items);
 
+  /** \brief `memory` must have PageBloomFilter::kAlignmentPadWords extra words (beyond the size of
+   * the filter), since the filter starts at the first 64-byte aligned address in it.
+   */
   explicit PageBloomFilter(PageId page_id, std::unique_ptr<u64[]> memory) noexcept;
 
   bool might_contain_key(const KeyView& key) override;
 
+  PageFilterType filter_type() const override
+  {
+    return PageFilterType::kBloom;
+  }
+
+  ConstBuffer packed_data() const override
+  {
+    return ConstBuffer{this->filter_, packed_sizeof(*this->filter_)};
+  }
+
+  // The filter is placed on a cache line boundary, so that each block of a
+  // BloomFilterLayout::kBlocked512 filter is one cache line.
+  //
+  static constexpr usize kAlignmentPadWords = 64 / sizeof(u64) - 1;
+
+  static PackedBloomFilter* aligned_filter(u64* memory)
+  {
+    return reinterpret_cast<PackedBloomFilter*>((reinterpret_cast<uintptr_t>(memory) + 63) &
+                                                ~uintptr_t{63});
+  }
+
  private:
   std::unique_ptr<u64[]> memory_;
   PackedBloomFilter* filter_;
 };
 
+// PageXorFilter: store an XOR filter for the page.  This takes less space than a PageBloomFilter
+// with the same false positive rate, and a query always reads exactly three fingerprints.
+//
+class PageXorFilter : public PageFilter
+{
+ public:
+  template <typename GetKeyItems>
+  static std::shared_ptr<PageXorFilter> build(const XorFilterParams& params, PageId page_id,
+                                              const GetKeyItems& items);
+
+  explicit PageXorFilter(PageId page_id, std::unique_ptr<u64[]> memory) noexcept;
+
+  bool might_contain_key(const KeyView& key) override;
+
+  PageFilterType filter_type() const override
+  {
+    return PageFilterType::kXor;
+  }
+
+  ConstBuffer packed_data() const override
+  {
+    return ConstBuffer{this->filter_, packed_sizeof(*this->filter_)};
+  }
+
+ private:
+  std::unique_ptr<u64[]> memory_;
+  PackedXorFilter* filter_;
+};
+
+// Recreates a filter for the given page from the output of PageFilter::filter_type() and
+// PageFilter::packed_data().  Returns StatusCode::kPageFilterBadData if `packed` isn't a valid
+// filter of the given type.
+//
+StatusOr<std::shared_ptr<PageFilter>> unpack_page_filter(PageId page_id, PageFilterType type,
+                                                         const ConstBuffer& packed);
+
+// Builds the filter for the given page and items specified by `policy`.
+//
+template <typename GetKeyItems>
+std::shared_ptr<PageFilter> build_page_filter(const PageFilterPolicy& policy, PageId page_id,
+                                              const GetKeyItems& items);
+
 //#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
 
 template <typename GetKeyItems>
@@ -79,8 +175,8 @@ template <typename GetKeyItems>
   const usize size = packed_sizeof_bloom_filter(params, items.size());
   const usize word_size = (size + sizeof(u64) - 1) / sizeof(u64);
   BATT_CHECK_EQ(word_size * sizeof(u64), size);
-  std::unique_ptr<u64[]> memory{new u64[word_size]};
-  auto filter = reinterpret_cast<PackedBloomFilter*>(memory.get());
+  std::unique_ptr<u64[]> memory{new u64[word_size + kAlignmentPadWords]};
+  PackedBloomFilter* const filter = aligned_filter(memory.get());
 
   filter->initialize(params, items.size());
 
@@ -90,6 +186,41 @@ template <typename GetKeyItems>
   return std::make_shared<PageBloomFilter>(page_id, std::move(memory));
 }
 
+template <typename GetKeyItems>
+/*static*/ inline std::shared_ptr<PageXorFilter> PageXorFilter::build(const XorFilterParams& params,
+                                                                      PageId page_id,
+                                                                      const GetKeyItems& items)
+{
+  const usize size = packed_sizeof_xor_filter(params, items.size());
+  const usize word_size = (size + sizeof(u64) - 1) / sizeof(u64);
+  std::unique_ptr<u64[]> memory{new u64[word_size]};
+  PackedXorFilter* const filter = reinterpret_cast<PackedXorFilter*>(memory.get());
+
+  filter->initialize(params, items.size());
+
+  parallel_build_xor_filter(batt::WorkerPool::default_pool(), std::begin(items), std::end(items),
+                            /*hash_fn=*/BATT_OVERLOADS_OF(get_key), filter);
+
+  return std::make_shared<PageXorFilter>(page_id, std::move(memory));
+}
+
+template <typename GetKeyItems>
+inline std::shared_ptr<PageFilter> build_page_filter(const PageFilterPolicy& policy, PageId page_id,
+                                                     const GetKeyItems& items)
+{
+  return batt::case_of(
+      policy,
+      [&](const batt::NoneType&) -> std::shared_ptr<PageFilter> {
+        return std::make_shared<NullPageFilter>(page_id);
+      },
+      [&](const BloomFilterParams& params) -> std::shared_ptr<PageFilter> {
+        return PageBloomFilter::build(params, page_id, items);
+      },
+      [&](const XorFilterParams& params) -> std::shared_ptr<PageFilter> {
+        return PageXorFilter::build(params, page_id, items);
+      });
+}
+
 }  // namespace llfs
 
 #endif  // LLFS_PAGE_FILTER_HPP
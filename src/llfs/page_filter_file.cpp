@@ -0,0 +1,294 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_filter_file.hpp>
+//
+
+#include <llfs/crc.hpp>
+#include <llfs/filesystem.hpp>
+#include <llfs/logging.hpp>
+#include <llfs/status_code.hpp>
+
+#include <batteries/checked_cast.hpp>
+#include <batteries/finally.hpp>
+#include <batteries/syscall_retry.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace llfs {
+
+namespace {
+
+// Don't bother compacting small files.
+//
+constexpr usize kMinRecordCountToCompact = 1024;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize record_size_for_data_size(usize data_size)
+{
+  return sizeof(PackedPageFilterRecordHeader) + (data_size + 7) / 8 * 8;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u32 record_crc32c(const PackedPageFilterRecordHeader& header, const void* data)
+{
+  PackedPageFilterRecordHeader header_without_crc = header;
+  header_without_crc.crc32c = 0;
+
+  return crc32c_extend(crc32c(&header_without_crc, sizeof(header_without_crc)), data,
+                       header.data_size);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Appends the record for `filter` (which must not be of type kNull) to `out`.
+//
+void pack_record(const PageFilter& filter, std::vector<u8>* out)
+{
+  const ConstBuffer data = filter.packed_data();
+
+  PackedPageFilterRecordHeader header;
+  std::memset(&header, 0, sizeof(header));
+
+  header.magic = PackedPageFilterRecordHeader::kMagic;
+  header.data_size = BATT_CHECKED_CAST(u32, data.size());
+  header.page_id = PackedPageId::from(filter.page_id());
+  header.filter_type = static_cast<u8>(filter.filter_type());
+  header.crc32c = record_crc32c(header, data.data());
+
+  const usize offset = out->size();
+  out->resize(offset + record_size_for_data_size(data.size()), 0);
+
+  std::memcpy(out->data() + offset, &header, sizeof(header));
+  std::memcpy(out->data() + offset + sizeof(header), data.data(), data.size());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Writes `filters` to a new file and renames it over `file_name`; returns the fd of the new file.
+//
+StatusOr<int> rewrite_file(const std::string& file_name,
+                           const std::vector<std::shared_ptr<PageFilter>>& filters, u64* end_offset)
+{
+  std::vector<u8> contents;
+  for (const std::shared_ptr<PageFilter>& filter : filters) {
+    if (filter != nullptr) {
+      pack_record(*filter, &contents);
+    }
+  }
+
+  const std::string tmp_file_name = file_name + ".tmp";
+
+  // A stale temporary file from an earlier failed attempt would make create_file_read_write fail.
+  //
+  delete_file(tmp_file_name).IgnoreError();
+
+  StatusOr<int> fd = create_file_read_write(tmp_file_name, OpenForAppend{false});
+  BATT_REQUIRE_OK(fd);
+
+  auto close_on_error = batt::finally([&] {
+    if (*fd != -1) {
+      close_fd(*fd).IgnoreError();
+    }
+  });
+
+  BATT_REQUIRE_OK(write_fd(*fd, ConstBuffer{contents.data(), contents.size()}, /*offset=*/0));
+
+  BATT_REQUIRE_OK(batt::status_from_retval(batt::syscall_retry([&] {
+    return ::fsync(*fd);
+  })));
+
+  BATT_REQUIRE_OK(batt::status_from_retval(batt::syscall_retry([&] {
+    return std::rename(/*from=*/tmp_file_name.c_str(), /*to=*/file_name.c_str());
+  })));
+
+  *end_offset = contents.size();
+
+  const int new_fd = *fd;
+  *fd = -1;
+  return new_fd;
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<std::unique_ptr<PageFilterFile>> PageFilterFile::open(
+    std::string_view file_name, const PageIdFactory& page_ids, PageFilterTable* table)
+{
+  BATT_CHECK_NOT_NULLPTR(table);
+
+  StatusOr<int> fd = open_file_read_write(file_name, OpenForAppend{false});
+  if (!fd.ok()) {
+    StatusOr<int> created_fd = create_file_read_write(file_name, OpenForAppend{false});
+    if (!created_fd.ok()) {
+      return fd.status();
+    }
+    fd = created_fd;
+  }
+
+  auto close_on_error = batt::finally([&] {
+    if (*fd != -1) {
+      close_fd(*fd).IgnoreError();
+    }
+  });
+
+  StatusOr<i64> file_size = sizeof_fd(*fd);
+  BATT_REQUIRE_OK(file_size);
+
+  std::unique_ptr<u8[]> buffer{new u8[std::max<i64>(*file_size, 1)]};
+  StatusOr<ConstBuffer> contents =
+      read_fd(*fd, MutableBuffer{buffer.get(), BATT_CHECKED_CAST(usize, *file_size)}, 0);
+  BATT_REQUIRE_OK(contents);
+
+  const u8* const data = static_cast<const u8*>(contents->data());
+  const usize size = contents->size();
+
+  // The newest filter found for each physical page.
+  //
+  std::vector<std::shared_ptr<PageFilter>> latest(page_ids.get_physical_page_count().value());
+
+  usize offset = 0;
+  usize record_count = 0;
+
+  while (offset + sizeof(PackedPageFilterRecordHeader) <= size) {
+    PackedPageFilterRecordHeader header;
+    std::memcpy(&header, data + offset, sizeof(header));
+
+    if (header.magic != PackedPageFilterRecordHeader::kMagic ||
+        offset + record_size_for_data_size(header.data_size) > size) {
+      break;
+    }
+
+    const u8* const filter_data = data + offset + sizeof(header);
+    if (record_crc32c(header, filter_data) != header.crc32c) {
+      break;
+    }
+
+    // The file is intact, but belongs to a different device.
+    //
+    const PageId page_id = header.page_id.unpack();
+    if (PageIdFactory::get_device_id(page_id) != page_ids.get_device_id() ||
+        page_ids.get_physical_page(page_id) >= page_ids.get_physical_page_count().value()) {
+      LLFS_LOG_ERROR() << "page filter file doesn't match the device: " << BATT_INSPECT(file_name)
+                       << BATT_INSPECT(page_id) << BATT_INSPECT(page_ids.get_device_id());
+      return ::llfs::make_status(StatusCode::kPageFilterBadData);
+    }
+
+    StatusOr<std::shared_ptr<PageFilter>> filter =
+        unpack_page_filter(page_id, static_cast<PageFilterType>(header.filter_type.value()),
+                           ConstBuffer{filter_data, header.data_size});
+    if (!filter.ok()) {
+      break;
+    }
+
+    std::shared_ptr<PageFilter>& newest = latest[page_ids.get_physical_page(page_id)];
+    if (newest == nullptr ||
+        page_ids.get_generation(newest->page_id()) <= page_ids.get_generation(page_id)) {
+      newest = std::move(*filter);
+    }
+
+    record_count += 1;
+    offset += record_size_for_data_size(header.data_size);
+  }
+
+  if (offset < size) {
+    LLFS_LOG_WARNING() << "truncating page filter file after the last valid record: "
+                       << BATT_INSPECT(file_name) << BATT_INSPECT(offset) << BATT_INSPECT(size);
+    BATT_REQUIRE_OK(truncate_fd(*fd, offset));
+  }
+  buffer = nullptr;
+
+  const usize live_count = std::count_if(latest.begin(), latest.end(),
+                                         [](const std::shared_ptr<PageFilter>& filter) {
+                                           return filter != nullptr;
+                                         });
+
+  std::string owned_file_name{file_name};
+  u64 end_offset = offset;
+
+  if (record_count >= kMinRecordCountToCompact && record_count > live_count * 2) {
+    StatusOr<int> new_fd = rewrite_file(owned_file_name, latest, &end_offset);
+    BATT_REQUIRE_OK(new_fd);
+
+    close_fd(*fd).IgnoreError();
+    *fd = *new_fd;
+    record_count = live_count;
+  }
+
+  for (std::shared_ptr<PageFilter>& filter : latest) {
+    if (filter != nullptr) {
+      table->update(std::move(filter));
+    }
+  }
+
+  LLFS_VLOG(1) << "opened page filter file: " << BATT_INSPECT(file_name)
+               << BATT_INSPECT(record_count) << BATT_INSPECT(live_count);
+
+  const int open_fd = *fd;
+  *fd = -1;
+
+  return {std::unique_ptr<PageFilterFile>{
+      new PageFilterFile{std::move(owned_file_name), open_fd, end_offset, record_count}}};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ PageFilterFile::PageFilterFile(std::string&& file_name, int fd, u64 end_offset,
+                                            usize record_count) noexcept
+    : file_name_{std::move(file_name)}
+    , fd_{fd}
+    , end_offset_{end_offset}
+    , record_count_{record_count}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageFilterFile::~PageFilterFile() noexcept
+{
+  close_fd(this->fd_).IgnoreError();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageFilterFile::append(const PageFilter& filter)
+{
+  if (filter.filter_type() == PageFilterType::kNull) {
+    return OkStatus();
+  }
+
+  std::vector<u8> record;
+  pack_record(filter, &record);
+
+  std::unique_lock<std::mutex> lock{this->mutex_};
+
+  BATT_REQUIRE_OK(write_fd(this->fd_, ConstBuffer{record.data(), record.size()},
+                           /*offset=*/this->end_offset_));
+
+  this->end_offset_ += record.size();
+  this->record_count_ += 1;
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize PageFilterFile::record_count() const
+{
+  std::unique_lock<std::mutex> lock{this->mutex_};
+
+  return this->record_count_;
+}
+
+}  // namespace llfs
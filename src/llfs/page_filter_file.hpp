@@ -0,0 +1,118 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_FILTER_FILE_HPP
+#define LLFS_PAGE_FILTER_FILE_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/packed_page_id.hpp>
+#include <llfs/page_filter.hpp>
+#include <llfs/page_filter_table.hpp>
+#include <llfs/page_id_factory.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/static_assert.hpp>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief The header of each record in a PageFilterFile; followed by `data_size` bytes of packed
+ * filter (see PageFilter::packed_data), then zero padding to the next multiple of 8 bytes.
+ */
+struct PackedPageFilterRecordHeader {
+  static constexpr u32 kMagic = 0x9f17e4c1;
+
+  little_u32 magic;
+
+  /** \brief The size of the packed filter (not including the padding).
+   */
+  little_u32 data_size;
+
+  /** \brief The page (including its generation) the filter was built for.
+   */
+  PackedPageId page_id;
+
+  /** \brief A PageFilterType value.
+   */
+  little_u8 filter_type;
+
+  little_u8 reserved_[3];
+
+  /** \brief The CRC32C of this header (with `crc32c` set to 0) followed by the filter data.
+   */
+  little_u32 crc32c;
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedPageFilterRecordHeader), 24);
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief An append-only file of the page filters built for a single PageDevice, so that they
+ * don't have to be rebuilt (by loading every page) after a restart.
+ *
+ * The whole file is read with a single sequential read when it is opened.  A record that doesn't
+ * pass its checks (e.g., because it was only partly written before a crash) ends the file; it and
+ * everything after it are truncated.  Records for older generations of a page are skipped when the
+ * file is loaded, and dropped by rewriting the file if they make up more than half of it.
+ *
+ * Appends aren't synced; losing the last few records in a crash only means that those filters
+ * have to be rebuilt.
+ */
+class PageFilterFile
+{
+ public:
+  /** \brief Opens (or creates) the filter file with the given name for the device whose pages are
+   * described by `page_ids`, and adds all the filters in it to `table`.
+   */
+  static StatusOr<std::unique_ptr<PageFilterFile>> open(std::string_view file_name,
+                                                        const PageIdFactory& page_ids,
+                                                        PageFilterTable* table);
+
+  PageFilterFile(const PageFilterFile&) = delete;
+  PageFilterFile& operator=(const PageFilterFile&) = delete;
+
+  ~PageFilterFile() noexcept;
+
+  /** \brief Appends a record for `filter` to the file.  Does nothing for filters of type
+   * PageFilterType::kNull.  Safe to call concurrently.
+   */
+  Status append(const PageFilter& filter);
+
+  /** \brief The number of records in the file.
+   */
+  usize record_count() const;
+
+ private:
+  explicit PageFilterFile(std::string&& file_name, int fd, u64 end_offset,
+                          usize record_count) noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const std::string file_name_;
+
+  const int fd_;
+
+  // Protects `end_offset_` and `record_count_`, and orders appends.
+  //
+  mutable std::mutex mutex_;
+
+  u64 end_offset_;
+
+  usize record_count_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_PAGE_FILTER_FILE_HPP
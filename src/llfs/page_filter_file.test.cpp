@@ -0,0 +1,249 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_filter_file.hpp>
+//
+#include <llfs/page_filter_file.hpp>
+
+#include <llfs/filesystem.hpp>
+#include <llfs/status_code.hpp>
+#include <llfs/xor_filter.hpp>
+
+#include <batteries/stream_util.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//
+//  1. (ReopenLoadsFilters) Filters appended to the file are loaded into the table when the file is
+//     reopened, and give the same answers; only the newest generation of each page is loaded.
+//  2. (TornTail) A partly written last record is truncated, and the records before it are kept.
+//  3. (Compaction) A file that is mostly records for old generations is rewritten to hold only the
+//     newest ones.
+//  4. (WrongDevice) Opening the file of another device fails.
+
+using llfs::PackedXorFilter;
+using llfs::PageCount;
+using llfs::PageFilter;
+using llfs::PageFilterFile;
+using llfs::PageFilterTable;
+using llfs::PageFilterType;
+using llfs::PageId;
+using llfs::PageIdFactory;
+using llfs::XorFilterParams;
+
+using namespace llfs::int_types;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+std::string make_key(u64 i)
+{
+  return batt::to_string("key_", i);
+}
+
+// Returns an XOR filter for `page_id` that contains the keys for the integers in [first, last).
+//
+std::shared_ptr<PageFilter> make_filter(PageId page_id, u64 first, u64 last)
+{
+  std::vector<u64> item_hashes;
+  for (u64 i = first; i < last; ++i) {
+    item_hashes.emplace_back(std::hash<llfs::KeyView>{}(make_key(i)));
+  }
+
+  std::vector<u8> memory(llfs::packed_sizeof_xor_filter(XorFilterParams{}, item_hashes.size()));
+  auto* filter = reinterpret_cast<PackedXorFilter*>(memory.data());
+  filter->initialize(XorFilterParams{}, item_hashes.size());
+  llfs::build_xor_filter_from_hashes(item_hashes, filter);
+
+  llfs::StatusOr<std::shared_ptr<PageFilter>> unpacked = llfs::unpack_page_filter(
+      page_id, PageFilterType::kXor, llfs::ConstBuffer{memory.data(), memory.size()});
+  BATT_CHECK_OK(unpacked);
+
+  return std::move(*unpacked);
+}
+
+class PageFilterFileTest : public ::testing::Test
+{
+ public:
+  void SetUp() override
+  {
+    llfs::delete_file(this->file_name).IgnoreError();
+    llfs::delete_file(this->file_name + ".tmp").IgnoreError();
+  }
+
+  void TearDown() override
+  {
+    llfs::delete_file(this->file_name).IgnoreError();
+  }
+
+  const std::string file_name = "/tmp/llfs_page_filter_file_test_file";
+
+  const PageIdFactory page_ids{PageCount{64}, /*page_device_id=*/2};
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+TEST_F(PageFilterFileTest, ReopenLoadsFilters)
+{
+  {
+    PageFilterTable table{this->page_ids};
+    auto file = PageFilterFile::open(this->file_name, this->page_ids, &table);
+    ASSERT_TRUE(file.ok()) << BATT_INSPECT(file.status());
+    EXPECT_EQ((*file)->record_count(), 0u);
+
+    for (u64 physical_page = 0; physical_page < 10; ++physical_page) {
+      ASSERT_TRUE((*file)
+                      ->append(*make_filter(this->page_ids.make_page_id(physical_page, 1),
+                                            physical_page * 1000, physical_page * 1000 + 500))
+                      .ok());
+    }
+
+    // Page 3 is rewritten, and its new filter is appended after the old one.
+    //
+    ASSERT_TRUE(
+        (*file)->append(*make_filter(this->page_ids.make_page_id(3, 2), 777000, 777500)).ok());
+
+    EXPECT_EQ((*file)->record_count(), 11u);
+  }
+
+  PageFilterTable table{this->page_ids};
+  auto file = PageFilterFile::open(this->file_name, this->page_ids, &table);
+  ASSERT_TRUE(file.ok()) << BATT_INSPECT(file.status());
+  EXPECT_EQ((*file)->record_count(), 11u);
+
+  for (u64 physical_page = 0; physical_page < 10; ++physical_page) {
+    const u64 generation = (physical_page == 3) ? 2 : 1;
+    const u64 first_item = (physical_page == 3) ? 777000 : physical_page * 1000;
+
+    std::shared_ptr<PageFilter> filter =
+        table.find(this->page_ids.make_page_id(physical_page, generation));
+    ASSERT_NE(filter, nullptr) << BATT_INSPECT(physical_page);
+    EXPECT_EQ(filter->filter_type(), PageFilterType::kXor);
+
+    for (u64 i = first_item; i < first_item + 500; ++i) {
+      ASSERT_TRUE(filter->might_contain_key(make_key(i))) << BATT_INSPECT(physical_page);
+    }
+  }
+  EXPECT_EQ(table.find(this->page_ids.make_page_id(3, 1)), nullptr);
+  EXPECT_EQ(table.find(this->page_ids.make_page_id(10, 1)), nullptr);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+TEST_F(PageFilterFileTest, TornTail)
+{
+  {
+    PageFilterTable table{this->page_ids};
+    auto file = PageFilterFile::open(this->file_name, this->page_ids, &table);
+    ASSERT_TRUE(file.ok()) << BATT_INSPECT(file.status());
+
+    ASSERT_TRUE((*file)->append(*make_filter(this->page_ids.make_page_id(0, 1), 0, 100)).ok());
+    ASSERT_TRUE((*file)->append(*make_filter(this->page_ids.make_page_id(1, 1), 0, 100)).ok());
+  }
+
+  // Chop off the end of the second record.
+  //
+  llfs::StatusOr<i64> full_size = llfs::sizeof_file(this->file_name);
+  ASSERT_TRUE(full_size.ok());
+  ASSERT_TRUE(llfs::truncate_file(this->file_name, *full_size - 5).ok());
+
+  {
+    PageFilterTable table{this->page_ids};
+    auto file = PageFilterFile::open(this->file_name, this->page_ids, &table);
+    ASSERT_TRUE(file.ok()) << BATT_INSPECT(file.status());
+
+    EXPECT_EQ((*file)->record_count(), 1u);
+    EXPECT_NE(table.find(this->page_ids.make_page_id(0, 1)), nullptr);
+    EXPECT_EQ(table.find(this->page_ids.make_page_id(1, 1)), nullptr);
+
+    // New records go after the last valid one.
+    //
+    ASSERT_TRUE((*file)->append(*make_filter(this->page_ids.make_page_id(2, 1), 0, 100)).ok());
+  }
+
+  PageFilterTable table{this->page_ids};
+  auto file = PageFilterFile::open(this->file_name, this->page_ids, &table);
+  ASSERT_TRUE(file.ok()) << BATT_INSPECT(file.status());
+
+  EXPECT_EQ((*file)->record_count(), 2u);
+  EXPECT_NE(table.find(this->page_ids.make_page_id(0, 1)), nullptr);
+  EXPECT_NE(table.find(this->page_ids.make_page_id(2, 1)), nullptr);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+TEST_F(PageFilterFileTest, Compaction)
+{
+  const usize kGenerations = 40;
+  {
+    PageFilterTable table{this->page_ids};
+    auto file = PageFilterFile::open(this->file_name, this->page_ids, &table);
+    ASSERT_TRUE(file.ok()) << BATT_INSPECT(file.status());
+
+    for (u64 generation = 1; generation <= kGenerations; ++generation) {
+      for (u64 physical_page = 0; physical_page < 64; ++physical_page) {
+        const PageId page_id = this->page_ids.make_page_id(physical_page, generation);
+        ASSERT_TRUE((*file)->append(*make_filter(page_id, generation, generation + 10)).ok());
+      }
+    }
+    EXPECT_EQ((*file)->record_count(), kGenerations * 64);
+  }
+
+  const llfs::StatusOr<i64> size_before = llfs::sizeof_file(this->file_name);
+  ASSERT_TRUE(size_before.ok());
+
+  {
+    PageFilterTable table{this->page_ids};
+    auto file = PageFilterFile::open(this->file_name, this->page_ids, &table);
+    ASSERT_TRUE(file.ok()) << BATT_INSPECT(file.status());
+
+    EXPECT_EQ((*file)->record_count(), 64u);
+  }
+
+  const llfs::StatusOr<i64> size_after = llfs::sizeof_file(this->file_name);
+  ASSERT_TRUE(size_after.ok());
+  EXPECT_EQ(*size_after * i64{kGenerations}, *size_before);
+
+  PageFilterTable table{this->page_ids};
+  auto file = PageFilterFile::open(this->file_name, this->page_ids, &table);
+  ASSERT_TRUE(file.ok()) << BATT_INSPECT(file.status());
+
+  for (u64 physical_page = 0; physical_page < 64; ++physical_page) {
+    std::shared_ptr<PageFilter> filter =
+        table.find(this->page_ids.make_page_id(physical_page, kGenerations));
+    ASSERT_NE(filter, nullptr);
+    EXPECT_TRUE(filter->might_contain_key(make_key(kGenerations)));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+TEST_F(PageFilterFileTest, WrongDevice)
+{
+  {
+    PageFilterTable table{this->page_ids};
+    auto file = PageFilterFile::open(this->file_name, this->page_ids, &table);
+    ASSERT_TRUE(file.ok()) << BATT_INSPECT(file.status());
+
+    ASSERT_TRUE((*file)->append(*make_filter(this->page_ids.make_page_id(0, 1), 0, 100)).ok());
+  }
+
+  const PageIdFactory other_page_ids{PageCount{64}, /*page_device_id=*/5};
+  PageFilterTable table{other_page_ids};
+  auto file = PageFilterFile::open(this->file_name, other_page_ids, &table);
+
+  EXPECT_EQ(file.status(), llfs::make_status(llfs::StatusCode::kPageFilterBadData));
+}
+
+}  // namespace
@@ -11,6 +11,7 @@
 #define LLFS_PAGE_FILTER_POLICY_HPP
 
 #include <llfs/bloom_filter.hpp>
+#include <llfs/xor_filter.hpp>
 
 #include <batteries/optional.hpp>
 
@@ -18,7 +19,8 @@
 
 namespace llfs {
 
-using PageFilterPolicy = std::variant<batt::NoneType, llfs::BloomFilterParams>;
+using PageFilterPolicy =
+    std::variant<batt::NoneType, llfs::BloomFilterParams, llfs::XorFilterParams>;
 
 }  // namespace llfs
 
@@ -0,0 +1,110 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_FILTER_TABLE_HPP
+#define LLFS_PAGE_FILTER_TABLE_HPP
+
+#include <llfs/atomic_shared_ptr.hpp>
+#include <llfs/int_types.hpp>
+#include <llfs/page_filter.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/page_id_factory.hpp>
+
+#include <batteries/assert.hpp>
+
+#include <memory>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// The most recently built PageFilter for each physical page of a PageDevice.
+//
+// Each physical page has its own atomic slot, so concurrent lookups and updates of different pages
+// never contend; there is no table-wide lock.  A slot may hold the filter of an older generation
+// of the page (e.g., if the page was rewritten before the new filter was built), so `find` checks
+// the PageId of the filter it loads.
+//
+class PageFilterTable
+{
+ public:
+  explicit PageFilterTable(const PageIdFactory& page_ids) noexcept
+      : page_ids_{page_ids}
+      , slots_{new Slot[page_ids.get_physical_page_count().value()]}
+  {
+  }
+
+  PageFilterTable(const PageFilterTable&) = delete;
+  PageFilterTable& operator=(const PageFilterTable&) = delete;
+
+  // Returns the filter for `page_id` (the exact generation), or nullptr if there isn't one.
+  //
+  std::shared_ptr<PageFilter> find(PageId page_id) const
+  {
+    std::shared_ptr<PageFilter> filter = this->slot_for(page_id).load();
+    if (filter == nullptr || filter->page_id() != page_id) {
+      return nullptr;
+    }
+    return filter;
+  }
+
+  // Stores `filter` in the slot of its page, unless the slot already holds the filter of a newer
+  // generation of the page.
+  //
+  void update(std::shared_ptr<PageFilter>&& filter)
+  {
+    BATT_CHECK_NOT_NULLPTR(filter);
+
+    const PageId page_id = filter->page_id();
+    const page_generation_int generation = this->page_ids_.get_generation(page_id);
+    Slot& slot = this->slot_for(page_id);
+
+    std::shared_ptr<PageFilter> observed = slot.load();
+    do {
+      if (observed != nullptr &&
+          this->page_ids_.get_generation(observed->page_id()) > generation) {
+        return;
+      }
+    } while (!slot.compare_exchange_weak(observed, filter));
+  }
+
+  // Drops the filter for `page_id` (if it is the one stored in the slot of its page).
+  //
+  void erase(PageId page_id)
+  {
+    Slot& slot = this->slot_for(page_id);
+
+    std::shared_ptr<PageFilter> observed = slot.load();
+    while (observed != nullptr && observed->page_id() == page_id) {
+      if (slot.compare_exchange_weak(observed, nullptr)) {
+        break;
+      }
+    }
+  }
+
+ private:
+  using Slot = AtomicSharedPtr<PageFilter>;
+
+  Slot& slot_for(PageId page_id) const
+  {
+    const i64 physical_page = this->page_ids_.get_physical_page(page_id);
+    BATT_CHECK_LT(physical_page, this->page_ids_.get_physical_page_count().value());
+
+    return this->slots_[physical_page];
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  PageIdFactory page_ids_;
+
+  std::unique_ptr<Slot[]> slots_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_PAGE_FILTER_TABLE_HPP
@@ -0,0 +1,85 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_filter_table.hpp>
+//
+#include <llfs/page_filter_table.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+// Test Plan:
+//
+//  1. (FindUpdateErase) A stored filter is found only by the exact PageId it was built for, and
+//     erase only removes the filter of the given generation.
+//  2. (StaleUpdateIgnored) Storing the filter of an older generation of a page doesn't replace the
+//     filter of a newer one.
+
+using llfs::NullPageFilter;
+using llfs::PageCount;
+using llfs::PageFilterTable;
+using llfs::PageId;
+using llfs::PageIdFactory;
+
+using namespace llfs::int_types;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+TEST(PageFilterTableTest, FindUpdateErase)
+{
+  const PageIdFactory page_ids{PageCount{16}, /*page_device_id=*/3};
+  PageFilterTable table{page_ids};
+
+  const PageId page_5_gen_1 = page_ids.make_page_id(5, 1);
+  const PageId page_5_gen_2 = page_ids.make_page_id(5, 2);
+  const PageId page_6_gen_1 = page_ids.make_page_id(6, 1);
+
+  EXPECT_EQ(table.find(page_5_gen_1), nullptr);
+
+  table.update(std::make_shared<NullPageFilter>(page_5_gen_1));
+
+  ASSERT_NE(table.find(page_5_gen_1), nullptr);
+  EXPECT_EQ(table.find(page_5_gen_1)->page_id(), page_5_gen_1);
+  EXPECT_EQ(table.find(page_5_gen_2), nullptr);
+  EXPECT_EQ(table.find(page_6_gen_1), nullptr);
+
+  table.erase(page_5_gen_2);
+  EXPECT_NE(table.find(page_5_gen_1), nullptr);
+
+  table.erase(page_5_gen_1);
+  EXPECT_EQ(table.find(page_5_gen_1), nullptr);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+TEST(PageFilterTableTest, StaleUpdateIgnored)
+{
+  const PageIdFactory page_ids{PageCount{16}, /*page_device_id=*/0};
+  PageFilterTable table{page_ids};
+
+  const PageId page_9_gen_3 = page_ids.make_page_id(9, 3);
+  const PageId page_9_gen_4 = page_ids.make_page_id(9, 4);
+
+  table.update(std::make_shared<NullPageFilter>(page_9_gen_4));
+  table.update(std::make_shared<NullPageFilter>(page_9_gen_3));
+
+  EXPECT_EQ(table.find(page_9_gen_3), nullptr);
+  ASSERT_NE(table.find(page_9_gen_4), nullptr);
+
+  // A newer generation replaces an older one.
+  //
+  const PageId page_9_gen_5 = page_ids.make_page_id(9, 5);
+  table.update(std::make_shared<NullPageFilter>(page_9_gen_5));
+
+  EXPECT_EQ(table.find(page_9_gen_4), nullptr);
+  EXPECT_NE(table.find(page_9_gen_5), nullptr);
+}
+
+}  // namespace
@@ -9,6 +9,13 @@
 #include <llfs/page_graph_node.hpp>
 //
 
+#include <boost/range/irange.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
 namespace llfs {
 
 namespace {
@@ -81,6 +88,24 @@ StatusOr<PinnedPage> PageGraphNodeBuilder::build(PageCacheJob& job) &&
   return job.pin_new(std::move(view), /*callers=*/0);
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<PageId> PageGraphNodeBuilder::build_uncached(PageCacheJob& job) &&
+{
+  BATT_CHECK_NOT_NULLPTR(this->packed_);
+  BATT_CHECK_NOT_NULLPTR(this->page_buffer_);
+
+  this->packed_ = nullptr;
+
+  BATT_ASSIGN_OK_RESULT(std::shared_ptr<PageGraphNodeView> view,
+                        PageGraphNodeView::make_shared(this->page_buffer_));
+
+  const PageId page_id = view->page_id();
+  BATT_REQUIRE_OK(job.write_new_page(std::move(view)));
+
+  return page_id;
+}
+
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 // class PageGraphNodeView
 
@@ -164,6 +189,16 @@ BoxedSeq<PageId> PageGraphNodeView::trace_refs() const /*override*/
   return as_seq(this->packed_->edges) | seq::map(BATT_OVERLOADS_OF(get_page_id)) | seq::boxed();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageGraphNodeView::append_refs(std::vector<PageId>* refs) const /*override*/
+{
+  refs->reserve(refs->size() + this->packed_->edges.size());
+  for (const PackedPageId& edge : this->packed_->edges) {
+    refs->emplace_back(get_page_id(edge));
+  }
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 void PageGraphNodeView::dump_to_ostream(std::ostream& out) const /*override*/
@@ -171,4 +206,169 @@ void PageGraphNodeView::dump_to_ostream(std::ostream& out) const /*override*/
   out << "PageGraphNode";
 }
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class CompactPageGraphNodeBuilder
+
+namespace {
+
+std::vector<u64> edge_values(const Slice<const PageId>& sorted_edges)
+{
+  std::vector<u64> values(sorted_edges.size());
+  std::transform(sorted_edges.begin(), sorted_edges.end(), values.begin(), [](PageId page_id) {
+    return page_id.int_value();
+  });
+  return values;
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ usize CompactPageGraphNodeBuilder::count_edges_that_fit(
+    const Slice<const PageId>& sorted_edges, PageSize page_size)
+{
+  const usize payload_size = PageBuffer::max_payload_size(page_size);
+  const std::vector<u64> values = edge_values(sorted_edges);
+
+  // The packed size only grows as edges are added, so binary search for the longest prefix that
+  // fits.
+  //
+  usize lower = 0;
+  usize upper = values.size() + 1;
+  while (upper - lower > 1) {
+    const usize mid = lower + (upper - lower) / 2;
+    if (packed_sizeof_sorted_u64s(as_slice(values.data(), mid)) <= payload_size) {
+      lower = mid;
+    } else {
+      upper = mid;
+    }
+  }
+  return lower;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<PinnedPage> CompactPageGraphNodeBuilder::build(
+    std::shared_ptr<PageBuffer>&& page_buffer, const Slice<const PageId>& sorted_edges,
+    PageCacheJob& job)
+{
+  BATT_CHECK_NOT_NULLPTR(page_buffer);
+
+  const std::vector<u64> values = edge_values(sorted_edges);
+  BATT_CHECK(std::is_sorted(values.begin(), values.end()))
+      << "CompactPageGraphNode edges must be sorted";
+
+  const usize packed_size = packed_sizeof_sorted_u64s(as_slice(values));
+  MutableBuffer payload = page_buffer->mutable_payload();
+  if (packed_size > payload.size()) {
+    return {batt::StatusCode::kResourceExhausted};
+  }
+
+  std::memset(payload.data(), 0, payload.size());
+  pack_sorted_u64s_to(MutableBuffer{payload.data(), packed_size}, as_slice(values));
+  {
+    PackedPageHeader* header = mutable_page_header(page_buffer.get());
+    header->layout_id = CompactPageGraphNodeView::page_layout_id();
+  }
+
+  BATT_ASSIGN_OK_RESULT(std::shared_ptr<CompactPageGraphNodeView> view,
+                        CompactPageGraphNodeView::make_shared(std::move(page_buffer)));
+
+  return job.pin_new(std::move(view), /*callers=*/0);
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class CompactPageGraphNodeView
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ PageLayoutId CompactPageGraphNodeView::page_layout_id()
+{
+  static const PageLayoutId id = PageLayoutId::from_str("grphcmpt");
+  return id;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ PageReader CompactPageGraphNodeView::page_reader()
+{
+  return [](std::shared_ptr<const PageBuffer> page_buffer)
+             -> StatusOr<std::shared_ptr<const PageView>> {
+    return {CompactPageGraphNodeView::make_shared(std::move(page_buffer))};
+  };
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ batt::Status CompactPageGraphNodeView::register_layout(PageCache& cache)
+{
+  return cache.register_page_reader(CompactPageGraphNodeView::page_layout_id(), __FILE__,
+                                    __LINE__, CompactPageGraphNodeView::page_reader());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<std::shared_ptr<CompactPageGraphNodeView>>
+CompactPageGraphNodeView::make_shared(std::shared_ptr<const PageBuffer>&& page_buffer)
+{
+  BATT_ASSIGN_OK_RESULT(
+      const PackedCompactPageGraphNode& packed_ref,
+      unpack_cast(page_buffer->const_payload(), batt::StaticType<PackedCompactPageGraphNode>{}));
+
+  return std::shared_ptr<CompactPageGraphNodeView>(
+      new CompactPageGraphNodeView{std::move(page_buffer), &packed_ref});
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ CompactPageGraphNodeView::CompactPageGraphNodeView(
+    std::shared_ptr<const PageBuffer>&& page_buffer,
+    const PackedCompactPageGraphNode* packed) noexcept
+    : PageView{std::move(page_buffer)}
+    , packed_{packed}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageLayoutId CompactPageGraphNodeView::get_page_layout_id() const /*override*/
+{
+  return CompactPageGraphNodeView::page_layout_id();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BoxedSeq<PageId> CompactPageGraphNodeView::trace_refs() const /*override*/
+{
+  return as_seq(boost::irange<usize>(0, this->edge_count()))  //
+         | seq::map([this](usize i) {
+             return this->get_edge(i);
+           })  //
+         | seq::boxed();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void CompactPageGraphNodeView::append_refs(std::vector<PageId>* refs) const /*override*/
+{
+  const PackedSortedU64s& edges = this->packed_->edges;
+
+  refs->reserve(refs->size() + edges.size());
+
+  std::array<u64, PackedSortedU64s::kBlockSize> block;
+  for (usize block_i = 0; block_i < edges.block_count(); ++block_i) {
+    const usize n = edges.unpack_block(block_i, block.data());
+    for (usize i = 0; i < n; ++i) {
+      refs->emplace_back(PageId{block[i]});
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void CompactPageGraphNodeView::dump_to_ostream(std::ostream& out) const /*override*/
+{
+  out << "CompactPageGraphNode{.edge_count=" << this->edge_count() << ",}";
+}
+
 }  //namespace llfs
@@ -15,10 +15,12 @@
 #include <llfs/optional.hpp>
 #include <llfs/packed_array.hpp>
 #include <llfs/packed_page_id.hpp>
+#include <llfs/packed_sorted_u64s.hpp>
 #include <llfs/page_cache_job.hpp>
 #include <llfs/page_filter.hpp>
 #include <llfs/page_view.hpp>
 #include <llfs/seq.hpp>
+#include <llfs/slice.hpp>
 #include <llfs/unpack_cast.hpp>
 
 #include <batteries/static_assert.hpp>
@@ -67,6 +69,11 @@ class PageGraphNodeBuilder
 
   StatusOr<PinnedPage> build(PageCacheJob& job) &&;
 
+  // Like `build`, but adds the page to the job via `PageCacheJob::write_new_page` (i.e., without
+  // inserting it into the cache), for bulk loading.  Returns the id of the new page.
+  //
+  StatusOr<PageId> build_uncached(PageCacheJob& job) &&;
+
  private:
   std::shared_ptr<PageBuffer> page_buffer_;
   MutableBuffer available_;
@@ -108,6 +115,18 @@ class PageGraphNodeView : public PageView
    */
   BoxedSeq<PageId> trace_refs() const override;
 
+  /** \brief Appends the ids of all pages directly referenced by this one to `*refs`.
+   */
+  void append_refs(std::vector<PageId>* refs) const override;
+
+  /** \brief Returns the edges of this page in place (without the allocation and virtual calls of
+   * `trace_refs()`).
+   */
+  Slice<const PackedPageId> edges() const
+  {
+    return as_slice(this->packed_->edges.data(), this->packed_->edges.size());
+  }
+
   /** \brief Returns the minimum key value contained within this page.
    */
   Optional<KeyView> min_key() const override
@@ -147,6 +166,129 @@ class PageGraphNodeView : public PageView
   const PackedPageGraphNode* packed_;
 };
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A compact page layout that references other pages by id: the edges are stored sorted,
+ * as a PackedSortedU64s (frame-of-reference compressed), so an index of the refs of many pages
+ * takes only a few bytes per edge instead of 8.
+ */
+struct PackedCompactPageGraphNode {
+  PackedSortedU64s edges;
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedCompactPageGraphNode), sizeof(PackedSortedU64s));
+
+inline usize packed_sizeof(const PackedCompactPageGraphNode& n)
+{
+  return packed_sizeof(n.edges);
+}
+
+inline Status validate_packed_value(const PackedCompactPageGraphNode& packed,
+                                    const void* buffer_data, usize buffer_size)
+{
+  return validate_packed_value(packed.edges, buffer_data, buffer_size);
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Builds CompactPageGraphNode pages from sorted edge lists, all at once.
+ */
+class CompactPageGraphNodeBuilder
+{
+ public:
+  /** \brief Returns the number of edges from the front of `sorted_edges` that fit in a page of the
+   * given size.
+   */
+  static usize count_edges_that_fit(const Slice<const PageId>& sorted_edges, PageSize page_size);
+
+  /** \brief Packs `sorted_edges` (which must be sorted by id value) into `page_buffer` and pins the
+   * new page to `job`.  Returns kResourceExhausted if the edges don't fit (see
+   * `count_edges_that_fit`).
+   */
+  static StatusOr<PinnedPage> build(std::shared_ptr<PageBuffer>&& page_buffer,
+                                    const Slice<const PageId>& sorted_edges, PageCacheJob& job);
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief PageView for CompactPageGraphNode pages.
+ */
+class CompactPageGraphNodeView : public PageView
+{
+ public:
+  /** \brief The page layout id for all instances of this class.
+   */
+  static PageLayoutId page_layout_id();
+
+  /** \brief Returns the PageReader for this layout.
+   */
+  static PageReader page_reader();
+
+  /** \brief Registers this page layout with the passed cache.
+   */
+  static batt::Status register_layout(PageCache& cache);
+
+  /** \brief Returns a shared instance of CompactPageGraphNodeView for the given page data.
+   * \return error status if the page is ill-formed
+   */
+  static StatusOr<std::shared_ptr<CompactPageGraphNodeView>> make_shared(
+      std::shared_ptr<const PageBuffer>&& page_buffer);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  PageLayoutId get_page_layout_id() const override;
+
+  BoxedSeq<PageId> trace_refs() const override;
+
+  /** \brief Decodes the edges straight into `*refs`, a block at a time.
+   */
+  void append_refs(std::vector<PageId>* refs) const override;
+
+  /** \brief The number of edges of this page.
+   */
+  usize edge_count() const
+  {
+    return this->packed_->edges.size();
+  }
+
+  /** \brief Returns edge `i` (in sorted order), which must be less than `edge_count()`.
+   */
+  PageId get_edge(usize i) const
+  {
+    return PageId{this->packed_->edges.get(i)};
+  }
+
+  /** \brief Returns the index of the first edge not less than `page_id` (or `edge_count()`).
+   */
+  usize lower_bound(PageId page_id) const
+  {
+    return this->packed_->edges.lower_bound(page_id.int_value());
+  }
+
+  Optional<KeyView> min_key() const override
+  {
+    return None;
+  }
+
+  Optional<KeyView> max_key() const override
+  {
+    return None;
+  }
+
+  std::shared_ptr<PageFilter> build_filter() const override
+  {
+    return std::make_shared<NullPageFilter>(this->page_id());
+  }
+
+  void dump_to_ostream(std::ostream& out) const override;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  explicit CompactPageGraphNodeView(std::shared_ptr<const PageBuffer>&& page_buffer,
+                                    const PackedCompactPageGraphNode* packed) noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const PackedCompactPageGraphNode* packed_;
+};
+
 }  //namespace llfs
 
 #endif  // LLFS_PAGE_GRAPH_NODE_HPP
@@ -0,0 +1,323 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_graph_node.hpp>
+//
+#include <llfs/page_graph_node.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/memory_page_cache.hpp>
+#include <llfs/opaque_page_view.hpp>
+#include <llfs/page_buffer.hpp>
+
+#include <batteries/async/runtime.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. A CompactPageGraphNode page built from sorted edges (clustered page ids, with duplicates)
+//     takes much less space than 8 bytes per edge; the edges can be read back via trace_refs,
+//     append_refs, get_edge and lower_bound, both from the built view and after the page is
+//     reloaded from its buffer.
+//  2. count_edges_that_fit returns the longest prefix that fits; build fails with
+//     kResourceExhausted if the edges don't fit.
+//  3. For every page view type (PageGraphNodeView, OpaquePageView, and a view that only implements
+//     trace_refs, which gets the default append_refs), append_refs appends exactly the ids that
+//     trace_refs returns, in the same order, after whatever is already in the vector.
+
+using namespace llfs::int_types;
+
+constexpr llfs::PageSize kTestPageSize{4096};
+
+class CompactPageGraphNodeTest : public ::testing::Test
+{
+ public:
+  void SetUp() override
+  {
+    llfs::StatusOr<batt::SharedPtr<llfs::PageCache>> page_cache_created =
+        llfs::make_memory_page_cache(batt::Runtime::instance().default_scheduler(),
+                                     /*arena_sizes=*/
+                                     {
+                                         {llfs::PageCount{4}, kTestPageSize},
+                                     },
+                                     llfs::MaxRefsPerPage{1024});
+
+    ASSERT_TRUE(page_cache_created.ok()) << BATT_INSPECT(page_cache_created.status());
+    this->page_cache = std::move(*page_cache_created);
+
+    ASSERT_TRUE(llfs::CompactPageGraphNodeView::register_layout(*this->page_cache).ok());
+
+    this->job = this->page_cache->new_job();
+  }
+
+  std::shared_ptr<llfs::PageBuffer> new_page_buffer()
+  {
+    llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer = this->job->new_page(
+        kTestPageSize, batt::WaitForResource::kFalse,
+        llfs::CompactPageGraphNodeView::page_layout_id(), llfs::Caller::Unknown,
+        /*cancel_token=*/llfs::None);
+
+    BATT_CHECK_OK(buffer);
+    return std::move(*buffer);
+  }
+
+  // Returns `count` sorted page ids spread over a small range (as the refs of an index page might
+  // be), including some duplicates.
+  //
+  std::vector<llfs::PageId> make_sorted_edges(usize count)
+  {
+    std::vector<llfs::PageId> edges;
+    for (usize i = 0; i < count; ++i) {
+      edges.emplace_back(llfs::PageId{(u64{3} << 56) | (this->rng() % 5000)});
+    }
+    std::sort(edges.begin(), edges.end(), [](const llfs::PageId& l, const llfs::PageId& r) {
+      return l.int_value() < r.int_value();
+    });
+    return edges;
+  }
+
+  batt::SharedPtr<llfs::PageCache> page_cache;
+  std::unique_ptr<llfs::PageCacheJob> job;
+  std::default_random_engine rng{7};
+};
+
+// A page view with a fixed list of refs that doesn't override append_refs.
+//
+class FakeRefsPageView : public llfs::PageView
+{
+ public:
+  explicit FakeRefsPageView(std::vector<llfs::PageId>&& refs) noexcept
+      : llfs::PageView{llfs::PageBuffer::allocate(kTestPageSize)}
+      , refs_{std::move(refs)}
+  {
+  }
+
+  llfs::PageLayoutId get_page_layout_id() const override
+  {
+    return llfs::OpaquePageView::page_layout_id();
+  }
+
+  llfs::BoxedSeq<llfs::PageId> trace_refs() const override
+  {
+    return llfs::as_seq(this->refs_) | llfs::seq::decayed() | llfs::seq::boxed();
+  }
+
+  llfs::Optional<llfs::KeyView> min_key() const override
+  {
+    return llfs::None;
+  }
+
+  llfs::Optional<llfs::KeyView> max_key() const override
+  {
+    return llfs::None;
+  }
+
+  std::shared_ptr<llfs::PageFilter> build_filter() const override
+  {
+    return nullptr;
+  }
+
+  void dump_to_ostream(std::ostream& out) const override
+  {
+    out << "FakeRefsPageView";
+  }
+
+ private:
+  std::vector<llfs::PageId> refs_;
+};
+
+// Checks that `view.append_refs` appends the same ids as `view.trace_refs`, after existing items.
+//
+void expect_append_refs_matches_trace_refs(const llfs::PageView& view)
+{
+  const std::vector<llfs::PageId> traced = view.trace_refs() | llfs::seq::collect_vec();
+
+  std::vector<llfs::PageId> appended{llfs::PageId{1}, llfs::PageId{2}};
+  view.append_refs(&appended);
+
+  ASSERT_EQ(appended.size(), traced.size() + 2);
+  EXPECT_EQ(appended[0], llfs::PageId{1});
+  EXPECT_EQ(appended[1], llfs::PageId{2});
+  EXPECT_TRUE(std::equal(appended.begin() + 2, appended.end(), traced.begin()));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST_F(CompactPageGraphNodeTest, BuildAndRead)
+{
+  const std::vector<llfs::PageId> edges = this->make_sorted_edges(1000);
+
+  std::shared_ptr<llfs::PageBuffer> buffer = this->new_page_buffer();
+  const llfs::PageId page_id = buffer->page_id();
+
+  llfs::StatusOr<llfs::PinnedPage> pinned = llfs::CompactPageGraphNodeBuilder::build(
+      std::move(buffer), llfs::as_slice(edges), *this->job);
+
+  ASSERT_TRUE(pinned.ok()) << BATT_INSPECT(pinned.status());
+  EXPECT_EQ(pinned->page_id(), page_id);
+
+  // 13 bits per delta (plus block headers) instead of 64 bits per edge.
+  //
+  const auto& packed = *static_cast<const llfs::PackedCompactPageGraphNode*>(
+      pinned->get_shared_view()->const_payload().data());
+  EXPECT_LT(llfs::packed_sizeof(packed), edges.size() * 2 + 512);
+
+  // Read the page both ways: through the view built by the builder, and from its buffer.
+  //
+  std::vector<std::shared_ptr<const llfs::CompactPageGraphNodeView>> views;
+  views.emplace_back(std::dynamic_pointer_cast<const llfs::CompactPageGraphNodeView>(
+      pinned->get_shared_view()));
+  views.emplace_back(BATT_OK_RESULT_OR_PANIC(
+      llfs::CompactPageGraphNodeView::make_shared(pinned->get_shared_view()->data())));
+
+  for (const auto& view : views) {
+    ASSERT_NE(view, nullptr);
+    EXPECT_EQ(view->get_page_layout_id(), llfs::CompactPageGraphNodeView::page_layout_id());
+    EXPECT_EQ(view->edge_count(), edges.size());
+
+    EXPECT_THAT(view->trace_refs() | llfs::seq::collect_vec(), ::testing::ElementsAreArray(edges));
+
+    std::vector<llfs::PageId> refs{llfs::PageId{1}};
+    view->append_refs(&refs);
+    ASSERT_EQ(refs.size(), edges.size() + 1);
+    EXPECT_EQ(refs.front(), llfs::PageId{1});
+    EXPECT_TRUE(std::equal(refs.begin() + 1, refs.end(), edges.begin()));
+
+    for (usize i = 0; i < edges.size(); i += 37) {
+      EXPECT_EQ(view->get_edge(i), edges[i]);
+
+      const usize expected = std::lower_bound(edges.begin(), edges.end(), edges[i],
+                                              [](const llfs::PageId& l, const llfs::PageId& r) {
+                                                return l.int_value() < r.int_value();
+                                              }) -
+                             edges.begin();
+      EXPECT_EQ(view->lower_bound(edges[i]), expected);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST_F(CompactPageGraphNodeTest, CountEdgesThatFit)
+{
+  // Spread the ids over the whole u64 range so the deltas need the full 64 bits.
+  //
+  std::vector<llfs::PageId> edges;
+  for (usize i = 0; i < 1000; ++i) {
+    edges.emplace_back(llfs::PageId{static_cast<u64>(this->rng()) << 32 | this->rng()});
+  }
+  std::sort(edges.begin(), edges.end(), [](const llfs::PageId& l, const llfs::PageId& r) {
+    return l.int_value() < r.int_value();
+  });
+
+  const usize n_fit =
+      llfs::CompactPageGraphNodeBuilder::count_edges_that_fit(llfs::as_slice(edges), kTestPageSize);
+
+  EXPECT_GT(n_fit, 0u);
+  EXPECT_LT(n_fit, edges.size());
+
+  EXPECT_EQ(llfs::CompactPageGraphNodeBuilder::build(this->new_page_buffer(),
+                                                     llfs::as_slice(edges), *this->job)
+                .status(),
+            batt::StatusCode::kResourceExhausted);
+
+  llfs::StatusOr<llfs::PinnedPage> pinned = llfs::CompactPageGraphNodeBuilder::build(
+      this->new_page_buffer(), llfs::as_slice(edges.data(), n_fit), *this->job);
+
+  ASSERT_TRUE(pinned.ok()) << BATT_INSPECT(pinned.status());
+
+  EXPECT_EQ(llfs::CompactPageGraphNodeBuilder::build(this->new_page_buffer(),
+                                                     llfs::as_slice(edges.data(), n_fit + 1),
+                                                     *this->job)
+                .status(),
+            batt::StatusCode::kResourceExhausted);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 3.
+//
+TEST_F(CompactPageGraphNodeTest, AppendRefsMatchesTraceRefs)
+{
+  ASSERT_TRUE(llfs::PageGraphNodeView::register_layout(*this->page_cache).ok());
+
+  // Unsorted, with duplicates, as the edges of a PageGraphNode may be.
+  //
+  const std::vector<llfs::PageId> edges{llfs::PageId{(u64{3} << 56) | 17},
+                                        llfs::PageId{(u64{3} << 56) | 4},
+                                        llfs::PageId{(u64{3} << 56) | 17},
+                                        llfs::PageId{(u64{3} << 56) | 900}};
+
+  // PageGraphNodeView, both as built and reloaded from its buffer.
+  //
+  {
+    llfs::StatusOr<llfs::PageGraphNodeBuilder> builder =
+        llfs::PageGraphNodeBuilder::from_new_page(this->job->new_page(
+            kTestPageSize, batt::WaitForResource::kFalse, llfs::PageGraphNodeView::page_layout_id(),
+            llfs::Caller::Unknown, /*cancel_token=*/llfs::None));
+    ASSERT_TRUE(builder.ok()) << BATT_INSPECT(builder.status());
+
+    for (const llfs::PageId& edge : edges) {
+      ASSERT_TRUE(builder->add_page(edge));
+    }
+
+    llfs::StatusOr<llfs::PinnedPage> pinned = std::move(*builder).build(*this->job);
+    ASSERT_TRUE(pinned.ok()) << BATT_INSPECT(pinned.status());
+
+    EXPECT_THAT(pinned->get_shared_view()->trace_refs() | llfs::seq::collect_vec(),
+                ::testing::ElementsAreArray(edges));
+    expect_append_refs_matches_trace_refs(*pinned->get_shared_view());
+
+    llfs::StatusOr<std::shared_ptr<llfs::PageGraphNodeView>> reloaded =
+        llfs::PageGraphNodeView::make_shared(pinned->get_shared_view()->data());
+    ASSERT_TRUE(reloaded.ok()) << BATT_INSPECT(reloaded.status());
+    expect_append_refs_matches_trace_refs(**reloaded);
+  }
+
+  // CompactPageGraphNodeView (see also test 1).
+  //
+  {
+    std::vector<llfs::PageId> sorted_edges = edges;
+    std::sort(sorted_edges.begin(), sorted_edges.end(),
+              [](const llfs::PageId& l, const llfs::PageId& r) {
+                return l.int_value() < r.int_value();
+              });
+
+    llfs::StatusOr<llfs::PinnedPage> pinned = llfs::CompactPageGraphNodeBuilder::build(
+        this->new_page_buffer(), llfs::as_slice(sorted_edges), *this->job);
+    ASSERT_TRUE(pinned.ok()) << BATT_INSPECT(pinned.status());
+
+    expect_append_refs_matches_trace_refs(*pinned->get_shared_view());
+  }
+
+  // OpaquePageView has no refs.
+  //
+  {
+    llfs::OpaquePageView view{llfs::PageBuffer::allocate(kTestPageSize)};
+
+    EXPECT_THAT(view.trace_refs() | llfs::seq::collect_vec(), ::testing::IsEmpty());
+    expect_append_refs_matches_trace_refs(view);
+  }
+
+  // The default append_refs (collecting trace_refs).
+  //
+  {
+    FakeRefsPageView view{batt::make_copy(edges)};
+
+    expect_append_refs_matches_trace_refs(view);
+  }
+}
+
+}  // namespace
@@ -18,6 +18,7 @@
 #include <batteries/assert.hpp>
 #include <batteries/checked_cast.hpp>
 #include <batteries/math.hpp>
+#include <batteries/utility.hpp>
 
 #include <boost/operators.hpp>
 
@@ -52,6 +53,10 @@ constexpr page_id_int kPageDeviceIdMask = ((page_id_int{1} << kPageDeviceIdBits)
 // |<-- kPageDeviceIdBits -->|<-- log_2(Max-Generation-Count) -->|<- log_2(Physical-Page-Count) ->|
 // +-------------------------+-----------------------------------+--------------------------------+
 //
+// Since the layout depends on the device capacity, a device that may grow later must be given a
+// PageIdFactory for its maximum (reserved) capacity from the start, even though only a prefix of
+// its pages is in service (see PageAllocator::grow).
+//
 class PageIdFactory : public boost::equality_comparable<PageIdFactory>
 {
  public:
@@ -77,6 +82,13 @@ class PageIdFactory : public boost::equality_comparable<PageIdFactory>
     return PageCount{this->capacity_};
   }
 
+  /** \brief The number of low-order bits of a page id that hold the physical page number.
+   */
+  u8 capacity_bits() const
+  {
+    return this->capacity_bits_;
+  }
+
   PageId make_page_id(page_id_int physical_page, page_generation_int generation) const
   {
     BATT_CHECK_LT(physical_page, this->capacity_);
@@ -148,6 +160,117 @@ class PageIdFactory : public boost::equality_comparable<PageIdFactory>
   u64 generation_mask_ = ~(kPageDeviceIdMask | this->physical_page_mask_);
 };
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A PageIdFactory whose capacity bits (see PageIdFactory::capacity_bits) are a compile-time
+ * constant, so the masks and shifts used to encode and decode page ids are constant-folded.
+ *
+ * Has the same interface as PageIdFactory (minus capacity_bits/equality); use
+ * `with_static_page_id_factory` to dispatch once to the right instantiation for a given
+ * PageIdFactory, then do the per-page work inside the passed function.
+ */
+template <u8 kCapacityBits>
+class StaticPageIdFactory
+{
+ public:
+  static_assert(sizeof(page_id_int) * 8 - kPageDeviceIdBits - kCapacityBits >=
+                    PageIdFactory::kMinGenerationBits,
+                "Not enough bits left for the page generation");
+
+  static constexpr u64 kPhysicalPageMask = (u64{1} << kCapacityBits) - 1;
+  static constexpr u64 kGenerationMask = ~(kPageDeviceIdMask | kPhysicalPageMask);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  explicit StaticPageIdFactory(const PageIdFactory& page_ids) noexcept
+      : capacity_{page_ids.get_physical_page_count().value()}
+      , device_id_{page_ids.get_device_id()}
+      , device_id_prefix_{(this->device_id_ << kPageDeviceIdShift) & kPageDeviceIdMask}
+  {
+    BATT_CHECK_EQ(page_ids.capacity_bits(), kCapacityBits);
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  PageCount get_physical_page_count() const
+  {
+    return PageCount{this->capacity_};
+  }
+
+  PageId make_page_id(page_id_int physical_page, page_generation_int generation) const
+  {
+    BATT_CHECK_LT(physical_page, this->capacity_);
+    return PageId{this->device_id_prefix_                                   //
+                  | ((u64{generation} << kCapacityBits) & kGenerationMask)  //
+                  | (u64{physical_page} & kPhysicalPageMask)};
+  }
+
+  PageId advance_generation(PageId id) const
+  {
+    return this->make_page_id(this->get_physical_page(id), this->get_generation(id) + 1);
+  }
+
+  static constexpr page_id_int max_generation_count()
+  {
+    return kGenerationMask >> kCapacityBits;
+  }
+
+  static i64 get_physical_page(PageId id)
+  {
+    return id.int_value() & kPhysicalPageMask;
+  }
+
+  static page_generation_int get_generation(PageId id)
+  {
+    return (id.int_value() & kGenerationMask) >> kCapacityBits;
+  }
+
+  static page_device_id_int get_device_id(PageId id)
+  {
+    return PageIdFactory::get_device_id(id);
+  }
+
+  page_device_id_int get_device_id() const
+  {
+    return this->device_id_;
+  }
+
+  static bool generation_less_than(page_generation_int first_gen, page_generation_int second_gen)
+  {
+    const auto delta = second_gen - first_gen;
+    return delta != 0 && delta < max_generation_count() / 2;
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  page_id_int capacity_;
+  page_device_id_int device_id_;
+  page_id_int device_id_prefix_;
+};
+
+/** \brief Invokes `fn` with a StaticPageIdFactory equivalent to `page_ids`, or with `page_ids`
+ * itself if there is no instantiation for its capacity bits.  `fn` must return the same type for
+ * every factory type.
+ */
+template <typename Fn>
+inline decltype(auto) with_static_page_id_factory(const PageIdFactory& page_ids, Fn&& fn)
+{
+  switch (page_ids.capacity_bits()) {
+    case 4:
+      return BATT_FORWARD(fn)(StaticPageIdFactory<4>{page_ids});
+    case 8:
+      return BATT_FORWARD(fn)(StaticPageIdFactory<8>{page_ids});
+    case 12:
+      return BATT_FORWARD(fn)(StaticPageIdFactory<12>{page_ids});
+    case 16:
+      return BATT_FORWARD(fn)(StaticPageIdFactory<16>{page_ids});
+    case 20:
+      return BATT_FORWARD(fn)(StaticPageIdFactory<20>{page_ids});
+    default:
+      break;
+  }
+  return BATT_FORWARD(fn)(page_ids);
+}
+
 }  // namespace llfs
 
 #endif  // LLFS_PAGE_ID_FACTORY_HPP
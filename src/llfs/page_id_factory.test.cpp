@@ -0,0 +1,101 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_id_factory.hpp>
+//
+#include <llfs/page_id_factory.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. For each capacity that with_static_page_id_factory specializes, the StaticPageIdFactory
+//     it passes encodes and decodes page ids exactly like the PageIdFactory.
+//  2. with_static_page_id_factory picks the instantiation matching the factory's capacity bits.
+
+using namespace llfs::int_types;
+
+using llfs::PageCount;
+using llfs::PageId;
+using llfs::PageIdFactory;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST(PageIdFactoryTest, StaticMatchesDynamic)
+{
+  for (u64 capacity : {u64{1}, u64{7}, u64{16}, u64{100}, u64{4096}, u64{4097}, u64{65536}}) {
+    const PageIdFactory page_ids{PageCount{capacity}, /*page_device_id=*/5};
+
+    const bool specialized = llfs::with_static_page_id_factory(page_ids, [&](const auto& ids) {
+      using IdsT = std::decay_t<decltype(ids)>;
+
+      EXPECT_EQ(ids.get_physical_page_count(), page_ids.get_physical_page_count());
+      EXPECT_EQ(ids.get_device_id(), page_ids.get_device_id());
+      EXPECT_EQ(ids.max_generation_count(), page_ids.max_generation_count());
+
+      for (u64 physical_page : {u64{0}, capacity / 2, capacity - 1}) {
+        for (u64 generation : {u64{0}, u64{1}, u64{12345}, page_ids.max_generation_count()}) {
+          const PageId expected = page_ids.make_page_id(physical_page, generation);
+          const PageId actual = ids.make_page_id(physical_page, generation);
+
+          EXPECT_EQ(actual, expected) << BATT_INSPECT(capacity) << BATT_INSPECT(generation);
+          EXPECT_EQ(ids.get_physical_page(actual), page_ids.get_physical_page(expected));
+          EXPECT_EQ(ids.get_generation(actual), page_ids.get_generation(expected));
+          EXPECT_EQ(IdsT::get_device_id(actual), PageIdFactory::get_device_id(expected));
+          EXPECT_EQ(ids.advance_generation(actual), page_ids.advance_generation(expected));
+          EXPECT_EQ(ids.generation_less_than(generation, generation + 1),
+                    page_ids.generation_less_than(generation, generation + 1));
+        }
+      }
+
+      return !std::is_same_v<IdsT, PageIdFactory>;
+    });
+
+    EXPECT_TRUE(specialized) << BATT_INSPECT(capacity) << BATT_INSPECT(page_ids.capacity_bits());
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST(PageIdFactoryTest, DispatchByCapacityBits)
+{
+  // Capacity bits are log2_ceil(capacity) rounded up to a multiple of 4, plus 4 (see
+  // PageIdFactory).
+  //
+  const std::vector<std::pair<u64, u8>> cases = {
+      {1, 4},     {16, 8},     {17, 12},    {256, 12},
+      {257, 16},  {4096, 16},  {4097, 20},  {65536, 20},
+  };
+
+  for (const auto& [capacity, expected_bits] : cases) {
+    const PageIdFactory page_ids{PageCount{capacity}, /*page_device_id=*/1};
+    ASSERT_EQ(page_ids.capacity_bits(), expected_bits) << BATT_INSPECT(capacity);
+
+    const u64 physical_page_mask =
+        llfs::with_static_page_id_factory(page_ids, [](const auto& ids) -> u64 {
+          using IdsT = std::decay_t<decltype(ids)>;
+          if constexpr (std::is_same_v<IdsT, PageIdFactory>) {
+            return 0;
+          } else {
+            return IdsT::kPhysicalPageMask;
+          }
+        });
+
+    EXPECT_EQ(physical_page_mask, (u64{1} << expected_bits) - 1) << BATT_INSPECT(capacity);
+  }
+}
+
+}  // namespace
@@ -0,0 +1,392 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_io_scheduler.hpp>
+//
+
+#include <batteries/assert.hpp>
+
+#include <algorithm>
+
+namespace llfs {
+
+namespace {
+
+// Virtual times are in units of 1/kWeightScale bytes, so that small costs with large weights
+// don't round down to nothing.
+//
+constexpr u64 kWeightScale = 1024;
+
+PageIoTag& thread_page_io_tag() noexcept
+{
+  thread_local PageIoTag tag;
+  return tag;
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, PageIoClass t)
+{
+  switch (t) {
+    case PageIoClass::kLatencySensitive:
+      return out << "LatencySensitive";
+    case PageIoClass::kBulk:
+      return out << "Bulk";
+  }
+  return out << "(bad:PageIoClass)" << (int)t;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, const PageIoTag& t)
+{
+  return out << "PageIoTag{.tenant=" << t.tenant << ", .io_class=" << t.io_class << ",}";
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class ScopedPageIoTag
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ const PageIoTag& ScopedPageIoTag::current() noexcept
+{
+  return thread_page_io_tag();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ ScopedPageIoTag::ScopedPageIoTag(const PageIoTag& tag) noexcept
+    : saved_{thread_page_io_tag()}
+{
+  thread_page_io_tag() = tag;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+ScopedPageIoTag::~ScopedPageIoTag() noexcept
+{
+  thread_page_io_tag() = this->saved_;
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class PageIoScheduler
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ PageIoScheduler::PageIoScheduler(const Options& options) noexcept : options_{options}
+{
+  BATT_CHECK_GT(this->options_.max_in_flight, 0u);
+  BATT_CHECK_GT(this->options_.max_bulk_in_flight, 0u);
+  BATT_CHECK_GT(this->options_.bulk_dispatch_interval, 0u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageIoScheduler::set_tenant_weight(u32 tenant, u32 weight)
+{
+  BATT_CHECK_GT(weight, 0u);
+
+  std::unique_lock<std::mutex> lock{this->mutex_};
+
+  this->tenant_weight_[tenant] = weight;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageIoScheduler::submit(const PageIoTag& tag, u64 cost, usize units, StartFn&& start)
+{
+  BATT_CHECK_LT((usize)tag.io_class, kNumPageIoClasses);
+  {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+
+    u64 weight = 1;
+    {
+      auto iter = this->tenant_weight_.find(tag.tenant);
+      if (iter != this->tenant_weight_.end()) {
+        weight = iter->second;
+      }
+    }
+
+    ClassQueue& queue = this->queues_[(usize)tag.io_class];
+    u64& last_finish_time = queue.last_finish_time[tag.tenant];
+
+    const u64 start_time = std::max(queue.virtual_time, last_finish_time);
+    last_finish_time = start_time + std::max<u64>(1, cost * kWeightScale / weight);
+
+    queue.heap.emplace_back(QueuedIo{
+        .finish_time = last_finish_time,
+        .seq = this->next_seq_++,
+        .units = units,
+        .submit_time = std::chrono::steady_clock::now(),
+        .start = std::move(start),
+    });
+    std::push_heap(queue.heap.begin(), queue.heap.end(), LaterFinish{});
+  }
+
+  this->dispatch();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageIoScheduler::finish(PageIoClass io_class, usize units)
+{
+  {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+
+    ClassQueue& queue = this->queues_[(usize)io_class];
+
+    BATT_CHECK_GE(queue.in_flight, units);
+    BATT_CHECK_GE(this->in_flight_, units);
+
+    queue.in_flight -= units;
+    this->in_flight_ -= units;
+  }
+
+  this->dispatch();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize PageIoScheduler::queued_count() const
+{
+  std::unique_lock<std::mutex> lock{this->mutex_};
+
+  return this->queues_[0].heap.size() + this->queues_[1].heap.size();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize PageIoScheduler::in_flight_count() const
+{
+  std::unique_lock<std::mutex> lock{this->mutex_};
+
+  return this->in_flight_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+int PageIoScheduler::next_class_locked() const
+{
+  const auto fits = [this](const ClassQueue& queue, usize class_limit) {
+    if (queue.heap.empty()) {
+      return false;
+    }
+    const usize units = queue.heap.front().units;
+    return (this->in_flight_ == 0 || this->in_flight_ + units <= this->options_.max_in_flight) &&
+           (queue.in_flight == 0 || queue.in_flight + units <= class_limit);
+  };
+
+  const bool latency_ready =
+      fits(this->queues_[(usize)PageIoClass::kLatencySensitive], this->options_.max_in_flight);
+
+  const bool bulk_ready =
+      fits(this->queues_[(usize)PageIoClass::kBulk], this->options_.max_bulk_in_flight);
+
+  if (latency_ready &&
+      (!bulk_ready || this->dispatches_since_bulk_ + 1 < this->options_.bulk_dispatch_interval)) {
+    return (int)PageIoClass::kLatencySensitive;
+  }
+  if (bulk_ready) {
+    return (int)PageIoClass::kBulk;
+  }
+  return -1;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageIoScheduler::dispatch()
+{
+  std::unique_lock<std::mutex> lock{this->mutex_};
+
+  if (this->dispatching_) {
+    return;
+  }
+  this->dispatching_ = true;
+
+  for (;;) {
+    const int i = this->next_class_locked();
+    if (i < 0) {
+      break;
+    }
+
+    ClassQueue& queue = this->queues_[i];
+
+    std::pop_heap(queue.heap.begin(), queue.heap.end(), LaterFinish{});
+    QueuedIo next = std::move(queue.heap.back());
+    queue.heap.pop_back();
+
+    queue.virtual_time = std::max(queue.virtual_time, next.finish_time);
+    queue.in_flight += next.units;
+    this->in_flight_ += next.units;
+
+    if (i == (int)PageIoClass::kBulk) {
+      this->dispatches_since_bulk_ = 0;
+    } else {
+      this->dispatches_since_bulk_ += 1;
+    }
+
+    // Start the I/O without holding the lock, since it may complete (and call `finish`) right
+    // away.
+    //
+    lock.unlock();
+
+    this->metrics_.dispatch_count[i].add(1);
+    this->metrics_.queue_latency[i].update(next.submit_time);
+
+    next.start();
+
+    lock.lock();
+  }
+
+  this->dispatching_ = false;
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class ScheduledPageDevice
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ ScheduledPageDevice::ScheduledPageDevice(std::shared_ptr<PageIoScheduler> scheduler,
+                                                      std::unique_ptr<PageDevice> device) noexcept
+    : scheduler_{std::move(scheduler)}
+    , device_{std::move(device)}
+    , page_size_{this->device_->page_size()}
+{
+  BATT_CHECK_NOT_NULLPTR(this->scheduler_);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageIdFactory ScheduledPageDevice::page_ids()
+{
+  return this->device_->page_ids();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageSize ScheduledPageDevice::page_size()
+{
+  return this->page_size_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status ScheduledPageDevice::enable_registered_page_buffers(usize buffer_count)
+{
+  return this->device_->enable_registered_page_buffers(buffer_count);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool ScheduledPageDevice::prefetch_hint(PageId id)
+{
+  return this->device_->prefetch_hint(id);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::shared_ptr<PageBuffer>> ScheduledPageDevice::prepare(PageId page_id)
+{
+  return this->device_->prepare(page_id);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void ScheduledPageDevice::write(std::shared_ptr<const PageBuffer>&& page_buffer,
+                                WriteHandler&& handler)
+{
+  const PageIoTag tag = ScopedPageIoTag::current();
+
+  this->scheduler_->submit(
+      tag, get_page_size(this->page_size_), /*units=*/1,
+      [this, tag, page_buffer = std::move(page_buffer), handler = std::move(handler)]() mutable {
+        this->device_->write(std::move(page_buffer), [scheduler = this->scheduler_, tag,
+                                                      handler = std::move(handler)](
+                                                         Status status) mutable {
+          scheduler->finish(tag.io_class, 1);
+          handler(status);
+        });
+      });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void ScheduledPageDevice::read(PageId page_id, ReadHandler&& handler)
+{
+  const PageIoTag tag = ScopedPageIoTag::current();
+
+  this->scheduler_->submit(
+      tag, get_page_size(this->page_size_), /*units=*/1,
+      [this, tag, page_id, handler = std::move(handler)]() mutable {
+        this->device_->read(page_id, [scheduler = this->scheduler_, tag,
+                                      handler = std::move(handler)](ReadResult&& result) mutable {
+          scheduler->finish(tag.io_class, 1);
+          handler(std::move(result));
+        });
+      });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void ScheduledPageDevice::read_batch(const batt::Slice<const PageId>& ids,
+                                     std::vector<ReadHandler>&& handlers)
+{
+  BATT_CHECK_EQ(ids.size(), handlers.size());
+
+  if (ids.empty()) {
+    return;
+  }
+
+  const PageIoTag tag = ScopedPageIoTag::current();
+
+  // Each page releases its part of the in-flight limit as it completes.
+  //
+  for (ReadHandler& handler : handlers) {
+    handler = [scheduler = this->scheduler_, tag,
+               handler = std::move(handler)](ReadResult&& result) mutable {
+      scheduler->finish(tag.io_class, 1);
+      handler(std::move(result));
+    };
+  }
+
+  this->scheduler_->submit(tag, get_page_size(this->page_size_) * ids.size(),
+                           /*units=*/ids.size(),
+                           [this, ids = std::vector<PageId>(ids.begin(), ids.end()),
+                            handlers = std::move(handlers)]() mutable {
+                             this->device_->read_batch(as_slice(ids), std::move(handlers));
+                           });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void ScheduledPageDevice::read_tail(PageId page_id, usize byte_count, ReadTailHandler&& handler)
+{
+  const PageIoTag tag = ScopedPageIoTag::current();
+
+  this->scheduler_->submit(
+      tag, std::min<u64>(byte_count, get_page_size(this->page_size_)), /*units=*/1,
+      [this, tag, page_id, byte_count, handler = std::move(handler)]() mutable {
+        this->device_->read_tail(page_id, byte_count,
+                                 [scheduler = this->scheduler_, tag,
+                                  handler = std::move(handler)](ReadTailResult&& result) mutable {
+                                   scheduler->finish(tag.io_class, 1);
+                                   handler(std::move(result));
+                                 });
+      });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void ScheduledPageDevice::drop(PageId page_id, WriteHandler&& handler)
+{
+  this->device_->drop(page_id, std::move(handler));
+}
+
+}  // namespace llfs
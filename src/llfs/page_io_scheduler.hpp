@@ -0,0 +1,302 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_IO_SCHEDULER_HPP
+#define LLFS_PAGE_IO_SCHEDULER_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/metrics.hpp>
+#include <llfs/page_device.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/status.hpp>
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace llfs {
+
+// The service class of a page I/O (see PageIoScheduler).
+//
+enum struct PageIoClass : u8 {
+  // I/O that a caller is waiting on (e.g., point reads); the default.
+  //
+  kLatencySensitive = 0,
+
+  // I/O for scans, compaction, recycling, etc., for which throughput matters more than latency.
+  //
+  kBulk = 1,
+};
+
+constexpr usize kNumPageIoClasses = 2;
+
+std::ostream& operator<<(std::ostream& out, PageIoClass t);
+
+/** \brief Identifies who a page I/O is being done for, for scheduling purposes.
+ */
+struct PageIoTag {
+  /** \brief A caller-chosen id (e.g., one per Volume); I/O bandwidth is shared fairly between
+   * tenants in proportion to their weights (PageIoScheduler::set_tenant_weight).
+   */
+  u32 tenant = 0;
+
+  PageIoClass io_class = PageIoClass::kLatencySensitive;
+};
+
+std::ostream& operator<<(std::ostream& out, const PageIoTag& t);
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Sets the PageIoTag of the I/O started by the current thread for the lifetime of this
+ * object (restoring the previous tag when it goes out of scope).
+ *
+ * The tag is captured when a ScheduledPageDevice function is called, so it only needs to be set
+ * around the call that starts the I/O (e.g., PageCache::get_page).  Because the tag is
+ * thread-local, a ScopedPageIoTag must not be held across a point where the current task may be
+ * suspended (other tasks on the same thread would see it).
+ */
+class ScopedPageIoTag
+{
+ public:
+  /** \brief Returns the tag of the current thread; PageIoTag{} if none has been set.
+   */
+  static const PageIoTag& current() noexcept;
+
+  explicit ScopedPageIoTag(const PageIoTag& tag) noexcept;
+
+  ScopedPageIoTag(const ScopedPageIoTag&) = delete;
+  ScopedPageIoTag& operator=(const ScopedPageIoTag&) = delete;
+
+  ~ScopedPageIoTag() noexcept;
+
+ private:
+  const PageIoTag saved_;
+};
+
+struct PageIoSchedulerOptions {
+  /** \brief The maximum number of page I/Os (over all devices sharing the scheduler) that may be
+   * in flight at once; the rest are queued until one completes.
+   */
+  usize max_in_flight = 64;
+
+  /** \brief The maximum number of kBulk I/Os that may be in flight at once, so that some queue
+   * depth is always left for latency-sensitive I/O.
+   */
+  usize max_bulk_in_flight = 48;
+
+  /** \brief When both classes have queued I/O, one of every this many dispatches goes to kBulk, so
+   * that bulk I/O is never starved completely.  Must be non-zero.
+   */
+  usize bulk_dispatch_interval = 8;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Orders the page I/O of several tenants sharing the same devices (or the same IoRing),
+ * and bounds the number of I/Os in flight.
+ *
+ * Each PageIoClass has its own queue.  Within a class, I/Os are dispatched in order of their
+ * virtual finish time (self-clocked fair queueing): an I/O of `cost` bytes from a tenant with
+ * weight `w` finishes `cost / w` after the later of the tenant's previous I/O and the current
+ * virtual time of the class (the finish time of the I/O last dispatched from it).  A tenant that
+ * submits many I/Os at once (e.g., a scan) therefore only gets its share of the dispatches, and
+ * another tenant's point read goes ahead of most of them.
+ *
+ * Between classes, kLatencySensitive I/O goes first, except for one of every
+ * `bulk_dispatch_interval` dispatches when both are waiting; kBulk I/O is also limited to
+ * `max_bulk_in_flight`.
+ *
+ * The scheduler is used through ScheduledPageDevice, which wraps each device that shares it.
+ */
+class PageIoScheduler
+{
+ public:
+  using Options = PageIoSchedulerOptions;
+
+  /** \brief The function that starts a queued I/O.
+   */
+  using StartFn = std::function<void()>;
+
+  struct Metrics {
+    /** \brief The number of I/Os dispatched, per class.
+     */
+    std::array<CountMetric<u64>, kNumPageIoClasses> dispatch_count;
+
+    /** \brief How long I/Os were queued before they were dispatched, per class.
+     */
+    std::array<LatencyHistogram, kNumPageIoClasses> queue_latency;
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  explicit PageIoScheduler(const Options& options = {}) noexcept;
+
+  PageIoScheduler(const PageIoScheduler&) = delete;
+  PageIoScheduler& operator=(const PageIoScheduler&) = delete;
+
+  const Options& options() const
+  {
+    return this->options_;
+  }
+
+  const Metrics& metrics() const
+  {
+    return this->metrics_;
+  }
+
+  /** \brief Sets the share of the I/O bandwidth given to `tenant`, relative to other tenants; the
+   * default weight is 1.  Applies to I/O submitted from now on.
+   */
+  void set_tenant_weight(u32 tenant, u32 weight);
+
+  /** \brief Queues an I/O for `tag`; `start` is called (on this thread, or on the thread that
+   * completes an earlier I/O) once it is dispatched.  The I/O costs `cost` bytes and occupies
+   * `units` of the in-flight limit, which the caller must release by calling `finish` as each
+   * part of it completes.
+   *
+   * An I/O with more units than the limit is dispatched once nothing else is in flight.
+   */
+  void submit(const PageIoTag& tag, u64 cost, usize units, StartFn&& start);
+
+  /** \brief Releases `units` of the in-flight limit held by an I/O of class `io_class`, and
+   * dispatches queued I/O that now fits.
+   */
+  void finish(PageIoClass io_class, usize units);
+
+  /** \brief The number of I/Os waiting to be dispatched.
+   */
+  usize queued_count() const;
+
+  /** \brief The number of in-flight units.
+   */
+  usize in_flight_count() const;
+
+ private:
+  struct QueuedIo {
+    u64 finish_time;
+    u64 seq;
+    usize units;
+    std::chrono::steady_clock::time_point submit_time;
+    StartFn start;
+  };
+
+  // Heap order for QueuedIo: the front of the heap is the earliest (finish_time, seq).
+  //
+  struct LaterFinish {
+    bool operator()(const QueuedIo& l, const QueuedIo& r) const
+    {
+      return l.finish_time > r.finish_time || (l.finish_time == r.finish_time && l.seq > r.seq);
+    }
+  };
+
+  struct ClassQueue {
+    std::vector<QueuedIo> heap;
+    u64 virtual_time = 0;
+    std::unordered_map<u32, u64> last_finish_time;
+    usize in_flight = 0;
+  };
+
+  /** \brief Returns the class of the next I/O to dispatch, or -1 if nothing can be dispatched
+   * now.
+   */
+  int next_class_locked() const;
+
+  /** \brief Starts queued I/O until the in-flight limit is reached or the queues are empty.
+   */
+  void dispatch();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const Options options_;
+
+  Metrics metrics_;
+
+  mutable std::mutex mutex_;
+
+  std::unordered_map<u32, u32> tenant_weight_;
+
+  std::array<ClassQueue, kNumPageIoClasses> queues_;
+
+  usize in_flight_ = 0;
+
+  u64 next_seq_ = 0;
+
+  // The number of kLatencySensitive dispatches since the last kBulk one.
+  //
+  usize dispatches_since_bulk_ = 0;
+
+  // True while some thread is running the dispatch loop; others just update the state above and
+  // let it pick up the change.
+  //
+  bool dispatching_ = false;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A PageDevice that sends all reads and writes of the wrapped device through a (possibly
+ * shared) PageIoScheduler, tagged with the ScopedPageIoTag that is current when they are started.
+ *
+ * `prepare` and `drop` are passed straight through (they don't do data I/O).  A `read_batch` is
+ * scheduled as one I/O, so that the wrapped device can still issue it as a batch.
+ */
+class ScheduledPageDevice : public PageDevice
+{
+ public:
+  explicit ScheduledPageDevice(std::shared_ptr<PageIoScheduler> scheduler,
+                               std::unique_ptr<PageDevice> device) noexcept;
+
+  //----- --- -- -  -  -   -
+  // PageDevice interface
+
+  PageIdFactory page_ids() override;
+
+  PageSize page_size() override;
+
+  Status enable_registered_page_buffers(usize buffer_count) override;
+
+  bool prefetch_hint(PageId id) override;
+
+  StatusOr<std::shared_ptr<PageBuffer>> prepare(PageId page_id) override;
+
+  void write(std::shared_ptr<const PageBuffer>&& page_buffer, WriteHandler&& handler) override;
+
+  void read(PageId id, ReadHandler&& handler) override;
+
+  void read_batch(const batt::Slice<const PageId>& ids,
+                  std::vector<ReadHandler>&& handlers) override;
+
+  void read_tail(PageId id, usize byte_count, ReadTailHandler&& handler) override;
+
+  void drop(PageId id, WriteHandler&& handler) override;
+
+  //----- --- -- -  -  -   -
+
+  PageIoScheduler& scheduler() const
+  {
+    return *this->scheduler_;
+  }
+
+  PageDevice& base_device() const
+  {
+    return *this->device_;
+  }
+
+ private:
+  const std::shared_ptr<PageIoScheduler> scheduler_;
+  const std::unique_ptr<PageDevice> device_;
+  const PageSize page_size_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_PAGE_IO_SCHEDULER_HPP
@@ -0,0 +1,307 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_io_scheduler.hpp>
+//
+#include <llfs/page_io_scheduler.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/memory_page_device.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. (QueueDepth) No more than max_in_flight I/Os are started at once; each completion starts
+//     the next queued I/O.
+//  2. (FairShare) A tenant that queues many I/Os at once doesn't delay another tenant's I/O until
+//     they are all done; with weights, dispatches are shared in proportion to the weights.
+//  3. (Classes) Latency-sensitive I/O goes ahead of bulk I/O, except for one of every
+//     bulk_dispatch_interval dispatches, and bulk I/O is limited to max_bulk_in_flight.
+//  4. (ScheduledDevice) Reads, batch reads and writes through a ScheduledPageDevice are tagged
+//     with the current ScopedPageIoTag and reach the wrapped device.
+
+using namespace llfs::int_types;
+
+using llfs::PageIoClass;
+using llfs::PageIoScheduler;
+using llfs::PageIoTag;
+
+constexpr u64 kCost = 4096;
+
+// Holds the I/Os started by a PageIoScheduler until the test completes them.
+//
+class FakeIo
+{
+ public:
+  explicit FakeIo(PageIoScheduler& scheduler) noexcept : scheduler_{scheduler}
+  {
+  }
+
+  void submit(const PageIoTag& tag, const std::string& name)
+  {
+    this->scheduler_.submit(tag, kCost, /*units=*/1, [this, tag, name] {
+      this->started_.emplace_back(tag, name);
+      this->started_names_.emplace_back(name);
+    });
+  }
+
+  // Completes the oldest in-flight I/O.
+  //
+  void complete_one()
+  {
+    ASSERT_FALSE(this->started_.empty());
+    const PageIoTag tag = this->started_.front().first;
+    this->started_.pop_front();
+    this->scheduler_.finish(tag.io_class, 1);
+  }
+
+  void complete_all()
+  {
+    while (!this->started_.empty()) {
+      this->complete_one();
+    }
+  }
+
+  usize in_flight() const
+  {
+    return this->started_.size();
+  }
+
+  const std::vector<std::string>& started_names() const
+  {
+    return this->started_names_;
+  }
+
+ private:
+  PageIoScheduler& scheduler_;
+  std::deque<std::pair<PageIoTag, std::string>> started_;
+  std::vector<std::string> started_names_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST(PageIoSchedulerTest, QueueDepth)
+{
+  PageIoScheduler scheduler{llfs::PageIoSchedulerOptions{
+      .max_in_flight = 2,
+      .max_bulk_in_flight = 2,
+      .bulk_dispatch_interval = 8,
+  }};
+  FakeIo io{scheduler};
+
+  for (usize i = 0; i < 5; ++i) {
+    io.submit(PageIoTag{}, std::to_string(i));
+  }
+
+  EXPECT_EQ(io.in_flight(), 2u);
+  EXPECT_EQ(scheduler.in_flight_count(), 2u);
+  EXPECT_EQ(scheduler.queued_count(), 3u);
+
+  io.complete_one();
+
+  EXPECT_EQ(io.in_flight(), 2u);
+  EXPECT_EQ(scheduler.queued_count(), 2u);
+
+  io.complete_all();
+
+  EXPECT_THAT(io.started_names(), ::testing::ElementsAre("0", "1", "2", "3", "4"));
+  EXPECT_EQ(scheduler.in_flight_count(), 0u);
+  EXPECT_EQ(scheduler.queued_count(), 0u);
+  EXPECT_EQ(scheduler.metrics().dispatch_count[0].load(), 5u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST(PageIoSchedulerTest, FairShare)
+{
+  const PageIoTag tenant_a{.tenant = 1, .io_class = PageIoClass::kLatencySensitive};
+  const PageIoTag tenant_b{.tenant = 2, .io_class = PageIoClass::kLatencySensitive};
+  {
+    PageIoScheduler scheduler{llfs::PageIoSchedulerOptions{
+        .max_in_flight = 1,
+        .max_bulk_in_flight = 1,
+        .bulk_dispatch_interval = 8,
+    }};
+    FakeIo io{scheduler};
+
+    // Tenant A queues a scan; then tenant B does two reads.
+    //
+    for (usize i = 0; i < 20; ++i) {
+      io.submit(tenant_a, "a");
+    }
+    io.submit(tenant_b, "b");
+    io.submit(tenant_b, "b");
+
+    io.complete_all();
+
+    ASSERT_EQ(io.started_names().size(), 22u);
+    EXPECT_THAT(std::vector<std::string>(io.started_names().begin(),
+                                         io.started_names().begin() + 5),
+                ::testing::ElementsAre("a", "a", "b", "a", "b"));
+  }
+  {
+    PageIoScheduler scheduler{llfs::PageIoSchedulerOptions{
+        .max_in_flight = 1,
+        .max_bulk_in_flight = 1,
+        .bulk_dispatch_interval = 8,
+    }};
+    scheduler.set_tenant_weight(tenant_a.tenant, 3);
+
+    FakeIo io{scheduler};
+
+    for (usize i = 0; i < 40; ++i) {
+      io.submit(tenant_a, "a");
+      io.submit(tenant_b, "b");
+    }
+
+    io.complete_all();
+
+    // A should get about 3 of every 4 dispatches while both have I/O queued.
+    //
+    ASSERT_EQ(io.started_names().size(), 80u);
+    const double a_count =
+        std::count(io.started_names().begin(), io.started_names().begin() + 40, "a");
+    EXPECT_NEAR(a_count, 30, 1);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 3.
+//
+TEST(PageIoSchedulerTest, Classes)
+{
+  const PageIoTag point_read{.tenant = 1, .io_class = PageIoClass::kLatencySensitive};
+  const PageIoTag scan{.tenant = 1, .io_class = PageIoClass::kBulk};
+  {
+    PageIoScheduler scheduler{llfs::PageIoSchedulerOptions{
+        .max_in_flight = 1,
+        .max_bulk_in_flight = 1,
+        .bulk_dispatch_interval = 4,
+    }};
+    FakeIo io{scheduler};
+
+    // Keep the device busy so that everything below is queued.
+    //
+    io.submit(point_read, "x");
+
+    for (usize i = 0; i < 3; ++i) {
+      io.submit(scan, "s");
+    }
+    for (usize i = 0; i < 6; ++i) {
+      io.submit(point_read, "p");
+    }
+
+    io.complete_all();
+
+    EXPECT_THAT(io.started_names(),
+                ::testing::ElementsAre("x", "p", "p", "s", "p", "p", "p", "s", "p", "s"));
+  }
+  {
+    PageIoScheduler scheduler{llfs::PageIoSchedulerOptions{
+        .max_in_flight = 4,
+        .max_bulk_in_flight = 2,
+        .bulk_dispatch_interval = 4,
+    }};
+    FakeIo io{scheduler};
+
+    for (usize i = 0; i < 4; ++i) {
+      io.submit(scan, "s");
+    }
+
+    EXPECT_EQ(io.in_flight(), 2u);
+
+    io.submit(point_read, "p");
+    io.submit(point_read, "p");
+
+    EXPECT_EQ(io.in_flight(), 4u);
+    EXPECT_THAT(io.started_names(), ::testing::ElementsAre("s", "s", "p", "p"));
+
+    io.complete_all();
+
+    EXPECT_EQ(io.started_names().size(), 6u);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 4.
+//
+TEST(PageIoSchedulerTest, ScheduledDevice)
+{
+  constexpr u64 kPageSize = 4096;
+  constexpr u64 kPageCount = 8;
+  constexpr llfs::page_device_id_int kDeviceId = 1;
+
+  auto scheduler = std::make_shared<PageIoScheduler>();
+
+  llfs::ScheduledPageDevice device{
+      scheduler, std::make_unique<llfs::MemoryPageDevice>(kDeviceId, llfs::PageCount{kPageCount},
+                                                          llfs::PageSize{kPageSize})};
+
+  EXPECT_EQ(device.page_size(), llfs::PageSize{kPageSize});
+
+  const llfs::PageIdFactory ids = device.page_ids();
+  std::vector<llfs::PageId> page_ids;
+
+  for (usize i = 0; i < kPageCount; ++i) {
+    const llfs::PageId page_id = ids.make_page_id(i, 1);
+    page_ids.emplace_back(page_id);
+
+    llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer = device.prepare(page_id);
+    ASSERT_TRUE(buffer.ok()) << BATT_INSPECT(buffer.status());
+
+    llfs::MutableBuffer payload = (*buffer)->mutable_payload();
+    std::memset(payload.data(), static_cast<char>(i), payload.size());
+
+    llfs::Status write_status = batt::StatusCode::kUnknown;
+    {
+      llfs::ScopedPageIoTag tag{PageIoTag{.tenant = 7, .io_class = PageIoClass::kBulk}};
+      device.write(std::move(*buffer), [&write_status](llfs::Status status) {
+        write_status = status;
+      });
+    }
+    ASSERT_TRUE(write_status.ok()) << BATT_INSPECT(write_status);
+  }
+
+  EXPECT_EQ(llfs::ScopedPageIoTag::current().tenant, 0u);
+  EXPECT_EQ(scheduler->metrics().dispatch_count[(usize)PageIoClass::kBulk].load(), kPageCount);
+
+  llfs::PageDevice::ReadResult result = device.await_read(page_ids[3]);
+  ASSERT_TRUE(result.ok()) << BATT_INSPECT(result.status());
+  EXPECT_EQ(static_cast<const char*>((*result)->const_payload().data())[0], 3);
+
+  std::vector<llfs::PageDevice::ReadResult> results(kPageCount, batt::StatusCode::kUnknown);
+  std::vector<llfs::PageDevice::ReadHandler> handlers;
+  for (usize i = 0; i < kPageCount; ++i) {
+    handlers.emplace_back([&results, i](llfs::PageDevice::ReadResult&& r) {
+      results[i] = std::move(r);
+    });
+  }
+  device.read_batch(batt::as_slice(page_ids), std::move(handlers));
+
+  for (usize i = 0; i < kPageCount; ++i) {
+    ASSERT_TRUE(results[i].ok()) << BATT_INSPECT(i) << BATT_INSPECT(results[i].status());
+    EXPECT_EQ(static_cast<const char*>((*results[i])->const_payload().data())[0],
+              static_cast<char>(i));
+  }
+
+  EXPECT_EQ(scheduler->metrics().dispatch_count[(usize)PageIoClass::kLatencySensitive].load(), 2u);
+  EXPECT_EQ(scheduler->in_flight_count(), 0u);
+}
+
+}  // namespace
@@ -10,36 +10,110 @@
 //
 
 #include <llfs/crc.hpp>
+#include <llfs/status_code.hpp>
 
 #include <boost/uuid/uuid_io.hpp>
 
 namespace llfs {
 
+namespace {
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Passes the bytes covered by the page checksum to `fn`: the header (with `crc32` zeroed), then the
+// used regions before and after the unused region.
 //
-u64 compute_page_crc64(const PageBuffer& page)
+template <typename Fn>
+void for_each_checksummed_part(const PageBuffer& page, Fn&& fn)
 {
-  BATT_PANIC() << "this is supposed to be disabled right now!";
-
   PackedPageHeader header = get_page_header(page);
 
   header.crc32 = 0;
 
-  auto crc64 = make_crc64();
-
   const u8* page_bytes = reinterpret_cast<const u8*>(&page);
 
-  crc64.process_bytes(&header, sizeof(PackedPageHeader));
+  fn(&header, sizeof(PackedPageHeader));
 
-  crc64.process_bytes(page_bytes + sizeof(PackedPageHeader),
-                      header.unused_begin.value() - sizeof(PackedPageHeader));
+  fn(page_bytes + sizeof(PackedPageHeader),
+     header.unused_begin.value() - sizeof(PackedPageHeader));
 
-  crc64.process_bytes(page_bytes + header.unused_end.value(),
-                      page.size() - header.unused_end.value());
+  fn(page_bytes + header.unused_end.value(), page.size() - header.unused_end.value());
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 compute_page_crc64(const PageBuffer& page)
+{
+  auto crc64 = make_crc64();
+
+  for_each_checksummed_part(page, [&crc64](const void* data, usize size) {
+    crc64.process_bytes(data, size);
+  });
 
   return crc64.checksum();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u32 compute_page_crc32c(const PageBuffer& page)
+{
+  u32 crc = 0;
+
+  for_each_checksummed_part(page, [&crc](const void* data, usize size) {
+    crc = crc32c_extend(crc, data, size);
+  });
+
+  return crc;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u32 compute_page_checksum(const PageBuffer& page, PageChecksumType type)
+{
+  switch (type) {
+    case PageChecksumType::kLegacyCrc64:
+      return static_cast<u32>(compute_page_crc64(page));
+
+    case PageChecksumType::kCrc32c:
+      return compute_page_crc32c(page);
+  }
+  BATT_PANIC() << "unknown page checksum type: " << type;
+  BATT_UNREACHABLE();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status verify_page_checksum(const PageBuffer& page)
+{
+  const PackedPageHeader& header = get_page_header(page);
+
+  if (header.crc32 == PackedPageHeader::kCrc32NotSet) {
+    return OkStatus();
+  }
+
+  // Don't trust the unused region bounds until they have been checked; they determine which bytes
+  // are read.
+  //
+  if (header.unused_begin < sizeof(PackedPageHeader) || header.unused_begin > page.size()) {
+    return make_status(StatusCode::kPageHeaderBadUnusedBegin);
+  }
+  if (header.unused_end < header.unused_begin || header.unused_end > page.size()) {
+    return make_status(StatusCode::kPageHeaderBadUnusedEnd);
+  }
+
+  const PageChecksumType type = header.checksum_type();
+  if (type != PageChecksumType::kLegacyCrc64 && type != PageChecksumType::kCrc32c) {
+    return make_status(StatusCode::kPageChecksumUnknownType);
+  }
+
+  if (header.crc32.value() != compute_page_checksum(page, type)) {
+    return make_status(StatusCode::kPageChecksumMismatch);
+  }
+
+  return OkStatus();
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 Status finalize_page_header(PageBuffer* page, const Interval<u64>& unused_region)
@@ -53,9 +127,14 @@ Status finalize_page_header(PageBuffer* page, const Interval<u64>& unused_region
   BATT_CHECK_EQ(header->unused_begin.value(), unused_region.lower_bound);
   BATT_CHECK_EQ(header->unused_end.value(), unused_region.upper_bound);
 
-#if !LLFS_DISABLE_PAGE_CRC
-  // TODO [tastolfi 2021-09-07] Decide and clean up: 32 vs 64 bits
-  header->crc32 = compute_page_crc64(*page);
+  // The checksum type is covered by the checksum, so it must be set first.
+  //
+  header->set_checksum_type(PageChecksumType::kCrc32c);
+
+#if LLFS_DISABLE_PAGE_CRC
+  header->crc32 = PackedPageHeader::kCrc32NotSet;
+#else
+  header->crc32 = compute_page_crc32c(*page);
 #endif
 
   return OkStatus();
@@ -70,9 +149,9 @@ std::ostream& operator<<(std::ostream& out, const PackedPageHeader& t)
 {
   return out << "PackedPageHeader{.magic=" << std::hex << t.magic.value()
              << ", .page_id=" << t.page_id.unpack() << ", .layout_id=" << t.layout_id
-             << ", .crc32=" << t.crc32.value() << ", .unused_begin=" << std::dec
-             << t.unused_begin.value() << ", .unused_end=" << t.unused_end.value()
-             << ", .size=" << t.size << ",}";
+             << ", .crc32=" << t.crc32.value() << ", .checksum_type=" << t.checksum_type()
+             << ", .unused_begin=" << std::dec << t.unused_begin.value()
+             << ", .unused_end=" << t.unused_end.value() << ", .size=" << t.size << ",}";
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -39,13 +39,29 @@ namespace llfs {
 //
 using slot_offset_type = u64;
 
-// Compute the crc64 for the given page.
+// Compute the crc64 for the given page.  Only pages with PageChecksumType::kLegacyCrc64 use this
+// (truncated to 32 bits); it is kept so that they can still be verified.
 //
 u64 compute_page_crc64(const PageBuffer& page);
 
+// Compute the CRC32C for the given page, over the same bytes as compute_page_crc64.
+//
+u32 compute_page_crc32c(const PageBuffer& page);
+
+// Compute the value that belongs in the header `crc32` field of `page` for the given algorithm.
+//
+u32 compute_page_checksum(const PageBuffer& page, PageChecksumType type);
+
+// Checks the header `crc32` field of `page` against its contents, using the algorithm named in the
+// header.  Returns OkStatus if the checksum matches or was never set
+// (PackedPageHeader::kCrc32NotSet).
+//
+Status verify_page_checksum(const PageBuffer& page);
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
-// Finalize a page by computing its crc64 and user slot information.
+// Finalize a page by setting its magic number and unused region and (unless LLFS_DISABLE_PAGE_CRC)
+// computing its CRC32C.
 //
 Status finalize_page_header(PageBuffer* page,
                             const Interval<u64>& unused_region = Interval<u64>{0u, 0u});
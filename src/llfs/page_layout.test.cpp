@@ -0,0 +1,116 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_layout.hpp>
+//
+#include <llfs/page_layout.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/status_code.hpp>
+
+namespace {
+
+// Test Plan:
+//
+//  1. A page finalized and checksummed with CRC32C verifies, until a byte in its used region is
+//     changed; changes in the unused region don't matter.
+//  2. A page written before the checksum type field existed (legacy CRC64 in `crc32`, old user slot
+//     bytes in `checksum_info`) still verifies.
+//  3. A page with kCrc32NotSet always verifies.
+//  4. An unknown checksum type is reported as an error.
+
+using namespace llfs::int_types;
+
+constexpr usize kTestPageSize = 4096;
+constexpr usize kTestUsedSize = 1000;
+
+std::shared_ptr<llfs::PageBuffer> make_test_page()
+{
+  std::shared_ptr<llfs::PageBuffer> page =
+      llfs::PageBuffer::allocate(llfs::PageSize{kTestPageSize}, llfs::PageId{7});
+
+  u8* const bytes = reinterpret_cast<u8*>(page.get());
+  for (usize i = sizeof(llfs::PackedPageHeader); i < kTestUsedSize; ++i) {
+    bytes[i] = static_cast<u8>(i * 31);
+  }
+
+  BATT_CHECK_OK(llfs::finalize_page_header(page.get(),
+                                           llfs::Interval<u64>{kTestUsedSize, kTestPageSize}));
+  return page;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageLayoutTest, Crc32cChecksum)
+{
+  std::shared_ptr<llfs::PageBuffer> page = make_test_page();
+  llfs::PackedPageHeader* const header = llfs::mutable_page_header(page.get());
+
+  EXPECT_EQ(header->checksum_type(), llfs::PageChecksumType::kCrc32c);
+
+  header->crc32 = llfs::compute_page_checksum(*page, llfs::PageChecksumType::kCrc32c);
+  EXPECT_EQ(header->crc32.value(), llfs::compute_page_crc32c(*page));
+  EXPECT_TRUE(llfs::verify_page_checksum(*page).ok());
+
+  u8* const bytes = reinterpret_cast<u8*>(page.get());
+
+  bytes[kTestUsedSize + 10] ^= 0x01;
+  EXPECT_TRUE(llfs::verify_page_checksum(*page).ok());
+
+  bytes[kTestUsedSize - 10] ^= 0x01;
+  EXPECT_EQ(llfs::verify_page_checksum(*page),
+            llfs::make_status(llfs::StatusCode::kPageChecksumMismatch));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageLayoutTest, LegacyCrc64Checksum)
+{
+  std::shared_ptr<llfs::PageBuffer> page = make_test_page();
+  llfs::PackedPageHeader* const header = llfs::mutable_page_header(page.get());
+
+  // Fill `checksum_info` with what could have been in the old user slot.
+  //
+  header->checksum_info = 0x12345678u;
+  EXPECT_EQ(header->checksum_type(), llfs::PageChecksumType::kLegacyCrc64);
+
+  header->crc32 = static_cast<u32>(llfs::compute_page_crc64(*page));
+  EXPECT_TRUE(llfs::verify_page_checksum(*page).ok());
+
+  reinterpret_cast<u8*>(page.get())[kTestUsedSize - 1] ^= 0x80;
+  EXPECT_EQ(llfs::verify_page_checksum(*page),
+            llfs::make_status(llfs::StatusCode::kPageChecksumMismatch));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageLayoutTest, ChecksumNotSet)
+{
+  std::shared_ptr<llfs::PageBuffer> page = make_test_page();
+  llfs::mutable_page_header(page.get())->crc32 = llfs::PackedPageHeader::kCrc32NotSet;
+
+  EXPECT_TRUE(llfs::verify_page_checksum(*page).ok());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PageLayoutTest, UnknownChecksumType)
+{
+  std::shared_ptr<llfs::PageBuffer> page = make_test_page();
+  llfs::PackedPageHeader* const header = llfs::mutable_page_header(page.get());
+
+  header->checksum_info = llfs::PackedPageHeader::kChecksumInfoMagic | 0x7fu;
+  header->crc32 = 0;
+
+  EXPECT_EQ(llfs::verify_page_checksum(*page),
+            llfs::make_status(llfs::StatusCode::kPageChecksumUnknownType));
+}
+
+}  // namespace
@@ -10,6 +10,7 @@
 //
 
 #include <llfs/pinned_page.hpp>
+#include <llfs/seq.hpp>
 
 namespace llfs {
 
@@ -111,4 +112,44 @@ StatusOr<PinnedPage> PageLoader::get_page_slot_ref_with_layout_in_job(
                                        ok_if_not_found, page_id);
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::vector<StatusOr<PinnedPage>> PageLoader::get_pages(
+    const Slice<const PageId>& page_ids, const Optional<PageLayoutId>& required_layout,
+    PinPageToJob pin_page_to_job, OkIfNotFound ok_if_not_found)
+{
+  std::vector<StatusOr<PinnedPage>> pages;
+  pages.reserve(page_ids.size());
+
+  for (const PageId& page_id : page_ids) {
+    pages.emplace_back(
+        this->get_page_with_layout_in_job(page_id, required_layout, pin_page_to_job, ok_if_not_found));
+  }
+
+  return pages;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::vector<PageId>> PageLoader::trace_page_refs(PageId page_id)
+{
+  std::vector<PageId> refs;
+  BATT_REQUIRE_OK(this->append_page_refs(page_id, &refs));
+
+  return refs;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageLoader::append_page_refs(PageId page_id, std::vector<PageId>* refs)
+{
+  StatusOr<PinnedPage> page = this->get_page(page_id, OkIfNotFound{false});
+  BATT_REQUIRE_OK(page);
+  BATT_CHECK_NOT_NULLPTR(*page);
+
+  (*page)->append_refs_and_delta_base(refs);
+
+  return OkStatus();
+}
+
 }  // namespace llfs
@@ -16,8 +16,11 @@
 #include <llfs/page_id.hpp>
 #include <llfs/page_id_slot.hpp>
 #include <llfs/page_layout_id.hpp>
+#include <llfs/slice.hpp>
 #include <llfs/status.hpp>
 
+#include <vector>
+
 namespace llfs {
 
 // Interface for an entity which can resolve `PageId`s into `PinnedPage`s.
@@ -69,6 +72,34 @@ class PageLoader
       const Optional<PageLayoutId>& required_layout, PinPageToJob pin_page_to_job,
       OkIfNotFound ok_if_not_found);
 
+  /** \brief Loads a batch of pages; the returned vector has one element per page id, in the same
+   * order as `page_ids`.
+   *
+   * Implementations should start loading all pages that aren't already available before waiting on
+   * any of them.  The default implementation simply calls `get_page_with_layout_in_job` for each
+   * page in turn.
+   */
+  virtual std::vector<StatusOr<PinnedPage>> get_pages(const Slice<const PageId>& page_ids,
+                                                      const Optional<PageLayoutId>& required_layout,
+                                                      PinPageToJob pin_page_to_job,
+                                                      OkIfNotFound ok_if_not_found);
+
+  /** \brief Returns the outgoing refs of the given page (the sequence returned by
+   * PageView::trace_refs).  Convenience wrapper for `append_page_refs`.
+   */
+  StatusOr<std::vector<PageId>> trace_page_refs(PageId page_id);
+
+  /** \brief Appends the outgoing refs of the given page (the sequence returned by
+   * PageView::trace_refs, plus its delta base if it has one; see
+   * PageView::append_refs_and_delta_base) to `*refs`.  Callers that trace many pages should reuse
+   * the same vector (clearing it in between) to avoid allocating for each page.
+   *
+   * Implementations may avoid loading the full page when they can get the refs some cheaper way
+   * (see page_ref_summary.hpp).  The default implementation loads the page via `get_page`.  If an
+   * error is returned, `*refs` is unchanged.
+   */
+  virtual Status append_page_refs(PageId page_id, std::vector<PageId>* refs);
+
  protected:
   PageLoader() = default;
 };
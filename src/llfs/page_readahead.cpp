@@ -0,0 +1,161 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_readahead.hpp>
+//
+
+#include <batteries/assert.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ SequentialReadahead::SequentialReadahead(usize min_window, usize max_window) noexcept
+    : min_window_{std::max<usize>(1, min_window)}
+    , max_window_{std::max(this->min_window_, max_window)}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Slice<const PageId> SequentialReadahead::observe(PageId page_id, const PageIdFactory& page_ids)
+{
+  this->to_prefetch_.clear();
+
+  if (!page_id) {
+    return as_slice(this->to_prefetch_);
+  }
+
+  const page_device_id_int device_id = PageIdFactory::get_device_id(page_id);
+  const i64 physical_page = page_ids.get_physical_page(page_id);
+  const page_generation_int generation = page_ids.get_generation(page_id);
+
+  bool is_new = false;
+  Stream& stream = this->find_stream(device_id, &is_new);
+
+  stream.last_observed = ++this->observe_count_;
+
+  if (is_new) {
+    stream.generation = generation;
+    stream.last_physical_page = physical_page;
+    return as_slice(this->to_prefetch_);
+  }
+
+  const i64 delta = physical_page - stream.last_physical_page;
+  if (delta == 0) {
+    // Re-reading the same page tells us nothing new.
+    //
+    return as_slice(this->to_prefetch_);
+  }
+
+  if (stream.stride != 0 && delta == stream.stride && generation == stream.generation) {
+    ++stream.run_length;
+
+    // If we had already prefetched this page, count a hit and grow the window once we've used a
+    // full window's worth of prefetches.
+    //
+    if (stream.outstanding > 0) {
+      --stream.outstanding;
+      ++this->hit_count_;
+      ++stream.hits_since_grow;
+      if (stream.hits_since_grow >= stream.window) {
+        stream.window = std::min(this->max_window_, stream.window * 2);
+        stream.hits_since_grow = 0;
+      }
+    }
+  } else {
+    // The stream is broken; anything we prefetched past this point was wasted, so shrink the
+    // window.
+    //
+    if (stream.outstanding > 0) {
+      this->waste_count_ += stream.outstanding;
+      stream.window = std::max(this->min_window_, stream.window / 2);
+      stream.outstanding = 0;
+    }
+    stream.hits_since_grow = 0;
+    stream.stride = (std::abs(delta) <= kMaxStride) ? delta : 0;
+    stream.run_length = 1;
+    stream.generation = generation;
+  }
+
+  stream.last_physical_page = physical_page;
+
+  if (stream.stride == 0 || stream.run_length < kMinRunLength) {
+    return as_slice(this->to_prefetch_);
+  }
+
+  // Top up the prefetched region so that it extends `window` steps past the reader.
+  //
+  const i64 page_count = BATT_CHECKED_CAST(i64, page_ids.get_physical_page_count().value());
+
+  i64 next_page = (stream.outstanding > 0 ? stream.prefetch_end : stream.last_physical_page) +
+                  stream.stride;
+
+  while (stream.outstanding < stream.window && next_page >= 0 && next_page < page_count) {
+    this->to_prefetch_.emplace_back(
+        page_ids.make_page_id(static_cast<page_id_int>(next_page), stream.generation));
+    stream.prefetch_end = next_page;
+    ++stream.outstanding;
+    next_page += stream.stride;
+  }
+
+  this->issue_count_ += this->to_prefetch_.size();
+
+  return as_slice(this->to_prefetch_);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize SequentialReadahead::window(page_device_id_int device_id) const noexcept
+{
+  for (const Stream& stream : this->streams_) {
+    if (stream.active && stream.device_id == device_id) {
+      return stream.window;
+    }
+  }
+  return 0;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto SequentialReadahead::find_stream(page_device_id_int device_id, bool* is_new) -> Stream&
+{
+  Stream* lru_stream = nullptr;
+
+  for (Stream& stream : this->streams_) {
+    if (stream.active && stream.device_id == device_id) {
+      *is_new = false;
+      return stream;
+    }
+    if (!lru_stream || !stream.active ||
+        (lru_stream->active && stream.last_observed < lru_stream->last_observed)) {
+      lru_stream = &stream;
+    }
+  }
+
+  BATT_CHECK_NOT_NULLPTR(lru_stream);
+
+  // Any pages prefetched on behalf of the stream being replaced are abandoned.
+  //
+  if (lru_stream->active) {
+    this->waste_count_ += lru_stream->outstanding;
+  }
+
+  *lru_stream = Stream{};
+  lru_stream->active = true;
+  lru_stream->device_id = device_id;
+  lru_stream->window = this->min_window_;
+
+  *is_new = true;
+  return *lru_stream;
+}
+
+}  // namespace llfs
@@ -0,0 +1,154 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_READAHEAD_HPP
+#define LLFS_PAGE_READAHEAD_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/page_id_factory.hpp>
+#include <llfs/slice.hpp>
+
+#include <array>
+#include <vector>
+
+namespace llfs {
+
+/** \brief Detects sequential (or constant-stride) access patterns in a stream of loaded page ids and
+ * decides which pages should be prefetched ahead of the reader.
+ *
+ * One access stream is tracked per PageDevice (up to kMaxStreams devices at once).  Once a stream
+ * has moved by the same stride (in physical page index) kMinRunLength times in a row, the engine
+ * starts issuing prefetches ahead of the reader, up to `window` pages ahead.  The window doubles
+ * each time a full window's worth of prefetched pages is actually used, and is halved whenever the
+ * stream breaks while there are still unused prefetched pages outstanding.
+ *
+ * Since a PageId includes the page generation, prefetch targets are assumed to have the same
+ * generation as the page most recently loaded in the stream; a stream only advances while that
+ * assumption holds.
+ *
+ * This class is not thread-safe; it is meant to be owned by a single reader (e.g., a PageCacheJob).
+ */
+class SequentialReadahead
+{
+ public:
+  /** \brief The maximum number of per-device streams tracked at once.
+   */
+  static constexpr usize kMaxStreams = 4;
+
+  /** \brief The number of consecutive same-stride steps required before readahead starts.
+   */
+  static constexpr usize kMinRunLength = 2;
+
+  /** \brief Physical page strides larger than this (in absolute value) are never treated as
+   * sequential.
+   */
+  static constexpr i64 kMaxStride = 64;
+
+  static constexpr usize kDefaultMinWindow = 2;
+  static constexpr usize kDefaultMaxWindow = 64;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  explicit SequentialReadahead(usize min_window = kDefaultMinWindow,
+                               usize max_window = kDefaultMaxWindow) noexcept;
+
+  SequentialReadahead(const SequentialReadahead&) = delete;
+  SequentialReadahead& operator=(const SequentialReadahead&) = delete;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Records that the reader has loaded `page_id` (which belongs to the device described by
+   * `page_ids`) and returns the ids of the pages that should be prefetched as a result.
+   *
+   * The returned slice is only valid until the next call to `observe`.
+   */
+  Slice<const PageId> observe(PageId page_id, const PageIdFactory& page_ids);
+
+  /** \brief Returns the current readahead window for the given device, or 0 if there is no active
+   * stream for that device.
+   */
+  usize window(page_device_id_int device_id) const noexcept;
+
+  /** \brief The total number of prefetches requested by this engine.
+   */
+  u64 issue_count() const noexcept
+  {
+    return this->issue_count_;
+  }
+
+  /** \brief The number of prefetched pages that were subsequently loaded by the reader.
+   */
+  u64 hit_count() const noexcept
+  {
+    return this->hit_count_;
+  }
+
+  /** \brief The number of prefetched pages that were never loaded because the stream broke.
+   */
+  u64 waste_count() const noexcept
+  {
+    return this->waste_count_;
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  /** \brief The access pattern state for a single device.
+   */
+  struct Stream {
+    bool active = false;
+    page_device_id_int device_id = 0;
+    page_generation_int generation = 0;
+    i64 last_physical_page = 0;
+    i64 stride = 0;
+    usize run_length = 0;
+    usize window = 0;
+
+    /** \brief The physical page index of the furthest page prefetched; only meaningful when
+     * `outstanding` is non-zero.
+     */
+    i64 prefetch_end = 0;
+
+    /** \brief The number of pages prefetched beyond `last_physical_page` along `stride`.
+     */
+    usize outstanding = 0;
+
+    /** \brief The number of prefetch hits since the window was last grown.
+     */
+    usize hits_since_grow = 0;
+
+    /** \brief Used to pick a stream to replace when all are active.
+     */
+    u64 last_observed = 0;
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Returns the stream for `device_id`, (re-)initializing the least recently used stream if
+   * there isn't one already.  Sets `*is_new` to true iff the stream was just initialized.
+   */
+  Stream& find_stream(page_device_id_int device_id, bool* is_new);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const usize min_window_;
+  const usize max_window_;
+  std::array<Stream, kMaxStreams> streams_;
+  std::vector<PageId> to_prefetch_;
+  u64 observe_count_ = 0;
+  u64 issue_count_ = 0;
+  u64 hit_count_ = 0;
+  u64 waste_count_ = 0;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_PAGE_READAHEAD_HPP
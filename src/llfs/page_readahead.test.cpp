@@ -0,0 +1,140 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_readahead.hpp>
+//
+#include <llfs/page_readahead.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//
+//  1. Random access never triggers readahead.
+//  2. A forward sequential scan triggers readahead; prefetched ids are the next pages on the same
+//     device with the same generation, and the window grows as prefetches are used.
+//  3. Strided (including backwards) scans are detected.
+//  4. Breaking the stream counts outstanding prefetches as wasted and shrinks the window.
+//  5. Readahead never runs off the end of the device.
+//
+
+using namespace llfs::int_types;
+
+constexpr u64 kTestPageCount = 1024;
+constexpr llfs::page_device_id_int kTestDeviceId = 3;
+constexpr llfs::page_generation_int kTestGeneration = 7;
+
+class SequentialReadaheadTest : public ::testing::Test
+{
+ public:
+  llfs::PageId page(i64 physical_page) const
+  {
+    return this->page_ids_.make_page_id(physical_page, kTestGeneration);
+  }
+
+  std::vector<llfs::PageId> observe(i64 physical_page)
+  {
+    llfs::Slice<const llfs::PageId> ids =
+        this->readahead_.observe(this->page(physical_page), this->page_ids_);
+    return std::vector<llfs::PageId>(ids.begin(), ids.end());
+  }
+
+  llfs::PageIdFactory page_ids_{llfs::PageCount{kTestPageCount}, kTestDeviceId};
+
+  llfs::SequentialReadahead readahead_{/*min_window=*/2, /*max_window=*/8};
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  1. Random access never triggers readahead.
+//
+TEST_F(SequentialReadaheadTest, RandomAccess)
+{
+  for (i64 physical_page : {500, 3, 901, 77, 640, 12, 333, 1000}) {
+    EXPECT_THAT(this->observe(physical_page), ::testing::IsEmpty());
+  }
+  EXPECT_EQ(this->readahead_.issue_count(), 0u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  2. A forward sequential scan triggers readahead.
+//
+TEST_F(SequentialReadaheadTest, SequentialScan)
+{
+  EXPECT_THAT(this->observe(100), ::testing::IsEmpty());
+  EXPECT_THAT(this->observe(101), ::testing::IsEmpty());
+
+  // Second step with the same stride; readahead starts with the minimum window.
+  //
+  EXPECT_THAT(this->observe(102), ::testing::ElementsAre(this->page(103), this->page(104)));
+  EXPECT_EQ(this->readahead_.window(kTestDeviceId), 2u);
+
+  // Consuming a prefetched page tops up the window.
+  //
+  EXPECT_THAT(this->observe(103), ::testing::ElementsAre(this->page(105)));
+
+  // After a full window of hits, the window doubles.
+  //
+  EXPECT_THAT(this->observe(104),
+              ::testing::ElementsAre(this->page(106), this->page(107), this->page(108)));
+  EXPECT_EQ(this->readahead_.window(kTestDeviceId), 4u);
+
+  for (i64 physical_page = 105; physical_page < 200; ++physical_page) {
+    (void)this->observe(physical_page);
+  }
+
+  EXPECT_EQ(this->readahead_.window(kTestDeviceId), 8u);
+  EXPECT_EQ(this->readahead_.waste_count(), 0u);
+  EXPECT_EQ(this->readahead_.hit_count() + 8, this->readahead_.issue_count());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  3. Strided (including backwards) scans are detected.
+//
+TEST_F(SequentialReadaheadTest, BackwardStride)
+{
+  (void)this->observe(50);
+  (void)this->observe(47);
+
+  EXPECT_THAT(this->observe(44), ::testing::ElementsAre(this->page(41), this->page(38)));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  4. Breaking the stream counts outstanding prefetches as wasted and shrinks the window.
+//
+TEST_F(SequentialReadaheadTest, BrokenStreamShrinksWindow)
+{
+  for (i64 physical_page = 0; physical_page < 20; ++physical_page) {
+    (void)this->observe(physical_page);
+  }
+  EXPECT_EQ(this->readahead_.window(kTestDeviceId), 8u);
+  EXPECT_EQ(this->readahead_.waste_count(), 0u);
+
+  EXPECT_THAT(this->observe(700), ::testing::IsEmpty());
+
+  EXPECT_EQ(this->readahead_.waste_count(), 8u);
+  EXPECT_EQ(this->readahead_.window(kTestDeviceId), 4u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  5. Readahead never runs off the end of the device.
+//
+TEST_F(SequentialReadaheadTest, StopsAtEndOfDevice)
+{
+  (void)this->observe(kTestPageCount - 4);
+  (void)this->observe(kTestPageCount - 3);
+
+  EXPECT_THAT(this->observe(kTestPageCount - 2),
+              ::testing::ElementsAre(this->page(kTestPageCount - 1)));
+  EXPECT_THAT(this->observe(kTestPageCount - 1), ::testing::IsEmpty());
+}
+
+}  // namespace
@@ -17,11 +17,13 @@ BATT_SUPPRESS_IF_GCC("-Wmaybe-uninitialized")
 #include <llfs/page_cache_job.hpp>
 #include <llfs/page_recycler_recovery_visitor.hpp>
 #include <llfs/system_config.hpp>
+#include <llfs/trace_span.hpp>
 
 #include <batteries/async/backoff.hpp>
 #include <batteries/finally.hpp>
 #include <batteries/hint.hpp>
 
+#include <iterator>
 #include <unordered_map>
 
 namespace llfs {
@@ -79,8 +81,8 @@ StatusOr<SlotRange> refresh_recycler_info_slot(TypedSlotWriter<PageRecycleEvent>
       options.total_page_grant_size() *
           (1 + max_buffered_page_count.value_or(
                    PageRecycler::default_max_buffered_page_count(options))) +
-      options.recycle_task_target() + packed_sizeof_slot(info) * (options.info_refresh_rate() + 1) +
-      1 * kKiB);
+      options.recycle_task_target() * options.worker_count() +
+      packed_sizeof_slot(info) * (options.info_refresh_rate() + 1) + 1 * kKiB);
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -145,7 +147,8 @@ StatusOr<SlotRange> refresh_recycler_info_slot(TypedSlotWriter<PageRecycleEvent>
 
   // Construct the recovered state machine.
   //
-  BATT_ASSIGN_OK_RESULT(Optional<PageRecycler::Batch> latest_batch, visitor.consume_latest_batch());
+  BATT_ASSIGN_OK_RESULT(std::vector<PageRecycler::Batch> pending_batches,
+                        visitor.consume_pending_batches());
 
   auto state =
       std::make_unique<State>(visitor.recycler_uuid(), latest_info_refresh_slot->lower_bound,
@@ -155,31 +158,44 @@ StatusOr<SlotRange> refresh_recycler_info_slot(TypedSlotWriter<PageRecycleEvent>
 
   return std::unique_ptr<PageRecycler>{new PageRecycler(scheduler, std::string{name}, page_deleter,
                                                         std::move(*recovered_log),
-                                                        std::move(latest_batch), std::move(state))};
+                                                        std::move(pending_batches),
+                                                        std::move(state))};
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 PageRecycler::PageRecycler(batt::TaskScheduler& scheduler, const std::string& name,
                            PageDeleter& page_deleter, std::unique_ptr<LogDevice>&& wal_device,
-                           Optional<Batch>&& recovered_batch,
+                           std::vector<Batch>&& recovered_batches,
                            std::unique_ptr<PageRecycler::State>&& state) noexcept
     : scheduler_{scheduler}
     , name_{name}
     , page_deleter_{page_deleter}
     , wal_device_{std::move(wal_device)}
     , slot_writer_{*this->wal_device_}
-    , recycle_task_grant_{ok_result_or_panic(
-          this->slot_writer_.reserve(0, batt::WaitForResource::kFalse))}
+    , recycle_task_grants_{}
     , insert_grant_pool_{ok_result_or_panic(
           this->slot_writer_.reserve(0, batt::WaitForResource::kFalse))}
     , state_{std::move(state)}
-    , recycle_task_{}
+    , recycle_tasks_{}
     , metrics_{}
-    , prepared_batch_{std::move(recovered_batch)}
+    , recovered_batches_(std::make_move_iterator(recovered_batches.begin()),
+                         std::make_move_iterator(recovered_batches.end()))
 {
   const PageRecyclerOptions& options = this->state_.no_lock().options;
 
+  for (usize i = 0; i < options.worker_count(); ++i) {
+    this->recycle_task_grants_.emplace_back(std::make_unique<batt::Grant>(
+        ok_result_or_panic(this->slot_writer_.reserve(0, batt::WaitForResource::kFalse))));
+  }
+
+  // The recovered batches are pending from the start; the log must not be trimmed past any of them
+  // until they are committed.
+  //
+  for (const Batch& batch : this->recovered_batches_) {
+    this->pending_batch_slots_.emplace_back(batch.slot_offset);
+  }
+
   BATT_CHECK_LE(PageRecycler::calculate_log_size(options), this->slot_writer_.log_capacity())
       << "The recycler WAL is too small for the given configuration (the recycler will never "
          "make progress...)"
@@ -187,8 +203,10 @@ PageRecycler::PageRecycler(batt::TaskScheduler& scheduler, const std::string& na
       << BATT_INSPECT(options.recycle_task_target());
 
   BATT_CHECK_GE(PageRecycler::calculate_log_size(options),
-                options.recycle_task_target() + options.insert_grant_size())
-      << BATT_INSPECT(options.recycle_task_target()) << BATT_INSPECT(options.insert_grant_size());
+                options.recycle_task_target() * options.worker_count() +
+                    options.insert_grant_size())
+      << BATT_INSPECT(options.recycle_task_target()) << BATT_INSPECT(options.worker_count())
+      << BATT_INSPECT(options.insert_grant_size());
 
   const auto metric_name = [this](std::string_view property) {
     return batt::to_string("PageRecycler_", this->name_, "_", property);
@@ -198,6 +216,16 @@ PageRecycler::PageRecycler(batt::TaskScheduler& scheduler, const std::string& na
 
   ADD_METRIC_(insert_count);
   ADD_METRIC_(remove_count);
+  ADD_METRIC_(urgent_batch_count);
+  ADD_METRIC_(background_batch_count);
+  ADD_METRIC_(throttle_delay_usec);
+  ADD_METRIC_(lag_page_count);
+  ADD_METRIC_(lag_log_bytes);
+  ADD_METRIC_(deferred_batch_count);
+  ADD_METRIC_(lag_deferred_page_count);
+  ADD_METRIC_(checkpoint_count);
+  ADD_METRIC_(checkpoint_page_count);
+  ADD_METRIC_(checkpoint_skip_count);
 
 #undef ADD_METRIC_
 }
@@ -214,7 +242,17 @@ PageRecycler::~PageRecycler() noexcept
 
   global_metric_registry()  //
       .remove(this->metrics_.insert_count)
-      .remove(this->metrics_.remove_count);
+      .remove(this->metrics_.remove_count)
+      .remove(this->metrics_.urgent_batch_count)
+      .remove(this->metrics_.background_batch_count)
+      .remove(this->metrics_.throttle_delay_usec)
+      .remove(this->metrics_.lag_page_count)
+      .remove(this->metrics_.lag_log_bytes)
+      .remove(this->metrics_.deferred_batch_count)
+      .remove(this->metrics_.lag_deferred_page_count)
+      .remove(this->metrics_.checkpoint_count)
+      .remove(this->metrics_.checkpoint_page_count)
+      .remove(this->metrics_.checkpoint_skip_count);
 
   LLFS_VLOG(1) << "PageRecycler::~PageRecycler() RETURNING";
 }
@@ -232,7 +270,7 @@ void PageRecycler::start()
 {
   const bool previously_started = this->start_requested_.exchange(true);
   if (!previously_started) {
-    if (!this->recycle_task_) {
+    if (this->recycle_tasks_.empty()) {
       this->refresh_grants();
       this->start_recycle_task();
     }
@@ -252,7 +290,10 @@ void PageRecycler::halt()
 {
   if (!this->stop_requested_.exchange(true)) {
     this->state_.no_lock().pending_count.close();
-    this->recycle_task_grant_.revoke();
+    this->commit_turn_.close();
+    for (const std::unique_ptr<batt::Grant>& grant : this->recycle_task_grants_) {
+      grant->revoke();
+    }
     this->insert_grant_pool_.revoke();
     this->slot_writer_.halt();
     this->wal_device_->close().IgnoreError();
@@ -263,8 +304,8 @@ void PageRecycler::halt()
 //
 void PageRecycler::join()
 {
-  if (this->recycle_task_) {
-    this->recycle_task_->join();
+  for (const std::unique_ptr<batt::Task>& task : this->recycle_tasks_) {
+    task->join();
   }
 }
 
@@ -272,13 +313,34 @@ void PageRecycler::join()
 //
 StatusOr<slot_offset_type> PageRecycler::recycle_pages(const Slice<const PageId>& page_ids,
                                                        batt::Grant* grant, i32 depth)
+{
+  // Internal calls (depth > 0) come from the page deleter, on the worker holding the commit turn;
+  // the dead pages found by recycling a deferred batch are deferred as well.
+  //
+  return this->recycle_pages_impl(page_ids, grant, depth,
+                                  /*deferred=*/depth > 0 && this->committing_deferred_batch_);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<slot_offset_type> PageRecycler::recycle_pages_deferred(
+    const Slice<const PageId>& page_ids)
+{
+  return this->recycle_pages_impl(page_ids, /*grant=*/nullptr, /*depth=*/0, /*deferred=*/true);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<slot_offset_type> PageRecycler::recycle_pages_impl(const Slice<const PageId>& page_ids,
+                                                            batt::Grant* grant, i32 depth,
+                                                            bool deferred)
 {
   BATT_CHECK_GE(depth, 0);
 
   LLFS_VLOG(1) << "PageRecycler::recycle_pages(page_ids=" << batt::dump_range(page_ids) << "["
                << page_ids.size() << "]"
-               << ", grant=[" << (grant ? grant->size() : usize{0}) << "], depth=" << depth << ") "
-               << this->name_;
+               << ", grant=[" << (grant ? grant->size() : usize{0}) << "], depth=" << depth
+               << ", deferred=" << deferred << ") " << this->name_;
 
   if (page_ids.empty()) {
     return this->wal_device_->slot_range(LogReadMode::kDurable).upper_bound;
@@ -320,7 +382,7 @@ StatusOr<slot_offset_type> PageRecycler::recycle_pages(const Slice<const PageId>
       {
         auto locked_state = this->state_.lock();
         StatusOr<slot_offset_type> append_slot =
-            this->insert_to_log(*local_grant, page_id, depth, locked_state);
+            this->insert_to_log(*local_grant, page_id, depth, deferred, locked_state);
         BATT_REQUIRE_OK(append_slot);
 
         clamp_min_slot(&sync_point, *append_slot);
@@ -332,7 +394,7 @@ StatusOr<slot_offset_type> PageRecycler::recycle_pages(const Slice<const PageId>
     auto locked_state = this->state_.lock();
     for (PageId page_id : page_ids) {
       StatusOr<slot_offset_type> append_slot =
-          this->insert_to_log(*grant, page_id, depth, locked_state);
+          this->insert_to_log(*grant, page_id, depth, deferred, locked_state);
       BATT_REQUIRE_OK(append_slot);
 
       clamp_min_slot(&sync_point, *append_slot);
@@ -340,6 +402,8 @@ StatusOr<slot_offset_type> PageRecycler::recycle_pages(const Slice<const PageId>
   }
 
   BATT_CHECK(sync_point);
+  this->update_lag_metrics();
+
   return *sync_point;
 }
 
@@ -354,7 +418,7 @@ StatusOr<slot_offset_type> PageRecycler::recycle_page(PageId page_id, batt::Gran
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 StatusOr<slot_offset_type> PageRecycler::insert_to_log(
-    batt::Grant& grant, PageId page_id, i32 depth,
+    batt::Grant& grant, PageId page_id, i32 depth, bool deferred,
     batt::Mutex<std::unique_ptr<State>>::Lock& locked_state)
 {
   BATT_CHECK(locked_state.is_held());
@@ -370,6 +434,7 @@ StatusOr<slot_offset_type> PageRecycler::insert_to_log(
               .refresh_slot = None,
               .batch_slot = None,
               .depth = depth,
+              .deferred = deferred,
           },
           [&](const batt::SmallVecBase<PageToRecycle*>& to_append) -> StatusOr<slot_offset_type> {
             if (to_append.empty()) {
@@ -421,11 +486,17 @@ u64 PageRecycler::total_log_bytes_flushed() const
 //
 void PageRecycler::start_recycle_task()
 {
-  this->recycle_task_.emplace(/*executor=*/this->scheduler_.schedule_task(),
-                              [this] {
-                                this->recycle_task_main();
-                              },
-                              this->name_ + ".recycle_task");
+  const usize worker_count = this->recycle_task_grants_.size();
+
+  for (usize worker_index = 0; worker_index < worker_count; ++worker_index) {
+    this->recycle_tasks_.emplace_back(std::make_unique<batt::Task>(
+        /*executor=*/this->scheduler_.schedule_task(),
+        [this, worker_index] {
+          this->recycle_task_main(worker_index);
+        },
+        (worker_count == 1) ? this->name_ + ".recycle_task"
+                            : batt::to_string(this->name_, ".recycle_task", worker_index)));
+  }
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -439,42 +510,45 @@ void PageRecycler::refresh_grants()
 
   const PageRecyclerOptions& options = this->state_.no_lock().options;
 
-  LLFS_VLOG(1) << " -- " << BATT_INSPECT(this->recycle_task_grant_.size())
-               << BATT_INSPECT(options.recycle_task_target());
+  bool all_grants_full = true;
 
-  if (this->recycle_task_grant_.size() < options.recycle_task_target()) {
-    const auto target_delta =
-        std::min(available, options.recycle_task_target() - this->recycle_task_grant_.size());
+  for (const std::unique_ptr<batt::Grant>& recycle_task_grant : this->recycle_task_grants_) {
+    LLFS_VLOG(1) << " -- " << BATT_INSPECT(recycle_task_grant->size())
+                 << BATT_INSPECT(options.recycle_task_target());
 
-    available -= target_delta;
+    if (recycle_task_grant->size() < options.recycle_task_target()) {
+      const auto target_delta =
+          std::min(available, options.recycle_task_target() - recycle_task_grant->size());
 
-    StatusOr<batt::Grant> tmp =
-        this->slot_writer_.reserve(target_delta, batt::WaitForResource::kFalse);
+      available -= target_delta;
 
-    if (this->stop_requested_) {
-      return;
-    }
+      StatusOr<batt::Grant> tmp =
+          this->slot_writer_.reserve(target_delta, batt::WaitForResource::kFalse);
+
+      if (this->stop_requested_) {
+        return;
+      }
 
-    BATT_CHECK(tmp.ok()) << "this->recycle_task_grant_.size()= " << this->recycle_task_grant_.size()
-                         << " target_delta= " << target_delta;
+      BATT_CHECK(tmp.ok()) << "recycle_task_grant->size()= " << recycle_task_grant->size()
+                           << " target_delta= " << target_delta;
 
-    this->recycle_task_grant_.subsume(std::move(*tmp));
+      recycle_task_grant->subsume(std::move(*tmp));
+
+      if (recycle_task_grant->size() < options.recycle_task_target()) {
+        all_grants_full = false;
+      }
+    }
   }
 
   LLFS_VLOG(1) << " -- " << BATT_INSPECT(available) << " (after reserving for recycle_task)";
 
-  if (available > 0) {
-    const auto observed_recycle_task_grant_size = this->recycle_task_grant_.size();
-    const auto observed_recycle_task_target = options.recycle_task_target();
-
+  // The recycle task grants must take priority over the insert grant pool!
+  //
+  if (available > 0 && all_grants_full) {
     if (this->stop_requested_) {
       return;
     }
 
-    BATT_CHECK_EQ(observed_recycle_task_grant_size, observed_recycle_task_target)
-        << "The recycle task grant must take priority over the insert grant pool!"
-        << BATT_INSPECT(this->stop_requested_);
-
     StatusOr<batt::Grant> grant =
         this->slot_writer_.reserve(available, batt::WaitForResource::kFalse);
     if (!grant.ok()) {
@@ -491,86 +565,333 @@ void PageRecycler::refresh_grants()
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-void PageRecycler::recycle_task_main()
+void PageRecycler::recycle_task_main(usize worker_index)
 {
-  BATT_DEBUG_INFO("PageRecycler::recycle_task_main" << BATT_INSPECT_STR(this->name_));
+  BATT_DEBUG_INFO("PageRecycler::recycle_task_main" << BATT_INSPECT_STR(this->name_)
+                                                    << BATT_INSPECT(worker_index));
+
+  batt::Grant& recycle_task_grant = *this->recycle_task_grants_[worker_index];
 
   const auto on_return = batt::finally([this] {
     // Stop the slot writer to unblock any threads that might be waiting on WAL space to write a
-    // slot.  Since this is the task that drains the WAL, freeing up more space, these requests
-    // will never unblock once we return.
+    // slot.  Since the recycle tasks drain the WAL, freeing up more space, these requests will
+    // never unblock once we return.  For the same reason, the other workers must stop too: close
+    // the commit turn so none of them waits for this one.
     //
     this->slot_writer_.halt();
-    this->recycle_task_grant_.revoke();
+    for (const std::unique_ptr<batt::Grant>& grant : this->recycle_task_grants_) {
+      grant->revoke();
+    }
     this->insert_grant_pool_.revoke();
+    this->commit_turn_.close();
   });
 
-  this->recycle_task_status_ = [this]() -> Status {
-    const PageRecyclerOptions& options = this->state_.no_lock().options;
-
+  const Status recycle_task_status = [&]() -> Status {
     for (;;) {
-      if (BATT_HINT_TRUE(this->prepared_batch_)) {
-        Batch batch_to_commit = std::move(*this->prepared_batch_);
-        this->prepared_batch_ = None;
-
-        Status commit_status = commit_batch(batch_to_commit);
-        BATT_REQUIRE_OK(commit_status);
-
-        Status trim_status = this->trim_log();
-        BATT_REQUIRE_OK(trim_status);
-      }
+      // Take the next batch, in turn with the other workers.
+      //
+      u64 ticket = 0;
+      StatusOr<Batch> batch = [&] {
+        auto locked_ticket = this->next_batch_ticket_.lock();
+
+        ticket = *locked_ticket;
+        StatusOr<Batch> claimed = this->claim_batch(recycle_task_grant, ticket);
+        if (claimed.ok()) {
+          *locked_ticket += 1;
+        }
+        return claimed;
+      }();
+      BATT_REQUIRE_OK(batch);
 
-      // Wait for work.
+      // Batches must be committed in the order they were prepared.
       //
+      StatusOr<u64> commit_turn = LLFS_TRACE_SPAN_EXPR(
+          "recycler", "await_commit_turn",
+          this->commit_turn_.await_true([ticket](u64 observed_turn) {
+            return observed_turn == ticket;
+          }));
+      BATT_REQUIRE_OK(commit_turn);
+
+      Status commit_status = this->commit_batch(*batch, recycle_task_grant);
+      BATT_REQUIRE_OK(commit_status);
       {
-        BATT_DEBUG_INFO("waiting for pending PageToRecycle events;"
-                        << " latest_info_refresh_slot="
-                        << this->state_.no_lock().latest_info_refresh_slot.get_value()
-                        << " lru_slot=" << this->state_.lock()->get()->get_lru_slot()
-                        << BATT_INSPECT(this->latest_batch_upper_bound_)
-                        << BATT_INSPECT(this->wal_device_->slot_range(LogReadMode::kSpeculative))
-                        << BATT_INSPECT(this->wal_device_->slot_range(LogReadMode::kDurable)));
-
-        const usize observed_pending_count = this->state_.no_lock().pending_count.get_value();
-        if (observed_pending_count == 0) {
-          this->page_deleter_.notify_caught_up(*this,
-                                               this->slot_upper_bound(LogReadMode::kSpeculative));
-
-          StatusOr<usize> pending_count = this->state_.no_lock().pending_count.await_not_equal(0);
-          BATT_REQUIRE_OK(pending_count);
-        }
+        std::unique_lock<std::mutex> lock{this->pending_batch_mutex_};
+        BATT_CHECK(!this->pending_batch_slots_.empty());
+        this->pending_batch_slots_.pop_front();
       }
 
-      // De-queue the next page.  Block for the first page, then pull as many as we can after that
-      // from the same depth.
-      //
-      std::vector<PageToRecycle> to_recycle =
-          this->state_.lock()->get()->collect_batch(options.batch_size(), this->metrics_);
+      Status trim_status = this->trim_log(recycle_task_grant);
+      BATT_REQUIRE_OK(trim_status);
 
-      // We must write a PackedRecyclePagePrepare event to the WAL in case we need to recover from
-      // a crash.
-      //
-      StatusOr<PageRecycler::Batch> next_batch = this->prepare_batch(std::move(to_recycle));
-      BATT_REQUIRE_OK(next_batch);
-      this->prepared_batch_ = std::move(*next_batch);
+      this->update_lag_metrics();
+      this->commit_turn_.fetch_add(1);
     }
   }();
 
   if (this->stop_requested_.load() || this->pre_halt_.load()) {
     LLFS_VLOG(1) << "[PageRecycler::recycle_task] exited with status code= "
-                 << this->recycle_task_status_;
+                 << recycle_task_status << BATT_INSPECT(worker_index);
   } else {
     if (!suppress_log_output_for_test()) {
       LLFS_LOG_WARNING() << "[PageRecycler::recycle_task] exited, no stop requested; code= "
-                         << this->recycle_task_status_ << BATT_INSPECT(this->stop_requested_);
+                         << recycle_task_status << BATT_INSPECT(this->stop_requested_)
+                         << BATT_INSPECT(worker_index);
+    }
+    if (!this->failure_notified_.exchange(true)) {
+      this->page_deleter_.notify_failure(*this, recycle_task_status);
     }
-    this->page_deleter_.notify_failure(*this, this->recycle_task_status_);
   }
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-StatusOr<PageRecycler::Batch> PageRecycler::prepare_batch(std::vector<PageToRecycle>&& to_recycle)
+StatusOr<PageRecycler::Batch> PageRecycler::claim_batch(batt::Grant& grant, u64 ticket)
+{
+  LLFS_TRACE_SPAN("recycler", "claim_batch");
+
+  // Recovered batches go first; they are already in `pending_batch_slots_`.
+  //
+  if (!this->recovered_batches_.empty()) {
+    Batch recovered_batch = std::move(this->recovered_batches_.front());
+    this->recovered_batches_.pop_front();
+
+    this->page_deleter_.prefetch_pages(as_slice(recovered_batch.to_recycle));
+
+    return recovered_batch;
+  }
+
+  const PageRecyclerOptions& options = this->state_.no_lock().options;
+
+  // Wait for work.
+  //
+  bool deferred = false;
+  {
+    BATT_DEBUG_INFO("waiting for pending PageToRecycle events;"
+                    << " latest_info_refresh_slot="
+                    << this->state_.no_lock().latest_info_refresh_slot.get_value()
+                    << " lru_slot=" << this->state_.lock()->get()->get_lru_slot()
+                    << BATT_INSPECT(ticket) << BATT_INSPECT(this->commit_turn_.get_value())
+                    << BATT_INSPECT(this->wal_device_->slot_range(LogReadMode::kSpeculative))
+                    << BATT_INSPECT(this->wal_device_->slot_range(LogReadMode::kDurable)));
+
+    for (;;) {
+      const usize pending_count = this->state_.no_lock().pending_count.get_value();
+
+      if (pending_count == 0) {
+        // Committing the batches ahead of this one may produce more pages to recycle, so we aren't
+        // caught up until they are all done.
+        //
+        if (this->commit_turn_.get_value() != ticket) {
+          StatusOr<u64> commit_turn = this->commit_turn_.await_true([ticket](u64 observed_turn) {
+            return observed_turn == ticket;
+          });
+          BATT_REQUIRE_OK(commit_turn);
+          continue;
+        }
+
+        this->page_deleter_.notify_caught_up(*this,
+                                             this->slot_upper_bound(LogReadMode::kSpeculative));
+
+        StatusOr<usize> new_pending_count =
+            this->state_.no_lock().pending_count.await_not_equal(0);
+        BATT_REQUIRE_OK(new_pending_count);
+        continue;
+      }
+
+      // Pages that aren't deferred always go first.
+      //
+      if (pending_count > this->state_.no_lock().deferred_count.get_value()) {
+        break;
+      }
+
+      StatusOr<bool> deferred_ready = this->await_deferred_budget();
+      BATT_REQUIRE_OK(deferred_ready);
+
+      if (*deferred_ready) {
+        deferred = true;
+        break;
+      }
+    }
+  }
+
+  // Pace the background lane; this may wait, but only ever with work to do.
+  //
+  StatusOr<bool> urgent = this->await_recycle_budget();
+  BATT_REQUIRE_OK(urgent);
+
+  // De-queue the next page.  Block for the first page, then pull as many as we can after that
+  // from the same depth.
+  //
+  std::vector<PageToRecycle> to_recycle;
+  {
+    auto locked_state = this->state_.lock();
+
+    to_recycle =
+        locked_state->get()->collect_batch(options.batch_size(), this->metrics_, deferred);
+    this->consume_recycle_budget(to_recycle.size(), *urgent, deferred);
+
+    // The pages are no longer in the LRU list, so hold back the log trim point at their oldest
+    // record until the batch is committed.  This happens under the state lock (as does the
+    // calculation of the trim point), so the pages are always covered by one or the other.
+    //
+    slot_offset_type pending_slot = this->slot_writer_.slot_offset();
+    for (const PageToRecycle& page : to_recycle) {
+      if (page.refresh_slot && slot_less_than(*page.refresh_slot, pending_slot)) {
+        pending_slot = *page.refresh_slot;
+      }
+    }
+
+    std::unique_lock<std::mutex> lock{this->pending_batch_mutex_};
+    this->pending_batch_slots_.emplace_back(pending_slot);
+  }
+
+  // We must write a PackedRecyclePagePrepare event to the WAL in case we need to recover from
+  // a crash.
+  //
+  return this->prepare_batch(std::move(to_recycle), grant);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<bool> PageRecycler::await_recycle_budget()
+{
+  // Sleep in short steps while waiting for the rate limit, so that a drop in free space (which
+  // moves us to the urgent lane) or a halt request is noticed promptly.
+  //
+  static constexpr auto kMaxThrottleSleep = std::chrono::milliseconds(10);
+
+  const PageRecyclerOptions& options = this->state_.no_lock().options;
+
+  for (;;) {
+    if (this->stop_requested_) {
+      return Status{batt::StatusCode::kCancelled};
+    }
+
+    if (options.is_urgent(this->page_deleter_.free_page_ratio())) {
+      return true;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (options.max_background_pages_per_second() == 0 ||
+        now >= this->next_background_batch_time_) {
+      return false;
+    }
+
+    const i64 delay_usec = std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::min<std::chrono::steady_clock::duration>(
+                                   this->next_background_batch_time_ - now, kMaxThrottleSleep))
+                               .count();
+
+    this->metrics_.throttle_delay_usec.add(delay_usec);
+
+    batt::Task::sleep(boost::posix_time::microseconds(delay_usec));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<bool> PageRecycler::await_deferred_budget()
+{
+  static constexpr auto kMaxThrottleSleep = std::chrono::milliseconds(10);
+
+  const NoLockState& no_lock_state = this->state_.no_lock();
+
+  for (;;) {
+    if (this->stop_requested_) {
+      return Status{batt::StatusCode::kCancelled};
+    }
+
+    // Only this worker removes pages right now, so if more pages are pending than deferred ones,
+    // some other pages have arrived; those go first.
+    //
+    if (no_lock_state.pending_count.get_value() > no_lock_state.deferred_count.get_value()) {
+      return false;
+    }
+
+    if (no_lock_state.options.is_urgent(this->page_deleter_.free_page_ratio())) {
+      return true;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= this->next_deferred_batch_time_) {
+      return true;
+    }
+
+    const i64 delay_usec = std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::min<std::chrono::steady_clock::duration>(
+                                   this->next_deferred_batch_time_ - now, kMaxThrottleSleep))
+                               .count();
+
+    this->metrics_.throttle_delay_usec.add(delay_usec);
+
+    batt::Task::sleep(boost::posix_time::microseconds(delay_usec));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageRecycler::consume_recycle_budget(usize page_count, bool urgent, bool deferred)
+{
+  const PageRecyclerOptions& options = this->state_.no_lock().options;
+  const auto now = std::chrono::steady_clock::now();
+
+  if (deferred) {
+    this->metrics_.deferred_batch_count.add(1);
+    if (!urgent) {
+      this->next_deferred_batch_time_ =
+          std::max(this->next_deferred_batch_time_, now) +
+          std::chrono::microseconds(page_count * 1000 * 1000 /
+                                    options.max_deferred_pages_per_second());
+    }
+  }
+
+  if (urgent) {
+    this->metrics_.urgent_batch_count.add(1);
+    return;
+  }
+  this->metrics_.background_batch_count.add(1);
+
+  const u64 pages_per_second = options.max_background_pages_per_second();
+  if (pages_per_second == 0) {
+    return;
+  }
+
+  // Charge the batch against the budget starting no earlier than now, so that an idle period
+  // doesn't let a burst through afterwards.
+  //
+  this->next_background_batch_time_ =
+      std::max(this->next_background_batch_time_, now) +
+      std::chrono::microseconds(page_count * 1000 * 1000 / pages_per_second);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageRecycler::update_lag_metrics()
+{
+  this->metrics_.lag_page_count.set(this->state_.no_lock().pending_count.get_value());
+  this->metrics_.lag_log_bytes.set(this->wal_device_->size());
+  this->metrics_.lag_deferred_page_count.set(this->state_.no_lock().deferred_count.get_value());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<slot_offset_type> PageRecycler::get_pending_batch_slot() const
+{
+  std::unique_lock<std::mutex> lock{this->pending_batch_mutex_};
+
+  Optional<slot_offset_type> pending_slot;
+  for (slot_offset_type slot : this->pending_batch_slots_) {
+    if (!pending_slot || slot_less_than(slot, *pending_slot)) {
+      pending_slot = slot;
+    }
+  }
+  return pending_slot;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<PageRecycler::Batch> PageRecycler::prepare_batch(std::vector<PageToRecycle>&& to_recycle,
+                                                          batt::Grant& grant)
 {
   LLFS_VLOG(1) << "Preparing Batch: " << batt::dump_range(to_recycle);
 
@@ -578,6 +899,12 @@ StatusOr<PageRecycler::Batch> PageRecycler::prepare_batch(std::vector<PageToRecy
 
   const i32 first_page_depth = to_recycle.empty() ? 0 : to_recycle.front().depth;
 
+  // Start loading all the pages in the batch right away, so that the reads overlap with the WAL
+  // flush below and with the commits of any batches ahead of this one; `commit_batch` will need
+  // them to trace their refs.
+  //
+  this->page_deleter_.prefetch_pages(as_slice(to_recycle));
+
   Batch batch{
       .depth = first_page_depth,
 
@@ -602,18 +929,17 @@ StatusOr<PageRecycler::Batch> PageRecycler::prepare_batch(std::vector<PageToRecy
 
     LLFS_VLOG(1) << "[PageRecycler::recycle_task] writing batch_slot: " << next_page
                  << BATT_INSPECT(batch.slot_offset)
-                 << BATT_INSPECT(this->recycle_task_grant_.size()) << " " << this->name_;
+                 << BATT_INSPECT(grant.size()) << " " << this->name_;
 
-    StatusOr<SlotRange> append_slot =
-        this->slot_writer_.append(this->recycle_task_grant_, next_page);
+    StatusOr<SlotRange> append_slot = this->slot_writer_.append(grant, next_page);
 
-    if (!append_slot.ok() && this->stop_requested_ && this->recycle_task_grant_.size() == 0) {
+    if (!append_slot.ok() && this->stop_requested_ && grant.size() == 0) {
       return append_slot.status();
     }
 
     BATT_REQUIRE_OK(append_slot) << (suppress_log_output_for_test() ? batt::LogLevel::kVerbose
                                                                     : batt::LogLevel::kWarning)
-                                 << BATT_INSPECT(this->recycle_task_grant_.size())
+                                 << BATT_INSPECT(grant.size())
                                  << BATT_INSPECT(this->slot_writer_.pool_size())
                                  << BATT_INSPECT(options.recycle_task_target())
                                  << BATT_INSPECT(this->stop_requested_);
@@ -631,10 +957,17 @@ StatusOr<PageRecycler::Batch> PageRecycler::prepare_batch(std::vector<PageToRecy
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-Status PageRecycler::commit_batch(const Batch& batch)
+Status PageRecycler::commit_batch(const Batch& batch, batt::Grant& grant)
 {
   LLFS_VLOG(1) << "Committing Batch: " << batch;
 
+  TraceSpan span{"recycler", "commit_batch", /*arg=*/batch.to_recycle.size()};
+
+  this->committing_deferred_batch_ = !batch.to_recycle.empty() && batch.to_recycle.front().deferred;
+  const auto on_return = batt::finally([this] {
+    this->committing_deferred_batch_ = false;
+  });
+
   // Recycle the pages inside a job.
   //
   Status commit_status = with_retry_policy(
@@ -645,7 +978,7 @@ Status PageRecycler::commit_batch(const Batch& batch)
         const usize page_count = batch.to_recycle.size();
         Status delete_result =
             this->page_deleter_.delete_pages(as_slice(batch.to_recycle), *this, batch.slot_offset,
-                                             this->recycle_task_grant_, batch.depth);
+                                             grant, batch.depth);
         if (delete_result.ok()) {
           LLFS_VLOG(1) << "delete OK: " << batt::dump_range(batch.to_recycle);
           this->metrics_.page_drop_ok_count.fetch_add(page_count);
@@ -665,22 +998,22 @@ Status PageRecycler::commit_batch(const Batch& batch)
   }
 
   LLFS_VLOG(1) << "[PageRecycler::commit_batch] delete_pages OK; "
-               << BATT_INSPECT(this->recycle_task_grant_.size())
-               << BATT_INSPECT(this->stop_requested_);
+               << BATT_INSPECT(grant.size()) << BATT_INSPECT(this->stop_requested_);
 
   // Write the Committed slot.  This will be after any dead pages generated by committing the batch
   // because that happened on the same task inside `page_deleter_.delete_pages`, and we are writing
   // to same WAL.
   //
   StatusOr<SlotRange> append_slot =
-      this->slot_writer_.append(this->recycle_task_grant_, PackedRecycleBatchCommit{
-                                                               .batch_slot = batch.slot_offset,
-                                                           });
+      this->slot_writer_.append(grant, PackedRecycleBatchCommit{
+                                           .batch_slot = batch.slot_offset,
+                                       });
   BATT_REQUIRE_OK(append_slot);
 
   LLFS_VLOG(1) << "[PageRecycler::commit_batch] append Commit slot OK";
 
-  Status flush_status = this->await_flush(append_slot->upper_bound);
+  Status flush_status = LLFS_TRACE_SPAN_EXPR("recycler", "await_commit_flush",
+                                             this->await_flush(append_slot->upper_bound));
   BATT_REQUIRE_OK(flush_status);
 
   this->latest_batch_upper_bound_ = append_slot->upper_bound;
@@ -692,31 +1025,112 @@ Status PageRecycler::commit_batch(const Batch& batch)
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-Status PageRecycler::trim_log()
+Status PageRecycler::checkpoint_if_needed()
+{
+  const PageRecyclerOptions& options = this->state_.no_lock().options;
+
+  if (options.checkpoint_interval() == 0) {
+    return OkStatus();
+  }
+
+  Optional<slot_offset_type> sync_point;
+  {
+    auto locked_state = this->state_.lock();
+    State& state = *locked_state->get();
+
+    const Optional<slot_offset_type> lru_slot = state.get_lru_slot();
+    if (!lru_slot || slot_distance(*lru_slot, this->slot_writer_.slot_offset()) <
+                         options.checkpoint_interval()) {
+      return OkStatus();
+    }
+
+    const usize page_count = state.queued_page_count();
+
+    // Only use spare log space; we must never wait here, since the insert grant pool is refilled by
+    // trimming the log.
+    //
+    StatusOr<batt::Grant> checkpoint_grant = this->insert_grant_pool_.spend(
+        options.checkpoint_size(page_count), batt::WaitForResource::kFalse);
+
+    if (!checkpoint_grant.ok()) {
+      if (this->stop_requested_) {
+        return ::llfs::make_status(StatusCode::kRecyclerStopped);
+      }
+      LLFS_VLOG(1) << "[PageRecycler::checkpoint_if_needed] not enough log space; skipping"
+                   << BATT_INSPECT(page_count) << BATT_INSPECT(this->insert_grant_pool_.size());
+      this->metrics_.checkpoint_skip_count.add(1);
+      return OkStatus();
+    }
+
+    StatusOr<usize> checkpointed = state.checkpoint(
+        PageRecyclerOptions::kMaxPagesPerCheckpointSlot,
+        [&](const Slice<const PageToRecycle>& pages) -> StatusOr<SlotRange> {
+          StatusOr<SlotRange> append_slot = this->slot_writer_.append(
+              *checkpoint_grant, PageRecyclerCheckpoint{.pages = pages});
+          BATT_REQUIRE_OK(append_slot);
+
+          clamp_min_slot(&sync_point, append_slot->upper_bound);
+          return append_slot;
+        });
+    BATT_REQUIRE_OK(checkpointed);
+    BATT_CHECK_EQ(*checkpointed, page_count);
+
+    this->metrics_.checkpoint_count.add(1);
+    this->metrics_.checkpoint_page_count.add(page_count);
+  }
+
+  LLFS_VLOG(1) << "[PageRecycler::checkpoint_if_needed] wrote checkpoint; "
+               << BATT_INSPECT(sync_point);
+
+  // The records superseded by the checkpoint must not be trimmed until it is durable.
+  //
+  return this->await_flush(sync_point);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageRecycler::trim_log(batt::Grant& grant)
 {
   LLFS_VLOG(1) << "[PageRecycler::trim_log]";
 
   const PageRecyclerOptions& options = this->state_.no_lock().options;
   const boost::uuids::uuid& recycler_uuid = this->state_.no_lock().uuid;
 
-  // Calculate the highest safe trim offset.  We can't go above "lru_slot" (if there is one) or
-  // "latest_batch_upper_bound" (if there is one).
+  Status checkpoint_status = this->checkpoint_if_needed();
+  BATT_REQUIRE_OK(checkpoint_status);
+
+  // Calculate the highest safe trim offset.  We can't go above "lru_slot" (if there is one),
+  // "latest_batch_upper_bound" (if there is one), or the oldest slot of any batch that other
+  // workers have claimed but not yet committed.
   //
   slot_offset_type latest_info_slot = this->state_.no_lock().latest_info_refresh_slot.get_value();
 
-  const Optional<slot_offset_type> lru_slot = this->state_.lock()->get()->get_lru_slot();
+  Optional<slot_offset_type> lru_slot;
+  Optional<slot_offset_type> pending_batch_slot;
+  {
+    auto locked_state = this->state_.lock();
+
+    lru_slot = locked_state->get()->get_lru_slot();
+    pending_batch_slot = this->get_pending_batch_slot();
+  }
 
   const slot_offset_type trim_point = [&] {
-    if (lru_slot && this->latest_batch_upper_bound_) {
-      return slot_min(*lru_slot, *this->latest_batch_upper_bound_);
-    }
-    if (lru_slot) {
-      BATT_CHECK(!this->latest_batch_upper_bound_);
-      return lru_slot.value_or(latest_info_slot);
-    } else {
-      BATT_CHECK(this->latest_batch_upper_bound_);
-      return this->latest_batch_upper_bound_.value_or(latest_info_slot);
+    slot_offset_type result = [&] {
+      if (lru_slot && this->latest_batch_upper_bound_) {
+        return slot_min(*lru_slot, *this->latest_batch_upper_bound_);
+      }
+      if (lru_slot) {
+        BATT_CHECK(!this->latest_batch_upper_bound_);
+        return lru_slot.value_or(latest_info_slot);
+      } else {
+        BATT_CHECK(this->latest_batch_upper_bound_);
+        return this->latest_batch_upper_bound_.value_or(latest_info_slot);
+      }
+    }();
+    if (pending_batch_slot) {
+      result = slot_min(result, *pending_batch_slot);
     }
+    return result;
   }();
 
   // Check to see if we need to refresh the info slot.
@@ -725,12 +1139,12 @@ Status PageRecycler::trim_log()
       trim_point > latest_info_slot) {
     LLFS_VLOG(1) << "[PageRecycler::recycle_task] refreshing info slot; "
                  << BATT_INSPECT(latest_info_slot) << BATT_INSPECT(lru_slot)
-                 << BATT_INSPECT(this->latest_batch_upper_bound_) << BATT_INSPECT(trim_point)
+                 << BATT_INSPECT(this->latest_batch_upper_bound_)
+                 << BATT_INSPECT(pending_batch_slot) << BATT_INSPECT(trim_point)
                  << BATT_INSPECT(this->wal_device_->slot_range(LogReadMode::kSpeculative))
                  << BATT_INSPECT(this->wal_device_->slot_range(LogReadMode::kDurable));
 
-    StatusOr<batt::Grant> info_slot_grant =
-        this->recycle_task_grant_.spend(options.info_slot_size());
+    StatusOr<batt::Grant> info_slot_grant = grant.spend(options.info_slot_size());
 
     if (!info_slot_grant.ok()) {
       BATT_CHECK(this->stop_requested_);
@@ -764,7 +1178,7 @@ Status PageRecycler::trim_log()
   Status trim_status = this->slot_writer_.trim(trim_point).status();
   BATT_REQUIRE_OK(trim_status);
 
-  // Top off WAL grants; first the recycle task grant, then the insert grant pool.
+  // Top off WAL grants; first the recycle task grants, then the insert grant pool.
   //
   this->refresh_grants();
 
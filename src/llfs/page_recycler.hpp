@@ -24,6 +24,7 @@
 #include <batteries/async/mutex.hpp>
 #include <batteries/async/task.hpp>
 #include <batteries/async/task_scheduler.hpp>
+#include <batteries/async/watch.hpp>
 #include <batteries/metrics/metric_collectors.hpp>
 #include <batteries/small_vec.hpp>
 
@@ -32,8 +33,14 @@
 #include <boost/uuid/uuid.hpp>
 
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_set>
+#include <vector>
 
 namespace llfs {
 
@@ -53,6 +60,33 @@ class PageRecycler
     CountMetric<u64> remove_count{0};
     CountMetric<u64> page_drop_ok_count{0};
     CountMetric<u64> page_drop_error_count{0};
+
+    // The number of batches prepared in each lane (see PageRecyclerOptions).
+    //
+    CountMetric<u64> urgent_batch_count{0};
+    CountMetric<u64> background_batch_count{0};
+
+    // The total time spent waiting for the background lane's (or the deferred drop) rate limit.
+    //
+    CountMetric<u64> throttle_delay_usec{0};
+
+    // How far behind the recycler is: the number of pages waiting to be recycled, and the number
+    // of bytes of recycler log that hold them (and the batches in progress).
+    //
+    GaugeMetric<u64> lag_page_count{0};
+    GaugeMetric<u64> lag_log_bytes{0};
+
+    // The number of batches of deferred drop pages, and how many such pages are waiting.
+    //
+    CountMetric<u64> deferred_batch_count{0};
+    GaugeMetric<u64> lag_deferred_page_count{0};
+
+    // The number of checkpoints written (see PageRecyclerOptions::checkpoint_interval), the total
+    // number of pages they refreshed, and the number skipped for lack of spare log space.
+    //
+    CountMetric<u64> checkpoint_count{0};
+    CountMetric<u64> checkpoint_page_count{0};
+    CountMetric<u64> checkpoint_skip_count{0};
   };
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -107,6 +141,13 @@ class PageRecycler
   StatusOr<slot_offset_type> recycle_pages(const Slice<const PageId>& page_ids,
                                            batt::Grant* grant = nullptr, i32 depth = 0);
 
+  // Like `recycle_pages`, but records the pages as deferred drops: they (and any pages they turn
+  // out to be the last reference to) are only recycled when there is nothing else to do, at
+  // `max_deferred_pages_per_second`, or as fast as possible once free space is below the urgent
+  // watermark.  Use this to drop the root of a very large tree without a long recycling burst.
+  //
+  StatusOr<slot_offset_type> recycle_pages_deferred(const Slice<const PageId>& page_ids);
+
   // Schedule a single page to be recycled.  \see recycle_pages
   //
   StatusOr<slot_offset_type> recycle_page(PageId page_id, batt::Grant* grant = nullptr,
@@ -164,6 +205,41 @@ class PageRecycler
   //
   //   O(kMaxPageRefDepth * kMaxPageRefsPerNode)
   //
+  // Workers:
+  //
+  // The work of the recycle task can be spread over several tasks (`worker_count` in
+  // PageRecyclerOptions).  Each worker takes a turn preparing a batch (pulling pages from the state
+  // machine and writing them to the WAL), then tells the PageDeleter to start loading the batch's
+  // pages, and then waits for the batches prepared before it to be committed before committing its
+  // own.  So commits (and log trimming) remain strictly serialized in batch order -- this is
+  // required because each PageAllocator only accepts ref count updates from a given recycler in
+  // increasing batch slot order -- but batch preparation and page loading overlap the PageAllocator
+  // transactions of the batches ahead.  Every uncommitted batch bounds the log trim point, so any
+  // number of them can be recovered after a crash.
+  //
+  // Pacing:
+  //
+  // Each batch runs in one of two lanes.  While PageDeleter::free_page_ratio is above the urgent
+  // watermark (PageRecyclerOptions::urgent_free_page_percent), batches run in the background lane,
+  // which is limited to `max_background_pages_per_second` so the recycler doesn't compete with
+  // foreground I/O; below the watermark, batches run in the urgent lane, as fast as possible.
+  //
+  // Deferred drops:
+  //
+  // Pages passed to `recycle_pages_deferred` are kept in a second stack, and so are the dead pages
+  // found by recycling them.  Deferred pages are only collected when no other pages are pending,
+  // at `max_deferred_pages_per_second` (on top of the lane limits above) unless the urgent lane is
+  // active, so a huge dropped tree is walked a little at a time, as free space is needed.  The
+  // deferred flag is part of each page's log record, so it survives recovery.
+  //
+  // Checkpoints:
+  //
+  // With a large backlog, refreshing one record per insert takes a long time to move the trim
+  // point, so most of the log (and therefore most of recovery's replay) is old records.  If
+  // `checkpoint_interval` is set, then whenever the oldest queued page's record falls that far
+  // behind, the worker holding the commit turn re-writes all queued pages at once in a few compact
+  // PageRecyclerCheckpoint slots (a bulk refresh), and the log is trimmed up to them.
+  //
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
   struct Batch {
@@ -195,27 +271,67 @@ class PageRecycler
   u64 total_log_bytes_flushed() const;
 
  private:
+  StatusOr<slot_offset_type> recycle_pages_impl(const Slice<const PageId>& page_ids,
+                                                batt::Grant* grant, i32 depth, bool deferred);
+
   explicit PageRecycler(batt::TaskScheduler& scheduler, const std::string& name,
                         PageDeleter& page_deleter, std::unique_ptr<LogDevice>&& wal_device,
-                        Optional<Batch>&& recovered_batch,
+                        std::vector<Batch>&& recovered_batches,
                         std::unique_ptr<PageRecycler::State>&& state) noexcept;
 
   void start_recycle_task();
 
-  void recycle_task_main();
+  void recycle_task_main(usize worker_index);
 
-  // MUST be called only on the recycle task or the ctor.
+  // Returns the next batch for a worker to commit: a recovered batch, if any are left; otherwise a
+  // newly prepared one.  `ticket` is the batch's position in the commit order.  Blocks until there
+  // is work to do.  MUST be called only while holding `next_batch_ticket_`.
+  //
+  StatusOr<Batch> claim_batch(batt::Grant& grant, u64 ticket);
+
+  // Decides which lane (urgent or background) the next batch runs in, and if it is the background
+  // lane, waits until the rate limit allows another batch.  Returns true iff the lane is urgent.
+  // MUST be called only while holding `next_batch_ticket_`.
+  //
+  StatusOr<bool> await_recycle_budget();
+
+  // Called when only deferred pages are pending; waits until the deferred rate limit allows another
+  // batch.  Returns true if a deferred batch should be collected now, false if other pages have
+  // become pending in the meantime.  MUST be called only while holding `next_batch_ticket_`.
+  //
+  StatusOr<bool> await_deferred_budget();
+
+  // Charges a newly collected batch of `page_count` pages to the lane it runs in (and to the
+  // deferred budget, if it is `deferred`).  MUST be called only while holding `next_batch_ticket_`.
+  //
+  void consume_recycle_budget(usize page_count, bool urgent, bool deferred);
+
+  void update_lag_metrics();
+
+  // MUST be called only on a recycle task (while it holds the commit turn) or the ctor.
   //
   void refresh_grants();
 
+  // Returns the lowest batch slot of all batches that have been prepared but not yet committed.
+  //
+  Optional<slot_offset_type> get_pending_batch_slot() const;
+
   StatusOr<slot_offset_type> insert_to_log(batt::Grant& grant, PageId page_id, i32 depth,
+                                           bool deferred,
                                            batt::Mutex<std::unique_ptr<State>>::Lock& locked_state);
 
-  StatusOr<Batch> prepare_batch(std::vector<PageToRecycle>&& to_recycle);
+  StatusOr<Batch> prepare_batch(std::vector<PageToRecycle>&& to_recycle, batt::Grant& grant);
 
-  Status commit_batch(const Batch& batch);
+  Status commit_batch(const Batch& batch, batt::Grant& grant);
 
-  Status trim_log();
+  // Writes a checkpoint of all queued pages if the oldest of their records is at least
+  // `checkpoint_interval` bytes behind the end of the log, and waits for it to be flushed.  Does
+  // nothing if there isn't enough spare log space.  MUST be called only by the worker holding the
+  // commit turn.
+  //
+  Status checkpoint_if_needed();
+
+  Status trim_log(batt::Grant& grant);
 
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
@@ -235,21 +351,64 @@ class PageRecycler
 
   TypedSlotWriter<PageRecycleEvent> slot_writer_;
 
-  batt::Grant recycle_task_grant_;
+  // One grant per worker; each is topped off to `options.recycle_task_target()` before any of the
+  // remaining log space goes to the insert grant pool.
+  //
+  std::vector<std::unique_ptr<batt::Grant>> recycle_task_grants_;
 
   batt::Grant insert_grant_pool_;
 
   batt::Mutex<std::unique_ptr<State>> state_;
 
-  Status recycle_task_status_;
-
-  Optional<batt::Task> recycle_task_;
+  std::vector<std::unique_ptr<batt::Task>> recycle_tasks_;
 
   Metrics metrics_;
 
-  Optional<Batch> prepared_batch_;
+  // Serializes batch preparation; holds the commit order position (ticket) of the next batch to be
+  // claimed by a worker.
+  //
+  batt::Mutex<u64> next_batch_ticket_{0};
+
+  // Batches recovered from the log, in the order they must be committed; protected by
+  // `next_batch_ticket_`.
+  //
+  std::deque<Batch> recovered_batches_;
+
+  // The ticket of the next batch to be committed.
+  //
+  batt::Watch<u64> commit_turn_{0};
+
+  // Protects `pending_batch_slots_`.
+  //
+  mutable std::mutex pending_batch_mutex_;
+
+  // The batch slots of all batches claimed by workers but not yet committed, in commit order.
+  //
+  std::deque<slot_offset_type> pending_batch_slots_;
+
+  // The earliest time at which the next background lane batch may be collected; protected by
+  // `next_batch_ticket_`.
+  //
+  std::chrono::steady_clock::time_point next_background_batch_time_;
+
+  // The earliest time at which the next batch of deferred pages may be collected (outside the
+  // urgent lane); protected by `next_batch_ticket_`.
+  //
+  std::chrono::steady_clock::time_point next_deferred_batch_time_;
 
+  // Set by the first worker to report a failure to the PageDeleter.
+  //
+  std::atomic<bool> failure_notified_{false};
+
+  // Only accessed by the worker holding the commit turn.
+  //
   Optional<slot_offset_type> latest_batch_upper_bound_;
+
+  // True while the worker holding the commit turn is committing a batch of deferred pages, so
+  // that the dead pages it finds (see `recycle_pages`, depth > 0) are deferred too.  Only accessed
+  // by the worker holding the commit turn.
+  //
+  bool committing_deferred_batch_ = false;
 };
 
 inline std::ostream& operator<<(std::ostream& out, const PageRecycler::Batch& t)
@@ -20,7 +20,11 @@
 #include <batteries/async/runtime.hpp>
 #include <batteries/stream_util.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <random>
 #include <unordered_map>
 #include <vector>
@@ -93,6 +97,15 @@ class MockPageDeleter : public llfs::PageDeleter
               (const Slice<const PageToRecycle>& to_delete, PageRecycler& recycler,
                slot_offset_type caller_slot, batt::Grant& recycle_grant, i32 recycle_depth),
               (override));
+
+  double free_page_ratio() override
+  {
+    return this->free_page_ratio_value.load();
+  }
+
+  // The value returned by free_page_ratio(); tests may change it at any time.
+  //
+  std::atomic<double> free_page_ratio_value{1.0};
 };
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
@@ -167,7 +180,7 @@ class PageRecyclerTest : public ::testing::Test
     std::sort(this->fake_page_root_set_.begin(), this->fake_page_root_set_.end());
   }
 
-  void run_crash_recovery_test();
+  void run_crash_recovery_test(usize worker_count, u64 seed_count, u64 checkpoint_interval = 0);
 
   u64 get_log_size() const noexcept
   {
@@ -214,8 +227,9 @@ class PageRecyclerTest : public ::testing::Test
 
   void save_log_snapshot()
   {
-    this->mem_log_snapshot_ =
-        llfs::LogDeviceSnapshot::from_device(*this->p_mem_log_, llfs::LogReadMode::kDurable);
+    this->mem_log_snapshot_ = llfs::LogDeviceSnapshot::from_device(
+        *this->p_mem_log_, llfs::LogReadMode::kDurable,
+        /*base=*/this->mem_log_snapshot_ ? &*this->mem_log_snapshot_ : nullptr);
   }
 
   // Returns a matcher for a single-page slice passed to `PageDeleter::delete_pages`.
@@ -424,7 +438,7 @@ TEST_F(PageRecyclerTest, CrashRecovery)
 
   batt::Task task{io.get_executor(),
                   [this] {
-                    this->run_crash_recovery_test();
+                    this->run_crash_recovery_test(/*worker_count=*/1, /*seed_count=*/10000);
                   },
                   "PageRecyclerTest_CrashRecovery"};
 
@@ -433,13 +447,55 @@ TEST_F(PageRecyclerTest, CrashRecovery)
   task.join();
 }
 
-void PageRecyclerTest::run_crash_recovery_test()
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Same as CrashRecovery, but with frequent checkpoints (so the simulated crash can also happen in
+// the middle of writing one).
+//
+TEST_F(PageRecyclerTest, CrashRecoveryWithCheckpoints)
+{
+  boost::asio::io_context io;
+
+  batt::Task task{io.get_executor(),
+                  [this] {
+                    this->run_crash_recovery_test(/*worker_count=*/2, /*seed_count=*/2000,
+                                                  /*checkpoint_interval=*/512);
+                  },
+                  "PageRecyclerTest_CrashRecoveryWithCheckpoints"};
+
+  ASSERT_NO_FATAL_FAILURE(io.run());
+
+  task.join();
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Same as CrashRecovery, but with several recycle workers, so that there may be more than one
+// prepared batch in the log when the simulated crash happens.
+//
+TEST_F(PageRecyclerTest, CrashRecoveryMultiWorker)
+{
+  boost::asio::io_context io;
+
+  batt::Task task{io.get_executor(),
+                  [this] {
+                    this->run_crash_recovery_test(/*worker_count=*/3, /*seed_count=*/2000);
+                  },
+                  "PageRecyclerTest_CrashRecoveryMultiWorker"};
+
+  ASSERT_NO_FATAL_FAILURE(io.run());
+
+  task.join();
+}
+
+void PageRecyclerTest::run_crash_recovery_test(usize worker_count, u64 seed_count,
+                                               u64 checkpoint_interval)
 {
   const usize fake_page_count = 256;
   const u32 max_branching_factor = 8;
 
   const auto options = llfs::PageRecyclerOptions{}  //
-                           .set_max_refs_per_page(max_branching_factor);
+                           .set_max_refs_per_page(max_branching_factor)
+                           .set_worker_count(worker_count)
+                           .set_checkpoint_interval(checkpoint_interval);
 
   const u64 log_size = PageRecycler::calculate_log_size(options);
   LLFS_VLOG(1) << BATT_INSPECT(log_size);
@@ -447,7 +503,7 @@ void PageRecyclerTest::run_crash_recovery_test()
   EXPECT_GE(PageRecycler::calculate_max_buffered_page_count(options, log_size),
             PageRecycler::default_max_buffered_page_count(options));
 
-  for (u64 seed = 0; seed < 10000; ++seed) {
+  for (u64 seed = 0; seed < seed_count; ++seed) {
     std::default_random_engine rng{seed};
     for (usize i = 0; i < 10; ++i) {
       (void)rng();
@@ -891,4 +947,304 @@ TEST_F(PageRecyclerTest, NoRefreshBatchedPage)
   EXPECT_EQ(page_0_insert_or_refresh_count, 1u);
 }
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// While there is plenty of free space, batches run in the background lane at no more than
+// `max_background_pages_per_second`; once free space drops below the urgent watermark, they run in
+// the urgent lane without waiting.
+//
+TEST_F(PageRecyclerTest, BackgroundRateLimit)
+{
+  constexpr usize kPagesPerSecond = 100;
+  constexpr usize kPagesPerLane = 6;
+
+  this->recycler_options_  //
+      .set_batch_size(1)
+      .set_max_background_pages_per_second(kPagesPerSecond)
+      .set_urgent_free_page_percent(10);
+
+  batt::Task test_task{
+      batt::Runtime::instance().schedule_task(), [&] {
+        batt::Status recovery = this->recover_page_recycler();
+        ASSERT_TRUE(recovery.ok()) << BATT_INSPECT(recovery);
+
+        batt::Watch<usize> delete_count{0};
+
+        EXPECT_CALL(this->mock_deleter_,
+                    delete_pages(/*to_recycle=*/::testing::_, ::testing::Ref(*this->recycler_),
+                                 /*caller_slot=*/testing::_,
+                                 /*recycle_grant=*/testing::_, /*recycle_depth=*/0))
+            .WillRepeatedly(::testing::InvokeWithoutArgs([&] {
+              delete_count.fetch_add(1);
+              return batt::OkStatus();
+            }));
+
+        // Background lane.
+        //
+        const auto start_time = std::chrono::steady_clock::now();
+
+        for (usize i = 0; i < kPagesPerLane; ++i) {
+          ASSERT_TRUE(this->recycler_->recycle_page(this->fake_page_id_[i]).ok());
+        }
+        ASSERT_TRUE(delete_count.await_equal(kPagesPerLane).ok());
+
+        // The first batch goes right away; each batch after it must wait for the one before.
+        //
+        EXPECT_GE(std::chrono::steady_clock::now() - start_time,
+                  std::chrono::milliseconds((kPagesPerLane - 1) * 1000 / kPagesPerSecond));
+
+        EXPECT_EQ(this->recycler_->metrics().background_batch_count.load(), kPagesPerLane);
+        EXPECT_EQ(this->recycler_->metrics().urgent_batch_count.load(), 0u);
+        EXPECT_GT(this->recycler_->metrics().throttle_delay_usec.load(), 0u);
+
+        // Urgent lane.
+        //
+        this->mock_deleter_.free_page_ratio_value.store(0.05);
+
+        for (usize i = kPagesPerLane; i < kPagesPerLane * 2; ++i) {
+          ASSERT_TRUE(this->recycler_->recycle_page(this->fake_page_id_[i]).ok());
+        }
+        ASSERT_TRUE(delete_count.await_equal(kPagesPerLane * 2).ok());
+
+        EXPECT_EQ(this->recycler_->metrics().background_batch_count.load(), kPagesPerLane);
+        EXPECT_EQ(this->recycler_->metrics().urgent_batch_count.load(), kPagesPerLane);
+      }};
+
+  test_task.join();
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// A deferred drop is recycled at no more than `max_deferred_pages_per_second`, the dead pages found
+// by recycling it are deferred too, and pages passed to `recycle_pages` go ahead of them.
+//
+TEST_F(PageRecyclerTest, DeferredDrop)
+{
+  constexpr usize kDeferredPagesPerSecond = 10;
+  constexpr usize kChildCount = 3;
+
+  this->recycler_options_  //
+      .set_batch_size(1)
+      .set_max_deferred_pages_per_second(kDeferredPagesPerSecond);
+
+  const PageId root_id = this->fake_page_id_[0];
+  const PageId other_id = this->fake_page_id_[1];
+  const std::vector<PageId> child_ids(this->fake_page_id_.begin() + 2,
+                                      this->fake_page_id_.begin() + 2 + kChildCount);
+
+  batt::Task test_task{
+      batt::Runtime::instance().schedule_task(), [&] {
+        batt::Status recovery = this->recover_page_recycler();
+        ASSERT_TRUE(recovery.ok()) << BATT_INSPECT(recovery);
+
+        std::mutex deleted_mutex;
+        std::vector<PageToRecycle> deleted;
+        std::vector<std::chrono::steady_clock::time_point> delete_times;
+        batt::Watch<usize> delete_count{0};
+
+        EXPECT_CALL(this->mock_deleter_,
+                    delete_pages(/*to_recycle=*/::testing::_, ::testing::Ref(*this->recycler_),
+                                 /*caller_slot=*/testing::_,
+                                 /*recycle_grant=*/testing::_, /*recycle_depth=*/testing::_))
+            .WillRepeatedly(::testing::Invoke(
+                [&](const Slice<const PageToRecycle>& to_delete, PageRecycler& recycler,
+                    slot_offset_type /*caller_slot*/, batt::Grant& recycle_grant,
+                    i32 recycle_depth) -> Status {
+                  {
+                    std::unique_lock<std::mutex> lock{deleted_mutex};
+                    deleted.insert(deleted.end(), to_delete.begin(), to_delete.end());
+                    delete_times.emplace_back(std::chrono::steady_clock::now());
+                  }
+                  if (to_delete.size() == 1 && to_delete[0].page_id == root_id) {
+                    BATT_REQUIRE_OK(recycler.recycle_pages(batt::as_slice(child_ids),
+                                                           &recycle_grant, recycle_depth + 1));
+                  }
+                  delete_count.fetch_add(to_delete.size());
+                  return batt::OkStatus();
+                }));
+
+        ASSERT_TRUE(this->recycler_->recycle_pages_deferred(batt::as_slice(&root_id, 1)).ok());
+        ASSERT_TRUE(delete_count.await_equal(1).ok());
+
+        // The root's children are now pending, but deferred; this page goes first.
+        //
+        ASSERT_TRUE(this->recycler_->recycle_page(other_id).ok());
+        ASSERT_TRUE(delete_count.await_equal(2 + kChildCount).ok());
+
+        std::unique_lock<std::mutex> lock{deleted_mutex};
+
+        ASSERT_EQ(deleted.size(), 2 + kChildCount);
+
+        EXPECT_EQ(deleted[0].page_id, root_id);
+        EXPECT_TRUE(deleted[0].deferred);
+        EXPECT_EQ(deleted[1].page_id, other_id);
+        EXPECT_FALSE(deleted[1].deferred);
+
+        std::vector<PageId> deleted_child_ids;
+        for (usize i = 2; i < deleted.size(); ++i) {
+          EXPECT_TRUE(deleted[i].deferred);
+          EXPECT_EQ(deleted[i].depth, 1);
+          deleted_child_ids.emplace_back(deleted[i].page_id);
+        }
+        EXPECT_THAT(deleted_child_ids, ::testing::UnorderedElementsAreArray(child_ids));
+
+        // Each deferred page after the root must wait for the one before.
+        //
+        EXPECT_GE(delete_times.back() - delete_times.front(),
+                  std::chrono::milliseconds((kChildCount - 1) * 1000 / kDeferredPagesPerSecond));
+
+        EXPECT_EQ(this->recycler_->metrics().deferred_batch_count.load(), 1 + kChildCount);
+      }};
+
+  test_task.join();
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// With a checkpoint interval, the first trim after a backlog has built up writes a checkpoint of
+// all the queued pages and trims the log past their older records; recovery from the trimmed log
+// still finds every queued page.
+//
+TEST_F(PageRecyclerTest, CheckpointTrimsRefreshRecords)
+{
+  this->recycler_options_  //
+      .set_batch_size(1)
+      .set_checkpoint_interval(1);
+
+  const usize queued_page_count = this->fake_page_id_.size() - 1;
+
+  batt::Task test_task{
+      batt::Runtime::instance().schedule_task(), [&] {
+        {
+          batt::Status recovery = this->recover_page_recycler();
+          ASSERT_TRUE(recovery.ok()) << BATT_INSPECT(recovery);
+        }
+
+        std::atomic<usize> call_count{0};
+        batt::Watch<bool> all_inserted{false};
+        PageId first_deleted_id;
+
+        // Hold up the first batch until all the other pages are queued behind it, then simulate a
+        // crash while the second batch is being committed.
+        //
+        EXPECT_CALL(this->mock_deleter_,
+                    delete_pages(/*to_recycle=*/::testing::_, ::testing::Ref(*this->recycler_),
+                                 /*caller_slot=*/testing::_,
+                                 /*recycle_grant=*/testing::_, /*recycle_depth=*/0))
+            .WillRepeatedly(::testing::Invoke(
+                [&](const batt::Slice<const llfs::PageToRecycle>& to_delete,
+                    llfs::PageRecycler& /*recycler*/, llfs::slot_offset_type /*caller_slot*/,
+                    batt::Grant& /*recycle_grant*/, i32 /*recycle_depth*/) -> batt::Status {
+                  const usize call_i = call_count.fetch_add(1);
+                  if (call_i == 0) {
+                    BATT_CHECK_EQ(to_delete.size(), 1u);
+                    first_deleted_id = to_delete[0].page_id;
+                    BATT_CHECK_OK(all_inserted.await_equal(true));
+                    return batt::OkStatus();
+                  }
+                  if (call_i == 1) {
+                    this->save_log_snapshot();
+                    this->recycler_->halt();
+                  }
+                  return batt::StatusCode::kClosed;
+                }));
+
+        for (PageId page_id : this->fake_page_id_) {
+          batt::StatusOr<llfs::slot_offset_type> result = this->recycler_->recycle_page(page_id);
+          ASSERT_TRUE(result.ok()) << BATT_INSPECT(result);
+
+          batt::Status flush_status = this->recycler_->await_flush(*result);
+          ASSERT_TRUE(flush_status.ok()) << BATT_INSPECT(flush_status);
+        }
+        all_inserted.set_value(true);
+
+        this->recycler_->join();
+
+        EXPECT_EQ(this->recycler_->metrics().checkpoint_count.load(), 1u);
+        EXPECT_EQ(this->recycler_->metrics().checkpoint_page_count.load(), queued_page_count);
+        EXPECT_EQ(this->recycler_->metrics().checkpoint_skip_count.load(), 0u);
+
+        this->p_mem_log_ = nullptr;
+        this->unique_page_recycler_ = nullptr;
+        this->recycler_ = nullptr;
+
+        ASSERT_TRUE(this->mem_log_snapshot_);
+
+        // The log should start (more or less) at the checkpoint: no insert or refresh records
+        // before it, and all the queued pages in it.
+        //
+        {
+          llfs::MemoryLogDevice mem_log2{this->get_log_size()};
+          mem_log2.restore_snapshot(*this->mem_log_snapshot_, llfs::LogReadMode::kDurable);
+
+          std::unique_ptr<llfs::LogDevice::Reader> log_reader =
+              mem_log2.new_reader(/*slot_lower_bound=*/batt::None, llfs::LogReadMode::kDurable);
+          llfs::TypedSlotReader<llfs::PageRecycleEvent> slot_reader{*log_reader};
+
+          bool checkpoint_seen = false;
+          usize records_before_checkpoint = 0;
+          usize checkpointed_page_count = 0;
+
+          slot_reader
+              .run(batt::WaitForResource::kFalse,
+                   /*visitor=*/batt::make_case_of_visitor(
+                       [&](const llfs::SlotParse& /*slot*/,
+                           const llfs::PageToRecycle& inserted) -> batt::Status {
+                         if (!checkpoint_seen && !inserted.batch_slot) {
+                           records_before_checkpoint += 1;
+                         }
+                         return batt::OkStatus();
+                       },
+                       [&](const llfs::SlotParse& /*slot*/,
+                           const llfs::PackedPageRecyclerCheckpoint& checkpoint) -> batt::Status {
+                         checkpoint_seen = true;
+                         checkpointed_page_count += checkpoint.pages.size();
+                         return batt::OkStatus();
+                       },
+                       [](const llfs::SlotParse& /*slot*/, const auto& /*event*/) {
+                         return batt::OkStatus();
+                       }))
+              .IgnoreError();
+
+          EXPECT_TRUE(checkpoint_seen);
+          EXPECT_EQ(records_before_checkpoint, 0u);
+          EXPECT_EQ(checkpointed_page_count, queued_page_count);
+        }
+
+        // Recover a new recycler from the snapshot; every page but the first one should be deleted
+        // exactly once.
+        //
+        {
+          batt::Status recovery = this->recover_page_recycler(/*start=*/false);
+          ASSERT_TRUE(recovery.ok()) << BATT_INSPECT(recovery);
+        }
+
+        std::map<PageId, usize> post_recovery_deletions;
+        batt::Watch<usize> delete_count{0};
+
+        EXPECT_CALL(this->mock_deleter_,
+                    delete_pages(/*to_recycle=*/::testing::_, ::testing::Ref(*this->recycler_),
+                                 /*caller_slot=*/testing::_,
+                                 /*recycle_grant=*/testing::_, /*recycle_depth=*/0))
+            .WillRepeatedly(::testing::Invoke(
+                [&](const batt::Slice<const llfs::PageToRecycle>& to_delete,
+                    llfs::PageRecycler& /*recycler*/, llfs::slot_offset_type /*caller_slot*/,
+                    batt::Grant& /*recycle_grant*/, i32 /*recycle_depth*/) -> batt::Status {
+                  for (const llfs::PageToRecycle& p : to_delete) {
+                    post_recovery_deletions[p.page_id] += 1;
+                  }
+                  delete_count.fetch_add(to_delete.size());
+                  return batt::OkStatus();
+                }));
+
+        this->recycler_->start();
+
+        BATT_CHECK_OK(delete_count.await_equal(queued_page_count));
+
+        for (PageId page_id : this->fake_page_id_) {
+          EXPECT_EQ(post_recovery_deletions[page_id], (page_id == first_deleted_id) ? 0u : 1u)
+              << BATT_INSPECT(page_id);
+        }
+      }};
+
+  test_task.join();
+}
+
 }  // namespace
@@ -18,7 +18,8 @@ namespace llfs {
 std::ostream& operator<<(std::ostream& out, const PageToRecycle& t)
 {
   return out << "PageToRecycle{.page_id=" << t.page_id << ", .refresh_slot=" << t.refresh_slot
-             << ", .batch_slot=" << t.batch_slot << ", .depth=" << t.depth << ",}";
+             << ", .batch_slot=" << t.batch_slot << ", .depth=" << t.depth
+             << ", .deferred=" << t.deferred << ",}";
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -34,6 +35,13 @@ std::ostream& operator<<(std::ostream& out, const PackedRecycleBatchCommit& t)
   return out << "Commit{.batch_slot=" << t.batch_slot << ",}";
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, const PackedPageRecyclerCheckpoint& t)
+{
+  return out << "Checkpoint{.pages.size()=" << t.pages.size() << ",}";
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 PackedPageRecyclerInfo PackedPageRecyclerInfo::from(const boost::uuids::uuid& uuid,
@@ -10,9 +10,12 @@
 #ifndef LLFS_PAGE_RECYCLER_EVENTS_HPP
 #define LLFS_PAGE_RECYCLER_EVENTS_HPP
 
+#include <llfs/array_packer.hpp>
 #include <llfs/data_layout.hpp>
 #include <llfs/data_reader.hpp>
+#include <llfs/packed_array.hpp>
 #include <llfs/page_layout.hpp>
+#include <llfs/slice.hpp>
 #include <llfs/slot.hpp>
 
 #include <batteries/static_assert.hpp>
@@ -36,6 +39,11 @@ struct PageToRecycle {
   //
   i32 depth;
 
+  // True iff this page belongs to a deferred drop (see PageRecycler::recycle_pages_deferred); such
+  // pages are only recycled when there is nothing else to do, or free space is running low.
+  //
+  bool deferred;
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   static PageToRecycle make_invalid()
@@ -45,6 +53,7 @@ struct PageToRecycle {
         .refresh_slot = None,
         .batch_slot = None,
         .depth = 0,
+        .deferred = false,
     };
   }
 
@@ -75,11 +84,13 @@ class PageRecyclerOptions;
 struct PackedPageToRecycle;
 struct PackedRecycleBatchCommit;
 struct PackedPageRecyclerInfo;
+struct PackedPageRecyclerCheckpoint;
 
 using PageRecycleEvent = PackedVariant<  //
     PackedPageToRecycle,                 //
     PackedRecycleBatchCommit,            //
-    PackedPageRecyclerInfo               //
+    PackedPageRecyclerInfo,              //
+    PackedPageRecyclerCheckpoint         //
     >;
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -125,6 +136,7 @@ std::ostream& operator<<(std::ostream& out, const PackedPageRecyclerInfo& t);
 struct PackedPageToRecycle {
   enum Flags : u8 {
     kHasBatchSlot = 0x01,
+    kDeferred = 0x02,
   };
 
   little_page_id_int page_id;
@@ -155,6 +167,9 @@ inline bool pack_object_to(const PageToRecycle& from, PackedPageToRecycle* to, D
   to->depth = from.depth;
   to->flags = 0;
   std::memset(&to->reserved_, 0, sizeof(PackedPageToRecycle::reserved_));
+  if (from.deferred) {
+    to->flags |= PackedPageToRecycle::kDeferred;
+  }
   if (from.batch_slot) {
     to->flags |= PackedPageToRecycle::kHasBatchSlot;
     to->batch_slot = *from.batch_slot;
@@ -176,6 +191,7 @@ inline StatusOr<PageToRecycle> unpack_object(const PackedPageToRecycle& packed,
         return None;
       }(),
       .depth = packed.depth,
+      .deferred = (packed.flags & PackedPageToRecycle::kDeferred) != 0,
   };
 }
 
@@ -214,6 +230,61 @@ inline slot_offset_type get_slot_offset(const PackedRecycleBatchCommit& commit)
   return commit.batch_slot.value();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+// A bulk refresh of queued pages: writing a checkpoint slot has the same effect as writing one
+// PackedPageToRecycle refresh record at the checkpoint's slot offset for each page in `pages`, but
+// is much more compact.  Checkpoints let the recycler trim the log past the older records of all
+// the pages they contain (see PageRecyclerOptions::checkpoint_interval).
+//
+struct PageRecyclerCheckpoint {
+  // The pages to refresh; none of these may have a batch slot.
+  //
+  Slice<const PageToRecycle> pages;
+};
+
+struct PackedPageRecyclerCheckpoint {
+  PackedArray<PackedPageToRecycle> pages;
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedPageRecyclerCheckpoint),
+                      sizeof(PackedArray<PackedPageToRecycle>));
+
+LLFS_DEFINE_PACKED_TYPE_FOR(PageRecyclerCheckpoint, PackedPageRecyclerCheckpoint);
+
+inline usize packed_sizeof_page_recycler_checkpoint(usize page_count)
+{
+  return packed_array_size<PackedPageToRecycle>(page_count);
+}
+
+inline usize packed_sizeof(const PageRecyclerCheckpoint& checkpoint)
+{
+  return packed_sizeof_page_recycler_checkpoint(checkpoint.pages.size());
+}
+
+inline usize packed_sizeof(const PackedPageRecyclerCheckpoint& checkpoint)
+{
+  return packed_sizeof_page_recycler_checkpoint(checkpoint.pages.size());
+}
+
+template <typename Dst>
+inline bool pack_object_to(const PageRecyclerCheckpoint& from, PackedPageRecyclerCheckpoint* to,
+                           Dst* dst)
+{
+  to->pages.initialize(0u);
+
+  BasicArrayPacker<PackedPageToRecycle, Dst> array_packer{&to->pages, dst};
+  for (const PageToRecycle& page : from.pages) {
+    BATT_CHECK(!page.batch_slot);
+    if (!array_packer.pack_item(page)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::ostream& operator<<(std::ostream& out, const PackedPageRecyclerCheckpoint& t);
+
 }  // namespace llfs
 
 #endif  // LLFS_PAGE_RECYCLER_EVENTS_HPP
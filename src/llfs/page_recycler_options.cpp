@@ -49,6 +49,49 @@ PageRecyclerOptions& PageRecyclerOptions::set_refresh_factor(usize value) noexce
   return *this;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageRecyclerOptions& PageRecyclerOptions::set_worker_count(usize value) noexcept
+{
+  BATT_CHECK_GT(value, 0) << "worker_count must be >0";
+  this->worker_count_ = BATT_CHECKED_CAST(u32, value);
+  return *this;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageRecyclerOptions& PageRecyclerOptions::set_max_background_pages_per_second(u64 value) noexcept
+{
+  this->max_background_pages_per_second_ = value;
+  return *this;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageRecyclerOptions& PageRecyclerOptions::set_urgent_free_page_percent(usize value) noexcept
+{
+  BATT_CHECK_LE(value, 100) << "urgent_free_page_percent must be <=100";
+  this->urgent_free_page_percent_ = value;
+  return *this;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageRecyclerOptions& PageRecyclerOptions::set_max_deferred_pages_per_second(u64 value) noexcept
+{
+  BATT_CHECK_GT(value, 0) << "max_deferred_pages_per_second must be >0";
+  this->max_deferred_pages_per_second_ = value;
+  return *this;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageRecyclerOptions& PageRecyclerOptions::set_checkpoint_interval(u64 value) noexcept
+{
+  this->checkpoint_interval_ = value;
+  return *this;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 usize PageRecyclerOptions::insert_grant_size() const
@@ -98,6 +141,22 @@ usize PageRecyclerOptions::commit_slot_size() const
           kMaxSlotHeaderSize);
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize PageRecyclerOptions::checkpoint_size(usize page_count) const
+{
+  const usize full_slot_count = page_count / kMaxPagesPerCheckpointSlot;
+  const usize last_slot_page_count = page_count % kMaxPagesPerCheckpointSlot;
+
+  const auto slot_size = [](usize n) -> usize {
+    return packed_sizeof<PackedVariant<>>() + packed_sizeof_page_recycler_checkpoint(n) +
+           kMaxSlotHeaderSize;
+  };
+
+  return full_slot_count * slot_size(kMaxPagesPerCheckpointSlot) +
+         ((last_slot_page_count != 0) ? slot_size(last_slot_page_count) : 0);
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 u64 PageRecyclerOptions::recycle_task_target() const
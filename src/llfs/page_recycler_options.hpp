@@ -24,6 +24,12 @@ class PageRecyclerOptions
   static constexpr usize kDefaultMaxRefsPerPage = 1 * kMiB;
   static constexpr usize kDefaultBatchSize = 24;
   static constexpr usize kDefaultRefreshFactor = 2;
+  static constexpr usize kDefaultWorkerCount = 1;
+  static constexpr u64 kDefaultMaxBackgroundPagesPerSecond = 0;
+  static constexpr usize kDefaultUrgentFreePagePercent = 10;
+  static constexpr u64 kDefaultMaxDeferredPagesPerSecond = 100;
+  static constexpr u64 kDefaultCheckpointInterval = 0;
+  static constexpr usize kMaxPagesPerCheckpointSlot = 1024;
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
@@ -42,6 +48,16 @@ class PageRecyclerOptions
 
   Self& set_refresh_factor(usize value) noexcept;
 
+  Self& set_worker_count(usize value) noexcept;
+
+  Self& set_max_background_pages_per_second(u64 value) noexcept;
+
+  Self& set_urgent_free_page_percent(usize value) noexcept;
+
+  Self& set_max_deferred_pages_per_second(u64 value) noexcept;
+
+  Self& set_checkpoint_interval(u64 value) noexcept;
+
   // (setters - end)
   //----- --- -- -  -  -   -
 
@@ -65,6 +81,39 @@ class PageRecyclerOptions
     return this->refresh_factor_;
   }
 
+  usize worker_count() const noexcept
+  {
+    return this->worker_count_;
+  }
+
+  u64 max_background_pages_per_second() const noexcept
+  {
+    return this->max_background_pages_per_second_;
+  }
+
+  usize urgent_free_page_percent() const noexcept
+  {
+    return this->urgent_free_page_percent_;
+  }
+
+  u64 max_deferred_pages_per_second() const noexcept
+  {
+    return this->max_deferred_pages_per_second_;
+  }
+
+  u64 checkpoint_interval() const noexcept
+  {
+    return this->checkpoint_interval_;
+  }
+
+  // Returns true iff the recycler should run in the urgent lane (i.e., without rate limiting),
+  // given the current fraction of free pages reported by the PageDeleter.
+  //
+  bool is_urgent(double free_page_ratio) const noexcept
+  {
+    return free_page_ratio * 100.0 < static_cast<double>(this->urgent_free_page_percent_);
+  }
+
   // The log space needed to insert a single page.
   //
   usize insert_grant_size() const;
@@ -92,6 +141,11 @@ class PageRecyclerOptions
   //
   usize commit_slot_size() const;
 
+  // The total size of the checkpoint slots needed to refresh `page_count` queued pages (at most
+  // kMaxPagesPerCheckpointSlot per slot).
+  //
+  usize checkpoint_size(usize page_count) const;
+
   // The target grant for the recycle task to maintain.
   //
   u64 recycle_task_target() const;
@@ -122,6 +176,51 @@ class PageRecyclerOptions
   // example, refresh_factor = 2 means that for each page inserted, one is inserted.
   //
   usize refresh_factor_ = kDefaultRefreshFactor;
+
+  // The number of recycle tasks.  Each task prepares its own batch (and starts loading its pages)
+  // while the batches ahead of it are being committed; commits are still done one at a time, in
+  // batch order.  Each task needs its own `recycle_task_target()` of log space.
+  //
+  // This is a runtime option; it is not stored in the recycler info slot, so it can be changed
+  // from one recovery to the next.
+  //
+  usize worker_count_ = kDefaultWorkerCount;
+
+  // The maximum rate at which the recycler recycles pages while there is plenty of free space (the
+  // "background" lane); each recycled page costs at least one page read plus its share of the
+  // PageAllocator updates, so this is the recycler's I/O budget.  0 means no limit.
+  //
+  // This is a runtime option (not stored in the recycler info slot).
+  //
+  u64 max_background_pages_per_second_ = kDefaultMaxBackgroundPagesPerSecond;
+
+  // When the fraction of free pages (see PageDeleter::free_page_ratio) drops below this percentage,
+  // the recycler switches to the "urgent" lane and runs as fast as it can, ignoring
+  // `max_background_pages_per_second_`, until free space is back above the watermark.
+  //
+  // This is a runtime option (not stored in the recycler info slot).
+  //
+  usize urgent_free_page_percent_ = kDefaultUrgentFreePagePercent;
+
+  // The maximum rate at which pages from deferred drops (see PageRecycler::recycle_pages_deferred)
+  // are recycled while there is plenty of free space and nothing else to recycle.  Must be >0, so
+  // that deferred drops always finish (and release their log space) eventually.
+  //
+  // This is a runtime option (not stored in the recycler info slot).
+  //
+  u64 max_deferred_pages_per_second_ = kDefaultMaxDeferredPagesPerSecond;
+
+  // If non-zero, whenever the oldest record of a queued page is at least this many bytes behind
+  // the end of the log, the recycler writes a checkpoint (see PageRecyclerCheckpoint) of all the
+  // queued pages, so the log can be trimmed past their older records.  This bounds how much of the
+  // log recovery has to replay (roughly one interval plus the checkpoint itself), no matter how
+  // large the backlog of pending pages is.  Checkpoints only use spare log space: if there isn't
+  // enough when one is due, it is skipped until the next trim.  0 (the default) disables
+  // checkpoints; the log is then trimmed only as records are refreshed one by one.
+  //
+  // This is a runtime option (not stored in the recycler info slot).
+  //
+  u64 checkpoint_interval_ = kDefaultCheckpointInterval;
 };
 
 }  // namespace llfs
@@ -26,7 +26,7 @@ namespace llfs {
     const PageRecyclerOptions& default_options) noexcept
     : options_{default_options}
     , recovered_pages_{}
-    , latest_batch_{}
+    , pending_batches_{}
     , recycler_uuid_{boost::uuids::random_generator{}()}
     , latest_info_refresh_slot_{}
 {
@@ -83,18 +83,14 @@ std::vector<PageToRecycle> PageRecyclerRecoveryVisitor::recovered_pages() const
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-StatusOr<Optional<PageRecycler::Batch>> PageRecyclerRecoveryVisitor::consume_latest_batch()
+StatusOr<std::vector<PageRecycler::Batch>> PageRecyclerRecoveryVisitor::consume_pending_batches()
 {
-  LLFS_VLOG(1) << "consuming latest batch: " << this->latest_batch_;
+  LLFS_VLOG(1) << "consuming pending batches: " << batt::dump_range(this->pending_batches_);
 
-  if (!this->latest_batch_) {
-    return {None};
-  }
-
-  PageRecycler::Batch consumed_batch = std::move(*this->latest_batch_);
-  this->latest_batch_ = None;
+  std::vector<PageRecycler::Batch> consumed_batches = std::move(this->pending_batches_);
+  this->pending_batches_.clear();
 
-  return {std::move(consumed_batch)};
+  return {std::move(consumed_batches)};
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -117,7 +113,7 @@ Status PageRecyclerRecoveryVisitor::operator()(const SlotParse& slot,
                                                const PageToRecycle& recovered)
 {
   LLFS_VLOG(1) << "Recovered slot: " << slot.offset << " " << recovered
-               << BATT_INSPECT((bool)this->latest_batch_);
+               << BATT_INSPECT(this->pending_batches_.size());
 
   // Add the new record, or verify that the existing one and the new one are equivalent.
   //
@@ -130,6 +126,7 @@ Status PageRecyclerRecoveryVisitor::operator()(const SlotParse& slot,
     PageToRecycle& existing_record = iter->second;
 
     BATT_CHECK_EQ(existing_record.depth, recovered.depth);
+    BATT_CHECK_EQ(existing_record.deferred, recovered.deferred);
     BATT_CHECK(existing_record.refresh_slot &&
                !slot_less_than(slot.offset.lower_bound, *existing_record.refresh_slot))
         << BATT_INSPECT(existing_record) << BATT_INSPECT(recovered);
@@ -144,26 +141,33 @@ Status PageRecyclerRecoveryVisitor::operator()(const SlotParse& slot,
   to_recycle.refresh_slot = slot.offset.lower_bound;
 
   if (to_recycle.batch_slot) {
-    if (this->latest_batch_) {
-      if (this->latest_batch_->slot_offset != *to_recycle.batch_slot) {
+    // Batches are prepared one at a time, so all the pages of a batch are written before any page
+    // of the next batch; thus a page either belongs to the newest pending batch, or starts a new
+    // one.
+    //
+    if (!this->pending_batches_.empty() &&
+        !slot_less_than(this->pending_batches_.back().slot_offset, *to_recycle.batch_slot)) {
+      PageRecycler::Batch& latest_batch = this->pending_batches_.back();
+
+      if (latest_batch.slot_offset != *to_recycle.batch_slot) {
         LLFS_LOG_WARNING() << "kTooManyPendingBatchesDuringRecovery" << BATT_INSPECT(to_recycle)
-                           << BATT_INSPECT(*this->latest_batch_);
+                           << BATT_INSPECT(latest_batch);
         return ::llfs::make_status(StatusCode::kTooManyPendingBatchesDuringRecovery);
       }
-      if (this->latest_batch_->depth != to_recycle.depth) {
+      if (latest_batch.depth != to_recycle.depth) {
         LLFS_LOG_WARNING() << "Inconsistent batch depth;" << BATT_INSPECT(to_recycle)
-                           << BATT_INSPECT(*this->latest_batch_);
+                           << BATT_INSPECT(latest_batch);
         return batt::StatusCode::kInternal;  // TODO [tastolfi 2023-03-20]
       }
     } else {
-      this->latest_batch_.emplace();
-      this->latest_batch_->slot_offset = *to_recycle.batch_slot;
-      this->latest_batch_->depth = to_recycle.depth;
-      LLFS_VLOG(1) << " -- Starting batch: " << this->latest_batch_;
+      this->pending_batches_.emplace_back();
+      this->pending_batches_.back().slot_offset = *to_recycle.batch_slot;
+      this->pending_batches_.back().depth = to_recycle.depth;
+      LLFS_VLOG(1) << " -- Starting batch: " << this->pending_batches_.back();
     }
 
-    BATT_CHECK(this->latest_batch_.has_value());
-    this->latest_batch_->to_recycle.emplace_back(to_recycle);
+    BATT_CHECK(!this->pending_batches_.empty());
+    this->pending_batches_.back().to_recycle.emplace_back(to_recycle);
   }
 
   return OkStatus();
@@ -176,15 +180,21 @@ Status PageRecyclerRecoveryVisitor::operator()(const SlotParse& slot,
 {
   LLFS_VLOG(1) << "Recovered slot: " << slot.offset << " " << commit;
 
-  // It's OK if the latest prepared batch has been trimmed off the log; but if we *can* see it,
-  // then validate that the batch slots match here.
+  // Batches are committed in slot order, so a commit always matches the oldest pending batch.  It's
+  // OK if the prepared batch has been trimmed off the log (this can happen even when there are
+  // pending batches, since the next batch may be prepared before the current one is committed);
+  // but if we *can* see it, then validate that the batch slots match here.
   //
-  if (this->latest_batch_) {
-    if (this->latest_batch_->slot_offset != commit.batch_slot) {
+  if (!this->pending_batches_.empty() &&
+      !slot_less_than(commit.batch_slot, this->pending_batches_.front().slot_offset)) {
+    if (this->pending_batches_.front().slot_offset != commit.batch_slot) {
       LLFS_LOG_WARNING() << "kInvalidBatchCommitDuringRecovery: "
-                         << BATT_INSPECT(*this->latest_batch_) << BATT_INSPECT(commit.batch_slot);
+                         << BATT_INSPECT(this->pending_batches_.front())
+                         << BATT_INSPECT(commit.batch_slot);
       return llfs::make_status(StatusCode::kInvalidBatchCommitDuringRecovery);
     }
+    LLFS_VLOG(1) << "Clearing" << BATT_INSPECT(this->pending_batches_.front());
+    this->pending_batches_.erase(this->pending_batches_.begin());
   } else {
     if (slot_less_or_equal(this->trim_pos_, commit.batch_slot)) {
       LLFS_LOG_WARNING()
@@ -192,8 +202,6 @@ Status PageRecyclerRecoveryVisitor::operator()(const SlotParse& slot,
           << BATT_INSPECT(slot) << BATT_INSPECT(commit);
     }
   }
-  LLFS_VLOG(1) << "Clearing" << BATT_INSPECT(this->latest_batch_);
-  this->latest_batch_ = None;
   return OkStatus();
 }
 
@@ -218,4 +226,29 @@ Status PageRecyclerRecoveryVisitor::operator()(const SlotParse& slot,
   return OkStatus();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageRecyclerRecoveryVisitor::operator()(const SlotParse& slot,
+                                               const PackedPageRecyclerCheckpoint& checkpoint)
+{
+  LLFS_VLOG(1) << "Recovered slot: " << slot.offset << " " << checkpoint;
+
+  // A checkpoint is the same as a refresh record for each of its pages, all at the same slot.
+  //
+  for (const PackedPageToRecycle& packed_page : checkpoint.pages) {
+    StatusOr<PageToRecycle> page = unpack_object(packed_page, /*reader=*/nullptr);
+    BATT_REQUIRE_OK(page);
+
+    if (page->batch_slot) {
+      LLFS_LOG_WARNING() << "Found a batched page in a PackedPageRecyclerCheckpoint"
+                         << BATT_INSPECT(slot) << BATT_INSPECT(*page);
+      return batt::StatusCode::kDataLoss;
+    }
+
+    BATT_REQUIRE_OK((*this)(slot, *page));
+  }
+
+  return OkStatus();
+}
+
 }  // namespace llfs
@@ -39,7 +39,10 @@ class PageRecyclerRecoveryVisitor
 
   std::vector<PageToRecycle> recovered_pages() const;
 
-  StatusOr<Optional<PageRecycler::Batch>> consume_latest_batch();
+  /** \brief Returns all batches for which no PackedRecycleBatchCommit event was found, in slot
+   * order (which is the order in which they must be committed).
+   */
+  StatusOr<std::vector<PageRecycler::Batch>> consume_pending_batches();
 
   const boost::uuids::uuid& recycler_uuid() const;
 
@@ -50,6 +53,7 @@ class PageRecyclerRecoveryVisitor
   Status operator()(const SlotParse&, const PageToRecycle& to_recycle);
   Status operator()(const SlotParse&, const PackedRecycleBatchCommit& commit);
   Status operator()(const SlotParse&, const PackedPageRecyclerInfo& info);
+  Status operator()(const SlotParse&, const PackedPageRecyclerCheckpoint& checkpoint);
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
@@ -67,10 +71,10 @@ class PageRecyclerRecoveryVisitor
    */
   std::unordered_map<PageId, PageToRecycle, PageId::Hash> recovered_pages_;
 
-  /** \brief The most recent (highest slot offset) batch for which no PackedRecycleBatchCommit event
-   * has yet been seen.
+  /** \brief The batches for which no PackedRecycleBatchCommit event has yet been seen, in slot
+   * order.  There can be more than one if the recycler was running with multiple workers.
    */
-  Optional<PageRecycler::Batch> latest_batch_;
+  std::vector<PageRecycler::Batch> pending_batches_;
 
   /** \brief The recycler UUID, as read in the most recent recycler info slot.
    */
@@ -33,6 +33,7 @@ PageRecycler::State::State(const boost::uuids::uuid& uuid,
     , arena_{}
     , pending_{}
     , stack_{}
+    , deferred_stack_{}
     , free_pool_{}
     , lru_{}
 {
@@ -46,6 +47,7 @@ void PageRecycler::State::bulk_load(Slice<const PageToRecycle> pages)
   Optional<slot_offset_type> prev_slot;
 
   usize pending_count_delta = 0;
+  usize deferred_count_delta = 0;
   for (const PageToRecycle& to_recycle : pages) {
     BATT_CHECK(to_recycle.page_id.is_valid());
     BATT_CHECK(to_recycle.refresh_slot);
@@ -58,12 +60,16 @@ void PageRecycler::State::bulk_load(Slice<const PageToRecycle> pages)
     const auto& [iter, inserted] = this->pending_.emplace(to_recycle.page_id);
     if (inserted == true) {
       ++pending_count_delta;
+      if (to_recycle.deferred) {
+        ++deferred_count_delta;
+      }
       (void)this->new_work_item(to_recycle);
     }
 
     prev_slot = to_recycle.refresh_slot;
   }
 
+  this->deferred_count.fetch_add(deferred_count_delta);
   this->pending_count.fetch_add(pending_count_delta);
 }
 
@@ -85,9 +91,14 @@ batt::StatusOr<slot_offset_type> PageRecycler::State::insert_and_refresh(
     }
   }
 
-  // Bump the pending counter to let the recycler task know it has some work to do.
+  // Bump the pending counter to let the recycler task know it has some work to do.  The deferred
+  // counter goes first, so that `pending_count - deferred_count` never overstates the number of
+  // pages that aren't deferred.
   //
   auto notify_pending = batt::finally([&] {
+    if (p.deferred) {
+      this->deferred_count.fetch_add(1);
+    }
     this->pending_count.fetch_add(1);
   });
 
@@ -125,7 +136,8 @@ batt::StatusOr<slot_offset_type> PageRecycler::State::insert_and_refresh(
       oldest->to_recycle.refresh_slot = oldest_refresh_slot;
     }
     BATT_CHECK(latest.PageListHook::is_linked());
-    this->stack_[p.depth].erase(this->stack_[p.depth].iterator_to(latest));
+    PageList& stack = this->stack_for(p);
+    stack.erase(stack.iterator_to(latest));
     this->delete_work_item(latest);
     notify_pending.cancel();
     return result;
@@ -154,42 +166,56 @@ batt::StatusOr<slot_offset_type> PageRecycler::State::insert_and_refresh(
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-PageToRecycle PageRecycler::State::remove()
+PageToRecycle PageRecycler::State::remove(bool deferred)
 {
+  auto& stack = deferred ? this->deferred_stack_ : this->stack_;
+
   // Enforce depth-first discipline: search for the highest non-empty stack level.
   //
-  i32 active_depth = this->get_active_depth();
+  i32 active_depth = this->get_active_depth(stack);
 
-  return this->remove_at_depth(active_depth).or_else([] {
+  return this->remove_at_depth(stack, active_depth).or_else([] {
     return PageToRecycle::make_invalid();
   });
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-Optional<PageToRecycle> PageRecycler::State::try_remove(i32 required_depth)
+Optional<PageToRecycle> PageRecycler::State::try_remove(i32 required_depth, bool deferred)
 {
   BATT_CHECK_GE(required_depth, 0);
 
+  auto& stack = deferred ? this->deferred_stack_ : this->stack_;
+
   // Enforce depth-first discipline: search for the highest non-empty stack level.
   //
-  i32 active_depth = this->get_active_depth();
+  i32 active_depth = this->get_active_depth(stack);
 
   if (active_depth != required_depth) {
     return None;
   }
 
-  return this->remove_at_depth(active_depth);
+  return this->remove_at_depth(stack, active_depth);
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-i32 PageRecycler::State::get_active_depth() const
+PageRecycler::PageList& PageRecycler::State::stack_for(const PageToRecycle& p)
+{
+  BATT_CHECK_LT(p.depth, BATT_CHECKED_CAST(i32, this->stack_.size()));
+
+  return p.deferred ? this->deferred_stack_[p.depth] : this->stack_[p.depth];
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+i32 PageRecycler::State::get_active_depth(
+    const std::array<PageList, kMaxPageRefDepth + 1>& stack) const
 {
   // Enforce depth-first discipline: search for the highest non-empty stack level.
   //
-  i32 active_depth = BATT_CHECKED_CAST(i32, this->stack_.size()) - 1;
-  for (; active_depth > 0 && this->stack_[active_depth].empty(); active_depth -= 1) {
+  i32 active_depth = BATT_CHECKED_CAST(i32, stack.size()) - 1;
+  for (; active_depth > 0 && stack[active_depth].empty(); active_depth -= 1) {
     continue;
   }
   BATT_CHECK_GE(active_depth, 0);
@@ -199,20 +225,25 @@ i32 PageRecycler::State::get_active_depth() const
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-Optional<PageToRecycle> PageRecycler::State::remove_at_depth(i32 active_depth)
+Optional<PageToRecycle> PageRecycler::State::remove_at_depth(
+    std::array<PageList, kMaxPageRefDepth + 1>& stack, i32 active_depth)
 {
-  if (this->stack_[active_depth].empty()) {
+  if (stack[active_depth].empty()) {
     return None;
   }
 
-  WorkItem& item = this->stack_[active_depth].back();
-  this->stack_[active_depth].pop_back();
+  WorkItem& item = stack[active_depth].back();
+  stack[active_depth].pop_back();
   BATT_CHECK_EQ(item.to_recycle.depth, active_depth);
 
   const auto on_return = batt::finally([&] {
+    const bool deferred = item.to_recycle.deferred;
     this->pending_.erase(item.to_recycle.page_id);
     this->delete_work_item(item);
     this->pending_count.fetch_sub(1);
+    if (deferred) {
+      this->deferred_count.fetch_sub(1);
+    }
   });
 
   return item.to_recycle;
@@ -266,9 +297,8 @@ void PageRecycler::State::init_work_item(WorkItem& item, const PageToRecycle& p)
 
   // The new item needs to go onto the stack and the LRU list.
   //
-  BATT_CHECK_LT(p.depth, BATT_CHECKED_CAST(i32, this->stack_.size()));
   BATT_CHECK(!item.PageListHook::is_linked());
-  this->stack_[p.depth].push_back(item);
+  this->stack_for(p).push_back(item);
 
   BATT_CHECK(!item.LRUHook::is_linked());
   this->lru_.push_back(item);
@@ -313,20 +343,63 @@ Optional<slot_offset_type> PageRecycler::State::get_lru_slot() const
   return lru_slot;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<usize> PageRecycler::State::checkpoint(
+    usize max_pages_per_slot,
+    std::function<StatusOr<SlotRange>(const Slice<const PageToRecycle>&)>&& append_to_log_fn)
+{
+  BATT_CHECK_GT(max_pages_per_slot, 0u);
+
+  const usize page_count = this->lru_.size();
+
+  std::vector<PageToRecycle> group;
+  group.reserve(std::min(page_count, max_pages_per_slot));
+
+  // Each group is taken from the front of the LRU list and moved to the back once it has been
+  // written, so the list stays in refresh slot order.
+  //
+  usize n_refreshed = 0;
+  while (n_refreshed < page_count) {
+    group.clear();
+    for (auto iter = this->lru_.begin();
+         iter != this->lru_.end() && n_refreshed + group.size() < page_count &&
+         group.size() < max_pages_per_slot;
+         ++iter) {
+      group.emplace_back(iter->to_recycle);
+    }
+
+    StatusOr<SlotRange> slot_range = append_to_log_fn(as_slice(group.data(), group.size()));
+    BATT_REQUIRE_OK(slot_range);
+
+    for (const PageToRecycle& page : group) {
+      WorkItem& item = this->lru_.front();
+      BATT_CHECK_EQ(item.to_recycle.page_id, page.page_id);
+
+      item.to_recycle.refresh_slot = slot_range->lower_bound;
+      this->lru_.pop_front();
+      this->lru_.push_back(item);
+    }
+    n_refreshed += group.size();
+  }
+
+  return n_refreshed;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 std::vector<PageToRecycle> PageRecycler::State::collect_batch(usize max_page_count,
-                                                              Metrics& metrics)
+                                                              Metrics& metrics, bool deferred)
 {
   std::vector<PageToRecycle> to_recycle;
 
   for (usize i = 0; i < max_page_count; ++i) {
     if (i == 0) {
-      to_recycle.emplace_back(this->remove());
+      to_recycle.emplace_back(this->remove(deferred));
       BATT_CHECK_NE(to_recycle.back().page_id, PageId{kInvalidPageId});
     } else {
-      Optional<PageToRecycle> next =
-          this->try_remove(/*required_depth=*/BATT_CHECKED_CAST(i32, to_recycle.back().depth));
+      Optional<PageToRecycle> next = this->try_remove(
+          /*required_depth=*/BATT_CHECKED_CAST(i32, to_recycle.back().depth), deferred);
       if (!next) {
         break;
       }
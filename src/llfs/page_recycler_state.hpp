@@ -33,6 +33,11 @@ struct PageRecycler::NoLockState {
   //
   batt::Watch<usize> pending_count{0};
 
+  // The number of pending WorkItem objects that belong to deferred drops; these are included in
+  // `pending_count`.
+  //
+  batt::Watch<usize> deferred_count{0};
+
   // The unique identifier for this recycler (to prevent double-committing refcount changes).
   //
   const boost::uuids::uuid uuid;
@@ -75,18 +80,38 @@ class PageRecycler::State : public PageRecycler::NoLockState
       std::function<batt::StatusOr<slot_offset_type>(const batt::SmallVecBase<PageToRecycle*>&)>&&
           append_to_log_fn);
 
-  /** \brief Removes a single page from the highest discovery depth available.  If no pages are
+  /** \brief Removes a single page from the highest discovery depth available, taking only deferred
+   * pages if `deferred` is true, and only non-deferred pages otherwise.  If no such pages are
    * queued, returns a record with an invalid PageId.
    */
-  PageToRecycle remove();
+  PageToRecycle remove(bool deferred = false);
 
-  Optional<PageToRecycle> try_remove(i32 required_depth);
+  Optional<PageToRecycle> try_remove(i32 required_depth, bool deferred = false);
 
   /** \brief Returns the oldest refresh slot value for any page currently tracked by the recycler;
    * if there are none, returns None.
    */
   Optional<slot_offset_type> get_lru_slot() const;
 
+  /** \brief Returns the number of queued pages (i.e., pages that are pending but have not yet been
+   * collected into a batch).
+   */
+  usize queued_page_count() const
+  {
+    return this->lru_.size();
+  }
+
+  /** \brief Refreshes all queued pages in bulk: passes them to `append_to_log_fn`, oldest first, in
+   * groups of at most `max_pages_per_slot`.  `append_to_log_fn` must write each group to the log
+   * as a single PageRecyclerCheckpoint slot and return the slot's offset range; the refresh slot of
+   * each page in the group is then set to the lower bound of that range.
+   *
+   * Returns the number of pages refreshed (all of them, unless an append fails).
+   */
+  StatusOr<usize> checkpoint(
+      usize max_pages_per_slot,
+      std::function<StatusOr<SlotRange>(const Slice<const PageToRecycle>&)>&& append_to_log_fn);
+
   /** \brief Returns the maximum number of pages that can be queued in this object for deletion.
    */
   usize max_page_count() const
@@ -95,11 +120,12 @@ class PageRecycler::State : public PageRecycler::NoLockState
   }
 
   /** \brief Removes and returns up to `max_page_count` pages at the highest discovery depth
-   * available.
+   * available, from the deferred pages if `deferred` is true (else from the rest).
    *
    * All the returned pages will be at the same depth.
    */
-  std::vector<PageToRecycle> collect_batch(usize max_page_count, Metrics& metrics);
+  std::vector<PageToRecycle> collect_batch(usize max_page_count, Metrics& metrics,
+                                           bool deferred = false);
 
   //+++++++++++-+-+--+----- --- -- -  -  -   --
 
@@ -137,15 +163,21 @@ class PageRecycler::State : public PageRecycler::NoLockState
    */
   void free_work_item(WorkItem& item);
 
-  /** \brief Returns the highest discovery depth value that currently has at least one page.
+  /** \brief Returns the stack that holds (or will hold) the WorkItem for `p`.
+   */
+  PageList& stack_for(const PageToRecycle& p);
+
+  /** \brief Returns the highest discovery depth value that currently has at least one page in
+   * `stack`.
    */
-  i32 get_active_depth() const;
+  i32 get_active_depth(const std::array<PageList, kMaxPageRefDepth + 1>& stack) const;
 
-  /** \brief Removes a single page record from the specified discovery depth.  If none are
-   * available, returns None.  If `active_depth` is past the maximum depth (kMaxPageRefDepth),
+  /** \brief Removes a single page record from the specified discovery depth of `stack`.  If none
+   * are available, returns None.  If `active_depth` is past the maximum depth (kMaxPageRefDepth),
    * behavior is undefined.
    */
-  Optional<PageToRecycle> remove_at_depth(i32 active_depth);
+  Optional<PageToRecycle> remove_at_depth(std::array<PageList, kMaxPageRefDepth + 1>& stack,
+                                          i32 active_depth);
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
@@ -156,6 +188,11 @@ class PageRecycler::State : public PageRecycler::NoLockState
   std::vector<std::unique_ptr<ArenaExtent>> arena_;
   std::unordered_set<PageId, PageId::Hash> pending_;
   std::array<PageList, kMaxPageRefDepth + 1> stack_;
+
+  // Like `stack_`, but for the pages of deferred drops, which are kept apart so they never hold up
+  // (or get mixed into a batch with) other pages.
+  //
+  std::array<PageList, kMaxPageRefDepth + 1> deferred_stack_;
   PageList free_pool_;
   LRUList lru_;
 };
@@ -0,0 +1,289 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_ref_count_verifier.hpp>
+//
+
+#include <llfs/logging.hpp>
+#include <llfs/slot_reader.hpp>
+#include <llfs/volume.hpp>
+#include <llfs/volume_events.hpp>
+#include <llfs/volume_reader.hpp>
+
+#include <algorithm>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, const PageRefCountMismatch& t)
+{
+  return out << "PageRefCountMismatch{.page_id=" << t.page_id
+             << ", .actual_page_id=" << t.actual_page_id << ", .expected_min=" << t.expected_min
+             << ", .expected_max=" << t.expected_max << ", .actual=" << t.actual
+             << ", .reachable=" << t.reachable << ",}";
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, const PageRefCountVerifierResult& t)
+{
+  return out << "PageRefCountVerifierResult{.root_ref_count=" << t.root_ref_count
+             << ", .reachable_page_count=" << t.reachable_page_count
+             << ", .garbage_page_count=" << t.garbage_page_count
+             << ", .checked_page_count=" << t.checked_page_count
+             << ", .mismatch_count=" << t.mismatch_count << ",}";
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// PageRefCountVerifier
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ PageRefCountVerifier::PageRefCountVerifier(
+    PageCache& cache, const PageRefCountVerifierOptions& options) noexcept
+    : cache_{cache}
+    , options_{options}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageRefCountVerifier::add_root_refs(const Slice<const PageId>& page_ids)
+{
+  for (const PageId& page_id : page_ids) {
+    if (page_id) {
+      this->root_refs_.emplace_back(page_id);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageRefCountVerifier::add_volume_root_refs(Volume& volume)
+{
+  StatusOr<VolumeReader> reader = volume.reader(SlotRangeSpec{None, None}, LogReadMode::kDurable);
+  BATT_REQUIRE_OK(reader);
+
+  std::vector<PageId> root_refs;
+  for (;;) {
+    StatusOr<usize> n_visited = reader->visit_next(
+        batt::WaitForResource::kFalse,
+        [&root_refs](const SlotParse& slot, std::string_view /*user_data*/) -> Status {
+          // The body of a user slot appended as part of a job is the commit slot, which lists the
+          // job's root page refs; the trimmer drops one ref per entry when the slot is trimmed.
+          //
+          return TypedSlotReader<VolumeEventVariant>::visit_slot(
+              slot, slot.body,
+              [&root_refs](const SlotParse&, const Ref<const PackedCommitJob>& commit) {
+                for (const PackedPageId& page_id : *commit.get().root_page_ids) {
+                  root_refs.emplace_back(page_id.unpack());
+                }
+                return OkStatus();
+              },
+              [](const SlotParse&, const auto&) {
+                return OkStatus();
+              });
+        });
+
+    BATT_REQUIRE_OK(n_visited);
+
+    if (*n_visited == 0) {
+      break;
+    }
+  }
+
+  LLFS_VLOG(1) << "add_volume_root_refs:" << BATT_INSPECT(volume.options().name)
+               << BATT_INSPECT(reader->slot_range()) << BATT_INSPECT(root_refs.size());
+
+  this->add_root_refs(as_slice(root_refs));
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<PageRefCountVerifierResult> PageRefCountVerifier::run()
+{
+  PageRefCountVerifierResult result;
+  result.root_ref_count = this->root_refs_.size();
+
+  this->reachable_.clear();
+  this->slack_.clear();
+
+  BATT_REQUIRE_OK(this->trace_reachable());
+  result.reachable_page_count = this->reachable_.size();
+
+  // Scan the ref counts of all physical pages, to find the garbage pages and the unreachable pages
+  // that are still allocated.  This only reads the PageAllocator state, not the pages themselves.
+  //
+  std::vector<PageId> garbage_page_ids;
+  std::vector<PageAllocatorRefCountStatus> unreachable_allocated;
+
+  for (PageCache::PageDeviceEntry* entry : this->cache_.all_devices()) {
+    BATT_CHECK_NOT_NULLPTR(entry);
+
+    PageAllocator& allocator = entry->arena.allocator();
+    const PageIdFactory page_ids = entry->arena.device().page_ids();
+    const page_id_int physical_page_count = page_ids.get_physical_page_count().value();
+
+    for (page_id_int physical_page = 0; physical_page < physical_page_count; ++physical_page) {
+      const PageAllocatorRefCountStatus status =
+          allocator.get_ref_count_status(page_ids.make_page_id(physical_page, /*generation=*/0));
+
+      result.checked_page_count += 1;
+
+      if (status.ref_count == 0 || this->reachable_.count(status.page_id)) {
+        continue;
+      }
+      if (status.ref_count == 1) {
+        garbage_page_ids.emplace_back(status.page_id);
+      } else {
+        unreachable_allocated.emplace_back(status);
+      }
+    }
+  }
+  result.garbage_page_count = garbage_page_ids.size();
+
+  BATT_REQUIRE_OK(this->trace_garbage(garbage_page_ids));
+
+  const auto get_slack = [this](PageId page_id) -> i32 {
+    auto iter = this->slack_.find(page_id);
+    return (iter == this->slack_.end()) ? 0 : iter->second;
+  };
+
+  // Check the reachable pages.  A reachable page whose generation has moved on (or whose ref count
+  // is 0) was recycled while still referenced.
+  //
+  for (const auto& [page_id, ref_count] : this->reachable_) {
+    const PageAllocatorRefCountStatus status =
+        this->cache_.arena_for_page_id(page_id).allocator().get_ref_count_status(page_id);
+
+    const i32 actual = (status.page_id == page_id) ? status.ref_count : 0;
+    const i32 expected_min = 1 + ref_count;
+    const i32 expected_max = expected_min + get_slack(page_id);
+
+    if (actual < expected_min || actual > expected_max) {
+      this->report(result, PageRefCountMismatch{
+                               .page_id = page_id,
+                               .actual_page_id = status.page_id,
+                               .expected_min = expected_min,
+                               .expected_max = expected_max,
+                               .actual = actual,
+                               .reachable = true,
+                           });
+    }
+  }
+
+  // Unreachable pages with a ref count above 1 are leaked, unless the extra refs are held by
+  // garbage pages.
+  //
+  for (const PageAllocatorRefCountStatus& status : unreachable_allocated) {
+    const i32 expected_max = 1 + get_slack(status.page_id);
+
+    if (status.ref_count > expected_max) {
+      this->report(result, PageRefCountMismatch{
+                               .page_id = status.page_id,
+                               .actual_page_id = status.page_id,
+                               .expected_min = 0,
+                               .expected_max = expected_max,
+                               .actual = status.ref_count,
+                               .reachable = false,
+                           });
+    }
+  }
+
+  LLFS_VLOG(1) << "PageRefCountVerifier::run:" << BATT_INSPECT(result);
+
+  return result;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageRefCountVerifier::trace_reachable()
+{
+  std::vector<PageId> frontier;
+
+  for (const PageId& page_id : this->root_refs_) {
+    const auto& [iter, inserted] = this->reachable_.emplace(page_id, 0);
+    iter->second += 1;
+    if (inserted) {
+      frontier.emplace_back(page_id);
+    }
+  }
+
+  std::vector<PageId> next_frontier;
+  std::vector<std::vector<PageId>> refs;
+
+  while (!frontier.empty()) {
+    // Page ids on a device are ordered by physical page, so this loads each level in roughly
+    // ascending device offset order.
+    //
+    std::sort(frontier.begin(), frontier.end());
+
+    BATT_REQUIRE_OK(load_page_refs_parallel(this->cache_, as_slice(frontier), &refs,
+                                            this->options_.trace_options));
+
+    next_frontier.clear();
+    for (const std::vector<PageId>& page_refs : refs) {
+      for (const PageId& page_id : page_refs) {
+        if (!page_id) {
+          continue;
+        }
+        const auto& [iter, inserted] = this->reachable_.emplace(page_id, 0);
+        iter->second += 1;
+        if (inserted) {
+          next_frontier.emplace_back(page_id);
+        }
+      }
+    }
+
+    std::swap(frontier, next_frontier);
+  }
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status PageRefCountVerifier::trace_garbage(const std::vector<PageId>& garbage_page_ids)
+{
+  if (garbage_page_ids.empty()) {
+    return OkStatus();
+  }
+
+  std::vector<std::vector<PageId>> refs;
+
+  BATT_REQUIRE_OK(load_page_refs_parallel(this->cache_, as_slice(garbage_page_ids), &refs,
+                                          this->options_.trace_options));
+
+  for (const std::vector<PageId>& page_refs : refs) {
+    for (const PageId& page_id : page_refs) {
+      if (page_id) {
+        this->slack_[page_id] += 1;
+      }
+    }
+  }
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageRefCountVerifier::report(PageRefCountVerifierResult& result,
+                                  PageRefCountMismatch&& mismatch) const
+{
+  LLFS_VLOG(1) << "ref count mismatch: " << mismatch;
+
+  result.mismatch_count += 1;
+  if (result.mismatches.size() < this->options_.max_reported_mismatches) {
+    result.mismatches.emplace_back(std::move(mismatch));
+  }
+}
+
+}  // namespace llfs
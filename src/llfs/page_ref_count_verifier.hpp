@@ -0,0 +1,171 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_REF_COUNT_VERIFIER_HPP
+#define LLFS_PAGE_REF_COUNT_VERIFIER_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/page_cache.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/slice.hpp>
+#include <llfs/slot.hpp>
+#include <llfs/status.hpp>
+#include <llfs/trace_refs_recursive.hpp>
+
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace llfs {
+
+class Volume;
+
+/** \brief Options for PageRefCountVerifier.
+ */
+struct PageRefCountVerifierOptions {
+  /** \brief Controls how the pages of each level of the page graph are loaded.
+   */
+  ParallelTraceRefsOptions trace_options;
+
+  /** \brief The maximum number of mismatches to keep in PageRefCountVerifierResult::mismatches
+   * (all of them are counted).
+   */
+  usize max_reported_mismatches = 64;
+};
+
+/** \brief A page whose ref count (as recorded by its PageAllocator) is not what the page graph
+ * says it should be.
+ */
+struct PageRefCountMismatch {
+  /** \brief The page id as referenced; if the page has since been recycled and reallocated,
+   * `actual_page_id` has a different generation.
+   */
+  PageId page_id;
+  PageId actual_page_id;
+
+  /** \brief The range of acceptable ref counts.  The range is wider than a single value only for
+   * pages referenced from garbage pages that the PageRecycler hasn't finished with yet.
+   */
+  i32 expected_min;
+  i32 expected_max;
+
+  /** \brief The ref count recorded by the PageAllocator.
+   */
+  i32 actual;
+
+  /** \brief True if the page is reachable from a root.
+   */
+  bool reachable;
+};
+
+std::ostream& operator<<(std::ostream& out, const PageRefCountMismatch& t);
+
+/** \brief The outcome of PageRefCountVerifier::run.
+ */
+struct PageRefCountVerifierResult {
+  /** \brief The number of root refs added (counting duplicates).
+   */
+  usize root_ref_count = 0;
+
+  /** \brief The number of distinct pages reachable from the roots.
+   */
+  usize reachable_page_count = 0;
+
+  /** \brief The number of unreachable pages with a ref count of 1, i.e. waiting to be recycled.
+   */
+  usize garbage_page_count = 0;
+
+  /** \brief The number of physical pages whose ref counts were checked.
+   */
+  usize checked_page_count = 0;
+
+  /** \brief The total number of mismatches found; the first few are in `mismatches`.
+   */
+  usize mismatch_count = 0;
+  std::vector<PageRefCountMismatch> mismatches;
+
+  bool ok() const noexcept
+  {
+    return this->mismatch_count == 0;
+  }
+};
+
+std::ostream& operator<<(std::ostream& out, const PageRefCountVerifierResult& t);
+
+/** \brief Checks the ref counts of every page in a PageCache against the page graph.
+ *
+ * The expected ref count of a page reachable from the roots is 1 (for the PageRecycler) plus the
+ * number of root refs to it plus the number of refs to it from other reachable pages (see
+ * CommittablePageCacheJob::get_page_ref_count_updates).  Unreachable pages must have a ref count
+ * of 0, or 1 if they are waiting to be recycled.  The refs held by pages waiting to be recycled are
+ * allowed as slack, since the recycler drops them one page at a time.
+ *
+ * The roots of all Volumes (and any other clients) that use the PageCache must be added before
+ * calling `run`, and nothing may modify the pages while the verifier runs; otherwise the check is
+ * meaningless.
+ *
+ * Each level of the page graph is loaded in parallel batches (see load_page_refs_parallel), sorted
+ * by page id, so that the pages of each level are read roughly in device order.
+ */
+class PageRefCountVerifier
+{
+ public:
+  explicit PageRefCountVerifier(PageCache& cache,
+                                const PageRefCountVerifierOptions& options = {}) noexcept;
+
+  PageRefCountVerifier(const PageRefCountVerifier&) = delete;
+  PageRefCountVerifier& operator=(const PageRefCountVerifier&) = delete;
+
+  /** \brief Adds one root ref to each of the passed page ids (duplicates count once each).
+   */
+  void add_root_refs(const Slice<const PageId>& page_ids);
+
+  /** \brief Adds the root refs of every committed job still in the root log of `volume`.
+   */
+  Status add_volume_root_refs(Volume& volume);
+
+  /** \brief Traces the page graph from the roots and checks every page's ref count.
+   */
+  StatusOr<PageRefCountVerifierResult> run();
+
+ private:
+  /** \brief Traces the page graph breadth-first from the roots, counting the refs to each page.
+   */
+  Status trace_reachable();
+
+  /** \brief Loads the refs of all the garbage pages (those with a ref count of 1 that aren't
+   * reachable), adding them to `slack_`.
+   */
+  Status trace_garbage(const std::vector<PageId>& garbage_page_ids);
+
+  /** \brief Records a mismatch in `result`.
+   */
+  void report(PageRefCountVerifierResult& result, PageRefCountMismatch&& mismatch) const;
+
+  PageCache& cache_;
+  const PageRefCountVerifierOptions options_;
+
+  // The root refs added by the caller.
+  //
+  std::vector<PageId> root_refs_;
+
+  // The number of refs to each reachable page, from roots and other reachable pages.
+  //
+  std::unordered_map<PageId, i32, PageId::Hash> reachable_;
+
+  // The number of refs to each page from garbage pages.
+  //
+  std::unordered_map<PageId, i32, PageId::Hash> slack_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_PAGE_REF_COUNT_VERIFIER_HPP
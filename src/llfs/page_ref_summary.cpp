@@ -0,0 +1,128 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_ref_summary.hpp>
+//
+
+#include <llfs/crc.hpp>
+
+#include <cstddef>
+#include <cstring>
+
+namespace llfs {
+
+namespace {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 compute_page_ref_summary_crc64(const void* summary_begin,
+                                   const PackedPageRefSummaryTrailer& trailer)
+{
+  auto crc64 = make_crc64();
+  crc64.process_bytes(summary_begin, sizeof(PackedPageId) * trailer.ref_count.value());
+  crc64.process_bytes(&trailer, offsetof(PackedPageRefSummaryTrailer, crc64));
+  return crc64.checksum();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+const PackedPageRefSummaryTrailer* get_page_ref_summary_trailer(const ConstBuffer& page_tail,
+                                                                PageId page_id)
+{
+  if (page_tail.size() < sizeof(PackedPageRefSummaryTrailer)) {
+    return nullptr;
+  }
+
+  const auto* trailer = reinterpret_cast<const PackedPageRefSummaryTrailer*>(
+      static_cast<const u8*>(page_tail.data()) + page_tail.size() -
+      sizeof(PackedPageRefSummaryTrailer));
+
+  if (trailer->magic != PackedPageRefSummaryTrailer::kMagic ||
+      trailer->page_id.unpack() != page_id ||
+      packed_sizeof_page_ref_summary(trailer->ref_count) > kMaxPageRefSummarySize) {
+    return nullptr;
+  }
+
+  return trailer;
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<u64> write_page_ref_summary(PageBuffer* page, const Slice<const PageId>& refs,
+                                     u64 used_end)
+{
+  const usize page_size = page->size();
+  const usize summary_size = packed_sizeof_page_ref_summary(refs.size());
+
+  if (summary_size > kMaxPageRefSummarySize || summary_size > page_size ||
+      page_size - summary_size < used_end) {
+    return {batt::StatusCode::kResourceExhausted};
+  }
+
+  const u64 summary_begin = page_size - summary_size;
+  u8* const page_bytes = reinterpret_cast<u8*>(page);
+
+  auto* const packed_refs = reinterpret_cast<PackedPageId*>(page_bytes + summary_begin);
+  for (usize i = 0; i < refs.size(); ++i) {
+    packed_refs[i] = PackedPageId::from(refs[i]);
+  }
+
+  auto* const trailer = reinterpret_cast<PackedPageRefSummaryTrailer*>(packed_refs + refs.size());
+  std::memset(trailer, 0, sizeof(PackedPageRefSummaryTrailer));
+
+  trailer->magic = PackedPageRefSummaryTrailer::kMagic;
+  trailer->page_id = PackedPageId::from(page->page_id());
+  trailer->ref_count = refs.size();
+  trailer->crc64 = compute_page_ref_summary_crc64(packed_refs, *trailer);
+
+  return summary_begin;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<usize> get_page_ref_summary_size(const ConstBuffer& page_tail, PageId page_id)
+{
+  const PackedPageRefSummaryTrailer* trailer = get_page_ref_summary_trailer(page_tail, page_id);
+  if (!trailer) {
+    return {batt::StatusCode::kNotFound};
+  }
+  return packed_sizeof_page_ref_summary(trailer->ref_count);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::vector<PageId>> read_page_ref_summary(const ConstBuffer& page_tail, PageId page_id)
+{
+  const PackedPageRefSummaryTrailer* trailer = get_page_ref_summary_trailer(page_tail, page_id);
+  if (!trailer) {
+    return {batt::StatusCode::kNotFound};
+  }
+
+  const usize ref_count = trailer->ref_count;
+  if (packed_sizeof_page_ref_summary(ref_count) > page_tail.size()) {
+    return {batt::StatusCode::kOutOfRange};
+  }
+
+  const auto* packed_refs = reinterpret_cast<const PackedPageId*>(trailer) - ref_count;
+
+  if (trailer->crc64 != compute_page_ref_summary_crc64(packed_refs, *trailer)) {
+    return {batt::StatusCode::kNotFound};
+  }
+
+  std::vector<PageId> refs;
+  refs.reserve(ref_count);
+  for (usize i = 0; i < ref_count; ++i) {
+    refs.emplace_back(packed_refs[i].unpack());
+  }
+
+  return refs;
+}
+
+}  // namespace llfs
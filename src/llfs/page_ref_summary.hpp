@@ -0,0 +1,119 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_REF_SUMMARY_HPP
+#define LLFS_PAGE_REF_SUMMARY_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/buffer.hpp>
+#include <llfs/int_types.hpp>
+#include <llfs/packed_page_id.hpp>
+#include <llfs/page_buffer.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/slice.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/static_assert.hpp>
+
+#include <vector>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief The fixed-size trailer of a page ref summary.
+ *
+ * A page ref summary is an optional, compact copy of the outgoing PageIds of a page (i.e., the
+ * sequence returned by PageView::trace_refs), stored in the last bytes of the page so that it can
+ * be read without loading the rest of the page.  The layout, from low to high address, is:
+ *
+ *   PackedPageId refs[ref_count];
+ *   PackedPageRefSummaryTrailer trailer;  // ends at the last byte of the page
+ *
+ * The trailer records the full PageId (including generation) of the page it was written for, so a
+ * summary left over from a previous generation of the same physical page is never mistaken for a
+ * current one.
+ */
+struct PackedPageRefSummaryTrailer {
+  static constexpr u64 kMagic = 0x5f0d3a7be2c61948ull;
+
+  // Must always be PackedPageRefSummaryTrailer::kMagic.
+  //
+  big_u64 magic;
+
+  // The id of the page this summary was written for.
+  //
+  PackedPageId page_id;
+
+  // The number of PackedPageId values preceding this trailer.
+  //
+  little_u32 ref_count;
+
+  // Reserved for future use; always zero.
+  //
+  little_u32 reserved_;
+
+  // The crc64 of the ref array plus all the fields of this struct above this one.
+  //
+  little_u64 crc64;
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedPageRefSummaryTrailer), 32);
+
+/** \brief The largest page ref summary that may be written; bounds the size of the tail read needed
+ * to load a summary.
+ */
+constexpr usize kMaxPageRefSummarySize = 4096;
+
+/** \brief The number of bytes to read from the end of a page on a first attempt to load its ref
+ * summary; summaries larger than this need a second, exactly sized read.
+ */
+constexpr usize kDefaultPageRefSummaryReadSize = 512;
+
+/** \brief Returns the number of bytes at the end of a page taken up by a summary of `ref_count`
+ * refs.
+ */
+inline usize packed_sizeof_page_ref_summary(usize ref_count)
+{
+  return sizeof(PackedPageId) * ref_count + sizeof(PackedPageRefSummaryTrailer);
+}
+
+/** \brief Writes a ref summary for `refs` into the end of `page`.
+ *
+ * `used_end` is the end of the region of the page used by its layout (i.e., the lower bound of the
+ * unused region).  On success, returns the offset of the start of the summary, which the caller
+ * must pass as the upper bound of the unused region to `finalize_page_header`.
+ *
+ * Returns batt::StatusCode::kResourceExhausted if the summary doesn't fit between `used_end` and
+ * the end of the page, or would be larger than kMaxPageRefSummarySize; the page is unmodified in
+ * that case, and can simply be written without a summary.
+ */
+StatusOr<u64> write_page_ref_summary(PageBuffer* page, const Slice<const PageId>& refs,
+                                     u64 used_end);
+
+/** \brief Returns the total size (refs plus trailer) of the summary whose trailer is at the end of
+ * `page_tail`, which must hold the last bytes of the page `page_id`.
+ *
+ * Returns batt::StatusCode::kNotFound if there is no valid trailer for `page_id`.
+ */
+StatusOr<usize> get_page_ref_summary_size(const ConstBuffer& page_tail, PageId page_id);
+
+/** \brief Unpacks the ref summary at the end of `page_tail`, which must hold the last bytes of the
+ * page `page_id`.
+ *
+ * Returns batt::StatusCode::kNotFound if the page has no (valid) summary for `page_id`; callers
+ * should fall back on loading the full page.  Returns batt::StatusCode::kOutOfRange if `page_tail`
+ * is too short to hold the whole summary; in this case, get_page_ref_summary_size returns the
+ * required size.
+ */
+StatusOr<std::vector<PageId>> read_page_ref_summary(const ConstBuffer& page_tail, PageId page_id);
+
+}  // namespace llfs
+
+#endif  // LLFS_PAGE_REF_SUMMARY_HPP
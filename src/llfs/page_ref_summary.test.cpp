@@ -0,0 +1,175 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_ref_summary.hpp>
+//
+#include <llfs/page_ref_summary.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/page_id_factory.hpp>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//
+//  1. A summary written for a page is read back exactly from any tail of the page that covers it.
+//  2. A tail that is too short reports the size needed; a summary for a different page (e.g., an
+//     older generation) or a corrupted summary is reported as not found.
+//  3. Summaries that overlap the used part of the page, or exceed kMaxPageRefSummarySize, are
+//     rejected without modifying the page.
+//
+
+using namespace llfs::int_types;
+
+constexpr usize kTestPageSize = 4096;
+
+const llfs::PageIdFactory& test_page_ids()
+{
+  static const llfs::PageIdFactory id_factory{llfs::PageCount{64}, /*device_id=*/3};
+  return id_factory;
+}
+
+std::vector<llfs::PageId> make_refs(usize count)
+{
+  std::vector<llfs::PageId> refs;
+  for (usize i = 0; i < count; ++i) {
+    refs.emplace_back(test_page_ids().make_page_id(/*physical_page=*/i % 64, /*generation=*/i + 1));
+  }
+  return refs;
+}
+
+std::shared_ptr<llfs::PageBuffer> new_page(llfs::PageId page_id)
+{
+  return llfs::PageBuffer::allocate(llfs::PageSize{kTestPageSize}, page_id);
+}
+
+// Returns the last `n` bytes of the page.
+//
+llfs::ConstBuffer page_tail(const llfs::PageBuffer& page, usize n)
+{
+  const llfs::ConstBuffer page_data = page.const_buffer();
+  return llfs::ConstBuffer{static_cast<const u8*>(page_data.data()) + page_data.size() - n, n};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  1. A summary written for a page is read back exactly.
+//
+TEST(PageRefSummaryTest, RoundTrip)
+{
+  const llfs::PageId page_id = test_page_ids().make_page_id(/*physical_page=*/7, /*generation=*/2);
+
+  for (usize ref_count : {0, 1, 10, 200}) {
+    std::shared_ptr<llfs::PageBuffer> page = new_page(page_id);
+    const std::vector<llfs::PageId> refs = make_refs(ref_count);
+    const usize summary_size = llfs::packed_sizeof_page_ref_summary(ref_count);
+
+    llfs::StatusOr<u64> summary_begin =
+        llfs::write_page_ref_summary(page.get(), llfs::as_slice(refs), /*used_end=*/256);
+
+    ASSERT_TRUE(summary_begin.ok()) << BATT_INSPECT(summary_begin.status());
+    EXPECT_EQ(*summary_begin, kTestPageSize - summary_size);
+
+    for (usize tail_size : {summary_size, kTestPageSize}) {
+      llfs::StatusOr<std::vector<llfs::PageId>> read_refs =
+          llfs::read_page_ref_summary(page_tail(*page, tail_size), page_id);
+
+      ASSERT_TRUE(read_refs.ok()) << BATT_INSPECT(read_refs.status());
+      EXPECT_THAT(*read_refs, ::testing::ContainerEq(refs));
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  2. Short tails, mismatched page ids, and corrupted summaries.
+//
+TEST(PageRefSummaryTest, ShortStaleOrCorrupt)
+{
+  const llfs::PageId page_id = test_page_ids().make_page_id(/*physical_page=*/7, /*generation=*/2);
+  const llfs::PageId next_generation = test_page_ids().advance_generation(page_id);
+
+  std::shared_ptr<llfs::PageBuffer> page = new_page(page_id);
+  const std::vector<llfs::PageId> refs = make_refs(100);
+  const usize summary_size = llfs::packed_sizeof_page_ref_summary(refs.size());
+
+  ASSERT_TRUE(llfs::write_page_ref_summary(page.get(), llfs::as_slice(refs), 64).ok());
+
+  const llfs::ConstBuffer short_tail = page_tail(*page, 512);
+
+  EXPECT_EQ(llfs::read_page_ref_summary(short_tail, page_id).status(),
+            batt::StatusCode::kOutOfRange);
+
+  llfs::StatusOr<usize> needed = llfs::get_page_ref_summary_size(short_tail, page_id);
+  ASSERT_TRUE(needed.ok()) << BATT_INSPECT(needed.status());
+  EXPECT_EQ(*needed, summary_size);
+
+  EXPECT_EQ(llfs::read_page_ref_summary(page_tail(*page, summary_size), next_generation).status(),
+            batt::StatusCode::kNotFound);
+  EXPECT_EQ(llfs::get_page_ref_summary_size(short_tail, next_generation).status(),
+            batt::StatusCode::kNotFound);
+
+  // Flip a bit in one of the refs.
+  //
+  u8* const first_ref =
+      static_cast<u8*>(page->mutable_buffer().data()) + kTestPageSize - summary_size;
+  first_ref[0] ^= 1;
+
+  EXPECT_EQ(llfs::read_page_ref_summary(page_tail(*page, summary_size), page_id).status(),
+            batt::StatusCode::kNotFound);
+
+  // A page that never had a summary.
+  //
+  std::shared_ptr<llfs::PageBuffer> empty_page = new_page(page_id);
+  std::memset(empty_page->mutable_payload().data(), 0, empty_page->mutable_payload().size());
+
+  EXPECT_EQ(llfs::read_page_ref_summary(page_tail(*empty_page, 512), page_id).status(),
+            batt::StatusCode::kNotFound);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  3. Summaries that don't fit are rejected.
+//
+TEST(PageRefSummaryTest, DoesNotFit)
+{
+  const llfs::PageId page_id = test_page_ids().make_page_id(/*physical_page=*/1, /*generation=*/1);
+
+  std::shared_ptr<llfs::PageBuffer> page = new_page(page_id);
+  std::memset(page->mutable_payload().data(), 0, page->mutable_payload().size());
+
+  const std::vector<llfs::PageId> refs = make_refs(10);
+  const usize summary_size = llfs::packed_sizeof_page_ref_summary(refs.size());
+
+  EXPECT_EQ(llfs::write_page_ref_summary(page.get(), llfs::as_slice(refs),
+                                         /*used_end=*/kTestPageSize - summary_size + 1)
+                .status(),
+            batt::StatusCode::kResourceExhausted);
+
+  const std::vector<llfs::PageId> too_many_refs = make_refs(kTestPageSize / sizeof(u64));
+
+  EXPECT_EQ(
+      llfs::write_page_ref_summary(page.get(), llfs::as_slice(too_many_refs), /*used_end=*/64)
+          .status(),
+      batt::StatusCode::kResourceExhausted);
+
+  EXPECT_EQ(llfs::read_page_ref_summary(page_tail(*page, 512), page_id).status(),
+            batt::StatusCode::kNotFound);
+
+  // Exactly filling the unused region is fine.
+  //
+  llfs::StatusOr<u64> summary_begin = llfs::write_page_ref_summary(
+      page.get(), llfs::as_slice(refs), /*used_end=*/kTestPageSize - summary_size);
+
+  ASSERT_TRUE(summary_begin.ok()) << BATT_INSPECT(summary_begin.status());
+  EXPECT_EQ(*summary_begin, kTestPageSize - summary_size);
+}
+
+}  // namespace
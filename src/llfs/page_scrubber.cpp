@@ -0,0 +1,180 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_scrubber.hpp>
+//
+
+#include <llfs/logging.hpp>
+#include <llfs/page_cache.hpp>
+#include <llfs/page_compression.hpp>
+#include <llfs/page_delta.hpp>
+#include <llfs/page_layout.hpp>
+
+#include <batteries/assert.hpp>
+
+#include <algorithm>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ PageScrubber::PageScrubber(PageCache& cache, batt::TaskScheduler& scheduler,
+                                        const Options& options) noexcept
+    : cache_{cache}
+    , options_{options}
+{
+  BATT_CHECK_GT(this->options_.pages_per_second, 0.0);
+
+  this->task_.emplace(
+      scheduler.schedule_task(),
+      [this] {
+        this->run();
+      },
+      "PageScrubber::run");
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageScrubber::~PageScrubber() noexcept
+{
+  this->halt();
+  this->join();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageScrubber::halt()
+{
+  this->halt_requested_.store(true);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageScrubber::join()
+{
+  if (this->task_) {
+    this->task_->join();
+    this->task_ = None;
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<Status> PageScrubber::scrub_page(PageId page_id)
+{
+  PageDevice::ReadResult page_data = this->cache_.arena_for_page_id(page_id).device().await_read(
+      page_id);
+
+  if (!page_data.ok()) {
+    return None;
+  }
+
+  // The checksum covers the uncompressed page.
+  //
+  if (is_compressed_page(**page_data)) {
+    page_data = decompress_page(std::move(*page_data));
+    if (!page_data.ok()) {
+      return page_data.status();
+    }
+  }
+
+  // Delta pages are checked once they've been materialized from their base page.
+  //
+  if (is_delta_page(**page_data)) {
+    StatusOr<PinnedPage> base =
+        this->cache_.get_page(get_delta_page_base_id(**page_data), OkIfNotFound{false});
+    if (!base.ok()) {
+      return base.status();
+    }
+    page_data = apply_page_delta(**page_data, (*base)->page_buffer());
+    if (!page_data.ok()) {
+      return page_data.status();
+    }
+  }
+
+  return verify_page_checksum(**page_data);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageScrubber::run()
+{
+  const i64 delay_usec = std::max<i64>(1, static_cast<i64>(1e6 / this->options_.pages_per_second));
+
+  for (;;) {
+    for (PageCache::PageDeviceEntry* entry : this->cache_.all_devices()) {
+      BATT_CHECK_NOT_NULLPTR(entry);
+
+      BoxedSeq<PageRefCount> ref_counts = entry->arena.allocator().page_ref_counts();
+      for (;;) {
+        if (this->halt_requested_.load()) {
+          return;
+        }
+
+        Optional<PageRefCount> prc = ref_counts.next();
+        if (!prc) {
+          break;
+        }
+
+        // Free pages have nothing to check.
+        //
+        if (prc->ref_count <= 0) {
+          continue;
+        }
+
+        if (entry->cache.find(prc->page_id)) {
+          this->metrics_.skipped_count.add(1);
+          continue;
+        }
+
+        Optional<Status> result = this->scrub_page(prc->page_id);
+        if (!result) {
+          this->metrics_.skipped_count.add(1);
+        } else {
+          this->metrics_.scrubbed_count.add(1);
+          if (!result->ok()) {
+            this->metrics_.failure_count.add(1);
+            LLFS_LOG_ERROR() << "PageScrubber: page failed validation;"
+                             << BATT_INSPECT(prc->page_id) << BATT_INSPECT(*result);
+          }
+        }
+
+        if (!this->pace(delay_usec)) {
+          return;
+        }
+      }
+    }
+
+    this->metrics_.pass_count.add(1);
+
+    // Don't spin if there is nothing to scrub.
+    //
+    if (!this->pace(delay_usec)) {
+      return;
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool PageScrubber::pace(i64 usec)
+{
+  // Sleep in short steps so that `halt()` takes effect promptly even at low scrub rates.
+  //
+  static constexpr i64 kMaxSleepUsec = 100 * 1000;
+
+  while (usec > 0 && !this->halt_requested_.load()) {
+    const i64 step = std::min(usec, kMaxSleepUsec);
+    batt::Task::sleep(boost::posix_time::microseconds(step));
+    usec -= step;
+  }
+
+  return !this->halt_requested_.load();
+}
+
+}  // namespace llfs
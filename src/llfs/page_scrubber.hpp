@@ -0,0 +1,128 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PAGE_SCRUBBER_HPP
+#define LLFS_PAGE_SCRUBBER_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/metrics.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/async/task.hpp>
+#include <batteries/async/task_scheduler.hpp>
+
+#include <atomic>
+
+namespace llfs {
+
+class PageCache;
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A background task that slowly reads every live page on all the devices of a PageCache
+ * and checks its checksum (verify_page_checksum), so that corruption in pages that are rarely read
+ * is found before they are needed.
+ *
+ * Pages that are currently in the cache are skipped, since they are hot (and, unless the cache is
+ * using PageValidationPolicy::kBackgroundScrub, were checked when they were loaded).  Pages are
+ * read directly from their PageDevice, so scrubbing doesn't displace anything from the cache.  When
+ * all devices have been scrubbed, the scrubber starts over.
+ *
+ * Checksum failures are logged and counted; they don't stop the scrubber.
+ */
+class PageScrubber
+{
+ public:
+  struct Options {
+    // The maximum number of pages read per second.
+    //
+    double pages_per_second;
+  };
+
+  struct Metrics {
+    // Pages whose checksum was checked.
+    //
+    CountMetric<u64> scrubbed_count{0};
+
+    // Pages skipped because they were in the cache, or because reading them failed (e.g., because
+    // they were deleted since the scrubber found them).
+    //
+    CountMetric<u64> skipped_count{0};
+
+    // Pages that failed their checksum.
+    //
+    CountMetric<u64> failure_count{0};
+
+    // Completed passes over all devices.
+    //
+    CountMetric<u64> pass_count{0};
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Creates a scrubber for the devices in `cache` and starts its task on `scheduler`.
+   */
+  explicit PageScrubber(PageCache& cache, batt::TaskScheduler& scheduler,
+                        const Options& options) noexcept;
+
+  PageScrubber(const PageScrubber&) = delete;
+  PageScrubber& operator=(const PageScrubber&) = delete;
+
+  /** \brief Halts and joins the scrubber task.
+   */
+  ~PageScrubber() noexcept;
+
+  const Metrics& metrics() const noexcept
+  {
+    return this->metrics_;
+  }
+
+  /** \brief Tells the scrubber task to stop (at the latest, after the page it is checking).
+   */
+  void halt();
+
+  /** \brief Waits for the scrubber task to stop; `halt()` must have been called first.
+   */
+  void join();
+
+  /** \brief Reads the given page from its device and checks it.  Returns the error if the page
+   * fails its checksum (or is compressed and can't be decompressed), OkStatus if it passes, and
+   * None if it couldn't be read.
+   */
+  Optional<Status> scrub_page(PageId page_id);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  // The body of the scrubber task.
+  //
+  void run();
+
+  // Sleeps for `usec` microseconds, or until `halt()` is called; returns false if halted.
+  //
+  bool pace(i64 usec);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  PageCache& cache_;
+
+  const Options options_;
+
+  Metrics metrics_;
+
+  std::atomic<bool> halt_requested_{false};
+
+  Optional<batt::Task> task_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_PAGE_SCRUBBER_HPP
@@ -0,0 +1,337 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/page_scrubber.hpp>
+//
+#include <llfs/page_scrubber.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/memory_page_arena.hpp>
+#include <llfs/opaque_page_view.hpp>
+#include <llfs/page_allocator.hpp>
+#include <llfs/page_cache.hpp>
+#include <llfs/page_cache_job.hpp>
+#include <llfs/page_cache_options.hpp>
+#include <llfs/page_id_factory.hpp>
+
+#include <batteries/async/runtime.hpp>
+
+#include <boost/uuid/uuid_generators.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//
+//  1. kFull: a page is checked the first time it is loaded, a corrupt page fails to load, a
+//     reload of a page that was already checked doesn't recompute the checksum, and
+//     prepare_page_for_write makes the next load check it again.
+//  2. kFirstLoadOnly: same as (1).
+//  3. kSampled: with a sample rate of 0, no load is checked (so corruption goes unnoticed); with a
+//     rate of 1, every load is checked, including reloads.
+//  4. kBackgroundScrub: loads are never checked; PageScrubber::scrub_page reports a good page as
+//     OkStatus, a corrupt page as an error, and a page that can't be read as None.
+//  5. A running PageScrubber visits every live page that isn't in the cache, and reports the
+//     corrupt ones in its metrics.
+
+using namespace llfs::int_types;
+
+constexpr llfs::PageSize kTestPageSize{4096};
+constexpr usize kTestPageCount = 4;
+
+class PageScrubberTest : public ::testing::Test
+{
+ public:
+  void make_cache(llfs::PageValidationPolicy policy, double sample_rate = 1.0)
+  {
+    llfs::PageCacheOptions options = llfs::PageCacheOptions::with_default_values();
+    options.set_max_cached_pages_per_size(kTestPageSize, kTestPageCount)
+        .set_page_validation_policy(policy)
+        .set_page_validation_sample_rate(sample_rate)
+        .set_background_scrub_pages_per_second(1000.0);
+
+    std::vector<llfs::PageArena> arenas;
+    arenas.emplace_back(llfs::make_memory_page_arena(
+        batt::Runtime::instance().default_scheduler(), llfs::PageCount{kTestPageCount},
+        kTestPageSize, "Arena0", /*device_id=*/0));
+
+    llfs::StatusOr<batt::SharedPtr<llfs::PageCache>> page_cache =
+        llfs::PageCache::make_shared(std::move(arenas), options);
+    ASSERT_TRUE(page_cache.ok()) << BATT_INSPECT(page_cache.status());
+
+    this->cache_ = std::move(*page_cache);
+
+    ASSERT_TRUE(llfs::OpaquePageView::register_layout(*this->cache_).ok());
+  }
+
+  // Writes a page filled with `value` to the device, and evicts it from the cache.
+  //
+  llfs::PageId write_page(u8 value)
+  {
+    std::unique_ptr<llfs::PageCacheJob> job = this->cache_->new_job();
+
+    llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer =
+        job->new_page(kTestPageSize, batt::WaitForResource::kFalse,
+                      llfs::OpaquePageView::page_layout_id(), llfs::Caller::Unknown,
+                      /*cancel_token=*/llfs::None);
+    BATT_CHECK_OK(buffer);
+
+    const llfs::PageId page_id = (*buffer)->page_id();
+    {
+      llfs::MutableBuffer payload = (*buffer)->mutable_payload();
+      std::memset(payload.data(), value, payload.size());
+    }
+
+    BATT_CHECK_OK(job->pin_new(std::make_shared<llfs::OpaquePageView>(std::move(*buffer)),
+                               llfs::Caller::Unknown));
+    BATT_CHECK_OK(job->stream_new_pages());
+
+    job = nullptr;
+    this->evict_page(page_id);
+
+    return page_id;
+  }
+
+  // Drops the page from the cache, if it is there.  (purge() would also mark the page dead, so
+  // that loading it fails.)
+  //
+  void evict_page(llfs::PageId page_id)
+  {
+    for (llfs::PageCache::PageDeviceEntry* entry : this->cache_->all_devices()) {
+      if (entry->arena.id() == llfs::PageIdFactory::get_device_id(page_id)) {
+        entry->cache.erase(page_id);
+      }
+    }
+  }
+
+  // Flips a payload byte of the page stored on the device (MemoryPageDevice keeps the written
+  // buffer, so this is corruption "at rest").
+  //
+  void corrupt_page(llfs::PageId page_id)
+  {
+    llfs::PageDevice::ReadResult image =
+        this->cache_->arena_for_page_id(page_id).device().await_read(page_id);
+    BATT_CHECK_OK(image);
+
+    llfs::ConstBuffer payload = (*image)->const_payload();
+    u8* const bytes = const_cast<u8*>(static_cast<const u8*>(payload.data()));
+    bytes[payload.size() / 2] ^= 0xff;
+  }
+
+  // Drops the page from the cache (if it is there) and loads it again.
+  //
+  llfs::Status reload_page(llfs::PageId page_id)
+  {
+    this->evict_page(page_id);
+    return this->cache_->get_page(page_id, llfs::OkIfNotFound{false}).status();
+  }
+
+  u64 validated_count() const
+  {
+    return this->cache_->metrics().validated_page_count.load();
+  }
+
+  u64 failure_count() const
+  {
+    return this->cache_->metrics().page_validation_failure_count.load();
+  }
+
+  // Checks the behavior shared by kFull and kFirstLoadOnly (test plan items 1 and 2).
+  //
+  void check_first_load_is_validated()
+  {
+    const llfs::PageId good_id = this->write_page(0x11);
+    const llfs::PageId bad_id = this->write_page(0x22);
+    this->corrupt_page(bad_id);
+
+    const u64 validated_before = this->validated_count();
+    const u64 failures_before = this->failure_count();
+
+    EXPECT_TRUE(this->reload_page(good_id).ok());
+    EXPECT_EQ(this->validated_count() - validated_before, 1u);
+
+    EXPECT_FALSE(this->reload_page(bad_id).ok());
+    EXPECT_EQ(this->failure_count() - failures_before, 1u);
+
+    // The good page has been checked since it was written, so reloading it is free.
+    //
+    EXPECT_TRUE(this->reload_page(good_id).ok());
+    EXPECT_TRUE(this->reload_page(good_id).ok());
+    EXPECT_EQ(this->validated_count() - validated_before, 1u);
+
+    // (Re)writing the page means it must be checked again.
+    //
+    {
+      llfs::StatusOr<llfs::PinnedPage> loaded =
+          this->cache_->get_page(good_id, llfs::OkIfNotFound{false});
+      ASSERT_TRUE(loaded.ok()) << BATT_INSPECT(loaded.status());
+
+      this->cache_->prepare_page_for_write(loaded->get_page_buffer());
+    }
+    EXPECT_TRUE(this->reload_page(good_id).ok());
+    EXPECT_EQ(this->validated_count() - validated_before, 2u);
+  }
+
+  batt::SharedPtr<llfs::PageCache> cache_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST_F(PageScrubberTest, FullValidation)
+{
+  this->make_cache(llfs::PageValidationPolicy::kFull);
+  this->check_first_load_is_validated();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST_F(PageScrubberTest, FirstLoadOnlyValidation)
+{
+  this->make_cache(llfs::PageValidationPolicy::kFirstLoadOnly);
+  this->check_first_load_is_validated();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 3.
+//
+TEST_F(PageScrubberTest, SampledValidation)
+{
+  // Sample rate 0: nothing is checked.
+  {
+    this->make_cache(llfs::PageValidationPolicy::kSampled, /*sample_rate=*/0.0);
+
+    const llfs::PageId bad_id = this->write_page(0x33);
+    this->corrupt_page(bad_id);
+
+    EXPECT_TRUE(this->reload_page(bad_id).ok());
+    EXPECT_EQ(this->validated_count(), 0u);
+    EXPECT_EQ(this->failure_count(), 0u);
+
+    this->cache_ = nullptr;
+  }
+
+  // Sample rate 1: every load is checked.
+  {
+    this->make_cache(llfs::PageValidationPolicy::kSampled, /*sample_rate=*/1.0);
+
+    const llfs::PageId good_id = this->write_page(0x44);
+    const llfs::PageId bad_id = this->write_page(0x55);
+    this->corrupt_page(bad_id);
+
+    const u64 validated_before = this->validated_count();
+
+    EXPECT_TRUE(this->reload_page(good_id).ok());
+    EXPECT_TRUE(this->reload_page(good_id).ok());
+    EXPECT_EQ(this->validated_count() - validated_before, 2u);
+
+    EXPECT_FALSE(this->reload_page(bad_id).ok());
+    EXPECT_EQ(this->failure_count(), 1u);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 4.
+//
+TEST_F(PageScrubberTest, BackgroundScrubPolicy)
+{
+  this->make_cache(llfs::PageValidationPolicy::kBackgroundScrub);
+
+  const llfs::PageId good_id = this->write_page(0x66);
+  const llfs::PageId bad_id = this->write_page(0x77);
+  this->corrupt_page(bad_id);
+
+  const u64 validated_before = this->validated_count();
+
+  EXPECT_TRUE(this->reload_page(good_id).ok());
+  EXPECT_TRUE(this->reload_page(bad_id).ok());
+  EXPECT_EQ(this->validated_count() - validated_before, 0u);
+  EXPECT_EQ(this->failure_count(), 0u);
+
+  // The pages aren't live in the allocator, so this scrubber's task has nothing to visit; it is
+  // only used to check pages directly.
+  //
+  llfs::PageScrubber scrubber{*this->cache_, batt::Runtime::instance().default_scheduler(),
+                              llfs::PageScrubber::Options{.pages_per_second = 1000.0}};
+
+  llfs::Optional<llfs::Status> good_result = scrubber.scrub_page(good_id);
+  ASSERT_TRUE(good_result);
+  EXPECT_TRUE(good_result->ok()) << BATT_INSPECT(*good_result);
+
+  llfs::Optional<llfs::Status> bad_result = scrubber.scrub_page(bad_id);
+  ASSERT_TRUE(bad_result);
+  EXPECT_FALSE(bad_result->ok());
+
+  const llfs::PageId stale_id =
+      this->cache_->arena_for_page_id(good_id).device().page_ids().advance_generation(good_id);
+
+  EXPECT_FALSE(scrubber.scrub_page(stale_id));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 5.
+//
+TEST_F(PageScrubberTest, ScrubberReportsCorruptPages)
+{
+  // Use kFull so that the cache doesn't start a scrubber of its own.
+  //
+  this->make_cache(llfs::PageValidationPolicy::kFull);
+
+  const llfs::PageId good_id = this->write_page(0x88);
+  const llfs::PageId bad_id = this->write_page(0x99);
+  this->corrupt_page(bad_id);
+
+  // Make both pages live, so the scrubber visits them.
+  //
+  {
+    llfs::PageAllocator& allocator = this->cache_->arena_for_page_id(good_id).allocator();
+    const boost::uuids::uuid user_id = boost::uuids::random_generator{}();
+
+    llfs::StatusOr<llfs::slot_offset_type> attached =
+        allocator.attach_user(user_id, /*user_slot=*/0);
+    ASSERT_TRUE(attached.ok()) << BATT_INSPECT(attached.status());
+
+    const std::vector<llfs::PageRefCount> ref_counts{
+        llfs::PageRefCount{.page_id = good_id, .ref_count = 2},
+        llfs::PageRefCount{.page_id = bad_id, .ref_count = 2},
+    };
+    llfs::StatusOr<llfs::slot_offset_type> updated =
+        allocator.update_page_ref_counts(user_id, /*user_slot=*/1, batt::as_seq(ref_counts));
+    ASSERT_TRUE(updated.ok()) << BATT_INSPECT(updated.status());
+    ASSERT_TRUE(allocator.sync(*updated).ok());
+  }
+
+  llfs::PageScrubber scrubber{*this->cache_, batt::Runtime::instance().default_scheduler(),
+                              llfs::PageScrubber::Options{.pages_per_second = 1000.0}};
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (scrubber.metrics().pass_count.load() < 1 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  scrubber.halt();
+  scrubber.join();
+
+  ASSERT_GE(scrubber.metrics().pass_count.load(), 1u);
+
+  // Each pass visits both pages; one of them is corrupt.
+  //
+  const u64 passes = scrubber.metrics().pass_count.load();
+  EXPECT_GE(scrubber.metrics().scrubbed_count.load(), 2u * passes);
+  EXPECT_GE(scrubber.metrics().failure_count.load(), passes);
+  EXPECT_LE(scrubber.metrics().failure_count.load(), passes + 1);
+  EXPECT_EQ(scrubber.metrics().skipped_count.load(), 0u);
+}
+
+}  // namespace
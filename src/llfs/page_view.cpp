@@ -29,12 +29,17 @@ Status PageView::validate(PageId expected_id)
 
 #if LLFS_DISABLE_PAGE_CRC
 #else
-  // TODO [tastolfi 2020-12-29] - give an error instead of asserting here.
-  //
-  BATT_CHECK_EQ(header.crc32.value(), compute_page_crc64(*this->data_));
+  BATT_REQUIRE_OK(verify_page_checksum(*this->data_));
 #endif
 
   return OkStatus();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PageView::append_refs(std::vector<PageId>* refs) const
+{
+  this->trace_refs() | seq::emplace_back(refs);
+}
+
 }  // namespace llfs
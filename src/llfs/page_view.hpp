@@ -25,6 +25,7 @@
 
 #include <memory>
 #include <type_traits>
+#include <vector>
 
 namespace llfs {
 
@@ -55,11 +56,22 @@ class PageView
     return this->data_->page_id();
   }
 
+  /** \brief Returns a shared reference to the page buffer.  This copies a std::shared_ptr (two
+   * atomic updates of its control block); callers that only need to read the page while it is
+   * pinned should use `page_buffer()`, `const_buffer()` or `const_payload()` instead.
+   */
   std::shared_ptr<const PageBuffer> data() const noexcept
   {
     return this->data_;
   }
 
+  /** \brief Returns the page buffer without taking a reference; valid for as long as this view is.
+   */
+  const PageBuffer& page_buffer() const noexcept
+  {
+    return *this->data_;
+  }
+
   ConstBuffer const_buffer() const noexcept
   {
     return this->data_->const_buffer();
@@ -84,6 +96,52 @@ class PageView
   //
   //  TODO [tastolfi 2023-03-13] add parallel friendly API
 
+  /** \brief Appends the ids of all pages directly referenced by this one (the same ids, in the same
+   * order, as `trace_refs()`) to `*refs`.
+   *
+   * Unlike `trace_refs()`, this doesn't heap-allocate a type-erased sequence or make a virtual call
+   * per ref (provided the page view type overrides it), so it should be used on hot paths; reusing
+   * the same vector across calls avoids allocation altogether.  The default implementation
+   * collects `trace_refs()`.
+   */
+  virtual void append_refs(std::vector<PageId>* refs) const;
+
+  /** \brief Appends the ids returned by `append_refs()` and then the delta base of this page, if it
+   * has one (see `delta_base()`); i.e., the ids of all the pages that must stay live for this one
+   * to be loadable.  This is what should be used to count refs.
+   */
+  void append_refs_and_delta_base(std::vector<PageId>* refs) const
+  {
+    this->append_refs(refs);
+    if (this->delta_base_) {
+      refs->emplace_back(this->delta_base_);
+    }
+  }
+
+  /** \brief If this page is stored as a delta image (see page_delta.hpp), returns the id of the
+   * base page it is a delta against; otherwise returns an invalid PageId.
+   */
+  PageId delta_base() const noexcept
+  {
+    return this->delta_base_;
+  }
+
+  /** \brief The number of delta images applied to materialize this page; 0 if it is stored in full.
+   */
+  u16 delta_depth() const noexcept
+  {
+    return this->delta_depth_;
+  }
+
+  /** \brief Records that this page is stored as a delta against `base_id`; must only be called
+   * before the view is shared with other threads (i.e., before it is added to a job or the cache).
+   */
+  void set_delta_base(PageId base_id, u16 depth) const noexcept
+  {
+    this->delta_base_ = base_id;
+    this->delta_depth_ = depth;
+  }
+
   /** \brief Returns the minimum key value contained within this page.
    */
   virtual Optional<KeyView> min_key() const = 0;
@@ -176,6 +234,11 @@ class PageView
   mutable batt::Mutex<UserData> user_data_;
   //            ^
   //            TODO [tastolfi 2021-12-01] potential concurrency bottleneck
+
+  // See `delta_base()`; set before the view is shared, so these need no synchronization.
+  //
+  mutable PageId delta_base_;
+  mutable u16 delta_depth_ = 0;
 };
 
 }  // namespace llfs
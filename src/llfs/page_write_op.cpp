@@ -76,13 +76,16 @@ Status parallel_drop_pages(const std::vector<PageId>& deleted_pages, PageCache&
   // Purge all dropped pages from the cache to reduce memory pressure.
   //
   Status overall_status;
+  std::vector<PageId> purged_page_ids;
+  purged_page_ids.reserve(n_ops);
   for (PageWriteOp& op : as_slice(ops.get(), n_ops)) {
     Status page_status = op.result;
     overall_status.Update(page_status);
     if (page_status.ok()) {
-      cache.purge(op.page_id, callers | Caller::PageCacheJob_commit_2, job_id);
+      purged_page_ids.emplace_back(op.page_id);
     }
   }
+  cache.purge_pages(as_slice(purged_page_ids), callers | Caller::PageCacheJob_commit_2, job_id);
 
   return overall_status;
 }
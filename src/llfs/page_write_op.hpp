@@ -19,6 +19,7 @@
 #include <batteries/async/handler.hpp>
 #include <batteries/async/watch.hpp>
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -35,6 +36,10 @@ struct PageWriteOp {
   batt::Watch<i64>* done_counter = nullptr;
   PageDevice::WriteResult result;
 
+  // Set by PageCache::write_page; decremented when the write completes.
+  //
+  std::atomic<usize>* writes_in_flight = nullptr;
+
   static std::unique_ptr<PageWriteOp[]> allocate_array(usize n, batt::Watch<i64>& done_counter);
 
   explicit PageWriteOp() noexcept;
@@ -45,6 +50,9 @@ struct PageWriteOp {
   {
     return make_custom_alloc_handler(this->handler_memory, [this](PageDevice::WriteResult result) {
       this->result = std::move(result);
+      if (this->writes_in_flight) {
+        this->writes_in_flight->fetch_sub(1);
+      }
       this->done_counter->fetch_add(1);
     });
   }
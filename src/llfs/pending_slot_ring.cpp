@@ -0,0 +1,144 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/pending_slot_ring.hpp>
+//
+
+#include <batteries/assert.hpp>
+#include <batteries/math.hpp>
+
+#include <algorithm>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ PendingSlotRing::PendingSlotRing(usize capacity) noexcept
+    : capacity_{usize{1} << batt::log2_ceil(std::max<usize>(capacity, 2))}
+    , entries_{new Entry[this->capacity_]}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto PendingSlotRing::push(slot_offset_type slot) noexcept -> Ticket
+{
+  const u64 seq = this->tail_.load();
+
+  if (seq - this->head_.load() >= this->capacity_) {
+    this->advance_head();
+
+    if (seq - this->head_.load() >= this->capacity_) {
+      std::unique_lock<std::mutex> lock{this->overflow_mutex_};
+
+      this->overflow_.emplace(slot);
+      this->overflow_size_.fetch_add(1);
+      this->overflow_count_.fetch_add(1);
+
+      return Ticket{.seq = kOverflow, .slot = slot};
+    }
+  }
+
+  Entry& entry = this->entry(seq);
+
+  // The entry's previous slot has been retired, but `min_pending` may still be reading it; the
+  // fence makes sure that if it sees the new slot value, it also sees that the state changed.
+  //
+  std::atomic_thread_fence(std::memory_order_release);
+  entry.slot.store(slot, std::memory_order_relaxed);
+  entry.state.store(2 * seq + 1);
+
+  this->tail_.store(seq + 1);
+
+  return Ticket{.seq = seq, .slot = slot};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PendingSlotRing::retire(const Ticket& ticket) noexcept
+{
+  if (ticket.seq == kOverflow) {
+    std::unique_lock<std::mutex> lock{this->overflow_mutex_};
+
+    auto iter = this->overflow_.find(ticket.slot);
+    BATT_CHECK(iter != this->overflow_.end()) << "ticket retired twice?";
+
+    this->overflow_.erase(iter);
+    this->overflow_size_.fetch_sub(1);
+    return;
+  }
+
+  BATT_CHECK_EQ(this->entry(ticket.seq).state.load(), 2 * ticket.seq + 1)
+      << "ticket retired twice?";
+
+  // The state store and the head load in `advance_head` (like the head update and state load
+  // there) must be sequentially consistent: if this thread doesn't see the head reach
+  // `ticket.seq`, the thread that moved it will see that this entry is retired.
+  //
+  this->entry(ticket.seq).state.store(2 * ticket.seq + 2);
+
+  this->advance_head();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PendingSlotRing::advance_head() noexcept
+{
+  u64 head = this->head_.load();
+
+  while (head != this->tail_.load() && this->entry(head).state.load() == 2 * head + 2) {
+    if (this->head_.compare_exchange_weak(head, head + 1)) {
+      head += 1;
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<slot_offset_type> PendingSlotRing::min_pending() const noexcept
+{
+  Optional<slot_offset_type> result;
+
+  // Slots are pushed in order, so the first pending entry at or after the head has the lowest.
+  //
+  u64 seq = this->head_.load();
+  while (seq < this->tail_.load()) {
+    Entry& entry = this->entry(seq);
+
+    const u64 state = entry.state.load(std::memory_order_acquire);
+    if (state == 2 * seq + 2) {
+      seq += 1;
+      continue;
+    }
+    if (state == 2 * seq + 1) {
+      const slot_offset_type slot = entry.slot.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (entry.state.load(std::memory_order_relaxed) == state) {
+        result = slot;
+        break;
+      }
+    }
+
+    // The entry was retired and reused while we were reading it, so the head has moved past it.
+    //
+    seq = std::max(seq + 1, this->head_.load());
+  }
+
+  if (this->overflow_size_.load() != 0) {
+    std::unique_lock<std::mutex> lock{this->overflow_mutex_};
+
+    if (!this->overflow_.empty()) {
+      const slot_offset_type overflow_min = *this->overflow_.begin();
+      result = result ? slot_min(*result, overflow_min) : overflow_min;
+    }
+  }
+
+  return result;
+}
+
+}  // namespace llfs
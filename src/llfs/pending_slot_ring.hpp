@@ -0,0 +1,139 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_PENDING_SLOT_RING_HPP
+#define LLFS_PENDING_SLOT_RING_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/slot.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief The set of slot offsets of pending (unresolved) jobs, for the case where offsets are
+ * added in log order and are usually removed soon after, in roughly the same order (e.g., the
+ * prepare slots of the two-phase jobs of a Volume; see VolumeMetadataRefresher).
+ *
+ * Each slot added is given a dense sequence number, which is the index of its entry in a
+ * power-of-2 sized ring.  `push` (of which there may only be one caller at a time) and `retire`
+ * are lock-free and O(1); retiring the oldest pending slot advances the head of the ring past any
+ * later slots that were already retired.  `min_pending` reads the entry at the head.
+ *
+ * If the ring fills up (because a slot at the head is never retired, e.g. a failed job, or there
+ * are more than `capacity` pending slots), further slots are added to a mutex-protected std::set
+ * until there is room in the ring again.
+ */
+class PendingSlotRing
+{
+ public:
+  static constexpr usize kDefaultCapacity = 4096;
+
+  /** \brief Identifies a slot added via `push`; pass it to `retire`.
+   */
+  struct Ticket {
+    // The sequence number of the entry, or kOverflow if the slot is in the overflow set.
+    //
+    u64 seq;
+    slot_offset_type slot;
+  };
+
+  static constexpr u64 kOverflow = ~u64{0};
+
+  /** \brief Creates an empty ring; `capacity` is rounded up to a power of 2.
+   */
+  explicit PendingSlotRing(usize capacity = kDefaultCapacity) noexcept;
+
+  PendingSlotRing(const PendingSlotRing&) = delete;
+  PendingSlotRing& operator=(const PendingSlotRing&) = delete;
+
+  usize capacity() const noexcept
+  {
+    return this->capacity_;
+  }
+
+  /** \brief Adds `slot`, which must not be less than any slot previously added.  Only one thread
+   * may call `push` at a time.
+   */
+  Ticket push(slot_offset_type slot) noexcept;
+
+  /** \brief Removes the slot added by the `push` that returned `ticket`.  Safe to call
+   * concurrently with everything else; each ticket must be retired at most once.
+   */
+  void retire(const Ticket& ticket) noexcept;
+
+  /** \brief Returns the lowest slot that has been pushed but not retired, or None if there are
+   * none.
+   */
+  Optional<slot_offset_type> min_pending() const noexcept;
+
+  /** \brief The number of slots that were added to the overflow set because the ring was full.
+   */
+  u64 overflow_count() const noexcept
+  {
+    return this->overflow_count_.load();
+  }
+
+ private:
+  struct Entry {
+    // 2*seq+1 while the slot pushed with sequence number `seq` is pending, 2*seq+2 once it has
+    // been retired.
+    //
+    std::atomic<u64> state{0};
+
+    // Only read after `state` shows the entry is pending (and checked again afterwards, since the
+    // entry may be reused as soon as it is retired).
+    //
+    std::atomic<slot_offset_type> slot{0};
+  };
+
+  Entry& entry(u64 seq) const noexcept
+  {
+    return this->entries_[seq & (this->capacity_ - 1)];
+  }
+
+  /** \brief Moves the head past all retired entries.
+   */
+  void advance_head() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const usize capacity_;
+
+  const std::unique_ptr<Entry[]> entries_;
+
+  // All entries before `head_` have been retired.
+  //
+  std::atomic<u64> head_{0};
+
+  // The sequence number of the next slot to be pushed.
+  //
+  std::atomic<u64> tail_{0};
+
+  std::atomic<u64> overflow_count_{0};
+
+  // The number of slots in `overflow_`; lets `min_pending` skip the mutex when there are none.
+  //
+  std::atomic<usize> overflow_size_{0};
+
+  mutable std::mutex overflow_mutex_;
+
+  std::multiset<slot_offset_type, SlotLess> overflow_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_PENDING_SLOT_RING_HPP
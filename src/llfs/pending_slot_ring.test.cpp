@@ -0,0 +1,219 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/pending_slot_ring.hpp>
+//
+#include <llfs/pending_slot_ring.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <batteries/assert.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. (RandomRetireOrder) Slots retired in random order; min_pending always matches a std::set.
+//  2. (Overflow) When the slot at the head is never retired, slots that don't fit in the ring go
+//     to the overflow set and are still reported/retired correctly.
+//  3. (Concurrent) One thread pushes while several others retire and read; min_pending never
+//     returns a slot higher than one that is known to be pending, and nothing is left at the end.
+
+using namespace llfs::int_types;
+
+using llfs::PendingSlotRing;
+using llfs::slot_offset_type;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST(PendingSlotRingTest, RandomRetireOrder)
+{
+  for (usize seed = 0; seed < 20; ++seed) {
+    std::default_random_engine rng{seed};
+
+    PendingSlotRing ring{/*capacity=*/64};
+    std::set<slot_offset_type> expected;
+    std::vector<PendingSlotRing::Ticket> tickets;
+    slot_offset_type next_slot = 100;
+
+    for (usize step = 0; step < 2000; ++step) {
+      if (tickets.empty() || std::uniform_int_distribution<int>{0, 2}(rng) != 0) {
+        tickets.emplace_back(ring.push(next_slot));
+        expected.emplace(next_slot);
+        next_slot += std::uniform_int_distribution<slot_offset_type>{1, 50}(rng);
+      } else {
+        const usize i = std::uniform_int_distribution<usize>{0, tickets.size() - 1}(rng);
+        std::swap(tickets[i], tickets.back());
+        ring.retire(tickets.back());
+        expected.erase(tickets.back().slot);
+        tickets.pop_back();
+      }
+
+      if (expected.empty()) {
+        ASSERT_FALSE(ring.min_pending());
+      } else {
+        ASSERT_EQ(ring.min_pending(), *expected.begin())
+            << BATT_INSPECT(seed) << BATT_INSPECT(step);
+      }
+    }
+
+    for (const PendingSlotRing::Ticket& ticket : tickets) {
+      ring.retire(ticket);
+    }
+    EXPECT_FALSE(ring.min_pending());
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST(PendingSlotRingTest, Overflow)
+{
+  PendingSlotRing ring{/*capacity=*/4};
+
+  EXPECT_EQ(ring.capacity(), 4u);
+
+  const PendingSlotRing::Ticket stuck = ring.push(10);
+
+  std::vector<PendingSlotRing::Ticket> tickets;
+  for (slot_offset_type slot = 11; slot < 30; ++slot) {
+    tickets.emplace_back(ring.push(slot));
+    ring.retire(tickets.back());
+    tickets.pop_back();
+
+    tickets.emplace_back(ring.push(slot * 100));
+  }
+
+  EXPECT_GT(ring.overflow_count(), 0u);
+  EXPECT_EQ(ring.min_pending(), 10u);
+
+  ring.retire(stuck);
+
+  EXPECT_EQ(ring.min_pending(), 1100u);
+
+  for (const PendingSlotRing::Ticket& ticket : tickets) {
+    ring.retire(ticket);
+  }
+  EXPECT_FALSE(ring.min_pending());
+
+  // Once the ring is empty again, new slots go into the ring.
+  //
+  const u64 overflow_count = ring.overflow_count();
+  const PendingSlotRing::Ticket ticket = ring.push(5000);
+
+  EXPECT_NE(ticket.seq, PendingSlotRing::kOverflow);
+  EXPECT_EQ(ring.overflow_count(), overflow_count);
+  EXPECT_EQ(ring.min_pending(), 5000u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 3.
+//
+TEST(PendingSlotRingTest, Concurrent)
+{
+  constexpr usize kNumSlots = 200 * 1000;
+  constexpr usize kNumRetirers = 3;
+
+  PendingSlotRing ring{/*capacity=*/256};
+
+  std::mutex mutex;
+  std::vector<PendingSlotRing::Ticket> to_retire;
+  std::atomic<bool> done_pushing{false};
+
+  // The lowest slot that the pusher knows to still be pending; only updated by the pusher.
+  //
+  std::atomic<slot_offset_type> pinned_slot{~slot_offset_type{0}};
+
+  std::thread pusher{[&] {
+    llfs::Optional<PendingSlotRing::Ticket> pinned;
+    for (slot_offset_type slot = 1; slot <= kNumSlots; ++slot) {
+      const PendingSlotRing::Ticket ticket = ring.push(slot);
+
+      // Every 1000 slots, hold on to one slot and then retire the previous one held (only after
+      // publishing the new one, so `pinned_slot` is always pending).
+      //
+      if (slot % 1000 == 0) {
+        pinned_slot.store(slot);
+        if (pinned) {
+          ring.retire(*pinned);
+        }
+        pinned = ticket;
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock{mutex};
+      to_retire.emplace_back(ticket);
+    }
+    if (pinned) {
+      pinned_slot.store(~slot_offset_type{0});
+      ring.retire(*pinned);
+    }
+    done_pushing.store(true);
+  }};
+
+  std::vector<std::thread> retirers;
+  for (usize i = 0; i < kNumRetirers; ++i) {
+    retirers.emplace_back([&, i] {
+      std::default_random_engine rng{i};
+      for (;;) {
+        llfs::Optional<PendingSlotRing::Ticket> ticket;
+        {
+          std::unique_lock<std::mutex> lock{mutex};
+          if (!to_retire.empty()) {
+            const usize j = std::uniform_int_distribution<usize>{0, to_retire.size() - 1}(rng);
+            std::swap(to_retire[j], to_retire.back());
+            ticket = to_retire.back();
+            to_retire.pop_back();
+          }
+        }
+        if (ticket) {
+          ring.retire(*ticket);
+        } else if (done_pushing.load()) {
+          std::unique_lock<std::mutex> lock{mutex};
+          if (to_retire.empty()) {
+            break;
+          }
+        }
+      }
+    });
+  }
+
+  usize checks = 0;
+  while (!done_pushing.load()) {
+    const slot_offset_type upper_bound = pinned_slot.load();
+    const llfs::Optional<slot_offset_type> min_pending = ring.min_pending();
+
+    // If the pinned slot didn't change while we were reading min_pending, it was pending the
+    // whole time.
+    //
+    if (upper_bound != ~slot_offset_type{0} && upper_bound == pinned_slot.load()) {
+      ASSERT_TRUE(min_pending);
+      ASSERT_LE(*min_pending, upper_bound);
+      ++checks;
+    }
+  }
+
+  pusher.join();
+  for (std::thread& t : retirers) {
+    t.join();
+  }
+
+  EXPECT_FALSE(ring.min_pending());
+  EXPECT_GT(checks, 0u);
+}
+
+}  // namespace
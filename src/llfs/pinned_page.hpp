@@ -88,11 +88,25 @@ class PinnedPage
     return this->pinned_cache_slot_;
   }
 
+  // Returns the page buffer; valid for as long as this PinnedPage (or a copy of it) is alive.
+  // Unlike `get_page_buffer()`, this does not touch any reference count.
+  //
+  const PageBuffer& page_buffer() const noexcept
+  {
+    return this->page_view_->page_buffer();
+  }
+
+  // Returns shared ownership of the page buffer, which keeps it alive even after the page is
+  // unpinned and evicted.  Prefer copying the PinnedPage (a single atomic pin count update) when
+  // the page only needs to stay alive while it is in use.
+  //
   std::shared_ptr<const PageBuffer> get_page_buffer() const noexcept
   {
     return this->page_view_->data();
   }
 
+  // Returns shared ownership of the page view; see `get_page_buffer()`.
+  //
   std::shared_ptr<const PageView> get_shared_view() const
   {
     return BATT_OK_RESULT_OR_PANIC(this->pinned_cache_slot_.get()->get_ready_value_or_panic());
@@ -0,0 +1,192 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/pooled_string.hpp>
+//
+
+#include <boost/lockfree/policies.hpp>
+#include <boost/lockfree/stack.hpp>
+
+#include <cstring>
+
+namespace llfs {
+
+namespace {
+
+// The free blocks shared by all threads.
+//
+class SharedFreeBlocks
+{
+ public:
+  static SharedFreeBlocks& instance()
+  {
+    static SharedFreeBlocks* const instance_ = new SharedFreeBlocks{};
+    return *instance_;
+  }
+
+  bool push(char* block) noexcept
+  {
+    return this->stack_.bounded_push(block);
+  }
+
+  char* pop() noexcept
+  {
+    char* block = nullptr;
+    if (!this->stack_.pop(block)) {
+      return nullptr;
+    }
+    return block;
+  }
+
+ private:
+  boost::lockfree::stack<char*, boost::lockfree::capacity<PooledString::kMaxSharedFreeBlocks>>
+      stack_;
+};
+
+// The free blocks cached by the current thread, as an intrusive singly-linked list (the first
+// bytes of each free block point to the next).
+//
+struct ThreadFreeBlocks {
+  char* head = nullptr;
+  usize count = 0;
+
+  ~ThreadFreeBlocks() noexcept
+  {
+    while (this->head) {
+      char* const block = this->head;
+      std::memcpy(&this->head, block, sizeof(char*));
+      if (!SharedFreeBlocks::instance().push(block)) {
+        delete[] block;
+      }
+    }
+    this->count = 0;
+  }
+};
+
+// Set once the current thread's ThreadFreeBlocks has been destroyed, so that blocks released by
+// later thread_local destructors go straight to the shared pool.
+//
+thread_local bool thread_free_blocks_destroyed = false;
+
+struct ThreadFreeBlocksHolder {
+  ThreadFreeBlocks blocks;
+
+  ~ThreadFreeBlocksHolder() noexcept
+  {
+    thread_free_blocks_destroyed = true;
+  }
+};
+
+ThreadFreeBlocks* thread_free_blocks() noexcept
+{
+  if (thread_free_blocks_destroyed) {
+    return nullptr;
+  }
+  thread_local ThreadFreeBlocksHolder holder;
+  return &holder.blocks;
+}
+
+}  //namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ PooledString::PooledString(const std::string_view& s) : size_{s.size()}
+{
+  if (s.empty()) {
+    return;
+  }
+
+  if (s.size() < PooledString::kBlockSize) {
+    this->data_ = PooledString::allocate_block();
+  } else {
+    this->data_ = new char[s.size() + 1];
+  }
+
+  std::memcpy(this->data_, s.data(), s.size());
+  this->data_[s.size()] = '\0';
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PooledString& PooledString::operator=(const PooledString& that)
+{
+  if (this != &that) {
+    *this = PooledString{that.view()};
+  }
+  return *this;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PooledString& PooledString::operator=(PooledString&& that) noexcept
+{
+  if (this != &that) {
+    this->release();
+    this->data_ = that.data_;
+    this->size_ = that.size_;
+    that.data_ = nullptr;
+    that.size_ = 0;
+  }
+  return *this;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PooledString::release() noexcept
+{
+  if (this->data_) {
+    if (this->size_ < PooledString::kBlockSize) {
+      PooledString::free_block(this->data_);
+    } else {
+      delete[] this->data_;
+    }
+    this->data_ = nullptr;
+  }
+  this->size_ = 0;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ char* PooledString::allocate_block()
+{
+  ThreadFreeBlocks* const local = thread_free_blocks();
+
+  if (local && local->head) {
+    char* const block = local->head;
+    std::memcpy(&local->head, block, sizeof(char*));
+    local->count -= 1;
+    return block;
+  }
+
+  char* const block = SharedFreeBlocks::instance().pop();
+  if (block) {
+    return block;
+  }
+
+  return new char[PooledString::kBlockSize];
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ void PooledString::free_block(char* block) noexcept
+{
+  ThreadFreeBlocks* const local = thread_free_blocks();
+
+  if (local && local->count < PooledString::kMaxFreeBlocksPerThread) {
+    std::memcpy(block, &local->head, sizeof(char*));
+    local->head = block;
+    local->count += 1;
+    return;
+  }
+
+  if (!SharedFreeBlocks::instance().push(block)) {
+    delete[] block;
+  }
+}
+
+}  //namespace llfs
@@ -0,0 +1,129 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_POOLED_STRING_HPP
+#define LLFS_POOLED_STRING_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+
+#include <ostream>
+#include <string_view>
+
+namespace llfs {
+
+/** \brief An immutable copy of a string whose storage is a fixed-size block taken from a freelist,
+ * rather than a fresh heap allocation.
+ *
+ * This is meant for the short-lived copies that must be made of names (file names, xattr names,
+ * etc.) when a request is handed off to another thread: blocks are cached per-thread, and any a
+ * thread has too many of (e.g., because it frees the blocks that another thread allocates) go to
+ * a shared lock-free pool that the allocating thread draws from.  Strings longer than a block
+ * (which should be rare: NAME_MAX is 255) fall back to the heap.
+ */
+class PooledString
+{
+ public:
+  /** \brief The size of a pooled block; strings of at most this many chars (including a
+   * terminating null) are pooled.
+   */
+  static constexpr usize kBlockSize = 256;
+
+  /** \brief The maximum number of free blocks to cache in each thread.
+   */
+  static constexpr usize kMaxFreeBlocksPerThread = 128;
+
+  /** \brief The maximum number of free blocks in the shared pool.
+   */
+  static constexpr usize kMaxSharedFreeBlocks = 4096;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  PooledString() = default;
+
+  explicit PooledString(const std::string_view& s);
+
+  explicit PooledString(const char* s) : PooledString{std::string_view{s}}
+  {
+  }
+
+  PooledString(const PooledString& that) : PooledString{that.view()}
+  {
+  }
+
+  PooledString(PooledString&& that) noexcept : data_{that.data_}, size_{that.size_}
+  {
+    that.data_ = nullptr;
+    that.size_ = 0;
+  }
+
+  PooledString& operator=(const PooledString& that);
+
+  PooledString& operator=(PooledString&& that) noexcept;
+
+  ~PooledString() noexcept
+  {
+    this->release();
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  std::string_view view() const noexcept
+  {
+    return std::string_view{this->c_str(), this->size_};
+  }
+
+  operator std::string_view() const noexcept
+  {
+    return this->view();
+  }
+
+  /** \brief Returns a pointer to the (null-terminated) string.
+   */
+  const char* c_str() const noexcept
+  {
+    return this->data_ ? this->data_ : "";
+  }
+
+  usize size() const noexcept
+  {
+    return this->size_;
+  }
+
+  bool empty() const noexcept
+  {
+    return this->size_ == 0;
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  static char* allocate_block();
+
+  static void free_block(char* block) noexcept;
+
+  void release() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  // Null for the empty string.
+  //
+  char* data_ = nullptr;
+
+  usize size_ = 0;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const PooledString& t)
+{
+  return out << t.view();
+}
+
+}  //namespace llfs
+
+#endif  // LLFS_POOLED_STRING_HPP
@@ -0,0 +1,104 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/pooled_string.hpp>
+//
+#include <llfs/pooled_string.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. Empty, short and long (larger than a block) strings round-trip through copy/move
+//     construction and assignment.
+//  2. A block freed by a thread is reused by that thread's next allocation.
+//  3. Blocks allocated on one thread and freed on another (the FUSE reader -> worker pattern) are
+//     handed back through the shared pool without leaks or double frees.
+
+using namespace llfs::int_types;
+
+using llfs::PooledString;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PooledStringTest, CopyAndMove)
+{
+  const std::string long_str(PooledString::kBlockSize * 3, 'x');
+
+  for (const std::string& s : {std::string{}, std::string{"hello"},
+                               std::string(PooledString::kBlockSize - 1, 'y'), long_str}) {
+    PooledString ps{s};
+
+    EXPECT_EQ(ps.view(), s);
+    EXPECT_EQ(ps.size(), s.size());
+    EXPECT_EQ(ps.empty(), s.empty());
+    EXPECT_STREQ(ps.c_str(), s.c_str());
+
+    PooledString copy{ps};
+    EXPECT_EQ(copy.view(), s);
+
+    PooledString moved{std::move(copy)};
+    EXPECT_EQ(moved.view(), s);
+    EXPECT_TRUE(copy.empty());
+
+    PooledString assigned{"other"};
+    assigned = ps;
+    EXPECT_EQ(assigned.view(), s);
+
+    assigned = PooledString{long_str};
+    EXPECT_EQ(assigned.view(), long_str);
+
+    assigned = std::move(moved);
+    EXPECT_EQ(assigned.view(), s);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PooledStringTest, BlockReuse)
+{
+  const char* first_data = nullptr;
+  {
+    PooledString ps{"first"};
+    first_data = ps.c_str();
+  }
+  PooledString ps{"second"};
+
+  EXPECT_EQ(ps.c_str(), first_data);
+  EXPECT_EQ(ps.view(), "second");
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(PooledStringTest, CrossThreadFree)
+{
+  constexpr usize kCount = PooledString::kMaxFreeBlocksPerThread * 4;
+
+  for (usize round = 0; round < 4; ++round) {
+    std::vector<PooledString> strings;
+    for (usize i = 0; i < kCount; ++i) {
+      strings.emplace_back(std::to_string(i));
+    }
+
+    std::thread{[&strings] {
+      for (usize i = 0; i < strings.size(); ++i) {
+        EXPECT_EQ(strings[i].view(), std::to_string(i));
+      }
+      strings.clear();
+    }}.join();
+  }
+}
+
+}  // namespace
@@ -0,0 +1,507 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/posix_page_file_device.hpp>
+//
+
+#include <llfs/filesystem.hpp>
+#include <llfs/logging.hpp>
+#include <llfs/packed_page_header.hpp>
+#include <llfs/status_code.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/checked_cast.hpp>
+#include <batteries/finally.hpp>
+#include <batteries/syscall_retry.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+namespace llfs {
+
+namespace {
+
+using ::batt::syscall_retry;
+
+// Reads or writes all of `iov` (which is modified) starting at `offset`, retrying short transfers.
+//
+Status transfer_all_vectored(int fd, i64 offset, std::vector<struct iovec>& iov, bool is_write)
+{
+  usize first = 0;
+  while (first < iov.size()) {
+    const int count = static_cast<int>(std::min<usize>(iov.size() - first, IOV_MAX));
+
+    const ssize_t n_transferred = syscall_retry([&] {
+      return is_write ? ::pwritev(fd, iov.data() + first, count, offset)
+                      : ::preadv(fd, iov.data() + first, count, offset);
+    });
+    BATT_REQUIRE_OK(batt::status_from_retval(n_transferred));
+
+    if (n_transferred == 0) {
+      // A read at or past the end of the file; the file should have been grown to hold all the
+      // pages when it was opened.
+      //
+      return {batt::StatusCode::kOutOfRange};
+    }
+
+    offset += n_transferred;
+
+    usize remaining = n_transferred;
+    while (remaining > 0) {
+      struct iovec& next = iov[first];
+      if (remaining < next.iov_len) {
+        next.iov_base = static_cast<u8*>(next.iov_base) + remaining;
+        next.iov_len -= remaining;
+        break;
+      }
+      remaining -= next.iov_len;
+      first += 1;
+    }
+  }
+
+  return OkStatus();
+}
+
+// Flushes the data written to `fd` to stable storage.
+//
+Status sync_data(int fd)
+{
+#if defined(__APPLE__)
+  // On macOS, fsync doesn't ask the drive to flush its cache; F_FULLFSYNC does.
+  //
+  const int retval = syscall_retry([&] {
+    return ::fcntl(fd, F_FULLFSYNC);
+  });
+#else
+  const int retval = syscall_retry([&] {
+    return ::fdatasync(fd);
+  });
+#endif
+  return batt::status_from_retval(retval);
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<std::unique_ptr<PosixPageFileDevice>> PosixPageFileDevice::open(
+    const std::string& file_name, const FileOffsetPtr<const PackedPageDeviceConfig&>& config,
+    const PosixPageFileDeviceOptions& options)
+{
+  StatusOr<int> fd = open_file_read_write(file_name, OpenForAppend{false}, OpenRawIO{false});
+  BATT_REQUIRE_OK(fd);
+
+  auto close_on_error = batt::finally([&] {
+    if (*fd != -1) {
+      close_fd(*fd).IgnoreError();
+    }
+  });
+
+  // Grow the file (if necessary) so every page of the device is within it.
+  //
+  const i64 end_of_pages = config.absolute_page_0_offset() +
+                           (config->page_capacity() << u16{config->page_size_log2});
+
+  StatusOr<i64> file_size = sizeof_fd(*fd);
+  BATT_REQUIRE_OK(file_size);
+
+  if (*file_size < end_of_pages) {
+    BATT_REQUIRE_OK(truncate_fd(*fd, end_of_pages));
+  }
+
+  auto device = std::make_unique<PosixPageFileDevice>(*fd, config, options);
+  *fd = -1;
+
+  return device;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ PosixPageFileDevice::PosixPageFileDevice(
+    int fd, const FileOffsetPtr<const PackedPageDeviceConfig&>& config,
+    const PosixPageFileDeviceOptions& options) noexcept
+    : fd_{fd}
+    , config_{config}
+    , page_ids_{PageCount{BATT_CHECKED_CAST(u64, config->page_capacity())},
+                BATT_CHECKED_CAST(page_device_id_int, config->device_id.value())}
+    , options_{options}
+{
+  BATT_CHECK_GT(this->options_.thread_count, 0u);
+  BATT_CHECK_GT(this->options_.max_batch_size, 0u);
+
+  if (this->options_.mmap_reads) {
+    const usize end_of_pages = BATT_CHECKED_CAST(
+        usize, this->config_.absolute_page_0_offset() +
+                   (this->config_->page_capacity() << u16{this->config_->page_size_log2}));
+
+    void* const mapped = ::mmap(nullptr, end_of_pages, PROT_READ, MAP_SHARED, this->fd_, 0);
+    if (mapped == MAP_FAILED) {
+      LLFS_LOG_WARNING() << "PosixPageFileDevice: failed to map file; reads will use pread"
+                         << BATT_INSPECT(end_of_pages) << BATT_INSPECT(errno);
+    } else {
+      this->mapped_data_ = mapped;
+      this->mapped_size_ = end_of_pages;
+    }
+  }
+
+  for (usize i = 0; i < this->options_.thread_count; ++i) {
+    this->io_threads_.emplace_back([this] {
+      this->io_thread_main();
+    });
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PosixPageFileDevice::~PosixPageFileDevice() noexcept
+{
+  {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+    this->halt_requested_ = true;
+  }
+  this->pending_changed_.notify_all();
+
+  for (std::thread& t : this->io_threads_) {
+    t.join();
+  }
+
+  if (this->mapped_data_ != nullptr) {
+    ::munmap(const_cast<void*>(this->mapped_data_), this->mapped_size_);
+  }
+
+  close_fd(this->fd_).IgnoreError();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageIdFactory PosixPageFileDevice::page_ids()
+{
+  return this->page_ids_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageSize PosixPageFileDevice::page_size()
+{
+  return PageSize{BATT_CHECKED_CAST(u32, this->config_->page_size())};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::shared_ptr<PageBuffer>> PosixPageFileDevice::prepare(PageId page_id)
+{
+  return PageBuffer::allocate(this->page_size(), page_id);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PosixPageFileDevice::write(std::shared_ptr<const PageBuffer>&& page_buffer,
+                                WriteHandler&& handler)
+{
+  BATT_CHECK_NOT_NULLPTR(page_buffer);
+  BATT_CHECK_EQ(page_buffer->size(), this->page_size());
+
+  StatusOr<i64> file_offset = this->get_file_offset_of_page(page_buffer->page_id());
+  if (!file_offset.ok()) {
+    handler(file_offset.status());
+    return;
+  }
+
+  std::vector<PendingIo> ios;
+  ios.emplace_back(PendingIo{
+      .is_write = true,
+      .file_offset = *file_offset,
+      .page_id = page_buffer->page_id(),
+      .write_buffer = std::move(page_buffer),
+      .write_handler = std::move(handler),
+      .read_buffer = nullptr,
+      .read_handler = nullptr,
+  });
+
+  this->push_pending(std::move(ios));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PosixPageFileDevice::read(PageId id, ReadHandler&& handler)
+{
+  const PageId* const p_id = &id;
+
+  this->read_batch(batt::as_slice(p_id, 1), [&] {
+    std::vector<ReadHandler> handlers;
+    handlers.emplace_back(std::move(handler));
+    return handlers;
+  }());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PosixPageFileDevice::read_batch(const batt::Slice<const PageId>& ids,
+                                     std::vector<ReadHandler>&& handlers)
+{
+  BATT_CHECK_EQ(ids.size(), handlers.size());
+
+  std::vector<PendingIo> ios;
+
+  for (usize i = 0; i < ids.size(); ++i) {
+    const PageId page_id = ids[i];
+
+    StatusOr<i64> file_offset = this->get_file_offset_of_page(page_id);
+    if (!file_offset.ok()) {
+      handlers[i](file_offset.status());
+      continue;
+    }
+
+    if (this->mapped_data_ != nullptr) {
+      handlers[i](this->read_mapped(page_id, *file_offset));
+      continue;
+    }
+
+    ios.emplace_back(PendingIo{
+        .is_write = false,
+        .file_offset = *file_offset,
+        .page_id = page_id,
+        .write_buffer = nullptr,
+        .write_handler = nullptr,
+        .read_buffer = PageBuffer::allocate(this->page_size()),
+        .read_handler = std::move(handlers[i]),
+    });
+  }
+
+  if (!ios.empty()) {
+    this->push_pending(std::move(ios));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PosixPageFileDevice::drop(PageId id, WriteHandler&& handler)
+{
+  // As in IoRingPageFileDevice, there is nothing to do; a later read of this page id will fail the
+  // generation check once the physical page is rewritten.
+  //
+  (void)id;
+  handler(OkStatus());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<i64> PosixPageFileDevice::get_file_offset_of_page(PageId page_id) const
+{
+  const i64 physical_page = this->page_ids_.get_physical_page(page_id);
+  if (physical_page >= this->config_->page_capacity() || physical_page < 0) {
+    return Status{batt::StatusCode::kOutOfRange};
+  }
+
+  return this->config_.absolute_page_0_offset() +
+         (physical_page << u16{this->config_->page_size_log2});
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto PosixPageFileDevice::read_mapped(PageId page_id, i64 file_offset) -> ReadResult
+{
+  const usize page_size = this->page_size();
+
+  BATT_CHECK_LE(static_cast<usize>(file_offset) + page_size, this->mapped_size_);
+
+  std::shared_ptr<PageBuffer> page_buffer = PageBuffer::allocate(this->page_size());
+
+  std::memcpy(page_buffer->mutable_buffer().data(),
+              static_cast<const u8*>(this->mapped_data_) + file_offset, page_size);
+
+  metrics().mapped_read_count.add(1);
+
+  return this->finish_read(page_id, std::move(page_buffer));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto PosixPageFileDevice::finish_read(PageId page_id, std::shared_ptr<PageBuffer>&& page_buffer)
+    -> ReadResult
+{
+  metrics().page_read_count.add(1);
+
+  Status status = get_page_header(*page_buffer).sanity_check(this->page_size(), page_id,
+                                                             this->page_ids_);
+  if (!status.ok()) {
+    // As in IoRingPageFileDevice, report a page that has since been rewritten as not found.
+    //
+    if (status == StatusCode::kPageHeaderBadGeneration) {
+      return Status{batt::StatusCode::kNotFound};
+    }
+    return status;
+  }
+
+  return {std::move(page_buffer)};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PosixPageFileDevice::push_pending(std::vector<PendingIo>&& ios)
+{
+  {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+    BATT_CHECK(!this->halt_requested_);
+
+    for (PendingIo& io : ios) {
+      this->pending_.emplace_back(std::move(io));
+    }
+  }
+
+  if (ios.size() == 1) {
+    this->pending_changed_.notify_one();
+  } else {
+    this->pending_changed_.notify_all();
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PosixPageFileDevice::io_thread_main()
+{
+  for (;;) {
+    std::vector<PendingIo> reads;
+    std::vector<PendingIo> writes;
+    {
+      std::unique_lock<std::mutex> lock{this->mutex_};
+
+      this->pending_changed_.wait(lock, [this] {
+        return this->halt_requested_ || !this->pending_.empty();
+      });
+
+      // Keep going until the queue is drained, even once halt has been requested, so that no
+      // handler is left uncalled.
+      //
+      if (this->pending_.empty()) {
+        return;
+      }
+
+      while (!this->pending_.empty() &&
+             reads.size() + writes.size() < this->options_.max_batch_size) {
+        PendingIo& next = this->pending_.front();
+        if (next.is_write) {
+          writes.emplace_back(std::move(next));
+        } else {
+          reads.emplace_back(std::move(next));
+        }
+        this->pending_.pop_front();
+      }
+    }
+
+    // Pages are immutable once written, so the relative order of reads and writes in a batch
+    // doesn't matter.
+    //
+    if (!writes.empty()) {
+      this->process_batch(std::move(writes), /*is_write=*/true);
+    }
+    if (!reads.empty()) {
+      this->process_batch(std::move(reads), /*is_write=*/false);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PosixPageFileDevice::process_batch(std::vector<PendingIo>&& ios, bool is_write)
+{
+  const usize page_size = this->page_size();
+  const usize max_pages_per_op =
+      std::max<usize>(1, this->options_.max_coalesced_io_size / page_size);
+
+  std::sort(ios.begin(), ios.end(), [](const PendingIo& l, const PendingIo& r) {
+    return l.file_offset < r.file_offset;
+  });
+
+  std::vector<Status> results(ios.size(), OkStatus());
+  std::vector<struct iovec> iov;
+
+  // Issue one vectored syscall for each run of pages that are adjacent in the file.
+  //
+  for (usize first = 0; first < ios.size();) {
+    usize last = first + 1;
+    while (last < ios.size() && last - first < max_pages_per_op &&
+           ios[last].file_offset == ios[last - 1].file_offset + static_cast<i64>(page_size)) {
+      last += 1;
+    }
+
+    iov.clear();
+    for (usize i = first; i < last; ++i) {
+      if (is_write) {
+        iov.push_back(iovec{
+            .iov_base = const_cast<void*>(ios[i].write_buffer->const_buffer().data()),
+            .iov_len = page_size,
+        });
+      } else {
+        iov.push_back(iovec{
+            .iov_base = ios[i].read_buffer->mutable_buffer().data(),
+            .iov_len = page_size,
+        });
+      }
+    }
+
+    if (is_write) {
+      metrics().write_op_count.add(1);
+    } else {
+      metrics().read_op_count.add(1);
+    }
+
+    const Status status = transfer_all_vectored(this->fd_, ios[first].file_offset, iov, is_write);
+    if (!status.ok()) {
+      LLFS_LOG_WARNING() << "PosixPageFileDevice: " << (is_write ? "write" : "read")
+                         << " failed;" << BATT_INSPECT(ios[first].file_offset)
+                         << BATT_INSPECT(last - first) << BATT_INSPECT(status);
+    }
+    for (usize i = first; i < last; ++i) {
+      results[i] = status;
+    }
+
+    first = last;
+  }
+
+  if (is_write) {
+    // One flush covers all the writes in the batch.
+    //
+    if (this->options_.sync_writes) {
+      metrics().sync_count.add(1);
+      const Status sync_status = sync_data(this->fd_);
+      if (!sync_status.ok()) {
+        for (Status& result : results) {
+          if (result.ok()) {
+            result = sync_status;
+          }
+        }
+      }
+    }
+
+    for (usize i = 0; i < ios.size(); ++i) {
+      metrics().page_write_count.add(1);
+      WriteHandler handler = std::move(ios[i].write_handler);
+      ios[i].write_buffer = nullptr;
+      handler(results[i]);
+    }
+  } else {
+    for (usize i = 0; i < ios.size(); ++i) {
+      ReadHandler handler = std::move(ios[i].read_handler);
+      if (!results[i].ok()) {
+        handler(results[i]);
+      } else {
+        handler(this->finish_read(ios[i].page_id, std::move(ios[i].read_buffer)));
+      }
+    }
+  }
+}
+
+}  // namespace llfs
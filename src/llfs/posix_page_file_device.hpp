@@ -0,0 +1,210 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_POSIX_PAGE_FILE_DEVICE_HPP
+#define LLFS_POSIX_PAGE_FILE_DEVICE_HPP
+
+#include <llfs/constants.hpp>
+#include <llfs/file_offset_ptr.hpp>
+#include <llfs/int_types.hpp>
+#include <llfs/metrics.hpp>
+#include <llfs/page_device.hpp>
+#include <llfs/page_device_config.hpp>
+#include <llfs/status.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace llfs {
+
+struct PosixPageFileDeviceOptions {
+  /** \brief The number of threads that issue I/O to the file.
+   */
+  usize thread_count = 4;
+
+  /** \brief The maximum number of queued page reads/writes an I/O thread takes at once; within a
+   * batch, pages that are adjacent in the file are read or written with a single vectored syscall.
+   */
+  usize max_batch_size = 32;
+
+  /** \brief The limit on the size of a single merged read or write.
+   */
+  usize max_coalesced_io_size = 256 * kKiB;
+
+  /** \brief If true, writes are flushed to stable storage (once per batch) before their handlers
+   * are invoked.
+   */
+  bool sync_writes = true;
+
+  /** \brief If true, the file is mapped into memory and `read` copies pages out of the mapping on
+   * the calling thread instead of queuing a pread.
+   */
+  bool mmap_reads = false;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A PageDevice that stores pages in a single file, using plain POSIX pread/pwrite from a
+ * pool of I/O threads; for platforms and containers where io_uring isn't available.
+ *
+ * The layout of the file is the same as for IoRingPageFileDevice (it is described by a
+ * PackedPageDeviceConfig), so the same file can be opened with either implementation.  The file
+ * is grown to hold all the pages of the device when it is opened.
+ *
+ * As with IoRingPageFileDevice, `drop` does nothing, and a read whose page header carries a
+ * different generation than the requested PageId fails with `batt::StatusCode::kNotFound`.
+ */
+class PosixPageFileDevice : public PageDevice
+{
+ public:
+  struct Metrics {
+    /** \brief The number of pages read (including reads from the mapping).
+     */
+    CountMetric<u64> page_read_count{0};
+
+    /** \brief The number of pages read by copying from the mapped file (see
+     * PosixPageFileDeviceOptions::mmap_reads).
+     */
+    CountMetric<u64> mapped_read_count{0};
+
+    /** \brief The number of read syscalls issued; page_read_count / read_op_count is the merge
+     * ratio (not counting mapped reads).
+     */
+    CountMetric<u64> read_op_count{0};
+
+    /** \brief The number of pages written.
+     */
+    CountMetric<u64> page_write_count{0};
+
+    /** \brief The number of write syscalls issued.
+     */
+    CountMetric<u64> write_op_count{0};
+
+    /** \brief The number of times the file was flushed to stable storage.
+     */
+    CountMetric<u64> sync_count{0};
+  };
+
+  static Metrics& metrics()
+  {
+    static Metrics m_;
+    return m_;
+  }
+
+  /** \brief Opens the file containing the page device described by `config`.
+   */
+  static StatusOr<std::unique_ptr<PosixPageFileDevice>> open(
+      const std::string& file_name, const FileOffsetPtr<const PackedPageDeviceConfig&>& config,
+      const PosixPageFileDeviceOptions& options = PosixPageFileDeviceOptions{});
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Creates a device that reads and writes pages to `fd`, which must be open for reading
+   * and writing and large enough to hold all of the device's pages.  Takes ownership of `fd`.
+   */
+  explicit PosixPageFileDevice(int fd, const FileOffsetPtr<const PackedPageDeviceConfig&>& config,
+                               const PosixPageFileDeviceOptions& options) noexcept;
+
+  /** \brief Waits for all queued reads and writes to complete, then closes the file.
+   */
+  ~PosixPageFileDevice() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  PageIdFactory page_ids() override;
+
+  PageSize page_size() override;
+
+  StatusOr<std::shared_ptr<PageBuffer>> prepare(PageId page_id) override;
+
+  void write(std::shared_ptr<const PageBuffer>&& page_buffer, WriteHandler&& handler) override;
+
+  void read(PageId id, ReadHandler&& handler) override;
+
+  /** \brief Queues all the reads at once, so that pages adjacent in the file can be merged.
+   */
+  void read_batch(const batt::Slice<const PageId>& ids,
+                  std::vector<ReadHandler>&& handlers) override;
+
+  void drop(PageId id, WriteHandler&& handler) override;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const PosixPageFileDeviceOptions& options() const
+  {
+    return this->options_;
+  }
+
+ private:
+  /** \brief A page read or write waiting for an I/O thread.
+   */
+  struct PendingIo {
+    bool is_write;
+    i64 file_offset;
+    PageId page_id;
+
+    // Set for writes.
+    //
+    std::shared_ptr<const PageBuffer> write_buffer;
+    WriteHandler write_handler;
+
+    // Set for reads.
+    //
+    std::shared_ptr<PageBuffer> read_buffer;
+    ReadHandler read_handler;
+  };
+
+  StatusOr<i64> get_file_offset_of_page(PageId page_id) const;
+
+  /** \brief Copies the page at `file_offset` out of the mapped file.
+   */
+  ReadResult read_mapped(PageId page_id, i64 file_offset);
+
+  /** \brief Verifies the header of a page that was just read.
+   */
+  ReadResult finish_read(PageId page_id, std::shared_ptr<PageBuffer>&& page_buffer);
+
+  void push_pending(std::vector<PendingIo>&& ios);
+
+  void io_thread_main();
+
+  /** \brief Issues all the reads or writes (not both) in `ios`, merging the ones adjacent in the
+   * file, and then completes them.
+   */
+  void process_batch(std::vector<PendingIo>&& ios, bool is_write);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const int fd_;
+  const FileOffsetPtr<PackedPageDeviceConfig> config_;
+  const PageIdFactory page_ids_;
+  const PosixPageFileDeviceOptions options_;
+
+  // The mapped file, if `options_.mmap_reads` is true and mapping the file succeeded.
+  //
+  const void* mapped_data_ = nullptr;
+  usize mapped_size_ = 0;
+
+  // Protects `pending_` and `halt_requested_`.
+  //
+  std::mutex mutex_;
+  std::condition_variable pending_changed_;
+  std::deque<PendingIo> pending_;
+  bool halt_requested_ = false;
+
+  std::vector<std::thread> io_threads_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_POSIX_PAGE_FILE_DEVICE_HPP
@@ -0,0 +1,242 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/posix_page_file_device.hpp>
+//
+#include <llfs/posix_page_file_device.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/filesystem.hpp>
+#include <llfs/page_buffer.hpp>
+
+#include <cstring>
+#include <future>
+#include <vector>
+
+namespace {
+
+using namespace llfs::int_types;
+
+// Test Plan:
+//  1. Open grows the file to hold every page; pages written can be read back, after reopening the
+//     file too; reading a page rewritten with a newer generation fails with kNotFound; reading a
+//     page that was never written fails; page ids past the end of the device are kOutOfRange.
+//  2. A batch of reads of adjacent pages is merged into a single read syscall.
+//  3. With mmap_reads, reads are copied out of the mapped file.
+
+constexpr u64 kPageSize = 4096;
+constexpr i64 kPageCount = 16;
+constexpr llfs::page_device_id_int kDeviceId = 3;
+
+class PosixPageFileDeviceTest : public ::testing::Test
+{
+ public:
+  void SetUp() override
+  {
+    llfs::delete_file(this->file_name_).IgnoreError();
+    ASSERT_TRUE(llfs::truncate_file(this->file_name_, 0).ok());
+
+    std::memset(&this->config_, 0, sizeof(this->config_));
+
+    // Leave room for the config itself at the start of the file, as a StorageFile would.
+    //
+    this->config_.page_0_offset = kPageSize;
+    this->config_.device_id = kDeviceId;
+    this->config_.page_count = kPageCount;
+    this->config_.page_size_log2 = 12;
+  }
+
+  void TearDown() override
+  {
+    llfs::delete_file(this->file_name_).IgnoreError();
+  }
+
+  std::unique_ptr<llfs::PosixPageFileDevice> open_device(
+      const llfs::PosixPageFileDeviceOptions& options = llfs::PosixPageFileDeviceOptions{})
+  {
+    llfs::StatusOr<std::unique_ptr<llfs::PosixPageFileDevice>> device =
+        llfs::PosixPageFileDevice::open(
+            this->file_name_,
+            llfs::FileOffsetPtr<const llfs::PackedPageDeviceConfig&>{this->config_, 0}, options);
+
+    EXPECT_TRUE(device.ok()) << BATT_INSPECT(device.status());
+    if (!device.ok()) {
+      return nullptr;
+    }
+    return std::move(*device);
+  }
+
+  llfs::Status write_page(llfs::PageDevice& device, llfs::PageId page_id, u8 value)
+  {
+    llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer = device.prepare(page_id);
+    BATT_REQUIRE_OK(buffer);
+
+    std::memset((*buffer)->mutable_payload().data(), value, (*buffer)->mutable_payload().size());
+
+    std::promise<llfs::Status> result;
+    device.write(std::move(*buffer), [&result](llfs::Status status) {
+      result.set_value(status);
+    });
+    return result.get_future().get();
+  }
+
+  // Returns the first payload byte of the page.
+  //
+  llfs::StatusOr<u8> read_page(llfs::PageDevice& device, llfs::PageId page_id)
+  {
+    std::promise<llfs::PageDevice::ReadResult> result;
+    device.read(page_id, [&result](llfs::PageDevice::ReadResult page) {
+      result.set_value(std::move(page));
+    });
+
+    llfs::PageDevice::ReadResult page = result.get_future().get();
+    BATT_REQUIRE_OK(page);
+
+    EXPECT_EQ((*page)->page_id(), page_id);
+
+    return static_cast<const u8*>((*page)->const_payload().data())[0];
+  }
+
+ protected:
+  const std::string file_name_ = "/tmp/llfs_PosixPageFileDeviceTest.llfs";
+
+  llfs::PackedPageDeviceConfig config_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(PosixPageFileDeviceTest, WriteRead)
+{
+  std::vector<llfs::PageId> page_ids;
+  {
+    std::unique_ptr<llfs::PosixPageFileDevice> device = this->open_device();
+    ASSERT_NE(device, nullptr);
+
+    llfs::StatusOr<i64> file_size = llfs::sizeof_file(this->file_name_);
+    ASSERT_TRUE(file_size.ok());
+    EXPECT_EQ(*file_size, static_cast<i64>(kPageSize * (kPageCount + 1)));
+
+    const llfs::PageIdFactory ids = device->page_ids();
+
+    for (i64 i = 0; i < kPageCount; i += 2) {
+      const llfs::PageId page_id = ids.make_page_id(i, 1);
+      ASSERT_TRUE(this->write_page(*device, page_id, /*value=*/i + 1).ok());
+      page_ids.emplace_back(page_id);
+    }
+
+    for (const llfs::PageId page_id : page_ids) {
+      llfs::StatusOr<u8> value = this->read_page(*device, page_id);
+      ASSERT_TRUE(value.ok()) << BATT_INSPECT(value.status()) << BATT_INSPECT(page_id);
+      EXPECT_EQ(*value, ids.get_physical_page(page_id) + 1);
+    }
+
+    // A page that was never written.
+    //
+    EXPECT_FALSE(this->read_page(*device, ids.make_page_id(1, 1)).ok());
+
+    // A page past the end of the device.
+    //
+    EXPECT_EQ(this->read_page(*device, ids.make_page_id(kPageCount, 1)).status(),
+              batt::StatusCode::kOutOfRange);
+
+    // Rewrite page 0 with a newer generation; the old page id is no longer found.
+    //
+    const llfs::PageId new_page_0 = ids.make_page_id(0, 2);
+    ASSERT_TRUE(this->write_page(*device, new_page_0, /*value=*/99).ok());
+
+    EXPECT_EQ(this->read_page(*device, page_ids[0]).status(), batt::StatusCode::kNotFound);
+    page_ids[0] = new_page_0;
+  }
+
+  // The pages are still there once the file is reopened.
+  //
+  std::unique_ptr<llfs::PosixPageFileDevice> device = this->open_device();
+  ASSERT_NE(device, nullptr);
+
+  for (usize i = 0; i < page_ids.size(); ++i) {
+    llfs::StatusOr<u8> value = this->read_page(*device, page_ids[i]);
+    ASSERT_TRUE(value.ok()) << BATT_INSPECT(value.status());
+    EXPECT_EQ(*value, (i == 0) ? 99 : (i * 2 + 1));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(PosixPageFileDeviceTest, ReadBatchCoalesces)
+{
+  llfs::PosixPageFileDeviceOptions options;
+  options.thread_count = 1;
+  options.max_batch_size = kPageCount;
+  options.sync_writes = false;
+
+  std::unique_ptr<llfs::PosixPageFileDevice> device = this->open_device(options);
+  ASSERT_NE(device, nullptr);
+
+  const llfs::PageIdFactory ids = device->page_ids();
+
+  std::vector<llfs::PageId> page_ids;
+  for (i64 i = 0; i < kPageCount; ++i) {
+    page_ids.emplace_back(ids.make_page_id(i, 1));
+    ASSERT_TRUE(this->write_page(*device, page_ids.back(), /*value=*/i).ok());
+  }
+
+  const u64 read_ops_before = llfs::PosixPageFileDevice::metrics().read_op_count.load();
+
+  std::vector<std::promise<llfs::PageDevice::ReadResult>> results(page_ids.size());
+  std::vector<llfs::PageDevice::ReadHandler> handlers;
+  for (usize i = 0; i < page_ids.size(); ++i) {
+    handlers.emplace_back([&results, i](llfs::PageDevice::ReadResult page) {
+      results[i].set_value(std::move(page));
+    });
+  }
+
+  device->read_batch(batt::as_slice(page_ids), std::move(handlers));
+
+  for (usize i = 0; i < page_ids.size(); ++i) {
+    llfs::PageDevice::ReadResult page = results[i].get_future().get();
+    ASSERT_TRUE(page.ok()) << BATT_INSPECT(page.status());
+    EXPECT_EQ((*page)->page_id(), page_ids[i]);
+    EXPECT_EQ(static_cast<const u8*>((*page)->const_payload().data())[0], i);
+  }
+
+  // All the pages are adjacent and fit in one merged read.
+  //
+  EXPECT_EQ(llfs::PosixPageFileDevice::metrics().read_op_count.load() - read_ops_before, 1u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(PosixPageFileDeviceTest, MappedReads)
+{
+  llfs::PosixPageFileDeviceOptions options;
+  options.mmap_reads = true;
+
+  std::unique_ptr<llfs::PosixPageFileDevice> device = this->open_device(options);
+  ASSERT_NE(device, nullptr);
+
+  const llfs::PageIdFactory ids = device->page_ids();
+  const llfs::PageId page_id = ids.make_page_id(5, 1);
+
+  ASSERT_TRUE(this->write_page(*device, page_id, /*value=*/42).ok());
+
+  const u64 mapped_reads_before = llfs::PosixPageFileDevice::metrics().mapped_read_count.load();
+
+  llfs::StatusOr<u8> value = this->read_page(*device, page_id);
+  ASSERT_TRUE(value.ok()) << BATT_INSPECT(value.status());
+  EXPECT_EQ(*value, 42);
+
+  EXPECT_EQ(llfs::PosixPageFileDevice::metrics().mapped_read_count.load() - mapped_reads_before,
+            1u);
+
+  EXPECT_EQ(this->read_page(*device, ids.make_page_id(5, 2)).status(),
+            batt::StatusCode::kNotFound);
+}
+
+}  // namespace
@@ -50,18 +50,24 @@ Status RawBlockFile::validate_buffer(const ConstBuffer& buffer, i64 offset)
 //
 Status write_all(RawBlockFile& file, i64 offset, const ConstBuffer& data)
 {
-  return transfer_all(offset, data, [&file](i64 offset, const ConstBuffer& data) {
-    return file.write_some(offset, data);
-  });
+  return transfer_all(
+      offset, data,
+      [&file](i64 offset, const ConstBuffer& data) {
+        return file.write_some(offset, data);
+      },
+      /*align_transfers=*/file.requires_aligned_io());
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 Status read_all(RawBlockFile& file, i64 offset, const MutableBuffer& buffer)
 {
-  return transfer_all(offset, buffer, [&file](i64 offset, const MutableBuffer& buffer) {
-    return file.read_some(offset, buffer);
-  });
+  return transfer_all(
+      offset, buffer,
+      [&file](i64 offset, const MutableBuffer& buffer) {
+        return file.read_some(offset, buffer);
+      },
+      /*align_transfers=*/file.requires_aligned_io());
 }
 
 }  // namespace llfs
@@ -88,6 +88,16 @@ class RawBlockFile
     return batt::StatusCode::kUnimplemented;
   }
 
+  // Returns true iff the buffers, sizes and offsets passed to write_some and read_some must be
+  // 512-byte aligned (see validate_buffer); this is the default.  Implementations that accept any
+  // alignment (e.g., BounceBufferRawBlockFile) return false, and may then return transfer sizes
+  // that aren't multiples of 512.
+  //
+  virtual bool requires_aligned_io() const
+  {
+    return true;
+  }
+
 #ifndef LLFS_DISABLE_IO_URING
   //
   virtual IoRing::File* get_io_ring_file()
@@ -109,10 +119,12 @@ Status write_all(RawBlockFile& file, i64 offset, const ConstBuffer& data);
 //
 Status read_all(RawBlockFile& file, i64 offset, const MutableBuffer& buffer);
 
-// Generic form of write_all/read_all.
+// Generic form of write_all/read_all.  If `align_transfers` is true, the size of each partial
+// transfer is rounded down to a multiple of 512 (so the next transfer starts aligned).
 //
 template <typename BufferT, typename TransferOp>
-Status transfer_all(i64 offset, const BufferT& buffer, TransferOp&& transfer_some)
+Status transfer_all(i64 offset, const BufferT& buffer, TransferOp&& transfer_some,
+                    bool align_transfers = true)
 {
   BufferT remaining = buffer;
   while (remaining.size() != 0) {
@@ -123,7 +135,9 @@ Status transfer_all(i64 offset, const BufferT& buffer, TransferOp&& transfer_som
       }
       BATT_REQUIRE_OK(n_transferred);
 
-      *n_transferred = RawBlockFile::align_down(*n_transferred);
+      if (align_transfers) {
+        *n_transferred = RawBlockFile::align_down(*n_transferred);
+      }
       if (*n_transferred == 0) {
         return make_status(StatusCode::kTransferAllBadAlignment);
       }
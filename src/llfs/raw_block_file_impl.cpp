@@ -22,6 +22,9 @@
 
 #include <boost/io/ios_state.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <utility>
 
 namespace llfs {
@@ -119,6 +122,201 @@ Status IoRingRawBlockFile::close()
   return close_fd(this->file_.release());
 }
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class BounceBufferRawBlockFile
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ BounceBufferRawBlockFile::BounceBufferRawBlockFile(
+    std::unique_ptr<RawBlockFile>&& file, IoRingBufferPool& pool) noexcept
+    : file_{std::move(file)}
+    , pool_{pool}
+{
+  BATT_CHECK_NOT_NULLPTR(this->file_);
+
+  const i64 buffer_size = BATT_CHECKED_CAST(i64, this->pool_.buffer_size().value());
+
+  BATT_CHECK_GE(buffer_size, 512);
+  BATT_CHECK_EQ(RawBlockFile::align_down(buffer_size), buffer_size)
+      << "Bounce buffers must be a multiple of 512 bytes";
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<i64> BounceBufferRawBlockFile::write_some(i64 offset, const ConstBuffer& data) /*override*/
+{
+  if (offset < 0) {
+    return {batt::StatusCode::kInvalidArgument};
+  }
+  if (data.size() == 0) {
+    return 0;
+  }
+  if (BounceBufferRawBlockFile::is_aligned_transfer(offset, data.data(), data.size())) {
+    const i64 aligned_size = RawBlockFile::align_down(BATT_CHECKED_CAST(i64, data.size()));
+    return this->file_->write_some(offset, resize_buffer(data, aligned_size));
+  }
+
+  const BounceRange range = this->get_bounce_range(offset, data.data(), data.size());
+
+  StatusOr<IoRingBufferPool::Buffer> bounce = this->pool_.await_allocate();
+  BATT_REQUIRE_OK(bounce);
+
+  u8* const bounce_data = static_cast<u8*>(bounce->data());
+
+  const i64 copy_size =
+      std::min(BATT_CHECKED_CAST(i64, data.size()), range.aligned_size - range.head_size);
+  const i64 copy_end = range.head_size + copy_size;
+
+  // Read the blocks that are only partly overwritten, so the rest of their contents survives.
+  //
+  const i64 last_block = RawBlockFile::align_down(copy_end - 1);
+
+  if (range.head_size != 0) {
+    BATT_REQUIRE_OK(
+        this->read_for_update(range.aligned_offset, MutableBuffer{bounce_data, /*size=*/512}));
+  }
+  if ((copy_end % 512) != 0 && !(range.head_size != 0 && last_block == 0)) {
+    BATT_REQUIRE_OK(this->read_for_update(range.aligned_offset + last_block,
+                                          MutableBuffer{bounce_data + last_block, /*size=*/512}));
+  }
+
+  std::memcpy(bounce_data + range.head_size, data.data(), copy_size);
+
+  BATT_REQUIRE_OK(
+      write_all(*this->file_, range.aligned_offset,
+                ConstBuffer{bounce_data, BATT_CHECKED_CAST(usize, range.aligned_size)}));
+
+  return copy_size;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<i64> BounceBufferRawBlockFile::read_some(i64 offset,
+                                                  const MutableBuffer& buffer) /*override*/
+{
+  if (offset < 0) {
+    return {batt::StatusCode::kInvalidArgument};
+  }
+  if (buffer.size() == 0) {
+    return 0;
+  }
+  if (BounceBufferRawBlockFile::is_aligned_transfer(offset, buffer.data(), buffer.size())) {
+    const i64 aligned_size = RawBlockFile::align_down(BATT_CHECKED_CAST(i64, buffer.size()));
+    return this->file_->read_some(offset, resize_buffer(buffer, aligned_size));
+  }
+
+  const BounceRange range = this->get_bounce_range(offset, buffer.data(), buffer.size());
+
+  StatusOr<IoRingBufferPool::Buffer> bounce = this->pool_.await_allocate();
+  BATT_REQUIRE_OK(bounce);
+
+  u8* const bounce_data = static_cast<u8*>(bounce->data());
+
+  StatusOr<i64> n_read = this->file_->read_some(
+      range.aligned_offset,
+      MutableBuffer{bounce_data, BATT_CHECKED_CAST(usize, range.aligned_size)});
+  BATT_REQUIRE_OK(n_read);
+
+  // A short read may not even reach `offset` (e.g., at end-of-file).
+  //
+  const i64 copy_size = std::min(BATT_CHECKED_CAST(i64, buffer.size()),
+                                 std::max<i64>(0, *n_read - range.head_size));
+
+  if (copy_size > 0) {
+    std::memcpy(buffer.data(), bounce_data + range.head_size, copy_size);
+  }
+
+  return copy_size;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<i64> BounceBufferRawBlockFile::get_size() /*override*/
+{
+  return this->file_->get_size();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status BounceBufferRawBlockFile::truncate(i64 new_offset_upper_bound) /*override*/
+{
+  return this->file_->truncate(new_offset_upper_bound);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status BounceBufferRawBlockFile::truncate_at_least(i64 minimum_size) /*override*/
+{
+  return this->file_->truncate_at_least(minimum_size);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ bool BounceBufferRawBlockFile::is_aligned_transfer(i64 offset, const void* data,
+                                                             usize size)
+{
+  return (offset % 512) == 0 && (reinterpret_cast<std::uintptr_t>(data) % 512) == 0 &&
+         size >= 512;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto BounceBufferRawBlockFile::get_bounce_range(i64 offset, const void* data, usize size) const
+    -> BounceRange
+{
+  const i64 aligned_offset = RawBlockFile::align_down(offset);
+  const i64 head_size = offset - aligned_offset;
+
+  i64 aligned_end = RawBlockFile::align_up(offset + BATT_CHECKED_CAST(i64, size));
+
+  // If the caller's memory is aligned once we get past the first (partial) block, bounce only
+  // that block; the rest can be passed straight through by the next call.
+  //
+  if (head_size != 0) {
+    const i64 bytes_to_next_block = 512 - head_size;
+    const std::uintptr_t next_block_data =
+        reinterpret_cast<std::uintptr_t>(data) + bytes_to_next_block;
+
+    if ((next_block_data % 512) == 0) {
+      aligned_end = std::min(aligned_end, aligned_offset + 512);
+    }
+  }
+
+  return BounceRange{
+      .aligned_offset = aligned_offset,
+      .aligned_size = std::min(aligned_end - aligned_offset,
+                               BATT_CHECKED_CAST(i64, this->pool_.buffer_size().value())),
+      .head_size = head_size,
+  };
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status BounceBufferRawBlockFile::read_for_update(i64 offset, const MutableBuffer& buffer)
+{
+  MutableBuffer remaining = buffer;
+  while (remaining.size() != 0) {
+    StatusOr<i64> n_read = this->file_->read_some(offset, remaining);
+    if (!n_read.ok() && batt::status_is_retryable(n_read.status())) {
+      continue;
+    }
+    BATT_REQUIRE_OK(n_read);
+
+    offset += *n_read;
+    remaining += *n_read;
+
+    // End-of-file (an unaligned short read can only happen there).
+    //
+    if (*n_read == 0 || RawBlockFile::align_down(*n_read) != *n_read) {
+      break;
+    }
+  }
+
+  std::memset(remaining.data(), 0, remaining.size());
+
+  return OkStatus();
+}
+
 }  // namespace llfs
 
 #endif  // LLFS_DISABLE_IO_URING
@@ -17,6 +17,7 @@
 
 #ifndef LLFS_DISABLE_IO_URING
 
+#include <llfs/ioring_buffer_pool.hpp>
 #include <llfs/ioring_file.hpp>
 #include <llfs/optional.hpp>
 #include <llfs/raw_block_file.hpp>
@@ -59,6 +60,81 @@ class IoRingRawBlockFile : public RawBlockFile
   IoRing::File file_;
 };
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// A RawBlockFile decorator that accepts buffers, sizes and offsets of any alignment, so that
+// callers of an unbuffered (O_DIRECT) file don't need to align their I/O.
+//
+// A transfer whose offset, size and memory are all block-aligned is passed straight through to the
+// wrapped file.  Otherwise the unaligned part goes through a bounce buffer allocated from `pool`:
+// reads fill the bounce buffer from the covering aligned range and copy out; writes read the
+// partially covered edge blocks first (read-modify-write), copy in, and write the aligned range.
+// When the caller's memory is aligned everywhere but at the head, only the head block is bounced,
+// and the aligned interior is transferred without copying on the next call.
+//
+// The read-modify-write of an edge block is not atomic: concurrent unaligned writes that touch the
+// same 512-byte block must be serialized by the caller.
+//
+class BounceBufferRawBlockFile : public RawBlockFile
+{
+ public:
+  // `pool` must outlive this object; its buffers must be a multiple of 512 bytes in size.  Each
+  // (unaligned) call to write_some/read_some holds one buffer for its duration.
+  //
+  explicit BounceBufferRawBlockFile(std::unique_ptr<RawBlockFile>&& file,
+                                    IoRingBufferPool& pool) noexcept;
+
+  StatusOr<i64> write_some(i64 offset, const ConstBuffer& data) override;
+
+  StatusOr<i64> read_some(i64 offset, const MutableBuffer& buffer) override;
+
+  StatusOr<i64> get_size() override;
+
+  Status truncate(i64 new_offset_upper_bound) override;
+
+  Status truncate_at_least(i64 minimum_size) override;
+
+  bool requires_aligned_io() const override
+  {
+    return false;
+  }
+
+  IoRing::File* get_io_ring_file() override
+  {
+    return this->file_->get_io_ring_file();
+  }
+
+  // The wrapped file.
+  //
+  RawBlockFile& base_file() const noexcept
+  {
+    return *this->file_;
+  }
+
+ private:
+  // The aligned file range a bounced transfer of `size` bytes at `offset` covers: at most one pool
+  // buffer, starting at the aligned block containing `offset`.
+  //
+  struct BounceRange {
+    i64 aligned_offset;
+    i64 aligned_size;
+    i64 head_size;
+  };
+
+  // Returns true iff the transfer can be passed straight through to the base file.
+  //
+  static bool is_aligned_transfer(i64 offset, const void* data, usize size);
+
+  BounceRange get_bounce_range(i64 offset, const void* data, usize size) const;
+
+  // Reads the block-aligned range [offset, offset + buffer.size()) from the base file, filling any
+  // part past the end of the file with zeros.
+  //
+  Status read_for_update(i64 offset, const MutableBuffer& buffer);
+
+  std::unique_ptr<RawBlockFile> file_;
+  IoRingBufferPool& pool_;
+};
+
 }  // namespace llfs
 
 #endif  // LLFS_DISABLE_IO_URING
@@ -0,0 +1,228 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/raw_block_file_impl.hpp>
+//
+#include <llfs/raw_block_file_impl.hpp>
+
+#include <llfs/config.hpp>
+
+#ifndef LLFS_DISABLE_IO_URING
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/constants.hpp>
+
+#include <batteries/async/simple_executor.hpp>
+#include <batteries/async/task.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. Random reads and writes of any offset, size and memory alignment through a
+//     BounceBufferRawBlockFile (using read_all/write_all) match a simple byte-array model, for
+//     several bounce buffer sizes and with/without short transfers from the base file; the base
+//     file only ever sees aligned I/O.
+//  2. Fully aligned transfers are passed straight through (same memory, no bounce buffer); when
+//     only the head of a transfer is unaligned, just the head block is bounced.
+
+using namespace llfs::int_types;
+using namespace llfs::constants;
+
+// An in-memory RawBlockFile that, like an O_DIRECT file, rejects unaligned I/O.
+//
+class AlignedMemoryFile : public llfs::RawBlockFile
+{
+ public:
+  llfs::StatusOr<i64> write_some(i64 offset, const llfs::ConstBuffer& data) override
+  {
+    if (!llfs::RawBlockFile::validate_buffer(data, offset).ok()) {
+      ADD_FAILURE() << "unaligned write;" << BATT_INSPECT(offset) << BATT_INSPECT(data.size());
+      return {batt::StatusCode::kInvalidArgument};
+    }
+
+    const usize n = std::min(data.size(), this->max_transfer_size);
+    if (this->contents.size() < offset + n) {
+      this->contents.resize(offset + n);
+    }
+    std::memcpy(this->contents.data() + offset, data.data(), n);
+    this->write_addresses.emplace_back(data.data());
+
+    return static_cast<i64>(n);
+  }
+
+  llfs::StatusOr<i64> read_some(i64 offset, const llfs::MutableBuffer& buffer) override
+  {
+    if (!llfs::RawBlockFile::validate_buffer(buffer, offset).ok()) {
+      ADD_FAILURE() << "unaligned read;" << BATT_INSPECT(offset) << BATT_INSPECT(buffer.size());
+      return {batt::StatusCode::kInvalidArgument};
+    }
+
+    if (static_cast<usize>(offset) >= this->contents.size()) {
+      return 0;
+    }
+    const usize n =
+        std::min({buffer.size(), this->contents.size() - offset, this->max_transfer_size});
+    std::memcpy(buffer.data(), this->contents.data() + offset, n);
+
+    return static_cast<i64>(n);
+  }
+
+  llfs::StatusOr<i64> get_size() override
+  {
+    return static_cast<i64>(this->contents.size());
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  std::vector<u8> contents;
+  std::vector<const void*> write_addresses;
+  usize max_transfer_size = 1 * kMiB;
+};
+
+// Runs `body` in a Task, with a pool of `buffer_count` bounce buffers of `buffer_size` bytes.
+//
+void with_bounce_pool(usize buffer_count, usize buffer_size,
+                      const std::function<void(llfs::IoRingBufferPool&)>& body)
+{
+  batt::SimpleExecutionContext ctx;
+
+  batt::Task task{
+      ctx.get_executor(),
+      [&] {
+        llfs::StatusOr<llfs::ScopedIoRing> io =
+            llfs::ScopedIoRing::make_new(llfs::MaxQueueDepth{16}, llfs::ThreadPoolSize{1});
+
+        ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+
+        llfs::StatusOr<std::unique_ptr<llfs::IoRingBufferPool>> pool =
+            llfs::IoRingBufferPool::make_new(io->get_io_ring(), llfs::BufferCount{buffer_count},
+                                             llfs::BufferSize{buffer_size});
+
+        ASSERT_TRUE(pool.ok()) << BATT_INSPECT(pool.status());
+
+        body(**pool);
+      },
+      "BounceBufferRawBlockFileTest",
+  };
+
+  ctx.run();
+
+  task.join();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(BounceBufferRawBlockFileTest, RandomUnalignedTransfers)
+{
+  for (usize buffer_size : {512, 1024, 4096}) {
+    for (usize max_transfer_size : {usize{512}, usize{1 * kMiB}}) {
+      with_bounce_pool(/*buffer_count=*/2, buffer_size, [&](llfs::IoRingBufferPool& pool) {
+        auto base_file = std::make_unique<AlignedMemoryFile>();
+        base_file->max_transfer_size = max_transfer_size;
+
+        llfs::BounceBufferRawBlockFile file{std::move(base_file), pool};
+
+        EXPECT_FALSE(file.requires_aligned_io());
+
+        std::vector<u8> expected;
+        std::default_random_engine rng{buffer_size + max_transfer_size};
+
+        alignas(512) static u8 memory[16 * kKiB];
+
+        for (usize i = 0; i < 2000; ++i) {
+          const i64 offset = rng() % (8 * kKiB);
+          const usize size = rng() % (6 * kKiB);
+          const usize memory_offset = (rng() % 2) ? 0 : (rng() % 512);
+
+          if (rng() % 2) {
+            for (usize j = 0; j < size; ++j) {
+              memory[memory_offset + j] = rng();
+            }
+            llfs::Status status =
+                llfs::write_all(file, offset, llfs::ConstBuffer{memory + memory_offset, size});
+            ASSERT_TRUE(status.ok()) << BATT_INSPECT(status);
+
+            if (expected.size() < offset + size) {
+              expected.resize(offset + size);
+            }
+            std::memcpy(expected.data() + offset, memory + memory_offset, size);
+
+          } else if (offset + size <= expected.size()) {
+            llfs::Status status =
+                llfs::read_all(file, offset, llfs::MutableBuffer{memory + memory_offset, size});
+            ASSERT_TRUE(status.ok()) << BATT_INSPECT(status);
+
+            ASSERT_EQ(std::memcmp(memory + memory_offset, expected.data() + offset, size), 0)
+                << BATT_INSPECT(offset) << BATT_INSPECT(size) << BATT_INSPECT(memory_offset);
+          }
+        }
+
+        EXPECT_EQ(pool.in_use(), 0u);
+      });
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(BounceBufferRawBlockFileTest, AlignedTransfersPassThrough)
+{
+  with_bounce_pool(/*buffer_count=*/1, /*buffer_size=*/4 * kKiB, [](llfs::IoRingBufferPool& pool) {
+    auto base_file = std::make_unique<AlignedMemoryFile>();
+    AlignedMemoryFile* const base = base_file.get();
+
+    llfs::BounceBufferRawBlockFile file{std::move(base_file), pool};
+
+    alignas(512) static u8 memory[8 * kKiB];
+    std::memset(memory, 0x5a, sizeof(memory));
+
+    // Fully aligned: the base file writes straight from the caller's memory.
+    //
+    ASSERT_TRUE(llfs::write_all(file, 0, llfs::ConstBuffer{memory, 4 * kKiB}).ok());
+    ASSERT_EQ(base->write_addresses.size(), 1u);
+    EXPECT_EQ(base->write_addresses[0], memory);
+
+    // Only the head is unaligned (the memory is aligned from the next block boundary on): the
+    // first call bounces just the head block...
+    //
+    llfs::StatusOr<i64> n_written = file.write_some(100, llfs::ConstBuffer{memory + 100, 1948});
+    ASSERT_TRUE(n_written.ok()) << BATT_INSPECT(n_written.status());
+    EXPECT_EQ(*n_written, 512 - 100);
+    ASSERT_EQ(base->write_addresses.size(), 2u);
+    EXPECT_NE(base->write_addresses[1], memory);
+
+    // ...and the rest is aligned, so it passes through.
+    //
+    n_written = file.write_some(512, llfs::ConstBuffer{memory + 512, 1536});
+    ASSERT_TRUE(n_written.ok()) << BATT_INSPECT(n_written.status());
+    EXPECT_EQ(*n_written, 1536);
+    ASSERT_EQ(base->write_addresses.size(), 3u);
+    EXPECT_EQ(base->write_addresses[2], memory + 512);
+
+    // An unaligned tail is read-modify-written: the bytes after it are preserved.
+    //
+    const u8 tail[3] = {1, 2, 3};
+    ASSERT_TRUE(llfs::write_all(file, 1000, llfs::ConstBuffer{tail, sizeof(tail)}).ok());
+
+    u8 check[8];
+    ASSERT_TRUE(llfs::read_all(file, 999, llfs::MutableBuffer{check, sizeof(check)}).ok());
+    EXPECT_THAT(check, ::testing::ElementsAre(0x5a, 1, 2, 3, 0x5a, 0x5a, 0x5a, 0x5a));
+  });
+}
+
+}  // namespace
+
+#endif  // LLFS_DISABLE_IO_URING
@@ -30,6 +30,11 @@ namespace llfs {
 class RawVolumeLogDataParser
 {
  public:
+  /** \brief The maximum number of slots whose boundaries are found before they are decoded (see
+   * SlotReader::run_batches).
+   */
+  static constexpr usize kMaxSlotsPerBatch = 256;
+
   RawVolumeLogDataParser() = default;
 
   /** \brief For parsing raw log data, like that returned by Volume::get_root_log_data.
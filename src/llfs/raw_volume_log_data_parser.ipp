@@ -56,10 +56,23 @@ inline StatusOr<slot_offset_type> RawVolumeLogDataParser::parse_chunk(
   //
   BufferedLogDataReader log_data_reader{slot_range.lower_bound, buffer};
 
-  // Read slot data!
+  // Read slot data!  Slots are read in batches: first the slot boundaries of up to
+  // `kMaxSlotsPerBatch` slots are found by walking the slot headers in the buffer, then the slots
+  // are decoded and passed to the demuxer, in order.  Since `buffer` already holds the whole chunk,
+  // this avoids the per-slot bookkeeping of SlotReader::run.
   //
-  TypedSlotReader<VolumeEventVariant> slot_reader{log_data_reader};
-  BATT_REQUIRE_OK(slot_reader.run(batt::WaitForResource::kFalse, demuxer));
+  using SlotReaderT = TypedSlotReader<VolumeEventVariant>;
+
+  const auto visit_batch = [&demuxer](const Slice<const SlotParse>& batch) -> Status {
+    for (const SlotParse& slot : batch) {
+      BATT_REQUIRE_OK(SlotReaderT::visit_slot(slot, slot.body, demuxer));
+    }
+    return OkStatus();
+  };
+
+  SlotReaderT slot_reader{log_data_reader};
+  BATT_REQUIRE_OK(
+      slot_reader.run_batches(batt::WaitForResource::kFalse, kMaxSlotsPerBatch, visit_batch));
 
   // Ask the demuxer how far we got; this should usually be updated, but just in case it wasn't, we
   // return the current `user_slot_upper_bound_`.
@@ -15,8 +15,12 @@
 #include <batteries/env.hpp>
 #include <batteries/syscall_retry.hpp>
 
+#include <fcntl.h>
 #include <sys/mman.h>
 
+#include <cstdint>
+#include <cstring>
+
 namespace llfs {
 
 static_assert(sizeof(char) == 1);
@@ -57,15 +61,23 @@ auto RingBuffer::ImplPool::allocate(const Params& params) noexcept -> Impl
       // Create a new temporary file and map it into our address space.
       //
       [this](const TempFile& p) -> Impl {
-        usize page_aligned_size = round_up_to_page_size_multiple(p.byte_size);
+        usize huge_page_size = p.huge_pages ? system_huge_page_size() : 0;
+        LLFS_LOG_WARNING_IF(p.huge_pages && huge_page_size == 0)
+            << "RingBuffer: huge pages are not supported on this system; using normal pages";
+
+        usize page_aligned_size = (huge_page_size != 0)
+                                      ? round_up_to_huge_page_size_multiple(p.byte_size)
+                                      : round_up_to_page_size_multiple(p.byte_size);
         const u16 index = RingBuffer::pool_index_from_buffer_size(page_aligned_size);
 
         // ---- begin pool lock
         if (RingBuffer::pool_enabled()) {
           std::unique_lock<std::mutex> lock{this->mutex_};
 
-          BATT_CHECK_LT(index, this->pool_.size());
-          ImplNodeList& subpool = this->pool_[index];
+          auto& pool = (huge_page_size != 0) ? this->huge_page_pool_ : this->pool_;
+
+          BATT_CHECK_LT(index, pool.size());
+          ImplNodeList& subpool = pool[index];
           if (!subpool.empty()) {
             BATT_CHECK_NE(subpool.size(), 0u);
 
@@ -82,6 +94,7 @@ auto RingBuffer::ImplPool::allocate(const Params& params) noexcept -> Impl
             std::memset(impl.memory_, 0, sizeof(ImplNode));
 
             impl.resize(p.byte_size);
+            impl.set_locked(p.mlock);
 
             return impl;
           }
@@ -95,7 +108,29 @@ auto RingBuffer::ImplPool::allocate(const Params& params) noexcept -> Impl
 
         FILE* const fp = nullptr;
 
-        const int fd = memfd_create(Impl::memfd_name_from_id(id).c_str(), MFD_CLOEXEC);
+        int fd = -1;
+        if (huge_page_size != 0) {
+          fd = memfd_create(Impl::memfd_name_from_id(id).c_str(), MFD_CLOEXEC | MFD_HUGETLB);
+
+          // Allocate the huge pages up front; otherwise running out of them would only be detected
+          // when the file is mapped (or worse, when the pages are first touched).
+          //
+          const usize capacity = RingBuffer::buffer_size_from_pool_index(index);
+          if (fd != -1 && ::fallocate(fd, /*mode=*/0, /*offset=*/0, capacity) != 0) {
+            const int saved_errno = errno;
+            ::close(fd);
+            fd = -1;
+            errno = saved_errno;
+          }
+          if (fd == -1) {
+            LLFS_LOG_WARNING() << "RingBuffer: failed to allocate huge pages; using normal pages"
+                               << BATT_INSPECT(errno) << BATT_INSPECT(std::strerror(errno));
+            huge_page_size = 0;
+          }
+        }
+        if (fd == -1) {
+          fd = memfd_create(Impl::memfd_name_from_id(id).c_str(), MFD_CLOEXEC);
+        }
 
         return Impl{FileDescriptor{
                         .fd = fd,
@@ -104,9 +139,10 @@ auto RingBuffer::ImplPool::allocate(const Params& params) noexcept -> Impl
                         .byte_offset = 0,
                         .truncate = true,
                         .close = true,
+                        .mlock = p.mlock,
                         .cache_on_deallocate = true,
                     },
-                    /*id=*/id};
+                    /*id=*/id, huge_page_size};
       },
 
       //----- --- -- -  -  -   -
@@ -127,6 +163,7 @@ auto RingBuffer::ImplPool::allocate(const Params& params) noexcept -> Impl
                         .byte_offset = p.byte_offset,
                         .truncate = p.truncate,
                         .close = true,
+                        .mlock = p.mlock,
                         .cache_on_deallocate = false,
                     },
                     /*id=*/-1};
@@ -156,8 +193,11 @@ auto RingBuffer::ImplPool::deallocate(Impl&& impl) noexcept -> void
   const u16 index = RingBuffer::pool_index_from_buffer_size(node->impl.capacity_);
   {
     std::unique_lock<std::mutex> lock{this->mutex_};
-    BATT_CHECK_LT(index, this->pool_.size());
-    this->pool_[index].push_front(*node);
+
+    auto& pool = (node->impl.huge_page_size_ != 0) ? this->huge_page_pool_ : this->pool_;
+
+    BATT_CHECK_LT(index, pool.size());
+    pool[index].push_front(*node);
   }
 }
 
@@ -166,12 +206,14 @@ auto RingBuffer::ImplPool::deallocate(Impl&& impl) noexcept -> void
 void RingBuffer::ImplPool::reset() noexcept
 {
   std::unique_lock<std::mutex> lock{this->mutex_};
-  for (auto& subpool : this->pool_) {
-    while (!subpool.empty()) {
-      ImplNode& node = subpool.front();
-      subpool.pop_front();
-      Impl impl = std::move(node.impl);
-      node.~ImplNode();
+  for (auto* pool : {&this->pool_, &this->huge_page_pool_}) {
+    for (auto& subpool : *pool) {
+      while (!subpool.empty()) {
+        ImplNode& node = subpool.front();
+        subpool.pop_front();
+        Impl impl = std::move(node.impl);
+        node.~ImplNode();
+      }
     }
   }
 }
@@ -185,8 +227,10 @@ void RingBuffer::ImplPool::reset() noexcept
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-/*explicit*/ RingBuffer::Impl::Impl(const FileDescriptor& desc, i64 id) noexcept
-    : size_{round_up_to_page_size_multiple(desc.byte_size)}
+/*explicit*/ RingBuffer::Impl::Impl(const FileDescriptor& desc, i64 id,
+                                    usize huge_page_size) noexcept
+    : size_{(huge_page_size != 0) ? round_up_to_huge_page_size_multiple(desc.byte_size)
+                                  : round_up_to_page_size_multiple(desc.byte_size)}
     , capacity_{RingBuffer::buffer_size_from_pool_index(
           RingBuffer::pool_index_from_buffer_size(this->size_))}
     , fd_{desc.fd}
@@ -195,6 +239,8 @@ void RingBuffer::ImplPool::reset() noexcept
     , offset_within_file_{desc.byte_offset}
     , close_fd_{desc.close}
     , cache_on_deallocate_{desc.cache_on_deallocate}
+    , huge_page_size_{huge_page_size}
+    , locked_{desc.mlock}
 {
   // Do this checked cast once so we can do a static_cast from here on.
   //
@@ -214,8 +260,37 @@ void RingBuffer::ImplPool::reset() noexcept
 
   // Map a region of size_*2 into the virtual memory table.
   //
-  this->memory_ = reinterpret_cast<char*>(
-      mmap(NULL, this->capacity_ * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  if (this->huge_page_size_ == 0) {
+    this->memory_ = reinterpret_cast<char*>(
+        mmap(NULL, this->capacity_ * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  } else {
+    // Huge page mappings must be aligned to the huge page size, which mmap does not guarantee for
+    // the reserved region; so over-reserve by one huge page and trim the unaligned head and tail.
+    //
+    BATT_CHECK_EQ(this->capacity_ % this->huge_page_size_, 0u);
+
+    const usize reserved_size = this->capacity_ * 2 + this->huge_page_size_;
+    void* const reserved =
+        mmap(NULL, reserved_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    BATT_CHECK_NE(reserved, MAP_FAILED);
+
+    char* const reserved_begin = reinterpret_cast<char*>(reserved);
+    char* const reserved_end = reserved_begin + reserved_size;
+
+    const usize misalignment =
+        reinterpret_cast<std::uintptr_t>(reserved_begin) % this->huge_page_size_;
+
+    this->memory_ = reserved_begin + (this->huge_page_size_ - misalignment) % this->huge_page_size_;
+
+    char* const memory_end = this->memory_ + this->capacity_ * 2;
+
+    if (this->memory_ != reserved_begin) {
+      BATT_CHECK_EQ(munmap(reserved_begin, this->memory_ - reserved_begin), 0);
+    }
+    if (memory_end != reserved_end) {
+      BATT_CHECK_EQ(munmap(memory_end, reserved_end - memory_end), 0);
+    }
+  }
 
   BATT_CHECK_NOT_NULLPTR((void*)this->memory_);
 
@@ -233,6 +308,8 @@ RingBuffer::Impl::Impl(Impl&& other) noexcept
     , close_fd_{other.close_fd_}
     , memory_{other.memory_}
     , cache_on_deallocate_{other.cache_on_deallocate_}
+    , huge_page_size_{other.huge_page_size_}
+    , locked_{other.locked_}
 {
   other.size_ = 0;
   other.capacity_ = 0;
@@ -242,6 +319,8 @@ RingBuffer::Impl::Impl(Impl&& other) noexcept
   other.close_fd_ = false;
   other.memory_ = nullptr;
   other.cache_on_deallocate_ = false;
+  other.huge_page_size_ = 0;
+  other.locked_ = false;
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -291,6 +370,8 @@ auto RingBuffer::Impl::operator=(Impl&& other) noexcept -> Impl&
   std::swap(this->close_fd_, tmp.close_fd_);
   std::swap(this->memory_, tmp.memory_);
   std::swap(this->cache_on_deallocate_, tmp.cache_on_deallocate_);
+  std::swap(this->huge_page_size_, tmp.huge_page_size_);
+  std::swap(this->locked_, tmp.locked_);
 
   return *this;
 }
@@ -302,11 +383,21 @@ std::string RingBuffer::Impl::memfd_name() const noexcept
   return Impl::memfd_name_from_id(this->id_);
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize RingBuffer::Impl::round_up_to_page_multiple(usize count) const noexcept
+{
+  if (this->huge_page_size_ != 0) {
+    return round_up_to_huge_page_size_multiple(count);
+  }
+  return round_up_to_page_size_multiple(count);
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 void RingBuffer::Impl::resize(usize new_size) noexcept
 {
-  new_size = round_up_to_page_size_multiple(new_size);
+  new_size = this->round_up_to_page_multiple(new_size);
 
   BATT_CHECK_LE(new_size, this->capacity_);
 
@@ -337,6 +428,35 @@ void RingBuffer::Impl::update_mapped_regions() noexcept
   LLFS_WARN_IF_NOT_OK(batt::status_from_retval(batt::syscall_retry([&] {
     return madvise(this->memory_, this->capacity_ * 2, MADV_SEQUENTIAL);
   })));
+
+  // Re-mapping drops any existing lock on the replaced pages, so lock the new mappings.
+  //
+  if (this->locked_) {
+    this->locked_ = false;
+    this->set_locked(true);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void RingBuffer::Impl::set_locked(bool lock) noexcept
+{
+  if (lock == this->locked_) {
+    return;
+  }
+
+  // Both mirrors map the same pages, so locking the first is sufficient to keep them resident.
+  //
+  if (lock) {
+    const int retval = ::mlock(this->memory_, this->size_);
+    LLFS_LOG_WARNING_IF(retval != 0) << "RingBuffer: mlock failed; buffer pages may be swapped out"
+                                     << BATT_INSPECT(this->size_) << BATT_INSPECT(errno)
+                                     << BATT_INSPECT(std::strerror(errno));
+    this->locked_ = (retval == 0);
+  } else {
+    LLFS_WARN_IF_NOT_OK(batt::status_from_retval(::munlock(this->memory_, this->size_)));
+    this->locked_ = false;
+  }
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -45,6 +45,17 @@ class RingBuffer
  public:
   struct TempFile {
     u64 byte_size;
+
+    // If true, back the buffer with huge pages (memfd_create with MFD_HUGETLB); the size is rounded
+    // up to a multiple of `system_huge_page_size()`.  Falls back to normal pages (with a warning)
+    // if no huge pages can be allocated.
+    //
+    bool huge_pages = false;
+
+    // If true, lock the buffer pages into memory (mlock) so they are never paged out.  Failure to
+    // lock (e.g., because of RLIMIT_MEMLOCK) is logged as a warning but is not fatal.
+    //
+    bool mlock = false;
   };
 
   struct NamedFile {
@@ -53,6 +64,7 @@ class RingBuffer
     i64 byte_offset = 0;
     bool create = true;
     bool truncate = true;
+    bool mlock = false;
   };
 
   struct FileDescriptor {
@@ -62,6 +74,7 @@ class RingBuffer
     i64 byte_offset = 0;
     bool truncate = true;
     bool close = false;
+    bool mlock = false;
 
     // If true, RingBuffer::Impl objects created from this struct will be saved to a global pool for
     // reuse, instead of being destroyed (un-mapping the memory regions and closing the fd).
@@ -93,17 +106,19 @@ class RingBuffer
   //
   // `params` can be one of the following types:
   //
-  // TempFile{.byte_size}
+  // TempFile{.byte_size, .huge_pages, .mlock}
   //   Create a new temp file with a unique name and the given size; the temp file is
-  //   automatically deleted when this RingBuffer is destroyed (closing the file descriptor).
+  //   automatically deleted when this RingBuffer is destroyed (closing the file descriptor).  If
+  //   `huge_pages` is true, the file is allocated from the huge page pool.  If `mlock` is true, the
+  //   buffer is locked into memory.
   //
-  // NamedFile{.file_name, .byte_size, .byte_offset, .create, .truncate}
+  // NamedFile{.file_name, .byte_size, .byte_offset, .create, .truncate, .mlock}
   //   Create or open the backing file at the given file name (path) and map the RingBuffer to the
   //   given byte offset/size within that file.  If `create` is true, then the create flag is set
   //   while opening the file.  If `truncate` is true, then the file is truncated at `size +
   //   offset`.
   //
-  // FileDescriptor{.fd, .byte_size, .byte_offset, .truncate, .close}
+  // FileDescriptor{.fd, .byte_size, .byte_offset, .truncate, .close, .mlock}
   //   Map the given region of the file for which `fd` is an open descriptor.
   //
   explicit RingBuffer(const Params& params) noexcept;
@@ -202,6 +217,15 @@ class RingBuffer
      */
     bool cache_on_deallocate_ = false;
 
+    /** \brief If non-zero, the buffer is backed by huge pages of this size; `this->size_`,
+     * `this->capacity_`, and `this->memory_` are all aligned to it.
+     */
+    usize huge_page_size_ = 0;
+
+    /** \brief Whether the mapped regions should be (and currently are) locked into memory.
+     */
+    bool locked_ = false;
+
     //+++++++++++-+-+--+----- --- -- -  -  -   -
 
     static std::string memfd_name_from_id(i64 id) noexcept;
@@ -222,9 +246,10 @@ class RingBuffer
      */
     Impl() = default;
 
-    /** \brief Creates a double-mapped ring buffer from the file described in `params`.
+    /** \brief Creates a double-mapped ring buffer from the file described in `params`.  If
+     * `huge_page_size` is non-zero, the file must be backed by huge pages of that size.
      */
-    explicit Impl(const FileDescriptor& params, i64 id) noexcept;
+    explicit Impl(const FileDescriptor& params, i64 id, usize huge_page_size = 0) noexcept;
 
     /** \brief Moves other to a new Impl instance.  This will invalidate `other`.
      */
@@ -247,9 +272,15 @@ class RingBuffer
 
     std::string memfd_name() const noexcept;
 
+    usize round_up_to_page_multiple(usize count) const noexcept;
+
     void resize(usize new_size) noexcept;
 
     void update_mapped_regions() noexcept;
+
+    /** \brief Locks or unlocks the mapped regions, according to `lock`.
+     */
+    void set_locked(bool lock) noexcept;
   };
 
   //----- --- -- -  -  -   -
@@ -296,7 +327,8 @@ class RingBuffer
 
     /** \brief Returns a freshly initialized Impl, if possible reusing resources from the pool.
      *
-     * Only `params` with type TempFile will attempt to reuse a buffer from the pool.
+     * Only `params` with type TempFile will attempt to reuse a buffer from the pool.  Huge page
+     * buffers are pooled separately from normal buffers.
      */
     auto allocate(const Params& params) noexcept -> Impl;
 
@@ -311,6 +343,7 @@ class RingBuffer
    private:
     std::mutex mutex_;
     std::array<ImplNodeList, kNumSubpools> pool_;
+    std::array<ImplNodeList, kNumSubpools> huge_page_pool_;
   };
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -143,4 +143,55 @@ TEST(RingBufferTest, PoolIndex)
   }
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(RingBufferTest, HugePagesAndMlock)
+{
+  const bool previously_enabled = RingBuffer::pool_enabled().exchange(true);
+  auto on_scope_exit = batt::finally([&] {
+    RingBuffer::pool_enabled().store(previously_enabled);
+  });
+
+  RingBuffer::reset_pool();
+
+  const char kTestData[] = "Four score and seven years ago...";
+
+  // Whether or not huge pages are actually available here, the buffer must be correctly sized and
+  // mirrored.
+  //
+  for (bool huge_pages : {false, true}) {
+    for (bool mlock : {false, true}) {
+      RingBuffer rb{RingBuffer::TempFile{
+          .byte_size = 4096,
+          .huge_pages = huge_pages,
+          .mlock = mlock,
+      }};
+
+      ASSERT_GE(rb.size(), 4096ul);
+      EXPECT_EQ(rb.size() % llfs::system_page_size(), 0u);
+
+      char* p = (char*)rb.get_mut(0).data();
+      std::memcpy(&p[rb.size() - 10], kTestData, std::strlen(kTestData));
+
+      EXPECT_EQ(0,
+                std::memcmp(rb.get(rb.size() * 3 - 10).data(), kTestData, std::strlen(kTestData)));
+      EXPECT_EQ(0, std::memcmp(rb.get(0).data(), &kTestData[10], std::strlen(kTestData) - 10));
+    }
+  }
+
+  // Locked buffers are pooled and re-used like any other.
+  //
+  void* ptr = nullptr;
+  {
+    RingBuffer rb{RingBuffer::TempFile{.byte_size = 8192, .mlock = true}};
+    ptr = rb.get_mut(0).data();
+  }
+  {
+    RingBuffer rb{RingBuffer::TempFile{.byte_size = 8192, .mlock = true}};
+    EXPECT_EQ(ptr, rb.get_mut(0).data());
+  }
+
+  RingBuffer::reset_pool();
+}
+
 }  // namespace
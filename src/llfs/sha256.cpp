@@ -9,8 +9,321 @@
 #include <llfs/sha256.hpp>
 //
 
+#include <batteries/assert.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define LLFS_SHA256_X86 1
+#endif
+
 namespace llfs {
 
+namespace {
+
+#if LLFS_SHA256_X86
+
+// The number of messages hashed at once by sha256_x8_avx2 (one per 32-bit lane).
+//
+constexpr usize kSha256Lanes = 8;
+
+constexpr usize kSha256BlockSize = 64;
+
+alignas(32) constexpr u32 kSha256RoundConstants[64] = {
+    0x428a2f98u, 0x71374491u, 0xb5c0fbcfu, 0xe9b5dba5u, 0x3956c25bu, 0x59f111f1u, 0x923f82a4u,
+    0xab1c5ed5u, 0xd807aa98u, 0x12835b01u, 0x243185beu, 0x550c7dc3u, 0x72be5d74u, 0x80deb1feu,
+    0x9bdc06a7u, 0xc19bf174u, 0xe49b69c1u, 0xefbe4786u, 0x0fc19dc6u, 0x240ca1ccu, 0x2de92c6fu,
+    0x4a7484aau, 0x5cb0a9dcu, 0x76f988dau, 0x983e5152u, 0xa831c66du, 0xb00327c8u, 0xbf597fc7u,
+    0xc6e00bf3u, 0xd5a79147u, 0x06ca6351u, 0x14292967u, 0x27b70a85u, 0x2e1b2138u, 0x4d2c6dfcu,
+    0x53380d13u, 0x650a7354u, 0x766a0abbu, 0x81c2c92eu, 0x92722c85u, 0xa2bfe8a1u, 0xa81a664bu,
+    0xc24b8b70u, 0xc76c51a3u, 0xd192e819u, 0xd6990624u, 0xf40e3585u, 0x106aa070u, 0x19a4c116u,
+    0x1e376c08u, 0x2748774cu, 0x34b0bcb5u, 0x391c0cb3u, 0x4ed8aa4au, 0x5b9cca4fu, 0x682e6ff3u,
+    0x748f82eeu, 0x78a5636fu, 0x84c87814u, 0x8cc70208u, 0x90befffau, 0xa4506cebu, 0xbef9a3f7u,
+    0xc67178f2u,
+};
+
+constexpr u32 kSha256InitialState[8] = {
+    0x6a09e667u, 0xbb67ae85u, 0x3c6ef372u, 0xa54ff53au,
+    0x510e527fu, 0x9b05688cu, 0x1f83d9abu, 0x5be0cd19u,
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+inline u32 load_be32(const u8* p) noexcept
+{
+  u32 value;
+  std::memcpy(&value, p, sizeof(value));
+  return __builtin_bswap32(value);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+__attribute__((target("avx2"))) inline __m256i rotr_x8(__m256i x, int n) noexcept
+{
+  return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Runs the SHA-256 compression function on one 64-byte block per lane (`blocks[lane]`), updating
+// `state` (word i of every lane in `state[i]`).
+//
+__attribute__((target("avx2"))) void sha256_compress_x8(
+    __m256i state[8], const u8* const blocks[kSha256Lanes]) noexcept
+{
+  __m256i w[16];
+  for (usize t = 0; t < 16; ++t) {
+    w[t] = _mm256_set_epi32(load_be32(blocks[7] + 4 * t), load_be32(blocks[6] + 4 * t),
+                            load_be32(blocks[5] + 4 * t), load_be32(blocks[4] + 4 * t),
+                            load_be32(blocks[3] + 4 * t), load_be32(blocks[2] + 4 * t),
+                            load_be32(blocks[1] + 4 * t), load_be32(blocks[0] + 4 * t));
+  }
+
+  __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+  __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+
+  for (usize t = 0; t < 64; ++t) {
+    // The message schedule is kept in a ring of the last 16 words.
+    //
+    if (t >= 16) {
+      const __m256i w15 = w[(t - 15) & 15];
+      const __m256i w2 = w[(t - 2) & 15];
+      const __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr_x8(w15, 7), rotr_x8(w15, 18)),
+                                          _mm256_srli_epi32(w15, 3));
+      const __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr_x8(w2, 17), rotr_x8(w2, 19)),
+                                          _mm256_srli_epi32(w2, 10));
+      w[t & 15] = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0),
+                                   _mm256_add_epi32(w[(t - 7) & 15], s1));
+    }
+
+    const __m256i sigma1 =
+        _mm256_xor_si256(_mm256_xor_si256(rotr_x8(e, 6), rotr_x8(e, 11)), rotr_x8(e, 25));
+    const __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+    const __m256i t1 = _mm256_add_epi32(
+        _mm256_add_epi32(_mm256_add_epi32(h, sigma1), ch),
+        _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(kSha256RoundConstants[t])), w[t & 15]));
+
+    const __m256i sigma0 =
+        _mm256_xor_si256(_mm256_xor_si256(rotr_x8(a, 2), rotr_x8(a, 13)), rotr_x8(a, 22));
+    const __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b),
+                                        _mm256_and_si256(c, _mm256_or_si256(a, b)));
+    const __m256i t2 = _mm256_add_epi32(sigma0, maj);
+
+    h = g;
+    g = f;
+    f = e;
+    e = _mm256_add_epi32(d, t1);
+    d = c;
+    c = b;
+    b = a;
+    a = _mm256_add_epi32(t1, t2);
+  }
+
+  state[0] = _mm256_add_epi32(state[0], a);
+  state[1] = _mm256_add_epi32(state[1], b);
+  state[2] = _mm256_add_epi32(state[2], c);
+  state[3] = _mm256_add_epi32(state[3], d);
+  state[4] = _mm256_add_epi32(state[4], e);
+  state[5] = _mm256_add_epi32(state[5], f);
+  state[6] = _mm256_add_epi32(state[6], g);
+  state[7] = _mm256_add_epi32(state[7], h);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Computes the SHA-256 of the `size` bytes at each of `data[0..8)`, storing the results in
+// `out[0..8)`.
+//
+__attribute__((target("avx2"))) void sha256_x8_avx2(const u8* const data[kSha256Lanes], usize size,
+                                                     Sha256* const out[kSha256Lanes]) noexcept
+{
+  __m256i state[8];
+  for (usize i = 0; i < 8; ++i) {
+    state[i] = _mm256_set1_epi32(static_cast<int>(kSha256InitialState[i]));
+  }
+
+  const u8* blocks[kSha256Lanes];
+
+  const usize full_block_count = size / kSha256BlockSize;
+  for (usize block_i = 0; block_i < full_block_count; ++block_i) {
+    for (usize lane = 0; lane < kSha256Lanes; ++lane) {
+      blocks[lane] = data[lane] + block_i * kSha256BlockSize;
+    }
+    sha256_compress_x8(state, blocks);
+  }
+
+  // All lanes have the same length, so they all have the same padding: the rest of the data, a
+  // 0x80 byte, zeros, and the big-endian bit length, in one or two blocks.
+  //
+  const usize tail_size = size % kSha256BlockSize;
+  const usize tail_block_count = (tail_size + 1 + 8 > kSha256BlockSize) ? 2 : 1;
+  const u64 bit_length = __builtin_bswap64(u64{size} * 8);
+
+  alignas(32) u8 tail[kSha256Lanes][2 * kSha256BlockSize];
+  for (usize lane = 0; lane < kSha256Lanes; ++lane) {
+    u8* const lane_tail = tail[lane];
+    std::memset(lane_tail, 0, sizeof(tail[lane]));
+    if (tail_size != 0) {
+      std::memcpy(lane_tail, data[lane] + full_block_count * kSha256BlockSize, tail_size);
+    }
+    lane_tail[tail_size] = 0x80;
+    std::memcpy(lane_tail + tail_block_count * kSha256BlockSize - 8, &bit_length, 8);
+  }
+  for (usize block_i = 0; block_i < tail_block_count; ++block_i) {
+    for (usize lane = 0; lane < kSha256Lanes; ++lane) {
+      blocks[lane] = tail[lane] + block_i * kSha256BlockSize;
+    }
+    sha256_compress_x8(state, blocks);
+  }
+
+  alignas(32) u32 words[8][kSha256Lanes];
+  for (usize i = 0; i < 8; ++i) {
+    _mm256_store_si256(reinterpret_cast<__m256i*>(words[i]), state[i]);
+  }
+  for (usize lane = 0; lane < kSha256Lanes; ++lane) {
+    for (usize i = 0; i < 8; ++i) {
+      const u32 be_word = __builtin_bswap32(words[i][lane]);
+      std::memcpy(out[lane]->bytes.data() + 4 * i, &be_word, 4);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool detect_sha256_multi_buffer() noexcept
+{
+  return __builtin_cpu_supports("avx2");
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool detect_sha256_extensions() noexcept
+{
+  return __builtin_cpu_supports("sha");
+}
+
+#else  // LLFS_SHA256_X86
+
+bool detect_sha256_multi_buffer() noexcept
+{
+  return false;
+}
+
+// On aarch64, OpenSSL uses the ARMv8 SHA2 instructions when the CPU has them; there is no
+// multi-buffer fallback here, so the answer doesn't change anything.
+//
+bool detect_sha256_extensions() noexcept
+{
+  return true;
+}
+
+#endif  // LLFS_SHA256_X86
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void compute_sha256_each(const batt::Slice<const batt::ConstBuffer>& inputs, Sha256* out) noexcept
+{
+  for (const batt::ConstBuffer& input : inputs) {
+    *out = compute_sha256(input);
+    ++out;
+  }
+}
+
+// The minimum number of equal-sized inputs for which the multi-buffer kernel is used; smaller
+// groups are padded out to kSha256Lanes by hashing one of the inputs several times.
+//
+constexpr usize kSha256MinMultiBufferGroup = 4;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void compute_sha256_multi_buffer_impl(const batt::Slice<const batt::ConstBuffer>& inputs,
+                                      Sha256* out, usize min_group_size) noexcept
+{
+#if LLFS_SHA256_X86
+  // Group the inputs by size (lanes of the kernel must all have the same size).
+  //
+  std::vector<usize> order(inputs.size());
+  std::iota(order.begin(), order.end(), usize{0});
+  std::stable_sort(order.begin(), order.end(), [&inputs](usize l, usize r) {
+    return inputs[l].size() < inputs[r].size();
+  });
+
+  const u8* data[kSha256Lanes];
+  Sha256* results[kSha256Lanes];
+  std::array<Sha256, kSha256Lanes> unused_results;
+
+  usize group_begin = 0;
+  while (group_begin < order.size()) {
+    const usize size = inputs[order[group_begin]].size();
+    usize group_end = group_begin + 1;
+    while (group_end < order.size() && group_end - group_begin < kSha256Lanes &&
+           inputs[order[group_end]].size() == size) {
+      ++group_end;
+    }
+
+    const usize group_size = group_end - group_begin;
+    if (group_size < min_group_size) {
+      for (usize i = group_begin; i < group_end; ++i) {
+        out[order[i]] = compute_sha256(inputs[order[i]]);
+      }
+    } else {
+      for (usize lane = 0; lane < kSha256Lanes; ++lane) {
+        if (lane < group_size) {
+          const usize input_i = order[group_begin + lane];
+          data[lane] = static_cast<const u8*>(inputs[input_i].data());
+          results[lane] = &out[input_i];
+        } else {
+          data[lane] = data[0];
+          results[lane] = &unused_results[lane];
+        }
+      }
+      sha256_x8_avx2(data, size, results);
+    }
+
+    group_begin = group_end;
+  }
+#else
+  (void)min_group_size;
+  compute_sha256_each(inputs, out);
+#endif
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void compute_sha256_batch(const batt::Slice<const batt::ConstBuffer>& inputs, Sha256* out) noexcept
+{
+  static const bool use_multi_buffer = !detect_sha256_extensions() && detect_sha256_multi_buffer();
+
+  if (use_multi_buffer && inputs.size() >= kSha256MinMultiBufferGroup) {
+    compute_sha256_multi_buffer_impl(inputs, out, kSha256MinMultiBufferGroup);
+  } else {
+    compute_sha256_each(inputs, out);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void compute_sha256_batch_multi_buffer(const batt::Slice<const batt::ConstBuffer>& inputs,
+                                       Sha256* out) noexcept
+{
+  BATT_CHECK(sha256_multi_buffer_is_available());
+
+  compute_sha256_multi_buffer_impl(inputs, out, /*min_group_size=*/1);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool sha256_multi_buffer_is_available() noexcept
+{
+  static const bool available = detect_sha256_multi_buffer();
+  return available;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 /*static*/ batt::Optional<Sha256> Sha256::from_str(const std::string_view& s)
@@ -21,6 +21,7 @@
 #include <batteries/seq.hpp>
 #include <batteries/seq/decay.hpp>
 #include <batteries/shared_ptr.hpp>
+#include <batteries/slice.hpp>
 #include <batteries/static_assert.hpp>
 #include <batteries/suppress.hpp>
 #include <batteries/type_traits.hpp>
@@ -161,6 +162,27 @@ inline Sha256 compute_sha256(const batt::ConstBuffer& single_buffer)
 
 BATT_UNSUPPRESS_IF_GCC()
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/** \brief Computes the SHA-256 hash of each of `inputs`, storing the results in
+ * `out[0..inputs.size())`.
+ *
+ * OpenSSL already uses the SHA extensions (x86-64 SHA-NI, ARMv8 SHA2) when the CPU has them; on
+ * x86-64 CPUs that have AVX2 but not SHA-NI, groups of (at least 4) equal-sized inputs, e.g.
+ * pages, are instead hashed eight at a time, one per 32-bit lane of a vector register.
+ */
+void compute_sha256_batch(const batt::Slice<const batt::ConstBuffer>& inputs, Sha256* out) noexcept;
+
+/** \brief Like compute_sha256_batch, but always uses the multi-buffer (AVX2) implementation; must
+ * only be called if `sha256_multi_buffer_is_available()`.
+ */
+void compute_sha256_batch_multi_buffer(const batt::Slice<const batt::ConstBuffer>& inputs,
+                                       Sha256* out) noexcept;
+
+/** \brief Returns true if this machine can run the multi-buffer SHA-256 implementation.
+ */
+bool sha256_multi_buffer_is_available() noexcept;
+
 }  // namespace llfs
 
 #endif  // LLFS_SHA256_HPP
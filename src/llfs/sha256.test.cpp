@@ -15,10 +15,14 @@
 
 #include <boost/functional/hash.hpp>
 
+#include <random>
 #include <unordered_set>
+#include <vector>
 
 namespace {
 
+using namespace llfs::int_types;
+
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 //
 /** \brief Test fixture for Sha256 tests.
@@ -174,4 +178,44 @@ TEST_F(Sha256Test, AsKey)
   EXPECT_EQ((const void*)key.data(), (const void*)(&this->sha_a1));
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(Sha256Test, Batch)
+{
+  std::default_random_engine rng{1};
+
+  // Sizes around the padding boundaries (55/56 bytes in the last block), and whole pages.
+  //
+  for (usize size : {0, 1, 55, 56, 63, 64, 65, 119, 120, 128, 1000, 4096}) {
+    for (usize count : {0, 1, 3, 4, 8, 9, 20}) {
+      // Mostly equal-sized inputs, with a few one byte longer so that the groups are uneven.
+      //
+      std::vector<std::vector<u8>> data(count);
+      std::vector<batt::ConstBuffer> inputs;
+      for (usize i = 0; i < count; ++i) {
+        data[i].resize(size + ((i % 5 == 4) ? 1 : 0));
+        for (u8& byte : data[i]) {
+          byte = static_cast<u8>(rng());
+        }
+        inputs.emplace_back(data[i].data(), data[i].size());
+      }
+
+      std::vector<llfs::Sha256> expected;
+      for (const batt::ConstBuffer& input : inputs) {
+        expected.emplace_back(llfs::compute_sha256(input));
+      }
+
+      std::vector<llfs::Sha256> actual(count);
+      llfs::compute_sha256_batch(batt::as_slice(inputs), actual.data());
+      EXPECT_EQ(actual, expected) << BATT_INSPECT(size) << BATT_INSPECT(count);
+
+      if (llfs::sha256_multi_buffer_is_available()) {
+        std::vector<llfs::Sha256> multi_buffer_actual(count);
+        llfs::compute_sha256_batch_multi_buffer(batt::as_slice(inputs), multi_buffer_actual.data());
+        EXPECT_EQ(multi_buffer_actual, expected) << BATT_INSPECT(size) << BATT_INSPECT(count);
+      }
+    }
+  }
+}
+
 }  // namespace
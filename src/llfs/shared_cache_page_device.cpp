@@ -0,0 +1,116 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+
+#include <llfs/shared_cache_page_device.hpp>
+//
+
+#include <batteries/assert.hpp>
+
+#include <algorithm>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ SharedCachePageDevice::SharedCachePageDevice(
+    std::unique_ptr<PageDevice> device, std::shared_ptr<SharedPageBufferCache> cache) noexcept
+    : device_{std::move(device)}
+    , cache_{std::move(cache)}
+{
+  BATT_CHECK_NOT_NULLPTR(this->device_);
+  BATT_CHECK_NOT_NULLPTR(this->cache_);
+  BATT_CHECK_EQ(this->device_->page_size(), this->cache_->page_size());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageIdFactory SharedCachePageDevice::page_ids()
+{
+  return this->device_->page_ids();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageSize SharedCachePageDevice::page_size()
+{
+  return this->device_->page_size();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status SharedCachePageDevice::enable_registered_page_buffers(usize buffer_count)
+{
+  return this->device_->enable_registered_page_buffers(buffer_count);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::shared_ptr<PageBuffer>> SharedCachePageDevice::prepare(PageId page_id)
+{
+  return this->device_->prepare(page_id);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void SharedCachePageDevice::write(std::shared_ptr<const PageBuffer>&& page_buffer,
+                                  WriteHandler&& handler)
+{
+  this->cache_->invalidate(page_buffer->page_id());
+  this->device_->write(std::move(page_buffer), std::move(handler));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void SharedCachePageDevice::read(PageId id, ReadHandler&& handler)
+{
+  if (std::shared_ptr<const PageBuffer> cached = this->cache_->find(id)) {
+    handler(std::move(cached));
+    return;
+  }
+
+  this->device_->read(id, [cache = this->cache_, handler = std::move(handler)](
+                              ReadResult&& result) mutable {
+    if (result.ok()) {
+      // Replace the private copy with the shared one, if there is room for it.
+      //
+      if (std::shared_ptr<const PageBuffer> shared = cache->insert(**result)) {
+        handler(std::move(shared));
+        return;
+      }
+    }
+    handler(std::move(result));
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void SharedCachePageDevice::read_tail(PageId id, usize byte_count, ReadTailHandler&& handler)
+{
+  std::shared_ptr<const PageBuffer> cached = this->cache_->find(id);
+  if (!cached) {
+    this->device_->read_tail(id, byte_count, std::move(handler));
+    return;
+  }
+
+  const ConstBuffer page_data = cached->const_buffer();
+  const usize n = std::min(byte_count, page_data.size());
+  const u8* const tail_begin = static_cast<const u8*>(page_data.data()) + page_data.size() - n;
+
+  handler(std::vector<u8>(tail_begin, tail_begin + n));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void SharedCachePageDevice::drop(PageId id, WriteHandler&& handler)
+{
+  this->cache_->invalidate(id);
+  this->device_->drop(id, std::move(handler));
+}
+
+}  // namespace llfs
@@ -0,0 +1,85 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+
+#pragma once
+#ifndef LLFS_SHARED_CACHE_PAGE_DEVICE_HPP
+#define LLFS_SHARED_CACHE_PAGE_DEVICE_HPP
+
+#include <llfs/int_types.hpp>
+#include <llfs/page_device.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/shared_page_buffer_cache.hpp>
+#include <llfs/status.hpp>
+
+#include <memory>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A PageDevice that serves reads of another device from a SharedPageBufferCache, so that
+ * several processes which open the same (read-mostly) arena share one copy of its hot pages.
+ *
+ * On a read, the page is looked up in the shared cache; on a miss, it is read from the underlying
+ * device and copied into the shared cache, and the shared copy is returned (so the private buffer
+ * is freed right away).  The PageCache of each process then holds PageViews over the shared
+ * memory; only the PageCacheSlot bookkeeping is per-process.  If the page can't be cached (every
+ * slot it could go in is pinned), the private buffer is returned instead.
+ *
+ * Writes and drops go to the underlying device, after removing the page from the shared cache.
+ */
+class SharedCachePageDevice : public PageDevice
+{
+ public:
+  /** \brief `cache` must have the same page size as `device`; it may be shared by several devices
+   * (in this and other processes), as long as their PageIds are unique within it.
+   */
+  explicit SharedCachePageDevice(std::unique_ptr<PageDevice> device,
+                                 std::shared_ptr<SharedPageBufferCache> cache) noexcept;
+
+  //----- --- -- -  -  -   -
+  // PageDevice interface
+
+  PageIdFactory page_ids() override;
+
+  PageSize page_size() override;
+
+  Status enable_registered_page_buffers(usize buffer_count) override;
+
+  StatusOr<std::shared_ptr<PageBuffer>> prepare(PageId page_id) override;
+
+  void write(std::shared_ptr<const PageBuffer>&& page_buffer, WriteHandler&& handler) override;
+
+  void read(PageId id, ReadHandler&& handler) override;
+
+  void read_tail(PageId id, usize byte_count, ReadTailHandler&& handler) override;
+
+  void drop(PageId id, WriteHandler&& handler) override;
+
+  //----- --- -- -  -  -   -
+
+  PageDevice& device() const
+  {
+    return *this->device_;
+  }
+
+  const std::shared_ptr<SharedPageBufferCache>& cache() const
+  {
+    return this->cache_;
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  std::unique_ptr<PageDevice> device_;
+
+  std::shared_ptr<SharedPageBufferCache> cache_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_SHARED_CACHE_PAGE_DEVICE_HPP
@@ -0,0 +1,136 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+
+#include <llfs/shared_cache_page_device.hpp>
+//
+#include <llfs/shared_cache_page_device.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/memory_page_device.hpp>
+#include <llfs/page_buffer.hpp>
+
+#include <cstring>
+#include <memory>
+
+namespace {
+
+using namespace llfs::int_types;
+
+// Test Plan:
+//  1. A read that misses goes to the underlying device and returns the shared copy; a read of the
+//     same page through another device attached to the shared cache (standing in for another
+//     process) is served from the cache, even though its own device doesn't have the page.
+//  2. Dropping a page removes it from the shared cache.
+
+constexpr llfs::page_device_id_int kDeviceId = 1;
+constexpr i64 kCapacity = 4;
+constexpr u32 kPageSize = 4096;
+
+llfs::PageDevice::ReadResult read_page(llfs::PageDevice& device, llfs::PageId page_id)
+{
+  llfs::PageDevice::ReadResult result{llfs::Status{batt::StatusCode::kUnknown}};
+  device.read(page_id, [&result](llfs::PageDevice::ReadResult r) {
+    result = std::move(r);
+  });
+  return result;
+}
+
+llfs::Status write_page(llfs::PageDevice& device, std::shared_ptr<llfs::PageBuffer>&& buffer)
+{
+  llfs::Status result;
+  device.write(std::move(buffer), [&result](llfs::Status status) {
+    result = status;
+  });
+  return result;
+}
+
+class SharedCachePageDeviceTest : public ::testing::Test
+{
+ public:
+  void SetUp() override
+  {
+    llfs::StatusOr<std::shared_ptr<llfs::SharedPageBufferCache>> cache =
+        llfs::SharedPageBufferCache::create(llfs::SharedPageBufferCacheOptions{
+            .page_size = llfs::PageSize{kPageSize},
+            .slot_count = 16,
+        });
+    ASSERT_TRUE(cache.ok()) << BATT_INSPECT(cache.status());
+
+    llfs::StatusOr<std::shared_ptr<llfs::SharedPageBufferCache>> other_cache =
+        llfs::SharedPageBufferCache::attach((*cache)->fd());
+    ASSERT_TRUE(other_cache.ok()) << BATT_INSPECT(other_cache.status());
+
+    this->device_.emplace(std::make_unique<llfs::MemoryPageDevice>(
+                              kDeviceId, llfs::PageCount{kCapacity}, llfs::PageSize{kPageSize}),
+                          *cache);
+
+    this->other_device_.emplace(std::make_unique<llfs::MemoryPageDevice>(
+                                    kDeviceId, llfs::PageCount{kCapacity},
+                                    llfs::PageSize{kPageSize}),
+                                *other_cache);
+
+    this->page_id_ = this->device_->page_ids().make_page_id(2, 1);
+
+    llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer =
+        this->device_->prepare(this->page_id_);
+    ASSERT_TRUE(buffer.ok()) << BATT_INSPECT(buffer.status());
+
+    llfs::MutableBuffer payload = (*buffer)->mutable_payload();
+    std::memset(payload.data(), 0x5a, payload.size());
+
+    this->written_ = buffer->get();
+
+    ASSERT_TRUE(write_page(*this->device_, std::move(*buffer)).ok());
+  }
+
+  llfs::Optional<llfs::SharedCachePageDevice> device_;
+  llfs::Optional<llfs::SharedCachePageDevice> other_device_;
+  llfs::PageId page_id_;
+  const llfs::PageBuffer* written_ = nullptr;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+//
+TEST_F(SharedCachePageDeviceTest, ReadThroughSharedCache)
+{
+  llfs::PageDevice::ReadResult first = read_page(*this->device_, this->page_id_);
+  ASSERT_TRUE(first.ok()) << BATT_INSPECT(first.status());
+
+  // The result is the shared copy, not the buffer held by the MemoryPageDevice.
+  //
+  EXPECT_NE(first->get(), this->written_);
+  EXPECT_EQ(std::memcmp(first->get(), this->written_, kPageSize), 0);
+  EXPECT_EQ(this->device_->cache()->metrics().insert_count.load(), 1u);
+
+  llfs::PageDevice::ReadResult second = read_page(*this->other_device_, this->page_id_);
+  ASSERT_TRUE(second.ok()) << BATT_INSPECT(second.status());
+  EXPECT_EQ(std::memcmp(second->get(), this->written_, kPageSize), 0);
+  EXPECT_EQ(this->other_device_->cache()->metrics().hit_count.load(), 1u);
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+//
+TEST_F(SharedCachePageDeviceTest, DropInvalidates)
+{
+  ASSERT_TRUE(read_page(*this->device_, this->page_id_).ok());
+  ASSERT_NE(this->device_->cache()->find(this->page_id_), nullptr);
+
+  llfs::Status drop_status{batt::StatusCode::kUnknown};
+  this->device_->drop(this->page_id_, [&drop_status](llfs::Status status) {
+    drop_status = status;
+  });
+  ASSERT_TRUE(drop_status.ok()) << BATT_INSPECT(drop_status);
+
+  EXPECT_EQ(this->device_->cache()->find(this->page_id_), nullptr);
+  EXPECT_FALSE(read_page(*this->other_device_, this->page_id_).ok());
+}
+
+}  // namespace
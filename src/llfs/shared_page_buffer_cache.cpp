@@ -0,0 +1,516 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+
+#include <llfs/shared_page_buffer_cache.hpp>
+//
+
+#include <llfs/logging.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/math.hpp>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <signal.h>
+#include <unistd.h>
+
+namespace llfs {
+
+namespace {
+
+constexpr u64 kRegionMagic = 0x5c0a7e1d9a6e3f21ull;
+constexpr u32 kRegionVersion = 1;
+
+// The header, the slot table and the page images each start on a page boundary of the mapping.
+//
+constexpr i32 kRegionAlignLog2 = 12;
+
+// Slot states.
+//
+constexpr u32 kSlotFree = 0;
+constexpr u32 kSlotWriting = 1;
+constexpr u32 kSlotValid = 2;
+
+// The slot holds a page that was invalidated; like kSlotFree, but it can only be reused once no
+// process has it pinned.
+//
+constexpr u32 kSlotRetired = 3;
+
+static_assert(std::atomic<u64>::is_always_lock_free, "");
+static_assert(std::atomic<u32>::is_always_lock_free, "");
+static_assert(std::atomic<i32>::is_always_lock_free, "");
+
+}  // namespace
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// The first part of the shared memory region.  All atomics in the region are lock-free, so they
+// work across processes.
+//
+struct SharedPageBufferCache::RegionHeader {
+  u64 magic;
+  u32 version;
+  u32 page_size;
+  u64 slot_count;
+  u64 tag;
+  u64 slots_offset;
+  u64 pages_offset;
+
+  // The pid of the process using each bit of the slot pin masks; 0 means the entry is free, and
+  // -1 means the (exited) process's pins are being swept.
+  //
+  std::atomic<i32> process_pid[kMaxProcessCount];
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+//
+struct SharedPageBufferCache::Slot {
+  // The PageId of the cached page; only meaningful while `state` is kSlotValid.
+  //
+  std::atomic<page_id_int> key;
+
+  // Bit i is set while process i has the slot pinned.
+  //
+  std::atomic<u64> pins;
+
+  std::atomic<u32> state;
+
+  // Set when the page is used; cleared by the eviction scan (second chance).
+  //
+  std::atomic<u32> referenced;
+
+  u64 reserved_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<std::shared_ptr<SharedPageBufferCache>> SharedPageBufferCache::create(
+    const SharedPageBufferCacheOptions& options) noexcept
+{
+  if (options.slot_count == 0 || options.page_size < sizeof(PageBuffer) ||
+      options.page_size % sizeof(PageBuffer::Block) != 0) {
+    return {batt::StatusCode::kInvalidArgument};
+  }
+
+  const usize slots_offset = batt::round_up_bits(kRegionAlignLog2, sizeof(RegionHeader));
+  const usize pages_offset =
+      slots_offset + batt::round_up_bits(kRegionAlignLog2, options.slot_count * sizeof(Slot));
+  const usize memory_size = pages_offset + options.slot_count * options.page_size;
+
+  const int fd = ::memfd_create("llfs_shared_page_buffer_cache", MFD_CLOEXEC);
+  if (fd == -1) {
+    return batt::status_from_errno(errno);
+  }
+
+  // The new file is zero-filled, which is the initial state of every slot and process entry.
+  //
+  if (::ftruncate(fd, memory_size) != 0) {
+    const int saved_errno = errno;
+    ::close(fd);
+    return batt::status_from_errno(saved_errno);
+  }
+
+  void* const memory = ::mmap(nullptr, memory_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (memory == MAP_FAILED) {
+    const int saved_errno = errno;
+    ::close(fd);
+    return batt::status_from_errno(saved_errno);
+  }
+
+  RegionHeader* const header = static_cast<RegionHeader*>(memory);
+  header->page_size = options.page_size;
+  header->slot_count = options.slot_count;
+  header->tag = options.tag;
+  header->slots_offset = slots_offset;
+  header->pages_offset = pages_offset;
+  header->version = kRegionVersion;
+
+  // Publish the header last; `attach` checks the magic number first.
+  //
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = kRegionMagic;
+
+  std::shared_ptr<SharedPageBufferCache> cache{
+      new SharedPageBufferCache{fd, memory, memory_size}};
+
+  BATT_REQUIRE_OK(cache->register_process());
+
+  return cache;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<std::shared_ptr<SharedPageBufferCache>> SharedPageBufferCache::attach(
+    int fd, Optional<u64> expected_tag) noexcept
+{
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    return batt::status_from_errno(errno);
+  }
+
+  const usize memory_size = st.st_size;
+  if (memory_size < sizeof(RegionHeader)) {
+    return {batt::StatusCode::kInvalidArgument};
+  }
+
+  const int own_fd = ::dup(fd);
+  if (own_fd == -1) {
+    return batt::status_from_errno(errno);
+  }
+
+  void* const memory =
+      ::mmap(nullptr, memory_size, PROT_READ | PROT_WRITE, MAP_SHARED, own_fd, 0);
+  if (memory == MAP_FAILED) {
+    const int saved_errno = errno;
+    ::close(own_fd);
+    return batt::status_from_errno(saved_errno);
+  }
+
+  // From here on, the cache object owns the fd and the mapping.
+  //
+  std::shared_ptr<SharedPageBufferCache> cache{
+      new SharedPageBufferCache{own_fd, memory, memory_size}};
+
+  const RegionHeader& header = cache->header();
+  if (header.magic != kRegionMagic || header.version != kRegionVersion ||
+      header.pages_offset + header.slot_count * header.page_size > memory_size) {
+    return {batt::StatusCode::kDataLoss};
+  }
+
+  if (expected_tag && *expected_tag != header.tag) {
+    return {batt::StatusCode::kInvalidArgument};
+  }
+
+  BATT_REQUIRE_OK(cache->register_process());
+
+  // Attaching is a good time to clean up after processes that have gone away.
+  //
+  cache->sweep_dead_processes();
+
+  return cache;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ SharedPageBufferCache::SharedPageBufferCache(int fd, void* memory,
+                                                          usize memory_size) noexcept
+    : fd_{fd}
+    , memory_{memory}
+    , memory_size_{memory_size}
+{
+  static_assert(sizeof(Slot) == 32, "");
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+SharedPageBufferCache::~SharedPageBufferCache() noexcept
+{
+  // Every buffer returned by this object holds a reference to it, so this process has no pins left
+  // (i.e., its bit is clear in every slot).
+  //
+  if (this->process_index_ < kMaxProcessCount) {
+    this->header().process_pid[this->process_index_].store(0);
+  }
+
+  ::munmap(this->memory_, this->memory_size_);
+  ::close(this->fd_);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status SharedPageBufferCache::register_process() noexcept
+{
+  RegionHeader& header = this->header();
+
+  this->page_size_ = PageSize{header.page_size};
+  this->slot_count_ = header.slot_count;
+  this->local_pins_.reset(new u32[this->slot_count_]{});
+
+  const i32 pid = ::getpid();
+
+  for (usize attempt = 0; attempt < 2; ++attempt) {
+    for (usize i = 0; i < kMaxProcessCount; ++i) {
+      i32 expected = 0;
+      if (header.process_pid[i].compare_exchange_strong(expected, pid)) {
+        this->process_index_ = i;
+        this->process_bit_ = u64{1} << i;
+        return OkStatus();
+      }
+    }
+    // The table is full; see whether any of the processes in it are gone.
+    //
+    if (this->sweep_dead_processes() == 0) {
+      break;
+    }
+  }
+
+  return {batt::StatusCode::kResourceExhausted};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 SharedPageBufferCache::tag() const noexcept
+{
+  return this->header().tag;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto SharedPageBufferCache::header() const noexcept -> RegionHeader&
+{
+  return *static_cast<RegionHeader*>(this->memory_);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto SharedPageBufferCache::slot(usize slot_i) const noexcept -> Slot&
+{
+  return reinterpret_cast<Slot*>(static_cast<u8*>(this->memory_) +
+                                 this->header().slots_offset)[slot_i];
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageBuffer* SharedPageBufferCache::page_at(usize slot_i) const noexcept
+{
+  return reinterpret_cast<PageBuffer*>(static_cast<u8*>(this->memory_) +
+                                       this->header().pages_offset +
+                                       slot_i * this->page_size_);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize SharedPageBufferCache::probe_start(PageId page_id) const noexcept
+{
+  // Mix the bits, since physical page numbers are in the low bits and generations in the high
+  // bits.
+  //
+  u64 h = page_id.int_value() * 0x9e3779b97f4a7c15ull;
+  h ^= h >> 29;
+
+  return h % this->slot_count_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::shared_ptr<const PageBuffer> SharedPageBufferCache::make_buffer(usize slot_i) noexcept
+{
+  return std::shared_ptr<const PageBuffer>{
+      this->page_at(slot_i), [cache = this->shared_from_this(), slot_i](const PageBuffer*) {
+        cache->unpin(slot_i);
+      }};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void SharedPageBufferCache::pin(usize slot_i) noexcept
+{
+  std::unique_lock<std::mutex> lock{this->pin_locks_[slot_i % this->pin_locks_.size()]};
+
+  if (this->local_pins_[slot_i] == 0) {
+    this->slot(slot_i).pins.fetch_or(this->process_bit_);
+  }
+  this->local_pins_[slot_i] += 1;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void SharedPageBufferCache::unpin(usize slot_i) noexcept
+{
+  std::unique_lock<std::mutex> lock{this->pin_locks_[slot_i % this->pin_locks_.size()]};
+
+  BATT_CHECK_GT(this->local_pins_[slot_i], 0u);
+  this->local_pins_[slot_i] -= 1;
+  if (this->local_pins_[slot_i] == 0) {
+    this->slot(slot_i).pins.fetch_and(~this->process_bit_);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool SharedPageBufferCache::try_pin(usize slot_i, page_id_int key) noexcept
+{
+  Slot& s = this->slot(slot_i);
+
+  if (s.state.load() != kSlotValid || s.key.load() != key) {
+    return false;
+  }
+
+  // Pin first, then check again; `try_claim` changes the state first and then checks the pins, so
+  // (with sequentially consistent atomics) at least one of the two sees the other.
+  //
+  this->pin(slot_i);
+
+  if (s.state.load() != kSlotValid || s.key.load() != key) {
+    this->unpin(slot_i);
+    return false;
+  }
+
+  s.referenced.store(1);
+  return true;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool SharedPageBufferCache::try_claim(usize slot_i, bool second_chance) noexcept
+{
+  Slot& s = this->slot(slot_i);
+
+  u32 observed = s.state.load();
+  if (observed == kSlotWriting) {
+    return false;
+  }
+
+  if (observed == kSlotValid && second_chance && s.referenced.exchange(0) != 0) {
+    return false;
+  }
+
+  if (!s.state.compare_exchange_strong(observed, kSlotWriting)) {
+    return false;
+  }
+
+  if (s.pins.load() != 0) {
+    s.state.store(observed);
+    return false;
+  }
+
+  if (observed == kSlotValid) {
+    this->metrics_.evict_count.add(1);
+  }
+  return true;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::shared_ptr<const PageBuffer> SharedPageBufferCache::find(PageId page_id) noexcept
+{
+  this->metrics_.find_count.add(1);
+
+  const page_id_int key = page_id.int_value();
+  const usize start = this->probe_start(page_id);
+
+  for (usize i = 0; i < kProbeLength; ++i) {
+    const usize slot_i = (start + i) % this->slot_count_;
+    if (this->try_pin(slot_i, key)) {
+      this->metrics_.hit_count.add(1);
+      return this->make_buffer(slot_i);
+    }
+  }
+
+  return nullptr;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::shared_ptr<const PageBuffer> SharedPageBufferCache::insert(const PageBuffer& page) noexcept
+{
+  if (page.size() != this->page_size_) {
+    return nullptr;
+  }
+
+  const PageId page_id = page.page_id();
+
+  if (std::shared_ptr<const PageBuffer> cached = this->find(page_id)) {
+    return cached;
+  }
+
+  const usize start = this->probe_start(page_id);
+
+  // First pass: free slots and pages that haven't been used since the last scan; second pass: any
+  // unpinned slot.  If that fails too, sweep the pins of exited processes and try once more.
+  //
+  for (usize pass = 0; pass < 3; ++pass) {
+    if (pass == 2 && this->sweep_dead_processes() == 0) {
+      break;
+    }
+    for (usize i = 0; i < kProbeLength; ++i) {
+      const usize slot_i = (start + i) % this->slot_count_;
+      if (!this->try_claim(slot_i, /*second_chance=*/(pass == 0))) {
+        continue;
+      }
+
+      Slot& s = this->slot(slot_i);
+
+      s.key.store(page_id.int_value());
+      std::memcpy(this->page_at(slot_i), &page, this->page_size_);
+      s.referenced.store(1);
+
+      this->pin(slot_i);
+      s.state.store(kSlotValid);
+
+      this->metrics_.insert_count.add(1);
+      return this->make_buffer(slot_i);
+    }
+  }
+
+  this->metrics_.insert_full_count.add(1);
+  return nullptr;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void SharedPageBufferCache::invalidate(PageId page_id) noexcept
+{
+  const page_id_int key = page_id.int_value();
+  const usize start = this->probe_start(page_id);
+
+  for (usize i = 0; i < kProbeLength; ++i) {
+    Slot& s = this->slot((start + i) % this->slot_count_);
+    if (s.key.load() == key) {
+      u32 expected = kSlotValid;
+      s.state.compare_exchange_strong(expected, kSlotRetired);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize SharedPageBufferCache::sweep_dead_processes() noexcept
+{
+  RegionHeader& header = this->header();
+  usize swept = 0;
+
+  for (usize i = 0; i < kMaxProcessCount; ++i) {
+    if (i == this->process_index_) {
+      continue;
+    }
+
+    i32 pid = header.process_pid[i].load();
+    if (pid <= 0 || ::kill(pid, 0) == 0 || errno != ESRCH) {
+      continue;
+    }
+
+    // Claim the entry so that only one process sweeps it, and no new process takes it until the
+    // sweep is done.
+    //
+    if (!header.process_pid[i].compare_exchange_strong(pid, -1)) {
+      continue;
+    }
+
+    const u64 mask = ~(u64{1} << i);
+    for (usize slot_i = 0; slot_i < this->slot_count_; ++slot_i) {
+      this->slot(slot_i).pins.fetch_and(mask);
+    }
+
+    LLFS_VLOG(1) << "SharedPageBufferCache: swept the pins of exited process" << BATT_INSPECT(pid)
+                 << BATT_INSPECT(i);
+
+    header.process_pid[i].store(0);
+    swept += 1;
+  }
+
+  this->metrics_.swept_process_count.add(swept);
+
+  return swept;
+}
+
+}  // namespace llfs
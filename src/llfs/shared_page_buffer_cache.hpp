@@ -0,0 +1,249 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+
+#pragma once
+#ifndef LLFS_SHARED_PAGE_BUFFER_CACHE_HPP
+#define LLFS_SHARED_PAGE_BUFFER_CACHE_HPP
+
+#include <llfs/config.hpp>
+//
+
+#include <llfs/int_types.hpp>
+#include <llfs/metrics.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/page_buffer.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/page_size.hpp>
+#include <llfs/status.hpp>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace llfs {
+
+/** \brief Options for creating a SharedPageBufferCache.
+ */
+struct SharedPageBufferCacheOptions {
+  /** \brief The size of every page in the cache.
+   */
+  PageSize page_size;
+
+  /** \brief The number of pages the cache can hold.
+   */
+  usize slot_count;
+
+  /** \brief An application-defined value stored in the cache; SharedPageBufferCache::attach can be
+   * asked to check it, e.g. so that processes only share a cache built for the same arenas.
+   */
+  u64 tag = 0;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A cache of immutable page images in shared memory (a memfd), which several processes on
+ * one host can attach to, so that a page read by any of them is cached once for all.
+ *
+ * The PageBuffers returned by `find` and `insert` point directly into the shared mapping; while one
+ * is alive, the slot holding it is pinned, and can't be reused for another page by any of the
+ * processes.  Pins are robust against processes that exit (or crash) without releasing them: each
+ * attached process has a bit in every slot's pin mask (plus a private pin count per slot), and
+ * `sweep_dead_processes` clears the bits of processes that no longer exist.  This happens
+ * automatically when a process attaches, and when `insert` can't find an unpinned slot.
+ *
+ * Pages are placed by hashing their PageId into a small window of slots; eviction within the
+ * window is second-chance (CLOCK).  Since PageIds contain the page generation, a cached page never
+ * goes stale while its PageId is in use, but all attached processes must use the cache for the
+ * same page devices (see `tag`).  The data of a cached page must not be modified.
+ *
+ * At most kMaxProcessCount processes may be attached at once.  A process whose pid is reused by
+ * another process before its pins are swept keeps its pins until that process exits too.
+ */
+class SharedPageBufferCache : public std::enable_shared_from_this<SharedPageBufferCache>
+{
+ public:
+  /** \brief The maximum number of processes which can be attached to one cache at the same time.
+   */
+  static constexpr usize kMaxProcessCount = 64;
+
+  /** \brief The number of slots a page may be placed in.
+   */
+  static constexpr usize kProbeLength = 8;
+
+  struct Metrics {
+    CountMetric<u64> find_count{0};
+    CountMetric<u64> hit_count{0};
+    CountMetric<u64> insert_count{0};
+    CountMetric<u64> evict_count{0};
+
+    /** \brief The number of calls to `insert` which failed because every candidate slot was pinned.
+     */
+    CountMetric<u64> insert_full_count{0};
+
+    /** \brief The number of exited processes whose pins have been swept.
+     */
+    CountMetric<u64> swept_process_count{0};
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Creates a new (empty) cache backed by a memfd and attaches the calling process to it.
+   *
+   * Other processes attach by calling `attach` on a descriptor for the same memfd (inherited
+   * across fork, passed over a unix socket, or opened through /proc/<pid>/fd/<fd>).
+   */
+  static StatusOr<std::shared_ptr<SharedPageBufferCache>> create(
+      const SharedPageBufferCacheOptions& options) noexcept;
+
+  /** \brief Attaches the calling process to the cache in the shared memory file `fd` (which is
+   * duplicated; the caller keeps ownership of `fd`).  If `expected_tag` is given, returns
+   * kInvalidArgument unless it matches the cache's tag.  Returns kResourceExhausted if
+   * kMaxProcessCount processes are already attached.
+   */
+  static StatusOr<std::shared_ptr<SharedPageBufferCache>> attach(
+      int fd, Optional<u64> expected_tag = None) noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  SharedPageBufferCache(const SharedPageBufferCache&) = delete;
+  SharedPageBufferCache& operator=(const SharedPageBufferCache&) = delete;
+
+  /** \brief Detaches this process from the cache (releasing all of its pins) and unmaps it.
+   */
+  ~SharedPageBufferCache() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief The shared memory file descriptor; pass this (or a duplicate) to `attach`.
+   */
+  int fd() const noexcept
+  {
+    return this->fd_;
+  }
+
+  PageSize page_size() const noexcept
+  {
+    return this->page_size_;
+  }
+
+  usize slot_count() const noexcept
+  {
+    return this->slot_count_;
+  }
+
+  u64 tag() const noexcept;
+
+  /** \brief The index of this process in the cache's process table.
+   */
+  usize process_index() const noexcept
+  {
+    return this->process_index_;
+  }
+
+  const Metrics& metrics() const noexcept
+  {
+    return this->metrics_;
+  }
+
+  /** \brief Returns the cached image of the given page, pinned until the returned buffer is
+   * released; returns nullptr if the page isn't cached.
+   */
+  std::shared_ptr<const PageBuffer> find(PageId page_id) noexcept;
+
+  /** \brief Copies `page` (whose size must be `page_size()`) into the cache, and returns the cached
+   * image as for `find`.  If the page is already cached, the existing image is returned.  Returns
+   * nullptr if the page can't be cached right now because all the slots it can go in are pinned.
+   */
+  std::shared_ptr<const PageBuffer> insert(const PageBuffer& page) noexcept;
+
+  /** \brief Removes the given page from the cache; buffers already returned for it stay valid.
+   */
+  void invalidate(PageId page_id) noexcept;
+
+  /** \brief Releases the pins held by attached processes that have exited.  Returns the number of
+   * processes swept.
+   */
+  usize sweep_dead_processes() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  struct RegionHeader;
+  struct Slot;
+
+  /** \brief Takes ownership of `fd` and the mapping at `memory`.
+   */
+  explicit SharedPageBufferCache(int fd, void* memory, usize memory_size) noexcept;
+
+  /** \brief Claims an entry in the process table for the calling process.
+   */
+  Status register_process() noexcept;
+
+  RegionHeader& header() const noexcept;
+
+  Slot& slot(usize slot_i) const noexcept;
+
+  PageBuffer* page_at(usize slot_i) const noexcept;
+
+  /** \brief Returns the index of the first slot in the probe window for `page_id`.
+   */
+  usize probe_start(PageId page_id) const noexcept;
+
+  /** \brief Returns a buffer for the page in the given slot, which the caller has already pinned;
+   * releasing the buffer unpins the slot.
+   */
+  std::shared_ptr<const PageBuffer> make_buffer(usize slot_i) noexcept;
+
+  /** \brief Tries to pin the given slot as holding `key`; returns false if it doesn't.
+   */
+  bool try_pin(usize slot_i, page_id_int key) noexcept;
+
+  void pin(usize slot_i) noexcept;
+
+  void unpin(usize slot_i) noexcept;
+
+  /** \brief Tries to take the given slot for writing a new page; returns true on success.
+   */
+  bool try_claim(usize slot_i, bool second_chance) noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  // The shared memory file.
+  //
+  const int fd_;
+
+  // The mapping of `fd_`; unmapped when the cache is destroyed.
+  //
+  void* const memory_;
+  const usize memory_size_;
+
+  // Cached from the region header.
+  //
+  PageSize page_size_{0};
+  usize slot_count_ = 0;
+
+  // This process's index in the process table, and its bit in each slot's pin mask.
+  //
+  usize process_index_ = kMaxProcessCount;
+  u64 process_bit_ = 0;
+
+  // A private (per-process) pin count for each slot; this process's bit is set in a slot's pin
+  // mask while its count is non-zero.
+  //
+  std::unique_ptr<u32[]> local_pins_;
+
+  // Protects `local_pins_` (and the updates of this process's pin bits), striped by slot index.
+  //
+  std::array<std::mutex, 64> pin_locks_;
+
+  Metrics metrics_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_SHARED_PAGE_BUFFER_CACHE_HPP
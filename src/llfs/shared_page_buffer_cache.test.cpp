@@ -0,0 +1,210 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+
+#include <llfs/shared_page_buffer_cache.hpp>
+//
+#include <llfs/shared_page_buffer_cache.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+using namespace llfs::int_types;
+
+// Test Plan:
+//  1. insert copies the page into the cache and returns the shared copy; find returns the same
+//     copy; pages not inserted are not found; invalidate removes a page.
+//  2. A second attachment of the same memfd sees the pages inserted through the first.
+//  3. Pinned slots are not evicted: with one probe window's worth of slots all pinned, insert
+//     fails until a buffer is released.
+//  4. The pins of a process that exits without releasing them are swept, so its slots can be
+//     reused.
+
+constexpr u32 kPageSize = 4096;
+
+std::shared_ptr<llfs::PageBuffer> make_page(u64 page_id_int)
+{
+  std::shared_ptr<llfs::PageBuffer> page =
+      llfs::PageBuffer::allocate(llfs::PageSize{kPageSize}, llfs::PageId{page_id_int});
+
+  llfs::MutableBuffer payload = page->mutable_payload();
+  std::memset(payload.data(), static_cast<int>(page_id_int & 0xff), payload.size());
+
+  return page;
+}
+
+bool same_contents(const llfs::PageBuffer& l, const llfs::PageBuffer& r)
+{
+  return std::memcmp(&l, &r, kPageSize) == 0;
+}
+
+llfs::SharedPageBufferCacheOptions small_cache_options()
+{
+  return llfs::SharedPageBufferCacheOptions{
+      .page_size = llfs::PageSize{kPageSize},
+      .slot_count = llfs::SharedPageBufferCache::kProbeLength,
+      .tag = 0x1234,
+  };
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+//
+TEST(SharedPageBufferCacheTest, InsertFind)
+{
+  llfs::StatusOr<std::shared_ptr<llfs::SharedPageBufferCache>> cache =
+      llfs::SharedPageBufferCache::create(llfs::SharedPageBufferCacheOptions{
+          .page_size = llfs::PageSize{kPageSize},
+          .slot_count = 64,
+      });
+  ASSERT_TRUE(cache.ok()) << BATT_INSPECT(cache.status());
+
+  std::shared_ptr<llfs::PageBuffer> page = make_page(7);
+
+  EXPECT_EQ((*cache)->find(llfs::PageId{7}), nullptr);
+
+  std::shared_ptr<const llfs::PageBuffer> inserted = (*cache)->insert(*page);
+  ASSERT_NE(inserted, nullptr);
+  EXPECT_NE(inserted.get(), page.get());
+  EXPECT_TRUE(same_contents(*inserted, *page));
+  EXPECT_EQ(inserted->page_id(), llfs::PageId{7});
+
+  std::shared_ptr<const llfs::PageBuffer> found = (*cache)->find(llfs::PageId{7});
+  EXPECT_EQ(found.get(), inserted.get());
+  EXPECT_EQ((*cache)->find(llfs::PageId{8}), nullptr);
+
+  // Inserting the same page again returns the existing copy.
+  //
+  EXPECT_EQ((*cache)->insert(*page).get(), inserted.get());
+  EXPECT_EQ((*cache)->metrics().insert_count.load(), 1u);
+
+  (*cache)->invalidate(llfs::PageId{7});
+  EXPECT_EQ((*cache)->find(llfs::PageId{7}), nullptr);
+
+  // Buffers returned before the page was invalidated are still valid.
+  //
+  EXPECT_TRUE(same_contents(*found, *page));
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+//
+TEST(SharedPageBufferCacheTest, SecondAttachment)
+{
+  llfs::StatusOr<std::shared_ptr<llfs::SharedPageBufferCache>> first =
+      llfs::SharedPageBufferCache::create(small_cache_options());
+  ASSERT_TRUE(first.ok()) << BATT_INSPECT(first.status());
+
+  EXPECT_EQ(llfs::SharedPageBufferCache::attach((*first)->fd(), /*expected_tag=*/0x9999).status(),
+            batt::StatusCode::kInvalidArgument);
+
+  llfs::StatusOr<std::shared_ptr<llfs::SharedPageBufferCache>> second =
+      llfs::SharedPageBufferCache::attach((*first)->fd(), /*expected_tag=*/0x1234);
+  ASSERT_TRUE(second.ok()) << BATT_INSPECT(second.status());
+
+  EXPECT_NE((*first)->process_index(), (*second)->process_index());
+  EXPECT_EQ((*second)->page_size(), llfs::PageSize{kPageSize});
+  EXPECT_EQ((*second)->slot_count(), (*first)->slot_count());
+
+  std::shared_ptr<llfs::PageBuffer> page = make_page(99);
+  ASSERT_NE((*first)->insert(*page), nullptr);
+
+  std::shared_ptr<const llfs::PageBuffer> found = (*second)->find(llfs::PageId{99});
+  ASSERT_NE(found, nullptr);
+  EXPECT_TRUE(same_contents(*found, *page));
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+//
+TEST(SharedPageBufferCacheTest, PinnedSlotsNotEvicted)
+{
+  llfs::StatusOr<std::shared_ptr<llfs::SharedPageBufferCache>> cache =
+      llfs::SharedPageBufferCache::create(small_cache_options());
+  ASSERT_TRUE(cache.ok()) << BATT_INSPECT(cache.status());
+
+  std::vector<std::shared_ptr<const llfs::PageBuffer>> pinned;
+  for (u64 i = 1; i <= llfs::SharedPageBufferCache::kProbeLength; ++i) {
+    pinned.emplace_back((*cache)->insert(*make_page(i)));
+    ASSERT_NE(pinned.back(), nullptr) << BATT_INSPECT(i);
+  }
+
+  std::shared_ptr<llfs::PageBuffer> extra = make_page(100);
+
+  EXPECT_EQ((*cache)->insert(*extra), nullptr);
+  EXPECT_EQ((*cache)->metrics().insert_full_count.load(), 1u);
+
+  // Every pinned page is still there.
+  //
+  for (u64 i = 1; i <= llfs::SharedPageBufferCache::kProbeLength; ++i) {
+    std::shared_ptr<const llfs::PageBuffer> found = (*cache)->find(llfs::PageId{i});
+    ASSERT_NE(found, nullptr);
+    EXPECT_TRUE(same_contents(*found, *make_page(i)));
+  }
+
+  pinned.erase(pinned.begin());
+
+  std::shared_ptr<const llfs::PageBuffer> inserted = (*cache)->insert(*extra);
+  ASSERT_NE(inserted, nullptr);
+  EXPECT_TRUE(same_contents(*inserted, *extra));
+  EXPECT_EQ((*cache)->find(llfs::PageId{1}), nullptr);
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+//
+TEST(SharedPageBufferCacheTest, DeadProcessPinsSwept)
+{
+  llfs::StatusOr<std::shared_ptr<llfs::SharedPageBufferCache>> cache =
+      llfs::SharedPageBufferCache::create(small_cache_options());
+  ASSERT_TRUE(cache.ok()) << BATT_INSPECT(cache.status());
+
+  for (u64 i = 1; i <= llfs::SharedPageBufferCache::kProbeLength; ++i) {
+    ASSERT_NE((*cache)->insert(*make_page(i)), nullptr) << BATT_INSPECT(i);
+  }
+
+  const pid_t child = ::fork();
+  ASSERT_NE(child, -1);
+
+  if (child == 0) {
+    // Attach, pin every page, and exit without releasing anything.
+    //
+    llfs::StatusOr<std::shared_ptr<llfs::SharedPageBufferCache>> child_cache =
+        llfs::SharedPageBufferCache::attach((*cache)->fd());
+    if (!child_cache.ok()) {
+      ::_exit(1);
+    }
+    auto* leaked = new std::vector<std::shared_ptr<const llfs::PageBuffer>>;
+    for (u64 i = 1; i <= llfs::SharedPageBufferCache::kProbeLength; ++i) {
+      leaked->emplace_back((*child_cache)->find(llfs::PageId{i}));
+      if (leaked->back() == nullptr) {
+        ::_exit(2);
+      }
+    }
+    ::_exit(0);
+  }
+
+  int wait_status = 0;
+  ASSERT_EQ(::waitpid(child, &wait_status, 0), child);
+  ASSERT_TRUE(WIFEXITED(wait_status));
+  ASSERT_EQ(WEXITSTATUS(wait_status), 0);
+
+  // The insert finds every slot pinned (by the exited child), sweeps, and succeeds.
+  //
+  std::shared_ptr<llfs::PageBuffer> extra = make_page(100);
+  std::shared_ptr<const llfs::PageBuffer> inserted = (*cache)->insert(*extra);
+  ASSERT_NE(inserted, nullptr);
+  EXPECT_TRUE(same_contents(*inserted, *extra));
+  EXPECT_EQ((*cache)->metrics().swept_process_count.load(), 1u);
+}
+
+}  // namespace
@@ -0,0 +1,129 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/simulated_device_timing.hpp>
+//
+
+#include <batteries/assert.hpp>
+
+#include <algorithm>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, const SimulatedOpTimingStats& t)
+{
+  return out << "{.op_count=" << t.op_count << ", .byte_count=" << t.byte_count
+             << ", .mean_latency_nsec=" << t.mean_latency_nsec()
+             << ", .max_latency_nsec=" << t.max_latency_nsec
+             << ", .total_queue_wait_nsec=" << t.total_queue_wait_nsec << ",}";
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, const SimulatedDeviceTimingStats& t)
+{
+  return out << "{.reads=" << t.reads << ", .writes=" << t.writes
+             << ", .busy_until_nsec=" << t.busy_until_nsec << ",}";
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// class SimulatedDeviceTimer
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ SimulatedDeviceTimer::SimulatedDeviceTimer(
+    const SimulatedDeviceTimingModel& model) noexcept
+    : model_{model}
+    , rng_{model.seed}
+{
+  BATT_CHECK_GT(this->model_.queue_depth, 0u);
+  BATT_CHECK_LE(this->model_.read_latency.min_nsec, this->model_.read_latency.max_nsec);
+  BATT_CHECK_LE(this->model_.write_latency.min_nsec, this->model_.write_latency.max_nsec);
+
+  for (usize i = 0; i < this->model_.queue_depth; ++i) {
+    this->slot_free_at_.push(0);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 SimulatedDeviceTimer::schedule_op(SimulatedOpKind kind, u64 now_nsec, usize byte_count)
+{
+  std::unique_lock<std::mutex> lock{this->mutex_};
+
+  const bool is_read = (kind == SimulatedOpKind::kRead);
+
+  // Wait for a queue slot, then for the device's bandwidth.
+  //
+  const u64 service_start = std::max(now_nsec, this->slot_free_at_.top());
+  this->slot_free_at_.pop();
+
+  const u64 transfer_nsec = (this->model_.bandwidth_bytes_per_sec == 0)
+                                ? 0
+                                : (u64{byte_count} * 1000000000ull +
+                                   this->model_.bandwidth_bytes_per_sec - 1) /
+                                      this->model_.bandwidth_bytes_per_sec;
+
+  const u64 transfer_start = std::max(service_start, this->bandwidth_free_at_);
+  this->bandwidth_free_at_ = transfer_start + transfer_nsec;
+
+  const u64 completion_nsec =
+      this->bandwidth_free_at_ +
+      this->sample_latency(is_read ? this->model_.read_latency : this->model_.write_latency);
+
+  this->slot_free_at_.push(completion_nsec);
+
+  // Update stats.
+  //
+  SimulatedOpTimingStats& op_stats = is_read ? this->stats_.reads : this->stats_.writes;
+  const u64 latency_nsec = completion_nsec - now_nsec;
+
+  op_stats.op_count += 1;
+  op_stats.byte_count += byte_count;
+  op_stats.total_latency_nsec += latency_nsec;
+  op_stats.max_latency_nsec = std::max(op_stats.max_latency_nsec, latency_nsec);
+  op_stats.total_queue_wait_nsec += transfer_start - now_nsec;
+
+  this->stats_.busy_until_nsec = std::max(this->stats_.busy_until_nsec, completion_nsec);
+
+  return completion_nsec;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+SimulatedDeviceTimingStats SimulatedDeviceTimer::stats() const
+{
+  std::unique_lock<std::mutex> lock{this->mutex_};
+
+  return this->stats_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 SimulatedDeviceTimer::sample_latency(const SimulatedLatency& latency)
+{
+  const u64 range = latency.max_nsec - latency.min_nsec;
+
+  // Draw from the raw generator rather than std::uniform_*_distribution, whose output isn't
+  // specified by the standard (so that runs are reproducible across standard libraries).
+  //
+  u64 sample = latency.min_nsec + ((range == 0) ? 0 : (this->rng_() % (range + 1)));
+
+  if (latency.tail_probability > 0.0) {
+    const double p = double(this->rng_() >> 11) * 0x1.0p-53;
+    if (p < latency.tail_probability) {
+      sample += latency.tail_nsec;
+    }
+  }
+
+  return sample;
+}
+
+}  //namespace llfs
@@ -0,0 +1,165 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_SIMULATED_DEVICE_TIMING_HPP
+#define LLFS_SIMULATED_DEVICE_TIMING_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <queue>
+#include <random>
+#include <vector>
+
+namespace llfs {
+
+/** \brief The distribution of the fixed (size-independent) part of the service time of one
+ * simulated I/O.
+ *
+ * Each op's latency is drawn uniformly from [min_nsec, max_nsec]; with probability
+ * `tail_probability`, `tail_nsec` is added on top of that (to model the occasional slow op, e.g. a
+ * flash GC pause).
+ */
+struct SimulatedLatency {
+  u64 min_nsec = 0;
+  u64 max_nsec = 0;
+  double tail_probability = 0.0;
+  u64 tail_nsec = 0;
+};
+
+/** \brief Describes the performance of a simulated storage device.
+ */
+struct SimulatedDeviceTimingModel {
+  SimulatedLatency read_latency;
+  SimulatedLatency write_latency;
+
+  /** \brief The maximum number of ops in service at once; ops issued beyond this wait for the
+   * earliest in-flight op to complete.
+   */
+  usize queue_depth = 32;
+
+  /** \brief The rate (bytes per simulated second) at which data moves to/from the device; the
+   * transfers of all ops on the device share this rate.  0 means unlimited.
+   */
+  u64 bandwidth_bytes_per_sec = 0;
+
+  /** \brief Seeds the generator from which latencies are drawn; kept apart from the simulation's
+   * entropy source so that a timing model doesn't change the set of event orderings explored.
+   */
+  u64 seed = 1;
+};
+
+/** \brief The kinds of simulated I/O, for the purpose of timing.  Drops (page trims) are timed as
+ * writes of zero bytes.
+ */
+enum struct SimulatedOpKind {
+  kRead = 0,
+  kWrite = 1,
+};
+
+/** \brief Simulated-time counters for one kind of op on one device.
+ */
+struct SimulatedOpTimingStats {
+  u64 op_count = 0;
+  u64 byte_count = 0;
+
+  /** \brief Sum over all ops of (completion time - issue time).
+   */
+  u64 total_latency_nsec = 0;
+
+  u64 max_latency_nsec = 0;
+
+  /** \brief Sum over all ops of the time spent waiting for a queue slot or for bandwidth.
+   */
+  u64 total_queue_wait_nsec = 0;
+
+  /** \brief Returns the average latency, or 0 if there were no ops.
+   */
+  u64 mean_latency_nsec() const noexcept
+  {
+    return (this->op_count == 0) ? 0 : (this->total_latency_nsec / this->op_count);
+  }
+};
+
+std::ostream& operator<<(std::ostream& out, const SimulatedOpTimingStats& t);
+
+/** \brief Simulated-time counters for one device.
+ */
+struct SimulatedDeviceTimingStats {
+  SimulatedOpTimingStats reads;
+  SimulatedOpTimingStats writes;
+
+  /** \brief The latest completion time of any op issued so far.
+   */
+  u64 busy_until_nsec = 0;
+};
+
+std::ostream& operator<<(std::ostream& out, const SimulatedDeviceTimingStats& t);
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Computes when simulated I/O ops complete, according to a SimulatedDeviceTimingModel.
+ *
+ * The timer doesn't schedule anything itself; the simulated device asks it for the completion
+ * time of each op as the op is issued and defers the op's handler until the simulation clock
+ * reaches that time (see StorageSimulation::post_at).
+ */
+class SimulatedDeviceTimer
+{
+ public:
+  explicit SimulatedDeviceTimer(const SimulatedDeviceTimingModel& model) noexcept;
+
+  SimulatedDeviceTimer(const SimulatedDeviceTimer&) = delete;
+  SimulatedDeviceTimer& operator=(const SimulatedDeviceTimer&) = delete;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const SimulatedDeviceTimingModel& model() const noexcept
+  {
+    return this->model_;
+  }
+
+  /** \brief Returns the simulated time at which an op of the given kind and size, issued at
+   * `now_nsec`, completes; the op is accounted for in the queue, bandwidth and stats.
+   */
+  u64 schedule_op(SimulatedOpKind kind, u64 now_nsec, usize byte_count);
+
+  /** \brief Returns a snapshot of the counters.
+   */
+  SimulatedDeviceTimingStats stats() const;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  u64 sample_latency(const SimulatedLatency& latency);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const SimulatedDeviceTimingModel model_;
+
+  mutable std::mutex mutex_;
+
+  std::mt19937_64 rng_;
+
+  // The times at which each of the `queue_depth` slots becomes free (min-heap).
+  //
+  std::priority_queue<u64, std::vector<u64>, std::greater<u64>> slot_free_at_;
+
+  // The time at which the device's bandwidth is next available.
+  //
+  u64 bandwidth_free_at_ = 0;
+
+  SimulatedDeviceTimingStats stats_;
+};
+
+}  //namespace llfs
+
+#endif  // LLFS_SIMULATED_DEVICE_TIMING_HPP
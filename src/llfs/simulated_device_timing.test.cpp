@@ -0,0 +1,192 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/simulated_device_timing.hpp>
+//
+#include <llfs/simulated_device_timing.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/page_buffer.hpp>
+#include <llfs/storage_simulation.hpp>
+
+#include <batteries/async/task.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. With a fixed latency, ops beyond the queue depth wait for the earliest in-flight op.
+//  2. With a bandwidth cap, the transfers of concurrent ops are serialized.
+//  3. Latencies are drawn from the configured range, and the same seed gives the same latencies.
+//  4. In a StorageSimulation, awaiting a write/read on a timed page device advances the
+//     simulation clock by the op's latency, and the device's stats are reported; without a timing
+//     model the clock doesn't move.
+
+using namespace llfs::int_types;
+
+using llfs::SimulatedDeviceTimer;
+using llfs::SimulatedDeviceTimingModel;
+using llfs::SimulatedDeviceTimingStats;
+using llfs::SimulatedOpKind;
+
+constexpr u64 kUsec = 1000;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(SimulatedDeviceTimerTest, QueueDepth)
+{
+  SimulatedDeviceTimingModel model;
+  model.write_latency.min_nsec = 100 * kUsec;
+  model.write_latency.max_nsec = 100 * kUsec;
+  model.queue_depth = 2;
+
+  SimulatedDeviceTimer timer{model};
+
+  EXPECT_EQ(timer.schedule_op(SimulatedOpKind::kWrite, 0, 4096), 100 * kUsec);
+  EXPECT_EQ(timer.schedule_op(SimulatedOpKind::kWrite, 0, 4096), 100 * kUsec);
+  EXPECT_EQ(timer.schedule_op(SimulatedOpKind::kWrite, 0, 4096), 200 * kUsec);
+
+  // An op issued after the device has gone idle doesn't wait.
+  //
+  EXPECT_EQ(timer.schedule_op(SimulatedOpKind::kWrite, 500 * kUsec, 4096), 600 * kUsec);
+
+  const SimulatedDeviceTimingStats stats = timer.stats();
+
+  EXPECT_EQ(stats.reads.op_count, 0u);
+  EXPECT_EQ(stats.writes.op_count, 4u);
+  EXPECT_EQ(stats.writes.byte_count, 4u * 4096);
+  EXPECT_EQ(stats.writes.total_latency_nsec, 500 * kUsec);
+  EXPECT_EQ(stats.writes.max_latency_nsec, 200 * kUsec);
+  EXPECT_EQ(stats.writes.total_queue_wait_nsec, 100 * kUsec);
+  EXPECT_EQ(stats.busy_until_nsec, 600 * kUsec);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(SimulatedDeviceTimerTest, Bandwidth)
+{
+  SimulatedDeviceTimingModel model;
+  model.read_latency.min_nsec = 10 * kUsec;
+  model.read_latency.max_nsec = 10 * kUsec;
+  model.bandwidth_bytes_per_sec = 1000 * 1000;  // 1 byte per usec
+
+  SimulatedDeviceTimer timer{model};
+
+  EXPECT_EQ(timer.schedule_op(SimulatedOpKind::kRead, 0, 1000), 1010 * kUsec);
+  EXPECT_EQ(timer.schedule_op(SimulatedOpKind::kRead, 0, 1000), 2010 * kUsec);
+  EXPECT_EQ(timer.schedule_op(SimulatedOpKind::kRead, 0, 0), 2010 * kUsec);
+
+  EXPECT_EQ(timer.stats().reads.op_count, 3u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(SimulatedDeviceTimerTest, LatencyDistribution)
+{
+  SimulatedDeviceTimingModel model;
+  model.read_latency.min_nsec = 50 * kUsec;
+  model.read_latency.max_nsec = 80 * kUsec;
+  model.read_latency.tail_probability = 0.1;
+  model.read_latency.tail_nsec = 10000 * kUsec;
+  model.queue_depth = 1000;
+  model.seed = 7;
+
+  const auto sample_latencies = [&model] {
+    SimulatedDeviceTimer timer{model};
+    std::vector<u64> latencies;
+    for (usize i = 0; i < 500; ++i) {
+      latencies.emplace_back(timer.schedule_op(SimulatedOpKind::kRead, 0, 512));
+    }
+    return latencies;
+  };
+
+  const std::vector<u64> latencies = sample_latencies();
+
+  usize tail_count = 0;
+  for (u64 latency : latencies) {
+    if (latency >= model.read_latency.tail_nsec) {
+      tail_count += 1;
+      latency -= model.read_latency.tail_nsec;
+    }
+    EXPECT_GE(latency, model.read_latency.min_nsec);
+    EXPECT_LE(latency, model.read_latency.max_nsec);
+  }
+  EXPECT_GT(tail_count, 0u);
+  EXPECT_LT(tail_count, latencies.size() / 2);
+
+  EXPECT_EQ(sample_latencies(), latencies);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(SimulatedDeviceTimingTest, StorageSimulationClock)
+{
+  for (bool timed : {false, true}) {
+    llfs::StorageSimulation sim{batt::StateMachineEntropySource{
+        /*entropy_fn=*/[](usize min_value, usize /*max_value*/) -> usize {
+          return min_value;
+        }}};
+
+    std::unique_ptr<llfs::PageDevice> device =
+        sim.get_page_device("TimedPageDevice", llfs::PageCount{4}, llfs::PageSize{4096});
+
+    if (timed) {
+      SimulatedDeviceTimingModel model;
+      model.write_latency.min_nsec = 100 * kUsec;
+      model.write_latency.max_nsec = 100 * kUsec;
+      model.read_latency.min_nsec = 50 * kUsec;
+      model.read_latency.max_nsec = 50 * kUsec;
+      model.queue_depth = 1;
+
+      sim.set_timing_model(model);
+    }
+
+    sim.run_main_task([&] {
+      const llfs::PageId page_id = device->page_ids().make_page_id(0, 1);
+
+      batt::StatusOr<std::shared_ptr<llfs::PageBuffer>> page_buffer = device->prepare(page_id);
+      ASSERT_TRUE(page_buffer.ok()) << BATT_INSPECT(page_buffer.status());
+
+      batt::Status write_status = batt::Task::await<batt::Status>([&](auto&& handler) {
+        device->write(std::move(*page_buffer), BATT_FORWARD(handler));
+      });
+      ASSERT_TRUE(write_status.ok()) << BATT_INSPECT(write_status);
+
+      EXPECT_EQ(sim.simulated_time_nsec(), timed ? 100 * kUsec : 0u);
+
+      llfs::PageDevice::ReadResult page = device->await_read(page_id);
+      ASSERT_TRUE(page.ok()) << BATT_INSPECT(page.status());
+
+      EXPECT_EQ(sim.simulated_time_nsec(), timed ? 150 * kUsec : 0u);
+    });
+
+    const std::map<std::string, SimulatedDeviceTimingStats> stats = sim.device_timing_stats();
+    if (!timed) {
+      EXPECT_TRUE(stats.empty());
+    } else {
+      ASSERT_EQ(stats.size(), 1u);
+      ASSERT_EQ(stats.count("TimedPageDevice"), 1u);
+
+      const SimulatedDeviceTimingStats& device_stats = stats.at("TimedPageDevice");
+
+      EXPECT_EQ(device_stats.writes.op_count, 1u);
+      EXPECT_EQ(device_stats.reads.op_count, 1u);
+      EXPECT_EQ(device_stats.reads.byte_count, 4096u);
+      EXPECT_EQ(device_stats.busy_until_nsec, 150 * kUsec);
+    }
+
+    device = nullptr;
+  }
+}
+
+}  // namespace
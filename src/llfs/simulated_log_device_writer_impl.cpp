@@ -115,9 +115,15 @@ StatusOr<slot_offset_type> SimulatedLogDevice::Impl::WriterImpl::commit(
     });
 
   } else {
-    // We are not injecting a failure; defer completion of the flush.
+    // We are not injecting a failure; defer completion of the flush (until the simulated time at
+    // which it finishes, if the device has a timing model).
     //
-    sim.post([this, committed_chunk = std::move(committed_chunk)] {
+    const u64 now_nsec = sim.simulated_time_nsec();
+    const u64 flush_at_nsec =
+        this->impl_.schedule_timed_op(SimulatedOpKind::kWrite, now_nsec, byte_count)
+            .value_or(now_nsec);
+
+    sim.post_at(flush_at_nsec, [this, committed_chunk = std::move(committed_chunk)] {
       if (this->impl_.closed_.get_value()) {
         this->impl_.log_event("slot_range ", committed_chunk->slot_range(),
                               " not flushed (device closed)");
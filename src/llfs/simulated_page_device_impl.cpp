@@ -113,6 +113,10 @@ void SimulatedPageDevice::Impl::write(u32 device_create_step,
     return;
   }
 
+  const Optional<u64> completes_at =
+      this->schedule_timed_op(SimulatedOpKind::kWrite, this->simulation_.simulated_time_nsec(),
+                              this->page_size_.value());
+
   auto op = batt::make_shared<MultiBlockOp>(*this);
   {
     const u64 current_step = this->latest_recovery_step_.get_value();
@@ -173,11 +177,11 @@ void SimulatedPageDevice::Impl::write(u32 device_create_step,
           });
     });
   }
-  op->on_completion(
-      [this, page_id, handler = std::move(handler)](const batt::Status& status) mutable {
-        this->log_event("write(", page_id, ") completed with status ", status);
-        std::move(handler)(status);
-      });
+  op->on_completion([this, page_id, completes_at,
+                     handler = std::move(handler)](const batt::Status& status) mutable {
+    this->log_event("write(", page_id, ") completed with status ", status);
+    this->complete_at(completes_at, std::move(handler), status);
+  });
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -203,6 +207,10 @@ void SimulatedPageDevice::Impl::read(u32 device_create_step, PageId page_id,
   std::shared_ptr<PageBuffer> page_buffer = PageBuffer::allocate(this->page_size_, page_id);
   auto op = batt::make_shared<MultiBlockOp>(*this);
 
+  const Optional<u64> completes_at =
+      this->schedule_timed_op(SimulatedOpKind::kRead, this->simulation_.simulated_time_nsec(),
+                              this->page_size_.value());
+
   // We do a piecewise read of each block at a different step so we can simulate the effect
   // of data races at the block device level.
   //
@@ -240,23 +248,27 @@ void SimulatedPageDevice::Impl::read(u32 device_create_step, PageId page_id,
   // success/failure. We succeed entirely or not at all (hence the single call to
   // `inject_failure()` instead of one for each block).
   //
-  op->on_completion([this, page_id,                                     //
+  op->on_completion([this, page_id, completes_at,                       //
                      should_fail = this->simulation_.inject_failure(),  //
                      page_buffer = std::move(page_buffer),              //
                      handler = std::move(handler)](                     //
                         const batt::Status& status) mutable {
+    PageDevice::ReadResult result{batt::StatusCode::kUnknown};
+
     if (!status.ok()) {
       this->log_event("read(", page_id, ") failed with status ", status);
-      std::move(handler)({status});
+      result = status;
 
     } else if (should_fail) {
       this->log_event("read(", page_id, ") -- failure injected (kUnavailable)");
-      std::move(handler)({batt::StatusCode::kUnavailable});
+      result = Status{batt::StatusCode::kUnavailable};
 
     } else {
       this->log_event("read(", page_id, ") ok");
-      std::move(handler)({std::move(page_buffer)});
+      result = std::shared_ptr<const PageBuffer>{std::move(page_buffer)};
     }
+
+    this->complete_at(completes_at, std::move(handler), std::move(result));
   });
 }
 
@@ -280,6 +292,10 @@ void SimulatedPageDevice::Impl::drop(u32 device_create_step, PageId page_id,
     return;
   }
 
+  const Optional<u64> completes_at =
+      this->schedule_timed_op(SimulatedOpKind::kWrite, this->simulation_.simulated_time_nsec(),
+                              /*byte_count=*/0);
+
   auto op = batt::make_shared<MultiBlockOp>(*this);
   {
     const u64 current_step = this->latest_recovery_step_.get_value();
@@ -316,11 +332,11 @@ void SimulatedPageDevice::Impl::drop(u32 device_create_step, PageId page_id,
       });
     });
   }
-  op->on_completion(
-      [this, page_id, handler = std::move(handler)](const batt::Status& status) mutable {
-        this->log_event("drop(", page_id, ") completed with status ", status);
-        std::move(handler)(status);
-      });
+  op->on_completion([this, page_id, completes_at,
+                     handler = std::move(handler)](const batt::Status& status) mutable {
+    this->log_event("drop(", page_id, ") completed with status ", status);
+    this->complete_at(completes_at, std::move(handler), status);
+  });
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -344,6 +360,26 @@ bool SimulatedPageDevice::Impl::validate_physical_page_async(i64 physical_page,
   return true;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename Handler, typename Result>
+void SimulatedPageDevice::Impl::complete_at(const Optional<u64>& completes_at, Handler&& handler,
+                                            Result&& result)
+{
+  if (!completes_at) {
+    std::move(handler)(BATT_FORWARD(result));
+    return;
+  }
+
+  this->log_event(" -- completing at ", *completes_at, "ns (now=",
+                  this->simulation_.simulated_time_nsec(), "ns)");
+
+  this->simulation_.post_at(*completes_at, [handler = std::move(handler),
+                                            result = BATT_FORWARD(result)]() mutable {
+    std::move(handler)(std::move(result));
+  });
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 template <typename Fn>
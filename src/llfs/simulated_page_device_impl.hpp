@@ -178,6 +178,12 @@ class SimulatedPageDevice::Impl : public SimulatedStorageObject
   template <typename Fn = void(i64 block_0, i64 block_i)>
   void for_each_page_block(i64 physical_page, Fn&& fn) const noexcept;
 
+  /** \brief Invokes `handler` with `result` right away if `completes_at` is None (no timing
+   * model); otherwise defers the call until the simulation clock reaches `*completes_at`.
+   */
+  template <typename Handler, typename Result>
+  void complete_at(const Optional<u64>& completes_at, Handler&& handler, Result&& result);
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   StorageSimulation& simulation_;
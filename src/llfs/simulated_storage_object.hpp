@@ -13,6 +13,10 @@
 #include <llfs/config.hpp>
 //
 #include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/simulated_device_timing.hpp>
+
+#include <memory>
 
 namespace llfs {
 
@@ -30,8 +34,47 @@ class SimulatedStorageObject
 
   virtual void crash_and_recover(u64 simulation_step) = 0;
 
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Attaches a timing model to this object (replacing any previous one, and its stats), or
+   * removes it if `model` is None.  Without a timing model, ops complete without advancing the
+   * simulation clock.
+   */
+  void set_timing_model(const Optional<SimulatedDeviceTimingModel>& model)
+  {
+    if (model) {
+      this->timer_ = std::make_unique<SimulatedDeviceTimer>(*model);
+    } else {
+      this->timer_ = nullptr;
+    }
+  }
+
+  /** \brief Returns the simulated-time stats for this object, or None if it has no timing model.
+   */
+  Optional<SimulatedDeviceTimingStats> timing_stats() const
+  {
+    if (!this->timer_) {
+      return None;
+    }
+    return this->timer_->stats();
+  }
+
+  /** \brief Returns the simulated time at which an op issued at `now_nsec` completes, or None if
+   * this object has no timing model.
+   */
+  Optional<u64> schedule_timed_op(SimulatedOpKind kind, u64 now_nsec, usize byte_count)
+  {
+    if (!this->timer_) {
+      return None;
+    }
+    return this->timer_->schedule_op(kind, now_nsec, byte_count);
+  }
+
  protected:
   SimulatedStorageObject() = default;
+
+ private:
+  std::unique_ptr<SimulatedDeviceTimer> timer_;
 };
 
 }  //namespace llfs
@@ -10,6 +10,7 @@
 #ifndef LLFS_SLOT_HPP
 #define LLFS_SLOT_HPP
 
+#include <llfs/coro.hpp>
 #include <llfs/interval.hpp>
 #include <llfs/page_layout.hpp>
 #include <llfs/varint.hpp>
@@ -167,6 +168,18 @@ inline StatusOr<slot_offset_type> await_slot_offset(const slot_offset_type min_o
   });
 }
 
+#if LLFS_HAS_COROUTINES
+// Coroutine version of await_slot_offset.
+//
+inline coro::Task<StatusOr<slot_offset_type>> co_await_slot_offset(
+    const slot_offset_type min_offset, batt::Watch<slot_offset_type>& active_offset)
+{
+  return coro::await_watch(active_offset, [min_offset](slot_offset_type current_offset) {
+    return !slot_less_than(current_offset, min_offset);
+  });
+}
+#endif  // LLFS_HAS_COROUTINES
+
 using SlotRange = Interval<slot_offset_type>;
 
 struct SlotLowerBoundGreater {
@@ -12,6 +12,9 @@
 #include <llfs/logging.hpp>
 #include <llfs/seq.hpp>
 
+#include <algorithm>
+#include <iterator>
+
 namespace llfs {
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -40,13 +43,8 @@ std::ostream& operator<<(std::ostream& out, const SlotIntervalMap::Entry& entry)
 //
 BoxedSeq<SlotIntervalMap::Entry> SlotIntervalMap::to_seq() const
 {
-  return ::llfs::as_seq(this->map_.begin(), this->map_.end())  //
-         | seq::map([](const auto& kv_pair) {
-             return Entry{
-                 .offset_range = kv_pair.first,
-                 .slot = kv_pair.second,
-             };
-           })  //
+  return ::llfs::as_seq(this->entries_.begin(), this->entries_.end())  //
+         | seq::decayed()                                             //
          | seq::boxed();
 }
 
@@ -54,16 +52,16 @@ BoxedSeq<SlotIntervalMap::Entry> SlotIntervalMap::to_seq() const
 //
 std::vector<slot_offset_type> SlotIntervalMap::to_vec() const
 {
-  if (this->map_.empty()) {
+  if (this->entries_.empty()) {
     return {};
   }
 
-  const isize offset_upper_bound = this->map_.rbegin()->first.upper_bound;
+  const isize offset_upper_bound = this->entries_.back().offset_range.upper_bound;
   std::vector<slot_offset_type> values(offset_upper_bound, 0);
 
-  for (auto& [interval, slot] : this->map_) {
-    for (isize i = interval.lower_bound; i < interval.upper_bound; ++i) {
-      values[i] = slot;
+  for (const Entry& entry : this->entries_) {
+    for (isize i = entry.offset_range.lower_bound; i < entry.offset_range.upper_bound; ++i) {
+      values[i] = entry.slot;
     }
   }
 
@@ -72,20 +70,29 @@ std::vector<slot_offset_type> SlotIntervalMap::to_vec() const
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-batt::SmallVec<SlotIntervalMap::Entry, 2> SlotIntervalMap::query(OffsetRange query_offsets) const
+auto SlotIntervalMap::query(OffsetRange query_offsets) const -> QueryResult
 {
-  batt::SmallVec<Entry, 2> result;
+  // The overlapping entries are the ones that end after the query range starts and start before
+  // it ends.
+  //
+  const Entry* const entries_begin = this->entries_.data();
+  const Entry* const entries_end = entries_begin + this->entries_.size();
 
-  auto [first, last] = this->map_.equal_range(query_offsets);
-  for (; first != last; ++first) {
-    const auto& [offsets, slot] = *first;
-    result.emplace_back(Entry{
-        .offset_range = offsets.intersection_with(query_offsets),
-        .slot = slot,
-    });
+  const Entry* first = std::upper_bound(entries_begin, entries_end, query_offsets.lower_bound,
+                                        [](isize offset, const Entry& entry) {
+                                          return offset < entry.offset_range.upper_bound;
+                                        });
+
+  const Entry* last = std::lower_bound(first, entries_end, query_offsets.upper_bound,
+                                       [](const Entry& entry, isize offset) {
+                                         return entry.offset_range.lower_bound < offset;
+                                       });
+
+  if (query_offsets.empty()) {
+    last = first;
   }
 
-  return result;
+  return QueryResult{first, last, query_offsets};
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -100,135 +107,88 @@ void SlotIntervalMap::update(OffsetRange update_offsets, slot_offset_type update
     return;
   }
 
-  auto [first, last] = this->map_.equal_range(update_offsets);
-
-  //----- --- -- -  -  -   -
-  // Check to see whether we can merge the update range with an existing range preceeding or
-  // following.
-
-  // If there is a previous entry whose offset range is adjacent to update_offsets and whose slot
-  // is the same, then remove it and simply adjust the update_offsets to include its offset range.
+  // Find the entries that overlap the update range or are adjacent to it (so they can be merged
+  // with it if their slot ends up being the same).
   //
-  LLFS_DVLOG(1) << " -- Checking for merge-with-prev";
-  if (first != this->map_.begin()) {
-    BATT_CHECK(!this->map_.empty());
-    auto prev = std::prev(first);
-    LLFS_DVLOG(1) << " ---- prev: " << prev->first << " => " << prev->second;
-    if (prev->first.upper_bound == update_offsets.lower_bound && prev->second == update_slot) {
-      update_offsets.lower_bound = prev->first.lower_bound;
-      this->map_.erase(prev);
-      LLFS_DVLOG(1) << " ---- Extending update_offsets: " << update_offsets;
+  const auto first = std::lower_bound(this->entries_.begin(), this->entries_.end(),
+                                      update_offsets.lower_bound,
+                                      [](const Entry& entry, isize offset) {
+                                        return entry.offset_range.upper_bound < offset;
+                                      });
+
+  const auto last = std::upper_bound(first, this->entries_.end(), update_offsets.upper_bound,
+                                     [](isize offset, const Entry& entry) {
+                                       return offset < entry.offset_range.lower_bound;
+                                     });
+
+  // Sweep the touched entries left to right, building their replacement in `scratch_`.
+  //
+  std::vector<Entry>& replacement = this->scratch_;
+  replacement.clear();
+
+  const auto emit = [&replacement](isize lower_bound, isize upper_bound, slot_offset_type slot) {
+    if (lower_bound >= upper_bound) {
+      return;
     }
-  } else {
-    LLFS_DVLOG(1) << " ---- No prev segment";
-  }
+    if (!replacement.empty() && replacement.back().offset_range.upper_bound == lower_bound &&
+        replacement.back().slot == slot) {
+      replacement.back().offset_range.upper_bound = upper_bound;
+      return;
+    }
+    replacement.emplace_back(Entry{
+        .offset_range = OffsetRange{lower_bound, upper_bound},
+        .slot = slot,
+    });
+  };
 
-  // If there is a next entry whose offset range is adjacent to update_offsets and whose slot
-  // is the same, then remove it and simply adjust the update_offsets to include its offset range.
+  // The part of the update range that hasn't been emitted yet starts at `cursor`.
   //
-  LLFS_DVLOG(1) << " -- Checking for merge-with-next";
-  if (last != this->map_.end()) {
-    BATT_CHECK(!this->map_.empty());
-    const bool first_is_last = (first == last);
-    auto next = last;
-    LLFS_DVLOG(1) << " ---- next: " << next->first << " => " << next->second;
-    if (update_offsets.upper_bound == next->first.lower_bound && next->second == update_slot) {
-      update_offsets.upper_bound = next->first.upper_bound;
-      last = this->map_.erase(next);
-      if (first_is_last) {
-        first = last;
-      }
-      LLFS_DVLOG(1) << " ---- Extending update_offsets: " << update_offsets;
-    }
-  } else {
-    LLFS_DVLOG(1) << " ---- No next segment";
-  }
-  //----- --- -- -  -  -   -
+  isize cursor = update_offsets.lower_bound;
+
+  for (auto iter = first; iter != last; ++iter) {
+    const OffsetRange& current_offsets = iter->offset_range;
+    const slot_offset_type current_slot = iter->slot;
+
+    LLFS_DVLOG(1) << "Processing: " << current_offsets << " => " << current_slot << ";"
+                  << BATT_INSPECT(cursor);
 
-  for (;;) {
-    // First handle exit conditions: no more input, no more overlapping/conflicting current state.
+    // The part of the current range before the update range keeps its slot.
     //
-    if (update_offsets.empty()) {
-      LLFS_DVLOG(1) << "Update range is empty; done!";
-      break;
-    }
+    emit(current_offsets.lower_bound, std::min(current_offsets.upper_bound, cursor),
+         current_slot);
 
-    // Second base case: No conflicting ranges exist.
+    // The gap (if any) between the last range and this one gets the update slot.
     //
-    if (first == last) {
-      LLFS_DVLOG(1) << "No more overlapping segments";
-      LLFS_DVLOG(1) << " -- Updateing " << update_offsets << " => " << update_slot;
-      this->map_.emplace_hint(first, update_offsets, update_slot);
-      break;
-    }
+    emit(cursor, std::min(current_offsets.lower_bound, update_offsets.upper_bound), update_slot);
+
+    // The overlap gets whichever slot is higher.
+    //
+    const isize overlap_upper_bound = std::min(current_offsets.upper_bound,
+                                               update_offsets.upper_bound);
+
+    emit(std::max(current_offsets.lower_bound, cursor), overlap_upper_bound,
+         slot_less_than(update_slot, current_slot) ? current_slot : update_slot);
 
-    const auto next = std::next(first);
+    cursor = std::max(cursor, overlap_upper_bound);
 
-    // Unpack the current segment.
+    // The part of the current range after the update range keeps its slot.
     //
-    const auto& [current_offsets, current_slot] = *first;
+    emit(std::max(current_offsets.lower_bound, update_offsets.upper_bound),
+         current_offsets.upper_bound, current_slot);
+  }
 
-    LLFS_DVLOG(1) << "Processing: " << current_offsets << " => " << current_slot << ";"
-                  << BATT_INSPECT(update_offsets);
-
-    if (update_slot == current_slot) {
-      // Adjust the update range to include the current one and remove current from the map.
-      //
-      update_offsets.lower_bound =
-          std::min(update_offsets.lower_bound, current_offsets.lower_bound);
-
-      update_offsets.upper_bound =
-          std::max(update_offsets.upper_bound, current_offsets.upper_bound);
-
-      this->map_.erase(first);
-
-    } else {
-      if (slot_greater_than(update_slot, current_slot)) {
-        // If there are any parts of the current range that don't intersect the update range, we
-        // need to keep the slot as it is.
-        //
-        const batt::SmallVec<OffsetRange, 2> preserve_offsets =
-            current_offsets.without(update_offsets);
-
-        // Save the current slot value for the current range before we remove the current entry from
-        // the map.
-        //
-        const slot_offset_type current_slot_value = current_slot;
-        LLFS_DVLOG(1) << "Removing segment " << current_offsets << " (update_slot is higher)";
-        this->map_.erase(first);
-
-        // Re-update the parts of the current range that are still up-to-date.
-        //
-        for (const OffsetRange& range : preserve_offsets) {
-          LLFS_DVLOG(1) << " -- Preserving segment " << range << " => " << current_slot_value;
-          this->map_.emplace(range, current_slot_value);
-        }
-      } else {
-        BATT_CHECK(slot_less_than(update_slot, current_slot));
-
-        // If there is some non-empty offset range before the current one, update that into the map.
-        //
-        if (update_offsets.lower_bound < current_offsets.lower_bound) {
-          this->map_.emplace(
-              OffsetRange{
-                  .lower_bound = update_offsets.lower_bound,
-                  .upper_bound = current_offsets.lower_bound,
-              },
-              update_slot);
-
-          update_offsets.lower_bound = current_offsets.lower_bound;
-        }
-
-        // Discard the remaining prefix of the update range that overlaps with the existing higher
-        // slot range.
-        //
-        update_offsets.lower_bound =
-            std::min(current_offsets.upper_bound, update_offsets.upper_bound);
-      }
-    }
+  emit(cursor, update_offsets.upper_bound, update_slot);
+
+  // Splice the replacement into the array, shifting the tail only if the number of entries changed.
+  //
+  const usize n_touched = std::distance(first, last);
+  const usize n_common = std::min(n_touched, replacement.size());
 
-    LLFS_DVLOG(1) << "(next segment)" << BATT_INSPECT(update_offsets);
-    first = next;
+  const auto copied_end = std::copy(replacement.begin(), replacement.begin() + n_common, first);
+  if (n_touched > n_common) {
+    this->entries_.erase(copied_end, last);
+  } else {
+    this->entries_.insert(copied_end, replacement.begin() + n_common, replacement.end());
   }
 }
 
@@ -17,7 +17,7 @@
 #include <batteries/interval.hpp>
 #include <batteries/small_vec.hpp>
 
-#include <map>
+#include <iterator>
 #include <vector>
 
 namespace llfs {
@@ -28,6 +28,12 @@ class SlotIntervalMap;
 
 std::ostream& operator<<(std::ostream& out, const SlotIntervalMap& t);
 
+// Maps disjoint offset ranges to slot offsets, keeping (for each offset) the highest slot it has
+// been updated to.  The entries are kept in a sorted flat array, with adjacent ranges that map to
+// the same slot always combined, so queries are a binary search and a linear scan of contiguous
+// memory, and updates don't allocate once the array (and its scratch buffer) have grown to the
+// working size of the map.
+//
 class SlotIntervalMap
 {
  public:
@@ -38,16 +44,114 @@ class SlotIntervalMap
     slot_offset_type slot;
   };
 
+  // The entries of the map that overlap some query range, clipped to that range.  Refers to the
+  // storage of the map, so it is invalidated by the next `update`.
+  //
+  class QueryResult
+  {
+   public:
+    class Iterator
+    {
+     public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = Entry;
+      using difference_type = isize;
+      using pointer = const Entry*;
+      using reference = Entry;
+
+      Iterator(const Entry* entry, OffsetRange query_range) noexcept
+          : entry_{entry}
+          , query_range_{query_range}
+      {
+      }
+
+      Entry operator*() const
+      {
+        return Entry{
+            .offset_range = this->entry_->offset_range.intersection_with(this->query_range_),
+            .slot = this->entry_->slot,
+        };
+      }
+
+      Iterator& operator++()
+      {
+        ++this->entry_;
+        return *this;
+      }
+
+      Iterator operator++(int)
+      {
+        Iterator prev = *this;
+        ++this->entry_;
+        return prev;
+      }
+
+      friend bool operator==(const Iterator& l, const Iterator& r)
+      {
+        return l.entry_ == r.entry_;
+      }
+
+      friend bool operator!=(const Iterator& l, const Iterator& r)
+      {
+        return !(l == r);
+      }
+
+     private:
+      const Entry* entry_;
+      OffsetRange query_range_;
+    };
+
+    QueryResult(const Entry* first, const Entry* last, OffsetRange query_range) noexcept
+        : first_{first}
+        , last_{last}
+        , query_range_{query_range}
+    {
+    }
+
+    Iterator begin() const
+    {
+      return Iterator{this->first_, this->query_range_};
+    }
+
+    Iterator end() const
+    {
+      return Iterator{this->last_, this->query_range_};
+    }
+
+    usize size() const
+    {
+      return this->last_ - this->first_;
+    }
+
+    bool empty() const
+    {
+      return this->first_ == this->last_;
+    }
+
+   private:
+    const Entry* first_;
+    const Entry* last_;
+    OffsetRange query_range_;
+  };
+
   BoxedSeq<Entry> to_seq() const;
 
   std::vector<slot_offset_type> to_vec() const;
 
-  batt::SmallVec<Entry, 2> query(OffsetRange query_range) const;
+  // Returns the entries that overlap `query_range`, in offset order, clipped to `query_range`.
+  //
+  QueryResult query(OffsetRange query_range) const;
 
   void update(OffsetRange update_range, slot_offset_type update_slot);
 
  private:
-  std::map<OffsetRange, slot_offset_type, OffsetRange::LinearOrder> map_;
+  // Sorted by offset; the ranges are non-empty and disjoint.
+  //
+  std::vector<Entry> entries_;
+
+  // Holds the entries that replace the ones touched by `update`, reused to avoid allocating.
+  //
+  std::vector<Entry> scratch_;
 };
 
 std::ostream& operator<<(std::ostream& out, const SlotIntervalMap::Entry& t);
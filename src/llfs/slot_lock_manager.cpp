@@ -9,11 +9,34 @@
 #include <llfs/slot_lock_manager.hpp>
 //
 
+#include <llfs/contention_profiler.hpp>
+#include <llfs/logging.hpp>
+
+#include <batteries/finally.hpp>
+
+#include <algorithm>
+#include <thread>
+
 namespace llfs {
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ usize SlotLockManager::default_shard_count()
+{
+  return std::clamp<usize>(std::thread::hardware_concurrency(), 1, kMaxShardCount);
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 SlotLockManager::SlotLockManager() noexcept
+    : SlotLockManager{SlotLockManager::default_shard_count()}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ SlotLockManager::SlotLockManager(usize shard_count) noexcept
+    : shards_(std::clamp<usize>(shard_count, 1, kMaxShardCount))
 {
 }
 
@@ -23,9 +46,13 @@ SlotLockManager::~SlotLockManager() noexcept
 {
   this->halt();
 
-  auto locked = this->state_.lock();
+  bool all_empty = true;
+  for (batt::CpuCacheLineIsolated<Shard>& shard : this->shards_) {
+    std::unique_lock<std::mutex> lock{shard->mutex};
+    all_empty = all_empty && shard->lock_heap.empty();
+  }
 
-  BATT_CHECK(locked->lock_heap_.empty()) << this->debug_info_locked(locked);
+  BATT_CHECK(all_empty) << this->debug_info();
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -46,6 +73,8 @@ void SlotLockManager::halt()
 //
 slot_offset_type SlotLockManager::get_lower_bound() const
 {
+  this->refresh_lower_bound();
+
   return this->lower_bound_.get_value();
 }
 
@@ -53,14 +82,19 @@ slot_offset_type SlotLockManager::get_lower_bound() const
 //
 slot_offset_type SlotLockManager::get_upper_bound() const
 {
-  auto locked = this->state_.lock();
-  return locked->upper_bound_;
+  return this->upper_bound_.load();
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 StatusOr<slot_offset_type> SlotLockManager::await_lower_bound(slot_offset_type min_offset)
 {
+  // Publish `min_offset` *before* refreshing, so that any lock released after our refresh has
+  // scanned its shard will see it and refresh the lower bound again (see `unlock_slots`).
+  //
+  this->raise_wake_offset(min_offset);
+  this->refresh_lower_bound();
+
   return await_slot_offset(min_offset, this->lower_bound_);
 }
 
@@ -68,55 +102,84 @@ StatusOr<slot_offset_type> SlotLockManager::await_lower_bound(slot_offset_type m
 //
 void SlotLockManager::update_upper_bound(slot_offset_type offset)
 {
-  auto locked = this->state_.lock();
-
-  this->update_upper_bound_locked(locked, /*new_upper_bound=*/offset);
+  this->raise_upper_bound(offset);
+  this->refresh_lower_bound_if_awaited();
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 StatusOr<SlotReadLock> SlotLockManager::lock_slots(const SlotRange& range, const char* holder)
 {
-  (void)holder;
+  const usize shard_index = this->get_shard_index();
+  Shard& shard = *this->shards_[shard_index];
+
+  SlotLockHeap::handle_type handle;
+  {
+    auto lock = LLFS_PROFILE_LOCK_WAIT("SlotLockManager::Shard::mutex",
+                                       std::unique_lock<std::mutex>{shard.mutex});
+
+    if (range.lower_bound < this->lower_bound_.get_value()) {
+      return Status{
+          batt::StatusCode::kOutOfRange};  // TODO [tastolfi 2021-10-20]   "the requested value
+                                           // extends below the current locked slot range"
+    }
 
-  auto locked = this->state_.lock();
+    const usize size_before = shard.lock_heap.size();
 
-  if (range.lower_bound < this->lower_bound_.get_value()) {
-    return Status{
-        batt::StatusCode::kOutOfRange};  // TODO [tastolfi 2021-10-20]   "the requested value
-                                         // extends below the current locked slot range"
-  }
+    handle = shard.lock_heap.push(SlotLockRecord{range.lower_bound, holder});
 
-  const usize size_before = locked->lock_heap_.size();
+    BATT_CHECK_EQ(size_before + 1, shard.lock_heap.size());
 
-  SlotLockHeap::handle_type handle =
-      locked->lock_heap_.push(SlotLockRecord{range.lower_bound, holder});
+    update_shard_min(shard);
+  }
 
-  this->update_lower_bound_locked(locked);
-  this->update_upper_bound_locked(locked, range.upper_bound);
+  // A refresh that scanned this shard before the push above may still publish a lower bound past
+  // `range.lower_bound`.  Any refresh that starts after we see no refresh in progress will see the
+  // new lock, so once that's the case, the lower bound can be checked for the last time.
+  //
+  while (this->refresh_count_.load() != 0) {
+    std::this_thread::yield();
+  }
+  if (range.lower_bound < this->lower_bound_.get_value()) {
+    {
+      auto lock = LLFS_PROFILE_LOCK_WAIT("SlotLockManager::Shard::mutex",
+                                         std::unique_lock<std::mutex>{shard.mutex});
+      shard.lock_heap.erase(handle);
+      update_shard_min(shard);
+    }
+    return Status{batt::StatusCode::kOutOfRange};
+  }
 
-  BATT_CHECK_EQ(size_before + 1, locked->lock_heap_.size());
+  // Adding a lock can never raise the lower bound, so there is no need to refresh it here.
+  //
+  this->raise_upper_bound(range.upper_bound);
 
-  return SlotReadLock{/*sponsor=*/this, range, handle};
+  return SlotReadLock{/*sponsor=*/this, range, handle, /*upper_bound_updated=*/false, shard_index};
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 void SlotLockManager::unlock_slots(SlotReadLock* read_lock)
 {
-  auto locked = this->state_.lock();
+  Shard& shard = *this->shards_[read_lock->shard_index()];
+  {
+    auto lock = LLFS_PROFILE_LOCK_WAIT("SlotLockManager::Shard::mutex",
+                                       std::unique_lock<std::mutex>{shard.mutex});
 
-  const usize size_before = locked->lock_heap_.size();
-  BATT_CHECK_GT(size_before, 0u);
+    const usize size_before = shard.lock_heap.size();
+    BATT_CHECK_GT(size_before, 0u);
 
-  locked->lock_heap_.erase(read_lock->release());
+    shard.lock_heap.erase(read_lock->release());
 
-  this->update_lower_bound_locked(locked);
-  if (read_lock->is_upper_bound_updated()) {
-    this->update_upper_bound_locked(locked, read_lock->slot_range().upper_bound);
+    BATT_CHECK_EQ(size_before - 1, shard.lock_heap.size());
+
+    update_shard_min(shard);
   }
 
-  BATT_CHECK_EQ(size_before - 1, locked->lock_heap_.size());
+  if (read_lock->is_upper_bound_updated()) {
+    this->raise_upper_bound(read_lock->slot_range().upper_bound);
+  }
+  this->refresh_lower_bound_if_awaited();
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -128,44 +191,53 @@ StatusOr<SlotReadLock> SlotLockManager::update_lock(SlotReadLock old_lock,
   BATT_CHECK_GE(new_range.lower_bound, old_lock.slot_range().lower_bound)
       << "The locked lower bound must increase monotonically" << BATT_INSPECT(holder);
 
-  auto locked = this->state_.lock();
-
-  const usize size_before = locked->lock_heap_.size();
+  const usize shard_index = old_lock.shard_index();
+  Shard& shard = *this->shards_[shard_index];
 
   auto handle = old_lock.release();
-  locked->lock_heap_.update(handle, SlotLockRecord{new_range.lower_bound, holder});
+  {
+    auto lock = LLFS_PROFILE_LOCK_WAIT("SlotLockManager::Shard::mutex",
+                                       std::unique_lock<std::mutex>{shard.mutex});
 
-  this->update_lower_bound_locked(locked);
-  this->update_upper_bound_locked(locked, new_range.upper_bound);
+    const usize size_before = shard.lock_heap.size();
 
-  BATT_CHECK_EQ(size_before, locked->lock_heap_.size());
+    shard.lock_heap.update(handle, SlotLockRecord{new_range.lower_bound, holder});
 
-  return SlotReadLock{/*sponsor=*/this, new_range, handle};
-}
+    BATT_CHECK_EQ(size_before, shard.lock_heap.size());
 
-//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
-//
-std::function<void(std::ostream&)> SlotLockManager::debug_info()
-{
-  auto locked = this->state_.lock();
+    update_shard_min(shard);
+  }
+
+  this->raise_upper_bound(new_range.upper_bound);
+  this->refresh_lower_bound_if_awaited();
 
-  return this->debug_info_locked(locked);
+  return SlotReadLock{/*sponsor=*/this, new_range, handle, /*upper_bound_updated=*/false,
+                      shard_index};
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-std::function<void(std::ostream&)> SlotLockManager::debug_info_locked(
-    batt::Mutex<State>::Lock& locked)
+std::function<void(std::ostream&)> SlotLockManager::debug_info()
 {
+  std::vector<SlotLockRecord> locked_slots_copy;
+  for (batt::CpuCacheLineIsolated<Shard>& shard : this->shards_) {
+    std::unique_lock<std::mutex> lock{shard->mutex};
+    locked_slots_copy.insert(locked_slots_copy.end(), shard->lock_heap.ordered_begin(),
+                             shard->lock_heap.ordered_end());
+  }
+  std::stable_sort(locked_slots_copy.begin(), locked_slots_copy.end(),
+                   [](const SlotLockRecord& left, const SlotLockRecord& right) {
+                     return slot_less_than(left.slot_offset, right.slot_offset);
+                   });
+
   Optional<SlotLockRecord> top_copy;
-  if (!locked->lock_heap_.empty()) {
-    top_copy = locked->lock_heap_.top();
+  if (!locked_slots_copy.empty()) {
+    top_copy = locked_slots_copy.front();
   }
-  std::vector<SlotLockRecord> locked_slots_copy(locked->lock_heap_.ordered_begin(),
-                                                locked->lock_heap_.ordered_end());
 
   return [locked_slots_copy = std::move(locked_slots_copy),
-          lower_bound_copy = this->lower_bound_.get_value(), top_copy](std::ostream& out) {
+          lower_bound_copy = this->lower_bound_.get_value(), top_copy,
+          shard_count = this->shards_.size()](std::ostream& out) {
     out << "SlotLockManager{.lower_bound=" << lower_bound_copy << ", .acquired=[";
     {
       int limit = 10;
@@ -181,37 +253,107 @@ std::function<void(std::ostream&)> SlotLockManager::debug_info_locked(
         }
       }
     }
-    out << "; size=" << locked_slots_copy.size() << "], .top=" << top_copy << "}";
+    out << "; size=" << locked_slots_copy.size() << "], .top=" << top_copy
+        << ", .shard_count=" << shard_count << "}";
   };
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-void SlotLockManager::update_lower_bound_locked(batt::Mutex<State>::Lock& locked)
+usize SlotLockManager::get_shard_index() const
+{
+  // Each thread is assigned a fixed index the first time it takes a lock, round-robin, so that
+  // threads in a pool are spread evenly across the shards.
+  //
+  static std::atomic<usize> next_thread_index{0};
+  thread_local const usize thread_index = next_thread_index.fetch_add(1);
+
+  return thread_index % this->shards_.size();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ void SlotLockManager::update_shard_min(Shard& shard)
 {
-  if (!locked->lock_heap_.empty()) {
-    const slot_offset_type trim_pos = get_slot_offset(locked->lock_heap_.top());
-    LLFS_DVLOG(1) << BATT_INSPECT((void*)this) << BATT_INSPECT(trim_pos);
-    BATT_CHECK_GE(trim_pos, this->lower_bound_.get_value())
-        << "the locked lower bound must never move backwards!";
-    this->lower_bound_.set_value(trim_pos);
+  if (shard.lock_heap.empty()) {
+    shard.has_locks.store(false);
   } else {
-    this->lower_bound_.modify([&locked](slot_offset_type old_lower_bound) {
-      return slot_max(locked->upper_bound_, old_lower_bound);
-    });
+    shard.min_offset.store(get_slot_offset(shard.lock_heap.top()));
+    shard.has_locks.store(true);
   }
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-void SlotLockManager::update_upper_bound_locked(batt::Mutex<State>::Lock& locked,
-                                                slot_offset_type new_upper_bound)
+void SlotLockManager::refresh_lower_bound() const
 {
-  locked->upper_bound_ = slot_max(new_upper_bound, locked->upper_bound_);
-  if (locked->lock_heap_.empty()) {
-    this->lower_bound_.modify([new_upper_bound](slot_offset_type old_lower_bound) {
-      return slot_max(new_upper_bound, old_lower_bound);
-    });
+  // No shard mutex is taken here; see `lock_slots` for how new locks are kept from ending up below
+  // the lower bound published by a concurrent refresh.
+  //
+  this->refresh_count_.fetch_add(1);
+  const auto on_return = batt::finally([this] {
+    this->refresh_count_.fetch_sub(1);
+  });
+
+  // Read the upper bound first: if there are no locks below it now, any lock acquired later is at
+  // or above it (it is checked against a lower bound that is at least as new).
+  //
+  const slot_offset_type upper_bound = this->upper_bound_.load();
+
+  Optional<slot_offset_type> min_locked_offset;
+  for (const batt::CpuCacheLineIsolated<Shard>& shard : this->shards_) {
+    if (shard->has_locks.load()) {
+      const slot_offset_type shard_min = shard->min_offset.load();
+      if (!min_locked_offset || slot_less_than(shard_min, *min_locked_offset)) {
+        min_locked_offset = shard_min;
+      }
+    }
+  }
+
+  // The cached minimums may be stale, and another refresh may already have published a greater
+  // value; the lower bound never moves backwards.
+  //
+  const slot_offset_type new_lower_bound = min_locked_offset.value_or(upper_bound);
+  LLFS_DVLOG(1) << BATT_INSPECT((void*)this) << BATT_INSPECT(new_lower_bound);
+
+  this->lower_bound_.modify([new_lower_bound](slot_offset_type old_lower_bound) {
+    return slot_max(new_lower_bound, old_lower_bound);
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void SlotLockManager::refresh_lower_bound_if_awaited() const
+{
+  // If no task is waiting for the lower bound to move past its current value, then refreshing can
+  // be put off until the next time the lower bound is read.
+  //
+  if (slot_less_than(this->lower_bound_.get_value(), this->wake_offset_.load())) {
+    this->refresh_lower_bound();
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void SlotLockManager::raise_wake_offset(slot_offset_type min_offset)
+{
+  slot_offset_type observed = this->wake_offset_.load();
+  while (slot_less_than(observed, min_offset)) {
+    if (this->wake_offset_.compare_exchange_weak(observed, min_offset)) {
+      break;
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void SlotLockManager::raise_upper_bound(slot_offset_type new_upper_bound)
+{
+  slot_offset_type observed = this->upper_bound_.load();
+  while (slot_less_than(observed, new_upper_bound)) {
+    if (this->upper_bound_.compare_exchange_weak(observed, new_upper_bound)) {
+      break;
+    }
   }
 }
 
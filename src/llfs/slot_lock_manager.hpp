@@ -10,20 +10,49 @@
 #ifndef LLFS_SLOT_LOCK_MANAGER_HPP
 #define LLFS_SLOT_LOCK_MANAGER_HPP
 
+#include <llfs/int_types.hpp>
 #include <llfs/slot_read_lock.hpp>
 
-#include <batteries/async/mutex.hpp>
 #include <batteries/async/watch.hpp>
+#include <batteries/cpu_align.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
 
 namespace llfs {
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 //
+// Active locks are spread over a number of shards, each with its own mutex and lock heap (isolated
+// on its own cache line), so that concurrent readers on different threads don't contend on a single
+// mutex.  Each thread always uses the same shard.
+//
+// Each shard caches the lowest offset in its heap in an atomic, updated under the shard mutex.  The
+// locked lower bound is only recalculated (from these cached minimums, without taking any shard
+// mutex) when it is needed: when it is read via `get_lower_bound()`, when a task starts waiting on
+// it, or when a lock is released that could be holding back a waiting task.  In between, the
+// published lower bound may lag behind the true minimum of the active locks; it is always safe,
+// though, since it never exceeds the lowest locked offset.
+//
 class SlotLockManager : public SlotReadLock::Sponsor
 {
  public:
+  // The maximum number of lock shards.
+  //
+  static constexpr usize kMaxShardCount = 64;
+
+  // Returns the default number of lock shards: the number of hardware threads (capped at
+  // kMaxShardCount).
+  //
+  static usize default_shard_count();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
   SlotLockManager() noexcept;
 
+  explicit SlotLockManager(usize shard_count) noexcept;
+
   ~SlotLockManager() noexcept;
 
   // Returns true if `halt()` has been called.
@@ -93,29 +122,70 @@ class SlotLockManager : public SlotReadLock::Sponsor
   SlotReadLock clone_lock(const SlotReadLock* lock) override;
 
  private:
-  struct State {
-    // All active locks.
+  struct Shard {
+    // Protects `lock_heap`.
     //
-    SlotLockHeap lock_heap_;
+    std::mutex mutex;
 
-    // The current slot upper bound.
+    // The active locks acquired through this shard.
     //
-    slot_offset_type upper_bound_ = 0;
+    SlotLockHeap lock_heap;
 
-    //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+    // Whether `lock_heap` is non-empty, and the offset at its top; only modified while `mutex` is
+    // held, but read without it.
+    //
+    std::atomic<bool> has_locks{false};
+    std::atomic<slot_offset_type> min_offset{0};
   };
 
-  std::function<void(std::ostream&)> debug_info_locked(batt::Mutex<State>::Lock& locked);
+  // Returns the index of the shard used by the calling thread.
+  //
+  usize get_shard_index() const;
 
   void unlock_slots(SlotReadLock*) override;
 
-  void update_lower_bound_locked(batt::Mutex<State>::Lock& locked);
+  // Updates the cached minimum of `shard` from its heap; `shard.mutex` must be held.
+  //
+  static void update_shard_min(Shard& shard);
+
+  // Recalculates the locked lower bound from all the shards.
+  //
+  void refresh_lower_bound() const;
+
+  // Refreshes the lower bound if a task may be waiting for it to advance.
+  //
+  void refresh_lower_bound_if_awaited() const;
+
+  // Makes sure that releasing any lock below `min_offset` refreshes the lower bound.
+  //
+  void raise_wake_offset(slot_offset_type min_offset);
+
+  // Atomically updates `upper_bound_` to the greater of its current value and `new_upper_bound`.
+  //
+  void raise_upper_bound(slot_offset_type new_upper_bound);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
 
-  void update_upper_bound_locked(batt::Mutex<State>::Lock& locked,
-                                 slot_offset_type new_upper_bound);
+  std::vector<batt::CpuCacheLineIsolated<Shard>> shards_;
 
-  batt::Mutex<State> state_;
-  batt::Watch<slot_offset_type> lower_bound_{0};
+  // The current slot upper bound.
+  //
+  std::atomic<slot_offset_type> upper_bound_{0};
+
+  // The greatest offset passed to `await_lower_bound`; once the lower bound reaches this, releases
+  // no longer need to refresh it.
+  //
+  std::atomic<slot_offset_type> wake_offset_{0};
+
+  // The number of `refresh_lower_bound` calls in progress.  A new lock waits for this to drop to
+  // zero before its final check against the lower bound, so that it either is seen by a refresh or
+  // sees that refresh's result.
+  //
+  mutable std::atomic<usize> refresh_count_{0};
+
+  // The published locked lower bound.
+  //
+  mutable batt::Watch<slot_offset_type> lower_bound_{0};
 };
 
 }  // namespace llfs
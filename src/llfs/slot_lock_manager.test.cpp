@@ -13,8 +13,26 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
 namespace {
 
+// Test Plan:
+//
+//  1. The lower bound is the least locked offset while locks are held, and the upper bound once all
+//     locks are released.
+//  2. Locking a range below the lower bound fails.
+//  3. update_lock moves the lower bound forward.
+//  4. await_lower_bound returns once the blocking locks are released (from other threads).
+//  5. Many threads locking/unlocking concurrently never see the lower bound move backwards or
+//     exceed a lock they hold.
+//
+
+using namespace llfs::int_types;
+
 using ::testing::Eq;
 
 TEST(SlotLockManagerTest, AllInputs)
@@ -24,4 +42,176 @@ TEST(SlotLockManagerTest, AllInputs)
   EXPECT_THAT(mgr.get_lower_bound(), Eq(0u));
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  1. Lower/upper bounds.
+//
+TEST(SlotLockManagerTest, LockedRange)
+{
+  for (usize shard_count : {1, 4}) {
+    llfs::SlotLockManager mgr{shard_count};
+
+    llfs::StatusOr<llfs::SlotReadLock> lock1 = mgr.lock_slots(llfs::SlotRange{10, 20}, "lock1");
+    ASSERT_TRUE(lock1.ok());
+
+    EXPECT_EQ(mgr.get_lower_bound(), 10u);
+    EXPECT_EQ(mgr.get_upper_bound(), 20u);
+
+    llfs::StatusOr<llfs::SlotReadLock> lock2 = mgr.lock_slots(llfs::SlotRange{15, 40}, "lock2");
+    ASSERT_TRUE(lock2.ok());
+
+    EXPECT_EQ(mgr.get_locked_range(), (llfs::SlotRange{10, 40}));
+
+    *lock1 = llfs::SlotReadLock{};
+    EXPECT_EQ(mgr.get_lower_bound(), 15u);
+
+    *lock2 = llfs::SlotReadLock{};
+    EXPECT_EQ(mgr.get_lower_bound(), 40u);
+
+    mgr.update_upper_bound(100);
+    EXPECT_EQ(mgr.get_locked_range(), (llfs::SlotRange{100, 100}));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  2. Locking below the lower bound.
+//
+TEST(SlotLockManagerTest, LockBelowLowerBound)
+{
+  llfs::SlotLockManager mgr{2};
+
+  mgr.update_upper_bound(50);
+  EXPECT_EQ(mgr.get_lower_bound(), 50u);
+
+  llfs::StatusOr<llfs::SlotReadLock> lock = mgr.lock_slots(llfs::SlotRange{49, 60}, "below");
+  EXPECT_EQ(lock.status(), batt::StatusCode::kOutOfRange);
+
+  lock = mgr.lock_slots(llfs::SlotRange{50, 60}, "at");
+  EXPECT_TRUE(lock.ok());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  3. update_lock.
+//
+TEST(SlotLockManagerTest, UpdateLock)
+{
+  llfs::SlotLockManager mgr{3};
+
+  llfs::StatusOr<llfs::SlotReadLock> lock = mgr.lock_slots(llfs::SlotRange{0, 10}, "lock");
+  ASSERT_TRUE(lock.ok());
+
+  llfs::StatusOr<llfs::SlotReadLock> updated =
+      mgr.update_lock(std::move(*lock), llfs::SlotRange{5, 30}, "updated");
+  ASSERT_TRUE(updated.ok());
+
+  EXPECT_EQ(mgr.get_locked_range(), (llfs::SlotRange{5, 30}));
+
+  llfs::SlotReadLock cloned = updated->clone();
+  *updated = llfs::SlotReadLock{};
+  EXPECT_EQ(mgr.get_lower_bound(), 5u);
+
+  cloned = llfs::SlotReadLock{};
+  EXPECT_EQ(mgr.get_lower_bound(), 30u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  4. await_lower_bound.
+//
+TEST(SlotLockManagerTest, AwaitLowerBound)
+{
+  constexpr usize kNumLocks = 8;
+
+  llfs::SlotLockManager mgr{4};
+  mgr.update_upper_bound(100);
+
+  std::vector<llfs::SlotReadLock> locks;
+  for (usize i = 0; i < kNumLocks; ++i) {
+    llfs::StatusOr<llfs::SlotReadLock> lock =
+        mgr.lock_slots(llfs::SlotRange{100 + i * 10, 200}, "await");
+    ASSERT_TRUE(lock.ok());
+    locks.emplace_back(std::move(*lock));
+  }
+
+  std::atomic<bool> done{false};
+  std::thread waiter{[&] {
+    llfs::StatusOr<llfs::slot_offset_type> lower_bound = mgr.await_lower_bound(150);
+    EXPECT_TRUE(lower_bound.ok());
+    if (lower_bound.ok()) {
+      EXPECT_GE(*lower_bound, 150u);
+    }
+    done = true;
+  }};
+
+  // Release the locks from threads other than the waiter and the one that acquired them.
+  //
+  std::vector<std::thread> releasers;
+  for (usize i = 0; i < kNumLocks; ++i) {
+    releasers.emplace_back([lock = std::move(locks[i])]() mutable {
+      lock = llfs::SlotReadLock{};
+    });
+  }
+  for (std::thread& t : releasers) {
+    t.join();
+  }
+
+  waiter.join();
+
+  EXPECT_TRUE(done);
+  EXPECT_EQ(mgr.get_lower_bound(), 200u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  5. Concurrent lock/unlock.
+//
+TEST(SlotLockManagerTest, ConcurrentLockUnlock)
+{
+  const usize kNumThreads = std::max<usize>(4, std::thread::hardware_concurrency());
+  constexpr usize kNumIterations = 5000;
+
+  llfs::SlotLockManager mgr;
+  std::atomic<llfs::slot_offset_type> next_offset{0};
+
+  std::vector<std::thread> threads;
+  for (usize thread_i = 0; thread_i < kNumThreads; ++thread_i) {
+    threads.emplace_back([&, thread_i] {
+      std::default_random_engine rng{thread_i};
+      std::uniform_int_distribution<usize> pick_count{1, 4};
+      llfs::slot_offset_type prev_lower_bound = 0;
+
+      for (usize i = 0; i < kNumIterations; ++i) {
+        std::vector<llfs::SlotReadLock> held;
+        const usize count = pick_count(rng);
+        for (usize j = 0; j < count; ++j) {
+          const llfs::slot_offset_type offset = next_offset.fetch_add(1);
+          mgr.update_upper_bound(offset);
+
+          // The lower bound may advance between reading it and locking; if so, try again.
+          //
+          for (;;) {
+            llfs::StatusOr<llfs::SlotReadLock> lock =
+                mgr.lock_slots(llfs::SlotRange{mgr.get_lower_bound(), offset + 1}, "stress");
+            if (lock.ok()) {
+              held.emplace_back(std::move(*lock));
+              break;
+            }
+            ASSERT_EQ(lock.status(), batt::StatusCode::kOutOfRange);
+          }
+        }
+
+        const llfs::slot_offset_type lower_bound = mgr.get_lower_bound();
+        EXPECT_GE(lower_bound, prev_lower_bound);
+        for (const llfs::SlotReadLock& lock : held) {
+          EXPECT_LE(lower_bound, lock.slot_range().lower_bound);
+        }
+        prev_lower_bound = lower_bound;
+      }
+    });
+  }
+
+  for (std::thread& t : threads) {
+    t.join();
+  }
+
+  EXPECT_EQ(mgr.get_locked_range(), (llfs::SlotRange{next_offset.load(), next_offset.load()}));
+}
+
 }  // namespace
@@ -10,6 +10,7 @@
 #ifndef LLFS_SLOT_READ_LOCK_HPP
 #define LLFS_SLOT_READ_LOCK_HPP
 
+#include <llfs/int_types.hpp>
 #include <llfs/pointers.hpp>
 #include <llfs/slot.hpp>
 
@@ -91,7 +92,7 @@ class SlotReadLock
       SlotReadLock clone_lock(const SlotReadLock* lock) override
       {
         return SlotReadLock{/*sponsor=*/this, lock->range_, lock->handle_,
-                            lock->upper_bound_updated_};
+                            lock->upper_bound_updated_, lock->shard_index_};
       }
     };
 
@@ -106,11 +107,12 @@ class SlotReadLock
 
   explicit SlotReadLock(Sponsor* sponsor, const SlotRange& range,
                         const SlotLockHeap::handle_type& handle,
-                        bool upper_bound_updated = false) noexcept
+                        bool upper_bound_updated = false, usize shard_index = 0) noexcept
       : sponsor_{sponsor}
       , range_{range}
       , handle_{handle}
       , upper_bound_updated_{upper_bound_updated}
+      , shard_index_{shard_index}
   {
   }
 
@@ -142,6 +144,13 @@ class SlotReadLock
     return this->upper_bound_updated_;
   }
 
+  // Identifies which of the sponsor's lock heaps (if it has more than one) holds `handle_`.
+  //
+  usize shard_index() const
+  {
+    return this->shard_index_;
+  }
+
   [[nodiscard]] SlotLockHeap::handle_type release()
   {
     this->sponsor_ = nullptr;
@@ -169,10 +178,12 @@ class SlotReadLock
       , range_{std::move(other.range_)}
       , handle_{std::move(other.handle_)}
       , upper_bound_updated_{other.upper_bound_updated_}
+      , shard_index_{other.shard_index_}
   {
     other.range_ = SlotRange{};
     other.handle_ = SlotLockHeap::handle_type{};
     other.upper_bound_updated_ = false;
+    other.shard_index_ = 0;
   }
 
   SlotReadLock& operator=(SlotReadLock&& other) noexcept
@@ -183,10 +194,12 @@ class SlotReadLock
       this->range_ = std::move(other.range_);
       this->handle_ = std::move(other.handle_);
       this->upper_bound_updated_ = other.upper_bound_updated_;
+      this->shard_index_ = other.shard_index_;
 
       other.range_ = SlotRange{};
       other.handle_ = SlotLockHeap::handle_type{};
       other.upper_bound_updated_ = false;
+      other.shard_index_ = 0;
     }
     return *this;
   }
@@ -196,6 +209,7 @@ class SlotReadLock
   SlotRange range_{0, 0};
   SlotLockHeap::handle_type handle_;
   bool upper_bound_updated_;
+  usize shard_index_ = 0;
 };
 
 }  // namespace llfs
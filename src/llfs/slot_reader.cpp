@@ -88,7 +88,6 @@ StatusOr<SlotParse> SlotReader::parse_next(batt::WaitForResource wait_for_data)
     min_bytes_needed = 0;
 
     ConstBuffer data = this->log_reader_.data();
-    DataReader data_reader{data};
     const slot_offset_type current_slot = this->log_reader_.slot_offset();
 
     BATT_CHECK_EQ(current_slot, this->consumed_upper_bound_.get_value());
@@ -99,55 +98,108 @@ StatusOr<SlotParse> SlotReader::parse_next(batt::WaitForResource wait_for_data)
       return {batt::StatusCode::kLoopBreak};
     }
 
-    // Save the reader position before parsing a varint so we know how large the varint was.  This
-    // is necessary because we can't count on varints being packed in a minimal fashion.
-    //
-    const usize bytes_available_before = data_reader.bytes_available();
-
-    Optional<u64> slot_body_size = data_reader.read_varint();
-    if (!slot_body_size) {
-      min_bytes_needed = data.size() + 1;
-      continue;
-    }
-    const usize bytes_available_after = data_reader.bytes_available();
-
-    BATT_CHECK_NE(*slot_body_size, 0u)
-        << BATT_INSPECT(bytes_available_before) << BATT_INSPECT(bytes_available_after)
-        << BATT_INSPECT(current_slot) << BATT_INSPECT(data.size())
-        << BATT_INSPECT(current_slot + data.size()) << BATT_INSPECT(this->slots_parsed_count_);
-
-    // Calculate the header (varint) size from bytes available before and after.
-    //
-    BATT_CHECK_GT(bytes_available_before, bytes_available_after);
-    const usize slot_header_size = bytes_available_before - bytes_available_after;
-    const usize slot_size = slot_header_size + *slot_body_size;
-
-    // Read the specified number of bytes; if this results in a short-read, then return false to
-    // signal that we need more data.
-    //
-    std::string_view slot_body = data_reader.read_raw(*slot_body_size);
-    if (slot_body.size() < *slot_body_size) {
-      min_bytes_needed = data.size() + (*slot_body_size - slot_body.size());
+    Optional<SlotParse> slot = this->parse_slot(data, current_slot, &min_bytes_needed);
+    if (!slot) {
       continue;
     }
 
-    BATT_CHECK_EQ(slot_body.size(), slot_body_size);
-
-    // Initialize the slot_range according to the log reader's offset attribute; we will update
-    // `upper_bound` inside the variant visitor passed to `DataReader::read_variant`.
-    //
-    return SlotParse{
-        .offset =
-            SlotRange{
-                .lower_bound = current_slot,
-                .upper_bound = current_slot + slot_size,
-            },
-        .body = slot_body,
-        .total_grant_spent = slot_size,
-    };
+    return *slot;
   }
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<SlotParse> SlotReader::parse_slot(const ConstBuffer& data, slot_offset_type slot_offset,
+                                           usize* min_bytes_needed) const
+{
+  DataReader data_reader{data};
+
+  // Save the reader position before parsing a varint so we know how large the varint was.  This
+  // is necessary because we can't count on varints being packed in a minimal fashion.
+  //
+  const usize bytes_available_before = data_reader.bytes_available();
+
+  Optional<u64> slot_body_size = data_reader.read_varint();
+  if (!slot_body_size) {
+    *min_bytes_needed = data.size() + 1;
+    return None;
+  }
+  const usize bytes_available_after = data_reader.bytes_available();
+
+  BATT_CHECK_NE(*slot_body_size, 0u)
+      << BATT_INSPECT(bytes_available_before) << BATT_INSPECT(bytes_available_after)
+      << BATT_INSPECT(slot_offset) << BATT_INSPECT(data.size())
+      << BATT_INSPECT(slot_offset + data.size()) << BATT_INSPECT(this->slots_parsed_count_);
+
+  // Calculate the header (varint) size from bytes available before and after.
+  //
+  BATT_CHECK_GT(bytes_available_before, bytes_available_after);
+  const usize slot_header_size = bytes_available_before - bytes_available_after;
+  const usize slot_size = slot_header_size + *slot_body_size;
+
+  // Read the specified number of bytes; if this results in a short-read, then return None to
+  // signal that we need more data.
+  //
+  std::string_view slot_body = data_reader.read_raw(*slot_body_size);
+  if (slot_body.size() < *slot_body_size) {
+    *min_bytes_needed = data.size() + (*slot_body_size - slot_body.size());
+    return None;
+  }
+
+  BATT_CHECK_EQ(slot_body.size(), slot_body_size);
+
+  return SlotParse{
+      .offset =
+          SlotRange{
+              .lower_bound = slot_offset,
+              .upper_bound = slot_offset + slot_size,
+          },
+      .body = slot_body,
+      .total_grant_spent = slot_size,
+  };
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void SlotReader::parse_batch(const SlotParse& first_slot, usize max_batch_size)
+{
+  this->batch_.clear();
+  this->batch_.emplace_back(first_slot);
+
+  // Only parse the slots that are already in the log reader's buffer (past the first slot); we
+  // never wait for more data here, since a partial batch can be delivered right away.
+  //
+  const ConstBuffer data = this->log_reader_.data();
+  usize batch_size_in_bytes = first_slot.offset.size();
+  usize min_bytes_needed = 0;
+
+  while (this->batch_.size() < max_batch_size && batch_size_in_bytes < data.size()) {
+    Optional<SlotParse> slot =
+        this->parse_slot(data + batch_size_in_bytes,
+                         first_slot.offset.lower_bound + batch_size_in_bytes, &min_bytes_needed);
+    if (!slot) {
+      break;
+    }
+    batch_size_in_bytes += slot->offset.size();
+    this->batch_.emplace_back(*slot);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void SlotReader::consume_batch()
+{
+  BATT_CHECK(!this->batch_.empty());
+
+  const usize batch_size_in_bytes =
+      this->batch_.back().offset.upper_bound - this->batch_.front().offset.lower_bound;
+
+  LLFS_VLOG(1) << "log_reader.consume(" << batch_size_in_bytes << ")";
+  this->log_reader_.consume(batch_size_in_bytes);
+  this->consumed_upper_bound_.fetch_add(batch_size_in_bytes);
+  this->batch_.clear();
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 void SlotReader::consume_slot(const SlotParse& slot)
@@ -13,7 +13,9 @@
 #include <llfs/buffer.hpp>
 #include <llfs/data_reader.hpp>
 #include <llfs/log_device.hpp>
+#include <llfs/optional.hpp>
 #include <llfs/seq.hpp>
+#include <llfs/slice.hpp>
 #include <llfs/slot_parse.hpp>
 
 #include <batteries/async/types.hpp>
@@ -22,6 +24,7 @@
 #include <llfs/logging.hpp>
 
 #include <functional>
+#include <vector>
 
 namespace llfs {
 
@@ -100,10 +103,7 @@ class SlotReader
 
     for (;;) {
       StatusOr<SlotParse> parsed = this->parse_next(wait_for_data);
-      if (!parsed.ok() && ((parsed.status() == batt::StatusCode::kLoopBreak) ||
-                           (parsed.status() == StatusCode::kBreakSlotReaderLoop) ||
-                           (parsed.status() == StatusCode::kSlotReaderOutOfData &&
-                            wait_for_data == batt::WaitForResource::kFalse))) {
+      if (is_end_of_run(parsed.status(), wait_for_data)) {
         break;
       }
       BATT_REQUIRE_OK(parsed);
@@ -120,13 +120,82 @@ class SlotReader
     return slot_count;
   }
 
+  // Like `run`, except that `visitor` is passed batches of consecutive slots instead of one slot at
+  // a time.  Each batch contains at least one and at most `max_batch_size` slots, all of which
+  // point directly into the log reader's current buffer; the slots in a batch are consumed
+  // together after `visitor` returns, so they are only valid until then.  A batch is never delayed
+  // waiting for more slots to fill it.
+  //
+  // If `visitor` returns a non-ok status, none of the slots in the batch are consumed.
+  //
+  template <typename /*Status(const Slice<const SlotParse>&)*/ BatchVisitorFn>
+  StatusOr<usize> run_batches(batt::WaitForResource wait_for_data, usize max_batch_size,
+                              BatchVisitorFn&& visitor)
+  {
+    [[maybe_unused]] static const bool b = ::llfs::initialize_status_codes();
+
+    BATT_DEBUG_INFO("SlotReader::run_batches()");
+    BATT_CHECK_GT(max_batch_size, 0u);
+
+    usize slot_count = 0;
+
+    this->consumed_upper_bound_.set_value(this->log_reader_.slot_offset());
+
+    for (;;) {
+      StatusOr<SlotParse> parsed = this->parse_next(wait_for_data);
+      if (is_end_of_run(parsed.status(), wait_for_data)) {
+        break;
+      }
+      BATT_REQUIRE_OK(parsed);
+
+      this->parse_batch(*parsed, max_batch_size);
+
+      const usize batch_size = this->batch_.size();
+      this->slots_parsed_count_ += batch_size;
+
+      Status visitor_status = visitor(as_slice(this->batch_));
+      BATT_REQUIRE_OK(visitor_status);
+
+      this->consume_batch();
+      slot_count += batch_size;
+    }
+
+    return slot_count;
+  }
+
  private:
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
+  // Returns true iff `status` (returned by parse_next) means `run` should return normally.
+  //
+  static bool is_end_of_run(const Status& status, batt::WaitForResource wait_for_data)
+  {
+    return !status.ok() && ((status == batt::StatusCode::kLoopBreak) ||
+                            (status == StatusCode::kBreakSlotReaderLoop) ||
+                            (status == StatusCode::kSlotReaderOutOfData &&
+                             wait_for_data == batt::WaitForResource::kFalse));
+  }
+
   StatusOr<SlotParse> parse_next(batt::WaitForResource wait_for_data);
 
+  // Parses the slot at the front of `data`, whose first byte is at `slot_offset` in the log.  If
+  // `data` doesn't contain the entire slot, returns None and sets `*min_bytes_needed` to the size
+  // `data` must grow to before trying again.
+  //
+  Optional<SlotParse> parse_slot(const ConstBuffer& data, slot_offset_type slot_offset,
+                                 usize* min_bytes_needed) const;
+
+  // Fills `batch_` with `first_slot` plus as many of the complete slots following it in the log
+  // reader's buffer as will fit in `max_batch_size`.
+  //
+  void parse_batch(const SlotParse& first_slot, usize max_batch_size);
+
   void consume_slot(const SlotParse& slot);
 
+  // Consumes all the slots in `batch_` and clears it.
+  //
+  void consume_batch();
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   // The log from which this object reads slots.
@@ -144,6 +213,11 @@ class SlotReader
   batt::Watch<slot_offset_type> consumed_upper_bound_;
 
   u64 slots_parsed_count_ = 0;
+
+  // The slots passed to the visitor by the current (or most recent) call to `run_batches`; this is
+  // kept as a member so its memory is reused from one batch to the next.
+  //
+  std::vector<SlotParse> batch_;
 };
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
@@ -15,6 +15,7 @@
 #include <batteries/async/latch.hpp>
 #include <batteries/shared_ptr.hpp>
 #include <batteries/stream_util.hpp>
+#include <batteries/utility.hpp>
 
 #include <functional>
 #include <memory>
@@ -49,6 +50,16 @@ namespace llfs {
 // BATT_CHECK(seq2.await_prev().ok());
 // BATT_CHECK_EQ(*seq2.await_prev(), llfs::SlotRange{10, 20});
 //
+// // Instead of blocking the current task, a continuation can be attached
+// // with `async_await_prev()`; it runs on whichever task calls set_current
+// // (or set_error) on the previous sequencer, or right away if that has
+// // already happened.
+// //
+// llfs::SlotSequencer seq3 = seq2.get_next();
+// seq3.async_await_prev([](llfs::StatusOr<llfs::SlotRange> slot2) {
+//   ...
+// });
+//
 // ```
 //
 class SlotSequencer
@@ -72,6 +83,35 @@ class SlotSequencer
 
   StatusOr<SlotRange> await_current() const;
 
+  /** \brief Invokes `handler` with the result of the previous slot in the sequence (as returned by
+   * `await_prev()`) once it is resolved, without blocking.
+   *
+   * If the previous slot is already resolved (or there is none), `handler` is invoked immediately
+   * on the calling task; otherwise it is invoked by the call to `set_current` or `set_error` that
+   * resolves the previous sequencer.  This lets a chain of dependent appends schedule slot N+1
+   * directly from the resolution of slot N.  `handler` must not block.
+   *
+   * Handler signature: `void(StatusOr<SlotRange>)`
+   */
+  template <typename Handler>
+  void async_await_prev(Handler&& handler) const
+  {
+    if (this->prev_ == nullptr) {
+      BATT_FORWARD(handler)(StatusOr<SlotRange>{SlotRange{0, 0}});
+      return;
+    }
+    this->prev_->async_get(BATT_FORWARD(handler));
+  }
+
+  /** \brief Invokes `handler` with the result of this slot once `set_current` or `set_error` is
+   * called, without blocking.  See `async_await_prev()`.
+   */
+  template <typename Handler>
+  void async_await_current(Handler&& handler) const
+  {
+    this->current_->async_get(BATT_FORWARD(handler));
+  }
+
   Optional<SlotRange> get_current() const;
 
   bool set_current(const SlotRange& slot_range);
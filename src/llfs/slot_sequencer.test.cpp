@@ -32,6 +32,10 @@ using namespace llfs::int_types;
 //  4. await_prev()/set_current() in concurrent tasks
 //  5. await_prev()/set_current() in concurrent tasks, using Fake executor
 //  6. Make chain of 7 sequencers, verify expected behavior in all permutations of set_current.
+//  7. async_await_prev: invoked immediately when there is no prev or prev is resolved, and from
+//     set_current/set_error otherwise.
+//  8. Chain of continuations: each sequencer's continuation resolves the next one, so resolving
+//     the first resolves the whole chain on the calling thread, with no tasks.
 //
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
@@ -119,4 +123,93 @@ TEST(SlotSequencerTest, Permutations)
   } while (std::next_permutation(order.begin(), order.end()));
 }
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+TEST(SlotSequencerTest, AsyncAwaitPrev)
+{
+  llfs::SlotSequencer seq1;
+
+  llfs::Optional<llfs::StatusOr<llfs::SlotRange>> result1;
+  seq1.async_await_prev([&result1](llfs::StatusOr<llfs::SlotRange> prev) {
+    result1 = prev;
+  });
+
+  ASSERT_TRUE(result1);
+  ASSERT_TRUE(result1->ok());
+  EXPECT_EQ(**result1, (llfs::SlotRange{0, 0}));
+
+  llfs::SlotSequencer seq2 = seq1.get_next();
+
+  llfs::Optional<llfs::StatusOr<llfs::SlotRange>> result2;
+  seq2.async_await_prev([&result2](llfs::StatusOr<llfs::SlotRange> prev) {
+    result2 = prev;
+  });
+
+  EXPECT_FALSE(result2);
+
+  EXPECT_TRUE(seq1.set_current(llfs::SlotRange{10, 20}));
+
+  ASSERT_TRUE(result2);
+  ASSERT_TRUE(result2->ok());
+  EXPECT_EQ(**result2, (llfs::SlotRange{10, 20}));
+
+  // Already resolved; the handler runs right away.
+  //
+  llfs::Optional<llfs::StatusOr<llfs::SlotRange>> result2b;
+  seq2.async_await_prev([&result2b](llfs::StatusOr<llfs::SlotRange> prev) {
+    result2b = prev;
+  });
+
+  ASSERT_TRUE(result2b);
+  ASSERT_TRUE(result2b->ok());
+  EXPECT_EQ(**result2b, (llfs::SlotRange{10, 20}));
+
+  // Errors are passed to the continuation.
+  //
+  llfs::SlotSequencer seq3 = seq2.get_next();
+
+  llfs::Optional<llfs::StatusOr<llfs::SlotRange>> result3;
+  seq3.async_await_prev([&result3](llfs::StatusOr<llfs::SlotRange> prev) {
+    result3 = prev;
+  });
+
+  EXPECT_FALSE(result3);
+
+  EXPECT_TRUE(seq2.set_error(batt::Status{batt::StatusCode::kCancelled}));
+
+  ASSERT_TRUE(result3);
+  EXPECT_EQ(result3->status(), batt::StatusCode::kCancelled);
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+TEST(SlotSequencerTest, ContinuationChain)
+{
+  constexpr usize kChainLength = 100;
+
+  std::vector<llfs::SlotSequencer> seq;
+  seq.emplace_back();
+  for (usize i = 1; i < kChainLength; ++i) {
+    seq.emplace_back(seq.back().get_next());
+  }
+
+  // Attach the continuations in reverse order so none of them can run before the first sequencer
+  // is resolved.
+  //
+  for (usize i = kChainLength - 1; i > 0; --i) {
+    seq[i].async_await_prev([&seq, i](llfs::StatusOr<llfs::SlotRange> prev) {
+      BATT_CHECK(prev.ok());
+      BATT_CHECK(seq[i].set_current(llfs::SlotRange{prev->upper_bound, prev->upper_bound + 1}));
+    });
+  }
+
+  for (usize i = 0; i < kChainLength; ++i) {
+    EXPECT_FALSE(seq[i].is_resolved());
+  }
+
+  EXPECT_TRUE(seq[0].set_current(llfs::SlotRange{0, 1}));
+
+  for (usize i = 0; i < kChainLength; ++i) {
+    EXPECT_EQ(seq[i].get_current(), llfs::make_optional(llfs::SlotRange{i, i + 1}));
+  }
+}
+
 }  // namespace
@@ -9,6 +9,12 @@
 #include <llfs/slot_writer.hpp>
 //
 
+#include <llfs/metrics.hpp>
+
+#include <batteries/finally.hpp>
+
+#include <cstring>
+
 namespace llfs {
 
 SlotWriter::SlotWriter(LogDevice& log_device) noexcept : log_device_{log_device}
@@ -19,9 +25,108 @@ SlotWriter::SlotWriter(LogDevice& log_device) noexcept : log_device_{log_device}
 //
 StatusOr<batt::Grant> SlotWriter::reserve(u64 size, batt::WaitForResource wait_for_resource)
 {
+  LogAppendMetrics& metrics = LogAppendMetrics::instance();
+  if (!metrics.sampler.sample()) {
+    return this->reserve_impl(size, wait_for_resource);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  StatusOr<batt::Grant> grant = this->reserve_impl(size, wait_for_resource);
+  metrics.reserve_wait_latency.update(start);
+
+  return grant;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<batt::Grant> SlotWriter::reserve_impl(u64 size, batt::WaitForResource wait_for_resource)
+{
+  // Fast path: take the space from this thread's cache, refilling it from the shared pool (without
+  // waiting) if necessary.  Large requests and requests made while others are waiting for the pool
+  // go straight to the pool.
+  //
+  if (size <= this->grant_shard_chunk_size_ &&
+      this->reserve_waiter_count_.load(std::memory_order_acquire) == 0) {
+    GrantShard& shard = *this->grant_shards_[striped_metric_thread_index() % kGrantShardCount];
+    std::unique_lock<std::mutex> lock{shard.mutex};
+
+    const u64 cached_size = shard.grant ? shard.grant->size() : 0;
+    if (cached_size < size) {
+      StatusOr<batt::Grant> refill = this->pool_.issue_grant(
+          this->grant_shard_chunk_size_ - cached_size, batt::WaitForResource::kFalse);
+      if (refill.ok()) {
+        // A waiter may have started (and drained this shard) since the check above; if so, don't
+        // strand the refill in the cache where the waiter can't see it.  The waiter's increment
+        // happens before its drain takes `shard.mutex`, so holding the lock makes this re-check
+        // reliable.
+        //
+        if (this->reserve_waiter_count_.load(std::memory_order_acquire) != 0) {
+          if (refill->size() >= size) {
+            return refill->spend(size, batt::WaitForResource::kFalse);
+          }
+          // Not enough for this request; let `refill` go back to the pool and take the slow path.
+        } else if (shard.grant) {
+          shard.grant->subsume(std::move(*refill));
+        } else {
+          shard.grant.emplace(std::move(*refill));
+        }
+      }
+    }
+
+    if (shard.grant && shard.grant->size() >= size) {
+      StatusOr<batt::Grant> grant = shard.grant->spend(size, batt::WaitForResource::kFalse);
+      shard.cached_size.store(shard.grant->size(), std::memory_order_relaxed);
+      if (grant.ok()) {
+        return grant;
+      }
+    }
+  }
+
+  StatusOr<batt::Grant> grant = this->pool_.issue_grant(size, batt::WaitForResource::kFalse);
+  if (grant.ok()) {
+    return grant;
+  }
+
+  // The shared pool is short (or closed); give it everything the caches hold before waiting (or
+  // failing).
+  //
+  this->reserve_waiter_count_.fetch_add(1);
+  auto on_scope_exit = batt::finally([&] {
+    this->reserve_waiter_count_.fetch_sub(1);
+  });
+
+  this->drain_grant_shards();
+
   return this->pool_.issue_grant(size, wait_for_resource);
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void SlotWriter::drain_grant_shards()
+{
+  for (batt::CpuCacheLineIsolated<GrantShard>& shard : this->grant_shards_) {
+    std::unique_lock<std::mutex> lock{shard->mutex};
+    shard->grant = None;
+    shard->cached_size.store(0, std::memory_order_relaxed);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status SlotWriter::sync(LogReadMode mode, SlotUpperBoundAt event)
+{
+  LogAppendMetrics& metrics = LogAppendMetrics::instance();
+  if (mode != LogReadMode::kDurable || !metrics.sampler.sample()) {
+    return this->log_device_.sync(mode, event);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  Status status = this->log_device_.sync(mode, event);
+  metrics.flush_wait_latency.update(start);
+
+  return status;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 StatusOr<slot_offset_type> SlotWriter::trim(slot_offset_type slot_lower_bound)
@@ -55,6 +160,7 @@ StatusOr<batt::Grant> SlotWriter::trim_and_reserve(slot_offset_type slot_lower_b
 void SlotWriter::halt()
 {
   this->pool_.close();
+  this->drain_grant_shards();
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -66,6 +172,28 @@ auto SlotWriter::prepare(batt::Grant& caller_grant, usize slot_body_size) -> Sta
   const usize slot_header_size = packed_sizeof_varint(slot_body_size);
   const usize slot_size = slot_header_size + slot_body_size;
 
+  return this->prepare_impl(caller_grant, slot_size, slot_body_size);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto SlotWriter::prepare_batch(batt::Grant& caller_grant, usize batch_size) -> StatusOr<Append>
+{
+  BATT_CHECK_NE(batch_size, 0);
+
+  return this->prepare_impl(caller_grant, batch_size, /*slot_body_size=*/None);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto SlotWriter::prepare_impl(batt::Grant& caller_grant, usize slot_size,
+                              Optional<usize> slot_body_size) -> StatusOr<Append>
+{
+  Optional<std::chrono::steady_clock::time_point> sample_start;
+  if (LogAppendMetrics::instance().sampler.sample()) {
+    sample_start = std::chrono::steady_clock::now();
+  }
+
   StatusOr<batt::Grant> slot_grant = caller_grant.spend(slot_size);
   if (slot_grant.status() == batt::StatusCode::kGrantUnavailable) {
     return ::llfs::make_status(StatusCode::kSlotGrantTooSmall);
@@ -82,14 +210,135 @@ auto SlotWriter::prepare(batt::Grant& caller_grant, usize slot_body_size) -> Sta
       std::move(*slot_grant),
       *slot_buffer,
       slot_body_size,
+      sample_start,
   }};
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto SlotWriter::prepare_concurrent(batt::Grant& caller_grant, usize slot_body_size)
+    -> StatusOr<ConcurrentAppend>
+{
+  BATT_CHECK_NE(slot_body_size, 0);
+
+  Optional<std::chrono::steady_clock::time_point> sample_start;
+  if (LogAppendMetrics::instance().sampler.sample()) {
+    sample_start = std::chrono::steady_clock::now();
+  }
+
+  const usize slot_header_size = packed_sizeof_varint(slot_body_size);
+  const usize slot_size = slot_header_size + slot_body_size;
+
+  StatusOr<batt::Grant> slot_grant = caller_grant.spend(slot_size);
+  if (slot_grant.status() == batt::StatusCode::kGrantUnavailable) {
+    return ::llfs::make_status(StatusCode::kSlotGrantTooSmall);
+  }
+  BATT_REQUIRE_OK(slot_grant);
+
+  ConcurrentAppend op{this, std::move(*slot_grant), slot_size, slot_body_size};
+  op.sample_start_ = sample_start;
+
+  return {std::move(op)};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void SlotWriter::publish_completed()
+{
+  this->publish_requests_.fetch_add(1);
+
+  for (;;) {
+    std::unique_lock<std::mutex> publish_lock{this->publish_mutex_, std::try_to_lock};
+    if (!publish_lock.owns_lock()) {
+      // The current owner of the lock will notice our request after it releases the lock.
+      //
+      return;
+    }
+
+    const u64 observed_requests = this->publish_requests_.load();
+    this->publish_completed_locked();
+    publish_lock.unlock();
+
+    if (this->publish_requests_.load() == observed_requests) {
+      return;
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void SlotWriter::publish_completed_locked()
+{
+  const u64 first_ticket = this->published_count_.get_value();
+
+  // Find the completed prefix of the ring.
+  //
+  u64 last_ticket = first_ticket;
+  usize batch_size = 0;
+  while (last_ticket - first_ticket < kCompletionRingSize) {
+    const CompletionEntry& entry = this->completion_ring_[last_ticket % kCompletionRingSize];
+    if (entry.ticket.load(std::memory_order_acquire) != last_ticket) {
+      break;
+    }
+    batch_size += entry.append->slot_size_;
+    ++last_ticket;
+  }
+
+  if (last_ticket == first_ticket) {
+    return;
+  }
+
+  // Copy the whole batch into the log while holding the writer lock (to serialize with Append).
+  //
+  {
+    batt::Mutex<LogDevice::Writer*>::Lock writer_lock = this->log_writer_.lock();
+    LogDevice::Writer& writer = **writer_lock;
+
+    const slot_offset_type batch_lower_bound = writer.slot_offset();
+
+    StatusOr<slot_offset_type> batch_upper_bound = [&]() -> StatusOr<slot_offset_type> {
+      StatusOr<MutableBuffer> batch_buffer = writer.prepare(batch_size, /*head_room=*/0);
+      BATT_REQUIRE_OK(batch_buffer);
+
+      char* dst = static_cast<char*>(batch_buffer->data());
+      for (u64 ticket = first_ticket; ticket != last_ticket; ++ticket) {
+        const ConcurrentAppend& op = *this->completion_ring_[ticket % kCompletionRingSize].append;
+        std::memcpy(dst, op.buffer_.get(), op.slot_size_);
+        dst += op.slot_size_;
+      }
+
+      return writer.commit(batch_size);
+    }();
+
+    slot_offset_type slot_lower_bound = batch_lower_bound;
+    for (u64 ticket = first_ticket; ticket != last_ticket; ++ticket) {
+      ConcurrentAppend& op = *this->completion_ring_[ticket % kCompletionRingSize].append;
+      if (!batch_upper_bound.ok()) {
+        op.result_ = batch_upper_bound.status();
+        continue;
+      }
+
+      op.result_ = SlotRange{
+          .lower_bound = slot_lower_bound,
+          .upper_bound = slot_lower_bound + op.slot_size_,
+      };
+      slot_lower_bound += op.slot_size_;
+
+      // Grow the in-use grant by the amount written.
+      //
+      this->in_use_.subsume(std::move(op.slot_grant_));
+    }
+  }
+
+  this->published_count_.set_value(last_ticket);
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 SlotWriter::Append::Append(SlotWriter* that, batt::Mutex<LogDevice::Writer*>::Lock writer_lock,
                            batt::Grant&& slot_grant, const MutableBuffer& slot_buffer,
-                           usize slot_body_size) noexcept
+                           Optional<usize> slot_body_size,
+                           Optional<std::chrono::steady_clock::time_point> sample_start) noexcept
     : that_{that}
     , writer_lock_{std::move(writer_lock)}
     , slot_grant_{std::move(slot_grant)}
@@ -97,11 +346,14 @@ SlotWriter::Append::Append(SlotWriter* that, batt::Mutex<LogDevice::Writer*>::Lo
     , committed_{false}
     , slot_lower_bound_{(*this->writer_lock_)->slot_offset()}
     , packer_{slot_buffer}
+    , sample_start_{sample_start}
 {
   BATT_CHECK_NOT_NULLPTR(*this->writer_lock_);
   BATT_CHECK_EQ(this->slot_grant_.get_issuer(), &this->that_->pool_);
   BATT_CHECK_EQ(this->packer_.buffer_size(), this->slot_grant_.size());
-  BATT_CHECK_NOT_NULLPTR(this->packer_.pack_varint(slot_body_size));
+  if (slot_body_size) {
+    BATT_CHECK_NOT_NULLPTR(this->packer_.pack_varint(*slot_body_size));
+  }
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -123,9 +375,19 @@ StatusOr<SlotRange> SlotWriter::Append::commit()
   this->committed_ = true;
   LLFS_VLOG(1) << "LogDevice::Writer::commit(" << this->packer_.buffer_size() << ")";
 
+  Optional<std::chrono::steady_clock::time_point> commit_start;
+  if (this->sample_start_) {
+    commit_start = std::chrono::steady_clock::now();
+    LogAppendMetrics::instance().prepare_latency.update(*commit_start - *this->sample_start_);
+  }
+
   StatusOr<slot_offset_type> commit_slot_upper_bound =
       (*this->writer_lock_)->commit(this->packer_.buffer_size());
 
+  if (commit_start) {
+    LogAppendMetrics::instance().commit_latency.update(*commit_start);
+  }
+
   BATT_REQUIRE_OK(commit_slot_upper_bound);
 
   LLFS_VLOG(1) << (void*)this << " commit succeeded; new upper_bound= " << *commit_slot_upper_bound
@@ -159,4 +421,116 @@ void SlotWriter::Append::cancel()
   }
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+SlotWriter::ConcurrentAppend::ConcurrentAppend(SlotWriter* that, batt::Grant&& slot_grant,
+                                               usize slot_size, usize slot_body_size) noexcept
+    : that_{that}
+    , slot_grant_{std::move(slot_grant)}
+    , slot_size_{slot_size}
+    , buffer_{new char[slot_size]}
+    , cancelled_{false}
+    , committed_{false}
+    , packer_{MutableBuffer{this->buffer_.get(), slot_size}}
+    , ticket_{0}
+    , result_{Status{batt::StatusCode::kUnknown}}
+{
+  BATT_CHECK_EQ(this->slot_grant_.get_issuer(), &this->that_->pool_);
+  BATT_CHECK_EQ(this->packer_.buffer_size(), this->slot_grant_.size());
+  if (slot_body_size) {
+    BATT_CHECK_NOT_NULLPTR(this->packer_.pack_varint(*slot_body_size));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+SlotWriter::ConcurrentAppend::~ConcurrentAppend() noexcept
+{
+  this->cancel();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<SlotRange> SlotWriter::ConcurrentAppend::commit()
+{
+  BATT_REQUIRE_OK(this->submit());
+
+  return this->await_published();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status SlotWriter::ConcurrentAppend::submit()
+{
+  if (this->cancelled_) {
+    return {batt::StatusCode::kCancelled};
+  }
+
+  BATT_CHECK(!this->committed_);
+  this->committed_ = true;
+
+  if (this->sample_start_) {
+    this->commit_start_ = std::chrono::steady_clock::now();
+    LogAppendMetrics::instance().prepare_latency.update(*this->commit_start_ -
+                                                        *this->sample_start_);
+  }
+
+  SlotWriter* const that = this->that_;
+  const u64 ticket = that->next_ticket_.fetch_add(1);
+  this->ticket_ = ticket;
+
+  // Wait for our entry in the ring to be free.  `published_count_` is never closed, since ops in
+  // the ring must always be published before they go away.
+  //
+  BATT_CHECK_OK(that->published_count_.await_true([ticket](u64 published_count) {
+    return ticket - published_count < kCompletionRingSize;
+  }));
+
+  CompletionEntry& entry = that->completion_ring_[ticket % kCompletionRingSize];
+  entry.append = this;
+  entry.ticket.store(ticket, std::memory_order_release);
+
+  that->publish_completed();
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<SlotRange> SlotWriter::ConcurrentAppend::await_published()
+{
+  BATT_CHECK(this->committed_);
+
+  const u64 ticket = this->ticket_;
+  BATT_CHECK_OK(this->that_->published_count_.await_true([ticket](u64 published_count) {
+    return published_count > ticket;
+  }));
+
+  if (this->commit_start_) {
+    LogAppendMetrics::instance().commit_latency.update(*this->commit_start_);
+  }
+
+  return this->result_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void SlotWriter::ConcurrentAppend::cancel()
+{
+  if (!this->committed_ && !this->cancelled_) {
+    this->cancelled_ = true;
+    this->slot_grant_.spend_all();
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void SlotWriter::ConcurrentAppend::cancel(batt::Grant& caller_grant)
+{
+  if (!this->committed_ && !this->cancelled_) {
+    this->cancelled_ = true;
+    caller_grant.subsume(std::move(this->slot_grant_));
+  }
+}
+
 }  // namespace llfs
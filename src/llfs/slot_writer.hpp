@@ -14,13 +14,25 @@
 
 #include <llfs/data_layout.hpp>
 #include <llfs/data_packer.hpp>
+#include <llfs/log_append_metrics.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/slice.hpp>
 #include <llfs/slot_parse.hpp>
 
 #include <batteries/async/grant.hpp>
 #include <batteries/async/mutex.hpp>
 #include <batteries/async/types.hpp>
+#include <batteries/async/watch.hpp>
+#include <batteries/cpu_align.hpp>
 #include <batteries/suppress.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace llfs {
 
 struct PackedRawData;
@@ -29,6 +41,20 @@ class SlotWriter
 {
  public:
   class Append;
+  class ConcurrentAppend;
+
+  // The maximum number of ConcurrentAppend ops that can be committed but not yet published to the
+  // log at any given time.
+  //
+  static constexpr usize kCompletionRingSize = 256;
+
+  // The number of per-thread grant caches used by `reserve`.
+  //
+  static constexpr usize kGrantShardCount = 16;
+
+  // The most log space that `reserve` takes from the shared pool at a time to refill a grant cache.
+  //
+  static constexpr u64 kMaxGrantShardChunkSize = 64 * 1024;
 
   explicit SlotWriter(LogDevice& log_device) noexcept;
 
@@ -42,9 +68,16 @@ class SlotWriter
     return this->log_device_.capacity();
   }
 
+  // The log space available to `reserve`: the shared pool plus whatever the grant caches hold.
+  // This is exact whenever no `reserve` call is in progress.
+  //
   usize pool_size() const
   {
-    return this->pool_.available();
+    usize total = this->pool_.available();
+    for (const batt::CpuCacheLineIsolated<GrantShard>& shard : this->grant_shards_) {
+      total += shard->cached_size.load(std::memory_order_relaxed);
+    }
+    return total;
   }
 
   usize in_use_size() const
@@ -59,6 +92,11 @@ class SlotWriter
 
   // Reserve `size` bytes in the log for future appends.
   //
+  // Small reservations are carved out of a per-thread grant cache, which is refilled from the
+  // shared pool a chunk at a time; so most calls don't touch the shared pool at all.  The unused
+  // part of a returned grant goes straight back to the shared pool.  If the shared pool can't cover
+  // a request, all the caches are returned to it before waiting (or failing).
+  //
   StatusOr<batt::Grant> reserve(u64 size, batt::WaitForResource wait_for_resource);
 
   // Set the new log trim offset (i.e., lower bound of the valid range); return the number of bytes
@@ -94,18 +132,81 @@ class SlotWriter
   //
   void halt();
 
-  // Convenience; wait for data to sync to the log.
+  // Convenience; wait for data to sync to the log.  Durable syncs are (sampled and) timed in
+  // LogAppendMetrics::flush_wait_latency.
   //
-  Status sync(LogReadMode mode, SlotUpperBoundAt event)
-  {
-    return this->log_device_.sync(mode, event);
-  }
+  Status sync(LogReadMode mode, SlotUpperBoundAt event);
 
   // Prepare space in the log to append a slot.
   //
   StatusOr<Append> prepare(batt::Grant& grant, usize slot_body_size);
 
+  // Prepare to append a slot without taking the log writer lock; see ConcurrentAppend.
+  //
+  StatusOr<ConcurrentAppend> prepare_concurrent(batt::Grant& grant, usize slot_body_size);
+
+  // Prepare space in the log to append a batch of consecutive slots with a single
+  // LogDevice::Writer prepare/commit.  `batch_size` is the total size of all the slots, *including*
+  // their headers; the caller must pack the header and body of each slot (see
+  // TypedSlotWriter::typed_append_batch).  The SlotRange returned by `Append::commit()` covers the
+  // whole batch.
+  //
+  StatusOr<Append> prepare_batch(batt::Grant& grant, usize batch_size);
+
  private:
+  // A cache of log space taken from `pool_`, used by `reserve`.
+  //
+  struct GrantShard {
+    // Protects `grant`.
+    //
+    std::mutex mutex;
+
+    // The cached space; None until first refilled.
+    //
+    Optional<batt::Grant> grant;
+
+    // The size of `grant`, readable without locking `mutex` (see `pool_size`).
+    //
+    std::atomic<u64> cached_size{0};
+  };
+
+  // Implements `reserve` (without metrics).
+  //
+  StatusOr<batt::Grant> reserve_impl(u64 size, batt::WaitForResource wait_for_resource);
+
+  // Returns the space held by all grant caches to `pool_`.
+  //
+  void drain_grant_shards();
+
+  // Common implementation of `prepare` and `prepare_batch`.
+  //
+  StatusOr<Append> prepare_impl(batt::Grant& grant, usize slot_size,
+                                Optional<usize> slot_body_size);
+
+  // An entry in the completion ring, through which committed ConcurrentAppend ops are published
+  // to the log in ticket order.
+  //
+  struct CompletionEntry {
+    // The ticket of the op currently stored in this entry; the entry for ticket `t` is at index
+    // `t % kCompletionRingSize`.
+    //
+    std::atomic<u64> ticket{~u64{0}};
+
+    // The op to publish; only valid when `ticket` has been set.
+    //
+    ConcurrentAppend* append = nullptr;
+  };
+
+  // Publishes the longest completed prefix of the completion ring.  If another thread is already
+  // doing this, it is asked to do another pass instead of waiting for it.
+  //
+  void publish_completed();
+
+  // Copies the completed prefix of the completion ring into the log with a single
+  // prepare/commit.  Caller must hold `publish_mutex_`.
+  //
+  void publish_completed_locked();
+
   LogDevice& log_device_;
 
   batt::Mutex<LogDevice::Writer*> log_writer_{&this->log_device_.writer()};
@@ -120,10 +221,44 @@ class SlotWriter
   batt::Grant in_use_{ok_result_or_panic(
       this->pool_.issue_grant(this->log_device_.size(), batt::WaitForResource::kFalse))};
 
+  // Per-thread caches of space taken from `pool_`; must be declared after `pool_`, so that they
+  // are released before it is destroyed.
+  //
+  std::array<batt::CpuCacheLineIsolated<GrantShard>, kGrantShardCount> grant_shards_;
+
+  // The amount by which a grant cache is refilled; scaled down for small logs so that the caches
+  // never hold more than a quarter of the log.  0 disables the caches.
+  //
+  const u64 grant_shard_chunk_size_ =
+      std::min<u64>(kMaxGrantShardChunkSize, this->log_device_.capacity() / (4 * kGrantShardCount));
+
+  // The number of `reserve` calls waiting on `pool_`; while non-zero, the caches are not refilled,
+  // so that waiters aren't starved.
+  //
+  std::atomic<usize> reserve_waiter_count_{0};
+
   // The current trim lower bound for the log.
   //
   batt::Watch<slot_offset_type> trim_lower_bound_{
       log_device_.new_reader(/*slot_lower_bound=*/None, LogReadMode::kInconsistent)->slot_offset()};
+
+  // The ticket to be given to the next committed ConcurrentAppend.
+  //
+  std::atomic<u64> next_ticket_{0};
+
+  // The number of tickets published to the log so far.
+  //
+  batt::Watch<u64> published_count_{0};
+
+  // Serializes `publish_completed_locked`.
+  //
+  std::mutex publish_mutex_;
+
+  // Incremented each time a publish pass is requested; see `publish_completed`.
+  //
+  std::atomic<u64> publish_requests_{0};
+
+  std::array<CompletionEntry, kCompletionRingSize> completion_ring_;
 };
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
@@ -131,9 +266,12 @@ class SlotWriter
 class SlotWriter::Append
 {
  public:
+  // If `slot_body_size` is None, the slot header(s) are not packed (see SlotWriter::prepare_batch).
+  //
   explicit Append(SlotWriter* that, batt::Mutex<LogDevice::Writer*>::Lock writer_lock,
                   batt::Grant&& slot_grant, const MutableBuffer& slot_buffer,
-                  usize slot_body_size) noexcept;
+                  Optional<usize> slot_body_size,
+                  Optional<std::chrono::steady_clock::time_point> sample_start = None) noexcept;
 
   Append(const Append&) = delete;
   Append& operator=(const Append&) = delete;
@@ -187,6 +325,117 @@ class SlotWriter::Append
   // Exposed to the caller to serialize the contents of the slot.
   //
   DataPacker packer_;
+
+  // If this append was selected by LogAppendMetrics::sampler, the time at which
+  // SlotWriter::prepare was called.
+  //
+  Optional<std::chrono::steady_clock::time_point> sample_start_;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// A slot append that doesn't hold the log writer lock while the slot is being packed.
+//
+// The slot is packed into a private buffer, so any number of ConcurrentAppend ops can be packed in
+// parallel.  `commit()` takes a ticket (a single atomic fetch-add) and stores the op in the
+// writer's completion ring; the longest completed prefix of the ring is then copied into the log
+// by whichever committer gets there first, with a single LogDevice::Writer prepare/commit for the
+// whole batch, so the log's commit position advances as soon as a prefix of tickets is complete.
+// Slots are therefore assigned their offsets in commit (ticket) order, not prepare order.
+//
+// Unlike Append, the slot lower bound is not known until `commit()` returns, and the packed data
+// is copied once more (into the log) before being committed.
+//
+class SlotWriter::ConcurrentAppend
+{
+ public:
+  explicit ConcurrentAppend(SlotWriter* that, batt::Grant&& slot_grant, usize slot_size,
+                            usize slot_body_size) noexcept;
+
+  ConcurrentAppend(const ConcurrentAppend&) = delete;
+  ConcurrentAppend& operator=(const ConcurrentAppend&) = delete;
+
+  BATT_SUPPRESS_IF_CLANG("-Wdefaulted-function-deleted")
+  //
+  ConcurrentAppend(ConcurrentAppend&&) = default;
+  ConcurrentAppend& operator=(ConcurrentAppend&&) = default;
+  //
+  BATT_UNSUPPRESS_IF_CLANG()
+
+  ~ConcurrentAppend() noexcept;
+
+  DataPacker& packer()
+  {
+    return this->packer_;
+  }
+
+  // Publish the packed slot to the log, in commit order; blocks until this slot (and all slots
+  // committed before it) have been written to the LogDevice.  Equivalent to `submit()` followed
+  // by `await_published()`.
+  //
+  StatusOr<SlotRange> commit();
+
+  // The first half of `commit()`: takes this op's ticket and hands it to the publisher, without
+  // waiting for it to be written.  A caller with several ops to commit can submit all of them
+  // before waiting, so they are written to the log as a single batch.
+  //
+  // Once submitted, this op MUST NOT be moved or destroyed until `await_published()` returns.
+  //
+  Status submit();
+
+  // The second half of `commit()`: blocks until this (submitted) op has been written to the log,
+  // returning its slot range.
+  //
+  StatusOr<SlotRange> await_published();
+
+  void cancel();
+
+  // Cancel this op, returning its unspent grant to `caller_grant` instead of the writer's pool.
+  //
+  void cancel(batt::Grant& caller_grant);
+
+ private:
+  friend class SlotWriter;
+
+  SlotWriter* that_;
+
+  // Released back to the pool if not committed; otherwise added to the writer's in-use grant when
+  // this slot is published.
+  //
+  batt::Grant slot_grant_;
+
+  // The packed slot data (header and body).
+  //
+  usize slot_size_;
+  std::unique_ptr<char[]> buffer_;
+
+  // Was this append cancelled?
+  //
+  bool cancelled_;
+
+  // Was this append committed?
+  //
+  bool committed_;
+
+  // Exposed to the caller to serialize the contents of the slot.
+  //
+  DataPacker packer_;
+
+  // The ticket taken by `submit()`.
+  //
+  u64 ticket_;
+
+  // Set by the publisher before this op's ticket is published.
+  //
+  StatusOr<SlotRange> result_;
+
+  // Set by `submit()` if this op is being sampled.
+  //
+  Optional<std::chrono::steady_clock::time_point> commit_start_;
+
+  // If this append was selected by LogAppendMetrics::sampler, the time at which
+  // SlotWriter::prepare_concurrent was called.
+  //
+  Optional<std::chrono::steady_clock::time_point> sample_start_;
 };
 
 inline constexpr usize packed_sizeof_slot_with_payload_size(usize payload_size)
@@ -214,6 +463,7 @@ class TypedSlotWriter<PackedVariant<Ts...>> : public SlotWriter
 {
  public:
   using Append = typename SlotWriter::Append;
+  using ConcurrentAppend = typename SlotWriter::ConcurrentAppend;
   using SlotWriter::SlotWriter;
 
   struct NullPostCommitFn {
@@ -293,6 +543,132 @@ class TypedSlotWriter<PackedVariant<Ts...>> : public SlotWriter
 
     return {packed->slot.offset};
   }
+
+  /** \brief Appends each element of `payloads` to the log as a separate slot, using a single
+   * LogDevice::Writer prepare/commit (and therefore one acquisition of the writer mutex) for the
+   * whole batch.
+   *
+   * \param caller_grant Must be at least as large as the sum of packed_sizeof_slot(payload) over
+   *                     all the payloads
+   * \param payloads The event data to append
+   * \param post_commit_fn (StatusOr<SlotRange>(StatusOr<SlotRange>)) Called after the batch has
+   *                       been committed to the log, while still holding the LogDevice::Writer
+   *                       mutex; must return the passed slot_range (which spans the whole batch)
+   *
+   * \return The interval where each payload was written, in the order of `payloads`
+   */
+  template <typename T, typename PostCommitFn = NullPostCommitFn>
+  StatusOr<std::vector<SlotRange>> append_batch(batt::Grant& caller_grant,
+                                                const Slice<const T>& payloads,
+                                                PostCommitFn&& post_commit_fn = {})
+  {
+    using PackedT = PackedTypeFor<T>;
+
+    std::vector<SlotRange> slot_ranges;
+    if (payloads.empty()) {
+      return slot_ranges;
+    }
+    slot_ranges.reserve(payloads.size());
+
+    // Calculate the layout of the batch; each slot's range is relative to the start of the batch
+    // until we know where the batch was written.
+    //
+    usize batch_size = 0;
+    for (const T& payload : payloads) {
+      const usize slot_body_size = sizeof(PackedVariant<Ts...>) + packed_sizeof(payload);
+      const usize slot_size = packed_sizeof_varint(slot_body_size) + slot_body_size;
+      slot_ranges.emplace_back(SlotRange{
+          .lower_bound = batch_size,
+          .upper_bound = batch_size + slot_size,
+      });
+      batch_size += slot_size;
+    }
+
+    StatusOr<Append> op = this->SlotWriter::prepare_batch(caller_grant, batch_size);
+    BATT_REQUIRE_OK(op);
+
+    // Each slot gets its own DataPacker so that any variable-sized data is packed within the slot.
+    //
+    u8* const batch_begin = op->packer().buffer_begin();
+    for (usize i = 0; i < payloads.size(); ++i) {
+      const SlotRange& slot_range = slot_ranges[i];
+      DataPacker slot_packer{MutableBuffer{batch_begin + slot_range.lower_bound,
+                                           slot_range.upper_bound - slot_range.lower_bound}};
+
+      const usize slot_body_size = sizeof(PackedVariant<Ts...>) + packed_sizeof(payloads[i]);
+      if (!slot_packer.pack_varint(slot_body_size)) {
+        return ::llfs::make_status(StatusCode::kFailedToPackSlotVarHead);
+      }
+
+      PackedVariant<Ts...>* variant_head =
+          slot_packer.pack_record(batt::StaticType<PackedVariant<Ts...>>{});
+      if (!variant_head) {
+        return ::llfs::make_status(StatusCode::kFailedToPackSlotVarHead);
+      }
+      variant_head->init(batt::StaticType<PackedT>{});
+
+      if (!pack_object(payloads[i], &slot_packer)) {
+        return ::llfs::make_status(StatusCode::kFailedToPackSlotVarTail);
+      }
+    }
+
+    StatusOr<SlotRange> batch_range = post_commit_fn(op->commit());
+    BATT_REQUIRE_OK(batch_range);
+
+    for (SlotRange& slot_range : slot_ranges) {
+      slot_range.lower_bound += batch_range->lower_bound;
+      slot_range.upper_bound += batch_range->lower_bound;
+    }
+    BATT_CHECK_EQ(slot_ranges.back().upper_bound, batch_range->upper_bound);
+
+    return slot_ranges;
+  }
+
+  /** \brief Spends a slot for `payload` from `caller_grant` and packs it into a new
+   * ConcurrentAppend, which the caller must then commit (or cancel); see
+   * SlotWriter::ConcurrentAppend.
+   */
+  template <typename T, typename PackedT = PackedTypeFor<T>>
+  StatusOr<ConcurrentAppend> prepare_concurrent_append(batt::Grant& caller_grant, T&& payload)
+  {
+    const usize slot_body_size = sizeof(PackedVariant<Ts...>) + packed_sizeof(payload);
+    BATT_CHECK_NE(slot_body_size, 0u);
+
+    StatusOr<ConcurrentAppend> op =
+        this->SlotWriter::prepare_concurrent(caller_grant, slot_body_size);
+    BATT_REQUIRE_OK(op);
+
+    PackedVariant<Ts...>* variant_head =
+        op->packer().pack_record(batt::StaticType<PackedVariant<Ts...>>{});
+    if (!variant_head) {
+      op->cancel(caller_grant);
+      return ::llfs::make_status(StatusCode::kFailedToPackSlotVarHead);
+    }
+
+    variant_head->init(batt::StaticType<PackedT>{});
+
+    if (!pack_object(BATT_FORWARD(payload), &(op->packer()))) {
+      op->cancel(caller_grant);
+      return ::llfs::make_status(StatusCode::kFailedToPackSlotVarTail);
+    }
+
+    return op;
+  }
+
+  /** \brief Appends `payload` to the log using the passed `caller_grant`, without holding the
+   * LogDevice::Writer mutex while packing; see SlotWriter::ConcurrentAppend.
+   *
+   * \return The interval where `payload` was written
+   */
+  template <typename T, typename PackedT = PackedTypeFor<T>>
+  StatusOr<SlotRange> concurrent_append(batt::Grant& caller_grant, T&& payload)
+  {
+    StatusOr<ConcurrentAppend> op =
+        this->prepare_concurrent_append<T, PackedT>(caller_grant, BATT_FORWARD(payload));
+    BATT_REQUIRE_OK(op);
+
+    return op->commit();
+  }
 };
 
 }  // namespace llfs
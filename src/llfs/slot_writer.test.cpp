@@ -0,0 +1,412 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/slot_writer.hpp>
+//
+#include <llfs/slot_writer.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/memory_log_device.hpp>
+#include <llfs/slot_reader.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <map>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//
+//  1. ConcurrentAppend ops committed in order produce the same slots as Append, and can be mixed
+//     with Append.
+//  2. Many threads appending concurrently produce a gap-free log in which each thread's slots
+//     appear in commit order, at the slot ranges returned by commit().
+//  3. Cancelled (or never committed) ConcurrentAppend ops release their grant and write nothing.
+//  4. Several ops submitted before any is awaited are written in submit order; an op cancelled
+//     with a caller grant returns its grant there.
+//  5. Space held in the per-thread grant caches of `reserve` is counted by pool_size(), and is
+//     given back when a reservation can't be met from the shared pool alone, so that the whole
+//     pool can still be reserved (also with several threads reserving at once).
+//  6. A reservation that waits for the whole pool is granted once other threads stop reserving,
+//     even if they were refilling their grant caches while it started waiting.
+//
+
+using namespace llfs::int_types;
+
+constexpr usize kLogSize = 1024 * 1024;
+
+struct TestSlot {
+  u32 thread_index;
+  u32 seq;
+};
+
+// Appends `slot` using a ConcurrentAppend.
+//
+llfs::StatusOr<llfs::SlotRange> concurrent_append(llfs::SlotWriter& slot_writer,
+                                                  batt::Grant& grant, const TestSlot& slot)
+{
+  llfs::StatusOr<llfs::SlotWriter::ConcurrentAppend> op =
+      slot_writer.prepare_concurrent(grant, sizeof(TestSlot));
+  BATT_REQUIRE_OK(op);
+
+  BATT_CHECK(op->packer().pack_raw_data(&slot, sizeof(slot)));
+
+  return op->commit();
+}
+
+// Returns all slots in the log, keyed by slot lower bound.
+//
+std::map<llfs::slot_offset_type, TestSlot> read_slots(llfs::LogDevice& log_device)
+{
+  std::map<llfs::slot_offset_type, TestSlot> slots;
+
+  std::unique_ptr<llfs::LogDevice::Reader> log_reader =
+      log_device.new_reader(/*slot_lower_bound=*/llfs::None, llfs::LogReadMode::kSpeculative);
+
+  llfs::SlotReader slot_reader{*log_reader};
+  llfs::StatusOr<usize> n_read =
+      slot_reader.run(batt::WaitForResource::kFalse, [&](const llfs::SlotParse& slot) {
+        BATT_CHECK_EQ(slot.body.size(), sizeof(TestSlot));
+
+        TestSlot value;
+        std::memcpy(&value, slot.body.data(), sizeof(value));
+        slots.emplace(slot.offset.lower_bound, value);
+
+        return llfs::OkStatus();
+      });
+  BATT_CHECK_OK(n_read);
+
+  return slots;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  1. ConcurrentAppend ops committed in order produce the same slots as Append.
+//
+TEST(SlotWriterTest, ConcurrentAppendInOrder)
+{
+  llfs::MemoryLogDevice log_device{kLogSize};
+  llfs::SlotWriter slot_writer{log_device};
+
+  llfs::StatusOr<batt::Grant> grant =
+      slot_writer.reserve(kLogSize / 2, batt::WaitForResource::kFalse);
+  ASSERT_TRUE(grant.ok()) << BATT_INSPECT(grant.status());
+
+  llfs::slot_offset_type expected_lower_bound = 0;
+  for (u32 seq = 0; seq < 10; ++seq) {
+    llfs::StatusOr<llfs::SlotRange> slot_range;
+    const TestSlot slot{0, seq};
+
+    if (seq % 3 == 0) {
+      llfs::StatusOr<llfs::SlotWriter::Append> op = slot_writer.prepare(*grant, sizeof(TestSlot));
+      ASSERT_TRUE(op.ok()) << BATT_INSPECT(op.status());
+      ASSERT_TRUE(op->packer().pack_raw_data(&slot, sizeof(slot)));
+      slot_range = op->commit();
+    } else {
+      slot_range = concurrent_append(slot_writer, *grant, slot);
+    }
+
+    ASSERT_TRUE(slot_range.ok()) << BATT_INSPECT(slot_range.status());
+    EXPECT_EQ(slot_range->lower_bound, expected_lower_bound);
+    EXPECT_EQ(slot_range->size(), 1 + sizeof(TestSlot));
+    expected_lower_bound = slot_range->upper_bound;
+  }
+
+  EXPECT_EQ(slot_writer.slot_offset(), expected_lower_bound);
+  EXPECT_EQ(slot_writer.in_use_size(), expected_lower_bound);
+
+  const std::map<llfs::slot_offset_type, TestSlot> slots = read_slots(log_device);
+  ASSERT_EQ(slots.size(), 10u);
+
+  u32 seq = 0;
+  for (const auto& [slot_lower_bound, slot] : slots) {
+    EXPECT_EQ(slot.seq, seq);
+    ++seq;
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  2. Many threads appending concurrently produce a gap-free log.
+//
+TEST(SlotWriterTest, ConcurrentAppendManyThreads)
+{
+  constexpr usize kNumThreads = 8;
+  constexpr usize kSlotsPerThread = 2000;
+
+  llfs::MemoryLogDevice log_device{kLogSize};
+  llfs::SlotWriter slot_writer{log_device};
+
+  std::vector<std::vector<llfs::SlotRange>> committed(kNumThreads);
+  std::vector<std::thread> threads;
+
+  for (usize thread_index = 0; thread_index < kNumThreads; ++thread_index) {
+    threads.emplace_back([&, thread_index] {
+      llfs::StatusOr<batt::Grant> grant = slot_writer.reserve(
+          kSlotsPerThread * (1 + sizeof(TestSlot)), batt::WaitForResource::kFalse);
+      BATT_CHECK_OK(grant);
+
+      for (u32 seq = 0; seq < kSlotsPerThread; ++seq) {
+        llfs::StatusOr<llfs::SlotRange> slot_range = concurrent_append(
+            slot_writer, *grant, TestSlot{static_cast<u32>(thread_index), seq});
+        BATT_CHECK_OK(slot_range);
+        committed[thread_index].emplace_back(*slot_range);
+      }
+      BATT_CHECK_EQ(grant->size(), 0u);
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+
+  const usize expected_size = kNumThreads * kSlotsPerThread * (1 + sizeof(TestSlot));
+  EXPECT_EQ(slot_writer.slot_offset(), expected_size);
+  EXPECT_EQ(slot_writer.in_use_size(), expected_size);
+
+  const std::map<llfs::slot_offset_type, TestSlot> slots = read_slots(log_device);
+  ASSERT_EQ(slots.size(), kNumThreads * kSlotsPerThread);
+
+  for (usize thread_index = 0; thread_index < kNumThreads; ++thread_index) {
+    llfs::slot_offset_type prev_upper_bound = 0;
+    for (u32 seq = 0; seq < kSlotsPerThread; ++seq) {
+      const llfs::SlotRange& slot_range = committed[thread_index][seq];
+      EXPECT_GE(slot_range.lower_bound, prev_upper_bound);
+      prev_upper_bound = slot_range.upper_bound;
+
+      auto iter = slots.find(slot_range.lower_bound);
+      ASSERT_NE(iter, slots.end());
+      EXPECT_EQ(iter->second.thread_index, thread_index);
+      EXPECT_EQ(iter->second.seq, seq);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  3. Cancelled ConcurrentAppend ops release their grant and write nothing.
+//
+TEST(SlotWriterTest, ConcurrentAppendCancel)
+{
+  llfs::MemoryLogDevice log_device{kLogSize};
+  llfs::SlotWriter slot_writer{log_device};
+
+  const usize initial_pool_size = slot_writer.pool_size();
+  {
+    llfs::StatusOr<batt::Grant> grant = slot_writer.reserve(100, batt::WaitForResource::kFalse);
+    ASSERT_TRUE(grant.ok()) << BATT_INSPECT(grant.status());
+    {
+      llfs::StatusOr<llfs::SlotWriter::ConcurrentAppend> op =
+          slot_writer.prepare_concurrent(*grant, sizeof(TestSlot));
+      ASSERT_TRUE(op.ok()) << BATT_INSPECT(op.status());
+      EXPECT_EQ(grant->size(), 100 - (1 + sizeof(TestSlot)));
+
+      op->cancel();
+      EXPECT_EQ(op->commit().status(), batt::StatusCode::kCancelled);
+    }
+    {
+      llfs::StatusOr<llfs::SlotWriter::ConcurrentAppend> op =
+          slot_writer.prepare_concurrent(*grant, sizeof(TestSlot));
+      ASSERT_TRUE(op.ok()) << BATT_INSPECT(op.status());
+    }
+  }
+  EXPECT_EQ(slot_writer.pool_size(), initial_pool_size);
+  EXPECT_EQ(slot_writer.slot_offset(), 0u);
+  EXPECT_EQ(slot_writer.in_use_size(), 0u);
+
+  llfs::StatusOr<batt::Grant> empty_grant = slot_writer.reserve(0, batt::WaitForResource::kFalse);
+  ASSERT_TRUE(empty_grant.ok()) << BATT_INSPECT(empty_grant.status());
+
+  EXPECT_EQ(concurrent_append(slot_writer, *empty_grant, TestSlot{1, 2}).status(),
+            llfs::make_status(llfs::StatusCode::kSlotGrantTooSmall));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  4. Several ops submitted before any is awaited are written in submit order.
+//
+TEST(SlotWriterTest, ConcurrentAppendSubmitBatch)
+{
+  constexpr usize kSlotSize = 1 + sizeof(TestSlot);
+
+  llfs::MemoryLogDevice log_device{kLogSize};
+  llfs::SlotWriter slot_writer{log_device};
+
+  llfs::StatusOr<batt::Grant> grant =
+      slot_writer.reserve(10 * kSlotSize, batt::WaitForResource::kFalse);
+  ASSERT_TRUE(grant.ok()) << BATT_INSPECT(grant.status());
+
+  std::vector<llfs::SlotWriter::ConcurrentAppend> ops;
+  for (u32 seq = 0; seq < 10; ++seq) {
+    llfs::StatusOr<llfs::SlotWriter::ConcurrentAppend> op =
+        slot_writer.prepare_concurrent(*grant, sizeof(TestSlot));
+    ASSERT_TRUE(op.ok()) << BATT_INSPECT(op.status());
+
+    const TestSlot slot{0, seq};
+    ASSERT_TRUE(op->packer().pack_raw_data(&slot, sizeof(slot)));
+    ops.emplace_back(std::move(*op));
+  }
+  EXPECT_EQ(grant->size(), 0u);
+
+  // Cancel every third op, returning its grant to `grant`; submit the rest.
+  //
+  for (u32 seq = 0; seq < 10; ++seq) {
+    if (seq % 3 == 0) {
+      ops[seq].cancel(*grant);
+    } else {
+      EXPECT_TRUE(ops[seq].submit().ok());
+    }
+  }
+  EXPECT_EQ(grant->size(), 4 * kSlotSize);
+
+  llfs::slot_offset_type expected_lower_bound = 0;
+  for (u32 seq = 0; seq < 10; ++seq) {
+    if (seq % 3 == 0) {
+      continue;
+    }
+    llfs::StatusOr<llfs::SlotRange> slot_range = ops[seq].await_published();
+    ASSERT_TRUE(slot_range.ok()) << BATT_INSPECT(slot_range.status());
+    EXPECT_EQ(slot_range->lower_bound, expected_lower_bound);
+    expected_lower_bound = slot_range->upper_bound;
+  }
+  EXPECT_EQ(slot_writer.in_use_size(), 6 * kSlotSize);
+
+  const std::map<llfs::slot_offset_type, TestSlot> slots = read_slots(log_device);
+  ASSERT_EQ(slots.size(), 6u);
+
+  std::vector<u32> seqs;
+  for (const auto& [slot_lower_bound, slot] : slots) {
+    seqs.emplace_back(slot.seq);
+  }
+  EXPECT_THAT(seqs, ::testing::ElementsAre(1, 2, 4, 5, 7, 8));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  5. Grant caches are accounted for and drained when needed.
+//
+TEST(SlotWriterTest, ReserveGrantCache)
+{
+  constexpr usize kNumThreads = 4;
+  constexpr usize kReservesPerThread = 10000;
+
+  llfs::MemoryLogDevice log_device{kLogSize};
+  llfs::SlotWriter slot_writer{log_device};
+
+  const usize initial_pool_size = slot_writer.pool_size();
+  EXPECT_EQ(initial_pool_size, kLogSize);
+
+  {
+    std::vector<batt::Grant> grants;
+    usize reserved = 0;
+    for (usize size = 1; size < 100; ++size) {
+      llfs::StatusOr<batt::Grant> grant = slot_writer.reserve(size, batt::WaitForResource::kFalse);
+      ASSERT_TRUE(grant.ok()) << BATT_INSPECT(grant.status());
+      EXPECT_EQ(grant->size(), size);
+      reserved += size;
+      grants.emplace_back(std::move(*grant));
+
+      EXPECT_EQ(slot_writer.pool_size() + reserved, initial_pool_size);
+    }
+  }
+  EXPECT_EQ(slot_writer.pool_size(), initial_pool_size);
+
+  // Reserve from several threads, so that several caches hold space.
+  //
+  {
+    std::vector<std::thread> threads;
+    for (usize i = 0; i < kNumThreads; ++i) {
+      threads.emplace_back([&slot_writer] {
+        for (usize j = 0; j < kReservesPerThread; ++j) {
+          llfs::StatusOr<batt::Grant> grant =
+              slot_writer.reserve(1 + j % 500, batt::WaitForResource::kFalse);
+          BATT_CHECK_OK(grant);
+        }
+      });
+    }
+    for (std::thread& t : threads) {
+      t.join();
+    }
+  }
+  EXPECT_EQ(slot_writer.pool_size(), initial_pool_size);
+
+  // All of the pool can be reserved, even though the caches hold some of it.
+  //
+  {
+    llfs::StatusOr<batt::Grant> small = slot_writer.reserve(10, batt::WaitForResource::kFalse);
+    ASSERT_TRUE(small.ok()) << BATT_INSPECT(small.status());
+
+    llfs::StatusOr<batt::Grant> too_big =
+        slot_writer.reserve(initial_pool_size, batt::WaitForResource::kFalse);
+    EXPECT_FALSE(too_big.ok());
+
+    llfs::StatusOr<batt::Grant> rest =
+        slot_writer.reserve(initial_pool_size - 10, batt::WaitForResource::kFalse);
+    ASSERT_TRUE(rest.ok()) << BATT_INSPECT(rest.status());
+    EXPECT_EQ(slot_writer.pool_size(), 0u);
+  }
+  EXPECT_EQ(slot_writer.pool_size(), initial_pool_size);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  6. A waiting reservation isn't starved by space left in the grant caches.
+//
+TEST(SlotWriterTest, ReserveWaiterSeesRefills)
+{
+  constexpr usize kNumThreads = 4;
+  constexpr usize kReservesPerThread = 20000;
+  constexpr usize kNumRounds = 10;
+
+  llfs::MemoryLogDevice log_device{kLogSize};
+  llfs::SlotWriter slot_writer{log_device};
+
+  const usize initial_pool_size = slot_writer.pool_size();
+
+  for (usize round = 0; round < kNumRounds; ++round) {
+    std::atomic<bool> start{false};
+
+    std::vector<std::thread> threads;
+    for (usize i = 0; i < kNumThreads; ++i) {
+      threads.emplace_back([&slot_writer, &start] {
+        while (!start.load()) {
+          std::this_thread::yield();
+        }
+        for (usize j = 0; j < kReservesPerThread; ++j) {
+          // These may fail while the waiter below holds the pool; that's fine.
+          //
+          slot_writer.reserve(1 + j % 500, batt::WaitForResource::kFalse).IgnoreError();
+        }
+      });
+    }
+
+    std::future<llfs::StatusOr<batt::Grant>> waiter = std::async(std::launch::async, [&] {
+      start.store(true);
+      return slot_writer.reserve(initial_pool_size, batt::WaitForResource::kTrue);
+    });
+
+    for (std::thread& t : threads) {
+      t.join();
+    }
+
+    // Once nobody else is reserving, all of the pool must reach the waiter.  If it doesn't, close
+    // the pool so the waiter returns (and the test fails instead of hanging).
+    //
+    const bool granted = waiter.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+    if (!granted) {
+      slot_writer.halt();
+    }
+    llfs::StatusOr<batt::Grant> all = waiter.get();
+
+    ASSERT_TRUE(granted) << BATT_INSPECT(round) << BATT_INSPECT(slot_writer.pool_size());
+    ASSERT_TRUE(all.ok()) << BATT_INSPECT(all.status());
+    EXPECT_EQ(all->size(), initial_pool_size);
+  }
+  EXPECT_EQ(slot_writer.pool_size(), initial_pool_size);
+}
+
+}  // namespace
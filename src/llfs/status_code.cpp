@@ -136,6 +136,29 @@ bool initialize_status_codes()
       CODE_WITH_MSG_(
           StatusCode::kIoRingShutDown,
           "The operation could not be completed because the IoRing was shut down"),  // 64,
+      CODE_WITH_MSG_(StatusCode::kPageAllocatorSnapshotBadMagic,
+                     "The PageAllocator snapshot file has a bad magic number or size"),  // 65,
+      CODE_WITH_MSG_(StatusCode::kPageAllocatorSnapshotBadCrc,
+                     "The PageAllocator snapshot file failed its CRC check"),  // 66,
+      CODE_WITH_MSG_(
+          StatusCode::kPageAllocatorSnapshotMismatch,
+          "The PageAllocator snapshot file does not match the page device or its log"),  // 67,
+      CODE_WITH_MSG_(StatusCode::kPageDecompressFailed,
+                     "The compressed page image is corrupt and could not be decompressed"),  // 68,
+      CODE_WITH_MSG_(StatusCode::kPageChecksumMismatch,
+                     "The page contents do not match the checksum in its header"),  // 69,
+      CODE_WITH_MSG_(StatusCode::kPageChecksumUnknownType,
+                     "The page header names an unknown checksum algorithm"),  // 70,
+      CODE_WITH_MSG_(StatusCode::kPageFilterBadData,
+                     "The packed page filter is of an unknown type or is corrupt"),  // 71,
+      CODE_WITH_MSG_(StatusCode::kPackedSortedU64sBadData,
+                     "The block table of a packed sorted u64 array is corrupt"),  // 72,
+      CODE_WITH_MSG_(StatusCode::kPackedFrontCodedStringsBadData,
+                     "A front-coded packed string array is corrupt"),  // 73,
+      CODE_WITH_MSG_(StatusCode::kPageCacheHotListBadData,
+                     "The page cache hot list file is truncated or corrupt"),  // 74,
+      CODE_WITH_MSG_(StatusCode::kPageDeltaBadData,
+                     "The delta page image is corrupt or does not match its base page"),  // 75,
   });
   return initialized;
 }
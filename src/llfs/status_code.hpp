@@ -80,6 +80,17 @@ enum struct StatusCode {
   kPutViewUnknownLayoutId = 62,
   kPageCacheSlotNotInitialized = 63,
   kIoRingShutDown = 64,
+  kPageAllocatorSnapshotBadMagic = 65,
+  kPageAllocatorSnapshotBadCrc = 66,
+  kPageAllocatorSnapshotMismatch = 67,
+  kPageDecompressFailed = 68,
+  kPageChecksumMismatch = 69,
+  kPageChecksumUnknownType = 70,
+  kPageFilterBadData = 71,
+  kPackedSortedU64sBadData = 72,
+  kPackedFrontCodedStringsBadData = 73,
+  kPageCacheHotListBadData = 74,
+  kPageDeltaBadData = 75,
 };
 
 bool initialize_status_codes();
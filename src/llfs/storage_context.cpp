@@ -9,10 +9,24 @@
 #include <llfs/storage_context.hpp>
 //
 
+#include <llfs/ioring_file_runtime_options.hpp>
+#include <llfs/lazy_page_device.hpp>
+#include <llfs/numa.hpp>
 #include <llfs/page_arena_config.hpp>
+#include <llfs/page_device_config.hpp>
 #include <llfs/raw_block_file_impl.hpp>
 #include <llfs/status_code.hpp>
 
+#include <batteries/async/task.hpp>
+#include <batteries/checked_cast.hpp>
+
+#include <boost/range/irange.hpp>
+
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 namespace llfs {
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -24,6 +38,15 @@ StorageContext::StorageContext(batt::TaskScheduler& scheduler, const IoRing& io_
   initialize_status_codes();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StorageContext::~StorageContext() noexcept
+{
+  for (const auto& [uuid, p_object_info] : this->index_) {
+    global_metric_registry().remove(p_object_info->recover_usec);
+  }
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 batt::SharedPtr<StorageObjectInfo> StorageContext::find_object_by_uuid(
@@ -40,16 +63,79 @@ batt::SharedPtr<StorageObjectInfo> StorageContext::find_object_by_uuid(
 //
 Status StorageContext::add_existing_named_file(std::string&& file_name, i64 start_offset)
 {
-  StatusOr<int> fd = open_file_read_write(file_name, OpenForAppend{false}, OpenRawIO{true});
-  BATT_REQUIRE_OK(fd);
+  std::vector<std::string> file_names;
+  file_names.emplace_back(std::move(file_name));
+
+  return this->add_existing_named_files(std::move(file_names), start_offset);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status StorageContext::add_existing_named_files(std::vector<std::string>&& file_names,
+                                                i64 start_offset)
+{
+  using ConfigBlocks = std::vector<std::unique_ptr<StorageFileConfigBlock>>;
+
+  std::vector<StatusOr<ConfigBlocks>> config_blocks;
+  for (usize i = 0; i < file_names.size(); ++i) {
+    config_blocks.emplace_back(Status{batt::StatusCode::kUnknown});
+  }
+
+  if (file_names.size() == 1) {
+    config_blocks[0] = read_storage_file_mapped(file_names[0], start_offset);
+  } else {
+    std::vector<std::unique_ptr<batt::Task>> tasks;
+
+    for (usize i = 0; i < file_names.size(); ++i) {
+      tasks.emplace_back(std::make_unique<batt::Task>(
+          this->scheduler_.schedule_task(),
+          [&file_names, &config_blocks, start_offset, i] {
+            config_blocks[i] = read_storage_file_mapped(file_names[i], start_offset);
+          },
+          batt::to_string("StorageContext.read_storage_file_", i)));
+    }
+
+    for (const std::unique_ptr<batt::Task>& task : tasks) {
+      task->join();
+    }
+  }
+
+  for (StatusOr<ConfigBlocks>& file_config_blocks : config_blocks) {
+    BATT_REQUIRE_OK(file_config_blocks);
+  }
+
+  std::vector<batt::SharedPtr<StorageFile>> files;
+  files.reserve(file_names.size());
+  for (usize i = 0; i < file_names.size(); ++i) {
+    files.emplace_back(
+        batt::make_shared<StorageFile>(std::move(file_names[i]), std::move(*config_blocks[i])));
+  }
 
-  IoRingRawBlockFile file{IoRing::File{*this->io_ring_, *fd}};
-  StatusOr<std::vector<std::unique_ptr<StorageFileConfigBlock>>> config_blocks =
-      read_storage_file(file, start_offset);
-  BATT_REQUIRE_OK(config_blocks);
+  // The files are added as a unit: if one can't be added, the objects of those added before it are
+  // removed again.  Since add_existing_file only appends to `objects_by_tag_`, the objects it added
+  // are the ones past each tag's size from before.
+  //
+  std::unordered_map<u16, usize> saved_tag_sizes;
+  for (const auto& [tag, objects] : this->objects_by_tag_) {
+    saved_tag_sizes.emplace(tag, objects.size());
+  }
 
-  return this->add_existing_file(
-      batt::make_shared<StorageFile>(std::move(file_name), std::move(*config_blocks)));
+  for (const batt::SharedPtr<StorageFile>& file : files) {
+    Status add_status = this->add_existing_file(file);
+    if (!add_status.ok()) {
+      for (auto& [tag, objects] : this->objects_by_tag_) {
+        const usize saved_size = saved_tag_sizes[tag];
+        for (usize i = saved_size; i < objects.size(); ++i) {
+          global_metric_registry().remove(objects[i]->recover_usec);
+          this->index_.erase(objects[i]->p_config_slot->uuid);
+        }
+        objects.resize(saved_size);
+      }
+      return add_status;
+    }
+  }
+
+  return OkStatus();
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -87,13 +173,57 @@ Status StorageContext::add_existing_file(const batt::SharedPtr<StorageFile>& fil
       | seq::for_each([&](const FileOffsetPtr<const PackedConfigSlot&>& slot) {
           LLFS_VLOG(1) << "Adding " << *slot << " to storage context";
 
-          this->index_.emplace(slot->uuid,
-                               batt::make_shared<StorageObjectInfo>(batt::make_copy(file), slot));
+          auto [iter, inserted] = this->index_.emplace(
+              slot->uuid, batt::make_shared<StorageObjectInfo>(batt::make_copy(file), slot));
+
+          if (inserted) {
+            this->objects_by_tag_[slot->tag].emplace_back(iter->second);
+            global_metric_registry().add(
+                batt::to_string("StorageObject_", slot->uuid, "_recover_usec"),
+                iter->second->recover_usec);
+          }
         });
 
   return OkStatus();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void StorageContext::set_page_device_io_ring(const IoRing& io)
+{
+  BATT_CHECK(this->page_cache_ == nullptr)
+      << "set_page_device_io_ring must be called before get_page_cache";
+
+  this->page_device_io_ring_ = &io;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void StorageContext::set_numa_node_io_ring(usize numa_node, const IoRing& io)
+{
+  BATT_CHECK(this->page_cache_ == nullptr)
+      << "set_numa_node_io_ring must be called before get_page_cache";
+
+  if (this->numa_node_io_rings_.size() <= numa_node) {
+    this->numa_node_io_rings_.resize(numa_node + 1, nullptr);
+  }
+  this->numa_node_io_rings_[numa_node] = &io;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+const IoRing& StorageContext::get_page_device_io_ring_for_file(const std::string& file_name) const
+{
+  if (!this->numa_node_io_rings_.empty()) {
+    const Optional<usize> numa_node = numa_node_of_file(file_name);
+    if (numa_node && *numa_node < this->numa_node_io_rings_.size() &&
+        this->numa_node_io_rings_[*numa_node] != nullptr) {
+      return *this->numa_node_io_rings_[*numa_node];
+    }
+  }
+  return this->get_page_device_io_ring();
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 void StorageContext::set_page_cache_options(const PageCacheOptions& options)
@@ -101,6 +231,23 @@ void StorageContext::set_page_cache_options(const PageCacheOptions& options)
   this->page_cache_options_ = options;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void StorageContext::set_page_device_options(const IoRingPageFileDeviceOptions& options)
+{
+  this->page_device_options_ = options;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void StorageContext::set_lazy_arena_recovery(bool lazy)
+{
+  BATT_CHECK_EQ(this->page_cache_, nullptr)
+      << "set_lazy_arena_recovery must be called before get_page_cache";
+
+  this->lazy_arena_recovery_ = lazy;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 StatusOr<batt::SharedPtr<PageCache>> StorageContext::get_page_cache()
@@ -109,38 +256,30 @@ StatusOr<batt::SharedPtr<PageCache>> StorageContext::get_page_cache()
     return this->page_cache_;
   }
 
-  std::vector<PageArena> storage_pool;
+  const std::vector<batt::SharedPtr<StorageObjectInfo>> arena_objects =
+      this->objects_by_tag_[PackedConfigSlotBase::Tag::kPageArena];
 
-  for (const auto& [uuid, p_object_info] : this->index_) {
-    if (p_object_info->p_config_slot->tag == PackedConfigSlotBase::Tag::kPageArena) {
-      const auto& packed_arena_config =
-          config_slot_cast<PackedPageArenaConfig>(p_object_info->p_config_slot.object);
-
-      const std::string base_name =
-          batt::to_string("PageDevice_", packed_arena_config.page_device_uuid);
-
-      StatusOr<PageArena> arena = this->recover_object(
-          batt::StaticType<PackedPageArenaConfig>{}, uuid,
-          PageAllocatorRuntimeOptions{
-              .scheduler = this->scheduler_,
-              .name = batt::to_string(base_name, "_Allocator"),
-          },
-          [&] {
-            IoRingLogDriverOptions options;
-            options.name = batt::to_string(base_name, "_AllocatorLog");
-            return options;
-          }(),
-          IoRingFileRuntimeOptions{
-              .io_ring = *this->io_ring_,
-              .use_raw_io = true,
-              .allow_read = true,
-              .allow_write = true,
-          });
-
-      BATT_REQUIRE_OK(arena);
-
-      storage_pool.emplace_back(std::move(*arena));
+  std::vector<StatusOr<PageArena>> arenas;
+  for (usize i = 0; i < arena_objects.size(); ++i) {
+    arenas.emplace_back(Status{batt::StatusCode::kUnknown});
+  }
+
+  if (this->lazy_arena_recovery_) {
+    for (usize i = 0; i < arena_objects.size(); ++i) {
+      arenas[i] = this->make_lazy_page_arena(arena_objects[i]);
     }
+  } else {
+    // The arenas are independent of each other, so recover them all at once.
+    //
+    this->recover_in_parallel(arena_objects, [&](usize i) {
+      arenas[i] = this->recover_page_arena(*arena_objects[i]);
+    });
+  }
+
+  std::vector<PageArena> storage_pool;
+  for (StatusOr<PageArena>& arena : arenas) {
+    BATT_REQUIRE_OK(arena);
+    storage_pool.emplace_back(std::move(*arena));
   }
 
   StatusOr<batt::SharedPtr<PageCache>> page_cache =
@@ -153,19 +292,134 @@ StatusOr<batt::SharedPtr<PageCache>> StorageContext::get_page_cache()
   return page_cache;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<PageArena> StorageContext::recover_page_arena(const StorageObjectInfo& object_info)
+{
+  const auto& packed_arena_config =
+      config_slot_cast<PackedPageArenaConfig>(object_info.p_config_slot.object);
+
+  const std::string base_name =
+      batt::to_string("PageDevice_", packed_arena_config.page_device_uuid);
+
+  // Use the IoRing for the NUMA node of the device's file (which may not be the arena's file).
+  //
+  const batt::SharedPtr<StorageObjectInfo> device_info =
+      this->find_object_by_uuid(packed_arena_config.page_device_uuid);
+
+  const IoRing& io_ring = this->get_page_device_io_ring_for_file(
+      (device_info ? device_info->storage_file : object_info.storage_file)->file_name());
+
+  return this->recover_object(
+      batt::StaticType<PackedPageArenaConfig>{}, object_info.p_config_slot->uuid,
+      PageAllocatorRuntimeOptions{
+          .scheduler = this->scheduler_,
+          .name = batt::to_string(base_name, "_Allocator"),
+      },
+      [&] {
+        IoRingLogDriverOptions options;
+        options.name = batt::to_string(base_name, "_AllocatorLog");
+        return options;
+      }(),
+      IoRingFileRuntimeOptions::with_default_values(io_ring), this->page_device_options_);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<PageArena> StorageContext::make_lazy_page_arena(
+    const batt::SharedPtr<StorageObjectInfo>& object_info)
+{
+  const auto& packed_arena_config =
+      config_slot_cast<PackedPageArenaConfig>(object_info->p_config_slot.object);
+
+  // The page ids and page size of the arena come from its device's config, which has already
+  // been read; nothing is opened until the arena is first used.
+  //
+  batt::SharedPtr<StorageObjectInfo> device_info =
+      this->find_object_by_uuid(packed_arena_config.page_device_uuid);
+  if (!device_info) {
+    return {batt::StatusCode::kNotFound};
+  }
+  if (PackedConfigTagFor<PackedPageDeviceConfig>::value != device_info->p_config_slot->tag) {
+    return ::llfs::make_status(::llfs::StatusCode::kStorageObjectTypeError);
+  }
+
+  const auto& packed_device_config =
+      config_slot_cast<PackedPageDeviceConfig>(device_info->p_config_slot.object);
+
+  const PageIdFactory page_ids{
+      PageCount{BATT_CHECKED_CAST(u64, packed_device_config.page_capacity())},
+      BATT_CHECKED_CAST(page_device_id_int, packed_device_config.device_id.value())};
+
+  const PageSize page_size{BATT_CHECKED_CAST(u32, packed_device_config.page_size())};
+
+  // Capturing a SharedPtr to `this` would make a reference cycle through `this->page_cache_`;
+  // see set_lazy_arena_recovery.
+  //
+  return LazyPageDevice::make_arena(
+      page_ids, page_size, this->scheduler_,
+      batt::to_string("PageDevice_", packed_arena_config.page_device_uuid),
+      [this, object_info]() -> StatusOr<PageArena> {
+        const auto start_time = std::chrono::steady_clock::now();
+
+        StatusOr<PageArena> arena = this->recover_page_arena(*object_info);
+
+        object_info->recover_usec.set(std::chrono::duration_cast<std::chrono::microseconds>(
+                                          std::chrono::steady_clock::now() - start_time)
+                                          .count());
+        return arena;
+      });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void StorageContext::recover_in_parallel(
+    const std::vector<batt::SharedPtr<StorageObjectInfo>>& objects,
+    const std::function<void(usize i)>& recover_fn)
+{
+  std::vector<std::unique_ptr<batt::Task>> tasks;
+
+  for (usize i = 0; i < objects.size(); ++i) {
+    tasks.emplace_back(std::make_unique<batt::Task>(
+        this->scheduler_.schedule_task(),
+        [&objects, &recover_fn, i] {
+          const auto start_time = std::chrono::steady_clock::now();
+
+          recover_fn(i);
+
+          if (objects[i] != nullptr) {
+            objects[i]->recover_usec.set(std::chrono::duration_cast<std::chrono::microseconds>(
+                                             std::chrono::steady_clock::now() - start_time)
+                                             .count());
+          }
+        },
+        batt::to_string("StorageContext.recover_", i)));
+  }
+
+  for (const std::unique_ptr<batt::Task>& task : tasks) {
+    task->join();
+  }
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 batt::BoxedSeq<batt::SharedPtr<StorageObjectInfo>> StorageContext::find_objects_by_tag(u16 tag)
 {
-  return as_seq(this->index_.begin(), this->index_.end())  //
-         | seq::filter_map(
-               [tag](const auto& kv_pair) -> Optional<batt::SharedPtr<StorageObjectInfo>> {
-                 if (kv_pair.second->p_config_slot->tag == tag) {
-                   return kv_pair.second;
-                 } else {
-                   return None;
-                 }
-               })  //
+  // Return a snapshot, so that adding files to the context while the sequence is being consumed
+  // can't invalidate it.
+  //
+  auto objects = std::make_shared<std::vector<batt::SharedPtr<StorageObjectInfo>>>();
+  {
+    auto iter = this->objects_by_tag_.find(tag);
+    if (iter != this->objects_by_tag_.end()) {
+      *objects = iter->second;
+    }
+  }
+
+  return as_seq(boost::irange<usize>(0, objects->size()))  //
+         | seq::map([objects](usize i) {
+             return (*objects)[i];
+           })  //
          | seq::boxed();
 }
 
@@ -16,6 +16,7 @@
 #ifndef LLFS_DISABLE_IO_URING
 
 #include <llfs/ioring.hpp>
+#include <llfs/ioring_page_file_device_options.hpp>
 #include <llfs/packed_config.hpp>
 #include <llfs/page_cache.hpp>
 #include <llfs/page_cache_options.hpp>
@@ -33,6 +34,8 @@
 #include <functional>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace llfs {
 
@@ -55,6 +58,8 @@ class StorageContext : public batt::RefCounted<StorageContext>
   StorageContext& operator=(const StorageContext&) = delete;
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
+  ~StorageContext() noexcept;
+
   batt::TaskScheduler& get_scheduler() const
   {
     return this->scheduler_;
@@ -65,13 +70,62 @@ class StorageContext : public batt::RefCounted<StorageContext>
     return *this->io_ring_;
   }
 
+  /*! \brief Sets the IoRing used for page I/O by the PageDevices recovered in `get_page_cache()`.
+   *
+   * This allows page reads/writes to use a ring configured for polling (see
+   * IoRingOptions::sqpoll/iopoll) while logs and other storage objects keep using the default
+   * IoRing.  Must be called before `get_page_cache()`; `io` must outlive this object.
+   */
+  void set_page_device_io_ring(const IoRing& io);
+
+  /*! \brief Returns the IoRing used for page I/O; this is the default IoRing unless
+   * `set_page_device_io_ring` has been called.
+   */
+  const IoRing& get_page_device_io_ring() const
+  {
+    return this->page_device_io_ring_ ? *this->page_device_io_ring_ : *this->io_ring_;
+  }
+
+  /*! \brief Sets the IoRing used for page I/O by PageDevices (and their allocator logs) whose
+   * storage file is on a device attached to NUMA node `numa_node` (see numa_node_of_file).
+   *
+   * Together with a ring created by ScopedIoRing::make_new_on_numa_node, this keeps the I/O
+   * submission and completion for each device's pages on the node it is attached to.  Devices on
+   * other nodes, or whose node isn't known, use `get_page_device_io_ring()`.  Must be called
+   * before `get_page_cache()`; `io` must outlive this object.
+   */
+  void set_numa_node_io_ring(usize numa_node, const IoRing& io);
+
+  /*! \brief Returns the IoRing used for page I/O on the given storage file: the ring registered
+   * for its NUMA node via `set_numa_node_io_ring`, if there is one; otherwise
+   * `get_page_device_io_ring()`.
+   */
+  const IoRing& get_page_device_io_ring_for_file(const std::string& file_name) const;
+
   /*! \brief Set runtime options for PageCache.
    */
   void set_page_cache_options(const PageCacheOptions& options);
 
+  /*! \brief Set runtime options for the page devices of the PageArenas recovered from now on (for
+   * example, IoRingPageFileDeviceOptions::discard_batch_size to discard dropped pages).
+   */
+  void set_page_device_options(const IoRingPageFileDeviceOptions& options);
+
+  /*! \brief If `lazy` is true, `get_page_cache()` doesn't recover any PageArenas; each arena is
+   * registered with the PageCache right away and recovered (in the background) the first time it
+   * is used.  See LazyPageDevice.
+   *
+   * Must be called before `get_page_cache()`.  With lazy recovery, this object must outlive the
+   * PageCache, and an arena that fails to recover only reports the error when it is used.
+   */
+  void set_lazy_arena_recovery(bool lazy);
+
   // Returns a PageCache object that can be used to access all PageDevices in the StorageContext.
   // The PageCache is created the first time this function is called, and cached to be returned on
-  // subsequent calls.
+  // subsequent calls.  All PageArenas are recovered in parallel, each on its own task (unless lazy
+  // arena recovery is enabled; see set_lazy_arena_recovery).
+  //
+  // The first call must not race with any other call.
   //
   StatusOr<batt::SharedPtr<PageCache>> get_page_cache();
 
@@ -81,7 +135,8 @@ class StorageContext : public batt::RefCounted<StorageContext>
   batt::SharedPtr<StorageObjectInfo> find_object_by_uuid(const boost::uuids::uuid& uuid);
 
   // Returns a sequence of StorageObjectInfo for all objects with the type named by the passed
-  // `tag`.  See `PackedConfigSlotBase::Tag`.
+  // `tag`.  See `PackedConfigSlotBase::Tag`.  The sequence is a snapshot, so it stays valid (and
+  // unchanged) if files are added to this context while it is held.
   //
   batt::BoxedSeq<batt::SharedPtr<StorageObjectInfo>> find_objects_by_tag(u16 tag);
 
@@ -89,6 +144,11 @@ class StorageContext : public batt::RefCounted<StorageContext>
   //
   Status add_existing_named_file(std::string&& file_name, i64 start_offset = 0);
 
+  // Adds already existing files to this context.  The files' config blocks are read in parallel;
+  // the files are then added in the order given.  If any file can't be read or added, none are.
+  //
+  Status add_existing_named_files(std::vector<std::string>&& file_names, i64 start_offset = 0);
+
   // Creates a new file with the given name by invoking the passed `initializer` function to build
   // storage objects.
   //
@@ -130,8 +190,63 @@ class StorageContext : public batt::RefCounted<StorageContext>
                                   BATT_FORWARD(extra_options)...);
   }
 
+  // Recovers several objects of a given type at once, each on its own task, and returns the
+  // results in the same order as `requests` (uuid plus extra options for each object).
+  //
+  // Most storage objects (e.g., Volumes) attach to the PageAllocators of the PageCache, so the
+  // PageCache is brought up (see `get_page_cache`) before any of the requested objects; if that
+  // fails, its error is returned for every object.
+  //
+  template <typename PackedConfigT, typename ExtraConfigOptions,
+            typename R = decltype(recover_storage_object(
+                std::declval<batt::SharedPtr<StorageContext>>(), std::declval<const std::string&>(),
+                std::declval<FileOffsetPtr<const PackedConfigT&>>(),
+                std::declval<ExtraConfigOptions>()))  //
+            >
+  std::vector<R> recover_objects(
+      batt::StaticType<PackedConfigT> type,
+      std::vector<std::pair<boost::uuids::uuid, ExtraConfigOptions>>&& requests)
+  {
+    std::vector<R> results;
+    results.reserve(requests.size());
+
+    StatusOr<batt::SharedPtr<PageCache>> page_cache = this->get_page_cache();
+    for (usize i = 0; i < requests.size(); ++i) {
+      results.emplace_back(page_cache.ok() ? Status{batt::StatusCode::kUnknown}
+                                           : page_cache.status());
+    }
+    if (!page_cache.ok()) {
+      return results;
+    }
+
+    std::vector<batt::SharedPtr<StorageObjectInfo>> objects;
+    for (const auto& [uuid, extra_options] : requests) {
+      objects.emplace_back(this->find_object_by_uuid(uuid));
+    }
+
+    this->recover_in_parallel(objects, [&](usize i) {
+      results[i] = this->recover_object(type, requests[i].first, std::move(requests[i].second));
+    });
+
+    return results;
+  }
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
  private:
+  // Calls `recover_fn(i)` for each index `i` into `objects`, each on its own task, and waits for
+  // all of them to finish.  Updates the `recover_usec` metric of each (non-null) object.
+  //
+  void recover_in_parallel(const std::vector<batt::SharedPtr<StorageObjectInfo>>& objects,
+                           const std::function<void(usize i)>& recover_fn);
+
+  // Recovers the PageArena (device and allocator) described by `object_info`.
+  //
+  StatusOr<PageArena> recover_page_arena(const StorageObjectInfo& object_info);
+
+  // Returns a PageArena for `object_info` that is recovered the first time it is used.
+  //
+  StatusOr<PageArena> make_lazy_page_arena(const batt::SharedPtr<StorageObjectInfo>& object_info);
+
   // Passed in at creation time; used to schedule all background tasks needed by recovered objects
   // and the PageCache.
   //
@@ -141,16 +256,38 @@ class StorageContext : public batt::RefCounted<StorageContext>
   //
   const IoRing* io_ring_;
 
+  // If non-null, the IoRing used by page devices (see set_page_device_io_ring).
+  //
+  const IoRing* page_device_io_ring_ = nullptr;
+
+  // The IoRings used for page I/O on each NUMA node (see set_numa_node_io_ring), indexed by node;
+  // nullptr for nodes without one.
+  //
+  std::vector<const IoRing*> numa_node_io_rings_;
+
   // An index of all storage objects by uuid.
   //
   std::unordered_map<boost::uuids::uuid, batt::SharedPtr<StorageObjectInfo>,
                      boost::hash<boost::uuids::uuid>>
       index_;
 
+  // The same objects as `index_`, grouped by config slot tag (see `PackedConfigSlotBase::Tag`), in
+  // the order they were added.
+  //
+  std::unordered_map<u16, std::vector<batt::SharedPtr<StorageObjectInfo>>> objects_by_tag_;
+
   // Options that will be used to instantiate `this->page_cache_`.
   //
   PageCacheOptions page_cache_options_ = PageCacheOptions::with_default_values();
 
+  // Options for the page devices of recovered arenas (see set_page_device_options).
+  //
+  IoRingPageFileDeviceOptions page_device_options_;
+
+  // See set_lazy_arena_recovery.
+  //
+  bool lazy_arena_recovery_ = false;
+
   // The PageCache for this context; this is lazily created the first time
   // `StorageContext::get_page_cache()` is called.
   //
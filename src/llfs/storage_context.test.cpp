@@ -15,7 +15,9 @@
 
 #include <llfs/constants.hpp>
 #include <llfs/ioring_log_device.hpp>
+#include <llfs/numa.hpp>
 #include <llfs/page_arena_config.hpp>
+#include <llfs/page_device_config.hpp>
 #include <llfs/raw_block_file_impl.hpp>
 #include <llfs/uuid.hpp>
 
@@ -136,6 +138,161 @@ TEST(StorageContextTest, GetPageCache)
   llfs::Slice<llfs::PageCache::PageDeviceEntry* const> devices_2mb =
       (*cache)->devices_with_page_size(2 * kMiB);
   EXPECT_EQ(devices_2mb.size(), 1u);
+
+  // The arenas are recovered in parallel; each one's recovery time is recorded.
+  //
+  for (const boost::uuids::uuid& uuid : {arena_uuid_4kb, arena_uuid_2mb}) {
+    batt::SharedPtr<llfs::StorageObjectInfo> info = storage_context->find_object_by_uuid(uuid);
+    ASSERT_NE(info, nullptr);
+    EXPECT_GT(info->recover_usec.load(), 0u);
+  }
+}
+
+// Test Plan:
+//  1. Create several storage files, each with one page device, using one StorageContext.
+//  2. Add all of them to a second StorageContext with `add_existing_named_files`; verify that
+//     `find_objects_by_tag` returns every page device, in the order the files were given.
+//  3. Adding a list of files where one doesn't exist fails and adds nothing.
+//  4. A sequence returned by `find_objects_by_tag` is a snapshot: adding more files while it is
+//     held doesn't change what it yields.
+//
+TEST(StorageContextTest, AddExistingNamedFiles)
+{
+  using Tag = llfs::PackedConfigSlotBase::Tag;
+
+  constexpr usize kNumFiles = 4;
+
+  llfs::StatusOr<llfs::ScopedIoRing> io =
+      llfs::ScopedIoRing::make_new(llfs::MaxQueueDepth{64}, llfs::ThreadPoolSize{1});
+
+  ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+
+  batt::SharedPtr<llfs::StorageContext> create_context = batt::make_shared<llfs::StorageContext>(
+      batt::Runtime::instance().default_scheduler(), io->get_io_ring());
+
+  const auto count_objects_with_tag = [](llfs::StorageContext& context, u16 tag) -> usize {
+    return (context.find_objects_by_tag(tag) | llfs::seq::collect_vec()).size();
+  };
+
+  std::vector<std::string> file_names;
+  std::vector<boost::uuids::uuid> device_uuids;
+
+  for (usize i = 0; i < kNumFiles; ++i) {
+    const std::string file_name =
+        batt::to_string("/tmp/llfs_StorageContextTest_AddExistingNamedFiles_", i, ".llfs");
+
+    llfs::delete_file(file_name).IgnoreError();
+
+    const boost::uuids::uuid device_uuid = llfs::random_uuid();
+
+    llfs::Status create_status = create_context->add_new_file(
+        file_name, [&](llfs::StorageFileBuilder& builder) -> llfs::Status {
+          llfs::StatusOr<llfs::FileOffsetPtr<const llfs::PackedPageDeviceConfig&>> config =
+              builder.add_object(llfs::PageDeviceConfigOptions{
+                  .uuid = device_uuid,
+                  .device_id = llfs::None,
+                  .page_count = llfs::PageCount{4},
+                  .page_size_log2 = llfs::PageSizeLog2{12},
+              });
+
+          BATT_REQUIRE_OK(config);
+
+          return llfs::OkStatus();
+        });
+
+    ASSERT_TRUE(create_status.ok()) << BATT_INSPECT(create_status);
+
+    file_names.emplace_back(file_name);
+    device_uuids.emplace_back(device_uuid);
+  }
+
+  // Each new file was added to the context that created it.
+  //
+  EXPECT_EQ(count_objects_with_tag(*create_context, Tag::kPageDevice), kNumFiles);
+
+  batt::SharedPtr<llfs::StorageContext> storage_context = batt::make_shared<llfs::StorageContext>(
+      batt::Runtime::instance().default_scheduler(), io->get_io_ring());
+
+  {
+    std::vector<std::string> names_with_missing_file = file_names;
+    names_with_missing_file.emplace_back(
+        "/tmp/llfs_StorageContextTest_AddExistingNamedFiles_missing.llfs");
+
+    llfs::Status add_status =
+        storage_context->add_existing_named_files(std::move(names_with_missing_file));
+
+    EXPECT_FALSE(add_status.ok());
+    EXPECT_EQ(count_objects_with_tag(*storage_context, Tag::kPageDevice), 0u);
+  }
+
+  // Add the files in two batches, taking a sequence in between.
+  //
+  const usize first_batch_size = kNumFiles / 2;
+  {
+    std::vector<std::string> first_batch(file_names.begin(),
+                                         file_names.begin() + first_batch_size);
+    llfs::Status add_status = storage_context->add_existing_named_files(std::move(first_batch));
+    ASSERT_TRUE(add_status.ok()) << BATT_INSPECT(add_status);
+  }
+
+  llfs::BoxedSeq<batt::SharedPtr<llfs::StorageObjectInfo>> before_second_batch =
+      storage_context->find_objects_by_tag(Tag::kPageDevice);
+  {
+    std::vector<std::string> second_batch(file_names.begin() + first_batch_size,
+                                          file_names.end());
+    llfs::Status add_status = storage_context->add_existing_named_files(std::move(second_batch));
+    ASSERT_TRUE(add_status.ok()) << BATT_INSPECT(add_status);
+  }
+
+  EXPECT_EQ((std::move(before_second_batch) | llfs::seq::collect_vec()).size(), first_batch_size);
+
+  std::vector<boost::uuids::uuid> found_uuids;
+  storage_context->find_objects_by_tag(Tag::kPageDevice)  //
+      | llfs::seq::for_each([&](const batt::SharedPtr<llfs::StorageObjectInfo>& info) {
+          EXPECT_EQ(info->p_config_slot->tag, Tag::kPageDevice);
+          found_uuids.emplace_back(info->p_config_slot->uuid);
+        });
+
+  EXPECT_EQ(found_uuids, device_uuids);
+
+  EXPECT_EQ(count_objects_with_tag(*storage_context, Tag::kPageArena), 0u);
+
+  for (const std::string& file_name : file_names) {
+    llfs::delete_file(file_name).IgnoreError();
+  }
+}
+
+// Test Plan:
+//  1. With no NUMA node rings registered, page I/O on any file uses the page device IoRing.
+//  2. With a ring registered for every NUMA node, a file uses that ring iff the node of its device
+//     is known (numa_node_of_file); otherwise it still uses the page device IoRing.
+//
+TEST(StorageContextTest, NumaNodeIoRing)
+{
+  llfs::StatusOr<llfs::ScopedIoRing> io =
+      llfs::ScopedIoRing::make_new(llfs::MaxQueueDepth{64}, llfs::ThreadPoolSize{1});
+  ASSERT_TRUE(io.ok()) << BATT_INSPECT(io.status());
+
+  llfs::StatusOr<llfs::ScopedIoRing> node_io = llfs::ScopedIoRing::make_new_on_numa_node(
+      llfs::IoRingOptions::with_default_values().set_queue_depth(llfs::MaxQueueDepth{64}),
+      llfs::ThreadPoolSize{1}, /*numa_node=*/0);
+  ASSERT_TRUE(node_io.ok()) << BATT_INSPECT(node_io.status());
+
+  batt::SharedPtr<llfs::StorageContext> storage_context = batt::make_shared<llfs::StorageContext>(
+      batt::Runtime::instance().default_scheduler(), io->get_io_ring());
+
+  const std::string file_name = "/proc/self/exe";
+
+  EXPECT_EQ(&storage_context->get_page_device_io_ring_for_file(file_name), &io->get_io_ring());
+
+  for (usize node = 0; node < llfs::numa_node_count(); ++node) {
+    storage_context->set_numa_node_io_ring(node, node_io->get_io_ring());
+  }
+
+  const llfs::IoRing* expected_io_ring =
+      llfs::numa_node_of_file(file_name) ? &node_io->get_io_ring() : &io->get_io_ring();
+
+  EXPECT_EQ(&storage_context->get_page_device_io_ring_for_file(file_name), expected_io_ring);
 }
 
 }  // namespace
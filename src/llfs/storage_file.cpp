@@ -9,16 +9,27 @@
 #include <llfs/storage_file.hpp>
 //
 
+#include <llfs/filesystem.hpp>
 #include <llfs/status_code.hpp>
 
+#include <batteries/checked_cast.hpp>
+#include <batteries/finally.hpp>
 #include <batteries/math.hpp>
 
+#include <sys/mman.h>
+
+#include <cerrno>
+
 namespace llfs {
 
-//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+namespace {
+
+// Reads the chain of config blocks starting at `start_offset`, using `read_block(offset)` to read
+// each one.
 //
-StatusOr<std::vector<std::unique_ptr<StorageFileConfigBlock>>> read_storage_file(RawBlockFile& file,
-                                                                                 i64 start_offset)
+template <typename ReadBlockFn>
+StatusOr<std::vector<std::unique_ptr<StorageFileConfigBlock>>> read_config_block_chain(
+    i64 start_offset, ReadBlockFn&& read_block)
 {
   std::vector<std::unique_ptr<StorageFileConfigBlock>> blocks;
 
@@ -29,8 +40,7 @@ StatusOr<std::vector<std::unique_ptr<StorageFileConfigBlock>>> read_storage_file
 
   i64 offset = aligned_start;
   for (;;) {
-    StatusOr<std::unique_ptr<StorageFileConfigBlock>> next_block =
-        StorageFileConfigBlock::read_from_raw_block_file(file, offset);
+    StatusOr<std::unique_ptr<StorageFileConfigBlock>> next_block = read_block(offset);
     BATT_REQUIRE_OK(next_block);
 
     const PackedConfigBlock& block = next_block->get()->get_const();
@@ -55,6 +65,57 @@ StatusOr<std::vector<std::unique_ptr<StorageFileConfigBlock>>> read_storage_file
   return blocks;
 }
 
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::vector<std::unique_ptr<StorageFileConfigBlock>>> read_storage_file(RawBlockFile& file,
+                                                                                 i64 start_offset)
+{
+  return read_config_block_chain(start_offset, [&file](i64 offset) {
+    return StorageFileConfigBlock::read_from_raw_block_file(file, offset);
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::vector<std::unique_ptr<StorageFileConfigBlock>>> read_storage_file_mapped(
+    std::string_view file_name, i64 start_offset)
+{
+  StatusOr<int> fd = open_file_read_only(file_name, OpenRawIO{false});
+  BATT_REQUIRE_OK(fd);
+
+  auto on_scope_exit = batt::finally([&] {
+    close_fd(*fd).IgnoreError();
+  });
+
+  StatusOr<i64> file_size = sizeof_fd(*fd);
+  BATT_REQUIRE_OK(file_size);
+
+  // mmap rejects zero-length mappings; an empty file has no config blocks to find.
+  //
+  if (*file_size == 0) {
+    return {batt::StatusCode::kOutOfRange};
+  }
+
+  const usize mapped_size = batt::checked_cast<usize>(*file_size);
+
+  void* const mapped = ::mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, *fd, /*offset=*/0);
+  if (mapped == MAP_FAILED) {
+    return batt::status_from_errno(errno);
+  }
+
+  auto unmap_on_scope_exit = batt::finally([&] {
+    ::munmap(mapped, mapped_size);
+  });
+
+  const ConstBuffer file_data{mapped, mapped_size};
+
+  return read_config_block_chain(start_offset, [&file_data](i64 offset) {
+    return StorageFileConfigBlock::read_from_memory(file_data, offset);
+  });
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 /*explicit*/ StorageFile::StorageFile(
@@ -19,6 +19,7 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace llfs {
@@ -26,6 +27,12 @@ namespace llfs {
 StatusOr<std::vector<std::unique_ptr<StorageFileConfigBlock>>> read_storage_file(RawBlockFile& file,
                                                                                  i64 start_offset);
 
+// Same as `read_storage_file`, but maps the named file into memory and reads the config blocks
+// from the mapping, rather than issuing (and waiting on) one read per block.
+//
+StatusOr<std::vector<std::unique_ptr<StorageFileConfigBlock>>> read_storage_file_mapped(
+    std::string_view file_name, i64 start_offset);
+
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 //
 class StorageFile : public batt::RefCounted<StorageFile>
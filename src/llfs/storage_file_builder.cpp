@@ -18,8 +18,70 @@
 
 #include <boost/uuid/random_generator.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 namespace llfs {
 
+namespace {
+
+// A RawBlockFile that forwards to another, serializing size changes.  Pre-flush actions write to
+// disjoint regions of the file, but `truncate_at_least` is a read-modify-write of the file size, so
+// two actions racing to grow the file could shrink it.
+//
+class SerializedResizeRawBlockFile : public RawBlockFile
+{
+ public:
+  explicit SerializedResizeRawBlockFile(RawBlockFile& file) noexcept : file_{file}
+  {
+  }
+
+  StatusOr<i64> write_some(i64 offset, const ConstBuffer& data) override
+  {
+    return this->file_.write_some(offset, data);
+  }
+
+  StatusOr<i64> read_some(i64 offset, const MutableBuffer& buffer) override
+  {
+    return this->file_.read_some(offset, buffer);
+  }
+
+  StatusOr<i64> get_size() override
+  {
+    std::unique_lock<std::mutex> lock{this->resize_mutex_};
+    return this->file_.get_size();
+  }
+
+  Status truncate(i64 new_offset_upper_bound) override
+  {
+    std::unique_lock<std::mutex> lock{this->resize_mutex_};
+    return this->file_.truncate(new_offset_upper_bound);
+  }
+
+  Status truncate_at_least(i64 minimum_size) override
+  {
+    std::unique_lock<std::mutex> lock{this->resize_mutex_};
+    return this->file_.truncate_at_least(minimum_size);
+  }
+
+#ifndef LLFS_DISABLE_IO_URING
+  //
+  IoRing::File* get_io_ring_file() override
+  {
+    return this->file_.get_io_ring_file();
+  }
+  //
+#endif  // LLFS_DISABLE_IO_URING
+
+ private:
+  RawBlockFile& file_;
+  std::mutex resize_mutex_;
+};
+
+}  // namespace
+
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 // class StorageFileBuilder
 //+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -44,9 +106,42 @@ Status StorageFileBuilder::flush_all()
   // First run pre-flush actions to write any data referred to or required by the committed config
   // blocks.
   //
-  for (auto action : this->pre_flush_actions_) {
-    Status result = action(this->file_);
+  if (this->pre_flush_actions_.size() == 1) {
+    Status result = this->pre_flush_actions_.front()(this->file_);
     BATT_REQUIRE_OK(result);
+
+  } else if (!this->pre_flush_actions_.empty()) {
+    SerializedResizeRawBlockFile file{this->file_};
+
+    std::vector<Status> results(this->pre_flush_actions_.size());
+    std::atomic<usize> next_action{0};
+
+    const auto run_actions = [&] {
+      for (;;) {
+        const usize i = next_action.fetch_add(1);
+        if (i >= this->pre_flush_actions_.size()) {
+          break;
+        }
+        results[i] = this->pre_flush_actions_[i](file);
+      }
+    };
+
+    const usize thread_count =
+        std::min(this->pre_flush_actions_.size(), kMaxConcurrentPreFlushActions);
+
+    std::vector<std::thread> threads;
+    for (usize i = 1; i < thread_count; ++i) {
+      threads.emplace_back(run_actions);
+    }
+    run_actions();
+
+    for (std::thread& t : threads) {
+      t.join();
+    }
+
+    for (const Status& result : results) {
+      BATT_REQUIRE_OK(result);
+    }
   }
 
   // Write the config blocks in reverse order so that we never see an incomplete chain on recovery.
@@ -27,6 +27,10 @@ class StorageFileBuilder
  public:
   using PreFlushAction = std::function<Status(RawBlockFile&)>;
 
+  // The maximum number of pre-flush actions that `flush_all` runs at the same time.
+  //
+  static constexpr usize kMaxConcurrentPreFlushActions = 16;
+
   class Transaction;
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -41,6 +45,12 @@ class StorageFileBuilder
 
   // Flush all storage object configs to the underlying storage file.
   //
+  // The pre-flush actions required by the added objects (e.g., initializing log device blocks)
+  // each touch a disjoint region of the file, so they are run concurrently, on up to
+  // kMaxConcurrentPreFlushActions threads; calls to `RawBlockFile::truncate` and
+  // `RawBlockFile::truncate_at_least` are serialized.  The config blocks are written only after
+  // all the actions have succeeded.
+  //
   Status flush_all();
 
  private:
@@ -10,6 +10,7 @@
 //
 #include <llfs/storage_file_builder.hpp>
 
+#include <algorithm>
 #include <random>
 
 #include <gmock/gmock.h>
@@ -17,6 +18,8 @@
 
 #include <llfs/filesystem.hpp>
 #include <llfs/ioring.hpp>
+#include <llfs/ioring_log_device.hpp>
+#include <llfs/log_device_config.hpp>
 #include <llfs/page_device.hpp>
 #include <llfs/page_device_config.hpp>
 #include <llfs/raw_block_file_impl.hpp>
@@ -251,13 +254,22 @@ TEST_F(StorageFileBuilderTest, PageDeviceConfig_Flush)
           .WillOnce(::testing::Return(llfs::OkStatus()));
 
       if (!llfs::kFastIoRingPageDeviceInit) {
+        // Pages up to 1MiB are written whole, as many as fit in 1MiB per write; larger pages get a
+        // 512-byte header write each.
+        //
+        const usize kPagesPerWrite = std::max<usize>(1, (1024 * 1024) / kTestPageSize);
+        const usize kMaxWriteSize = (kPagesPerWrite == 1) ? 512 : kPagesPerWrite * kTestPageSize;
+        const usize kWriteCount = (options.page_count + kPagesPerWrite - 1) / kPagesPerWrite;
+
         EXPECT_CALL(file_mock, write_some(::testing::Gt(kExpectedConfigBlockOffset),
-                                          ::testing::Truly([](const llfs::ConstBuffer& b) {
-                                            return b.size() == 512;
+                                          ::testing::Truly([&](const llfs::ConstBuffer& b) {
+                                            return b.size() <= kMaxWriteSize;
                                           })))
-            .Times(options.page_count)
+            .Times(kWriteCount)
             .InSequence(flush_sequence)
-            .WillRepeatedly(::testing::Return(512));
+            .WillRepeatedly(::testing::Invoke([](i64, const llfs::ConstBuffer& b) {
+              return llfs::StatusOr<i64>{static_cast<i64>(b.size())};
+            }));
       }
 
       EXPECT_CALL(file_mock,
@@ -283,6 +295,41 @@ TEST_F(StorageFileBuilderTest, PageDeviceConfig_Flush)
   }
 }
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+//
+TEST_F(StorageFileBuilderTest, PreFlushActionFailure)
+{
+  constexpr usize kNumObjects = 4;
+
+  ::testing::StrictMock<llfs::RawBlockFileMock> file_mock;
+
+  llfs::StorageFileBuilder builder{file_mock, /*base_offset=*/0};
+
+  for (usize i = 0; i < kNumObjects; ++i) {
+    llfs::StatusOr<llfs::FileOffsetPtr<const llfs::PackedPageDeviceConfig&>> packed_config =
+        builder.add_object(llfs::PageDeviceConfigOptions{
+            .uuid = llfs::None,
+            .device_id = llfs::None,
+            .page_count = llfs::PageCount{kTestPageCount},
+            .page_size_log2 = llfs::PageSizeLog2{12},
+        });
+
+    ASSERT_TRUE(packed_config.ok()) << BATT_INSPECT(packed_config.status());
+  }
+
+  // The pre-flush actions run concurrently; all of them run even though one fails, and no config
+  // block is written (StrictMock fails the test on any write_some).
+  //
+  EXPECT_CALL(file_mock, truncate_at_least(::testing::_))
+      .Times(kNumObjects)
+      .WillOnce(::testing::Return(llfs::Status{batt::StatusCode::kInternal}))
+      .WillRepeatedly(::testing::Return(llfs::OkStatus()));
+
+  llfs::Status flush_status = builder.flush_all();
+
+  EXPECT_EQ(flush_status, batt::StatusCode::kInternal);
+}
+
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 //
 TEST_F(StorageFileBuilderTest, WriteReadFile)
@@ -482,4 +529,102 @@ TEST_F(StorageFileBuilderTest, WriteReadManyPackedConfigs)
   ASSERT_TRUE(recovered_device.ok()) << BATT_INSPECT(recovered_device.status());
 }
 
+//---------------------------------------------------------------------------------------------------
+// Format several logs (and a page device) in one flush_all, so their initializers run concurrently
+// on the same IoRing; then verify that every log can be recovered and opened, and is empty.
+//
+TEST_F(StorageFileBuilderTest, WriteReadManyLogs)
+{
+  constexpr usize kNumLogs = 4;
+
+  llfs::StatusOr<llfs::ScopedIoRing> ioring =
+      llfs::ScopedIoRing::make_new(llfs::MaxQueueDepth{1024}, llfs::ThreadPoolSize{1});
+
+  ASSERT_TRUE(ioring.ok()) << BATT_INSPECT(ioring.status());
+
+  auto storage_context = batt::make_shared<llfs::StorageContext>(
+      batt::Runtime::instance().default_scheduler(), ioring->get_io_ring());
+
+  const char* const test_file_name = "/tmp/llfs_test_file";
+  std::filesystem::remove(test_file_name);
+
+  std::vector<boost::uuids::uuid> log_uuids;
+  {
+    llfs::StatusOr<int> test_fd =
+        llfs::create_file_read_write(test_file_name, llfs::OpenForAppend{false});
+    ASSERT_TRUE(test_fd.ok()) << BATT_INSPECT(test_fd.status());
+    {
+      llfs::Status status = llfs::enable_raw_io_fd(*test_fd, /*enabled=*/true);
+      EXPECT_TRUE(status.ok()) << BATT_INSPECT(status);
+    }
+    llfs::IoRingRawBlockFile test_file{llfs::IoRing::File{ioring->get_io_ring(), *test_fd}};
+
+    {
+      llfs::StorageFileBuilder builder{test_file, /*base_offset=*/0};
+
+      for (usize i = 0; i < kNumLogs; ++i) {
+        llfs::StatusOr<llfs::FileOffsetPtr<const llfs::PackedLogDeviceConfig&>> packed_config =
+            builder.add_object(llfs::LogDeviceConfigOptions{
+                .uuid = llfs::None,
+                .pages_per_block_log2 = llfs::None,
+                .log_size = 64 * 1024,
+            });
+
+        ASSERT_TRUE(packed_config.ok()) << BATT_INSPECT(packed_config.status());
+
+        log_uuids.emplace_back((*packed_config)->uuid);
+      }
+
+      llfs::StatusOr<llfs::FileOffsetPtr<const llfs::PackedPageDeviceConfig&>> packed_config =
+          builder.add_object(llfs::PageDeviceConfigOptions{
+              .uuid = llfs::None,
+              .device_id = llfs::None,
+              .page_count = llfs::PageCount{kTestPageCount},
+              .page_size_log2 = llfs::PageSizeLog2{12},
+          });
+
+      ASSERT_TRUE(packed_config.ok()) << BATT_INSPECT(packed_config.status());
+
+      llfs::Status flush_status = builder.flush_all();
+
+      ASSERT_TRUE(flush_status.ok()) << BATT_INSPECT(flush_status);
+    }
+
+    llfs::StatusOr<std::vector<std::unique_ptr<llfs::StorageFileConfigBlock>>> config_blocks =
+        llfs::read_storage_file(test_file, /*start_offset=*/0);
+
+    ASSERT_TRUE(config_blocks.ok()) << BATT_INSPECT(config_blocks.status());
+
+    auto storage_file =
+        batt::make_shared<llfs::StorageFile>(test_file_name, std::move(*config_blocks));
+
+    EXPECT_EQ(
+        storage_file->find_objects_by_type<llfs::PackedLogDeviceConfig>() | llfs::seq::count(),
+        kNumLogs);
+
+    llfs::Status status = storage_context->add_existing_file(storage_file);
+    ASSERT_TRUE(status.ok()) << BATT_INSPECT(status);
+  }
+
+  for (const boost::uuids::uuid& log_uuid : log_uuids) {
+    llfs::StatusOr<std::unique_ptr<llfs::IoRingLogDeviceFactory>> log_device_factory =
+        storage_context->recover_object(batt::StaticType<llfs::PackedLogDeviceConfig>{}, log_uuid,
+                                        llfs::IoRingLogDriverOptions::with_default_values()
+                                            .set_name("test_log")
+                                            .set_queue_depth(2));
+
+    ASSERT_TRUE(log_device_factory.ok()) << BATT_INSPECT(log_device_factory.status());
+
+    llfs::StatusOr<std::unique_ptr<llfs::IoRingLogDevice>> log_device =
+        (**log_device_factory).open_ioring_log_device();
+
+    ASSERT_TRUE(log_device.ok()) << BATT_INSPECT(log_device.status());
+
+    EXPECT_EQ((*log_device)->slot_range(llfs::LogReadMode::kDurable).size(), 0u);
+
+    llfs::Status close_status = (*log_device)->close();
+    EXPECT_TRUE(close_status.ok()) << BATT_INSPECT(close_status);
+  }
+}
+
 }  // namespace
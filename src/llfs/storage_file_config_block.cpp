@@ -9,6 +9,8 @@
 #include <llfs/storage_file_config_block.hpp>
 //
 
+#include <batteries/checked_cast.hpp>
+
 namespace llfs {
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -41,6 +43,27 @@ StorageFileConfigBlock::read_from_raw_block_file(RawBlockFile& file, i64 offset)
 
   return config_block;
 }
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<std::unique_ptr<StorageFileConfigBlock>>
+StorageFileConfigBlock::read_from_memory(const ConstBuffer& file_data, i64 offset)
+{
+  if (offset < 0 || batt::checked_cast<usize>(offset) > file_data.size() ||
+      file_data.size() - batt::checked_cast<usize>(offset) < sizeof(PackedConfigBlock)) {
+    return {batt::StatusCode::kOutOfRange};
+  }
+
+  auto config_block = std::make_unique<StorageFileConfigBlock>(offset);
+
+  std::memcpy(&config_block->block_, static_cast<const u8*>(file_data.data()) + offset,
+              sizeof(PackedConfigBlock));
+
+  config_block->dirty_ = false;
+
+  return config_block;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 /*explicit*/ StorageFileConfigBlock::StorageFileConfigBlock(i64 file_offset) noexcept
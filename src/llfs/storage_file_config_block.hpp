@@ -27,6 +27,13 @@ class StorageFileConfigBlock
   static StatusOr<std::unique_ptr<StorageFileConfigBlock>> read_from_raw_block_file(
       RawBlockFile& file, i64 offset);
 
+  // Copies the block at `offset` out of `file_data`, the entire contents of a file (e.g., mapped
+  // into memory).  Returns `batt::StatusCode::kOutOfRange` if the block doesn't fit in
+  // `file_data`.
+  //
+  static StatusOr<std::unique_ptr<StorageFileConfigBlock>> read_from_memory(
+      const ConstBuffer& file_data, i64 offset);
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   explicit StorageFileConfigBlock(i64 file_offset) noexcept;
@@ -11,6 +11,7 @@
 #define LLFS_STORAGE_OBJECT_INFO_HPP
 
 #include <llfs/int_types.hpp>
+#include <llfs/metrics.hpp>
 #include <llfs/packed_config.hpp>
 #include <llfs/page_id_factory.hpp>
 #include <llfs/page_size.hpp>
@@ -30,6 +31,11 @@ struct StorageObjectInfo : batt::RefCounted<StorageObjectInfo> {
 
   batt::SharedPtr<StorageFile> storage_file;
   FileOffsetPtr<const PackedConfigSlot&> p_config_slot;
+
+  // How long it took to recover this object (in microseconds) the last time it was recovered by
+  // StorageContext::get_page_cache or StorageContext::recover_objects; zero if it hasn't been.
+  //
+  CountMetric<u64> recover_usec{0};
 };
 
 }  // namespace llfs
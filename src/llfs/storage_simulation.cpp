@@ -153,6 +153,25 @@ void StorageSimulation::handle_events()
         });
 
     if (!next_event_handler) {
+      // Nothing can run at the current simulated time; advance the clock to the earliest timed
+      // event and release every event due at that time.
+      //
+      if (!this->timed_events_.empty()) {
+        const u64 next_time_nsec = this->timed_events_.begin()->first;
+
+        LLFS_LOG_SIM_EVENT() << "advancing simulated time to " << next_time_nsec
+                             << "ns; step=" << step;
+
+        this->simulated_time_nsec_.set_value(next_time_nsec);
+
+        while (!this->timed_events_.empty() &&
+               this->timed_events_.begin()->first == next_time_nsec) {
+          this->post(std::move(this->timed_events_.begin()->second));
+          this->timed_events_.erase(this->timed_events_.begin());
+        }
+        continue;
+      }
+
       LLFS_LOG_SIM_EVENT() << "no more events to handle";
       return;
     }
@@ -181,6 +200,8 @@ std::unique_ptr<LogDevice> StorageSimulation::get_log_device(const std::string&
     iter = this->log_devices_
                .emplace(name, std::make_shared<SimulatedLogDevice::Impl>(*this, name, *capacity))
                .first;
+
+    iter->second->set_timing_model(this->default_timing_model_);
   }
 
   // At this point we should have a valid entry.
@@ -216,6 +237,8 @@ std::unique_ptr<PageDevice> StorageSimulation::get_page_device(const std::string
 
     BATT_CHECK_NOT_NULLPTR(iter->second);
 
+    iter->second->set_timing_model(this->default_timing_model_);
+
     this->page_device_id_map_.emplace(next_page_device_id, iter->second);
   }
 
@@ -383,6 +406,62 @@ StatusOr<std::unique_ptr<Volume>> StorageSimulation::get_volume(
   return Volume::recover(std::move(params), slot_visitor_fn);
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void StorageSimulation::set_timing_model(const Optional<SimulatedDeviceTimingModel>& model)
+{
+  this->log_event("set_timing_model(", model ? "ON" : "OFF", ")");
+
+  this->default_timing_model_ = model;
+
+  for (const auto& [name, p_log_device_impl] : this->log_devices_) {
+    p_log_device_impl->set_timing_model(model);
+  }
+  for (const auto& [name, p_page_device_impl] : this->page_devices_) {
+    p_page_device_impl->set_timing_model(model);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void StorageSimulation::set_timing_model(const std::string& device_name,
+                                         const Optional<SimulatedDeviceTimingModel>& model)
+{
+  this->log_event("set_timing_model(", batt::c_str_literal(device_name), ", ",
+                  model ? "ON" : "OFF", ")");
+
+  if (auto iter = this->log_devices_.find(device_name); iter != this->log_devices_.end()) {
+    iter->second->set_timing_model(model);
+    return;
+  }
+
+  auto iter = this->page_devices_.find(device_name);
+  BATT_CHECK_NE(iter, this->page_devices_.end())
+      << "No simulated device named " << batt::c_str_literal(device_name);
+
+  iter->second->set_timing_model(model);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::map<std::string, SimulatedDeviceTimingStats> StorageSimulation::device_timing_stats() const
+{
+  std::map<std::string, SimulatedDeviceTimingStats> result;
+
+  for (const auto& [name, p_log_device_impl] : this->log_devices_) {
+    if (Optional<SimulatedDeviceTimingStats> stats = p_log_device_impl->timing_stats()) {
+      result.emplace(name, *stats);
+    }
+  }
+  for (const auto& [name, p_page_device_impl] : this->page_devices_) {
+    if (Optional<SimulatedDeviceTimingStats> stats = p_page_device_impl->timing_stats()) {
+      result.emplace(name, *stats);
+    }
+  }
+
+  return result;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 StatusOr<bool> StorageSimulation::has_data_for_page_id(PageId page_id) const noexcept
@@ -17,12 +17,14 @@
 #include <llfs/optional.hpp>
 #include <llfs/page_cache.hpp>
 #include <llfs/page_size.hpp>
+#include <llfs/simulated_device_timing.hpp>
 #include <llfs/simulated_log_device.hpp>
 #include <llfs/simulated_page_device.hpp>
 #include <llfs/slot.hpp>
 #include <llfs/volume.hpp>
 
 #include <batteries/async/fake_execution_context.hpp>
+#include <batteries/async/handler.hpp>
 #include <batteries/async/watch.hpp>
 #include <batteries/state_machine_model/entropy_source.hpp>
 #include <batteries/stream_util.hpp>
@@ -30,6 +32,7 @@
 
 #include <boost/asio/post.hpp>
 
+#include <map>
 #include <memory>
 
 namespace llfs {
@@ -40,6 +43,11 @@ namespace llfs {
 
 /** \brief A simulated collection of LogDevices and PageDevices, used for event-reordering and
  * failure-injection testing.
+ *
+ * Devices may also be given a timing model (see set_timing_model), to estimate how a workload
+ * would perform on some target hardware.  The simulation then keeps a clock (in simulated
+ * nanoseconds) that advances only when no event is ready to run: I/O completions are deferred
+ * until the time the model says they finish, and computation is treated as taking no time.
  */
 class StorageSimulation
 {
@@ -82,6 +90,47 @@ class StorageSimulation
     boost::asio::post(this->fake_executor_, BATT_FORWARD(fn));
   }
 
+  /** \brief Schedules `fn` (signature: void()) to run once the simulation clock reaches
+   * `time_nsec`; if that time has already passed, this is the same as `this->post(fn)`.
+   *
+   * Functions whose time has come are run in an order chosen by the entropy source, just like
+   * those passed to `post`.
+   */
+  template <typename Fn>
+  void post_at(u64 time_nsec, Fn&& fn)
+  {
+    if (time_nsec <= this->simulated_time_nsec()) {
+      this->post(BATT_FORWARD(fn));
+    } else {
+      this->timed_events_.emplace(time_nsec, batt::UniqueHandler<>{BATT_FORWARD(fn)});
+    }
+  }
+
+  /** \brief Returns the current simulated time (nanoseconds since the start of the simulation);
+   * this only changes when some device has a timing model.
+   */
+  u64 simulated_time_nsec() const noexcept
+  {
+    return this->simulated_time_nsec_.get_value();
+  }
+
+  /** \brief Sets the timing model for all simulated devices, existing and yet to be created; None
+   * removes it.  Replacing a device's timing model resets its stats.
+   *
+   * Page reads, writes and drops are timed, as are log flushes (one write per commit); log reads
+   * and trims are not.
+   */
+  void set_timing_model(const Optional<SimulatedDeviceTimingModel>& model);
+
+  /** \brief Sets the timing model for the named (page or log) device, which must exist.
+   */
+  void set_timing_model(const std::string& device_name,
+                        const Optional<SimulatedDeviceTimingModel>& model);
+
+  /** \brief Returns the simulated-time stats of each device that has a timing model, by name.
+   */
+  std::map<std::string, SimulatedDeviceTimingStats> device_timing_stats() const;
+
   /** \brief Returns a reference to the shared PageCache for the simulation; the PageCache must have
    * already been created (by a call to init_cache()) or this function will panic.
    */
@@ -258,6 +307,18 @@ class StorageSimulation
   //
   batt::Watch<u64> step_{0};
 
+  // The simulated clock (nanoseconds); see `post_at`.
+  //
+  batt::Watch<u64> simulated_time_nsec_{0};
+
+  // Functions passed to `post_at` whose time hasn't yet come, ordered by time.
+  //
+  std::multimap<u64, batt::UniqueHandler<>> timed_events_;
+
+  // The timing model given to newly created devices.
+  //
+  Optional<SimulatedDeviceTimingModel> default_timing_model_;
+
   // Used for all tasks and I/O scheduling within the simulation, so we can control event orderings.
   //
   batt::FakeExecutionContext fake_io_context_;
@@ -24,10 +24,7 @@ std::string_view find_common_prefix(usize skip_len, const std::string_view& a,
   }
 
   len -= skip_len;
-  auto a_first = a.begin() + skip_len;
-  auto b_first = b.begin() + skip_len;
-  const auto [a_match_end, b_match_end] = std::mismatch(a_first, std::next(a_first, len), b_first);
-  const usize prefix_len = std::distance(a_first, a_match_end);
+  const usize prefix_len = find_first_mismatch(a.data() + skip_len, b.data() + skip_len, len);
 
   return std::string_view{a.data() + skip_len, prefix_len};
 }
@@ -14,10 +14,72 @@
 //
 #include <llfs/int_types.hpp>
 
+#include <cstring>
 #include <string_view>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace llfs {
 
+/** \brief Returns the index of the first byte at which `a[0:n]` and `b[0:n]` differ, or `n` if they
+ * are equal.
+ *
+ * Compares 16 bytes at a time with SSE2 (x86-64) or NEON (aarch64), both of which are always
+ * available on their targets, then 8 bytes at a time, then bytewise.  Never reads past `a + n` or
+ * `b + n`.
+ */
+inline usize find_first_mismatch(const char* a, const char* b, usize n) noexcept
+{
+  usize i = 0;
+
+#if defined(__SSE2__)
+  for (; i + 16 <= n; i += 16) {
+    const __m128i a_bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i b_bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    const u32 mismatch_mask =
+        ~static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi8(a_bytes, b_bytes))) & 0xffff;
+    if (mismatch_mask != 0) {
+      return i + __builtin_ctz(mismatch_mask);
+    }
+  }
+#elif defined(__ARM_NEON)
+  for (; i + 16 <= n; i += 16) {
+    const uint8x16_t equal = vceqq_u8(vld1q_u8(reinterpret_cast<const u8*>(a + i)),
+                                      vld1q_u8(reinterpret_cast<const u8*>(b + i)));
+
+    // Narrow the byte mask to 4 bits per byte so it fits in a u64.
+    //
+    const u64 equal_mask =
+        vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(equal), 4)), 0);
+    if (equal_mask != ~u64{0}) {
+      return i + (__builtin_ctzll(~equal_mask) >> 2);
+    }
+  }
+#endif
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  for (; i + 8 <= n; i += 8) {
+    u64 a_word, b_word;
+    std::memcpy(&a_word, a + i, sizeof(u64));
+    std::memcpy(&b_word, b + i, sizeof(u64));
+    if (a_word != b_word) {
+      return i + (__builtin_ctzll(a_word ^ b_word) >> 3);
+    }
+  }
+#endif
+
+  for (; i < n; ++i) {
+    if (a[i] != b[i]) {
+      return i;
+    }
+  }
+  return n;
+}
+
 /** \brief Calculates the longest common prefix of the strings `a[skip_len:]` and `b[skip_len:]`.
  *
  * If `skip_len` is equal to or greater than the lengths of either input string, empty string is
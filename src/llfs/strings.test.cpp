@@ -13,6 +13,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <string>
+
 namespace {
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
@@ -388,4 +390,25 @@ TEST(CompareKthByteTest, Case2_4_3)
   EXPECT_TRUE((llfs::CompareKthByte{/*k=*/2}(std::string_view{"abcd"}, 'd')));
 }
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// find_first_mismatch returns the same index as a bytewise scan, for every mismatch position and
+// length around the 8 and 16 byte block sizes.
+//
+TEST(FindFirstMismatchTest, MatchesBytewiseScan)
+{
+  const std::string a(70, 'x');
+
+  for (std::size_t n = 0; n <= a.size(); ++n) {
+    EXPECT_EQ(llfs::find_first_mismatch(a.data(), a.data(), n), n);
+
+    for (std::size_t k = 0; k < n; ++k) {
+      std::string b = a;
+      b[k] = '\xff';
+
+      EXPECT_EQ(llfs::find_first_mismatch(a.data(), b.data(), n), k) << n << " " << k;
+      EXPECT_EQ(llfs::find_first_mismatch(b.data(), a.data(), n), k) << n << " " << k;
+    }
+  }
+}
+
 }  // namespace
@@ -11,6 +11,10 @@
 
 #include <sys/mman.h>
 
+#include <fstream>
+#include <sstream>
+#include <string>
+
 namespace llfs {
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -35,4 +39,36 @@ usize round_up_to_page_size_multiple(usize count)
   return round_down_to_page_size_multiple(count + system_page_size() - 1);
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize system_huge_page_size()
+{
+  static const usize size = [] {
+    std::ifstream ifs{"/proc/meminfo"};
+    std::string line;
+    while (std::getline(ifs, line)) {
+      std::istringstream iss{line};
+      std::string key;
+      usize value_kb = 0;
+      if ((iss >> key >> value_kb) && key == "Hugepagesize:") {
+        return value_kb * 1024;
+      }
+    }
+    return usize{0};
+  }();
+
+  return size;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize round_up_to_huge_page_size_multiple(usize count)
+{
+  const usize huge_page_size = system_huge_page_size();
+  if (huge_page_size == 0) {
+    return round_up_to_page_size_multiple(count);
+  }
+  return (count + huge_page_size - 1) / huge_page_size * huge_page_size;
+}
+
 }  // namespace llfs
@@ -26,6 +26,16 @@ usize round_down_to_page_size_multiple(usize count);
 //
 usize round_up_to_page_size_multiple(usize count);
 
+// Get the system's default huge page size (the "Hugepagesize" entry in /proc/meminfo), or 0 if huge
+// pages are not supported on this system.
+//
+usize system_huge_page_size();
+
+// Compute `count` rounded UP to the nearest multiple of `system_huge_page_size()`.  If huge pages
+// are not supported, this is the same as `round_up_to_page_size_multiple(count)`.
+//
+usize round_up_to_huge_page_size_multiple(usize count);
+
 }  // namespace llfs
 
 #endif  // LLFS_SYSTEM_CONFIG_HPP
@@ -45,7 +45,7 @@ void FakePageDevice::write(std::shared_ptr<const PageBuffer>&& page_buffer,
     if (!status.ok()) {
       handler(status);
     } else {
-      this->write(std::move(page_buffer), std::move(handler));
+      this->impl().write(std::move(page_buffer), std::move(handler));
     }
   });
 }
@@ -58,7 +58,7 @@ void FakePageDevice::read(PageId id, ReadHandler&& handler) /*override*/
     if (!status.ok()) {
       handler(status);
     } else {
-      this->read(id, std::move(handler));
+      this->impl().read(id, std::move(handler));
     }
   });
 }
@@ -71,7 +71,7 @@ void FakePageDevice::drop(PageId id, WriteHandler&& handler) /*override*/
     if (!status.ok()) {
       handler(status);
     } else {
-      this->drop(id, std::move(handler));
+      this->impl().drop(id, std::move(handler));
     }
   });
 }
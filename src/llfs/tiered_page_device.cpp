@@ -0,0 +1,401 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/tiered_page_device.hpp>
+//
+
+#include <llfs/logging.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/utility.hpp>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ TieredPageDevice::TieredPageDevice(batt::TaskScheduler& scheduler,
+                                                std::string_view name,
+                                                std::unique_ptr<PageDevice> fast_tier,
+                                                std::unique_ptr<PageDevice> slow_tier,
+                                                const TieredPageDeviceOptions& options) noexcept
+    : scheduler_{scheduler}
+    , name_{name}
+    , fast_tier_{std::move(fast_tier)}
+    , slow_tier_{std::move(slow_tier)}
+    , options_{options}
+{
+  BATT_CHECK_NOT_NULLPTR(this->fast_tier_);
+  BATT_CHECK_NOT_NULLPTR(this->slow_tier_);
+  BATT_CHECK(this->fast_tier_->page_ids() == this->slow_tier_->page_ids())
+      << "both tiers must use the same PageIds";
+  BATT_CHECK_EQ(this->fast_tier_->page_size(), this->slow_tier_->page_size());
+  BATT_CHECK_LE(this->options_.fast_tier_low_water_pages,
+                this->options_.fast_tier_high_water_pages);
+  BATT_CHECK_LE(this->options_.fast_tier_high_water_pages, this->options_.fast_tier_max_pages);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TieredPageDevice::~TieredPageDevice() noexcept
+{
+  this->halt();
+  this->join();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void TieredPageDevice::start()
+{
+  if (this->migration_task_ || this->stop_requested_.load()) {
+    return;
+  }
+  this->migration_task_ = std::make_unique<batt::Task>(
+      /*executor=*/this->scheduler_.schedule_task(),
+      [this] {
+        this->migration_task_main();
+      },
+      this->name_ + ".migration_task");
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void TieredPageDevice::halt()
+{
+  if (!this->stop_requested_.exchange(true)) {
+    this->fast_tier_page_count_.close();
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void TieredPageDevice::join()
+{
+  if (this->migration_task_) {
+    this->migration_task_->join();
+    this->migration_task_ = nullptr;
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageIdFactory TieredPageDevice::page_ids()
+{
+  return this->fast_tier_->page_ids();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageSize TieredPageDevice::page_size()
+{
+  return this->fast_tier_->page_size();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::shared_ptr<PageBuffer>> TieredPageDevice::prepare(PageId page_id)
+{
+  return this->fast_tier_->prepare(page_id);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void TieredPageDevice::write(std::shared_ptr<const PageBuffer>&& page_buffer,
+                             WriteHandler&& handler)
+{
+  BATT_CHECK_NOT_NULLPTR(page_buffer);
+
+  const PageId page_id = page_buffer->page_id();
+
+  const Tier tier = [&] {
+    auto locked = this->state_.lock();
+
+    const Tier tier = (static_cast<usize>(this->fast_tier_page_count_.get_value()) <
+                       this->options_.fast_tier_max_pages)
+                          ? Tier::kFast
+                          : Tier::kSlow;
+
+    auto [iter, inserted] = locked->index.emplace(page_id, Placement{tier});
+    BATT_CHECK(inserted) << "page written more than once: " << page_id;
+
+    iter->second.writing = true;
+    if (tier == Tier::kFast) {
+      iter->second.lru_pos = locked->lru.insert(locked->lru.end(), page_id);
+      this->fast_tier_page_count_.fetch_add(1);
+    }
+
+    return tier;
+  }();
+
+  LLFS_VLOG(1) << "write " << BATT_INSPECT(page_id) << BATT_INSPECT(tier);
+
+  this->device_for(tier).write(
+      std::move(page_buffer),
+      [this, page_id, handler = std::move(handler)](Status result) mutable {
+        {
+          auto locked = this->state_.lock();
+          if (result.ok()) {
+            auto iter = locked->index.find(page_id);
+            if (iter != locked->index.end()) {
+              iter->second.writing = false;
+            }
+          } else {
+            this->erase_placement(*locked, page_id);
+          }
+        }
+        handler(result);
+      });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void TieredPageDevice::read(PageId page_id, ReadHandler&& handler)
+{
+  const Tier tier = [&] {
+    auto locked = this->state_.lock();
+
+    auto iter = locked->index.find(page_id);
+    if (iter == locked->index.end()) {
+      return Tier::kFast;
+    }
+    if (iter->second.tier == Tier::kFast) {
+      locked->lru.splice(locked->lru.end(), locked->lru, iter->second.lru_pos);
+    }
+    return iter->second.tier;
+  }();
+
+  if (tier == Tier::kSlow) {
+    this->slow_tier_->read(page_id, std::move(handler));
+    return;
+  }
+
+  // If the page isn't on the fast tier, it has either been migrated since we looked it up, or it
+  // isn't in the index at all (e.g. it was written before a restart); try the slow tier.
+  //
+  this->fast_tier_->read(page_id, [this, page_id, handler = std::move(handler)](
+                                      ReadResult result) mutable {
+    if (result.status() == batt::StatusCode::kNotFound) {
+      this->slow_tier_->read(page_id, std::move(handler));
+      return;
+    }
+    handler(std::move(result));
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void TieredPageDevice::drop(PageId page_id, WriteHandler&& handler)
+{
+  const Optional<Tier> tier = [&]() -> Optional<Tier> {
+    auto locked = this->state_.lock();
+
+    auto iter = locked->index.find(page_id);
+    if (iter == locked->index.end()) {
+      return None;
+    }
+    const Tier tier = iter->second.tier;
+
+    // If the page is being migrated, the migration will notice that it has been removed from the
+    // index and drop the copy it made.
+    //
+    this->erase_placement(*locked, page_id);
+
+    return tier;
+  }();
+
+  LLFS_VLOG(1) << "drop " << BATT_INSPECT(page_id) << BATT_INSPECT(tier);
+
+  if (tier) {
+    this->device_for(*tier).drop(page_id, std::move(handler));
+    return;
+  }
+
+  // We don't know where the page is; drop it from both tiers.
+  //
+  this->fast_tier_->drop(page_id, [this, page_id, handler = std::move(handler)](
+                                      Status fast_result) mutable {
+    this->slow_tier_->drop(page_id, [fast_result, handler = std::move(handler)](
+                                        Status slow_result) mutable {
+      handler(fast_result.ok() ? slow_result : fast_result);
+    });
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<TieredPageDevice::Tier> TieredPageDevice::find_tier(PageId page_id)
+{
+  auto locked = this->state_.lock();
+
+  auto iter = locked->index.find(page_id);
+  if (iter == locked->index.end()) {
+    return None;
+  }
+  return iter->second.tier;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<usize> TieredPageDevice::migrate_cold_pages(usize max_count)
+{
+  usize migrated_count = 0;
+
+  while (migrated_count < max_count) {
+    // Pick the least recently used page that isn't already being written or migrated.
+    //
+    const Optional<PageId> page_id = [&]() -> Optional<PageId> {
+      auto locked = this->state_.lock();
+
+      for (const PageId& candidate : locked->lru) {
+        Placement& placement = locked->index.find(candidate)->second;
+        if (!placement.writing && !placement.migrating) {
+          placement.migrating = true;
+          return candidate;
+        }
+      }
+      return None;
+    }();
+
+    if (!page_id) {
+      break;
+    }
+
+    const auto abandon_migration = [&] {
+      auto locked = this->state_.lock();
+      auto iter = locked->index.find(*page_id);
+      if (iter != locked->index.end()) {
+        iter->second.migrating = false;
+      }
+      return iter != locked->index.end();
+    };
+
+    // Copy...
+    //
+    StatusOr<std::shared_ptr<const PageBuffer>> page_buffer =
+        batt::Task::await<ReadResult>([&](auto&& handler) {
+          this->fast_tier_->read(*page_id, BATT_FORWARD(handler));
+        });
+
+    if (!page_buffer.ok()) {
+      if (abandon_migration()) {
+        return page_buffer.status();
+      }
+      // The page was dropped before we could read it.
+      //
+      continue;
+    }
+
+    Status write_status = batt::Task::await<WriteResult>([&](auto&& handler) {
+      this->slow_tier_->write(std::move(*page_buffer), BATT_FORWARD(handler));
+    });
+
+    if (!write_status.ok()) {
+      abandon_migration();
+      return write_status;
+    }
+
+    // ...then switch.
+    //
+    const bool switched = [&] {
+      auto locked = this->state_.lock();
+
+      auto iter = locked->index.find(*page_id);
+      if (iter == locked->index.end()) {
+        return false;
+      }
+      BATT_CHECK(iter->second.migrating);
+
+      locked->lru.erase(iter->second.lru_pos);
+      iter->second.tier = Tier::kSlow;
+      iter->second.migrating = false;
+      this->fast_tier_page_count_.fetch_sub(1);
+
+      return true;
+    }();
+
+    // Drop the copy that is no longer referenced by the index: the fast tier copy if we switched,
+    // or the slow tier copy if the page was dropped while we were copying it.
+    //
+    PageDevice& drop_device = switched ? *this->fast_tier_ : *this->slow_tier_;
+
+    Status drop_status = batt::Task::await<WriteResult>([&](auto&& handler) {
+      drop_device.drop(*page_id, BATT_FORWARD(handler));
+    });
+
+    if (switched) {
+      this->migrated_page_count_.fetch_add(1);
+      ++migrated_count;
+    }
+
+    BATT_REQUIRE_OK(drop_status);
+  }
+
+  return migrated_count;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void TieredPageDevice::erase_placement(State& state, PageId page_id)
+{
+  auto iter = state.index.find(page_id);
+  if (iter == state.index.end()) {
+    return;
+  }
+  if (iter->second.tier == Tier::kFast) {
+    state.lru.erase(iter->second.lru_pos);
+    this->fast_tier_page_count_.fetch_sub(1);
+  }
+  state.index.erase(iter);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void TieredPageDevice::migration_task_main()
+{
+  for (;;) {
+    StatusOr<i64> fast_count = this->fast_tier_page_count_.await_true([this](i64 count) {
+      return static_cast<usize>(count) > this->options_.fast_tier_high_water_pages;
+    });
+
+    if (!fast_count.ok() || this->stop_requested_.load()) {
+      break;
+    }
+
+    const usize excess =
+        static_cast<usize>(*fast_count) - this->options_.fast_tier_low_water_pages;
+
+    StatusOr<usize> migrated = this->migrate_cold_pages(excess);
+    if (!migrated.ok()) {
+      LLFS_LOG_WARNING() << "page migration failed;" << BATT_INSPECT(this->name_)
+                         << BATT_INSPECT(migrated.status());
+    }
+
+    // If nothing could be migrated (all the cold pages are still being written, or there was an
+    // error), back off before trying again.
+    //
+    if (!migrated.ok() || *migrated == 0) {
+      batt::Task::sleep(boost::posix_time::milliseconds(1));
+    }
+  }
+
+  LLFS_VLOG(1) << "migration task exiting;" << BATT_INSPECT(this->name_);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, TieredPageDevice::Tier t)
+{
+  switch (t) {
+    case TieredPageDevice::Tier::kFast:
+      return out << "Fast";
+    case TieredPageDevice::Tier::kSlow:
+      return out << "Slow";
+  }
+  return out << "(bad value:" << static_cast<int>(t) << ")";
+}
+
+}  // namespace llfs
@@ -0,0 +1,205 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_TIERED_PAGE_DEVICE_HPP
+#define LLFS_TIERED_PAGE_DEVICE_HPP
+
+#include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/page_device.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/async/mutex.hpp>
+#include <batteries/async/task.hpp>
+#include <batteries/async/task_scheduler.hpp>
+#include <batteries/async/watch.hpp>
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace llfs {
+
+struct TieredPageDeviceOptions {
+  /** \brief Background migration starts once the fast tier holds more than this many pages.
+   */
+  usize fast_tier_high_water_pages;
+
+  /** \brief Background migration moves the coldest pages until the fast tier holds no more than
+   * this many pages.
+   */
+  usize fast_tier_low_water_pages;
+
+  /** \brief New pages are written directly to the slow tier while the fast tier holds this many
+   * pages (i.e. while migration is falling behind).
+   */
+  usize fast_tier_max_pages;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A PageDevice composed of a fast tier (e.g. NVMe) and a slower, larger tier, with pages
+ * written to the fast tier and migrated to the slow tier, coldest first, in the background.
+ *
+ * Both tiers must have the same `page_ids()` and `page_size()`: a page has the same PageId on
+ * either tier, and the fast tier bounds how many pages it holds, not which ids it can hold (e.g.
+ * a MemoryPageDevice, or a sparse file).  Since pages are immutable, migration copies a page to
+ * the slow tier and then switches the placement index over before dropping the fast copy; a read
+ * that looked up the page before the switch and then misses on the fast tier retries on the slow
+ * tier.
+ *
+ * Reads go to whichever tier the placement index says holds the page; a fast-tier read makes the
+ * page the most recently used.  The index is kept in memory only: pages it doesn't know about
+ * (e.g. after a restart) are looked for on the fast tier first and then on the slow tier.
+ */
+class TieredPageDevice : public PageDevice
+{
+ public:
+  enum struct Tier : u8 {
+    kFast = 0,
+    kSlow = 1,
+  };
+
+  /** \brief Creates a tiered device; `start()` must be called to begin background migration.
+   */
+  explicit TieredPageDevice(batt::TaskScheduler& scheduler, std::string_view name,
+                            std::unique_ptr<PageDevice> fast_tier,
+                            std::unique_ptr<PageDevice> slow_tier,
+                            const TieredPageDeviceOptions& options) noexcept;
+
+  ~TieredPageDevice() noexcept;
+
+  //----- --- -- -  -  -   -
+
+  /** \brief Starts the background migration task.
+   */
+  void start();
+
+  /** \brief Requests that the migration task stop; does not wait for it.
+   */
+  void halt();
+
+  /** \brief Waits for the migration task to finish.
+   */
+  void join();
+
+  //----- --- -- -  -  -   -
+  // PageDevice interface
+
+  PageIdFactory page_ids() override;
+
+  PageSize page_size() override;
+
+  StatusOr<std::shared_ptr<PageBuffer>> prepare(PageId page_id) override;
+
+  void write(std::shared_ptr<const PageBuffer>&& page_buffer, WriteHandler&& handler) override;
+
+  void read(PageId id, ReadHandler&& handler) override;
+
+  void drop(PageId id, WriteHandler&& handler) override;
+
+  //----- --- -- -  -  -   -
+
+  PageDevice& fast_tier() const
+  {
+    return *this->fast_tier_;
+  }
+
+  PageDevice& slow_tier() const
+  {
+    return *this->slow_tier_;
+  }
+
+  /** \brief Returns the tier that holds `page_id` according to the placement index, or None if the
+   * page isn't in the index.
+   */
+  Optional<Tier> find_tier(PageId page_id);
+
+  /** \brief The number of pages currently written (or being written) to the fast tier.
+   */
+  usize fast_tier_page_count() const
+  {
+    return this->fast_tier_page_count_.get_value();
+  }
+
+  /** \brief The number of pages migrated to the slow tier since this object was created.
+   */
+  u64 migrated_page_count() const
+  {
+    return this->migrated_page_count_.load();
+  }
+
+  /** \brief Moves up to `max_count` of the least recently used pages from the fast tier to the slow
+   * tier, waiting for the I/O to complete.  Called by the migration task; may also be called
+   * directly.
+   *
+   * \return the number of pages migrated.
+   */
+  StatusOr<usize> migrate_cold_pages(usize max_count);
+
+ private:
+  struct Placement {
+    Tier tier;
+
+    // True until the write to `tier` completes.
+    //
+    bool writing = false;
+
+    // True while the page is being copied to the slow tier.
+    //
+    bool migrating = false;
+
+    // While `tier == kFast`, the position of this page in `State::lru`.
+    //
+    std::list<PageId>::iterator lru_pos;
+  };
+
+  struct State {
+    std::unordered_map<PageId, Placement, PageId::Hash> index;
+
+    // The pages on the fast tier, least recently used first.
+    //
+    std::list<PageId> lru;
+  };
+
+  PageDevice& device_for(Tier tier) const
+  {
+    return (tier == Tier::kFast) ? *this->fast_tier_ : *this->slow_tier_;
+  }
+
+  // Removes `page_id` from the index (and the LRU list, if it is on the fast tier).  `state` must
+  // be locked.
+  //
+  void erase_placement(State& state, PageId page_id);
+
+  void migration_task_main();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  batt::TaskScheduler& scheduler_;
+  const std::string name_;
+  const std::unique_ptr<PageDevice> fast_tier_;
+  const std::unique_ptr<PageDevice> slow_tier_;
+  const TieredPageDeviceOptions options_;
+  batt::Mutex<State> state_;
+  batt::Watch<i64> fast_tier_page_count_{0};
+  std::atomic<u64> migrated_page_count_{0};
+  std::atomic<bool> stop_requested_{false};
+  std::unique_ptr<batt::Task> migration_task_;
+};
+
+std::ostream& operator<<(std::ostream& out, TieredPageDevice::Tier t);
+
+}  // namespace llfs
+
+#endif  // LLFS_TIERED_PAGE_DEVICE_HPP
@@ -0,0 +1,242 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/tiered_page_device.hpp>
+//
+#include <llfs/tiered_page_device.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/memory_page_device.hpp>
+#include <llfs/page_buffer.hpp>
+
+#include <batteries/async/runtime.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+using namespace llfs::int_types;
+
+using Tier = llfs::TieredPageDevice::Tier;
+
+// Test Plan:
+//  1. Pages are written to the fast tier; migrate_cold_pages moves the least recently used ones
+//     to the slow tier, and reads are served from whichever tier holds the page.
+//  2. Once the fast tier holds fast_tier_max_pages, new pages go straight to the slow tier.
+//  3. Pages that aren't in the placement index (e.g. written before a restart) are found on
+//     either tier, and dropping them drops them from both.
+//  4. The background migration task keeps the fast tier at or below the low water mark.
+
+constexpr u64 kPageSize = 4096;
+constexpr u64 kPageCount = 64;
+constexpr llfs::page_device_id_int kDeviceId = 7;
+
+llfs::Status write_page(llfs::PageDevice& device, llfs::PageId page_id)
+{
+  llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer = device.prepare(page_id);
+  BATT_REQUIRE_OK(buffer);
+
+  llfs::MutableBuffer payload = (*buffer)->mutable_payload();
+  std::memset(payload.data(), static_cast<char>(page_id.int_value()), payload.size());
+
+  llfs::Status result;
+  device.write(std::move(*buffer), [&result](llfs::Status status) {
+    result = status;
+  });
+  return result;
+}
+
+llfs::Status read_page(llfs::PageDevice& device, llfs::PageId page_id)
+{
+  llfs::Status result;
+  device.read(page_id, [&result, page_id](llfs::PageDevice::ReadResult page) {
+    if (!page.ok()) {
+      result = page.status();
+      return;
+    }
+    EXPECT_EQ((*page)->page_id(), page_id);
+    EXPECT_EQ(static_cast<const char*>((*page)->const_payload().data())[0],
+              static_cast<char>(page_id.int_value()));
+  });
+  return result;
+}
+
+llfs::Status drop_page(llfs::PageDevice& device, llfs::PageId page_id)
+{
+  llfs::Status result;
+  device.drop(page_id, [&result](llfs::Status status) {
+    result = status;
+  });
+  return result;
+}
+
+class TieredPageDeviceTest : public ::testing::Test
+{
+ public:
+  void create_device(const llfs::TieredPageDeviceOptions& options)
+  {
+    this->device_.emplace(batt::Runtime::instance().default_scheduler(), "TieredPageDeviceTest",
+                          std::make_unique<llfs::MemoryPageDevice>(
+                              kDeviceId, llfs::PageCount{kPageCount}, llfs::PageSize{kPageSize}),
+                          std::make_unique<llfs::MemoryPageDevice>(
+                              kDeviceId, llfs::PageCount{kPageCount}, llfs::PageSize{kPageSize}),
+                          options);
+  }
+
+  llfs::PageId page_id(usize physical_page) const
+  {
+    return llfs::PageIdFactory{llfs::PageCount{kPageCount}, kDeviceId}.make_page_id(physical_page,
+                                                                                   1);
+  }
+
+  llfs::Optional<llfs::TieredPageDevice> device_;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(TieredPageDeviceTest, MigrateColdPages)
+{
+  this->create_device(llfs::TieredPageDeviceOptions{
+      .fast_tier_high_water_pages = 8,
+      .fast_tier_low_water_pages = 4,
+      .fast_tier_max_pages = 16,
+  });
+  llfs::TieredPageDevice& device = *this->device_;
+
+  for (usize i = 0; i < 6; ++i) {
+    ASSERT_TRUE(write_page(device, this->page_id(i)).ok());
+    EXPECT_EQ(device.find_tier(this->page_id(i)), Tier::kFast);
+  }
+  EXPECT_EQ(device.fast_tier_page_count(), 6u);
+
+  // Touch pages 0 and 1 so that pages 2, 3, and 4 are the coldest.
+  //
+  ASSERT_TRUE(read_page(device, this->page_id(0)).ok());
+  ASSERT_TRUE(read_page(device, this->page_id(1)).ok());
+
+  llfs::StatusOr<usize> migrated = device.migrate_cold_pages(3);
+  ASSERT_TRUE(migrated.ok()) << BATT_INSPECT(migrated.status());
+  EXPECT_EQ(*migrated, 3u);
+  EXPECT_EQ(device.migrated_page_count(), 3u);
+  EXPECT_EQ(device.fast_tier_page_count(), 3u);
+
+  for (usize i = 0; i < 6; ++i) {
+    const Tier expected_tier = (i >= 2 && i <= 4) ? Tier::kSlow : Tier::kFast;
+    EXPECT_EQ(device.find_tier(this->page_id(i)), expected_tier) << BATT_INSPECT(i);
+
+    EXPECT_TRUE(read_page(device, this->page_id(i)).ok()) << BATT_INSPECT(i);
+
+    // Each page is on exactly one tier.
+    //
+    const bool on_fast_tier = read_page(device.fast_tier(), this->page_id(i)).ok();
+    const bool on_slow_tier = read_page(device.slow_tier(), this->page_id(i)).ok();
+    EXPECT_EQ(on_fast_tier, expected_tier == Tier::kFast) << BATT_INSPECT(i);
+    EXPECT_EQ(on_slow_tier, expected_tier == Tier::kSlow) << BATT_INSPECT(i);
+  }
+
+  // Drop one page from each tier.
+  //
+  ASSERT_TRUE(drop_page(device, this->page_id(3)).ok());
+  ASSERT_TRUE(drop_page(device, this->page_id(5)).ok());
+
+  EXPECT_FALSE(device.find_tier(this->page_id(3)));
+  EXPECT_FALSE(device.find_tier(this->page_id(5)));
+  EXPECT_EQ(read_page(device, this->page_id(3)), batt::StatusCode::kNotFound);
+  EXPECT_EQ(read_page(device, this->page_id(5)), batt::StatusCode::kNotFound);
+  EXPECT_EQ(device.fast_tier_page_count(), 2u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(TieredPageDeviceTest, FastTierFull)
+{
+  this->create_device(llfs::TieredPageDeviceOptions{
+      .fast_tier_high_water_pages = 2,
+      .fast_tier_low_water_pages = 1,
+      .fast_tier_max_pages = 4,
+  });
+  llfs::TieredPageDevice& device = *this->device_;
+
+  for (usize i = 0; i < 8; ++i) {
+    ASSERT_TRUE(write_page(device, this->page_id(i)).ok());
+    EXPECT_EQ(device.find_tier(this->page_id(i)), (i < 4) ? Tier::kFast : Tier::kSlow)
+        << BATT_INSPECT(i);
+  }
+  EXPECT_EQ(device.fast_tier_page_count(), 4u);
+
+  for (usize i = 0; i < 8; ++i) {
+    EXPECT_TRUE(read_page(device, this->page_id(i)).ok()) << BATT_INSPECT(i);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(TieredPageDeviceTest, PagesNotInIndex)
+{
+  this->create_device(llfs::TieredPageDeviceOptions{
+      .fast_tier_high_water_pages = 8,
+      .fast_tier_low_water_pages = 4,
+      .fast_tier_max_pages = 16,
+  });
+  llfs::TieredPageDevice& device = *this->device_;
+
+  ASSERT_TRUE(write_page(device.fast_tier(), this->page_id(0)).ok());
+  ASSERT_TRUE(write_page(device.slow_tier(), this->page_id(1)).ok());
+
+  EXPECT_FALSE(device.find_tier(this->page_id(0)));
+  EXPECT_FALSE(device.find_tier(this->page_id(1)));
+
+  EXPECT_TRUE(read_page(device, this->page_id(0)).ok());
+  EXPECT_TRUE(read_page(device, this->page_id(1)).ok());
+  EXPECT_EQ(read_page(device, this->page_id(2)), batt::StatusCode::kNotFound);
+
+  ASSERT_TRUE(drop_page(device, this->page_id(0)).ok());
+  ASSERT_TRUE(drop_page(device, this->page_id(1)).ok());
+
+  EXPECT_EQ(read_page(device, this->page_id(0)), batt::StatusCode::kNotFound);
+  EXPECT_EQ(read_page(device, this->page_id(1)), batt::StatusCode::kNotFound);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(TieredPageDeviceTest, BackgroundMigration)
+{
+  this->create_device(llfs::TieredPageDeviceOptions{
+      .fast_tier_high_water_pages = 8,
+      .fast_tier_low_water_pages = 4,
+      .fast_tier_max_pages = 32,
+  });
+  llfs::TieredPageDevice& device = *this->device_;
+
+  device.start();
+
+  for (usize i = 0; i < 20; ++i) {
+    ASSERT_TRUE(write_page(device, this->page_id(i)).ok());
+  }
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (device.fast_tier_page_count() > 8 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  device.halt();
+  device.join();
+
+  EXPECT_LE(device.fast_tier_page_count(), 8u);
+  EXPECT_GE(device.migrated_page_count(), 12u);
+
+  for (usize i = 0; i < 20; ++i) {
+    EXPECT_TRUE(read_page(device, this->page_id(i)).ok()) << BATT_INSPECT(i);
+  }
+}
+
+}  // namespace
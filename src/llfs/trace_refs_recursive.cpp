@@ -0,0 +1,112 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/trace_refs_recursive.hpp>
+//
+
+#include <llfs/page_view.hpp>
+
+#include <batteries/async/runtime.hpp>
+#include <batteries/async/task.hpp>
+#include <batteries/stream_util.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status load_page_refs_parallel(PageLoader& page_loader, const Slice<const PageId>& page_ids,
+                               std::vector<std::vector<PageId>>* refs,
+                               const ParallelTraceRefsOptions& options)
+{
+  BATT_CHECK_GT(options.max_batch_size, 0u);
+
+  // Keep the per-page vectors from the last call (clearing them), so their memory can be reused.
+  //
+  refs->resize(page_ids.size());
+  for (std::vector<PageId>& page_refs : *refs) {
+    page_refs.clear();
+  }
+
+  const usize batch_count = (page_ids.size() + options.max_batch_size - 1) / options.max_batch_size;
+
+  // Each loader (the calling task plus any helper tasks) claims the next unclaimed batch until
+  // there are none left.  Each page's refs go to their own vector, so no locking is needed.
+  //
+  std::atomic<usize> next_batch{0};
+
+  const auto load_batches = [&]() -> Status {
+    for (;;) {
+      const usize batch_i = next_batch.fetch_add(1);
+      if (batch_i >= batch_count) {
+        return OkStatus();
+      }
+
+      const usize batch_begin = batch_i * options.max_batch_size;
+      const usize batch_size = std::min(options.max_batch_size, page_ids.size() - batch_begin);
+
+      std::vector<StatusOr<PinnedPage>> pages =
+          page_loader.get_pages(as_slice(page_ids.begin() + batch_begin, batch_size),
+                                /*required_layout=*/None, PinPageToJob::kDefault,
+                                OkIfNotFound{false});
+
+      BATT_CHECK_EQ(pages.size(), batch_size);
+
+      for (usize i = 0; i < batch_size; ++i) {
+        if (!pages[i].ok()) {
+          // Make the other loaders stop early.
+          //
+          next_batch.store(batch_count);
+          return pages[i].status();
+        }
+        BATT_CHECK_NOT_NULLPTR(*pages[i]);
+
+        (*pages[i])->append_refs_and_delta_base(&(*refs)[batch_begin + i]);
+      }
+    }
+  };
+
+  const usize loader_count = std::min(options.parallelism, batch_count);
+  if (loader_count <= 1) {
+    return load_batches();
+  }
+
+  batt::TaskScheduler& scheduler = options.scheduler
+                                       ? *options.scheduler
+                                       : batt::Runtime::instance().default_scheduler();
+
+  // The calling task is one of the loaders, so we only need `loader_count - 1` helpers.
+  //
+  std::vector<Status> helper_status(loader_count - 1, OkStatus());
+  std::vector<std::unique_ptr<batt::Task>> helpers;
+
+  for (usize i = 0; i < helper_status.size(); ++i) {
+    helpers.emplace_back(std::make_unique<batt::Task>(
+        scheduler.schedule_task(),
+        [&load_batches, &status = helper_status[i]] {
+          status = load_batches();
+        },
+        batt::to_string("load_page_refs_parallel.helper_", i)));
+  }
+
+  Status status = load_batches();
+
+  for (const std::unique_ptr<batt::Task>& helper : helpers) {
+    helper->join();
+  }
+  for (const Status& s : helper_status) {
+    status.Update(s);
+  }
+
+  return status;
+}
+
+}  // namespace llfs
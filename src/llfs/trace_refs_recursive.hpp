@@ -10,10 +10,13 @@
 #ifndef LLFS_TRACE_REFS_RECURSIVE_HPP
 #define LLFS_TRACE_REFS_RECURSIVE_HPP
 
+#include <llfs/int_types.hpp>
 #include <llfs/page_id.hpp>
 #include <llfs/page_loader.hpp>
 #include <llfs/pinned_page.hpp>
+#include <llfs/slice.hpp>
 
+#include <batteries/async/task_scheduler.hpp>
 #include <batteries/seq.hpp>
 #include <batteries/status.hpp>
 #include <batteries/utility.hpp>
@@ -40,22 +43,99 @@ inline batt::Status trace_refs_recursive(PageLoader& page_loader, IdTypePairSeq&
     pushed.insert(page_id);
   }
 
+  // Reused for all pages, so that tracing doesn't allocate per page.
+  //
+  std::vector<PageId> refs;
+
   while (!pending.empty()) {
     const PageId next = pending.back();
     pending.pop_back();
 
-    batt::StatusOr<PinnedPage> status_or_page = page_loader.get_page(next, OkIfNotFound{false});
-    BATT_REQUIRE_OK(status_or_page);
+    refs.clear();
+    BATT_REQUIRE_OK(page_loader.append_page_refs(next, &refs));
 
-    PinnedPage& page = *status_or_page;
-    BATT_CHECK_NOT_NULLPTR(page);
-    page->trace_refs() | seq::for_each([&](const PageId& id) {
+    for (const PageId& id : refs) {
       fn(id);
       if (!pushed.count(id) && should_recursively_trace(id)) {
         pushed.insert(id);
         pending.push_back(id);
       }
-    });
+    }
+  }
+
+  return batt::OkStatus();
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Options for parallel_trace_refs_recursive.
+ */
+struct ParallelTraceRefsOptions {
+  // The maximum number of batches of pages being loaded at once, each on its own task.  If this is
+  // 1, all pages are loaded on the calling task.
+  //
+  usize parallelism = 4;
+
+  // The maximum number of pages loaded by a single call to PageLoader::get_pages.
+  //
+  usize max_batch_size = 64;
+
+  // Used to run the loader tasks; if nullptr, the default scheduler of batt::Runtime is used.
+  //
+  batt::TaskScheduler* scheduler = nullptr;
+};
+
+/** \brief Loads `page_ids` in batches of up to `options.max_batch_size` pages (using
+ * PageLoader::get_pages), with up to `options.parallelism` batches in flight at once; on success,
+ * `(*refs)[i]` holds the refs of `page_ids[i]` (see PageView::append_refs_and_delta_base).
+ *
+ * If `options.parallelism` is greater than 1, `page_loader` must be safe to use from several tasks
+ * at once (as PageCache is, but PageCacheJob is not).
+ */
+Status load_page_refs_parallel(PageLoader& page_loader, const Slice<const PageId>& page_ids,
+                               std::vector<std::vector<PageId>>* refs,
+                               const ParallelTraceRefsOptions& options);
+
+/** \brief Same as trace_refs_recursive, except that pages are traced breadth-first, one level at a
+ * time; all the pages in a level are loaded in parallel batches (see load_page_refs_parallel).
+ *
+ * `fn` and `should_recursively_trace` are only invoked on the calling task, and `fn` is invoked
+ * for the same ids as trace_refs_recursive would invoke it for (though in a different order).
+ */
+template <typename IdTypePairSeq, typename Pred, typename Fn>
+inline batt::Status parallel_trace_refs_recursive(PageLoader& page_loader, IdTypePairSeq&& roots,
+                                                  Pred&& should_recursively_trace, Fn&& fn,
+                                                  const ParallelTraceRefsOptions& options)
+{
+  static_assert(std::is_convertible_v<std::decay_t<SeqItem<IdTypePairSeq>>, PageId>,
+                "`roots` arg must be a Seq of PageViewId");
+
+  std::unordered_set<PageId, PageId::Hash> pushed;
+  std::vector<PageId> frontier;
+
+  BATT_FORWARD(roots) | seq::emplace_back(&frontier);
+
+  for (const PageId& page_id : frontier) {
+    pushed.insert(page_id);
+  }
+
+  std::vector<PageId> next_frontier;
+  std::vector<std::vector<PageId>> refs;
+
+  while (!frontier.empty()) {
+    BATT_REQUIRE_OK(load_page_refs_parallel(page_loader, as_slice(frontier), &refs, options));
+
+    next_frontier.clear();
+    for (const std::vector<PageId>& page_refs : refs) {
+      for (const PageId& id : page_refs) {
+        fn(id);
+        if (!pushed.count(id) && should_recursively_trace(id)) {
+          pushed.insert(id);
+          next_frontier.push_back(id);
+        }
+      }
+    }
+
+    std::swap(frontier, next_frontier);
   }
 
   return batt::OkStatus();
@@ -0,0 +1,238 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/trace_span.hpp>
+//
+
+#include <batteries/env.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+
+#include <unistd.h>
+
+namespace llfs {
+
+namespace {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void print_json_string(std::ostream& out, const char* str)
+{
+  out << '"';
+  for (; *str != '\0'; ++str) {
+    if (*str == '"' || *str == '\\') {
+      out << '\\';
+    }
+    out << *str;
+  }
+  out << '"';
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void print_usec(std::ostream& out, u64 nsec)
+{
+  out << (nsec / 1000) << '.' << std::setw(3) << std::setfill('0') << (nsec % 1000)
+      << std::setfill(' ');
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ TraceLog& TraceLog::instance()
+{
+  // Intentionally leaked so that spans can be recorded (and the trace exported) during static
+  // destruction.
+  //
+  static TraceLog* const instance_ = [] {
+    auto* const log = new TraceLog{};
+
+    // When LLFS_TRACE_FILE is set, tracing is on from the start (see enabled_flag()); the first
+    // recorded span creates this instance, which arranges for the trace to be written at exit.
+    //
+    if (std::getenv("LLFS_TRACE_FILE") != nullptr) {
+      std::atexit([] {
+        const char* file_name = std::getenv("LLFS_TRACE_FILE");
+        if (file_name != nullptr) {
+          TraceLog::instance().stop();
+          TraceLog::instance().write_chrome_trace_file(file_name).IgnoreError();
+        }
+      });
+    }
+
+    return log;
+  }();
+
+  return *instance_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ std::atomic<bool>& TraceLog::enabled_flag() noexcept
+{
+  static std::atomic<bool> enabled_{std::getenv("LLFS_TRACE_FILE") != nullptr};
+
+  return enabled_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TraceLog::TraceLog() noexcept
+    : events_per_thread_{std::max<usize>(
+          1, batt::getenv_as<usize>("LLFS_TRACE_EVENTS_PER_THREAD").value_or(
+                 TraceLog::kDefaultEventsPerThread))}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void TraceLog::start() noexcept
+{
+  TraceLog::enabled_flag().store(true, std::memory_order_relaxed);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void TraceLog::stop() noexcept
+{
+  TraceLog::enabled_flag().store(false, std::memory_order_relaxed);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void TraceLog::clear()
+{
+  std::unique_lock<std::mutex> lock{this->mutex_};
+
+  for (const std::shared_ptr<ThreadBuffer>& buffer : this->buffers_) {
+    buffer->next.store(0, std::memory_order_release);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto TraceLog::thread_buffer() -> ThreadBuffer&
+{
+  thread_local std::shared_ptr<ThreadBuffer> buffer_;
+
+  if (!buffer_) {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+
+    buffer_ = std::make_shared<ThreadBuffer>(/*tid=*/this->buffers_.size() + 1,
+                                             this->events_per_thread_);
+    this->buffers_.emplace_back(buffer_);
+  }
+
+  return *buffer_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void TraceLog::record(const char* category, const char* name, u64 begin_nsec, u64 end_nsec,
+                      u64 arg) noexcept
+{
+  if (!TraceLog::is_enabled()) {
+    return;
+  }
+
+  ThreadBuffer& buffer = this->thread_buffer();
+
+  const u64 i = buffer.next.load(std::memory_order_relaxed);
+
+  buffer.events[i % buffer.capacity] = Event{
+      .category = category,
+      .name = name,
+      .begin_nsec = begin_nsec,
+      .duration_nsec = (end_nsec > begin_nsec) ? (end_nsec - begin_nsec) : 0,
+      .arg = arg,
+  };
+
+  buffer.next.store(i + 1, std::memory_order_release);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 TraceLog::overwritten_count() const
+{
+  std::unique_lock<std::mutex> lock{this->mutex_};
+
+  u64 total = 0;
+  for (const std::shared_ptr<ThreadBuffer>& buffer : this->buffers_) {
+    const u64 n = buffer->next.load(std::memory_order_acquire);
+    if (n > buffer->capacity) {
+      total += n - buffer->capacity;
+    }
+  }
+  return total;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void TraceLog::write_chrome_trace(std::ostream& out) const
+{
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+    buffers = this->buffers_;
+  }
+
+  const int pid = ::getpid();
+  const char* sep = "\n";
+
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+  for (const std::shared_ptr<ThreadBuffer>& buffer : buffers) {
+    const u64 n = buffer->next.load(std::memory_order_acquire);
+    const u64 first = (n > buffer->capacity) ? (n - buffer->capacity) : 0;
+
+    for (u64 i = first; i < n; ++i) {
+      const Event& event = buffer->events[i % buffer->capacity];
+
+      out << sep << "{\"name\":";
+      print_json_string(out, event.name);
+      out << ",\"cat\":";
+      print_json_string(out, event.category);
+      out << ",\"ph\":\"X\",\"ts\":";
+      print_usec(out, event.begin_nsec);
+      out << ",\"dur\":";
+      print_usec(out, event.duration_nsec);
+      out << ",\"pid\":" << pid << ",\"tid\":" << buffer->tid << ",\"args\":{\"arg\":" << event.arg
+          << "}}";
+
+      sep = ",\n";
+    }
+  }
+
+  out << "\n]}\n";
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status TraceLog::write_chrome_trace_file(const std::string& file_name) const
+{
+  std::ofstream ofs{file_name, std::ios_base::out | std::ios_base::trunc};
+  if (!ofs.good()) {
+    return batt::status_from_errno(errno);
+  }
+
+  this->write_chrome_trace(ofs);
+
+  ofs.flush();
+  if (!ofs.good()) {
+    return batt::StatusCode::kInternal;
+  }
+
+  return OkStatus();
+}
+
+}  // namespace llfs
@@ -0,0 +1,234 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_TRACE_SPAN_HPP
+#define LLFS_TRACE_SPAN_HPP
+
+#include <llfs/int_types.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/utility.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace llfs {
+
+/** \brief Process-wide collector of timed spans, exported as a Chrome trace (JSON) that can be
+ * loaded into ui.perfetto.dev or chrome://tracing.
+ *
+ * Tracing is off by default; while it is off, TraceSpan costs one relaxed atomic load.  It can be
+ * turned on programmatically (start/stop) or by setting the environment variable LLFS_TRACE_FILE
+ * to a path, in which case tracing starts on first use and the trace is written to that path
+ * when the process exits.
+ *
+ * Each thread records into its own fixed-size ring buffer (LLFS_TRACE_EVENTS_PER_THREAD events,
+ * default: 64Ki) without locking; when a ring wraps, the oldest events of that thread are
+ * overwritten.  Buffers outlive their threads so that spans from short-lived threads still show
+ * up in the export.
+ */
+class TraceLog
+{
+ public:
+  static constexpr usize kDefaultEventsPerThread = 64 * 1024;
+
+  /** \brief A single completed span.  `category` and `name` must be string literals (or otherwise
+   * have static storage duration).
+   */
+  struct Event {
+    const char* category;
+    const char* name;
+    u64 begin_nsec;
+    u64 duration_nsec;
+    u64 arg;
+  };
+
+  /** \brief Returns the global instance.
+   */
+  static TraceLog& instance();
+
+  /** \brief Returns true iff spans are currently being recorded.
+   */
+  static bool is_enabled() noexcept
+  {
+    return TraceLog::enabled_flag().load(std::memory_order_relaxed);
+  }
+
+  /** \brief Returns the current time in the clock used for all trace timestamps.
+   */
+  static u64 now_nsec() noexcept
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  TraceLog(const TraceLog&) = delete;
+  TraceLog& operator=(const TraceLog&) = delete;
+
+  /** \brief Starts recording spans.
+   */
+  void start() noexcept;
+
+  /** \brief Stops recording spans; recorded events are kept until clear() is called.
+   */
+  void stop() noexcept;
+
+  /** \brief Discards all recorded events.  Must only be called while tracing is stopped.
+   */
+  void clear();
+
+  /** \brief Records a span for the calling thread.  Does nothing if tracing is stopped.
+   */
+  void record(const char* category, const char* name, u64 begin_nsec, u64 end_nsec,
+              u64 arg = 0) noexcept;
+
+  /** \brief Returns the number of events overwritten because a per-thread ring wrapped.
+   */
+  u64 overwritten_count() const;
+
+  /** \brief Writes all recorded events in the Chrome trace event format ("traceEvents" array of
+   * complete events).  Tracing should be stopped first; events recorded concurrently with the
+   * export may be torn.
+   */
+  void write_chrome_trace(std::ostream& out) const;
+
+  /** \brief Writes the Chrome trace to the given file, replacing it if it exists.
+   */
+  Status write_chrome_trace_file(const std::string& file_name) const;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  struct ThreadBuffer {
+    explicit ThreadBuffer(usize tid, usize capacity) noexcept
+        : tid{tid}
+        , capacity{capacity}
+        , events{new Event[capacity]}
+    {
+    }
+
+    const usize tid;
+    const usize capacity;
+    const std::unique_ptr<Event[]> events;
+
+    // Only the owning thread writes this; readers load it to find out how many events are valid.
+    //
+    std::atomic<u64> next{0};
+  };
+
+  static std::atomic<bool>& enabled_flag() noexcept;
+
+  TraceLog() noexcept;
+
+  ThreadBuffer& thread_buffer();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const usize events_per_thread_;
+
+  mutable std::mutex mutex_;
+
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+};
+
+/** \brief RAII helper that records a span from its construction until end() is called or it goes
+ * out of scope.  The start time is only taken if tracing is enabled at construction.
+ */
+class TraceSpan
+{
+ public:
+  explicit TraceSpan(const char* category, const char* name, u64 arg = 0) noexcept
+      : category_{category}
+      , name_{name}
+      , arg_{arg}
+      , begin_nsec_{TraceLog::is_enabled() ? TraceLog::now_nsec() : 0}
+  {
+  }
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+  ~TraceSpan() noexcept
+  {
+    this->end();
+  }
+
+  /** \brief Sets the value shown as `args.arg` in the exported event.
+   */
+  void set_arg(u64 arg) noexcept
+  {
+    this->arg_ = arg;
+  }
+
+  /** \brief Records the span now (if it was started with tracing enabled); later calls do nothing.
+   */
+  void end() noexcept
+  {
+    if (this->begin_nsec_ != 0) {
+      TraceLog::instance().record(this->category_, this->name_, this->begin_nsec_,
+                                  TraceLog::now_nsec(), this->arg_);
+      this->begin_nsec_ = 0;
+    }
+  }
+
+ private:
+  const char* category_;
+  const char* name_;
+  u64 arg_;
+  u64 begin_nsec_;
+};
+
+/** \brief If tracing is enabled, returns a handler that records a span from now until `handler`
+ * is invoked (e.g. the submission and completion of an async I/O) and then forwards to it;
+ * otherwise returns `handler` unchanged.
+ *
+ * HandlerT must be constructible from a lambda (e.g. std::function or batt::SmallFn).
+ */
+template <typename HandlerT>
+inline HandlerT trace_async_handler(const char* category, const char* name, u64 arg,
+                                    HandlerT handler)
+{
+  if (!TraceLog::is_enabled()) {
+    return std::move(handler);
+  }
+  return [category, name, arg, begin_nsec = TraceLog::now_nsec(),
+          handler = std::move(handler)](auto&&... args) mutable {
+    TraceLog::instance().record(category, name, begin_nsec, TraceLog::now_nsec(), arg);
+    return handler(BATT_FORWARD(args)...);
+  };
+}
+
+}  // namespace llfs
+
+#define LLFS_TRACE_SPAN_NAME_(line) llfs_trace_span_##line
+#define LLFS_TRACE_SPAN_NAME(line) LLFS_TRACE_SPAN_NAME_(line)
+
+/** \brief Records a span named `name` (in `category`) from this point to the end of the enclosing
+ * scope.
+ */
+#define LLFS_TRACE_SPAN(category, name)                                                            \
+  ::llfs::TraceSpan LLFS_TRACE_SPAN_NAME(__LINE__){(category), (name)}
+
+/** \brief Evaluates `expr` inside a span named `name`, and returns its value.
+ */
+#define LLFS_TRACE_SPAN_EXPR(category, name, expr)                                                 \
+  [&]() -> decltype(auto) {                                                                        \
+    ::llfs::TraceSpan llfs_trace_span_expr_((category), (name));                                   \
+    return expr;                                                                                   \
+  }()
+
+#endif  // LLFS_TRACE_SPAN_HPP
@@ -0,0 +1,163 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/trace_span.hpp>
+//
+#include <llfs/trace_span.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <batteries/env.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. Nothing is recorded while tracing is stopped.
+//  2. Spans recorded by several threads (TraceSpan, LLFS_TRACE_SPAN_EXPR and trace_async_handler)
+//     all show up in the Chrome trace export, with one tid per thread.
+//  3. When a thread records more events than its ring holds, only the newest are exported and the
+//     rest are counted as overwritten.
+
+using namespace llfs::int_types;
+
+using llfs::TraceLog;
+using llfs::TraceSpan;
+
+usize count_substr(const std::string& str, const std::string& pattern)
+{
+  usize count = 0;
+  for (usize pos = str.find(pattern); pos != std::string::npos;
+       pos = str.find(pattern, pos + pattern.size())) {
+    ++count;
+  }
+  return count;
+}
+
+std::string export_trace()
+{
+  std::ostringstream oss;
+  TraceLog::instance().write_chrome_trace(oss);
+  return std::move(oss).str();
+}
+
+void reset_trace_log()
+{
+  TraceLog::instance().stop();
+  TraceLog::instance().clear();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Test Plan (1)
+//
+TEST(TraceSpanTest, DisabledRecordsNothing)
+{
+  reset_trace_log();
+
+  {
+    TraceSpan span{"test", "disabled_span"};
+  }
+  EXPECT_EQ(LLFS_TRACE_SPAN_EXPR("test", "disabled_expr", 7 * 6), 42);
+
+  const std::string trace = export_trace();
+
+  EXPECT_THAT(trace, ::testing::HasSubstr("\"traceEvents\":["));
+  EXPECT_THAT(trace, ::testing::Not(::testing::HasSubstr("disabled_")));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Test Plan (2)
+//
+TEST(TraceSpanTest, MultiThreadExport)
+{
+  reset_trace_log();
+  TraceLog::instance().start();
+
+  constexpr usize kNumThreads = 4;
+  constexpr usize kSpansPerThread = 100;
+
+  std::vector<std::thread> threads;
+  for (usize t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([] {
+      for (usize i = 0; i < kSpansPerThread; ++i) {
+        TraceSpan span{"test", "outer_span", /*arg=*/i};
+        EXPECT_EQ(LLFS_TRACE_SPAN_EXPR("test", "inner_span", i + 1), i + 1);
+      }
+
+      std::function<void(int)> handler = [](int) {
+      };
+      handler = llfs::trace_async_handler("test", "async_op", /*arg=*/99, std::move(handler));
+      handler(0);
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  TraceLog::instance().stop();
+
+  const std::string trace = export_trace();
+
+  EXPECT_EQ(count_substr(trace, "\"name\":\"outer_span\""), kNumThreads * kSpansPerThread);
+  EXPECT_EQ(count_substr(trace, "\"name\":\"inner_span\""), kNumThreads * kSpansPerThread);
+  EXPECT_EQ(count_substr(trace, "\"name\":\"async_op\""), kNumThreads);
+  EXPECT_EQ(count_substr(trace, "\"args\":{\"arg\":99}"), kNumThreads);
+  EXPECT_EQ(count_substr(trace, "\"ph\":\"X\""), kNumThreads * (2 * kSpansPerThread + 1));
+
+  std::vector<std::string> tids;
+  for (usize pos = trace.find("\"tid\":"); pos != std::string::npos;
+       pos = trace.find("\"tid\":", pos + 1)) {
+    std::string tid = trace.substr(pos, trace.find(',', pos) - pos);
+    if (std::find(tids.begin(), tids.end(), tid) == tids.end()) {
+      tids.emplace_back(std::move(tid));
+    }
+  }
+  EXPECT_EQ(tids.size(), kNumThreads);
+
+  TraceLog::instance().clear();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Test Plan (3)
+//
+TEST(TraceSpanTest, RingOverwrite)
+{
+  reset_trace_log();
+  TraceLog::instance().start();
+
+  const usize capacity = batt::getenv_as<usize>("LLFS_TRACE_EVENTS_PER_THREAD")
+                             .value_or(TraceLog::kDefaultEventsPerThread);
+
+  std::thread{[capacity] {
+    for (usize i = 0; i < capacity + 10; ++i) {
+      TraceLog::instance().record("test", "wrap_span", /*begin_nsec=*/i + 1, /*end_nsec=*/i + 2,
+                                  /*arg=*/i);
+    }
+  }}.join();
+
+  TraceLog::instance().stop();
+
+  EXPECT_EQ(TraceLog::instance().overwritten_count(), 10u);
+
+  const std::string trace = export_trace();
+
+  EXPECT_EQ(count_substr(trace, "\"name\":\"wrap_span\""), capacity);
+  EXPECT_THAT(trace, ::testing::Not(::testing::HasSubstr("\"args\":{\"arg\":9}")));
+  EXPECT_THAT(trace, ::testing::HasSubstr("\"args\":{\"arg\":10}"));
+
+  TraceLog::instance().clear();
+}
+
+}  // namespace
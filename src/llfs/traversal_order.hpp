@@ -17,6 +17,7 @@
 
 #include <algorithm>
 #include <deque>
+#include <iterator>
 #include <vector>
 
 namespace llfs {
@@ -145,6 +146,75 @@ class VanEmdeBoasOrder
   std::vector<Item> heap_;
 };
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+
+/** \brief Orders items in blocks of (at most) `kBlockSize` bytes of packed data, each of which
+ * holds the top levels of a sub-tree in BFS order.
+ *
+ * `PackedSizeFn` is a default-constructible function object that returns the number of bytes the
+ * passed item (not including its children) takes up once packed.  The children pushed after an
+ * item is popped stay in the current block while they fit; once the next one doesn't, all the
+ * remaining children become the roots of new blocks, which are started in FIFO order.  An item
+ * larger than `kBlockSize` gets a block of its own.
+ */
+template <typename T, typename PackedSizeFn, usize kBlockSize = 64>
+class CacheLineBlockedOrder
+{
+ public:
+  bool empty() const noexcept
+  {
+    return this->in_block_.empty() && this->block_roots_.empty();
+  }
+
+  template <typename... Args>
+  void push(Args&&... args)
+  {
+    this->in_block_.emplace_back(T{BATT_FORWARD(args)...});
+  }
+
+  T pop()
+  {
+    if (!this->in_block_.empty()) {
+      const usize packed_size = PackedSizeFn{}(this->in_block_.front());
+      if (packed_size <= this->block_space_) {
+        this->block_space_ -= packed_size;
+        return this->pop_front(this->in_block_);
+      }
+
+      // The current block is full; start blocks for what's left of it.
+      //
+      std::move(this->in_block_.begin(), this->in_block_.end(),
+                std::back_inserter(this->block_roots_));
+      this->in_block_.clear();
+    }
+
+    const usize packed_size = PackedSizeFn{}(this->block_roots_.front());
+    this->block_space_ = kBlockSize - std::min(packed_size, kBlockSize);
+
+    return this->pop_front(this->block_roots_);
+  }
+
+ private:
+  static T pop_front(std::deque<T>& queue)
+  {
+    T item = std::move(queue.front());
+    queue.pop_front();
+    return item;
+  }
+
+  // The bytes left in the current block.
+  //
+  usize block_space_ = 0;
+
+  // Children of the items in the current block, in BFS order.
+  //
+  std::deque<T> in_block_;
+
+  // The roots of blocks not yet started.
+  //
+  std::deque<T> block_roots_;
+};
+
 }  //namespace llfs
 
 #endif  // LLFS_TRAVERSAL_ORDER_HPP
@@ -9,8 +9,10 @@
 #include <llfs/trie.hpp>
 //
 
+#include <llfs/strings.hpp>
 #include <llfs/traversal_order.hpp>
 
+#include <algorithm>
 #include <bitset>
 
 namespace llfs {
@@ -105,6 +107,34 @@ struct QueueItem {
   batt::Interval<usize> range;
 };
 
+// The number of bytes the node of `item` (not including its sub-tries) takes up once packed; this
+// must agree with build_packed_trie.
+//
+template <typename SubtreeOffset>
+struct QueueItemPackedSize {
+  usize operator()(const QueueItem<SubtreeOffset>& item) const noexcept
+  {
+    const usize prefix_len = item.node->prefix_.size();
+
+    // One header byte per prefix chunk (and always at least one).
+    //
+    usize node_size = prefix_len + prefix_len / PackedBPTrie::kMaxPrefixChunkLen + 1;
+
+    if (item.node->left_) {
+      const usize range_size = item.range.size();
+      const usize pivot_pos_size = (range_size <= 0xff)       ? 1
+                                   : (range_size <= 0xffff)   ? 2
+                                   : (range_size <= 0xffffff) ? 3
+                                                              : 4;
+
+      node_size += 1 /*pivot*/ + pivot_pos_size +
+                   sizeof(PackedPointer<PackedBPTrieNodeBase, SubtreeOffset>) * 2;
+    }
+
+    return node_size;
+  }
+};
+
 template <typename SubtreeOffset, typename Queue>
 PackedBPTrie* build_packed_trie(const BPTrie& object, PackedBPTrie* packed, DataPacker* dst)
 {
@@ -229,6 +259,12 @@ PackedBPTrie* pack_trie_impl(const BPTrie& object, PackedBPTrie* packed, DataPac
       return build_packed_trie<SubtreeOffset, VanEmdeBoasOrder<QueueItem<SubtreeOffset>>>(
           object, packed, dst);
 
+    case BPTrie::PackedLayout::kCacheLineBlocked:
+      return build_packed_trie<SubtreeOffset,
+                               CacheLineBlockedOrder<QueueItem<SubtreeOffset>,
+                                                     QueueItemPackedSize<SubtreeOffset>>>(
+          object, packed, dst);
+
     default:
       break;
   }
@@ -392,106 +428,253 @@ template <>
 struct NextSmaller<u8> : batt::StaticType<u8> {
 };
 
+// The state of one (possibly interleaved) PackedBPTrie::find.
+//
+struct FindCursor {
+  // The next node to visit.
+  //
+  const PackedBPTrieNodeBase* node;
+
+  // The part of the key not yet matched.
+  //
+  std::string_view key;
+
+  // The range of key indices that may match; this is the result once the search is done.
+  //
+  batt::Interval<usize> range;
+};
+
+enum struct PrefixMatch {
+  kLess,
+  kGreater,
+  kEqual,
+};
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
-template <typename PivotPosT, typename SubtreeOffset>
-batt::Interval<usize> find_impl(const PackedBPTrieNodeBase* node, std::string_view& key,
-                                batt::Interval<usize>& range)
+inline PrefixMatch match_prefix_chunk(const std::string_view& key, const char* prefix_chunk,
+                                      usize prefix_chunk_len) noexcept
 {
-  constexpr i64 threshold = i64{1} << (sizeof(typename NextSmaller<PivotPosT>::type) * 8);
+  const usize common_len = std::min(prefix_chunk_len, key.size());
+  const usize i = find_first_mismatch(key.data(), prefix_chunk, common_len);
 
-  for (;;) {
-    if (!std::is_same_v<PivotPosT, u8> && range.size() < threshold) {
-      return find_impl<typename NextSmaller<PivotPosT>::type, SubtreeOffset>(node, key, range);
-    }
+  if (i < common_len) {
+    return ((u8)key[i] < (u8)prefix_chunk[i]) ? PrefixMatch::kLess : PrefixMatch::kGreater;
+  }
+  return (key.size() < prefix_chunk_len) ? PrefixMatch::kLess : PrefixMatch::kEqual;
+}
 
-    usize prefix_chunk_len;
-    for (;;) {
-      prefix_chunk_len = node->header & PackedBPTrie::kPrefixChunkLenMask;
-      if (prefix_chunk_len != 0) {
-        std::string_view prefix_chunk{node->prefix_, prefix_chunk_len};
-        const usize key_len = key.size();
-        const usize common_len = std::min(prefix_chunk_len, key_len);
-        const batt::Order order = batt::compare(key.substr(0, common_len), prefix_chunk);
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Visits `cursor.node` (all of its prefix chunks), moving the cursor to the child to search next.
+// Returns true iff the search is done, in which case `cursor.range` is the result.
+//
+template <typename PivotPosT, typename SubtreeOffset>
+inline bool find_step(FindCursor& cursor) noexcept
+{
+  const PackedBPTrieNodeBase* node = cursor.node;
+  std::string_view& key = cursor.key;
+  batt::Interval<usize>& range = cursor.range;
 
-        if (order == batt::Order::Greater) {
+  usize prefix_chunk_len;
+  for (;;) {
+    prefix_chunk_len = node->header & PackedBPTrie::kPrefixChunkLenMask;
+    if (prefix_chunk_len != 0) {
+      switch (match_prefix_chunk(key, node->prefix_, prefix_chunk_len)) {
+        case PrefixMatch::kGreater:
           range.lower_bound = range.upper_bound;
-          return range;
-        }
-        if (order == batt::Order::Less || key_len < prefix_chunk_len) {
+          return true;
+
+        case PrefixMatch::kLess:
           range.upper_bound = range.lower_bound;
-          return range;
-        }
+          return true;
 
-        key = key.substr(prefix_chunk_len);
+        case PrefixMatch::kEqual:
+          break;
+      }
 
-        if (prefix_chunk_len == PackedBPTrie::kMaxPrefixChunkLen) {
-          node = reinterpret_cast<const PackedBPTrieNodeBase*>(&node->prefix_[prefix_chunk_len]);
-          continue;
-        }
+      key.remove_prefix(prefix_chunk_len);
+
+      if (prefix_chunk_len == PackedBPTrie::kMaxPrefixChunkLen) {
+        node = reinterpret_cast<const PackedBPTrieNodeBase*>(&node->prefix_[prefix_chunk_len]);
+        continue;
       }
-      break;
     }
+    break;
+  }
 
-    if ((node->header & PackedBPTrie::kParentNodeMask) == 0) {
-      range.upper_bound = range.lower_bound + 1;
-      break;
+  if ((node->header & PackedBPTrie::kParentNodeMask) == 0) {
+    range.upper_bound = range.lower_bound + 1;
+    return true;
+  }
+
+  const auto* parent = reinterpret_cast<const PackedBPTrieNodeParent<PivotPosT, SubtreeOffset>*>(
+      &node->prefix_[prefix_chunk_len]);
+
+  const usize middle = range.lower_bound + (usize)parent->pivot_pos;
+  const u8 parent_pivot = parent->pivot;
+
+  // Select the child without branching on the key (this is the least predictable branch of the
+  // search); the compiler turns each of the selects below into a conditional move.
+  //
+  const u8 key_byte = key.empty() ? 0 : (u8)key[0];
+  const bool go_right = !key.empty() & (key_byte >= parent_pivot);
+
+  node = go_right ? parent->right.get() : parent->left.get();
+  range.lower_bound = go_right ? middle : range.lower_bound;
+  range.upper_bound = go_right ? range.upper_bound : middle;
+
+  // Implement right-leaf optimization (the parent pivot is always prefix[0] in this case).
+  //
+  if (go_right && (node->header & PackedBPTrie::kParentNodeMask) == 0) {
+    if (key_byte != parent_pivot) {
+      range.lower_bound = range.upper_bound;
+      return true;
     }
+    key.remove_prefix(1);
+  }
 
-    const auto* parent = reinterpret_cast<const PackedBPTrieNodeParent<PivotPosT, SubtreeOffset>*>(
-        &node->prefix_[prefix_chunk_len]);
+  cursor.node = node;
+  return false;
+}
 
-    const usize middle = range.lower_bound + (usize)parent->pivot_pos;
-    const u8 parent_pivot = parent->pivot;
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename PivotPosT, typename SubtreeOffset>
+batt::Interval<usize> find_impl(FindCursor& cursor)
+{
+  constexpr i64 threshold = i64{1} << (sizeof(typename NextSmaller<PivotPosT>::type) * 8);
 
-    if (key.empty() || (u8)key[0] < parent_pivot) {
-      node = parent->left.get();
-      range.upper_bound = middle;
-    } else {
-      node = parent->right.get();
+  for (;;) {
+    if (!std::is_same_v<PivotPosT, u8> && cursor.range.size() < threshold) {
+      return find_impl<typename NextSmaller<PivotPosT>::type, SubtreeOffset>(cursor);
+    }
+    if (find_step<PivotPosT, SubtreeOffset>(cursor)) {
+      return cursor.range;
+    }
+  }
+}
 
-      // Implement right-leaf optimization (the parent pivot is always prefix[0] in this case).
-      //
-      if ((node->header & PackedBPTrie::kParentNodeMask) == 0) {
-        if ((u8)key[0] != parent_pivot) {
-          range.lower_bound = range.upper_bound;
-          return range;
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Like one iteration of find_impl, but selects the size of the pivot position from the cursor's
+// range at run time (the same choice that find_impl makes at compile time, as the range shrinks).
+//
+template <typename SubtreeOffset>
+inline bool find_step_any(FindCursor& cursor) noexcept
+{
+  const usize n = cursor.range.size();
+
+  if (sizeof(SubtreeOffset) == 1 || n < (usize{1} << 8)) {
+    return find_step<u8, SubtreeOffset>(cursor);
+  }
+  if (sizeof(SubtreeOffset) == 2 || n < (usize{1} << 16)) {
+    return find_step<little_u16, SubtreeOffset>(cursor);
+  }
+  if (sizeof(SubtreeOffset) == 3 || n < (usize{1} << 24)) {
+    return find_step<little_u24, SubtreeOffset>(cursor);
+  }
+  return find_step<little_u32, SubtreeOffset>(cursor);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename SubtreeOffset>
+void find_many_impl(const PackedBPTrie& trie, const batt::Slice<const std::string_view>& keys,
+                    batt::Interval<usize>* results)
+{
+  constexpr usize kInterleave = PackedBPTrie::kFindManyInterleave;
+
+  FindCursor cursors[kInterleave];
+  usize active[kInterleave];
+
+  for (usize base = 0; base < keys.size(); base += kInterleave) {
+    usize active_count = std::min(kInterleave, keys.size() - base);
+
+    for (usize i = 0; i < active_count; ++i) {
+      cursors[i] = FindCursor{
+          .node = trie.root(),
+          .key = keys[base + i],
+          .range = batt::Interval<usize>{0, trie.size()},
+      };
+      active[i] = i;
+    }
+
+    // Advance each unfinished lookup by one node per round, prefetching the node it will visit
+    // next; by the time the round comes back to it, the node is (hopefully) in cache.
+    //
+    while (active_count != 0) {
+      usize still_active = 0;
+      for (usize j = 0; j < active_count; ++j) {
+        const usize i = active[j];
+        FindCursor& cursor = cursors[i];
+        if (find_step_any<SubtreeOffset>(cursor)) {
+          results[base + i] = cursor.range;
+        } else {
+          __builtin_prefetch(cursor.node);
+          active[still_active] = i;
+          ++still_active;
         }
-        key = key.substr(1);
       }
-
-      range.lower_bound = middle;
+      active_count = still_active;
     }
   }
-
-  return range;
 }
+
 }  //namespace
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 batt::Interval<usize> PackedBPTrie::find(std::string_view key) const noexcept
 {
-  batt::Interval<usize> range{0, this->size()};
+  FindCursor cursor{
+      .node = this->root(),
+      .key = key,
+      .range = batt::Interval<usize>{0, this->size()},
+  };
+
+  if (cursor.range.empty()) {
+    return cursor.range;
+  }
 
-  if (range.empty()) {
-    return range;
+  switch (this->offset_kind_) {
+    case PackedBPTrie::kOffset8:
+      return find_impl<u8, u8>(cursor);
+
+    case PackedBPTrie::kOffset16:
+      return find_impl<little_u16, little_u16>(cursor);
+
+    case PackedBPTrie::kOffset24:
+      return find_impl<little_u24, little_u24>(cursor);
+
+    case PackedBPTrie::kOffset32:
+      return find_impl<little_u32, little_u32>(cursor);
   }
 
-  const PackedBPTrieNodeBase* node = this->root();
+  BATT_PANIC() << "Bad offset kind: " << (int)this->offset_kind_;
+  BATT_UNREACHABLE();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PackedBPTrie::find_many(const batt::Slice<const std::string_view>& keys,
+                             batt::Interval<usize>* results) const noexcept
+{
+  if (this->size() == 0) {
+    std::fill(results, results + keys.size(), batt::Interval<usize>{0, 0});
+    return;
+  }
 
   switch (this->offset_kind_) {
     case PackedBPTrie::kOffset8:
-      return find_impl<u8, u8>(node, key, range);
+      return find_many_impl<u8>(*this, keys, results);
 
     case PackedBPTrie::kOffset16:
-      return find_impl<little_u16, little_u16>(node, key, range);
+      return find_many_impl<little_u16>(*this, keys, results);
 
     case PackedBPTrie::kOffset24:
-      return find_impl<little_u24, little_u24>(node, key, range);
+      return find_many_impl<little_u24>(*this, keys, results);
 
     case PackedBPTrie::kOffset32:
-      return find_impl<little_u32, little_u32>(node, key, range);
+      return find_many_impl<little_u32>(*this, keys, results);
   }
 
   BATT_PANIC() << "Bad offset kind: " << (int)this->offset_kind_;
@@ -585,4 +768,179 @@ std::string_view PackedBPTrie::get_key(usize index, batt::SmallVecBase<char>& bu
   BATT_UNREACHABLE();
 }
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+
+namespace {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Calls `fn` with the parent fields of `node` (whose last prefix chunk is `prefix_chunk_len` bytes
+// long), choosing the size of the pivot position from `range_size` the same way find_impl does.
+//
+template <typename SubtreeOffset, typename Fn>
+inline void visit_parent(const PackedBPTrieNodeBase* node, usize prefix_chunk_len,
+                         usize range_size, Fn&& fn)
+{
+  const void* parent = &node->prefix_[prefix_chunk_len];
+
+  if (sizeof(SubtreeOffset) == 1 || range_size < (usize{1} << 8)) {
+    fn(reinterpret_cast<const PackedBPTrieNodeParent<u8, SubtreeOffset>*>(parent));
+
+  } else if (sizeof(SubtreeOffset) == 2 || range_size < (usize{1} << 16)) {
+    fn(reinterpret_cast<const PackedBPTrieNodeParent<little_u16, SubtreeOffset>*>(parent));
+
+  } else if (sizeof(SubtreeOffset) == 3 || range_size < (usize{1} << 24)) {
+    fn(reinterpret_cast<const PackedBPTrieNodeParent<little_u24, SubtreeOffset>*>(parent));
+
+  } else {
+    fn(reinterpret_cast<const PackedBPTrieNodeParent<little_u32, SubtreeOffset>*>(parent));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+inline bool is_leaf(const PackedBPTrieNodeBase* node) noexcept
+{
+  return (node->header & PackedBPTrie::kParentNodeMask) == 0;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename SubtreeOffset, typename Frame>
+void descend_impl(const PackedBPTrieNodeBase* node, batt::Interval<usize> range,
+                  usize target_index, batt::SmallVecBase<char>& key,
+                  batt::SmallVecBase<Frame>& stack)
+{
+  for (;;) {
+    usize prefix_chunk_len;
+    for (;;) {
+      prefix_chunk_len = node->header & PackedBPTrie::kPrefixChunkLenMask;
+      key.insert(key.end(), node->prefix_, node->prefix_ + prefix_chunk_len);
+
+      if (prefix_chunk_len == PackedBPTrie::kMaxPrefixChunkLen) {
+        node = reinterpret_cast<const PackedBPTrieNodeBase*>(&node->prefix_[prefix_chunk_len]);
+        continue;
+      }
+      break;
+    }
+
+    if (is_leaf(node)) {
+      return;
+    }
+
+    visit_parent<SubtreeOffset>(node, prefix_chunk_len, range.size(), [&](const auto* parent) {
+      const usize middle = range.lower_bound + (usize)parent->pivot_pos;
+      const PackedBPTrieNodeBase* right = parent->right.get();
+
+      if (target_index < middle) {
+        stack.emplace_back(Frame{
+            .node = right,
+            .range = batt::Interval<usize>{middle, range.upper_bound},
+            .key_len = key.size(),
+            .pivot = parent->pivot,
+        });
+        node = parent->left.get();
+        range.upper_bound = middle;
+      } else {
+        // Implement right-leaf optimization (the parent pivot is always prefix[0] in this case).
+        //
+        if (is_leaf(right)) {
+          key.push_back((char)parent->pivot);
+        }
+        node = right;
+        range.lower_bound = middle;
+      }
+    });
+  }
+}
+
+}  //namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ PackedBPTrieKeySeq::PackedBPTrieKeySeq(const PackedBPTrie& trie,
+                                                    usize begin_index) noexcept
+    : trie_{&trie}
+    , index_{std::min<usize>(begin_index, trie.size())}
+{
+  if (this->index_ < this->trie_->size()) {
+    this->descend(this->trie_->root(), batt::Interval<usize>{0, this->trie_->size()},
+                  this->index_);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<std::string_view> PackedBPTrieKeySeq::peek() noexcept
+{
+  this->settle();
+
+  if (this->index_ == this->trie_->size()) {
+    return None;
+  }
+  return std::string_view{this->key_.data(), this->key_.size()};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<std::string_view> PackedBPTrieKeySeq::next() noexcept
+{
+  Optional<std::string_view> key = this->peek();
+  if (key) {
+    this->advance_pending_ = true;
+  }
+  return key;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PackedBPTrieKeySeq::settle() noexcept
+{
+  if (!this->advance_pending_) {
+    return;
+  }
+  this->advance_pending_ = false;
+
+  if (this->stack_.empty()) {
+    this->index_ = this->trie_->size();
+    this->key_.clear();
+    return;
+  }
+
+  // The next key is the leftmost key of the most recently passed right sub-trie.
+  //
+  const Frame next = this->stack_.back();
+  this->stack_.pop_back();
+
+  this->key_.resize(next.key_len);
+  if (is_leaf(next.node)) {
+    this->key_.push_back((char)next.pivot);
+  }
+
+  this->index_ = next.range.lower_bound;
+  this->descend(next.node, next.range, next.range.lower_bound);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void PackedBPTrieKeySeq::descend(const PackedBPTrieNodeBase* node, batt::Interval<usize> range,
+                                 usize target_index)
+{
+  switch (this->trie_->offset_kind_) {
+    case PackedBPTrie::kOffset8:
+      return descend_impl<u8>(node, range, target_index, this->key_, this->stack_);
+
+    case PackedBPTrie::kOffset16:
+      return descend_impl<little_u16>(node, range, target_index, this->key_, this->stack_);
+
+    case PackedBPTrie::kOffset24:
+      return descend_impl<little_u24>(node, range, target_index, this->key_, this->stack_);
+
+    case PackedBPTrie::kOffset32:
+      return descend_impl<little_u32>(node, range, target_index, this->key_, this->stack_);
+  }
+
+  BATT_PANIC() << "Bad offset kind: " << (int)this->trie_->offset_kind_;
+  BATT_UNREACHABLE();
+}
+
 }  //namespace llfs
@@ -15,8 +15,12 @@
 #include <llfs/data_packer.hpp>
 #include <llfs/define_packed_type.hpp>
 #include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
 #include <llfs/packed_pointer.hpp>
 
+#include <batteries/async/worker_pool.hpp>
+#include <batteries/interval.hpp>
+#include <batteries/slice.hpp>
 #include <batteries/small_vec.hpp>
 #include <batteries/static_dispatch.hpp>
 #include <batteries/utility.hpp>
@@ -51,6 +55,29 @@ template <typename Range>
 BPTrieNode* make_trie(const Range& keys, std::vector<std::unique_ptr<BPTrieNode>>& nodes,
                       usize current_prefix_len = 0, bool is_right_subtree = false);
 
+namespace detail {
+
+template <typename Iter>
+struct BPTrieDeferredSubtree;
+
+}  // namespace detail
+
+/** \brief Builds a BPTrie subtree from the keys in [first, last) without allocating: the nodes
+ * are written to `nodes`, which must have room for `2 * std::distance(first, last) - 1` of them
+ * (the number of nodes in a sub-trie of that many keys).  The root goes at `nodes[0]`, followed by
+ * the left sub-trie and then the right; so the result is the same no matter the order in which
+ * the sub-tries are built.
+ *
+ * If `deferred` is non-null, sub-tries of at most `defer_max_count` keys are not built, but added
+ * to `*deferred` (still with their root nodes linked into the tree); they can then be built
+ * independently (e.g., in parallel) by calling this function again for each of them.
+ */
+template <typename Iter>
+BPTrieNode* make_trie_in_arena(
+    Iter first, Iter last, BPTrieNode* nodes, usize current_prefix_len = 0,
+    bool is_right_subtree = false, usize defer_max_count = 0,
+    std::vector<detail::BPTrieDeferredSubtree<Iter>>* deferred = nullptr);
+
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 /** \brief A binary prefix trie - implements an ordered set of strings.
  *
@@ -84,8 +111,23 @@ class BPTrie
      * regardless of cache level/block-size (i.e., it is "Cache-Oblivious").
      */
     kVanEmdeBoas = 1,
+
+    /** \brief Specifies that nodes should be packed in cache-line-sized blocks: each block holds
+     * the top levels (in BFS order) of a sub-trie, as many as fit in 64 bytes, and the children
+     * left over become the roots of later blocks.  A search then fetches one block per several
+     * levels of the trie (as in CSS/FAST trees).
+     *
+     * Blocks are contiguous but not padded to line boundaries (the packed trie can start anywhere
+     * in a page), so a block may still straddle two cache lines.
+     */
+    kCacheLineBlocked = 2,
   };
 
+  /** \brief The minimum number of keys for which the WorkerPool constructor builds sub-tries in
+   * parallel.
+   */
+  static constexpr usize kMinParallelBuildSize = 16 * 1024;
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   /** \brief Constructs a BPTrie from a sorted, unique range of std::string_view keys.
@@ -96,10 +138,19 @@ class BPTrie
    * this object, as only string pointers (std::string_view) are stored within the BPTrie.
    */
   template <typename Range>
-  explicit BPTrie(const Range& keys)
-      : nodes_{}
-      , root_{make_trie(keys, this->nodes_)}
-      , size_{std::size(keys)}
+  explicit BPTrie(const Range& keys) : BPTrie{keys, /*worker_pool=*/nullptr}
+  {
+  }
+
+  /** \brief Constructs a BPTrie from a sorted, unique range of std::string_view keys, building
+   * sub-tries in parallel on the given WorkerPool (for key sets of at least
+   * kMinParallelBuildSize).  The result is exactly the same as that of the single-threaded
+   * constructor.
+   *
+   * The same requirements as for BPTrie(const Range&) apply.
+   */
+  template <typename Range>
+  explicit BPTrie(const Range& keys, batt::WorkerPool& worker_pool) : BPTrie{keys, &worker_pool}
   {
   }
 
@@ -132,7 +183,7 @@ class BPTrie
    */
   usize node_count() const noexcept
   {
-    return this->nodes_.size();
+    return this->node_count_;
   }
 
   /** \brief Returns the number of strings in the set.
@@ -151,8 +202,9 @@ class BPTrie
   batt::Interval<usize> find(std::string_view key) const noexcept;
 
   /** \brief Changes the node order used to pack this object.  The BFS layout is still supported
-   * mainly to be able to compare it to the more search-optimized vEB (default) layout, although
-   * YMMV and there may be workloads for which BFS layout performs better.
+   * mainly to be able to compare it to the more search-optimized vEB (default) and cache-line
+   * blocked layouts, although YMMV and there may be workloads for which BFS layout performs
+   * better.
    */
   void set_packed_layout(PackedLayout layout) noexcept
   {
@@ -177,7 +229,16 @@ class BPTrie
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
  private:
-  std::vector<std::unique_ptr<BPTrieNode>> nodes_;
+  template <typename Range>
+  explicit BPTrie(const Range& keys, batt::WorkerPool* worker_pool);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  // A trie of N keys always has 2*N - 1 nodes (N leaves, N - 1 parents), so they are all allocated
+  // up front, in one block.
+  //
+  usize node_count_;
+  std::unique_ptr<BPTrieNode[]> nodes_;
   BPTrieNode* root_;
   usize size_ = 0;
   PackedLayout layout_ = PackedLayout::kVanEmdeBoas;
@@ -273,6 +334,10 @@ struct PackedBPTrie {
   static constexpr u8 kOffset24 = 2;
   static constexpr u8 kOffset32 = 3;
 
+  // The number of lookups that `find_many` runs side by side.
+  //
+  static constexpr usize kFindManyInterleave = 8;
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   little_u64 size_;
@@ -292,11 +357,104 @@ struct PackedBPTrie {
 
   batt::Interval<usize> find(std::string_view key) const noexcept;
 
+  /** \brief Sets `results[i]` to `this->find(keys[i])` for each i in `[0, keys.size())`.
+   *
+   * Runs up to kFindManyInterleave lookups side by side, advancing each by one node per round and
+   * prefetching the node it will visit next, so that the cache misses of different lookups
+   * overlap instead of being taken one after another.
+   */
+  void find_many(const batt::Slice<const std::string_view>& keys,
+                 batt::Interval<usize>* results) const noexcept;
+
   std::string_view get_key(usize index, batt::SmallVecBase<char>& buffer) const noexcept;
 };
 
 LLFS_DEFINE_PACKED_TYPE_FOR(BPTrie, PackedBPTrie);
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+
+/** \brief A Seq of the keys of a PackedBPTrie, in order, starting at a given index.
+ *
+ * Rebuilding each key with PackedBPTrie::get_key costs one root-to-leaf walk per key.  This
+ * instead keeps the current key and the path to it (the right sub-tries not yet visited), so each
+ * step only truncates the key back to the prefix it shares with the next key and appends the new
+ * suffix; a scan of N keys visits each trie node once.
+ *
+ * The string_view returned by `peek()` or `next()` points into this object; it stays valid until
+ * the next call to `peek()` or `next()` after a `next()` (or until this object is moved or
+ * destroyed).  The PackedBPTrie must outlive this object.
+ */
+class PackedBPTrieKeySeq
+{
+ public:
+  using Item = std::string_view;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Creates a Seq of the keys of `trie` from index `begin_index` to the end.
+   */
+  explicit PackedBPTrieKeySeq(const PackedBPTrie& trie, usize begin_index = 0) noexcept;
+
+  /** \brief Returns the index of the key that the next call to `next()` will return (or the size
+   * of the trie, if there are no more keys).
+   */
+  usize index() const noexcept
+  {
+    return this->index_ + (this->advance_pending_ ? 1 : 0);
+  }
+
+  Optional<std::string_view> peek() noexcept;
+
+  Optional<std::string_view> next() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  // A right sub-trie not yet visited.
+  //
+  struct Frame {
+    const PackedBPTrieNodeBase* node;
+
+    // The key index range of the sub-trie.
+    //
+    batt::Interval<usize> range;
+
+    // The length of the key prefix shared by all the keys in the sub-trie, not counting the pivot
+    // byte of the parent (which is only part of the key if `node` is a leaf).
+    //
+    usize key_len;
+
+    // The pivot byte of the parent.
+    //
+    u8 pivot;
+  };
+
+  // Appends the path from `node` down to the key at `target_index` (which must be in `range`),
+  // pushing a Frame for each right sub-trie passed on the way.
+  //
+  void descend(const PackedBPTrieNodeBase* node, batt::Interval<usize> range, usize target_index);
+
+  // Moves to the next key, if `next()` returned the current one.
+  //
+  void settle() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const PackedBPTrie* trie_;
+
+  // The index of the current key; `trie_->size()` once the Seq is at the end.
+  //
+  usize index_;
+
+  // Set by `next()`; the current key is only replaced on the following call, so that the
+  // string_view returned by `next()` stays valid until then.
+  //
+  bool advance_pending_ = false;
+
+  batt::SmallVec<char, 256> key_;
+
+  batt::SmallVec<Frame, 32> stack_;
+};
+
 /** \brief Calculate the size of the given sub-trie.
  */
 usize packed_sizeof(const BPTrie& node);
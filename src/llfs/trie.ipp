@@ -16,60 +16,67 @@
 #include <llfs/strings.hpp>
 
 #include <batteries/assert.hpp>
+#include <batteries/async/work_context.hpp>
 #include <batteries/compare.hpp>
 
+#include <algorithm>
+
 namespace llfs {
 
 //#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
 
-//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
-//
-template <typename Range>
-inline BPTrieNode* make_trie(const Range& keys, std::vector<std::unique_ptr<BPTrieNode>>& nodes,
-                             usize current_prefix_len, bool is_right_subtree)
-{
-  // Guard against too much recursion.
-  //
-  thread_local int depth = 0;
+namespace detail {
 
-  BATT_CHECK_LT(depth, 48);
+/** \brief Guards against too much recursion in the trie builders.
+ */
+class BPTrieDepthGuard
+{
+ public:
+  BPTrieDepthGuard() noexcept
+  {
+    BATT_CHECK_LT(depth(), 48);
+    ++depth();
+  }
 
-  ++depth;
-  auto on_scope_exit = batt::finally([&] {
-    --depth;
-  });
+  BPTrieDepthGuard(const BPTrieDepthGuard&) = delete;
+  BPTrieDepthGuard& operator=(const BPTrieDepthGuard&) = delete;
 
-  // Grab the iterator pair and find the input range size.
-  //
-  auto first = std::begin(keys);
-  auto last = std::end(keys);
-  const usize count = std::distance(first, last);
+  ~BPTrieDepthGuard() noexcept
+  {
+    --depth();
+  }
 
-  // Base case 0: empty input.
-  //
-  if (count == 0) {
-    return nullptr;
+ private:
+  static int& depth() noexcept
+  {
+    thread_local int depth_ = 0;
+    return depth_;
   }
+};
 
-  // We know we are going to create at least one node.
+/** \brief Returns the prefix of the single-key sub-trie node for `key`.
+ */
+template <typename Key>
+inline std::string_view bp_trie_leaf_prefix(const Key& key, usize current_prefix_len,
+                                            bool is_right_subtree)
+{
+  // Implement right-leaf optimization (the parent pivot is always prefix[0] in this case).
   //
-  auto new_node = std::make_unique<BPTrieNode>();
-  auto* node = new_node.get();
-  nodes.emplace_back(std::move(new_node));
+  if (is_right_subtree) {
+    current_prefix_len += 1;
+  }
 
-  // Base case 1: single key.
-  //
-  if (count == 1) {
-    // Implement right-leaf optimization (the parent pivot is always prefix[0] in this case).
-    //
-    if (is_right_subtree) {
-      current_prefix_len += 1;
-    }
+  return std::string_view{key.data() + current_prefix_len,  //
+                          key.size() - current_prefix_len};
+}
 
-    node->prefix_ = std::string_view{first->data() + current_prefix_len,  //
-                                     first->size() - current_prefix_len};
-    return node;
-  }
+/** \brief Sets the prefix, pivot, and pivot position of `node`, the root of the sub-trie for the
+ * keys in [first, last) (of which there must be at least 2).
+ */
+template <typename Iter>
+inline void bp_trie_split(Iter first, Iter last, usize current_prefix_len, BPTrieNode* node)
+{
+  const usize count = std::distance(first, last);
 
   // Find the longest common prefix of the input key range.
   //
@@ -117,18 +124,70 @@ inline BPTrieNode* make_trie(const Range& keys, std::vector<std::unique_ptr<BPTr
     }
   }();
 
-  // We have our pivot!  Subdivide the input range and recurse down left (lower) and right (upper)
-  // halves.
+  // We have our pivot!
   //
   node->pivot_pos_ = std::distance(first, pivot_iter);
   node->pivot_ = get_kth_byte(node->pivot_pos_);
 
-  current_prefix_len = k;
   BATT_CHECK_NE(first, pivot_iter) << BATT_INSPECT(lo_distance) << BATT_INSPECT(hi_distance);
   BATT_CHECK_NE(last, pivot_iter) << BATT_INSPECT(lo_distance) << BATT_INSPECT(hi_distance)
                                   << BATT_INSPECT(middle_pos) << BATT_INSPECT(count)
                                   << batt::dump_range(boost::make_iterator_range(first, last))
                                   << BATT_INSPECT(current_prefix_len);
+}
+
+/** \brief A sub-trie whose construction was deferred by `make_trie_in_arena`.
+ */
+template <typename Iter>
+struct BPTrieDeferredSubtree {
+  Iter first;
+  Iter last;
+  BPTrieNode* nodes;
+  usize current_prefix_len;
+  bool is_right_subtree;
+};
+
+}  // namespace detail
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename Range>
+inline BPTrieNode* make_trie(const Range& keys, std::vector<std::unique_ptr<BPTrieNode>>& nodes,
+                             usize current_prefix_len, bool is_right_subtree)
+{
+  detail::BPTrieDepthGuard depth_guard;
+
+  // Grab the iterator pair and find the input range size.
+  //
+  auto first = std::begin(keys);
+  auto last = std::end(keys);
+  const usize count = std::distance(first, last);
+
+  // Base case 0: empty input.
+  //
+  if (count == 0) {
+    return nullptr;
+  }
+
+  // We know we are going to create at least one node.
+  //
+  auto new_node = std::make_unique<BPTrieNode>();
+  auto* node = new_node.get();
+  nodes.emplace_back(std::move(new_node));
+
+  // Base case 1: single key.
+  //
+  if (count == 1) {
+    node->prefix_ = detail::bp_trie_leaf_prefix(*first, current_prefix_len, is_right_subtree);
+    return node;
+  }
+
+  // Subdivide the input range at the pivot and recurse down left (lower) and right (upper) halves.
+  //
+  detail::bp_trie_split(first, last, current_prefix_len, node);
+
+  const auto pivot_iter = std::next(first, node->pivot_pos_);
+  current_prefix_len += node->prefix_.size();
 
   node->left_ =
       make_trie(boost::make_iterator_range(first, pivot_iter), nodes, current_prefix_len, false);
@@ -139,6 +198,107 @@ inline BPTrieNode* make_trie(const Range& keys, std::vector<std::unique_ptr<BPTr
   return node;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename Iter>
+inline BPTrieNode* make_trie_in_arena(Iter first, Iter last, BPTrieNode* nodes,
+                                      usize current_prefix_len, bool is_right_subtree,
+                                      usize defer_max_count,
+                                      std::vector<detail::BPTrieDeferredSubtree<Iter>>* deferred)
+{
+  detail::BPTrieDepthGuard depth_guard;
+
+  const usize count = std::distance(first, last);
+  if (count == 0) {
+    return nullptr;
+  }
+
+  BPTrieNode* const node = nodes;
+
+  if (count == 1) {
+    node->prefix_ = detail::bp_trie_leaf_prefix(*first, current_prefix_len, is_right_subtree);
+    return node;
+  }
+
+  // The position of this sub-trie's nodes doesn't depend on how (or when) they are built, so
+  // its root can be returned right away.
+  //
+  if (deferred != nullptr && count <= defer_max_count) {
+    deferred->push_back(detail::BPTrieDeferredSubtree<Iter>{
+        .first = first,
+        .last = last,
+        .nodes = nodes,
+        .current_prefix_len = current_prefix_len,
+        .is_right_subtree = is_right_subtree,
+    });
+    return node;
+  }
+
+  detail::bp_trie_split(first, last, current_prefix_len, node);
+
+  const usize left_count = node->pivot_pos_;
+  const auto pivot_iter = std::next(first, left_count);
+  current_prefix_len += node->prefix_.size();
+
+  // The left sub-trie (2 * left_count - 1 nodes) comes right after this node, followed by the
+  // right sub-trie.
+  //
+  node->left_ = make_trie_in_arena(first, pivot_iter, nodes + 1, current_prefix_len,
+                                   /*is_right_subtree=*/false, defer_max_count, deferred);
+
+  node->right_ = make_trie_in_arena(pivot_iter, last, nodes + 2 * left_count, current_prefix_len,
+                                    /*is_right_subtree=*/true, defer_max_count, deferred);
+
+  return node;
+}
+
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename Range>
+inline BPTrie::BPTrie(const Range& keys, batt::WorkerPool* worker_pool)
+    : node_count_{(std::size(keys) == 0) ? 0 : (std::size(keys) * 2 - 1)}
+    , nodes_{new BPTrieNode[this->node_count_]}
+    , root_{nullptr}
+    , size_{std::size(keys)}
+{
+  auto first = std::begin(keys);
+  auto last = std::end(keys);
+
+  using Iter = decltype(first);
+
+  const usize parallelism = (worker_pool == nullptr) ? 1 : (worker_pool->size() + 1);
+
+  if (parallelism <= 1 || this->size_ < BPTrie::kMinParallelBuildSize) {
+    this->root_ = make_trie_in_arena(first, last, this->nodes_.get(), /*current_prefix_len=*/0,
+                                     /*is_right_subtree=*/false);
+    return;
+  }
+
+  // Build the top of the trie on this thread, leaving sub-tries small enough that there are
+  // several for each worker (so the load evens out even if the pivots are lopsided); then build
+  // those in parallel.
+  //
+  const usize defer_max_count =
+      std::max(BPTrie::kMinParallelBuildSize / 4, this->size_ / (parallelism * 4));
+
+  std::vector<detail::BPTrieDeferredSubtree<Iter>> deferred;
+
+  this->root_ = make_trie_in_arena(first, last, this->nodes_.get(), /*current_prefix_len=*/0,
+                                   /*is_right_subtree=*/false, defer_max_count, &deferred);
+  {
+    batt::ScopedWorkContext work_context{*worker_pool};
+
+    for (const detail::BPTrieDeferredSubtree<Iter>& subtree : deferred) {
+      work_context.async_run([&subtree] {
+        make_trie_in_arena(subtree.first, subtree.last, subtree.nodes, subtree.current_prefix_len,
+                           subtree.is_right_subtree);
+      });
+    }
+  }
+}
+
 }  //namespace llfs
 
 #endif  // LLFS_TRIE_IPP
@@ -34,6 +34,8 @@
 #include <boost/endian/conversion.hpp>
 
 #include <algorithm>
+#include <array>
+#include <chrono>
 #include <fstream>
 #include <memory>
 #include <numeric>
@@ -128,6 +130,7 @@ TEST(Trie, Test)
   double speedup_total_mem_sstable = 0;
   double speedup_total_packed_bfs = 0;
   double speedup_total_packed_veb = 0;
+  double speedup_total_packed_clb = 0;
 
   const usize kMaxTake = extra_testing ? words.size() : 1000;
 
@@ -185,6 +188,19 @@ TEST(Trie, Test)
         ASSERT_NE(packed_veb, nullptr);
       }
 
+      // ...and once more in cache-line blocked order.
+      //
+      trie.set_packed_layout(BPTrie::PackedLayout::kCacheLineBlocked);
+      const usize packed_size_clb = llfs::packed_sizeof(trie);
+      std::unique_ptr<u8[]> buffer_clb{new u8[packed_size_clb]};
+      const PackedBPTrie* packed_clb = nullptr;
+      {
+        llfs::DataPacker packer{llfs::MutableBuffer{buffer_clb.get(), packed_size_clb}};
+        packed_clb = llfs::pack_object(trie, &packer);
+
+        ASSERT_NE(packed_clb, nullptr);
+      }
+
       // Finally, pack in SSTable layout.
       //
       const usize packed_size_sstable =
@@ -276,9 +292,11 @@ TEST(Trie, Test)
 
         auto pos2 = packed_bfs->find(word);
         auto pos3 = packed_veb->find(word);
+        auto pos4 = packed_clb->find(word);
 
         EXPECT_EQ(pos, pos2) << debug_info;
         EXPECT_EQ(pos, pos3) << debug_info;
+        EXPECT_EQ(pos, pos4) << debug_info;
       }
 
       batt::SmallVec<char, 64> buffer;
@@ -298,6 +316,11 @@ TEST(Trie, Test)
           std::string_view actual_key = packed_veb->get_key(i, buffer);
           EXPECT_EQ(actual_key, sample[i]);
         }
+        buffer.clear();
+        {
+          std::string_view actual_key = packed_clb->get_key(i, buffer);
+          EXPECT_EQ(actual_key, sample[i]);
+        }
       }
 
       const auto run_timed_bench = [&sample, &words, &kStep](const auto& target) -> double {
@@ -328,16 +351,18 @@ TEST(Trie, Test)
       double mem_sstable_time = run_timed_bench(SSTableWrapper{sample});
       double packed_bfs_time = run_timed_bench(*packed_bfs);
       double packed_veb_time = run_timed_bench(*packed_veb);
+      double packed_clb_time = run_timed_bench(*packed_clb);
       double packed_sstable_time = run_timed_bench(PackedSSTableWrapper{*packed_sstable});
 
       speedup_total_mem_trie += packed_sstable_time / mem_trie_time;
       speedup_total_mem_sstable += packed_sstable_time / mem_sstable_time;
       speedup_total_packed_bfs += packed_sstable_time / packed_bfs_time;
       speedup_total_packed_veb += packed_sstable_time / packed_veb_time;
+      speedup_total_packed_clb += packed_sstable_time / packed_clb_time;
 
       VLOG(1) << BATT_INSPECT(mem_trie_time) << BATT_INSPECT(mem_sstable_time)
               << BATT_INSPECT(packed_bfs_time) << BATT_INSPECT(packed_veb_time)
-              << BATT_INSPECT(packed_sstable_time);
+              << BATT_INSPECT(packed_clb_time) << BATT_INSPECT(packed_sstable_time);
     }
   }
 
@@ -347,12 +372,14 @@ TEST(Trie, Test)
   double avg_speedup_mem_sstable = speedup_total_mem_sstable / trials;
   double avg_speedup_packed_bfs = speedup_total_packed_bfs / trials;
   double avg_speedup_packed_veb = speedup_total_packed_veb / trials;
+  double avg_speedup_packed_clb = speedup_total_packed_clb / trials;
 
   LOG(INFO) << BATT_INSPECT(avg_compression_bfs) << "%" << BATT_INSPECT(avg_compression_veb) << "%";
   LOG(INFO) << BATT_INSPECT(avg_speedup_mem_trie);
   LOG(INFO) << BATT_INSPECT(avg_speedup_mem_sstable);
   LOG(INFO) << BATT_INSPECT(avg_speedup_packed_bfs);
   LOG(INFO) << BATT_INSPECT(avg_speedup_packed_veb);
+  LOG(INFO) << BATT_INSPECT(avg_speedup_packed_clb);
 }
 
 //#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
@@ -522,4 +549,268 @@ TEST(Trie, VEBLayoutTest)
   }
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Building a trie in parallel (on a WorkerPool) gives exactly the same packed trie as building it
+// on a single thread.
+//
+TEST(Trie, ParallelBuild)
+{
+  const std::vector<std::string> words = load_words();
+
+  const auto pack_trie = [](const BPTrie& trie) {
+    std::vector<u8> buffer(llfs::packed_sizeof(trie));
+    llfs::DataPacker packer{llfs::MutableBuffer{buffer.data(), buffer.size()}};
+    BATT_CHECK_NOT_NULLPTR(llfs::pack_object(trie, &packer));
+    return buffer;
+  };
+
+  for (const usize n_keys : {usize{0}, usize{1}, usize{1000}, BPTrie::kMinParallelBuildSize,
+                             usize{100 * 1000}, words.size()}) {
+    const auto keys = boost::make_iterator_range(words.begin(),
+                                                 std::next(words.begin(),
+                                                           std::min(n_keys, words.size())));
+
+    BPTrie serial_trie{keys};
+    BPTrie parallel_trie{keys, batt::WorkerPool::default_pool()};
+
+    EXPECT_EQ(serial_trie.size(), parallel_trie.size());
+    EXPECT_EQ(serial_trie.node_count(), parallel_trie.node_count());
+    EXPECT_EQ(serial_trie.node_count(), (keys.size() == 0) ? 0u : (keys.size() * 2 - 1));
+
+    for (const auto layout :
+         {BPTrie::PackedLayout::kBreadthFirst, BPTrie::PackedLayout::kVanEmdeBoas,
+          BPTrie::PackedLayout::kCacheLineBlocked}) {
+      serial_trie.set_packed_layout(layout);
+      parallel_trie.set_packed_layout(layout);
+
+      EXPECT_EQ(pack_trie(serial_trie), pack_trie(parallel_trie)) << BATT_INSPECT(n_keys);
+    }
+
+    for (usize i = 0; i < keys.size(); i += 97) {
+      EXPECT_EQ(parallel_trie.find(keys[i]), (batt::Interval<usize>{i, i + 1}));
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// PackedBPTrie::find_many gives the same result as PackedBPTrie::find for every key, both for keys
+// in the trie and for keys that aren't, in every offset size and layout.
+//
+TEST(Trie, FindMany)
+{
+  const std::vector<std::string> words = load_words();
+
+  std::default_random_engine rng{/*seed=*/2024};
+
+  for (const usize n_keys : {usize{0}, usize{1}, usize{7}, usize{100}, usize{10 * 1000},
+                             words.size()}) {
+    const auto keys = boost::make_iterator_range(words.begin(),
+                                                 std::next(words.begin(),
+                                                           std::min(n_keys, words.size())));
+
+    // Look up every key in the trie (in a random order, with some duplicates), plus truncated,
+    // extended, and altered versions of some of them.
+    //
+    std::vector<std::string> queries{keys.begin(), keys.end()};
+    for (usize i = 0; i < keys.size(); i += 3) {
+      std::string key = keys[i];
+      queries.emplace_back(key + "~");
+      queries.emplace_back(key.substr(0, key.size() / 2));
+      if (!key.empty()) {
+        key.back() = '\0';
+        queries.emplace_back(key);
+      }
+    }
+    queries.emplace_back("");
+    queries.emplace_back(std::string(300, 'q'));
+    std::shuffle(queries.begin(), queries.end(), rng);
+
+    const std::vector<std::string_view> query_views(queries.begin(), queries.end());
+
+    BPTrie trie{keys};
+
+    for (const auto layout :
+         {BPTrie::PackedLayout::kBreadthFirst, BPTrie::PackedLayout::kVanEmdeBoas,
+          BPTrie::PackedLayout::kCacheLineBlocked}) {
+      trie.set_packed_layout(layout);
+
+      std::vector<u8> buffer(llfs::packed_sizeof(trie));
+      llfs::DataPacker packer{llfs::MutableBuffer{buffer.data(), buffer.size()}};
+      const PackedBPTrie* packed = llfs::pack_object(trie, &packer);
+      ASSERT_NE(packed, nullptr);
+
+      std::vector<batt::Interval<usize>> results(query_views.size());
+      packed->find_many(batt::as_slice(query_views), results.data());
+
+      for (usize i = 0; i < query_views.size(); ++i) {
+        ASSERT_EQ(results[i], packed->find(query_views[i]))
+            << BATT_INSPECT(n_keys) << BATT_INSPECT(i) << BATT_INSPECT_STR(query_views[i]);
+        ASSERT_EQ(results[i], trie.find(query_views[i]))
+            << BATT_INSPECT(n_keys) << BATT_INSPECT(i) << BATT_INSPECT_STR(query_views[i]);
+      }
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// PackedBPTrieKeySeq returns the keys of the trie in order, from any start index, in every offset
+// size and layout; keys longer than one prefix chunk (127 bytes) are rebuilt correctly too.
+//
+TEST(Trie, KeySeq)
+{
+  const std::vector<std::string> words = load_words();
+
+  std::vector<std::string> long_keys;
+  for (usize i = 0; i < 200; ++i) {
+    long_keys.emplace_back(std::string(100 + i, 'k') + std::to_string(i % 10) +
+                           std::string(i % 7, 'z'));
+  }
+  std::sort(long_keys.begin(), long_keys.end());
+  long_keys.erase(std::unique(long_keys.begin(), long_keys.end()), long_keys.end());
+
+  std::vector<std::vector<std::string>> key_sets;
+  for (const usize n_keys : {usize{0}, usize{1}, usize{2}, usize{100}, usize{10 * 1000},
+                             words.size()}) {
+    key_sets.emplace_back(words.begin(), std::next(words.begin(), std::min(n_keys, words.size())));
+  }
+  key_sets.emplace_back(long_keys);
+
+  for (const std::vector<std::string>& keys : key_sets) {
+    BPTrie trie{keys};
+
+    for (const auto layout :
+         {BPTrie::PackedLayout::kBreadthFirst, BPTrie::PackedLayout::kVanEmdeBoas,
+          BPTrie::PackedLayout::kCacheLineBlocked}) {
+      trie.set_packed_layout(layout);
+
+      std::vector<u8> buffer(llfs::packed_sizeof(trie));
+      llfs::DataPacker packer{llfs::MutableBuffer{buffer.data(), buffer.size()}};
+      const PackedBPTrie* packed = llfs::pack_object(trie, &packer);
+      ASSERT_NE(packed, nullptr);
+
+      // Full scan.
+      {
+        llfs::PackedBPTrieKeySeq seq{*packed};
+        for (usize i = 0; i < keys.size(); ++i) {
+          ASSERT_EQ(seq.index(), i);
+          ASSERT_EQ(seq.peek(), batt::Optional<std::string_view>{keys[i]});
+
+          batt::Optional<std::string_view> key = seq.next();
+          ASSERT_TRUE(key);
+          ASSERT_EQ(*key, keys[i]) << BATT_INSPECT(i) << BATT_INSPECT(keys.size());
+        }
+        EXPECT_EQ(seq.index(), keys.size());
+        EXPECT_EQ(seq.next(), batt::None);
+        EXPECT_EQ(seq.peek(), batt::None);
+      }
+
+      // Partial scans from various start indices.
+      //
+      for (usize begin = 0; begin <= keys.size(); begin += std::max<usize>(1, keys.size() / 37)) {
+        llfs::PackedBPTrieKeySeq seq{*packed, begin};
+        for (usize i = begin; i < std::min(begin + 50, keys.size()); ++i) {
+          batt::Optional<std::string_view> key = seq.next();
+          ASSERT_TRUE(key);
+          ASSERT_EQ(*key, keys[i]) << BATT_INSPECT(begin) << BATT_INSPECT(i);
+        }
+        if (begin == keys.size()) {
+          EXPECT_EQ(seq.next(), batt::None);
+        }
+      }
+
+      // Starting past the end gives an empty Seq.
+      {
+        llfs::PackedBPTrieKeySeq seq{*packed, keys.size() + 10};
+        EXPECT_EQ(seq.index(), keys.size());
+        EXPECT_EQ(seq.next(), batt::None);
+      }
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Compares PackedBPTrie::find across the three packed layouts, by key count and key length.
+// Prints one CSV row per (key count, key length) to stderr: the packed size and the average lookup
+// time (ns) for each layout.  Set LLFS_EXTRA_TESTING=1 for the larger key counts.
+//
+TEST(Trie, LayoutBenchmark)
+{
+  const bool extra_testing = batt::getenv_as<int>("LLFS_EXTRA_TESTING").value_or(0);
+
+  const std::vector<usize> key_counts = extra_testing
+                                            ? std::vector<usize>{64, 256, 1024, 16 * 1024,
+                                                                 256 * 1024}
+                                            : std::vector<usize>{64, 256, 1024};
+  const usize kMinLookupCount = extra_testing ? 4 * 1000 * 1000 : 100 * 1000;
+
+  const std::array<BPTrie::PackedLayout, 3> layouts{
+      BPTrie::PackedLayout::kBreadthFirst,
+      BPTrie::PackedLayout::kVanEmdeBoas,
+      BPTrie::PackedLayout::kCacheLineBlocked,
+  };
+
+  std::cerr << "key_count, key_len, size(BFS), size(vEB), size(CLB), ns(BFS), ns(vEB), ns(CLB)"
+            << std::endl;
+
+  std::default_random_engine rng{/*seed=*/58};
+
+  for (const usize key_count : key_counts) {
+    for (const usize key_len : {usize{8}, usize{32}, usize{128}}) {
+      // Random keys over a small alphabet, so that they share prefixes the way real keys do.
+      //
+      std::uniform_int_distribution<int> pick_char{'a', 'h'};
+      std::vector<std::string> keys(key_count);
+      for (std::string& key : keys) {
+        key.resize(key_len);
+        for (char& ch : key) {
+          ch = (char)pick_char(rng);
+        }
+      }
+      std::sort(keys.begin(), keys.end());
+      keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+      std::vector<std::string_view> queries(keys.begin(), keys.end());
+      std::shuffle(queries.begin(), queries.end(), rng);
+
+      BPTrie trie{keys};
+
+      std::cerr << key_count << ", " << key_len;
+
+      std::array<double, 3> ns_per_lookup;
+      for (usize i = 0; i < layouts.size(); ++i) {
+        trie.set_packed_layout(layouts[i]);
+
+        std::vector<u8> buffer(llfs::packed_sizeof(trie));
+        llfs::DataPacker packer{llfs::MutableBuffer{buffer.data(), buffer.size()}};
+        const PackedBPTrie* packed = llfs::pack_object(trie, &packer);
+        ASSERT_NE(packed, nullptr);
+
+        std::cerr << ", " << buffer.size();
+
+        const usize repeat = (kMinLookupCount + queries.size() - 1) / queries.size();
+        usize checksum = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (usize n = 0; n < repeat; ++n) {
+          for (const std::string_view& key : queries) {
+            checksum += packed->find(key).lower_bound;
+          }
+        }
+        const i64 nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+
+        EXPECT_EQ(checksum, repeat * (queries.size() * (queries.size() - 1) / 2));
+
+        ns_per_lookup[i] = double(nsec) / double(repeat * queries.size());
+      }
+
+      for (const double ns : ns_per_lookup) {
+        std::cerr << ", " << ns;
+      }
+      std::cerr << std::endl;
+    }
+  }
+}
+
 }  // namespace
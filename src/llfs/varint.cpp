@@ -11,11 +11,59 @@
 
 #include <batteries/assert.hpp>
 
+#include <boost/endian/conversion.hpp>
+
+#include <algorithm>
+#include <cstring>
+
 namespace llfs {
 
 namespace {
 constexpr u64 kLowBitsMask = 0b01111111;
 constexpr u8 kHighBitMask = 0b10000000;
+
+// The high (continuation) bit and the low 7 bits of every byte in a 64-bit word.
+//
+constexpr u64 kWordHighBitsMask = 0x8080808080808080ull;
+constexpr u64 kWordLowBitsMask = 0x7f7f7f7f7f7f7f7full;
+
+// Loads the 8 bytes at `p` as a little-endian word (byte 0 in the low bits).
+//
+inline u64 load_varint_word(const u8* p)
+{
+  u64 word;
+  std::memcpy(&word, p, sizeof(word));
+  return boost::endian::little_to_native(word);
+}
+
+// Decodes the varint at the start of `word` (as returned by `load_varint_word`) if it is at most
+// 8 bytes long, storing its value in `*value` and returning its length; returns 0 if the varint is
+// longer than 8 bytes.
+//
+inline usize decode_varint_word(u64 word, u64* value)
+{
+  const u64 stop_bits = ~word & kWordHighBitsMask;
+  if (stop_bits == 0) {
+    return 0;
+  }
+
+  // The last byte of the varint is the first one whose high bit is clear.
+  //
+  const usize len = (__builtin_ctzll(stop_bits) >> 3) + 1;
+  const u64 len_mask = (len == 8) ? ~u64{0} : ((u64{1} << (len * 8)) - 1);
+
+  // Squeeze out the high bit of each byte: pairs of 7-bit groups into 14 bits, then pairs of those
+  // into 28 bits, then into 56 bits.
+  //
+  u64 x = word & len_mask & kWordLowBitsMask;
+  x = (x & 0x007f007f007f007full) | ((x & 0x7f007f007f007f00ull) >> 1);
+  x = (x & 0x00003fff00003fffull) | ((x & 0x3fff00003fff0000ull) >> 2);
+  x = (x & 0x000000000fffffffull) | ((x & 0x0fffffff00000000ull) >> 4);
+
+  *value = x;
+  return len;
+}
+
 }  // namespace
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -90,6 +138,14 @@ u8* pack_varint_to(u8* first, u8* last, u64 n)
 //
 std::tuple<Optional<u64>, const u8*> unpack_varint_from(const u8* first, const u8* last)
 {
+  if (last - first >= 8) {
+    u64 value;
+    const usize len = decode_varint_word(load_varint_word(first), &value);
+    if (len != 0) {
+      return {{value}, first + len};
+    }
+  }
+
   u64 n = 0;
   int shift = 0;
   for (;;) {
@@ -108,4 +164,93 @@ std::tuple<Optional<u64>, const u8*> unpack_varint_from(const u8* first, const u
   return {{n}, first};
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize packed_sizeof_varints(const batt::Slice<const u64>& values)
+{
+  usize total = 0;
+  for (const u64 n : values) {
+    total += packed_sizeof_varint(n);
+  }
+  return total;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u8* pack_varints_to(u8* first, u8* last, const batt::Slice<const u64>& values)
+{
+  if (static_cast<usize>(last - first) < packed_sizeof_varints(values)) {
+    return nullptr;
+  }
+
+  for (const u64 n : values) {
+    if (n <= kLowBitsMask) {
+      *first = static_cast<u8>(n);
+      ++first;
+    } else {
+      first = pack_varint_to(first, last, n);
+      BATT_CHECK_NOT_NULLPTR(first);
+    }
+  }
+
+  return first;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+const u8* unpack_varints_from(const u8* first, const u8* last, const batt::Slice<u64>& values)
+{
+  u64* out = values.begin();
+  u64* const out_end = values.end();
+
+  // While a whole word can be loaded, decode from the word.
+  //
+  while (out != out_end && last - first >= 8) {
+    const u64 word = load_varint_word(first);
+
+    if ((word & kWordHighBitsMask) == 0) {
+      // Eight single-byte varints.
+      //
+      const usize count = std::min<usize>(8, out_end - out);
+      for (usize i = 0; i < count; ++i) {
+        out[i] = (word >> (i * 8)) & 0xff;
+      }
+      out += count;
+      first += count;
+      continue;
+    }
+
+    const usize len = decode_varint_word(word, out);
+    if (len != 0) {
+      ++out;
+      first += len;
+      continue;
+    }
+
+    // A 9 or 10 byte varint; decode it the slow way.
+    //
+    Optional<u64> n;
+    std::tie(n, first) = unpack_varint_from(first, last);
+    if (!n) {
+      return nullptr;
+    }
+    *out = *n;
+    ++out;
+  }
+
+  // Finish up byte by byte near the end of the input.
+  //
+  while (out != out_end) {
+    Optional<u64> n;
+    std::tie(n, first) = unpack_varint_from(first, last);
+    if (!n) {
+      return nullptr;
+    }
+    *out = *n;
+    ++out;
+  }
+
+  return first;
+}
+
 }  // namespace llfs
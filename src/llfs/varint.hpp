@@ -15,6 +15,7 @@
 #include <llfs/int_types.hpp>
 #include <llfs/optional.hpp>
 
+#include <batteries/slice.hpp>
 #include <batteries/static_assert.hpp>
 
 #include <limits>
@@ -73,6 +74,26 @@ u8* pack_varint_to(u8* first, u8* last, u64 n);
 //
 std::tuple<Optional<u64>, const u8*> unpack_varint_from(const u8* first, const u8* last);
 
+// Returns the total size of the varint representations of `values`.
+//
+usize packed_sizeof_varints(const batt::Slice<const u64>& values);
+
+// Packs all of `values`, in order, as consecutive varints into [first, last).  Returns a pointer to
+// the byte after the last one packed, or nullptr (having written nothing) if there isn't enough
+// space for all of them.
+//
+u8* pack_varints_to(u8* first, u8* last, const batt::Slice<const u64>& values);
+
+// Decodes `values.size()` consecutive varints from [first, last) into `values`.  Returns a pointer
+// to the byte after the last varint parsed, or nullptr if the range ends before all of them have
+// been decoded (in which case the contents of `values` are unspecified).
+//
+// Produces the same values as calling `unpack_varint_from` repeatedly, but decodes a whole 64-bit
+// word at a time where it can: eight single-byte varints at once, or one varint of up to eight
+// bytes without a per-byte loop.
+//
+const u8* unpack_varints_from(const u8* first, const u8* last, const batt::Slice<u64>& values);
+
 }  // namespace llfs
 
 #endif  // LLFS_VARINT_HPP
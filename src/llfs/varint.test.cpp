@@ -15,6 +15,7 @@
 
 #include <llfs/logging.hpp>
 
+#include <llfs/data_packer.hpp>
 #include <llfs/data_reader.hpp>
 
 #include <bitset>
@@ -85,4 +86,75 @@ TEST(VarIntTest, RandomValues)
   }
 }
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// pack_varints_to/unpack_varints_from round-trip sequences of varints of mixed sizes (including
+// long runs of single-byte values), agree with the one-at-a-time functions, and fail cleanly on
+// truncated input or a short output buffer.
+//
+TEST(VarIntTest, BulkRoundTrip)
+{
+  std::default_random_engine rng{61};
+
+  for (usize trial = 0; trial < 1000; ++trial) {
+    std::vector<u64> values(trial % 97);
+    for (u64& n : values) {
+      const usize bits = std::uniform_int_distribution<usize>{0, 64}(rng);
+      n = (bits == 0) ? 0 : (u64{rng()} << 32 | rng()) >> (64 - bits);
+      if (trial % 3 == 0) {
+        n &= 0x7f;
+      }
+    }
+
+    const usize packed_size = llfs::packed_sizeof_varints(batt::as_slice(values));
+    std::vector<u8> storage(packed_size + (trial % 2) * 17);
+
+    u8* const packed_end = llfs::pack_varints_to(storage.data(), storage.data() + storage.size(),
+                                                 batt::as_slice(values));
+    ASSERT_EQ(packed_end, storage.data() + packed_size);
+
+    // The bulk encoding is the same as packing each value on its own.
+    {
+      const u8* next = storage.data();
+      for (u64 n : values) {
+        Optional<u64> out;
+        std::tie(out, next) = llfs::unpack_varint_from(next, storage.data() + storage.size());
+        ASSERT_TRUE(out);
+        EXPECT_EQ(*out, n);
+      }
+      EXPECT_EQ(next, packed_end);
+    }
+
+    std::vector<u64> unpacked(values.size());
+    EXPECT_EQ(llfs::unpack_varints_from(storage.data(), storage.data() + storage.size(),
+                                        batt::as_slice(unpacked)),
+              packed_end);
+    EXPECT_EQ(unpacked, values);
+
+    // Through DataPacker and DataReader.
+    {
+      std::vector<u8> buffer(packed_size);
+      llfs::DataPacker packer{MutableBuffer{buffer.data(), buffer.size()}};
+      if (!values.empty()) {
+        ASSERT_NE(packer.pack_varints(batt::as_slice(values)), nullptr);
+      }
+      EXPECT_EQ(buffer, std::vector<u8>(storage.begin(), storage.begin() + packed_size));
+
+      llfs::DataReader reader{ConstBuffer{buffer.data(), buffer.size()}};
+      std::vector<u64> read_values(values.size());
+      ASSERT_TRUE(reader.read_varints(batt::as_slice(read_values)));
+      EXPECT_EQ(read_values, values);
+      EXPECT_EQ(reader.bytes_available(), 0u);
+    }
+
+    if (!values.empty()) {
+      EXPECT_EQ(llfs::pack_varints_to(storage.data(), storage.data() + packed_size - 1,
+                                      batt::as_slice(values)),
+                nullptr);
+      EXPECT_EQ(llfs::unpack_varints_from(storage.data(), storage.data() + packed_size - 1,
+                                          batt::as_slice(unpacked)),
+                nullptr);
+    }
+  }
+}
+
 }  // namespace
@@ -9,7 +9,9 @@
 #include <llfs/volume.hpp>
 //
 
+#include <llfs/appendable_job.hpp>
 #include <llfs/pack_as_raw.hpp>
+#include <llfs/slot_reader.hpp>
 #include <llfs/volume_job_recovery_visitor.hpp>
 #include <llfs/volume_metadata_recovery_visitor.hpp>
 #include <llfs/volume_reader.hpp>
@@ -17,8 +19,36 @@
 
 #include <boost/uuid/random_generator.hpp>
 
+#include <algorithm>
+
 namespace llfs {
 
+namespace {
+
+// The user data of a snapshot slot: packed as raw bytes, with the snapshot's root page refs.
+//
+struct SnapshotUserData {
+  std::string_view bytes;
+  const std::vector<PageId>* root_page_ids;
+};
+
+usize packed_sizeof(const SnapshotUserData& user_data)
+{
+  return packed_sizeof(pack_as_raw(user_data.bytes));
+}
+
+PackedRawData* pack_object(const SnapshotUserData& user_data, DataPacker* dst)
+{
+  return pack_object(pack_as_raw(user_data.bytes), dst);
+}
+
+BoxedSeq<PageId> trace_refs(const SnapshotUserData& user_data)
+{
+  return as_seq(*user_data.root_page_ids) | seq::decayed() | seq::boxed();
+}
+
+}  // namespace
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 /*static*/ bool Volume::write_new_pages_asap()
@@ -32,6 +62,56 @@ namespace llfs {
   return value;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+VolumeWritePolicy Volume::write_policy() const
+{
+  if (this->options_.write_policy == VolumeWritePolicy::kDefault) {
+    return write_new_pages_asap() ? VolumeWritePolicy::kEager : VolumeWritePolicy::kDeferred;
+  }
+  return this->options_.write_policy;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool Volume::should_write_new_pages_early(const CommittablePageCacheJob& job)
+{
+  if (job.new_page_count() == 0) {
+    return false;
+  }
+
+  const bool early = [&] {
+    switch (this->write_policy()) {
+      case VolumeWritePolicy::kEager:
+        return true;
+
+      case VolumeWritePolicy::kAdaptive: {
+        const usize max_in_flight = (this->options_.adaptive_write_queue_depth != 0)
+                                        ? this->options_.adaptive_write_queue_depth
+                                        : VolumeOptions::kDefaultAdaptiveWriteQueueDepth;
+        bool idle = true;
+        job.page_device_ids() | seq::for_each([&](page_device_id_int device_id) {
+          if (this->cache_->page_writes_in_flight(device_id) >= max_in_flight) {
+            idle = false;
+          }
+        });
+        return idle;
+      }
+
+      default:
+        return false;
+    }
+  }();
+
+  if (early) {
+    this->metrics_.eager_page_write_job_count.add(1);
+  } else {
+    this->metrics_.deferred_page_write_job_count.add(1);
+  }
+
+  return early;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 const VolumeOptions& Volume::options() const
@@ -78,6 +158,69 @@ u64 Volume::calculate_grant_size(const AppendableJob& appendable) const
   return appendable.calculate_grant_size();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+u64 Volume::calculate_batch_grant_size(const Slice<const std::string_view>& payloads) const
+{
+  u64 total = 0;
+  for (const std::string_view& payload : payloads) {
+    total += this->calculate_grant_size(payload);
+  }
+  return total;
+}
+
+namespace {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Seeds `metadata_visitor` from the latest PackedVolumeMetadataCheckpoint in the log (if there is
+// one) and skips `slot_reader` forward to the checkpoint's replay lower bound.
+//
+Status seek_to_metadata_checkpoint(LogDevice::Reader& log_reader,
+                                   TypedSlotReader<VolumeEventVariant>& slot_reader,
+                                   VolumeMetadataRecoveryVisitor& metadata_visitor)
+{
+  Optional<SlotParse> checkpoint_slot =
+      find_latest_volume_metadata_checkpoint(log_reader.data(), log_reader.slot_offset());
+
+  if (!checkpoint_slot) {
+    return OkStatus();
+  }
+
+  Optional<slot_offset_type> replay_lower_bound;
+
+  BATT_REQUIRE_OK(TypedSlotReader<VolumeEventVariant>::visit_slot(
+      *checkpoint_slot, checkpoint_slot->body,
+      [&](const SlotParse& slot,
+          const Ref<const PackedVolumeMetadataCheckpoint>& checkpoint) -> Status {
+        LLFS_VLOG(1) << "Recovering Volume metadata from checkpoint at " << slot.offset << ": "
+                     << checkpoint.get();
+
+        replay_lower_bound = checkpoint.get().replay_lower_bound;
+        return metadata_visitor.on_volume_metadata_checkpoint(slot, checkpoint);
+      },
+      [](const SlotParse&, const auto&) -> Status {
+        return OkStatus();
+      }));
+
+  BATT_CHECK(replay_lower_bound);
+  BATT_CHECK(slot_at_most(*replay_lower_bound, checkpoint_slot->offset.lower_bound))
+      << BATT_INSPECT(replay_lower_bound) << BATT_INSPECT(checkpoint_slot->offset);
+
+  // The checkpoint slot itself is replayed again, so the metadata visitor sees it after any
+  // (older) metadata slots in [replay_lower_bound, checkpoint).
+  //
+  if (slot_less_than(log_reader.slot_offset(), *replay_lower_bound)) {
+    LLFS_VLOG(1) << "Skipping root log replay from " << log_reader.slot_offset() << " to "
+                 << *replay_lower_bound;
+
+    slot_reader.skip(slot_distance(log_reader.slot_offset(), *replay_lower_bound));
+  }
+
+  return OkStatus();
+}
+
+}  // namespace
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 /*static*/ auto Volume::recover(VolumeRecoverParams&& params,
@@ -122,11 +265,21 @@ u64 Volume::calculate_grant_size(const AppendableJob& appendable) const
                             [&](LogDevice::Reader& log_reader) -> StatusOr<slot_offset_type> {
                               TypedSlotReader<VolumeEventVariant> slot_reader{log_reader};
 
+                              // Without a user slot visitor, only the Volume metadata and pending
+                              // jobs are needed; start replay from the latest checkpoint, if any.
+                              //
+                              if (!slot_visitor_fn) {
+                                BATT_REQUIRE_OK(seek_to_metadata_checkpoint(
+                                    log_reader, slot_reader, metadata_visitor));
+                              }
+
                               StatusOr<usize> slots_read = slot_reader.run(
                                   batt::WaitForResource::kFalse, [&](auto&&... args) -> Status {
                                     BATT_REQUIRE_OK(job_visitor(args...));
                                     BATT_REQUIRE_OK(metadata_visitor(args...));
-                                    BATT_REQUIRE_OK(user_fn_visitor(args...));
+                                    if (slot_visitor_fn) {
+                                      BATT_REQUIRE_OK(user_fn_visitor(args...));
+                                    }
                                     return batt::OkStatus();
                                   });
 
@@ -156,6 +309,14 @@ u64 Volume::calculate_grant_size(const AppendableJob& appendable) const
   auto metadata_refresher =
       std::make_unique<VolumeMetadataRefresher>(*slot_writer, batt::make_copy(metadata));
   {
+    // The Volume attaches to every arena below; let any lazily recovered arenas (see
+    // StorageContext::set_lazy_arena_recovery) recover concurrently, instead of one at a time.
+    //
+    for (PageCache::PageDeviceEntry* entry : cache->all_devices()) {
+      BATT_CHECK_NOT_NULLPTR(entry);
+      entry->arena.start_recovery();
+    }
+
     for (const boost::uuids::uuid& uuid : {
              metadata.ids->main_uuid,
              metadata.ids->recycler_uuid,
@@ -249,8 +410,14 @@ u64 Volume::calculate_grant_size(const AppendableJob& appendable) const
                    << BATT_INSPECT(VolumeMetadata::kAttachmentGrantSize)
                    << BATT_INSPECT(reclaimable_size);
 
-      batt::Grant initial_metadata_refresh_grant = BATT_OK_RESULT_OR_PANIC(
-          slot_writer->reserve(initial_refresh_grant_size, batt::WaitForResource::kFalse));
+      // When recovery started from a checkpoint, duplicate metadata slots before the replay lower
+      // bound are not counted in `reclaimable_size`; never ask for more than the pool has, since
+      // the trimmer tops up the refresher grant as those slots are trimmed.
+      //
+      batt::Grant initial_metadata_refresh_grant =
+          BATT_OK_RESULT_OR_PANIC(slot_writer->reserve(
+              std::min<usize>(initial_refresh_grant_size, slot_writer->pool_size()),
+              batt::WaitForResource::kFalse));
 
       BATT_REQUIRE_OK(metadata_refresher->update_grant_partial(initial_metadata_refresh_grant));
     }
@@ -267,6 +434,16 @@ u64 Volume::calculate_grant_size(const AppendableJob& appendable) const
 
     LLFS_VLOG(1) << "Pending jobs resolved";
 
+    // Now that there are no pending jobs, write a metadata checkpoint so that the next recovery can
+    // skip everything before this point.
+    //
+    StatusOr<SlotRange> checkpoint_slot = metadata_refresher->write_checkpoint(
+        /*trim_pos=*/root_log->slot_range(LogReadMode::kSpeculative).lower_bound);
+
+    if (!checkpoint_slot.ok()) {
+      LLFS_VLOG(1) << "Volume metadata checkpoint not written: " << checkpoint_slot.status();
+    }
+
     // Notify all PageAllocators that we are done with recovery.
     //
     for (const boost::uuids::uuid& uuid : {
@@ -298,7 +475,8 @@ u64 Volume::calculate_grant_size(const AppendableJob& appendable) const
                             *slot_writer,                                                  //
                             VolumeTrimmer::make_default_drop_roots_fn(*cache, *recycler),  //
                             *params.trim_control,                                          //
-                            *metadata_refresher                                            //
+                            *metadata_refresher,                                           //
+                            params.trimmer_options                                         //
                             ));
 
   // Create the Volume object.
@@ -483,12 +661,29 @@ StatusOr<SlotRange> Volume::append(const std::string_view& payload, batt::Grant&
   return this->append(pack_as_raw(payload), grant);  // PackableRef
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::vector<SlotRange>> Volume::append_batch(
+    const Slice<const std::string_view>& payloads, batt::Grant& grant)
+{
+  // As in `append`, the payloads are packed as raw data so that they are visited as exactly the
+  // same bytes.
+  //
+  std::vector<PackAsRawData> packed_as_raw;
+  packed_as_raw.reserve(payloads.size());
+  for (const std::string_view& payload : payloads) {
+    packed_as_raw.emplace_back(pack_as_raw(payload));
+  }
+
+  return this->append_batch<PackAsRawData>(as_slice(packed_as_raw), grant);
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 StatusOr<SlotRange> Volume::append(AppendableJob&& appendable, batt::Grant& grant,
                                    Optional<SlotSequencer>&& sequencer)
 {
-  if (write_new_pages_asap()) {
+  if (this->should_write_new_pages_early(appendable.job)) {
     BATT_REQUIRE_OK(appendable.job.start_writing_new_pages());
   }
 
@@ -550,19 +745,37 @@ StatusOr<SlotRange> Volume::append(AppendableJob&& appendable, batt::Grant& gran
     //
     Optional<SlotReadLock> trim_lock;
 
+    // Set in the post-commit-fn of the prepare slot; removes the job from the metadata refresher's
+    // pending jobs once it is committed.
+    //
+    Optional<PendingSlotRing::Ticket> pending_job;
+
+    // The job is no longer pending once this call returns, whether or not it succeeded: on
+    // failure, the trim lock is released as well, so nothing protects the prepare slot anyway.
+    //
+    const auto retire_pending_job = batt::finally([&] {
+      if (pending_job) {
+        this->metadata_refresher_->remove_pending_job(*pending_job);
+      }
+    });
+
     // Append the prepare!
     //
     StatusOr<SlotParseWithPayload<const PackedPrepareJob*>> prepare_slot = LLFS_COLLECT_LATENCY(
         this->metrics_.prepare_slot_append_latency,
         this->slot_writer_->typed_append(
             grant, std::move(prepared_job),
-            [this, &prev_user_slot, &trim_lock](StatusOr<SlotRange> slot_range) {
+            [this, &prev_user_slot, &trim_lock, &pending_job](StatusOr<SlotRange> slot_range) {
               if (slot_range.ok()) {
                 // Set the prev_user_slot.
                 //
                 trim_lock.emplace(BATT_OK_RESULT_OR_PANIC(
                     this->trim_control_->lock_slots(*slot_range, "Volume::append(job)")));
 
+                // Keep metadata checkpoints from skipping this job until it is resolved.
+                //
+                pending_job = this->metadata_refresher_->add_pending_job(slot_range->lower_bound);
+
                 // Acquire a read lock to prevent premature trimming.
                 //
                 prev_user_slot = this->latest_user_slot_.exchange(slot_range->lower_bound);
@@ -694,6 +907,95 @@ struct PrepareJob_must_be_passed_to_Volume_append_by_move* Volume::append(const
   return nullptr;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<VolumeSnapshot> Volume::snapshot(const std::string_view& user_data,
+                                          batt::WaitForResource wait_for_log_space)
+{
+  // Make sure every job appended so far is visible to the (durable) reader below.
+  //
+  BATT_REQUIRE_OK(this->sync(LogReadMode::kDurable,
+                             SlotUpperBoundAt{
+                                 this->root_log_slot_range(LogReadMode::kSpeculative).upper_bound,
+                             }));
+
+  // The reader's lock keeps the commit slots we find from being trimmed (and so their root pages
+  // from being dropped) until the snapshot job holds its own refs.
+  //
+  StatusOr<VolumeReader> reader = this->reader(SlotRangeSpec{None, None}, LogReadMode::kDurable);
+  BATT_REQUIRE_OK(reader);
+
+  SlotRange covered_slot_range{
+      .lower_bound = reader->slot_range().lower_bound,
+      .upper_bound = reader->slot_range().lower_bound,
+  };
+
+  std::vector<PageId> root_page_ids;
+  for (;;) {
+    StatusOr<usize> n_visited = reader->visit_next(
+        batt::WaitForResource::kFalse,
+        [&](const SlotParse& slot, std::string_view /*user_data*/) -> Status {
+          covered_slot_range.upper_bound = slot.offset.upper_bound;
+
+          // The body of a user slot appended as part of a job is the commit slot, which lists the
+          // job's root page refs.
+          //
+          return TypedSlotReader<VolumeEventVariant>::visit_slot(
+              slot, slot.body,
+              [&root_page_ids](const SlotParse&, const Ref<const PackedCommitJob>& commit) {
+                for (const PackedPageId& page_id : *commit.get().root_page_ids) {
+                  root_page_ids.emplace_back(page_id.unpack());
+                }
+                return OkStatus();
+              },
+              [](const SlotParse&, const auto&) {
+                return OkStatus();
+              });
+        });
+
+    BATT_REQUIRE_OK(n_visited);
+
+    if (*n_visited == 0) {
+      break;
+    }
+  }
+
+  // One extra ref per distinct root is enough to keep the whole tree alive.
+  //
+  std::sort(root_page_ids.begin(), root_page_ids.end());
+  root_page_ids.erase(std::unique(root_page_ids.begin(), root_page_ids.end()),
+                      root_page_ids.end());
+
+  const SnapshotUserData snapshot_user_data{
+      .bytes = user_data,
+      .root_page_ids = &root_page_ids,
+  };
+
+  StatusOr<AppendableJob> appendable =
+      make_appendable_job(this->new_job(), PackableRef{snapshot_user_data});
+  BATT_REQUIRE_OK(appendable);
+
+  StatusOr<batt::Grant> grant =
+      this->reserve(this->calculate_grant_size(*appendable), wait_for_log_space);
+  BATT_REQUIRE_OK(grant);
+
+  StatusOr<SlotRange> snapshot_slot = this->append(std::move(*appendable), *grant);
+  BATT_REQUIRE_OK(snapshot_slot);
+
+  BATT_REQUIRE_OK(
+      this->sync(LogReadMode::kDurable, SlotUpperBoundAt{snapshot_slot->upper_bound}));
+
+  StatusOr<SlotReadLock> snapshot_lock =
+      this->lock_slots(*snapshot_slot, LogReadMode::kDurable, "Volume::snapshot");
+  BATT_REQUIRE_OK(snapshot_lock);
+
+  LLFS_VLOG(1) << "Volume::snapshot:" << BATT_INSPECT(covered_slot_range)
+               << BATT_INSPECT(*snapshot_slot) << BATT_INSPECT(root_page_ids.size());
+
+  return VolumeSnapshot{covered_slot_range, *snapshot_slot, std::move(root_page_ids),
+                        std::move(*snapshot_lock)};
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 Status Volume::await_trim(slot_offset_type slot_lower_bound)
@@ -16,6 +16,7 @@
 #include <llfs/page_cache.hpp>
 #include <llfs/page_cache_job.hpp>
 #include <llfs/page_recycler.hpp>
+#include <llfs/slice.hpp>
 #include <llfs/slot.hpp>
 #include <llfs/slot_lock_manager.hpp>
 #include <llfs/slot_sequencer.hpp>
@@ -24,14 +25,17 @@
 #include <llfs/volume_options.hpp>
 #include <llfs/volume_reader.hpp>
 #include <llfs/volume_reader.ipp>
+#include <llfs/volume_snapshot.hpp>
 #include <llfs/volume_trimmer.hpp>
 
 #include <batteries/async/grant.hpp>
+#include <batteries/async/mutex.hpp>
 #include <batteries/async/task_scheduler.hpp>
 #include <batteries/shared_ptr.hpp>
 
 #include <memory>
 #include <type_traits>
+#include <vector>
 
 namespace llfs {
 
@@ -42,9 +46,14 @@ struct VolumeRecoverParams {
   LogDeviceFactory* root_log_factory;
   LogDeviceFactory* recycler_log_factory;
   std::shared_ptr<SlotLockManager> trim_control;
+
+  // Controls incremental trimming of the root log; see VolumeTrimmerOptions.
+  //
+  VolumeTrimmerOptions trimmer_options;
 };
 
 class VolumeJobRecoveryVisitor;
+struct MultiVolumeJobPart;
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 //
@@ -53,11 +62,18 @@ class Volume
  public:
   friend class VolumeReader;
 
+  friend StatusOr<std::vector<SlotRange>> append_multi_volume_job(
+      std::unique_ptr<PageCacheJob>&& job, std::vector<MultiVolumeJobPart>&& parts,
+      batt::WaitForResource wait_for_log_space);
+
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 
   // Read the Volume state from the passed log devices and resolve any pending jobs by committing or
   // rolling back so the Volume is in a clean state.
   //
+  // If `slot_visitor_fn` is empty, no user slots are replayed, and the root log is only replayed
+  // from the latest PackedVolumeMetadataCheckpoint (if any) onward.
+  //
   static StatusOr<std::unique_ptr<Volume>> recover(
       VolumeRecoverParams&& params, const VolumeReader::SlotVisitorFn& slot_visitor_fn);
 
@@ -113,6 +129,15 @@ class Volume
   //
   u64 calculate_grant_size(const AppendableJob& appendable) const;
 
+  // Returns the number of bytes needed to append all of `payloads` (see `append_batch`).
+  //
+  template <typename T>
+  u64 calculate_batch_grant_size(const Slice<const T>& payloads) const;
+
+  // Returns the number of bytes needed to append all of `payloads` (see `append_batch`).
+  //
+  u64 calculate_batch_grant_size(const Slice<const std::string_view>& payloads) const;
+
   // Atomically append a new slot containing `payload` to the end of the root log.
   //
   template <typename T>
@@ -122,6 +147,21 @@ class Volume
   //
   StatusOr<SlotRange> append(const std::string_view& payload, batt::Grant& grant);
 
+  // Atomically append one new slot per element of `payloads` to the end of the root log, all at
+  // once (with a single SlotWriter prepare/commit).  The slots are contiguous and in the order of
+  // `payloads`; returns the range of each slot.
+  //
+  template <typename T>
+  StatusOr<std::vector<SlotRange>> append_batch(const Slice<const T>& payloads,
+                                                batt::Grant& grant);
+
+  // Atomically append one new slot per element of `payloads` to the end of the root log, all at
+  // once (with a single SlotWriter prepare/commit).  The slots are contiguous and in the order of
+  // `payloads`; returns the range of each slot.
+  //
+  StatusOr<std::vector<SlotRange>> append_batch(const Slice<const std::string_view>& payloads,
+                                                batt::Grant& grant);
+
   // Create a new PageCacheJob for writing new pages via the WAL of this Volume.
   //
   std::unique_ptr<PageCacheJob> new_job() const;
@@ -150,6 +190,14 @@ class Volume
   StatusOr<TypedVolumeReader<T>> typed_reader(const SlotRangeSpec& slot_range, LogReadMode mode,
                                               batt::StaticType<T> = {});
 
+  // Takes a snapshot of the Volume's current root set: appends a job (with `user_data`, which is
+  // visited like any other user slot) that adds one ref to each distinct root page of the jobs
+  // committed so far, and returns a VolumeSnapshot that keeps the job's slot from being trimmed
+  // until it is released.  Does not block concurrent appends.
+  //
+  StatusOr<VolumeSnapshot> snapshot(const std::string_view& user_data,
+                                    batt::WaitForResource wait_for_log_space);
+
   // Blocks until the Volume is closed/failed, or the root log trim position has reached the
   // specified lower bound.
   //
@@ -232,14 +280,34 @@ class Volume
     return this->trimmer_->trim_count();
   }
 
+  /** \brief The total time (usec) the VolumeTrimmer has spent pacing incremental trim steps; see
+   * VolumeTrimmerOptions::max_bytes_per_second.
+   */
+  u64 trim_throttle_delay_usec() const noexcept
+  {
+    return this->trimmer_->throttle_delay_usec();
+  }
+
   // Returns the current valid slot offset range for the root log at the specified durability level.
   //
   SlotRange root_log_slot_range(LogReadMode mode) const;
 
+  // Returns diagnostic metrics for this Volume.
+  //
+  const VolumeMetrics& metrics() const
+  {
+    return this->metrics_;
+  }
+
   // Returns diagnostic metrics for this Volume's PageRecycler.
   //
   const PageRecycler::Metrics& page_recycler_metrics() const;
 
+  // Returns the policy for writing the new pages of appended jobs; never kDefault (which is
+  // resolved using `write_new_pages_asap()`).
+  //
+  VolumeWritePolicy write_policy() const;
+
   /** \brief Returns the root log data corresponding to the given slot read lock.
    *
    * The returned buffer is valid only as long as the lock is held.  The requested/returned slot
@@ -276,6 +344,11 @@ class Volume
   //
   void start();
 
+  // Returns true iff the new pages of `job` should be written before its prepare slot is appended,
+  // according to `write_policy()`; updates the metrics with the decision.
+  //
+  bool should_write_new_pages_early(const CommittablePageCacheJob& job);
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   // TaskScheduler used to launch all background tasks that are created after recovery.
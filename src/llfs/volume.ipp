@@ -41,6 +41,30 @@ StatusOr<SlotRange> Volume::append(const T& payload, batt::Grant& grant)
   return this->slot_writer_->append(grant, packed_obj_as_raw);
 }
 
+template <typename T>
+u64 Volume::calculate_batch_grant_size(const Slice<const T>& payloads) const
+{
+  u64 total = 0;
+  for (const T& payload : payloads) {
+    total += this->calculate_grant_size(payload);
+  }
+  return total;
+}
+
+template <typename T>
+StatusOr<std::vector<SlotRange>> Volume::append_batch(const Slice<const T>& payloads,
+                                                      batt::Grant& grant)
+{
+  std::vector<PackObjectAsRawData<const T&>> packed_objs_as_raw;
+  packed_objs_as_raw.reserve(payloads.size());
+  for (const T& payload : payloads) {
+    packed_objs_as_raw.emplace_back(PackObjectAsRawData<const T&>{payload});
+  }
+
+  return this->slot_writer_->append_batch<PackObjectAsRawData<const T&>>(
+      grant, as_slice(packed_objs_as_raw));
+}
+
 }  // namespace llfs
 
 #endif  // LLFS_VOLUME_IPP
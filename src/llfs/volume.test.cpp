@@ -15,19 +15,28 @@
 
 #include <llfs/testing/fake_log_device.hpp>
 
+#include <llfs/finalized_page_index.hpp>
 #include <llfs/memory_log_device.hpp>
 #include <llfs/memory_page_cache.hpp>
+#include <llfs/multi_volume_job.hpp>
 #include <llfs/opaque_page_view.hpp>
 #include <llfs/packable_ref.hpp>
 #include <llfs/page_graph_node.hpp>
 #include <llfs/raw_volume_log_data_parser.hpp>
 #include <llfs/storage_simulation.hpp>
+#include <llfs/trace_refs_recursive.hpp>
+#include <llfs/volume_commit_pipeline.hpp>
+#include <llfs/volume_compaction.hpp>
 
+#include <batteries/async/runtime.hpp>
 #include <batteries/cpu_align.hpp>
 #include <batteries/env.hpp>
 #include <batteries/state_machine_model.hpp>
 
+#include <chrono>
 #include <cstdlib>
+#include <mutex>
+#include <numeric>
 
 namespace {
 
@@ -131,22 +140,26 @@ class VolumeTest : public ::testing::Test
   template <typename SlotVisitorFn>
   std::unique_ptr<llfs::Volume> open_volume_or_die(llfs::LogDeviceFactory& root_log,
                                                    llfs::LogDeviceFactory& recycler_log,
-                                                   SlotVisitorFn&& slot_visitor_fn)
+                                                   SlotVisitorFn&& slot_visitor_fn,
+                                                   const std::string& name = "test_volume")
   {
     llfs::StatusOr<std::unique_ptr<llfs::Volume>> test_volume_recovered = llfs::Volume::recover(
         llfs::VolumeRecoverParams{
             &batt::Runtime::instance().default_scheduler(),
             llfs::VolumeOptions{
-                .name = "test_volume",
+                .name = name,
                 .uuid = llfs::None,
                 .max_refs_per_page = max_refs_per_page,
                 .trim_lock_update_interval = llfs::TrimLockUpdateInterval{0u},
                 .trim_delay_byte_count = this->trim_delay,
+                .write_policy = this->write_policy,
+                .adaptive_write_queue_depth = this->adaptive_write_queue_depth,
             },
             this->page_cache,
             /*root_log=*/&root_log,
             /*recycler_log=*/&recycler_log,
             nullptr,
+            this->trimmer_options,
         },  //
         BATT_FORWARD(slot_visitor_fn));
 
@@ -419,6 +432,12 @@ class VolumeTest : public ::testing::Test
 
   llfs::TrimDelayByteCount trim_delay{0};
 
+  llfs::VolumeWritePolicy write_policy = llfs::VolumeWritePolicy::kDefault;
+
+  u16 adaptive_write_queue_depth = 0;
+
+  llfs::VolumeTrimmerOptions trimmer_options;
+
   batt::SharedPtr<llfs::PageCache> page_cache;
 
   llfs::Optional<llfs::MemoryLogDevice> root_log;
@@ -470,130 +489,1246 @@ TEST_F(VolumeTest, RecoverEmptyVolume)
   LLFS_VLOG(1) << "done";
 }
 
-//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
-TEST_F(VolumeTest, ReadWriteEvents)
-{
-  std::vector<llfs::slot_offset_type> upsert_slots;
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+TEST_F(VolumeTest, ReadWriteEvents)
+{
+  std::vector<llfs::slot_offset_type> upsert_slots;
+  {
+    // Create an empty volume.
+    //
+    auto fake_root_log = llfs::testing::make_fake_log_device_factory(*this->root_log);
+    auto fake_recycler_log = llfs::testing::make_fake_log_device_factory(*this->recycler_log);
+
+    std::unique_ptr<llfs::Volume> test_volume = this->open_volume_or_die(
+        fake_root_log, fake_recycler_log,
+        /*slot_visitor_fn=*/[](const llfs::SlotParse&, const auto& /*payload*/) {
+          return llfs::OkStatus();
+        });
+
+    this->save_uuids(*test_volume);
+
+    // Verify that there are no key/value pairs.
+    {
+      std::unordered_map<i32, i32> data = this->read_volume(*test_volume);
+
+      EXPECT_THAT(data, ::testing::IsEmpty());
+    }
+
+    // Append slots.
+    //
+    for (i32 key = 0; key < 10; key += 1) {
+      UpsertEvent upsert{key, key * 3 + 1};
+      auto upsert_event = llfs::pack_as_variant<TestVolumeEvent>(upsert);
+
+      llfs::StatusOr<batt::Grant> grant = test_volume->reserve(
+          test_volume->calculate_grant_size(upsert_event), batt::WaitForResource::kFalse);
+
+      ASSERT_TRUE(grant.ok());
+
+      llfs::StatusOr<llfs::SlotRange> appended = test_volume->append(upsert_event, *grant);
+
+      ASSERT_TRUE(appended.ok()) << appended.status();
+
+      upsert_slots.emplace_back(appended->upper_bound);
+    }
+
+    // Flush the log.
+    //
+    llfs::StatusOr<llfs::SlotRange> flushed =
+        test_volume->sync(llfs::LogReadMode::kDurable, llfs::SlotUpperBoundAt{upsert_slots.back()});
+
+    ASSERT_TRUE(flushed.ok());
+
+    // Re-read the root log; now we should see the data we inserted.
+    //
+    {
+      std::unordered_map<i32, i32> data = this->read_volume(*test_volume);
+
+      EXPECT_THAT(data, ::testing::UnorderedElementsAre(
+                            std::make_pair(0, 1), std::make_pair(1, 4), std::make_pair(2, 7),
+                            std::make_pair(3, 10), std::make_pair(4, 13), std::make_pair(5, 16),
+                            std::make_pair(6, 19), std::make_pair(7, 22), std::make_pair(8, 25),
+                            std::make_pair(9, 28)));
+    }
+    //
+    // Close the first volume; we will re-open the log to recover our data below.
+  }
+
+  // Re-open the volume; we should still see the data we inserted.
+  //
+  {
+    auto fake_root_log = llfs::testing::make_fake_log_device_factory(*this->root_log);
+    auto fake_recycler_log = llfs::testing::make_fake_log_device_factory(*this->recycler_log);
+
+    std::unique_ptr<llfs::Volume> test_volume = this->open_volume_or_die(
+        fake_root_log, fake_recycler_log,
+        /*slot_visitor_fn=*/[](const llfs::SlotParse&, const std::string_view&) {
+          return llfs::OkStatus();
+        });
+
+    {
+      std::unordered_map<i32, i32> data = this->read_volume(*test_volume);
+
+      EXPECT_THAT(data, ::testing::UnorderedElementsAre(
+                            std::make_pair(0, 1), std::make_pair(1, 4), std::make_pair(2, 7),
+                            std::make_pair(3, 10), std::make_pair(4, 13), std::make_pair(5, 16),
+                            std::make_pair(6, 19), std::make_pair(7, 22), std::make_pair(8, 25),
+                            std::make_pair(9, 28)));
+    }
+
+    // Trim the log to erase some data.
+    //
+    LLFS_VLOG(1) << "Trimming volume to " << upsert_slots[4];
+    llfs::Status trim_set = test_volume->trim(upsert_slots[4]);
+
+    ASSERT_TRUE(trim_set.ok());
+
+    LLFS_VLOG(1) << "Awaiting trim offset " << upsert_slots[4];
+    llfs::Status trimmed = test_volume->await_trim(upsert_slots[4]);
+
+    ASSERT_TRUE(trimmed.ok());
+  }
+
+  // Re-open the volume one last time; we should see the half we didn't trim.
+  //
+  {
+    auto fake_root_log = llfs::testing::make_fake_log_device_factory(*this->root_log);
+    auto fake_recycler_log = llfs::testing::make_fake_log_device_factory(*this->recycler_log);
+
+    std::unique_ptr<llfs::Volume> test_volume = this->open_volume_or_die(
+        fake_root_log, fake_recycler_log,
+        /*slot_visitor_fn=*/[](const llfs::SlotParse&, const auto& /*payload*/) {
+          return llfs::OkStatus();
+        });
+
+    {
+      std::unordered_map<i32, i32> data = this->read_volume(*test_volume);
+
+      EXPECT_THAT(data, ::testing::UnorderedElementsAre(
+                            std::make_pair(5, 16), std::make_pair(6, 19), std::make_pair(7, 22),
+                            std::make_pair(8, 25), std::make_pair(9, 28)));
+    }
+
+    this->validate_uuids(*test_volume);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Recovering without a slot visitor starts from the latest metadata checkpoint; the recovered
+// Volume must be indistinguishable from one recovered by replaying the whole log.
+//
+TEST_F(VolumeTest, RecoverFromMetadataCheckpoint)
+{
+  constexpr i32 kNumEvents = 10;
+
+  const auto append_events = [](llfs::Volume& test_volume, i32 first_key) {
+    llfs::slot_offset_type last_upper_bound = 0;
+    for (i32 key = first_key; key < first_key + kNumEvents; key += 1) {
+      auto upsert_event = llfs::pack_as_variant<TestVolumeEvent>(UpsertEvent{key, key * 5});
+
+      llfs::StatusOr<batt::Grant> grant = test_volume.reserve(
+          test_volume.calculate_grant_size(upsert_event), batt::WaitForResource::kFalse);
+      BATT_CHECK_OK(grant);
+
+      llfs::StatusOr<llfs::SlotRange> appended = test_volume.append(upsert_event, *grant);
+      BATT_CHECK_OK(appended);
+
+      last_upper_bound = appended->upper_bound;
+    }
+    BATT_CHECK_OK(
+        test_volume.sync(llfs::LogReadMode::kDurable, llfs::SlotUpperBoundAt{last_upper_bound}));
+  };
+
+  const auto expected_data = [](i32 n_keys) {
+    std::unordered_map<i32, i32> data;
+    for (i32 key = 0; key < n_keys; ++key) {
+      data[key] = key * 5;
+    }
+    return data;
+  };
+
+  // Create the Volume, with a page job (so the recycler and page allocator attachments matter)
+  // and some events.
+  //
+  llfs::PageId page_id;
+  {
+    auto fake_root_log = llfs::testing::make_fake_log_device_factory(*this->root_log);
+    auto fake_recycler_log = llfs::testing::make_fake_log_device_factory(*this->recycler_log);
+
+    std::unique_ptr<llfs::Volume> test_volume = this->open_volume_or_die(
+        fake_root_log, fake_recycler_log,
+        /*slot_visitor_fn=*/[](const llfs::SlotParse&, const auto& /*payload*/) {
+          return llfs::OkStatus();
+        });
+
+    this->save_uuids(*test_volume);
+
+    std::unique_ptr<llfs::PageCacheJob> job = test_volume->new_job();
+
+    llfs::StatusOr<llfs::PinnedPage> pinned_page = this->make_opaque_page(*job);
+    ASSERT_TRUE(pinned_page.ok());
+
+    page_id = get_page_id(*pinned_page);
+
+    const std::vector<llfs::PageId> root_ids{page_id};
+
+    llfs::StatusOr<llfs::SlotRange> job_slot = this->append_job(
+        *test_volume, std::move(job),
+        llfs::as_seq(root_ids) | llfs::seq::decayed() | llfs::seq::boxed());
+
+    ASSERT_TRUE(job_slot.ok()) << BATT_INSPECT(job_slot.status());
+
+    append_events(*test_volume, 0);
+  }
+
+  // Recover twice from checkpoints (the first recovery writes the checkpoint the second one
+  // starts from), appending more events each time.
+  //
+  for (i32 i = 1; i <= 2; ++i) {
+    auto fake_root_log = llfs::testing::make_fake_log_device_factory(*this->root_log);
+    auto fake_recycler_log = llfs::testing::make_fake_log_device_factory(*this->recycler_log);
+
+    std::unique_ptr<llfs::Volume> test_volume = this->open_volume_or_die(
+        fake_root_log, fake_recycler_log, /*slot_visitor_fn=*/llfs::VolumeReader::SlotVisitorFn{});
+
+    this->validate_uuids(*test_volume);
+
+    EXPECT_EQ(this->read_volume(*test_volume), expected_data(kNumEvents * i));
+    EXPECT_TRUE(this->verify_opaque_page(page_id, /*expected_ref_count=*/2));
+
+    append_events(*test_volume, kNumEvents * i);
+  }
+
+  // A full replay still sees every event, and agrees with the checkpoint recoveries.
+  //
+  {
+    auto fake_root_log = llfs::testing::make_fake_log_device_factory(*this->root_log);
+    auto fake_recycler_log = llfs::testing::make_fake_log_device_factory(*this->recycler_log);
+
+    usize user_slot_count = 0;
+    std::unique_ptr<llfs::Volume> test_volume = this->open_volume_or_die(
+        fake_root_log, fake_recycler_log,
+        /*slot_visitor_fn=*/[&user_slot_count](const llfs::SlotParse&, const auto& /*payload*/) {
+          ++user_slot_count;
+          return llfs::OkStatus();
+        });
+
+    this->validate_uuids(*test_volume);
+
+    EXPECT_GE(user_slot_count, usize{kNumEvents} * 3);
+    EXPECT_EQ(this->read_volume(*test_volume), expected_data(kNumEvents * 3));
+    EXPECT_TRUE(this->verify_opaque_page(page_id, /*expected_ref_count=*/2));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Volume::append_batch must write contiguous slots, exactly as if each payload had been appended
+// separately, for both typed and raw (string) payloads.
+//
+TEST_F(VolumeTest, AppendBatch)
+{
+  constexpr i32 kNumEvents = 10;
+
+  auto fake_root_log = llfs::testing::make_fake_log_device_factory(*this->root_log);
+  auto fake_recycler_log = llfs::testing::make_fake_log_device_factory(*this->recycler_log);
+
+  std::unique_ptr<llfs::Volume> test_volume = this->open_volume_or_die(
+      fake_root_log, fake_recycler_log,
+      /*slot_visitor_fn=*/[](const llfs::SlotParse&, const auto& /*payload*/) {
+        return llfs::OkStatus();
+      });
+
+  // Append a batch of typed events.
+  //
+  using UpsertVariant = llfs::PackAsVariant<TestVolumeEvent, UpsertEvent>;
+
+  std::vector<UpsertVariant> upsert_events;
+  for (i32 key = 0; key < kNumEvents; key += 1) {
+    upsert_events.emplace_back(llfs::pack_as_variant<TestVolumeEvent>(UpsertEvent{key, key + 100}));
+  }
+  const llfs::Slice<const UpsertVariant> upsert_slice = llfs::as_slice(upsert_events);
+
+  const u64 upsert_grant_size = test_volume->calculate_batch_grant_size(upsert_slice);
+  llfs::StatusOr<batt::Grant> grant =
+      test_volume->reserve(upsert_grant_size, batt::WaitForResource::kFalse);
+
+  ASSERT_TRUE(grant.ok());
+
+  const llfs::slot_offset_type batch_lower_bound =
+      test_volume->root_log().slot_range(llfs::LogReadMode::kSpeculative).upper_bound;
+
+  llfs::StatusOr<std::vector<llfs::SlotRange>> upsert_slots =
+      test_volume->append_batch(upsert_slice, *grant);
+
+  ASSERT_TRUE(upsert_slots.ok()) << BATT_INSPECT(upsert_slots.status());
+  ASSERT_EQ(upsert_slots->size(), upsert_events.size());
+  EXPECT_EQ(grant->size(), 0u);
+
+  llfs::slot_offset_type expected_lower_bound = batch_lower_bound;
+  for (usize i = 0; i < upsert_events.size(); ++i) {
+    EXPECT_EQ((*upsert_slots)[i],
+              (llfs::SlotRange{
+                  .lower_bound = expected_lower_bound,
+                  .upper_bound =
+                      expected_lower_bound + test_volume->calculate_grant_size(upsert_events[i]),
+              }));
+    expected_lower_bound = (*upsert_slots)[i].upper_bound;
+  }
+
+  // Append a batch of raw strings.
+  //
+  const std::vector<std::string_view> raw_payloads = {"alpha", "bo", "charlie", "d"};
+  const llfs::Slice<const std::string_view> raw_slice = llfs::as_slice(raw_payloads);
+
+  grant = test_volume->reserve(test_volume->calculate_batch_grant_size(raw_slice),
+                               batt::WaitForResource::kFalse);
+
+  ASSERT_TRUE(grant.ok());
+
+  llfs::StatusOr<std::vector<llfs::SlotRange>> raw_slots =
+      test_volume->append_batch(raw_slice, *grant);
+
+  ASSERT_TRUE(raw_slots.ok()) << BATT_INSPECT(raw_slots.status());
+  ASSERT_EQ(raw_slots->size(), raw_payloads.size());
+  EXPECT_EQ(raw_slots->front().lower_bound, upsert_slots->back().upper_bound);
+
+  // An empty batch writes nothing.
+  //
+  llfs::StatusOr<std::vector<llfs::SlotRange>> no_slots =
+      test_volume->append_batch(llfs::Slice<const std::string_view>{}, *grant);
+
+  ASSERT_TRUE(no_slots.ok());
+  EXPECT_TRUE(no_slots->empty());
+
+  // Read back all the slots.
+  //
+  llfs::StatusOr<llfs::SlotRange> flushed = test_volume->sync(
+      llfs::LogReadMode::kDurable, llfs::SlotUpperBoundAt{raw_slots->back().upper_bound});
+
+  ASSERT_TRUE(flushed.ok());
+
+  llfs::StatusOr<llfs::VolumeReader> reader =
+      test_volume->reader(llfs::SlotRangeSpec{0, llfs::None}, llfs::LogReadMode::kDurable);
+
+  ASSERT_TRUE(reader.ok());
+
+  std::vector<llfs::SlotRange> visited_slots;
+  std::vector<std::string> visited_user_data;
+
+  llfs::StatusOr<usize> n_visited = reader->consume_slots(
+      batt::WaitForResource::kFalse,
+      [&](const llfs::SlotParse& slot, const std::string_view& user_data) {
+        visited_slots.emplace_back(slot.offset);
+        visited_user_data.emplace_back(user_data);
+        return llfs::OkStatus();
+      });
+
+  ASSERT_TRUE(n_visited.ok()) << BATT_INSPECT(n_visited.status());
+  ASSERT_EQ(visited_slots.size(), upsert_slots->size() + raw_slots->size());
+
+  for (usize i = 0; i < upsert_slots->size(); ++i) {
+    EXPECT_EQ(visited_slots[i], (*upsert_slots)[i]);
+
+    llfs::Status status = llfs::TypedSlotReader<TestVolumeEvent>::visit_slot(
+        llfs::SlotParse{.offset = visited_slots[i]}, visited_user_data[i],
+        [&](const llfs::SlotParse&, const UpsertEvent& event) {
+          EXPECT_EQ(event.key, static_cast<i32>(i));
+          EXPECT_EQ(event.value, static_cast<i32>(i) + 100);
+          return llfs::OkStatus();
+        },
+        [](const llfs::SlotParse&, const auto&) {
+          ADD_FAILURE() << "expected an UpsertEvent";
+          return llfs::OkStatus();
+        });
+
+    EXPECT_TRUE(status.ok()) << BATT_INSPECT(status);
+  }
+  for (usize i = 0; i < raw_slots->size(); ++i) {
+    EXPECT_EQ(visited_slots[upsert_slots->size() + i], (*raw_slots)[i]);
+    EXPECT_EQ(visited_user_data[upsert_slots->size() + i], raw_payloads[i]);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Reading user slots in batches (VolumeReader::visit_next_batch/consume_slot_batches) must visit
+// the same slots, in the same order, as reading them one at a time.
+//
+TEST_F(VolumeTest, ReadEventBatches)
+{
+  constexpr i32 kNumEvents = 20;
+  constexpr usize kMaxBatchSize = 7;
+
+  auto fake_root_log = llfs::testing::make_fake_log_device_factory(*this->root_log);
+  auto fake_recycler_log = llfs::testing::make_fake_log_device_factory(*this->recycler_log);
+
+  std::unique_ptr<llfs::Volume> test_volume = this->open_volume_or_die(
+      fake_root_log, fake_recycler_log,
+      /*slot_visitor_fn=*/[](const llfs::SlotParse&, const auto& /*payload*/) {
+        return llfs::OkStatus();
+      });
+
+  std::vector<llfs::slot_offset_type> upsert_slots;
+  for (i32 key = 0; key < kNumEvents; key += 1) {
+    auto upsert_event = llfs::pack_as_variant<TestVolumeEvent>(UpsertEvent{key, key * 3 + 1});
+
+    llfs::StatusOr<batt::Grant> grant = test_volume->reserve(
+        test_volume->calculate_grant_size(upsert_event), batt::WaitForResource::kFalse);
+
+    ASSERT_TRUE(grant.ok());
+
+    llfs::StatusOr<llfs::SlotRange> appended = test_volume->append(upsert_event, *grant);
+
+    ASSERT_TRUE(appended.ok()) << appended.status();
+
+    upsert_slots.emplace_back(appended->upper_bound);
+  }
+
+  llfs::StatusOr<llfs::SlotRange> flushed =
+      test_volume->sync(llfs::LogReadMode::kDurable, llfs::SlotUpperBoundAt{upsert_slots.back()});
+
+  ASSERT_TRUE(flushed.ok());
+
+  for (bool consume : {false, true}) {
+    llfs::StatusOr<llfs::VolumeReader> reader =
+        test_volume->reader(llfs::SlotRangeSpec{0, llfs::None}, llfs::LogReadMode::kDurable);
+
+    ASSERT_TRUE(reader.ok());
+
+    std::vector<llfs::slot_offset_type> visited_slots;
+    std::vector<i32> visited_keys;
+
+    const auto batch_visitor =
+        [&](const llfs::Slice<const llfs::VolumeReader::UserSlot>& batch) -> llfs::Status {
+      EXPECT_GT(batch.size(), 0u);
+      EXPECT_LE(batch.size(), kMaxBatchSize);
+
+      for (const llfs::VolumeReader::UserSlot& user_slot : batch) {
+        visited_slots.emplace_back(user_slot.slot.offset.upper_bound);
+
+        llfs::Status status = llfs::TypedSlotReader<TestVolumeEvent>::visit_slot(
+            user_slot.slot, user_slot.user_data,
+            [&](const llfs::SlotParse&, const UpsertEvent& event) {
+              visited_keys.emplace_back(event.key);
+              return llfs::OkStatus();
+            },
+            [](const llfs::SlotParse&, const auto&) {
+              return llfs::OkStatus();
+            });
+
+        EXPECT_TRUE(status.ok()) << BATT_INSPECT(status);
+      }
+      return llfs::OkStatus();
+    };
+
+    if (consume) {
+      llfs::StatusOr<usize> n_visited = reader->consume_slot_batches(
+          batt::WaitForResource::kFalse, batch_visitor, kMaxBatchSize);
+
+      ASSERT_TRUE(n_visited.ok()) << BATT_INSPECT(n_visited.status());
+      EXPECT_EQ(*n_visited, upsert_slots.size());
+    } else {
+      usize n_batches = 0;
+      for (;;) {
+        llfs::StatusOr<usize> n_visited =
+            reader->visit_next_batch(batt::WaitForResource::kFalse, batch_visitor, kMaxBatchSize);
+
+        ASSERT_TRUE(n_visited.ok()) << BATT_INSPECT(n_visited.status());
+        if (*n_visited == 0) {
+          break;
+        }
+        ++n_batches;
+      }
+      EXPECT_GE(n_batches, (upsert_slots.size() + kMaxBatchSize - 1) / kMaxBatchSize);
+    }
+
+    std::vector<i32> expected_keys(kNumEvents);
+    std::iota(expected_keys.begin(), expected_keys.end(), 0);
+
+    EXPECT_THAT(visited_slots, ::testing::ContainerEq(upsert_slots));
+    EXPECT_THAT(visited_keys, ::testing::ContainerEq(expected_keys));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// A speculative reader must visit all committed user slots, passing a durable upper bound with each
+// batch that is never more than `max_durable_lag` behind the end of the batch.
+//
+TEST_F(VolumeTest, ReadSpeculativeBatches)
+{
+  constexpr i32 kNumEvents = 20;
+  constexpr usize kMaxBatchSize = 5;
+
+  auto fake_root_log = llfs::testing::make_fake_log_device_factory(*this->root_log);
+  auto fake_recycler_log = llfs::testing::make_fake_log_device_factory(*this->recycler_log);
+
+  std::unique_ptr<llfs::Volume> test_volume = this->open_volume_or_die(
+      fake_root_log, fake_recycler_log,
+      /*slot_visitor_fn=*/[](const llfs::SlotParse&, const auto& /*payload*/) {
+        return llfs::OkStatus();
+      });
+
+  // Don't wait for the appended slots to be flushed; the speculative reader should still see them.
+  //
+  std::vector<llfs::slot_offset_type> upsert_slots;
+  for (i32 key = 0; key < kNumEvents; key += 1) {
+    auto upsert_event = llfs::pack_as_variant<TestVolumeEvent>(UpsertEvent{key, key * 5});
+
+    llfs::StatusOr<batt::Grant> grant = test_volume->reserve(
+        test_volume->calculate_grant_size(upsert_event), batt::WaitForResource::kFalse);
+
+    ASSERT_TRUE(grant.ok());
+
+    llfs::StatusOr<llfs::SlotRange> appended = test_volume->append(upsert_event, *grant);
+
+    ASSERT_TRUE(appended.ok()) << appended.status();
+
+    upsert_slots.emplace_back(appended->upper_bound);
+  }
+
+  for (u64 max_durable_lag : {u64{0}, u64{64}, u64{1} << 40}) {
+    for (bool consume : {false, true}) {
+      llfs::StatusOr<llfs::VolumeReader> reader = test_volume->reader(
+          llfs::SlotRangeSpec{0, llfs::None}, llfs::LogReadMode::kSpeculative);
+
+      ASSERT_TRUE(reader.ok());
+
+      std::vector<llfs::slot_offset_type> visited_slots;
+      llfs::slot_offset_type prev_durable_upper_bound = 0;
+
+      const auto batch_visitor = [&](const llfs::Slice<const llfs::VolumeReader::UserSlot>& batch,
+                                     llfs::slot_offset_type durable_upper_bound) -> llfs::Status {
+        EXPECT_GT(batch.size(), 0u);
+        EXPECT_LE(batch.size(), kMaxBatchSize);
+        EXPECT_GE(durable_upper_bound + max_durable_lag, batch.back().slot.offset.upper_bound)
+            << BATT_INSPECT(max_durable_lag);
+        EXPECT_GE(durable_upper_bound, prev_durable_upper_bound);
+        prev_durable_upper_bound = durable_upper_bound;
+
+        for (const llfs::VolumeReader::UserSlot& user_slot : batch) {
+          visited_slots.emplace_back(user_slot.slot.offset.upper_bound);
+        }
+        return llfs::OkStatus();
+      };
+
+      if (consume) {
+        llfs::StatusOr<usize> n_visited = reader->consume_speculative_batches(
+            batt::WaitForResource::kFalse, max_durable_lag, batch_visitor, kMaxBatchSize);
+
+        ASSERT_TRUE(n_visited.ok()) << BATT_INSPECT(n_visited.status());
+        EXPECT_EQ(*n_visited, upsert_slots.size());
+      } else {
+        for (;;) {
+          llfs::StatusOr<usize> n_visited = reader->visit_next_speculative_batch(
+              batt::WaitForResource::kFalse, max_durable_lag, batch_visitor, kMaxBatchSize);
+
+          ASSERT_TRUE(n_visited.ok()) << BATT_INSPECT(n_visited.status());
+          if (*n_visited == 0) {
+            break;
+          }
+        }
+      }
+
+      EXPECT_THAT(visited_slots, ::testing::ContainerEq(upsert_slots));
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// A job committed across two Volumes with append_multi_volume_job must write its new page once,
+// make it a root of both Volumes, and append a user slot to each; all of this must survive
+// recovery.
+//
+TEST_F(VolumeTest, MultiVolumeJob)
+{
+  llfs::MemoryLogDevice participant_root_log{kTestRootLogSize};
+  llfs::MemoryLogDevice participant_recycler_log{this->recycler_log->capacity()};
+
+  llfs::PageId page_id;
+
+  // Returns the number of user slots in `test_volume` that refer to `page_id`.
+  //
+  const auto count_user_slots = [&page_id](llfs::Volume& test_volume) -> usize {
+    llfs::StatusOr<llfs::VolumeReader> reader =
+        test_volume.reader(llfs::SlotRangeSpec{0, llfs::None}, llfs::LogReadMode::kDurable);
+
+    BATT_CHECK_OK(reader);
+
+    usize count = 0;
+    llfs::StatusOr<usize> n_slots_read = reader->consume_slots(
+        batt::WaitForResource::kFalse,
+        [&](const llfs::SlotParse& /*slot*/, std::string_view user_data) -> llfs::Status {
+          auto* event = (const llfs::PackedVariantInstance<
+                         TestVolumeEvent, llfs::PackedArray<llfs::PackedPageId>>*)user_data.data();
+
+          EXPECT_TRUE(event->verify_case());
+          EXPECT_EQ(event->tail.size(), 1u);
+          if (event->tail.size() == 1u && event->tail[0].unpack() == page_id) {
+            count += 1;
+          }
+          return llfs::OkStatus();
+        });
+
+    BATT_CHECK_OK(n_slots_read);
+
+    return count;
+  };
+
+  for (bool recovering : {false, true}) {
+    auto fake_root_log = llfs::testing::make_fake_log_device_factory(*this->root_log);
+    auto fake_recycler_log = llfs::testing::make_fake_log_device_factory(*this->recycler_log);
+
+    auto participant_fake_root_log =
+        llfs::testing::make_fake_log_device_factory(participant_root_log);
+    auto participant_fake_recycler_log =
+        llfs::testing::make_fake_log_device_factory(participant_recycler_log);
+
+    const auto ignore_slots = [](const llfs::SlotParse&, const auto& /*payload*/) {
+      return llfs::OkStatus();
+    };
+
+    std::unique_ptr<llfs::Volume> coordinator =
+        this->open_volume_or_die(fake_root_log, fake_recycler_log, ignore_slots, "coordinator");
+
+    std::unique_ptr<llfs::Volume> participant = this->open_volume_or_die(
+        participant_fake_root_log, participant_fake_recycler_log, ignore_slots, "participant");
+
+    if (!recovering) {
+      std::unique_ptr<llfs::PageCacheJob> job = coordinator->new_job();
+
+      llfs::StatusOr<llfs::PinnedPage> pinned_page = this->make_opaque_page(*job);
+      ASSERT_TRUE(pinned_page.ok());
+
+      page_id = get_page_id(*pinned_page);
+
+      const std::vector<llfs::PageId> root_ids{page_id};
+
+      auto coordinator_event = llfs::pack_as_variant<TestVolumeEvent>(
+          llfs::as_seq(root_ids) | llfs::seq::decayed() | llfs::seq::boxed());
+
+      auto participant_event = llfs::pack_as_variant<TestVolumeEvent>(
+          llfs::as_seq(root_ids) | llfs::seq::decayed() | llfs::seq::boxed());
+
+      llfs::StatusOr<std::vector<llfs::SlotRange>> appended = llfs::append_multi_volume_job(
+          std::move(job),
+          {
+              llfs::MultiVolumeJobPart{coordinator.get(), llfs::PackableRef{coordinator_event}},
+              llfs::MultiVolumeJobPart{participant.get(), llfs::PackableRef{participant_event}},
+          },
+          batt::WaitForResource::kFalse);
+
+      ASSERT_TRUE(appended.ok()) << BATT_INSPECT(appended.status());
+      ASSERT_EQ(appended->size(), 2u);
+
+      ASSERT_TRUE(coordinator
+                      ->sync(llfs::LogReadMode::kDurable,
+                             llfs::SlotUpperBoundAt{(*appended)[0].upper_bound})
+                      .ok());
+      ASSERT_TRUE(participant
+                      ->sync(llfs::LogReadMode::kDurable,
+                             llfs::SlotUpperBoundAt{(*appended)[1].upper_bound})
+                      .ok());
+    }
+
+    // One ref for each Volume (plus one for being allocated).
+    //
+    EXPECT_TRUE(this->verify_opaque_page(page_id, /*expected_ref_count=*/3));
+
+    EXPECT_EQ(count_user_slots(*coordinator), 1u) << BATT_INSPECT(recovering);
+    EXPECT_EQ(count_user_slots(*participant), 1u) << BATT_INSPECT(recovering);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Test Plan:
+//  1. If a participant can't reserve log space, nothing is appended anywhere, and the coordinator
+//     can still commit jobs.
+//  2. If a participant's log fails after the coordinator's prepare slot is written, the job is
+//     rolled back, and the coordinator can still commit jobs (rather than waiting forever for the
+//     failed job in `commit`).
+//  3. After both Volumes are recovered, only the jobs that succeeded are visible.
+//
+TEST_F(VolumeTest, MultiVolumeJobFailure)
+{
+  llfs::MemoryLogDevice participant_root_log{kTestRootLogSize};
+  llfs::MemoryLogDevice participant_recycler_log{this->recycler_log->capacity()};
+
+  const auto ignore_slots = [](const llfs::SlotParse&, const auto& /*payload*/) {
+    return llfs::OkStatus();
+  };
+
+  // Returns the root page ids of all the user slots in `test_volume`.
+  //
+  const auto user_slot_roots = [](llfs::Volume& test_volume) -> std::vector<llfs::PageId> {
+    llfs::StatusOr<llfs::VolumeReader> reader =
+        test_volume.reader(llfs::SlotRangeSpec{0, llfs::None}, llfs::LogReadMode::kDurable);
+
+    BATT_CHECK_OK(reader);
+
+    std::vector<llfs::PageId> roots;
+    llfs::StatusOr<usize> n_slots_read = reader->consume_slots(
+        batt::WaitForResource::kFalse,
+        [&](const llfs::SlotParse& /*slot*/, std::string_view user_data) -> llfs::Status {
+          auto* event = (const llfs::PackedVariantInstance<
+                         TestVolumeEvent, llfs::PackedArray<llfs::PackedPageId>>*)user_data.data();
+
+          EXPECT_TRUE(event->verify_case());
+          for (const llfs::PackedPageId& packed_page_id : event->tail) {
+            roots.emplace_back(packed_page_id.unpack());
+          }
+          return llfs::OkStatus();
+        });
+
+    BATT_CHECK_OK(n_slots_read);
+
+    return roots;
+  };
+
+  // Appends a multi-Volume job with a single new page as the root of both Volumes.
+  //
+  llfs::PageId shared_page_id;
+  const auto append_shared_page_job = [&](llfs::Volume& coordinator, llfs::Volume& participant) {
+    std::unique_ptr<llfs::PageCacheJob> job = coordinator.new_job();
+
+    llfs::StatusOr<llfs::PinnedPage> pinned_page = this->make_opaque_page(*job);
+    BATT_CHECK_OK(pinned_page);
+
+    shared_page_id = get_page_id(*pinned_page);
+
+    const std::vector<llfs::PageId> root_ids{shared_page_id};
+
+    auto coordinator_event = llfs::pack_as_variant<TestVolumeEvent>(
+        llfs::as_seq(root_ids) | llfs::seq::decayed() | llfs::seq::boxed());
+
+    auto participant_event = llfs::pack_as_variant<TestVolumeEvent>(
+        llfs::as_seq(root_ids) | llfs::seq::decayed() | llfs::seq::boxed());
+
+    return llfs::append_multi_volume_job(
+        std::move(job),
+        {
+            llfs::MultiVolumeJobPart{&coordinator, llfs::PackableRef{coordinator_event}},
+            llfs::MultiVolumeJobPart{&participant, llfs::PackableRef{participant_event}},
+        },
+        batt::WaitForResource::kFalse);
+  };
+
+  // Appends a single-Volume job with a new page as its root; returns the page id.
+  //
+  const auto append_page_job = [this](llfs::Volume& test_volume) -> llfs::PageId {
+    std::unique_ptr<llfs::PageCacheJob> job = test_volume.new_job();
+
+    llfs::StatusOr<llfs::PinnedPage> pinned_page = this->make_opaque_page(*job);
+    BATT_CHECK_OK(pinned_page);
+
+    const llfs::PageId page_id = get_page_id(*pinned_page);
+    const std::vector<llfs::PageId> root_ids{page_id};
+
+    llfs::StatusOr<llfs::SlotRange> job_slot =
+        this->append_job(test_volume, std::move(job),
+                         llfs::as_seq(root_ids) | llfs::seq::decayed() | llfs::seq::boxed());
+
+    BATT_CHECK_OK(job_slot);
+    BATT_CHECK_OK(test_volume.sync(llfs::LogReadMode::kDurable,
+                                   llfs::SlotUpperBoundAt{job_slot->upper_bound}));
+
+    return page_id;
+  };
+
+  std::vector<llfs::PageId> committed_page_ids;
+  {
+    auto fake_root_log = llfs::testing::make_fake_log_device_factory(*this->root_log);
+    auto fake_recycler_log = llfs::testing::make_fake_log_device_factory(*this->recycler_log);
+
+    auto participant_fake_root_log =
+        llfs::testing::make_fake_log_device_factory(participant_root_log);
+    auto participant_fake_recycler_log =
+        llfs::testing::make_fake_log_device_factory(participant_recycler_log);
+
+    std::unique_ptr<llfs::Volume> coordinator =
+        this->open_volume_or_die(fake_root_log, fake_recycler_log, ignore_slots, "coordinator");
+
+    std::unique_ptr<llfs::Volume> participant = this->open_volume_or_die(
+        participant_fake_root_log, participant_fake_recycler_log, ignore_slots, "participant");
+
+    //----- --- -- -  -  -   -
+    // 1. No log space in the participant.
+    {
+      llfs::StatusOr<batt::Grant> all_space = participant->reserve(
+          participant->available_to_reserve(), batt::WaitForResource::kFalse);
+      ASSERT_TRUE(all_space.ok()) << BATT_INSPECT(all_space.status());
+
+      const llfs::slot_offset_type coordinator_log_end =
+          coordinator->root_log_slot_range(llfs::LogReadMode::kSpeculative).upper_bound;
+
+      llfs::StatusOr<std::vector<llfs::SlotRange>> appended =
+          append_shared_page_job(*coordinator, *participant);
+
+      EXPECT_FALSE(appended.ok());
+      EXPECT_EQ(coordinator->root_log_slot_range(llfs::LogReadMode::kSpeculative).upper_bound,
+                coordinator_log_end);
+    }
+    committed_page_ids.emplace_back(append_page_job(*coordinator));
+
+    //----- --- -- -  -  -   -
+    // 2. The participant's log fails before its prepare slot is written.
+    {
+      participant_fake_root_log.state()->failure_time =
+          participant_fake_root_log.state()->device_time.load() + 1;
+
+      llfs::StatusOr<std::vector<llfs::SlotRange>> appended =
+          append_shared_page_job(*coordinator, *participant);
+
+      EXPECT_FALSE(appended.ok());
+    }
+    committed_page_ids.emplace_back(append_page_job(*coordinator));
+
+    EXPECT_THAT(user_slot_roots(*coordinator),
+                ::testing::ElementsAreArray(committed_page_ids));
+  }
+
+  //----- --- -- -  -  -   -
+  // 3. Recover both Volumes.
+  {
+    auto fake_root_log = llfs::testing::make_fake_log_device_factory(*this->root_log);
+    auto fake_recycler_log = llfs::testing::make_fake_log_device_factory(*this->recycler_log);
+
+    auto participant_fake_root_log =
+        llfs::testing::make_fake_log_device_factory(participant_root_log);
+    auto participant_fake_recycler_log =
+        llfs::testing::make_fake_log_device_factory(participant_recycler_log);
+
+    std::unique_ptr<llfs::Volume> coordinator =
+        this->open_volume_or_die(fake_root_log, fake_recycler_log, ignore_slots, "coordinator");
+
+    std::unique_ptr<llfs::Volume> participant = this->open_volume_or_die(
+        participant_fake_root_log, participant_fake_recycler_log, ignore_slots, "participant");
+
+    EXPECT_THAT(user_slot_roots(*coordinator),
+                ::testing::ElementsAreArray(committed_page_ids));
+    EXPECT_THAT(user_slot_roots(*participant), ::testing::IsEmpty());
+
+    for (llfs::PageId page_id : committed_page_ids) {
+      EXPECT_TRUE(this->verify_opaque_page(page_id, /*expected_ref_count=*/2));
+    }
+
+    // Multi-Volume jobs work again after recovery.
+    //
+    llfs::StatusOr<std::vector<llfs::SlotRange>> appended =
+        append_shared_page_job(*coordinator, *participant);
+
+    ASSERT_TRUE(appended.ok()) << BATT_INSPECT(appended.status());
+    EXPECT_TRUE(this->verify_opaque_page(shared_page_id, /*expected_ref_count=*/3));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// compact_volume_log must re-append the live user slots of the window (keeping the page refs of job
+// slots alive) and then let the window be trimmed.
+//
+TEST_F(VolumeTest, CompactLog)
+{
+  constexpr i32 kNumEvents = 6;
+
+  auto fake_root_log = llfs::testing::make_fake_log_device_factory(*this->root_log);
+  auto fake_recycler_log = llfs::testing::make_fake_log_device_factory(*this->recycler_log);
+
+  std::unique_ptr<llfs::Volume> test_volume = this->open_volume_or_die(
+      fake_root_log, fake_recycler_log,
+      /*slot_visitor_fn=*/[](const llfs::SlotParse&, const auto& /*payload*/) {
+        return llfs::OkStatus();
+      });
+
+  // Append a job that makes a new page a root, followed by some plain events.
+  //
+  llfs::PageId page_id;
+  {
+    std::unique_ptr<llfs::PageCacheJob> job = test_volume->new_job();
+
+    llfs::StatusOr<llfs::PinnedPage> pinned_page = this->make_opaque_page(*job);
+    ASSERT_TRUE(pinned_page.ok());
+
+    page_id = get_page_id(*pinned_page);
+
+    const std::vector<llfs::PageId> root_ids{page_id};
+
+    llfs::StatusOr<llfs::SlotRange> job_slot = this->append_job(
+        *test_volume, std::move(job),
+        llfs::as_seq(root_ids) | llfs::seq::decayed() | llfs::seq::boxed());
+
+    ASSERT_TRUE(job_slot.ok()) << BATT_INSPECT(job_slot.status());
+  }
+
+  llfs::slot_offset_type last_upper_bound = 0;
+  for (i32 key = 0; key < kNumEvents; key += 1) {
+    auto upsert_event = llfs::pack_as_variant<TestVolumeEvent>(UpsertEvent{key, key * 7});
+
+    llfs::StatusOr<batt::Grant> grant = test_volume->reserve(
+        test_volume->calculate_grant_size(upsert_event), batt::WaitForResource::kFalse);
+
+    ASSERT_TRUE(grant.ok());
+
+    llfs::StatusOr<llfs::SlotRange> appended = test_volume->append(upsert_event, *grant);
+
+    ASSERT_TRUE(appended.ok()) << appended.status();
+    last_upper_bound = appended->upper_bound;
+  }
+
+  ASSERT_TRUE(
+      test_volume->sync(llfs::LogReadMode::kDurable, llfs::SlotUpperBoundAt{last_upper_bound})
+          .ok());
+
+  // One ref for the root slot, plus one for being allocated.
+  //
+  EXPECT_TRUE(this->verify_opaque_page(page_id, /*expected_ref_count=*/2));
+
+  // Compact the whole log, keeping the job slot and the events with even keys.
+  //
+  llfs::StatusOr<llfs::VolumeCompactionResult> result = llfs::compact_volume_log(
+      *test_volume,
+      llfs::VolumeCompactionOptions{
+          .max_window_size = 1 * kMiB,
+          .wait_for_log_space = batt::WaitForResource::kFalse,
+      },
+      [](const llfs::SlotParse& slot, std::string_view user_data) {
+        bool live = true;
+        llfs::Status status = llfs::TypedSlotReader<TestVolumeEvent>::visit_slot(
+            slot, user_data,
+            [&live](const llfs::SlotParse&, const UpsertEvent& event) {
+              live = (event.key % 2 == 0);
+              return llfs::OkStatus();
+            },
+            [](const llfs::SlotParse&, const auto&) {
+              return llfs::OkStatus();
+            });
+        EXPECT_TRUE(status.ok()) << BATT_INSPECT(status);
+        return live;
+      });
+
+  ASSERT_TRUE(result.ok()) << BATT_INSPECT(result.status());
+  EXPECT_EQ(result->user_slot_count, usize{kNumEvents} + 1);
+  EXPECT_EQ(result->relocated.size(), usize{kNumEvents} / 2 + 1);
+  EXPECT_EQ(result->compacted.upper_bound, last_upper_bound);
+
+  for (const llfs::RelocatedSlot& relocated : result->relocated) {
+    EXPECT_FALSE(llfs::slot_less_than(relocated.new_slot.lower_bound, last_upper_bound))
+        << BATT_INSPECT(relocated);
+  }
+
+  // Once the old slots are trimmed, the page must still be referenced by the relocated job slot.
+  //
+  ASSERT_TRUE(test_volume->await_trim(result->compacted.upper_bound).ok());
+
+  const llfs::PageArena& arena = this->page_cache->arena_for_page_id(page_id);
+  ASSERT_TRUE(arena.allocator().await_ref_count(page_id, 2));
+  EXPECT_TRUE(this->verify_opaque_page(page_id, /*expected_ref_count=*/2));
+
+  // Only the live events remain.
+  //
+  std::unordered_map<i32, i32> data = this->read_volume(*test_volume);
+
+  EXPECT_THAT(data, ::testing::UnorderedElementsAre(std::make_pair(0, 0), std::make_pair(2, 14),
+                                                    std::make_pair(4, 28)));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Jobs submitted to a VolumeCommitPipeline are all committed, in submission order, and their new
+// pages end up with the same ref counts as if they had been appended one at a time.
+//
+TEST_F(VolumeTest, CommitPipeline)
+{
+  constexpr usize kNumJobsPerDepth = 6;
+
+  auto fake_root_log = llfs::testing::make_fake_log_device_factory(*this->root_log);
+  auto fake_recycler_log = llfs::testing::make_fake_log_device_factory(*this->recycler_log);
+
+  std::unique_ptr<llfs::Volume> test_volume = this->open_volume_or_die(
+      fake_root_log, fake_recycler_log,
+      /*slot_visitor_fn=*/[](const llfs::SlotParse&, const auto& /*payload*/) {
+        return llfs::OkStatus();
+      });
+
+  for (usize depth : {1, 3}) {
+    // The root page ids of each job; these must outlive the pipeline, since the user data of each
+    // job refers to them.
+    //
+    std::vector<std::vector<llfs::PageId>> root_ids(kNumJobsPerDepth);
+
+    std::mutex mutex;
+    std::vector<llfs::StatusOr<llfs::SlotRange>> job_slots(kNumJobsPerDepth,
+                                                            {batt::StatusCode::kUnknown});
+    {
+      llfs::VolumeCommitPipeline pipeline{*test_volume,
+                                          batt::Runtime::instance().default_scheduler(),
+                                          llfs::VolumeCommitPipeline::Options{
+                                              .depth = depth,
+                                              .wait_for_log_space = batt::WaitForResource::kFalse,
+                                          }};
+
+      for (usize i = 0; i < kNumJobsPerDepth; ++i) {
+        std::unique_ptr<llfs::PageCacheJob> job = test_volume->new_job();
+
+        llfs::StatusOr<llfs::PinnedPage> pinned_page = this->make_opaque_page(*job);
+        ASSERT_TRUE(pinned_page.ok()) << BATT_INSPECT(pinned_page.status());
+
+        root_ids[i].emplace_back(get_page_id(*pinned_page));
+
+        llfs::Status submitted = pipeline.submit(
+            std::move(job),
+            llfs::pack_as_variant<TestVolumeEvent>(llfs::as_seq(root_ids[i]) |
+                                                   llfs::seq::decayed() | llfs::seq::boxed()),
+            [&mutex, &job_slots, i](const llfs::StatusOr<llfs::SlotRange>& job_slot) {
+              std::unique_lock<std::mutex> lock{mutex};
+              job_slots[i] = job_slot;
+            });
+
+        ASSERT_TRUE(submitted.ok()) << BATT_INSPECT(submitted) << BATT_INSPECT(depth);
+      }
+
+      llfs::Status finished = pipeline.finish();
+      ASSERT_TRUE(finished.ok()) << BATT_INSPECT(finished) << BATT_INSPECT(depth);
+    }
+
+    for (usize i = 0; i < kNumJobsPerDepth; ++i) {
+      ASSERT_TRUE(job_slots[i].ok()) << BATT_INSPECT(job_slots[i].status()) << BATT_INSPECT(i);
+      if (i > 0) {
+        EXPECT_TRUE(llfs::slot_less_than(job_slots[i - 1]->lower_bound, job_slots[i]->lower_bound))
+            << BATT_INSPECT(i) << BATT_INSPECT(depth);
+      }
+
+      // One ref for the root slot, plus one for being allocated.
+      //
+      EXPECT_TRUE(this->verify_opaque_page(root_ids[i].front(), /*expected_ref_count=*/2))
+          << BATT_INSPECT(i) << BATT_INSPECT(depth);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Jobs chained with set_base_job share the FinalizedPageIndex of their pipeline: a job's new pages
+// are in the index from the time it is finalized until it is committed, and the next job finds
+// them there before they have been written.
+//
+TEST_F(VolumeTest, ChainedJobsWithPageIndex)
+{
+  auto fake_root_log = llfs::testing::make_fake_log_device_factory(*this->root_log);
+  auto fake_recycler_log = llfs::testing::make_fake_log_device_factory(*this->recycler_log);
+
+  std::unique_ptr<llfs::Volume> test_volume = this->open_volume_or_die(
+      fake_root_log, fake_recycler_log,
+      /*slot_visitor_fn=*/[](const llfs::SlotParse&, const auto& /*payload*/) {
+        return llfs::OkStatus();
+      });
+
+  auto page_index = std::make_shared<llfs::FinalizedPageIndex>();
+
+  // The first job creates a page and is finalized.
+  //
+  std::unique_ptr<llfs::PageCacheJob> job1 = test_volume->new_job();
+  job1->set_page_index(page_index);
+
+  llfs::StatusOr<llfs::PinnedPage> page1 = this->make_opaque_page(*job1);
+  ASSERT_TRUE(page1.ok()) << BATT_INSPECT(page1.status());
+
+  const llfs::PageId page1_id = get_page_id(*page1);
+  const std::vector<llfs::PageId> job1_roots{page1_id};
+  auto event1 = llfs::pack_as_variant<TestVolumeEvent>(
+      llfs::as_seq(job1_roots) | llfs::seq::decayed() | llfs::seq::boxed());
+
+  llfs::StatusOr<llfs::AppendableJob> appendable1 =
+      llfs::make_appendable_job(std::move(job1), llfs::PackableRef{event1});
+  ASSERT_TRUE(appendable1.ok()) << BATT_INSPECT(appendable1.status());
+
+  EXPECT_EQ(page_index->size(), 1u);
+  EXPECT_NE(page_index->find(page1_id), nullptr);
+
+  // The second job inherits the index from its base job, and gets the first job's page from it.
+  // Its roots include that page, so committing it also has to find the page.
+  //
+  std::unique_ptr<llfs::PageCacheJob> job2 = test_volume->new_job();
+  job2->set_base_job(appendable1->job.finalized_job());
+
+  EXPECT_EQ(job2->page_index(), page_index);
   {
-    // Create an empty volume.
-    //
-    auto fake_root_log = llfs::testing::make_fake_log_device_factory(*this->root_log);
-    auto fake_recycler_log = llfs::testing::make_fake_log_device_factory(*this->recycler_log);
+    llfs::StatusOr<llfs::PinnedPage> found = job2->get_page(page1_id, llfs::OkIfNotFound{false});
+    ASSERT_TRUE(found.ok()) << BATT_INSPECT(found.status());
+    EXPECT_EQ(found->get(), page1->get());
+  }
 
-    std::unique_ptr<llfs::Volume> test_volume = this->open_volume_or_die(
-        fake_root_log, fake_recycler_log,
-        /*slot_visitor_fn=*/[](const llfs::SlotParse&, const auto& /*payload*/) {
-          return llfs::OkStatus();
-        });
+  llfs::StatusOr<llfs::PinnedPage> page2 = this->make_opaque_page(*job2);
+  ASSERT_TRUE(page2.ok()) << BATT_INSPECT(page2.status());
 
-    this->save_uuids(*test_volume);
+  const llfs::PageId page2_id = get_page_id(*page2);
+  const std::vector<llfs::PageId> job2_roots{page1_id, page2_id};
+  auto event2 = llfs::pack_as_variant<TestVolumeEvent>(
+      llfs::as_seq(job2_roots) | llfs::seq::decayed() | llfs::seq::boxed());
 
-    // Verify that there are no key/value pairs.
-    {
-      std::unordered_map<i32, i32> data = this->read_volume(*test_volume);
+  llfs::StatusOr<llfs::AppendableJob> appendable2 =
+      llfs::make_appendable_job(std::move(job2), llfs::PackableRef{event2});
+  ASSERT_TRUE(appendable2.ok()) << BATT_INSPECT(appendable2.status());
 
-      EXPECT_THAT(data, ::testing::IsEmpty());
-    }
+  EXPECT_EQ(page_index->size(), 2u);
+  EXPECT_NE(page_index->find(page2_id), nullptr);
 
-    // Append slots.
-    //
-    for (i32 key = 0; key < 10; key += 1) {
-      UpsertEvent upsert{key, key * 3 + 1};
-      auto upsert_event = llfs::pack_as_variant<TestVolumeEvent>(upsert);
+  // Each job's pages leave the index when it is committed.
+  //
+  llfs::StatusOr<batt::Grant> grant1 = test_volume->reserve(
+      test_volume->calculate_grant_size(*appendable1), batt::WaitForResource::kFalse);
+  ASSERT_TRUE(grant1.ok()) << BATT_INSPECT(grant1.status());
 
-      llfs::StatusOr<batt::Grant> grant = test_volume->reserve(
-          test_volume->calculate_grant_size(upsert_event), batt::WaitForResource::kFalse);
+  llfs::StatusOr<batt::Grant> grant2 = test_volume->reserve(
+      test_volume->calculate_grant_size(*appendable2), batt::WaitForResource::kFalse);
+  ASSERT_TRUE(grant2.ok()) << BATT_INSPECT(grant2.status());
 
-      ASSERT_TRUE(grant.ok());
+  llfs::StatusOr<llfs::SlotRange> job1_slot =
+      test_volume->append(std::move(*appendable1), *grant1);
+  ASSERT_TRUE(job1_slot.ok()) << BATT_INSPECT(job1_slot.status());
 
-      llfs::StatusOr<llfs::SlotRange> appended = test_volume->append(upsert_event, *grant);
+  EXPECT_EQ(page_index->find(page1_id), nullptr);
+  EXPECT_NE(page_index->find(page2_id), nullptr);
 
-      ASSERT_TRUE(appended.ok()) << appended.status();
+  llfs::StatusOr<llfs::SlotRange> job2_slot =
+      test_volume->append(std::move(*appendable2), *grant2);
+  ASSERT_TRUE(job2_slot.ok()) << BATT_INSPECT(job2_slot.status());
 
-      upsert_slots.emplace_back(appended->upper_bound);
-    }
+  EXPECT_EQ(page_index->size(), 0u);
 
-    // Flush the log.
-    //
-    llfs::StatusOr<llfs::SlotRange> flushed =
-        test_volume->sync(llfs::LogReadMode::kDurable, llfs::SlotUpperBoundAt{upsert_slots.back()});
+  // The first page is a root of both jobs (plus one ref for being allocated).
+  //
+  EXPECT_TRUE(this->verify_opaque_page(page1_id, /*expected_ref_count=*/3));
+  EXPECT_TRUE(this->verify_opaque_page(page2_id, /*expected_ref_count=*/2));
+}
 
-    ASSERT_TRUE(flushed.ok());
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Volume::append writes a job's new pages early (before its prepare slot is durable) or at commit
+// according to the VolumeWritePolicy, and counts each decision in the VolumeMetrics; kAdaptive
+// defers the job when its device already has adaptive_write_queue_depth writes in flight.  Either
+// way no write is left in flight once the job is appended.
+//
+TEST_F(VolumeTest, WritePolicy)
+{
+  struct TestCase {
+    llfs::VolumeWritePolicy policy;
+    usize other_writes_in_flight;
+    bool expect_early;
+  };
 
-    // Re-read the root log; now we should see the data we inserted.
-    //
-    {
-      std::unordered_map<i32, i32> data = this->read_volume(*test_volume);
+  constexpr u16 kQueueDepth = 2;
 
-      EXPECT_THAT(data, ::testing::UnorderedElementsAre(
-                            std::make_pair(0, 1), std::make_pair(1, 4), std::make_pair(2, 7),
-                            std::make_pair(3, 10), std::make_pair(4, 13), std::make_pair(5, 16),
-                            std::make_pair(6, 19), std::make_pair(7, 22), std::make_pair(8, 25),
-                            std::make_pair(9, 28)));
-    }
-    //
-    // Close the first volume; we will re-open the log to recover our data below.
-  }
+  const std::vector<TestCase> test_cases{
+      {llfs::VolumeWritePolicy::kEager, 0, true},
+      {llfs::VolumeWritePolicy::kEager, kQueueDepth, true},
+      {llfs::VolumeWritePolicy::kDeferred, 0, false},
+      {llfs::VolumeWritePolicy::kAdaptive, 0, true},
+      {llfs::VolumeWritePolicy::kAdaptive, kQueueDepth - 1, true},
+      {llfs::VolumeWritePolicy::kAdaptive, kQueueDepth, false},
+  };
+
+  for (const TestCase& test_case : test_cases) {
+    SCOPED_TRACE(batt::to_string(BATT_INSPECT(test_case.policy),
+                                 BATT_INSPECT(test_case.other_writes_in_flight)));
+
+    this->reset_cache();
+    this->reset_logs();
+    this->write_policy = test_case.policy;
+    this->adaptive_write_queue_depth = kQueueDepth;
 
-  // Re-open the volume; we should still see the data we inserted.
-  //
-  {
     auto fake_root_log = llfs::testing::make_fake_log_device_factory(*this->root_log);
     auto fake_recycler_log = llfs::testing::make_fake_log_device_factory(*this->recycler_log);
 
     std::unique_ptr<llfs::Volume> test_volume = this->open_volume_or_die(
         fake_root_log, fake_recycler_log,
-        /*slot_visitor_fn=*/[](const llfs::SlotParse&, const std::string_view&) {
+        /*slot_visitor_fn=*/[](const llfs::SlotParse&, const auto& /*payload*/) {
           return llfs::OkStatus();
         });
 
-    {
-      std::unordered_map<i32, i32> data = this->read_volume(*test_volume);
-
-      EXPECT_THAT(data, ::testing::UnorderedElementsAre(
-                            std::make_pair(0, 1), std::make_pair(1, 4), std::make_pair(2, 7),
-                            std::make_pair(3, 10), std::make_pair(4, 13), std::make_pair(5, 16),
-                            std::make_pair(6, 19), std::make_pair(7, 22), std::make_pair(8, 25),
-                            std::make_pair(9, 28)));
-    }
+    EXPECT_EQ(test_volume->write_policy(), test_case.policy);
 
-    // Trim the log to erase some data.
+    // Stand in for writes issued by other jobs (the memory device completes writes right away).
     //
-    LLFS_VLOG(1) << "Trimming volume to " << upsert_slots[4];
-    llfs::Status trim_set = test_volume->trim(upsert_slots[4]);
+    ASSERT_EQ(this->page_cache->all_devices().size(), 1u);
+    llfs::PageCache::PageDeviceEntry* const entry = this->page_cache->all_devices()[0];
+    entry->writes_in_flight.fetch_add(test_case.other_writes_in_flight);
 
-    ASSERT_TRUE(trim_set.ok());
+    const llfs::VolumeMetrics& metrics = test_volume->metrics();
+    const u64 early_before = metrics.eager_page_write_job_count.load();
+    const u64 deferred_before = metrics.deferred_page_write_job_count.load();
 
-    LLFS_VLOG(1) << "Awaiting trim offset " << upsert_slots[4];
-    llfs::Status trimmed = test_volume->await_trim(upsert_slots[4]);
+    std::unique_ptr<llfs::PageCacheJob> job = test_volume->new_job();
 
-    ASSERT_TRUE(trimmed.ok());
-  }
+    llfs::StatusOr<llfs::PinnedPage> page = this->make_opaque_page(*job);
+    ASSERT_TRUE(page.ok()) << BATT_INSPECT(page.status());
 
-  // Re-open the volume one last time; we should see the half we didn't trim.
-  //
-  {
-    auto fake_root_log = llfs::testing::make_fake_log_device_factory(*this->root_log);
-    auto fake_recycler_log = llfs::testing::make_fake_log_device_factory(*this->recycler_log);
+    const llfs::PageId page_id = get_page_id(*page);
+    const std::vector<llfs::PageId> roots{page_id};
+    auto event = llfs::pack_as_variant<TestVolumeEvent>(llfs::as_seq(roots) | llfs::seq::decayed() |
+                                                        llfs::seq::boxed());
 
-    std::unique_ptr<llfs::Volume> test_volume = this->open_volume_or_die(
-        fake_root_log, fake_recycler_log,
-        /*slot_visitor_fn=*/[](const llfs::SlotParse&, const auto& /*payload*/) {
-          return llfs::OkStatus();
-        });
+    llfs::StatusOr<llfs::AppendableJob> appendable =
+        llfs::make_appendable_job(std::move(job), llfs::PackableRef{event});
+    ASSERT_TRUE(appendable.ok()) << BATT_INSPECT(appendable.status());
 
-    {
-      std::unordered_map<i32, i32> data = this->read_volume(*test_volume);
+    llfs::StatusOr<batt::Grant> grant = test_volume->reserve(
+        test_volume->calculate_grant_size(*appendable), batt::WaitForResource::kFalse);
+    ASSERT_TRUE(grant.ok()) << BATT_INSPECT(grant.status());
 
-      EXPECT_THAT(data, ::testing::UnorderedElementsAre(
-                            std::make_pair(5, 16), std::make_pair(6, 19), std::make_pair(7, 22),
-                            std::make_pair(8, 25), std::make_pair(9, 28)));
-    }
+    llfs::StatusOr<llfs::SlotRange> slot = test_volume->append(std::move(*appendable), *grant);
+    ASSERT_TRUE(slot.ok()) << BATT_INSPECT(slot.status());
 
-    this->validate_uuids(*test_volume);
+    EXPECT_EQ(metrics.eager_page_write_job_count.load() - early_before,
+              test_case.expect_early ? 1u : 0u);
+    EXPECT_EQ(metrics.deferred_page_write_job_count.load() - deferred_before,
+              test_case.expect_early ? 0u : 1u);
+
+    EXPECT_EQ(this->page_cache->page_writes_in_flight(entry->arena.id()),
+              test_case.other_writes_in_flight);
+    entry->writes_in_flight.fetch_sub(test_case.other_writes_in_flight);
+
+    EXPECT_TRUE(this->verify_opaque_page(page_id, /*expected_ref_count=*/2));
   }
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// append_multi_volume_job must reject jobs without a single Volume, or with the same Volume twice.
+//
+TEST_F(VolumeTest, MultiVolumeJobInvalidArgs)
+{
+  auto fake_root_log = llfs::testing::make_fake_log_device_factory(*this->root_log);
+  auto fake_recycler_log = llfs::testing::make_fake_log_device_factory(*this->recycler_log);
+
+  std::unique_ptr<llfs::Volume> test_volume = this->open_volume_or_die(
+      fake_root_log, fake_recycler_log,
+      /*slot_visitor_fn=*/[](const llfs::SlotParse&, const auto& /*payload*/) {
+        return llfs::OkStatus();
+      });
+
+  auto event = llfs::pack_as_variant<TestVolumeEvent>(UpsertEvent{1, 2});
+
+  EXPECT_EQ(llfs::append_multi_volume_job(test_volume->new_job(), {},
+                                          batt::WaitForResource::kFalse)
+                .status(),
+            batt::StatusCode::kInvalidArgument);
+
+  EXPECT_EQ(llfs::append_multi_volume_job(
+                test_volume->new_job(),
+                {
+                    llfs::MultiVolumeJobPart{test_volume.get(), llfs::PackableRef{event}},
+                    llfs::MultiVolumeJobPart{test_volume.get(), llfs::PackableRef{event}},
+                },
+                batt::WaitForResource::kFalse)
+                .status(),
+            batt::StatusCode::kInvalidArgument);
+
+  // No pages means no PageAllocator to record the commit decision.
+  //
+  EXPECT_EQ(llfs::append_multi_volume_job(
+                test_volume->new_job(),
+                {
+                    llfs::MultiVolumeJobPart{test_volume.get(), llfs::PackableRef{event}},
+                },
+                batt::WaitForResource::kFalse)
+                .status(),
+            batt::StatusCode::kInvalidArgument);
+}
+
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 // Test Plan:
 //  1. Reader::clone_lock() - keep trim from happening when there is no other barrier
@@ -711,6 +1846,63 @@ TEST_F(VolumeTest, TrimControl_LastVolumeReaderCausesTrim)
             this->volume->root_log_slot_range(llfs::LogReadMode::kDurable).lower_bound);
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// With incremental, paced trimming, one trim request is carried out in several small steps, no
+// faster than max_bytes_per_second.
+//
+TEST_F(VolumeTest, TrimControl_IncrementalPacedTrim)
+{
+  constexpr u64 kStepSize = 32;
+  constexpr u64 kBytesPerSecond = 4 * kKiB;
+
+  this->trimmer_options = llfs::VolumeTrimmerOptions{
+      .incremental_step_size = kStepSize,
+      .max_bytes_per_second = kBytesPerSecond,
+      .urgent_available_percent = 10,
+  };
+
+  this->init_events();
+
+  const llfs::slot_offset_type explicit_trim_offset =
+      this->appended_events[90].slot_range.upper_bound;
+
+  // Find the greatest-lower-bound slot boundary for (explicit_trim_offset - this->trim_delay)
+  //
+  llfs::slot_offset_type expected_trim_pos = explicit_trim_offset;
+  for (usize i = 90; i > 0; --i) {
+    expected_trim_pos = this->appended_events[i].slot_range.lower_bound;
+    if (expected_trim_pos <= explicit_trim_offset - this->trim_delay) {
+      break;
+    }
+  }
+
+  const u64 trim_count_before = this->volume->trim_count();
+  const auto start_time = std::chrono::steady_clock::now();
+
+  llfs::Status trim_status = this->volume->trim(explicit_trim_offset);
+  ASSERT_TRUE(trim_status.ok()) << BATT_INSPECT(trim_status);
+
+  ASSERT_TRUE(this->volume->await_trim(expected_trim_pos).ok());
+
+  const i64 elapsed_usec = std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::steady_clock::now() - start_time)
+                               .count();
+
+  EXPECT_EQ(expected_trim_pos,
+            this->volume->root_log_slot_range(llfs::LogReadMode::kDurable).lower_bound);
+
+  // Every step but the first had to wait for the rate limit.
+  //
+  const u64 trimmed_bytes = expected_trim_pos;
+  const u64 min_steps = trimmed_bytes / (2 * kStepSize);
+
+  ASSERT_GE(min_steps, 3u);
+  EXPECT_GE(this->volume->trim_count() - trim_count_before, min_steps);
+  EXPECT_GT(this->volume->trim_throttle_delay_usec(), 0u);
+  EXPECT_GE(elapsed_usec, i64((trimmed_bytes - 2 * kStepSize) * 1000000 / kBytesPerSecond))
+      << BATT_INSPECT(trimmed_bytes);
+}
+
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 // Test Plan:
 //  1. read_lock invalid - should fail
@@ -1603,6 +2795,272 @@ TEST_F(VolumeSimTest, ConcurrentAppendJobs)
   }
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// parallel_trace_refs_recursive must report the same refs as trace_refs_recursive, for any degree
+// of parallelism and batch size.
+//
+TEST_F(VolumeSimTest, ParallelTraceRefs)
+{
+  llfs::StorageSimulation sim{batt::StateMachineEntropySource{
+      /*entropy_fn=*/[](usize min_value, usize /*max_value*/) -> usize {
+        return min_value;
+      }}};
+
+  sim.add_page_arena(llfs::PageCount{16}, llfs::PageSize{1 * kKiB});
+
+  sim.register_page_reader(llfs::PageGraphNodeView::page_layout_id(), __FILE__, __LINE__,
+                           llfs::PageGraphNodeView::page_reader());
+
+  sim.run_main_task([&] {
+    batt::StatusOr<std::unique_ptr<llfs::Volume>> recovered_volume = sim.get_volume(
+        "TestVolume", /*slot_visitor_fn=*/
+        [](auto&&...) {
+          return batt::OkStatus();
+        },
+        /*root_log_capacity=*/64 * kKiB);
+
+    ASSERT_TRUE(recovered_volume.ok()) << recovered_volume.status();
+
+    llfs::Volume& volume = **recovered_volume;
+
+    // Build a DAG with shared children: root -> {mid_0, mid_1}, mid_0 -> {leaf_0, leaf_1},
+    // mid_1 -> {leaf_1, leaf_2}.
+    //
+    std::unique_ptr<llfs::PageCacheJob> job = volume.new_job();
+
+    const auto build_page = [&](const std::vector<llfs::PageId>& refs) {
+      return BATT_OK_RESULT_OR_PANIC(
+          VolumeSimTest::build_page_with_refs_to(refs, llfs::PageSize{1 * kKiB}, *job, sim));
+    };
+
+    const llfs::PageId leaf_0 = build_page({});
+    const llfs::PageId leaf_1 = build_page({});
+    const llfs::PageId leaf_2 = build_page({});
+    const llfs::PageId mid_0 = build_page({leaf_0, leaf_1});
+    const llfs::PageId mid_1 = build_page({leaf_1, leaf_2});
+    const llfs::PageId root = build_page({mid_0, mid_1});
+
+    llfs::SlotRange slot = BATT_OK_RESULT_OR_PANIC(
+        VolumeSimTest::commit_job_to_root_log(std::move(job), root, volume, sim));
+
+    BATT_CHECK_OK(volume.sync(llfs::LogReadMode::kDurable, llfs::SlotUpperBoundAt{
+                                                               .offset = slot.upper_bound,
+                                                           }));
+
+    const std::vector<llfs::PageId> roots{root};
+    const auto trace_all = [](llfs::PageId) {
+      return true;
+    };
+
+    std::vector<llfs::PageId> expected;
+    ASSERT_TRUE(llfs::trace_refs_recursive(*sim.cache(), llfs::as_seq(roots) | llfs::seq::decayed(),
+                                           trace_all,
+                                           [&expected](llfs::PageId id) {
+                                             expected.emplace_back(id);
+                                           })
+                    .ok());
+
+    EXPECT_THAT(expected, ::testing::UnorderedElementsAre(mid_0, mid_1, leaf_0, leaf_1, leaf_1,
+                                                          leaf_2));
+
+    for (usize parallelism : {1, 2, 8}) {
+      for (usize max_batch_size : {1, 2, 64}) {
+        std::vector<llfs::PageId> actual;
+        llfs::Status status = llfs::parallel_trace_refs_recursive(
+            *sim.cache(), llfs::as_seq(roots) | llfs::seq::decayed(), trace_all,
+            [&actual](llfs::PageId id) {
+              actual.emplace_back(id);
+            },
+            llfs::ParallelTraceRefsOptions{
+                .parallelism = parallelism,
+                .max_batch_size = max_batch_size,
+                .scheduler = &sim.task_scheduler(),
+            });
+
+        ASSERT_TRUE(status.ok()) << BATT_INSPECT(status);
+        EXPECT_THAT(actual, ::testing::UnorderedElementsAreArray(expected))
+            << BATT_INSPECT(parallelism) << BATT_INSPECT(max_batch_size);
+      }
+    }
+
+    volume.halt();
+    volume.join();
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// A job in streaming mode writes its new pages (and drops its pins/buffers for them) as it goes;
+// the job must still commit with the correct ref counts, reloading the streamed pages as needed.
+//
+TEST_F(VolumeSimTest, StreamingJob)
+{
+  llfs::StorageSimulation sim{batt::StateMachineEntropySource{
+      /*entropy_fn=*/[](usize min_value, usize /*max_value*/) -> usize {
+        return min_value;
+      }}};
+
+  sim.add_page_arena(llfs::PageCount{16}, llfs::PageSize{1 * kKiB});
+
+  sim.register_page_reader(llfs::PageGraphNodeView::page_layout_id(), __FILE__, __LINE__,
+                           llfs::PageGraphNodeView::page_reader());
+
+  sim.run_main_task([&] {
+    batt::StatusOr<std::unique_ptr<llfs::Volume>> recovered_volume = sim.get_volume(
+        "TestVolume", /*slot_visitor_fn=*/
+        [](auto&&...) {
+          return batt::OkStatus();
+        },
+        /*root_log_capacity=*/64 * kKiB);
+
+    ASSERT_TRUE(recovered_volume.ok()) << recovered_volume.status();
+
+    llfs::Volume& volume = **recovered_volume;
+
+    std::unique_ptr<llfs::PageCacheJob> job = volume.new_job();
+    job->enable_streaming(/*max_unstreamed_pages=*/3, llfs::StreamedPageRetention::kHintObsolete);
+
+    std::vector<llfs::PageId> leaves;
+    for (usize i = 0; i < 8; ++i) {
+      leaves.emplace_back(BATT_OK_RESULT_OR_PANIC(
+          VolumeSimTest::build_page_with_refs_to({}, llfs::PageSize{1 * kKiB}, *job, sim)));
+    }
+
+    // The first 6 leaves have been streamed; the job no longer holds them.
+    //
+    EXPECT_EQ(job->streamed_page_count(), 6u);
+    for (usize i = 0; i < 6; ++i) {
+      EXPECT_FALSE(job->get_already_pinned(leaves[i]));
+      EXPECT_EQ(job->get_new_pages().at(leaves[i]).buffer(), nullptr);
+      EXPECT_TRUE(job->is_page_new_and_pinned(leaves[i]));
+    }
+    EXPECT_TRUE(job->get_already_pinned(leaves[7]));
+
+    const llfs::PageId root = BATT_OK_RESULT_OR_PANIC(
+        VolumeSimTest::build_page_with_refs_to(leaves, llfs::PageSize{1 * kKiB}, *job, sim));
+
+    EXPECT_EQ(job->streamed_page_count(), 9u);
+
+    llfs::SlotRange slot = BATT_OK_RESULT_OR_PANIC(
+        VolumeSimTest::commit_job_to_root_log(std::move(job), root, volume, sim));
+
+    BATT_CHECK_OK(volume.sync(llfs::LogReadMode::kDurable, llfs::SlotUpperBoundAt{
+                                                               .offset = slot.upper_bound,
+                                                           }));
+
+    for (llfs::PageCache::PageDeviceEntry* entry : sim.cache()->devices_with_page_size(1 * kKiB)) {
+      BATT_CHECK_NOT_NULLPTR(entry);
+      EXPECT_EQ(entry->arena.allocator().get_ref_count(root).first, 2);
+      for (llfs::PageId page_id : leaves) {
+        EXPECT_EQ(entry->arena.allocator().get_ref_count(page_id).first, 2);
+      }
+      break;
+    }
+
+    // The streamed pages can be loaded from the device.
+    //
+    batt::StatusOr<llfs::PinnedPage> loaded_root =
+        sim.cache()->get_page(root, llfs::OkIfNotFound{false});
+    ASSERT_TRUE(loaded_root.ok()) << BATT_INSPECT(loaded_root.status());
+    EXPECT_THAT((*loaded_root)->trace_refs() | llfs::seq::collect_vec(),
+                ::testing::ElementsAreArray(leaves));
+
+    volume.halt();
+    volume.join();
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// Pages added to a job via write_new_page (bulk loading) bypass the cache; they are streamed to
+// their devices and committed with the right ref counts in a single root log transaction.
+//
+TEST_F(VolumeSimTest, BulkLoadJob)
+{
+  llfs::StorageSimulation sim{batt::StateMachineEntropySource{
+      /*entropy_fn=*/[](usize min_value, usize /*max_value*/) -> usize {
+        return min_value;
+      }}};
+
+  sim.add_page_arena(llfs::PageCount{16}, llfs::PageSize{1 * kKiB});
+
+  sim.register_page_reader(llfs::PageGraphNodeView::page_layout_id(), __FILE__, __LINE__,
+                           llfs::PageGraphNodeView::page_reader());
+
+  sim.run_main_task([&] {
+    batt::StatusOr<std::unique_ptr<llfs::Volume>> recovered_volume = sim.get_volume(
+        "TestVolume", /*slot_visitor_fn=*/
+        [](auto&&...) {
+          return batt::OkStatus();
+        },
+        /*root_log_capacity=*/64 * kKiB);
+
+    ASSERT_TRUE(recovered_volume.ok()) << recovered_volume.status();
+
+    llfs::Volume& volume = **recovered_volume;
+
+    std::unique_ptr<llfs::PageCacheJob> job = volume.new_job();
+    job->enable_streaming(/*max_unstreamed_pages=*/4);
+
+    const auto build_uncached = [&](const std::vector<llfs::PageId>& refs) {
+      batt::StatusOr<llfs::PageGraphNodeBuilder> page_builder =
+          llfs::PageGraphNodeBuilder::from_new_page(job->new_page(
+              llfs::PageSize{1 * kKiB}, batt::WaitForResource::kFalse,
+              llfs::PageGraphNodeView::page_layout_id(), /*callers=*/0,
+              /*cancel_token=*/llfs::None));
+
+      BATT_CHECK_OK(page_builder);
+      for (llfs::PageId page_id : refs) {
+        page_builder->add_page(page_id);
+      }
+      return BATT_OK_RESULT_OR_PANIC(std::move(*page_builder).build_uncached(*job));
+    };
+
+    std::vector<llfs::PageId> leaves;
+    for (usize i = 0; i < 10; ++i) {
+      leaves.emplace_back(build_uncached({}));
+    }
+    const llfs::PageId root = build_uncached(leaves);
+
+    // Nothing was pinned (or inserted into the cache); the first 8 leaves have been streamed.
+    //
+    EXPECT_EQ(job->pinned_page_count(), 0u);
+    EXPECT_EQ(job->streamed_page_count(), 8u);
+
+    // The job can trace the new pages without loading them, streamed or not.
+    //
+    std::vector<llfs::PageId> root_refs;
+    ASSERT_TRUE(job->append_new_page_refs(root, &root_refs));
+    EXPECT_THAT(root_refs, ::testing::ElementsAreArray(leaves));
+
+    BATT_CHECK_OK(job->stream_new_pages());
+    EXPECT_EQ(job->streamed_page_count(), 11u);
+
+    llfs::SlotRange slot = BATT_OK_RESULT_OR_PANIC(
+        VolumeSimTest::commit_job_to_root_log(std::move(job), root, volume, sim));
+
+    BATT_CHECK_OK(volume.sync(llfs::LogReadMode::kDurable, llfs::SlotUpperBoundAt{
+                                                               .offset = slot.upper_bound,
+                                                           }));
+
+    for (llfs::PageCache::PageDeviceEntry* entry : sim.cache()->devices_with_page_size(1 * kKiB)) {
+      BATT_CHECK_NOT_NULLPTR(entry);
+      EXPECT_EQ(entry->arena.allocator().get_ref_count(root).first, 2);
+      for (llfs::PageId page_id : leaves) {
+        EXPECT_EQ(entry->arena.allocator().get_ref_count(page_id).first, 2);
+      }
+      break;
+    }
+
+    batt::StatusOr<llfs::PinnedPage> loaded_root =
+        sim.cache()->get_page(root, llfs::OkIfNotFound{false});
+    ASSERT_TRUE(loaded_root.ok()) << BATT_INSPECT(loaded_root.status());
+    EXPECT_THAT((*loaded_root)->trace_refs() | llfs::seq::collect_vec(),
+                ::testing::ElementsAreArray(leaves));
+
+    volume.halt();
+    volume.join();
+  });
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 auto VolumeSimTest::RecoverySimState::get_slot_visitor()
@@ -0,0 +1,204 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/volume_commit_pipeline.hpp>
+//
+
+#include <llfs/logging.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/checked_cast.hpp>
+#include <batteries/stream_util.hpp>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ VolumeCommitPipeline::VolumeCommitPipeline(Volume& volume,
+                                                        batt::TaskScheduler& scheduler,
+                                                        const Options& options) noexcept
+    : volume_{volume}
+    , options_{options}
+{
+  BATT_CHECK_GT(this->options_.depth, 0u);
+
+  for (usize i = 0; i < this->options_.depth; ++i) {
+    this->workers_.emplace_back(std::make_unique<Worker>());
+  }
+
+  // Start the tasks only after all the workers have been created, so that `workers_` is never
+  // modified while a task is running.
+  //
+  for (usize i = 0; i < this->workers_.size(); ++i) {
+    Worker& worker = *this->workers_[i];
+    worker.task.emplace(
+        scheduler.schedule_task(),
+        [this, &worker] {
+          this->worker_main(worker);
+        },
+        batt::to_string("VolumeCommitPipeline.worker_", i));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+VolumeCommitPipeline::~VolumeCommitPipeline() noexcept
+{
+  this->finish().IgnoreError();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeCommitPipeline::submit_impl(std::unique_ptr<PageCacheJob>&& job,
+                                         std::shared_ptr<const void>&& user_data,
+                                         PackableRef&& packable, CompletionHandler&& handler)
+{
+  BATT_CHECK(!this->halted_) << "jobs may not be submitted after finish()";
+
+  if (this->failed_.load()) {
+    return this->get_error();
+  }
+
+  StatusOr<AppendableJob> appendable = make_appendable_job(std::move(job), std::move(packable));
+  BATT_REQUIRE_OK(appendable);
+
+  // Bound the number of jobs in flight.  This must happen before the page writes are started, since
+  // the depth also bounds the amount of page data that is being written ahead of the log.
+  //
+  const i64 max_in_flight = BATT_CHECKED_CAST(i64, this->options_.depth);
+
+  StatusOr<i64> in_flight = this->in_flight_count_.await_true([max_in_flight](i64 n) {
+    return n < max_in_flight;
+  });
+  BATT_REQUIRE_OK(in_flight);
+
+  // Don't wait for the prepare slot to be flushed (or for the jobs ahead of this one) to start
+  // writing new pages; this is where the overlap between jobs comes from.  (Volume::append skips
+  // this step if the writes have already been started.)
+  //
+  BATT_REQUIRE_OK(appendable->job.start_writing_new_pages());
+
+  StatusOr<batt::Grant> grant = this->volume_.reserve(
+      this->volume_.calculate_grant_size(*appendable), this->options_.wait_for_log_space);
+  BATT_REQUIRE_OK(grant);
+
+  SlotSequencer sequencer = this->next_sequencer_;
+  this->next_sequencer_ = sequencer.get_next();
+
+  this->in_flight_count_.fetch_add(1);
+
+  Worker& worker = *this->workers_[this->next_worker_];
+  this->next_worker_ = (this->next_worker_ + 1) % this->workers_.size();
+
+  Status push_status = worker.queue.push(QueuedJob{
+      .user_data = std::move(user_data),
+      .appendable = std::move(*appendable),
+      .grant = std::move(*grant),
+      .sequencer = std::move(sequencer),
+      .handler = std::move(handler),
+  });
+
+  if (!push_status.ok()) {
+    this->in_flight_count_.fetch_sub(1);
+    this->record_error(push_status);
+    return push_status;
+  }
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeCommitPipeline::finish()
+{
+  if (!this->halted_) {
+    // Tell each worker to stop once it has processed everything ahead of the end marker.
+    //
+    for (const std::unique_ptr<Worker>& worker : this->workers_) {
+      worker->queue.push(None).IgnoreError();
+    }
+    for (const std::unique_ptr<Worker>& worker : this->workers_) {
+      worker->task->join();
+    }
+    this->halt_and_join();
+  }
+
+  return this->get_error();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeCommitPipeline::worker_main(Worker& worker)
+{
+  for (;;) {
+    StatusOr<Optional<QueuedJob>> next = worker.queue.await_next();
+    if (!next.ok() || !*next) {
+      break;
+    }
+
+    QueuedJob& queued = **next;
+
+    // Even if an earlier job has failed, this job must still go through Volume::append so that its
+    // sequencer is resolved (with the error of the job before it); otherwise the jobs after it
+    // would wait forever.
+    //
+    StatusOr<SlotRange> job_slot = this->volume_.append(std::move(queued.appendable), queued.grant,
+                                                        std::move(queued.sequencer));
+
+    if (!job_slot.ok()) {
+      LLFS_LOG_WARNING() << "VolumeCommitPipeline: job failed;" << BATT_INSPECT(job_slot.status());
+      this->record_error(job_slot.status());
+    }
+
+    if (queued.handler) {
+      queued.handler(job_slot);
+    }
+
+    this->in_flight_count_.fetch_sub(1);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeCommitPipeline::record_error(const Status& status)
+{
+  {
+    auto locked = this->first_error_.lock();
+    if (locked->ok()) {
+      *locked = status;
+    }
+  }
+  this->failed_.store(true);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeCommitPipeline::get_error()
+{
+  return *this->first_error_.lock();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeCommitPipeline::halt_and_join()
+{
+  if (this->halted_) {
+    return;
+  }
+  this->halted_ = true;
+
+  for (const std::unique_ptr<Worker>& worker : this->workers_) {
+    worker->queue.close();
+  }
+  for (const std::unique_ptr<Worker>& worker : this->workers_) {
+    worker->task->join();
+  }
+  this->in_flight_count_.close();
+}
+
+}  // namespace llfs
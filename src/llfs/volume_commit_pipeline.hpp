@@ -0,0 +1,199 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_VOLUME_COMMIT_PIPELINE_HPP
+#define LLFS_VOLUME_COMMIT_PIPELINE_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/appendable_job.hpp>
+#include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/packable_ref.hpp>
+#include <llfs/page_cache_job.hpp>
+#include <llfs/slot.hpp>
+#include <llfs/slot_sequencer.hpp>
+#include <llfs/status.hpp>
+#include <llfs/volume.hpp>
+
+#include <batteries/async/grant.hpp>
+#include <batteries/async/mutex.hpp>
+#include <batteries/async/queue.hpp>
+#include <batteries/async/task.hpp>
+#include <batteries/async/task_scheduler.hpp>
+#include <batteries/async/types.hpp>
+#include <batteries/async/watch.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Commits a stream of PageCacheJobs to a Volume with up to `depth` jobs in flight at once.
+ *
+ * Volume::append (for jobs) goes through writing the new pages, appending and flushing the prepare
+ * slot, updating ref counts, dropping deleted pages, and appending the commit slot, in that order,
+ * and returns only when all of these are done.  A caller that appends one job after another
+ * therefore waits out every device round trip of every job.  This class runs each job's
+ * Volume::append on one of `depth` worker tasks instead, so that while job N's ref count updates
+ * are being written, the new pages of jobs N+1, N+2, ... are already being written (their writes
+ * are started as soon as they are submitted).
+ *
+ * The crash-consistency ordering of each job is unchanged, since every job still goes through
+ * Volume::append.  Across jobs:
+ *
+ *  - The prepare slots are appended in submission order (using a SlotSequencer).
+ *  - The ref count updates of each job wait for those of the job before it (as for any
+ *    Volume::append).
+ *
+ * If a job fails, all the jobs submitted after it fail too (their prepare slots are never
+ * appended), and all further calls to `submit` return the first error.
+ *
+ * `submit` must not be called concurrently from more than one task.  `finish()` must be called (and
+ * return OK) before all submitted jobs can be assumed committed.
+ */
+class VolumeCommitPipeline
+{
+ public:
+  /** \brief Called (on a worker task) with the result of Volume::append for a submitted job.
+   */
+  using CompletionHandler = std::function<void(const StatusOr<SlotRange>& job_slot)>;
+
+  struct Options {
+    // The maximum number of jobs submitted but not yet committed; `submit` blocks while this many
+    // jobs are in flight.  This is also the number of worker tasks.
+    //
+    usize depth;
+
+    // Whether `submit` should wait for log space to become available.
+    //
+    batt::WaitForResource wait_for_log_space = batt::WaitForResource::kTrue;
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  explicit VolumeCommitPipeline(Volume& volume, batt::TaskScheduler& scheduler,
+                                const Options& options) noexcept;
+
+  VolumeCommitPipeline(const VolumeCommitPipeline&) = delete;
+  VolumeCommitPipeline& operator=(const VolumeCommitPipeline&) = delete;
+
+  /** \brief Calls `finish()` (ignoring the result).  Queued jobs can't simply be dropped, since a
+   * job that has already started may be waiting for the prepare slot of one of them.
+   */
+  ~VolumeCommitPipeline() noexcept;
+
+  /** \brief Starts writing the new pages of `job` and queues it to be appended to the Volume with
+   * `user_data` (which is moved into the pipeline, and must have a PackableRef-compatible
+   * packed_sizeof/pack_object).
+   *
+   * Reserves the log space for the job (see Volume::reserve) before returning.  If `handler` is
+   * non-empty, it is invoked with the slot range of the job once it is committed (or with the error
+   * that stopped it).
+   *
+   * Returns the first error of any earlier job (if there has been one), in which case `job` is not
+   * queued.
+   */
+  template <typename T>
+  Status submit(std::unique_ptr<PageCacheJob>&& job, T&& user_data,
+                CompletionHandler&& handler = {})
+  {
+    auto owned_user_data = std::make_shared<std::decay_t<T>>(BATT_FORWARD(user_data));
+    PackableRef packable{*owned_user_data};
+
+    return this->submit_impl(std::move(job), std::move(owned_user_data), std::move(packable),
+                             std::move(handler));
+  }
+
+  /** \brief Waits for all submitted jobs to finish and stops the worker tasks.  Returns the first
+   * error of any job, or OkStatus if all of them were committed.
+   *
+   * No more jobs may be submitted after `finish` is called.
+   */
+  Status finish();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  // A submitted job, queued for a worker.
+  //
+  struct QueuedJob {
+    // Owns the object that `appendable.user_data` refers to.
+    //
+    std::shared_ptr<const void> user_data;
+
+    AppendableJob appendable;
+    batt::Grant grant;
+    SlotSequencer sequencer;
+    CompletionHandler handler;
+  };
+
+  // Jobs are assigned to workers round-robin; None tells the worker it is finished.
+  //
+  struct Worker {
+    batt::Queue<Optional<QueuedJob>> queue;
+    Optional<batt::Task> task;
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  Status submit_impl(std::unique_ptr<PageCacheJob>&& job, std::shared_ptr<const void>&& user_data,
+                     PackableRef&& packable, CompletionHandler&& handler);
+
+  // The body of each worker task.
+  //
+  void worker_main(Worker& worker);
+
+  // Saves `status` if it is the first error.
+  //
+  void record_error(const Status& status);
+
+  // Returns the first recorded error, or OkStatus.
+  //
+  Status get_error();
+
+  // Closes all worker queues and joins the worker tasks (idempotent).
+  //
+  void halt_and_join();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  Volume& volume_;
+
+  const Options options_;
+
+  // The number of submitted jobs whose Volume::append hasn't returned yet.
+  //
+  batt::Watch<i64> in_flight_count_{0};
+
+  // Orders the prepare slot of the next submitted job after that of the last one.
+  //
+  SlotSequencer next_sequencer_;
+
+  // The worker that gets the next submitted job.
+  //
+  usize next_worker_ = 0;
+
+  // Set once any job has failed; the error is in `first_error_`.
+  //
+  std::atomic<bool> failed_{false};
+
+  batt::Mutex<Status> first_error_{OkStatus()};
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  bool halted_ = false;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_VOLUME_COMMIT_PIPELINE_HPP
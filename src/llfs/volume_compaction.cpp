@@ -0,0 +1,227 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/volume_compaction.hpp>
+//
+
+#include <llfs/appendable_job.hpp>
+#include <llfs/logging.hpp>
+#include <llfs/pack_as_raw.hpp>
+#include <llfs/packable_ref.hpp>
+#include <llfs/slot_reader.hpp>
+#include <llfs/volume_events.hpp>
+#include <llfs/volume_reader.hpp>
+
+#include <string>
+
+namespace llfs {
+
+namespace {
+
+// The user data of a relocated job slot: packed as raw bytes (so that it is visited exactly as it
+// was originally), but with the root page refs of the original slot.
+//
+struct RelocatedUserData {
+  std::string_view bytes;
+  const std::vector<PageId>* root_page_ids;
+};
+
+usize packed_sizeof(const RelocatedUserData& user_data)
+{
+  return packed_sizeof(pack_as_raw(user_data.bytes));
+}
+
+PackedRawData* pack_object(const RelocatedUserData& user_data, DataPacker* dst)
+{
+  return pack_object(pack_as_raw(user_data.bytes), dst);
+}
+
+BoxedSeq<PageId> trace_refs(const RelocatedUserData& user_data)
+{
+  return as_seq(*user_data.root_page_ids) | seq::decayed() | seq::boxed();
+}
+
+// A copy of a live user slot, waiting to be relocated.
+//
+struct LiveSlot {
+  SlotRange old_slot;
+  std::string user_data;
+  std::vector<PageId> root_page_ids;
+};
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<VolumeCompactionResult> compact_volume_log(Volume& volume,
+                                                    const VolumeCompactionOptions& options,
+                                                    const VolumeSlotLivenessFn& is_live)
+{
+  VolumeCompactionResult result;
+  std::vector<LiveSlot> live_slots;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+  // Phase 1: Scan the window, copying the live slots (the data must be copied because appending
+  // the relocated slots may wrap the log buffer).
+  //
+  {
+    StatusOr<VolumeReader> reader =
+        volume.reader(SlotRangeSpec{None, None}, LogReadMode::kDurable);
+
+    BATT_REQUIRE_OK(reader);
+
+    const slot_offset_type window_lower_bound = reader->slot_range().lower_bound;
+    const slot_offset_type window_upper_bound =
+        slot_min(window_lower_bound + options.max_window_size,
+                 volume.root_log().slot_range(LogReadMode::kDurable).upper_bound);
+
+    result.compacted = SlotRange{
+        .lower_bound = window_lower_bound,
+        .upper_bound = window_lower_bound,
+    };
+
+    bool past_window = false;
+    while (!past_window) {
+      StatusOr<usize> n_visited = reader->visit_next(
+          batt::WaitForResource::kFalse,
+          [&](const SlotParse& slot, std::string_view user_data) -> Status {
+            if (slot_less_than(window_upper_bound, slot.offset.upper_bound)) {
+              past_window = true;
+              return OkStatus();
+            }
+
+            result.user_slot_count += 1;
+            result.compacted.upper_bound = slot.offset.upper_bound;
+
+            if (!is_live(slot, user_data)) {
+              return OkStatus();
+            }
+
+            LiveSlot& live = live_slots.emplace_back(LiveSlot{
+                .old_slot = slot.offset,
+                .user_data = std::string{user_data},
+                .root_page_ids = {},
+            });
+
+            // The body of a user slot appended as part of a job is the commit slot, which lists
+            // the job's root page refs.
+            //
+            return TypedSlotReader<VolumeEventVariant>::visit_slot(
+                slot, slot.body,
+                [&live](const SlotParse&, const Ref<const PackedCommitJob>& commit) -> Status {
+                  for (const PackedPageId& page_id : *commit.get().root_page_ids) {
+                    live.root_page_ids.emplace_back(page_id.unpack());
+                  }
+                  return OkStatus();
+                },
+                [](const SlotParse&, const auto&) -> Status {
+                  return OkStatus();
+                });
+          });
+
+      BATT_REQUIRE_OK(n_visited);
+
+      if (*n_visited == 0) {
+        break;
+      }
+    }
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+  // Phase 2: Re-append the live slots at the tail of the log, in order.  Runs of slots without page
+  // refs are appended together as a single batch; slots with page refs become new jobs.
+  //
+  std::vector<std::string_view> raw_batch;
+  std::vector<const LiveSlot*> raw_batch_slots;
+
+  const auto append_raw_batch = [&]() -> Status {
+    if (raw_batch.empty()) {
+      return OkStatus();
+    }
+
+    const Slice<const std::string_view> payloads = as_slice(raw_batch);
+
+    StatusOr<batt::Grant> grant =
+        volume.reserve(volume.calculate_batch_grant_size(payloads), options.wait_for_log_space);
+
+    BATT_REQUIRE_OK(grant);
+
+    StatusOr<std::vector<SlotRange>> new_slots = volume.append_batch(payloads, *grant);
+
+    BATT_REQUIRE_OK(new_slots);
+    BATT_CHECK_EQ(new_slots->size(), raw_batch_slots.size());
+
+    for (usize i = 0; i < raw_batch_slots.size(); ++i) {
+      result.relocated.emplace_back(RelocatedSlot{
+          .old_slot = raw_batch_slots[i]->old_slot,
+          .new_slot = (*new_slots)[i],
+      });
+    }
+
+    raw_batch.clear();
+    raw_batch_slots.clear();
+
+    return OkStatus();
+  };
+
+  for (const LiveSlot& live : live_slots) {
+    if (live.root_page_ids.empty()) {
+      raw_batch.emplace_back(live.user_data);
+      raw_batch_slots.emplace_back(&live);
+      continue;
+    }
+
+    BATT_REQUIRE_OK(append_raw_batch());
+
+    // The new job adds a ref to each of the slot's root pages, to replace the one that will be
+    // dropped when the old slot is trimmed.
+    //
+    const RelocatedUserData user_data{
+        .bytes = live.user_data,
+        .root_page_ids = &live.root_page_ids,
+    };
+
+    StatusOr<AppendableJob> appendable =
+        make_appendable_job(volume.new_job(), PackableRef{user_data});
+
+    BATT_REQUIRE_OK(appendable);
+
+    StatusOr<batt::Grant> grant =
+        volume.reserve(volume.calculate_grant_size(*appendable), options.wait_for_log_space);
+
+    BATT_REQUIRE_OK(grant);
+
+    StatusOr<SlotRange> new_slot = volume.append(std::move(*appendable), *grant);
+
+    BATT_REQUIRE_OK(new_slot);
+
+    result.relocated.emplace_back(RelocatedSlot{
+        .old_slot = live.old_slot,
+        .new_slot = *new_slot,
+    });
+  }
+
+  BATT_REQUIRE_OK(append_raw_batch());
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+  // Phase 3: Once the relocated slots are durable, allow the window to be trimmed.
+  //
+  if (!result.relocated.empty()) {
+    const slot_offset_type relocated_upper_bound = result.relocated.back().new_slot.upper_bound;
+
+    BATT_REQUIRE_OK(volume.sync(LogReadMode::kDurable, SlotUpperBoundAt{relocated_upper_bound}));
+  }
+
+  BATT_REQUIRE_OK(volume.trim(result.compacted.upper_bound));
+
+  LLFS_VLOG(1) << "compact_volume_log:" << BATT_INSPECT(result);
+
+  return result;
+}
+
+}  // namespace llfs
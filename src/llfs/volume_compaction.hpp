@@ -0,0 +1,124 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_VOLUME_COMPACTION_HPP
+#define LLFS_VOLUME_COMPACTION_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/slot.hpp>
+#include <llfs/slot_parse.hpp>
+#include <llfs/status.hpp>
+#include <llfs/volume.hpp>
+
+#include <batteries/async/types.hpp>
+
+#include <functional>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace llfs {
+
+/** \brief Returns true if the passed user slot is still needed, i.e. it must be relocated to the
+ * tail of the log before the part of the log that contains it can be trimmed.
+ */
+using VolumeSlotLivenessFn =
+    std::function<bool(const SlotParse& slot, std::string_view user_data)>;
+
+/** \brief Parameters for compact_volume_log.
+ */
+struct VolumeCompactionOptions {
+  /** \brief The default value of `max_window_size`.
+   */
+  static constexpr u64 kDefaultMaxWindowSize = 4 * kMiB;
+
+  /** \brief The maximum number of bytes (starting at the current trim position) to compact per
+   * call.
+   */
+  u64 max_window_size = kDefaultMaxWindowSize;
+
+  /** \brief Whether to wait for log space to relocate the live slots of the window.
+   */
+  batt::WaitForResource wait_for_log_space = batt::WaitForResource::kTrue;
+};
+
+/** \brief A user slot moved by compact_volume_log.
+ */
+struct RelocatedSlot {
+  /** \brief The slot range of the original slot, as passed to the liveness function.
+   */
+  SlotRange old_slot;
+
+  /** \brief The slot range returned by Volume::append (or Volume::append_batch) for the relocated
+   * copy; for a slot with page refs, this spans both the prepare and commit slots of the new job.
+   */
+  SlotRange new_slot;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const RelocatedSlot& t)
+{
+  return out << "RelocatedSlot{.old_slot=" << t.old_slot << ", .new_slot=" << t.new_slot << ",}";
+}
+
+/** \brief The outcome of compact_volume_log.
+ */
+struct VolumeCompactionResult {
+  /** \brief The range of the log that was compacted; the Volume's trim position has been advanced
+   * to `compacted.upper_bound`.
+   */
+  SlotRange compacted;
+
+  /** \brief The number of user slots examined.
+   */
+  usize user_slot_count = 0;
+
+  /** \brief The live slots that were re-appended, in log order.
+   */
+  std::vector<RelocatedSlot> relocated;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const VolumeCompactionResult& t)
+{
+  return out << "VolumeCompactionResult{.compacted=" << t.compacted
+             << ", .user_slot_count=" << t.user_slot_count
+             << ", .relocated.size()=" << t.relocated.size() << ",}";
+}
+
+/** \brief Compacts the oldest part of the root log of `volume`, so that it can be trimmed even if
+ * it contains long-lived user slots.
+ *
+ * Scans the user slots in the first `options.max_window_size` bytes of the log (starting at the
+ * current trim position, and only up to the current durable end of the log), and calls `is_live`
+ * for each.  Live slots are re-appended at the tail of the log, in their original order, with the
+ * same user data; if a slot was appended as part of a PageCacheJob, it is re-appended as a new job
+ * with the same root page refs, so that its pages stay alive once the original slot is trimmed.
+ * After the relocated slots are durable, the Volume's trim position is advanced past the window.
+ *
+ * The actual trimming is done (asynchronously) by the Volume's VolumeTrimmer; use
+ * Volume::await_trim to wait for it.  The caller is responsible for updating any external
+ * references (e.g. indexes) to the relocated slots, using `VolumeCompactionResult::relocated`.
+ *
+ * NOTE: relocation is not atomic with trimming.  If the process crashes after some relocated
+ * slots are durable but before the trim past the window is, recovery finds both the original and
+ * the relocated copies of those slots, and replays both (in log order).  Slot visitors must
+ * therefore tolerate duplicate user slots, e.g. by making replay idempotent or by keying state on
+ * the user data rather than on the slot offset.  A repeated compaction after such a crash just
+ * relocates the surviving originals again.
+ *
+ * compact_volume_log should only be called by one task at a time per Volume.
+ */
+StatusOr<VolumeCompactionResult> compact_volume_log(Volume& volume,
+                                                    const VolumeCompactionOptions& options,
+                                                    const VolumeSlotLivenessFn& is_live);
+
+}  // namespace llfs
+
+#endif  // LLFS_VOLUME_COMPACTION_HPP
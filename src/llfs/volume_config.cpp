@@ -67,6 +67,8 @@ Status configure_storage_object(StorageFileBuilder::Transaction& txn,
   p_config->slot_1.n_slots = 2;
   p_config->trim_lock_update_interval_bytes = options.base.trim_lock_update_interval;
   p_config->trim_delay_byte_count = options.base.trim_delay_byte_count;
+  p_config->write_policy = static_cast<u8>(options.base.write_policy);
+  p_config->adaptive_write_queue_depth = options.base.adaptive_write_queue_depth;
 
   if (!txn.packer().pack_string_to(&p_config->name, options.base.name)) {
     return ::batt::StatusCode::kResourceExhausted;
@@ -106,11 +108,14 @@ StatusOr<std::unique_ptr<Volume>> recover_storage_object(
               .trim_lock_update_interval =
                   TrimLockUpdateInterval{p_volume_config->trim_lock_update_interval_bytes},
               .trim_delay_byte_count = TrimDelayByteCount{p_volume_config->trim_delay_byte_count},
+              .write_policy = static_cast<VolumeWritePolicy>(p_volume_config->write_policy.value()),
+              .adaptive_write_queue_depth = p_volume_config->adaptive_write_queue_depth,
           },
       .cache = *page_cache,
       .root_log_factory = root_log_factory->get(),
       .recycler_log_factory = recycler_log_factory->get(),
       .trim_control = std::move(volume_runtime_options.trim_control),
+      .trimmer_options = volume_runtime_options.trimmer_options,
   };
 
   return Volume::recover(std::move(params), volume_runtime_options.slot_visitor_fn);
@@ -103,9 +103,19 @@ struct PackedVolumeConfig : PackedConfigSlotHeader {
   //
   PackedBytes name;
 
+  // VolumeOptions::write_policy (a VolumeWritePolicy value).
+  //
+  little_u8 write_policy;
+
+  u8 pad1_[1];
+
+  // VolumeOptions::adaptive_write_queue_depth.
+  //
+  little_u16 adaptive_write_queue_depth;
+
   // Reserved for future use.
   //
-  u8 pad1_[36];
+  u8 pad2_[32];
 };
 
 BATT_STATIC_ASSERT_EQ(sizeof(PackedVolumeConfig), PackedVolumeConfig::kSize);
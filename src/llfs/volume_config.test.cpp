@@ -128,6 +128,8 @@ TEST_F(VolumeConfigTest, ConfigRestore)
                         .max_refs_per_page = llfs::MaxRefsPerPage{1},
                         .trim_lock_update_interval = llfs::TrimLockUpdateInterval{4 * kKiB},
                         .trim_delay_byte_count = llfs::TrimDelayByteCount{0},
+                        .write_policy = llfs::VolumeWritePolicy::kAdaptive,
+                        .adaptive_write_queue_depth = 7,
                     },
                 .root_log =
                     llfs::LogDeviceConfigOptions{
@@ -180,6 +182,11 @@ TEST_F(VolumeConfigTest, ConfigRestore)
     ASSERT_TRUE(maybe_volume.ok()) << BATT_INSPECT(maybe_volume.status());
 
     llfs::Volume& volume = **maybe_volume;
+
+    EXPECT_EQ(volume.options().write_policy, llfs::VolumeWritePolicy::kAdaptive);
+    EXPECT_EQ(volume.options().adaptive_write_queue_depth, 7u);
+    EXPECT_EQ(volume.write_policy(), llfs::VolumeWritePolicy::kAdaptive);
+
     llfs::StatusOr<batt::Grant> grant =
         volume.reserve(volume.calculate_grant_size(std::string_view("alpha")) +        //
                            volume.calculate_grant_size(std::string_view("bravo")) +    //
@@ -58,6 +58,9 @@ class VolumeEventVisitor
   LLFS_VOLUME_EVENT_HANDLER_DECL(PackedVolumeRecovered, on_volume_recovered)
   LLFS_VOLUME_EVENT_HANDLER_DECL(PackedVolumeFormatUpgrade, on_volume_format_upgrade)
   LLFS_VOLUME_EVENT_HANDLER_DECL(VolumeTrimEvent, on_volume_trim)
+  LLFS_VOLUME_EVENT_HANDLER_DECL(Ref<const PackedVolumeMetadataCheckpoint>,
+                                 on_volume_metadata_checkpoint)
+  LLFS_VOLUME_EVENT_HANDLER_DECL(Ref<const PackedPrepareJobLink>, on_prepare_job_link)
 
 #undef LLFS_VOLUME_EVENT_HANDLER_DECL
 
@@ -120,6 +123,17 @@ class VolumeEventVisitor<R>::NullImpl : public VolumeEventVisitor<R>
   {
     return batt::make_default<R>();
   }
+
+  R on_volume_metadata_checkpoint(const SlotParse&,
+                                  const Ref<const PackedVolumeMetadataCheckpoint>&) override
+  {
+    return batt::make_default<R>();
+  }
+
+  R on_prepare_job_link(const SlotParse&, const Ref<const PackedPrepareJobLink>&) override
+  {
+    return batt::make_default<R>();
+  }
 };
 
 //#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
@@ -347,4 +347,139 @@ std::ostream& operator<<(std::ostream& out, const VolumeTrimEvent& t)
              << ",}";
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize packed_sizeof(const VolumeMetadataCheckpoint& object)
+{
+  return sizeof(PackedVolumeMetadataCheckpoint) +
+         packed_array_size<PackedVolumeAttachCheckpoint>(object.attachments.size());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize packed_sizeof(const PackedVolumeMetadataCheckpoint& packed)
+{
+  return sizeof(PackedVolumeMetadataCheckpoint) + packed_sizeof(*packed.attachments);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PackedVolumeMetadataCheckpoint* pack_object_to(const VolumeMetadataCheckpoint& object,
+                                               PackedVolumeMetadataCheckpoint* packed,
+                                               DataPacker* dst)
+{
+  packed->ids = object.ids;
+  packed->ids_last_refresh = object.ids_last_refresh;
+  packed->replay_lower_bound = object.replay_lower_bound;
+  packed->trim_pos = object.trim_pos;
+
+  Optional<DataPacker::ArrayPacker<PackedVolumeAttachCheckpoint>> packed_attachments =
+      dst->pack_range(object.attachments);
+
+  if (!packed_attachments) {
+    return nullptr;
+  }
+  packed->attachments.reset(packed_attachments->finish(), dst);
+
+  return packed;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<Ref<const PackedVolumeMetadataCheckpoint>> unpack_object(
+    const PackedVolumeMetadataCheckpoint& packed, DataReader*)
+{
+  return as_cref(packed);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status validate_packed_value(const PackedVolumeMetadataCheckpoint& packed,
+                             const void* buffer_data, usize buffer_size)
+{
+  BATT_REQUIRE_OK(validate_packed_struct(packed, buffer_data, buffer_size));
+  BATT_REQUIRE_OK(validate_packed_value(*packed.attachments, buffer_data, buffer_size));
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, const PackedVolumeMetadataCheckpoint& t)
+{
+  return out << "PackedVolumeMetadataCheckpoint"                          //
+             << "{.ids=" << t.ids                                         //
+             << ", .ids_last_refresh=" << t.ids_last_refresh.value()      //
+             << ", .replay_lower_bound=" << t.replay_lower_bound.value()  //
+             << ", .trim_pos=" << t.trim_pos.value()                      //
+             << ", .attachments.size()=" << t.attachments->size()         //
+             << ",}";
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize packed_sizeof(const PrepareJobLink& object)
+{
+  return sizeof(PackedPrepareJobLink) +
+         packed_array_size<PackedPageId>(object.extra_root_page_ids.size());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize packed_sizeof(const PackedPrepareJobLink& packed)
+{
+  return sizeof(PackedPrepareJobLink) + packed_sizeof(*packed.extra_root_page_ids);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PackedPrepareJobLink* pack_object_to(const PrepareJobLink& object, PackedPrepareJobLink* packed,
+                                     DataPacker* dst)
+{
+  packed->decision_uuid = object.decision_uuid;
+  packed->prepare_slot = object.prepare_slot;
+  packed->decision_slot = object.decision_slot;
+
+  PackedArray<PackedPageId>* packed_extra_roots = pack_object(
+      pack_seq_as_array(as_seq(object.extra_root_page_ids) | seq::decayed()), dst);
+
+  if (!packed_extra_roots) {
+    return nullptr;
+  }
+  packed->extra_root_page_ids.reset(packed_extra_roots, dst);
+
+  return packed;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<Ref<const PackedPrepareJobLink>> unpack_object(const PackedPrepareJobLink& packed,
+                                                        DataReader*)
+{
+  return as_cref(packed);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status validate_packed_value(const PackedPrepareJobLink& packed, const void* buffer_data,
+                             usize buffer_size)
+{
+  BATT_REQUIRE_OK(validate_packed_struct(packed, buffer_data, buffer_size));
+  BATT_REQUIRE_OK(validate_packed_value(*packed.extra_root_page_ids, buffer_data, buffer_size));
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, const PackedPrepareJobLink& t)
+{
+  return out << "PackedPrepareJobLink"                                            //
+             << "{.decision_uuid=" << t.decision_uuid                              //
+             << ", .prepare_slot=" << t.prepare_slot.value()                       //
+             << ", .decision_slot=" << t.decision_slot.value()                     //
+             << ", .extra_root_page_ids.size()=" << t.extra_root_page_ids->size()  //
+             << ",}";
+}
+
 }  // namespace llfs
@@ -15,6 +15,7 @@
 #include <llfs/page_id_factory.hpp>
 #include <llfs/page_layout.hpp>
 #include <llfs/simple_packed_type.hpp>
+#include <llfs/unpack_cast.hpp>
 #include <llfs/volume_events_fwd.hpp>
 
 #include <batteries/bounds.hpp>
@@ -26,6 +27,8 @@
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_io.hpp>
 
+#include <vector>
+
 namespace llfs {
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
@@ -293,6 +296,139 @@ Status validate_packed_value(const PackedVolumeTrimEvent& packed, const void* bu
 
 std::ostream& operator<<(std::ostream& out, const VolumeTrimEvent& t);
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A Volume attachment as recorded in a PackedVolumeMetadataCheckpoint.
+ */
+struct PackedVolumeAttachCheckpoint {
+  // The attach event, exactly as last written to the log.
+  //
+  PackedVolumeAttachEvent event;
+
+  // The slot at which `event` was last refreshed.
+  //
+  PackedSlotOffset last_refresh;
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedVolumeAttachCheckpoint), 40);
+
+LLFS_SIMPLE_PACKED_TYPE(PackedVolumeAttachCheckpoint);
+
+inline Status validate_packed_value(const PackedVolumeAttachCheckpoint& packed,
+                                    const void* buffer_data, usize buffer_size)
+{
+  return validate_packed_struct(packed, buffer_data, buffer_size);
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A compact snapshot of the Volume metadata (ids and attachments) that allows recovery to
+ * start replaying the WAL at `replay_lower_bound` instead of at the beginning of the log.
+ *
+ * A checkpoint is only written when the metadata refresher has nothing left to flush, so it always
+ * agrees with the PackedVolumeIds and PackedVolumeAttachEvent slots before it.  Every job whose
+ * PackedPrepareJob slot is before `replay_lower_bound` was resolved (committed or rolled back) by
+ * the time the checkpoint was written.
+ */
+struct PackedVolumeMetadataCheckpoint {
+  PackedVolumeMetadataCheckpoint(const PackedVolumeMetadataCheckpoint&) = delete;
+  PackedVolumeMetadataCheckpoint& operator=(const PackedVolumeMetadataCheckpoint&) = delete;
+
+  PackedVolumeIds ids;
+  PackedSlotOffset ids_last_refresh;
+
+  // The lower bound of all pending jobs when this checkpoint was written; never greater than the
+  // slot offset of the checkpoint itself.
+  //
+  PackedSlotOffset replay_lower_bound;
+
+  // The trim position of the log at the time this checkpoint was written (informational).
+  //
+  PackedSlotOffset trim_pos;
+
+  PackedPointer<PackedArray<PackedVolumeAttachCheckpoint>> attachments;
+};
+
+struct VolumeMetadataCheckpoint {
+  PackedVolumeIds ids;
+  slot_offset_type ids_last_refresh;
+  slot_offset_type replay_lower_bound;
+  slot_offset_type trim_pos;
+  std::vector<PackedVolumeAttachCheckpoint> attachments;
+};
+
+LLFS_DEFINE_PACKED_TYPE_FOR(VolumeMetadataCheckpoint, PackedVolumeMetadataCheckpoint);
+
+usize packed_sizeof(const VolumeMetadataCheckpoint& object);
+
+usize packed_sizeof(const PackedVolumeMetadataCheckpoint& packed);
+
+PackedVolumeMetadataCheckpoint* pack_object_to(const VolumeMetadataCheckpoint& object,
+                                               PackedVolumeMetadataCheckpoint* packed,
+                                               DataPacker* dst);
+
+StatusOr<Ref<const PackedVolumeMetadataCheckpoint>> unpack_object(
+    const PackedVolumeMetadataCheckpoint& packed, DataReader*);
+
+Status validate_packed_value(const PackedVolumeMetadataCheckpoint& packed,
+                             const void* buffer_data, usize buffer_size);
+
+std::ostream& operator<<(std::ostream& out, const PackedVolumeMetadataCheckpoint& t);
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Written right after a PackedPrepareJob that is part of a multi-Volume job (see
+ * append_multi_volume_job), in the same flush, to say where the commit decision for that job lives.
+ *
+ * A multi-Volume job is decided by the ref count updates made by its *coordinator* Volume: the job
+ * is committed iff some PageAllocator named in the prepare has an attachment for `decision_uuid`
+ * whose user slot is at least `decision_slot`.  In the coordinator's own log, `decision_uuid` is
+ * the Volume's uuid and `extra_root_page_ids` holds the root refs of all the other (participant)
+ * Volumes, so that recovery can roll the job forward with the correct ref counts.  In a
+ * participant's log, `extra_root_page_ids` is empty.
+ */
+struct PackedPrepareJobLink {
+  PackedPrepareJobLink(const PackedPrepareJobLink&) = delete;
+  PackedPrepareJobLink& operator=(const PackedPrepareJobLink&) = delete;
+
+  // The uuid of the coordinator Volume.
+  //
+  boost::uuids::uuid decision_uuid;
+
+  // The slot offset of the PackedPrepareJob (in this log) that this link belongs to.
+  //
+  PackedSlotOffset prepare_slot;
+
+  // The slot offset of the coordinator's PackedPrepareJob.
+  //
+  PackedSlotOffset decision_slot;
+
+  PackedPointer<PackedArray<PackedPageId>> extra_root_page_ids;
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedPrepareJobLink), 36);
+
+struct PrepareJobLink {
+  boost::uuids::uuid decision_uuid;
+  slot_offset_type prepare_slot;
+  slot_offset_type decision_slot;
+  std::vector<PageId> extra_root_page_ids;
+};
+
+LLFS_DEFINE_PACKED_TYPE_FOR(PrepareJobLink, PackedPrepareJobLink);
+
+usize packed_sizeof(const PrepareJobLink& object);
+
+usize packed_sizeof(const PackedPrepareJobLink& packed);
+
+PackedPrepareJobLink* pack_object_to(const PrepareJobLink& object, PackedPrepareJobLink* packed,
+                                     DataPacker* dst);
+
+StatusOr<Ref<const PackedPrepareJobLink>> unpack_object(const PackedPrepareJobLink& packed,
+                                                        DataReader*);
+
+Status validate_packed_value(const PackedPrepareJobLink& packed, const void* buffer_data,
+                             usize buffer_size);
+
+std::ostream& operator<<(std::ostream& out, const PackedPrepareJobLink& t);
+
 }  // namespace llfs
 
 #endif  // LLFS_VOLUME_EVENTS_HPP
@@ -16,6 +16,7 @@
 #include <llfs/testing/packed_type_test_fixture.hpp>
 
 #include <boost/range/irange.hpp>
+#include <boost/uuid/random_generator.hpp>
 
 namespace {
 
@@ -327,4 +328,67 @@ TEST_F(VolumeJobEventsTest, CommitJobTest)
   }
 }
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// VolumeMetadataCheckpoint Test Plan
+// -----------------------------------
+//  Pack checkpoints with 0, 1, and many attachments; verify that packed_sizeof is exact and that
+//  all fields (including each attachment's last refresh slot) unpack correctly.
+//
+TEST_F(VolumeJobEventsTest, MetadataCheckpointTest)
+{
+  boost::uuids::random_generator uuid_gen;
+
+  for (usize attachment_count : {0, 1, 37}) {
+    llfs::VolumeMetadataCheckpoint checkpoint{
+        .ids =
+            llfs::PackedVolumeIds{
+                .main_uuid = uuid_gen(),
+                .recycler_uuid = uuid_gen(),
+                .trimmer_uuid = uuid_gen(),
+            },
+        .ids_last_refresh = 4096,
+        .replay_lower_bound = 8192 + attachment_count,
+        .trim_pos = 1024,
+        .attachments = {},
+    };
+
+    for (usize i = 0; i < attachment_count; ++i) {
+      llfs::PackedVolumeAttachCheckpoint attach;
+      attach.event.id = llfs::VolumeAttachmentId{
+          .client = uuid_gen(),
+          .device = i,
+      };
+      attach.event.user_slot_offset = i * 3;
+      attach.last_refresh = 5000 + i;
+
+      checkpoint.attachments.emplace_back(attach);
+    }
+
+    std::vector<char> storage;
+    ASSERT_NO_FATAL_FAILURE(this->pack_test_object(checkpoint, storage));
+
+    llfs::StatusOr<const llfs::PackedVolumeMetadataCheckpoint&> unpacked =
+        llfs::unpack_cast(storage, batt::StaticType<llfs::PackedVolumeMetadataCheckpoint>{});
+
+    ASSERT_TRUE(unpacked.ok()) << BATT_INSPECT(unpacked.status());
+    EXPECT_EQ(llfs::packed_sizeof(*unpacked), storage.size());
+
+    EXPECT_EQ(unpacked->ids.main_uuid, checkpoint.ids.main_uuid);
+    EXPECT_EQ(unpacked->ids.recycler_uuid, checkpoint.ids.recycler_uuid);
+    EXPECT_EQ(unpacked->ids.trimmer_uuid, checkpoint.ids.trimmer_uuid);
+    EXPECT_EQ(unpacked->ids_last_refresh, checkpoint.ids_last_refresh);
+    EXPECT_EQ(unpacked->replay_lower_bound, checkpoint.replay_lower_bound);
+    EXPECT_EQ(unpacked->trim_pos, checkpoint.trim_pos);
+
+    ASSERT_EQ(unpacked->attachments->size(), attachment_count);
+    for (usize i = 0; i < attachment_count; ++i) {
+      const llfs::PackedVolumeAttachCheckpoint& attach = (*unpacked->attachments)[i];
+
+      EXPECT_EQ(attach.event.id, checkpoint.attachments[i].event.id);
+      EXPECT_EQ(attach.event.user_slot_offset, i * 3);
+      EXPECT_EQ(attach.last_refresh, 5000 + i);
+    }
+  }
+}
+
 }  // namespace
@@ -23,21 +23,25 @@ struct PackedPrepareJob;
 struct PackedCommitJob;
 struct PackedRollbackJob;
 struct PackedVolumeTrimEvent;
+struct PackedVolumeMetadataCheckpoint;
+struct PackedPrepareJobLink;
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 //
 using VolumeEventVariant =
-    PackedVariant<PackedVolumeIds,            // 0
-                  PackedVolumeAttachEvent,    // 1
-                  PackedVolumeDetachEvent,    // 2
-                  PackedVolumeRecovered,      // 3
-                  PackedPrepareJob,           // 4
-                  PackedCommitJob,            // 5
-                  PackedRollbackJob,          // 6
-                  PackedVolumeFormatUpgrade,  // 7
-                  PackedRawData,              // 8
-                  PackedVolumeTrimEvent       // 9
-                                              // 10..255 : reserved for future use.
+    PackedVariant<PackedVolumeIds,                 // 0
+                  PackedVolumeAttachEvent,         // 1
+                  PackedVolumeDetachEvent,         // 2
+                  PackedVolumeRecovered,           // 3
+                  PackedPrepareJob,                // 4
+                  PackedCommitJob,                 // 5
+                  PackedRollbackJob,               // 6
+                  PackedVolumeFormatUpgrade,       // 7
+                  PackedRawData,                   // 8
+                  PackedVolumeTrimEvent,           // 9
+                  PackedVolumeMetadataCheckpoint,  // 10
+                  PackedPrepareJobLink             // 11
+                                                   // 12..255 : reserved for future use.
                   >;
 
 }  // namespace llfs
@@ -0,0 +1,245 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/volume_fuse_events.hpp>
+//
+
+#include <batteries/stream_util.hpp>
+
+#include <cstring>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// VolumeFuseInodeCreated
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize packed_sizeof(const VolumeFuseInodeCreated& object)
+{
+  return sizeof(PackedVolumeFuseInodeCreated) + packed_sizeof_str_data(object.name.size());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize packed_sizeof(const PackedVolumeFuseInodeCreated& packed)
+{
+  return sizeof(PackedVolumeFuseInodeCreated) + packed_sizeof_str_data(packed.name.size());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PackedVolumeFuseInodeCreated* pack_object_to(const VolumeFuseInodeCreated& object,
+                                             PackedVolumeFuseInodeCreated* packed,
+                                             DataPacker* dst)
+{
+  packed->ino = object.ino;
+  packed->parent = object.parent;
+  packed->mode = object.mode;
+  packed->uid = object.uid;
+  packed->gid = object.gid;
+  std::memset(packed->reserved_, 0, sizeof(packed->reserved_));
+
+  if (!dst->pack_string_to(&packed->name, object.name)) {
+    return nullptr;
+  }
+
+  return packed;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<VolumeFuseInodeCreated> unpack_object(const PackedVolumeFuseInodeCreated& packed,
+                                               DataReader*)
+{
+  return VolumeFuseInodeCreated{
+      .ino = packed.ino,
+      .parent = packed.parent,
+      .mode = packed.mode,
+      .uid = packed.uid,
+      .gid = packed.gid,
+      .name = packed.name.as_str(),
+  };
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status validate_packed_value(const PackedVolumeFuseInodeCreated& packed, const void* buffer_data,
+                             usize buffer_size)
+{
+  BATT_REQUIRE_OK(validate_packed_struct(packed, buffer_data, buffer_size));
+  BATT_REQUIRE_OK(validate_packed_value(packed.name, buffer_data, buffer_size));
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, const VolumeFuseInodeCreated& t)
+{
+  return out << "VolumeFuseInodeCreated{.ino=" << t.ino << ", .parent=" << t.parent
+             << ", .mode=" << std::oct << t.mode << std::dec << ", .uid=" << t.uid
+             << ", .gid=" << t.gid << ", .name=" << batt::c_str_literal(t.name) << ",}";
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// VolumeFuseEntryRemoved
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize packed_sizeof(const VolumeFuseEntryRemoved& object)
+{
+  return sizeof(PackedVolumeFuseEntryRemoved) + packed_sizeof_str_data(object.name.size());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize packed_sizeof(const PackedVolumeFuseEntryRemoved& packed)
+{
+  return sizeof(PackedVolumeFuseEntryRemoved) + packed_sizeof_str_data(packed.name.size());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PackedVolumeFuseEntryRemoved* pack_object_to(const VolumeFuseEntryRemoved& object,
+                                             PackedVolumeFuseEntryRemoved* packed,
+                                             DataPacker* dst)
+{
+  packed->parent = object.parent;
+  packed->ino = object.ino;
+
+  if (!dst->pack_string_to(&packed->name, object.name)) {
+    return nullptr;
+  }
+
+  return packed;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<VolumeFuseEntryRemoved> unpack_object(const PackedVolumeFuseEntryRemoved& packed,
+                                               DataReader*)
+{
+  return VolumeFuseEntryRemoved{
+      .parent = packed.parent,
+      .ino = packed.ino,
+      .name = packed.name.as_str(),
+  };
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status validate_packed_value(const PackedVolumeFuseEntryRemoved& packed, const void* buffer_data,
+                             usize buffer_size)
+{
+  BATT_REQUIRE_OK(validate_packed_struct(packed, buffer_data, buffer_size));
+  BATT_REQUIRE_OK(validate_packed_value(packed.name, buffer_data, buffer_size));
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, const VolumeFuseEntryRemoved& t)
+{
+  return out << "VolumeFuseEntryRemoved{.parent=" << t.parent << ", .ino=" << t.ino
+             << ", .name=" << batt::c_str_literal(t.name) << ",}";
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// PackedVolumeFuseAttributesSet
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, const PackedVolumeFuseAttributesSet& t)
+{
+  return out << "PackedVolumeFuseAttributesSet{.ino=" << t.ino.value() << ", .mode=" << std::oct
+             << t.mode.value() << std::dec << ", .uid=" << t.uid.value()
+             << ", .gid=" << t.gid.value() << ", .atime_nsec=" << t.atime_nsec.value()
+             << ", .mtime_nsec=" << t.mtime_nsec.value() << ",}";
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// VolumeFuseBlocksWritten
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize packed_sizeof(const VolumeFuseBlocksWritten& object)
+{
+  return sizeof(PackedVolumeFuseBlocksWritten) +
+         packed_array_size<PackedVolumeFuseBlockRef>(object.blocks.size());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize packed_sizeof(const PackedVolumeFuseBlocksWritten& packed)
+{
+  return sizeof(PackedVolumeFuseBlocksWritten) + packed_sizeof(*packed.blocks);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PackedVolumeFuseBlocksWritten* pack_object_to(const VolumeFuseBlocksWritten& object,
+                                              PackedVolumeFuseBlocksWritten* packed,
+                                              DataPacker* dst)
+{
+  packed->ino = object.ino;
+  packed->file_size = object.file_size;
+  std::memset(packed->reserved_, 0, sizeof(packed->reserved_));
+
+  Optional<DataPacker::ArrayPacker<PackedVolumeFuseBlockRef>> packed_blocks =
+      dst->pack_range(object.blocks);
+
+  if (!packed_blocks) {
+    return nullptr;
+  }
+  packed->blocks.reset(packed_blocks->finish(), dst);
+
+  return packed;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<Ref<const PackedVolumeFuseBlocksWritten>> unpack_object(
+    const PackedVolumeFuseBlocksWritten& packed, DataReader*)
+{
+  return as_cref(packed);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status validate_packed_value(const PackedVolumeFuseBlocksWritten& packed, const void* buffer_data,
+                             usize buffer_size)
+{
+  BATT_REQUIRE_OK(validate_packed_struct(packed, buffer_data, buffer_size));
+  BATT_REQUIRE_OK(validate_packed_value(packed.blocks, buffer_data, buffer_size));
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+BoxedSeq<PageId> trace_refs(const VolumeFuseBlocksWritten& object)
+{
+  return as_seq(object.blocks)  //
+         | seq::map([](const PackedVolumeFuseBlockRef& block_ref) -> PageId {
+             return block_ref.page_id.unpack();
+           })  //
+         | seq::boxed();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, const PackedVolumeFuseBlocksWritten& t)
+{
+  return out << "PackedVolumeFuseBlocksWritten{.ino=" << t.ino.value()
+             << ", .file_size=" << t.file_size.value() << ", .blocks.size()=" << t.blocks->size()
+             << ",}";
+}
+
+}  // namespace llfs
@@ -0,0 +1,220 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_VOLUME_FUSE_EVENTS_HPP
+#define LLFS_VOLUME_FUSE_EVENTS_HPP
+
+#include <llfs/data_packer.hpp>
+#include <llfs/data_reader.hpp>
+#include <llfs/define_packed_type.hpp>
+#include <llfs/int_types.hpp>
+#include <llfs/packed_array.hpp>
+#include <llfs/packed_bytes.hpp>
+#include <llfs/packed_page_id.hpp>
+#include <llfs/packed_pointer.hpp>
+#include <llfs/packed_variant.hpp>
+#include <llfs/ref.hpp>
+#include <llfs/seq.hpp>
+#include <llfs/simple_packed_type.hpp>
+#include <llfs/status.hpp>
+#include <llfs/unpack_cast.hpp>
+
+#include <batteries/static_assert.hpp>
+
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace llfs {
+
+// The Volume root log events written by VolumeFuseImpl.  The file system state is the result of
+// replaying these events in log order, starting from the root directory (ino 1, mode 0755).
+//
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A new inode `ino` was created and linked into directory `parent` as `name`.
+ */
+struct PackedVolumeFuseInodeCreated {
+  little_u64 ino;
+  little_u64 parent;
+
+  // The full st_mode of the new inode (file type and permission bits).
+  //
+  little_u32 mode;
+
+  little_u32 uid;
+  little_u32 gid;
+
+  u8 reserved_[4];
+
+  PackedBytes name;
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedVolumeFuseInodeCreated), 40);
+
+struct VolumeFuseInodeCreated {
+  u64 ino;
+  u64 parent;
+  u32 mode;
+  u32 uid;
+  u32 gid;
+  std::string_view name;
+};
+
+LLFS_DEFINE_PACKED_TYPE_FOR(VolumeFuseInodeCreated, PackedVolumeFuseInodeCreated);
+
+usize packed_sizeof(const VolumeFuseInodeCreated& object);
+
+usize packed_sizeof(const PackedVolumeFuseInodeCreated& packed);
+
+PackedVolumeFuseInodeCreated* pack_object_to(const VolumeFuseInodeCreated& object,
+                                             PackedVolumeFuseInodeCreated* packed,
+                                             DataPacker* dst);
+
+/** \brief The unpacked `name` points into the slot data; it is only valid while the slot is.
+ */
+StatusOr<VolumeFuseInodeCreated> unpack_object(const PackedVolumeFuseInodeCreated& packed,
+                                               DataReader*);
+
+Status validate_packed_value(const PackedVolumeFuseInodeCreated& packed, const void* buffer_data,
+                             usize buffer_size);
+
+std::ostream& operator<<(std::ostream& out, const VolumeFuseInodeCreated& t);
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief The entry `name` (naming inode `ino`) was removed from directory `parent`; since hard
+ * links aren't supported, this also deletes the inode (and releases its data pages).
+ */
+struct PackedVolumeFuseEntryRemoved {
+  little_u64 parent;
+  little_u64 ino;
+  PackedBytes name;
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedVolumeFuseEntryRemoved), 24);
+
+struct VolumeFuseEntryRemoved {
+  u64 parent;
+  u64 ino;
+  std::string_view name;
+};
+
+LLFS_DEFINE_PACKED_TYPE_FOR(VolumeFuseEntryRemoved, PackedVolumeFuseEntryRemoved);
+
+usize packed_sizeof(const VolumeFuseEntryRemoved& object);
+
+usize packed_sizeof(const PackedVolumeFuseEntryRemoved& packed);
+
+PackedVolumeFuseEntryRemoved* pack_object_to(const VolumeFuseEntryRemoved& object,
+                                             PackedVolumeFuseEntryRemoved* packed,
+                                             DataPacker* dst);
+
+/** \brief The unpacked `name` points into the slot data; it is only valid while the slot is.
+ */
+StatusOr<VolumeFuseEntryRemoved> unpack_object(const PackedVolumeFuseEntryRemoved& packed,
+                                               DataReader*);
+
+Status validate_packed_value(const PackedVolumeFuseEntryRemoved& packed, const void* buffer_data,
+                             usize buffer_size);
+
+std::ostream& operator<<(std::ostream& out, const VolumeFuseEntryRemoved& t);
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief The attributes of inode `ino` other than its size were set.
+ */
+struct PackedVolumeFuseAttributesSet {
+  little_u64 ino;
+  little_u32 mode;
+  little_u32 uid;
+  little_u32 gid;
+  u8 reserved_[4];
+  little_i64 atime_nsec;
+  little_i64 mtime_nsec;
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedVolumeFuseAttributesSet), 40);
+
+LLFS_SIMPLE_PACKED_TYPE(PackedVolumeFuseAttributesSet);
+
+std::ostream& operator<<(std::ostream& out, const PackedVolumeFuseAttributesSet& t);
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief The page holding block `block_index` of a file (the bytes at offset `block_index *
+ * block_size`, where block_size is the payload size of the file system's pages).
+ */
+struct PackedVolumeFuseBlockRef {
+  little_u64 block_index;
+  PackedPageId page_id;
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedVolumeFuseBlockRef), 16);
+
+LLFS_SIMPLE_PACKED_TYPE(PackedVolumeFuseBlockRef);
+
+inline Status validate_packed_value(const PackedVolumeFuseBlockRef& packed,
+                                    const void* buffer_data, usize buffer_size)
+{
+  return validate_packed_struct(packed, buffer_data, buffer_size);
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief The size of file `ino` became `file_size`, and the given blocks were (re)written.
+ *
+ * Replay first drops the file's blocks at or past the new end of file, then installs `blocks`.
+ * The data pages are written by the PageCacheJob appended with this event; since the event traces
+ * its page ids (see trace_refs below), each page stays live for as long as a slot that refers to
+ * it is still in the log.
+ */
+struct PackedVolumeFuseBlocksWritten {
+  little_u64 ino;
+  little_u64 file_size;
+  PackedPointer<PackedArray<PackedVolumeFuseBlockRef>> blocks;
+  u8 reserved_[4];
+};
+
+BATT_STATIC_ASSERT_EQ(sizeof(PackedVolumeFuseBlocksWritten), 24);
+
+struct VolumeFuseBlocksWritten {
+  u64 ino;
+  u64 file_size;
+  std::vector<PackedVolumeFuseBlockRef> blocks;
+};
+
+LLFS_DEFINE_PACKED_TYPE_FOR(VolumeFuseBlocksWritten, PackedVolumeFuseBlocksWritten);
+
+usize packed_sizeof(const VolumeFuseBlocksWritten& object);
+
+usize packed_sizeof(const PackedVolumeFuseBlocksWritten& packed);
+
+PackedVolumeFuseBlocksWritten* pack_object_to(const VolumeFuseBlocksWritten& object,
+                                              PackedVolumeFuseBlocksWritten* packed,
+                                              DataPacker* dst);
+
+StatusOr<Ref<const PackedVolumeFuseBlocksWritten>> unpack_object(
+    const PackedVolumeFuseBlocksWritten& packed, DataReader*);
+
+Status validate_packed_value(const PackedVolumeFuseBlocksWritten& packed, const void* buffer_data,
+                             usize buffer_size);
+
+BoxedSeq<PageId> trace_refs(const VolumeFuseBlocksWritten& object);
+
+std::ostream& operator<<(std::ostream& out, const PackedVolumeFuseBlocksWritten& t);
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+
+using VolumeFuseEvent = PackedVariant<  //
+    PackedVolumeFuseInodeCreated,       //
+    PackedVolumeFuseEntryRemoved,       //
+    PackedVolumeFuseAttributesSet,      //
+    PackedVolumeFuseBlocksWritten       //
+    >;
+
+}  // namespace llfs
+
+#endif  // LLFS_VOLUME_FUSE_EVENTS_HPP
@@ -0,0 +1,1273 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/volume_fuse_impl.hpp>
+//
+
+#include <llfs/appendable_job.hpp>
+#include <llfs/logging.hpp>
+#include <llfs/opaque_page_view.hpp>
+#include <llfs/page_buffer.hpp>
+
+#include <batteries/checked_cast.hpp>
+#include <batteries/math.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <deque>
+
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace llfs {
+
+namespace {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+i64 nsec_from_timespec(const struct timespec& ts)
+{
+  return i64{ts.tv_sec} * 1000000000ll + ts.tv_nsec;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+struct timespec timespec_from_nsec(i64 nsec)
+{
+  struct timespec ts;
+  ts.tv_sec = nsec / 1000000000ll;
+  ts.tv_nsec = nsec % 1000000000ll;
+  if (ts.tv_nsec < 0) {
+    ts.tv_sec -= 1;
+    ts.tv_nsec += 1000000000ll;
+  }
+  return ts;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+struct timespec current_time()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PackedVolumeFuseAttributesSet make_attributes_set_event(fuse_ino_t ino, const struct stat& attr)
+{
+  PackedVolumeFuseAttributesSet event;
+  std::memset(&event, 0, sizeof(event));
+
+  event.ino = ino;
+  event.mode = attr.st_mode;
+  event.uid = attr.st_uid;
+  event.gid = attr.st_gid;
+  event.atime_nsec = nsec_from_timespec(attr.st_atim);
+  event.mtime_nsec = nsec_from_timespec(attr.st_mtim);
+
+  return event;
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*static*/ StatusOr<std::unique_ptr<VolumeFuseImpl>> VolumeFuseImpl::recover(
+    std::shared_ptr<WorkQueue>&& work_queue, std::unique_ptr<Volume>&& volume,
+    const VolumeFuseImplOptions& options)
+{
+  BATT_CHECK_NOT_NULLPTR(volume);
+
+  BATT_REQUIRE_OK(OpaquePageView::register_layout(volume->cache()));
+
+  auto impl = std::make_unique<VolumeFuseImpl>(std::move(work_queue), std::move(volume), options);
+
+  BATT_REQUIRE_OK(impl->replay_log());
+
+  return {std::move(impl)};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ VolumeFuseImpl::VolumeFuseImpl(std::shared_ptr<WorkQueue>&& work_queue,
+                                            std::unique_ptr<Volume>&& volume,
+                                            const VolumeFuseImplOptions& options) noexcept
+    : Super{std::move(work_queue)}
+    , options_{options}
+    , volume_{std::move(volume)}
+    , block_size_{PageBuffer::max_payload_size(options.page_size)}
+    , checkpoint_interval_{options.checkpoint_interval != 0
+                               ? options.checkpoint_interval
+                               : this->volume_->root_log().capacity() / 4}
+    , zero_block_(this->block_size_, '\0')
+{
+  this->set_cache_options(options.cache);
+  this->set_connection_options(options.connection);
+
+  auto locked = this->state_.lock();
+
+  std::unique_ptr<Inode> root = this->new_inode(FUSE_ROOT_ID, S_IFDIR | 0755, getuid(), getgid());
+  locked->inodes.emplace(FUSE_ROOT_ID, std::move(root));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+VolumeFuseImpl::~VolumeFuseImpl() noexcept
+{
+  this->volume_->halt();
+  this->volume_->join();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeFuseImpl::replay_log()
+{
+  BATT_ASSIGN_OK_RESULT(TypedVolumeReader<VolumeFuseEvent> reader,
+                        this->volume_->typed_reader(
+                            SlotRangeSpec{
+                                .lower_bound = None,
+                                .upper_bound = None,
+                            },
+                            LogReadMode::kDurable, batt::StaticType<VolumeFuseEvent>{}));
+
+  auto locked = this->state_.lock();
+  State& state = *locked;
+
+  for (;;) {
+    BATT_ASSIGN_OK_RESULT(
+        const usize n_slots_visited,
+        reader.visit_typed_next(
+            batt::WaitForResource::kFalse,
+            [&](const SlotParse&, const VolumeFuseInodeCreated& event) {
+              this->apply(state, event);
+              return OkStatus();
+            },
+            [&](const SlotParse&, const VolumeFuseEntryRemoved& event) {
+              this->apply(state, event);
+              return OkStatus();
+            },
+            [&](const SlotParse&, const PackedVolumeFuseAttributesSet& event) {
+              this->apply(state, event);
+              return OkStatus();
+            },
+            [&](const SlotParse&, const Ref<const PackedVolumeFuseBlocksWritten>& event) {
+              const PackedVolumeFuseBlocksWritten& packed = event.get();
+              const PackedArray<PackedVolumeFuseBlockRef>& blocks = *packed.blocks;
+              this->apply_blocks_written(state, packed.ino, packed.file_size,
+                                         batt::as_slice(blocks.data(), blocks.size()));
+              return OkStatus();
+            }));
+
+    if (n_slots_visited == 0) {
+      break;
+    }
+  }
+
+  // Count everything that survived the last trim towards the next checkpoint.
+  //
+  state.bytes_since_checkpoint = this->volume_->root_log().size();
+
+  LLFS_VLOG(1) << "VolumeFuseImpl recovered " << state.inodes.size() << " inode(s);"
+               << BATT_INSPECT(state.next_unused_ino) << BATT_INSPECT(state.bytes_since_checkpoint);
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto VolumeFuseImpl::find_inode(State& state, fuse_ino_t ino) -> StatusOr<Inode*>
+{
+  auto iter = state.inodes.find(ino);
+  if (iter == state.inodes.end()) {
+    LLFS_VLOG(1) << "Bad ino: " << ino;
+    return {batt::status_from_errno(ENOENT)};
+  }
+  return {iter->second.get()};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto VolumeFuseImpl::new_inode(fuse_ino_t ino, u32 mode, u32 uid, u32 gid) const
+    -> std::unique_ptr<Inode>
+{
+  auto inode = std::make_unique<Inode>();
+  std::memset(&inode->entry, 0, sizeof(inode->entry));
+
+  inode->entry.ino = ino;
+  inode->entry.attr_timeout = 1.0;
+  inode->entry.entry_timeout = 1.0;
+
+  struct stat& attr = inode->entry.attr;
+
+  attr.st_ino = ino;
+  attr.st_mode = mode;
+  attr.st_nlink = S_ISDIR(mode) ? 2 : 1;
+  attr.st_uid = uid;
+  attr.st_gid = gid;
+  attr.st_blksize = this->block_size_;
+  attr.st_atim = current_time();
+  attr.st_mtim = attr.st_atim;
+  attr.st_ctim = attr.st_atim;
+
+  return inode;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeFuseImpl::update_block_count(Inode& inode) const
+{
+  // st_blocks is always in units of 512 bytes.
+  //
+  inode.entry.attr.st_blocks = batt::round_up_bits(9, inode.file_size()) / 512;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeFuseImpl::apply(State& state, const VolumeFuseInodeCreated& event)
+{
+  if (state.inodes.count(event.ino)) {
+    return;
+  }
+
+  auto parent_iter = state.inodes.find(event.parent);
+  if (parent_iter == state.inodes.end() || !parent_iter->second->is_dir()) {
+    return;
+  }
+  Inode& parent = *parent_iter->second;
+
+  std::string name{event.name};
+  if (parent.children_by_name.count(name)) {
+    return;
+  }
+
+  std::unique_ptr<Inode> child = this->new_inode(event.ino, event.mode, event.uid, event.gid);
+  if (child->is_dir()) {
+    parent.entry.attr.st_nlink += 1;
+  }
+
+  const u64 offset = parent.next_dirent_offset;
+  parent.next_dirent_offset += 1;
+  parent.children_by_name.emplace(name, DirectoryEntry{event.ino, offset});
+  parent.children_by_offset.emplace(offset, std::move(name));
+  parent.entry.attr.st_mtim = child->entry.attr.st_mtim;
+  parent.entry.attr.st_ctim = child->entry.attr.st_ctim;
+
+  state.inodes.emplace(event.ino, std::move(child));
+  state.next_unused_ino = std::max<fuse_ino_t>(state.next_unused_ino, event.ino + 1);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeFuseImpl::apply(State& state, const VolumeFuseEntryRemoved& event)
+{
+  auto parent_iter = state.inodes.find(event.parent);
+  if (parent_iter == state.inodes.end()) {
+    return;
+  }
+  Inode& parent = *parent_iter->second;
+
+  auto entry_iter = parent.children_by_name.find(std::string{event.name});
+  if (entry_iter == parent.children_by_name.end() || entry_iter->second.ino != event.ino) {
+    return;
+  }
+  parent.children_by_offset.erase(entry_iter->second.offset);
+  parent.children_by_name.erase(entry_iter);
+  parent.entry.attr.st_mtim = current_time();
+  parent.entry.attr.st_ctim = parent.entry.attr.st_mtim;
+
+  auto child_iter = state.inodes.find(event.ino);
+  if (child_iter == state.inodes.end()) {
+    return;
+  }
+  Inode& child = *child_iter->second;
+
+  if (child.is_dir()) {
+    parent.entry.attr.st_nlink -= 1;
+  }
+  child.unlinked = true;
+  child.entry.attr.st_nlink = 0;
+
+  this->maybe_delete_inode(state, child);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeFuseImpl::apply(State& state, const PackedVolumeFuseAttributesSet& event)
+{
+  auto iter = state.inodes.find(event.ino);
+  if (iter == state.inodes.end()) {
+    return;
+  }
+  struct stat& attr = iter->second->entry.attr;
+
+  attr.st_mode = event.mode;
+  attr.st_uid = event.uid;
+  attr.st_gid = event.gid;
+  attr.st_atim = timespec_from_nsec(event.atime_nsec);
+  attr.st_mtim = timespec_from_nsec(event.mtime_nsec);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeFuseImpl::apply_blocks_written(State& state, fuse_ino_t ino, u64 file_size,
+                                          const batt::Slice<const PackedVolumeFuseBlockRef>& blocks)
+{
+  auto iter = state.inodes.find(ino);
+  if (iter == state.inodes.end() || iter->second->is_dir()) {
+    return;
+  }
+  Inode& inode = *iter->second;
+
+  const u64 block_count = (file_size + this->block_size_ - 1) / this->block_size_;
+
+  inode.blocks.erase(inode.blocks.lower_bound(block_count), inode.blocks.end());
+  for (const PackedVolumeFuseBlockRef& block_ref : blocks) {
+    if (block_ref.block_index < block_count) {
+      inode.blocks[block_ref.block_index] = block_ref.page_id.unpack();
+    }
+  }
+
+  inode.entry.attr.st_size = BATT_CHECKED_CAST(off_t, file_size);
+  inode.logged_size = file_size;
+  this->update_block_count(inode);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeFuseImpl::maybe_delete_inode(State& state, Inode& inode)
+{
+  if (inode.unlinked && inode.lookup_count == 0 && inode.open_count == 0) {
+    state.inodes.erase(inode.entry.ino);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename T>
+StatusOr<SlotRange> VolumeFuseImpl::append_event(State& state, const T& event,
+                                                 std::unique_ptr<PageCacheJob> job)
+{
+  if (state.bytes_since_checkpoint >= this->checkpoint_interval_) {
+    BATT_ASSIGN_OK_RESULT(const bool checkpointed, this->checkpoint_impl(state));
+    if (!checkpointed) {
+      // Try again after another half interval, rather than before every event.
+      //
+      state.bytes_since_checkpoint = this->checkpoint_interval_ / 2;
+    }
+  }
+  return this->append_event_impl(state, event, std::move(job));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename T>
+StatusOr<SlotRange> VolumeFuseImpl::append_event_impl(State& state, const T& event,
+                                                      std::unique_ptr<PageCacheJob> job,
+                                                      batt::Grant* grant)
+{
+  auto packable_event = pack_as_variant<VolumeFuseEvent>(event);
+
+  // Spends from `grant` if there is one; otherwise reserves (waiting if necessary).
+  //
+  Optional<batt::Grant> reserved;
+  const auto grant_for_size = [&](u64 size) -> StatusOr<batt::Grant*> {
+    if (grant != nullptr) {
+      return grant;
+    }
+    BATT_ASSIGN_OK_RESULT(batt::Grant new_grant,
+                          this->volume_->reserve(size, batt::WaitForResource::kTrue));
+    reserved.emplace(std::move(new_grant));
+    return &*reserved;
+  };
+
+  StatusOr<SlotRange> slot_range = [&]() -> StatusOr<SlotRange> {
+    if (!job) {
+      BATT_ASSIGN_OK_RESULT(batt::Grant * event_grant,
+                            grant_for_size(this->volume_->calculate_grant_size(packable_event)));
+
+      return this->volume_->append(packable_event, *event_grant);
+    }
+
+    BATT_ASSIGN_OK_RESULT(AppendableJob appendable_job,
+                          make_appendable_job(std::move(job), PackableRef{packable_event}));
+
+    BATT_ASSIGN_OK_RESULT(batt::Grant * event_grant,
+                          grant_for_size(this->volume_->calculate_grant_size(appendable_job)));
+
+    return this->volume_->append(std::move(appendable_job), *event_grant);
+  }();
+
+  BATT_REQUIRE_OK(slot_range);
+
+  state.bytes_since_checkpoint += slot_range->size();
+
+  return slot_range;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeFuseImpl::flush_inode(State& state, Inode& inode)
+{
+  // The data of an unlinked file only lives until it is closed, so there is no need to write it.
+  //
+  if (inode.unlinked || (inode.dirty_blocks.empty() && !inode.size_dirty)) {
+    return OkStatus();
+  }
+
+  do {
+    std::unique_ptr<PageCacheJob> job = this->volume_->new_job();
+
+    VolumeFuseBlocksWritten event{
+        .ino = inode.entry.ino,
+        .file_size = inode.file_size(),
+        .blocks = {},
+    };
+
+    auto iter = inode.dirty_blocks.begin();
+    for (; iter != inode.dirty_blocks.end() && event.blocks.size() < kMaxBlocksPerEvent; ++iter) {
+      // Don't wait for pages to be freed; they are only freed by trimming the log, which may be
+      // waiting for this request.
+      //
+      StatusOr<std::shared_ptr<PageBuffer>> page_buffer = job->new_page(
+          this->options_.page_size, batt::WaitForResource::kFalse,
+          OpaquePageView::page_layout_id(), Caller::Unknown, /*cancel_token=*/None);
+
+      if (!page_buffer.ok()) {
+        LLFS_LOG_WARNING() << "Failed to allocate a page for file data;"
+                           << BATT_INSPECT(page_buffer.status());
+        return batt::status_from_errno(ENOSPC);
+      }
+
+      const PageId page_id = (*page_buffer)->page_id();
+      const MutableBuffer payload = (*page_buffer)->mutable_payload();
+
+      BATT_CHECK_EQ(payload.size(), this->block_size_);
+      std::memcpy(payload.data(), iter->second->data(), this->block_size_);
+
+      BATT_REQUIRE_OK(job->pin_new(std::make_shared<OpaquePageView>(std::move(*page_buffer)),
+                                   Caller::Unknown));
+
+      event.blocks.emplace_back(PackedVolumeFuseBlockRef{
+          .block_index = iter->first,
+          .page_id = PackedPageId::from(page_id),
+      });
+    }
+
+    BATT_REQUIRE_OK(this->append_event(state, event, std::move(job)));
+
+    this->apply_blocks_written(state, event.ino, event.file_size, batt::as_slice(event.blocks));
+    inode.dirty_blocks.erase(inode.dirty_blocks.begin(), iter);
+
+  } while (!inode.dirty_blocks.empty());
+
+  inode.size_dirty = false;
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::vector<char>*> VolumeFuseImpl::get_dirty_block(Inode& inode, u64 block_index,
+                                                             bool load)
+{
+  auto iter = inode.dirty_blocks.find(block_index);
+  if (iter != inode.dirty_blocks.end()) {
+    // The use count can only go down while we hold the state lock, so if no reader has the block
+    // now, none will until we release the lock.
+    //
+    DirtyBlock& block = iter->second;
+    if (block.use_count() > 1) {
+      block = std::make_shared<std::vector<char>>(*block);
+    }
+    return block.get();
+  }
+
+  auto block = std::make_shared<std::vector<char>>(this->block_size_, '\0');
+
+  if (load) {
+    auto page_iter = inode.blocks.find(block_index);
+    if (page_iter != inode.blocks.end()) {
+      BATT_ASSIGN_OK_RESULT(PinnedPage page, this->volume_->cache().get_page(
+                                                 page_iter->second, OkIfNotFound{false}));
+
+      const ConstBuffer payload = page.const_payload();
+      std::memcpy(block->data(), payload.data(), std::min(payload.size(), this->block_size_));
+    }
+  }
+
+  iter = inode.dirty_blocks.emplace(block_index, std::move(block)).first;
+  return iter->second.get();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename Fn>
+Status VolumeFuseImpl::for_each_checkpoint_event(State& state, Fn&& fn)
+{
+  const auto visit_inode_blocks = [&](Inode& inode) -> Status {
+    if (inode.is_dir() || (inode.blocks.empty() && inode.logged_size == 0)) {
+      return OkStatus();
+    }
+    auto iter = inode.blocks.begin();
+    do {
+      VolumeFuseBlocksWritten event{
+          .ino = inode.entry.ino,
+          .file_size = inode.logged_size,
+          .blocks = {},
+      };
+      for (; iter != inode.blocks.end() && event.blocks.size() < kMaxBlocksPerEvent; ++iter) {
+        event.blocks.emplace_back(PackedVolumeFuseBlockRef{
+            .block_index = iter->first,
+            .page_id = PackedPageId::from(iter->second),
+        });
+      }
+      // The (empty) job re-references the pages, so that they outlive the trimmed slots.
+      //
+      BATT_REQUIRE_OK(fn(event, /*with_job=*/true));
+
+    } while (iter != inode.blocks.end());
+
+    return OkStatus();
+  };
+
+  // Walk the namespace top-down, so that every directory is created before its entries.
+  //
+  std::deque<fuse_ino_t> queue{FUSE_ROOT_ID};
+  while (!queue.empty()) {
+    const fuse_ino_t ino = queue.front();
+    queue.pop_front();
+
+    BATT_ASSIGN_OK_RESULT(Inode * inode, this->find_inode(state, ino));
+
+    BATT_REQUIRE_OK(fn(make_attributes_set_event(ino, inode->entry.attr), /*with_job=*/false));
+
+    BATT_REQUIRE_OK(visit_inode_blocks(*inode));
+
+    for (const auto& [name, dirent] : inode->children_by_name) {
+      BATT_ASSIGN_OK_RESULT(Inode * child, this->find_inode(state, dirent.ino));
+
+      BATT_REQUIRE_OK(fn(
+          VolumeFuseInodeCreated{
+              .ino = dirent.ino,
+              .parent = ino,
+              .mode = child->entry.attr.st_mode,
+              .uid = child->entry.attr.st_uid,
+              .gid = child->entry.attr.st_gid,
+              .name = name,
+          },
+          /*with_job=*/false));
+
+      queue.push_back(dirent.ino);
+    }
+  }
+
+  // Files that are unlinked but still open are ignored by replay; their pages must stay live
+  // until they are closed.
+  //
+  for (const auto& [ino, inode] : state.inodes) {
+    if (inode->unlinked) {
+      BATT_REQUIRE_OK(visit_inode_blocks(*inode));
+    }
+  }
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<bool> VolumeFuseImpl::checkpoint_impl(State& state)
+{
+  LLFS_VLOG(1) << "VolumeFuseImpl::checkpoint_impl();"
+               << BATT_INSPECT(state.bytes_since_checkpoint);
+
+  // Everything before this point is superseded by the events appended below.
+  //
+  const slot_offset_type checkpoint_lower_bound =
+      this->volume_->root_log().slot_range(LogReadMode::kSpeculative).upper_bound;
+
+  // Reserve all the log space the checkpoint needs up front, without waiting.  The caller holds
+  // the state lock, and when the log is full, only the trim at the end of a checkpoint frees
+  // space; waiting here would block every file system operation forever.
+  //
+  u64 grant_size = 0;
+  BATT_REQUIRE_OK(
+      this->for_each_checkpoint_event(state, [&](const auto& event, bool with_job) -> Status {
+        auto packable_event = pack_as_variant<VolumeFuseEvent>(event);
+        if (!with_job) {
+          grant_size += this->volume_->calculate_grant_size(packable_event);
+          return OkStatus();
+        }
+        BATT_ASSIGN_OK_RESULT(
+            AppendableJob appendable_job,
+            make_appendable_job(this->volume_->new_job(), PackableRef{packable_event}));
+
+        grant_size += this->volume_->calculate_grant_size(appendable_job);
+        return OkStatus();
+      }));
+
+  StatusOr<batt::Grant> grant =
+      this->volume_->reserve(grant_size, batt::WaitForResource::kFalse);
+  if (!grant.ok()) {
+    LLFS_LOG_WARNING() << "Not enough log space for a checkpoint;" << BATT_INSPECT(grant_size)
+                       << BATT_INSPECT(grant.status());
+    return false;
+  }
+
+  BATT_REQUIRE_OK(
+      this->for_each_checkpoint_event(state, [&](const auto& event, bool with_job) -> Status {
+        return this
+            ->append_event_impl(state, event, with_job ? this->volume_->new_job() : nullptr,
+                                &*grant)
+            .status();
+      }));
+
+  // The checkpoint must be durable before the slots it replaces can be trimmed.
+  //
+  const slot_offset_type checkpoint_upper_bound =
+      this->volume_->root_log().slot_range(LogReadMode::kSpeculative).upper_bound;
+
+  BATT_REQUIRE_OK(this->await_durable(checkpoint_upper_bound));
+
+  BATT_REQUIRE_OK(this->volume_->trim(checkpoint_lower_bound));
+
+  state.bytes_since_checkpoint = 0;
+
+  return true;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeFuseImpl::await_durable(slot_offset_type slot_upper_bound)
+{
+  StatusOr<SlotRange> synced =
+      this->volume_->sync(LogReadMode::kDurable, SlotUpperBoundAt{.offset = slot_upper_bound});
+
+  BATT_REQUIRE_OK(synced);
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeFuseImpl::sync()
+{
+  slot_offset_type slot_upper_bound;
+  {
+    auto locked = this->state_.lock();
+
+    for (auto& [ino, inode] : locked->inodes) {
+      BATT_REQUIRE_OK(this->flush_inode(*locked, *inode));
+    }
+    slot_upper_bound = this->volume_->root_log().slot_range(LogReadMode::kSpeculative).upper_bound;
+  }
+  return this->await_durable(slot_upper_bound);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeFuseImpl::checkpoint()
+{
+  auto locked = this->state_.lock();
+
+  BATT_ASSIGN_OK_RESULT(const bool checkpointed, this->checkpoint_impl(*locked));
+  if (!checkpointed) {
+    return batt::status_from_errno(ENOSPC);
+  }
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeFuseImpl::init()
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeFuseImpl::destroy()
+{
+  Status status = this->sync();
+  if (!status.ok()) {
+    LLFS_LOG_WARNING() << "VolumeFuseImpl::destroy() failed to sync;" << BATT_INSPECT(status);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+batt::StatusOr<const fuse_entry_param*> VolumeFuseImpl::lookup(fuse_req_t req, fuse_ino_t parent,
+                                                               const std::string_view& name)
+{
+  auto locked = this->state_.lock();
+
+  BATT_ASSIGN_OK_RESULT(Inode * parent_inode, this->find_inode(*locked, parent));
+  if (!parent_inode->is_dir()) {
+    return {batt::status_from_errno(ENOTDIR)};
+  }
+
+  auto iter = parent_inode->children_by_name.find(std::string{name});
+  if (iter == parent_inode->children_by_name.end()) {
+    return {batt::status_from_errno(ENOENT)};
+  }
+
+  BATT_ASSIGN_OK_RESULT(Inode * inode, this->find_inode(*locked, iter->second.ino));
+  inode->lookup_count += 1;
+
+  return {&inode->entry};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeFuseImpl::forget_inode(fuse_req_t req, fuse_ino_t ino, uint64_t nlookup)
+{
+  auto locked = this->state_.lock();
+
+  StatusOr<Inode*> inode = this->find_inode(*locked, ino);
+  if (!inode.ok()) {
+    return;
+  }
+
+  (*inode)->lookup_count -= std::min((*inode)->lookup_count, nlookup);
+  this->maybe_delete_inode(*locked, **inode);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+batt::StatusOr<FuseImplBase::Attributes> VolumeFuseImpl::get_attributes(fuse_req_t req,
+                                                                        fuse_ino_t ino)
+{
+  auto locked = this->state_.lock();
+
+  BATT_ASSIGN_OK_RESULT(Inode * inode, this->find_inode(*locked, ino));
+
+  return {FuseImplBase::Attributes{
+      .attr = &inode->entry.attr,
+      .timeout_sec = 1.0,
+  }};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+batt::StatusOr<FuseImplBase::Attributes> VolumeFuseImpl::set_attributes(
+    fuse_req_t req, fuse_ino_t ino, const struct stat* attr, int to_set,
+    batt::Optional<FuseFileHandle> fh)
+{
+  auto locked = this->state_.lock();
+
+  BATT_ASSIGN_OK_RESULT(Inode * inode, this->find_inode(*locked, ino));
+
+  if (to_set & FUSE_SET_ATTR_SIZE) {
+    if (inode->is_dir()) {
+      return {batt::status_from_errno(EISDIR)};
+    }
+
+    const u64 old_size = inode->file_size();
+    const u64 new_size = BATT_CHECKED_CAST(u64, attr->st_size);
+
+    if (new_size < old_size) {
+      // Drop the data past the new end of file, and zero the rest of the last block, so that it
+      // reads back as zeros if the file grows again.
+      //
+      const u64 block_count = (new_size + this->block_size_ - 1) / this->block_size_;
+
+      inode->dirty_blocks.erase(inode->dirty_blocks.lower_bound(block_count),
+                                inode->dirty_blocks.end());
+
+      const usize tail_offset = new_size % this->block_size_;
+      if (tail_offset != 0) {
+        BATT_ASSIGN_OK_RESULT(
+            std::vector<char>* block,
+            this->get_dirty_block(*inode, new_size / this->block_size_, /*load=*/true));
+
+        std::memset(block->data() + tail_offset, 0, this->block_size_ - tail_offset);
+      }
+    }
+
+    if (new_size != old_size) {
+      inode->entry.attr.st_size = BATT_CHECKED_CAST(off_t, new_size);
+      inode->size_dirty = true;
+      inode->entry.attr.st_mtim = current_time();
+      inode->entry.attr.st_ctim = inode->entry.attr.st_mtim;
+      this->update_block_count(*inode);
+    }
+
+    // A truncation is logged right away, so that the dropped blocks can't come back if the file
+    // grows again before the next flush.
+    //
+    if (new_size < old_size) {
+      BATT_REQUIRE_OK(this->flush_inode(*locked, *inode));
+    }
+  }
+
+  struct stat new_attr = inode->entry.attr;
+  bool attr_changed = false;
+
+  if (to_set & FUSE_SET_ATTR_MODE) {
+    new_attr.st_mode = (new_attr.st_mode & S_IFMT) | (attr->st_mode & ~S_IFMT);
+    attr_changed = true;
+  }
+  if (to_set & FUSE_SET_ATTR_UID) {
+    new_attr.st_uid = attr->st_uid;
+    attr_changed = true;
+  }
+  if (to_set & FUSE_SET_ATTR_GID) {
+    new_attr.st_gid = attr->st_gid;
+    attr_changed = true;
+  }
+  if (to_set & FUSE_SET_ATTR_ATIME_NOW) {
+    new_attr.st_atim = current_time();
+    attr_changed = true;
+  } else if (to_set & FUSE_SET_ATTR_ATIME) {
+    new_attr.st_atim = attr->st_atim;
+    attr_changed = true;
+  }
+  if (to_set & FUSE_SET_ATTR_MTIME_NOW) {
+    new_attr.st_mtim = current_time();
+    attr_changed = true;
+  } else if (to_set & FUSE_SET_ATTR_MTIME) {
+    new_attr.st_mtim = attr->st_mtim;
+    attr_changed = true;
+  }
+
+  if (attr_changed) {
+    const PackedVolumeFuseAttributesSet event = make_attributes_set_event(ino, new_attr);
+
+    BATT_REQUIRE_OK(this->append_event(*locked, event));
+
+    this->apply(*locked, event);
+    inode->entry.attr.st_ctim = current_time();
+  }
+
+  return {FuseImplBase::Attributes{
+      .attr = &inode->entry.attr,
+      .timeout_sec = 1.0,
+  }};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+batt::StatusOr<const fuse_entry_param*> VolumeFuseImpl::make_directory(fuse_req_t req,
+                                                                       fuse_ino_t parent,
+                                                                       const std::string_view& name,
+                                                                       mode_t mode)
+{
+  return this->create_impl(req, parent, name, S_IFDIR | (mode & ~S_IFMT));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+batt::Status VolumeFuseImpl::unlink(fuse_req_t req, fuse_ino_t parent,
+                                    const std::string_view& name)
+{
+  return this->unlink_impl(parent, name, /*is_dir=*/false);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+batt::Status VolumeFuseImpl::remove_directory(fuse_req_t req, fuse_ino_t parent,
+                                              const std::string_view& name)
+{
+  return this->unlink_impl(parent, name, /*is_dir=*/true);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+batt::StatusOr<const fuse_file_info*> VolumeFuseImpl::open(fuse_req_t req, fuse_ino_t ino,
+                                                           const fuse_file_info& fi)
+{
+  auto locked = this->state_.lock();
+
+  BATT_ASSIGN_OK_RESULT(Inode * inode, this->find_inode(*locked, ino));
+
+  return this->open_impl(*locked, *inode, fi);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+batt::StatusOr<FuseImplBase::FuseReadData> VolumeFuseImpl::read(fuse_req_t req, fuse_ino_t ino,
+                                                                size_t size, FileOffset offset,
+                                                                FuseFileHandle fh)
+{
+  // Plan the read under the lock, then load the pages it needs without holding the lock.
+  //
+  struct Chunk {
+    usize block_offset;
+    usize size;
+    DirtyBlock dirty;
+    Optional<PageId> page_id;
+  };
+
+  std::vector<Chunk> chunks;
+  {
+    auto locked = this->state_.lock();
+
+    BATT_ASSIGN_OK_RESULT(Inode * inode, this->find_inode(*locked, ino));
+    if (inode->is_dir()) {
+      return {batt::status_from_errno(EISDIR)};
+    }
+
+    const u64 begin = BATT_CHECKED_CAST(u64, offset.value());
+    const u64 end = std::min<u64>(begin + size, inode->file_size());
+
+    for (u64 pos = begin; pos < end;) {
+      const u64 block_index = pos / this->block_size_;
+      const usize block_offset = pos % this->block_size_;
+      const usize n = std::min<u64>(end - pos, this->block_size_ - block_offset);
+
+      Chunk chunk{
+          .block_offset = block_offset,
+          .size = n,
+          .dirty = nullptr,
+          .page_id = None,
+      };
+
+      auto dirty_iter = inode->dirty_blocks.find(block_index);
+      if (dirty_iter != inode->dirty_blocks.end()) {
+        chunk.dirty = dirty_iter->second;
+      } else {
+        auto page_iter = inode->blocks.find(block_index);
+        if (page_iter != inode->blocks.end()) {
+          chunk.page_id = page_iter->second;
+        }
+      }
+      chunks.emplace_back(std::move(chunk));
+
+      pos += n;
+    }
+  }
+
+  std::vector<batt::ConstBuffer> buffers;
+  std::vector<std::shared_ptr<const void>> refs;
+  std::vector<PinnedPage> pinned_pages;
+
+  for (Chunk& chunk : chunks) {
+    if (chunk.dirty) {
+      buffers.emplace_back(chunk.dirty->data() + chunk.block_offset, chunk.size);
+      refs.emplace_back(std::move(chunk.dirty));
+
+    } else if (chunk.page_id) {
+      BATT_ASSIGN_OK_RESULT(PinnedPage page,
+                            this->volume_->cache().get_page(*chunk.page_id, OkIfNotFound{false}));
+
+      const ConstBuffer payload = page.const_payload();
+      buffers.emplace_back(static_cast<const char*>(payload.data()) + chunk.block_offset,
+                           chunk.size);
+      pinned_pages.emplace_back(std::move(page));
+
+    } else {
+      buffers.emplace_back(this->zero_block_.data() + chunk.block_offset, chunk.size);
+    }
+  }
+
+  // Keep the pages pinned and hold a reference to the dirty blocks until the reply has been sent.
+  //
+  auto buffers_slice = batt::as_slice(buffers);
+  return {FuseImplBase::FuseReadData{FuseImplBase::with_cleanup(
+      buffers_slice, [buffers = std::move(buffers), refs = std::move(refs),
+                      pinned_pages = std::move(pinned_pages)](auto&&...) {
+      })}};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+batt::Status VolumeFuseImpl::flush(fuse_req_t req, fuse_ino_t ino, FuseFileHandle fh)
+{
+  auto locked = this->state_.lock();
+
+  BATT_ASSIGN_OK_RESULT(Inode * inode, this->find_inode(*locked, ino));
+
+  return this->flush_inode(*locked, *inode);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+batt::Status VolumeFuseImpl::release(fuse_req_t req, fuse_ino_t ino, FuseFileHandle fh,
+                                     FileOpenFlags flags)
+{
+  auto locked = this->state_.lock();
+
+  auto handle_iter = locked->file_handles.find(fh.value());
+  if (handle_iter == locked->file_handles.end()) {
+    LLFS_VLOG(1) << "Bad fh: " << fh;
+    return {batt::status_from_errno(EINVAL)};
+  }
+  const fuse_ino_t handle_ino = handle_iter->second->ino;
+  locked->file_handles.erase(handle_iter);
+
+  BATT_ASSIGN_OK_RESULT(Inode * inode, this->find_inode(*locked, handle_ino));
+
+  // Close the handle even if the flush fails.
+  //
+  Status flush_status = this->flush_inode(*locked, *inode);
+
+  inode->open_count -= 1;
+  this->maybe_delete_inode(*locked, *inode);
+
+  return flush_status;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+batt::Status VolumeFuseImpl::fsync(fuse_req_t req, fuse_ino_t ino, IsDataSync datasync,
+                                   FuseFileHandle fh)
+{
+  slot_offset_type slot_upper_bound;
+  {
+    auto locked = this->state_.lock();
+
+    BATT_ASSIGN_OK_RESULT(Inode * inode, this->find_inode(*locked, ino));
+    BATT_REQUIRE_OK(this->flush_inode(*locked, *inode));
+
+    slot_upper_bound = this->volume_->root_log().slot_range(LogReadMode::kSpeculative).upper_bound;
+  }
+  return this->await_durable(slot_upper_bound);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+batt::StatusOr<FuseImplBase::FuseCreateReply> VolumeFuseImpl::create(fuse_req_t req,
+                                                                     fuse_ino_t parent,
+                                                                     const std::string_view& name,
+                                                                     mode_t mode,
+                                                                     const fuse_file_info& fi)
+{
+  BATT_ASSIGN_OK_RESULT(const fuse_entry_param* entry,
+                        this->create_impl(req, parent, name, S_IFREG | (mode & ~S_IFMT)));
+
+  auto locked = this->state_.lock();
+
+  BATT_ASSIGN_OK_RESULT(Inode * inode, this->find_inode(*locked, entry->ino));
+  BATT_ASSIGN_OK_RESULT(const fuse_file_info* file_info, this->open_impl(*locked, *inode, fi));
+
+  return {FuseImplBase::FuseCreateReply{
+      .entry = entry,
+      .fi = file_info,
+  }};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<const fuse_entry_param*> VolumeFuseImpl::create_impl(fuse_req_t req, fuse_ino_t parent,
+                                                              const std::string_view& name,
+                                                              mode_t mode)
+{
+  auto locked = this->state_.lock();
+
+  BATT_ASSIGN_OK_RESULT(Inode * parent_inode, this->find_inode(*locked, parent));
+  if (!parent_inode->is_dir()) {
+    return {batt::status_from_errno(ENOTDIR)};
+  }
+  if (name.size() > NAME_MAX) {
+    return {batt::status_from_errno(ENAMETOOLONG)};
+  }
+  if (parent_inode->children_by_name.count(std::string{name})) {
+    return {batt::status_from_errno(EEXIST)};
+  }
+
+  const fuse_ctx* ctx = req ? fuse_req_ctx(req) : nullptr;
+
+  const VolumeFuseInodeCreated event{
+      .ino = locked->next_unused_ino,
+      .parent = parent,
+      .mode = mode,
+      .uid = ctx ? ctx->uid : getuid(),
+      .gid = ctx ? ctx->gid : getgid(),
+      .name = name,
+  };
+
+  BATT_REQUIRE_OK(this->append_event(*locked, event));
+
+  this->apply(*locked, event);
+
+  BATT_ASSIGN_OK_RESULT(Inode * inode, this->find_inode(*locked, event.ino));
+  inode->lookup_count += 1;
+
+  return {&inode->entry};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<const fuse_file_info*> VolumeFuseImpl::open_impl(State& state, Inode& inode,
+                                                          const fuse_file_info& fi)
+{
+  const u64 fh = state.next_unused_fh;
+  state.next_unused_fh += 1;
+
+  auto handle = std::make_unique<FileHandle>(FileHandle{
+      .info = fi,
+      .ino = inode.entry.ino,
+  });
+  handle->info.fh = fh;
+
+  const fuse_file_info* info = &handle->info;
+  state.file_handles.emplace(fh, std::move(handle));
+  inode.open_count += 1;
+
+  return {info};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeFuseImpl::unlink_impl(fuse_ino_t parent, const std::string_view& name, bool is_dir)
+{
+  auto locked = this->state_.lock();
+
+  BATT_ASSIGN_OK_RESULT(Inode * parent_inode, this->find_inode(*locked, parent));
+  if (!parent_inode->is_dir()) {
+    return {batt::status_from_errno(ENOTDIR)};
+  }
+
+  auto iter = parent_inode->children_by_name.find(std::string{name});
+  if (iter == parent_inode->children_by_name.end()) {
+    return {batt::status_from_errno(ENOENT)};
+  }
+
+  BATT_ASSIGN_OK_RESULT(Inode * inode, this->find_inode(*locked, iter->second.ino));
+  if (is_dir) {
+    if (!inode->is_dir()) {
+      return {batt::status_from_errno(ENOTDIR)};
+    }
+    if (!inode->children_by_name.empty()) {
+      return {batt::status_from_errno(ENOTEMPTY)};
+    }
+  } else if (inode->is_dir()) {
+    return {batt::status_from_errno(EISDIR)};
+  }
+
+  const VolumeFuseEntryRemoved event{
+      .parent = parent,
+      .ino = inode->entry.ino,
+      .name = name,
+  };
+
+  BATT_REQUIRE_OK(this->append_event(*locked, event));
+
+  this->apply(*locked, event);
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<usize> VolumeFuseImpl::write_impl(fuse_ino_t ino,
+                                           const batt::Slice<const batt::ConstBuffer>& buffers,
+                                           FileOffset offset)
+{
+  auto locked = this->state_.lock();
+
+  BATT_ASSIGN_OK_RESULT(Inode * inode, this->find_inode(*locked, ino));
+  if (inode->is_dir()) {
+    return {batt::status_from_errno(EISDIR)};
+  }
+
+  const u64 begin = BATT_CHECKED_CAST(u64, offset.value());
+  u64 pos = begin;
+
+  for (const batt::ConstBuffer& buffer : buffers) {
+    batt::ConstBuffer src = buffer;
+    while (src.size() > 0) {
+      const u64 block_index = pos / this->block_size_;
+      const usize block_offset = pos % this->block_size_;
+      const usize n = std::min(src.size(), this->block_size_ - block_offset);
+
+      // Only a partial block write needs the old contents of the block.
+      //
+      const bool load = (n != this->block_size_);
+
+      BATT_ASSIGN_OK_RESULT(std::vector<char>* block,
+                            this->get_dirty_block(*inode, block_index, load));
+
+      std::memcpy(block->data() + block_offset, src.data(), n);
+
+      src += n;
+      pos += n;
+    }
+  }
+
+  if (pos > inode->file_size()) {
+    inode->entry.attr.st_size = BATT_CHECKED_CAST(off_t, pos);
+    inode->size_dirty = true;
+    this->update_block_count(*inode);
+  }
+  inode->entry.attr.st_mtim = current_time();
+  inode->entry.attr.st_ctim = inode->entry.attr.st_mtim;
+
+  if (inode->dirty_blocks.size() >= this->options_.max_dirty_blocks_per_inode) {
+    BATT_REQUIRE_OK(this->flush_inode(*locked, *inode));
+  }
+
+  return {pos - begin};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto VolumeFuseImpl::readdir_impl(fuse_req_t req, fuse_ino_t ino, size_t size,
+                                  DirentOffset offset, PlusApi plus_api)
+    -> StatusOr<FuseReadDirData>
+{
+  std::unique_ptr<char[]> storage{new (std::nothrow) char[size]};
+  if (!storage) {
+    return {batt::status_from_errno(ENOMEM)};
+  }
+
+  batt::ConstBuffer out_buf{storage.get(), 0u};
+  batt::MutableBuffer dst_buf{storage.get(), size};
+
+  {
+    auto locked = this->state_.lock();
+
+    BATT_ASSIGN_OK_RESULT(Inode * inode, this->find_inode(*locked, ino));
+    if (!inode->is_dir()) {
+      return {batt::status_from_errno(ENOTDIR)};
+    }
+
+    // Each entry's next offset is its own (unique, increasing) offset, so that resuming after an
+    // entry works even if entries before it have been removed.
+    //
+    auto iter = inode->children_by_offset.upper_bound(BATT_CHECKED_CAST(u64, offset.value()));
+    for (; iter != inode->children_by_offset.end(); ++iter) {
+      const auto& [next_offset, name] = *iter;
+
+      auto child_iter = locked->inodes.find(inode->children_by_name.at(name).ino);
+      BATT_CHECK(child_iter != locked->inodes.end());
+      Inode& child = *child_iter->second;
+
+      const usize size_needed = [&] {
+        if (plus_api) {
+          const fuse_entry_param entry = this->entry_with_cache_options(child.entry);
+          return fuse_add_direntry_plus(req, static_cast<char*>(dst_buf.data()), dst_buf.size(),
+                                        name.c_str(), &entry, next_offset);
+        } else {
+          return fuse_add_direntry(req, static_cast<char*>(dst_buf.data()), dst_buf.size(),
+                                   name.c_str(), &child.entry.attr, next_offset);
+        }
+      }();
+
+      if (size_needed > dst_buf.size()) {
+        break;
+      }
+
+      // The lookup count of every entry returned by readdirplus (except "." and "..") is
+      // incremented by one.
+      //
+      if (plus_api) {
+        child.lookup_count += 1;
+      }
+
+      out_buf = batt::ConstBuffer{out_buf.data(), out_buf.size() + size_needed};
+      dst_buf += size_needed;
+    }
+  }
+
+  return {FuseReadDirData{FuseImplBase::OwnedConstBuffer{std::move(storage), out_buf}}};
+}
+
+}  // namespace llfs
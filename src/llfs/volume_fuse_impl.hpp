@@ -0,0 +1,567 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_VOLUME_FUSE_IMPL_HPP
+#define LLFS_VOLUME_FUSE_IMPL_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/fuse.hpp>
+#include <llfs/page_cache_job.hpp>
+#include <llfs/page_size.hpp>
+#include <llfs/slot.hpp>
+#include <llfs/volume.hpp>
+#include <llfs/volume_fuse_events.hpp>
+#include <llfs/worker_task_fuse_impl.hpp>
+
+#include <batteries/async/mutex.hpp>
+#include <batteries/suppress.hpp>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace llfs {
+
+BATT_SUPPRESS_IF_GCC("-Wunused-parameter")
+
+/** \brief Configuration for VolumeFuseImpl.
+ */
+struct VolumeFuseImplOptions {
+  /** \brief The size of the pages that hold file data.  Each page holds one file block, so the
+   * file system block size is PageBuffer::max_payload_size(page_size).  The Volume's PageCache must
+   * have an arena of pages of this size.
+   */
+  PageSize page_size{4096};
+
+  /** \brief When an inode has this many dirty (not yet written) blocks, the write that dirtied the
+   * last one writes them all out.
+   */
+  usize max_dirty_blocks_per_inode = 256;
+
+  /** \brief The number of root log bytes appended between checkpoints; 0 means a quarter of the
+   * root log capacity.
+   */
+  u64 checkpoint_interval = 0;
+
+  /** \brief The kernel cache timeouts; replies are made with a 1 second timeout by default.  Since
+   * all changes to the file system go through the kernel, long timeouts are safe here.
+   */
+  FuseCacheOptions cache;
+
+  /** \brief The connection parameters to negotiate with the kernel (e.g., a larger max_write, or
+   * the writeback cache, to get fewer and larger writes).
+   */
+  FuseConnectionOptions connection;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A persistent FuseImpl that stores a file system in an LLFS Volume.
+ *
+ * Inodes and directory entries are recorded as events in the Volume root log (see
+ * volume_fuse_events.hpp), and file data lives in PageCache pages: each page holds one block of
+ * one file.  The whole namespace, plus the page id of every file block, is kept in memory and is
+ * rebuilt at mount time by replaying the log (see `recover`).
+ *
+ * Writes are buffered per inode as dirty blocks.  The dirty blocks of an inode are written out
+ * together, as new pages in one PageCacheJob that is committed with the
+ * PackedVolumeFuseBlocksWritten event that maps them into the file, when the file is
+ * flushed/fsync'ed/released or when it has `max_dirty_blocks_per_inode` dirty blocks.  fsync
+ * additionally waits for the log to be durable.
+ *
+ * A page stays live for as long as some slot in the log refers to it.  To bound the size of the
+ * log (and to free overwritten pages), every `checkpoint_interval` bytes the current state is
+ * appended again (as a minimal sequence of events, re-referencing all live pages) and the log is
+ * trimmed up to the start of the checkpoint.  Event replay is idempotent and tolerates events for
+ * inodes it doesn't know, so recovery is correct no matter how much of the log before the
+ * checkpoint has actually been trimmed.
+ *
+ * All requests are serialized by a single mutex, except for the loading of pages by `read`.  Hard
+ * links, rename, symbolic links, device nodes and extended attributes are not supported.
+ */
+class VolumeFuseImpl : public WorkerTaskFuseImpl<VolumeFuseImpl>
+{
+ public:
+  using Super = WorkerTaskFuseImpl<VolumeFuseImpl>;
+
+  /** \brief The maximum number of block refs in one PackedVolumeFuseBlocksWritten event.
+   */
+  static constexpr usize kMaxBlocksPerEvent = 128;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Creates a VolumeFuseImpl for the file system stored in `volume`, by replaying the
+   * events in its root log.  An empty Volume holds an empty file system.
+   */
+  static StatusOr<std::unique_ptr<VolumeFuseImpl>> recover(
+      std::shared_ptr<WorkQueue>&& work_queue, std::unique_ptr<Volume>&& volume,
+      const VolumeFuseImplOptions& options = VolumeFuseImplOptions{});
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  explicit VolumeFuseImpl(std::shared_ptr<WorkQueue>&& work_queue,
+                          std::unique_ptr<Volume>&& volume,
+                          const VolumeFuseImplOptions& options) noexcept;
+
+  VolumeFuseImpl(const VolumeFuseImpl&) = delete;
+  VolumeFuseImpl& operator=(const VolumeFuseImpl&) = delete;
+
+  /** \brief Halts and joins the Volume.  Call `sync()` first to avoid losing buffered writes.
+   */
+  ~VolumeFuseImpl() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  Volume& volume() const noexcept
+  {
+    return *this->volume_;
+  }
+
+  /** \brief The number of file bytes stored in each page.
+   */
+  usize block_size() const noexcept
+  {
+    return this->block_size_;
+  }
+
+  /** \brief Writes out the dirty blocks of all inodes and waits for the root log to be durable.
+   */
+  Status sync();
+
+  /** \brief Appends the current state of the file system to the log and trims the log up to it.
+   * This happens automatically every `checkpoint_interval` bytes.  Fails with ENOSPC (and changes
+   * nothing) if the log doesn't have room for the checkpoint.
+   */
+  Status checkpoint();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief
+   */ // 1/44
+  void init();
+
+  /** \brief
+   */ // 2/44
+  void destroy();
+
+  /** \brief
+   */ // 3/44
+  batt::StatusOr<const fuse_entry_param*> lookup(fuse_req_t req, fuse_ino_t parent,
+                                                 const std::string_view& name);
+
+  /** \brief
+   */ // 4/44
+  void forget_inode(fuse_req_t req, fuse_ino_t ino, uint64_t nlookup);
+
+  /** \brief
+   */ // 5/44
+  batt::StatusOr<FuseImplBase::Attributes> get_attributes(fuse_req_t req, fuse_ino_t ino);
+
+  /** \brief
+   */ // 6/44
+  batt::StatusOr<FuseImplBase::Attributes> set_attributes(fuse_req_t req, fuse_ino_t ino,
+                                                          const struct stat* attr, int to_set,
+                                                          batt::Optional<FuseFileHandle> fh);
+
+  /** \brief
+   */ // 7/44
+  const char* readlink(fuse_req_t req, fuse_ino_t ino)
+  {
+    return "";
+  }
+
+  /** \brief
+   */ // 8/44
+  batt::StatusOr<const fuse_entry_param*> make_node(fuse_req_t req, fuse_ino_t parent,
+                                                    const std::string_view& name, mode_t mode,
+                                                    dev_t rdev)
+  {
+    return {batt::StatusCode::kUnimplemented};
+  }
+
+  /** \brief
+   */ // 9/44
+  batt::StatusOr<const fuse_entry_param*> make_directory(fuse_req_t req, fuse_ino_t parent,
+                                                         const std::string_view& name,
+                                                         mode_t mode);
+
+  /** \brief
+   */ // 10/44
+  batt::Status unlink(fuse_req_t req, fuse_ino_t parent, const std::string_view& name);
+
+  /** \brief
+   */ // 11/44
+  batt::Status remove_directory(fuse_req_t req, fuse_ino_t parent, const std::string_view& name);
+
+  /** \brief
+   */ // 12/44
+  batt::StatusOr<const fuse_entry_param*> symbolic_link(fuse_req_t req,
+                                                        const std::string_view& link,
+                                                        fuse_ino_t parent,
+                                                        const std::string_view& name)
+  {
+    return {batt::StatusCode::kUnimplemented};
+  }
+
+  /** \brief
+   */ // 13/44
+  batt::Status rename(fuse_req_t req, fuse_ino_t parent, const std::string_view& name,
+                      fuse_ino_t newparent, const std::string_view& newname, unsigned int flags)
+  {
+    return {batt::StatusCode::kUnimplemented};
+  }
+
+  /** \brief
+   */ // 14/44
+  batt::StatusOr<const fuse_entry_param*> hard_link(fuse_req_t req, fuse_ino_t ino,
+                                                    fuse_ino_t newparent,
+                                                    const std::string_view& newname)
+  {
+    return {batt::StatusCode::kUnimplemented};
+  }
+
+  /** \brief
+   */ // 15/44
+  batt::StatusOr<const fuse_file_info*> open(fuse_req_t req, fuse_ino_t ino,
+                                             const fuse_file_info& fi);
+
+  /** \brief
+   */ // 16/44
+  batt::StatusOr<FuseImplBase::FuseReadData> read(fuse_req_t req, fuse_ino_t ino, size_t size,
+                                                  FileOffset offset, FuseFileHandle fh);
+
+  /** \brief
+   */ // 17/44
+  batt::StatusOr<usize> write(fuse_req_t req, fuse_ino_t ino, const batt::ConstBuffer& buffer,
+                              FileOffset offset, FuseFileHandle fh)
+  {
+    return this->write_impl(ino, batt::as_slice(&buffer, 1), offset);
+  }
+
+  /** \brief
+   */ // 37/44
+  batt::StatusOr<usize> write_buf(fuse_req_t req, fuse_ino_t ino,
+                                  const FuseImplBase::ConstBufferVec& bufv, FileOffset offset,
+                                  FuseFileHandle fh)
+  {
+    return this->write_impl(ino, batt::as_slice(bufv), offset);
+  }
+
+  /** \brief
+   */ // 18/44
+  batt::Status flush(fuse_req_t req, fuse_ino_t ino, FuseFileHandle fh);
+
+  /** \brief
+   */ // 19/44
+  batt::Status release(fuse_req_t req, fuse_ino_t ino, FuseFileHandle fh, FileOpenFlags flags);
+
+  /** \brief
+   */ // 20/44
+  batt::Status fsync(fuse_req_t req, fuse_ino_t ino, IsDataSync datasync, FuseFileHandle fh);
+
+  /** \brief
+   */ // 21/44
+  batt::StatusOr<const fuse_file_info*> opendir(fuse_req_t req, fuse_ino_t ino,
+                                                const fuse_file_info& fi)
+  {
+    return this->open(req, ino, fi);
+  }
+
+  /** \brief
+   */ // 22/44
+  batt::StatusOr<FuseImplBase::FuseReadDirData> readdir(fuse_req_t req, fuse_ino_t ino, size_t size,
+                                                        DirentOffset offset, FuseFileHandle fh)
+  {
+    return this->readdir_impl(req, ino, size, offset, PlusApi{false});
+  }
+
+  /** \brief
+   */ // 23/44
+  batt::Status releasedir(fuse_req_t req, fuse_ino_t ino, FuseFileHandle fh)
+  {
+    return this->release(req, ino, fh, FileOpenFlags{0});
+  }
+
+  /** \brief
+   */ // 24/44
+  batt::Status fsyncdir(fuse_req_t req, fuse_ino_t ino, IsDataSync datasync, FuseFileHandle fh)
+  {
+    return this->fsync(req, ino, datasync, fh);
+  }
+
+  /** \brief
+   */ // 25/44
+  batt::StatusOr<const struct statvfs*> statfs(fuse_req_t req, fuse_ino_t ino)
+  {
+    return {batt::StatusCode::kUnimplemented};
+  }
+
+  /** \brief
+   */ // 26/44
+  batt::Status set_extended_attribute(fuse_req_t req, fuse_ino_t ino,
+                                      const FuseImplBase::ExtendedAttribute& attr, int flags)
+  {
+    return {batt::StatusCode::kUnimplemented};
+  }
+
+  /** \brief
+   */ // 27/44
+  batt::StatusOr<FuseImplBase::FuseGetExtendedAttributeReply> get_extended_attribute(
+      fuse_req_t req, fuse_ino_t ino, const std::string_view& name, size_t size)
+  {
+    return {batt::StatusCode::kUnimplemented};
+  }
+
+  /** \brief
+   */ // 29/44
+  batt::Status remove_extended_attribute(fuse_req_t req, fuse_ino_t ino,
+                                         const std::string_view& name)
+  {
+    return {batt::StatusCode::kUnimplemented};
+  }
+
+  /** \brief
+   */ // 30/44
+  batt::Status check_access(fuse_req_t req, fuse_ino_t ino, int mask)
+  {
+    return batt::OkStatus();
+  }
+
+  /** \brief
+   */ // 31/44
+  batt::StatusOr<FuseImplBase::FuseCreateReply> create(fuse_req_t req, fuse_ino_t parent,
+                                                       const std::string_view& name, mode_t mode,
+                                                       const fuse_file_info& fi);
+
+  /** \brief
+   */ // 35/44
+  batt::StatusOr<FuseImplBase::FuseIoctlReply> ioctl(fuse_req_t req, fuse_ino_t ino,
+                                                     unsigned int cmd, void* arg,
+                                                     struct fuse_file_info* fi, unsigned flags,
+                                                     const batt::ConstBuffer& in_buf,
+                                                     size_t out_bufsz)
+  {
+    return {batt::StatusCode::kUnimplemented};
+  }
+
+  /** \brief
+   */ // 38/44
+  void retrieve_reply(fuse_req_t req, void* cookie, fuse_ino_t ino, off_t offset,
+                      struct fuse_bufvec* bufv)
+  {
+  }
+
+  /** \brief
+   */ // 39/44
+  void forget_multiple_inodes(fuse_req_t req, batt::Slice<fuse_forget_data> forgets)
+  {
+    for (const fuse_forget_data& forget : forgets) {
+      this->forget_inode(req, forget.ino, forget.nlookup);
+    }
+  }
+
+  /** \brief
+   */ // 41/44
+  batt::Status file_allocate(fuse_req_t req, fuse_ino_t ino, int mode, FileOffset offset,
+                             FileLength length, fuse_file_info* fi)
+  {
+    return {batt::StatusCode::kUnimplemented};
+  }
+
+  /** \brief
+   */ // 42/44
+  batt::StatusOr<FuseImplBase::FuseReadDirData> readdirplus(fuse_req_t req, fuse_ino_t ino,
+                                                            size_t size, DirentOffset offset,
+                                                            FuseFileHandle fh)
+  {
+    return this->readdir_impl(req, ino, size, offset, PlusApi{true});
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  /** \brief The contents of one file block that hasn't been written to a page yet.  Reads hold a
+   * reference to the blocks they return until the reply is sent, so a write copies a dirty block
+   * that is shared before modifying it.
+   */
+  using DirtyBlock = std::shared_ptr<std::vector<char>>;
+
+  struct DirectoryEntry {
+    fuse_ino_t ino;
+    u64 offset;
+  };
+
+  struct Inode {
+    fuse_entry_param entry;
+
+    // (Directories only) The entries of the directory, by name and by readdir offset.  Offsets are
+    // assigned in increasing order as entries are added, so that a readdir in progress isn't
+    // disturbed by removals.
+    //
+    std::map<std::string, DirectoryEntry> children_by_name;
+    std::map<u64, std::string> children_by_offset;
+    u64 next_dirent_offset = 1;
+
+    // (Files only) The page holding each block that has been written, and the blocks that have
+    // been written since.
+    //
+    std::map<u64, PageId> blocks;
+    std::map<u64, DirtyBlock> dirty_blocks;
+
+    // The file size recorded by the last PackedVolumeFuseBlocksWritten event, and whether the
+    // file size changed since.
+    //
+    u64 logged_size = 0;
+    bool size_dirty = false;
+
+    // The number of kernel lookups and of open file handles; an unlinked inode is deleted when
+    // both reach zero.
+    //
+    u64 lookup_count = 0;
+    u64 open_count = 0;
+    bool unlinked = false;
+
+    //----- --- -- -  -  -   -
+
+    bool is_dir() const noexcept
+    {
+      return S_ISDIR(this->entry.attr.st_mode);
+    }
+
+    u64 file_size() const noexcept
+    {
+      return BATT_CHECKED_CAST(u64, this->entry.attr.st_size);
+    }
+  };
+
+  struct FileHandle {
+    fuse_file_info info;
+    fuse_ino_t ino;
+  };
+
+  struct State {
+    std::unordered_map<fuse_ino_t, std::unique_ptr<Inode>> inodes;
+    std::unordered_map<u64, std::unique_ptr<FileHandle>> file_handles;
+    fuse_ino_t next_unused_ino = FUSE_ROOT_ID + 1;
+    u64 next_unused_fh = 1;
+
+    // The number of root log bytes appended since the last checkpoint.
+    //
+    u64 bytes_since_checkpoint = 0;
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief Replays all the events in the root log.
+   */
+  Status replay_log();
+
+  /** \brief Returns the inode `ino`, or ENOENT.
+   */
+  StatusOr<Inode*> find_inode(State& state, fuse_ino_t ino);
+
+  /** \brief Allocates a new Inode object (not yet in the inode table).
+   */
+  std::unique_ptr<Inode> new_inode(fuse_ino_t ino, u32 mode, u32 uid, u32 gid) const;
+
+  /** \brief Updates the st_blocks of `inode` for its current size.
+   */
+  void update_block_count(Inode& inode) const;
+
+  // Apply an event to the in-memory state.  These are used both at recovery time and after
+  // appending a new event; they ignore events for inodes that don't exist, and applying an event
+  // twice has the same effect as applying it once.
+  //
+  void apply(State& state, const VolumeFuseInodeCreated& event);
+  void apply(State& state, const VolumeFuseEntryRemoved& event);
+  void apply(State& state, const PackedVolumeFuseAttributesSet& event);
+  void apply_blocks_written(State& state, fuse_ino_t ino, u64 file_size,
+                            const batt::Slice<const PackedVolumeFuseBlockRef>& blocks);
+
+  /** \brief Deletes `inode` from the inode table if it is unlinked and unreferenced.
+   */
+  void maybe_delete_inode(State& state, Inode& inode);
+
+  /** \brief Appends `event` to the root log, along with `job` if it is non-null (`job` is required
+   * iff the event refers to pages).  Checkpoints first if it is time to.
+   */
+  template <typename T>
+  StatusOr<SlotRange> append_event(State& state, const T& event,
+                                   std::unique_ptr<PageCacheJob> job = nullptr);
+
+  /** \brief Same as append_event, without the checkpoint check.  If `grant` is non-null, the log
+   * space is taken from it instead of being reserved.
+   */
+  template <typename T>
+  StatusOr<SlotRange> append_event_impl(State& state, const T& event,
+                                        std::unique_ptr<PageCacheJob> job,
+                                        batt::Grant* grant = nullptr);
+
+  /** \brief Writes all dirty blocks of `inode` to new pages, and records the file size.
+   */
+  Status flush_inode(State& state, Inode& inode);
+
+  /** \brief Returns a dirty block for block `block_index` of `inode` that isn't shared with any
+   * reader, loading the current contents of the block if `load` is true.
+   */
+  StatusOr<std::vector<char>*> get_dirty_block(Inode& inode, u64 block_index, bool load);
+
+  /** \brief Calls `fn(event, with_job)` for each event of a checkpoint of `state`, in log order;
+   * `with_job` is true for events that must be appended with a (empty) job, to keep the pages
+   * they refer to live.
+   */
+  template <typename Fn>
+  Status for_each_checkpoint_event(State& state, Fn&& fn);
+
+  /** \brief Appends the state of the file system to the log; see `checkpoint`.  Returns false,
+   * without appending anything, if the log space for the checkpoint can't be reserved right away.
+   */
+  StatusOr<bool> checkpoint_impl(State& state);
+
+  /** \brief Waits for the root log to be durable up to `slot_upper_bound`.
+   */
+  Status await_durable(slot_offset_type slot_upper_bound);
+
+  StatusOr<const fuse_entry_param*> create_impl(fuse_req_t req, fuse_ino_t parent,
+                                                const std::string_view& name, mode_t mode);
+
+  StatusOr<const fuse_file_info*> open_impl(State& state, Inode& inode, const fuse_file_info& fi);
+
+  Status unlink_impl(fuse_ino_t parent, const std::string_view& name, bool is_dir);
+
+  StatusOr<usize> write_impl(fuse_ino_t ino, const batt::Slice<const batt::ConstBuffer>& buffers,
+                             FileOffset offset);
+
+  StatusOr<FuseReadDirData> readdir_impl(fuse_req_t req, fuse_ino_t ino, size_t size,
+                                         DirentOffset offset, PlusApi plus_api);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const VolumeFuseImplOptions options_;
+
+  std::unique_ptr<Volume> volume_;
+
+  const usize block_size_;
+
+  const u64 checkpoint_interval_;
+
+  // One block of zeros, returned by `read` for the holes in a file.
+  //
+  const std::vector<char> zero_block_;
+
+  batt::Mutex<State> state_;
+};
+
+BATT_UNSUPPRESS_IF_GCC()
+
+}  //namespace llfs
+
+#endif  // LLFS_VOLUME_FUSE_IMPL_HPP
@@ -0,0 +1,362 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/volume_fuse_impl.hpp>
+//
+#include <llfs/volume_fuse_impl.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/testing/fake_log_device.hpp>
+
+#include <llfs/constants.hpp>
+#include <llfs/memory_log_device.hpp>
+#include <llfs/memory_page_cache.hpp>
+
+#include <batteries/async/runtime.hpp>
+
+#include <cstring>
+#include <string>
+#include <variant>
+
+namespace {
+
+// Test Plan:
+//  1. Files written (across several blocks, with partial overwrites) in a new directory read back
+//     as written, before and after the file system is recovered from its Volume.
+//  2. Truncation (followed by extension) and unlink are persistent; the truncated bytes read back
+//     as zeros.
+//  3. After a checkpoint (which trims the log), further changes and a recovery still produce the
+//     same file system.
+
+using namespace llfs::int_types;
+using namespace llfs::constants;
+
+constexpr usize kTestRootLogSize = 1 * kMiB;
+
+const llfs::PageSize kTestPageSize{512};
+
+class VolumeFuseImplTest : public ::testing::Test
+{
+ public:
+  void SetUp() override
+  {
+    llfs::StatusOr<batt::SharedPtr<llfs::PageCache>> page_cache_created =
+        llfs::make_memory_page_cache(batt::Runtime::instance().default_scheduler(),
+                                     /*arena_sizes=*/
+                                     {
+                                         {llfs::PageCount{64}, kTestPageSize},
+                                     },
+                                     this->max_refs_per_page);
+
+    ASSERT_TRUE(page_cache_created.ok());
+    this->page_cache = std::move(*page_cache_created);
+
+    this->root_log.emplace(kTestRootLogSize);
+    this->recycler_log.emplace(llfs::PageRecycler::calculate_log_size(
+        llfs::PageRecyclerOptions{}.set_max_refs_per_page(this->max_refs_per_page)));
+
+    this->open_fs();
+  }
+
+  void TearDown() override
+  {
+    this->fs = nullptr;
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /** \brief (Re-)opens the Volume and recovers this->fs from it.
+   */
+  void open_fs()
+  {
+    this->fs = nullptr;
+
+    this->fake_root_log_factory =  //
+        llfs::testing::make_fake_log_device_factory(*this->root_log);
+
+    this->fake_recycler_log_factory =  //
+        llfs::testing::make_fake_log_device_factory(*this->recycler_log);
+
+    llfs::StatusOr<std::unique_ptr<llfs::Volume>> volume = llfs::Volume::recover(
+        llfs::VolumeRecoverParams{
+            &batt::Runtime::instance().default_scheduler(),
+            llfs::VolumeOptions{
+                .name = "test_volume",
+                .uuid = llfs::None,
+                .max_refs_per_page = this->max_refs_per_page,
+                .trim_lock_update_interval = llfs::TrimLockUpdateInterval{0u},
+                .trim_delay_byte_count = llfs::TrimDelayByteCount{0},
+            },
+            this->page_cache,
+            /*root_log=*/&*this->fake_root_log_factory,
+            /*recycler_log=*/&*this->fake_recycler_log_factory,
+            nullptr,
+        },
+        /*slot_visitor_fn=*/[](const llfs::SlotParse&, const std::string_view& /*user_data*/) {
+          return llfs::OkStatus();
+        });
+
+    ASSERT_TRUE(volume.ok()) << BATT_INSPECT(volume.status());
+
+    llfs::StatusOr<std::unique_ptr<llfs::VolumeFuseImpl>> recovered =
+        llfs::VolumeFuseImpl::recover(std::make_shared<llfs::WorkQueue>(), std::move(*volume),
+                                      llfs::VolumeFuseImplOptions{
+                                          .page_size = kTestPageSize,
+                                          .max_dirty_blocks_per_inode = 4,
+                                          .checkpoint_interval = 0,
+                                      });
+
+    ASSERT_TRUE(recovered.ok()) << BATT_INSPECT(recovered.status());
+    this->fs = std::move(*recovered);
+  }
+
+  /** \brief Syncs and closes this->fs, then recovers it.
+   */
+  void reopen_fs()
+  {
+    ASSERT_TRUE(this->fs->sync().ok());
+    this->open_fs();
+  }
+
+  fuse_ino_t lookup(fuse_ino_t parent, const std::string_view& name)
+  {
+    llfs::StatusOr<const fuse_entry_param*> entry = this->fs->lookup(nullptr, parent, name);
+    if (!entry.ok()) {
+      return 0;
+    }
+    return (*entry)->ino;
+  }
+
+  fuse_ino_t make_directory(fuse_ino_t parent, const std::string_view& name)
+  {
+    llfs::StatusOr<const fuse_entry_param*> entry =
+        this->fs->make_directory(nullptr, parent, name, 0755);
+
+    BATT_CHECK_OK(entry);
+    return (*entry)->ino;
+  }
+
+  llfs::FuseImplBase::FuseCreateReply create(fuse_ino_t parent, const std::string_view& name)
+  {
+    fuse_file_info fi;
+    std::memset(&fi, 0, sizeof(fi));
+
+    llfs::StatusOr<llfs::FuseImplBase::FuseCreateReply> reply =
+        this->fs->create(nullptr, parent, name, S_IFREG | 0644, fi);
+
+    BATT_CHECK_OK(reply);
+    return *reply;
+  }
+
+  void write(fuse_ino_t ino, u64 offset, const std::string& data)
+  {
+    llfs::StatusOr<usize> n_written =
+        this->fs->write(nullptr, ino, batt::ConstBuffer{data.data(), data.size()},
+                        llfs::FileOffset(offset), llfs::FuseFileHandle{0});
+
+    ASSERT_TRUE(n_written.ok()) << BATT_INSPECT(n_written.status());
+    EXPECT_EQ(*n_written, data.size());
+  }
+
+  u64 file_size(fuse_ino_t ino)
+  {
+    llfs::StatusOr<llfs::FuseImplBase::Attributes> attributes =
+        this->fs->get_attributes(nullptr, ino);
+
+    BATT_CHECK_OK(attributes);
+    return attributes->attr->st_size;
+  }
+
+  std::string read_file(fuse_ino_t ino)
+  {
+    llfs::StatusOr<llfs::FuseImplBase::FuseReadData> data =
+        this->fs->read(nullptr, ino, this->file_size(ino) + 1000, llfs::FileOffset{0},
+                       llfs::FuseFileHandle{0});
+
+    BATT_CHECK_OK(data);
+
+    auto& buffers =
+        std::get<llfs::FuseImplBase::WithCleanup<batt::Slice<batt::ConstBuffer>>>(*data);
+
+    std::string contents;
+    for (const batt::ConstBuffer& buffer : buffers.value) {
+      contents.append(static_cast<const char*>(buffer.data()), buffer.size());
+    }
+    buffers.cleanup(buffers.value);
+
+    return contents;
+  }
+
+  static std::string make_data(usize size, char seed)
+  {
+    std::string data(size, '\0');
+    for (usize i = 0; i < size; ++i) {
+      data[i] = static_cast<char>(seed + i * 7 + i / 251);
+    }
+    return data;
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const llfs::MaxRefsPerPage max_refs_per_page{8};
+
+  batt::SharedPtr<llfs::PageCache> page_cache;
+
+  llfs::Optional<llfs::MemoryLogDevice> root_log;
+
+  llfs::Optional<llfs::MemoryLogDevice> recycler_log;
+
+  llfs::Optional<llfs::testing::FakeLogDeviceFactory<llfs::MemoryLogStorageDriver>>
+      fake_root_log_factory;
+
+  llfs::Optional<llfs::testing::FakeLogDeviceFactory<llfs::MemoryLogStorageDriver>>
+      fake_recycler_log_factory;
+
+  std::unique_ptr<llfs::VolumeFuseImpl> fs;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(VolumeFuseImplTest, WriteReadRecover)
+{
+  const usize block_size = this->fs->block_size();
+
+  const fuse_ino_t dir = this->make_directory(FUSE_ROOT_ID, "dir");
+  const llfs::FuseImplBase::FuseCreateReply created = this->create(dir, "file");
+  const fuse_ino_t file = created.entry->ino;
+
+  // More blocks than max_dirty_blocks_per_inode, so that some are written before the release.
+  //
+  std::string expected = make_data(block_size * 6 + 17, 'a');
+  this->write(file, 0, expected);
+
+  // A partial overwrite that spans a block boundary.
+  //
+  const std::string patch = make_data(100, 'z');
+  const u64 patch_offset = block_size * 2 - 40;
+  this->write(file, patch_offset, patch);
+  expected.replace(patch_offset, patch.size(), patch);
+
+  EXPECT_EQ(this->file_size(file), expected.size());
+  EXPECT_EQ(this->read_file(file), expected);
+
+  ASSERT_TRUE(this->fs->release(nullptr, file, llfs::FuseFileHandle{created.fi->fh},
+                                llfs::FileOpenFlags{0})
+                  .ok());
+
+  EXPECT_EQ(this->read_file(file), expected);
+
+  this->reopen_fs();
+
+  EXPECT_EQ(this->lookup(FUSE_ROOT_ID, "dir"), dir);
+  EXPECT_EQ(this->lookup(dir, "file"), file);
+  EXPECT_EQ(this->lookup(dir, "nope"), 0u);
+  EXPECT_EQ(this->file_size(file), expected.size());
+  EXPECT_EQ(this->read_file(file), expected);
+
+  // New inodes don't reuse recovered inode numbers.
+  //
+  const fuse_ino_t dir2 = this->make_directory(FUSE_ROOT_ID, "dir2");
+  EXPECT_GT(dir2, file);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(VolumeFuseImplTest, TruncateAndUnlink)
+{
+  const usize block_size = this->fs->block_size();
+
+  const fuse_ino_t file = this->create(FUSE_ROOT_ID, "file").entry->ino;
+  const fuse_ino_t doomed = this->create(FUSE_ROOT_ID, "doomed").entry->ino;
+
+  std::string expected = make_data(block_size * 3, 'q');
+  this->write(file, 0, expected);
+  this->write(doomed, 0, expected);
+  ASSERT_TRUE(this->fs->flush(nullptr, file, llfs::FuseFileHandle{0}).ok());
+
+  // Truncate to the middle of a block, then grow the file again.
+  //
+  struct stat attr;
+  std::memset(&attr, 0, sizeof(attr));
+
+  attr.st_size = block_size + 10;
+  ASSERT_TRUE(this->fs->set_attributes(nullptr, file, &attr, FUSE_SET_ATTR_SIZE, llfs::None).ok());
+
+  attr.st_size = block_size * 2;
+  ASSERT_TRUE(this->fs->set_attributes(nullptr, file, &attr, FUSE_SET_ATTR_SIZE, llfs::None).ok());
+
+  expected.resize(block_size + 10);
+  expected.resize(block_size * 2, '\0');
+
+  EXPECT_EQ(this->read_file(file), expected);
+
+  ASSERT_TRUE(this->fs->unlink(nullptr, FUSE_ROOT_ID, "doomed").ok());
+  EXPECT_EQ(this->lookup(FUSE_ROOT_ID, "doomed"), 0u);
+
+  // Removing a non-empty directory fails.
+  //
+  const fuse_ino_t dir = this->make_directory(FUSE_ROOT_ID, "dir");
+  this->make_directory(dir, "sub");
+  EXPECT_EQ(this->fs->remove_directory(nullptr, FUSE_ROOT_ID, "dir"),
+            batt::status_from_errno(ENOTEMPTY));
+  EXPECT_EQ(this->fs->unlink(nullptr, FUSE_ROOT_ID, "dir"), batt::status_from_errno(EISDIR));
+
+  this->reopen_fs();
+
+  EXPECT_EQ(this->read_file(file), expected);
+  EXPECT_EQ(this->lookup(FUSE_ROOT_ID, "doomed"), 0u);
+  EXPECT_NE(this->lookup(FUSE_ROOT_ID, "dir"), 0u);
+  EXPECT_NE(doomed, 0u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST_F(VolumeFuseImplTest, RecoverAfterCheckpoint)
+{
+  const usize block_size = this->fs->block_size();
+
+  const fuse_ino_t dir = this->make_directory(FUSE_ROOT_ID, "dir");
+  const fuse_ino_t file = this->create(dir, "file").entry->ino;
+  const fuse_ino_t gone = this->create(dir, "gone").entry->ino;
+
+  std::string expected = make_data(block_size * 2 + 5, 'k');
+  this->write(file, 0, expected);
+  ASSERT_TRUE(this->fs->sync().ok());
+
+  struct stat attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.st_mode = 0600;
+  ASSERT_TRUE(this->fs->set_attributes(nullptr, file, &attr, FUSE_SET_ATTR_MODE, llfs::None).ok());
+
+  ASSERT_TRUE(this->fs->checkpoint().ok());
+
+  // Changes after the checkpoint are replayed on top of it.
+  //
+  const std::string patch = make_data(10, 'p');
+  this->write(file, 3, patch);
+  expected.replace(3, patch.size(), patch);
+  ASSERT_TRUE(this->fs->unlink(nullptr, dir, "gone").ok());
+
+  this->reopen_fs();
+
+  EXPECT_EQ(this->lookup(FUSE_ROOT_ID, "dir"), dir);
+  EXPECT_EQ(this->lookup(dir, "file"), file);
+  EXPECT_EQ(this->lookup(dir, "gone"), 0u);
+  EXPECT_NE(gone, 0u);
+  EXPECT_EQ(this->read_file(file), expected);
+
+  llfs::StatusOr<llfs::FuseImplBase::Attributes> attributes =
+      this->fs->get_attributes(nullptr, file);
+
+  ASSERT_TRUE(attributes.ok());
+  EXPECT_EQ(attributes->attr->st_mode, S_IFREG | 0600);
+}
+
+}  // namespace
@@ -41,6 +41,7 @@ Status VolumeJobRecoveryVisitor::on_commit_job(
     const SlotParse& /*slot*/, const Ref<const PackedCommitJob>& commit) /*override*/
 {
   this->pending_jobs_.erase(commit.get().prepare_slot_offset);
+  this->job_links_.erase(commit.get().prepare_slot_offset);
 
   return OkStatus();
 }
@@ -51,6 +52,17 @@ Status VolumeJobRecoveryVisitor::on_rollback_job(const SlotParse& /*slot*/,
                                                  const PackedRollbackJob& rollback) /*override*/
 {
   this->pending_jobs_.erase(rollback.prepare_slot);
+  this->job_links_.erase(rollback.prepare_slot);
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeJobRecoveryVisitor::on_prepare_job_link(
+    const SlotParse& /*slot*/, const Ref<const PackedPrepareJobLink>& link) /*override*/
+{
+  this->job_links_.emplace(link.get().prepare_slot.value(), link);
 
   return OkStatus();
 }
@@ -79,6 +91,20 @@ Status VolumeJobRecoveryVisitor::resolve_pending_jobs(
     //
     Status overall_status = OkStatus();
 
+    // If this job is part of a multi-Volume job, it is decided by the ref count updates of the
+    // coordinator Volume (which may or may not be this one).
+    //
+    const PackedPrepareJobLink* link = nullptr;
+    {
+      auto iter = this->job_links_.find(prepare_slot);
+      if (iter != this->job_links_.end()) {
+        link = iter->second.pointer();
+      }
+    }
+    const boost::uuids::uuid decision_uuid = link ? link->decision_uuid : volume_uuid;
+    const slot_offset_type decision_slot = link ? link->decision_slot.value() : prepare_slot;
+    const bool is_participant = (decision_uuid != volume_uuid);
+
     // See whether any ref count updates were flushed.
     //
     bool found_ref_count_updates =
@@ -86,12 +112,12 @@ Status VolumeJobRecoveryVisitor::resolve_pending_jobs(
         | seq::map([&](page_device_id_int page_device_id) -> bool {
             PageAllocator& page_allocator = cache.arena_for_device_id(page_device_id).allocator();
             Optional<PageAllocatorAttachmentStatus> attachment =
-                page_allocator.get_client_attachment_status(volume_uuid);
+                page_allocator.get_client_attachment_status(decision_uuid);
             if (!attachment) {
               overall_status.Update(::llfs::make_status(StatusCode::kPageAllocatorNotAttached));
               return false;
             }
-            return slot_at_least(attachment->user_slot, prepare_slot);
+            return slot_at_least(attachment->user_slot, decision_slot);
           })  //
         | seq::any_true();
 
@@ -134,41 +160,55 @@ Status VolumeJobRecoveryVisitor::resolve_pending_jobs(
     } else {
       LLFS_VLOG(1) << "Committing job at slot " << prepare_slot << "...";
 
-      //----- --- -- -  -  -   -
-      // Call recover_page for all the new pages.
-      //
-      as_seq(*packed_prepare_job.get().new_page_ids)  //
-          | seq::for_each([&](const PackedPageId& packed_page_id) {
-              auto page_id = packed_page_id.as_page_id();
-              Status recover_status = job->recover_page(page_id, volume_uuid, prepare_slot);
-              overall_status.Update(recover_status);
-            });
-
-      // If any pages failed to load, that's a fatal failure.
-      //
-      BATT_REQUIRE_OK(overall_status);
-
-      // Add the root page ids to the job so that ref counts will be recalculated correctly.
-      //
-      as_seq(*packed_prepare_job.get().root_page_ids)  //
-          | seq::map(BATT_OVERLOADS_OF(get_page_id))   //
-          | seq::for_each([&job](PageId page_id) {
-              job->new_root(page_id);
-            });
-
-      // Commit the job!
+      // The PageCacheJob of a multi-Volume job is recovered by its coordinator; a participant only
+      // needs to write its commit slot.
       //
-      Status commit_status = commit(std::move(job),
-                                    JobCommitParams{
-                                        .caller_uuid = &volume_uuid,
-                                        .caller_slot = prepare_slot,
-                                        .recycler = as_ref(recycler),
-                                        .recycle_grant = nullptr,
-                                        .recycle_depth = -1,
-                                    },
-                                    Caller::Unknown);
-
-      BATT_REQUIRE_OK(commit_status);
+      if (!is_participant) {
+        //----- --- -- -  -  -   -
+        // Call recover_page for all the new pages.
+        //
+        as_seq(*packed_prepare_job.get().new_page_ids)  //
+            | seq::for_each([&](const PackedPageId& packed_page_id) {
+                auto page_id = packed_page_id.as_page_id();
+                Status recover_status = job->recover_page(page_id, volume_uuid, prepare_slot);
+                overall_status.Update(recover_status);
+              });
+
+        // If any pages failed to load, that's a fatal failure.
+        //
+        BATT_REQUIRE_OK(overall_status);
+
+        // Add the root page ids to the job so that ref counts will be recalculated correctly.  For
+        // the coordinator of a multi-Volume job, this includes the roots of all participants.
+        //
+        as_seq(*packed_prepare_job.get().root_page_ids)  //
+            | seq::map(BATT_OVERLOADS_OF(get_page_id))   //
+            | seq::for_each([&job](PageId page_id) {
+                job->new_root(page_id);
+              });
+
+        if (link) {
+          as_seq(*link->extra_root_page_ids)              //
+              | seq::map(BATT_OVERLOADS_OF(get_page_id))  //
+              | seq::for_each([&job](PageId page_id) {
+                  job->new_root(page_id);
+                });
+        }
+
+        // Commit the job!
+        //
+        Status commit_status = commit(std::move(job),
+                                      JobCommitParams{
+                                          .caller_uuid = &volume_uuid,
+                                          .caller_slot = prepare_slot,
+                                          .recycler = as_ref(recycler),
+                                          .recycle_grant = nullptr,
+                                          .recycle_depth = -1,
+                                      },
+                                      Caller::Unknown);
+
+        BATT_REQUIRE_OK(commit_status);
+      }
 
       const auto commit_event = CommitJob{
           .prepare_slot_offset = prepare_slot,
@@ -19,6 +19,7 @@
 #include <llfs/volume_slot_demuxer.hpp>
 
 #include <map>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace llfs {
@@ -33,6 +34,7 @@ class VolumeJobRecoveryVisitor : public VolumeEventVisitor<Status>::NullImpl
   void reset_pending_jobs()
   {
     this->pending_jobs_.clear();
+    this->job_links_.clear();
   }
 
   const VolumePendingJobsMap& get_pending_jobs() const noexcept
@@ -52,11 +54,17 @@ class VolumeJobRecoveryVisitor : public VolumeEventVisitor<Status>::NullImpl
 
   Status on_rollback_job(const SlotParse&, const PackedRollbackJob&) override;
 
+  Status on_prepare_job_link(const SlotParse&, const Ref<const PackedPrepareJobLink>&) override;
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
  private:
   // The pending jobs for this volume.
   //
   VolumePendingJobsMap pending_jobs_;
+
+  // The links of pending jobs that are part of a multi-Volume job, by prepare slot offset.
+  //
+  std::unordered_map<slot_offset_type, Ref<const PackedPrepareJobLink>> job_links_;
 };
 
 }  // namespace llfs
@@ -9,8 +9,56 @@
 #include <llfs/volume_metadata_recovery_visitor.hpp>
 //
 
+#include <llfs/data_reader.hpp>
+
 namespace llfs {
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<SlotParse> find_latest_volume_metadata_checkpoint(const ConstBuffer& log_data,
+                                                           slot_offset_type slot_offset)
+{
+  static constexpr u8 kCheckpointWhich =
+      index_of_type_within_packed_variant<VolumeEventVariant, PackedVolumeMetadataCheckpoint>();
+
+  Optional<SlotParse> latest;
+  DataReader data_reader{log_data};
+
+  for (;;) {
+    const usize bytes_available_before = data_reader.bytes_available();
+
+    Optional<u64> slot_body_size = data_reader.read_varint();
+    if (!slot_body_size || *slot_body_size == 0) {
+      break;
+    }
+
+    const usize slot_header_size = bytes_available_before - data_reader.bytes_available();
+
+    std::string_view slot_body = data_reader.read_raw(*slot_body_size);
+    if (slot_body.size() < *slot_body_size) {
+      break;
+    }
+
+    const usize slot_size = slot_header_size + *slot_body_size;
+
+    if (static_cast<u8>(slot_body.front()) == kCheckpointWhich) {
+      latest = SlotParse{
+          .offset =
+              SlotRange{
+                  .lower_bound = slot_offset,
+                  .upper_bound = slot_offset + slot_size,
+              },
+          .body = slot_body,
+          .total_grant_spent = slot_size,
+      };
+    }
+
+    slot_offset += slot_size;
+  }
+
+  return latest;
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 /*explicit*/ VolumeMetadataRecoveryVisitor::VolumeMetadataRecoveryVisitor(
@@ -25,7 +73,8 @@ Status VolumeMetadataRecoveryVisitor::on_volume_ids(const SlotParse& slot,
                                                     const PackedVolumeIds& ids) /*override*/
 {
   this->metadata_.ids = ids;
-  if (this->metadata_.ids_last_refresh) {
+  if (this->metadata_.ids_last_refresh &&
+      *this->metadata_.ids_last_refresh != slot.offset.lower_bound) {
     this->ids_duplicated_ = true;
   }
   this->metadata_.ids_last_refresh = slot.offset.lower_bound;
@@ -40,7 +89,7 @@ Status VolumeMetadataRecoveryVisitor::on_volume_attach(
 {
   VolumeMetadata::AttachInfo& attach_info = this->metadata_.attachments[attach.id];
 
-  if (attach_info.last_refresh) {
+  if (attach_info.last_refresh && *attach_info.last_refresh != slot.offset.lower_bound) {
     this->attachment_duplicated_.emplace(attach.id);
   }
 
@@ -61,6 +110,43 @@ Status VolumeMetadataRecoveryVisitor::on_volume_detach(
   return OkStatus();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeMetadataRecoveryVisitor::on_volume_metadata_checkpoint(
+    const SlotParse&, const Ref<const PackedVolumeMetadataCheckpoint>& checkpoint) /*override*/
+{
+  const PackedVolumeMetadataCheckpoint& packed = checkpoint.get();
+
+  // Any ids or attach slot seen so far that is not the one recorded in the checkpoint is an older
+  // copy, which will be reclaimed when it is trimmed.
+  //
+  if (this->metadata_.ids_last_refresh &&
+      *this->metadata_.ids_last_refresh != packed.ids_last_refresh) {
+    this->ids_duplicated_ = true;
+  }
+  this->metadata_.ids = packed.ids;
+  this->metadata_.ids_last_refresh = packed.ids_last_refresh;
+
+  std::unordered_map<VolumeAttachmentId, VolumeMetadata::AttachInfo, VolumeAttachmentId::Hash>
+      attachments;
+
+  for (const PackedVolumeAttachCheckpoint& attach : *packed.attachments) {
+    auto iter = this->metadata_.attachments.find(attach.event.id);
+    if (iter != this->metadata_.attachments.end() && iter->second.last_refresh &&
+        *iter->second.last_refresh != attach.last_refresh) {
+      this->attachment_duplicated_.emplace(attach.event.id);
+    }
+    attachments.emplace(attach.event.id, VolumeMetadata::AttachInfo{
+                                             .last_refresh = attach.last_refresh.value(),
+                                             .event = attach.event,
+                                         });
+  }
+
+  this->metadata_.attachments = std::move(attachments);
+
+  return OkStatus();
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 usize VolumeMetadataRecoveryVisitor::grant_byte_size_reclaimable_on_trim() const noexcept
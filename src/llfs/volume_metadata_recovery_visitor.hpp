@@ -12,12 +12,24 @@
 
 #include <llfs/config.hpp>
 //
+#include <llfs/buffer.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/slot_parse.hpp>
 #include <llfs/status.hpp>
 #include <llfs/volume_event_visitor.hpp>
 #include <llfs/volume_metadata.hpp>
 
 namespace llfs {
 
+/** \brief Returns the last PackedVolumeMetadataCheckpoint slot in `log_data`, which must start at a
+ * slot boundary (`slot_offset`).
+ *
+ * Only slot headers and variant tags are read; no other slot is unpacked.  The scan stops at the
+ * first incomplete slot.
+ */
+Optional<SlotParse> find_latest_volume_metadata_checkpoint(const ConstBuffer& log_data,
+                                                           slot_offset_type slot_offset);
+
 class VolumeMetadataRecoveryVisitor : public VolumeEventVisitor<Status>::NullImpl
 {
  public:
@@ -31,6 +43,11 @@ class VolumeMetadataRecoveryVisitor : public VolumeEventVisitor<Status>::NullImp
   Status on_volume_detach(const SlotParse& slot, const PackedVolumeDetachEvent& detach) override;
 
   Status on_volume_ids(const SlotParse& slot, const PackedVolumeIds&) override;
+
+  /** \brief Replaces the recovered metadata with the contents of `checkpoint`.
+   */
+  Status on_volume_metadata_checkpoint(
+      const SlotParse& slot, const Ref<const PackedVolumeMetadataCheckpoint>& checkpoint) override;
   //
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
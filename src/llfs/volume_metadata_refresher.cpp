@@ -118,6 +118,42 @@ StatusOr<SlotRange> VolumeMetadataRefresher::flush() noexcept
   return this->state_.lock()->flush();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PendingSlotRing::Ticket VolumeMetadataRefresher::add_pending_job(
+    slot_offset_type prepare_slot) noexcept
+{
+  return this->pending_jobs_.push(prepare_slot);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeMetadataRefresher::remove_pending_job(const PendingSlotRing::Ticket& ticket) noexcept
+{
+  this->pending_jobs_.retire(ticket);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<SlotRange> VolumeMetadataRefresher::write_checkpoint(slot_offset_type trim_pos) noexcept
+{
+  auto locked_state = this->state_.lock();
+
+  // IMPORTANT: the log offset must be read *before* the pending jobs; a prepare slot appended
+  // before this point has already been added to `pending_jobs_`, and any prepare slot appended
+  // after this point is at or above `replay_lower_bound`.
+  //
+  slot_offset_type replay_lower_bound = locked_state->slot_offset();
+  {
+    const Optional<slot_offset_type> min_pending_job = this->pending_jobs_.min_pending();
+    if (min_pending_job) {
+      replay_lower_bound = slot_min(replay_lower_bound, *min_pending_job);
+    }
+  }
+
+  return locked_state->write_checkpoint(trim_pos, replay_lower_bound);
+}
+
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 // class VolumeMetadataRefresher::State
 
@@ -388,4 +424,55 @@ StatusOr<SlotRange> VolumeMetadataRefresher::State::flush() noexcept
   return {SlotRange{*lower_bound, *upper_bound}};
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+slot_offset_type VolumeMetadataRefresher::State::slot_offset() noexcept
+{
+  return this->slot_writer_.slot_offset();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<SlotRange> VolumeMetadataRefresher::State::write_checkpoint(
+    slot_offset_type trim_pos, slot_offset_type replay_lower_bound) noexcept
+{
+  if (this->needs_flush()) {
+    return {batt::StatusCode::kFailedPrecondition};
+  }
+
+  BATT_CHECK(this->metadata_.ids);
+  BATT_CHECK(this->metadata_.ids_last_refresh);
+
+  VolumeMetadataCheckpoint checkpoint{
+      .ids = *this->metadata_.ids,
+      .ids_last_refresh = *this->metadata_.ids_last_refresh,
+      .replay_lower_bound = replay_lower_bound,
+      .trim_pos = trim_pos,
+      .attachments = {},
+  };
+
+  checkpoint.attachments.reserve(this->metadata_.attachments.size());
+  for (const auto& [attach_id, attach_info] : this->metadata_.attachments) {
+    BATT_CHECK(attach_info.last_refresh) << BATT_INSPECT(attach_id);
+
+    checkpoint.attachments.emplace_back(PackedVolumeAttachCheckpoint{
+        .event = attach_info.event,
+        .last_refresh = *attach_info.last_refresh,
+    });
+  }
+
+  BATT_ASSIGN_OK_RESULT(batt::Grant checkpoint_grant,
+                        this->slot_writer_.reserve(packed_sizeof_slot(checkpoint),
+                                                   batt::WaitForResource::kFalse));
+
+  StatusOr<SlotRange> checkpoint_slot = this->slot_writer_.append(checkpoint_grant, checkpoint);
+  BATT_REQUIRE_OK(checkpoint_slot);
+
+  LLFS_VLOG(1) << "Wrote Volume metadata checkpoint at " << checkpoint_slot->lower_bound
+               << BATT_INSPECT(replay_lower_bound) << BATT_INSPECT(trim_pos)
+               << BATT_INSPECT(checkpoint.attachments.size());
+
+  return checkpoint_slot;
+}
+
 }  //namespace llfs
@@ -14,6 +14,7 @@
 //
 #include <llfs/int_types.hpp>
 #include <llfs/optional.hpp>
+#include <llfs/pending_slot_ring.hpp>
 #include <llfs/slot.hpp>
 #include <llfs/slot_writer.hpp>
 #include <llfs/volume_events.hpp>
@@ -110,6 +111,28 @@ class VolumeMetadataRefresher
    */
   StatusOr<SlotRange> flush() noexcept;
 
+  /** \brief Records that the job whose PackedPrepareJob slot starts at `prepare_slot` is not yet
+   * resolved, so that no checkpoint lets recovery skip over its prepare slot.  Returns the ticket
+   * to pass to `remove_pending_job`.
+   *
+   * Must be called before any later slot can be appended (i.e., from the post-commit function of
+   * the prepare slot append); this also means calls are made one at a time, in slot order.
+   */
+  PendingSlotRing::Ticket add_pending_job(slot_offset_type prepare_slot) noexcept;
+
+  /** \brief Records that the job added via `add_pending_job` has been committed or rolled back.
+   */
+  void remove_pending_job(const PendingSlotRing::Ticket& ticket) noexcept;
+
+  /** \brief Appends a PackedVolumeMetadataCheckpoint slot holding the current metadata, using grant
+   * reserved (without waiting) from the log's free pool.
+   *
+   * Returns batt::StatusCode::kFailedPrecondition if there are metadata updates that have not been
+   * flushed yet.  Callers should treat any failure as "no checkpoint written," since checkpoints
+   * are only an optimization.
+   */
+  StatusOr<SlotRange> write_checkpoint(slot_offset_type trim_pos) noexcept;
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
  private:
   class State
@@ -148,6 +171,11 @@ class VolumeMetadataRefresher
 
     StatusOr<SlotRange> flush() noexcept;
 
+    slot_offset_type slot_offset() noexcept;
+
+    StatusOr<SlotRange> write_checkpoint(slot_offset_type trim_pos,
+                                         slot_offset_type replay_lower_bound) noexcept;
+
    private:
     TypedSlotWriter<VolumeEventVariant>& slot_writer_;
 
@@ -163,6 +191,12 @@ class VolumeMetadataRefresher
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   batt::Mutex<State> state_;
+
+  // The prepare slots of all jobs that are not yet resolved.  Adding and removing jobs doesn't
+  // take `state_`'s mutex (or any other, unless there are more pending jobs than fit in the ring),
+  // since `add_pending_job` is called while the log writer is locked.
+  //
+  PendingSlotRing pending_jobs_;
 };
 
 }  //namespace llfs
@@ -28,6 +28,12 @@ class VolumeMetrics
   LatencyMetric reaper_append_deprecated_latency;
   LatencyMetric reaper_flush_deprecated_latency;
   LatencyMetric reaper_append_removed_latency;
+
+  // The number of appended jobs (with new pages) whose page writes were started before the prepare
+  // slot was appended, and the number deferred until commit (see VolumeWritePolicy).
+  //
+  CountMetric<u64> eager_page_write_job_count{0};
+  CountMetric<u64> deferred_page_write_job_count{0};
 };
 
 }  // namespace llfs
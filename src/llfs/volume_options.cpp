@@ -0,0 +1,31 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/volume_options.hpp>
+//
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, VolumeWritePolicy t)
+{
+  switch (t) {
+    case VolumeWritePolicy::kDefault:
+      return out << "Default";
+    case VolumeWritePolicy::kEager:
+      return out << "Eager";
+    case VolumeWritePolicy::kDeferred:
+      return out << "Deferred";
+    case VolumeWritePolicy::kAdaptive:
+      return out << "Adaptive";
+  }
+  return out << "(bad:VolumeWritePolicy)" << (int)t;
+}
+
+}  // namespace llfs
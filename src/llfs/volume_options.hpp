@@ -11,12 +11,14 @@
 #define LLFS_VOLUME_OPTIONS_HPP
 
 #include <llfs/config.hpp>
+#include <llfs/int_types.hpp>
 #include <llfs/optional.hpp>
 
 #include <batteries/strong_typedef.hpp>
 
 #include <boost/uuid/uuid.hpp>
 
+#include <ostream>
 #include <string>
 
 namespace llfs {
@@ -26,7 +28,37 @@ namespace llfs {
 //
 BATT_STRONG_TYPEDEF(u64, TrimLockUpdateInterval);
 
+// When the new pages of a job appended to a Volume (see Volume::append) are written.
+//
+enum struct VolumeWritePolicy : u8 {
+  // As selected by the LLFS_WRITE_NEW_PAGES_ASAP environment variable: kEager unless it is set to
+  // 0, in which case kDeferred.
+  //
+  kDefault = 0,
+
+  // Start writing the new pages before appending the job's prepare slot, so that the page writes
+  // overlap the log flush.
+  //
+  kEager = 1,
+
+  // Write the new pages when the job is committed, after its prepare slot is durable.
+  //
+  kDeferred = 2,
+
+  // kEager while each device the job writes to has fewer than
+  // VolumeOptions::adaptive_write_queue_depth page writes in flight; kDeferred otherwise, so that
+  // jobs don't add to the queue of a device that is already saturated.
+  //
+  kAdaptive = 3,
+};
+
+std::ostream& operator<<(std::ostream& out, VolumeWritePolicy t);
+
 struct VolumeOptions {
+  // Used for kAdaptive when `adaptive_write_queue_depth` is 0.
+  //
+  static constexpr u16 kDefaultAdaptiveWriteQueueDepth = 32;
+
   static constexpr usize kMaxNameLength = 160;
 
   std::string name;
@@ -38,6 +70,10 @@ struct VolumeOptions {
   TrimLockUpdateInterval trim_lock_update_interval;
 
   TrimDelayByteCount trim_delay_byte_count;
+
+  VolumeWritePolicy write_policy = VolumeWritePolicy::kDefault;
+
+  u16 adaptive_write_queue_depth = 0;
 };
 
 }  // namespace llfs
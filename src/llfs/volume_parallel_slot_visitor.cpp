@@ -0,0 +1,185 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/volume_parallel_slot_visitor.hpp>
+//
+
+#include <llfs/logging.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/checked_cast.hpp>
+#include <batteries/stream_util.hpp>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ VolumeParallelSlotVisitor::VolumeParallelSlotVisitor(
+    batt::TaskScheduler& scheduler, const Options& options, PartitionFn&& partition_fn,
+    VolumeReader::SlotVisitorFn&& slot_visitor_fn) noexcept
+    : options_{options}
+    , partition_fn_{std::move(partition_fn)}
+    , slot_visitor_fn_{std::move(slot_visitor_fn)}
+{
+  BATT_CHECK_GT(this->options_.worker_count, 0u);
+  BATT_CHECK_GT(this->options_.max_pending_slots, 0u);
+
+  for (usize i = 0; i < this->options_.worker_count; ++i) {
+    this->workers_.emplace_back(std::make_unique<Worker>());
+  }
+
+  // Start the tasks only after all the workers have been created, so that `workers_` is never
+  // modified while a task is running.
+  //
+  for (usize i = 0; i < this->workers_.size(); ++i) {
+    Worker& worker = *this->workers_[i];
+    worker.task.emplace(
+        scheduler.schedule_task(),
+        [this, &worker] {
+          this->worker_main(worker);
+        },
+        batt::to_string("VolumeParallelSlotVisitor.worker_", i));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+VolumeParallelSlotVisitor::~VolumeParallelSlotVisitor() noexcept
+{
+  this->halt_and_join();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeParallelSlotVisitor::operator()(const SlotParse& slot, std::string_view user_data)
+{
+  BATT_CHECK(!this->halted_) << "slots may not be visited after finish()";
+
+  if (this->failed_.load()) {
+    return this->get_error();
+  }
+
+  const usize partition = this->partition_fn_(slot, user_data) % this->workers_.size();
+
+  // Bound the number of copied slots awaiting a worker.
+  //
+  const i64 max_pending_slots = BATT_CHECKED_CAST(i64, this->options_.max_pending_slots);
+
+  StatusOr<i64> pending = this->pending_count_.await_true([max_pending_slots](i64 n) {
+    return n < max_pending_slots;
+  });
+  BATT_REQUIRE_OK(pending);
+
+  this->pending_count_.fetch_add(1);
+
+  Status push_status = this->workers_[partition]->queue.push(QueuedSlot{
+      .offset = slot.offset,
+      .total_grant_spent = slot.total_grant_spent,
+      .user_data = std::string{user_data},
+  });
+
+  if (!push_status.ok()) {
+    this->pending_count_.fetch_sub(1);
+    return push_status;
+  }
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeParallelSlotVisitor::finish()
+{
+  if (!this->halted_) {
+    // Tell each worker to stop once it has processed everything ahead of the end marker.
+    //
+    for (const std::unique_ptr<Worker>& worker : this->workers_) {
+      worker->queue.push(None).IgnoreError();
+    }
+    for (const std::unique_ptr<Worker>& worker : this->workers_) {
+      worker->task->join();
+    }
+    this->halt_and_join();
+  }
+
+  return this->get_error();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeParallelSlotVisitor::worker_main(Worker& worker)
+{
+  for (;;) {
+    StatusOr<Optional<QueuedSlot>> next = worker.queue.await_next();
+    if (!next.ok() || !*next) {
+      break;
+    }
+
+    QueuedSlot& queued = **next;
+
+    // Once any worker has failed, the rest of the queued slots are dropped (but still counted, so
+    // that a producer blocked on `pending_count_` wakes up).
+    //
+    if (!this->failed_.load()) {
+      const SlotParse slot{
+          .offset = queued.offset,
+          .body = queued.user_data,
+          .total_grant_spent = queued.total_grant_spent,
+      };
+
+      Status status = this->slot_visitor_fn_(slot, queued.user_data);
+      if (!status.ok()) {
+        LLFS_LOG_WARNING() << "VolumeParallelSlotVisitor: slot visitor failed;"
+                           << BATT_INSPECT(slot) << BATT_INSPECT(status);
+        this->record_error(status);
+      }
+    }
+
+    this->pending_count_.fetch_sub(1);
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeParallelSlotVisitor::record_error(const Status& status)
+{
+  {
+    auto locked = this->first_error_.lock();
+    if (locked->ok()) {
+      *locked = status;
+    }
+  }
+  this->failed_.store(true);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeParallelSlotVisitor::get_error()
+{
+  return *this->first_error_.lock();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeParallelSlotVisitor::halt_and_join()
+{
+  if (this->halted_) {
+    return;
+  }
+  this->halted_ = true;
+
+  for (const std::unique_ptr<Worker>& worker : this->workers_) {
+    worker->queue.close();
+  }
+  for (const std::unique_ptr<Worker>& worker : this->workers_) {
+    worker->task->join();
+  }
+  this->pending_count_.close();
+}
+
+}  // namespace llfs
@@ -0,0 +1,156 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_VOLUME_PARALLEL_SLOT_VISITOR_HPP
+#define LLFS_VOLUME_PARALLEL_SLOT_VISITOR_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/slot_parse.hpp>
+#include <llfs/status.hpp>
+#include <llfs/volume_reader.hpp>
+
+#include <batteries/async/mutex.hpp>
+#include <batteries/async/queue.hpp>
+#include <batteries/async/task.hpp>
+#include <batteries/async/task_scheduler.hpp>
+#include <batteries/async/watch.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace llfs {
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief A user slot visitor that dispatches slots to a bounded pool of worker tasks by partition
+ * key, so that independent slots can be replayed in parallel.
+ *
+ * This is a drop-in replacement for a VolumeReader::SlotVisitorFn; it can be passed (by reference)
+ * as the slot visitor of Volume::recover, VolumeSlotDemuxer, or VolumeReader::consume_slots.  The
+ * log is still parsed and demuxed serially by the caller; only the user-level visitor function
+ * runs on the worker tasks.  Slots whose partition keys are equal are always visited in log order,
+ * by the same worker.  There is no ordering between slots in different partitions.
+ *
+ * Because a slot may be visited after the log reader has moved past it, the user data of each slot
+ * is copied before it is queued; the SlotParse passed to the visitor function has its `body` set
+ * to this copy of the user data (not the entire slot).
+ *
+ * `finish()` must be called (and return OK) before the effects of all visited slots can be relied
+ * on.
+ */
+class VolumeParallelSlotVisitor
+{
+ public:
+  using PartitionFn = std::function<usize(const SlotParse& slot, std::string_view user_data)>;
+
+  struct Options {
+    // The number of worker tasks.
+    //
+    usize worker_count;
+
+    // The maximum number of slots dispatched but not yet visited; `operator()` blocks while this
+    // many slots are outstanding.
+    //
+    usize max_pending_slots;
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  explicit VolumeParallelSlotVisitor(batt::TaskScheduler& scheduler, const Options& options,
+                                     PartitionFn&& partition_fn,
+                                     VolumeReader::SlotVisitorFn&& slot_visitor_fn) noexcept;
+
+  VolumeParallelSlotVisitor(const VolumeParallelSlotVisitor&) = delete;
+  VolumeParallelSlotVisitor& operator=(const VolumeParallelSlotVisitor&) = delete;
+
+  /** \brief Stops and joins all worker tasks; slots that haven't been visited yet are dropped.
+   */
+  ~VolumeParallelSlotVisitor() noexcept;
+
+  /** \brief Queues `slot` to be visited by the worker for its partition.
+   *
+   * Returns the first error returned by the visitor function on any worker (if there has been
+   * one), in which case `slot` is not queued.
+   */
+  Status operator()(const SlotParse& slot, std::string_view user_data);
+
+  /** \brief Waits for all queued slots to be visited and stops the worker tasks.  Returns the first
+   * error returned by the visitor function, or OkStatus if there were none.
+   *
+   * No more slots may be passed to this object after `finish` is called.
+   */
+  Status finish();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  // A copy of a slot, queued for a worker.
+  //
+  struct QueuedSlot {
+    SlotRange offset;
+    u64 total_grant_spent;
+    std::string user_data;
+  };
+
+  // Each worker has its own queue; None tells the worker it is finished.
+  //
+  struct Worker {
+    batt::Queue<Optional<QueuedSlot>> queue;
+    Optional<batt::Task> task;
+  };
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  // The body of each worker task.
+  //
+  void worker_main(Worker& worker);
+
+  // Saves `status` if it is the first error.
+  //
+  void record_error(const Status& status);
+
+  // Returns the first recorded error, or OkStatus.
+  //
+  Status get_error();
+
+  // Closes all worker queues and joins the worker tasks (idempotent).
+  //
+  void halt_and_join();
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const Options options_;
+
+  const PartitionFn partition_fn_;
+
+  const VolumeReader::SlotVisitorFn slot_visitor_fn_;
+
+  // The number of queued slots that haven't been visited yet.
+  //
+  batt::Watch<i64> pending_count_{0};
+
+  // Set once any visitor call has failed; the error is in `first_error_`.
+  //
+  std::atomic<bool> failed_{false};
+
+  batt::Mutex<Status> first_error_{OkStatus()};
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  bool halted_ = false;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_VOLUME_PARALLEL_SLOT_VISITOR_HPP
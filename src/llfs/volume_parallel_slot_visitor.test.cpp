@@ -0,0 +1,146 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/volume_parallel_slot_visitor.hpp>
+//
+#include <llfs/volume_parallel_slot_visitor.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <batteries/async/runtime.hpp>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//
+//  1. All slots are visited exactly once, and slots in the same partition are visited in the
+//     order they were passed in, for various worker counts and queue bounds.
+//  2. The first error returned by the visitor function is reported by finish() and stops further
+//     slots from being queued.
+//
+
+using namespace llfs::int_types;
+
+constexpr usize kNumSlots = 1000;
+constexpr usize kNumPartitions = 10;
+
+llfs::SlotParse make_slot(usize i, std::string_view user_data)
+{
+  return llfs::SlotParse{
+      .offset =
+          llfs::SlotRange{
+              .lower_bound = i * 100,
+              .upper_bound = i * 100 + 100,
+          },
+      .body = user_data,
+      .total_grant_spent = 100,
+  };
+}
+
+usize parse_partition(std::string_view user_data)
+{
+  return std::stoul(std::string{user_data}) % kNumPartitions;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  1. Per-partition ordering.
+//
+TEST(VolumeParallelSlotVisitorTest, PartitionOrder)
+{
+  for (usize worker_count : {1, 3, 8}) {
+    for (usize max_pending_slots : {1, 16, 4096}) {
+      std::mutex mutex;
+      std::map<usize, std::vector<llfs::slot_offset_type>> visited;
+
+      llfs::VolumeParallelSlotVisitor visitor{
+          batt::Runtime::instance().default_scheduler(),
+          llfs::VolumeParallelSlotVisitor::Options{
+              .worker_count = worker_count,
+              .max_pending_slots = max_pending_slots,
+          },
+          /*partition_fn=*/
+          [](const llfs::SlotParse&, std::string_view user_data) {
+            return parse_partition(user_data);
+          },
+          /*slot_visitor_fn=*/
+          [&](const llfs::SlotParse& slot, std::string_view user_data) {
+            EXPECT_EQ(slot.body, user_data);
+            std::unique_lock<std::mutex> lock{mutex};
+            visited[parse_partition(user_data)].emplace_back(slot.offset.lower_bound);
+            return llfs::OkStatus();
+          }};
+
+      for (usize i = 0; i < kNumSlots; ++i) {
+        const std::string user_data = std::to_string(i);
+        ASSERT_TRUE(visitor(make_slot(i, user_data), user_data).ok());
+      }
+
+      llfs::Status status = visitor.finish();
+      ASSERT_TRUE(status.ok()) << BATT_INSPECT(status);
+
+      ASSERT_EQ(visited.size(), kNumPartitions);
+      for (const auto& [partition, slots] : visited) {
+        std::vector<llfs::slot_offset_type> expected;
+        for (usize i = partition; i < kNumSlots; i += kNumPartitions) {
+          expected.emplace_back(i * 100);
+        }
+        EXPECT_THAT(slots, ::testing::ContainerEq(expected))
+            << BATT_INSPECT(partition) << BATT_INSPECT(worker_count)
+            << BATT_INSPECT(max_pending_slots);
+      }
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//  2. Errors.
+//
+TEST(VolumeParallelSlotVisitorTest, VisitorError)
+{
+  constexpr usize kFailingSlot = 77;
+
+  llfs::VolumeParallelSlotVisitor visitor{
+      batt::Runtime::instance().default_scheduler(),
+      llfs::VolumeParallelSlotVisitor::Options{
+          .worker_count = 4,
+          .max_pending_slots = 1,
+      },
+      /*partition_fn=*/
+      [](const llfs::SlotParse&, std::string_view user_data) {
+        return parse_partition(user_data);
+      },
+      /*slot_visitor_fn=*/
+      [](const llfs::SlotParse&, std::string_view user_data) -> llfs::Status {
+        if (std::stoul(std::string{user_data}) == kFailingSlot) {
+          return batt::StatusCode::kDataLoss;
+        }
+        return llfs::OkStatus();
+      }};
+
+  usize i = 0;
+  for (; i < kNumSlots; ++i) {
+    const std::string user_data = std::to_string(i);
+    if (!visitor(make_slot(i, user_data), user_data).ok()) {
+      break;
+    }
+  }
+
+  // With at most one slot pending, the error must be noticed soon after the failing slot.
+  //
+  EXPECT_GT(i, kFailingSlot);
+  EXPECT_LT(i, kNumSlots);
+  EXPECT_EQ(visitor.finish(), batt::StatusCode::kDataLoss);
+}
+
+}  // namespace
@@ -85,6 +85,13 @@ StatusOr<PinnedPage> VolumeReader::get_page_with_layout_in_job(
                                                         ok_if_not_found);
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeReader::enable_readahead(usize max_window)
+{
+  this->impl_->job_->enable_readahead(max_window);
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 SlotRange VolumeReader::slot_range() const
@@ -135,4 +142,27 @@ Status VolumeReader::trim(slot_offset_type trim_upper_bound)
   return OkStatus();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<slot_offset_type> VolumeReader::await_durable_lag(slot_offset_type batch_upper_bound,
+                                                           u64 max_durable_lag)
+{
+  LogDevice& root_log = this->impl_->volume_.root_log();
+
+  slot_offset_type durable_upper_bound = root_log.slot_range(LogReadMode::kDurable).upper_bound;
+
+  if (slot_less_than(durable_upper_bound + max_durable_lag, batch_upper_bound)) {
+    // Wait for just enough of the log to be flushed to bring the lag back within bounds.
+    //
+    BATT_REQUIRE_OK(root_log.sync(LogReadMode::kDurable,
+                                  SlotUpperBoundAt{
+                                      .offset = batch_upper_bound - max_durable_lag,
+                                  }));
+
+    durable_upper_bound = root_log.slot_range(LogReadMode::kDurable).upper_bound;
+  }
+
+  return durable_upper_bound;
+}
+
 }  // namespace llfs
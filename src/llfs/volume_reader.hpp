@@ -12,6 +12,8 @@
 
 #include <llfs/log_device.hpp>
 #include <llfs/page_loader.hpp>
+#include <llfs/page_readahead.hpp>
+#include <llfs/slice.hpp>
 #include <llfs/slot_read_lock.hpp>
 #include <llfs/slot_reader.hpp>
 #include <llfs/volume_options.hpp>
@@ -39,6 +41,28 @@ class VolumeReader : public PageLoader
 
   using SlotVisitorFn = std::function<Status(const SlotParse& slot, std::string_view user_data)>;
 
+  // A user-visible slot, as passed to the batch visitor of `visit_next_batch` and
+  // `consume_slot_batches`.  `user_data` points directly into the log buffer; it is only valid
+  // until the batch visitor returns.
+  //
+  struct UserSlot {
+    SlotParse slot;
+    std::string_view user_data;
+  };
+
+  using SlotBatchVisitorFn = std::function<Status(const Slice<const UserSlot>& batch)>;
+
+  // Visitor for speculative batches (see `consume_speculative_batches`); `durable_upper_bound` is
+  // the root log's durable upper bound as of the time the batch was visited: every slot in the
+  // batch whose upper bound is not greater than this will survive a crash.
+  //
+  using SpeculativeBatchVisitorFn = std::function<Status(const Slice<const UserSlot>& batch,
+                                                         slot_offset_type durable_upper_bound)>;
+
+  // The default maximum number of log slots to parse per batch.
+  //
+  static constexpr usize kDefaultMaxBatchSize = 64;
+
   explicit VolumeReader(Volume& volume, SlotReadLock&& read_lock, LogReadMode mode) noexcept;
 
   VolumeReader() = default;
@@ -82,6 +106,11 @@ class VolumeReader : public PageLoader
   //
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
+  // Turn on sequential readahead for pages loaded through this reader.  See
+  // PageCacheJob::enable_readahead.
+  //
+  void enable_readahead(usize max_window = SequentialReadahead::kDefaultMaxWindow);
+
   // The current range of slot offsets locked by this VolumeReader.
   //
   SlotRange slot_range() const;
@@ -106,6 +135,41 @@ class VolumeReader : public PageLoader
   template <typename F = SlotVisitorFn>
   StatusOr<usize> consume_slots(batt::WaitForResource wait_for_commit, F&& visitor_fn);
 
+  // Parses up to `max_batch_size` consecutive slots from the log (without waiting for more than
+  // one), then applies the given visitor function once to the user-visible slots among them.  The
+  // visitor is not called if none of the parsed slots is user-visible.  Returns the number of user
+  // slots visited.
+  //
+  template <typename F = SlotBatchVisitorFn>
+  StatusOr<usize> visit_next_batch(batt::WaitForResource wait_for_commit, F&& batch_visitor_fn,
+                                   usize max_batch_size = kDefaultMaxBatchSize);
+
+  // Like `consume_slots`, but passes user slots to the visitor function in batches (see
+  // `visit_next_batch`).  Returns the number of user slots visited.
+  //
+  template <typename F = SlotBatchVisitorFn>
+  StatusOr<usize> consume_slot_batches(batt::WaitForResource wait_for_commit, F&& batch_visitor_fn,
+                                       usize max_batch_size = kDefaultMaxBatchSize);
+
+  // Like `visit_next_batch`, but for a reader created with LogReadMode::kSpeculative: slots are
+  // visited as soon as they are committed to the log, without waiting for each one to be flushed.
+  // Instead, the visitor is passed the durable upper bound of the log (checked once per batch), and
+  // the staleness of the durable data is bounded: if the end of the batch is more than
+  // `max_durable_lag` bytes ahead of the durable upper bound, this function first waits for the log
+  // to be flushed up to that point.
+  //
+  template <typename F = SpeculativeBatchVisitorFn>
+  StatusOr<usize> visit_next_speculative_batch(batt::WaitForResource wait_for_commit,
+                                               u64 max_durable_lag, F&& batch_visitor_fn,
+                                               usize max_batch_size = kDefaultMaxBatchSize);
+
+  // Like `consume_slot_batches`, with speculative batches (see `visit_next_speculative_batch`).
+  //
+  template <typename F = SpeculativeBatchVisitorFn>
+  StatusOr<usize> consume_speculative_batches(batt::WaitForResource wait_for_commit,
+                                              u64 max_durable_lag, F&& batch_visitor_fn,
+                                              usize max_batch_size = kDefaultMaxBatchSize);
+
   //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
  private:
   class ImplDeleter
@@ -114,6 +178,30 @@ class VolumeReader : public PageLoader
     void operator()(Impl*) const;
   };
 
+  // Implements `visit_next_batch` (if `pause_after_batch` is true) and `consume_slot_batches`.
+  //
+  template <typename F>
+  StatusOr<usize> visit_batches(batt::WaitForResource wait_for_commit, F&& batch_visitor_fn,
+                                usize max_batch_size, bool pause_after_batch);
+
+  // Implements `visit_next_speculative_batch` and `consume_speculative_batches`.
+  //
+  template <typename F>
+  StatusOr<usize> visit_speculative_batches(batt::WaitForResource wait_for_commit,
+                                            u64 max_durable_lag, F&& batch_visitor_fn,
+                                            usize max_batch_size, bool pause_after_batch);
+
+  // Returns the durable upper bound of the root log, first waiting (if necessary) until it is at
+  // most `max_durable_lag` bytes behind `batch_upper_bound`.
+  //
+  StatusOr<slot_offset_type> await_durable_lag(slot_offset_type batch_upper_bound,
+                                               u64 max_durable_lag);
+
+  // Updates the trim lock for this reader if `slot` is far enough past the last update.
+  //
+  template <typename Demuxer>
+  Status update_trim_lock_if_needed(const SlotParse& slot, const Demuxer& demuxer);
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   std::unique_ptr<Impl, ImplDeleter> impl_;
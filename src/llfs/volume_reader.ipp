@@ -16,6 +16,8 @@
 #include <llfs/volume_events.hpp>
 #include <llfs/volume_slot_demuxer.hpp>
 
+#include <vector>
+
 namespace llfs {
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
@@ -40,6 +42,11 @@ class VolumeReader::Impl
   TypedSlotReader<VolumeEventVariant> slot_reader_;
   bool paused_;
   slot_offset_type trim_lock_update_lower_bound_;
+
+  // The user slots passed to the visitor of the current (or most recent) batch; kept here so that
+  // its memory is reused from one batch to the next.
+  //
+  std::vector<VolumeReader::UserSlot> user_slot_batch_;
 };
 
 //#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
@@ -105,25 +112,8 @@ inline StatusOr<usize> VolumeReader::consume_slots(batt::WaitForResource wait_fo
   //
   StatusOr<usize> result = this->impl_->slot_reader_.run(
       wait_for_commit,
-      [this, &demuxer, &n_user_slots_visited](const SlotParse& slot, auto&& payload) -> Status {
-        // Check to see whether the trim lock for this reader can be updated yet.
-        //
-        if (BATT_HINT_FALSE(!slot_less_than(slot.offset.lower_bound,
-                                            this->impl_->trim_lock_update_lower_bound_))) {
-          // Advance the lock update lower bound to delay the next update.
-          //
-          this->impl_->trim_lock_update_lower_bound_ =
-              slot.offset.upper_bound + this->volume_options().trim_lock_update_interval;
-
-          // The demuxer must be consulted because pending jobs can affect when it is safe to update
-          // the trim lock.
-          //
-          Optional<slot_offset_type> new_trim_pos = demuxer.get_safe_trim_pos();
-          if (new_trim_pos) {
-            Status trim_status = this->trim(*new_trim_pos);
-            BATT_REQUIRE_OK(trim_status);
-          }
-        }
+      [this, &demuxer](const SlotParse& slot, auto&& payload) -> Status {
+        BATT_REQUIRE_OK(this->update_trim_lock_if_needed(slot, demuxer));
 
         // Visit the slot!  (This is safe to do after trimming because the demuxer tracks the
         // greatest slot offset it has processed.)
@@ -136,6 +126,167 @@ inline StatusOr<usize> VolumeReader::consume_slots(batt::WaitForResource wait_fo
   return n_user_slots_visited;
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename F>
+inline StatusOr<usize> VolumeReader::visit_next_batch(batt::WaitForResource wait_for_commit,
+                                                      F&& batch_visitor_fn, usize max_batch_size)
+{
+  return this->visit_batches(wait_for_commit, BATT_FORWARD(batch_visitor_fn), max_batch_size,
+                             /*pause_after_batch=*/true);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename F>
+inline StatusOr<usize> VolumeReader::consume_slot_batches(batt::WaitForResource wait_for_commit,
+                                                          F&& batch_visitor_fn,
+                                                          usize max_batch_size)
+{
+  return this->visit_batches(wait_for_commit, BATT_FORWARD(batch_visitor_fn), max_batch_size,
+                             /*pause_after_batch=*/false);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename F>
+inline StatusOr<usize> VolumeReader::visit_batches(batt::WaitForResource wait_for_commit,
+                                                   F&& batch_visitor_fn, usize max_batch_size,
+                                                   bool pause_after_batch)
+{
+  usize n_user_slots_visited = 0;
+
+  // Unpause the reader; if `pause_after_batch` is true, it is paused again as soon as a batch
+  // containing at least one user slot is passed to the visitor.
+  //
+  this->impl_->paused_ = false;
+  auto on_scope_exit = batt::finally([&] {
+    this->impl_->paused_ = true;
+  });
+
+  std::vector<UserSlot>& user_slots = this->impl_->user_slot_batch_;
+
+  // The demuxer only collects user slots; they are passed on to `batch_visitor_fn` after the whole
+  // batch has been demuxed.
+  //
+  auto collect_user_slot = [&user_slots](const SlotParse& slot,
+                                         const std::string_view& user_data) -> Status {
+    user_slots.emplace_back(UserSlot{
+        .slot = slot,
+        .user_data = user_data,
+    });
+    return OkStatus();
+  };
+
+  VolumeSlotDemuxer<NoneType, decltype(collect_user_slot)&> demuxer{collect_user_slot};
+
+  StatusOr<usize> result = this->impl_->slot_reader_.run_batches(
+      wait_for_commit, max_batch_size,
+      [&](const Slice<const SlotParse>& batch) -> Status {
+        // Only update the trim lock between batches, since the demuxer may have visited slots in
+        // the current batch that haven't been passed to `batch_visitor_fn` yet.
+        //
+        if (!pause_after_batch) {
+          BATT_REQUIRE_OK(this->update_trim_lock_if_needed(batch.front(), demuxer));
+        }
+
+        user_slots.clear();
+        for (const SlotParse& slot : batch) {
+          Status status = TypedSlotReader<VolumeEventVariant>::visit_slot(
+              slot, slot.body, [&demuxer](auto&&... args) -> Status {
+                return demuxer(BATT_FORWARD(args)...).status();
+              });
+          BATT_REQUIRE_OK(status);
+        }
+
+        if (user_slots.empty()) {
+          return OkStatus();
+        }
+        if (pause_after_batch) {
+          this->impl_->paused_ = true;
+        }
+        n_user_slots_visited += user_slots.size();
+
+        return batch_visitor_fn(as_slice(user_slots));
+      });
+
+  BATT_REQUIRE_OK(result);
+
+  return n_user_slots_visited;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename F>
+inline StatusOr<usize> VolumeReader::visit_next_speculative_batch(
+    batt::WaitForResource wait_for_commit, u64 max_durable_lag, F&& batch_visitor_fn,
+    usize max_batch_size)
+{
+  return this->visit_speculative_batches(wait_for_commit, max_durable_lag,
+                                         BATT_FORWARD(batch_visitor_fn), max_batch_size,
+                                         /*pause_after_batch=*/true);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename F>
+inline StatusOr<usize> VolumeReader::consume_speculative_batches(
+    batt::WaitForResource wait_for_commit, u64 max_durable_lag, F&& batch_visitor_fn,
+    usize max_batch_size)
+{
+  return this->visit_speculative_batches(wait_for_commit, max_durable_lag,
+                                         BATT_FORWARD(batch_visitor_fn), max_batch_size,
+                                         /*pause_after_batch=*/false);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename F>
+inline StatusOr<usize> VolumeReader::visit_speculative_batches(
+    batt::WaitForResource wait_for_commit, u64 max_durable_lag, F&& batch_visitor_fn,
+    usize max_batch_size, bool pause_after_batch)
+{
+  return this->visit_batches(
+      wait_for_commit,
+      [this, max_durable_lag, &batch_visitor_fn](const Slice<const UserSlot>& batch) -> Status {
+        StatusOr<slot_offset_type> durable_upper_bound =
+            this->await_durable_lag(batch.back().slot.offset.upper_bound, max_durable_lag);
+
+        BATT_REQUIRE_OK(durable_upper_bound);
+
+        return batch_visitor_fn(batch, *durable_upper_bound);
+      },
+      max_batch_size, pause_after_batch);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename Demuxer>
+inline Status VolumeReader::update_trim_lock_if_needed(const SlotParse& slot,
+                                                       const Demuxer& demuxer)
+{
+  // Check to see whether the trim lock for this reader can be updated yet.
+  //
+  if (BATT_HINT_FALSE(!slot_less_than(slot.offset.lower_bound,
+                                      this->impl_->trim_lock_update_lower_bound_))) {
+    // Advance the lock update lower bound to delay the next update.
+    //
+    this->impl_->trim_lock_update_lower_bound_ =
+        slot.offset.upper_bound + this->volume_options().trim_lock_update_interval;
+
+    // The demuxer must be consulted because pending jobs can affect when it is safe to update
+    // the trim lock.
+    //
+    Optional<slot_offset_type> new_trim_pos = demuxer.get_safe_trim_pos();
+    if (new_trim_pos) {
+      Status trim_status = this->trim(*new_trim_pos);
+      BATT_REQUIRE_OK(trim_status);
+    }
+  }
+
+  return OkStatus();
+}
+
 }  // namespace llfs
 
 #endif  // LLFS_VOLUME_READER_IPP
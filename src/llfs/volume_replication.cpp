@@ -0,0 +1,470 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/volume_replication.hpp>
+//
+
+#include <llfs/appendable_job.hpp>
+#include <llfs/buffered_log_data_reader.hpp>
+#include <llfs/logging.hpp>
+#include <llfs/pack_as_raw.hpp>
+#include <llfs/packable_ref.hpp>
+#include <llfs/slot_reader.hpp>
+#include <llfs/volume_event_visitor.hpp>
+#include <llfs/volume_events.hpp>
+
+#include <batteries/async/task.hpp>
+
+namespace llfs {
+
+namespace {
+
+// The user data of a replicated job slot: packed as raw bytes (so that it is visited on the
+// follower exactly as it was on the leader), with the root page refs of the leader's slot.
+//
+struct ReplicatedUserData {
+  std::string_view bytes;
+  const std::vector<PageId>* root_page_ids;
+};
+
+usize packed_sizeof(const ReplicatedUserData& user_data)
+{
+  return packed_sizeof(pack_as_raw(user_data.bytes));
+}
+
+PackedRawData* pack_object(const ReplicatedUserData& user_data, DataPacker* dst)
+{
+  return pack_object(pack_as_raw(user_data.bytes), dst);
+}
+
+BoxedSeq<PageId> trace_refs(const ReplicatedUserData& user_data)
+{
+  return as_seq(*user_data.root_page_ids) | seq::decayed() | seq::boxed();
+}
+
+}  // namespace
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// VolumeLogShipper::LogVisitor
+
+/** \brief Collects the user slots of one chunk of the leader's log into a batch, and tracks the
+ * jobs that are prepared but not yet committed.
+ */
+class VolumeLogShipper::LogVisitor : public VolumeEventVisitor<Status>::NullImpl
+{
+ public:
+  explicit LogVisitor(VolumeLogShipper& shipper, VolumeReplicationBatch& batch) noexcept
+      : shipper_{shipper}
+      , batch_{batch}
+  {
+  }
+
+  Status on_raw_data(const SlotParse& slot, const Ref<const PackedRawData>& raw) override
+  {
+    if (!this->should_ship(slot)) {
+      return OkStatus();
+    }
+
+    this->batch_.records.emplace_back(VolumeReplicationRecord{
+        .leader_slot = slot.offset,
+        .user_data = raw_data_from_slot(slot, raw.pointer()),
+    });
+
+    return OkStatus();
+  }
+
+  Status on_prepare_job(const SlotParse& slot, const Ref<const PackedPrepareJob>& prepare) override
+  {
+    PreparedJob& job = this->shipper_.prepared_jobs_[slot.offset.lower_bound];
+
+    for (const PackedPageId& page_id : *prepare.get().new_page_ids) {
+      job.new_page_ids.emplace_back(page_id.unpack());
+    }
+    for (const PackedPageId& page_id : *prepare.get().deleted_page_ids) {
+      job.deleted_page_ids.emplace_back(page_id.unpack());
+    }
+
+    return OkStatus();
+  }
+
+  Status on_commit_job(const SlotParse& slot, const Ref<const PackedCommitJob>& commit) override
+  {
+    const slot_offset_type prepare_slot = get_slot_offset(commit.get().prepare_slot_offset);
+
+    auto iter = this->shipper_.prepared_jobs_.find(prepare_slot);
+    if (iter == this->shipper_.prepared_jobs_.end()) {
+      if (!this->should_ship(slot)) {
+        return OkStatus();
+      }
+      LLFS_LOG_ERROR() << "VolumeLogShipper: the prepare slot of a committed job was not found"
+                       << BATT_INSPECT(slot.offset) << BATT_INSPECT(prepare_slot);
+      return {batt::StatusCode::kDataLoss};
+    }
+
+    PreparedJob job = std::move(iter->second);
+    this->shipper_.prepared_jobs_.erase(iter);
+
+    if (!this->should_ship(slot)) {
+      return OkStatus();
+    }
+
+    VolumeReplicationRecord& record = this->batch_.records.emplace_back(VolumeReplicationRecord{
+        .leader_slot = slot.offset,
+        .user_data = commit.get().user_data(),
+        .is_job = true,
+        .root_page_ids = {},
+        .new_page_ids = std::move(job.new_page_ids),
+        .deleted_page_ids = std::move(job.deleted_page_ids),
+        .new_pages = {},
+    });
+
+    for (const PackedPageId& page_id : *commit.get().root_page_ids) {
+      record.root_page_ids.emplace_back(page_id.unpack());
+    }
+
+    for (const PageId& page_id : record.new_page_ids) {
+      if (!this->shipper_.sink_.needs_page(page_id)) {
+        this->shipper_.metrics_.skipped_page_count.add(1);
+        continue;
+      }
+
+      // If the leader has already dropped the page (possible only if the job's pages were
+      // released by later jobs before this one was shipped), the follower can't be brought up to
+      // date by shipping.
+      //
+      StatusOr<PinnedPage> pinned_page =
+          this->shipper_.volume_.cache().get_page(page_id, OkIfNotFound{false});
+
+      BATT_REQUIRE_OK(pinned_page) << BATT_INSPECT(page_id) << BATT_INSPECT(slot.offset);
+
+      record.new_pages.emplace_back(std::move(*pinned_page));
+      this->shipper_.metrics_.shipped_page_count.add(1);
+    }
+
+    return OkStatus();
+  }
+
+  Status on_rollback_job(const SlotParse&, const PackedRollbackJob& rollback) override
+  {
+    this->shipper_.prepared_jobs_.erase(get_slot_offset(rollback.prepare_slot));
+    return OkStatus();
+  }
+
+ private:
+  /** \brief Returns true if the follower doesn't have the given slot yet.
+   */
+  bool should_ship(const SlotParse& slot) const
+  {
+    return slot_less_than(this->shipper_.start_slot_, slot.offset.upper_bound);
+  }
+
+  VolumeLogShipper& shipper_;
+  VolumeReplicationBatch& batch_;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// VolumeLogShipper
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+VolumeLogShipper::VolumeLogShipper(Volume& leader, VolumeReplicationSink& sink,
+                                   slot_offset_type start_slot,
+                                   const VolumeLogShipperOptions& options) noexcept
+    : volume_{leader}
+    , sink_{sink}
+    , options_{options}
+    , scan_lower_bound_{start_slot}
+    , start_slot_{start_slot}
+    , shipped_upper_bound_{start_slot}
+    , acked_upper_bound_{start_slot}
+    , last_seen_upper_bound_{start_slot}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+VolumeLogShipper::~VolumeLogShipper() noexcept
+{
+  this->halt();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<u64> VolumeLogShipper::ship_available()
+{
+  if (this->lag_limit_reached()) {
+    return 0;
+  }
+
+  const SlotRange log_range = this->volume_.root_log_slot_range(this->options_.mode);
+  this->last_seen_upper_bound_ = log_range.upper_bound;
+
+  // On the first call, start scanning at the beginning of the leader's log, so that the prepare
+  // slots of jobs committed after `start_slot_` are seen.
+  //
+  if (!this->tail_lock_) {
+    if (slot_less_than(this->start_slot_, log_range.lower_bound) ||
+        slot_less_than(log_range.upper_bound, this->start_slot_)) {
+      LLFS_LOG_ERROR() << "VolumeLogShipper: the start slot is not in the leader's log"
+                       << BATT_INSPECT(this->start_slot_) << BATT_INSPECT(log_range);
+      return {batt::StatusCode::kOutOfRange};
+    }
+    this->scan_lower_bound_ = log_range.lower_bound;
+
+    StatusOr<SlotReadLock> tail_lock =
+        this->volume_.lock_slots(SlotRange{this->scan_lower_bound_, log_range.upper_bound},
+                                 this->options_.mode, "VolumeLogShipper");
+    BATT_REQUIRE_OK(tail_lock);
+
+    this->tail_lock_.emplace(std::move(*tail_lock));
+  }
+
+  if (!slot_less_than(this->scan_lower_bound_, log_range.upper_bound)) {
+    return 0;
+  }
+
+  const SlotRange chunk{this->scan_lower_bound_, log_range.upper_bound};
+
+  StatusOr<SlotReadLock> chunk_lock =
+      this->volume_.lock_slots(chunk, this->options_.mode, "VolumeLogShipper");
+  BATT_REQUIRE_OK(chunk_lock);
+
+  StatusOr<ConstBuffer> chunk_data = this->volume_.get_root_log_data(*chunk_lock, chunk);
+  BATT_REQUIRE_OK(chunk_data);
+
+  auto in_flight = std::make_unique<InFlightBatch>(InFlightBatch{
+      .read_lock = std::move(*chunk_lock),
+      .batch = VolumeReplicationBatch{},
+  });
+
+  // Parse the chunk.  The end of the chunk may be in the middle of a slot (if the log was flushed
+  // part way through it); parsing stops at the last complete slot, and the next chunk starts
+  // there.
+  //
+  BufferedLogDataReader log_data_reader{chunk.lower_bound, *chunk_data};
+  {
+    TypedSlotReader<VolumeEventVariant> slot_reader{log_data_reader};
+    LogVisitor visitor{*this, in_flight->batch};
+
+    StatusOr<usize> slots_read =
+        slot_reader.run(batt::WaitForResource::kFalse, [&visitor](auto&&... args) -> Status {
+          return visitor(args...);
+        });
+
+    BATT_REQUIRE_OK(slots_read);
+  }
+  const slot_offset_type parsed_upper_bound = log_data_reader.slot_offset();
+
+  if (!slot_less_than(this->shipped_upper_bound_, parsed_upper_bound)) {
+    this->scan_lower_bound_ = slot_max(this->scan_lower_bound_, parsed_upper_bound);
+    return 0;
+  }
+
+  VolumeReplicationBatch& batch = in_flight->batch;
+  batch.leader_slot_range = SlotRange{this->shipped_upper_bound_, parsed_upper_bound};
+
+  const u64 shipped_bytes = batch.leader_slot_range.size();
+
+  this->scan_lower_bound_ = parsed_upper_bound;
+  this->shipped_upper_bound_ = parsed_upper_bound;
+
+  // Move the tail lock up to the new scan position; the shipped part of the log is now held by the
+  // batch's lock until it is acknowledged.
+  //
+  {
+    StatusOr<SlotReadLock> tail_lock = this->volume_.lock_slots(
+        SlotRangeSpec{.lower_bound = this->scan_lower_bound_, .upper_bound = None},
+        this->options_.mode, "VolumeLogShipper");
+    BATT_REQUIRE_OK(tail_lock);
+
+    *this->tail_lock_ = std::move(*tail_lock);
+  }
+
+  this->metrics_.batch_count.add(1);
+  this->metrics_.record_count.add(batch.records.size());
+  this->metrics_.shipped_byte_count.add(shipped_bytes);
+
+  // The batch must be in `in_flight_` before it is sent, since it may be acknowledged (and
+  // released) before `send` returns; `batch` must not be touched after that.
+  //
+  {
+    std::unique_lock<std::mutex> lock{this->in_flight_mutex_};
+    this->in_flight_.emplace_back(std::move(in_flight));
+  }
+
+  BATT_REQUIRE_OK(this->sink_.send(batch));
+
+  return shipped_bytes;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeLogShipper::run()
+{
+  while (!this->halt_requested_.load()) {
+    StatusOr<u64> shipped_bytes = this->ship_available();
+    BATT_REQUIRE_OK(shipped_bytes);
+
+    if (*shipped_bytes != 0) {
+      continue;
+    }
+
+    if (this->lag_limit_reached()) {
+      StatusOr<slot_offset_type> acked =
+          this->acked_upper_bound_.await_not_equal(this->acked_upper_bound_.get_value());
+      if (!acked.ok() && this->halt_requested_.load()) {
+        break;
+      }
+      BATT_REQUIRE_OK(acked);
+    } else {
+      StatusOr<SlotRange> synced = this->volume_.sync(
+          this->options_.mode, SlotUpperBoundAt{.offset = this->last_seen_upper_bound_ + 1});
+      BATT_REQUIRE_OK(synced);
+    }
+  }
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeLogShipper::halt()
+{
+  this->halt_requested_.store(true);
+  this->acked_upper_bound_.close();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeLogShipper::acknowledge(slot_offset_type follower_upper_bound)
+{
+  clamp_min_slot(this->acked_upper_bound_, follower_upper_bound);
+
+  std::unique_lock<std::mutex> lock{this->in_flight_mutex_};
+
+  while (!this->in_flight_.empty() &&
+         slot_less_or_equal(this->in_flight_.front()->batch.leader_slot_range.upper_bound,
+                            follower_upper_bound)) {
+    this->in_flight_.pop_front();
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool VolumeLogShipper::lag_limit_reached() const
+{
+  return slot_distance(this->acked_upper_bound_.get_value(), this->shipped_upper_bound_) >=
+         this->options_.max_lag_bytes;
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// VolumeFollower
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+VolumeFollower::VolumeFollower(Volume& volume, slot_offset_type applied_upper_bound) noexcept
+    : volume_{volume}
+    , applied_upper_bound_{applied_upper_bound}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool VolumeFollower::has_page(PageId page_id) const
+{
+  return this->volume_.cache().get_page(page_id, OkIfNotFound{true}).ok();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeFollower::apply(const VolumeReplicationBatch& batch)
+{
+  Optional<slot_offset_type> appended_upper_bound;
+
+  for (const VolumeReplicationRecord& record : batch.records) {
+    if (slot_less_or_equal(record.leader_slot.upper_bound, this->applied_upper_bound_)) {
+      continue;
+    }
+
+    StatusOr<SlotRange> appended = [&]() -> StatusOr<SlotRange> {
+      if (record.is_job) {
+        return this->apply_job(record);
+      }
+
+      StatusOr<batt::Grant> grant = this->volume_.reserve(
+          this->volume_.calculate_grant_size(record.user_data), batt::WaitForResource::kTrue);
+      BATT_REQUIRE_OK(grant);
+
+      return this->volume_.append(record.user_data, *grant);
+    }();
+
+    BATT_REQUIRE_OK(appended) << BATT_INSPECT(record);
+
+    appended_upper_bound = appended->upper_bound;
+  }
+
+  if (appended_upper_bound) {
+    BATT_REQUIRE_OK(this->volume_.sync(LogReadMode::kDurable,
+                                       SlotUpperBoundAt{.offset = *appended_upper_bound}));
+  }
+
+  clamp_min_slot(&this->applied_upper_bound_, batch.leader_slot_range.upper_bound);
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<SlotRange> VolumeFollower::apply_job(const VolumeReplicationRecord& record)
+{
+  // Write the shipped pages first, so that the job can pick them up like pages recovered from a
+  // prepared job (they are not written again when the job is committed).
+  //
+  for (const PinnedPage& page : record.new_pages) {
+    BATT_REQUIRE_OK(this->write_page(page.get_page_buffer()));
+  }
+
+  std::unique_ptr<PageCacheJob> job = this->volume_.new_job();
+
+  for (const PageId& page_id : record.new_page_ids) {
+    BATT_REQUIRE_OK(job->recover_page(page_id, this->volume_.get_volume_uuid(),
+                                      record.leader_slot.lower_bound))
+        << BATT_INSPECT(page_id);
+  }
+  for (const PageId& page_id : record.deleted_page_ids) {
+    BATT_REQUIRE_OK(job->delete_page(page_id));
+  }
+
+  const ReplicatedUserData user_data{
+      .bytes = record.user_data,
+      .root_page_ids = &record.root_page_ids,
+  };
+
+  StatusOr<AppendableJob> appendable = make_appendable_job(std::move(job), PackableRef{user_data});
+  BATT_REQUIRE_OK(appendable);
+
+  StatusOr<batt::Grant> grant = this->volume_.reserve(
+      this->volume_.calculate_grant_size(*appendable), batt::WaitForResource::kTrue);
+  BATT_REQUIRE_OK(grant);
+
+  return this->volume_.append(std::move(*appendable), *grant);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeFollower::write_page(std::shared_ptr<const PageBuffer>&& page_buffer)
+{
+  PageCache& cache = this->volume_.cache();
+  PageDevice& device = cache.arena_for_page_id(page_buffer->page_id()).device();
+
+  return batt::Task::await<Status>([&](auto&& handler) {
+    device.write(cache.prepare_page_for_write(std::move(page_buffer)), BATT_FORWARD(handler));
+  });
+}
+
+}  // namespace llfs
@@ -0,0 +1,321 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_VOLUME_REPLICATION_HPP
+#define LLFS_VOLUME_REPLICATION_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/constants.hpp>
+#include <llfs/int_types.hpp>
+#include <llfs/metrics.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/page_id.hpp>
+#include <llfs/pinned_page.hpp>
+#include <llfs/slot.hpp>
+#include <llfs/slot_read_lock.hpp>
+#include <llfs/status.hpp>
+#include <llfs/volume.hpp>
+
+#include <batteries/async/watch.hpp>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace llfs {
+
+/** \brief One user-visible slot of a leader Volume's root log, as shipped to a follower.
+ */
+struct VolumeReplicationRecord {
+  /** \brief The slot range of the user slot in the leader's root log (for a job, the commit slot).
+   */
+  SlotRange leader_slot;
+
+  /** \brief The user data of the slot; points directly into the leader's root log.
+   */
+  std::string_view user_data;
+
+  /** \brief True if the slot was appended as part of a PageCacheJob.
+   */
+  bool is_job = false;
+
+  /** \brief For a job, its root page refs, new pages and deleted pages.
+   */
+  std::vector<PageId> root_page_ids;
+  std::vector<PageId> new_page_ids;
+  std::vector<PageId> deleted_page_ids;
+
+  /** \brief The contents of the new pages the follower doesn't already have (see
+   * VolumeReplicationSink::needs_page); a subset of `new_page_ids`, pinned in the leader's cache.
+   */
+  std::vector<PinnedPage> new_pages;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const VolumeReplicationRecord& t)
+{
+  return out << "VolumeReplicationRecord{.leader_slot=" << t.leader_slot
+             << ", .user_data.size()=" << t.user_data.size() << ", .is_job=" << t.is_job
+             << ", .new_page_ids.size()=" << t.new_page_ids.size()
+             << ", .new_pages.size()=" << t.new_pages.size() << ",}";
+}
+
+/** \brief A contiguous range of a leader Volume's root log, and the user slots in it.
+ */
+struct VolumeReplicationBatch {
+  /** \brief The range of the leader's log covered by this batch; once a follower has applied the
+   * batch, it has caught up to `leader_slot_range.upper_bound`.
+   */
+  SlotRange leader_slot_range;
+
+  std::vector<VolumeReplicationRecord> records;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief The transport between a VolumeLogShipper and a follower (e.g. a network connection, or
+ * a VolumeFollower in the same process).
+ */
+class VolumeReplicationSink
+{
+ public:
+  VolumeReplicationSink(const VolumeReplicationSink&) = delete;
+  VolumeReplicationSink& operator=(const VolumeReplicationSink&) = delete;
+
+  virtual ~VolumeReplicationSink() = default;
+
+  /** \brief Returns false if the follower already has the page (so its contents need not be
+   * shipped).  Pages are immutable and their ids are never reused with the same generation, so
+   * having the id means having the contents.
+   */
+  virtual bool needs_page(PageId page_id) = 0;
+
+  /** \brief Sends `batch` to the follower.  May return before the follower has applied it: the
+   * memory referenced by the batch (user data and pages) stays valid until the follower's progress
+   * is reported back via VolumeLogShipper::acknowledge.
+   */
+  virtual Status send(const VolumeReplicationBatch& batch) = 0;
+
+ protected:
+  VolumeReplicationSink() = default;
+};
+
+/** \brief Options for VolumeLogShipper.
+ */
+struct VolumeLogShipperOptions {
+  /** \brief Which part of the leader's log to ship: kDurable ships only slots that have been
+   * flushed on the leader.  kSpeculative ships slots as soon as they are committed, which lowers
+   * replication lag, but a follower may then apply slots that the leader loses in a crash.
+   */
+  LogReadMode mode = LogReadMode::kDurable;
+
+  /** \brief The maximum number of bytes of the leader's log that may be shipped but not yet
+   * acknowledged; shipping pauses when this is reached.  Unacknowledged slots can't be trimmed from
+   * the leader's log, so this must be well below the log size.
+   */
+  u64 max_lag_bytes = 1 * kMiB;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Tails the root log of a leader Volume and ships each user slot, together with the new
+ * pages of each committed job, to a follower through a VolumeReplicationSink.
+ *
+ * Shipping is zero-copy: each batch's user data points directly into the leader's log buffer (the
+ * shipper holds a SlotReadLock on the batch's range until it is acknowledged) and its pages are
+ * pinned in the leader's PageCache.  Pages the follower already has are not shipped again.
+ *
+ * Backpressure: at most `max_lag_bytes` of log (plus the one batch being shipped) may be
+ * unacknowledged at any time; `run` waits for acknowledgements before shipping more.
+ *
+ * Multi-Volume jobs are shipped like single-Volume jobs; the follower applies each participant's
+ * part independently.
+ */
+class VolumeLogShipper
+{
+ public:
+  struct Metrics {
+    CountMetric<u64> batch_count{0};
+    CountMetric<u64> record_count{0};
+    CountMetric<u64> shipped_page_count{0};
+    CountMetric<u64> skipped_page_count{0};
+    CountMetric<u64> shipped_byte_count{0};
+  };
+
+  /** \brief Creates a shipper that ships `leader` to `sink`, starting at slot offset
+   * `start_slot` (0 for a new follower; otherwise the follower's applied upper bound).
+   */
+  explicit VolumeLogShipper(Volume& leader, VolumeReplicationSink& sink,
+                            slot_offset_type start_slot,
+                            const VolumeLogShipperOptions& options = {}) noexcept;
+
+  VolumeLogShipper(const VolumeLogShipper&) = delete;
+  VolumeLogShipper& operator=(const VolumeLogShipper&) = delete;
+
+  ~VolumeLogShipper() noexcept;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const Metrics& metrics() const noexcept
+  {
+    return this->metrics_;
+  }
+
+  const VolumeLogShipperOptions& options() const noexcept
+  {
+    return this->options_;
+  }
+
+  /** \brief Ships one batch covering everything appended to the leader's log (at
+   * `options().mode`) since the last batch, unless the lag limit has been reached.  Does not wait
+   * for new slots.  Returns the number of bytes of log shipped (0 if there was nothing to do).
+   */
+  StatusOr<u64> ship_available();
+
+  /** \brief Ships batches as the leader's log grows, until `halt` is called or there is an error.
+   * Should be run on its own Task.
+   */
+  Status run();
+
+  /** \brief Stops `run`.  `run` may not notice until the leader's log grows (or the leader is
+   * halted).
+   */
+  void halt();
+
+  /** \brief Reports that the follower has applied (and made durable) everything up to
+   * `follower_upper_bound`; releases the log and pages held for the batches it covers.  May be
+   * called from any thread, including from inside VolumeReplicationSink::send.
+   */
+  void acknowledge(slot_offset_type follower_upper_bound);
+
+  /** \brief The upper bound of the last batch shipped.
+   */
+  slot_offset_type shipped_upper_bound() const noexcept
+  {
+    return this->shipped_upper_bound_;
+  }
+
+  /** \brief The upper bound of the last batch acknowledged.
+   */
+  slot_offset_type acked_upper_bound() const noexcept
+  {
+    return this->acked_upper_bound_.get_value();
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  class LogVisitor;
+
+  /** \brief The new and deleted pages of a job prepared on the leader but not yet committed.
+   */
+  struct PreparedJob {
+    std::vector<PageId> new_page_ids;
+    std::vector<PageId> deleted_page_ids;
+  };
+
+  /** \brief A shipped batch and the resources it refers to, held until it is acknowledged.
+   */
+  struct InFlightBatch {
+    SlotReadLock read_lock;
+    VolumeReplicationBatch batch;
+  };
+
+  /** \brief Returns true if the unacknowledged part of the shipped log is at the lag limit.
+   */
+  bool lag_limit_reached() const;
+
+  Volume& volume_;
+  VolumeReplicationSink& sink_;
+  const VolumeLogShipperOptions options_;
+  Metrics metrics_;
+
+  // Where the next batch starts parsing; before the first batch this may be earlier than
+  // `start_slot_`, to find the prepare slots of jobs committed after it.
+  //
+  slot_offset_type scan_lower_bound_;
+  const slot_offset_type start_slot_;
+
+  slot_offset_type shipped_upper_bound_;
+  batt::Watch<slot_offset_type> acked_upper_bound_;
+
+  // The upper bound of the leader's log as of the last call to `ship_available`.
+  //
+  slot_offset_type last_seen_upper_bound_;
+
+  // Keeps the part of the leader's log that hasn't been shipped yet from being trimmed; acquired
+  // by the first call to `ship_available`.
+  //
+  Optional<SlotReadLock> tail_lock_;
+
+  std::atomic<bool> halt_requested_{false};
+
+  // Jobs prepared but not yet committed, by prepare slot offset.
+  //
+  std::unordered_map<slot_offset_type, PreparedJob> prepared_jobs_;
+
+  std::mutex in_flight_mutex_;
+  std::deque<std::unique_ptr<InFlightBatch>> in_flight_;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Applies batches shipped by a VolumeLogShipper to a follower Volume.
+ *
+ * User slots without pages are appended as they are.  For a job, its shipped pages are written to
+ * the follower's page devices with their original PageIds, and a job with the same new pages,
+ * deleted pages, root refs and user data is appended to the follower's log; so the follower's page
+ * reference counts follow the leader's.  Slot offsets in the follower's log differ from the
+ * leader's; `applied_upper_bound()` tracks progress in terms of the leader's log.
+ *
+ * The follower's PageCache must have the same page device ids (and page sizes) as the leader's, and
+ * nothing other than the VolumeFollower may allocate pages on it.
+ */
+class VolumeFollower
+{
+ public:
+  /** \brief Creates a follower that applies to `volume`; `applied_upper_bound` is the leader slot
+   * offset the follower has already caught up to (0 for a new follower).
+   */
+  explicit VolumeFollower(Volume& volume, slot_offset_type applied_upper_bound = 0) noexcept;
+
+  VolumeFollower(const VolumeFollower&) = delete;
+  VolumeFollower& operator=(const VolumeFollower&) = delete;
+
+  /** \brief Returns true if the page is present on the follower's page devices.
+   */
+  bool has_page(PageId page_id) const;
+
+  /** \brief Applies `batch` and waits for the result to be durable.  Records the follower has
+   * already applied are skipped, so it is safe to re-apply a batch after a reconnect.
+   */
+  Status apply(const VolumeReplicationBatch& batch);
+
+  slot_offset_type applied_upper_bound() const noexcept
+  {
+    return this->applied_upper_bound_;
+  }
+
+ private:
+  /** \brief Writes `page_buffer` to the follower's device for its page id.
+   */
+  Status write_page(std::shared_ptr<const PageBuffer>&& page_buffer);
+
+  /** \brief Appends the job described by `record` to the follower; returns its slot range.
+   */
+  StatusOr<SlotRange> apply_job(const VolumeReplicationRecord& record);
+
+  Volume& volume_;
+  slot_offset_type applied_upper_bound_;
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_VOLUME_REPLICATION_HPP
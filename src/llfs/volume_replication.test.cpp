@@ -0,0 +1,343 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/volume_replication.hpp>
+//
+#include <llfs/volume_replication.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/testing/fake_log_device.hpp>
+
+#include <llfs/appendable_job.hpp>
+#include <llfs/memory_log_device.hpp>
+#include <llfs/memory_page_cache.hpp>
+#include <llfs/opaque_page_view.hpp>
+#include <llfs/packable_ref.hpp>
+#include <llfs/packed_variant.hpp>
+#include <llfs/page_recycler.hpp>
+
+#include <batteries/async/runtime.hpp>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. Raw slots and jobs appended to a leader Volume are replayed on a follower Volume in order;
+//     the follower ends up with the same user data and the same pages (same ids and contents),
+//     and pages the follower already has are not shipped again.
+//  2. A shipper whose batches are not acknowledged stops shipping once max_lag_bytes is reached,
+//     and resumes after an acknowledgement.
+
+using namespace llfs::constants;
+using namespace llfs::int_types;
+
+constexpr usize kTestRootLogSize = 1 * kMiB;
+constexpr llfs::MaxRefsPerPage kMaxRefsPerPage{8};
+
+// The user data of the test jobs: the ids of the job's new pages (its root set).
+//
+using TestVolumeEvent = llfs::PackedVariant<llfs::PackedArray<llfs::PackedPageId>>;
+
+// A PageCache, root/recycler logs, and a Volume built on top of them.
+//
+struct TestNode {
+  explicit TestNode(const std::string& name)
+  {
+    llfs::StatusOr<batt::SharedPtr<llfs::PageCache>> page_cache_created =
+        llfs::make_memory_page_cache(batt::Runtime::instance().default_scheduler(),
+                                     /*arena_sizes=*/
+                                     {
+                                         {llfs::PageCount{16}, llfs::PageSize{256}},
+                                     },
+                                     kMaxRefsPerPage);
+
+    BATT_CHECK_OK(page_cache_created);
+    this->page_cache = std::move(*page_cache_created);
+
+    BATT_CHECK_OK(llfs::OpaquePageView::register_layout(*this->page_cache));
+
+    const auto recycler_options =
+        llfs::PageRecyclerOptions{}.set_max_refs_per_page(kMaxRefsPerPage);
+
+    this->root_log.emplace(kTestRootLogSize);
+    this->recycler_log.emplace(llfs::PageRecycler::calculate_log_size(recycler_options));
+
+    this->root_log_factory.emplace(llfs::testing::make_fake_log_device_factory(*this->root_log));
+    this->recycler_log_factory.emplace(
+        llfs::testing::make_fake_log_device_factory(*this->recycler_log));
+
+    llfs::StatusOr<std::unique_ptr<llfs::Volume>> recovered = llfs::Volume::recover(
+        llfs::VolumeRecoverParams{
+            &batt::Runtime::instance().default_scheduler(),
+            llfs::VolumeOptions{
+                .name = name,
+                .uuid = llfs::None,
+                .max_refs_per_page = kMaxRefsPerPage,
+                .trim_lock_update_interval = llfs::TrimLockUpdateInterval{0u},
+                .trim_delay_byte_count = llfs::TrimDelayByteCount{0},
+            },
+            this->page_cache,
+            /*root_log=*/&*this->root_log_factory,
+            /*recycler_log=*/&*this->recycler_log_factory,
+            nullptr,
+        },
+        /*slot_visitor_fn=*/[](const llfs::SlotParse&, const std::string_view&) {
+          return llfs::OkStatus();
+        });
+
+    BATT_CHECK_OK(recovered);
+    this->volume = std::move(*recovered);
+  }
+
+  ~TestNode() noexcept
+  {
+    this->volume->halt();
+    this->volume->join();
+  }
+
+  llfs::StatusOr<llfs::SlotRange> append_raw(const std::string_view& user_data)
+  {
+    llfs::StatusOr<batt::Grant> grant = this->volume->reserve(
+        this->volume->calculate_grant_size(user_data), batt::WaitForResource::kFalse);
+    BATT_REQUIRE_OK(grant);
+
+    return this->volume->append(user_data, *grant);
+  }
+
+  // Appends a job that creates `page_count` new pages filled with `fill`, each referenced from the
+  // job's root set; the new page ids are appended to `*page_ids`.
+  //
+  llfs::StatusOr<llfs::SlotRange> append_job(usize page_count, u8 fill,
+                                             std::vector<llfs::PageId>* page_ids)
+  {
+    std::unique_ptr<llfs::PageCacheJob> job = this->volume->new_job();
+    std::vector<llfs::PageId> new_page_ids;
+
+    for (usize i = 0; i < page_count; ++i) {
+      llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> page_allocated =
+          job->new_page(llfs::PageSize{256}, batt::WaitForResource::kFalse,
+                        llfs::OpaquePageView::page_layout_id(), llfs::Caller::Unknown,
+                        /*cancel_token=*/llfs::None);
+      BATT_REQUIRE_OK(page_allocated);
+
+      const llfs::PageId page_id = page_allocated->get()->page_id();
+      llfs::MutableBuffer payload = page_allocated->get()->mutable_payload();
+      std::memset(payload.data(), fill, payload.size());
+
+      BATT_REQUIRE_OK(job->pin_new(std::make_shared<llfs::OpaquePageView>(
+                                       std::move(*page_allocated)),
+                                   llfs::Caller::Unknown));
+
+      new_page_ids.emplace_back(page_id);
+    }
+
+    page_ids->insert(page_ids->end(), new_page_ids.begin(), new_page_ids.end());
+
+    auto event = llfs::pack_as_variant<TestVolumeEvent>(
+        llfs::as_seq(new_page_ids) | llfs::seq::decayed() | llfs::seq::boxed());
+
+    llfs::StatusOr<llfs::AppendableJob> appendable =
+        llfs::make_appendable_job(std::move(job), llfs::PackableRef{event});
+    BATT_REQUIRE_OK(appendable);
+
+    llfs::StatusOr<batt::Grant> grant = this->volume->reserve(
+        this->volume->calculate_grant_size(*appendable), batt::WaitForResource::kFalse);
+    BATT_REQUIRE_OK(grant);
+
+    return this->volume->append(std::move(*appendable), *grant);
+  }
+
+  // Returns the user data of all the slots in the volume's root log.
+  //
+  std::vector<std::string> read_user_data()
+  {
+    llfs::StatusOr<llfs::VolumeReader> reader =
+        this->volume->reader(llfs::SlotRangeSpec{0, llfs::None}, llfs::LogReadMode::kDurable);
+    BATT_CHECK_OK(reader);
+
+    std::vector<std::string> user_data;
+
+    llfs::StatusOr<usize> n_visited = reader->consume_slots(
+        batt::WaitForResource::kFalse,
+        [&user_data](const llfs::SlotParse&, const std::string_view& slot_data) {
+          user_data.emplace_back(slot_data);
+          return llfs::OkStatus();
+        });
+    BATT_CHECK_OK(n_visited);
+
+    return user_data;
+  }
+
+  batt::SharedPtr<llfs::PageCache> page_cache;
+  llfs::Optional<llfs::MemoryLogDevice> root_log;
+  llfs::Optional<llfs::MemoryLogDevice> recycler_log;
+  llfs::Optional<llfs::testing::FakeLogDeviceFactory<llfs::MemoryLogStorageDriver>>
+      root_log_factory;
+  llfs::Optional<llfs::testing::FakeLogDeviceFactory<llfs::MemoryLogStorageDriver>>
+      recycler_log_factory;
+  std::unique_ptr<llfs::Volume> volume;
+};
+
+// Applies each batch to a follower in-process, and (optionally) acknowledges it.
+//
+class TestSink : public llfs::VolumeReplicationSink
+{
+ public:
+  explicit TestSink(llfs::VolumeFollower& follower, bool auto_ack) noexcept
+      : follower_{follower}
+      , auto_ack_{auto_ack}
+  {
+  }
+
+  void set_shipper(llfs::VolumeLogShipper* shipper)
+  {
+    this->shipper_ = shipper;
+  }
+
+  bool needs_page(llfs::PageId page_id) override
+  {
+    return !this->follower_.has_page(page_id);
+  }
+
+  llfs::Status send(const llfs::VolumeReplicationBatch& batch) override
+  {
+    this->sent_slot_ranges.emplace_back(batch.leader_slot_range);
+
+    BATT_REQUIRE_OK(this->follower_.apply(batch));
+
+    if (this->auto_ack_) {
+      this->shipper_->acknowledge(batch.leader_slot_range.upper_bound);
+    }
+    return llfs::OkStatus();
+  }
+
+  std::vector<llfs::SlotRange> sent_slot_ranges;
+
+ private:
+  llfs::VolumeFollower& follower_;
+  const bool auto_ack_;
+  llfs::VolumeLogShipper* shipper_ = nullptr;
+};
+
+// Returns the payload of `page_id` in `cache`, or the empty string if it can't be loaded.
+//
+std::string load_payload(llfs::PageCache& cache, llfs::PageId page_id)
+{
+  llfs::StatusOr<llfs::PinnedPage> loaded = cache.get_page(page_id, llfs::OkIfNotFound{true});
+  if (!loaded.ok()) {
+    return {};
+  }
+  const llfs::ConstBuffer payload = (*loaded)->data()->const_payload();
+  return std::string{static_cast<const char*>(payload.data()), payload.size()};
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST(VolumeReplicationTest, ShipRawSlotsAndJobs)
+{
+  TestNode leader{"leader"};
+  TestNode follower_node{"follower"};
+
+  llfs::VolumeFollower follower{*follower_node.volume};
+  TestSink sink{follower, /*auto_ack=*/true};
+  llfs::VolumeLogShipper shipper{*leader.volume, sink, /*start_slot=*/0,
+                                 llfs::VolumeLogShipperOptions{
+                                     .mode = llfs::LogReadMode::kSpeculative,
+                                 }};
+  sink.set_shipper(&shipper);
+
+  std::vector<llfs::PageId> page_ids;
+
+  ASSERT_TRUE(leader.append_raw("first").ok());
+  ASSERT_TRUE(leader.append_job(/*page_count=*/2, /*fill=*/0xa5, &page_ids).ok());
+  llfs::StatusOr<llfs::SlotRange> last = leader.append_raw("second");
+  ASSERT_TRUE(last.ok());
+
+  llfs::StatusOr<u64> shipped = shipper.ship_available();
+  ASSERT_TRUE(shipped.ok()) << BATT_INSPECT(shipped.status());
+  EXPECT_GT(*shipped, 0u);
+  EXPECT_EQ(shipper.shipped_upper_bound(), last->upper_bound);
+  EXPECT_EQ(shipper.acked_upper_bound(), last->upper_bound);
+  EXPECT_EQ(follower.applied_upper_bound(), last->upper_bound);
+  EXPECT_EQ(shipper.metrics().shipped_page_count.load(), 2u);
+
+  // Nothing new to ship.
+  //
+  shipped = shipper.ship_available();
+  ASSERT_TRUE(shipped.ok());
+  EXPECT_EQ(*shipped, 0u);
+
+  ASSERT_TRUE(leader.append_job(/*page_count=*/1, /*fill=*/0x3c, &page_ids).ok());
+
+  shipped = shipper.ship_available();
+  ASSERT_TRUE(shipped.ok());
+  EXPECT_GT(*shipped, 0u);
+  EXPECT_EQ(shipper.metrics().shipped_page_count.load(), 3u);
+  EXPECT_EQ(shipper.metrics().batch_count.load(), 2u);
+
+  ASSERT_EQ(page_ids.size(), 3u);
+  for (const llfs::PageId& page_id : page_ids) {
+    const std::string expected = load_payload(*leader.page_cache, page_id);
+    ASSERT_FALSE(expected.empty()) << BATT_INSPECT(page_id);
+    EXPECT_EQ(load_payload(*follower_node.page_cache, page_id), expected)
+        << BATT_INSPECT(page_id);
+  }
+
+  EXPECT_EQ(follower_node.read_user_data(), leader.read_user_data());
+  EXPECT_THAT(follower_node.read_user_data(), ::testing::Contains("first"));
+  EXPECT_THAT(follower_node.read_user_data(), ::testing::Contains("second"));
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST(VolumeReplicationTest, LagLimit)
+{
+  TestNode leader{"leader"};
+  TestNode follower_node{"follower"};
+
+  llfs::VolumeFollower follower{*follower_node.volume};
+  TestSink sink{follower, /*auto_ack=*/false};
+  llfs::VolumeLogShipper shipper{*leader.volume, sink, /*start_slot=*/0,
+                                 llfs::VolumeLogShipperOptions{
+                                     .mode = llfs::LogReadMode::kSpeculative,
+                                     .max_lag_bytes = 1,
+                                 }};
+  sink.set_shipper(&shipper);
+
+  ASSERT_TRUE(leader.append_raw("first").ok());
+
+  llfs::StatusOr<u64> shipped = shipper.ship_available();
+  ASSERT_TRUE(shipped.ok());
+  EXPECT_GT(*shipped, 0u);
+  ASSERT_EQ(sink.sent_slot_ranges.size(), 1u);
+
+  ASSERT_TRUE(leader.append_raw("second").ok());
+
+  shipped = shipper.ship_available();
+  ASSERT_TRUE(shipped.ok());
+  EXPECT_EQ(*shipped, 0u);
+  EXPECT_EQ(sink.sent_slot_ranges.size(), 1u);
+
+  shipper.acknowledge(sink.sent_slot_ranges.back().upper_bound);
+
+  shipped = shipper.ship_available();
+  ASSERT_TRUE(shipped.ok());
+  EXPECT_GT(*shipped, 0u);
+  EXPECT_EQ(sink.sent_slot_ranges.size(), 2u);
+
+  EXPECT_EQ(follower_node.read_user_data(), leader.read_user_data());
+}
+
+}  // namespace
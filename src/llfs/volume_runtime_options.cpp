@@ -22,6 +22,7 @@ namespace llfs {
       .root_log_options = IoRingLogDriverOptions::with_default_values(),
       .recycler_log_options = IoRingLogDriverOptions::with_default_values(),
       .trim_control = nullptr,
+      .trimmer_options = VolumeTrimmerOptions{},
   };
 }
 
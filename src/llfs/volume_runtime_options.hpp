@@ -13,6 +13,7 @@
 #include <llfs/ioring_log_driver_options.hpp>
 #include <llfs/slot_lock_manager.hpp>
 #include <llfs/volume_reader.hpp>
+#include <llfs/volume_trimmer.hpp>
 
 #include <batteries/async/task_scheduler.hpp>
 
@@ -26,7 +27,8 @@ struct VolumeRuntimeOptions {
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   // A slot visitor that will be invoked to rebuild the application-specific Volume state by
-  // replaying the events found in the root log.
+  // replaying the events found in the root log.  May be empty, in which case recovery can skip the
+  // part of the log covered by the latest Volume metadata checkpoint.
   //
   VolumeReader::SlotVisitorFn slot_visitor_fn;
 
@@ -42,6 +44,10 @@ struct VolumeRuntimeOptions {
   // `nullptr`, a new SlotLockManager will be created.
   //
   std::shared_ptr<SlotLockManager> trim_control;
+
+  // Controls incremental trimming of the root log; see VolumeTrimmerOptions.
+  //
+  VolumeTrimmerOptions trimmer_options;
 };
 
 }  // namespace llfs
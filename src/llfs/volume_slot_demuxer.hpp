@@ -26,8 +26,12 @@ using VolumePendingJobsMap =
 //
 // Only known committed jobs are passed on to the user-level slot visitor.
 //
+// `Fn` is called directly (it is not type-erased unless it is itself a std::function), and the
+// `operator()` overloads below dispatch to this class's handlers without a virtual call, so a
+// demuxer invoked from a TypedSlotReader visitor is fully inlinable.
+//
 template <typename R, typename Fn = VolumeReader::SlotVisitorFn>
-class VolumeSlotDemuxer : public VolumeEventVisitor<StatusOr<R>>
+class VolumeSlotDemuxer final : public VolumeEventVisitor<StatusOr<R>>
 {
  public:
   template <typename FnArg>
@@ -74,6 +78,37 @@ class VolumeSlotDemuxer : public VolumeEventVisitor<StatusOr<R>>
 
   StatusOr<R> on_volume_trim(const SlotParse&, const VolumeTrimEvent&) override;
 
+  StatusOr<R> on_volume_metadata_checkpoint(
+      const SlotParse&, const Ref<const PackedVolumeMetadataCheckpoint>&) override;
+
+  StatusOr<R> on_prepare_job_link(const SlotParse&,
+                                  const Ref<const PackedPrepareJobLink>&) override;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+  // Statically dispatched event handlers; these hide VolumeEventVisitor::operator().
+  //
+#define LLFS_VOLUME_SLOT_DEMUXER_DISPATCH(EVENT_TYPE, METHOD_NAME)                                 \
+  StatusOr<R> operator()(const SlotParse& slot, const EVENT_TYPE& event)                           \
+  {                                                                                                \
+    return this->VolumeSlotDemuxer::METHOD_NAME(slot, event);                                      \
+  }
+
+  LLFS_VOLUME_SLOT_DEMUXER_DISPATCH(Ref<const PackedRawData>, on_raw_data)
+  LLFS_VOLUME_SLOT_DEMUXER_DISPATCH(Ref<const PackedPrepareJob>, on_prepare_job)
+  LLFS_VOLUME_SLOT_DEMUXER_DISPATCH(Ref<const PackedCommitJob>, on_commit_job)
+  LLFS_VOLUME_SLOT_DEMUXER_DISPATCH(PackedRollbackJob, on_rollback_job)
+  LLFS_VOLUME_SLOT_DEMUXER_DISPATCH(PackedVolumeAttachEvent, on_volume_attach)
+  LLFS_VOLUME_SLOT_DEMUXER_DISPATCH(PackedVolumeDetachEvent, on_volume_detach)
+  LLFS_VOLUME_SLOT_DEMUXER_DISPATCH(PackedVolumeIds, on_volume_ids)
+  LLFS_VOLUME_SLOT_DEMUXER_DISPATCH(PackedVolumeRecovered, on_volume_recovered)
+  LLFS_VOLUME_SLOT_DEMUXER_DISPATCH(PackedVolumeFormatUpgrade, on_volume_format_upgrade)
+  LLFS_VOLUME_SLOT_DEMUXER_DISPATCH(VolumeTrimEvent, on_volume_trim)
+  LLFS_VOLUME_SLOT_DEMUXER_DISPATCH(Ref<const PackedVolumeMetadataCheckpoint>,
+                                    on_volume_metadata_checkpoint)
+  LLFS_VOLUME_SLOT_DEMUXER_DISPATCH(Ref<const PackedPrepareJobLink>, on_prepare_job_link)
+
+#undef LLFS_VOLUME_SLOT_DEMUXER_DISPATCH
+
  private:
   // Updates internal state to reflect having visited the given slot.
   //
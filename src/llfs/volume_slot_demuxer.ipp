@@ -205,6 +205,36 @@ StatusOr<R> VolumeSlotDemuxer<R, Fn>::on_volume_trim(const SlotParse& slot,
   return this->base_.on_volume_trim(slot, trim);
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename R, typename Fn>
+StatusOr<R> VolumeSlotDemuxer<R, Fn>::on_volume_metadata_checkpoint(
+    const SlotParse& slot, const Ref<const PackedVolumeMetadataCheckpoint>& checkpoint) /*override*/
+{
+  auto on_scope_exit = batt::finally([&] {
+    this->mark_slot_visited(slot);
+  });
+
+  LLFS_VLOG(1) << "on_volume_metadata_checkpoint(" << BATT_INSPECT(slot) << ")";
+
+  return this->base_.on_volume_metadata_checkpoint(slot, checkpoint);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+template <typename R, typename Fn>
+StatusOr<R> VolumeSlotDemuxer<R, Fn>::on_prepare_job_link(
+    const SlotParse& slot, const Ref<const PackedPrepareJobLink>& link) /*override*/
+{
+  auto on_scope_exit = batt::finally([&] {
+    this->mark_slot_visited(slot);
+  });
+
+  LLFS_VLOG(1) << "on_prepare_job_link(" << BATT_INSPECT(slot) << ")";
+
+  return this->base_.on_prepare_job_link(slot, link);
+}
+
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
 //
 template <typename R, typename Fn>
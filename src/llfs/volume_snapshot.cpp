@@ -0,0 +1,77 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/volume_snapshot.hpp>
+//
+
+#include <llfs/seq.hpp>
+
+#include <unordered_set>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ VolumeSnapshot::VolumeSnapshot(const SlotRange& covered_slot_range,
+                                            const SlotRange& snapshot_slot,
+                                            std::vector<PageId>&& root_page_ids,
+                                            SlotReadLock&& lock) noexcept
+    : covered_slot_range_{covered_slot_range}
+    , snapshot_slot_{snapshot_slot}
+    , root_page_ids_{std::move(root_page_ids)}
+    , lock_{std::move(lock)}
+{
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeSnapshot::release() noexcept
+{
+  this->lock_.clear();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeSnapshot::visit_pages(PageLoader& page_loader, const PageVisitorFn& fn) const
+{
+  if (!this->lock_) {
+    return {batt::StatusCode::kFailedPrecondition};
+  }
+
+  std::unordered_set<PageId, PageId::Hash> visited{this->root_page_ids_.begin(),
+                                                   this->root_page_ids_.end()};
+  std::vector<PageId> frontier = this->root_page_ids_;
+  std::vector<PageId> next_frontier;
+  std::vector<PageId> refs;
+
+  while (!frontier.empty()) {
+    next_frontier.clear();
+
+    for (const PageId& page_id : frontier) {
+      StatusOr<PinnedPage> page = page_loader.get_page(page_id, OkIfNotFound{false});
+      BATT_REQUIRE_OK(page) << BATT_INSPECT(page_id);
+
+      BATT_REQUIRE_OK(fn(*page));
+
+      refs.clear();
+      page->get()->append_refs_and_delta_base(&refs);
+
+      for (const PageId& ref : refs) {
+        if (ref && visited.insert(ref).second) {
+          next_frontier.emplace_back(ref);
+        }
+      }
+    }
+
+    std::swap(frontier, next_frontier);
+  }
+
+  return OkStatus();
+}
+
+}  // namespace llfs
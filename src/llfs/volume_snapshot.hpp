@@ -0,0 +1,118 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_VOLUME_SNAPSHOT_HPP
+#define LLFS_VOLUME_SNAPSHOT_HPP
+
+#include <llfs/config.hpp>
+//
+#include <llfs/page_id.hpp>
+#include <llfs/page_loader.hpp>
+#include <llfs/pinned_page.hpp>
+#include <llfs/slot.hpp>
+#include <llfs/slot_read_lock.hpp>
+#include <llfs/status.hpp>
+
+#include <functional>
+#include <ostream>
+#include <vector>
+
+namespace llfs {
+
+/** \brief A point-in-time view of the pages reachable from a Volume's root set; see
+ * Volume::snapshot.
+ *
+ * The snapshot holds one extra ref count on each of its root pages, recorded in the snapshot slot
+ * (a job with no new pages whose root set is the Volume's root set at the time the snapshot was
+ * taken).  Since pages are immutable, and every page reachable from a root stays alive as long as
+ * the root does, the entire tree of pages stays readable until the snapshot slot is trimmed.
+ *
+ * While the snapshot is held, a SlotReadLock keeps the root log from being trimmed at or past the
+ * snapshot slot.  Releasing the snapshot (or destroying it) releases the lock; the extra ref counts
+ * are dropped when the Volume's trimmer trims the snapshot slot.  Because the lock also blocks
+ * trimming of everything appended after the snapshot, long-running readers must keep an eye on
+ * root log space.
+ */
+class VolumeSnapshot
+{
+ public:
+  using PageVisitorFn = std::function<Status(const PinnedPage& page)>;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  /*explicit*/ VolumeSnapshot(const SlotRange& covered_slot_range, const SlotRange& snapshot_slot,
+                              std::vector<PageId>&& root_page_ids, SlotReadLock&& lock) noexcept;
+
+  VolumeSnapshot(const VolumeSnapshot&) = delete;
+  VolumeSnapshot& operator=(const VolumeSnapshot&) = delete;
+
+  VolumeSnapshot(VolumeSnapshot&&) = default;
+  VolumeSnapshot& operator=(VolumeSnapshot&&) = default;
+
+  /** \brief The part of the root log whose committed jobs make up the snapshot: every job whose
+   * commit slot is in this range (and not yet trimmed when the snapshot was taken) is included.
+   */
+  const SlotRange& covered_slot_range() const noexcept
+  {
+    return this->covered_slot_range_;
+  }
+
+  /** \brief The slot range (prepare and commit) of the job that holds the snapshot's ref counts.
+   */
+  const SlotRange& snapshot_slot() const noexcept
+  {
+    return this->snapshot_slot_;
+  }
+
+  /** \brief The distinct root page ids of the snapshot, sorted.
+   */
+  const std::vector<PageId>& root_page_ids() const noexcept
+  {
+    return this->root_page_ids_;
+  }
+
+  /** \brief Returns true until `release()` is called.
+   */
+  bool is_held() const noexcept
+  {
+    return static_cast<bool>(this->lock_);
+  }
+
+  /** \brief Allows the snapshot slot to be trimmed, which drops the snapshot's ref counts.  After
+   * this is called, pages of the snapshot may be recycled at any time.
+   */
+  void release() noexcept;
+
+  /** \brief Loads every page reachable from the snapshot's roots (each exactly once, roots first,
+   * then breadth-first) and passes it to `fn`.
+   *
+   * Returns kFailedPrecondition if the snapshot has been released.  Stops at the first error
+   * returned by `fn` or by `page_loader`.
+   */
+  Status visit_pages(PageLoader& page_loader, const PageVisitorFn& fn) const;
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+ private:
+  SlotRange covered_slot_range_;
+  SlotRange snapshot_slot_;
+  std::vector<PageId> root_page_ids_;
+  SlotReadLock lock_;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const VolumeSnapshot& t)
+{
+  return out << "VolumeSnapshot{.covered_slot_range=" << t.covered_slot_range()
+             << ", .snapshot_slot=" << t.snapshot_slot()
+             << ", .root_page_ids.size()=" << t.root_page_ids().size()
+             << ", .is_held=" << t.is_held() << ",}";
+}
+
+}  // namespace llfs
+
+#endif  // LLFS_VOLUME_SNAPSHOT_HPP
@@ -0,0 +1,280 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/volume_snapshot.hpp>
+//
+#include <llfs/volume_snapshot.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/testing/fake_log_device.hpp>
+
+#include <llfs/appendable_job.hpp>
+#include <llfs/memory_log_device.hpp>
+#include <llfs/memory_page_cache.hpp>
+#include <llfs/opaque_page_view.hpp>
+#include <llfs/packable_ref.hpp>
+#include <llfs/packed_variant.hpp>
+#include <llfs/page_recycler.hpp>
+#include <llfs/volume.hpp>
+
+#include <batteries/async/runtime.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Test Plan:
+//  1. A snapshot's root set is the set of distinct root pages of all committed jobs; taking it
+//     adds exactly one ref to each, and visit_pages visits each page once.  The snapshot slot is
+//     visited as a user slot with the passed user data.
+//  2. The pages of a snapshot stay alive (and readable) after the jobs that created them are
+//     trimmed; visit_pages fails once the snapshot is released.
+
+using namespace llfs::constants;
+using namespace llfs::int_types;
+
+constexpr usize kTestRootLogSize = 1 * kMiB;
+constexpr llfs::MaxRefsPerPage kMaxRefsPerPage{8};
+
+// The user data of the test jobs: the ids of the job's root pages.
+//
+using TestVolumeEvent = llfs::PackedVariant<llfs::PackedArray<llfs::PackedPageId>>;
+
+class VolumeSnapshotTest : public ::testing::Test
+{
+ public:
+  void SetUp() override
+  {
+    llfs::StatusOr<batt::SharedPtr<llfs::PageCache>> page_cache_created =
+        llfs::make_memory_page_cache(batt::Runtime::instance().default_scheduler(),
+                                     /*arena_sizes=*/
+                                     {
+                                         {llfs::PageCount{16}, llfs::PageSize{256}},
+                                     },
+                                     kMaxRefsPerPage);
+
+    ASSERT_TRUE(page_cache_created.ok());
+    this->page_cache = std::move(*page_cache_created);
+
+    ASSERT_TRUE(llfs::OpaquePageView::register_layout(*this->page_cache).ok());
+
+    const auto recycler_options =
+        llfs::PageRecyclerOptions{}.set_max_refs_per_page(kMaxRefsPerPage);
+
+    this->root_log.emplace(kTestRootLogSize);
+    this->recycler_log.emplace(llfs::PageRecycler::calculate_log_size(recycler_options));
+
+    this->root_log_factory.emplace(llfs::testing::make_fake_log_device_factory(*this->root_log));
+    this->recycler_log_factory.emplace(
+        llfs::testing::make_fake_log_device_factory(*this->recycler_log));
+
+    llfs::StatusOr<std::unique_ptr<llfs::Volume>> recovered = llfs::Volume::recover(
+        llfs::VolumeRecoverParams{
+            &batt::Runtime::instance().default_scheduler(),
+            llfs::VolumeOptions{
+                .name = "test_volume",
+                .uuid = llfs::None,
+                .max_refs_per_page = kMaxRefsPerPage,
+                .trim_lock_update_interval = llfs::TrimLockUpdateInterval{0u},
+                .trim_delay_byte_count = llfs::TrimDelayByteCount{0},
+            },
+            this->page_cache,
+            /*root_log=*/&*this->root_log_factory,
+            /*recycler_log=*/&*this->recycler_log_factory,
+            nullptr,
+        },
+        /*slot_visitor_fn=*/[](const llfs::SlotParse&, const std::string_view&) {
+          return llfs::OkStatus();
+        });
+
+    ASSERT_TRUE(recovered.ok()) << BATT_INSPECT(recovered.status());
+    this->volume = std::move(*recovered);
+  }
+
+  void TearDown() override
+  {
+    if (this->volume) {
+      this->volume->halt();
+      this->volume->join();
+    }
+  }
+
+  // Appends a job that creates `page_count` new pages; its root set is the new pages plus
+  // `extra_roots`.  The new page ids are appended to `*page_ids`.
+  //
+  llfs::StatusOr<llfs::SlotRange> append_job(usize page_count,
+                                             const std::vector<llfs::PageId>& extra_roots,
+                                             std::vector<llfs::PageId>* page_ids)
+  {
+    std::unique_ptr<llfs::PageCacheJob> job = this->volume->new_job();
+    std::vector<llfs::PageId> root_ids = extra_roots;
+
+    for (usize i = 0; i < page_count; ++i) {
+      llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> page_allocated =
+          job->new_page(llfs::PageSize{256}, batt::WaitForResource::kFalse,
+                        llfs::OpaquePageView::page_layout_id(), llfs::Caller::Unknown,
+                        /*cancel_token=*/llfs::None);
+      BATT_REQUIRE_OK(page_allocated);
+
+      const llfs::PageId page_id = page_allocated->get()->page_id();
+      llfs::MutableBuffer payload = page_allocated->get()->mutable_payload();
+      std::memset(payload.data(), 0x5a, payload.size());
+
+      BATT_REQUIRE_OK(job->pin_new(std::make_shared<llfs::OpaquePageView>(
+                                       std::move(*page_allocated)),
+                                   llfs::Caller::Unknown));
+
+      root_ids.emplace_back(page_id);
+      page_ids->emplace_back(page_id);
+    }
+
+    auto event = llfs::pack_as_variant<TestVolumeEvent>(
+        llfs::as_seq(root_ids) | llfs::seq::decayed() | llfs::seq::boxed());
+
+    llfs::StatusOr<llfs::AppendableJob> appendable =
+        llfs::make_appendable_job(std::move(job), llfs::PackableRef{event});
+    BATT_REQUIRE_OK(appendable);
+
+    llfs::StatusOr<batt::Grant> grant = this->volume->reserve(
+        this->volume->calculate_grant_size(*appendable), batt::WaitForResource::kFalse);
+    BATT_REQUIRE_OK(grant);
+
+    return this->volume->append(std::move(*appendable), *grant);
+  }
+
+  i32 get_ref_count(llfs::PageId page_id) const
+  {
+    return this->page_cache->arena_for_page_id(page_id).allocator().get_ref_count(page_id).first;
+  }
+
+  batt::SharedPtr<llfs::PageCache> page_cache;
+  llfs::Optional<llfs::MemoryLogDevice> root_log;
+  llfs::Optional<llfs::MemoryLogDevice> recycler_log;
+  llfs::Optional<llfs::testing::FakeLogDeviceFactory<llfs::MemoryLogStorageDriver>>
+      root_log_factory;
+  llfs::Optional<llfs::testing::FakeLogDeviceFactory<llfs::MemoryLogStorageDriver>>
+      recycler_log_factory;
+  std::unique_ptr<llfs::Volume> volume;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 1.
+//
+TEST_F(VolumeSnapshotTest, RootSetRefCounts)
+{
+  std::vector<llfs::PageId> page_ids;
+
+  ASSERT_TRUE(this->append_job(/*page_count=*/2, /*extra_roots=*/{}, &page_ids).ok());
+
+  // The second job also references the first page of the first job.
+  //
+  ASSERT_TRUE(this->append_job(/*page_count=*/1, /*extra_roots=*/{page_ids[0]}, &page_ids).ok());
+  ASSERT_EQ(page_ids.size(), 3u);
+
+  std::vector<i32> ref_counts_before;
+  for (const llfs::PageId& page_id : page_ids) {
+    ref_counts_before.emplace_back(this->get_ref_count(page_id));
+  }
+
+  llfs::StatusOr<llfs::VolumeSnapshot> snapshot =
+      this->volume->snapshot("snapshot-1", batt::WaitForResource::kFalse);
+
+  ASSERT_TRUE(snapshot.ok()) << BATT_INSPECT(snapshot.status());
+  EXPECT_TRUE(snapshot->is_held());
+
+  std::vector<llfs::PageId> expected_roots = page_ids;
+  std::sort(expected_roots.begin(), expected_roots.end());
+  EXPECT_EQ(snapshot->root_page_ids(), expected_roots);
+
+  for (usize i = 0; i < page_ids.size(); ++i) {
+    EXPECT_EQ(this->get_ref_count(page_ids[i]), ref_counts_before[i] + 1)
+        << BATT_INSPECT(page_ids[i]);
+  }
+
+  std::vector<llfs::PageId> visited;
+  llfs::Status visit_status =
+      snapshot->visit_pages(*this->page_cache, [&visited](const llfs::PinnedPage& page) {
+        visited.emplace_back(page.page_id());
+        return llfs::OkStatus();
+      });
+
+  ASSERT_TRUE(visit_status.ok()) << BATT_INSPECT(visit_status);
+  EXPECT_THAT(visited, ::testing::UnorderedElementsAreArray(page_ids));
+
+  // The snapshot slot is the last user slot in the log.
+  //
+  llfs::StatusOr<llfs::VolumeReader> reader = this->volume->reader(
+      llfs::SlotRangeSpec{llfs::None, llfs::None}, llfs::LogReadMode::kDurable);
+  ASSERT_TRUE(reader.ok());
+
+  std::vector<std::string> user_data;
+  llfs::StatusOr<usize> n_visited = reader->consume_slots(
+      batt::WaitForResource::kFalse,
+      [&user_data](const llfs::SlotParse&, const std::string_view& slot_data) {
+        user_data.emplace_back(slot_data);
+        return llfs::OkStatus();
+      });
+
+  ASSERT_TRUE(n_visited.ok());
+  ASSERT_EQ(user_data.size(), 3u);
+  EXPECT_EQ(user_data.back(), "snapshot-1");
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+// 2.
+//
+TEST_F(VolumeSnapshotTest, PagesSurviveTrim)
+{
+  std::vector<llfs::PageId> page_ids;
+
+  ASSERT_TRUE(this->append_job(/*page_count=*/2, /*extra_roots=*/{}, &page_ids).ok());
+
+  const i32 ref_count_before = this->get_ref_count(page_ids[0]);
+
+  llfs::StatusOr<llfs::VolumeSnapshot> snapshot =
+      this->volume->snapshot("snapshot-2", batt::WaitForResource::kFalse);
+
+  ASSERT_TRUE(snapshot.ok()) << BATT_INSPECT(snapshot.status());
+
+  // Trim the job that created the pages; the snapshot lock stops the trim at the snapshot slot.
+  //
+  const llfs::slot_offset_type trim_pos = snapshot->snapshot_slot().lower_bound;
+
+  ASSERT_TRUE(this->volume->trim(trim_pos).ok());
+  ASSERT_TRUE(this->volume->await_trim(trim_pos).ok());
+
+  for (const llfs::PageId& page_id : page_ids) {
+    EXPECT_EQ(this->get_ref_count(page_id), ref_count_before) << BATT_INSPECT(page_id);
+  }
+
+  usize visit_count = 0;
+  llfs::Status visit_status =
+      snapshot->visit_pages(*this->page_cache, [&visit_count](const llfs::PinnedPage&) {
+        visit_count += 1;
+        return llfs::OkStatus();
+      });
+
+  ASSERT_TRUE(visit_status.ok()) << BATT_INSPECT(visit_status);
+  EXPECT_EQ(visit_count, page_ids.size());
+
+  snapshot->release();
+  EXPECT_FALSE(snapshot->is_held());
+
+  visit_status = snapshot->visit_pages(*this->page_cache, [](const llfs::PinnedPage&) {
+    return llfs::OkStatus();
+  });
+
+  EXPECT_EQ(visit_status, batt::StatusCode::kFailedPrecondition);
+}
+
+}  // namespace
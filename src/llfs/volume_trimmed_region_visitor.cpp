@@ -15,7 +15,8 @@ namespace llfs {
 //
 StatusOr<VolumeTrimmedRegionInfo> read_trimmed_region(
     TypedSlotReader<VolumeEventVariant>& slot_reader, VolumeMetadataRefresher& metadata_refresher,
-    HaveTrimEventGrant have_trim_event_grant, slot_offset_type trim_upper_bound)
+    HaveTrimEventGrant have_trim_event_grant, slot_offset_type trim_upper_bound,
+    Optional<u64> max_region_size)
 {
   VolumeTrimmedRegionInfo trimmed_region;
   trimmed_region.slot_range.lower_bound = slot_reader.next_slot_offset();
@@ -36,11 +37,15 @@ StatusOr<VolumeTrimmedRegionInfo> read_trimmed_region(
         const bool ends_after_trim_pos =  //
             slot_less_than(trim_upper_bound, slot_range.upper_bound);
 
-        const bool will_visit = starts_before_trim_pos && !ends_after_trim_pos;
+        const bool exceeds_max_size =
+            max_region_size && !trimmed_region.slot_range.empty() &&
+            slot_range.upper_bound - trimmed_region.slot_range.lower_bound > *max_region_size;
+
+        const bool will_visit = starts_before_trim_pos && !ends_after_trim_pos && !exceeds_max_size;
 
         LLFS_VLOG(1) << "read slot: " << BATT_INSPECT(slot_range) << BATT_INSPECT(slot_size)
                      << BATT_INSPECT(starts_before_trim_pos) << BATT_INSPECT(ends_after_trim_pos)
-                     << BATT_INSPECT(will_visit);
+                     << BATT_INSPECT(exceeds_max_size) << BATT_INSPECT(will_visit);
 
         if (!will_visit) {
           reached_end = true;
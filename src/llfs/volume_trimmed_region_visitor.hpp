@@ -29,10 +29,14 @@ BATT_STRONG_TYPEDEF(bool, HaveTrimEventGrant);
 
 /** \brief Reads slots from the passed reader, up to the given slot upper bound, collecting the
  * information needed to trim the log.
+ *
+ * If `max_region_size` is specified, the scan also stops before the first slot that would make the
+ * region larger than that (but the region always includes at least one slot if any are available).
  */
 StatusOr<VolumeTrimmedRegionInfo> read_trimmed_region(
     TypedSlotReader<VolumeEventVariant>& slot_reader, VolumeMetadataRefresher& metadata_refresher,
-    HaveTrimEventGrant have_trim_event_grant, slot_offset_type trim_upper_bound);
+    HaveTrimEventGrant have_trim_event_grant, slot_offset_type trim_upper_bound,
+    Optional<u64> max_region_size = None);
 
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 /** \brief Scans regions to be trimmed, saving information in a VolumeTrimmedRegionInfo struct.
@@ -11,11 +11,15 @@
 
 #include <llfs/page_cache_job.hpp>
 #include <llfs/slot_reader.hpp>
+#include <llfs/trace_span.hpp>
 #include <llfs/volume_trimmed_region_visitor.hpp>
 #include <llfs/volume_trimmer_recovery_visitor.hpp>
 
+#include <batteries/async/task.hpp>
 #include <batteries/stream_util.hpp>
 
+#include <algorithm>
+
 namespace llfs {
 namespace {
 
@@ -68,7 +72,8 @@ const usize kTrimEventGrantSize =
     TypedSlotWriter<VolumeEventVariant>& slot_writer,  //
     VolumeDropRootsFn&& drop_roots,                    //
     SlotLockManager& trim_control,                     //
-    VolumeMetadataRefresher& metadata_refresher)
+    VolumeMetadataRefresher& metadata_refresher,       //
+    const VolumeTrimmerOptions& options)
 {
   // Recover VolumeTrimmer state.  It is important that we do this only once all jobs have been
   // resolved and metadata (such as attachments) has been appended.
@@ -145,7 +150,7 @@ const usize kTrimEventGrantSize =
   //
   return std::make_unique<VolumeTrimmer>(trimmer_uuid, std::move(name), trim_control, trim_delay,
                                          std::move(log_reader), slot_writer, std::move(drop_roots),
-                                         metadata_refresher);
+                                         metadata_refresher, options);
 }
 
 //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -157,7 +162,8 @@ const usize kTrimEventGrantSize =
                                           std::unique_ptr<LogDevice::Reader>&& log_reader,   //
                                           TypedSlotWriter<VolumeEventVariant>& slot_writer,  //
                                           VolumeDropRootsFn&& drop_roots_fn,                 //
-                                          VolumeMetadataRefresher& metadata_refresher) noexcept
+                                          VolumeMetadataRefresher& metadata_refresher,       //
+                                          const VolumeTrimmerOptions& options) noexcept
     : trimmer_uuid_{trimmer_uuid}
     , name_{std::move(name)}
     , trim_control_{trim_control}
@@ -169,6 +175,7 @@ const usize kTrimEventGrantSize =
     , trimmer_grant_{BATT_OK_RESULT_OR_PANIC(
           this->slot_writer_.reserve(0, batt::WaitForResource::kFalse))}
     , metadata_refresher_{metadata_refresher}
+    , options_{options}
 {
   LLFS_VLOG(1) << "VolumeTrimmer::VolumeTrimmer" << BATT_INSPECT_STR(this->name_);
 
@@ -244,6 +251,14 @@ Status VolumeTrimmer::run()
     //
     least_upper_bound = *trim_upper_bound + 1;
 
+    // In incremental mode, pace the trim and limit how far this step goes.
+    //
+    StatusOr<Optional<u64>> max_step_size = this->await_trim_step();
+    if (!max_step_size.ok() && (this->halt_requested_ || this->trim_control_.is_closed())) {
+      return OkStatus();
+    }
+    BATT_REQUIRE_OK(max_step_size);
+
     LLFS_VLOG(1) << "new value for " << BATT_INSPECT(*trim_upper_bound) << "; scanning log slots ["
                  << this->slot_reader_.next_slot_offset() << "," << (*trim_upper_bound) << ")"
                  << BATT_INSPECT(this->trimmer_grant_.size());
@@ -253,9 +268,12 @@ Status VolumeTrimmer::run()
     //
     LLFS_VLOG(1) << "[VolumeTrimmer] read_trimmed_region";
     //
-    StatusOr<VolumeTrimmedRegionInfo> trimmed_region_info = read_trimmed_region(
-        this->slot_reader_, this->metadata_refresher_,
-        HaveTrimEventGrant{this->trimmer_grant_.size() >= kTrimEventGrantSize}, *trim_upper_bound);
+    StatusOr<VolumeTrimmedRegionInfo> trimmed_region_info = LLFS_TRACE_SPAN_EXPR(
+        "trimmer", "read_trimmed_region",
+        read_trimmed_region(this->slot_reader_, this->metadata_refresher_,
+                            HaveTrimEventGrant{this->trimmer_grant_.size() >= kTrimEventGrantSize},
+                            *trim_upper_bound,
+                            /*max_region_size=*/*max_step_size));
 
     BATT_REQUIRE_OK(trimmed_region_info);
 
@@ -284,10 +302,24 @@ Status VolumeTrimmer::run()
       // Make sure all Volume metadata has been refreshed.
       //
       if (this->metadata_refresher_.needs_flush()) {
+        LLFS_TRACE_SPAN("trimmer", "refresh_metadata");
+
         StatusOr<SlotRange> metadata_slots = this->metadata_refresher_.flush();
         BATT_REQUIRE_OK(metadata_slots);
 
         clamp_min_slot(&sync_point, metadata_slots->upper_bound);
+
+        // Follow each refresh with a metadata checkpoint, so that recovery never has to replay
+        // (much) more than one refresh interval of the log.
+        //
+        StatusOr<SlotRange> checkpoint_slot = this->metadata_refresher_.write_checkpoint(
+            /*trim_pos=*/trimmed_region_info->slot_range.upper_bound);
+
+        if (checkpoint_slot.ok()) {
+          clamp_min_slot(&sync_point, checkpoint_slot->upper_bound);
+        } else {
+          LLFS_VLOG(1) << "[VolumeTrimmer] checkpoint not written: " << checkpoint_slot.status();
+        }
       }
 
       //+++++++++++-+-+--+----- --- -- -  -  -   -
@@ -300,7 +332,9 @@ Status VolumeTrimmer::run()
         //
         BATT_ASSIGN_OK_RESULT(
             trim_event_info,
-            write_trim_event(this->slot_writer_, this->trimmer_grant_, *trimmed_region_info));
+            LLFS_TRACE_SPAN_EXPR(
+                "trimmer", "write_trim_event",
+                write_trim_event(this->slot_writer_, this->trimmer_grant_, *trimmed_region_info)));
 
         clamp_min_slot(&sync_point, trim_event_info->trim_event_slot.upper_bound);
       }
@@ -312,6 +346,7 @@ Status VolumeTrimmer::run()
         LLFS_VLOG(1) << "Flushing trim event," << BATT_INSPECT(*sync_point) << ";"
                      << BATT_INSPECT(trimmed_region_info->slot_range);
         //
+        LLFS_TRACE_SPAN("trimmer", "sync");
         BATT_REQUIRE_OK(
             this->slot_writer_.sync(LogReadMode::kDurable, SlotUpperBoundAt{*sync_point}));
       }
@@ -325,14 +360,26 @@ Status VolumeTrimmer::run()
     BATT_DEBUG_INFO("VolumeTrimmer -> trim_volume_log;" << BATT_INSPECT(this->name_));
 
     LLFS_VLOG(1) << "[VolumeTrimmer] trim_volume_log";
-    Status trim_result = trim_volume_log(
-        this->trimmer_uuid_, this->slot_writer_, this->trimmer_grant_, std::move(trim_event_info),
-        std::move(*trimmed_region_info), this->metadata_refresher_, this->drop_roots_);
+    Status trim_result = LLFS_TRACE_SPAN_EXPR(
+        "trimmer", "trim_volume_log",
+        trim_volume_log(this->trimmer_uuid_, this->slot_writer_, this->trimmer_grant_,
+                        std::move(trim_event_info), std::move(*trimmed_region_info),
+                        this->metadata_refresher_, this->drop_roots_));
 
     this->trim_count_.fetch_add(1);
 
     BATT_REQUIRE_OK(trim_result);
 
+    // If this was a partial (incremental) step, continue with the rest of the current target
+    // without waiting for it to advance.
+    //
+    if (*max_step_size) {
+      this->consume_trim_budget(new_trim_target - trim_lower_bound);
+      if (slot_less_than(new_trim_target, *trim_upper_bound)) {
+        least_upper_bound = *trim_upper_bound;
+      }
+    }
+
     // Update the trim position and repeat the loop.
     //
     bytes_trimmed += (new_trim_target - trim_lower_bound);
@@ -358,6 +405,80 @@ StatusOr<slot_offset_type> VolumeTrimmer::await_trim_target(slot_offset_type min
 
   return new_trim_target;
 }
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<u64> VolumeTrimmer::get_max_step_size() const
+{
+  if (this->options_.incremental_step_size == 0) {
+    return None;
+  }
+
+  const u64 capacity = this->slot_writer_.log_capacity();
+  const u64 available = this->slot_writer_.pool_size();
+
+  if (available * 100 < capacity * this->options_.urgent_available_percent) {
+    return None;
+  }
+
+  // Take bigger steps as the log fills up.
+  //
+  const u64 scale = std::max<u64>(1, capacity / std::max<u64>(1, available * 2));
+
+  return this->options_.incremental_step_size * scale;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<Optional<u64>> VolumeTrimmer::await_trim_step()
+{
+  // Sleep in short steps while waiting for the rate limit, so that a drop in available log space
+  // (which makes trimming urgent) or a halt request is noticed promptly.
+  //
+  static constexpr auto kMaxThrottleSleep = std::chrono::milliseconds(10);
+
+  for (;;) {
+    const Optional<u64> max_step_size = this->get_max_step_size();
+    if (!max_step_size || this->options_.max_bytes_per_second == 0) {
+      return max_step_size;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= this->next_step_time_) {
+      return max_step_size;
+    }
+
+    if (this->halt_requested_ || this->trim_control_.is_closed()) {
+      return Status{batt::StatusCode::kCancelled};
+    }
+
+    const i64 delay_usec = std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::min<std::chrono::steady_clock::duration>(
+                                   this->next_step_time_ - now, kMaxThrottleSleep))
+                               .count();
+
+    this->throttle_delay_usec_.fetch_add(delay_usec);
+
+    batt::Task::sleep(boost::posix_time::microseconds(delay_usec));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeTrimmer::consume_trim_budget(u64 byte_count)
+{
+  const u64 bytes_per_second = this->options_.max_bytes_per_second;
+  if (bytes_per_second == 0) {
+    return;
+  }
+
+  const auto step_duration = std::chrono::microseconds(byte_count * 1000000 / bytes_per_second);
+
+  // Don't let idle time accumulate into a burst allowance.
+  //
+  this->next_step_time_ =
+      std::max(this->next_step_time_, std::chrono::steady_clock::now()) + step_duration;
+}
 //
 // class VolumeTrimmer
 //#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
@@ -23,6 +23,7 @@
 #include <llfs/volume_trimmed_region_info.hpp>
 
 #include <atomic>
+#include <chrono>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -34,6 +35,32 @@ using VolumeDropRootsFn = std::function<batt::Status(const boost::uuids::uuid& t
                                                      slot_offset_type trim_event_slot_offset,
                                                      Slice<const PageId> root_ref_page_ids)>;
 
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief Runtime options that control how eagerly a VolumeTrimmer trims.
+ *
+ * By default, each trim goes all the way to the latest trim target.  With incremental trimming
+ * enabled, the trimmer advances in steps of about `incremental_step_size` bytes, optionally paced
+ * to `max_bytes_per_second`, so that the page ref count updates for dropped roots are spread out
+ * over time instead of landing in bursts.  Steps get larger as the log fills up (at under half
+ * available, the step size is scaled by `log_capacity / (2 * available)`), and once less than
+ * `urgent_available_percent` of the log is available to reserve, the trimmer goes back to trimming
+ * to the full target without delay.
+ */
+struct VolumeTrimmerOptions {
+  /** \brief The nominal number of bytes per incremental trim step; 0 disables incremental
+   * trimming.
+   */
+  u64 incremental_step_size = 0;
+
+  /** \brief The maximum (non-urgent) trim rate in log bytes per second; 0 means no limit.
+   */
+  u64 max_bytes_per_second = 0;
+
+  /** \brief The available log space percentage below which trimming is urgent.
+   */
+  u32 urgent_available_percent = 10;
+};
+
 //=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
 /** \brief Information about a durably committed PackedVolumeTrimEvent.
  */
@@ -88,7 +115,8 @@ class VolumeTrimmer
       TypedSlotWriter<VolumeEventVariant>& slot_writer,  //
       VolumeDropRootsFn&& drop_roots,                    //
       SlotLockManager& trim_control,                     //
-      VolumeMetadataRefresher& metadata_refresher);
+      VolumeMetadataRefresher& metadata_refresher,       //
+      const VolumeTrimmerOptions& options = VolumeTrimmerOptions{});
 
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
@@ -99,7 +127,8 @@ class VolumeTrimmer
                          std::unique_ptr<LogDevice::Reader>&& log_reader,   //
                          TypedSlotWriter<VolumeEventVariant>& slot_writer,  //
                          VolumeDropRootsFn&& drop_roots_fn,                 //
-                         VolumeMetadataRefresher& metadata_refresher) noexcept;
+                         VolumeMetadataRefresher& metadata_refresher,       //
+                         const VolumeTrimmerOptions& options = VolumeTrimmerOptions{}) noexcept;
 
   VolumeTrimmer(const VolumeTrimmer&) = delete;
   VolumeTrimmer& operator=(const VolumeTrimmer&) = delete;
@@ -130,6 +159,13 @@ class VolumeTrimmer
     return this->trim_count_.load();
   }
 
+  /** \brief The total time (usec) the trimmer has spent pacing incremental trim steps.
+   */
+  u64 throttle_delay_usec() const noexcept
+  {
+    return this->throttle_delay_usec_.load();
+  }
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
  private:
@@ -143,6 +179,22 @@ class VolumeTrimmer
    */
   StatusOr<slot_offset_type> await_trim_target(slot_offset_type min_offset);
 
+  /** \brief Returns the maximum size of the next trim step, or None if the next trim should go all
+   * the way to the trim target (incremental trimming is off, or the log is nearly full).
+   */
+  Optional<u64> get_max_step_size() const;
+
+  /** \brief Blocks until the rate limit allows the next incremental trim step, returning its
+   * maximum size (see get_max_step_size); this may return None early if trimming becomes urgent.
+   *
+   * \return batt::StatusCode::kCancelled if the trimmer is halted while waiting
+   */
+  StatusOr<Optional<u64>> await_trim_step();
+
+  /** \brief Charges a completed incremental step of `byte_count` bytes against the rate limit.
+   */
+  void consume_trim_budget(u64 byte_count);
+
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
   /** \brief The unique identifier for this trimmer; used to prevent page refcount
@@ -196,6 +248,18 @@ class VolumeTrimmer
   /** \brief The number of trim operations completed.
    */
   std::atomic<u64> trim_count_{0};
+
+  /** \brief Controls incremental trimming.
+   */
+  const VolumeTrimmerOptions options_;
+
+  /** \brief The earliest time at which the next rate-limited trim step may start.
+   */
+  std::chrono::steady_clock::time_point next_step_time_ = std::chrono::steady_clock::now();
+
+  /** \brief The total time spent pacing trim steps.
+   */
+  std::atomic<u64> throttle_delay_usec_{0};
 };
 
 }  // namespace llfs
@@ -97,6 +97,8 @@ class VolumeTrimmerTest : public ::testing::Test
 
     u64 trim_delay_byte_count = 0;
 
+    u64 incremental_step_size = 0;
+
     llfs::slot_offset_type highest_seen_drop_pages_client_slot = 0;
 
     std::map<llfs::slot_offset_type, JobInfo> pending_jobs;
@@ -270,6 +272,11 @@ void VolumeTrimmerTest::SimRun::reset(unsigned random_seed, const Config& config
   }
 
   this->trim_delay_byte_count = this->pick_usize(0, 16) * 64;
+
+  // Run every third seed with incremental trimming; derive the step size from the seed (rather than
+  // the rng) so the rest of the pseudo-random sequence is the same either way.
+  //
+  this->incremental_step_size = (random_seed % 3 == 2) ? ((random_seed / 3) % 8 + 1) * 64 : 0;
   this->highest_seen_drop_pages_client_slot = 0;
   this->pending_jobs.clear();
   this->committed_jobs.clear();
@@ -793,9 +800,13 @@ void VolumeTrimmerTest::TrimmerSession::initialize(const Config& config, SimRun&
         [this](auto&&... args) -> decltype(auto) {
           return this->handle_drop_roots(BATT_FORWARD(args)...);
         },
-        *this->log->trim_control,       //
-        *this->log->metadata_refresher  //
-    );
+        *this->log->trim_control,        //
+        *this->log->metadata_refresher,  //
+        llfs::VolumeTrimmerOptions{
+            .incremental_step_size = this->sim->incremental_step_size,
+            .max_bytes_per_second = 0,
+            .urgent_available_percent = 10,
+        });
 
     ASSERT_TRUE(new_trimmer.ok()) << BATT_INSPECT(new_trimmer.status());
 
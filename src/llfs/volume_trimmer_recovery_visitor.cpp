@@ -120,4 +120,20 @@ Status VolumeTrimmerRecoveryVisitor::on_volume_trim(const SlotParse& slot,
   return OkStatus();
 }
 
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeTrimmerRecoveryVisitor::on_volume_metadata_checkpoint(
+    const SlotParse&, const Ref<const PackedVolumeMetadataCheckpoint>&) /*override*/
+{
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeTrimmerRecoveryVisitor::on_prepare_job_link(
+    const SlotParse&, const Ref<const PackedPrepareJobLink>&) /*override*/
+{
+  return OkStatus();
+}
+
 }  //namespace llfs
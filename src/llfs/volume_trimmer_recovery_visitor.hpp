@@ -53,6 +53,11 @@ class VolumeTrimmerRecoveryVisitor : public VolumeEventVisitor<Status>
   Status on_volume_format_upgrade(const SlotParse&, const PackedVolumeFormatUpgrade&) override;
 
   Status on_volume_trim(const SlotParse&, const VolumeTrimEvent&) override;
+
+  Status on_volume_metadata_checkpoint(const SlotParse&,
+                                       const Ref<const PackedVolumeMetadataCheckpoint>&) override;
+
+  Status on_prepare_job_link(const SlotParse&, const Ref<const PackedPrepareJobLink>&) override;
   //
   //+++++++++++-+-+--+----- --- -- -  -  -   -
 
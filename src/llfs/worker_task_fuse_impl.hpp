@@ -13,11 +13,15 @@
 #include <llfs/config.hpp>
 //
 #include <llfs/fuse.hpp>
+#include <llfs/fuse_metrics.hpp>
 #include <llfs/logging.hpp>
+#include <llfs/pooled_string.hpp>
 #include <llfs/worker_task.hpp>
 
+#include <chrono>
 #include <memory>
 #include <utility>
+#include <vector>
 
 namespace llfs {
 
@@ -26,7 +30,18 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
 {
  public:
   explicit WorkerTaskFuseImpl(std::shared_ptr<WorkQueue>&& work_queue) noexcept
-      : work_queue_{std::move(work_queue)}
+      : work_queues_{std::move(work_queue)}
+  {
+  }
+
+  /** \brief Creates an impl that spreads requests over several work queues, choosing the queue by
+   * the index of the thread that received the request (see FuseSession::current_thread_index), so
+   * that with one queue per FuseSession reader thread, readers never contend on a shared queue.
+   *
+   * If `work_queues` is empty, requests are handled directly on the thread that received them.
+   */
+  explicit WorkerTaskFuseImpl(std::vector<std::shared_ptr<WorkQueue>>&& work_queues) noexcept
+      : work_queues_{std::move(work_queues)}
   {
   }
 
@@ -43,8 +58,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
     LLFS_VLOG(1) << BATT_THIS_FUNCTION << BATT_INSPECT(req) << BATT_INSPECT(parent)
                  << BATT_INSPECT(name);
 
-    batt::Status push_status = this->work_queue_->push_job(
-        [this, req, parent, name = std::string{name}, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kLookup,
+        [this, req, parent, name = PooledString{name}, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->lookup(req, parent, name));
         });
 
@@ -61,8 +77,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
     LLFS_VLOG(1) << BATT_THIS_FUNCTION << BATT_INSPECT(req) << BATT_INSPECT(ino)
                  << BATT_INSPECT(nlookup);
 
-    batt::Status push_status =
-        this->work_queue_->push_job([this, req, ino, nlookup, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kForgetInode,
+        [this, req, ino, nlookup, handler = BATT_FORWARD(handler)] {
           auto on_scope_exit = batt::finally([&] {
             BATT_FORWARD(handler)();
           });
@@ -84,8 +101,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
                  << BATT_INSPECT(req)   //
                  << BATT_INSPECT(ino);
 
-    batt::Status push_status =
-        this->work_queue_->push_job([this, req, ino, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kGetAttributes,
+        [this, req, ino, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->get_attributes(req, ino));
         });
 
@@ -123,7 +141,8 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
       return batt::None;
     }();
 
-    batt::Status push_status = this->work_queue_->push_job(
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kSetAttributes,
         [this, req, ino, attr = *attr, to_set, fh, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)
           (this->derived_this()->set_attributes(req, ino, &attr, to_set, fh));
@@ -141,8 +160,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
   {
     LLFS_VLOG(1) << BATT_THIS_FUNCTION << BATT_INSPECT(req) << BATT_INSPECT(ino);
 
-    batt::Status push_status =
-        this->work_queue_->push_job([this, req, ino, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kReadlink,
+        [this, req, ino, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->readlink(req, ino));
         });
 
@@ -164,8 +184,10 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
                  << BATT_INSPECT(DumpFileMode{mode})  //
                  << BATT_INSPECT(rdev);
 
-    batt::Status push_status = this->work_queue_->push_job(
-        [this, req, parent, name = std::string{name}, mode, rdev, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kMakeNode,
+        [this, req, parent, name = PooledString{name}, mode, rdev,
+         handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->make_node(req, parent, name, mode, rdev));
         });
 
@@ -183,8 +205,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
     LLFS_VLOG(1) << BATT_THIS_FUNCTION << BATT_INSPECT(req) << BATT_INSPECT(parent)
                  << BATT_INSPECT(name) << BATT_INSPECT(DumpFileMode{mode});
 
-    batt::Status push_status = this->work_queue_->push_job(
-        [this, req, parent, name = std::string{name}, mode, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kMakeDirectory,
+        [this, req, parent, name = PooledString{name}, mode, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->make_directory(req, parent, name, mode));
         });
 
@@ -201,8 +224,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
     LLFS_VLOG(1) << BATT_THIS_FUNCTION << BATT_INSPECT(req) << BATT_INSPECT(parent)
                  << BATT_INSPECT(name);
 
-    batt::Status push_status = this->work_queue_->push_job(
-        [this, req, parent, name = std::string{name}, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kUnlink,
+        [this, req, parent, name = PooledString{name}, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->unlink(req, parent, name));
         });
 
@@ -220,8 +244,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
     LLFS_VLOG(1) << BATT_THIS_FUNCTION << BATT_INSPECT(req) << BATT_INSPECT(parent)
                  << BATT_INSPECT(name);
 
-    batt::Status push_status = this->work_queue_->push_job(
-        [this, req, parent, name = std::string{name}, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kRemoveDirectory,
+        [this, req, parent, name = PooledString{name}, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->remove_directory(req, parent, name));
         });
 
@@ -239,9 +264,10 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
     LLFS_VLOG(1) << BATT_THIS_FUNCTION << BATT_INSPECT(req) << BATT_INSPECT(link)
                  << BATT_INSPECT(parent) << BATT_INSPECT(name);
 
-    batt::Status push_status =
-        this->work_queue_->push_job([this, req, link = std::string{link}, parent,
-                                     name = std::string{name}, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kSymbolicLink,
+        [this, req, link = PooledString{link}, parent,
+                                     name = PooledString{name}, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->symbolic_link(req, link, parent, name));
         });
 
@@ -260,8 +286,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
                  << BATT_INSPECT(name) << BATT_INSPECT(newparent) << BATT_INSPECT(newname)
                  << BATT_INSPECT(flags);
 
-    batt::Status push_status = this->work_queue_->push_job(
-        [this, req, parent, name = std::string{name}, newparent, newname = std::string{newname},
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kRename,
+        [this, req, parent, name = PooledString{name}, newparent, newname = PooledString{newname},
          flags, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)
           (this->derived_this()->rename(req, parent, name, newparent, newname, flags));
@@ -281,8 +308,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
     LLFS_VLOG(1) << BATT_THIS_FUNCTION << BATT_INSPECT(req) << BATT_INSPECT(ino)
                  << BATT_INSPECT(newparent) << BATT_INSPECT(newname);
 
-    batt::Status push_status =
-        this->work_queue_->push_job([this, req, ino, newparent, newname = std::string{newname},
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kHardLink,
+        [this, req, ino, newparent, newname = PooledString{newname},
                                      handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->hard_link(req, ino, newparent, newname));
         });
@@ -302,8 +330,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
 
     BATT_CHECK_NOT_NULLPTR(fi);
 
-    batt::Status push_status =
-        this->work_queue_->push_job([this, req, ino, fi = *fi, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kOpen,
+        [this, req, ino, fi = *fi, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->open(req, ino, fi));
         });
 
@@ -321,7 +350,8 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
     LLFS_VLOG(1) << BATT_THIS_FUNCTION << BATT_INSPECT(req) << BATT_INSPECT(ino)
                  << BATT_INSPECT(size) << BATT_INSPECT(offset) << BATT_INSPECT(fh);
 
-    batt::Status push_status = this->work_queue_->push_job(
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kRead,
         [this, req, ino, size, offset, fh, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->read(req, ino, size, offset, fh));
         });
@@ -341,7 +371,8 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
                  << BATT_INSPECT(batt::make_printable(buffer)) << BATT_INSPECT(offset)
                  << BATT_INSPECT(fh);
 
-    batt::Status push_status = this->work_queue_->push_job(
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kWrite,
         [this, req, ino, buffer, offset, fh, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->write(req, ino, buffer, offset, fh));
         });
@@ -359,8 +390,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
     LLFS_VLOG(1) << BATT_THIS_FUNCTION << BATT_INSPECT(req) << BATT_INSPECT(ino)
                  << BATT_INSPECT(fh);
 
-    batt::Status push_status =
-        this->work_queue_->push_job([this, req, ino, fh, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kFlush,
+        [this, req, ino, fh, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->flush(req, ino, fh));
         });
 
@@ -378,8 +410,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
     LLFS_VLOG(1) << BATT_THIS_FUNCTION << BATT_INSPECT(req) << BATT_INSPECT(ino)
                  << BATT_INSPECT(fh);
 
-    batt::Status push_status =
-        this->work_queue_->push_job([this, req, ino, fh, flags, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kRelease,
+        [this, req, ino, fh, flags, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->release(req, ino, fh, flags));
         });
 
@@ -397,7 +430,8 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
     LLFS_VLOG(1) << BATT_THIS_FUNCTION << BATT_INSPECT(req) << BATT_INSPECT(ino)
                  << BATT_INSPECT(datasync) << BATT_INSPECT(fh);
 
-    batt::Status push_status = this->work_queue_->push_job(
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kFsync,
         [this, req, ino, datasync, fh, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->fsync(req, ino, datasync, fh));
         });
@@ -417,8 +451,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
 
     BATT_CHECK_NOT_NULLPTR(fi);
 
-    batt::Status push_status =
-        this->work_queue_->push_job([this, req, ino, fi = *fi, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kOpendir,
+        [this, req, ino, fi = *fi, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->opendir(req, ino, fi));
         });
 
@@ -440,7 +475,8 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
                  << BATT_INSPECT(off)   //
                  << BATT_INSPECT(fh);
 
-    batt::Status push_status = this->work_queue_->push_job(
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kReaddir,
         [this, req, ino, size, off, fh, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)
           (this->derived_this()->readdir(req, ino, size, off, fh));
@@ -461,8 +497,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
                  << BATT_INSPECT(ino)   //
                  << BATT_INSPECT(fh);
 
-    batt::Status push_status =
-        this->work_queue_->push_job([this, req, ino, fh, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kReleasedir,
+        [this, req, ino, fh, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->releasedir(req, ino, fh));
         });
 
@@ -483,7 +520,8 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
                  << BATT_INSPECT(datasync)  //
                  << BATT_INSPECT(fh);
 
-    batt::Status push_status = this->work_queue_->push_job(
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kFsyncdir,
         [this, req, ino, datasync, fh, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)
           (this->derived_this()->fsyncdir(req, ino, datasync, fh));
@@ -503,8 +541,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
                  << BATT_INSPECT(req)   //
                  << BATT_INSPECT(ino);
 
-    batt::Status push_status =
-        this->work_queue_->push_job([this, req, ino, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kStatfs,
+        [this, req, ino, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->statfs(req, ino));
         });
 
@@ -526,8 +565,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
                  << BATT_INSPECT(batt::make_printable(attr))  //
                  << BATT_INSPECT(flags);
 
-    batt::Status push_status =
-        this->work_queue_->push_job([this, req, ino, attr, flags, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kSetExtendedAttribute,
+        [this, req, ino, attr, flags, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)
           (this->derived_this()->set_extended_attribute(req, ino, attr, flags));
         });
@@ -549,8 +589,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
                  << BATT_INSPECT(name)  //
                  << BATT_INSPECT(size);
 
-    batt::Status push_status = this->work_queue_->push_job(
-        [this, req, ino, name = std::string{name}, size, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kGetExtendedAttribute,
+        [this, req, ino, name = PooledString{name}, size, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)
           (this->derived_this()->get_extended_attribute(req, ino, name, size));
         });
@@ -572,8 +613,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
                  << BATT_INSPECT(ino)   //
                  << BATT_INSPECT(name);
 
-    batt::Status push_status = this->work_queue_->push_job(
-        [this, req, ino, name = std::string{name}, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kRemoveExtendedAttribute,
+        [this, req, ino, name = PooledString{name}, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->remove_extended_attribute(req, ino, name));
         });
 
@@ -592,8 +634,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
                  << BATT_INSPECT(ino)   //
                  << BATT_INSPECT(mask);
 
-    batt::Status push_status =
-        this->work_queue_->push_job([this, req, ino, mask, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kCheckAccess,
+        [this, req, ino, mask, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->check_access(req, ino, mask));
         });
 
@@ -617,8 +660,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
 
     BATT_CHECK_NOT_NULLPTR(fi);
 
-    batt::Status push_status =
-        this->work_queue_->push_job([this, req, parent, name = std::string{name}, mode, fi = *fi,
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kCreate,
+        [this, req, parent, name = PooledString{name}, mode, fi = *fi,
                                      handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->create(req, parent, name, mode, fi));
         });
@@ -648,7 +692,8 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
 
     BATT_CHECK_NOT_NULLPTR(fi);
 
-    batt::Status push_status = this->work_queue_->push_job(
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kIoctl,
         [this, req, ino, cmd, arg, fi, flags, in_buf, out_bufsz, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)
           (this->derived_this()->ioctl(req, ino, cmd, arg, fi, flags, in_buf, out_bufsz));
@@ -673,7 +718,8 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
                  << BATT_INSPECT(offset)  //
                  << BATT_INSPECT(fh);
 
-    batt::Status push_status = this->work_queue_->push_job(
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kWriteBuf,
         [this, req, ino, bufv, offset, fh, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)(this->derived_this()->write_buf(req, ino, bufv, offset, fh));
         });
@@ -696,7 +742,8 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
                  << BATT_INSPECT(offset)  //
                  << BATT_INSPECT(bufv);
 
-    batt::Status push_status = this->work_queue_->push_job(
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kRetrieveReply,
         [this, req, cookie, ino, offset, bufv, handler = BATT_FORWARD(handler)] {
           auto on_scope_exit = batt::finally([&] {
             BATT_FORWARD(handler)();
@@ -720,8 +767,9 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
                  << BATT_INSPECT(req)   //
         /*<< BATT_INSPECT(batt::make_printable(forgets)) TODO [tastolfi 2023-06-30] */;
 
-    batt::Status push_status =
-        this->work_queue_->push_job([this, req, forgets, handler = BATT_FORWARD(handler)] {
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kForgetMultipleInodes,
+        [this, req, forgets, handler = BATT_FORWARD(handler)] {
           auto on_scope_exit = batt::finally([&] {
             BATT_FORWARD(handler)();
           });
@@ -748,7 +796,8 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
                  << BATT_INSPECT(length)              //
                  << BATT_INSPECT(fi);
 
-    batt::Status push_status = this->work_queue_->push_job(
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kFileAllocate,
         [this, req, ino, mode, offset, length, fi, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)
           (this->derived_this()->file_allocate(req, ino, mode, offset, length, fi));
@@ -772,7 +821,8 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
                  << BATT_INSPECT(offset)  //
                  << BATT_INSPECT(fh);
 
-    batt::Status push_status = this->work_queue_->push_job(
+    batt::Status push_status = this->push_job(
+        FuseOpcode::kReaddirplus,
         [this, req, ino, size, offset, fh, handler = BATT_FORWARD(handler)] {
           BATT_FORWARD(handler)
           (this->derived_this()->readdirplus(req, ino, size, offset, fh));
@@ -784,7 +834,78 @@ class WorkerTaskFuseImpl : public FuseImpl<Derived>
   }
 
  private:
-  std::shared_ptr<WorkQueue> work_queue_;
+  /** \brief Runs `work_fn` on one of the work queues (or inline, if there are none), updating the
+   * FuseMetrics for `opcode`.
+   *
+   * If the push fails, the request is no longer counted as in-flight when this function returns;
+   * the caller is responsible for replying.
+   */
+  template <typename WorkFn>
+  batt::Status push_job(FuseOpcode opcode, WorkFn&& work_fn)
+  {
+    FuseMetrics& metrics = FuseMetrics::instance();
+    FuseMetrics::OpMetrics& op_metrics = metrics.op(opcode);
+
+    op_metrics.count.add(1);
+    op_metrics.in_flight.add(1);
+
+    const bool sampled = metrics.sampler.sample();
+
+    const usize n_queues = this->work_queues_.size();
+    if (n_queues == 0) {
+      run_job(op_metrics, sampled, work_fn);
+      return batt::OkStatus();
+    }
+
+    const usize queue_index =
+        (n_queues == 1) ? 0 : (FuseSession::current_thread_index() % n_queues);
+
+    WorkQueue& work_queue = *this->work_queues_[queue_index];
+
+    const auto push_time = sampled ? std::chrono::steady_clock::now()
+                                   : std::chrono::steady_clock::time_point{};
+
+    op_metrics.queue_depth.add(1);
+
+    batt::Status push_status = work_queue.push_job(
+        [&op_metrics, sampled, push_time, work_fn = BATT_FORWARD(work_fn)]() mutable {
+          op_metrics.queue_depth.add(-1);
+          if (sampled) {
+            op_metrics.queue_latency.update(push_time);
+          }
+          run_job(op_metrics, sampled, work_fn);
+        });
+
+    if (!push_status.ok()) {
+      op_metrics.queue_depth.add(-1);
+      op_metrics.in_flight.add(-1);
+    }
+    return push_status;
+  }
+
+  /** \brief Runs `work_fn`, timing it if `sampled` is true, and then marks the request as no
+   * longer in-flight.
+   */
+  template <typename WorkFn>
+  static void run_job(FuseMetrics::OpMetrics& op_metrics, bool sampled, WorkFn& work_fn)
+  {
+    auto on_scope_exit = batt::finally([&] {
+      op_metrics.in_flight.add(-1);
+    });
+
+    if (!sampled) {
+      work_fn();
+      return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    work_fn();
+    op_metrics.handler_latency.update(start);
+  }
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  std::vector<std::shared_ptr<WorkQueue>> work_queues_;
 };
 
 }  //namespace llfs
@@ -0,0 +1,117 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/xor_filter.hpp>
+//
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void build_xor_filter_from_hashes(std::vector<u64>& item_hashes, PackedXorFilter* filter)
+{
+  // Construction fails with probability < 1% per seed at the configured size (and very much less
+  // with the extra slots), so running out of seeds means something else is wrong.
+  //
+  static constexpr u64 kMaxSeedAttempts = 64;
+
+  // Identical hashes would always collide in all three slots, so the filter could never be built.
+  //
+  std::sort(item_hashes.begin(), item_hashes.end());
+  item_hashes.erase(std::unique(item_hashes.begin(), item_hashes.end()), item_hashes.end());
+
+  BATT_CHECK_GE(filter->segment_length,
+                PackedXorFilter::segment_length_for_item_count(item_hashes.size()))
+      << "The filter is too small";
+
+  // While peeling, each slot holds the xor of (and the number of) the item hashes that map to it;
+  // a slot with count == 1 therefore holds the hash of its only item.
+  //
+  struct Slot {
+    u64 hash_xor;
+    u32 count;
+  };
+
+  const usize slot_count = filter->slot_count();
+  std::vector<Slot> slots(slot_count);
+  std::vector<usize> ready;
+  std::vector<std::pair<u64, usize>> peeled;
+  peeled.reserve(item_hashes.size());
+
+  for (u64 attempt = 0;; ++attempt) {
+    BATT_CHECK_LT(attempt, kMaxSeedAttempts) << "Failed to build XOR filter";
+
+    filter->seed = PackedXorFilter::mix_hash(attempt, 0x9e3779b97f4a7c15ull);
+
+    std::fill(slots.begin(), slots.end(), Slot{0, 0});
+    for (u64 item_hash : item_hashes) {
+      const PackedXorFilter::Probe p = filter->probe_from_item_hash(item_hash);
+      for (usize slot : p.slot) {
+        slots[slot].hash_xor ^= item_hash;
+        slots[slot].count += 1;
+      }
+    }
+
+    ready.clear();
+    for (usize i = 0; i < slot_count; ++i) {
+      if (slots[i].count == 1) {
+        ready.push_back(i);
+      }
+    }
+
+    // Repeatedly remove an item that is alone in one of its slots; that slot is the one that will
+    // be assigned to determine the item's fingerprint.
+    //
+    peeled.clear();
+    while (!ready.empty()) {
+      const usize i = ready.back();
+      ready.pop_back();
+      if (slots[i].count != 1) {
+        continue;
+      }
+
+      const u64 item_hash = slots[i].hash_xor;
+      peeled.emplace_back(item_hash, i);
+
+      const PackedXorFilter::Probe p = filter->probe_from_item_hash(item_hash);
+      for (usize slot : p.slot) {
+        slots[slot].hash_xor ^= item_hash;
+        slots[slot].count -= 1;
+        if (slots[slot].count == 1) {
+          ready.push_back(slot);
+        }
+      }
+    }
+
+    if (peeled.size() == item_hashes.size()) {
+      break;
+    }
+  }
+
+  // Assign the fingerprints in the reverse of the peeling order: each item's assigned slot is not
+  // used by any item assigned before it, so its fingerprint can be fixed up there.
+  //
+  std::memset(filter->fingerprints, 0, slot_count * filter->fingerprint_size());
+
+  for (auto iter = peeled.rbegin(); iter != peeled.rend(); ++iter) {
+    const auto& [item_hash, assigned_slot] = *iter;
+    const PackedXorFilter::Probe p = filter->probe_from_item_hash(item_hash);
+
+    // The assigned slot is still 0, so xor-ing all three is the same as xor-ing the other two.
+    //
+    filter->set_fingerprint(assigned_slot, p.fingerprint ^ filter->get_fingerprint(p.slot[0]) ^
+                                               filter->get_fingerprint(p.slot[1]) ^
+                                               filter->get_fingerprint(p.slot[2]));
+  }
+}
+
+}  // namespace llfs
@@ -0,0 +1,242 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_XOR_FILTER_HPP
+#define LLFS_XOR_FILTER_HPP
+
+#include <llfs/data_layout.hpp>
+#include <llfs/int_types.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/async/slice_work.hpp>
+#include <batteries/async/work_context.hpp>
+#include <batteries/async/worker_pool.hpp>
+#include <batteries/checked_cast.hpp>
+#include <batteries/static_assert.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace llfs {
+
+struct XorFilterParams {
+  // The size of each fingerprint: 8 (false positive rate about 0.4%, about 9.9 bits per item) or
+  // 16 (about 0.0015%, about 19.7 bits per item).
+  //
+  usize fingerprint_bits = 8;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// A static approximate-membership filter (Graf & Lemire, "Xor Filters: Faster and Smaller Than
+// Bloom and Cuckoo Filters"): each item maps to three slots, one in each third of the fingerprint
+// array, and the filter is built so that the xor of those three slots is the item's fingerprint.
+//
+// A query always reads exactly 3 fingerprints.  For the same false positive rate, an XOR filter
+// takes less space than a PackedBloomFilter, but it can't be added to after it is built (which
+// suits pages, since they are immutable).
+//
+struct PackedXorFilter {
+  // Seeds the hash that maps items to slots; chosen at build time (see
+  // build_xor_filter_from_hashes).
+  //
+  little_u64 seed;
+
+  // The number of slots in each of the three segments.
+  //
+  little_u32 segment_length;
+
+  // 8 or 16.
+  //
+  little_u8 fingerprint_bits;
+
+  little_u8 reserved_[3];
+
+  // `3 * segment_length` fingerprints (of `fingerprint_bits / 8` bytes each, little-endian) start
+  // here.
+  //
+  little_u8 fingerprints[1];
+
+  //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  // The filter has 1.23 slots per item, plus this many, so that construction is very likely to
+  // succeed on the first try even for small item counts.
+  //
+  static constexpr usize kExtraSlots = 32;
+
+  static u32 segment_length_for_item_count(usize item_count)
+  {
+    const usize slot_count = (item_count * 123 + 99) / 100 + kExtraSlots;
+    return BATT_CHECKED_CAST(u32, (slot_count + 2) / 3);
+  }
+
+  static PackedXorFilter from_params(const XorFilterParams& params, usize item_count)
+  {
+    PackedXorFilter filter;
+    filter.initialize(params, item_count);
+    return filter;
+  }
+
+  struct Probe {
+    usize slot[3];
+    u32 fingerprint;
+  };
+
+  //==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  void initialize(const XorFilterParams& params, usize item_count)
+  {
+    BATT_CHECK(params.fingerprint_bits == 8 || params.fingerprint_bits == 16)
+        << BATT_INSPECT(params.fingerprint_bits);
+
+    this->seed = 0;
+    this->segment_length = segment_length_for_item_count(item_count);
+    this->fingerprint_bits = params.fingerprint_bits;
+    std::memset(this->reserved_, 0, sizeof(this->reserved_));
+  }
+
+  usize slot_count() const
+  {
+    return usize{this->segment_length} * 3;
+  }
+
+  usize fingerprint_size() const
+  {
+    return this->fingerprint_bits / 8;
+  }
+
+  static u64 mix_hash(u64 item_hash, u64 seed)
+  {
+    // The MurmurHash3 finalizer.
+    //
+    u64 h = item_hash + seed;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+  }
+
+  Probe probe_from_item_hash(u64 item_hash) const
+  {
+    const u64 h = mix_hash(item_hash, this->seed);
+    const u64 n = this->segment_length;
+
+    // Maps a 32-bit value uniformly onto [0, n) without division.
+    //
+    const auto reduce = [n](u64 x) -> usize {
+      return ((x & 0xffffffffull) * n) >> 32;
+    };
+    const auto rotl = [](u64 x, int k) -> u64 {
+      return (x << k) | (x >> (64 - k));
+    };
+
+    Probe p;
+    p.slot[0] = reduce(h);
+    p.slot[1] = reduce(rotl(h, 21)) + n;
+    p.slot[2] = reduce(rotl(h, 42)) + n * 2;
+    p.fingerprint = static_cast<u32>(h ^ (h >> 32)) & ((u32{1} << this->fingerprint_bits) - 1);
+    return p;
+  }
+
+  u32 get_fingerprint(usize slot) const
+  {
+    if (this->fingerprint_bits == 8) {
+      return this->fingerprints[slot];
+    }
+    return u32{this->fingerprints[slot * 2]} | (u32{this->fingerprints[slot * 2 + 1]} << 8);
+  }
+
+  void set_fingerprint(usize slot, u32 value)
+  {
+    if (this->fingerprint_bits == 8) {
+      this->fingerprints[slot] = static_cast<u8>(value);
+    } else {
+      this->fingerprints[slot * 2] = static_cast<u8>(value);
+      this->fingerprints[slot * 2 + 1] = static_cast<u8>(value >> 8);
+    }
+  }
+
+  bool might_contain_item_hash(u64 item_hash) const
+  {
+    const Probe p = this->probe_from_item_hash(item_hash);
+
+    return (this->get_fingerprint(p.slot[0]) ^ this->get_fingerprint(p.slot[1]) ^
+            this->get_fingerprint(p.slot[2])) == p.fingerprint;
+  }
+
+  template <typename T>
+  bool might_contain(const T& item) const
+  {
+    return this->might_contain_item_hash(std::hash<T>{}(item));
+  }
+};
+
+BATT_STATIC_ASSERT_EQ(offsetof(PackedXorFilter, fingerprints), 16);
+
+inline usize packed_sizeof(const PackedXorFilter& filter)
+{
+  return offsetof(PackedXorFilter, fingerprints) + filter.slot_count() * filter.fingerprint_size();
+}
+
+inline usize packed_sizeof_xor_filter(const XorFilterParams& params, usize item_count)
+{
+  return packed_sizeof(PackedXorFilter::from_params(params, item_count));
+}
+
+// Fills in `filter` (which must have been initialized for at least as many items as there are
+// distinct values in `item_hashes`) so that it contains the items with the given std::hash values.
+// Sorts and removes duplicates from `item_hashes`.
+//
+void build_xor_filter_from_hashes(std::vector<u64>& item_hashes, PackedXorFilter* filter);
+
+// Builds an XOR filter of `hash_fn(item)` for the items in [first, last).  Mirrors
+// parallel_build_bloom_filter: the items are hashed in parallel on `worker_pool`; the rest of the
+// construction (which is linear-time and touches only the hashes) runs on the calling thread.
+//
+template <typename Iter, typename HashFn>
+void parallel_build_xor_filter(batt::WorkerPool& worker_pool, Iter first, Iter last,
+                               const HashFn& hash_fn, PackedXorFilter* filter)
+{
+  const batt::WorkSliceParams params{
+      .min_task_size = batt::TaskSize{1024},
+      .max_tasks = batt::TaskCount{worker_pool.size() + 1},
+  };
+
+  const batt::WorkSlicePlan plan{params, first, last};
+
+  std::vector<u64> item_hashes(plan.input_size);
+  {
+    batt::ScopedWorkContext work_context{worker_pool};
+
+    BATT_CHECK_OK(slice_work(work_context, plan,
+                             /*gen_work_fn=*/
+                             [&](usize /*task_index*/, isize task_offset, isize task_size) {
+                               return [&item_hashes, &hash_fn, first, task_offset, task_size] {
+                                 auto src = std::next(first, task_offset);
+                                 for (isize i = task_offset; i < task_offset + task_size;
+                                      ++i, ++src) {
+                                   const auto& key = hash_fn(*src);
+                                   item_hashes[i] = std::hash<std::decay_t<decltype(key)>>{}(key);
+                                 }
+                               };
+                             }))
+        << "work_context must not be closed!";
+  }
+
+  build_xor_filter_from_hashes(item_hashes, filter);
+}
+
+}  // namespace llfs
+
+#endif  // LLFS_XOR_FILTER_HPP
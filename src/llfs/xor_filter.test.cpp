@@ -0,0 +1,138 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/xor_filter.hpp>
+//
+#include <llfs/xor_filter.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+// Test Plan:
+//
+//  1. (RandomItems) Filters built from random items (8- and 16-bit fingerprints, various item
+//     counts including 0) have no false negatives, and a false positive rate close to
+//     2^-fingerprint_bits.
+//  2. (DuplicateItems) Items that appear more than once don't stop the filter from being built.
+//  3. (Size) The packed size is about 1.23 fingerprints per item.
+
+using llfs::packed_sizeof;
+using llfs::packed_sizeof_xor_filter;
+using llfs::PackedXorFilter;
+using llfs::parallel_build_xor_filter;
+using llfs::XorFilterParams;
+
+using namespace llfs::int_types;
+
+using batt::WorkerPool;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+std::unique_ptr<u8[]> build_filter(const XorFilterParams& params, const std::vector<u64>& items)
+{
+  std::unique_ptr<u8[]> memory{new u8[packed_sizeof_xor_filter(params, items.size())]};
+  auto* filter = reinterpret_cast<PackedXorFilter*>(memory.get());
+
+  filter->initialize(params, items.size());
+  EXPECT_EQ(packed_sizeof(*filter), packed_sizeof_xor_filter(params, items.size()));
+
+  parallel_build_xor_filter(
+      WorkerPool::default_pool(), items.begin(), items.end(),
+      /*hash_fn=*/
+      [](const u64& item) -> const u64& {
+        return item;
+      },
+      filter);
+
+  return memory;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+TEST(XorFilterTest, RandomItems)
+{
+  std::mt19937_64 rng{20240917};
+
+  for (usize fingerprint_bits : {8, 16}) {
+    const XorFilterParams params{
+        .fingerprint_bits = fingerprint_bits,
+    };
+    const double expected_rate = 1.0 / double(u64{1} << fingerprint_bits);
+
+    for (usize n_items : {0, 1, 2, 10, 1000, 100 * 1000}) {
+      std::vector<u64> items(n_items);
+      for (u64& item : items) {
+        item = rng();
+      }
+
+      std::unique_ptr<u8[]> memory = build_filter(params, items);
+      const auto& filter = *reinterpret_cast<const PackedXorFilter*>(memory.get());
+
+      for (const u64& item : items) {
+        ASSERT_TRUE(filter.might_contain(item)) << BATT_INSPECT(n_items) << BATT_INSPECT(item);
+      }
+
+      const usize n_queries = 1000 * 1000;
+      usize false_positive = 0;
+      for (usize i = 0; i < n_queries; ++i) {
+        if (filter.might_contain(rng())) {
+          false_positive += 1;
+        }
+      }
+      const double actual_rate = double(false_positive) / double(n_queries);
+
+      EXPECT_LT(actual_rate, expected_rate * 1.5)
+          << BATT_INSPECT(fingerprint_bits) << BATT_INSPECT(n_items);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+TEST(XorFilterTest, DuplicateItems)
+{
+  std::mt19937_64 rng{1};
+
+  std::vector<u64> items;
+  for (usize i = 0; i < 5000; ++i) {
+    const u64 item = rng();
+    for (usize j = 0; j < 1 + i % 3; ++j) {
+      items.emplace_back(item);
+    }
+  }
+
+  std::unique_ptr<u8[]> memory = build_filter(XorFilterParams{}, items);
+  const auto& filter = *reinterpret_cast<const PackedXorFilter*>(memory.get());
+
+  for (const u64& item : items) {
+    ASSERT_TRUE(filter.might_contain(item));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+
+TEST(XorFilterTest, Size)
+{
+  for (usize n_items : {0, 100, 10 * 1000, 1000 * 1000}) {
+    const usize expected_slots = n_items * 123 / 100 + PackedXorFilter::kExtraSlots;
+
+    EXPECT_NEAR(double(packed_sizeof_xor_filter(XorFilterParams{.fingerprint_bits = 8}, n_items)),
+                double(16 + expected_slots), 3.0);
+
+    EXPECT_NEAR(double(packed_sizeof_xor_filter(XorFilterParams{.fingerprint_bits = 16}, n_items)),
+                double(16 + expected_slots * 2), 6.0);
+  }
+}
+
+}  // namespace
@@ -0,0 +1,269 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/zoned_page_device.hpp>
+//
+
+#include <llfs/logging.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/checked_cast.hpp>
+
+namespace llfs {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+/*explicit*/ ZonedPageDevice::ZonedPageDevice(page_device_id_int device_id, PageSize page_size,
+                                              const ZonedPageDeviceOptions& options) noexcept
+    : options_{options}
+    , page_ids_{PageCount{options.zone_count * options.pages_per_zone}, device_id}
+    , page_size_{page_size}
+{
+  BATT_CHECK_GT(options.zone_count, 0u);
+  BATT_CHECK_GT(options.pages_per_zone, 0u);
+  BATT_CHECK_GT(options.lifetime_group_count, 0u);
+
+  auto locked = this->state_.lock();
+
+  locked->zones.resize(options.zone_count);
+  for (usize zone = 0; zone < options.zone_count; ++zone) {
+    locked->empty_zones.push_back(zone);
+  }
+  locked->open_zone_for_group.resize(options.lifetime_group_count);
+  locked->page_recs.resize(this->page_ids_.get_physical_page_count());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageIdFactory ZonedPageDevice::page_ids()
+{
+  return this->page_ids_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+PageSize ZonedPageDevice::page_size()
+{
+  return this->page_size_;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::shared_ptr<PageBuffer>> ZonedPageDevice::prepare(PageId page_id)
+{
+  return PageBuffer::allocate(this->page_size_, page_id);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void ZonedPageDevice::write(std::shared_ptr<const PageBuffer>&& page_buffer,
+                            WriteHandler&& handler)
+{
+  BATT_CHECK_NOT_NULLPTR(page_buffer);
+
+  auto result = [&]() -> Status {
+    const PageId page_id = page_buffer->page_id();
+    const auto physical_page = this->page_ids_.get_physical_page(page_id);
+    const auto generation = this->page_ids_.get_generation(page_id);
+
+    const usize group =
+        this->options_.lifetime_classifier
+            ? this->options_.lifetime_classifier(*page_buffer) % this->options_.lifetime_group_count
+            : 0;
+
+    auto locked = this->state_.lock();
+
+    BATT_CHECK_LT(physical_page, batt::checked_cast<i64>(locked->page_recs.size()));
+    PageRec& rec = locked->page_recs[physical_page];
+    BATT_CHECK(this->page_ids_.generation_less_than(rec.generation, generation))
+        << "\n  current generation = " << rec.generation
+        << "\n  write generation =   " << generation;
+
+    const Optional<usize> zone_index = this->zone_for_append(*locked, group);
+    if (!zone_index) {
+      return {batt::StatusCode::kResourceExhausted};
+    }
+
+    Zone& zone = locked->zones[*zone_index];
+    const Placement placement{*zone_index, zone.write_pointer};
+
+    LLFS_VLOG(1) << "write " << BATT_INSPECT(page_id) << BATT_INSPECT(group)
+                 << BATT_INSPECT(placement.zone) << BATT_INSPECT(placement.slot);
+
+    zone.slots[placement.slot] = std::move(page_buffer);
+    zone.write_pointer += 1;
+    zone.live_pages += 1;
+
+    if (zone.write_pointer == this->options_.pages_per_zone) {
+      zone.is_open = false;
+      locked->open_zone_for_group[group] = None;
+    }
+
+    // If the previous generation of this physical page was never dropped, its slot is dead now.
+    //
+    if (rec.placement) {
+      this->release_slot(*locked, *rec.placement);
+    }
+    rec.generation = generation;
+    rec.placement = placement;
+
+    return OkStatus();
+  }();
+
+  handler(result);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void ZonedPageDevice::read(PageId page_id, ReadHandler&& handler)
+{
+  auto result = [&]() -> StatusOr<std::shared_ptr<const PageBuffer>> {
+    const auto physical_page = this->page_ids_.get_physical_page(page_id);
+    const auto generation = this->page_ids_.get_generation(page_id);
+
+    auto locked = this->state_.lock();
+
+    BATT_CHECK_LT(physical_page, batt::checked_cast<i64>(locked->page_recs.size()));
+    const PageRec& rec = locked->page_recs[physical_page];
+    if (rec.generation != generation || !rec.placement) {
+      LLFS_VLOG(1) << "failing read with `kNotFound`;" << BATT_INSPECT(page_id)
+                   << BATT_INSPECT(generation) << BATT_INSPECT(rec.generation)
+                   << BATT_INSPECT(bool(rec.placement));
+      return Status{batt::StatusCode::kNotFound};
+    }
+
+    return locked->zones[rec.placement->zone].slots[rec.placement->slot];
+  }();
+
+  BATT_CHECK(handler);
+  std::move(handler)(result);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void ZonedPageDevice::drop(PageId page_id, WriteHandler&& handler)
+{
+  auto result = [&]() -> Status {
+    const auto physical_page = this->page_ids_.get_physical_page(page_id);
+    const auto generation_to_drop = this->page_ids_.get_generation(page_id);
+
+    auto locked = this->state_.lock();
+
+    BATT_CHECK_LT(physical_page, batt::checked_cast<i64>(locked->page_recs.size()));
+    PageRec& rec = locked->page_recs[physical_page];
+
+    // As in MemoryPageDevice, a generation mismatch means the physical page has already been
+    // reallocated, so there is nothing to drop.
+    //
+    if (rec.generation == generation_to_drop && rec.placement) {
+      this->release_slot(*locked, *rec.placement);
+      rec.placement = None;
+    } else {
+      LLFS_VLOG(1) << " -- skipping drop " << BATT_INSPECT(page_id) << BATT_INSPECT(rec.generation)
+                   << BATT_INSPECT(generation_to_drop);
+    }
+
+    return OkStatus();
+  }();
+
+  handler(result);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto ZonedPageDevice::zone_info(usize zone) -> ZoneInfo
+{
+  auto locked = this->state_.lock();
+
+  BATT_CHECK_LT(zone, locked->zones.size());
+  const Zone& z = locked->zones[zone];
+
+  return ZoneInfo{
+      .write_pointer = z.write_pointer,
+      .live_pages = z.live_pages,
+      .is_open = z.is_open,
+  };
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+usize ZonedPageDevice::empty_zone_count()
+{
+  return this->state_.lock()->empty_zones.size();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+auto ZonedPageDevice::find_placement(PageId page_id) -> Optional<Placement>
+{
+  const auto physical_page = this->page_ids_.get_physical_page(page_id);
+  const auto generation = this->page_ids_.get_generation(page_id);
+
+  auto locked = this->state_.lock();
+
+  BATT_CHECK_LT(physical_page, batt::checked_cast<i64>(locked->page_recs.size()));
+  const PageRec& rec = locked->page_recs[physical_page];
+  if (rec.generation != generation) {
+    return None;
+  }
+  return rec.placement;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Optional<usize> ZonedPageDevice::zone_for_append(State& state, usize group)
+{
+  Optional<usize>& open_zone = state.open_zone_for_group[group];
+  if (open_zone) {
+    return open_zone;
+  }
+
+  if (state.empty_zones.empty()) {
+    return None;
+  }
+
+  const usize zone_index = state.empty_zones.front();
+  state.empty_zones.pop_front();
+
+  Zone& zone = state.zones[zone_index];
+  BATT_CHECK_EQ(zone.write_pointer, 0u);
+  BATT_CHECK_EQ(zone.live_pages, 0u);
+
+  zone.slots.resize(this->options_.pages_per_zone);
+  zone.is_open = true;
+  open_zone = zone_index;
+
+  return zone_index;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void ZonedPageDevice::release_slot(State& state, const Placement& placement)
+{
+  Zone& zone = state.zones[placement.zone];
+
+  BATT_CHECK_NOT_NULLPTR(zone.slots[placement.slot]);
+  BATT_CHECK_GT(zone.live_pages, 0u);
+
+  zone.slots[placement.slot] = nullptr;
+  zone.live_pages -= 1;
+
+  // An open zone is still being appended to; it is reset once it fills up and empties.
+  //
+  if (zone.live_pages == 0 && !zone.is_open) {
+    LLFS_VLOG(1) << "resetting zone " << placement.zone;
+
+    zone.slots.clear();
+    zone.slots.shrink_to_fit();
+    zone.write_pointer = 0;
+    state.empty_zones.push_back(placement.zone);
+    this->zone_reset_count_.fetch_add(1);
+  }
+}
+
+}  // namespace llfs
@@ -0,0 +1,163 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_ZONED_PAGE_DEVICE_HPP
+#define LLFS_ZONED_PAGE_DEVICE_HPP
+
+#include <llfs/int_types.hpp>
+#include <llfs/optional.hpp>
+#include <llfs/page_device.hpp>
+#include <llfs/page_size.hpp>
+#include <llfs/status.hpp>
+
+#include <batteries/async/mutex.hpp>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace llfs {
+
+struct ZonedPageDeviceOptions {
+  /** \brief Returns the lifetime group (in [0, lifetime_group_count)) of a page about to be
+   * written; pages in the same group are appended to the same zone.
+   */
+  using LifetimeClassifier = std::function<usize(const PageBuffer&)>;
+
+  usize zone_count;
+  usize pages_per_zone;
+
+  /** \brief The number of zones that may be open (i.e., partially written) at once; one per
+   * lifetime group.
+   */
+  usize lifetime_group_count = 1;
+
+  /** \brief If not set, all pages are in group 0.
+   */
+  LifetimeClassifier lifetime_classifier;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+/** \brief An in-memory page device that places pages the way a zoned (ZNS/SMR) device must be
+ * written: sequentially within a zone, with space reclaimed only by resetting a whole zone.
+ *
+ * Each write is a zone append: the page goes to the next slot of the open zone for its lifetime
+ * group (see ZonedPageDeviceOptions::lifetime_classifier), and the device records where it went
+ * in a placement table indexed by physical page.  Dropping a page only marks its slot dead; once
+ * every slot of a fully written zone is dead, the zone is reset and becomes empty again.  Live
+ * pages are never relocated, so writes to the device are never amplified; the price is that a
+ * zone's space isn't reusable until all of its pages are dropped.  Grouping pages by expected
+ * lifetime (e.g. by page layout) makes zones empty at about the same time.
+ *
+ * Writes fail with `batt::StatusCode::kResourceExhausted` when the open zone for a group is full
+ * and there are no empty zones.
+ */
+class ZonedPageDevice : public PageDevice
+{
+ public:
+  struct ZoneInfo {
+    usize write_pointer;
+    usize live_pages;
+    bool is_open;
+  };
+
+  struct Placement {
+    usize zone;
+    usize slot;
+  };
+
+  explicit ZonedPageDevice(page_device_id_int device_id, PageSize page_size,
+                           const ZonedPageDeviceOptions& options) noexcept;
+
+  //----- --- -- -  -  -   -
+  // PageDevice interface
+
+  PageIdFactory page_ids() override;
+
+  PageSize page_size() override;
+
+  StatusOr<std::shared_ptr<PageBuffer>> prepare(PageId page_id) override;
+
+  void write(std::shared_ptr<const PageBuffer>&& page_buffer, WriteHandler&& handler) override;
+
+  void read(PageId page_id, ReadHandler&& handler) override;
+
+  void drop(PageId page_id, WriteHandler&& handler) override;
+
+  //----- --- -- -  -  -   -
+
+  usize zone_count() const
+  {
+    return this->options_.zone_count;
+  }
+
+  usize pages_per_zone() const
+  {
+    return this->options_.pages_per_zone;
+  }
+
+  ZoneInfo zone_info(usize zone);
+
+  /** \brief The number of zones with nothing written to them.
+   */
+  usize empty_zone_count();
+
+  /** \brief The number of times a zone has been reset since this object was created.
+   */
+  u64 zone_reset_count() const
+  {
+    return this->zone_reset_count_.load();
+  }
+
+  /** \brief Returns where `page_id` is stored, or None if it isn't currently written.
+   */
+  Optional<Placement> find_placement(PageId page_id);
+
+ private:
+  struct Zone {
+    std::vector<std::shared_ptr<const PageBuffer>> slots;
+    usize write_pointer = 0;
+    usize live_pages = 0;
+    bool is_open = false;
+  };
+
+  struct PageRec {
+    page_generation_int generation = 0;
+    Optional<Placement> placement;
+  };
+
+  struct State {
+    std::vector<Zone> zones;
+    std::deque<usize> empty_zones;
+    std::vector<Optional<usize>> open_zone_for_group;
+    std::vector<PageRec> page_recs;
+  };
+
+  // Returns the zone to append the next page of `group` to, opening a new one if necessary.
+  //
+  Optional<usize> zone_for_append(State& state, usize group);
+
+  // Marks the slot at `placement` dead, resetting its zone if that was its last live page.
+  //
+  void release_slot(State& state, const Placement& placement);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const ZonedPageDeviceOptions options_;
+  const PageIdFactory page_ids_;
+  const PageSize page_size_;
+  batt::Mutex<State> state_;
+  std::atomic<u64> zone_reset_count_{0};
+};
+
+}  // namespace llfs
+
+#endif  // LLFS_ZONED_PAGE_DEVICE_HPP
@@ -0,0 +1,198 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs/zoned_page_device.hpp>
+//
+#include <llfs/zoned_page_device.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <llfs/page_buffer.hpp>
+
+#include <vector>
+
+namespace {
+
+using namespace llfs::int_types;
+
+// Test Plan:
+//  1. Writes are appended to consecutive slots of a zone; reads return the page written; a zone
+//     is reset only once it is full and all of its pages are dropped.
+//  2. Writes fail with kResourceExhausted when there are no empty zones.
+//  3. With pages classified by lifetime, dropping all the short-lived pages resets every zone
+//     they were written to; without classification, the same workload resets no zones.
+
+constexpr u64 kPageSize = 4096;
+constexpr llfs::page_device_id_int kDeviceId = 2;
+
+// The first payload byte of the pages written by these tests is their lifetime group.
+//
+usize first_payload_byte(const llfs::PageBuffer& page)
+{
+  return static_cast<const u8*>(page.const_payload().data())[0];
+}
+
+llfs::Status write_page(llfs::PageDevice& device, llfs::PageId page_id, u8 group = 0)
+{
+  llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer = device.prepare(page_id);
+  BATT_REQUIRE_OK(buffer);
+
+  static_cast<u8*>((*buffer)->mutable_payload().data())[0] = group;
+
+  llfs::Status result;
+  device.write(std::move(*buffer), [&result](llfs::Status status) {
+    result = status;
+  });
+  return result;
+}
+
+llfs::Status read_page(llfs::PageDevice& device, llfs::PageId page_id)
+{
+  llfs::Status result;
+  device.read(page_id, [&result, page_id](llfs::PageDevice::ReadResult page) {
+    if (!page.ok()) {
+      result = page.status();
+      return;
+    }
+    EXPECT_EQ((*page)->page_id(), page_id);
+  });
+  return result;
+}
+
+llfs::Status drop_page(llfs::PageDevice& device, llfs::PageId page_id)
+{
+  llfs::Status result;
+  device.drop(page_id, [&result](llfs::Status status) {
+    result = status;
+  });
+  return result;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(ZonedPageDeviceTest, AppendAndReset)
+{
+  llfs::ZonedPageDevice device{kDeviceId, llfs::PageSize{kPageSize},
+                               llfs::ZonedPageDeviceOptions{
+                                   .zone_count = 2,
+                                   .pages_per_zone = 4,
+                               }};
+
+  EXPECT_EQ(device.page_ids().get_physical_page_count(), 8u);
+  EXPECT_EQ(device.empty_zone_count(), 2u);
+
+  std::vector<llfs::PageId> page_ids;
+  for (usize i = 0; i < 6; ++i) {
+    // Use physical pages out of order to show that placement doesn't depend on them.
+    //
+    page_ids.emplace_back(device.page_ids().make_page_id(7 - i, 1));
+    ASSERT_TRUE(write_page(device, page_ids.back()).ok());
+
+    const llfs::Optional<llfs::ZonedPageDevice::Placement> placement =
+        device.find_placement(page_ids.back());
+    ASSERT_TRUE(placement);
+    EXPECT_EQ(placement->zone, i / 4);
+    EXPECT_EQ(placement->slot, i % 4);
+  }
+  EXPECT_EQ(device.empty_zone_count(), 0u);
+
+  for (const llfs::PageId& page_id : page_ids) {
+    EXPECT_TRUE(read_page(device, page_id).ok());
+  }
+
+  // Dropping pages from the open zone doesn't reset it.
+  //
+  ASSERT_TRUE(drop_page(device, page_ids[4]).ok());
+  ASSERT_TRUE(drop_page(device, page_ids[5]).ok());
+  EXPECT_EQ(device.zone_info(1).live_pages, 0u);
+  EXPECT_EQ(device.zone_info(1).write_pointer, 2u);
+  EXPECT_TRUE(device.zone_info(1).is_open);
+  EXPECT_EQ(device.zone_reset_count(), 0u);
+
+  // Dropping all the pages of a full zone resets it.
+  //
+  for (usize i = 0; i < 4; ++i) {
+    EXPECT_EQ(device.zone_reset_count(), 0u);
+    ASSERT_TRUE(drop_page(device, page_ids[i]).ok());
+    EXPECT_EQ(read_page(device, page_ids[i]), batt::StatusCode::kNotFound);
+  }
+  EXPECT_EQ(device.zone_reset_count(), 1u);
+  EXPECT_EQ(device.empty_zone_count(), 1u);
+  EXPECT_EQ(device.zone_info(0).write_pointer, 0u);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(ZonedPageDeviceTest, NoEmptyZones)
+{
+  llfs::ZonedPageDevice device{kDeviceId, llfs::PageSize{kPageSize},
+                               llfs::ZonedPageDeviceOptions{
+                                   .zone_count = 2,
+                                   .pages_per_zone = 2,
+                               }};
+
+  for (usize i = 0; i < 4; ++i) {
+    ASSERT_TRUE(write_page(device, device.page_ids().make_page_id(i, 1)).ok());
+  }
+
+  // Rewriting a physical page (new generation) needs a new slot, even though the old one is dead
+  // now.
+  //
+  const llfs::PageId next_gen = device.page_ids().make_page_id(0, 2);
+  EXPECT_EQ(write_page(device, next_gen), batt::StatusCode::kResourceExhausted);
+
+  ASSERT_TRUE(drop_page(device, device.page_ids().make_page_id(0, 1)).ok());
+  ASSERT_TRUE(drop_page(device, device.page_ids().make_page_id(1, 1)).ok());
+
+  EXPECT_EQ(device.empty_zone_count(), 1u);
+  EXPECT_TRUE(write_page(device, next_gen).ok());
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+TEST(ZonedPageDeviceTest, LifetimeGroups)
+{
+  constexpr usize kZoneCount = 16;
+  constexpr usize kPagesPerZone = 8;
+  constexpr usize kPageCount = kZoneCount * kPagesPerZone / 2;
+
+  for (bool classify : {false, true}) {
+    llfs::ZonedPageDeviceOptions options{
+        .zone_count = kZoneCount,
+        .pages_per_zone = kPagesPerZone,
+    };
+    if (classify) {
+      options.lifetime_group_count = 2;
+      options.lifetime_classifier = &first_payload_byte;
+    }
+    llfs::ZonedPageDevice device{kDeviceId, llfs::PageSize{kPageSize}, options};
+
+    // Alternate long-lived (group 0) and short-lived (group 1) pages.
+    //
+    for (usize i = 0; i < kPageCount; ++i) {
+      ASSERT_TRUE(write_page(device, device.page_ids().make_page_id(i, 1), i % 2).ok());
+    }
+
+    for (usize i = 1; i < kPageCount; i += 2) {
+      ASSERT_TRUE(drop_page(device, device.page_ids().make_page_id(i, 1)).ok());
+    }
+
+    if (classify) {
+      EXPECT_EQ(device.zone_reset_count(), kPageCount / 2 / kPagesPerZone);
+    } else {
+      EXPECT_EQ(device.zone_reset_count(), 0u);
+    }
+
+    for (usize i = 0; i < kPageCount; i += 2) {
+      EXPECT_TRUE(read_page(device, device.page_ids().make_page_id(i, 1)).ok());
+    }
+  }
+}
+
+}  // namespace
@@ -0,0 +1,146 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs_bench/bench.hpp>
+//
+
+#include <algorithm>
+#include <iomanip>
+
+namespace llfs_bench {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::ostream& operator<<(std::ostream& out, const BenchResult& t)
+{
+  // Benchmark and counter names are plain identifiers, so they need no escaping.
+  //
+  out << "{\"name\":\"" << t.name << "\",\"iterations\":" << t.iterations
+      << ",\"elapsed_sec\":" << std::setprecision(6) << t.elapsed_sec;
+
+  if (t.iterations > 0 && t.elapsed_sec > 0) {
+    out << ",\"ns_per_op\":" << (t.elapsed_sec * 1e9 / double(t.iterations))
+        << ",\"ops_per_sec\":" << (double(t.iterations) / t.elapsed_sec);
+  }
+  for (const auto& [label, value] : t.latency_ns) {
+    out << ",\"" << label << "\":" << value;
+  }
+  for (const auto& [label, value] : t.counters) {
+    out << ",\"" << label << "\":" << value;
+  }
+  return out << "}";
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void BenchRunner::add(std::vector<std::string> names, BenchFn&& fn)
+{
+  this->groups_.emplace_back(Group{std::move(names), std::move(fn)});
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void BenchRunner::run_all()
+{
+  for (Group& group : this->groups_) {
+    const bool any_selected = std::any_of(group.names.begin(), group.names.end(),
+                                          [this](const std::string& name) {
+                                            return this->selected(name);
+                                          });
+    if (any_selected) {
+      group.fn(*this);
+    }
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+bool BenchRunner::selected(const std::string& name) const
+{
+  return this->options_.filter.empty() || name.find(this->options_.filter) != std::string::npos;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void BenchRunner::run_throughput(const std::string& name, const ThroughputFn& fn,
+                                 std::vector<std::pair<std::string, double>> counters)
+{
+  if (!this->selected(name)) {
+    return;
+  }
+
+  // Warm up (page in code and data) before timing anything.
+  //
+  fn(1);
+
+  u64 n = 1;
+  for (;;) {
+    const auto start = std::chrono::steady_clock::now();
+    fn(n);
+    const double elapsed_sec =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (elapsed_sec >= this->options_.min_time_sec || n >= (u64{1} << 40)) {
+      this->report(BenchResult{
+          .name = name,
+          .iterations = n,
+          .elapsed_sec = elapsed_sec,
+          .latency_ns = {},
+          .counters = std::move(counters),
+      });
+      return;
+    }
+
+    // Aim for 1.5x the minimum time on the next try, growing by at most 10x at a time.
+    //
+    const double scale = (elapsed_sec > 0) ? (this->options_.min_time_sec * 1.5 / elapsed_sec) : 10;
+    n = std::max(n + 1, static_cast<u64>(double(n) * std::min(scale, 10.0)));
+  }
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void BenchRunner::report_latency(const std::string& name,
+                                 std::vector<std::chrono::nanoseconds> samples,
+                                 std::chrono::nanoseconds elapsed)
+{
+  if (!this->selected(name) || samples.empty()) {
+    return;
+  }
+
+  std::sort(samples.begin(), samples.end());
+
+  const auto percentile = [&samples](double p) -> double {
+    const usize i = std::min(samples.size() - 1, static_cast<usize>(p * double(samples.size())));
+    return double(samples[i].count());
+  };
+
+  this->report(BenchResult{
+      .name = name,
+      .iterations = samples.size(),
+      .elapsed_sec = std::chrono::duration<double>(elapsed).count(),
+      .latency_ns =
+          {
+              {"min_ns", double(samples.front().count())},
+              {"p50_ns", percentile(0.50)},
+              {"p90_ns", percentile(0.90)},
+              {"p99_ns", percentile(0.99)},
+              {"max_ns", double(samples.back().count())},
+          },
+      .counters = {},
+  });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void BenchRunner::report(const BenchResult& result)
+{
+  this->out_ << result << std::endl;
+}
+
+}  // namespace llfs_bench
@@ -0,0 +1,153 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_BENCH_BENCH_HPP
+#define LLFS_BENCH_BENCH_HPP
+
+#include <llfs/int_types.hpp>
+
+#include <chrono>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace llfs_bench {
+
+using namespace llfs::int_types;
+
+/** \brief Options shared by all benchmarks.
+ */
+struct BenchOptions {
+  /** \brief Only benchmarks whose name contains this string are run (all, if empty).
+   */
+  std::string filter;
+
+  /** \brief Each throughput benchmark is repeated with more iterations until it runs for at least
+   * this long.
+   */
+  double min_time_sec = 0.5;
+
+  /** \brief The number of threads used by benchmarks that measure contention.
+   */
+  usize threads = 4;
+
+  /** \brief The file used for the IoRingLogDevice benchmark (created, and overwritten if present).
+   */
+  std::string log_file = "/tmp/llfs_bench_log.llfs";
+};
+
+/** \brief The measurements for one benchmark, written as a single line of JSON.
+ */
+struct BenchResult {
+  std::string name;
+
+  /** \brief The total number of operations timed.
+   */
+  u64 iterations = 0;
+
+  /** \brief The wall-clock time for all iterations.
+   */
+  double elapsed_sec = 0;
+
+  /** \brief Latency percentiles in nanoseconds, for benchmarks that time each operation; each is a
+   * (label, value) pair, e.g. ("p50_ns", 1234).
+   */
+  std::vector<std::pair<std::string, double>> latency_ns;
+
+  /** \brief Benchmark-specific values (e.g. the false positive rate of a filter).
+   */
+  std::vector<std::pair<std::string, double>> counters;
+};
+
+std::ostream& operator<<(std::ostream& out, const BenchResult& t);
+
+/** \brief Registers and runs benchmarks, and reports their results.
+ *
+ * A throughput benchmark is a function that performs `n` operations; the runner calls it with
+ * increasing `n` until one call takes at least BenchOptions::min_time_sec, and reports that call.
+ * A latency benchmark records its own samples (see `report_latency`).
+ */
+class BenchRunner
+{
+ public:
+  using ThroughputFn = std::function<void(u64 n)>;
+  using BenchFn = std::function<void(BenchRunner&)>;
+
+  explicit BenchRunner(const BenchOptions& options, std::ostream& out) noexcept
+      : options_{options}
+      , out_{out}
+  {
+  }
+
+  const BenchOptions& options() const noexcept
+  {
+    return this->options_;
+  }
+
+  /** \brief Adds a group of benchmarks; `fn` is only called (to set up and run the benchmarks in
+   * the group) if at least one of `names` passes the filter.
+   */
+  void add(std::vector<std::string> names, BenchFn&& fn);
+
+  /** \brief Runs all added benchmark groups that pass the filter.
+   */
+  void run_all();
+
+  /** \brief Returns true iff the benchmark called `name` should run.
+   */
+  bool selected(const std::string& name) const;
+
+  /** \brief Runs a throughput benchmark (if selected) and reports it.
+   */
+  void run_throughput(const std::string& name, const ThroughputFn& fn,
+                      std::vector<std::pair<std::string, double>> counters = {});
+
+  /** \brief Reports the per-operation latencies `samples`, and their total `elapsed` time.
+   */
+  void report_latency(const std::string& name, std::vector<std::chrono::nanoseconds> samples,
+                      std::chrono::nanoseconds elapsed);
+
+  /** \brief Writes `result` to the output.
+   */
+  void report(const BenchResult& result);
+
+ private:
+  struct Group {
+    std::vector<std::string> names;
+    BenchFn fn;
+  };
+
+  BenchOptions options_;
+  std::ostream& out_;
+  std::vector<Group> groups_;
+};
+
+/** \brief Prevents the compiler from optimizing away the computation of `value`.
+ */
+template <typename T>
+inline void do_not_optimize(const T& value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Benchmark groups (one source file each).
+
+void add_bloom_filter_benchmarks(BenchRunner& runner);
+void add_crc_benchmarks(BenchRunner& runner);
+void add_log_benchmarks(BenchRunner& runner);
+void add_page_cache_benchmarks(BenchRunner& runner);
+void add_trie_benchmarks(BenchRunner& runner);
+void add_varint_benchmarks(BenchRunner& runner);
+
+}  // namespace llfs_bench
+
+#endif  // LLFS_BENCH_BENCH_HPP
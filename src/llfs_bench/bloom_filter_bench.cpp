@@ -0,0 +1,102 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs_bench/bench.hpp>
+//
+
+#include <llfs/bloom_filter.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llfs_bench {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void add_bloom_filter_benchmarks(BenchRunner& runner)
+{
+  constexpr usize kNumItems = 64 * 1024;
+  constexpr usize kBitsPerItem = 10;
+
+  for (llfs::BloomFilterLayout layout :
+       {llfs::BloomFilterLayout::kFlat, llfs::BloomFilterLayout::kBlocked512}) {
+    const std::string suffix =
+        (layout == llfs::BloomFilterLayout::kFlat) ? "_flat" : "_blocked512";
+
+    runner.add(
+        {
+            "bloom_filter_build" + suffix,
+            "bloom_filter_query_hit" + suffix,
+            "bloom_filter_query_miss" + suffix,
+        },
+        [layout, suffix](BenchRunner& runner) {
+          // Items that are inserted ("key0", "key2", ...) and items that aren't ("key1", ...).
+          //
+          std::vector<std::string> items, non_items;
+          for (usize i = 0; i < kNumItems; ++i) {
+            items.emplace_back("key" + std::to_string(i * 2));
+            non_items.emplace_back("key" + std::to_string(i * 2 + 1));
+          }
+
+          const llfs::BloomFilterParams params{
+              .bits_per_item = kBitsPerItem,
+              .layout = layout,
+          };
+
+          std::unique_ptr<u8[]> memory{new u8[llfs::packed_sizeof_bloom_filter(params, kNumItems)]};
+          auto* filter = reinterpret_cast<llfs::PackedBloomFilter*>(memory.get());
+          *filter = llfs::PackedBloomFilter::from_params(params, kNumItems);
+
+          // Each iteration inserts one item; the filter is cleared when it is full.
+          //
+          runner.run_throughput("bloom_filter_build" + suffix, [&](u64 n) {
+            for (u64 i = 0; i < n; ++i) {
+              if (i % kNumItems == 0) {
+                filter->clear();
+              }
+              filter->insert(items[i % kNumItems]);
+            }
+          });
+
+          filter->clear();
+          for (const std::string& item : items) {
+            filter->insert(item);
+          }
+
+          runner.run_throughput("bloom_filter_query_hit" + suffix, [&](u64 n) {
+            usize count = 0;
+            for (u64 i = 0; i < n; ++i) {
+              count += filter->might_contain(items[i % kNumItems]);
+            }
+            do_not_optimize(count);
+          });
+
+          usize false_positives = 0;
+          for (const std::string& item : non_items) {
+            false_positives += filter->might_contain(item);
+          }
+
+          runner.run_throughput(
+              "bloom_filter_query_miss" + suffix,
+              [&](u64 n) {
+                usize count = 0;
+                for (u64 i = 0; i < n; ++i) {
+                  count += filter->might_contain(non_items[i % kNumItems]);
+                }
+                do_not_optimize(count);
+              },
+              {
+                  {"bits_per_item", double(kBitsPerItem)},
+                  {"false_positive_rate", double(false_positives) / double(kNumItems)},
+              });
+        });
+  }
+}
+
+}  // namespace llfs_bench
@@ -0,0 +1,58 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs_bench/bench.hpp>
+//
+
+#include <llfs/crc.hpp>
+#include <llfs/page_buffer.hpp>
+#include <llfs/page_layout.hpp>
+
+#include <cstring>
+#include <memory>
+
+namespace llfs_bench {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void add_crc_benchmarks(BenchRunner& runner)
+{
+  constexpr usize kPageSize = 4096;
+
+  runner.add({"compute_page_crc64", "compute_page_crc32c"}, [](BenchRunner& runner) {
+    std::shared_ptr<llfs::PageBuffer> page =
+        llfs::PageBuffer::allocate(llfs::PageSize{kPageSize}, llfs::PageId{1});
+
+    std::memset(page->mutable_buffer().data(), 'x', kPageSize);
+
+    runner.run_throughput(
+        "compute_page_crc64",
+        [&](u64 n) {
+          for (u64 i = 0; i < n; ++i) {
+            do_not_optimize(llfs::compute_page_crc64(*page));
+          }
+        },
+        {
+            {"page_size", double(kPageSize)},
+        });
+
+    runner.run_throughput(
+        "compute_page_crc32c",
+        [&](u64 n) {
+          for (u64 i = 0; i < n; ++i) {
+            do_not_optimize(llfs::compute_page_crc32c(*page));
+          }
+        },
+        {
+            {"page_size", double(kPageSize)},
+            {"hardware_accelerated", llfs::crc32c_is_hardware_accelerated() ? 1.0 : 0.0},
+        });
+  });
+}
+
+}  // namespace llfs_bench
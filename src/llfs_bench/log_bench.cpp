@@ -0,0 +1,169 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs_bench/bench.hpp>
+//
+
+#include <llfs/memory_log_device.hpp>
+#include <llfs/slot_writer.hpp>
+
+#ifndef LLFS_DISABLE_IO_URING
+#include <llfs/ioring.hpp>
+#include <llfs/ioring_log_device.hpp>
+#include <llfs/log_device_config.hpp>
+#include <llfs/storage_context.hpp>
+#include <llfs/uuid.hpp>
+#endif  // LLFS_DISABLE_IO_URING
+
+#include <batteries/assert.hpp>
+#include <batteries/async/runtime.hpp>
+#include <batteries/constants.hpp>
+
+#include <cstring>
+#include <filesystem>
+
+namespace llfs_bench {
+
+using namespace batt::constants;
+
+namespace {
+
+constexpr usize kSlotBodySize = 100;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void run_slot_writer_benchmark(BenchRunner& runner)
+{
+  constexpr usize kLogSize = 4 * kMiB;
+
+  llfs::MemoryLogDevice log_device{kLogSize};
+  llfs::SlotWriter slot_writer{log_device};
+
+  llfs::StatusOr<batt::Grant> grant =
+      slot_writer.reserve(kLogSize / 2, batt::WaitForResource::kFalse);
+  BATT_CHECK_OK(grant);
+
+  const char body[kSlotBodySize] = {};
+  const usize slot_size = llfs::packed_sizeof_varint(kSlotBodySize) + kSlotBodySize;
+
+  // Each iteration appends one slot; when the grant runs out, everything written so far is trimmed
+  // to make room (this is included in the time, as it would be for a real log).
+  //
+  runner.run_throughput(
+      "slot_writer_append",
+      [&](u64 n) {
+        for (u64 i = 0; i < n; ++i) {
+          if (grant->size() < slot_size) {
+            llfs::StatusOr<batt::Grant> trimmed =
+                slot_writer.trim_and_reserve(slot_writer.slot_offset());
+            BATT_CHECK_OK(trimmed);
+            grant->subsume(std::move(*trimmed));
+          }
+
+          llfs::StatusOr<llfs::SlotWriter::Append> op = slot_writer.prepare(*grant, kSlotBodySize);
+          BATT_CHECK_OK(op);
+          BATT_CHECK(op->packer().pack_raw_data(body, sizeof(body)));
+          BATT_CHECK_OK(op->commit());
+        }
+      },
+      {
+          {"slot_body_size", double(kSlotBodySize)},
+      });
+}
+
+#ifndef LLFS_DISABLE_IO_URING
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void run_ioring_log_device_benchmark(BenchRunner& runner)
+{
+  constexpr usize kLogSize = 16 * kMiB;
+
+  const std::filesystem::path log_file_path = runner.options().log_file;
+  const boost::uuids::uuid log_uuid = llfs::random_uuid();
+
+  llfs::StatusOr<llfs::ScopedIoRing> scoped_ioring =
+      llfs::ScopedIoRing::make_new(llfs::MaxQueueDepth{256}, llfs::ThreadPoolSize{1});
+  BATT_CHECK_OK(scoped_ioring);
+
+  auto storage_context = batt::make_shared<llfs::StorageContext>(
+      batt::Runtime::instance().default_scheduler(), scoped_ioring->get_io_ring());
+
+  std::filesystem::remove_all(log_file_path);
+
+  BATT_CHECK_OK(storage_context->add_new_file(
+      log_file_path, [&](llfs::StorageFileBuilder& builder) -> batt::Status {
+        BATT_REQUIRE_OK(builder.add_object(llfs::LogDeviceConfigOptions{
+            .uuid = log_uuid,
+            .pages_per_block_log2 = llfs::None,
+            .log_size = kLogSize,
+        }));
+        return batt::OkStatus();
+      }));
+
+  {
+    llfs::StatusOr<std::unique_ptr<llfs::IoRingLogDeviceFactory>> factory =
+        storage_context->recover_object(
+            batt::StaticType<llfs::PackedLogDeviceConfig>{}, log_uuid,
+            llfs::IoRingLogDriverOptions::with_default_values().set_name("llfs_bench_log"));
+    BATT_CHECK_OK(factory);
+
+    llfs::StatusOr<std::unique_ptr<llfs::IoRingLogDevice>> log_device =
+        (**factory).open_ioring_log_device();
+    BATT_CHECK_OK(log_device);
+
+    llfs::LogDevice::Writer& writer = (**log_device).writer();
+
+    // Each sample is the time to commit one slot-sized record and wait for it to be durable; the
+    // log is trimmed after each one, so it never fills up.
+    //
+    std::vector<std::chrono::nanoseconds> samples;
+    const auto start = std::chrono::steady_clock::now();
+    const auto min_time = std::chrono::duration<double>(runner.options().min_time_sec);
+
+    while (samples.size() < 100 || std::chrono::steady_clock::now() - start < min_time) {
+      const auto sample_start = std::chrono::steady_clock::now();
+
+      llfs::StatusOr<llfs::MutableBuffer> buffer = writer.prepare(kSlotBodySize);
+      BATT_CHECK_OK(buffer);
+      std::memset(buffer->data(), 'a', kSlotBodySize);
+
+      llfs::StatusOr<llfs::slot_offset_type> upper_bound = writer.commit(kSlotBodySize);
+      BATT_CHECK_OK(upper_bound);
+
+      BATT_CHECK_OK((**log_device).sync(llfs::LogReadMode::kDurable,
+                                       llfs::SlotUpperBoundAt{*upper_bound}));
+
+      samples.emplace_back(std::chrono::steady_clock::now() - sample_start);
+
+      BATT_CHECK_OK((**log_device).trim(*upper_bound));
+    }
+
+    runner.report_latency("ioring_log_device_commit_to_flush", std::move(samples),
+                          std::chrono::steady_clock::now() - start);
+
+    BATT_CHECK_OK((**log_device).close());
+  }
+
+  std::filesystem::remove_all(log_file_path);
+}
+#endif  // LLFS_DISABLE_IO_URING
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void add_log_benchmarks(BenchRunner& runner)
+{
+  runner.add({"slot_writer_append"}, &run_slot_writer_benchmark);
+
+#ifndef LLFS_DISABLE_IO_URING
+  runner.add({"ioring_log_device_commit_to_flush"}, &run_ioring_log_device_benchmark);
+#endif  // LLFS_DISABLE_IO_URING
+}
+
+}  // namespace llfs_bench
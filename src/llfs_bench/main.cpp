@@ -0,0 +1,65 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+//######=###=##=#=#=#=#=#==#==#====#+==#+==============+==+==+==+=+==+=+=+=+=+=+=+
+// LLFS Microbenchmarks.
+//
+// Writes one line of JSON per benchmark to stdout (or to --output), e.g.:
+//
+//   {"name":"varint_pack","iterations":123456789,"elapsed_sec":0.61,"ns_per_op":4.9,...}
+//
+
+#include <llfs_bench/bench.hpp>
+
+#include <CLI/App.hpp>
+#include <CLI/Config.hpp>
+#include <CLI/Formatter.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv)
+{
+  CLI::App app{"LLFS microbenchmarks"};
+
+  llfs_bench::BenchOptions options;
+  std::string output;
+
+  app.add_option("--filter", options.filter,
+                 "Run only the benchmarks whose names contain this string");
+  app.add_option("--min-time", options.min_time_sec,
+                 "Minimum time (seconds) to run each throughput benchmark");
+  app.add_option("--threads", options.threads, "Number of threads for the contention benchmarks");
+  app.add_option("--log-file", options.log_file, "Scratch file for the IoRingLogDevice benchmark");
+  app.add_option("--output", output, "Write results to this file instead of stdout");
+
+  CLI11_PARSE(app, argc, argv);
+
+  std::ofstream ofs;
+  if (!output.empty()) {
+    ofs.open(output);
+    if (!ofs.good()) {
+      std::cerr << "could not open " << output << std::endl;
+      return 1;
+    }
+  }
+
+  llfs_bench::BenchRunner runner{options, output.empty() ? std::cout : ofs};
+
+  llfs_bench::add_varint_benchmarks(runner);
+  llfs_bench::add_crc_benchmarks(runner);
+  llfs_bench::add_bloom_filter_benchmarks(runner);
+  llfs_bench::add_trie_benchmarks(runner);
+  llfs_bench::add_page_cache_benchmarks(runner);
+  llfs_bench::add_log_benchmarks(runner);
+
+  runner.run_all();
+
+  return 0;
+}
@@ -0,0 +1,154 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs_bench/bench.hpp>
+//
+
+#include <llfs/memory_page_cache.hpp>
+#include <llfs/opaque_page_view.hpp>
+#include <llfs/packed_page_header.hpp>
+#include <llfs/page_cache.hpp>
+#include <llfs/page_device_cache.hpp>
+#include <llfs/page_layout.hpp>
+
+#include <batteries/assert.hpp>
+#include <batteries/async/runtime.hpp>
+
+#include <thread>
+#include <vector>
+
+namespace llfs_bench {
+
+namespace {
+
+constexpr usize kPageSize = 4096;
+constexpr usize kNumPages = 1024;
+
+// Fills a memory page cache with kNumPages opaque pages and returns their ids.
+//
+std::vector<llfs::PageId> write_pages(llfs::PageCache& cache)
+{
+  BATT_CHECK_OK(llfs::OpaquePageView::register_layout(cache));
+
+  llfs::PageDevice& device = cache.devices_with_page_size(kPageSize)[0]->arena.device();
+
+  std::vector<llfs::PageId> page_ids;
+  for (usize i = 0; i < kNumPages; ++i) {
+    const llfs::PageId page_id = device.page_ids().make_page_id(i, /*generation=*/1);
+
+    llfs::StatusOr<std::shared_ptr<llfs::PageBuffer>> buffer = device.prepare(page_id);
+    BATT_CHECK_OK(buffer);
+
+    llfs::mutable_page_header(buffer->get())->layout_id = llfs::OpaquePageView::page_layout_id();
+    BATT_CHECK_OK(llfs::finalize_page_header(buffer->get()));
+
+    llfs::Status write_status;
+    device.write(std::move(*buffer), [&write_status](llfs::Status status) {
+      write_status = status;
+    });
+    BATT_CHECK_OK(write_status);
+
+    page_ids.emplace_back(page_id);
+  }
+  return page_ids;
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void add_page_cache_benchmarks(BenchRunner& runner)
+{
+  runner.add({"page_cache_get_hit", "page_cache_get_miss"}, [](BenchRunner& runner) {
+    batt::SharedPtr<llfs::PageCache> cache = llfs::make_memory_page_cache(
+        batt::Runtime::instance().default_scheduler(),
+        /*arena_sizes=*/{{llfs::PageCount{kNumPages}, llfs::PageSize{kPageSize}}},
+        llfs::MaxRefsPerPage{0});
+
+    const std::vector<llfs::PageId> page_ids = write_pages(*cache);
+
+    const auto get_page = [&cache](llfs::PageId page_id) {
+      llfs::StatusOr<llfs::PinnedPage> page = cache->get_page(page_id, llfs::OkIfNotFound{false});
+      BATT_CHECK_OK(page);
+      do_not_optimize(page->get());
+    };
+
+    // Load every page (twice, to get past the cache admission filter, if there is one).
+    //
+    for (usize round = 0; round < 2; ++round) {
+      for (llfs::PageId page_id : page_ids) {
+        get_page(page_id);
+      }
+    }
+
+    runner.run_throughput("page_cache_get_hit", [&](u64 n) {
+      for (u64 i = 0; i < n; ++i) {
+        get_page(page_ids[i % kNumPages]);
+      }
+    });
+
+    // Each iteration purges the page from the cache first, so the time includes the purge.
+    //
+    runner.run_throughput("page_cache_get_miss", [&](u64 n) {
+      for (u64 i = 0; i < n; ++i) {
+        const llfs::PageId page_id = page_ids[i % kNumPages];
+        cache->purge(page_id, llfs::Caller::Unknown, /*job_id=*/0);
+        get_page(page_id);
+      }
+    });
+  });
+
+  runner.add({"page_device_cache_find_or_insert"}, [](BenchRunner& runner) {
+    // Fewer slots than pages, so that a share of the lookups evict another page.
+    //
+    constexpr usize kNumSlots = kNumPages / 2;
+
+    const llfs::PageIdFactory page_ids{llfs::PageCount{kNumPages}, /*page_device_id=*/0};
+
+    llfs::PageDeviceCache cache{page_ids, kPageSize,
+                                llfs::PageCacheSlot::Pool::make_new(kNumSlots, "llfs_bench")};
+
+    const std::shared_ptr<const llfs::PageView> view = std::make_shared<llfs::OpaquePageView>(
+        llfs::PageBuffer::allocate(llfs::PageSize{kPageSize}));
+
+    const usize n_threads = std::max<usize>(1, runner.options().threads);
+
+    // Each iteration is one lookup; the lookups are split evenly over the threads, which all start
+    // at different pages and stride through the whole device.
+    //
+    runner.run_throughput(
+        "page_device_cache_find_or_insert",
+        [&](u64 n) {
+          std::vector<std::thread> threads;
+          for (usize t = 0; t < n_threads; ++t) {
+            threads.emplace_back([&, t] {
+              for (u64 i = t; i < n; i += n_threads) {
+                const llfs::PageId page_id =
+                    page_ids.make_page_id((i * 7) % kNumPages, /*generation=*/1);
+
+                llfs::StatusOr<llfs::PageCacheSlot::PinnedRef> pinned = cache.find_or_insert(
+                    page_id, [&view](const llfs::PageCacheSlot::PinnedRef& pinned_ref) {
+                      pinned_ref->set_value(batt::make_copy(view));
+                    });
+                do_not_optimize(pinned.ok());
+              }
+            });
+          }
+          for (std::thread& thread : threads) {
+            thread.join();
+          }
+        },
+        {
+            {"threads", double(n_threads)},
+            {"slots", double(kNumSlots)},
+            {"pages", double(kNumPages)},
+        });
+  });
+}
+
+}  // namespace llfs_bench
@@ -0,0 +1,98 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs_bench/bench.hpp>
+//
+
+#include <llfs/data_packer.hpp>
+#include <llfs/trie.hpp>
+
+#include <batteries/assert.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace llfs_bench {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void add_trie_benchmarks(BenchRunner& runner)
+{
+  runner.add({"bptrie_build", "bptrie_find", "packed_bptrie_find"}, [](BenchRunner& runner) {
+    constexpr usize kNumKeys = 16 * 1024;
+
+    // Sorted, unique keys with long shared prefixes, like the pivot keys of a tree.
+    //
+    std::vector<std::string> keys;
+    {
+      char buffer[64];
+      for (usize i = 0; i < kNumKeys; ++i) {
+        std::snprintf(buffer, sizeof(buffer), "user/%08zu/item/%zu", i / 16, i % 16);
+        keys.emplace_back(buffer);
+      }
+      std::sort(keys.begin(), keys.end());
+    }
+
+    // Look up the keys in a random order.
+    //
+    std::vector<std::string> queries = keys;
+    std::shuffle(queries.begin(), queries.end(), std::default_random_engine{1});
+
+    // Each iteration builds a trie on all the keys.
+    //
+    runner.run_throughput(
+        "bptrie_build",
+        [&](u64 n) {
+          for (u64 i = 0; i < n; ++i) {
+            llfs::BPTrie trie{keys};
+            do_not_optimize(trie.size());
+          }
+        },
+        {
+            {"keys", double(kNumKeys)},
+        });
+
+    llfs::BPTrie trie{keys};
+
+    runner.run_throughput("bptrie_find", [&](u64 n) {
+      usize sum = 0;
+      for (u64 i = 0; i < n; ++i) {
+        sum += trie.find(queries[i % kNumKeys]).lower_bound;
+      }
+      do_not_optimize(sum);
+    });
+
+    const usize packed_size = llfs::packed_sizeof(trie);
+    std::unique_ptr<u8[]> buffer{new u8[packed_size]};
+    const llfs::PackedBPTrie* packed = nullptr;
+    {
+      llfs::DataPacker packer{llfs::MutableBuffer{buffer.get(), packed_size}};
+      packed = llfs::pack_object(trie, &packer);
+      BATT_CHECK_NOT_NULLPTR(packed);
+    }
+
+    runner.run_throughput(
+        "packed_bptrie_find",
+        [&](u64 n) {
+          usize sum = 0;
+          for (u64 i = 0; i < n; ++i) {
+            sum += packed->find(queries[i % kNumKeys]).lower_bound;
+          }
+          do_not_optimize(sum);
+        },
+        {
+            {"packed_size", double(packed_size)},
+        });
+  });
+}
+
+}  // namespace llfs_bench
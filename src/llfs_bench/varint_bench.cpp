@@ -0,0 +1,70 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs_bench/bench.hpp>
+//
+
+#include <llfs/varint.hpp>
+
+#include <batteries/assert.hpp>
+
+#include <random>
+#include <vector>
+
+namespace llfs_bench {
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void add_varint_benchmarks(BenchRunner& runner)
+{
+  runner.add({"varint_pack", "varint_unpack"}, [](BenchRunner& runner) {
+    constexpr usize kNumValues = 4096;
+
+    // Values with a uniformly random number of significant bits, so that all encoded sizes occur.
+    //
+    std::default_random_engine rng{1};
+    std::vector<u64> values(kNumValues);
+    for (u64& value : values) {
+      const int bits = std::uniform_int_distribution<int>{1, 64}(rng);
+      value = rng() & (~u64{0} >> (64 - bits));
+    }
+
+    std::vector<u8> buffer(llfs::packed_sizeof_varints(batt::as_slice(values)));
+    u8* const first = buffer.data();
+    u8* const last = first + buffer.size();
+
+    runner.run_throughput("varint_pack", [&](u64 n) {
+      u8* dst = first;
+      for (u64 i = 0; i < n; ++i) {
+        if (i % kNumValues == 0) {
+          dst = first;
+        }
+        dst = llfs::pack_varint_to(dst, last, values[i % kNumValues]);
+      }
+      do_not_optimize(dst);
+    });
+
+    BATT_CHECK_NOT_NULLPTR(llfs::pack_varints_to(first, last, batt::as_slice(values)));
+
+    runner.run_throughput("varint_unpack", [&](u64 n) {
+      const u8* src = first;
+      u64 sum = 0;
+      for (u64 i = 0; i < n; ++i) {
+        if (i % kNumValues == 0) {
+          src = first;
+        }
+        auto [value, next] = llfs::unpack_varint_from(src, last);
+        sum += *value;
+        src = next;
+      }
+      do_not_optimize(sum);
+    });
+  });
+}
+
+}  // namespace llfs_bench
@@ -0,0 +1,637 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs_cli/bench_command.hpp>
+//
+
+#include <llfs/appendable_job.hpp>
+#include <llfs/ioring.hpp>
+#include <llfs/logging.hpp>
+#include <llfs/opaque_page_view.hpp>
+#include <llfs/page_arena_config.hpp>
+#include <llfs/page_device_config.hpp>
+#include <llfs/storage_context.hpp>
+#include <llfs/volume.hpp>
+#include <llfs/volume_config.hpp>
+
+#include <batteries/async/runtime.hpp>
+#include <batteries/math.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace llfs_cli {
+
+using namespace llfs;
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// The root log event written by each job: the ids of the pages it wrote.  This is what keeps the
+// job's pages live until the slot is trimmed.
+//
+struct BenchJobRoots {
+  std::vector<PackedPageId> page_ids;
+};
+
+usize packed_sizeof(const BenchJobRoots& roots)
+{
+  return packed_array_size<PackedPageId>(roots.page_ids.size());
+}
+
+PackedArray<PackedPageId>* pack_object(const BenchJobRoots& roots, DataPacker* dst)
+{
+  Optional<DataPacker::ArrayPacker<PackedPageId>> packed_ids = dst->pack_range(roots.page_ids);
+  if (!packed_ids) {
+    return nullptr;
+  }
+  return packed_ids->finish();
+}
+
+BoxedSeq<PageId> trace_refs(const BenchJobRoots& roots)
+{
+  return as_seq(roots.page_ids)  //
+         | seq::map([](const PackedPageId& packed_id) -> PageId {
+             return packed_id.as_page_id();
+           })  //
+         | seq::boxed();
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+
+enum struct BenchOp : usize {
+  kAppend = 0,
+  kJob,
+  kRead,
+  kTrim,
+};
+
+constexpr usize kNumBenchOps = 4;
+
+constexpr std::array<const char*, kNumBenchOps> kBenchOpNames = {
+    "append",
+    "job",
+    "read",
+    "trim",
+};
+
+// Per-thread results; merged after all threads have finished.
+//
+struct BenchThreadStats {
+  std::array<std::vector<std::chrono::nanoseconds>, kNumBenchOps> latency;
+  u64 read_misses = 0;
+  u64 alloc_failures = 0;
+};
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+// Runs the operation mix described by BenchCommandArgs against a recovered Volume.
+//
+class VolumeBench
+{
+ public:
+  // A committed slot, plus the pages it wrote (if it was a job).
+  //
+  struct CommittedSlot {
+    slot_offset_type upper_bound;
+    std::vector<PageId> page_ids;
+  };
+
+  explicit VolumeBench(const BenchCommandArgs& args, Volume& volume) noexcept
+      : args_{args}
+      , volume_{volume}
+      , append_payload_(args.append_size, 'a')
+      , trim_lag_{std::min<u64>(args.trim_lag, volume.root_log_capacity() / 4)}
+  {
+  }
+
+  // Runs `args.threads` threads for `args.duration_sec` and returns the stats from each.
+  //
+  std::vector<BenchThreadStats> run();
+
+ private:
+  Status run_thread(usize thread_i, BenchClock::time_point deadline, BenchThreadStats* stats);
+
+  Status append();
+
+  Status commit_job(BenchThreadStats* stats);
+
+  Status read_page(std::default_random_engine& rng, BenchThreadStats* stats);
+
+  Status trim(u64 lag);
+
+  // Trims the root log if it is more than half full, so that reservations never block forever.
+  //
+  Status trim_if_needed();
+
+  // Records a newly committed slot, so that later trims have a slot boundary to move to.
+  //
+  void add_committed_slot(CommittedSlot&& slot);
+
+  //+++++++++++-+-+--+----- --- -- -  -  -   -
+
+  const BenchCommandArgs& args_;
+
+  Volume& volume_;
+
+  const std::string append_payload_;
+
+  const u64 trim_lag_;
+
+  // Protects `committed_slots_`, `job_slots_` and `trim_pos_`; also serializes calls to
+  // Volume::trim.
+  //
+  std::mutex mutex_;
+
+  // Slots committed since the last trim, roughly in log order (threads commit concurrently).
+  //
+  std::deque<slot_offset_type> committed_slots_;
+
+  // The subset of `committed_slots_` written by jobs; reads are chosen from these.
+  //
+  std::deque<CommittedSlot> job_slots_;
+
+  slot_offset_type trim_pos_ = 0;
+};
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+std::vector<BenchThreadStats> VolumeBench::run()
+{
+  std::vector<BenchThreadStats> stats(this->args_.threads);
+  std::vector<std::thread> threads;
+
+  const BenchClock::time_point deadline =
+      BenchClock::now() + std::chrono::duration_cast<BenchClock::duration>(
+                              std::chrono::duration<double>(this->args_.duration_sec));
+
+  for (usize thread_i = 0; thread_i < this->args_.threads; ++thread_i) {
+    threads.emplace_back([this, thread_i, deadline, &stats] {
+      Status status = this->run_thread(thread_i, deadline, &stats[thread_i]);
+      BATT_CHECK_OK(status) << BATT_INSPECT(thread_i);
+    });
+  }
+
+  for (std::thread& t : threads) {
+    t.join();
+  }
+
+  return stats;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeBench::run_thread(usize thread_i, BenchClock::time_point deadline,
+                               BenchThreadStats* stats)
+{
+  std::default_random_engine rng{thread_i};
+  std::discrete_distribution<usize> pick_op{
+      this->args_.append_weight,
+      this->args_.job_weight,
+      this->args_.read_weight,
+      this->args_.trim_weight,
+  };
+
+  while (BenchClock::now() < deadline) {
+    BATT_REQUIRE_OK(this->trim_if_needed());
+
+    const auto op = static_cast<BenchOp>(pick_op(rng));
+    const auto start = BenchClock::now();
+
+    switch (op) {
+      case BenchOp::kAppend:
+        BATT_REQUIRE_OK(this->append());
+        break;
+
+      case BenchOp::kJob:
+        BATT_REQUIRE_OK(this->commit_job(stats));
+        break;
+
+      case BenchOp::kRead:
+        BATT_REQUIRE_OK(this->read_page(rng, stats));
+        break;
+
+      case BenchOp::kTrim:
+        BATT_REQUIRE_OK(this->trim(this->trim_lag_));
+        break;
+    }
+
+    stats->latency[static_cast<usize>(op)].emplace_back(BenchClock::now() - start);
+  }
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeBench::append()
+{
+  const std::string_view payload = this->append_payload_;
+
+  BATT_ASSIGN_OK_RESULT(batt::Grant grant,
+                        this->volume_.reserve(this->volume_.calculate_grant_size(payload),
+                                              batt::WaitForResource::kTrue));
+
+  BATT_ASSIGN_OK_RESULT(SlotRange slot, this->volume_.append(payload, grant));
+
+  if (this->args_.sync) {
+    BATT_REQUIRE_OK(
+        this->volume_.sync(LogReadMode::kDurable, SlotUpperBoundAt{.offset = slot.upper_bound}));
+  }
+
+  this->add_committed_slot(CommittedSlot{
+      .upper_bound = slot.upper_bound,
+      .page_ids = {},
+  });
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeBench::commit_job(BenchThreadStats* stats)
+{
+  std::unique_ptr<PageCacheJob> job = this->volume_.new_job();
+
+  BenchJobRoots roots;
+  std::vector<PageId> page_ids;
+
+  for (usize i = 0; i < this->args_.job_pages; ++i) {
+    StatusOr<std::shared_ptr<PageBuffer>> page_buffer = job->new_page(
+        PageSize{BATT_CHECKED_CAST(u32, this->args_.page_size)}, batt::WaitForResource::kFalse,
+        OpaquePageView::page_layout_id(), Caller::Unknown, /*cancel_token=*/None);
+
+    // The arena is full; give the trims in flight a chance to free some pages.
+    //
+    if (!page_buffer.ok()) {
+      stats->alloc_failures += 1;
+      return this->trim(/*lag=*/0);
+    }
+
+    const PageId page_id = (*page_buffer)->page_id();
+    const MutableBuffer payload = (*page_buffer)->mutable_payload();
+    std::memset(payload.data(), static_cast<int>(i), payload.size());
+
+    BATT_REQUIRE_OK(job->pin_new(std::make_shared<OpaquePageView>(std::move(*page_buffer)),
+                                 Caller::Unknown));
+
+    roots.page_ids.emplace_back(PackedPageId::from(page_id));
+    page_ids.emplace_back(page_id);
+  }
+
+  BATT_ASSIGN_OK_RESULT(AppendableJob appendable,
+                        make_appendable_job(std::move(job), PackableRef{roots}));
+
+  BATT_ASSIGN_OK_RESULT(batt::Grant grant,
+                        this->volume_.reserve(this->volume_.calculate_grant_size(appendable),
+                                              batt::WaitForResource::kTrue));
+
+  BATT_ASSIGN_OK_RESULT(SlotRange slot, this->volume_.append(std::move(appendable), grant));
+
+  if (this->args_.sync) {
+    BATT_REQUIRE_OK(
+        this->volume_.sync(LogReadMode::kDurable, SlotUpperBoundAt{.offset = slot.upper_bound}));
+  }
+
+  this->add_committed_slot(CommittedSlot{
+      .upper_bound = slot.upper_bound,
+      .page_ids = std::move(page_ids),
+  });
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeBench::read_page(std::default_random_engine& rng, BenchThreadStats* stats)
+{
+  Optional<PageId> page_id;
+  {
+    std::unique_lock<std::mutex> lock{this->mutex_};
+
+    if (!this->job_slots_.empty()) {
+      const CommittedSlot& slot = this->job_slots_[std::uniform_int_distribution<usize>{
+          0, this->job_slots_.size() - 1}(rng)];
+
+      if (!slot.page_ids.empty()) {
+        page_id = slot.page_ids[std::uniform_int_distribution<usize>{
+            0, slot.page_ids.size() - 1}(rng)];
+      }
+    }
+  }
+
+  if (!page_id) {
+    stats->read_misses += 1;
+    return OkStatus();
+  }
+
+  // A page can be trimmed (and recycled) between choosing it and loading it; count that as a miss
+  // rather than an error.
+  //
+  StatusOr<PinnedPage> page = this->volume_.cache().get_page(*page_id, OkIfNotFound{true});
+  if (!page.ok()) {
+    stats->read_misses += 1;
+  }
+
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeBench::trim(u64 lag)
+{
+  std::unique_lock<std::mutex> lock{this->mutex_};
+
+  const SlotRange slot_range = this->volume_.root_log_slot_range(LogReadMode::kDurable);
+  if (slot_range.size() <= lag) {
+    return OkStatus();
+  }
+  const slot_offset_type target = slot_range.upper_bound - lag;
+
+  // Only ever trim to a slot boundary we know of.
+  //
+  Optional<slot_offset_type> new_trim_pos;
+  while (!this->committed_slots_.empty() &&
+         !slot_less_than(target, this->committed_slots_.front())) {
+    new_trim_pos = this->committed_slots_.front();
+    this->committed_slots_.pop_front();
+  }
+  while (!this->job_slots_.empty() &&
+         !slot_less_than(target, this->job_slots_.front().upper_bound)) {
+    this->job_slots_.pop_front();
+  }
+
+  if (!new_trim_pos || !slot_less_than(this->trim_pos_, *new_trim_pos)) {
+    return OkStatus();
+  }
+  this->trim_pos_ = *new_trim_pos;
+
+  return this->volume_.trim(this->trim_pos_);
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status VolumeBench::trim_if_needed()
+{
+  const SlotRange slot_range = this->volume_.root_log_slot_range(LogReadMode::kSpeculative);
+
+  if (slot_range.size() > this->volume_.root_log_capacity() / 2) {
+    return this->trim(this->trim_lag_);
+  }
+  return OkStatus();
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void VolumeBench::add_committed_slot(CommittedSlot&& slot)
+{
+  std::unique_lock<std::mutex> lock{this->mutex_};
+
+  this->committed_slots_.emplace_back(slot.upper_bound);
+  if (!slot.page_ids.empty()) {
+    this->job_slots_.emplace_back(std::move(slot));
+  }
+}
+
+//=#=#==#==#===============+=+=+=+=++=++++++++++++++-++-+--+-+----+---------------
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+Status create_storage_file(StorageContext& storage_context, const BenchCommandArgs& args)
+{
+  if (args.page_size == 0 || (args.page_size & (args.page_size - 1)) != 0) {
+    return batt::StatusCode::kInvalidArgument;
+  }
+
+  const PageSizeLog2 page_size_log2{BATT_CHECKED_CAST(u32, batt::log2_ceil(args.page_size))};
+
+  std::error_code ec;
+  std::filesystem::remove(args.filename, ec);
+
+  return storage_context.add_new_file(
+      args.filename, [&](StorageFileBuilder& builder) -> Status {
+        BATT_REQUIRE_OK(builder.add_object(PageArenaConfigOptions{
+            .uuid = None,
+            .page_allocator =
+                CreateNewPageAllocator{
+                    .options =
+                        PageAllocatorConfigOptions{
+                            .uuid = None,
+                            .max_attachments = 32,
+                            .page_count = PageCount{args.page_count},
+                            .log_device =
+                                CreateNewLogDeviceWithDefaultSize{
+                                    .uuid = None,
+                                    .pages_per_block_log2 =
+                                        IoRingLogConfig::kDefaultPagesPerBlockLog2 + 1,
+                                },
+                            .page_size_log2 = page_size_log2,
+                            .page_device = LinkToNewPageDevice{},
+                        },
+                },
+            .page_device =
+                CreateNewPageDevice{
+                    .options =
+                        PageDeviceConfigOptions{
+                            .uuid = None,
+                            .device_id = None,
+                            .page_count = PageCount{args.page_count},
+                            .page_size_log2 = page_size_log2,
+                        },
+                },
+        }));
+
+        BATT_REQUIRE_OK(builder.add_object(VolumeConfigOptions{
+            .base =
+                VolumeOptions{
+                    .name = "llfs_cli_bench",
+                    .uuid = None,
+                    .max_refs_per_page = MaxRefsPerPage{1},
+                    .trim_lock_update_interval = TrimLockUpdateInterval{4 * kKiB},
+                    .trim_delay_byte_count = TrimDelayByteCount{0},
+                },
+            .root_log =
+                LogDeviceConfigOptions{
+                    .uuid = None,
+                    .pages_per_block_log2 = None,
+                    .log_size = args.log_size,
+                },
+            .recycler_max_buffered_page_count = None,
+        }));
+
+        return OkStatus();
+      });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+StatusOr<std::unique_ptr<Volume>> recover_volume(StorageContext& storage_context)
+{
+  Optional<boost::uuids::uuid> volume_uuid;
+
+  const std::vector<batt::SharedPtr<StorageObjectInfo>> volumes =
+      storage_context.find_objects_by_tag(PackedConfigSlotBase::Tag::kVolume) | seq::collect_vec();
+
+  for (const batt::SharedPtr<StorageObjectInfo>& info : volumes) {
+    if (volume_uuid) {
+      LLFS_LOG_ERROR() << "The storage file must contain exactly one Volume";
+      return batt::StatusCode::kInvalidArgument;
+    }
+    volume_uuid = info->p_config_slot->uuid;
+  }
+
+  if (!volume_uuid) {
+    return batt::StatusCode::kNotFound;
+  }
+
+  return storage_context.recover_object(
+      batt::StaticType<PackedVolumeConfig>{}, *volume_uuid,
+      VolumeRuntimeOptions{
+          .slot_visitor_fn =
+              [](const SlotParse&, std::string_view) {
+                return OkStatus();
+              },
+          .root_log_options = IoRingLogDriverOptions{},
+          .recycler_log_options = IoRingLogDriverOptions{},
+          .trim_control = nullptr,
+      });
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void print_report(const BenchCommandArgs& args, std::vector<BenchThreadStats>&& stats)
+{
+  const auto percentile_usec = [](const std::vector<std::chrono::nanoseconds>& sorted,
+                                  double p) -> double {
+    const usize i = std::min(sorted.size() - 1, static_cast<usize>(p * sorted.size()));
+    return static_cast<double>(sorted[i].count()) / 1000.0;
+  };
+
+  u64 total_ops = 0;
+  u64 read_misses = 0;
+  u64 alloc_failures = 0;
+
+  std::cout << std::fixed << std::setprecision(1);
+
+  for (usize op_i = 0; op_i < kNumBenchOps; ++op_i) {
+    std::vector<std::chrono::nanoseconds> latency;
+    for (BenchThreadStats& thread_stats : stats) {
+      latency.insert(latency.end(), thread_stats.latency[op_i].begin(),
+                     thread_stats.latency[op_i].end());
+    }
+    if (latency.empty()) {
+      continue;
+    }
+    std::sort(latency.begin(), latency.end());
+    total_ops += latency.size();
+
+    std::cout << std::setw(8) << kBenchOpNames[op_i] << ": count=" << latency.size()
+              << " ops/sec=" << (latency.size() / args.duration_sec)
+              << " p50=" << percentile_usec(latency, 0.50) << "us"
+              << " p99=" << percentile_usec(latency, 0.99) << "us"
+              << " p999=" << percentile_usec(latency, 0.999) << "us" << std::endl;
+  }
+
+  for (const BenchThreadStats& thread_stats : stats) {
+    read_misses += thread_stats.read_misses;
+    alloc_failures += thread_stats.alloc_failures;
+  }
+
+  std::cout << std::setw(8) << "total"
+            << ": count=" << total_ops << " ops/sec=" << (total_ops / args.duration_sec)
+            << " read_misses=" << read_misses << " alloc_failures=" << alloc_failures
+            << std::endl;
+}
+
+}  // namespace
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+CLI::App* add_bench_command(CLI::App* cmd)
+{
+  CLI::App* bench_cmd =
+      cmd->add_subcommand("bench", "Run a mixed append/job/read/trim workload against a Volume");
+
+  auto args = std::make_shared<BenchCommandArgs>();
+
+  bench_cmd->add_option("-f,--file", args->filename, "The storage file (.llfs) to use.")
+      ->required();
+  bench_cmd->add_flag("--create", args->create,
+                      "(Re)create the storage file with a new page arena and Volume.");
+  bench_cmd->add_option("--page-size", args->page_size, "Page size in bytes (with --create).");
+  bench_cmd->add_option("--page-count", args->page_count, "Arena page count (with --create).");
+  bench_cmd->add_option("--log-size", args->log_size, "Root log size in bytes (with --create).");
+  bench_cmd->add_option("--cache-pages", args->cache_pages, "PageCache capacity in pages.");
+  bench_cmd->add_option("--threads", args->threads, "Number of worker threads.");
+  bench_cmd->add_option("--duration", args->duration_sec, "Run time in seconds.");
+  bench_cmd->add_option("--append-weight", args->append_weight, "Relative frequency of appends.");
+  bench_cmd->add_option("--job-weight", args->job_weight, "Relative frequency of job commits.");
+  bench_cmd->add_option("--read-weight", args->read_weight, "Relative frequency of page reads.");
+  bench_cmd->add_option("--trim-weight", args->trim_weight, "Relative frequency of trims.");
+  bench_cmd->add_option("--append-size", args->append_size, "Bytes per appended slot.");
+  bench_cmd->add_option("--job-pages", args->job_pages, "New pages per job.");
+  bench_cmd->add_option("--trim-lag", args->trim_lag,
+                        "Bytes of root log to keep behind the end when trimming.");
+  bench_cmd->add_option("--sync", args->sync, "Wait for each slot to be durable (true/false).");
+
+  bench_cmd->callback([args] {
+    run_bench_command(*args);
+  });
+
+  return bench_cmd;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void run_bench_command(BenchCommandArgs& args)
+{
+  BATT_CHECK_GT(args.threads, 0u);
+  BATT_CHECK_GT(args.duration_sec, 0);
+
+  StatusOr<ScopedIoRing> ioring = ScopedIoRing::make_new(MaxQueueDepth{1024}, ThreadPoolSize{1});
+  BATT_CHECK_OK(ioring);
+
+  auto storage_context = batt::make_shared<StorageContext>(
+      batt::Runtime::instance().default_scheduler(), ioring->get_io_ring());
+
+  if (args.create) {
+    BATT_CHECK_OK(create_storage_file(*storage_context, args));
+  } else {
+    BATT_CHECK_OK(storage_context->add_existing_named_file(batt::make_copy(args.filename)));
+  }
+
+  storage_context->set_page_cache_options(
+      PageCacheOptions::with_default_values().set_max_cached_pages_per_size(
+          PageSize{BATT_CHECKED_CAST(u32, args.page_size)}, args.cache_pages));
+
+  StatusOr<std::unique_ptr<Volume>> volume = recover_volume(*storage_context);
+  BATT_CHECK_OK(volume);
+
+  BATT_CHECK_OK(OpaquePageView::register_layout((*volume)->cache()));
+
+  std::vector<BenchThreadStats> stats = VolumeBench{args, **volume}.run();
+
+  (*volume)->halt();
+  (*volume)->join();
+
+  print_report(args, std::move(stats));
+}
+
+}  // namespace llfs_cli
@@ -0,0 +1,75 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_CLI_BENCH_COMMAND_HPP
+#define LLFS_CLI_BENCH_COMMAND_HPP
+
+#include <CLI/App.hpp>
+
+#include <llfs/int_types.hpp>
+
+#include <string>
+
+namespace llfs_cli {
+
+using namespace llfs::int_types;
+
+CLI::App* add_bench_command(CLI::App* app);
+
+struct BenchCommandArgs {
+  // The storage file (.llfs) holding the Volume and its page arena.
+  //
+  std::string filename;
+
+  // If true, (re)create the storage file before running, using the sizes below; otherwise the file
+  // must already contain exactly one Volume.
+  //
+  bool create = false;
+
+  // Sizes used when creating the storage file.
+  //
+  u64 page_size = 4096;
+  u64 page_count = 16 * 1024;
+  u64 log_size = 64 * 1024 * 1024;
+
+  // The number of pages the PageCache may hold in memory.
+  //
+  u64 cache_pages = 1024;
+
+  // How many threads run operations, and for how long.
+  //
+  usize threads = 4;
+  double duration_sec = 10;
+
+  // The relative frequency of each operation:
+  //
+  //  - append: append a raw slot of `append_size` bytes to the root log
+  //  - job: commit a PageCacheJob of `job_pages` new pages
+  //  - read: load a random one of the pages written by recent jobs
+  //  - trim: trim the root log to `trim_lag` bytes behind its current end
+  //
+  u32 append_weight = 25;
+  u32 job_weight = 25;
+  u32 read_weight = 50;
+  u32 trim_weight = 1;
+
+  u64 append_size = 128;
+  u64 job_pages = 4;
+  u64 trim_lag = 16 * 1024 * 1024;
+
+  // If true, each append and job waits for its slot to be durable.
+  //
+  bool sync = true;
+};
+
+void run_bench_command(BenchCommandArgs& args);
+
+}  // namespace llfs_cli
+
+#endif  // LLFS_CLI_BENCH_COMMAND_HPP
@@ -11,8 +11,11 @@
 //
 
 #include <llfs_cli/arena_command.hpp>
+#include <llfs_cli/bench_command.hpp>
 #include <llfs_cli/cache_command.hpp>
 #include <llfs_cli/list_command.hpp>
+#include <llfs_cli/replay_command.hpp>
+#include <llfs_cli/verify_command.hpp>
 
 #include <CLI/App.hpp>
 #include <CLI/Config.hpp>
@@ -28,7 +31,10 @@ int main(int argc, char** argv)
 
   // llfs_cli::add_arena_command(&app);
   // llfs_cli::add_cache_command(&app);
+  llfs_cli::add_bench_command(&app);
   llfs_cli::add_list_command(&app);
+  llfs_cli::add_replay_command(&app);
+  llfs_cli::add_verify_command(&app);
 
   app.require_subcommand();
 
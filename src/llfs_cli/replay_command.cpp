@@ -0,0 +1,98 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs_cli/replay_command.hpp>
+//
+
+#include <llfs/page_cache_trace.hpp>
+#include <llfs/page_cache_trace_replay.hpp>
+
+#include <batteries/stream_util.hpp>
+
+#include <iomanip>
+#include <iostream>
+
+namespace llfs_cli {
+
+using namespace llfs;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+CLI::App* add_replay_command(CLI::App* cmd)
+{
+  CLI::App* replay_cmd = cmd->add_subcommand(
+      "replay-cache-trace", "Replay a PageCache trace file against simulated eviction policies");
+
+  auto args = std::make_shared<ReplayCommandArgs>();
+
+  replay_cmd->add_option("trace_file", args->trace_file, "The trace file to replay.")
+      ->required();
+  replay_cmd->add_option(
+      "-p,--policy", args->policies,
+      "Policies to simulate: Lru, SampledLru, ScanResistant, Arc, ClockPro (default: all).");
+  replay_cmd->add_option("-s,--size", args->cache_sizes, "Cache sizes (in pages) to simulate.")
+      ->required();
+
+  replay_cmd->callback([args] {
+    run_replay_command(*args);
+  });
+
+  return replay_cmd;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void run_replay_command(ReplayCommandArgs& args)
+{
+  std::vector<PageCacheReplayPolicy> policies;
+  for (const std::string& name : args.policies) {
+    StatusOr<PageCacheReplayPolicy> policy = parse_page_cache_replay_policy(name);
+    BATT_CHECK_OK(policy) << BATT_INSPECT_STR(name);
+    policies.emplace_back(*policy);
+  }
+  if (policies.empty()) {
+    policies = {
+        PageCacheReplayPolicy::kLru,
+        PageCacheReplayPolicy::kSampledLru,
+        PageCacheReplayPolicy::kScanResistant,
+        PageCacheReplayPolicy::kArc,
+        PageCacheReplayPolicy::kClockPro,
+    };
+  }
+
+  StatusOr<std::vector<PageCacheTraceEvent>> trace = read_page_cache_trace(args.trace_file);
+  BATT_CHECK_OK(trace);
+
+  u64 recorded_hits = 0;
+  for (const PageCacheTraceEvent& event : *trace) {
+    recorded_hits += event.hit ? 1 : 0;
+  }
+
+  std::cout << args.trace_file << ": " << trace->size() << " lookups, recorded miss ratio "
+            << std::fixed << std::setprecision(4)
+            << (trace->empty() ? 0.0 : 1.0 - double(recorded_hits) / double(trace->size()))
+            << std::endl
+            << std::endl;
+
+  std::cout << std::setw(16) << "policy";
+  for (usize cache_size : args.cache_sizes) {
+    std::cout << std::setw(12) << cache_size;
+  }
+  std::cout << std::endl;
+
+  for (PageCacheReplayPolicy policy : policies) {
+    std::cout << std::setw(16) << batt::to_string(policy);
+    for (const PageCacheReplayResult& result :
+         page_cache_miss_ratio_curve(as_slice(*trace), policy, args.cache_sizes)) {
+      std::cout << std::setw(12) << result.miss_ratio();
+    }
+    std::cout << std::endl;
+  }
+}
+
+}  // namespace llfs_cli
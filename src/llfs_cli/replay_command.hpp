@@ -0,0 +1,44 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_CLI_REPLAY_COMMAND_HPP
+#define LLFS_CLI_REPLAY_COMMAND_HPP
+
+#include <CLI/App.hpp>
+
+#include <llfs/int_types.hpp>
+
+#include <string>
+#include <vector>
+
+namespace llfs_cli {
+
+using namespace llfs::int_types;
+
+CLI::App* add_replay_command(CLI::App* app);
+
+struct ReplayCommandArgs {
+  // A trace file written by the PageCache (see PageCacheOptions::page_cache_trace_file).
+  //
+  std::string trace_file;
+
+  // The policies to simulate (see llfs::PageCacheReplayPolicy); all of them if empty.
+  //
+  std::vector<std::string> policies;
+
+  // The cache sizes (in pages) to simulate.
+  //
+  std::vector<usize> cache_sizes;
+};
+
+void run_replay_command(ReplayCommandArgs& args);
+
+}  // namespace llfs_cli
+
+#endif  // LLFS_CLI_REPLAY_COMMAND_HPP
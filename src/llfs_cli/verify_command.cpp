@@ -0,0 +1,141 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#include <llfs_cli/verify_command.hpp>
+//
+
+#include <llfs/ioring.hpp>
+#include <llfs/logging.hpp>
+#include <llfs/opaque_page_view.hpp>
+#include <llfs/page_graph_node.hpp>
+#include <llfs/page_ref_count_verifier.hpp>
+#include <llfs/storage_context.hpp>
+#include <llfs/volume.hpp>
+#include <llfs/volume_config.hpp>
+
+#include <batteries/async/runtime.hpp>
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace llfs_cli {
+
+using namespace llfs;
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+CLI::App* add_verify_command(CLI::App* cmd)
+{
+  CLI::App* verify_cmd = cmd->add_subcommand(
+      "verify", "Check the page ref counts of storage files (.llfs) against their Volumes' roots");
+
+  auto args = std::make_shared<VerifyCommandArgs>();
+
+  verify_cmd->add_option("files", args->files, "The storage files to check.")->required();
+  verify_cmd->add_option("--parallelism", args->parallelism,
+                         "Number of batches of pages to load at once.");
+  verify_cmd->add_option("--batch-size", args->batch_size, "Maximum pages per batch.");
+  verify_cmd->add_option("--max-reported", args->max_reported,
+                         "Maximum number of mismatches to print.");
+
+  verify_cmd->callback([args] {
+    run_verify_command(*args);
+  });
+
+  return verify_cmd;
+}
+
+//==#==========+==+=+=++=+++++++++++-+-+--+----- --- -- -  -  -   -
+//
+void run_verify_command(VerifyCommandArgs& args)
+{
+  StatusOr<ScopedIoRing> ioring = ScopedIoRing::make_new(MaxQueueDepth{1024}, ThreadPoolSize{1});
+  BATT_CHECK_OK(ioring);
+
+  auto storage_context = batt::make_shared<StorageContext>(
+      batt::Runtime::instance().default_scheduler(), ioring->get_io_ring());
+
+  BATT_CHECK_OK(storage_context->add_existing_named_files(batt::make_copy(args.files)));
+
+  StatusOr<batt::SharedPtr<PageCache>> page_cache = storage_context->get_page_cache();
+  BATT_CHECK_OK(page_cache);
+
+  // Only the page layouts built into LLFS can be traced; pages of any other layout fail to load.
+  // The layouts must be registered before the Volumes are recovered, since recovery may recycle
+  // pages.
+  //
+  BATT_CHECK_OK(OpaquePageView::register_layout(**page_cache));
+  BATT_CHECK_OK(PageGraphNodeView::register_layout(**page_cache));
+
+  // Recover every Volume, so that pending jobs are resolved and all clients of the page arenas
+  // have attached before the ref counts are read.
+  //
+  std::vector<std::unique_ptr<Volume>> volumes;
+
+  const std::vector<batt::SharedPtr<StorageObjectInfo>> volume_infos =
+      storage_context->find_objects_by_tag(PackedConfigSlotBase::Tag::kVolume) |
+      seq::collect_vec();
+
+  for (const batt::SharedPtr<StorageObjectInfo>& info : volume_infos) {
+    StatusOr<std::unique_ptr<Volume>> volume = storage_context->recover_object(
+        batt::StaticType<PackedVolumeConfig>{}, info->p_config_slot->uuid,
+        VolumeRuntimeOptions{
+            .slot_visitor_fn =
+                [](const SlotParse&, std::string_view) {
+                  return OkStatus();
+                },
+            .root_log_options = IoRingLogDriverOptions{},
+            .recycler_log_options = IoRingLogDriverOptions{},
+            .trim_control = nullptr,
+        });
+    BATT_CHECK_OK(volume) << BATT_INSPECT(info->p_config_slot->uuid);
+
+    volumes.emplace_back(std::move(*volume));
+  }
+
+  PageRefCountVerifierOptions options;
+  options.trace_options.parallelism = args.parallelism;
+  options.trace_options.max_batch_size = args.batch_size;
+  options.max_reported_mismatches = args.max_reported;
+
+  PageRefCountVerifier verifier{**page_cache, options};
+
+  for (const std::unique_ptr<Volume>& volume : volumes) {
+    BATT_CHECK_OK(verifier.add_volume_root_refs(*volume));
+  }
+
+  StatusOr<PageRefCountVerifierResult> result = verifier.run();
+
+  for (const std::unique_ptr<Volume>& volume : volumes) {
+    volume->halt();
+  }
+  for (const std::unique_ptr<Volume>& volume : volumes) {
+    volume->join();
+  }
+
+  BATT_CHECK_OK(result);
+
+  std::cout << volumes.size() << " volume(s), " << result->root_ref_count << " root ref(s), "
+            << result->reachable_page_count << " reachable page(s), "
+            << result->garbage_page_count << " page(s) waiting to be recycled, "
+            << result->checked_page_count << " page(s) checked" << std::endl;
+
+  for (const PageRefCountMismatch& mismatch : result->mismatches) {
+    std::cout << "  " << mismatch << std::endl;
+  }
+
+  if (!result->ok()) {
+    std::cout << result->mismatch_count << " ref count mismatch(es)" << std::endl;
+    throw CLI::RuntimeError{1};
+  }
+
+  std::cout << "OK" << std::endl;
+}
+
+}  // namespace llfs_cli
@@ -0,0 +1,48 @@
+//#=##=##=#==#=#==#===#+==#+==========+==+=+=+=+=+=++=+++=+++++=-++++=-+++++++++++
+//
+// Part of the LLFS Project, under Apache License v2.0.
+// See https://www.apache.org/licenses/LICENSE-2.0 for license information.
+// SPDX short identifier: Apache-2.0
+//
+//+++++++++++-+-+--+----- --- -- -  -  -   -
+
+#pragma once
+#ifndef LLFS_CLI_VERIFY_COMMAND_HPP
+#define LLFS_CLI_VERIFY_COMMAND_HPP
+
+#include <CLI/App.hpp>
+
+#include <llfs/int_types.hpp>
+
+#include <string>
+#include <vector>
+
+namespace llfs_cli {
+
+using namespace llfs::int_types;
+
+CLI::App* add_verify_command(CLI::App* app);
+
+struct VerifyCommandArgs {
+  // The storage files (.llfs) holding the Volumes and page arenas to check.
+  //
+  std::vector<std::string> files;
+
+  // The number of batches of pages to load at once (see llfs::ParallelTraceRefsOptions).
+  //
+  usize parallelism = 16;
+
+  // The maximum number of pages per batch.
+  //
+  usize batch_size = 256;
+
+  // The maximum number of mismatches to print.
+  //
+  usize max_reported = 64;
+};
+
+void run_verify_command(VerifyCommandArgs& args);
+
+}  // namespace llfs_cli
+
+#endif  // LLFS_CLI_VERIFY_COMMAND_HPP